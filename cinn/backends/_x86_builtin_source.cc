@@ -147,6 +147,15 @@ struct ExternalVec {
   T* data_{nullptr};
 };
 
+//! Reinterpret the bits of \p x as the type \p To of the same size.
+template <typename To, typename From>
+inline To cinn_reinterpret(const From& x) {
+  static_assert(sizeof(To) == sizeof(From), "cinn_reinterpret should keep the size");
+  To y;
+  memcpy(&y, &x, sizeof(To));
+  return y;
+}
+
 // AVX256 load
 //@{
 inline __m256 cinn_avx256_load(const float* dst) { return _mm256_load_ps(dst); }
@@ -0,0 +1,70 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/backends/algo_cache.h"
+
+#include <glog/logging.h>
+
+#include <cstdlib>
+
+namespace cinn {
+namespace backends {
+
+std::string AlgoCache::EntryKey(const std::string& key, const std::vector<std::string>& context) {
+  std::vector<std::string> parts{key};
+  parts.insert(parts.end(), context.begin(), context.end());
+  return CompilationCache::Key("algo", parts);
+}
+
+bool AlgoCache::Find(const std::string& key,
+                     const std::vector<std::string>& context,
+                     int* algo,
+                     const CompilationCache& cache) {
+  std::string entry_key = EntryKey(key, context);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = algos_.find(entry_key);
+    if (it != algos_.end()) {
+      *algo = it->second;
+      return true;
+    }
+  }
+  std::string data;
+  if (!cache.enabled() || !cache.Load(entry_key, &data)) return false;
+  char* end  = nullptr;
+  long value = std::strtol(data.c_str(), &end, 10);  // NOLINT
+  if (data.empty() || *end != '\0') {
+    LOG(WARNING) << "Invalid algorithm in the compilation cache for " << key;
+    return false;
+  }
+  *algo = static_cast<int>(value);
+  std::lock_guard<std::mutex> lock(mutex_);
+  algos_[entry_key] = *algo;
+  return true;
+}
+
+void AlgoCache::Store(const std::string& key,
+                      const std::vector<std::string>& context,
+                      int algo,
+                      const CompilationCache& cache) {
+  std::string entry_key = EntryKey(key, context);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    algos_[entry_key] = algo;
+  }
+  if (cache.enabled()) cache.Store(entry_key, std::to_string(algo));
+}
+
+}  // namespace backends
+}  // namespace cinn
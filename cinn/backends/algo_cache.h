@@ -0,0 +1,56 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cinn/backends/compilation_cache.h"
+
+namespace cinn {
+namespace backends {
+
+/**
+ * The algorithms chosen for the library calls, e.g. the cuDNN convolution algorithms found by the search, kept in the
+ * memory of the process and persisted in a CompilationCache, so that the processes sharing the cache skip the search.
+ * A choice is keyed by the call and the context it is made in, e.g. the device and the version of the library, as the
+ * best algorithm of one device is not the best of another. It is thread-safe.
+ */
+class AlgoCache {
+ public:
+  //! The key of the entry of the call \p key in \p context in the compilation cache.
+  static std::string EntryKey(const std::string& key, const std::vector<std::string>& context);
+
+  //! Get the algorithm chosen for the call \p key in \p context to \p algo, return false if none.
+  bool Find(const std::string& key,
+            const std::vector<std::string>& context,
+            int* algo,
+            const CompilationCache& cache = CompilationCache::Default());
+
+  //! Store the algorithm chosen for the call \p key in \p context, also to \p cache if it is enabled.
+  void Store(const std::string& key,
+             const std::vector<std::string>& context,
+             int algo,
+             const CompilationCache& cache = CompilationCache::Default());
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, int> algos_;
+};
+
+}  // namespace backends
+}  // namespace cinn
@@ -0,0 +1,64 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/backends/algo_cache.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace cinn {
+namespace backends {
+
+TEST(AlgoCache, store_and_reload) {
+  std::string dir = "./algo_cache_test_" + std::to_string(getpid());
+  CompilationCache cache(dir);
+  const std::string key = "conv2d,1,3,224,224,64,3,7,7,1,64,112,112,3,3,2,2,1,1,1";
+  const std::vector<std::string> context{"Tesla V100", "7.0", "8200"};
+
+  AlgoCache algos;
+  int algo = -1;
+  EXPECT_FALSE(algos.Find(key, context, &algo, cache));
+  algos.Store(key, context, 5, cache);
+  ASSERT_TRUE(algos.Find(key, context, &algo, cache));
+  EXPECT_EQ(algo, 5);
+
+  // A new process reloads the choice from the directory.
+  AlgoCache reloaded;
+  algo = -1;
+  ASSERT_TRUE(reloaded.Find(key, context, &algo, cache));
+  EXPECT_EQ(algo, 5);
+  // Another convolution, device or version misses.
+  EXPECT_FALSE(reloaded.Find(key + ",2", context, &algo, cache));
+  EXPECT_FALSE(reloaded.Find(key, {"A100", "8.0", "8200"}, &algo, cache));
+  EXPECT_FALSE(reloaded.Find(key, {"Tesla V100", "7.0", "8300"}, &algo, cache));
+}
+
+TEST(AlgoCache, invalid_entry) {
+  CompilationCache::ClearMemory();
+  CompilationCache cache("", 1 << 10);
+  ASSERT_TRUE(cache.Store(AlgoCache::EntryKey("conv2d", {"dev"}), "not an algorithm"));
+  int algo = -1;
+  EXPECT_FALSE(AlgoCache().Find("conv2d", {"dev"}, &algo, cache));
+  // without a cache the choices only live in the process
+  AlgoCache algos;
+  algos.Store("conv2d", {"dev"}, 2, CompilationCache(""));
+  ASSERT_TRUE(algos.Find("conv2d", {"dev"}, &algo, CompilationCache("")));
+  EXPECT_EQ(algo, 2);
+  CompilationCache::ClearMemory();
+}
+
+}  // namespace backends
+}  // namespace cinn
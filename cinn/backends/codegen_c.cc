@@ -20,6 +20,8 @@
 #include "cinn/ir/ir_operators.h"
 #include "cinn/ir/ir_verify.h"
 #include "cinn/ir/lowered_func.h"
+#include "cinn/optim/insert_cache_hints.h"
+#include "cinn/optim/lower_intrin.h"
 #include "cinn/optim/ir_simplify.h"
 #include "cinn/optim/remove_nested_block.h"
 #include "cinn/runtime/cpu/thread_backend.h"
@@ -99,6 +101,10 @@ std::string CodeGenC::GetTypeRepr(Type type) {
     str += "int64_t";
   } else if (type.is_bool()) {
     str += "bool";
+  } else if (type.is_float(16)) {
+    str += "float16";
+  } else if (type.is_bfloat16()) {
+    str += "bfloat16";
   } else if (type.is_float(32)) {
     str += "float";
   } else if (type.is_float(64)) {
@@ -651,6 +657,10 @@ void CodeGenC::PrintRuntimeType(const cinn_type_t &type) {
     os() << "cinn_int32_t()";
   } else if (type == cinn_int64_t()) {
     os() << "cinn_int64_t()";
+  } else if (type == cinn_float16_t()) {
+    os() << "cinn_float16_t()";
+  } else if (type == cinn_bfloat16_t()) {
+    os() << "cinn_bfloat16_t()";
   } else if (type == cinn_float32_t()) {
     os() << "cinn_float32_t()";
   } else if (type == cinn_float64_t()) {
@@ -678,16 +688,17 @@ void CodeGenC::Visit(const ir::IntrinsicOp *op) {
   }
 }
 
-void CodeGenC::Visit(const ir::intrinsics::BufferGetDataHandle *op) {
-  os() << op->buffer.as_buffer()->name;
-  os() << "->";
-  os() << "memory";
-}
+void CodeGenC::Visit(const ir::intrinsics::BufferGetDataHandle *op) { PrintBufferData(op->buffer.as_buffer()); }
+
+void CodeGenC::Visit(const ir::intrinsics::BufferGetDataConstHandle *op) { PrintBufferData(op->buffer.as_buffer()); }
 
-void CodeGenC::Visit(const ir::intrinsics::BufferGetDataConstHandle *op) {
-  os() << op->buffer.as_buffer()->name;
+void CodeGenC::PrintBufferData(const ir::_Buffer_ *buffer) {
+  int alignment = buffer->KnownAlignment();
+  if (alignment > 1) os() << "__builtin_assume_aligned(";
+  os() << buffer->name;
   os() << "->";
   os() << "memory";
+  if (alignment > 1) os() << ", " << alignment << ")";
 }
 
 void CodeGenC::Visit(const ir::intrinsics::PodValueToX *op) {
@@ -757,6 +768,19 @@ void CodeGenC::Visit(const ir::intrinsics::ArgsConstruct *op) {
 }
 
 void CodeGenC::Visit(const ir::intrinsics::BuiltinIntrin *op) {
+  if (op->name == optim::kNontemporalStoreIntrin) {
+    // C has no portable non-temporal store, so it is a normal store
+    CHECK_EQ(op->args.size(), 1U);
+    Print(op->args[0]);
+    return;
+  }
+  if (op->name == optim::kReinterpretIntrin) {
+    CHECK_EQ(op->args.size(), 1U);
+    os() << op->name << "<" << GetTypeRepr(op->type()) << ">(";
+    Print(op->args[0]);
+    os() << ")";
+    return;
+  }
   os() << op->name << "(";
   if (!op->args.empty()) {
     for (int i = 0; i < op->args.size() - 1; i++) {
@@ -768,6 +792,20 @@ void CodeGenC::Visit(const ir::intrinsics::BuiltinIntrin *op) {
   os() << ")";
 }
 
+void CodeGenC::Visit(const ir::intrinsics::DotProduct4 *op) {
+  // C has no 4-way dot product, so it is the sum of the products widened to int32
+  os() << "(";
+  Print(op->acc);
+  for (int i = 0; i < op->a.size(); i++) {
+    os() << " + (int)(";
+    Print(op->a[i]);
+    os() << ") * (int)(";
+    Print(op->b[i]);
+    os() << ")";
+  }
+  os() << ")";
+}
+
 std::string ReadWholeFile(const std::string &path) {
   CHECK(!path.empty());
   std::ifstream file(path);
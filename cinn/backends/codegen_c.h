@@ -79,6 +79,9 @@ class CodeGenC : public ir::IrPrinter {
 
   void PrintShape(const std::vector<Expr>& shape, char leftb = '{', char rightb = '}');
 
+  //! Print the data of \p buffer, assumed aligned by ir::_Buffer_::KnownAlignment.
+  void PrintBufferData(const ir::_Buffer_* buffer);
+
   virtual void PrintIncludes();
   void PrintBuiltinCodes();
   void PrintFileGuardOpen(const std::string& module_name);
@@ -17,6 +17,13 @@
 namespace cinn {
 namespace backends {
 
+CodeGenCX86::Feature CodeGenCX86::GetFeature(const Target &target) {
+  if (target.supports(Target::X86Feature::AVX512)) return Feature::AVX512;
+  if (target.supports(Target::X86Feature::AVX2)) return Feature::AVX256;
+  if (target.supports(Target::X86Feature::SSE)) return Feature::SSE;
+  return Feature::None;
+}
+
 void CodeGenCX86::Visit(const ir::Add *op) { VisitBinaryOp(op, op->a(), op->b(), "add"); }
 void CodeGenCX86::Visit(const ir::Sub *op) { VisitBinaryOp(op, op->a(), op->b(), "sub"); }
 void CodeGenCX86::Visit(const ir::Mul *op) { VisitBinaryOp(op, op->a(), op->b(), "mul"); }
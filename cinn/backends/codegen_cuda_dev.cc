@@ -130,6 +130,15 @@ void CodeGenCUDA_Dev::Visit(const ir::Alloc *op) {
   PrintTempBufferCreation(op->destination.as_buffer_ref());
 }
 
+void CodeGenCUDA_Dev::Visit(const ir::FloatImm *op) {
+  // CUDA has no literal of half or bfloat16, build it from the float one.
+  if (op->type().is_float(16) || op->type().is_bfloat16()) {
+    os() << GetTypeRepr(op->type()) << "(" << op->value << "f)";
+    return;
+  }
+  CodeGenC::Visit(op);
+}
+
 void CodeGenCUDA_Dev::Visit(const ir::Min *op) {
   os() << "cinn_nvgpu_min_fp32(";
   Print(op->a());
@@ -146,6 +155,116 @@ void CodeGenCUDA_Dev::Visit(const ir::Max *op) {
   os() << ")";
 }
 
+namespace {
+
+//! The CUDA vector type of \p type, e.g. float4 of 4 float32 lanes, empty if CUDA has none.
+std::string GetCudaVectorTypeRepr(Type type) {
+  if (type.ElementOf().is_float(32) && (type.lanes() == 2 || type.lanes() == 4)) {
+    return "float" + std::to_string(type.lanes());
+  }
+  if (type.ElementOf().is_float(16) && type.lanes() == 2) return "half2";
+  return "";
+}
+
+//! Whether \p e is a multiple of \p n for all the values of its variables.
+bool IsMultipleOf(const Expr &e, int n) {
+  if (auto *imm = e.As<ir::IntImm>()) return imm->value % n == 0;
+  if (auto *mul = e.As<ir::Mul>()) return IsMultipleOf(mul->a(), n) || IsMultipleOf(mul->b(), n);
+  if (auto *add = e.As<ir::Add>()) return IsMultipleOf(add->a(), n) && IsMultipleOf(add->b(), n);
+  if (auto *sub = e.As<ir::Sub>()) return IsMultipleOf(sub->a(), n) && IsMultipleOf(sub->b(), n);
+  return false;
+}
+
+//! Whether the contiguous \p lanes at \p base of \p tensor are aligned to the vector.
+bool IsAlignedVector(const ir::_Tensor_ *tensor, const Expr &base, int lanes) {
+  // the global buffers allocated by cudaMalloc are aligned to 256 bytes, the temporary ones only to their elements
+  CHECK(tensor);
+  return tensor->buffer.defined() && tensor->buffer->memory_type == ir::MemoryType::Heap && IsMultipleOf(base, lanes);
+}
+
+}  // namespace
+
+void CodeGenCUDA_Dev::Visit(const ir::Load *op) {
+  auto vector_type = GetCudaVectorTypeRepr(op->type());
+  Expr base        = detail::StridedRampBase(op->index(), 1);
+  if (vector_type.empty() || !base.defined()) {
+    CodeGenC::Visit(op);
+    return;
+  }
+  // the aligned vectors are loaded by a single instruction, the others element by element
+  auto *tensor = op->tensor.As<ir::_Tensor_>();
+  if (IsAlignedVector(tensor, base, op->type().lanes())) {
+    os() << "(*reinterpret_cast<const " << vector_type << "*>(" << tensor->name << " + ";
+    Print(base);
+    os() << "))";
+  } else {
+    os() << "cinn_nvgpu_loadu_" << vector_type << "(" << tensor->name << " + ";
+    Print(base);
+    os() << ")";
+  }
+}
+
+void CodeGenCUDA_Dev::Visit(const ir::Store *op) {
+  auto vector_type = GetCudaVectorTypeRepr(op->value.type());
+  Expr base        = detail::StridedRampBase(op->index(), 1);
+  if (vector_type.empty() || !base.defined()) {
+    CodeGenC::Visit(op);
+    return;
+  }
+  auto *tensor = op->tensor.As<ir::_Tensor_>();
+  bool aligned = IsAlignedVector(tensor, base, op->value.type().lanes());
+  if (aligned) {
+    os() << "*reinterpret_cast<" << vector_type << "*>(" << tensor->name << " + ";
+    Print(base);
+    os() << ") = ";
+  } else {
+    os() << "cinn_nvgpu_storeu(" << tensor->name << " + ";
+    Print(base);
+    os() << ", ";
+  }
+  Print(op->value);
+  if (!aligned) os() << ")";
+}
+
+void CodeGenCUDA_Dev::Visit(const ir::Broadcast *op) {
+  auto vector_type = GetCudaVectorTypeRepr(op->type());
+  if (vector_type.empty()) {
+    CodeGenC::Visit(op);
+    return;
+  }
+  if (op->type().ElementOf().is_float(16)) {
+    os() << "__half2half2(";
+    Print(op->value);
+    os() << ")";
+    return;
+  }
+  os() << "make_" << vector_type << "(";
+  for (int i = 0; i < op->lanes; i++) {
+    if (i > 0) os() << ", ";
+    Print(op->value);
+  }
+  os() << ")";
+}
+
+void CodeGenCUDA_Dev::Visit(const ir::intrinsics::DotProduct4 *op) {
+  // the DP4A multiplies the int8 elements packed in the int32s
+  auto print_pack = [&](const llvm::SmallVectorImpl<Expr> &elems) {
+    os() << "cinn_nvgpu_pack_char4(";
+    for (int i = 0; i < elems.size(); i++) {
+      if (i > 0) os() << ", ";
+      Print(elems[i]);
+    }
+    os() << ")";
+  };
+  os() << "__dp4a(";
+  print_pack(op->a);
+  os() << ", ";
+  print_pack(op->b);
+  os() << ", ";
+  Print(op->acc);
+  os() << ")";
+}
+
 void CodeGenCUDA_Dev::PrintFunctionDeclaration(const ir::_LoweredFunc_ *op) {
   // os() << "void " << GenKernelName(op->name) << "(";
   os() << "void " << op->name << "(";
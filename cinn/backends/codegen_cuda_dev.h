@@ -71,10 +71,15 @@ class CodeGenCUDA_Dev : public CodeGenC {
 
  protected:
   void Visit(const ir::_LoweredFunc_* op) override;
+  void Visit(const ir::FloatImm* op) override;
   void Visit(const ir::Min* op) override;
   void Visit(const ir::Max* op) override;
   void Visit(const ir::Alloc* op) override;
   void Visit(const ir::Call* op) override;
+  void Visit(const ir::Load* op) override;
+  void Visit(const ir::Store* op) override;
+  void Visit(const ir::Broadcast* op) override;
+  void Visit(const ir::intrinsics::DotProduct4* op) override;
 
   void PrintBuiltinCodes();
 
@@ -14,9 +14,12 @@
 
 #include "cinn/backends/codegen_cuda_dev.h"
 
+#include <cuda_fp16.h>
 #include <gtest/gtest.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <cmath>
 #include <tuple>
 #include <vector>
 
@@ -971,6 +974,462 @@ void mul_cache_write(const float* __restrict__ A1, const float* __restrict__ B1,
   }
 }
 
+TEST(CodeGenCUDA3, test_of_matmul_tiled) {
+  Context::Global().ResetNameId();
+  Expr M(128);
+  Expr N(128);
+  Expr K(128);
+
+  Target target = common::DefaultNVGPUTarget();
+
+  Placeholder<float> A("A1", {M, K});
+  Placeholder<float> B("B1", {K, N});
+
+  auto k1 = Var(K.as_int32(), "k1");
+  auto C  = Compute(
+      {M, N}, [&](Var i, Var j) { return ReduceSum(A(i, k1) * B(k1, j), {k1}); }, "C1");
+
+  auto stages = CreateStages({A, B, C});
+  hlir::pe::CudaScheduleMatmul(stages, C, target);
+  auto tiles = hlir::pe::GetCudaGemmTiles(M.as_int32(), N.as_int32(), K.as_int32());
+
+  CodeGenCUDA_Dev codegen(target);
+
+  auto func = Lower("matmul_tiled", stages, {A, B, C}, {}, {}, nullptr, target);
+
+  Module::Builder builder("module", target);
+  builder.AddFunction(func);
+
+  auto source_code = codegen.Compile(builder.Build());
+
+  LOG(INFO) << "compiled tiled matmul code:\n\n\n" << source_code;
+  ASSERT_NE(source_code.find("__shared__"), std::string::npos);
+  ASSERT_NE(source_code.find("__syncthreads()"), std::string::npos);
+  // the tiles of the next bk are copied asynchronously while computing on the current tiles
+  ASSERT_NE(source_code.find("cinn_nvgpu_cp_async_fp32"), std::string::npos);
+  ASSERT_NE(source_code.find("cinn_nvgpu_cp_async_wait(0)"), std::string::npos);
+
+  using runtime::cuda::CUDAModule;
+
+  backends::NVRTC_Compiler compiler;
+
+  auto ptx = compiler(source_code);
+  CHECK(!ptx.empty());
+
+  CUDAModule cuda_module(ptx, CUDAModule::Kind::PTX);
+
+  auto _Ad_Bd_Cd_host_data1_host_data2_host_data3_ = CreateNVMemory(M.as_int32(), N.as_int32());
+  auto& Ad                                         = std::get<0>(_Ad_Bd_Cd_host_data1_host_data2_host_data3_);
+  auto& Bd                                         = std::get<1>(_Ad_Bd_Cd_host_data1_host_data2_host_data3_);
+  auto& Cd                                         = std::get<2>(_Ad_Bd_Cd_host_data1_host_data2_host_data3_);
+  auto& host_data1                                 = std::get<3>(_Ad_Bd_Cd_host_data1_host_data2_host_data3_);
+  auto& host_data2                                 = std::get<4>(_Ad_Bd_Cd_host_data1_host_data2_host_data3_);
+  auto& host_data3                                 = std::get<5>(_Ad_Bd_Cd_host_data1_host_data2_host_data3_);
+
+  void* args[] = {&Ad, &Bd, &Cd};
+
+  dim3 grid(N.as_int32() / (tiles.tx * tiles.tn), M.as_int32() / (tiles.ty * tiles.tm), 1);
+  dim3 block(tiles.tx, tiles.ty, 1);
+  cuda_module.LaunchKernel(0, "matmul_tiled", grid, block, args);
+
+  CUDA_CALL(cudaMemcpy(host_data3.data(),
+                       reinterpret_cast<void*>(Cd),
+                       M.as_int32() * N.as_int32() * sizeof(float),
+                       cudaMemcpyDeviceToHost));
+  int n = N.as_int32();
+  for (int i = 0; i < M.as_int32(); i++) {
+    for (int j = 0; j < n; j++) {
+      float res = 0;
+      for (int k = 0; k < K.as_int32(); k++) {
+        res += host_data1[i * K.as_int32() + k] * host_data2[k * n + j];
+      }
+      EXPECT_NEAR(host_data3[i * n + j], res, 1e-3);
+    }
+  }
+}
+
+TEST(CodeGenCUDA3, test_of_tensor_core_matmul) {
+  Context::Global().ResetNameId();
+  const int m = 64;
+  const int n = 32;
+  const int k = 48;
+
+  Target target = common::DefaultNVGPUTarget();
+
+  auto A  = lang::CreatePlaceHolder({Expr(m), Expr(k)}, Float(16), "A1");
+  auto B  = lang::CreatePlaceHolder({Expr(k), Expr(n)}, Float(16), "B1");
+  auto k1 = Var(k, "k1");
+  auto C  = Compute(
+      {Expr(m), Expr(n)},
+      [&](Var i, Var j) {
+        return ReduceSum(ir::Cast::Make(Float(32), A(i, k1)) * ir::Cast::Make(Float(32), B(k1, j)), {k1});
+      },
+      "C1");
+
+  auto stages = CreateStages({A, B, C});
+  // [i, j, k] -> [io, jo, ko, ii, ji, ki]
+  stages[C]->Split(2, 16);
+  stages[C]->Split(1, 16);
+  stages[C]->Split(0, 16);
+  stages[C]->Reorder({0, 2, 4, 1, 3, 5});
+  stages[C]->Bind(0, "blockIdx.y");
+  stages[C]->Bind(1, "blockIdx.x");
+  stages[C]->TensorCore(3);
+
+  auto func = Lower("tensor_core_matmul", stages, {A, B, C}, {}, {}, nullptr, target);
+  ASSERT_EQ(func->cuda_axis_info.block_dim(0), 32);
+
+  Module::Builder builder("module", target);
+  builder.AddFunction(func);
+
+  CodeGenCUDA_Dev codegen(target);
+  auto source_code = codegen.Compile(builder.Build());
+  LOG(INFO) << "compiled tensor core code:\n\n\n" << source_code;
+  ASSERT_NE(source_code.find("cinn_nvgpu_wmma_m16n16k16_fp16_row_row"), std::string::npos);
+
+  using runtime::cuda::CUDAModule;
+
+  backends::NVRTC_Compiler compiler;
+
+  auto ptx = compiler(source_code);
+  CHECK(!ptx.empty());
+
+  CUDAModule cuda_module(ptx, CUDAModule::Kind::PTX);
+
+  std::vector<half> host_a(m * k), host_b(k * n);
+  std::vector<float> host_c(m * n, 0);
+  for (auto& v : host_a) v = __float2half(static_cast<float>(rand()) / INT_MAX);  // NOLINT
+  for (auto& v : host_b) v = __float2half(static_cast<float>(rand()) / INT_MAX);  // NOLINT
+
+  CUdeviceptr Ad, Bd, Cd;
+  cuMemAlloc(&Ad, m * k * sizeof(half));
+  cuMemAlloc(&Bd, k * n * sizeof(half));
+  cuMemAlloc(&Cd, m * n * sizeof(float));
+  CUDA_CALL(cudaMemcpy(reinterpret_cast<void*>(Ad), host_a.data(), m * k * sizeof(half), cudaMemcpyHostToDevice));
+  CUDA_CALL(cudaMemcpy(reinterpret_cast<void*>(Bd), host_b.data(), k * n * sizeof(half), cudaMemcpyHostToDevice));
+
+  void* args[] = {&Ad, &Bd, &Cd};
+
+  dim3 grid(n / 16, m / 16, 1);
+  dim3 block(32, 1, 1);
+  cuda_module.LaunchKernel(0, "tensor_core_matmul", grid, block, args);
+
+  CUDA_CALL(cudaMemcpy(host_c.data(), reinterpret_cast<void*>(Cd), m * n * sizeof(float), cudaMemcpyDeviceToHost));
+  for (int i = 0; i < m; i++) {
+    for (int j = 0; j < n; j++) {
+      float res = 0;
+      for (int x = 0; x < k; x++) {
+        res += __half2float(host_a[i * k + x]) * __half2float(host_b[x * n + j]);
+      }
+      EXPECT_NEAR(host_c[i * n + j], res, 1e-2);
+    }
+  }
+
+  CUDA_CALL(cudaFree(reinterpret_cast<void*>(Ad)))
+  CUDA_CALL(cudaFree(reinterpret_cast<void*>(Bd)))
+  CUDA_CALL(cudaFree(reinterpret_cast<void*>(Cd)))
+}
+
+TEST(CodeGenCUDA3, test_of_dot_product4) {
+  Context::Global().ResetNameId();
+  const int m = 32;
+  const int n = 32;
+  const int k = 64;
+
+  Target target = common::DefaultNVGPUTarget();
+
+  auto A  = lang::CreatePlaceHolder({Expr(m), Expr(k)}, Int(8), "A1");
+  auto B  = lang::CreatePlaceHolder({Expr(k), Expr(n)}, Int(8), "B1");
+  auto k1 = Var(k, "k1");
+  auto C  = Compute(
+      {Expr(m), Expr(n)},
+      [&](Var i, Var j) {
+        return ReduceSum(ir::Cast::Make(Int(32), A(i, k1)) * ir::Cast::Make(Int(32), B(k1, j)), {k1});
+      },
+      "C1");
+
+  auto stages = CreateStages({A, B, C});
+  // [i, j, k] -> [i, j, ko, ki]
+  stages[C]->Split(2, 4);
+  stages[C]->Bind(0, "blockIdx.x");
+  stages[C]->Bind(1, "threadIdx.x");
+  stages[C]->DotProduct4(3);
+
+  auto func = Lower("dot_product4_matmul", stages, {A, B, C}, {}, {}, nullptr, target);
+
+  Module::Builder builder("module", target);
+  builder.AddFunction(func);
+
+  CodeGenCUDA_Dev codegen(target);
+  auto source_code = codegen.Compile(builder.Build());
+  LOG(INFO) << "compiled dot product code:\n\n\n" << source_code;
+  ASSERT_NE(source_code.find("__dp4a(cinn_nvgpu_pack_char4("), std::string::npos);
+
+  backends::NVRTC_Compiler compiler;
+  auto ptx = compiler(source_code);
+  CHECK(!ptx.empty());
+}
+
+TEST(CodeGenCUDA3, test_of_block_reduce) {
+  Context::Global().ResetNameId();
+  const int m = 16;
+  const int k = 4096;
+
+  Target target = common::DefaultNVGPUTarget();
+
+  auto A  = lang::CreatePlaceHolder({Expr(m), Expr(k)}, Float(32), "A1");
+  auto k1 = Var(k, "k1");
+  auto B  = Compute(
+      {Expr(m)}, [&](Var i) { return ReduceSum(A(i, k1), {k1}); }, "B1");
+
+  auto stages = CreateStages({A, B});
+  stages[B]->Bind(0, "blockIdx.x");
+  stages[B]->BlockReduce(1);
+
+  auto func = Lower("block_reduce", stages, {A, B}, {}, {}, nullptr, target);
+  ASSERT_EQ(func->cuda_axis_info.grid_dim(0), m);
+  ASSERT_EQ(func->cuda_axis_info.block_dim(0), 512);
+
+  Module::Builder builder("module", target);
+  builder.AddFunction(func);
+
+  CodeGenCUDA_Dev codegen(target);
+  auto source_code = codegen.Compile(builder.Build());
+  LOG(INFO) << "compiled block reduce code:\n\n\n" << source_code;
+  ASSERT_NE(source_code.find("cinn_block_reduce_sum_fp32"), std::string::npos);
+
+  using runtime::cuda::CUDAModule;
+
+  backends::NVRTC_Compiler compiler;
+
+  auto ptx = compiler(source_code);
+  CHECK(!ptx.empty());
+
+  CUDAModule cuda_module(ptx, CUDAModule::Kind::PTX);
+
+  std::vector<float> host_a(m * k), host_b(m, 0);
+  for (auto& v : host_a) v = static_cast<float>(rand()) / INT_MAX;  // NOLINT
+
+  CUdeviceptr Ad, Bd;
+  cuMemAlloc(&Ad, m * k * sizeof(float));
+  cuMemAlloc(&Bd, m * sizeof(float));
+  CUDA_CALL(cudaMemcpy(reinterpret_cast<void*>(Ad), host_a.data(), m * k * sizeof(float), cudaMemcpyHostToDevice));
+
+  void* args[] = {&Ad, &Bd};
+
+  dim3 grid(m, 1, 1);
+  dim3 block(512, 1, 1);
+  cuda_module.LaunchKernel(0, "block_reduce", grid, block, args);
+
+  CUDA_CALL(cudaMemcpy(host_b.data(), reinterpret_cast<void*>(Bd), m * sizeof(float), cudaMemcpyDeviceToHost));
+  for (int i = 0; i < m; i++) {
+    float res = 0;
+    for (int x = 0; x < k; x++) {
+      res += host_a[i * k + x];
+    }
+    EXPECT_NEAR(host_b[i], res, 1e-2);
+  }
+
+  CUDA_CALL(cudaFree(reinterpret_cast<void*>(Ad)))
+  CUDA_CALL(cudaFree(reinterpret_cast<void*>(Bd)))
+}
+
+TEST(CodeGenCUDA3, test_of_block_reduce_logsumexp) {
+  Context::Global().ResetNameId();
+  const int m = 16;
+  const int k = 4096;
+
+  Target target = common::DefaultNVGPUTarget();
+
+  auto A  = lang::CreatePlaceHolder({Expr(m), Expr(k)}, Float(32), "A1");
+  auto k1 = Var(k, "k1");
+  auto B  = Compute(
+      {Expr(m)}, [&](Var i) { return lang::ReduceLogSumExp(A(i, k1), {k1}); }, "B1");
+
+  auto stages = CreateStages({A, B});
+  hlir::pe::CudaScheduleReduce(stages, B, target);
+
+  auto func = Lower("block_reduce_logsumexp", stages, {A, B}, {}, {}, nullptr, target);
+  ASSERT_EQ(func->cuda_axis_info.grid_dim(0), m);
+
+  Module::Builder builder("module", target);
+  builder.AddFunction(func);
+
+  CodeGenCUDA_Dev codegen(target);
+  auto source_code = codegen.Compile(builder.Build());
+  LOG(INFO) << "compiled block reduce code:\n\n\n" << source_code;
+  ASSERT_NE(source_code.find("cinn_block_reduce_logsumexp_fp32"), std::string::npos);
+
+  using runtime::cuda::CUDAModule;
+
+  backends::NVRTC_Compiler compiler;
+
+  auto ptx = compiler(source_code);
+  CHECK(!ptx.empty());
+
+  CUDAModule cuda_module(ptx, CUDAModule::Kind::PTX);
+
+  // the exponents of the elements overflow float32, which the online normalizer never computes
+  std::vector<float> host_a(m * k), host_b(m, 0);
+  for (auto& v : host_a) v = 100.f * static_cast<float>(rand()) / INT_MAX;  // NOLINT
+
+  CUdeviceptr Ad, Bd;
+  cuMemAlloc(&Ad, m * k * sizeof(float));
+  cuMemAlloc(&Bd, m * sizeof(float));
+  CUDA_CALL(cudaMemcpy(reinterpret_cast<void*>(Ad), host_a.data(), m * k * sizeof(float), cudaMemcpyHostToDevice));
+
+  void* args[] = {&Ad, &Bd};
+
+  dim3 grid(m, 1, 1);
+  dim3 block(func->cuda_axis_info.block_dim(0), 1, 1);
+  cuda_module.LaunchKernel(0, "block_reduce_logsumexp", grid, block, args);
+
+  CUDA_CALL(cudaMemcpy(host_b.data(), reinterpret_cast<void*>(Bd), m * sizeof(float), cudaMemcpyDeviceToHost));
+  for (int i = 0; i < m; i++) {
+    double max_value = *std::max_element(host_a.begin() + i * k, host_a.begin() + (i + 1) * k);
+    double sum       = 0;
+    for (int x = 0; x < k; x++) {
+      sum += std::exp(host_a[i * k + x] - max_value);
+    }
+    EXPECT_NEAR(host_b[i], max_value + std::log(sum), 1e-3);
+  }
+
+  CUDA_CALL(cudaFree(reinterpret_cast<void*>(Ad)))
+  CUDA_CALL(cudaFree(reinterpret_cast<void*>(Bd)))
+}
+
+TEST(CodeGenCUDA3, test_of_cached_reduce) {
+  Context::Global().ResetNameId();
+  const int m = 4096;
+  const int k = 64;
+
+  Target target = common::DefaultNVGPUTarget();
+
+  auto A  = lang::CreatePlaceHolder({Expr(m), Expr(k)}, Float(32), "A2");
+  auto V  = lang::CreatePlaceHolder({Expr(k)}, Float(32), "V2");
+  auto k1 = Var(k, "k1");
+  auto B  = Compute(
+      {Expr(m)}, [&](Var i) { return lang::ReduceSum(A(i, k1) * V(k1), {k1}); }, "B2");
+
+  auto stages = CreateStages({A, V, B});
+  // the sums are accumulated in the registers, and the vector read by all the threads is in the shared memory
+  B = hlir::pe::CudaScheduleCachedReduce(stages, B, target);
+
+  auto func = Lower("cached_reduce", stages, {A, V, B}, {}, {}, nullptr, target);
+
+  Module::Builder builder("module", target);
+  builder.AddFunction(func);
+
+  CodeGenCUDA_Dev codegen(target);
+  auto source_code = codegen.Compile(builder.Build());
+  LOG(INFO) << "compiled cached reduce code:\n\n\n" << source_code;
+  ASSERT_NE(source_code.find("__shared__"), std::string::npos);
+  ASSERT_NE(source_code.find("__syncthreads"), std::string::npos);
+
+  using runtime::cuda::CUDAModule;
+
+  backends::NVRTC_Compiler compiler;
+
+  auto ptx = compiler(source_code);
+  CHECK(!ptx.empty());
+
+  CUDAModule cuda_module(ptx, CUDAModule::Kind::PTX);
+
+  std::vector<float> host_a(m * k), host_v(k), host_b(m, 0);
+  for (auto& v : host_a) v = static_cast<float>(rand()) / INT_MAX;  // NOLINT
+  for (auto& v : host_v) v = static_cast<float>(rand()) / INT_MAX;  // NOLINT
+
+  CUdeviceptr Ad, Vd, Bd;
+  cuMemAlloc(&Ad, m * k * sizeof(float));
+  cuMemAlloc(&Vd, k * sizeof(float));
+  cuMemAlloc(&Bd, m * sizeof(float));
+  CUDA_CALL(cudaMemcpy(reinterpret_cast<void*>(Ad), host_a.data(), m * k * sizeof(float), cudaMemcpyHostToDevice));
+  CUDA_CALL(cudaMemcpy(reinterpret_cast<void*>(Vd), host_v.data(), k * sizeof(float), cudaMemcpyHostToDevice));
+
+  void* args[] = {&Ad, &Vd, &Bd};
+
+  dim3 grid(func->cuda_axis_info.grid_dim(0), 1, 1);
+  dim3 block(func->cuda_axis_info.block_dim(0), 1, 1);
+  cuda_module.LaunchKernel(0, "cached_reduce", grid, block, args);
+
+  CUDA_CALL(cudaMemcpy(host_b.data(), reinterpret_cast<void*>(Bd), m * sizeof(float), cudaMemcpyDeviceToHost));
+  for (int i = 0; i < m; i++) {
+    float res = 0;
+    for (int x = 0; x < k; x++) {
+      res += host_a[i * k + x] * host_v[x];
+    }
+    EXPECT_NEAR(host_b[i], res, 1e-3);
+  }
+
+  CUDA_CALL(cudaFree(reinterpret_cast<void*>(Ad)))
+  CUDA_CALL(cudaFree(reinterpret_cast<void*>(Vd)))
+  CUDA_CALL(cudaFree(reinterpret_cast<void*>(Bd)))
+}
+
+TEST(CodeGenCUDA3, test_of_vectorized_injective) {
+  Context::Global().ResetNameId();
+  Expr M(128);
+  Expr N(256);
+
+  Target target = common::DefaultNVGPUTarget();
+
+  Placeholder<float> A("A1", {M, N});
+  Placeholder<float> B("B1", {M, N});
+
+  auto C = Compute(
+      {M, N}, [&](Var i, Var j) { return ir::Max::Make(A(i, j) + B(i, j), Expr(0.f)); }, "C1");
+
+  auto stages = CreateStages({A, B, C});
+  std::vector<int> shape{M.as_int32(), N.as_int32()};
+  int lanes = hlir::pe::GetCudaInjectiveLanes(stages[C]->tensor(), shape);
+  ASSERT_EQ(lanes, 4);
+  hlir::pe::CudaScheduleInjective(stages[C], shape, target);
+
+  auto func = Lower("vectorized_injective", stages, {A, B, C}, {}, {}, nullptr, target);
+
+  Module::Builder builder("module", target);
+  builder.AddFunction(func);
+
+  CodeGenCUDA_Dev codegen(target);
+  auto source_code = codegen.Compile(builder.Build());
+  LOG(INFO) << "compiled vectorized injective code:\n\n\n" << source_code;
+  // the aligned float4 are loaded and stored by single instructions
+  ASSERT_NE(source_code.find("reinterpret_cast<const float4*>(A1"), std::string::npos);
+  ASSERT_NE(source_code.find("reinterpret_cast<float4*>(C1"), std::string::npos);
+
+  using runtime::cuda::CUDAModule;
+
+  backends::NVRTC_Compiler compiler;
+
+  auto ptx = compiler(source_code);
+  CHECK(!ptx.empty());
+
+  CUDAModule cuda_module(ptx, CUDAModule::Kind::PTX);
+
+  auto _Ad_Bd_Cd_host_data1_host_data2_host_data3_ = CreateNVMemory(M.as_int32(), N.as_int32());
+  auto& Ad                                         = std::get<0>(_Ad_Bd_Cd_host_data1_host_data2_host_data3_);
+  auto& Bd                                         = std::get<1>(_Ad_Bd_Cd_host_data1_host_data2_host_data3_);
+  auto& Cd                                         = std::get<2>(_Ad_Bd_Cd_host_data1_host_data2_host_data3_);
+  auto& host_data1                                 = std::get<3>(_Ad_Bd_Cd_host_data1_host_data2_host_data3_);
+  auto& host_data2                                 = std::get<4>(_Ad_Bd_Cd_host_data1_host_data2_host_data3_);
+  auto& host_data3                                 = std::get<5>(_Ad_Bd_Cd_host_data1_host_data2_host_data3_);
+
+  void* args[] = {&Ad, &Bd, &Cd};
+
+  auto& axis_info = func->cuda_axis_info;
+  dim3 grid(axis_info.grid_dim(0), axis_info.grid_dim(1), axis_info.grid_dim(2));
+  dim3 block(axis_info.block_dim(0), axis_info.block_dim(1), axis_info.block_dim(2));
+  cuda_module.LaunchKernel(0, "vectorized_injective", grid, block, args);
+
+  CUDA_CALL(cudaMemcpy(host_data3.data(),
+                       reinterpret_cast<void*>(Cd),
+                       M.as_int32() * N.as_int32() * sizeof(float),
+                       cudaMemcpyDeviceToHost));
+  for (int i = 0; i < M.as_int32() * N.as_int32(); i++) {
+    EXPECT_NEAR(host_data3[i], std::max(host_data1[i] + host_data2[i], 0.f), 1e-5);
+  }
+}
+
 class ElementwiseTester {
  public:
   Expr N{212};
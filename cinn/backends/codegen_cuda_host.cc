@@ -23,8 +23,6 @@
 namespace cinn {
 namespace backends {
 
-const int kArgsArrayMaxLen = 20;
-
 llvm::Value* CodeGenCUDA_Host::LowerGPUKernelLauncher(const ir::_LoweredFunc_* func) {
   CHECK(func->cuda_axis_info.valid());
   /* The current function definiton is
@@ -0,0 +1,184 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/backends/compilation_cache.h"
+
+#include <glog/logging.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/SHA1.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <unordered_map>
+
+DEFINE_string(cinn_compilation_cache_dir,
+              "",
+              "The directory to cache the compiled code across processes, the cache is disabled if it is empty.");
+
+DEFINE_int32(cinn_compilation_cache_memory_mb,
+             0,
+             "The megabytes of the compiled code cached in the memory of the process, e.g. to skip compiling the same "
+             "modules again when a script or a notebook cell reruns, 0 to disable it.");
+
+namespace cinn {
+namespace backends {
+
+namespace {
+// Create the directory and its parents, like `mkdir -p`.
+bool MakeDirs(const std::string& dir) {
+  for (size_t pos = dir.find('/', 1); pos != std::string::npos; pos = dir.find('/', pos + 1)) {
+    std::string parent = dir.substr(0, pos);
+    if (mkdir(parent.c_str(), 0755) != 0 && errno != EEXIST) return false;
+  }
+  return mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+// The entries kept in the memory of the process, in the order of their insertion to evict the oldest ones first.
+struct MemoryCache {
+  std::mutex mutex;
+  std::unordered_map<std::string, std::string> entries;
+  std::deque<std::string> order;
+  size_t bytes{0};
+
+  static MemoryCache& Global() {
+    static auto* cache = new MemoryCache;
+    return *cache;
+  }
+};
+}  // namespace
+
+std::string CompilationCache::Key(const std::string& kind, const std::vector<std::string>& parts) {
+  llvm::SHA1 sha1;
+  auto update = [&](const std::string& part) {
+    // Hash the size before each part, so that moving the content between the parts changes the key.
+    std::string size = std::to_string(part.size()) + ":";
+    sha1.update(llvm::StringRef(size));
+    sha1.update(llvm::StringRef(part));
+  };
+  update(kVersion);
+  update(kind);
+  for (auto& part : parts) update(part);
+
+  std::string key;
+  char hex[3];
+  for (uint8_t byte : sha1.final()) {
+    snprintf(hex, sizeof(hex), "%02x", byte);
+    key += hex;
+  }
+  return key + "." + kind;
+}
+
+bool CompilationCache::LoadFromMemory(const std::string& key, std::string* data) const {
+  if (!memory_bytes_) return false;
+  auto& cache = MemoryCache::Global();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  auto it = cache.entries.find(key);
+  if (it == cache.entries.end()) return false;
+  *data = it->second;
+  return true;
+}
+
+void CompilationCache::StoreToMemory(const std::string& key, const std::string& data) const {
+  if (!memory_bytes_ || data.size() > memory_bytes_) return;
+  auto& cache = MemoryCache::Global();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  auto it = cache.entries.find(key);
+  if (it != cache.entries.end()) {
+    cache.bytes -= it->second.size();
+    cache.entries.erase(it);
+    cache.order.erase(std::find(cache.order.begin(), cache.order.end(), key));
+  }
+  cache.entries.emplace(key, data);
+  cache.order.push_back(key);
+  cache.bytes += data.size();
+  // The new entry fits alone, so it is never evicted here.
+  while (cache.bytes > memory_bytes_) {
+    auto evicted = cache.entries.find(cache.order.front());
+    cache.bytes -= evicted->second.size();
+    cache.entries.erase(evicted);
+    cache.order.pop_front();
+  }
+}
+
+void CompilationCache::ClearMemory() {
+  auto& cache = MemoryCache::Global();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.entries.clear();
+  cache.order.clear();
+  cache.bytes = 0;
+}
+
+size_t CompilationCache::MemoryBytes() {
+  auto& cache = MemoryCache::Global();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  return cache.bytes;
+}
+
+bool CompilationCache::Load(const std::string& key, std::string* data) const {
+  if (!enabled()) return false;
+  if (LoadFromMemory(key, data)) {
+    VLOG(3) << "Load " << key << " from the compilation cache in memory";
+    return true;
+  }
+  if (dir_.empty()) return false;
+  std::ifstream ifs(Path(key), std::ios::binary);
+  if (!ifs) return false;
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  if (ifs.bad()) return false;
+  *data = ss.str();
+  StoreToMemory(key, *data);
+  VLOG(3) << "Load " << key << " from the compilation cache";
+  return true;
+}
+
+bool CompilationCache::Store(const std::string& key, const std::string& data) const {
+  if (!enabled()) return false;
+  StoreToMemory(key, data);
+  if (dir_.empty()) return memory_bytes_ >= data.size();
+  if (!MakeDirs(dir_)) {
+    LOG(WARNING) << "Failed to create the compilation cache directory " << dir_;
+    return false;
+  }
+  // The temporary file is unique among the processes and the threads.
+  static std::atomic<int> counter{0};
+  std::string tmp_path = Path(key) + ".tmp" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+  {
+    std::ofstream ofs(tmp_path, std::ios::binary);
+    ofs.write(data.data(), data.size());
+    if (!ofs) {
+      LOG(WARNING) << "Failed to write the compilation cache " << tmp_path;
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), Path(key).c_str()) != 0) {
+    LOG(WARNING) << "Failed to write the compilation cache " << Path(key);
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  VLOG(3) << "Store " << key << " to the compilation cache";
+  return true;
+}
+
+}  // namespace backends
+}  // namespace cinn
@@ -0,0 +1,89 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+DECLARE_string(cinn_compilation_cache_dir);
+DECLARE_int32(cinn_compilation_cache_memory_mb);
+
+namespace cinn {
+namespace backends {
+
+/**
+ * A content-addressed cache of the compiled code on disk, e.g. the objects of the LLVM JIT and the PTX of NVRTC, so
+ * that a new process can skip compiling the modules compiled before. The entries are keyed by a hash of everything
+ * affecting the compiled code, and each one is stored in a file named by the key.
+ *
+ * An entry is written to a temporary file and renamed to its key, so that the processes sharing a cache directory
+ * never see a partial entry.
+ *
+ * The entries can also be kept in the memory of the process, shared by all the caches of it, so that compiling the same
+ * module again, e.g. rerunning a script defining the kernels in a notebook, skips the compiler without a directory. The
+ * memory tier evicts the oldest entries beyond its capacity.
+ */
+class CompilationCache {
+ public:
+  //! The version of the compiled code, bump it when the code generated for the same inputs changes.
+  static constexpr const char* kVersion = "cinn-compilation-cache-v1";
+
+  explicit CompilationCache(std::string dir, size_t memory_bytes = 0)
+      : dir_(std::move(dir)), memory_bytes_(memory_bytes) {}
+
+  //! The cache in the directory given by FLAGS_cinn_compilation_cache_dir and the memory of
+  //! FLAGS_cinn_compilation_cache_memory_mb, it is disabled if neither is set.
+  static CompilationCache Default() {
+    return CompilationCache(FLAGS_cinn_compilation_cache_dir,
+                            static_cast<size_t>(std::max(FLAGS_cinn_compilation_cache_memory_mb, 0)) << 20);
+  }
+
+  bool enabled() const { return !dir_.empty() || memory_bytes_ > 0; }
+
+  /**
+   * Get the key of an entry.
+   * @param kind The kind of the compiled code, e.g. "llvm" or "ptx", which is used as the suffix of the file.
+   * @param parts Everything affecting the compiled code, e.g. the source code, the target and the compiler flags.
+   */
+  static std::string Key(const std::string& kind, const std::vector<std::string>& parts);
+
+  //! Load the entry of \p key to \p data from the memory, or else the directory, return false if it is not cached.
+  bool Load(const std::string& key, std::string* data) const;
+
+  //! Store \p data to the entry of \p key, return false if failed, the cache is only a hint so it isn't fatal.
+  bool Store(const std::string& key, const std::string& data) const;
+
+  //! Drop the entries kept in the memory of the process.
+  static void ClearMemory();
+
+  //! The bytes of the entries kept in the memory of the process.
+  static size_t MemoryBytes();
+
+ private:
+  std::string Path(const std::string& key) const { return dir_ + "/" + key; }
+
+  bool LoadFromMemory(const std::string& key, std::string* data) const;
+  void StoreToMemory(const std::string& key, const std::string& data) const;
+
+  std::string dir_;
+  size_t memory_bytes_;
+};
+
+}  // namespace backends
+}  // namespace cinn
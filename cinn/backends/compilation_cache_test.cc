@@ -0,0 +1,91 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/backends/compilation_cache.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace cinn {
+namespace backends {
+
+TEST(CompilationCache, key) {
+  auto key = CompilationCache::Key("ptx", {"code", "-arch=compute_70"});
+  EXPECT_EQ(key, CompilationCache::Key("ptx", {"code", "-arch=compute_70"}));
+  EXPECT_NE(key, CompilationCache::Key("ptx", {"code", "-arch=compute_80"}));
+  EXPECT_NE(key, CompilationCache::Key("llvm", {"code", "-arch=compute_70"}));
+  // Moving the content between the parts changes the key.
+  EXPECT_NE(key, CompilationCache::Key("ptx", {"code-", "arch=compute_70"}));
+  EXPECT_EQ(key.substr(key.size() - 4), ".ptx");
+}
+
+TEST(CompilationCache, store_and_load) {
+  std::string dir = "./compilation_cache_test_" + std::to_string(getpid()) + "/nested";
+  CompilationCache cache(dir);
+  ASSERT_TRUE(cache.enabled());
+
+  auto key = CompilationCache::Key("llvm", {"module"});
+  std::string data;
+  EXPECT_FALSE(cache.Load(key, &data));
+
+  std::string object("object\0with\0zeros", 17);
+  ASSERT_TRUE(cache.Store(key, object));
+  ASSERT_TRUE(cache.Load(key, &data));
+  EXPECT_EQ(data, object);
+
+  // Another cache in the same directory, e.g. in a new process, sees the entry.
+  ASSERT_TRUE(CompilationCache(dir).Load(key, &data));
+  EXPECT_EQ(data, object);
+}
+
+TEST(CompilationCache, disabled) {
+  CompilationCache cache("");
+  EXPECT_FALSE(cache.enabled());
+  auto key = CompilationCache::Key("llvm", {"module"});
+  std::string data;
+  EXPECT_FALSE(cache.Store(key, "object"));
+  EXPECT_FALSE(cache.Load(key, &data));
+}
+
+TEST(CompilationCache, memory) {
+  CompilationCache::ClearMemory();
+  CompilationCache cache("", 16);
+  ASSERT_TRUE(cache.enabled());
+
+  auto key0 = CompilationCache::Key("llvm", {"module0"});
+  auto key1 = CompilationCache::Key("llvm", {"module1"});
+  std::string data;
+  EXPECT_FALSE(cache.Load(key0, &data));
+  ASSERT_TRUE(cache.Store(key0, "object0"));
+  // The entries are shared by the caches of the process.
+  ASSERT_TRUE(CompilationCache("", 16).Load(key0, &data));
+  EXPECT_EQ(data, "object0");
+
+  // The oldest entry is evicted beyond the capacity, and the ones larger than it are not kept.
+  ASSERT_TRUE(cache.Store(key1, "object1-"));
+  ASSERT_TRUE(cache.Store(key1, "object1--"));
+  EXPECT_EQ(CompilationCache::MemoryBytes(), 16UL);
+  ASSERT_TRUE(cache.Store(CompilationCache::Key("llvm", {"module2"}), "object2"));
+  EXPECT_FALSE(cache.Load(key0, &data));
+  ASSERT_TRUE(cache.Load(key1, &data));
+  EXPECT_EQ(data, "object1--");
+  EXPECT_FALSE(cache.Store(key0, std::string(17, 'x')));
+  CompilationCache::ClearMemory();
+  EXPECT_FALSE(cache.Load(key1, &data));
+}
+
+}  // namespace backends
+}  // namespace cinn
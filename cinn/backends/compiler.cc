@@ -14,24 +14,120 @@
 
 #include "cinn/backends/compiler.h"
 
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "cinn/backends/compilation_cache.h"
 #include "cinn/backends/llvm/runtime_symbol_registry.h"
+#include "cinn/backends/remote_compiler.h"
+#include "cinn/utils/thread_pool.h"
+
+DEFINE_bool(cinn_tiered_compile,
+            false,
+            "Whether to compile the CPU modules at -O1 first for the immediate use, and swap the functions for those "
+            "compiled at -O3 on a background thread once they are ready");
+
 #ifdef CINN_WITH_CUDA
+#include <nvrtc.h>
+
 #include "cinn/backends/codegen_cuda_dev.h"
 #include "cinn/backends/codegen_cuda_host.h"
 #include "cinn/backends/codegen_cuda_util.h"
 #include "cinn/backends/nvrtc_util.h"
+#include "cinn/common/context.h"
 #include "cinn/runtime/cuda/cuda_module.h"
 #include "cinn/runtime/cuda/cuda_util.h"
+#include "cinn/utils/string.h"
 #endif
 
 namespace cinn {
 namespace backends {
 using ir::Module;
 
+namespace {
+// Split the modules into more shards than the threads, to balance the load when the functions vary in cost.
+constexpr int kShardsPerThread = 4;
+
+// Split the functions of \p module into at most \p num_shards modules of contiguous functions.
+std::vector<Module> SplitModule(const Module& module, int num_shards) {
+  auto functions = module.functions();
+  num_shards     = std::max(1, std::min<int>(num_shards, functions.size()));
+  std::vector<Module> shards;
+  for (int i = 0; i < num_shards; i++) {
+    Module::Builder builder(module.name() + "_shard" + std::to_string(i), module.target());
+    if (i == 0) {
+      for (auto& buffer : module.buffers()) builder.AddBuffer(buffer);
+    }
+    int begin = functions.size() * i / num_shards;
+    int end   = functions.size() * (i + 1) / num_shards;
+    for (int j = begin; j < end; j++) builder.AddFunction(functions[j]);
+    shards.push_back(builder.Build());
+  }
+  return shards;
+}
+
+#ifdef CINN_WITH_CUDA
+// Compile the CUDA source code to PTX or CUBIN in \p mode, or load it from the disk cache, it is thread-safe.
+std::string CompileCudaSource(const std::string& source_code, common::PrecisionMode mode) {
+  backends::NVRTC_Compiler compiler(mode);
+
+  // The PTX or CUBIN depends on the source code, the compile options containing the device architecture, the math
+  // options and the kind, the CINN runtime header included by the source code and the NVRTC version.
+  auto cache = CompilationCache::Default();
+  std::string cache_key;
+  if (cache.enabled()) {
+    std::ifstream ifs(common::Context::Global().runtime_include_dir() + "/cinn_cuda_runtime_source.cuh");
+    std::stringstream runtime_header;
+    runtime_header << ifs.rdbuf();
+    int nvrtc_major, nvrtc_minor;
+    NVRTC_CALL(nvrtcVersion(&nvrtc_major, &nvrtc_minor));
+    cache_key = CompilationCache::Key("ptx",
+                                      {source_code,
+                                       utils::Join(compiler.GetCompileOptions(true), " "),
+                                       runtime_header.str(),
+                                       std::to_string(nvrtc_major) + "." + std::to_string(nvrtc_minor)});
+  }
+
+  std::string ptx;
+  if (!cache.Load(cache_key, &ptx)) {
+    // the service compiles with its own include paths
+    if (!CompileRemotely("ptx", source_code, compiler.GetCompileOptions(false), &ptx)) ptx = compiler(source_code);
+    CHECK(!ptx.empty());
+    cache.Store(cache_key, ptx);
+  }
+  return ptx;
+}
+#endif
+}  // namespace
+
+Compiler::Compiler(const Target& target) : target_(target), tiered_(FLAGS_cinn_tiered_compile && target.is_cpu()) {
+  ExecutionOptions options = EngineOptions();
+  if (tiered_) options.opt_level = 1;
+  engine_ = ExecutionEngine::Create(options);
+}
+
+ExecutionOptions Compiler::EngineOptions() const {
+  ExecutionOptions options;
+  options.precision_mode = precision_mode_;
+  return options;
+}
+
+void Compiler::SetPrecisionMode(common::PrecisionMode mode) {
+  // the background compilation creates the optimized engine
+  WaitOptimized();
+  precision_mode_ = mode;
+  engine_->SetPrecisionMode(mode);
+  if (optimized_engine_) optimized_engine_->SetPrecisionMode(mode);
+}
+
+Compiler::~Compiler() { WaitOptimized(); }
+
 void Compiler::Build(const Module& module, const std::string& code) {
   if (target_.arch == Target::Arch::NVGPU) {
     CompileCudaModule(module, code);
-  } else if (target_.arch == Target::Arch::X86) {
+  } else if (target_.is_cpu()) {
     CompileX86Module(module);
   } else {
     CINN_NOT_IMPLEMENTED
@@ -58,7 +154,7 @@ std::string Compiler::GetSourceCode(const ir::Module& module) {
 void Compiler::BuildDefault(const Module& module) {
   if (target_.arch == Target::Arch::NVGPU) {
     CompileCudaModule(module);
-  } else if (target_.arch == Target::Arch::X86) {
+  } else if (target_.is_cpu()) {
     CompileX86Module(module);
   } else {
     CINN_NOT_IMPLEMENTED
@@ -74,23 +170,97 @@ void Compiler::CompileCudaModule(const Module& module, const std::string& code)
 
   {  // compile cuda device
     LOG(INFO) << "[CUDA] device module:\n" << device_module;
-    CodeGenCUDA_Dev codegen(target_);
-    auto source_code = codegen.Compile(device_module);
-    if (!code.empty()) source_code = code;
-    LOG(INFO) << "[CUDA] source code:\n" << source_code;
     using runtime::cuda::CUDAModule;
 
-    backends::NVRTC_Compiler compiler;
+    // The attached code replaces the whole device module, so it can't be split.
+    std::vector<Module> device_shards{device_module};
+    if (num_threads_ > 1 && code.empty()) {
+      device_shards = SplitModule(device_module, num_threads_ * kShardsPerThread);
+    }
+    std::vector<std::string> ptxs(device_shards.size());
+    auto compile_shard = [&](int i) {
+      CodeGenCUDA_Dev codegen(target_);
+      auto source_code = codegen.Compile(device_shards[i]);
+      if (!code.empty()) source_code = code;
+      LOG(INFO) << "[CUDA] source code:\n" << source_code;
+      ptxs[i] = CompileCudaSource(source_code, precision_mode_);
+    };
+    if (device_shards.size() == 1) {
+      compile_shard(0);
+    } else {
+      utils::ThreadPool pool(num_threads_);
+      for (int i = 0; i < device_shards.size(); i++) {
+        pool.Schedule([&, i] { compile_shard(i); });
+      }
+    }
 
-    auto ptx = compiler(source_code);
-    CHECK(!ptx.empty());
+    device_code_.ptxs = std::move(ptxs);
+    device_code_.kernel_names.clear();
+    for (auto& shard : device_shards) {
+      std::vector<std::string> kernel_names;
+      for (auto& fn : shard.functions()) kernel_names.push_back(fn->name);
+      device_code_.kernel_names.push_back(std::move(kernel_names));
+    }
+    LoadCudaModules();
+  }
+
+  {  // compile host jit
+    engine_ = ExecutionEngine::Create(EngineOptions());
+    engine_->Link<CodeGenCUDA_Host>(host_module);
+  }
 
-    // TODO(Superjomn) Whether to support multiple CUDA modules?
-    cuda_module_.reset(new CUDAModule(ptx, CUDAModule::Kind::PTX));
+#else
+  CINN_NOT_IMPLEMENTED
+#endif
+}
+
+void Compiler::SetEntryFunction(const std::string& name, const std::vector<std::string>& callees) {
+  CHECK(target_.is_cpu()) << "The entry function is only supported on the CPUs";
+  entry_name_    = name;
+  entry_callees_ = callees;
+}
+
+void Compiler::CompileX86Module(const Module& module) {
+  if (!entry_name_.empty()) {
+    // The entry function reads its arguments from the global arrays of its own module, so it is never swapped.
+    engine_->SetEntryFunction(entry_name_, entry_callees_);
+    entry_name_.clear();
+    entry_callees_.clear();
+    engine_->Link<CodeGenX86>(module);
+    return;
+  }
+  LinkX86Module(engine_.get(), module);
+  if (!tiered_ || engine_->lazy()) return;
+
+  // The modules of the successive Builds are compiled in order, so the optimized engine links all of them.
+  if (optimize_thread_.joinable()) optimize_thread_.join();
+  optimize_thread_ = std::thread([this, module] {
+    if (!optimized_engine_) optimized_engine_ = ExecutionEngine::Create(EngineOptions());
+    LinkX86Module(optimized_engine_.get(), module);
+    VLOG(3) << "The functions of " << module.name() << " are compiled at -O3";
+    std::lock_guard<std::mutex> lock(mu_);
+    optimized_ = true;
+    for (auto& callback : optimized_callbacks_) callback.second();
+  });
+}
+
+void Compiler::LinkX86Module(ExecutionEngine* engine, const Module& module) {
+  if (num_threads_ > 1 && module.functions().size() > 1) {
+    engine->LinkParallel<CodeGenX86>(SplitModule(module, num_threads_ * kShardsPerThread), num_threads_);
+  } else {
+    engine->Link<CodeGenX86>(module);
+  }
+}
 
-    for (auto& fn : device_module.functions()) {
-      std::string kernel_fn_name = fn->name;
-      auto fn_kernel             = cuda_module_->GetFunction(0, kernel_fn_name);
+#ifdef CINN_WITH_CUDA
+void Compiler::LoadCudaModules() {
+  using runtime::cuda::CUDAModule;
+  cuda_modules_.clear();
+  for (int i = 0; i < device_code_.ptxs.size(); i++) {
+    auto& binary = device_code_.ptxs[i];
+    cuda_modules_.emplace_back(new CUDAModule(binary, CUDAModule::KindOf(binary)));
+    for (auto& kernel_fn_name : device_code_.kernel_names[i]) {
+      auto fn_kernel = cuda_modules_.back()->GetFunction(0, kernel_fn_name);
       CHECK(fn_kernel);
 
       backends::RuntimeSymbolRegistry::Global().RegisterVar(kernel_fn_name + "_ptr_",
@@ -99,21 +269,46 @@ void Compiler::CompileCudaModule(const Module& module, const std::string& code)
       backends::RuntimeSymbolRegistry::Global().RegisterVar(kernel_fn_name + "_stream_ptr_", stream);
     }
   }
+}
+#endif
 
-  {  // compile host jit
-    engine_ = ExecutionEngine::Create(ExecutionOptions());
-    engine_->Link<CodeGenCUDA_Host>(host_module);
-  }
+CompiledCode Compiler::GetCompiledCode() {
+  CHECK(!engine_->lazy()) << "The functions compiled lazily have no objects to save, unset --cinn_llvm_lazy_compile";
+  WaitOptimized();
+  CompiledCode code = device_code_;
+  code.objects      = optimized_ ? optimized_engine_->objects() : engine_->objects();
+  return code;
+}
 
+void Compiler::Load(const CompiledCode& code) {
+  CHECK_EQ(code.ptxs.size(), code.kernel_names.size());
+  if (!code.ptxs.empty()) {
+#ifdef CINN_WITH_CUDA
+    device_code_ = code;
+    device_code_.objects.clear();
+    LoadCudaModules();
 #else
-  CINN_NOT_IMPLEMENTED
+    LOG(FATAL) << "The code with CUDA modules can't be loaded without CUDA";
 #endif
+  }
+  // The engine resolves the kernel symbols registered above when it is created.
+  WaitOptimized();
+  optimized_engine_.reset();
+  optimized_ = false;
+  engine_    = ExecutionEngine::Create(EngineOptions());
+  for (auto& object : code.objects) {
+    CHECK(engine_->AddObject(object)) << "Invalid object file in the compiled code";
+  }
 }
 
-void Compiler::CompileX86Module(const Module& module) { engine_->Link<CodeGenX86>(module); }
-
 void Compiler::ExportObject(const std::string& path) { engine_->ExportObject(path); }
 
+void Compiler::ExportStaticLibrary(const std::string& path, const std::map<std::string, std::string>& data) {
+  CHECK(target_.arch == Target::Arch::X86) << "Only the X86 code can be exported as a static library";
+  WaitOptimized();
+  (optimized_ ? optimized_engine_ : engine_)->ExportStaticLibrary(path, data);
+}
+
 lower_func_ptr_t Compiler::Lookup(absl::string_view fn_name) {
   CHECK(engine_);
   if (engine_->Lookup(fn_name) != nullptr) {
@@ -122,5 +317,25 @@ lower_func_ptr_t Compiler::Lookup(absl::string_view fn_name) {
   return nullptr;
 }
 
+lower_func_ptr_t Compiler::LookupOptimized(absl::string_view fn_name) {
+  if (!optimized_) return nullptr;
+  return reinterpret_cast<lower_func_ptr_t>(optimized_engine_->Lookup(fn_name));
+}
+
+void Compiler::AddOptimizedCallback(const void* key, std::function<void()> callback) {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (optimized_) callback();
+  optimized_callbacks_[key] = std::move(callback);
+}
+
+void Compiler::RemoveOptimizedCallback(const void* key) {
+  std::lock_guard<std::mutex> lock(mu_);
+  optimized_callbacks_.erase(key);
+}
+
+void Compiler::WaitOptimized() {
+  if (optimize_thread_.joinable()) optimize_thread_.join();
+}
+
 }  // namespace backends
 }  // namespace cinn
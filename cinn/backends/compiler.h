@@ -15,9 +15,16 @@
 #pragma once
 
 #include <absl/strings/string_view.h>
+#include <gflags/gflags.h>
 
+#include <atomic>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "cinn/backends/llvm/codegen_llvm.h"
 #include "cinn/backends/llvm/execution_engine.h"
@@ -27,9 +34,24 @@
 #include "cinn/runtime/cuda/cuda_module.h"
 #endif
 
+DECLARE_bool(cinn_tiered_compile);
+
 namespace cinn {
 namespace backends {
 
+/**
+ * The code compiled from a module, which is enough to restore the compiled functions in another process without
+ * compiling again.
+ */
+struct CompiledCode {
+  //! The object files linked by the host JIT.
+  std::vector<std::string> objects;
+  //! The PTX or CUBIN of each CUDA module, the CUBIN only loads on the devices of the architecture it is compiled for.
+  std::vector<std::string> ptxs;
+  //! The names of the kernels in each CUDA module.
+  std::vector<std::vector<std::string>> kernel_names;
+};
+
 class Compiler final {
  public:
   static std::unique_ptr<Compiler> Create(const Target& target) {
@@ -43,6 +65,37 @@ class Compiler final {
 
   void ExportObject(const std::string& path);
 
+  //! Export the X86 code compiled, the optimized one with the tiered compilation, as a static library, see
+  //! ExecutionEngine::ExportStaticLibrary.
+  void ExportStaticLibrary(const std::string& path, const std::map<std::string, std::string>& data = {});
+
+  /**
+   * Compile on \p num_threads threads concurrently, the module is split into shards of functions that are compiled
+   * independently, e.g. into separate LLVM modules or NVRTC programs.
+   */
+  void SetNumThreads(int num_threads) { num_threads_ = num_threads; }
+
+  /**
+   * Compile the modules of the next Builds in \p mode: the fast-math flags of the LLVM code, and the math options of
+   * NVRTC, see common::PrecisionMode.
+   */
+  void SetPrecisionMode(common::PrecisionMode mode);
+
+  /**
+   * Let the next Build of an X86 module also define a function \p name calling the functions \p callees in order, see
+   * ExecutionEngine::SetEntryFunction. The module is compiled as a whole in this case, so that the callees can be
+   * inlined into it.
+   */
+  void SetEntryFunction(const std::string& name, const std::vector<std::string>& callees);
+
+  //! Get the code compiled by Build, which can be loaded by Load, the optimized one with the tiered compilation.
+  CompiledCode GetCompiledCode();
+
+  /**
+   * Restore the compiled functions from the \p code got by GetCompiledCode, instead of calling Build.
+   */
+  void Load(const CompiledCode& code);
+
   std::string GetSourceCode(const ir::Module& module);
 
   void BuildDefault(const ir::Module& module);
@@ -53,21 +106,66 @@ class Compiler final {
    */
   lower_func_ptr_t Lookup(absl::string_view fn_name);
 
+  /**
+   * With the tiered compilation(--cinn_tiered_compile) on the CPUs, Build compiles the module at -O1 for the immediate
+   * use, and compiles it again at -O3 on a background thread. Retrieve the function \p fn_name of the -O3 code, or
+   * null if it is not ready.
+   */
+  lower_func_ptr_t LookupOptimized(absl::string_view fn_name);
+
+  /**
+   * Call \p callback once the -O3 code of each Build is ready, e.g. to swap the functions called for the optimized
+   * ones, or right now if some is ready. The callbacks are called one at a time, on the background thread.
+   * @param key The key to remove the callback by.
+   */
+  void AddOptimizedCallback(const void* key, std::function<void()> callback);
+  void RemoveOptimizedCallback(const void* key);
+
+  //! Wait for the background compilation at -O3 to finish.
+  void WaitOptimized();
+
+  ~Compiler();
+
  private:
   void CompileCudaModule(const ir::Module& module, const std::string& code = "");
 
   void CompileX86Module(const ir::Module& module);
 
-  explicit Compiler(const Target& target) : target_(target), engine_(ExecutionEngine::Create(ExecutionOptions())) {}
+  void LinkX86Module(ExecutionEngine* engine, const ir::Module& module);
+
+  // The options of the engines created, which compile in precision_mode_.
+  ExecutionOptions EngineOptions() const;
+
+#ifdef CINN_WITH_CUDA
+  // Load the PTX of device_code_ and register the kernels as runtime symbols for the host JIT.
+  void LoadCudaModules();
+#endif
+
+  explicit Compiler(const Target& target);
 
   CINN_DISALLOW_COPY_AND_ASSIGN(Compiler);
 
  private:
   Target target_;
   std::unique_ptr<ExecutionEngine> engine_;
+  int num_threads_{1};
+  common::PrecisionMode precision_mode_{common::DefaultPrecisionMode()};
+  std::string entry_name_;
+  std::vector<std::string> entry_callees_;
+  // The PTX and the kernel names of the CUDA modules.
+  CompiledCode device_code_;
+
+  // The tiered compilation, engine_ holds the -O1 code, and optimized_engine_ gets the -O3 one from optimize_thread_.
+  bool tiered_{false};
+  std::unique_ptr<ExecutionEngine> optimized_engine_;
+  std::thread optimize_thread_;
+  std::atomic<bool> optimized_{false};
+  // Guard the callbacks.
+  std::mutex mu_;
+  std::map<const void*, std::function<void()>> optimized_callbacks_;
 
 #ifdef CINN_WITH_CUDA
-  std::unique_ptr<runtime::cuda::CUDAModule> cuda_module_;
+  std::vector<std::unique_ptr<runtime::cuda::CUDAModule>> cuda_modules_;
 #endif
 };
 
@@ -14,8 +14,11 @@
 
 #include "cinn/backends/compiler.h"
 
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 
 #include "cinn/cinn.h"
@@ -188,5 +191,53 @@ TEST(Compiler, sqrt) {
   compiler->Build(builder.Build());
 }
 
+TEST(Compiler, tiered) {
+  Expr M(128), N(128);
+
+  Placeholder<float> A("A", {M, N});
+  Placeholder<float> B("B", {M, N});
+  auto C = Compute(
+      {M, N}, [=](Expr i, Expr j) { return A(i, j) * B(i, j); }, "C");
+
+  auto stages = CreateStages({C});
+  auto fn     = Lower("fn_tiered", stages, {A, B, C});
+
+  ir::Module::Builder builder("tiered_module", common::DefaultHostTarget());
+  builder.AddFunction(fn);
+
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  FLAGS_cinn_tiered_compile = true;
+  auto compiler             = Compiler::Create(common::DefaultHostTarget());
+  std::atomic<int> num_optimized{0};
+  compiler->AddOptimizedCallback(&num_optimized, [&] { num_optimized++; });
+  compiler->Build(builder.Build());
+
+  // the -O1 function is ready for use right after Build
+  auto* fast_fn = compiler->Lookup("fn_tiered");
+  ASSERT_TRUE(fast_fn);
+  compiler->WaitOptimized();
+  ASSERT_EQ(num_optimized, 1);
+  auto* optimized_fn = compiler->LookupOptimized("fn_tiered");
+  ASSERT_TRUE(optimized_fn);
+  ASSERT_NE(fast_fn, optimized_fn);
+
+  auto* Ab = common::BufferBuilder(Float(32), {M.as_int32(), N.as_int32()}).set_random().Build();
+  auto* Bb = common::BufferBuilder(Float(32), {M.as_int32(), N.as_int32()}).set_random().Build();
+  auto* Cb = common::BufferBuilder(Float(32), {M.as_int32(), N.as_int32()}).set_zero().Build();
+  auto args = common::ArgsBuilder().Add(Ab).Add(Bb).Add(Cb).Build();
+
+  auto* Ad = reinterpret_cast<float*>(Ab->memory);
+  auto* Bd = reinterpret_cast<float*>(Bb->memory);
+  auto* Cd = reinterpret_cast<float*>(Cb->memory);
+  for (auto* fnp : {fast_fn, optimized_fn}) {
+    std::fill(Cd, Cd + Cb->num_elements(), 0.f);
+    fnp(args.data(), args.size());
+    for (int i = 0; i < Ab->num_elements(); i++) {
+      ASSERT_NEAR(Ad[i] * Bd[i], Cd[i], 1e-5);
+    }
+  }
+  compiler->RemoveOptimizedCallback(&num_optimized);
+}
+
 }  // namespace backends
 }  // namespace cinn
@@ -16,6 +16,9 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <cctype>
+
 #include "cinn/backends/extern_func_jit_register.h"
 #include "cinn/common/target.h"
 
@@ -52,5 +55,16 @@ std::string cuda_block_axis_name(int level) {
   return "";
 }
 
+std::string GetCudaDeviceName() {
+  int device_id = 0;
+  cudaDeviceProp prop;
+  CUDA_CALL(cudaGetDevice(&device_id));
+  CUDA_CALL(cudaGetDeviceProperties(&prop, device_id));
+  std::string name = prop.name;
+  std::replace_if(
+      name.begin(), name.end(), [](char c) { return !std::isalnum(static_cast<unsigned char>(c)); }, '_');
+  return name + "_sm" + std::to_string(prop.major) + std::to_string(prop.minor);
+}
+
 }  // namespace backends
 }  // namespace cinn
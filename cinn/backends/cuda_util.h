@@ -65,6 +65,10 @@ std::string cuda_thread_axis_name(int level);
 // CUDA syntax for block axis.
 std::string cuda_block_axis_name(int level);
 
+// The name and the compute capability of the current GPU, e.g. "Tesla_V100_SXM2_16GB_sm70", with the characters other
+// than the letters and the digits replaced by '_'.
+std::string GetCudaDeviceName();
+
 }  // namespace backends
 }  // namespace cinn
 
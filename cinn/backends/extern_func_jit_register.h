@@ -80,6 +80,7 @@ namespace backends {
 static const char* TargetToBackendRepr(Target target) {
   switch (target.arch) {
     case Target::Arch::X86:
+    case Target::Arch::ARM:
       return backend_llvm_host;
     case Target::Arch::NVGPU:
       return backend_nvgpu;
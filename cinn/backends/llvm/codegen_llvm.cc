@@ -20,6 +20,7 @@
 #include <llvm/IR/Instruction.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/IntrinsicsX86.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Metadata.h>
 #include <llvm/Support/TargetSelect.h>
@@ -33,12 +34,16 @@
 #include <type_traits>
 
 #include "cinn/backends/extern_func_emitter.h"
+#include "cinn/backends/llvm/execution_engine.h"
 #include "cinn/backends/llvm/llvm_util.h"
 #include "cinn/common/cas.h"
+#include "cinn/common/ir_util.h"
 #include "cinn/common/type.h"
 #include "cinn/ir/ir_operators.h"
 #include "cinn/ir/ir_printer.h"
 #include "cinn/ir/ir_verify.h"
+#include "cinn/optim/insert_cache_hints.h"
+#include "cinn/optim/lower_intrin.h"
 #include "cinn/runtime/cinn_runtime.h"
 #include "cinn/runtime/intrinsic.h"
 #include "cinn/utils/string.h"
@@ -66,13 +71,50 @@ auto NodeToExpr(const T *node) {
 
 bool is_integral_type(common::Type t) { return t.is_int() || t.is_uint(); }
 
-bool is_floating_type(common::Type t) { return t.is_float(); }
+bool is_floating_type(common::Type t) { return t.is_floating_point(); }
+
+//! The scalar or vector type in the shape of \p type of the \p scalar_type elements, e.g. <4 x i16> of <4 x bfloat>.
+llvm::Type *WithScalarType(llvm::Type *type, llvm::Type *scalar_type) {
+  if (auto *vec = llvm::dyn_cast<llvm::FixedVectorType>(type)) {
+    return llvm::FixedVectorType::get(scalar_type, vec->getNumElements());
+  }
+  return scalar_type;
+}
+
+bool IsBFloat16(llvm::Value *value) { return value->getType()->getScalarType()->isBFloatTy(); }
+
+/**
+ * Convert the bfloat16 \p value to float32 by its bits, the upper half of the float32 of the same value. LLVM 11 has
+ * neither the arithmetic nor the conversions of bfloat on X86, so the bfloat16 values are computed in float32.
+ */
+llvm::Value *BFloat16ToFloat32(llvm::Value *value, llvm::IRBuilder<> *b) {
+  auto *type = value->getType();
+  auto *bits = b->CreateBitCast(value, WithScalarType(type, b->getInt16Ty()));
+  bits       = b->CreateShl(b->CreateZExt(bits, WithScalarType(type, b->getInt32Ty())), 16);
+  return b->CreateBitCast(bits, WithScalarType(type, b->getFloatTy()));
+}
+
+//! Convert the float32 \p value to bfloat16, rounding to the nearest even and keeping the NaNs.
+llvm::Value *Float32ToBFloat16(llvm::Value *value, llvm::IRBuilder<> *b) {
+  auto *type    = value->getType();
+  auto *i32     = WithScalarType(type, b->getInt32Ty());
+  auto *bits    = b->CreateBitCast(value, i32);
+  auto *lsb     = b->CreateAnd(b->CreateLShr(bits, 16), 1);
+  auto *rounded = b->CreateLShr(b->CreateAdd(b->CreateAdd(bits, llvm::ConstantInt::get(i32, 0x7fff)), lsb), 16);
+  rounded       = b->CreateSelect(b->CreateFCmpUNO(value, value), llvm::ConstantInt::get(i32, 0x7fc0), rounded);
+  return b->CreateBitCast(b->CreateTrunc(rounded, WithScalarType(type, b->getInt16Ty())),
+                          WithScalarType(type, b->getBFloatTy()));
+}
 
 llvm::Value *EmitComparison(llvm::CmpInst::Predicate predicate,
                             llvm::Value *lhs,
                             llvm::Value *rhs,
                             llvm::IRBuilder<> *b) {
   llvm::Value *comparison_result{nullptr};
+  if (IsBFloat16(lhs)) {
+    lhs = BFloat16ToFloat32(lhs, b);
+    rhs = BFloat16ToFloat32(rhs, b);
+  }
   if (lhs->getType()->isIntegerTy()) {
     comparison_result = b->CreateICmp(predicate, lhs, rhs);
   } else {
@@ -191,6 +233,10 @@ llvm::Value *CodeGenLLVM::EmitBinaryOp(
       << "the types of operands of binary operation are mismatch"
       << ", lhs[" << DumpToString(*lhs) << "] " << opcode << " rhs[" << DumpToString(*rhs) << "]"
       << ", lhs_type[" << DumpToString(*lhs->getType()) << "], rhs_type[" << DumpToString(*rhs->getType()) << "]";
+  if (IsBFloat16(lhs)) {
+    auto *res = EmitBinaryOp(BFloat16ToFloat32(lhs, b_), BFloat16ToFloat32(rhs, b_), opcode, is_integral, is_signed);
+    return res ? Float32ToBFloat16(res, b_) : nullptr;
+  }
   switch (opcode) {
     case '+':
       ops = is_integral ? llvm::Instruction::BinaryOps::Add : llvm::Instruction::BinaryOps::FAdd;
@@ -229,7 +275,9 @@ llvm::Value *CodeGenLLVM::Visit(const ir::UIntImm *op) {
   return llvm::ConstantInt::get(type, op->value, false);
 }
 
-llvm::Value *CodeGenLLVM::Visit(const ir::FloatImm *op) { return llvm::ConstantFP::get(b_->getFloatTy(), op->value); }
+llvm::Value *CodeGenLLVM::Visit(const ir::FloatImm *op) {
+  return llvm::ConstantFP::get(CinnTypeToLLVMType(op->type(), m_), op->value);
+}
 
 llvm::Value *CodeGenLLVM::LLVMGenGlobalStringVar(const std::string &data) { return b_->CreateGlobalStringPtr(data); }
 
@@ -298,6 +346,8 @@ llvm::Value *CodeGenLLVM::Visit(const ir::Min *op) {
     p = ICmpSLT(lhs, rhs);
   } else if (op->type().is_uint()) {
     p = ICmpULT(lhs, rhs);
+  } else if (IsBFloat16(lhs)) {
+    p = FCmpOLT(BFloat16ToFloat32(lhs, b_), BFloat16ToFloat32(rhs, b_));
   } else /*float*/ {
     p = FCmpOLT(lhs, rhs);
   }
@@ -314,6 +364,8 @@ llvm::Value *CodeGenLLVM::Visit(const ir::Max *op) {
     p = ICmpSGT(lhs, rhs);
   } else if (op->type().is_uint()) {
     p = ICmpUGT(lhs, rhs);
+  } else if (IsBFloat16(lhs)) {
+    p = FCmpOGT(BFloat16ToFloat32(lhs, b_), BFloat16ToFloat32(rhs, b_));
   } else /*float*/ {
     p = FCmpOGT(lhs, rhs);
   }
@@ -323,6 +375,7 @@ llvm::Value *CodeGenLLVM::Visit(const ir::Max *op) {
 
 llvm::Value *CodeGenLLVM::Visit(const ir::Minus *op) {
   auto *v = Visit(&op->v());
+  if (IsBFloat16(v)) return Float32ToBFloat16(FNeg(BFloat16ToFloat32(v, b_)), b_);
   return (op->type().is_int() || op->type().is_uint()) ? Neg(v) : FNeg(v);
 }
 
@@ -340,6 +393,18 @@ llvm::Value *CodeGenLLVM::Visit(const ir::Cast *op) {
   llvm::Value *value = Visit(&op->v());
   CHECK(value) << "value is null";
 
+  // the bfloat16 values are cast through float32
+  bool to_bfloat16 = to.is_bfloat16() && !from.is_bfloat16();
+  if (from.is_bfloat16() && !to.is_bfloat16()) {
+    value  = BFloat16ToFloat32(value, b_);
+    from   = Float(32, from.lanes());
+    source = CinnTypeToLLVMType(from, m_);
+  }
+  if (to_bfloat16) {
+    to     = Float(32, to.lanes());
+    target = CinnTypeToLLVMType(to, m_);
+  }
+
   // pod_value_t cast to a value.
   if (op->v().type().is_customized_type() &&
       op->v().type().customized_type() == common::customized_type::kpod_value_t) {  // pod_value_t operator
@@ -419,7 +484,7 @@ llvm::Value *CodeGenLLVM::Visit(const ir::Cast *op) {
     value = FPCast(value, target);
   } while (false);
 
-  return value;
+  return to_bfloat16 ? Float32ToBFloat16(value, b_) : value;
 }
 
 llvm::Value *CodeGenLLVM::CreateSerialFor(const ir::For *op, int stride) {
@@ -571,6 +636,20 @@ llvm::Value *CodeGenLLVM::Visit(const ir::PolyFor *op) {
 }
 
 llvm::Value *CodeGenLLVM::Visit(const ir::Select *op) {
+  // Load the lanes of a dense vector under the mask only, those not selected may be out of the buffer.
+  auto *load = op->true_value.As<ir::Load>();
+  if (op->type().is_vector() && op->condition.type().lanes() == op->type().lanes() && load &&
+      load->tensor.as_tensor() && detail::StridedRampBase(load->index(), 1).defined()) {
+    Type type     = load->type();
+    auto *ramp    = load->index().As<ir::Ramp>();
+    auto *ptr     = CreateBufferPtr(type.ElementOf(), Visit(&load->tensor), Visit(&ramp->base));
+    auto *vec_ptr = b_->CreatePointerCast(ptr, CinnTypeToLLVMType(type, m_, true)->getPointerTo(), "get_vec_ptr");
+    int alignment = std::max(type.ElementOf().bits() / 8, 1);
+    auto *inst    = b_->CreateMaskedLoad(
+        vec_ptr, llvm::Align(alignment), Visit(&op->condition), Visit(&op->false_value), "masked_load");
+    AddTbaaMetadata(inst, load->tensor.as_tensor()->name, load->index());
+    return inst;
+  }
   return Select(Visit(&op->condition), Visit(&op->true_value), Visit(&op->false_value));
 }
 
@@ -700,19 +779,13 @@ llvm::Value *CodeGenLLVM::Visit(const ir::_Var_ *op) {
   return result;
 }
 
-void CodeGenLLVM::Scalarize(const Expr &e, std::function<void(int i, llvm::Value *v)> flambda) {
-  if (const ir::Ramp *ramp = e.As<ir::Ramp>()) {
-    for (int i = 0; i < ramp->type().lanes(); ++i) {
-      Expr offset = ramp->base + (ramp->stride * i);
-      VLOG(3) << "offset: " << offset;
-      flambda(i, Visit(&offset));
-    }
-  } else {
-    llvm::Value *value = Visit(&e);
-    for (int i = 0; i < e->type().lanes(); ++i) {
-      flambda(i, b_->CreateExtractElement(value, i));
-    }
-  }
+llvm::Value *CodeGenLLVM::CreateAllTrueMask(int lanes) {
+#if LLVM_VERSION_MAJOR >= 11
+  const llvm::ElementCount elem_count(lanes, /*scalable*/ false);
+#else
+  const int elem_count = lanes;
+#endif
+  return llvm::Constant::getAllOnesValue(llvm::VectorType::get(b_->getInt1Ty(), elem_count));
 }
 
 llvm::Value *CodeGenLLVM::Visit(const ir::Load *op) {
@@ -765,20 +838,15 @@ llvm::Value *CodeGenLLVM::Visit(const ir::Load *op) {
       CHECK(op->type().is_vector());
       return DenseVectorLoad(op);
     }
-    // scalarize load
-    Type type        = op->type();
-    int alignment    = type.bits() / 8;
-    llvm::Value *ret = llvm::UndefValue::get(CinnTypeToLLVMType(type, m_, true));
-    auto flambda     = [&](int i, llvm::Value *index) {
-      auto *ptr                 = CreateBufferPtr(type.ElementOf(), buffer, index);
-      llvm::LoadInst *load_inst = b_->CreateAlignedLoad(ptr, llvm::Align(alignment), "load_vec");
-      ret                       = b_->CreateInsertElement(ret, load_inst, ll_const_int32(i));
-      if (auto *load_tensor = op->tensor.as_tensor()) {
-        AddTbaaMetadata(load_inst, load_tensor->name, op->index());
-      }
-    };
-    Scalarize(op->index(), flambda);
-    return ret;
+    // gather the lanes by the vector of their pointers
+    Type type     = op->type();
+    int alignment = std::max(type.ElementOf().bits() / 8, 1);
+    auto *ptrs    = CreateBufferPtr(type.ElementOf(), buffer, Visit(&index));
+    auto *inst    = b_->CreateMaskedGather(ptrs, llvm::Align(alignment), CreateAllTrueMask(type.lanes()));
+    if (auto *load_tensor = op->tensor.as_tensor()) {
+      AddTbaaMetadata(inst, load_tensor->name, op->index());
+    }
+    return inst;
   }
 }
 
@@ -820,6 +888,8 @@ llvm::Value *CodeGenLLVM::Visit(const ir::Store *op) {
     // store_inst->setMetadata("tbaa", md_builder_->createTBAAStructTagNode(meta, meta, 0));
     AddTbaaMetadata(store_inst, op->tensor.as_tensor()->name, op->index());
     return store_inst;
+  } else if (index.type().is_scalar()) {  // horizontal reduction
+    return HorizontalReduceStore(op);
   } else {  // vector store
     Expr dense_strided_ramp = detail::StridedRampBase(op->index(), 1);
     auto ramp_expr          = op->index();
@@ -846,25 +916,91 @@ llvm::Value *CodeGenLLVM::Visit(const ir::Store *op) {
         return inst;
       }
     }
-    // scalarize store
-    Type type        = op->type();
-    int alignment    = type.bits() / 8;
-    llvm::Value *ret = llvm::UndefValue::get(CinnTypeToLLVMType(type, m_, true));
-    auto flambda     = [&](int i, llvm::Value *index) {
-      auto *ptr = CreateBufferPtr(type.ElementOf(), buffer, index);
-      llvm::StoreInst *store_inst =
-          b_->CreateAlignedStore(b_->CreateExtractElement(value, i), ptr, llvm::Align(alignment), "store_vec");
-      ret = b_->CreateInsertElement(ret, store_inst, ll_const_int32(i));
-      if (auto *store_tensor = op->tensor.as_tensor()) {
-        AddTbaaMetadata(store_inst, store_tensor->name, op->index());
-      }
-    };
-    Scalarize(op->index(), flambda);
-    return ret;
+    // scatter the lanes by the vector of their pointers, the lanes of the same address are stored in order
+    Type type     = op->type();
+    int alignment = std::max(type.ElementOf().bits() / 8, 1);
+    auto *ptrs    = CreateBufferPtr(type.ElementOf(), buffer, Visit(&index));
+    auto *inst    = b_->CreateMaskedScatter(value, ptrs, llvm::Align(alignment), CreateAllTrueMask(type.lanes()));
+    if (auto *store_tensor = op->tensor.as_tensor()) {
+      AddTbaaMetadata(inst, store_tensor->name, op->index());
+    }
+    return inst;
   }
   return nullptr;
 }
 
+llvm::Value *CodeGenLLVM::HorizontalReduceStore(const ir::Store *op) {
+  Expr index = op->index();
+  // The vectorized reduction stores `A[i] = A[i] op x` with a vector x, the accumulator is the scalar load broadcast.
+  auto is_accumulator = [&](const Expr &e) {
+    auto *broadcast = e.As<ir::Broadcast>();
+    auto *load      = broadcast ? broadcast->value.As<ir::Load>() : nullptr;
+    return load && load->tensor.as_tensor() && op->tensor.as_tensor() &&
+           load->tensor.as_tensor()->name == op->tensor.as_tensor()->name && common::MathEqual(load->index(), index);
+  };
+  Expr acc_expr, x_expr;
+  auto match = [&](const Expr &a, const Expr &b) {
+    if (is_accumulator(a)) {
+      acc_expr = a.As<ir::Broadcast>()->value;
+      x_expr   = b;
+    } else if (is_accumulator(b)) {
+      acc_expr = b.As<ir::Broadcast>()->value;
+      x_expr   = a;
+    }
+    return acc_expr.defined();
+  };
+  auto *add    = op->value.As<ir::Add>();
+  auto *mul    = op->value.As<ir::Mul>();
+  auto *max    = op->value.As<ir::Max>();
+  auto *min    = op->value.As<ir::Min>();
+  bool matched = (add && match(add->a(), add->b())) || (mul && match(mul->a(), mul->b())) ||
+                 (max && match(max->a(), max->b())) || (min && match(min->a(), min->b()));
+  CHECK(matched) << "The vector store to a scalar index should reduce the vector into the element, but got "
+                 << Expr(const_cast<ir::Store *>(op));
+
+  Type type        = op->type().ElementOf();
+  llvm::Value *acc = Visit(&acc_expr);
+  llvm::Value *x   = Visit(&x_expr);
+  llvm::Value *res = nullptr;
+  if (type.is_float()) {
+    llvm::Instruction *reduce = nullptr;
+    if (add) {
+      reduce = b_->CreateFAddReduce(acc, x);
+    } else if (mul) {
+      reduce = b_->CreateFMulReduce(acc, x);
+    } else if (max) {
+      reduce = b_->CreateFPMaxReduce(x);
+    } else {
+      reduce = b_->CreateFPMinReduce(x);
+    }
+    // the lanes are reduced in any order like the vectorized reduction
+    reduce->setHasAllowReassoc(true);
+    res = reduce;
+    if (max) res = b_->CreateMaxNum(acc, reduce);
+    if (min) res = b_->CreateMinNum(acc, reduce);
+  } else {
+    bool is_signed = type.is_int();
+    if (add) {
+      res = b_->CreateAdd(acc, b_->CreateAddReduce(x));
+    } else if (mul) {
+      res = b_->CreateMul(acc, b_->CreateMulReduce(x));
+    } else if (max) {
+      auto *reduce = b_->CreateIntMaxReduce(x, is_signed);
+      auto *gt     = is_signed ? b_->CreateICmpSGT(acc, reduce) : b_->CreateICmpUGT(acc, reduce);
+      res          = b_->CreateSelect(gt, acc, reduce);
+    } else {
+      auto *reduce = b_->CreateIntMinReduce(x, is_signed);
+      auto *lt     = is_signed ? b_->CreateICmpSLT(acc, reduce) : b_->CreateICmpULT(acc, reduce);
+      res          = b_->CreateSelect(lt, acc, reduce);
+    }
+  }
+
+  auto *ptr  = CreateBufferPtr(type, Visit(&op->tensor), Visit(&index));
+  auto *inst = b_->CreateAlignedStore(res, ptr, llvm::Align(std::max(type.bits() / 8, 1)));
+  AddTbaaMetadata(inst, op->tensor.as_tensor()->name, index);
+  return inst;
+}
+
 llvm::Value *CodeGenLLVM::Visit(const ir::Alloc *op) {
   auto *buffer_op = op->destination.As<ir::_Buffer_>();
   auto *buffer    = GetVar(buffer_op->name);
@@ -1001,7 +1137,15 @@ llvm::Value *CodeGenLLVM::Visit(const ir::Let *op) {
 
 llvm::Value *CodeGenLLVM::Visit(const ir::Reduce *op) { __IR_EMITTER_NOT_IMPLEMENTED(op); }
 
-llvm::Value *CodeGenLLVM::Visit(const ir::Ramp *op) { __IR_EMITTER_NOT_IMPLEMENTED(op); }
+llvm::Value *CodeGenLLVM::Visit(const ir::Ramp *op) {
+  // base + stride * <0, 1, ..., lanes - 1>
+  llvm::Value *base   = Visit(&op->base);
+  llvm::Value *stride = b_->CreateIntCast(Visit(&op->stride), base->getType(), true);
+  std::vector<llvm::Constant *> steps;
+  for (int i = 0; i < op->lanes; i++) steps.push_back(llvm::ConstantInt::get(base->getType(), i));
+  auto *offsets = b_->CreateMul(b_->CreateVectorSplat(op->lanes, stride), llvm::ConstantVector::get(steps));
+  return b_->CreateAdd(b_->CreateVectorSplat(op->lanes, base), offsets, "ramp");
+}
 
 llvm::Value *CodeGenLLVM::Visit(const ir::Broadcast *op) {
 #if LLVM_VERSION_MAJOR >= 11
@@ -1291,13 +1435,21 @@ llvm::Value *CodeGenLLVM::Visit(const ir::IntrinsicOp *op) {
 llvm::Value *CodeGenLLVM::Visit(const ir::intrinsics::BufferGetDataHandle *op) {
   std::vector<llvm::Value *> args({Visit(&op->buffer)});
   auto *callee = m_->getFunction("cinn_buffer_get_data_handle");
-  return Call(callee, std::move(args));
+  return AssumeAligned(Call(callee, std::move(args)), op->buffer);
 }
 
 llvm::Value *CodeGenLLVM::Visit(const ir::intrinsics::BufferGetDataConstHandle *op) {
   std::vector<llvm::Value *> args({Visit(&op->buffer)});
   auto *callee = m_->getFunction("cinn_buffer_get_data_const_handle");
-  return Call(callee, std::move(args));
+  return AssumeAligned(Call(callee, std::move(args)), op->buffer);
+}
+
+llvm::Value *CodeGenLLVM::AssumeAligned(llvm::Value *data, const Expr &buffer) {
+  // the vectorizer emits the aligned accesses of the loops on the aligned data instead of peeling them
+  auto *node    = buffer.as_buffer();
+  int alignment = node ? node->KnownAlignment() : 0;
+  if (alignment > 1) b_->CreateAlignmentAssumption(m_->getDataLayout(), data, alignment);
+  return data;
 }
 
 llvm::Value *CodeGenLLVM::Visit(const ir::intrinsics::BufferCreate *op) {
@@ -1311,7 +1463,7 @@ llvm::Value *CodeGenLLVM::Visit(const ir::intrinsics::BufferCreate *op) {
     memory_size *= shape_int;
   }
   args.push_back(ll_const_int64(memory_size));
-  args.push_back(ll_const_int32(32));
+  args.push_back(ll_const_int32(buffer_node->data_alignment > 0 ? buffer_node->data_alignment : CINN_BUFFER_ALIGNMENT));
 
   return Call(callee, args);
 }
@@ -1404,7 +1556,36 @@ llvm::Function *CodeGenLLVM::GetIntrinsicDecl(llvm::Intrinsic::ID id,
 llvm::Value *CodeGenLLVM::Visit(const ir::intrinsics::BuiltinIntrin *op) {
   std::string func_name = op->name;
   if (op->id == -1) {
-    if (func_name == "bitwise_and") {
+    if (func_name == optim::kPrefetchIntrin) {
+      CHECK_EQ(op->args.size(), 3U);
+      auto *addr = op->args[0].As<ir::IntrinsicOp>();
+      CHECK(addr && llvm::isa<ir::intrinsics::GetAddr>(addr)) << "The prefetch should read an address";
+      auto *load = llvm::dyn_cast<ir::intrinsics::GetAddr>(addr)->data.As<ir::Load>();
+      CHECK(load);
+      // compute the address without loading it, the address prefetched ahead may be out of the buffer
+      Expr index  = load->index();
+      auto *ptr   = CreateBufferPtr(load->type(), Visit(&load->tensor), Visit(&index));
+      ptr         = b_->CreatePointerCast(ptr, ll_void_p_ty());
+      auto *write = Visit(&op->args[1]);
+      auto *level = Visit(&op->args[2]);
+      auto *fn    = GetIntrinsicDecl(
+          llvm::Intrinsic::prefetch, b_->getVoidTy(), {ptr->getType(), ll_int32_ty(), ll_int32_ty(), ll_int32_ty()});
+      // the cache type 1 means the data cache
+      return b_->CreateCall(fn, {ptr, write, level, ll_const_int32(1)});
+    } else if (func_name == optim::kNontemporalStoreIntrin) {
+      CHECK_EQ(op->args.size(), 1U);
+      CHECK(op->args[0].As<ir::Store>());
+      auto *store_inst = llvm::dyn_cast<llvm::StoreInst>(Visit(&op->args[0]));
+      CHECK(store_inst) << "The non-temporal store should be a scalar or a dense vector store";
+      store_inst->setMetadata(llvm::LLVMContext::MD_nontemporal,
+                              llvm::MDNode::get(b_->getContext(), {llvm::ConstantAsMetadata::get(ll_const_int32(1))}));
+      return store_inst;
+    } else if (func_name == optim::kReinterpretIntrin) {
+      CHECK_EQ(op->args.size(), 1U);
+      return b_->CreateBitCast(Visit(&op->args[0]), CinnTypeToLLVMType(op->type(), m_));
+    } else if (func_name == optim::kStoreFenceIntrin) {
+      return b_->CreateCall(llvm::Intrinsic::getDeclaration(m_, llvm::Intrinsic::x86_sse_sfence));
+    } else if (func_name == "bitwise_and") {
       CHECK_GE(op->args.size(), 2U);
       return b_->CreateAnd(Visit(&op->args[0]), Visit(&op->args[1]));
     } else if (func_name == "bitwise_or") {
@@ -1450,6 +1631,34 @@ llvm::Value *CodeGenLLVM::Visit(const ir::intrinsics::BuiltinIntrin *op) {
   return b_->CreateCall(fn, arg_value);
 }
 
+llvm::Value *CodeGenLLVM::Visit(const ir::intrinsics::DotProduct4 *op) {
+  auto *acc = Visit(&op->acc);
+  // the multi-versioned objects share the IR of all the CPUs, so they keep the generic code
+  if (target_.supports(common::Target::X86Feature::VNNI) && FLAGS_cinn_x86_export_cpus.empty()) {
+    auto pack = [&](const llvm::SmallVectorImpl<Expr> &elems) {
+      llvm::Value *vec = llvm::UndefValue::get(llvm::FixedVectorType::get(ll_int8_ty(), elems.size()));
+      for (int i = 0; i < elems.size(); i++) vec = b_->CreateInsertElement(vec, Visit(&elems[i]), i);
+      return b_->CreateVectorSplat(4, b_->CreateBitCast(vec, ll_int32_ty()));
+    };
+    // VPDPBUSD multiplies the unsigned bytes of a by the signed ones of b, so a is offset by 128 to be unsigned and the
+    // excess 128 * sum(b) is subtracted
+    auto *offset = b_->CreateVectorSplat(4, ll_const_int32(static_cast<int>(0x80808080u)));
+    auto *a      = b_->CreateXor(pack(op->a), offset);
+    auto *b      = pack(op->b);
+    auto *fn     = llvm::Intrinsic::getDeclaration(m_, llvm::Intrinsic::x86_avx512_vpdpbusd_128);
+    auto *dot    = b_->CreateCall(fn, {b_->CreateVectorSplat(4, acc), a, b});
+    auto *excess = b_->CreateCall(fn, {llvm::Constant::getNullValue(offset->getType()), offset, b});
+    return b_->CreateExtractElement(b_->CreateSub(dot, excess), static_cast<uint64_t>(0));
+  }
+  llvm::Value *res = acc;
+  for (int i = 0; i < op->a.size(); i++) {
+    auto *a = b_->CreateSExt(Visit(&op->a[i]), ll_int32_ty());
+    auto *b = b_->CreateSExt(Visit(&op->b[i]), ll_int32_ty());
+    res     = b_->CreateAdd(res, b_->CreateMul(a, b));
+  }
+  return res;
+}
+
 llvm::Value *CodeGenLLVM::Visit(const ir::intrinsics::PodValueToX *op) {
   auto to_type = op->GetOutputType(0);
   llvm::Function *callee{};
@@ -197,8 +197,14 @@ class CodeGenLLVM : public LLVMIRVisitor, public IrBuilderMixin<CodeGenLLVM> {
   llvm::Value *CreateBufferPtr(Type t, llvm::Value *buffer, llvm::Value *index);
   llvm::Value *CreateBufferVecPtr(Type t, llvm::Value *buffer, llvm::Value *index);
   llvm::Value *CreateVecSlice(llvm::Value *vec, int begin, int lanes);
+  //! Let the optimizer assume the alignment of the \p data of \p buffer, see ir::_Buffer_::KnownAlignment.
+  llvm::Value *AssumeAligned(llvm::Value *data, const Expr &buffer);
 
   llvm::Value *DenseVectorLoad(const ir::Load *load);
+  //! Store `A[i] = A[i] op x` of a vector x by the horizontal reduction of x, which the vectorized reduction yields.
+  llvm::Value *HorizontalReduceStore(const ir::Store *op);
+  //! The mask of the gathers and scatters of all the \p lanes.
+  llvm::Value *CreateAllTrueMask(int lanes);
   llvm::Value *CreateSerialFor(const ir::For *op, int stride = 1);
 
   /**
@@ -209,8 +215,6 @@ class CodeGenLLVM : public LLVMIRVisitor, public IrBuilderMixin<CodeGenLLVM> {
 
   void InitTarget(const Target &target);
 
-  void Scalarize(const Expr &e, std::function<void(int i, llvm::Value *v)> flambda);
-
   llvm::Module *m_;
   llvm::IRBuilder<> *b_;
   // Current function
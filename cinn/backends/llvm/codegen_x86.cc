@@ -18,12 +18,16 @@
 #include <llvm/IR/LLVMContext.h>
 
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
 #include <utility>
 
 #include "cinn/backends/llvm/codegen_llvm.h"
 #include "cinn/common/target.h"
 #include "cinn/ir/ir.h"
 #include "cinn/ir/ir_operators.h"
+#include "cinn/ir/ir_visitor.h"
 #include "cinn/optim/collect_undefined_vars.h"
 #include "cinn/runtime/intrinsic.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -31,8 +35,120 @@
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/Support/Casting.h"
 
+DEFINE_int64(cinn_parallel_min_work,
+             32768,
+             "The parallel loops of fewer estimated instructions run serially, as launching the tasks on the threads "
+             "costs more than the work.");
+DEFINE_int64(cinn_parallel_task_work,
+             16384,
+             "The estimated instructions of each task of a parallel loop, which fix the count of the tasks launched.");
+DEFINE_string(cinn_parallel_tuning_log,
+              "",
+              "The file of the tuned task counts of the parallel loops, which override the estimated ones.");
+
 namespace cinn::backends {
 
+namespace {
+// The tasks per thread of the parallel launches with all the available threads, see cinn_backend_parallel_launch.
+constexpr int kTasksPerThread = 4;
+
+// Count the instructions of a loop body, each node once per iteration of the loops around it.
+struct ParallelWorkCounter : public ir::IRVisitor {
+  int64_t work{0};
+  int64_t iterations{1};
+  bool known{true};
+
+  void Visit(const Expr* x) override {
+    switch (x->node_type()) {
+      case ir::IrNodeTy::IntImm:
+      case ir::IrNodeTy::UIntImm:
+      case ir::IrNodeTy::FloatImm:
+      case ir::IrNodeTy::StringImm:
+      case ir::IrNodeTy::_Var_:
+      case ir::IrNodeTy::_Buffer_:
+      case ir::IrNodeTy::_Tensor_:
+        return;
+      case ir::IrNodeTy::Block:
+        break;
+      case ir::IrNodeTy::For: {
+        auto* op = x->As<ir::For>();
+        if (!op->extent.is_constant()) {
+          known = false;
+          return;
+        }
+        int64_t outer = iterations;
+        iterations *= op->extent.as_int64();
+        // the increment, the comparison and the branch of each iteration
+        work += 3 * iterations;
+        ir::IRVisitor::Visit(&op->body);
+        iterations = outer;
+        return;
+      }
+      case ir::IrNodeTy::PolyFor:
+        known = false;
+        return;
+      default:
+        work += iterations;
+    }
+    ir::IRVisitor::Visit(x);
+  }
+
+#define __m(t__)                          \
+  void Visit(const ir::t__* x) override { \
+    for (auto* n : x->expr_fields()) {    \
+      if (n->defined()) Visit(n);         \
+    }                                     \
+  }
+  NODETY_FORALL(__m)
+#undef __m
+};
+}  // namespace
+
+int64_t EstimateParallelWork(const ir::For* op) {
+  if (!op->extent.is_constant()) return -1;
+  ParallelWorkCounter counter;
+  counter.iterations = op->extent.as_int64();
+  counter.work       = 3 * counter.iterations;
+  counter.Visit(&op->body);
+  return counter.known ? counter.work : -1;
+}
+
+std::string GenerateParallelLaunchKey(int extent, int64_t work) {
+  return "ParallelLaunch extent " + std::to_string(extent) + " work " + std::to_string(work);
+}
+
+absl::flat_hash_map<std::string, int>& GetTunedParallelTaskCounts() {
+  static auto* counts = [] {
+    auto* res = new absl::flat_hash_map<std::string, int>;
+    std::ifstream is(FLAGS_cinn_parallel_tuning_log);
+    if (FLAGS_cinn_parallel_tuning_log.empty() || !is.good()) return res;
+    VLOG(3) << "Load the tuned parallel task counts from " << FLAGS_cinn_parallel_tuning_log;
+    std::string line;
+    while (std::getline(is, line)) {
+      auto pos = line.rfind(" num_task ");
+      if (pos == std::string::npos) continue;
+      (*res)[line.substr(0, pos)] = std::stoi(line.substr(pos + 10));
+    }
+    return res;
+  }();
+  return *counts;
+}
+
+int GetParallelTaskCount(int extent, int64_t work) {
+  auto& tuned = GetTunedParallelTaskCounts();
+  auto it     = tuned.find(GenerateParallelLaunchKey(extent, work));
+  if (it != tuned.end()) {
+    CHECK_GE(it->second, 0) << "The tuned task count of " << it->first << " should be non-negative";
+    return std::min(it->second, extent);
+  }
+  if (work < 0) return 0;
+  if (work < FLAGS_cinn_parallel_min_work) return 1;
+  int64_t num_task = std::max<int64_t>(work / std::max<int64_t>(FLAGS_cinn_parallel_task_work, 1), 1);
+  num_task         = std::min<int64_t>(num_task, extent);
+  int max_tasks    = std::max<int>(std::thread::hardware_concurrency(), 1) * kTasksPerThread;
+  return num_task >= max_tasks ? 0 : num_task;
+}
+
 CodeGenX86::CodeGenX86(llvm::Module* m, llvm::IRBuilder<>* b, const std::shared_ptr<SymbolTable>& vars)
     : CodeGenLLVM(m, b, vars) {}
 
@@ -126,10 +242,20 @@ llvm::Value* CodeGenX86::Visit(const ir::For* op) {
   if (op->is_parallel()) {
     VLOG(3) << "parallel forloop";
     if (parallel_env_.penv == nullptr) {
-      CreateParallelLaunch(
-          ir::For::Make(
-              op->loop_var, op->min, op->extent, op->for_type(), op->device_api, op->body, op->vectorize_info()),
-          0);
+      auto loop = ir::For::Make(
+          op->loop_var, op->min, op->extent, op->for_type(), op->device_api, op->body, op->vectorize_info());
+      int num_task = 0;
+      if (op->extent.is_constant()) {
+        int64_t work = EstimateParallelWork(op);
+        num_task     = GetParallelTaskCount(op->extent.as_int32(), work);
+        VLOG(3) << "Launch the parallel loop " << op->loop_var->name << " of " << work << " instructions by "
+                << num_task << " tasks";
+      }
+      if (num_task == 1) {
+        loop.As<ir::For>()->set_parallel(false);
+        return CodeGenLLVM::Visit(loop.As<ir::For>());
+      }
+      CreateParallelLaunch(loop, num_task);
     } else {
       Expr num_task = parallel_env_.num_task;
       Expr task_id  = parallel_env_.task_id;
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <absl/container/flat_hash_map.h>
+#include <gflags/gflags.h>
 #include <llvm/IR/IRBuilder.h>
 
 #include <memory>
@@ -23,8 +24,35 @@
 
 #include "cinn/backends/llvm/codegen_llvm.h"
 
+DECLARE_int64(cinn_parallel_min_work);
+DECLARE_int64(cinn_parallel_task_work);
+DECLARE_string(cinn_parallel_tuning_log);
+
 namespace cinn::backends {
 
+/**
+ * Estimate the instructions of running the parallel loop \p op, the inner loops counted by their extents. Return -1 if
+ * the extent of any loop is not constant.
+ */
+int64_t EstimateParallelWork(const ir::For* op);
+
+//! The key of the parallel loop of \p extent iterations and \p work instructions in the tuned task counts.
+std::string GenerateParallelLaunchKey(int extent, int64_t work);
+
+/**
+ * The task counts of the parallel loops tuned, keyed by GenerateParallelLaunchKey. They are loaded from
+ * FLAGS_cinn_parallel_tuning_log at the first call, if the file exists, each line a key followed by "num_task N".
+ */
+absl::flat_hash_map<std::string, int>& GetTunedParallelTaskCounts();
+
+/**
+ * Get the count of the tasks to launch the parallel loop of \p extent iterations and \p work instructions by, see
+ * EstimateParallelWork: the tuned one if any, otherwise 1 to run it serially below FLAGS_cinn_parallel_min_work,
+ * or a task per FLAGS_cinn_parallel_task_work instructions, and 0 to launch it with all the available threads when
+ * the tasks would outnumber them or the work is unknown.
+ */
+int GetParallelTaskCount(int extent, int64_t work);
+
 class CodeGenX86 : public CodeGenLLVM {
  public:
   explicit CodeGenX86(llvm::Module* m, llvm::IRBuilder<>* b, const std::shared_ptr<SymbolTable>& vars = nullptr);
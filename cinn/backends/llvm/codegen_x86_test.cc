@@ -16,9 +16,13 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+
 #include "cinn/backends/llvm/simple_jit.h"
 #include "cinn/cinn.h"
 #include "cinn/common/test_helper.h"
+#include "cinn/ir/collect_ir_nodes.h"
 #include "cinn/runtime/cinn_runtime.h"
 
 namespace cinn {
@@ -68,5 +72,211 @@ TEST(Vectorize, basic) {
   }
 }
 
+TEST(Vectorize, math_functions) {
+  Expr M(1024);
+  Placeholder<float> X("X", {M});
+
+  auto exp_out  = Compute({M}, [&](Expr i) { return lang::Exp(X(i)); }, "Exp");
+  auto log_out  = Compute({M}, [&](Expr i) { return lang::Log(lang::Exp(X(i))); }, "Log");
+  auto tanh_out = Compute({M}, [&](Expr i) { return lang::Tanh(X(i)); }, "Tanh");
+  auto erf_out  = Compute({M}, [&](Expr i) { return lang::Erf(X(i)); }, "Erf");
+  auto stages   = CreateStages({exp_out, log_out, tanh_out, erf_out});
+  for (auto& tensor : {exp_out, log_out, tanh_out, erf_out}) {
+    stages[tensor]->Vectorize(0, 8);
+  }
+
+  auto fn = Lower("fn", stages, {X, exp_out, log_out, tanh_out, erf_out});
+  Module::Builder builder("module", common::DefaultHostTarget());
+  builder.AddFunction(fn);
+
+  auto jit = SimpleJIT::Create();
+  jit->Link(builder.Build());
+  auto* fn_ptr = reinterpret_cast<lower_func_ptr_t>(jit->Lookup("fn"));
+
+  // the polynomials of the float32 vectors err within a few ULP over the whole range
+  auto* X_buf  = common::BufferBuilder(Float(32), {1024}).set_zero().set_align(64).Build();
+  auto* X_data = reinterpret_cast<float*>(X_buf->memory);
+  for (int i = 0; i < 1024; i++) {
+    X_data[i] = -20.f + 40.f * i / 1024;
+  }
+  std::vector<cinn_buffer_t*> outs;
+  for (int i = 0; i < 4; i++) {
+    outs.push_back(common::BufferBuilder(Float(32), {1024}).set_zero().set_align(64).Build());
+  }
+  auto args = common::ArgsBuilder().Add(X_buf).Add(outs[0]).Add(outs[1]).Add(outs[2]).Add(outs[3]).Build();
+  fn_ptr(reinterpret_cast<void**>(args.data()), args.size());
+
+  auto out_data = [&](int k, int i) { return reinterpret_cast<float*>(outs[k]->memory)[i]; };
+  for (int i = 0; i < 1024; i++) {
+    double x = X_data[i];
+    ASSERT_NEAR(out_data(0, i), std::exp(x), 1e-6 * std::exp(x)) << "exp at " << x;
+    ASSERT_NEAR(out_data(1, i), x, 1e-6 * std::max(std::abs(x), 1.)) << "log at " << std::exp(x);
+    ASSERT_NEAR(out_data(2, i), std::tanh(x), 1e-6) << "tanh at " << x;
+    ASSERT_NEAR(out_data(3, i), std::erf(x), 1e-6) << "erf at " << x;
+  }
+
+  cinn_buffer_free(nullptr, X_buf);
+  for (auto* out : outs) {
+    cinn_buffer_free(nullptr, out);
+  }
+}
+
+TEST(Vectorize, gather_and_reduce) {
+  const int m = 32, n = 64;
+  Placeholder<float> A("A", {Expr(m), Expr(n)});
+  // the strided loads of the transpose are gathered
+  auto B = Compute(
+      {Expr(n), Expr(m)}, [&](Var i, Var j) { return A(j, i); }, "B");
+  // the vectorized reduction axis is reduced horizontally into the element
+  Var k(n, "k");
+  auto C = Compute(
+      {Expr(m)}, [&](Var i) { return ReduceSum(A(i, k), {k}); }, "C");
+
+  auto stages = CreateStages({B, C});
+  stages[B]->Vectorize(1, 8);
+  stages[C]->Vectorize(1, 8);
+
+  auto fn = Lower("fn", stages, {A, B, C});
+  LOG(INFO) << "fn: " << fn;
+
+  Module::Builder builder("module", common::DefaultHostTarget());
+  builder.AddFunction(fn);
+
+  auto jit = SimpleJIT::Create();
+  jit->Link(builder.Build());
+  auto* fn_ptr = reinterpret_cast<lower_func_ptr_t>(jit->Lookup("fn"));
+
+  auto* A_buf = common::BufferBuilder(Float(32), {m, n}).set_random().Build();
+  auto* B_buf = common::BufferBuilder(Float(32), {n, m}).set_zero().Build();
+  auto* C_buf = common::BufferBuilder(Float(32), {m}).set_zero().Build();
+  auto args   = common::ArgsBuilder().Add(A_buf).Add(B_buf).Add(C_buf).Build();
+  fn_ptr(reinterpret_cast<void**>(args.data()), args.size());
+
+  auto* A_data = reinterpret_cast<float*>(A_buf->memory);
+  auto* B_data = reinterpret_cast<float*>(B_buf->memory);
+  auto* C_data = reinterpret_cast<float*>(C_buf->memory);
+  for (int i = 0; i < m; i++) {
+    float sum = 0.f;
+    for (int j = 0; j < n; j++) {
+      ASSERT_EQ(B_data[j * m + i], A_data[i * n + j]);
+      sum += A_data[i * n + j];
+    }
+    ASSERT_NEAR(C_data[i], sum, 1e-4);
+  }
+
+  cinn_buffer_free(nullptr, A_buf);
+  cinn_buffer_free(nullptr, B_buf);
+  cinn_buffer_free(nullptr, C_buf);
+}
+
+TEST(DotProduct4, int8_matmul) {
+  const int m = 16, n = 32, k = 64;
+  Placeholder<int8_t> A("A", {Expr(m), Expr(k)});
+  Placeholder<int8_t> B("B", {Expr(k), Expr(n)});
+  Var k1(k, "k1");
+  auto C = Compute(
+      {Expr(m), Expr(n)},
+      [&](Var i, Var j) {
+        return ReduceSum(ir::Cast::Make(Int(32), A(i, k1)) * ir::Cast::Make(Int(32), B(k1, j)), {k1});
+      },
+      "C");
+
+  auto stages = CreateStages({C});
+  // [i, j, k] -> [i, j, ko, ki]
+  stages[C]->Split(2, 4);
+  stages[C]->DotProduct4(3);
+
+  auto fn = Lower("fn", stages, {A, B, C});
+  LOG(INFO) << "fn: " << fn;
+
+  Module::Builder builder("module", common::DefaultHostTarget());
+  builder.AddFunction(fn);
+
+  auto jit = SimpleJIT::Create();
+  jit->Link(builder.Build());
+  auto* fn_ptr = reinterpret_cast<lower_func_ptr_t>(jit->Lookup("fn"));
+
+  auto* A_buf  = common::BufferBuilder(Int(8), {m, k}).set_zero().Build();
+  auto* B_buf  = common::BufferBuilder(Int(8), {k, n}).set_zero().Build();
+  auto* C_buf  = common::BufferBuilder(Int(32), {m, n}).set_zero().Build();
+  auto* A_data = reinterpret_cast<int8_t*>(A_buf->memory);
+  auto* B_data = reinterpret_cast<int8_t*>(B_buf->memory);
+  // the elements of the whole int8 range check the compensation of the unsigned operand of the VNNI
+  for (int i = 0; i < m * k; i++) A_data[i] = static_cast<int8_t>(i * 37 % 256 - 128);
+  for (int i = 0; i < k * n; i++) B_data[i] = static_cast<int8_t>(i * 91 % 256 - 128);
+
+  auto args = common::ArgsBuilder().Add(A_buf).Add(B_buf).Add(C_buf).Build();
+  fn_ptr(reinterpret_cast<void**>(args.data()), args.size());
+
+  auto* C_data = reinterpret_cast<int32_t*>(C_buf->memory);
+  for (int i = 0; i < m; i++) {
+    for (int j = 0; j < n; j++) {
+      int32_t res = 0;
+      for (int x = 0; x < k; x++) res += static_cast<int32_t>(A_data[i * k + x]) * B_data[x * n + j];
+      ASSERT_EQ(C_data[i * n + j], res) << "at " << i << ", " << j;
+    }
+  }
+
+  cinn_buffer_free(nullptr, A_buf);
+  cinn_buffer_free(nullptr, B_buf);
+  cinn_buffer_free(nullptr, C_buf);
+}
+
+TEST(ParallelLaunch, task_count) {
+  // too little work to launch a task on each thread
+  ASSERT_EQ(GetParallelTaskCount(100, 1000), 1);
+  ASSERT_EQ(GetParallelTaskCount(8, 4 * FLAGS_cinn_parallel_task_work), 4);
+  ASSERT_EQ(GetParallelTaskCount(2, 4 * FLAGS_cinn_parallel_task_work), 2);
+  // the tasks outnumbering the threads, or the unknown work, by the tasks of all the available threads
+  ASSERT_EQ(GetParallelTaskCount(1 << 30, int64_t{1} << 50), 0);
+  ASSERT_EQ(GetParallelTaskCount(100, -1), 0);
+  // the tuned task count overrides the estimated one
+  GetTunedParallelTaskCounts()[GenerateParallelLaunchKey(100, 1000)] = 3;
+  ASSERT_EQ(GetParallelTaskCount(100, 1000), 3);
+  GetTunedParallelTaskCounts().clear();
+
+  for (int m : {4, 1024}) {
+    const int n = 256;
+    Placeholder<float> A("A", {Expr(m), Expr(n)});
+    Placeholder<float> B("B", {Expr(m), Expr(n)});
+    auto C = Compute(
+        {Expr(m), Expr(n)}, [&](Var i, Var j) { return A(i, j) + B(i, j); }, "C");
+    auto stages = CreateStages({C});
+    stages[C]->Parallel(0);
+    auto fn = Lower("fn", stages, {A, B, C});
+
+    auto loops = ir::CollectIRNodes(fn->body, [](const Expr* x) {
+      return x->As<ir::For>() && x->As<ir::For>()->is_parallel();
+    });
+    ASSERT_EQ(loops.size(), 1UL);
+    int64_t work = EstimateParallelWork(loops.begin()->As<ir::For>());
+    LOG(INFO) << "The parallel loop of " << m << " iterations costs " << work << " instructions";
+    ASSERT_GT(work, 3 * m * n);
+    // the small loop runs serially
+    ASSERT_EQ(GetParallelTaskCount(m, work) == 1, m == 4);
+
+    Module::Builder builder("module", common::DefaultHostTarget());
+    builder.AddFunction(fn);
+    auto jit = SimpleJIT::Create();
+    jit->Link(builder.Build());
+    auto* fn_ptr = reinterpret_cast<lower_func_ptr_t>(jit->Lookup("fn"));
+
+    auto* A_buf = common::BufferBuilder(Float(32), {m, n}).set_random().Build();
+    auto* B_buf = common::BufferBuilder(Float(32), {m, n}).set_random().Build();
+    auto* C_buf = common::BufferBuilder(Float(32), {m, n}).set_zero().Build();
+    auto args   = common::ArgsBuilder().Add(A_buf).Add(B_buf).Add(C_buf).Build();
+    fn_ptr(reinterpret_cast<void**>(args.data()), args.size());
+
+    auto* A_data = reinterpret_cast<float*>(A_buf->memory);
+    auto* B_data = reinterpret_cast<float*>(B_buf->memory);
+    auto* C_data = reinterpret_cast<float*>(C_buf->memory);
+    for (int i = 0; i < m * n; i++) ASSERT_NEAR(C_data[i], A_data[i] + B_data[i], 1e-5);
+
+    cinn_buffer_free(nullptr, A_buf);
+    cinn_buffer_free(nullptr, B_buf);
+    cinn_buffer_free(nullptr, C_buf);
+  }
+}
+
 }  // namespace backends
 }  // namespace cinn
@@ -17,6 +17,7 @@
 #include <absl/strings/string_view.h>
 #include <llvm/ADT/Triple.h>
 #include <llvm/AsmParser/Parser.h>
+#include <llvm/Bitcode/BitcodeReader.h>
 #include <llvm/Config/llvm-config.h>
 #include <llvm/ExecutionEngine/JITSymbol.h>
 #include <llvm/ExecutionEngine/Orc/Core.h>
@@ -31,6 +32,8 @@
 #include <llvm/IR/Verifier.h>
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/InitializePasses.h>
+#include <llvm/Object/ArchiveWriter.h>
+#include <llvm/Object/ObjectFile.h>
 #include <llvm/PassRegistry.h>
 #include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/Error.h>
@@ -47,22 +50,49 @@
 #include <llvm/Transforms/Scalar/NewGVN.h>
 #include <llvm/Transforms/Scalar/Reassociate.h>
 #include <llvm/Transforms/Scalar/SimplifyCFG.h>
+#include <llvm/Transforms/Utils/Cloning.h>
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "cinn/backends/codegen_cuda_host.h"
+#include "cinn/backends/compilation_cache.h"
 #include "cinn/backends/llvm/cinn_runtime_llvm_ir.h"
 #include "cinn/backends/llvm/codegen_llvm.h"
 #include "cinn/backends/llvm/codegen_x86.h"
 #include "cinn/backends/llvm/llvm_optimizer.h"
 #include "cinn/backends/llvm/llvm_util.h"
 #include "cinn/backends/llvm/runtime_symbol_registry.h"
+#include "cinn/backends/remote_compiler.h"
 #include "cinn/ir/ir_printer.h"
 #include "cinn/runtime/intrinsic.h"
+#include "cinn/utils/compile_tracer.h"
+#include "cinn/utils/string.h"
+#include "cinn/utils/thread_pool.h"
+
+DEFINE_string(cinn_x86_export_cpus,
+              "",
+              "The comma separated LLVM names of the X86 CPUs, e.g. haswell,skylake-avx512, the objects exported hold "
+              "a version of the lowered functions for each of them and the stubs calling the best one the host "
+              "supports, empty to export the versions for the host only");
+
+DEFINE_bool(cinn_llvm_lazy_compile,
+            false,
+            "Whether to compile the X86 functions on their first call instead of when the module is built, which "
+            "shortens the build of the models with many rarely called functions");
+
+DEFINE_int32(cinn_llvm_compile_threads, 1, "The number of threads the LLVM JIT compiles the modules on");
+
+DEFINE_bool(cinn_llvm_shared_jit,
+            false,
+            "Whether the X86 and the CUDA host modules of all the programs are linked into one JIT of the process, "
+            "each into its own JITDylib, instead of a JIT with the runtime symbols registered for each program");
 
 namespace cinn::backends {
 namespace {
@@ -85,13 +115,207 @@ void InitializeLLVMPasses() {
   // llvm::initializeTarget(registry);
   // llvm::initializeCodeGenPreparePass(registry);
 }
+
+/**
+ * Load the runtime from the embedded bitcode, which is much faster than parsing the textual IR for each module. The
+ * runtime functions drop the CPU clang compiled them for, so that they are inlined into the lowered functions and
+ * compiled for the same CPU as them.
+ */
+std::unique_ptr<llvm::Module> LoadRuntimeModule(llvm::LLVMContext *ctx) {
+  llvm::MemoryBufferRef bitcode(AsStringRef(backends::kRuntimeLlvmBitcode), "cinn_runtime");
+  auto m = llvm::parseBitcodeFile(bitcode, *ctx);
+  CHECK(m) << "Invalid runtime bitcode: " << llvm::toString(m.takeError());
+  for (auto &f : **m) {
+    f.removeFnAttr("target-cpu");
+    f.removeFnAttr("target-features");
+    f.removeFnAttr("tune-cpu");
+  }
+  return std::move(*m);
+}
+
+// Define the function \p name in \p m calling \p callees with the arguments in the global arrays.
+void EmitEntryFunction(llvm::Module *m, const std::string &name, const std::vector<std::string> &callees) {
+  auto &ctx      = m->getContext();
+  auto *i8_ptr   = llvm::Type::getInt8PtrTy(ctx);
+  auto *i32      = llvm::Type::getInt32Ty(ctx);
+  auto *args_ty  = llvm::ArrayType::get(i8_ptr, callees.size());
+  auto *nargs_ty = llvm::ArrayType::get(i32, callees.size());
+  // The arrays are external and mutable, so the optimizer never folds the arguments.
+  auto *args  = new llvm::GlobalVariable(*m,
+                                        args_ty,
+                                        /*isConstant=*/false,
+                                        llvm::GlobalValue::ExternalLinkage,
+                                        llvm::Constant::getNullValue(args_ty),
+                                        name + "_args");
+  auto *nargs = new llvm::GlobalVariable(*m,
+                                         nargs_ty,
+                                         /*isConstant=*/false,
+                                         llvm::GlobalValue::ExternalLinkage,
+                                         llvm::Constant::getNullValue(nargs_ty),
+                                         name + "_nargs");
+
+  auto *fn_ty = llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), {i8_ptr, i32}, false);
+  CHECK(m->getFunction(name) == nullptr) << "function[" << name << "] exists";
+  auto *fn = llvm::Function::Create(fn_ty, llvm::Function::ExternalLinkage, name, m);
+  fn->setCallingConv(llvm::CallingConv::C);
+  llvm::IRBuilder<> b(llvm::BasicBlock::Create(ctx, "entry", fn));
+  for (int k = 0; k < callees.size(); k++) {
+    auto *callee = m->getFunction(callees[k]);
+    CHECK(callee) << "The function [" << callees[k] << "] called by [" << name << "] is not in the module";
+    CHECK_EQ(callee->getFunctionType(), fn_ty) << "The function [" << callees[k] << "] is not a lowered function";
+    auto *arg  = b.CreateLoad(i8_ptr, b.CreateConstInBoundsGEP2_32(args_ty, args, 0, k));
+    auto *narg = b.CreateLoad(i32, b.CreateConstInBoundsGEP2_32(nargs_ty, nargs, 0, k));
+    b.CreateCall(callee, {arg, narg});
+  }
+  b.CreateRetVoid();
+}
+
+//! Create the target machine of the LLVM CPU \p cpu, the host if it is empty.
+std::unique_ptr<llvm::TargetMachine> CreateTargetMachine(const std::string &cpu) {
+  if (cpu.empty()) {
+    return llvm::cantFail(llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost()).createTargetMachine());
+  }
+  llvm::orc::JITTargetMachineBuilder builder(llvm::Triple(llvm::sys::getProcessTriple()));
+  builder.setCPU(cpu);
+  return llvm::cantFail(builder.createTargetMachine());
+}
+
+//! Get the mask of the common::Target::X86Feature the code compiled for the LLVM CPU \p cpu requires.
+int GetRequiredX86Features(const std::string &cpu) {
+  using X86Feature = common::Target::X86Feature;
+  auto machine     = CreateTargetMachine(cpu);
+  auto *info       = machine->getMCSubtargetInfo();
+  int features     = 0;
+  if (info->checkFeatures("+sse4.2")) features |= static_cast<int>(X86Feature::SSE);
+  if (info->checkFeatures("+avx2,+fma")) features |= static_cast<int>(X86Feature::AVX2);
+  if (info->checkFeatures("+avx512f")) features |= static_cast<int>(X86Feature::AVX512);
+  if (info->checkFeatures("+avx512vnni,+avx512vl")) features |= static_cast<int>(X86Feature::VNNI);
+  return features;
+}
+
+// Compile the object defining the read-only \p data as `<name>`(uint8_t[]) and its size as `<name>_size`(int64_t).
+std::string CompileDataObject(const std::string &name, const std::string &data) {
+  llvm::LLVMContext ctx;
+  llvm::Module m(name, ctx);
+  auto machine = CreateTargetMachine("");
+  m.setTargetTriple(machine->getTargetTriple().str());
+  m.setDataLayout(machine->createDataLayout());
+  auto *bytes = llvm::ConstantDataArray::getRaw(AsStringRef(data), data.size(), llvm::Type::getInt8Ty(ctx));
+  auto *array = new llvm::GlobalVariable(
+      m, bytes->getType(), /*isConstant=*/true, llvm::GlobalValue::ExternalLinkage, bytes, name);
+  array->setAlignment(llvm::MaybeAlign(64));
+  auto *i64 = llvm::Type::getInt64Ty(ctx);
+  new llvm::GlobalVariable(m,
+                           i64,
+                           /*isConstant=*/true,
+                           llvm::GlobalValue::ExternalLinkage,
+                           llvm::ConstantInt::get(i64, data.size()),
+                           name + "_size");
+  CHECK(!llvm::verifyModule(m, &llvm::errs())) << "Invalid data module " << name;
+
+  llvm::SmallString<0> buffer;
+  llvm::raw_svector_ostream rawstream(buffer);
+  llvm::legacy::PassManager pass_manager;
+  machine->addPassesToEmitFile(pass_manager, rawstream, nullptr, llvm::CGFT_ObjectFile);
+  pass_manager.run(m);
+  return buffer.str().str();
+}
+
+std::string GetVersionName(const std::string &name, const std::string &cpu) {
+  std::string suffix = cpu;
+  std::replace(suffix.begin(), suffix.end(), '-', '_');
+  return name + "_" + suffix;
+}
+
+void DefineAbsoluteSymbols(llvm::orc::JITDylib *dylib, const std::map<std::string, void *> &symbols) {
+  if (symbols.empty()) return;
+  auto &session = dylib->getExecutionSession();
+  llvm::orc::SymbolMap map;
+  for (auto &item : symbols) {
+    map[session.intern(item.first)] = {llvm::pointerToJITTargetAddress(item.second), llvm::JITSymbolFlags::None};
+  }
+  llvm::cantFail(dylib->define(llvm::orc::absoluteSymbols(std::move(map))));
+}
+
+/**
+ * The process-wide JIT of the shared engines, each of which links its modules into its own JITDylib. The runtime
+ * symbols are defined once in the main JITDylib, which the others link against.
+ */
+class SharedJIT {
+ public:
+  //! It is never destructed, so that the code is valid until the process exits.
+  static SharedJIT &Global() {
+    static auto *shared = new SharedJIT;
+    return *shared;
+  }
+
+  llvm::orc::LLJIT *jit() { return jit_.get(); }
+
+  //! Create the JITDylib of an engine, the runtime symbols registered since the last one are defined.
+  llvm::orc::JITDylib *CreateDylib() {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto *dylib = &llvm::cantFail(jit_->createJITDylib("cinn_engine_" + std::to_string(num_dylibs_++)));
+    dylib->addToLinkOrder(jit_->getMainJITDylib());
+    // the symbols registered again at other addresses after the registry is cleared shadow the ones of the main
+    std::map<std::string, void *> added, shadowed;
+    for (auto &item : RuntimeSymbolRegistry::Global().All()) {
+      auto it = defined_.find(item.first);
+      if (it == defined_.end()) {
+        added.insert(item);
+        defined_.insert(item);
+      } else if (it->second != item.second) {
+        shadowed.insert(item);
+      }
+    }
+    DefineAbsoluteSymbols(&jit_->getMainJITDylib(), added);
+    DefineAbsoluteSymbols(dylib, shadowed);
+    return dylib;
+  }
+
+ private:
+  SharedJIT() {
+    llvm::orc::LLJITBuilder builder;
+    // the engines link their modules concurrently
+    builder.setCompileFunctionCreator([](llvm::orc::JITTargetMachineBuilder jtmb)
+                                          -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+      return std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(jtmb));
+    });
+    if (FLAGS_cinn_llvm_compile_threads > 1) builder.setNumCompileThreads(FLAGS_cinn_llvm_compile_threads);
+    jit_ = llvm::cantFail(builder.create());
+    jit_->getMainJITDylib().addGenerator(llvm::cantFail(
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(jit_->getDataLayout().getGlobalPrefix())));
+  }
+
+  std::mutex mu_;
+  std::unique_ptr<llvm::orc::LLJIT> jit_;
+  // The runtime symbols defined in the main JITDylib.
+  std::map<std::string, void *> defined_;
+  int num_dylibs_{0};
+};
+
+// The fast-math flags of the float math generated in \p mode. The reduced mode still keeps the NaNs and the infinities,
+// which the lowered code checks, e.g. by x != x.
+llvm::FastMathFlags FastMathFlagsOf(common::PrecisionMode mode) {
+  llvm::FastMathFlags flags;
+  if (mode == common::PrecisionMode::kStrict) return flags;
+  flags.setAllowContract(true);
+  flags.setApproxFunc();
+  if (mode == common::PrecisionMode::kReduced) {
+    flags.setAllowReassoc();
+    flags.setNoSignedZeros();
+    flags.setAllowReciprocal();
+  }
+  return flags;
+}
 }  // namespace
 void NaiveObjectCache::notifyObjectCompiled(const llvm::Module *m, llvm::MemoryBufferRef obj_buffer) {
+  std::lock_guard<std::mutex> lock(mu_);
   cached_objects_[m->getModuleIdentifier()] =
       llvm::MemoryBuffer::getMemBufferCopy(obj_buffer.getBuffer(), obj_buffer.getBufferIdentifier());
 }
 
 std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::getObject(const llvm::Module *m) {
+  std::lock_guard<std::mutex> lock(mu_);
   auto it = cached_objects_.find(m->getModuleIdentifier());
   if (it == cached_objects_.end()) {
     VLOG(1) << "No object for " << m->getModuleIdentifier() << " in cache. Compiling.";
@@ -111,10 +335,25 @@ std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::getObject(const llvm::Modu
   llvm::InitializeNativeTargetAsmPrinter();
   InitializeLLVMPasses();
 
-  auto engine = std::make_unique<ExecutionEngine>(/*enable_object_cache=*/true);
+  auto engine        = std::make_unique<ExecutionEngine>(/*enable_object_cache=*/true);
+  engine->opt_level_      = config.opt_level;
+  engine->precision_mode_ = config.precision_mode;
+  if (config.shared_jit && !config.lazy_compile) {
+    VLOG(2) << "link into the shared jit";
+    engine->shared_jit_ = SharedJIT::Global().jit();
+    engine->dylib_      = SharedJIT::Global().CreateDylib();
+#if LLVM_VERSION_MAJOR >= 12
+    engine->tracker_ = engine->dylib_->createResourceTracker();
+#endif
+    return engine;
+  }
 
-  auto compile_layer_creator = [&engine](llvm::orc::JITTargetMachineBuilder jtmb)
+  auto compile_layer_creator = [&engine, &config](llvm::orc::JITTargetMachineBuilder jtmb)
       -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+    if (config.num_compile_threads > 1) {
+      // A target machine is created for each module compiled, so the modules can be compiled concurrently.
+      return std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(jtmb), engine->cache_.get());
+    }
     auto machine = llvm::cantFail(jtmb.createTargetMachine());
     VLOG(1) << "create llvm compile layer";
     VLOG(1) << "Target Name: " << machine->getTarget().getName();
@@ -133,12 +372,42 @@ std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::getObject(const llvm::Modu
   };
 
   VLOG(2) << "create jit execution engine";
-  engine->jit_ = llvm::cantFail(llvm::orc::LLJITBuilder()
-                                    .setCompileFunctionCreator(compile_layer_creator)
-                                    .setObjectLinkingLayerCreator(object_layer_creator)
-                                    .create());
+  auto setup_builder = [&](auto &builder) {
+    builder.setCompileFunctionCreator(compile_layer_creator).setObjectLinkingLayerCreator(object_layer_creator);
+    if (config.num_compile_threads > 1) builder.setNumCompileThreads(config.num_compile_threads);
+  };
+  if (config.lazy_compile) {
+    // The modules are partitioned per function by the compile-on-demand layer, and each function is compiled when it
+    // is called the first time through its lazy reexport.
+    llvm::orc::LLLazyJITBuilder builder;
+    setup_builder(builder);
+    auto jit          = llvm::cantFail(builder.create());
+    engine->lazy_jit_ = jit.get();
+    engine->jit_      = std::move(jit);
+    // The eager modules are optimized as a whole before added, while the lazy ones are optimized per partition.
+    int opt_level = config.opt_level;
+    engine->jit_->getIRTransformLayer().setTransform(
+        [opt_level](llvm::orc::ThreadSafeModule tsm,
+                    const llvm::orc::MaterializationResponsibility &) -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+          tsm.withModuleDo([opt_level](llvm::Module &m) {
+            utils::CompileStageTimer timer("LLVMModuleOptimizer");
+            auto machine = CreateTargetMachine("");
+            LLVMModuleOptimizer optimize(machine.get(), opt_level, {}, true);
+            optimize(&m);
+          });
+          return std::move(tsm);
+        });
+  } else {
+    llvm::orc::LLJITBuilder builder;
+    setup_builder(builder);
+    engine->jit_ = llvm::cantFail(builder.create());
+  }
   engine->jit_->getMainJITDylib().addGenerator(llvm::cantFail(
       llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(engine->jit_->getDataLayout().getGlobalPrefix())));
+  engine->dylib_ = &engine->jit_->getMainJITDylib();
+#if LLVM_VERSION_MAJOR >= 12
+  engine->tracker_ = engine->dylib_->getDefaultResourceTracker();
+#endif
 
   VLOG(2) << "register runtime call symbols";
 
@@ -148,35 +417,240 @@ std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::getObject(const llvm::Modu
   return engine;
 }
 
+ExecutionEngine::~ExecutionEngine() {
+  if (!shared_jit_) return;
+#if LLVM_VERSION_MAJOR >= 12
+  // the code and the symbols of the engine are removed from the shared JIT, and the memory of the code is released
+  if (auto err = tracker_->remove()) {
+    LOG(WARNING) << "Failed to unload the code of the engine: " << llvm::toString(std::move(err));
+  }
+#else
+  // the JITDylibs can not be emptied before LLVM 12, the code stays until the process exits
+  VLOG(3) << "The code of the engine is not unloaded from the shared JIT";
+#endif
+}
+
 template <typename CodeGenT>
-void ExecutionEngine::Link(const ir::Module &module) {
-  llvm::SMDiagnostic error;
-  auto ctx        = std::make_unique<llvm::LLVMContext>();
-  auto m          = llvm::parseAssemblyString(AsStringRef(backends::kRuntimeLlvmIr), error, *ctx);
+std::unique_ptr<llvm::Module> ExecutionEngine::GenerateModule(const ir::Module &module, llvm::LLVMContext *ctx) {
+  auto m          = LoadRuntimeModule(ctx);
   auto b          = std::make_unique<llvm::IRBuilder<>>(*ctx);
+  // the flags are printed in the IR, so the cached objects follow the mode too
+  b->setFastMathFlags(FastMathFlagsOf(precision_mode_));
   auto ir_emitter = std::make_unique<CodeGenT>(m.get(), b.get());
+  // The symbols exported, the others are internal to the module.
+  std::set<std::string> exported;
+  for (auto &func : module.functions()) exported.insert(func->name);
   VLOG(3) << "ir_emitter->Compile(module) Begin";
-  ir_emitter->Compile(module);
+  {
+    utils::CompileStageTimer timer("CodeGenLLVM");
+    ir_emitter->Compile(module);
+  }
   VLOG(3) << "ir_emitter->Compile(module) Succeed!";
+  if (!entry_name_.empty()) {
+    EmitEntryFunction(m.get(), entry_name_, entry_callees_);
+    exported.insert({entry_name_, entry_name_ + "_args", entry_name_ + "_nargs"});
+    entry_name_.clear();
+    entry_callees_.clear();
+  }
+  // The runtime is stateless, so each module linked together can hold a private copy of it. Like LTO, all the
+  // definitions except the exported ones are internal, then the optimizer inlines the runtime functions into the
+  // lowered ones and drops them.
+  for (auto &value : m->global_values()) {
+    if (value.isDeclaration() || value.hasLocalLinkage() || exported.count(value.getName().str())) continue;
+    if (auto *object = llvm::dyn_cast<llvm::GlobalObject>(&value)) object->setComdat(nullptr);
+    value.setLinkage(llvm::GlobalValue::InternalLinkage);
+  }
   CHECK(!llvm::verifyModule(*m, &llvm::errs())) << "Invalid module found";
+  return m;
+}
 
-  auto machine =
-      std::move(llvm::cantFail(llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost()).createTargetMachine()));
-  LLVMModuleOptimizer optimize(machine.get(), 3, {}, true);
-  optimize(m.get());
+namespace {
+// Optimize \p m and emit the object file for \p machine.
+std::string EmitObject(llvm::Module *m, llvm::TargetMachine *machine, const OptimizeOptions &options) {
+  if (options.opt_level < 2) {
+    machine->setOptLevel(options.opt_level == 0 ? llvm::CodeGenOpt::None : llvm::CodeGenOpt::Less);
+  }
+  {
+    utils::CompileStageTimer timer("LLVMModuleOptimizer");
+    LLVMModuleOptimizer optimize(machine, options);
+    optimize(m);
+  }
   CHECK(!llvm::verifyModule(*m, &llvm::errs())) << "Invalid optimized module detected";
   for (auto &f : *m) {
     VLOG(5) << "function: " << DumpToString(f);
   }
 
-  llvm::raw_svector_ostream rawstream(buffer_);
-  llvm::legacy::PassManager pass_manager;
-  machine->addPassesToEmitFile(pass_manager, rawstream, nullptr, llvm::CGFT_ObjectFile);
-  pass_manager.run(*m);
+  llvm::SmallString<0> buffer;
+  {
+    llvm::raw_svector_ostream rawstream(buffer);
+    llvm::legacy::PassManager pass_manager;
+    machine->addPassesToEmitFile(pass_manager, rawstream, nullptr, llvm::CGFT_ObjectFile);
+    utils::CompileStageTimer timer("LLVMEmitObject");
+    pass_manager.run(*m);
+  }
+  return buffer.str().str();
+}
 
-  CHECK(AddModule(std::move(m), std::move(ctx)));
+bool IsValidObject(const std::string &object, const std::string &source) {
+  auto file = llvm::object::ObjectFile::createObjectFile(llvm::MemoryBufferRef(object, "cinn_object"));
+  if (file) return true;
+  LOG(WARNING) << "Invalid object from the " << source << ": " << llvm::toString(file.takeError());
+  return false;
+}
+}  // namespace
+
+std::string ExecutionEngine::CompileObject(llvm::Module *m, const std::string &cpu) {
+  auto machine = CreateTargetMachine(cpu);
+  OptimizeOptions options;
+  options.opt_level    = opt_level_;
+  options.print_passes = true;
+
+  // The unoptimized LLVM IR covers both the lowered module and the runtime, so it is used as the key of the object
+  // with the host machine and the LLVM version, and sent to the compile service with the machine.
+  auto cache  = CompilationCache::Default();
+  bool remote = RemoteCompiler::Global() != nullptr;
+  std::string ir, cache_key;
+  if (cache.enabled() || remote) {
+    llvm::raw_string_ostream os(ir);
+    m->print(os, nullptr);
+    os.flush();
+  }
+  std::vector<std::string> machine_options = {machine->getTargetTriple().str(),
+                                              machine->getTargetCPU().str(),
+                                              machine->getTargetFeatureString().str(),
+                                              options.ToString()};
+  if (cache.enabled()) {
+    cache_key = CompilationCache::Key("llvm",
+                                      {ir,
+                                       machine_options[0],
+                                       machine_options[1],
+                                       machine_options[2],
+                                       machine_options[3],
+                                       LLVM_VERSION_STRING});
+    std::string object;
+    if (cache.Load(cache_key, &object) && IsValidObject(object, "compilation cache")) return object;
+  }
+
+  std::string object;
+  if (!remote || !CompileRemotely("llvm", ir, machine_options, &object) || !IsValidObject(object, "compile service")) {
+    object = EmitObject(m, machine.get(), options);
+  }
+  if (cache.enabled()) cache.Store(cache_key, object);
+  return object;
+}
+
+std::string ExecutionEngine::CompileIR(const std::string &ir,
+                                       const std::string &triple,
+                                       const std::string &cpu,
+                                       const std::string &features,
+                                       const OptimizeOptions &options) {
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  InitializeLLVMPasses();
+  llvm::LLVMContext ctx;
+  llvm::SMDiagnostic error;
+  auto m = llvm::parseAssemblyString(ir, error, ctx);
+  CHECK(m) << "Invalid LLVM IR to compile: " << error.getMessage().str();
+  llvm::orc::JITTargetMachineBuilder builder{llvm::Triple(triple)};
+  builder.setCPU(cpu);
+  if (!features.empty()) builder.addFeatures(utils::Split(features, ","));
+  auto machine = llvm::cantFail(builder.createTargetMachine());
+  return EmitObject(m.get(), machine.get(), options);
+}
+
+std::vector<std::string> ExecutionEngine::CompileVersions(const llvm::Module &m, const ir::Module &module) {
+  // the most demanding version is tried first, and the last one is called if the host supports none of the others
+  std::vector<std::pair<int, std::string>> versions;
+  for (auto &cpu : utils::Split(FLAGS_cinn_x86_export_cpus, ",")) {
+    if (!cpu.empty()) versions.emplace_back(GetRequiredX86Features(cpu), cpu);
+  }
+  std::stable_sort(versions.begin(), versions.end(), [](auto &a, auto &b) { return a.first > b.first; });
+  if (versions.empty() || versions.back().first != 0) versions.emplace_back(0, "x86-64");
+
+  auto &ctx     = m.getContext();
+  auto *i32     = llvm::Type::getInt32Ty(ctx);
+  auto *void_ty = llvm::Type::getVoidTy(ctx);
+  auto *fn_ty   = llvm::FunctionType::get(void_ty, {llvm::Type::getInt8PtrTy(ctx), i32}, false);
+  std::vector<std::string> names;
+  for (auto &func : module.functions()) {
+    auto *f = m.getFunction(func->name);
+    if (f && !f->isDeclaration() && f->getFunctionType() == fn_ty) names.push_back(func->name);
+  }
 
-  decltype(auto) es = jit_->getExecutionSession();
+  std::vector<std::string> objects;
+  for (auto &version : versions) {
+    auto copied = llvm::CloneModule(m);
+    for (auto &f : *copied) {
+      if (f.isDeclaration()) continue;
+      if (std::count(names.begin(), names.end(), f.getName().str())) {
+        f.setName(GetVersionName(f.getName().str(), version.second));
+      } else {
+        f.setLinkage(llvm::GlobalValue::InternalLinkage);
+      }
+    }
+    for (auto &g : copied->globals()) {
+      if (!g.isDeclaration()) g.setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
+    VLOG(3) << "Compile the version of " << module.name() << " for " << version.second;
+    objects.push_back(CompileObject(copied.get(), version.second));
+  }
+
+  llvm::Module stub(m.getModuleIdentifier() + "_dispatch", ctx);
+  stub.setTargetTriple(m.getTargetTriple());
+  stub.setDataLayout(m.getDataLayout());
+  auto supports =
+      stub.getOrInsertFunction(runtime::intrinsic::x86_host_supports, llvm::FunctionType::get(i32, {i32}, false));
+  llvm::IRBuilder<> b(ctx);
+  for (auto &name : names) {
+    auto *fn = llvm::Function::Create(fn_ty, llvm::Function::ExternalLinkage, name, &stub);
+    std::vector<llvm::Value *> args;
+    for (auto &arg : fn->args()) args.push_back(&arg);
+    auto *block = llvm::BasicBlock::Create(ctx, "entry", fn);
+    for (int i = 0; i < versions.size(); i++) {
+      auto *call_block = block;
+      if (i + 1 < versions.size()) {
+        b.SetInsertPoint(block);
+        call_block      = llvm::BasicBlock::Create(ctx, "call_" + std::to_string(i), fn);
+        block           = llvm::BasicBlock::Create(ctx, "next_" + std::to_string(i), fn);
+        auto *supported = b.CreateCall(supports, {b.getInt32(versions[i].first)});
+        b.CreateCondBr(b.CreateICmpNE(supported, b.getInt32(0)), call_block, block);
+      }
+      b.SetInsertPoint(call_block);
+      b.CreateCall(stub.getOrInsertFunction(GetVersionName(name, versions[i].second), fn_ty), args);
+      b.CreateRetVoid();
+    }
+  }
+  CHECK(!llvm::verifyModule(stub, &llvm::errs())) << "Invalid dispatch stubs of " << module.name();
+  objects.push_back(CompileObject(&stub, versions.back().second));
+  return objects;
+}
+
+template <typename CodeGenT>
+void ExecutionEngine::Link(const ir::Module &module) {
+  auto ctx = std::make_unique<llvm::LLVMContext>();
+  auto m   = GenerateModule<CodeGenT>(module, ctx.get());
+  if (lazy_jit_) {
+    CHECK(AddModule(std::move(m), std::move(ctx)));
+    return;
+  }
+  if (!FLAGS_cinn_x86_export_cpus.empty()) {
+    auto versions = CompileVersions(*m, module);
+    export_objects_.insert(export_objects_.end(), versions.begin(), versions.end());
+  }
+  auto object = CompileObject(m.get());
+
+  if (CompilationCache::Default().enabled()) {
+    // Link the object directly, so that the code runs the same as the one loaded from the cache later.
+    CHECK(AddObject(object));
+  } else {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      objects_.push_back(std::move(object));
+    }
+    CHECK(AddModule(std::move(m), std::move(ctx)));
+  }
+
+  decltype(auto) es = jit()->getExecutionSession();
   if (false) {
     LOG(INFO) << "======= dump jit execution session ======";
     std::string buffer;
@@ -187,8 +661,44 @@ void ExecutionEngine::Link(const ir::Module &module) {
   }
 }
 
+template <typename CodeGenT>
+void ExecutionEngine::LinkParallel(const std::vector<ir::Module> &modules, int num_threads) {
+  CHECK(entry_name_.empty()) << "The entry function should be linked in one module with all its callees";
+  if (lazy_jit_) {
+    utils::ThreadPool pool(std::max(1, std::min<int>(num_threads, modules.size())));
+    for (int i = 0; i < modules.size(); i++) {
+      pool.Schedule([&, i] {
+        auto ctx = std::make_unique<llvm::LLVMContext>();
+        auto m   = GenerateModule<CodeGenT>(modules[i], ctx.get());
+        CHECK(AddModule(std::move(m), std::move(ctx)));
+      });
+    }
+    return;
+  }
+  std::vector<std::string> objects(modules.size());
+  std::vector<std::vector<std::string>> versions(modules.size());
+  {
+    utils::ThreadPool pool(std::max(1, std::min<int>(num_threads, modules.size())));
+    for (int i = 0; i < modules.size(); i++) {
+      pool.Schedule([&, i] {
+        llvm::LLVMContext ctx;
+        auto m = GenerateModule<CodeGenT>(modules[i], &ctx);
+        if (!FLAGS_cinn_x86_export_cpus.empty()) versions[i] = CompileVersions(*m, modules[i]);
+        objects[i] = CompileObject(m.get());
+      });
+    }
+    // The pool finishes all the tasks before destructed.
+  }
+  for (auto &object : objects) {
+    CHECK(AddObject(object));
+  }
+  for (auto &module_versions : versions) {
+    export_objects_.insert(export_objects_.end(), module_versions.begin(), module_versions.end());
+  }
+}
+
 bool ExecutionEngine::AddModule(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> context) {
-  module->setDataLayout(jit_->getDataLayout());
+  module->setDataLayout(jit()->getDataLayout());
   if (false) {
     LOG(INFO) << "======= dump jit lib ==========";
     std::string buffer;
@@ -200,19 +710,73 @@ bool ExecutionEngine::AddModule(std::unique_ptr<llvm::Module> module, std::uniqu
   }
   llvm::orc::ThreadSafeContext tsc(std::move(context));
   llvm::orc::ThreadSafeModule tsm(std::move(module), std::move(tsc));
-  llvm::cantFail(jit_->addIRModule(std::move(tsm)));
+  if (lazy_jit_) {
+    llvm::cantFail(lazy_jit_->addLazyIRModule(std::move(tsm)));
+  } else {
+#if LLVM_VERSION_MAJOR >= 12
+    llvm::cantFail(jit()->addIRModule(tracker_, std::move(tsm)));
+#else
+    llvm::cantFail(jit()->addIRModule(*dylib_, std::move(tsm)));
+#endif
+  }
+  return true;
+}
+
+bool ExecutionEngine::AddObject(const std::string &object) {
+  auto buffer = llvm::MemoryBuffer::getMemBufferCopy(object, "cinn_object");
+#if LLVM_VERSION_MAJOR >= 12
+  auto err = jit()->addObjectFile(tracker_, std::move(buffer));
+#else
+  auto err = jit()->addObjectFile(*dylib_, std::move(buffer));
+#endif
+  if (err) {
+    LOG(WARNING) << "Failed to add the object: " << llvm::toString(std::move(err));
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mu_);
+  objects_.push_back(object);
   return true;
 }
 
 void ExecutionEngine::ExportObject(const std::string &path) {
   FILE *of = fopen(path.c_str(), "w");
-  fwrite(buffer_.data(), 1, buffer_.size(), of);
+  for (auto &object : export_objects_.empty() ? objects_ : export_objects_) {
+    fwrite(object.data(), 1, object.size(), of);
+  }
   fclose(of);
 }
 
+void ExecutionEngine::ExportStaticLibrary(const std::string &path, const std::map<std::string, std::string> &data) {
+  std::vector<std::string> objects;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    objects = export_objects_.empty() ? objects_ : export_objects_;
+  }
+  CHECK(!objects.empty()) << "No object to export, the modules compiled lazily keep no object";
+  std::vector<std::string> names;
+  for (int i = 0; i < objects.size(); i++) names.push_back("cinn_module_" + std::to_string(i) + ".o");
+  for (auto &item : data) {
+    objects.push_back(CompileDataObject(item.first, item.second));
+    names.push_back(item.first + ".o");
+  }
+  std::vector<llvm::NewArchiveMember> members;
+  for (int i = 0; i < objects.size(); i++) {
+    members.emplace_back(llvm::MemoryBufferRef(AsStringRef(objects[i]), AsStringRef(names[i])));
+  }
+  // the symbol table lets the linkers pick the members by the symbols
+  auto err = llvm::writeArchive(AsStringRef(path),
+                                members,
+                                /*WriteSymtab=*/true,
+                                llvm::object::Archive::K_GNU,
+                                /*Deterministic=*/true,
+                                /*Thin=*/false);
+  CHECK(!err) << "Failed to write the static library " << path << ": " << llvm::toString(std::move(err));
+}
+
 void *ExecutionEngine::Lookup(absl::string_view name) {
-  std::lock_guard<std::mutex> lock(mu_);
-  if (auto symbol = jit_->lookup(AsStringRef(name))) {
+  // The lookups of the JIT are thread-safe, and may compile the lazy or the shared modules, so they don't hold the lock
+  // of the object files.
+  if (auto symbol = jit()->lookup(*dylib_, AsStringRef(name))) {
     return reinterpret_cast<void *>(symbol->getAddress());
   }
 
@@ -221,18 +785,15 @@ void *ExecutionEngine::Lookup(absl::string_view name) {
 }
 
 void ExecutionEngine::RegisterRuntimeSymbols() {
-  const auto &registry = RuntimeSymbolRegistry::Global();
-  auto *session        = &jit_->getExecutionSession();
-  for (const auto &_name_addr_ : registry.All()) {
-    auto &name = std::get<0>(_name_addr_);
-    auto &addr = std::get<1>(_name_addr_);
-    llvm::cantFail(jit_->define(llvm::orc::absoluteSymbols(
-        {{session->intern(name), {llvm::pointerToJITTargetAddress(addr), llvm::JITSymbolFlags::None}}})));
-  }
+  DefineAbsoluteSymbols(&jit_->getMainJITDylib(), RuntimeSymbolRegistry::Global().All());
 }
 
 template void ExecutionEngine::Link<CodeGenLLVM>(const ir::Module &module);
 template void ExecutionEngine::Link<CodeGenX86>(const ir::Module &module);
 template void ExecutionEngine::Link<CodeGenCUDA_Host>(const ir::Module &module);
+template void ExecutionEngine::LinkParallel<CodeGenLLVM>(const std::vector<ir::Module> &modules, int num_threads);
+template void ExecutionEngine::LinkParallel<CodeGenX86>(const std::vector<ir::Module> &modules, int num_threads);
+template void ExecutionEngine::LinkParallel<CodeGenCUDA_Host>(const std::vector<ir::Module> &modules,
+                                                              int num_threads);
 
 }  // namespace cinn::backends
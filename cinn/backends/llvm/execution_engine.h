@@ -14,7 +14,9 @@
 
 #pragma once
 
+#include <gflags/gflags.h>
 #include <llvm/ADT/StringMap.h>
+#include <llvm/Config/llvm-config.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/ExecutionEngine/JITSymbol.h>
 #include <llvm/ExecutionEngine/ObjectCache.h>
@@ -37,6 +39,7 @@
 #include <llvm/Support/raw_ostream.h>
 
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <optional>
@@ -44,9 +47,16 @@
 #include <vector>
 
 #include "cinn/backends/llvm/codegen_x86.h"
+#include "cinn/backends/llvm/llvm_optimizer.h"
 #include "cinn/backends/llvm/llvm_util.h"
+#include "cinn/common/precision.h"
 #include "cinn/ir/module.h"
 
+DECLARE_string(cinn_x86_export_cpus);
+DECLARE_bool(cinn_llvm_lazy_compile);
+DECLARE_int32(cinn_llvm_compile_threads);
+DECLARE_bool(cinn_llvm_shared_jit);
+
 namespace cinn::backends {
 
 class NaiveObjectCache : public llvm::ObjectCache {
@@ -55,30 +65,102 @@ class NaiveObjectCache : public llvm::ObjectCache {
   std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *) override;
 
  private:
+  std::mutex mu_;
   llvm::StringMap<std::unique_ptr<llvm::MemoryBuffer>> cached_objects_;
 };
 
 struct ExecutionOptions {
   int opt_level{3};
   bool enable_debug_info{false};
-  // TODO(fc500110)
-  // int num_compile_threads{1};
-  // bool enable_fast_math;
+  //! The number of threads the JIT compiles the modules added on, 1 to compile on the thread looking up the symbols.
+  int num_compile_threads{FLAGS_cinn_llvm_compile_threads};
+  /**
+   * Compile each function of the modules linked on its first call instead of at link time, only the functions called
+   * and their callees are compiled then. The objects of such modules are not kept for exporting.
+   */
+  bool lazy_compile{FLAGS_cinn_llvm_lazy_compile};
+  /**
+   * Link the modules into a JITDylib of the process-wide JIT instead of a JIT of the engine, which shares the runtime
+   * symbols with the other engines. The code of the engine is unloaded when it is destructed. It is ignored by the
+   * lazy engines.
+   */
+  bool shared_jit{FLAGS_cinn_llvm_shared_jit};
+  //! The fast-math flags of the float math generated, none in the strict mode, see common::PrecisionMode.
+  common::PrecisionMode precision_mode{common::DefaultPrecisionMode()};
 };
 
 class ExecutionEngine {
  public:
   static std::unique_ptr<ExecutionEngine> Create(const ExecutionOptions &config);
 
+  ~ExecutionEngine();
+
   void *Lookup(absl::string_view name);
 
   template <typename CodeGenT = CodeGenLLVM>
   void Link(const ir::Module &module);
 
+  /**
+   * Compile the \p modules concurrently on \p num_threads threads and link all of them, it is the same as linking
+   * them one by one but much faster for a large number of functions. Each module embeds a private copy of the runtime.
+   * With the lazy compilation, the LLVM modules are generated and added concurrently, and compiled on their first call.
+   */
+  template <typename CodeGenT = CodeGenLLVM>
+  void LinkParallel(const std::vector<ir::Module> &modules, int num_threads);
+
+  //! Export the object files of the modules linked, or the multi-versioned ones if FLAGS_cinn_x86_export_cpus is set.
   void ExportObject(const std::string &path);
 
+  /**
+   * Export the object files ExportObject exports as the members of the static library \p path, with the symbol table
+   * for the linkers. Each item of \p data is compiled to a member defining the read-only bytes `<name>`(uint8_t[])
+   * and their number `<name>_size`(int64_t), e.g. the parameters embedded in an ahead-of-time compiled model.
+   */
+  void ExportStaticLibrary(const std::string &path, const std::map<std::string, std::string> &data = {});
+
+  //! Add an LLVM module, which is compiled lazily per function if the engine is lazy, it is thread-safe.
   bool AddModule(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> context);
 
+  //! Add a compiled object file, return false if it is invalid.
+  bool AddObject(const std::string &object);
+
+  /**
+   * Optimize the textual LLVM \p ir and compile it to an object file for the machine of \p triple, \p cpu and the
+   * comma separated \p features, e.g. on the compile service for a client, see RemoteCompiler.
+   */
+  static std::string CompileIR(const std::string &ir,
+                               const std::string &triple,
+                               const std::string &cpu,
+                               const std::string &features,
+                               const OptimizeOptions &options);
+
+  //! Whether the functions are compiled on their first call, see ExecutionOptions::lazy_compile.
+  bool lazy() const { return lazy_jit_ != nullptr; }
+
+  //! Whether the modules are linked into the process-wide JIT, see ExecutionOptions::shared_jit.
+  bool shared() const { return shared_jit_ != nullptr; }
+
+  //! Set the precision mode of the modules linked from now on, see ExecutionOptions::precision_mode.
+  void SetPrecisionMode(common::PrecisionMode mode) { precision_mode_ = mode; }
+  common::PrecisionMode precision_mode() const { return precision_mode_; }
+
+  //! The object files of all the modules linked.
+  const std::vector<std::string> &objects() const { return objects_; }
+
+  //! The multi-versioned object files of all the modules linked, to be exported.
+  const std::vector<std::string> &export_objects() const { return export_objects_; }
+
+  /**
+   * Let the next module linked define a function \p name calling the functions \p callees in order, so that they can
+   * be inlined into one function. The arguments of the k-th call are read from the k-th elements of the global arrays
+   * `<name>_args`(cinn_pod_value_t*) and `<name>_nargs`(int32_t), which should be filled before calling it. The
+   * function has the same signature as the lowered functions and ignores its arguments.
+   */
+  void SetEntryFunction(const std::string &name, const std::vector<std::string> &callees) {
+    entry_name_    = name;
+    entry_callees_ = callees;
+  }
+
  protected:
   explicit ExecutionEngine(bool enable_object_cache) : cache_(std::make_unique<NaiveObjectCache>()) {}
 
@@ -86,13 +168,56 @@ class ExecutionEngine {
 
   bool SetupTargetTriple(llvm::Module *module);
 
+  //! Generate the LLVM module of \p module with the runtime, only the lowered functions and the entry are external.
+  template <typename CodeGenT>
+  std::unique_ptr<llvm::Module> GenerateModule(const ir::Module &module, llvm::LLVMContext *ctx);
+
+  /**
+   * Optimize \p m and compile it to an object file for the LLVM CPU \p cpu, the host if it is empty, or load the object
+   * from the disk cache, or compile it on the compile service if there is one, see RemoteCompiler. It is thread-safe.
+   */
+  std::string CompileObject(llvm::Module *m, const std::string &cpu = "");
+
+  /**
+   * Compile a version of the lowered functions of \p module for each CPU of FLAGS_cinn_x86_export_cpus, the version
+   * of `fn` for the CPU `haswell` is named `fn_haswell`, and the others definitions of the versions are internal. A
+   * stub `fn` compiled for the baseline X86 CPU calls the most demanding version the host supports.
+   * @param m The unoptimized LLVM module of \p module, which is not modified.
+   * @return The object files of the versions and the stubs.
+   */
+  std::vector<std::string> CompileVersions(const llvm::Module &m, const ir::Module &module);
+
+  //! The JIT the modules are linked into, the process-wide one if the engine is shared.
+  llvm::orc::LLJIT *jit() const { return shared_jit_ ? shared_jit_ : jit_.get(); }
+
   friend std::unique_ptr<ExecutionEngine> std::make_unique<ExecutionEngine>(bool &&);
 
  private:
+  // Guard the object files.
   mutable std::mutex mu_;
-  llvm::SmallString<0> buffer_;
+  // The object files linked, to be exported.
+  std::vector<std::string> objects_;
+  // The object files of the multi-versioned functions, which are exported instead if they exist.
+  std::vector<std::string> export_objects_;
+  // The JIT of the engine, null if it is shared.
   std::unique_ptr<llvm::orc::LLJIT> jit_;
+  // The process-wide JIT if the engine is shared, otherwise null.
+  llvm::orc::LLJIT *shared_jit_{};
+  // The JITDylib the modules are linked into, the main one of jit_ if the engine is not shared.
+  llvm::orc::JITDylib *dylib_{};
+#if LLVM_VERSION_MAJOR >= 12
+  // Track the code linked into dylib_, to unload it from the shared JIT.
+  llvm::orc::ResourceTrackerSP tracker_;
+#endif
+  // The optimization level of the modules compiled eagerly.
+  int opt_level_{3};
+  common::PrecisionMode precision_mode_{common::PrecisionMode::kFast};
+  // The same JIT as jit_ if it compiles lazily, otherwise null.
+  llvm::orc::LLLazyJIT *lazy_jit_{};
   std::unique_ptr<NaiveObjectCache> cache_;
+  // The entry function to define in the next module linked.
+  std::string entry_name_;
+  std::vector<std::string> entry_callees_;
 };
 
 }  // namespace cinn::backends
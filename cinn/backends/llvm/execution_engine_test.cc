@@ -14,6 +14,7 @@
 
 #include "cinn/backends/llvm/execution_engine.h"
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <glog/raw_logging.h>
 #include <gtest/gtest.h>
@@ -26,18 +27,22 @@
 #include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/raw_ostream.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <memory>
 #include <random>
+#include <string>
 #include <tuple>
 #include <utility>
 #include <vector>
 
+#include "cinn/backends/compilation_cache.h"
 #include "cinn/backends/llvm/cinn_runtime_llvm_ir.h"
 #include "cinn/backends/llvm/codegen_llvm.h"
+#include "cinn/backends/llvm/llvm_optimizer.h"
 #include "cinn/backends/llvm/runtime_symbol_registry.h"
 #include "cinn/cinn.h"
 #include "cinn/ir/ir.h"
@@ -325,5 +330,241 @@ TEST(ExecutionEngine, call_extern) {
   }
 }
 
+TEST(ExecutionEngine, compilation_cache) {
+  ir::Expr M(kM);
+  ir::Expr N(kN);
+
+  Placeholder<float> x("x", {M, N});
+  Placeholder<float> y("y", {M, N});
+
+  auto res = Compute(
+      {M, N}, [=](Var i, Var j) { return x(i, j) * y(i, j); }, "res");
+
+  auto stages = CreateStages({res});
+  auto func   = Lower("cached_comp", stages, {x, y, res});
+
+  Module::Builder builder("module0", common::DefaultHostTarget());
+  builder.AddFunction(func);
+  auto module = builder.Build();
+
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  std::string cache_dir = "./execution_engine_test_cache_" + std::to_string(getpid());
+  FLAGS_cinn_compilation_cache_dir = cache_dir;
+
+  auto _ab_bb_cb_ = CreateTestBuffer();  // NOLINT
+  auto &ab        = std::get<0>(_ab_bb_cb_);
+  auto &bb        = std::get<1>(_ab_bb_cb_);
+  auto &cb        = std::get<2>(_ab_bb_cb_);
+  cinn_pod_value_t a_arg(ab), b_arg(bb), c_arg(cb);
+  cinn_pod_value_t args[3] = {a_arg, b_arg, c_arg};
+
+  auto *ad = reinterpret_cast<float *>(ab->memory);
+  auto *bd = reinterpret_cast<float *>(bb->memory);
+  auto *cd = reinterpret_cast<float *>(cb->memory);
+
+  // The first engine compiles and stores the object, the second one loads it from the cache.
+  for (int i = 0; i < 2; i++) {
+    auto engine = backends::ExecutionEngine::Create({1});
+    engine->Link(module);
+    auto comp = reinterpret_cast<void (*)(void *, int32_t)>(engine->Lookup("cached_comp"));
+    ASSERT_TRUE(comp);
+
+    std::fill(cd, cd + kM * kN, 0.f);
+    comp(args, 3);
+    for (int m = 0; m < kM * kN; m++) {
+      ASSERT_NEAR(cd[m], ad[m] * bd[m], 1e-5);
+    }
+  }
+}
+
+TEST(ExecutionEngine, multi_versioned_export) {
+  ir::Expr M(kM);
+  ir::Expr N(kN);
+
+  Placeholder<float> x("x", {M, N});
+  Placeholder<float> y("y", {M, N});
+
+  auto res = Compute(
+      {M, N}, [=](Var i, Var j) { return x(i, j) + y(i, j); }, "res");
+
+  auto stages = CreateStages({res});
+  auto func   = Lower("multi_versioned", stages, {x, y, res});
+
+  Module::Builder builder("module0", common::DefaultHostTarget());
+  builder.AddFunction(func);
+  auto module = builder.Build();
+
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  FLAGS_cinn_x86_export_cpus = "x86-64,haswell,skylake-avx512";
+  auto engine                = backends::ExecutionEngine::Create({1});
+  engine->Link(module);
+  // a version for each CPU and the stubs
+  ASSERT_EQ(engine->export_objects().size(), 4UL);
+
+  // the stub dispatches to one of the versions the host supports
+  auto exported = backends::ExecutionEngine::Create({1});
+  for (auto &object : engine->export_objects()) {
+    ASSERT_TRUE(exported->AddObject(object));
+  }
+  auto fn = reinterpret_cast<void (*)(void *, int32_t)>(exported->Lookup("multi_versioned"));
+  ASSERT_TRUE(fn);
+
+  auto _ab_bb_cb_ = CreateTestBuffer();  // NOLINT
+  auto &ab        = std::get<0>(_ab_bb_cb_);
+  auto &bb        = std::get<1>(_ab_bb_cb_);
+  auto &cb        = std::get<2>(_ab_bb_cb_);
+  cinn_pod_value_t a_arg(ab), b_arg(bb), c_arg(cb);
+  cinn_pod_value_t args[3] = {a_arg, b_arg, c_arg};
+  fn(args, 3);
+
+  auto *ad = reinterpret_cast<float *>(ab->memory);
+  auto *bd = reinterpret_cast<float *>(bb->memory);
+  auto *cd = reinterpret_cast<float *>(cb->memory);
+  for (int m = 0; m < kM * kN; m++) {
+    ASSERT_NEAR(cd[m], ad[m] + bd[m], 1e-5);
+  }
+}
+
+TEST(ExecutionEngine, lazy_compile) {
+  ir::Expr M(kM);
+  ir::Expr N(kN);
+
+  Placeholder<float> x("x", {M, N});
+  Placeholder<float> y("y", {M, N});
+
+  auto add = Compute(
+      {M, N}, [=](Var i, Var j) { return x(i, j) + y(i, j); }, "add");
+  auto mul = Compute(
+      {M, N}, [=](Var i, Var j) { return x(i, j) * y(i, j); }, "mul");
+
+  std::vector<ir::Module> modules;
+  for (auto &tensor : {add, mul}) {
+    auto stages = CreateStages({tensor});
+    Module::Builder builder("module_" + tensor->name, common::DefaultHostTarget());
+    builder.AddFunction(Lower("lazy_" + tensor->name, stages, {x, y, tensor}));
+    modules.push_back(builder.Build());
+  }
+
+  ExecutionOptions options;
+  options.num_compile_threads = 2;
+  options.lazy_compile        = true;
+  auto engine                 = backends::ExecutionEngine::Create(options);
+  ASSERT_TRUE(engine->lazy());
+  // the modules are added concurrently
+  engine->LinkParallel(modules, 2);
+  ASSERT_TRUE(engine->objects().empty());
+
+  auto _ab_bb_cb_ = CreateTestBuffer();  // NOLINT
+  auto &ab        = std::get<0>(_ab_bb_cb_);
+  auto &bb        = std::get<1>(_ab_bb_cb_);
+  auto &cb        = std::get<2>(_ab_bb_cb_);
+  cinn_pod_value_t a_arg(ab), b_arg(bb), c_arg(cb);
+  cinn_pod_value_t args[3] = {a_arg, b_arg, c_arg};
+
+  auto *ad = reinterpret_cast<float *>(ab->memory);
+  auto *bd = reinterpret_cast<float *>(bb->memory);
+  auto *cd = reinterpret_cast<float *>(cb->memory);
+  // the function is compiled on its first call
+  auto fn_add = reinterpret_cast<void (*)(void *, int32_t)>(engine->Lookup("lazy_add"));
+  ASSERT_TRUE(fn_add);
+  fn_add(args, 3);
+  for (int m = 0; m < kM * kN; m++) {
+    ASSERT_NEAR(cd[m], ad[m] + bd[m], 1e-5);
+  }
+  auto fn_mul = reinterpret_cast<void (*)(void *, int32_t)>(engine->Lookup("lazy_mul"));
+  ASSERT_TRUE(fn_mul);
+  fn_mul(args, 3);
+  for (int m = 0; m < kM * kN; m++) {
+    ASSERT_NEAR(cd[m], ad[m] * bd[m], 1e-5);
+  }
+}
+
+TEST(ExecutionEngine, shared_jit) {
+  ir::Expr M(kM);
+  ir::Expr N(kN);
+
+  Placeholder<float> x("x", {M, N});
+  Placeholder<float> y("y", {M, N});
+
+  auto add = Compute(
+      {M, N}, [=](Var i, Var j) { return x(i, j) + y(i, j); }, "add");
+  auto mul = Compute(
+      {M, N}, [=](Var i, Var j) { return x(i, j) * y(i, j); }, "mul");
+
+  // the engines in the same JIT define the functions of the same name
+  ExecutionOptions options;
+  options.shared_jit = true;
+  std::vector<std::unique_ptr<ExecutionEngine>> engines;
+  for (auto &tensor : {add, mul}) {
+    auto stages = CreateStages({tensor});
+    Module::Builder builder("module0", common::DefaultHostTarget());
+    builder.AddFunction(Lower("shared_fn", stages, {x, y, tensor}));
+    engines.push_back(backends::ExecutionEngine::Create(options));
+    ASSERT_TRUE(engines.back()->shared());
+    engines.back()->Link(builder.Build());
+  }
+
+  auto _ab_bb_cb_ = CreateTestBuffer();  // NOLINT
+  auto &ab        = std::get<0>(_ab_bb_cb_);
+  auto &bb        = std::get<1>(_ab_bb_cb_);
+  auto &cb        = std::get<2>(_ab_bb_cb_);
+  cinn_pod_value_t a_arg(ab), b_arg(bb), c_arg(cb);
+  cinn_pod_value_t args[3] = {a_arg, b_arg, c_arg};
+
+  auto *ad    = reinterpret_cast<float *>(ab->memory);
+  auto *bd    = reinterpret_cast<float *>(bb->memory);
+  auto *cd    = reinterpret_cast<float *>(cb->memory);
+  auto fn_mul = reinterpret_cast<void (*)(void *, int32_t)>(engines[1]->Lookup("shared_fn"));
+  ASSERT_TRUE(fn_mul);
+  // the code of the other engine is unloaded
+  engines[0].reset();
+  fn_mul(args, 3);
+  for (int m = 0; m < kM * kN; m++) {
+    ASSERT_NEAR(cd[m], ad[m] * bd[m], 1e-5);
+  }
+}
+
+TEST(ExecutionEngine, new_pass_manager) {
+  ir::Expr M(kM);
+  ir::Expr N(kN);
+
+  Placeholder<float> x("x", {M, N});
+  Placeholder<float> y("y", {M, N});
+
+  auto res = Compute(
+      {M, N}, [=](Var i, Var j) { return x(i, j) - y(i, j); }, "res");
+
+  auto stages = CreateStages({res});
+  stages[res]->Vectorize(1, 8);
+  auto func = Lower("new_pm_comp", stages, {x, y, res});
+
+  Module::Builder builder("module0", common::DefaultHostTarget());
+  builder.AddFunction(func);
+  auto module = builder.Build();
+
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  FLAGS_cinn_llvm_new_pass_manager        = true;
+  FLAGS_cinn_llvm_keep_schedule_vectorize = true;
+  auto engine                             = backends::ExecutionEngine::Create({3});
+  engine->Link(module);
+  auto comp = reinterpret_cast<void (*)(void *, int32_t)>(engine->Lookup("new_pm_comp"));
+  ASSERT_TRUE(comp);
+
+  auto _ab_bb_cb_ = CreateTestBuffer();  // NOLINT
+  auto &ab        = std::get<0>(_ab_bb_cb_);
+  auto &bb        = std::get<1>(_ab_bb_cb_);
+  auto &cb        = std::get<2>(_ab_bb_cb_);
+  cinn_pod_value_t a_arg(ab), b_arg(bb), c_arg(cb);
+  cinn_pod_value_t args[3] = {a_arg, b_arg, c_arg};
+  comp(args, 3);
+
+  auto *ad = reinterpret_cast<float *>(ab->memory);
+  auto *bd = reinterpret_cast<float *>(bb->memory);
+  auto *cd = reinterpret_cast<float *>(cb->memory);
+  for (int m = 0; m < kM * kN; m++) {
+    ASSERT_NEAR(cd[m], ad[m] - bd[m], 1e-5);
+  }
+}
+
 }  // namespace backends
 }  // namespace cinn
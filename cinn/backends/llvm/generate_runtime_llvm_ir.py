@@ -21,6 +21,8 @@ import subprocess
 def main():
     path = sys.argv[1]
     out_path = sys.argv[2]
+    # the bitcode of the same IR, which is much faster to load for each module
+    bitcode_path = sys.argv[3] if len(sys.argv) > 3 else None
 
     srcs = []
     srcs.append('#include <absl/strings/string_view.h>')
@@ -34,6 +36,21 @@ def main():
     srcs.append(')ROC"')
     srcs.append(');\n')
 
+    if bitcode_path:
+        with open(bitcode_path, 'rb') as fr:
+            bitcode = fr.read()
+        srcs.append("static const unsigned char kRuntimeLlvmBitcodeData[] = {")
+        for i in range(0, len(bitcode), 16):
+            srcs.append("    " + ", ".join(
+                "0x{:02x}".format(b) for b in bitcode[i:i + 16]) + ",")
+        srcs.append("};")
+        srcs.append(
+            "static const absl::string_view kRuntimeLlvmBitcode(reinterpret_cast<const char*>(kRuntimeLlvmBitcodeData),"
+        )
+        srcs.append(
+            "                                                   sizeof(kRuntimeLlvmBitcodeData));\n"
+        )
+
     cmd = "llvm-config --version"
     version = subprocess.check_output(
         cmd, shell=True).decode('utf-8').strip().split('.')
@@ -17,6 +17,7 @@
 #include <glog/logging.h>
 #include <llvm/ADT/Triple.h>
 #include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/LoopInfo.h>
 #include <llvm/AsmParser/Parser.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/ExecutionEngine/JITSymbol.h>
@@ -28,6 +29,7 @@
 #include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
 #include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
 #include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/IR/Dominators.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Module.h>
@@ -51,16 +53,29 @@
 #include <llvm/Transforms/Scalar/NewGVN.h>
 #include <llvm/Transforms/Scalar/Reassociate.h>
 #include <llvm/Transforms/Scalar/SimplifyCFG.h>
+#include <llvm/Transforms/Utils/LoopUtils.h>
 #include <llvm/Transforms/Vectorize.h>
 
 #include <algorithm>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "cinn/utils/string.h"
 #include "llvm/Support/CodeGen.h"
 
+DEFINE_bool(cinn_llvm_new_pass_manager, false, "Whether to optimize the LLVM modules by the new pass manager");
+DEFINE_bool(cinn_llvm_loop_vectorize, true, "Whether to run the loop vectorizer of LLVM");
+DEFINE_bool(cinn_llvm_slp_vectorize, true, "Whether to run the SLP vectorizer of LLVM");
+DEFINE_int32(cinn_llvm_interleave_count, 0, "The interleave count of the loops, 0 to let LLVM decide");
+DEFINE_int32(cinn_llvm_inline_threshold, -1, "The threshold of the LLVM inliner, -1 for the default");
+DEFINE_bool(cinn_llvm_keep_schedule_vectorize,
+            false,
+            "Whether to keep the loops vectorized by the Vectorize schedule from being vectorized by LLVM again");
+
 namespace cinn::backends {
 
 namespace {
@@ -113,18 +128,122 @@ class CustomPassManager : public PassManagerT {
 
 using CustomFunctionPassManager = CustomPassManager<llvm::legacy::FunctionPassManager>;
 using CustomModulePassManager   = CustomPassManager<llvm::legacy::PassManager>;
+
+bool HasVectorCode(const llvm::Loop &loop) {
+  for (auto *block : loop.blocks()) {
+    for (auto &inst : *block) {
+      if (inst.getType()->isVectorTy()) return true;
+      if (auto *store = llvm::dyn_cast<llvm::StoreInst>(&inst)) {
+        if (store->getValueOperand()->getType()->isVectorTy()) return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Attach the loop hints of \p options to the loops of \p m, which both of the pass managers follow.
+void AddLoopHints(llvm::Module *m, const OptimizeOptions &options) {
+  if (!options.keep_schedule_vectorize && options.interleave_count <= 0) return;
+  for (auto &f : *m) {
+    if (f.isDeclaration()) continue;
+    llvm::DominatorTree dom_tree(f);
+    llvm::LoopInfo loop_info(dom_tree);
+    for (auto *loop : loop_info.getLoopsInPreorder()) {
+      if (options.keep_schedule_vectorize && HasVectorCode(*loop)) {
+        // The vector width 1 disables the vectorization but allows the unrolling.
+        llvm::addStringMetadataToLoop(loop, "llvm.loop.vectorize.width", 1);
+        llvm::addStringMetadataToLoop(loop, "llvm.loop.interleave.count", 1);
+      } else if (options.interleave_count > 0) {
+        llvm::addStringMetadataToLoop(loop, "llvm.loop.interleave.count", options.interleave_count);
+      }
+    }
+  }
+}
+
+std::unique_ptr<llvm::TargetMachine> CreateTargetMachine(const OptimizeOptions &options) {
+  auto builder = llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost());
+  if (!options.cpu.empty()) {
+    builder.setCPU(options.cpu);
+    // The features of the host CPU don't apply to the other ones.
+    builder.getFeatures() = llvm::SubtargetFeatures();
+  }
+  if (!options.features.empty()) builder.addFeatures(utils::Split(options.features, ","));
+  return llvm::cantFail(builder.createTargetMachine());
+}
 }  // namespace
 
+std::string OptimizeOptions::ToString() const {
+  std::stringstream ss;
+  ss << "opt_level=" << opt_level << ",cpu=" << cpu << ",features=" << features
+     << ",new_pass_manager=" << use_new_pass_manager << ",loop_vectorize=" << loop_vectorize
+     << ",slp_vectorize=" << slp_vectorize << ",interleave_count=" << interleave_count
+     << ",inline_threshold=" << inline_threshold << ",keep_schedule_vectorize=" << keep_schedule_vectorize;
+  return ss.str();
+}
+
+OptimizeOptions OptimizeOptions::FromString(const std::string &str) {
+  // The features are separated by commas too, so each value ends at the next key.
+  const std::vector<std::string> keys = {"opt_level",
+                                         "cpu",
+                                         "features",
+                                         "new_pass_manager",
+                                         "loop_vectorize",
+                                         "slp_vectorize",
+                                         "interleave_count",
+                                         "inline_threshold",
+                                         "keep_schedule_vectorize"};
+  std::vector<std::string> values;
+  size_t pos = 0;
+  for (int i = 0; i < keys.size(); i++) {
+    std::string key = (i == 0 ? "" : ",") + keys[i] + "=";
+    CHECK_EQ(str.compare(pos, key.size(), key), 0) << "No " << keys[i] << " in the optimize options: " << str;
+    size_t begin = pos + key.size();
+    pos          = i + 1 < keys.size() ? str.find("," + keys[i + 1] + "=", begin) : str.size();
+    CHECK_NE(pos, std::string::npos) << "Invalid optimize options: " << str;
+    values.push_back(str.substr(begin, pos - begin));
+  }
+  OptimizeOptions options;
+  options.opt_level               = std::stoi(values[0]);
+  options.cpu                     = values[1];
+  options.features                = values[2];
+  options.use_new_pass_manager    = values[3] == "1";
+  options.loop_vectorize          = values[4] == "1";
+  options.slp_vectorize           = values[5] == "1";
+  options.interleave_count        = std::stoi(values[6]);
+  options.inline_threshold        = std::stoi(values[7]);
+  options.keep_schedule_vectorize = values[8] == "1";
+  return options;
+}
+
 LLVMModuleOptimizer::LLVMModuleOptimizer(llvm::TargetMachine *machine,
                                          int opt_level,
                                          llvm::FastMathFlags fast_math_flags,
                                          bool print_passes)
-    : opt_level_(opt_level), print_passes_(print_passes), machine_(machine) {}
+    : machine_(machine) {
+  options_.opt_level    = opt_level;
+  options_.print_passes = print_passes;
+}
+
+LLVMModuleOptimizer::LLVMModuleOptimizer(llvm::TargetMachine *machine, const OptimizeOptions &options)
+    : machine_(machine), options_(options) {}
 
 void LLVMModuleOptimizer::operator()(llvm::Module *m) {
-  auto machine =
-      std::move(llvm::cantFail(llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost()).createTargetMachine()));
-  auto fpm = std::make_unique<CustomFunctionPassManager>(print_passes_, m);
+  std::unique_ptr<llvm::TargetMachine> owned_machine;
+  auto *machine = machine_;
+  if (!machine) {
+    owned_machine = CreateTargetMachine(options_);
+    machine       = owned_machine.get();
+  }
+  AddLoopHints(m, options_);
+  if (options_.use_new_pass_manager) {
+    RunNewPassManager(m, machine);
+  } else {
+    RunLegacyPassManager(m, machine);
+  }
+}
+
+void LLVMModuleOptimizer::RunLegacyPassManager(llvm::Module *m, llvm::TargetMachine *machine) {
+  auto fpm = std::make_unique<CustomFunctionPassManager>(options_.print_passes, m);
   // fpm->add(llvm::createTargetTransformInfoWrapperPass(llvm::TargetIRAnalysis()));
   // fpm->add(llvm::createInstructionCombiningPass());
   // fpm->add(llvm::createReassociatePass());
@@ -139,17 +258,18 @@ void LLVMModuleOptimizer::operator()(llvm::Module *m) {
   // fpm->add(llvm::createLoadStoreVectorizerPass());
   // fpm->add(llvm::createLoopUnrollPass());
 
-  auto mpm = std::make_unique<CustomModulePassManager>(print_passes_);
+  auto mpm = std::make_unique<CustomModulePassManager>(options_.print_passes);
   // mpm->add(llvm::createTargetTransformInfoWrapperPass(llvm::TargetIRAnalysis()));
   // LOG(INFO) << "llvm run pass: target machine: name[" << machine_->getTarget().getName() << "]";
   // LOG(INFO) << "llvm run pass: target machine: cpu[" << machine_->getTargetCPU().str() << "]";
   fpm->add(llvm::createTargetTransformInfoWrapperPass(machine->getTargetIRAnalysis()));
   mpm->add(llvm::createTargetTransformInfoWrapperPass(machine->getTargetIRAnalysis()));
   auto builder           = std::make_unique<llvm::PassManagerBuilder>();
-  builder->OptLevel      = opt_level_;
-  builder->Inliner       = llvm::createFunctionInliningPass();
-  builder->LoopVectorize = true;
-  builder->SLPVectorize  = true;
+  builder->OptLevel = options_.opt_level;
+  builder->Inliner  = options_.inline_threshold >= 0 ? llvm::createFunctionInliningPass(options_.inline_threshold)
+                                                     : llvm::createFunctionInliningPass();
+  builder->LoopVectorize = options_.loop_vectorize;
+  builder->SLPVectorize  = options_.slp_vectorize;
   builder->populateFunctionPassManager(*fpm);
   builder->populateModulePassManager(*mpm);
 
@@ -160,4 +280,31 @@ void LLVMModuleOptimizer::operator()(llvm::Module *m) {
   mpm->run(*m);
 }
 
+void LLVMModuleOptimizer::RunNewPassManager(llvm::Module *m, llvm::TargetMachine *machine) {
+  if (options_.opt_level <= 0) return;
+  llvm::PipelineTuningOptions tuning;
+  tuning.LoopVectorization = options_.loop_vectorize;
+  tuning.SLPVectorization  = options_.slp_vectorize;
+  tuning.LoopInterleaving  = options_.interleave_count != 1;
+  llvm::PassBuilder builder(machine, tuning);
+
+  // The new pass manager prints the passes to stderr, so it follows the verbosity as the legacy one.
+  bool debug_logging = options_.print_passes && VLOG_IS_ON(1);
+  llvm::LoopAnalysisManager lam(debug_logging);
+  llvm::FunctionAnalysisManager fam(debug_logging);
+  llvm::CGSCCAnalysisManager cgam(debug_logging);
+  llvm::ModuleAnalysisManager mam(debug_logging);
+  fam.registerPass([&] { return builder.buildDefaultAAPipeline(); });
+  builder.registerModuleAnalyses(mam);
+  builder.registerCGSCCAnalyses(cgam);
+  builder.registerFunctionAnalyses(fam);
+  builder.registerLoopAnalyses(lam);
+  builder.crossRegisterProxies(lam, fam, cgam, mam);
+
+  using Level = llvm::PassBuilder::OptimizationLevel;
+  Level level = options_.opt_level == 1 ? Level::O1 : options_.opt_level == 2 ? Level::O2 : Level::O3;
+  auto mpm    = builder.buildPerModuleDefaultPipeline(level, debug_logging);
+  mpm.run(*m, mam);
+}
+
 }  // namespace cinn::backends
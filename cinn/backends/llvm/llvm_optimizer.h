@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <gflags/gflags.h>
 #include <llvm/IR/Instruction.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Module.h>
@@ -21,10 +22,44 @@
 #include <llvm/Target/TargetMachine.h>
 
 #include <functional>
+#include <string>
+
+DECLARE_bool(cinn_llvm_new_pass_manager);
+DECLARE_bool(cinn_llvm_loop_vectorize);
+DECLARE_bool(cinn_llvm_slp_vectorize);
+DECLARE_int32(cinn_llvm_interleave_count);
+DECLARE_int32(cinn_llvm_inline_threshold);
+DECLARE_bool(cinn_llvm_keep_schedule_vectorize);
 
 namespace cinn::backends {
 
-// TODO(fc500110): define class OptimizeOptions
+//! The options of the LLVM optimization pipeline, the defaults are taken from the flags.
+struct OptimizeOptions {
+  int opt_level{3};
+  //! The LLVM CPU name and the comma separated features, e.g. +avx2, of the target machine if none is given, empty for
+  //! the ones of the host.
+  std::string cpu;
+  std::string features;
+  //! Run the default pipeline of the new pass manager instead of the legacy one.
+  bool use_new_pass_manager{FLAGS_cinn_llvm_new_pass_manager};
+  bool loop_vectorize{FLAGS_cinn_llvm_loop_vectorize};
+  bool slp_vectorize{FLAGS_cinn_llvm_slp_vectorize};
+  //! The interleave count of all the loops, 0 to let the loop vectorizer decide.
+  int interleave_count{FLAGS_cinn_llvm_interleave_count};
+  //! The threshold of the inliner, -1 for the default of the level. The new pass manager always uses the default.
+  int inline_threshold{FLAGS_cinn_llvm_inline_threshold};
+  /**
+   * Keep the vector code of CINN's Vectorize schedule as it is: the loops holding vector instructions are neither
+   * vectorized nor interleaved by LLVM again.
+   */
+  bool keep_schedule_vectorize{FLAGS_cinn_llvm_keep_schedule_vectorize};
+  bool print_passes{false};
+
+  //! The options affecting the code generated, e.g. for the key of the compiled code.
+  std::string ToString() const;
+  //! Parse the options from ToString, e.g. those of the client of a compile service, see RemoteCompiler.
+  static OptimizeOptions FromString(const std::string& str);
+};
 
 // llvm module optimizer
 class LLVMModuleOptimizer final {
@@ -33,11 +68,15 @@ class LLVMModuleOptimizer final {
                                int opt_level,
                                llvm::FastMathFlags fast_math_flags,
                                bool print_passes = false);
+  //! Optimize for \p machine, or the machine described by \p options if it is null.
+  LLVMModuleOptimizer(llvm::TargetMachine *machine, const OptimizeOptions &options);
   void operator()(llvm::Module *m);
 
  private:
+  void RunLegacyPassManager(llvm::Module *m, llvm::TargetMachine *machine);
+  void RunNewPassManager(llvm::Module *m, llvm::TargetMachine *machine);
+
   llvm::TargetMachine *machine_;
-  int opt_level_{};
-  bool print_passes_{};
+  OptimizeOptions options_;
 };
 }  // namespace cinn::backends
@@ -36,8 +36,10 @@ llvm::Type *CinnTypeToLLVMType(common::Type type, llvm::Module *m, bool is_vec)
   llvm::Type *i32 = llvm::Type::getInt32Ty(m->getContext());
   llvm::Type *i64 = llvm::Type::getInt64Ty(m->getContext());
   llvm::Type *u32 = llvm::Type::getInt32Ty(m->getContext());
-  llvm::Type *f32 = llvm::Type::getFloatTy(m->getContext());
-  llvm::Type *f64 = llvm::Type::getDoubleTy(m->getContext());
+  llvm::Type *f16  = llvm::Type::getHalfTy(m->getContext());
+  llvm::Type *bf16 = llvm::Type::getBFloatTy(m->getContext());
+  llvm::Type *f32  = llvm::Type::getFloatTy(m->getContext());
+  llvm::Type *f64  = llvm::Type::getDoubleTy(m->getContext());
   if (type.is_void() && type.is_cpp_handle()) {
     return llvm::PointerType::getUnqual(i8);
   }
@@ -53,6 +55,10 @@ llvm::Type *CinnTypeToLLVMType(common::Type type, llvm::Module *m, bool is_vec)
     ir_type = i64;
   } else if (type.is_bool()) {
     ir_type = i1;
+  } else if (type.is_float(16)) {
+    ir_type = f16;
+  } else if (type.is_bfloat16()) {
+    ir_type = bf16;
   } else if (type.is_float(32)) {
     ir_type = f32;
   } else if (type.is_float(64)) {
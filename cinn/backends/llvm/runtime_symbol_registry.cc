@@ -17,6 +17,7 @@
 #include <absl/strings/string_view.h>
 #include <glog/raw_logging.h>
 
+#include <cstring>
 #include <iostream>
 
 namespace cinn {
@@ -42,6 +43,18 @@ void RuntimeSymbolRegistry::Register(const std::string &name, void *address) {
   RAW_LOG_INFO("JIT Register function [%s]: %p", name.c_str(), address);
 #endif  // CINN_WITH_DEBUG
   std::lock_guard<std::mutex> lock(mu_);
+  InsertSymbol(name, address);
+}
+
+void RuntimeSymbolRegistry::RegisterScalar(const std::string &name, const void *data, size_t size) {
+  std::lock_guard<std::mutex> lock(mu_);
+  auto &holder = scalar_holder_[name];
+  holder.resize(size);
+  memcpy(holder.data(), data, size);
+  InsertSymbol(name, reinterpret_cast<void *>(holder.data()));
+}
+
+void RuntimeSymbolRegistry::InsertSymbol(const std::string &name, void *address) {
   auto it = symbols_.find(name);
   if (it != symbols_.end()) {
     CHECK_EQ(it->second, address) << "Duplicate register symbol [" << name << "]";
@@ -51,6 +64,11 @@ void RuntimeSymbolRegistry::Register(const std::string &name, void *address) {
   symbols_.insert({name, reinterpret_cast<void *>(address)});
 }
 
+std::map<std::string, void *> RuntimeSymbolRegistry::All() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return symbols_;
+}
+
 void RuntimeSymbolRegistry::Clear() {
   std::lock_guard<std::mutex> lock(mu_);
   symbols_.clear();
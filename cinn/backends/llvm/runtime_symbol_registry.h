@@ -50,12 +50,7 @@ class RuntimeSymbolRegistry {
    * @param val Scalar value.
    */
   template <typename T>
-  void RegisterVar(const std::string &name, T val) {
-    auto &data = scalar_holder_[name];
-    data.resize(sizeof(T));
-    memcpy(data.data(), &val, sizeof(T));
-    Register(name, reinterpret_cast<void *>(data.data()));
-  }
+  void RegisterVar(const std::string &name, T val) { RegisterScalar(name, &val, sizeof(T)); }
 
   /**
    * Lookup a symbol from the registry.
@@ -65,9 +60,9 @@ class RuntimeSymbolRegistry {
   void *Lookup(absl::string_view name) const;
 
   /**
-   * Get all the symbols.
+   * Get a snapshot of all the symbols, which may be registered concurrently.
    */
-  const std::map<std::string, void *> &All() const { return symbols_; }
+  std::map<std::string, void *> All() const;
 
   /**
    * Clear all the symbols.
@@ -82,6 +77,12 @@ class RuntimeSymbolRegistry {
    */
   void Register(const std::string &name, void *address);
 
+  //! Register a copy of the scalar of \p size bytes, held by the registry.
+  void RegisterScalar(const std::string &name, const void *data, size_t size);
+
+  //! Insert the symbol, the lock should be held.
+  void InsertSymbol(const std::string &name, void *address);
+
   RuntimeSymbolRegistry() = default;
   CINN_DISALLOW_COPY_AND_ASSIGN(RuntimeSymbolRegistry);
 
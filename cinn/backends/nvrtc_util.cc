@@ -18,18 +18,76 @@
 #include <cuda_runtime.h>
 #include <nvrtc.h>
 
+#include <algorithm>
+
 #include "cinn/backends/cuda_util.h"
 #include "cinn/common/common.h"
+#include "cinn/utils/compile_tracer.h"
 #include "cinn/utils/string.h"
 
+DEFINE_bool(cinn_nvrtc_cubin,
+            true,
+            "Whether to compile the CUDA code to the CUBIN of the devices' architecture, so that the driver doesn't "
+            "compile the PTX again when loading the modules on each device");
+
 namespace cinn {
 namespace backends {
 
-std::string NVRTC_Compiler::operator()(const std::string& code, bool include_headers) {
-  return CompilePTX(code, include_headers);
+namespace {
+
+struct DeviceArch {
+  //! The lowest compute capability of the devices, e.g. 80.
+  int cc{30};
+  //! Whether NVRTC could compile the CUBIN of the devices, which share the compute capability.
+  bool cubin{false};
+};
+
+//! The architecture of the devices, detected once as they don't change in the process.
+const DeviceArch& GetDeviceArch() {
+  static const DeviceArch arch = [] {
+    DeviceArch arch;
+    int num_devices = 0;
+    if (cudaGetDeviceCount(&num_devices) != cudaSuccess || num_devices == 0) {
+      LOG(WARNING) << "cannot detect compute capability from your device, "
+                   << "fall back to compute_30.";
+      return arch;
+    }
+    std::vector<int> ccs;
+    for (int i = 0; i < num_devices; i++) {
+      int major, minor;
+      cudaError_t e1 = cudaDeviceGetAttribute(&major, cudaDevAttrComputeCapabilityMajor, i);
+      cudaError_t e2 = cudaDeviceGetAttribute(&minor, cudaDevAttrComputeCapabilityMinor, i);
+      if (e1 != cudaSuccess || e2 != cudaSuccess) {
+        LOG(WARNING) << "cannot detect compute capability from your device, "
+                     << "fall back to compute_30.";
+        return arch;
+      }
+      ccs.push_back(major * 10 + minor);
+    }
+    arch.cc = *std::min_element(ccs.begin(), ccs.end());
+#if CUDA_VERSION >= 11010
+    arch.cubin = std::all_of(ccs.begin(), ccs.end(), [&](int cc) { return cc == arch.cc; });
+#endif
+#if CUDA_VERSION >= 11020
+    int num_archs;
+    NVRTC_CALL(nvrtcGetNumSupportedArchs(&num_archs));
+    std::vector<int> archs(num_archs);
+    NVRTC_CALL(nvrtcGetSupportedArchs(archs.data()));
+    if (!archs.empty() && arch.cc > archs.back()) {
+      // the PTX of the highest architecture NVRTC supports is compiled by the driver for the newer devices
+      arch.cc    = archs.back();
+      arch.cubin = false;
+    }
+    arch.cubin = arch.cubin && std::count(archs.begin(), archs.end(), arch.cc);
+#endif
+    VLOG(3) << "The CUDA code is compiled for the devices of compute capability " << arch.cc
+            << (arch.cubin ? " to CUBIN" : " to PTX");
+    return arch;
+  }();
+  return arch;
 }
 
-std::vector<std::string> NVRTC_Compiler::FindCUDAIncludePaths() {
+std::vector<std::string> SearchCUDAIncludePaths() {
   const std::string delimiter = "/";
   std::string cuda_include_path;
   const char* cuda_path_env = std::getenv("CUDA_PATH");
@@ -52,41 +110,73 @@ std::vector<std::string> NVRTC_Compiler::FindCUDAIncludePaths() {
   return {cuda_include_path};
 }
 
+}  // namespace
+
+std::string NVRTC_Compiler::operator()(const std::string& code, bool include_headers) {
+  return Compile(code, include_headers);
+}
+
+bool NVRTC_Compiler::compile_to_cubin() const { return FLAGS_cinn_nvrtc_cubin && GetDeviceArch().cubin; }
+
+std::vector<std::string> NVRTC_Compiler::FindCUDAIncludePaths() {
+  // The include paths are searched once, as they are needed by each compilation.
+  static const std::vector<std::string> include_paths = SearchCUDAIncludePaths();
+  return include_paths;
+}
+
 std::vector<std::string> NVRTC_Compiler::FindCINNRuntimeIncludePaths() {
   return {Context::Global().runtime_include_dir()};
 }
 
-std::string NVRTC_Compiler::CompilePTX(const std::string& code, bool include_headers) {
+std::vector<std::string> NVRTC_Compiler::GetCompileOptions(bool include_headers) {
   std::vector<std::string> compile_options;
-  std::vector<const char*> param_cstrings{};
-  nvrtcProgram prog;
-  std::string cc = "30";
-  int major, minor;
-  cudaError_t e1 = cudaDeviceGetAttribute(&major, cudaDevAttrComputeCapabilityMajor, 0);
-  cudaError_t e2 = cudaDeviceGetAttribute(&minor, cudaDevAttrComputeCapabilityMinor, 0);
-
-  if (e1 == cudaSuccess && e2 == cudaSuccess) {
-    cc = std::to_string(major) + std::to_string(minor);
-  } else {
-    LOG(WARNING) << "cannot detect compute capability from your device, "
-                 << "fall back to compute_30.";
+  std::string cc = std::to_string(GetDeviceArch().cc);
+  compile_options.push_back((compile_to_cubin() ? "-arch=sm_" : "-arch=compute_") + cc);
+  if (mode_ == common::PrecisionMode::kStrict) {
+    for (auto* option : {"--fmad=false", "--prec-div=true", "--prec-sqrt=true", "--ftz=false"}) {
+      compile_options.push_back(option);
+    }
+  } else if (mode_ == common::PrecisionMode::kReduced) {
+    compile_options.push_back("--use_fast_math");
   }
 
-  compile_options.push_back("-arch=compute_" + cc);
-
   if (include_headers) {  // prepare include headers
-    auto cuda_headers = FindCUDAIncludePaths();
-    auto cinn_headers = FindCINNRuntimeIncludePaths();
-    std::vector<std::string> include_paths;
-    for (auto& header : cuda_headers) {
-      include_paths.push_back("--include-path=" + header);
-    }
-    for (auto& header : cinn_headers) {
-      include_paths.push_back("--include-path=" + header);
-    }
-
+    auto include_paths = IncludePathOptions();
     compile_options.insert(std::end(compile_options), include_paths.begin(), include_paths.end());
   }
+  return compile_options;
+}
+
+std::vector<std::string> NVRTC_Compiler::IncludePathOptions() {
+  std::vector<std::string> include_paths;
+  for (auto& header : FindCUDAIncludePaths()) {
+    include_paths.push_back("--include-path=" + header);
+  }
+  for (auto& header : FindCINNRuntimeIncludePaths()) {
+    include_paths.push_back("--include-path=" + header);
+  }
+  return include_paths;
+}
+
+std::string NVRTC_Compiler::CompileWithOptions(const std::string& code, const std::vector<std::string>& options) {
+  CHECK(!options.empty()) << "The NVRTC options should have the architecture";
+  bool to_cubin      = options[0].rfind("-arch=sm_", 0) == 0;
+  auto all_options   = options;
+  auto include_paths = IncludePathOptions();
+  all_options.insert(all_options.end(), include_paths.begin(), include_paths.end());
+  return Compile(code, all_options, to_cubin);
+}
+
+std::string NVRTC_Compiler::Compile(const std::string& code, bool include_headers) {
+  return Compile(code, GetCompileOptions(include_headers), compile_to_cubin());
+}
+
+std::string NVRTC_Compiler::Compile(const std::string& code,
+                                    const std::vector<std::string>& compile_options,
+                                    bool to_cubin) {
+  utils::CompileStageTimer timer("NVRTC");
+  std::vector<const char*> param_cstrings{};
+  nvrtcProgram prog;
 
   for (const auto& option : compile_options) {
     param_cstrings.push_back(option.c_str());
@@ -104,15 +194,25 @@ std::string NVRTC_Compiler::CompilePTX(const std::string& code, bool include_hea
     CHECK_EQ(compile_res, NVRTC_SUCCESS) << log;
   }
 
+  std::string binary;
+#if CUDA_VERSION >= 11010
+  if (to_cubin) {
+    size_t cubin_size;
+    NVRTC_CALL(nvrtcGetCUBINSize(prog, &cubin_size));
+    binary.resize(cubin_size);
+    NVRTC_CALL(nvrtcGetCUBIN(prog, &binary[0]));
+    NVRTC_CALL(nvrtcDestroyProgram(&prog));
+    return binary;
+  }
+#endif
   size_t ptx_size;
   NVRTC_CALL(nvrtcGetPTXSize(prog, &ptx_size));
 
-  std::string ptx;
-  ptx.resize(ptx_size);
-  NVRTC_CALL(nvrtcGetPTX(prog, &ptx[0]));
+  binary.resize(ptx_size);
+  NVRTC_CALL(nvrtcGetPTX(prog, &binary[0]));
   NVRTC_CALL(nvrtcDestroyProgram(&prog));
 
-  return ptx;
+  return binary;
 }
 
 }  // namespace backends
@@ -17,27 +17,57 @@
 #if defined(__linux__)
 #include <sys/stat.h>
 #endif
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include <string>
 #include <vector>
 
+#include "cinn/common/precision.h"
+
+DECLARE_bool(cinn_nvrtc_cubin);
+
 namespace cinn {
 namespace backends {
 
 /**
- * An helper class to call NVRTC. Input CUDA device source code, get PTX string.
+ * An helper class to call NVRTC. Input CUDA device source code, get the PTX or CUBIN string.
+ *
+ * The code is compiled to the CUBIN of the devices' architecture when FLAGS_cinn_nvrtc_cubin is set, all the devices
+ * share the architecture and NVRTC supports it, so that the driver loads it on each device without compiling the PTX.
+ * Otherwise it is compiled to the PTX of the lowest architecture of the devices.
+ *
+ * The math options follow the precision mode: `--fmad=false` in the strict mode, `--use_fast_math` in the reduced
+ * one, and the NVRTC defaults in the fast one.
  */
 class NVRTC_Compiler {
  public:
+  explicit NVRTC_Compiler(common::PrecisionMode mode = common::DefaultPrecisionMode()) : mode_(mode) {}
+
   /**
-   * Compile the \p code and get PTX string.
+   * Compile the \p code and get PTX or CUBIN string.
    * @param code The CUDA source code.
    * @param include_headers Whether to include the headers of CUDA and CINN runtime modules.
-   * @return Compiled PTX code string.
+   * @return Compiled PTX or CUBIN code string, either can be loaded by CUDAModule.
    */
   std::string operator()(const std::string& code, bool include_headers = true);
 
+  //! Whether the code is compiled to CUBIN instead of PTX.
+  bool compile_to_cubin() const;
+
+  /**
+   * Get the options to compile the code with, including the architecture of the current device and the math options.
+   * @param include_headers Whether to include the headers of CUDA and CINN runtime modules.
+   * @return list of the compile options.
+   */
+  std::vector<std::string> GetCompileOptions(bool include_headers);
+
+  /**
+   * Compile the \p code with the \p options got by GetCompileOptions(false) elsewhere, e.g. by a client of the compile
+   * service, see RemoteCompiler, and the headers of this host. It compiles to CUBIN if the options are for it.
+   */
+  std::string CompileWithOptions(const std::string& code, const std::vector<std::string>& options);
+
  private:
   /**
    * Get the directories of CUDA's header files.
@@ -51,12 +81,20 @@ class NVRTC_Compiler {
    */
   std::vector<std::string> FindCINNRuntimeIncludePaths();
 
+  //! Get the options of the include paths of CUDA and CINN runtime.
+  std::vector<std::string> IncludePathOptions();
+
   /**
-   * Compile CUDA source code and get PTX.
+   * Compile CUDA source code and get PTX or CUBIN.
    * @param code source code string.
-   * @return PTX string.
+   * @return PTX or CUBIN string.
    */
-  std::string CompilePTX(const std::string& code, bool include_headers);
+  std::string Compile(const std::string& code, bool include_headers);
+
+  // Compile the code with all the options, to CUBIN if \p to_cubin.
+  std::string Compile(const std::string& code, const std::vector<std::string>& compile_options, bool to_cubin);
+
+  common::PrecisionMode mode_;
 };
 
 }  // namespace backends
@@ -14,15 +14,15 @@
 
 #include "cinn/backends/nvrtc_util.h"
 
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
+#include "cinn/runtime/cuda/cuda_module.h"
+
 namespace cinn {
 namespace backends {
 
-TEST(NVRTC_Compiler, basic) {
-  NVRTC_Compiler compiler;
-
-  std::string source_code = R"ROC(
+static const char* kSaxpySource = R"ROC(
 extern "C" __global__
 void saxpy(float a, float *x, float *y, float *out, size_t n)
 {
@@ -33,10 +33,27 @@ void saxpy(float a, float *x, float *y, float *out, size_t n)
 }
 )ROC";
 
-  auto ptx = compiler(source_code);
+TEST(NVRTC_Compiler, basic) {
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  NVRTC_Compiler compiler;
+
+  FLAGS_cinn_nvrtc_cubin = false;
+  auto ptx               = compiler(kSaxpySource);
 
   LOG(INFO) << "ptx:\n" << ptx;
 }
 
+TEST(NVRTC_Compiler, cubin) {
+  using runtime::cuda::CUDAModule;
+  NVRTC_Compiler compiler;
+
+  auto binary = compiler(kSaxpySource);
+  auto kind   = CUDAModule::KindOf(binary);
+  EXPECT_EQ(kind == CUDAModule::Kind::CUBIN, compiler.compile_to_cubin());
+
+  CUDAModule module(binary, kind);
+  EXPECT_TRUE(module.GetFunction(0, "saxpy"));
+}
+
 }  // namespace backends
 }  // namespace cinn
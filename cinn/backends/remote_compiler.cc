@@ -0,0 +1,181 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/backends/remote_compiler.h"
+
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>  // NOLINT
+#include <utility>
+
+#include "cinn/backends/llvm/execution_engine.h"
+#include "cinn/backends/llvm/llvm_optimizer.h"
+#include "cinn/utils/compile_tracer.h"
+
+#ifdef CINN_WITH_CUDA
+#include "cinn/backends/nvrtc_util.h"
+#endif
+
+DEFINE_string(cinn_remote_compile_command,
+              "",
+              "The shell command compiling a serialized request on the remote compile service, which reads it from "
+              "the standard input and writes the compiled code to the standard output, empty to compile locally.");
+
+namespace cinn {
+namespace backends {
+
+namespace {
+constexpr const char* kRequestMagic = "cinn-remote-compile-v1\n";
+
+void WriteField(std::string* data, const std::string& field) {
+  *data += std::to_string(field.size()) + "\n";
+  *data += field;
+}
+
+std::string ReadField(const std::string& data, size_t* pos) {
+  size_t end = data.find('\n', *pos);
+  CHECK_NE(end, std::string::npos) << "Truncated remote compile request";
+  size_t size = std::stoull(data.substr(*pos, end - *pos));
+  CHECK_LE(end + 1 + size, data.size()) << "Truncated remote compile request";
+  *pos = end + 1 + size;
+  return data.substr(end + 1, size);
+}
+
+std::mutex& GlobalMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::shared_ptr<RemoteCompiler>& GlobalCompiler() {
+  static std::shared_ptr<RemoteCompiler> compiler;
+  return compiler;
+}
+}  // namespace
+
+std::string RemoteCompileRequest::Serialize() const {
+  std::string data = kRequestMagic;
+  WriteField(&data, kind);
+  WriteField(&data, source);
+  WriteField(&data, std::to_string(options.size()));
+  for (auto& option : options) WriteField(&data, option);
+  return data;
+}
+
+RemoteCompileRequest RemoteCompileRequest::Deserialize(const std::string& data) {
+  std::string magic = kRequestMagic;
+  CHECK_EQ(data.compare(0, magic.size(), magic), 0) << "Not a remote compile request of this version";
+  size_t pos = magic.size();
+  RemoteCompileRequest request;
+  request.kind   = ReadField(data, &pos);
+  request.source = ReadField(data, &pos);
+  int size       = std::stoi(ReadField(data, &pos));
+  for (int i = 0; i < size; i++) request.options.push_back(ReadField(data, &pos));
+  return request;
+}
+
+void RemoteCompiler::SetGlobal(std::shared_ptr<RemoteCompiler> compiler) {
+  std::lock_guard<std::mutex> lock(GlobalMutex());
+  GlobalCompiler() = std::move(compiler);
+}
+
+std::shared_ptr<RemoteCompiler> RemoteCompiler::Global() {
+  std::lock_guard<std::mutex> lock(GlobalMutex());
+  auto& compiler = GlobalCompiler();
+  if (!compiler && !FLAGS_cinn_remote_compile_command.empty()) {
+    compiler = std::make_shared<CommandRemoteCompiler>(FLAGS_cinn_remote_compile_command);
+  }
+  return compiler;
+}
+
+bool CommandRemoteCompiler::Compile(const RemoteCompileRequest& request, std::string* binary) {
+  // The request is fed by a file, as popen only opens one direction of the pipes.
+  char path[] = "/tmp/cinn_remote_compile_XXXXXX";
+  int fd      = mkstemp(path);
+  if (fd < 0) {
+    LOG(WARNING) << "Failed to create the file of the remote compile request";
+    return false;
+  }
+  close(fd);
+  {
+    std::ofstream ofs(path, std::ios::binary);
+    std::string data = request.Serialize();
+    ofs.write(data.data(), data.size());
+  }
+  std::string command = command_ + " < " + path;
+  FILE* pipe          = popen(command.c_str(), "r");
+  if (!pipe) {
+    LOG(WARNING) << "Failed to run the remote compile command: " << command_;
+    std::remove(path);
+    return false;
+  }
+  std::string output;
+  char buffer[1 << 16];
+  size_t size;
+  while ((size = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0) output.append(buffer, size);
+  int status = pclose(pipe);
+  std::remove(path);
+  if (status != 0 || output.empty()) {
+    LOG(WARNING) << "The remote compile command failed with the status " << status << ": " << command_;
+    return false;
+  }
+  *binary = std::move(output);
+  return true;
+}
+
+std::string ServeCompileRequest(const RemoteCompileRequest& request) {
+  if (request.kind == "llvm") {
+    CHECK_EQ(request.options.size(), 4UL) << "The LLVM request should have the triple, the CPU, the features and the "
+                                             "optimize options";
+    return ExecutionEngine::CompileIR(request.source,
+                                      request.options[0],
+                                      request.options[1],
+                                      request.options[2],
+                                      OptimizeOptions::FromString(request.options[3]));
+  }
+  if (request.kind == "ptx") {
+#ifdef CINN_WITH_CUDA
+    return NVRTC_Compiler().CompileWithOptions(request.source, request.options);
+#else
+    LOG(FATAL) << "The CUDA source can't be compiled without CUDA";
+#endif
+  }
+  LOG(FATAL) << "Unknown kind of the remote compile request: " << request.kind;
+  return "";
+}
+
+bool CompileRemotely(const std::string& kind,
+                     const std::string& source,
+                     const std::vector<std::string>& options,
+                     std::string* binary) {
+  auto compiler = RemoteCompiler::Global();
+  if (!compiler) return false;
+  RemoteCompileRequest request;
+  request.kind    = kind;
+  request.source  = source;
+  request.options = options;
+  utils::CompileStageTimer timer("RemoteCompile");
+  if (!compiler->Compile(request, binary)) {
+    LOG(WARNING) << "The remote compilation of the " << kind << " code failed, compile it locally";
+    return false;
+  }
+  VLOG(3) << "Compile the " << kind << " code of " << source.size() << " bytes remotely";
+  return true;
+}
+
+}  // namespace backends
+}  // namespace cinn
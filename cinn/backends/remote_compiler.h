@@ -0,0 +1,101 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <gflags/gflags.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+DECLARE_string(cinn_remote_compile_command);
+
+namespace cinn {
+namespace backends {
+
+/**
+ * A request to compile the code of a module on a compile service, which holds everything the compiled code depends on,
+ * so that the service keeps no state of its clients.
+ */
+struct RemoteCompileRequest {
+  //! The kind of the code, "llvm" for the LLVM IR of an X86 module compiled to an object file, or "ptx" for the CUDA
+  //! source compiled to the PTX or CUBIN by NVRTC, the same as the kinds of CompilationCache.
+  std::string kind;
+  //! The unoptimized LLVM IR of the module with the runtime, or the CUDA source.
+  std::string source;
+  //! The target triple, the CPU, the features and the OptimizeOptions of the client for "llvm", or the NVRTC options
+  //! without the include paths, i.e. the architecture and the math options, for "ptx".
+  std::vector<std::string> options;
+
+  //! Serialize the request to the bytes sent to the service.
+  std::string Serialize() const;
+  static RemoteCompileRequest Deserialize(const std::string& data);
+};
+
+/**
+ * A compile backend offloading the heavy part of the compilation, i.e. the LLVM optimization and the code generation
+ * of the X86 modules and the NVRTC compilation of the CUDA ones, to a shared compile service, so that the serving
+ * hosts do little compile work during the deploys. The lowering stays local, and the code lowered is sent as the
+ * LLVM IR or the CUDA source, the textual forms the compiled code is keyed by in CompilationCache, so the code
+ * returned is stored in the cache under the same key as if it were compiled locally. A failed request falls back to
+ * the local compilation.
+ *
+ * The service runs the same version of CINN, e.g. with the same CUDA runtime headers, and serves each request by
+ * ServeCompileRequest.
+ */
+class RemoteCompiler {
+ public:
+  virtual ~RemoteCompiler() = default;
+
+  //! Compile \p request on the service to \p binary, return false if it fails.
+  virtual bool Compile(const RemoteCompileRequest& request, std::string* binary) = 0;
+
+  //! Use \p compiler for the compilations of the process, null to compile locally.
+  static void SetGlobal(std::shared_ptr<RemoteCompiler> compiler);
+
+  //! The compiler set by SetGlobal, or else a CommandRemoteCompiler of FLAGS_cinn_remote_compile_command if it is set,
+  //! or null.
+  static std::shared_ptr<RemoteCompiler> Global();
+};
+
+/**
+ * A RemoteCompiler running a shell command for each request, which reads the serialized request from its standard
+ * input, and writes the compiled code to its standard output, e.g. a client of the RPC of the service. The request
+ * fails if the command exits with a non-zero status or writes nothing.
+ */
+class CommandRemoteCompiler : public RemoteCompiler {
+ public:
+  explicit CommandRemoteCompiler(std::string command) : command_(std::move(command)) {}
+
+  bool Compile(const RemoteCompileRequest& request, std::string* binary) override;
+
+ private:
+  std::string command_;
+};
+
+//! Compile \p request on the service, i.e. compile it locally as the client would, and return the compiled code.
+std::string ServeCompileRequest(const RemoteCompileRequest& request);
+
+/**
+ * Compile the code of \p kind on the global RemoteCompiler if there is one, return false if there is none or the
+ * request fails, for the caller to compile it locally.
+ */
+bool CompileRemotely(const std::string& kind,
+                     const std::string& source,
+                     const std::vector<std::string>& options,
+                     std::string* binary);
+
+}  // namespace backends
+}  // namespace cinn
@@ -0,0 +1,118 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/backends/remote_compiler.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "cinn/backends/compiler.h"
+#include "cinn/backends/llvm/llvm_optimizer.h"
+#include "cinn/cinn.h"
+#include "cinn/common/test_helper.h"
+
+namespace cinn {
+namespace backends {
+
+// Serve the requests in the process, as the compile service would.
+class LocalService : public RemoteCompiler {
+ public:
+  explicit LocalService(bool fail = false) : fail_(fail) {}
+
+  bool Compile(const RemoteCompileRequest& request, std::string* binary) override {
+    num_requests++;
+    if (fail_) return false;
+    *binary = ServeCompileRequest(RemoteCompileRequest::Deserialize(request.Serialize()));
+    return true;
+  }
+
+  std::atomic<int> num_requests{0};
+
+ private:
+  bool fail_;
+};
+
+void BuildAndRun() {
+  Expr M(64), N(32);
+  Placeholder<float> A("A", {M, N});
+  auto B = Compute(
+      {M, N}, [=](Expr i, Expr j) { return A(i, j) * 2.f + 1.f; }, "B");
+  auto stages = CreateStages({B});
+  auto fn     = Lower("fn", stages, {A, B});
+  ir::Module::Builder builder("remote_module", common::DefaultHostTarget());
+  builder.AddFunction(fn);
+
+  auto compiler = Compiler::Create(common::DefaultHostTarget());
+  compiler->Build(builder.Build());
+  auto* fnp = compiler->Lookup("fn");
+  ASSERT_TRUE(fnp);
+
+  auto* Ab  = common::BufferBuilder(Float(32), {64, 32}).set_random().Build();
+  auto* Bb  = common::BufferBuilder(Float(32), {64, 32}).set_zero().Build();
+  auto args = common::ArgsBuilder().Add(Ab).Add(Bb).Build();
+  fnp(args.data(), args.size());
+  auto* Ad = reinterpret_cast<float*>(Ab->memory);
+  auto* Bd = reinterpret_cast<float*>(Bb->memory);
+  for (int i = 0; i < Ab->num_elements(); i++) ASSERT_NEAR(Bd[i], Ad[i] * 2.f + 1.f, 1e-5);
+}
+
+TEST(RemoteCompiler, serialize) {
+  RemoteCompileRequest request;
+  request.kind    = "llvm";
+  request.source  = std::string("source\0with\nzeros", 17);
+  request.options = {"x86_64-unknown-linux-gnu", "", "+avx2,+fma"};
+  auto restored   = RemoteCompileRequest::Deserialize(request.Serialize());
+  EXPECT_EQ(restored.kind, request.kind);
+  EXPECT_EQ(restored.source, request.source);
+  EXPECT_EQ(restored.options, request.options);
+
+  // the features are separated by commas as well
+  OptimizeOptions options;
+  options.opt_level        = 1;
+  options.cpu              = "haswell";
+  options.features         = "+avx2,+fma";
+  options.interleave_count = 2;
+  EXPECT_EQ(OptimizeOptions::FromString(options.ToString()).ToString(), options.ToString());
+}
+
+TEST(RemoteCompiler, command) {
+  RemoteCompileRequest request;
+  request.kind   = "ptx";
+  request.source = "code";
+  // cat echoes the request as the compiled code
+  std::string binary;
+  ASSERT_TRUE(CommandRemoteCompiler("cat").Compile(request, &binary));
+  EXPECT_EQ(binary, request.Serialize());
+  EXPECT_FALSE(CommandRemoteCompiler("false").Compile(request, &binary));
+}
+
+TEST(RemoteCompiler, offload) {
+  auto service = std::make_shared<LocalService>();
+  RemoteCompiler::SetGlobal(service);
+  BuildAndRun();
+  EXPECT_GT(service->num_requests, 0);
+
+  // the failed requests are compiled locally
+  auto failed = std::make_shared<LocalService>(/*fail=*/true);
+  RemoteCompiler::SetGlobal(failed);
+  BuildAndRun();
+  EXPECT_GT(failed->num_requests, 0);
+  RemoteCompiler::SetGlobal(nullptr);
+}
+
+}  // namespace backends
+}  // namespace cinn
@@ -0,0 +1,80 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/common/arena.h"
+
+#include <glog/logging.h>
+
+#include <cstdlib>
+#include <new>
+
+namespace cinn {
+namespace common {
+
+struct alignas(16) Arena::Chunk {
+  //! The live objects in the chunk, plus one held by the arena allocating from it.
+  std::atomic<int64_t> live{1};
+};
+
+namespace {
+
+constexpr size_t kAlignment = 16;
+
+std::atomic<uint32_t> session_counter{0};
+
+}  // namespace
+
+Arena::Arena() {
+  do {
+    session_ = ++session_counter;
+  } while (session_ == 0);
+}
+
+Arena::~Arena() {
+  if (chunk_) Unref(chunk_);
+}
+
+void* Arena::Allocate(size_t size) {
+  if (size > kMaxObjectSize) return nullptr;
+  size = (size + kAlignment - 1) / kAlignment * kAlignment;
+
+  if (!chunk_ || offset_ + size > kChunkSize) {
+    if (chunk_) Unref(chunk_);
+    void* memory = nullptr;
+    CHECK_EQ(posix_memalign(&memory, kChunkSize, kChunkSize), 0) << "Failed to allocate a chunk of the arena";
+    chunk_  = new (memory) Chunk;
+    offset_ = sizeof(Chunk);
+  }
+
+  chunk_->live.fetch_add(1, std::memory_order_relaxed);
+  void* p = reinterpret_cast<char*>(chunk_) + offset_;
+  offset_ += size;
+  return p;
+}
+
+void Arena::Release(const void* p) {
+  // The chunks are aligned by their size, so the chunk of an object is found by masking its address.
+  auto address = reinterpret_cast<uintptr_t>(p) & ~static_cast<uintptr_t>(kChunkSize - 1);
+  Unref(reinterpret_cast<Chunk*>(address));
+}
+
+void Arena::Unref(Chunk* chunk) {
+  if (chunk->live.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    chunk->~Chunk();
+    std::free(chunk);
+  }
+}
+
+}  // namespace common
+}  // namespace cinn
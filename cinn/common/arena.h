@@ -0,0 +1,97 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace cinn {
+namespace common {
+
+/**
+ * The tag of the classes whose instances created by `make_shared` in an ArenaScope are allocated by its Arena.
+ */
+struct ArenaAllocatable {};
+
+/**
+ * A bump allocator for the huge amount of the short-lived objects created in a session, such as the IR nodes created
+ * during lowering.
+ *
+ * The memory is allocated by the chunks aligned by their size. Each chunk counts its live objects, and is freed at once
+ * when both the arena and all its objects are gone, so the objects escaping from the session are still valid.
+ *
+ * The reference counts of the objects allocated by an arena are not atomic while its session is active on the thread,
+ * so these objects should not be shared with the other threads before the session ends.
+ */
+class Arena {
+ public:
+  static constexpr size_t kChunkSize = 1 << 20;
+  //! The objects larger than this are left to the heap.
+  static constexpr size_t kMaxObjectSize = kChunkSize / 16;
+
+  Arena();
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  ~Arena();
+
+  //! Allocate \p size bytes aligned by 16 bytes, return nullptr if the size is too large for the arena.
+  void* Allocate(size_t size);
+
+  //! Release the memory of an object allocated by any arena.
+  static void Release(const void* p);
+
+  //! The unique id of the session, never 0.
+  uint32_t session() const { return session_; }
+
+  //! The arena of the session active on this thread, nullptr if none.
+  static Arena*& Current() {
+    static thread_local Arena* arena = nullptr;
+    return arena;
+  }
+
+  //! The id of the session active on this thread, 0 if none.
+  static uint32_t CurrentSession() {
+    auto* arena = Current();
+    return arena ? arena->session_ : 0;
+  }
+
+ private:
+  struct Chunk;
+
+  static void Unref(Chunk* chunk);
+
+  Chunk* chunk_{};
+  size_t offset_{};
+  uint32_t session_{};
+};
+
+/**
+ * A session in which the ArenaAllocatable objects are allocated by a new arena, the previous session is restored when
+ * the scope exits.
+ */
+class ArenaScope {
+ public:
+  ArenaScope() : prev_(Arena::Current()) { Arena::Current() = &arena_; }
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+  ~ArenaScope() { Arena::Current() = prev_; }
+
+ private:
+  Arena arena_;
+  Arena* prev_{};
+};
+
+}  // namespace common
+}  // namespace cinn
@@ -0,0 +1,75 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/common/arena.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "cinn/common/object.h"
+
+namespace cinn {
+namespace common {
+
+struct Node : public Object, public ArenaAllocatable {
+  explicit Node(int value) : value(value) {}
+  virtual ~Node() = default;
+  const char *type_info() const override { return "Node"; }
+
+  int value;
+  Shared<Node> next;
+};
+
+TEST(Arena, allocate) {
+  Arena arena;
+  EXPECT_NE(arena.session(), 0);
+  auto *a = arena.Allocate(3);
+  auto *b = arena.Allocate(sizeof(Node));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 16, 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 16, 0);
+  EXPECT_EQ(arena.Allocate(Arena::kMaxObjectSize + 1), nullptr);
+  Arena::Release(a);
+  Arena::Release(b);
+}
+
+TEST(Arena, scope) {
+  Shared<Node> escaped;
+  {
+    ArenaScope scope;
+    Shared<Node> head(make_shared<Node>(0));
+    for (int i = 1; i < 10000; i++) {
+      Shared<Node> node(make_shared<Node>(i));
+      node->next = head;
+      head       = node;
+    }
+    EXPECT_EQ(ref_count(head.get()).session(), Arena::CurrentSession());
+    EXPECT_EQ(ref_count(head.get()).val(), 1);
+    escaped = head->next;
+  }
+  EXPECT_EQ(Arena::CurrentSession(), 0);
+
+  // The nodes escaping from the session are still valid.
+  int count = 0;
+  for (auto *node = escaped.get(); node; node = node->next.get()) count++;
+  EXPECT_EQ(count, 9999);
+  EXPECT_EQ(escaped->value, 9998);
+  EXPECT_EQ(ref_count(escaped.get()).val(), 1);
+
+  // The objects out of the sessions are on the heap.
+  Shared<Node> heap(make_shared<Node>(0));
+  EXPECT_EQ(ref_count(heap.get()).session(), 0);
+}
+
+}  // namespace common
+}  // namespace cinn
@@ -16,24 +16,155 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <set>
+#include <sstream>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "cinn/common/arithmatic.h"
 #include "cinn/common/ir_util.h"
 #include "cinn/ir/collect_ir_nodes.h"
+#include "cinn/ir/ir_hash.h"
 #include "cinn/ir/ir_mutator.h"
 #include "cinn/ir/ir_operators.h"
 #include "cinn/ir/ir_printer.h"
 #include "cinn/ir/ir_visitor.h"
 #include "cinn/optim/ir_copy.h"
 #include "cinn/utils/string.h"
+#include "cinn/utils/timer.h"
+
+DEFINE_bool(cinn_cas_memo, true, "Whether to memoize the results of AutoSimplify by the expressions and the intervals");
 
 namespace cinn {
 namespace common {
 using namespace ir;  // NOLINT
 
-Expr AutoSimplify(Expr u, const absl::flat_hash_map<std::string, CasInterval>& var_intervals) {
+namespace {
+
+//! The memo is cleared once it grows larger than this.
+constexpr size_t kMaxCasMemoSize = 1 << 16;
+
+/**
+ * The key of the memo of AutoSimplify, the expression and the intervals of the vars it uses, including the vars used by
+ * these intervals, sorted by the names. The types are compared, for the CAS makes the constants in the types of the
+ * expressions.
+ */
+struct CasMemoKey {
+  Expr expr;
+  std::vector<std::pair<std::string, CasInterval>> intervals;
+
+  CasMemoKey(const Expr& u, const cas_intervals_t& var_intervals) : expr(optim::IRCopy(u)) {
+    std::set<std::string> names;
+    std::vector<Expr> pending({u});
+    while (!pending.empty()) {
+      Expr e = pending.back();
+      pending.pop_back();
+      ir::CollectIRNodes(e, [&](const Expr* x) {
+        auto* var = x->As<_Var_>();
+        if (!var || !names.insert(var->name).second) return false;
+        auto it = var_intervals.find(var->name);
+        if (it != var_intervals.end() && it->second.e_l.defined() && it->second.e_r.defined()) {
+          pending.push_back(it->second.e_l);
+          pending.push_back(it->second.e_r);
+        }
+        return false;
+      });
+    }
+    for (auto& name : names) {
+      auto it = var_intervals.find(name);
+      if (it != var_intervals.end()) intervals.emplace_back(name, it->second);
+    }
+  }
+};
+
+bool IsExprInterval(const CasInterval& interval) { return interval.e_l.defined() && interval.e_r.defined(); }
+
+struct CasMemoKeyHash {
+  size_t operator()(const CasMemoKey& key) const {
+    size_t hash = ir::StructuralHash(key.expr, true);
+    for (auto& item : key.intervals) {
+      hash = Combine(hash, std::hash<std::string>()(item.first));
+      if (IsExprInterval(item.second)) {
+        hash = Combine(hash, ir::StructuralHash(item.second.e_l, true));
+        hash = Combine(hash, ir::StructuralHash(item.second.e_r, true));
+      } else {
+        hash = Combine(Combine(hash, item.second.l), item.second.r);
+      }
+    }
+    return hash;
+  }
+
+  static size_t Combine(size_t seed, size_t value) { return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2)); }
+};
+
+struct CasMemoKeyEqual {
+  bool operator()(const CasMemoKey& a, const CasMemoKey& b) const {
+    if (a.intervals.size() != b.intervals.size() || !ir::StructuralEqual(a.expr, b.expr, true)) return false;
+    for (size_t i = 0; i < a.intervals.size(); i++) {
+      auto& x = a.intervals[i];
+      auto& y = b.intervals[i];
+      if (x.first != y.first || IsExprInterval(x.second) != IsExprInterval(y.second)) return false;
+      if (IsExprInterval(x.second)) {
+        if (!ir::StructuralEqual(x.second.e_l, y.second.e_l, true) ||
+            !ir::StructuralEqual(x.second.e_r, y.second.e_r, true)) {
+          return false;
+        }
+      } else if (x.second.l != y.second.l || x.second.r != y.second.r) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+using cas_memo_t = std::unordered_map<CasMemoKey, Expr, CasMemoKeyHash, CasMemoKeyEqual>;
+
+cas_memo_t& GetCasMemo() {
+  static thread_local cas_memo_t memo;
+  return memo;
+}
+
+//! Fold the integer constants of the additions, subtractions and multiplications.
+bool FoldIntConstant(const Expr& u, int64_t* value) {
+  if (auto* imm = u.As<IntImm>()) {
+    *value = imm->value;
+    return true;
+  }
+  int64_t a, b;
+  if (u.As<Minus>()) {
+    if (!FoldIntConstant(u.As<Minus>()->v(), &a)) return false;
+    *value = -a;
+    return true;
+  }
+  if (!(u.As<Add>() || u.As<Sub>() || u.As<Mul>()) || !FoldIntConstant(u->operands[0], &a) ||
+      !FoldIntConstant(u->operands[1], &b)) {
+    return false;
+  }
+  *value = u.As<Add>() ? a + b : u.As<Sub>() ? a - b : a * b;
+  return true;
+}
+
+/**
+ * The fast paths of the expressions simplified trivially, the immediates and vars are kept by the CAS, and the integer
+ * constants are folded.
+ */
+bool SimplifyTrivially(const Expr& u, Expr* res) {
+  if (u.is_constant() || u.As<_Var_>()) {
+    *res = optim::IRCopy(u);
+    return true;
+  }
+  int64_t value;
+  if (u.type() == Int(32) && FoldIntConstant(u, &value) && value >= std::numeric_limits<int32_t>::min() &&
+      value <= std::numeric_limits<int32_t>::max()) {
+    *res = Expr(static_cast<int32_t>(value));
+    return true;
+  }
+  return false;
+}
+
+Expr AutoSimplifyImpl(Expr u, const absl::flat_hash_map<std::string, CasInterval>& var_intervals) {
   u = detail::ConvertCinnToCAS(u);
   absl::flat_hash_map<std::string, CasInterval> s_var_intervals;
   for (auto& item : var_intervals) {
@@ -50,6 +181,49 @@ Expr AutoSimplify(Expr u, const absl::flat_hash_map<std::string, CasInterval>& v
   return u;
 }
 
+}  // namespace
+
+CasStats& CasStats::Global() {
+  static thread_local CasStats stats;
+  return stats;
+}
+
+std::string CasStats::Summary() const {
+  std::stringstream ss;
+  ss << "AutoSimplify calls: " << calls << ", fast paths: " << fast_path_hits << ", memo hits: " << memo_hits
+     << ", time: " << total_ms << " ms";
+  return ss.str();
+}
+
+Expr AutoSimplify(Expr u, const absl::flat_hash_map<std::string, CasInterval>& var_intervals) {
+  utils::Timer timer;
+  timer.Start();
+  auto& stats = CasStats::Global();
+  stats.calls++;
+
+  Expr res;
+  if (SimplifyTrivially(u, &res)) {
+    stats.fast_path_hits++;
+  } else if (!FLAGS_cinn_cas_memo) {
+    res = AutoSimplifyImpl(u, var_intervals);
+  } else {
+    auto& memo = GetCasMemo();
+    CasMemoKey key(u, var_intervals);
+    auto it = memo.find(key);
+    if (it != memo.end()) {
+      stats.memo_hits++;
+      res = optim::IRCopy(it->second);
+    } else {
+      res = AutoSimplifyImpl(u, var_intervals);
+      if (memo.size() >= kMaxCasMemoSize) memo.clear();
+      memo.emplace(std::move(key), optim::IRCopy(res));
+    }
+  }
+
+  stats.total_ms += timer.Stop();
+  return res;
+}
+
 int gcd(int a, int b) {
   // Everything divides 0
   if (a == 0) return b;
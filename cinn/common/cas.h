@@ -14,6 +14,7 @@
 
 #pragma once
 #include <absl/container/flat_hash_map.h>
+#include <gflags/gflags.h>
 
 #include <functional>
 #include <string>
@@ -22,6 +23,8 @@
 #include "cinn/ir/ir.h"
 #include "cinn/ir/ir_printer.h"
 
+DECLARE_bool(cinn_cas_memo);
+
 namespace cinn {
 namespace common {
 
@@ -50,6 +53,22 @@ struct CasInterval {
 
 using cas_intervals_t = absl::flat_hash_map<std::string, CasInterval>;
 
+/**
+ * The statistics of AutoSimplify on this thread, to profile the time spent in the CAS.
+ */
+struct CasStats {
+  int64_t calls{};
+  int64_t fast_path_hits{};
+  int64_t memo_hits{};
+  double total_ms{};
+
+  static CasStats& Global();
+
+  void Reset() { *this = CasStats(); }
+
+  std::string Summary() const;
+};
+
 Expr AutoSimplify(Expr u, const absl::flat_hash_map<std::string, CasInterval>& var_intervals = {});
 
 //! Simplify a CAS expression.
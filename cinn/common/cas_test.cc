@@ -453,5 +453,32 @@ TEST(CAS, cond) {
   }
 }
 
+TEST(CAS, memo) {
+  Var x = ir::_Var_::Make("x", Int(32));
+  Var y = ir::_Var_::Make("y", Int(32));
+  CasStats::Global().Reset();
+
+  common::cas_intervals_t var_intervals;
+  var_intervals.emplace("y", common::CasInterval(0, 31));
+  auto u = AutoSimplify((Expr(x) * 32 + y) / 32, var_intervals);
+  EXPECT_EQ(GetStreamCnt(u), "x");
+  u = AutoSimplify((Expr(x) * 32 + y) / 32, var_intervals);
+  EXPECT_EQ(GetStreamCnt(u), "x");
+  EXPECT_EQ(CasStats::Global().memo_hits, 1);
+
+  // the intervals are parts of the key
+  u = AutoSimplify((Expr(x) * 32 + y) / 32);
+  EXPECT_NE(GetStreamCnt(u), "x");
+  EXPECT_EQ(CasStats::Global().memo_hits, 1);
+
+  // the fast paths
+  u = AutoSimplify(Expr(x));
+  u = AutoSimplify(Expr(3) * 4 - 2);
+  EXPECT_EQ(GetStreamCnt(u), "10");
+  EXPECT_EQ(CasStats::Global().fast_path_hits, 2);
+  EXPECT_EQ(CasStats::Global().calls, 5);
+  LOG(INFO) << CasStats::Global().Summary();
+}
+
 }  // namespace common
 }  // namespace cinn
@@ -36,6 +36,7 @@ using common::Shared;
 using common::UniqName;
 
 // Type related.
+using common::BFloat16;
 using common::Bool;
 using common::Float;
 using common::Int;
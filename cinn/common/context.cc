@@ -23,6 +23,7 @@
 namespace cinn {
 namespace common {
 
+thread_local NameGenerator* Context::thread_name_generator_ = nullptr;
 thread_local isl::ctx Context::ctx_ = isl_ctx_alloc();
 thread_local InfoRegistry Context::info_rgt_;
 thread_local DebugManager Context::debug_mgr_;
@@ -57,4 +58,11 @@ std::string NameGenerator::New(const std::string& name_hint) {
 }  // namespace common
 
 DEFINE_bool(cinn_runtime_display_debug_info, false, "Whether to display debug information in runtime");
+DEFINE_int32(cinn_runtime_debug_info_first_n,
+             0,
+             "Only display the stores of the first n elements of each tensor with the runtime debug information");
+DEFINE_int32(cinn_runtime_debug_info_every_k,
+             1,
+             "Only display the stores of one in every k elements of each tensor with the runtime debug information");
+DEFINE_bool(cinn_use_ir_arena, false, "Whether to allocate the IR nodes created during lowering by an arena");
 }  // namespace cinn
@@ -24,11 +24,15 @@
 
 #include "cinn/common/debug_manager.h"
 #include "cinn/common/info_registry.h"
+#include "cinn/common/macros.h"
 #include "cinn/common/target.h"
 
 namespace cinn {
 
 DECLARE_bool(cinn_runtime_display_debug_info);
+DECLARE_int32(cinn_runtime_debug_info_first_n);
+DECLARE_int32(cinn_runtime_debug_info_every_k);
+DECLARE_bool(cinn_use_ir_arena);
 
 namespace ir {
 class Expr;
@@ -38,6 +42,10 @@ namespace common {
 
 extern const char* kRuntimeIncludeDirEnvironKey;
 
+/**
+ * NameGenerator generates the unique names of a compilation. The names are unique among those generated by the same
+ * generator, which is shared by the threads of the compilation.
+ */
 struct NameGenerator {
   std::string New(const std::string& name_hint);
 
@@ -57,12 +65,15 @@ class Context {
   static Context& Global();
 
   /**
-   * Generate a new unique name.
+   * Generate a new unique name by the name generator of the calling thread.
    * @param name_hint The prefix.
    */
-  std::string NewName(const std::string& name_hint) { return name_generator_.New(name_hint); }
+  std::string NewName(const std::string& name_hint) { return name_generator().New(name_hint); }
 
-  void ResetNameId() { name_generator_.ResetID(); }
+  void ResetNameId() { name_generator().ResetID(); }
+
+  //! The name generator installed on the calling thread by a NameScope, or the global one.
+  NameGenerator& name_generator() { return thread_name_generator_ ? *thread_name_generator_ : name_generator_; }
 
   const std::string& runtime_include_dir();
 
@@ -82,9 +93,40 @@ class Context {
   std::string runtime_include_dir_;
   mutable std::mutex mutex_;
 
+  static thread_local NameGenerator* thread_name_generator_;
   static thread_local isl::ctx ctx_;
   static thread_local InfoRegistry info_rgt_;
   static thread_local DebugManager debug_mgr_;
+
+  friend class NameScope;
+};
+
+/**
+ * NameScope installs a name generator on the calling thread while it is alive, so that the compilations on different
+ * threads generate their names independently instead of contending for the global generator, e.g. the models built
+ * concurrently in a server. The names of a generator are only unique among themselves, so a generator should cover
+ * all of a compilation, from building its program to lowering it, and the threads a compilation spreads its work
+ * over should install the generator of the compilation by a NameScope too.
+ *
+ *   common::NameGenerator names;
+ *   {
+ *     common::NameScope scope(&names);
+ *     // build and compile a model
+ *   }
+ *
+ * The scopes nest, and the generator of the enclosing scope is restored when one is destructed.
+ */
+class NameScope {
+ public:
+  explicit NameScope(NameGenerator* generator) : prev_(Context::thread_name_generator_) {
+    Context::thread_name_generator_ = generator;
+  }
+  ~NameScope() { Context::thread_name_generator_ = prev_; }
+
+ private:
+  NameGenerator* prev_;
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(NameScope);
 };
 
 static std::string UniqName(const std::string& prefix) { return Context::Global().NewName(prefix); }
@@ -0,0 +1,78 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/common/context.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cinn {
+namespace common {
+
+TEST(NameScope, nested) {
+  auto* global = &Context::Global().name_generator();
+  NameGenerator outer_names, inner_names;
+  {
+    NameScope outer(&outer_names);
+    EXPECT_EQ(&Context::Global().name_generator(), &outer_names);
+    EXPECT_EQ(UniqName("name_scope_var"), "name_scope_var");
+    {
+      NameScope inner(&inner_names);
+      EXPECT_EQ(UniqName("name_scope_var"), "name_scope_var");
+      EXPECT_EQ(UniqName("name_scope_var"), "name_scope_var_0");
+    }
+    EXPECT_EQ(&Context::Global().name_generator(), &outer_names);
+    EXPECT_EQ(UniqName("name_scope_var"), "name_scope_var_0");
+  }
+  EXPECT_EQ(&Context::Global().name_generator(), global);
+}
+
+TEST(NameScope, threads) {
+  // the compilations on the threads generate the same names by their own generators
+  const int num_threads = 4;
+  const int num_names   = 1000;
+  std::vector<std::vector<std::string>> names(num_threads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      NameGenerator generator;
+      NameScope scope(&generator);
+      for (int j = 0; j < num_names; j++) names[i].push_back(UniqName("tmp"));
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int i = 1; i < num_threads; i++) EXPECT_EQ(names[i], names[0]);
+
+  // and the workers of a compilation share its generator
+  NameGenerator shared;
+  std::vector<std::set<std::string>> worker_names(num_threads);
+  threads.clear();
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      NameScope scope(&shared);
+      for (int j = 0; j < num_names; j++) worker_names[i].insert(UniqName("tmp"));
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  std::set<std::string> all_names;
+  for (auto& set : worker_names) all_names.insert(set.begin(), set.end());
+  EXPECT_EQ(all_names.size(), num_threads * num_names);
+}
+
+}  // namespace common
+}  // namespace cinn
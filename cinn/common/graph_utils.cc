@@ -70,14 +70,20 @@ std::vector<GraphNode *> Graph::nodes() {
 }
 
 std::tuple<std::vector<GraphNode *>, std::vector<GraphEdge *>> Graph::topological_order() const {
+  if (IsCached(topo_stamp_)) {
+    // the indices may be reassigned by the topological order of another graph sharing the nodes
+    auto &node_order = std::get<0>(topo_order_);
+    for (int i = 0; i < node_order.size(); i++) node_order[i]->set_index(i);
+    return topo_order_;
+  }
   std::vector<GraphNode *> node_order;
   std::vector<GraphEdge *> edge_order;
   std::deque<GraphNode *> queue;
 
   // collect indegreee.
-  std::map<std::string, int> indegree;
-  for (auto *n : nodes()) {
-    indegree[n->id()] = n->inlinks().size();
+  absl::flat_hash_map<const GraphNode *, int> indegree;
+  for (auto &n : nodes_) {
+    indegree[n.get()] = n->inlinks().size();
   }
 
   // insert start points first.
@@ -99,15 +105,44 @@ std::tuple<std::vector<GraphNode *>, std::vector<GraphEdge *>> Graph::topologica
       CHECK_EQ(edge->source(), top_node);
       edge_order.push_back(edge.get());
       auto *sink = edge->sink();
-      if ((--indegree[sink->id()]) == 0) {
+      if ((--indegree[sink]) == 0) {
         queue.push_back(sink);
       }
     }
   }
 
-  CHECK_EQ(node_order.size(), nodes().size()) << "circle detected in the schedule graph:\n\n" << Visualize();
+  CHECK_EQ(node_order.size(), nodes_.size()) << "circle detected in the schedule graph:\n\n" << Visualize();
+
+  topo_order_ = std::make_tuple(std::move(node_order), std::move(edge_order));
+  topo_stamp_ = {version_, GraphNode::link_version()};
+  return topo_order_;
+}
 
-  return std::make_tuple(node_order, edge_order);
+const CSRAdjacency &Graph::csr_adjacency() const {
+  if (IsCached(csr_stamp_)) return csr_;
+  csr_.nodes = std::get<0>(topological_order());
+  int num    = csr_.nodes.size();
+  for (auto *ids : {&csr_.in_offsets, &csr_.in_nodes, &csr_.out_offsets, &csr_.out_nodes}) ids->clear();
+  csr_.in_offsets.reserve(num + 1);
+  csr_.out_offsets.reserve(num + 1);
+  csr_.in_offsets.push_back(0);
+  csr_.out_offsets.push_back(0);
+  // the edges sorted by their indices, with the positions in the topological order of the other ends
+  std::vector<std::pair<int, int>> edges;
+  auto append = [&](std::vector<int> *offsets, std::vector<int> *ids) {
+    std::stable_sort(edges.begin(), edges.end(), [](auto &a, auto &b) { return a.first < b.first; });
+    for (auto &edge : edges) ids->push_back(edge.second);
+    offsets->push_back(ids->size());
+    edges.clear();
+  };
+  for (auto *node : csr_.nodes) {
+    for (auto &edge : node->inlinks()) edges.emplace_back(edge->index(), edge->source()->get_index());
+    append(&csr_.in_offsets, &csr_.in_nodes);
+    for (auto &edge : node->outlinks()) edges.emplace_back(edge->index(), edge->sink()->get_index());
+    append(&csr_.out_offsets, &csr_.out_nodes);
+  }
+  csr_stamp_ = topo_stamp_;
+  return csr_;
 }
 
 std::vector<GraphNode *> Graph::dfs_order() { return std::vector<GraphNode *>(); }
@@ -131,6 +166,7 @@ std::vector<GraphNode *> Graph::start_points() {
 GraphNode *Graph::RegisterNode(size_t key, GraphNode *node) {
   registry_.emplace(key, node);
   nodes_.emplace_back(node);
+  version_++;
   return node;
 }
 
@@ -174,6 +210,7 @@ void Graph::ClearUnlinkedNodes(absl::flat_hash_map<std::string, std::vector<int>
     if (node->inlinks().empty() && node->outlinks().empty()) {
       VLOG(2) << "delete unlinked node: " << node->id();
       nodes_.erase(it);
+      version_++;
       if (shape_dict->count(node->id())) {
         shape_dict->erase(node->id());
       }
@@ -189,6 +226,7 @@ void Graph::ClearUnlinkedNodes(absl::flat_hash_map<std::string, std::vector<int>
 }
 
 const char *GraphNode::__type_info__ = "GraphNode";
+std::atomic<uint64_t> GraphNode::link_version_{0};
 
 bool GraphEdgeCompare::operator()(const Shared<GraphEdge> &a, const Shared<GraphEdge> &b) const {
   if (a->source()->id() == b->source()->id()) {
@@ -19,6 +19,7 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <list>
 #include <map>
@@ -89,6 +90,7 @@ class GraphNode : public Object {
     auto edge1 = make_shared<GraphEdge>(this, other, other->index_inlinks);
     index_outlinks++;
     other->index_inlinks++;
+    link_version_++;
     outlinks_.insert(edge);
     other->inlinks_.insert(edge1);
 
@@ -116,6 +118,7 @@ class GraphNode : public Object {
       });
       if (it != outlinks_.end()) {
         outlinks_.erase(it);
+        link_version_++;
         other->UnLinkTo(this);
       }
     }
@@ -125,6 +128,7 @@ class GraphNode : public Object {
       });
       if (it != inlinks_.end()) {
         inlinks_.erase(it);
+        link_version_++;
         other->UnLinkTo(this);
       }
     }
@@ -149,6 +153,9 @@ class GraphNode : public Object {
 
   const char* type_info() const override { return __type_info__; }
 
+  //! The number of times the links of any node have changed, by which the graphs invalidate their cached analysis.
+  static uint64_t link_version() { return link_version_.load(std::memory_order_relaxed); }
+
   GraphNode() = default;
 
   static const char* __type_info__;
@@ -166,6 +173,28 @@ class GraphNode : public Object {
   int index_inlinks{0};
   int index_outlinks{0};
   int index{0};
+
+  static std::atomic<uint64_t> link_version_;
+};
+
+/**
+ * The adjacency of a graph in the compressed sparse row form for the analysis passes. The nodes are numbered by the
+ * topological order, which is also their get_index(), and the inputs and outputs of node i are
+ * in_nodes[in_offsets[i], in_offsets[i + 1]) and out_nodes[out_offsets[i], out_offsets[i + 1]), in the order of the
+ * edge indices, i.e. the order of the input and output tensors of an operator.
+ */
+struct CSRAdjacency {
+  std::vector<GraphNode*> nodes;
+  std::vector<int> in_offsets;
+  std::vector<int> in_nodes;
+  std::vector<int> out_offsets;
+  std::vector<int> out_nodes;
+
+  int num_nodes() const { return nodes.size(); }
+  int num_inputs(int i) const { return in_offsets[i + 1] - in_offsets[i]; }
+  int num_outputs(int i) const { return out_offsets[i + 1] - out_offsets[i]; }
+  const int* inputs(int i) const { return in_nodes.data() + in_offsets[i]; }
+  const int* outputs(int i) const { return out_nodes.data() + out_offsets[i]; }
 };
 
 /**
@@ -192,9 +221,14 @@ class Graph {
   std::vector<const GraphNode*> start_points() const;
   std::vector<GraphNode*> start_points();
 
-  //! Return the graph's nodes and edges(visited) in topological order.
+  //! Return the graph's nodes and edges(visited) in topological order. It is cached until the nodes of the graph or
+  //! the links of any node change.
   std::tuple<std::vector<GraphNode*>, std::vector<GraphEdge*>> topological_order() const;
 
+  //! The adjacency in the CSR form, cached as the topological order. It is valid until the graph changes and it is
+  //! called again.
+  const CSRAdjacency& csr_adjacency() const;
+
   //! Return the graph's DFS order.
   std::vector<GraphNode*> dfs_order();
 
@@ -211,6 +245,7 @@ class Graph {
     auto it = std::find_if(nodes_.begin(), nodes_.end(), [&](auto& x) { return x.get() == n; });
     if (it != nodes_.end()) {
       nodes_.erase(it);
+      version_++;
     }
   }
 
@@ -228,6 +263,23 @@ class Graph {
   std::map<size_t, GraphNode*> registry_;
   //! A list owns the graph nodes.
   std::vector<Shared<GraphNode>> nodes_;
+  //! The number of times nodes_ has changed, the derived graphs changing nodes_ directly should increase it.
+  uint64_t version_{0};
+
+ private:
+  // The versions of the graph and the links a cached analysis is computed at.
+  struct CacheStamp {
+    uint64_t version{~0ULL};
+    uint64_t link_version{~0ULL};
+  };
+  bool IsCached(const CacheStamp& stamp) const {
+    return stamp.version == version_ && stamp.link_version == GraphNode::link_version();
+  }
+
+  mutable CacheStamp topo_stamp_;
+  mutable std::tuple<std::vector<GraphNode*>, std::vector<GraphEdge*>> topo_order_;
+  mutable CacheStamp csr_stamp_;
+  mutable CSRAdjacency csr_;
 };
 
 }  // namespace common
@@ -88,5 +88,43 @@ TEST(Graph, simple) {
   }
 }
 
+TEST(Graph, cached_topological_order) {
+  auto graph  = CreateGraph0();
+  auto order0 = std::get<0>(graph->topological_order());
+  ASSERT_EQ(std::get<0>(graph->topological_order()), order0);
+  auto* D = graph->RetrieveNode("D");
+  auto* E = graph->RetrieveNode("E");
+  ASSERT_EQ(order0.back(), D);
+
+  // linking invalidates the cached order, D goes before E
+  D->LinkTo(E);
+  ASSERT_EQ(std::get<0>(graph->topological_order()).back(), E);
+
+  // and so does registering a node
+  graph->RegisterNode("F", make_shared<GraphNodeWithName>("F"));
+  ASSERT_EQ(std::get<0>(graph->topological_order()).size(), 6UL);
+}
+
+TEST(Graph, csr_adjacency) {
+  auto graph = CreateGraph0();
+  auto& csr  = graph->csr_adjacency();
+  ASSERT_EQ(csr.num_nodes(), 5);
+  auto pos = [&](const std::string& id) { return graph->RetrieveNode(id)->get_index(); };
+  for (int i = 0; i < csr.num_nodes(); i++) ASSERT_EQ(csr.nodes[i]->get_index(), i);
+
+  // the inputs of D in the order linked
+  int d = pos("D");
+  ASSERT_EQ(csr.num_inputs(d), 2);
+  ASSERT_EQ(csr.inputs(d)[0], pos("B"));
+  ASSERT_EQ(csr.inputs(d)[1], pos("C"));
+  ASSERT_EQ(csr.num_outputs(d), 0);
+  int c = pos("C");
+  ASSERT_EQ(csr.num_outputs(c), 2);
+  ASSERT_EQ(csr.outputs(c)[0], d);
+  ASSERT_EQ(csr.outputs(c)[1], pos("E"));
+  ASSERT_EQ(&graph->csr_adjacency(), &csr);
+  ASSERT_EQ(csr.in_nodes.size(), 5UL);
+}
+
 }  // namespace common
 }  // namespace cinn
@@ -390,5 +390,20 @@ Expr min(Expr a, Expr b) {
   return ir::Min::Make(a, b);
 }
 
+std::string BufferName(const Expr &tensor) {
+  auto *t = tensor.as_tensor();
+  CHECK(t);
+  return t->buffer.defined() ? t->buffer->name : t->name;
+}
+
+Expr GetOnlyStmt(Expr stmt) {
+  while (stmt.As<ir::Block>()) {
+    auto &stmts = stmt.As<ir::Block>()->stmts;
+    CHECK_EQ(stmts.size(), 1U) << "The block should hold a single statement:\n" << stmt;
+    stmt = stmts.front();
+  }
+  return stmt;
+}
+
 }  // namespace common
 }  // namespace cinn
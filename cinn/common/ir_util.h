@@ -98,6 +98,12 @@ Expr max(Expr a, Expr b);
 
 Expr min(Expr a, Expr b);
 
+//! Get the name of the buffer \p tensor is stored in, or the name of \p tensor if it is not bound to a buffer.
+std::string BufferName(const Expr &tensor);
+
+//! Get the only statement of the nested blocks \p stmt, or \p stmt itself if it is not a block.
+Expr GetOnlyStmt(Expr stmt);
+
 template <typename T>
 Expr make_const(Type t, T v) {
   if (t.is_vector()) {
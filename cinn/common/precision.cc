@@ -0,0 +1,70 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/common/precision.h"
+
+#include <glog/logging.h>
+
+DEFINE_string(cinn_precision_mode,
+              "fast",
+              "The precision mode of the programs compiled, one of strict, fast and reduced, see "
+              "common::PrecisionMode");
+
+namespace cinn {
+namespace common {
+
+namespace {
+thread_local bool thread_mode_set      = false;
+thread_local PrecisionMode thread_mode = PrecisionMode::kFast;
+}  // namespace
+
+PrecisionMode ParsePrecisionMode(const std::string& name) {
+  if (name == "strict") return PrecisionMode::kStrict;
+  if (name == "fast") return PrecisionMode::kFast;
+  if (name == "reduced") return PrecisionMode::kReduced;
+  LOG(FATAL) << "Unknown precision mode " << name << ", which should be one of strict, fast and reduced";
+  return PrecisionMode::kFast;
+}
+
+const char* PrecisionModeName(PrecisionMode mode) {
+  switch (mode) {
+    case PrecisionMode::kStrict:
+      return "strict";
+    case PrecisionMode::kFast:
+      return "fast";
+    case PrecisionMode::kReduced:
+      return "reduced";
+  }
+  LOG(FATAL) << "Unknown precision mode " << static_cast<int>(mode);
+  return "";
+}
+
+std::ostream& operator<<(std::ostream& os, PrecisionMode mode) { return os << PrecisionModeName(mode); }
+
+PrecisionMode DefaultPrecisionMode() { return ParsePrecisionMode(FLAGS_cinn_precision_mode); }
+
+PrecisionMode CurrentPrecisionMode() { return thread_mode_set ? thread_mode : DefaultPrecisionMode(); }
+
+PrecisionScope::PrecisionScope(PrecisionMode mode) : prev_set_(thread_mode_set), prev_(thread_mode) {
+  thread_mode_set = true;
+  thread_mode     = mode;
+}
+
+PrecisionScope::~PrecisionScope() {
+  thread_mode_set = prev_set_;
+  thread_mode     = prev_;
+}
+
+}  // namespace common
+}  // namespace cinn
@@ -0,0 +1,75 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <gflags/gflags.h>
+
+#include <ostream>
+#include <string>
+
+DECLARE_string(cinn_precision_mode);
+
+namespace cinn {
+namespace common {
+
+/**
+ * The trade-off between the accuracy of the floating point math and its speed, chosen per program and honored by
+ * every backend and runtime library call it compiles to.
+ *
+ * - kStrict: IEEE float math. No multiply-add is contracted to fma, the CPU vector math calls libm instead of the
+ *   polynomials (but erf), LLVM gets no fast-math flags, NVRTC compiles with `--fmad=false` and the precise
+ *   division and sqrt, cuDNN uses the FMA math and the deterministic algorithms only, and cuBLAS is pedantic.
+ * - kFast: contracts multiply-add to fma and lowers the CPU vector math to the polynomials within
+ *   `--cinn_cpu_vector_math_max_ulp`, with the LLVM `contract` and `afn` flags, but keeps full fp32 precision in the
+ *   library calls, i.e. no TF32.
+ * - kReduced: kFast plus the reassociation of float math, `--use_fast_math` of NVRTC, TF32 in the fp32 convs and
+ *   matmuls of cuDNN and cuBLAS, and the fp16 accumulation of the fp16 matmuls.
+ */
+enum class PrecisionMode : int {
+  kStrict  = 0,
+  kFast    = 1,
+  kReduced = 2,
+};
+
+//! Parse the name of a mode, which is one of "strict", "fast" and "reduced".
+PrecisionMode ParsePrecisionMode(const std::string& name);
+const char* PrecisionModeName(PrecisionMode mode);
+std::ostream& operator<<(std::ostream& os, PrecisionMode mode);
+
+//! The mode set by --cinn_precision_mode.
+PrecisionMode DefaultPrecisionMode();
+
+//! The mode of the compilation on the calling thread, installed by a PrecisionScope, or the default one.
+PrecisionMode CurrentPrecisionMode();
+
+/**
+ * PrecisionScope installs the mode of a compilation on the calling thread while it is alive, so that the passes that
+ * lower the math, e.g. LowerIntrin, follow the mode of the program they lower. The scopes nest like NameScope.
+ */
+class PrecisionScope {
+ public:
+  explicit PrecisionScope(PrecisionMode mode);
+  ~PrecisionScope();
+
+ private:
+  PrecisionScope(const PrecisionScope&) = delete;
+  PrecisionScope& operator=(const PrecisionScope&) = delete;
+
+  bool prev_set_;
+  PrecisionMode prev_;
+};
+
+}  // namespace common
+}  // namespace cinn
@@ -0,0 +1,60 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/common/precision.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "cinn/cinn.h"
+#include "cinn/optim/lower_intrin.h"
+#include "cinn/utils/string.h"
+
+namespace cinn::common {
+
+TEST(PrecisionMode, scope) {
+  for (auto mode : {PrecisionMode::kStrict, PrecisionMode::kFast, PrecisionMode::kReduced}) {
+    ASSERT_EQ(ParsePrecisionMode(PrecisionModeName(mode)), mode);
+  }
+  ASSERT_EQ(utils::GetStreamCnt(PrecisionMode::kReduced), "reduced");
+  ASSERT_EQ(CurrentPrecisionMode(), DefaultPrecisionMode());
+  {
+    PrecisionScope strict(PrecisionMode::kStrict);
+    ASSERT_EQ(CurrentPrecisionMode(), PrecisionMode::kStrict);
+    {
+      PrecisionScope reduced(PrecisionMode::kReduced);
+      ASSERT_EQ(CurrentPrecisionMode(), PrecisionMode::kReduced);
+    }
+    ASSERT_EQ(CurrentPrecisionMode(), PrecisionMode::kStrict);
+    // the scope only covers the calling thread
+    std::thread([] { ASSERT_EQ(CurrentPrecisionMode(), DefaultPrecisionMode()); }).join();
+  }
+  ASSERT_EQ(CurrentPrecisionMode(), DefaultPrecisionMode());
+}
+
+TEST(PrecisionMode, lower_intrin) {
+  Var a("a", Float(32)), b("b", Float(32)), c("c", Float(32));
+  auto lower = [&](PrecisionMode mode) {
+    PrecisionScope scope(mode);
+    Expr e = Expr(a) * Expr(b) + Expr(c);
+    optim::LowerIntrin(&e, DefaultHostTarget());
+    return utils::GetStreamCnt(e);
+  };
+  // the product is rounded before the sum in the strict mode
+  EXPECT_NE(lower(PrecisionMode::kFast).find("fma"), std::string::npos);
+  EXPECT_EQ(lower(PrecisionMode::kStrict).find("fma"), std::string::npos);
+}
+
+}  // namespace cinn::common
@@ -14,9 +14,12 @@
 
 #pragma once
 #include <atomic>
+#include <new>
 #include <string>
 #include <type_traits>
 
+#include "cinn/common/arena.h"
+
 namespace cinn {
 namespace common {
 
@@ -25,14 +28,27 @@ class RefCount {
   using value_type = int32_t;
   RefCount()       = default;
 
-  value_type Inc() { return ++count_; }
-  value_type Dec() { return --count_; }
+  value_type Inc() { return local() ? Store(count_.load(std::memory_order_relaxed) + 1) : ++count_; }
+  value_type Dec() { return local() ? Store(count_.load(std::memory_order_relaxed) - 1) : --count_; }
   bool is_zero() const { return 0 == count_; }
   std::string to_string() { return std::to_string(count_.load()); }
   int32_t val() const { return count_; }
 
+  //! The session of the arena allocating the object, 0 if the object is on the heap.
+  uint32_t session() const { return session_; }
+  void set_session(uint32_t session) { session_ = session; }
+
  private:
+  //! The objects are only shared by a thread while the session of their arena is active on it.
+  bool local() const { return session_ && session_ == Arena::CurrentSession(); }
+
+  value_type Store(value_type count) {
+    count_.store(count, std::memory_order_relaxed);
+    return count;
+  }
+
   std::atomic<value_type> count_{0};
+  uint32_t session_{0};
 };
 
 class Object;
@@ -46,6 +62,11 @@ RefCount& ref_count(const T* t) {
 }
 template <typename T>
 void Destroy(const T* t) {
+  if (ref_count(t).session()) {
+    t->~T();
+    Arena::Release(t);
+    return;
+  }
   delete t;
 }
 
@@ -119,10 +140,25 @@ Shared<T>& Shared<T>::operator=(const Shared<T>& other) {
 }
 
 template <typename T, typename... Args>
-T* make_shared(Args&&... args) {
+T* MakeShared(std::false_type /*arena_allocatable*/, Args&&... args) {
   return new T(args...);
 }
 
+template <typename T, typename... Args>
+T* MakeShared(std::true_type /*arena_allocatable*/, Args&&... args) {
+  auto* arena  = Arena::Current();
+  void* memory = arena ? arena->Allocate(sizeof(T)) : nullptr;
+  if (!memory) return new T(args...);
+  auto* t = new (memory) T(args...);
+  ref_count(t).set_session(arena->session());
+  return t;
+}
+
+template <typename T, typename... Args>
+T* make_shared(Args&&... args) {
+  return MakeShared<T>(std::is_base_of<ArenaAllocatable, T>(), args...);
+}
+
 template <typename T>
 Shared<T>& Shared<T>::operator=(T* x) {
   if (p_ == x) return *this;
@@ -51,6 +51,36 @@ int Target::max_num_threads() const {
 
 std::vector<Target::Lib> Target::get_target_libs() const { return libs; }
 
+int Target::get_vector_bits() const {
+  // the fixed-width NEON vectors, which the SVE cores run as well
+  if (arch == Arch::ARM) return 128;
+  return get_target_bits() * 8;
+}
+
+bool Target::supports(X86Feature feature) const {
+  return arch == Arch::X86 && (GetHostX86Features() & static_cast<int>(feature)) == static_cast<int>(feature);
+}
+
+int GetHostX86Features() {
+  static const int features = [] {
+    int x = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) x |= static_cast<int>(Target::X86Feature::SSE);
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+      x |= static_cast<int>(Target::X86Feature::AVX2);
+    }
+    if (__builtin_cpu_supports("avx512f")) x |= static_cast<int>(Target::X86Feature::AVX512);
+    if (__builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512vl")) {
+      x |= static_cast<int>(Target::X86Feature::VNNI);
+    }
+#endif
+    VLOG(3) << "The X86 features of the host: " << x;
+    return x;
+  }();
+  return features;
+}
+
 int Target::get_target_bits() const {
   switch (bits) {
     case Bit::k32:
@@ -66,6 +66,18 @@ struct Target {
   std::vector<Feature> features;
   std::vector<Lib> libs;
 
+  /**
+   * The instruction set extensions of the X86 CPUs, the X86 targets run on the host, so they support the extensions
+   * detected from the host CPU.
+   */
+  enum class X86Feature : int {
+    None   = 0,
+    SSE    = 1,       // SSE4.2
+    AVX2   = 1 << 1,  // AVX2 and FMA
+    AVX512 = 1 << 2,  // AVX512F
+    VNNI   = 1 << 3,  // AVX512_VNNI and AVX512VL, the int8 dot products
+  };
+
   explicit Target(OS o                                 = OS::Linux,
                   Arch a                               = Arch::Unk,
                   Bit b                                = Bit::Unk,
@@ -75,6 +87,9 @@ struct Target {
 
   bool defined() const { return os != OS::Unk && arch != Arch::Unk && bits != Bit::Unk; }
 
+  //! Whether the target is a CPU, which runs the code generated by the LLVM host backend.
+  bool is_cpu() const { return arch == Arch::X86 || arch == Arch::ARM; }
+
   //! Get the Runtime architecture, it is casted to integer to avoid header file depending.
   int runtime_arch() const;
 
@@ -82,6 +97,15 @@ struct Target {
 
   int get_target_bits() const;
 
+  /**
+   * Get the bits of the native vectors the loops are vectorized and tiled by, the 128 bits of NEON on ARM, and 8
+   * times the target bits on X86, as the AVX512 registers are assumed.
+   */
+  int get_vector_bits() const;
+
+  //! Whether the target supports the X86 instruction set extension \p feature, always false if it is not X86.
+  bool supports(X86Feature feature) const;
+
   std::vector<Lib> get_target_libs() const;
 
   std::string arch_str() const;
@@ -97,7 +121,16 @@ static const Target& UnkTarget() {
 }
 
 static const Target& DefaultHostTarget() {
+#if defined(__aarch64__)
+  static Target target(Target::OS::Linux, Target::Arch::ARM, Target::Bit::k64, {}, {});
+#else
   static Target target(Target::OS::Linux, Target::Arch::X86, Target::Bit::k64, {}, {});
+#endif
+  return target;
+}
+
+static const Target& DefaultARMTarget() {
+  static Target target(Target::OS::Linux, Target::Arch::ARM, Target::Bit::k64, {}, {});
   return target;
 }
 
@@ -108,5 +141,8 @@ static const Target& DefaultNVGPUTarget() {
 
 std::ostream& operator<<(std::ostream& os, Target::Arch arch);
 
+//! Get the X86Features the host CPU supports, detected by cpuid once, 0 if the host is not X86.
+int GetHostX86Features();
+
 }  // namespace common
 }  // namespace cinn
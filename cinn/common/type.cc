@@ -56,6 +56,9 @@ std::ostream &operator<<(std::ostream &os, const Type &t) {
     case Type::type_t::Float:
       os << "float" << t.bits();
       break;
+    case Type::type_t::BFloat:
+      os << "bfloat16";
+      break;
     case Type::type_t::Void:
       os << "void";
       break;
@@ -91,6 +94,9 @@ std::ostream &operator<<(std::ostream &os, Type::type_t t) {
     case Type::type_t::Float:
       os << "Float";
       break;
+    case Type::type_t::BFloat:
+      os << "BFloat";
+      break;
     case Type::type_t::Unk:
       os << "Unk";
       break;
@@ -238,6 +244,8 @@ bool Type::is_void() const { return type() == type_t::Void; }
 bool Type::is_vector() const { return lanes() > 1; }
 bool Type::is_scalar() const { return lanes() == 1; }
 bool Type::is_float(int bits) const { return type() == type_t::Float && (bits < 0 || bits == this->bits()); }
+bool Type::is_bfloat16() const { return type() == type_t::BFloat; }
+bool Type::is_floating_point() const { return is_float() || is_bfloat16(); }
 bool Type::is_uint(int bits) const { return type() == type_t::UInt && (bits < 0 || bits == this->bits()); }
 bool Type::is_int(int bits) const { return type() == type_t::Int && (bits < 0 || bits == this->bits()); }
 bool Type::is_integer(int bits) const {
@@ -280,6 +288,10 @@ const Type &F16() {
   static auto t = Float(16);
   return t;
 }
+const Type &BF16() {
+  static auto t = BFloat16();
+  return t;
+}
 const Type &F32() {
   static auto t = Float(32);
   return t;
@@ -329,5 +341,31 @@ const Type &UI1() {
   return t;
 }
 
+Type Str2Type(const std::string &type) {
+  if (type == "float16") return F16();
+  if (type == "bfloat16") return BF16();
+  if (type == "float32") return F32();
+  if (type == "float64") return F64();
+  if (type == "int8") return I8();
+  if (type == "int32") return I32();
+  if (type == "int64") return I64();
+  if (type == "bool") return Bool();
+  LOG(FATAL) << "Not supported type " << type;
+  return Type();
+}
+
+std::string Type2Str(const Type &type) {
+  if (type.is_float(16)) return "float16";
+  if (type.is_bfloat16()) return "bfloat16";
+  if (type.is_float(32)) return "float32";
+  if (type.is_float(64)) return "float64";
+  if (type.is_int(8)) return "int8";
+  if (type.is_int(32)) return "int32";
+  if (type.is_int(64)) return "int64";
+  if (type.is_bool()) return "bool";
+  LOG(FATAL) << "Not supported type " << type;
+  return "";
+}
+
 }  // namespace common
 }  // namespace cinn
@@ -37,6 +37,7 @@ struct Type {
     Int,
     UInt,
     Float,
+    BFloat,  // bfloat16, the upper 16 bits of a float32
     String,
     Void,
     // stupid idea to mix the Customized with other primitive types, large refactor needs here.
@@ -69,6 +70,9 @@ struct Type {
   CINN_NODISCARD bool is_vector() const;
   CINN_NODISCARD bool is_scalar() const;
   CINN_NODISCARD bool is_float(int bits = -1) const;
+  CINN_NODISCARD bool is_bfloat16() const;
+  //! Whether it is a float or a bfloat16.
+  CINN_NODISCARD bool is_floating_point() const;
   CINN_NODISCARD bool is_int(int bits = -1) const;
   CINN_NODISCARD bool is_integer(int bits = -1) const;
   CINN_NODISCARD bool is_uint(int bits = -1) const;
@@ -141,12 +145,14 @@ inline Type Void() { return Type(Type::type_t ::Void, 1, 0); }
 inline Type Int(int bits, int lanes = 1) { return Type(Type::type_t ::Int, bits, lanes); }
 inline Type UInt(int bits, int lanes = 1) { return Type(Type::type_t ::UInt, bits, lanes); }
 inline Type Float(int bits, int lanes = 1) { return Type(Type::type_t ::Float, bits, lanes); }
+inline Type BFloat16(int lanes = 1) { return Type(Type::type_t ::BFloat, 16, lanes); }
 inline Type Bool(int lanes = 1) { return Type(Type::type_t ::UInt, 1, lanes); }
 inline Type String() { return Type(Type::type_t::String, 1, 1); }
 
 //! Builtin native types as global singletons.
 // @{
 const Type& F16();
+const Type& BF16();
 const Type& F32();
 const Type& F64();
 const Type& I8();
@@ -161,6 +167,13 @@ const Type& I1();
 const Type& UI1();
 // @}
 
+//! Get the type by its name used in the op attributes, one of "float16", "bfloat16", "float32", "float64", "int8",
+//! "int32", "int64" and "bool".
+Type Str2Type(const std::string& type);
+
+//! Get the name of \p type used in the op attributes, the inverse of Str2Type.
+std::string Type2Str(const Type& type);
+
 template <typename T>
 Type type_of();
 
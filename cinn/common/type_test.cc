@@ -16,6 +16,8 @@
 
 #include <gtest/gtest.h>
 
+#include "cinn/utils/string.h"
+
 namespace cinn::common {
 
 TEST(Type, basic) {
@@ -28,4 +30,16 @@ TEST(Type, basic) {
   LOG(INFO) << type_of<float>();
 }
 
+TEST(Type, bfloat16) {
+  ASSERT_TRUE(BF16().is_bfloat16());
+  ASSERT_TRUE(BF16().is_floating_point());
+  ASSERT_FALSE(BF16().is_float());
+  ASSERT_FALSE(F16().is_bfloat16());
+  ASSERT_NE(BF16(), F16());
+  ASSERT_EQ(BF16().bits(), 16);
+  ASSERT_EQ(Str2Type("bfloat16"), BF16());
+  ASSERT_EQ(Str2Type("float16"), F16());
+  ASSERT_EQ(utils::GetStreamCnt(BFloat16(4)), "bfloat16<4>");
+}
+
 }  // namespace cinn::common
@@ -12,9 +12,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <gflags/gflags.h>
+
 #include "cinn/frontend/decomposer_registry.h"
 #include "cinn/frontend/syntax.h"
 
+DEFINE_bool(cinn_decompose_batch_norm_train,
+            false,
+            "Whether to decompose batch_norm_train into the reductions and the elementwise ops, instead of lowering it "
+            "to the single-pass statistics followed by the fused normalize, which reads the input twice instead of "
+            "three times.");
+
 namespace cinn {
 namespace frontend {
 namespace decomposer {
@@ -30,6 +38,13 @@ void batch_norm_train(const Instruction& instr, const DecomposerContext& context
   CHECK_EQ(instr->outputs.size(), 5UL) << "The number of the given outputs is not equal to the required for op "
                                        << instr->op_type;
 
+  CinnBuilder* builder = context.builder();
+  if (!FLAGS_cinn_decompose_batch_norm_train) {
+    // batch_norm_train is lowered by itself
+    builder->AppendInstruction(instr);
+    return;
+  }
+
   auto& x               = instr->inputs[0];
   auto& scale           = instr->inputs[1];
   auto& bias            = instr->inputs[2];
@@ -42,7 +57,6 @@ void batch_norm_train(const Instruction& instr, const DecomposerContext& context
 
   CHECK_EQ(x->shape.size(), 4UL) << "Only 4-D input tensor is supported, but get " << x->shape.size()
                                  << "-D input tensor.";
-  CinnBuilder* builder        = context.builder();
   std::vector<int> reduce_dim = {};
   float element_count         = 0;
   int channel_dim             = 0;
@@ -89,6 +103,9 @@ void batch_norm_train(const Instruction& instr, const DecomposerContext& context
   auto scaled_diff = builder->Mul(scale_4d, builder->Sub(x, mean_4d));
   auto y_nobias    = builder->Div(scaled_diff, std_variance_4d);
   auto y           = builder->Add(y_nobias, bias_4d);
+  if (instr->attrs.count("fuse_relu") && instr.GetAttrs<bool>("fuse_relu")) {
+    y = builder->Max(y, GetTensorFromScalar<float>(builder, 0.f, "zero", x->shape));
+  }
 
   auto factor_0 = GetTensorFromScalar<float>(builder, momentum, "factor_0", moving_mean->shape);
   auto factor_1 = GetTensorFromScalar<float>(builder, 1.0f - momentum, "factor_1", moving_mean->shape);
@@ -12,8 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <gflags/gflags.h>
+
 #include "cinn/frontend/decomposer/test_helper.h"
 
+DECLARE_bool(cinn_decompose_batch_norm_train);
+
 namespace cinn {
 namespace frontend {
 namespace {
@@ -142,7 +146,9 @@ void ComputeBatchNormTrainRef(const std::vector<T>& x,
   }
 }
 
-TEST(Decomposer, BatchNormTrain) {
+void RunBatchNormTrain(bool decompose) {
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  FLAGS_cinn_decompose_batch_norm_train = decompose;
   int n = 16, c = 32, h = 16, w = 16;
   float epsilon           = 1e-5;
   float momentum          = 0.9f;
@@ -167,6 +173,13 @@ TEST(Decomposer, BatchNormTrain) {
 
   auto target = GetTarget();
   RunDecomposer(&program, target);
+  // batch_norm_train is kept to be lowered by itself unless decomposed
+  if (decompose) {
+    ASSERT_GT(program.size(), 1UL);
+  } else {
+    ASSERT_EQ(program.size(), 1UL);
+    ASSERT_EQ(program[0]->op_type, "batch_norm_train");
+  }
 
   auto graph = std::make_shared<hlir::framework::Graph>(program, target);
   hlir::framework::ApplyPass(graph.get(), "OpFusion");
@@ -233,6 +246,10 @@ TEST(Decomposer, BatchNormTrain) {
   }
 }
 
+TEST(Decomposer, BatchNormTrain) { RunBatchNormTrain(true); }
+
+TEST(Decomposer, BatchNormTrainSinglePass) { RunBatchNormTrain(false); }
+
 template <typename T>
 void ComputeBatchNormGradRef(const std::vector<T>& y_grad,
                              const std::vector<T>& x,
@@ -14,11 +14,32 @@
 
 #include "cinn/frontend/interpreter.h"
 
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <utility>
+
 #include "cinn/frontend/syntax.h"
 #include "cinn/hlir/framework/graph.h"
 #include "cinn/hlir/framework/pass.h"
 #include "cinn/hlir/op/use_ops.h"
 #include "cinn/hlir/pass/use_pass.h"
+#include "cinn/utils/compile_tracer.h"
+#include "cinn/utils/thread_pool.h"
+
+#ifdef CINN_WITH_CUDA
+#include "cinn/runtime/cuda/cuda_util.h"
+#endif
+
+DEFINE_bool(cinn_use_fp16,
+            false,
+            "Whether to run conv2d, mul and matmul in float16 on NVGPU and keep the other ops in float32.");
 
 namespace cinn::frontend {
 
@@ -38,6 +59,48 @@ struct Interpreter::Impl {
  private:
   friend class Interpreter;
 
+  // The compiled program for a bucket of input shapes, with its own scope sharing the parameters.
+  struct Bucket {
+    std::shared_ptr<hlir::framework::Scope> scope;
+    std::unique_ptr<hlir::framework::GraphCompiler> graph_compiler;
+    std::unique_ptr<hlir::framework::Program> runtime_program;
+    // The variables the clones share with the program, i.e. the parameters and the prepacked weights.
+    std::vector<std::string> shared_vars;
+    // The clones not taken by any running thread.
+    std::vector<std::unique_ptr<hlir::framework::Program>> idle_clones;
+    std::mutex mutex;
+  };
+
+  std::vector<hlir::framework::shape_t> BucketShapes(const std::vector<hlir::framework::shape_t>& input_shapes) const;
+
+  // Get the bucket of the bucket shapes, build it if not cached.
+  Bucket* GetBucket(const std::vector<hlir::framework::shape_t>& bucket_shapes);
+
+  // Switch to the bucket of input shapes, build it if not cached.
+  std::vector<hlir::framework::shape_t> SwitchBucket(const std::vector<hlir::framework::shape_t>& input_shapes);
+
+  // Take an idle clone of the program of the bucket for a run, or create one.
+  std::unique_ptr<hlir::framework::Program> AcquireClone(Bucket* bucket);
+  // Give the clone back to the bucket after the run.
+  void ReleaseClone(Bucket* bucket, std::unique_ptr<hlir::framework::Program> program);
+
+  // The name of a variable in the scope for its name in the Paddle model.
+  std::string CinnName(const std::string& name) const {
+    auto it = var_map_paddle_to_cinn_.find(name);
+    return it == var_map_paddle_to_cinn_.end() ? name : it->second;
+  }
+
+  Target target_;
+  // The scope holding the parameters loaded from the model.
+  std::shared_ptr<hlir::framework::Scope> param_scope_;
+  Interpreter::ShapeBucketFn bucket_fn_;
+  std::map<std::vector<hlir::framework::shape_t>, Bucket> buckets_;
+  Bucket* current_{};
+  // Guards the building and the lookup of the buckets.
+  std::mutex mutex_;
+  // Serializes the micro-batched runs, which run on the programs of the buckets.
+  std::mutex micro_batch_mutex_;
+
   std::vector<std::string> input_names_;
   std::vector<hlir::framework::shape_t> input_shapes_;
 
@@ -51,9 +114,21 @@ struct Interpreter::Impl {
 
   std::unique_ptr<hlir::framework::Program> runtime_program_;
   std::unique_ptr<hlir::framework::Program> prerun_program_;
+
+  // The names of the programs of the model, so that the models are built concurrently without sharing a generator.
+  common::NameGenerator name_generator_;
+
+  int num_async_threads_{4};
+  // The workers of RunAsync, created on the first use. It is the last member so that the pending runs finish before
+  // the others are destroyed.
+  std::unique_ptr<utils::ThreadPool> async_pool_;
 };
 
 void Interpreter::LoadPaddleModel(const std::string& model_dir, const Target& target, bool params_combined) {
+  common::NameScope name_scope(&impl_->name_generator_);
+  utils::CompileStageTimer timer("Frontend");
+  // the parameters are not loaded into the scope of a restored program
+  if (impl_->current_) impl_->scope_ = std::make_shared<hlir::framework::Scope>();
   auto programTuple               = LoadPaddleProgram(model_dir, impl_->scope_.get(), params_combined, target);
   auto& program                   = std::get<0>(programTuple);
   auto& var_map                   = std::get<1>(programTuple);
@@ -61,11 +136,418 @@ void Interpreter::LoadPaddleModel(const std::string& model_dir, const Target& ta
   impl_->program_.reset(program.release());
   impl_->var_map_                = var_map;
   impl_->var_map_paddle_to_cinn_ = var_map_paddle_to_program;
+  impl_->target_                 = target;
+  impl_->param_scope_            = impl_->scope_;
+
+  impl_->SwitchBucket(impl_->input_shapes_);
+}
+
+void Interpreter::Run() {
+  CHECK(impl_->current_) << "The model should be loaded first";
+  impl_->current_->runtime_program->Execute();
+}
+
+void Interpreter::SetShapeBucketFn(ShapeBucketFn fn) { impl_->bucket_fn_ = std::move(fn); }
+
+std::vector<hlir::framework::shape_t> Interpreter::SetInputShapes(
+    const std::vector<hlir::framework::shape_t>& input_shapes) {
+  CHECK(impl_->param_scope_) << "The model should be loaded first";
+  return impl_->SwitchBucket(input_shapes);
+}
+
+hlir::framework::shape_t Interpreter::RoundBatchToPowerOfTwo(const std::string& input_name,
+                                                             const hlir::framework::shape_t& shape) {
+  auto res = shape;
+  if (res.empty() || res[0] <= 0) return res;
+  int batch = 1;
+  while (batch < res[0]) batch <<= 1;
+  res[0] = batch;
+  return res;
+}
+
+Interpreter::ShapeBucketFn Interpreter::RoundBatchToBuckets(std::vector<int> batch_sizes) {
+  std::sort(batch_sizes.begin(), batch_sizes.end());
+  return [batch_sizes](const std::string& input_name, const hlir::framework::shape_t& shape) {
+    auto res = shape;
+    if (res.empty() || res[0] <= 0) return res;
+    auto it = std::lower_bound(batch_sizes.begin(), batch_sizes.end(), res[0]);
+    if (it != batch_sizes.end()) res[0] = *it;
+    return res;
+  };
+}
+
+size_t Interpreter::num_compiled_programs() const { return impl_->buckets_.size(); }
+
+const std::vector<std::string>& Interpreter::input_names() const { return impl_->input_names_; }
+
+std::vector<hlir::framework::shape_t> Interpreter::Impl::BucketShapes(
+    const std::vector<hlir::framework::shape_t>& input_shapes) const {
+  CHECK_EQ(input_names_.size(), input_shapes.size());
+  std::vector<hlir::framework::shape_t> bucket_shapes;
+  for (int i = 0; i < input_shapes.size(); i++) {
+    bucket_shapes.push_back(bucket_fn_ ? bucket_fn_(input_names_[i], input_shapes[i]) : input_shapes[i]);
+  }
+  return bucket_shapes;
+}
+
+Interpreter::Impl::Bucket* Interpreter::Impl::GetBucket(const std::vector<hlir::framework::shape_t>& bucket_shapes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = buckets_.find(bucket_shapes);
+  if (it != buckets_.end()) return &it->second;
+
+  CHECK(program_) << "The bucket of the input shapes is not restored, load the Paddle model to compile it";
+  VLOG(3) << "Compile the program for a new bucket of input shapes, " << buckets_.size() << " cached";
+  // The intermediate variables differ in shape across buckets, so each bucket has its own scope, while the
+  // parameters are shared.
+  auto current_scope = scope_;
+  scope_             = std::make_shared<hlir::framework::Scope>();
+  std::vector<std::string> param_names;
+  for (auto& name : param_scope_->var_names()) {
+    std::string var_name({name.data(), name.size()});
+    *scope_->Var<hlir::framework::Tensor>(var_name) = param_scope_->GetTensor(var_name);
+    param_names.push_back(var_name);
+  }
+  {
+    common::NameScope name_scope(&name_generator_);
+    Build(input_names_, bucket_shapes, target_);
+  }
+  auto& bucket           = buckets_[bucket_shapes];
+  bucket.scope           = scope_;
+  bucket.graph_compiler  = std::move(graph_compiler_);
+  bucket.runtime_program = std::move(runtime_program_);
+  bucket.shared_vars     = std::move(param_names);
+  auto& prepacked        = bucket.runtime_program->prepacked_vars();
+  bucket.shared_vars.insert(bucket.shared_vars.end(), prepacked.begin(), prepacked.end());
+  // the scope of the current bucket is kept for the runs from another thread
+  scope_ = current_ ? current_scope : scope_;
+  return &bucket;
+}
+
+std::vector<hlir::framework::shape_t> Interpreter::Impl::SwitchBucket(
+    const std::vector<hlir::framework::shape_t>& input_shapes) {
+  auto bucket_shapes = BucketShapes(input_shapes);
+  current_           = GetBucket(bucket_shapes);
+  scope_             = current_->scope;
+  return bucket_shapes;
+}
+
+namespace {
+
+// Copy the row-major \p src in \p src_shape to the leading corner of \p dst in \p dst_shape, and fill the rest with
+// zeros.
+void CopyPadded(const uint8_t* src,
+                const hlir::framework::shape_t& src_shape,
+                uint8_t* dst,
+                const hlir::framework::shape_t& dst_shape,
+                size_t element_bytes) {
+  CHECK_EQ(src_shape.size(), dst_shape.size()) << "The input should be of the rank of its bucket";
+  size_t dst_numel = std::accumulate(dst_shape.begin(), dst_shape.end(), size_t(1), std::multiplies<size_t>());
+  if (src_shape == dst_shape || src_shape.empty()) {
+    std::memcpy(dst, src, dst_numel * element_bytes);
+    return;
+  }
+  for (int d = 0; d < src_shape.size(); d++) {
+    CHECK_LE(src_shape[d], dst_shape[d]) << "The input is larger than its bucket";
+  }
+  std::memset(dst, 0, dst_numel * element_bytes);
+  int rank         = src_shape.size();
+  size_t row_bytes = src_shape.back() * element_bytes;
+  size_t rows      = std::accumulate(src_shape.begin(), src_shape.end() - 1, size_t(1), std::multiplies<size_t>());
+  std::vector<int> index(rank - 1, 0);
+  for (size_t r = 0; r < rows; r++) {
+    size_t offset = 0;
+    for (int d = 0; d < rank - 1; d++) offset = offset * dst_shape[d] + index[d];
+    std::memcpy(dst + offset * dst_shape.back() * element_bytes, src + r * row_bytes, row_bytes);
+    for (int d = rank - 2; d >= 0 && ++index[d] == src_shape[d]; d--) index[d] = 0;
+  }
+}
+
+// The shapes of the inputs with the batch dimension replaced by \p micro_batch.
+std::vector<hlir::framework::shape_t> MicroBatchShapes(const std::vector<hlir::framework::shape_t>& input_shapes,
+                                                       int micro_batch) {
+  auto shapes = input_shapes;
+  for (auto& shape : shapes) shape[0] = micro_batch;
+  return shapes;
+}
+
+// The largest power of two no larger than \p n.
+int FloorPowerOfTwo(int n) {
+  int res = 1;
+  while (res <= n / 2) res *= 2;
+  return res;
+}
+
+void CopyTensorMemory(void* dst, const void* src, size_t size, const Target& target, bool to_device) {
+  if (target.arch == Target::Arch::NVGPU) {
+#ifdef CINN_WITH_CUDA
+    CUDA_CALL(cudaMemcpy(dst, src, size, to_device ? cudaMemcpyHostToDevice : cudaMemcpyDeviceToHost));
+#else
+    CINN_NOT_IMPLEMENTED
+#endif
+  } else {
+    std::memcpy(dst, src, size);
+  }
+}
+
+void CopyDeviceMemory(void* dst, const void* src, size_t size) {
+#ifdef CINN_WITH_CUDA
+  CUDA_CALL(cudaMemcpy(dst, src, size, cudaMemcpyDeviceToDevice));
+#else
+  CINN_NOT_IMPLEMENTED
+#endif
+}
+
+}  // namespace
+
+void Interpreter::Run(const std::vector<const void*>& inputs,
+                      const std::vector<hlir::framework::shape_t>& input_shapes,
+                      const std::map<std::string, void*>& outputs) {
+  CHECK(impl_->param_scope_) << "The model should be loaded first";
+  CHECK_EQ(inputs.size(), input_shapes.size());
+  auto bucket_shapes = impl_->BucketShapes(input_shapes);
+  auto* bucket       = impl_->GetBucket(bucket_shapes);
+  auto program       = impl_->AcquireClone(bucket);
+
+  auto& scope = program->GetScope();
+  for (int i = 0; i < inputs.size(); i++) {
+    auto tensor      = scope->GetTensor(impl_->CinnName(impl_->input_names_[i]));
+    auto* buffer     = tensor->buffer();
+    auto* src        = static_cast<const uint8_t*>(inputs[i]);
+    size_t elem_size = buffer->memory_size / std::max<size_t>(1, tensor->shape().numel());
+    std::vector<uint8_t> padded;
+    if (input_shapes[i] != bucket_shapes[i]) {
+      padded.resize(buffer->memory_size);
+      CopyPadded(src, input_shapes[i], padded.data(), bucket_shapes[i], elem_size);
+      src = padded.data();
+    }
+    CopyTensorMemory(buffer->memory, src, buffer->memory_size, impl_->target_, true);
+  }
+  program->Execute();
+  for (auto& output : outputs) {
+    auto* buffer = scope->GetTensor(impl_->CinnName(output.first))->buffer();
+    CopyTensorMemory(output.second, buffer->memory, buffer->memory_size, impl_->target_, false);
+  }
+  impl_->ReleaseClone(bucket, std::move(program));
+}
+
+void Interpreter::RunBound(const std::vector<cinn_buffer_t*>& inputs,
+                           const std::map<std::string, cinn_buffer_t*>& outputs) {
+  CHECK(impl_->param_scope_) << "The model should be loaded first";
+  CHECK(impl_->target_.arch == Target::Arch::X86) << "Only the host buffers of the X86 target can be bound";
+  CHECK_EQ(inputs.size(), impl_->input_names_.size());
+  std::vector<hlir::framework::shape_t> input_shapes;
+  for (auto* buffer : inputs) input_shapes.emplace_back(buffer->dims, buffer->dims + buffer->dimensions);
+  CHECK(impl_->BucketShapes(input_shapes) == input_shapes) << "The bound inputs should be in the shapes of a bucket";
+  auto* bucket = impl_->GetBucket(input_shapes);
+  auto program = impl_->AcquireClone(bucket);
+
+  auto& scope = program->GetScope();
+  std::vector<std::pair<std::string, cinn_buffer_t*>> bound;
+  for (int i = 0; i < inputs.size(); i++) bound.emplace_back(impl_->CinnName(impl_->input_names_[i]), inputs[i]);
+  for (auto& output : outputs) bound.emplace_back(impl_->CinnName(output.first), output.second);
+  for (auto& item : bound) {
+    auto tensor = scope->GetTensor(item.first);
+    CHECK_GE(item.second->memory_size, tensor->num_bytes())
+        << "The buffer bound to [" << item.first << "] is smaller than the variable";
+    program->BindInput(item.first, item.second);
+  }
+  program->Execute();
+  // the idle clones run on their own buffers
+  for (auto& item : bound) program->UnbindInput(item.first);
+  impl_->ReleaseClone(bucket, std::move(program));
+}
 
-  impl_->Build(impl_->input_names_, impl_->input_shapes_, target);
+int Interpreter::ChooseMicroBatch(const std::vector<hlir::framework::shape_t>& input_shapes, size_t memory_budget) {
+  CHECK(impl_->param_scope_) << "The model should be loaded first";
+  CHECK_EQ(input_shapes.size(), impl_->input_names_.size());
+  int batch = -1;
+  for (auto& shape : input_shapes) {
+    CHECK(!shape.empty() && shape[0] > 0) << "The inputs should be in batches";
+    CHECK(batch < 0 || shape[0] == batch) << "The inputs should be of the same batch size";
+    batch = shape[0];
+  }
+  auto bytes_of = [&](int micro_batch) {
+    auto* bucket = impl_->GetBucket(MicroBatchShapes(input_shapes, micro_batch));
+    return bucket->runtime_program->GetMemoryReport().total_bytes();
+  };
+  size_t single_bytes = bytes_of(1);
+  CHECK_LE(single_bytes, memory_budget) << "The program of a single sample takes " << single_bytes
+                                        << " bytes, over the budget of " << memory_budget;
+  if (batch == 1) return 1;
+  size_t double_bytes = bytes_of(2);
+  size_t sample_bytes = double_bytes - std::min(double_bytes, single_bytes);
+  int micro_batch     = batch;
+  if (sample_bytes > 0) {
+    micro_batch = std::min<size_t>(batch, 1 + (memory_budget - single_bytes) / sample_bytes);
+  }
+  if (micro_batch < batch) micro_batch = FloorPowerOfTwo(micro_batch);
+  // the estimate is checked by the program compiled, whose workspaces may not be linear in the batch
+  while (micro_batch > 1 && bytes_of(micro_batch) > memory_budget) micro_batch = FloorPowerOfTwo(micro_batch - 1);
+  VLOG(3) << "Run the batch of " << batch << " in the micro-batches of " << micro_batch << " within "
+          << memory_budget << " bytes";
+  return micro_batch;
 }
 
-void Interpreter::Run() { impl_->runtime_program_->Execute(); }
+void Interpreter::RunMicroBatched(const std::vector<cinn_buffer_t*>& inputs,
+                                  const std::map<std::string, cinn_buffer_t*>& outputs,
+                                  const MicroBatchOptions& options) {
+  CHECK_EQ(inputs.size(), impl_->input_names_.size());
+  std::vector<hlir::framework::shape_t> input_shapes;
+  for (auto* buffer : inputs) input_shapes.emplace_back(buffer->dims, buffer->dims + buffer->dimensions);
+  int batch       = input_shapes[0][0];
+  int micro_batch = options.micro_batch;
+  if (micro_batch <= 0) micro_batch = ChooseMicroBatch(input_shapes, options.memory_budget);
+  micro_batch  = std::min(micro_batch, batch);
+  auto* bucket = impl_->GetBucket(MicroBatchShapes(input_shapes, micro_batch));
+
+  std::lock_guard<std::mutex> lock(impl_->micro_batch_mutex_);
+  auto* program = bucket->runtime_program.get();
+  auto& scope   = program->GetScope();
+  // The view of the rows of a micro-batch in the buffer of the whole batch, which is moved along the rows.
+  struct View {
+    std::string name;
+    bool is_input;
+    uint8_t* memory;
+    size_t row_bytes;
+    std::unique_ptr<cinn_buffer_t> buffer;
+  };
+  std::vector<View> views;
+  auto add_view = [&](const std::string& name, cinn_buffer_t* buffer, bool is_input) {
+    auto tensor = scope->GetTensor(name);
+    auto& shape = tensor->shape().data();
+    CHECK(!shape.empty() && shape[0] == micro_batch && buffer->dimensions == shape.size() && buffer->dims[0] == batch)
+        << "The variable [" << name << "] should be in batches of the inputs";
+    for (int d = 1; d < shape.size(); d++) {
+      CHECK_EQ(buffer->dims[d], shape[d]) << "The buffer of [" << name << "] differs from the variable in shape";
+    }
+    size_t row_bytes = tensor->shape().numel() / micro_batch * tensor->element_bytes();
+    CHECK_GE(buffer->memory_size, row_bytes * batch) << "The buffer of [" << name << "] is smaller than the batch";
+    View view{name, is_input, buffer->memory, row_bytes, std::make_unique<cinn_buffer_t>(*buffer)};
+    view.buffer->dims[0]     = micro_batch;
+    view.buffer->memory_size = row_bytes * micro_batch;
+    views.push_back(std::move(view));
+  };
+  for (int i = 0; i < inputs.size(); i++) add_view(impl_->CinnName(impl_->input_names_[i]), inputs[i], true);
+  for (auto& output : outputs) add_view(impl_->CinnName(output.first), output.second, false);
+
+  // The CUDA kernels access the global buffers by the aligned vectors, so the rows not aligned to kSliceAlignment,
+  // e.g. those of a micro-batch of odd rows, are copied through the own memory of the variables instead.
+  bool is_nvgpu = impl_->target_.arch == Target::Arch::NVGPU;
+  auto aligned  = [](const uint8_t* memory) {
+    return reinterpret_cast<uintptr_t>(memory) % hlir::framework::GraphCompiler::kSliceAlignment == 0;
+  };
+  for (int start = 0; start < batch; start += micro_batch) {
+    // the last micro-batch ends at the last row, so the rows it shares with the previous one are computed again
+    int row = std::min(start, batch - micro_batch);
+    std::vector<View*> staged;
+    for (auto& view : views) {
+      view.buffer->memory = view.memory + row * view.row_bytes;
+      if (!is_nvgpu || aligned(view.buffer->memory)) {
+        program->BindInput(view.name, view.buffer.get());
+        continue;
+      }
+      program->UnbindInput(view.name);
+      staged.push_back(&view);
+      if (!view.is_input) continue;
+      auto tensor = scope->GetTensor(view.name);
+      CopyDeviceMemory(tensor->mutable_data(impl_->target_), view.buffer->memory, view.buffer->memory_size);
+    }
+    program->Execute();
+    for (auto* view : staged) {
+      if (view->is_input) continue;
+      CopyDeviceMemory(view->buffer->memory, scope->GetTensor(view->name)->buffer()->memory, view->buffer->memory_size);
+    }
+  }
+  for (auto& view : views) program->UnbindInput(view.name);
+}
+
+std::unique_ptr<hlir::framework::Program> Interpreter::Impl::AcquireClone(Bucket* bucket) {
+  {
+    std::lock_guard<std::mutex> lock(bucket->mutex);
+    if (!bucket->idle_clones.empty()) {
+      auto program = std::move(bucket->idle_clones.back());
+      bucket->idle_clones.pop_back();
+      return program;
+    }
+  }
+  return bucket->runtime_program->Clone(bucket->shared_vars);
+}
+
+void Interpreter::Impl::ReleaseClone(Bucket* bucket, std::unique_ptr<hlir::framework::Program> program) {
+  std::lock_guard<std::mutex> lock(bucket->mutex);
+  bucket->idle_clones.push_back(std::move(program));
+}
+
+std::shared_future<void> Interpreter::RunAsync(std::vector<const void*> inputs,
+                                               std::vector<hlir::framework::shape_t> input_shapes,
+                                               std::map<std::string, void*> outputs) {
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    if (!impl_->async_pool_) impl_->async_pool_.reset(new utils::ThreadPool(impl_->num_async_threads_));
+  }
+  auto task = std::make_shared<std::packaged_task<void()>>(
+      [this, inputs = std::move(inputs), input_shapes = std::move(input_shapes), outputs = std::move(outputs)] {
+        Run(inputs, input_shapes, outputs);
+      });
+  std::shared_future<void> future = task->get_future().share();
+  impl_->async_pool_->Schedule([task] { (*task)(); });
+  return future;
+}
+
+void Interpreter::SetNumAsyncThreads(int num_threads) {
+  CHECK_GT(num_threads, 0);
+  std::lock_guard<std::mutex> lock(impl_->mutex_);
+  impl_->num_async_threads_ = num_threads;
+}
+
+void Interpreter::SaveCompiledProgram(const std::string& path) {
+  CHECK(impl_->current_) << "The model should be loaded first";
+  impl_->current_->runtime_program->Save(path, impl_->current_->shared_vars);
+  // The names of the variables the Paddle model refers to and the shared ones are kept aside the program.
+  std::ofstream os(path + ".vars");
+  CHECK(os.is_open()) << "Cannot open file: " << path << ".vars";
+  os << impl_->current_->shared_vars.size() << "\n";
+  for (auto& name : impl_->current_->shared_vars) os << name << "\n";
+  os << impl_->var_map_paddle_to_cinn_.size() << "\n";
+  for (auto& item : impl_->var_map_paddle_to_cinn_) os << item.first << " " << item.second << "\n";
+}
+
+void Interpreter::LoadCompiledProgram(const std::string& path, const Target& target) {
+  auto program = hlir::framework::Program::Load(path, target);
+  std::ifstream is(path + ".vars");
+  CHECK(is.is_open()) << "Cannot open file: " << path << ".vars";
+  std::vector<std::string> shared_vars;
+  size_t size;
+  is >> size;
+  shared_vars.resize(size);
+  for (auto& name : shared_vars) is >> name;
+  is >> size;
+  for (size_t i = 0; i < size; i++) {
+    std::string paddle_name, cinn_name;
+    is >> paddle_name >> cinn_name;
+    impl_->var_map_paddle_to_cinn_[paddle_name] = cinn_name;
+  }
+  CHECK(static_cast<bool>(is)) << "The variables of the program " << path << " are truncated";
+
+  std::vector<hlir::framework::shape_t> input_shapes;
+  auto& scope = program->GetScope();
+  for (auto& name : impl_->input_names_) {
+    input_shapes.push_back(scope->GetTensor(impl_->CinnName(name))->shape().data());
+  }
+
+  std::lock_guard<std::mutex> lock(impl_->mutex_);
+  CHECK(!impl_->buckets_.count(input_shapes)) << "The bucket of the program " << path << " is used";
+  auto& bucket           = impl_->buckets_[input_shapes];
+  bucket.scope           = scope;
+  bucket.runtime_program = std::move(program);
+  bucket.shared_vars     = std::move(shared_vars);
+  impl_->target_         = target;
+  if (!impl_->param_scope_) impl_->param_scope_ = bucket.scope;
+  if (!impl_->current_) {
+    impl_->current_ = &bucket;
+    impl_->scope_   = bucket.scope;
+  }
+}
 
 hlir::framework::Tensor Interpreter::GetTensor(const std::string& name) {
   if (impl_->scope_->FindVar(name)) return impl_->scope_->GetTensor(name);
@@ -100,18 +582,35 @@ void Interpreter::Impl::Build(const std::vector<std::string>& input_names,
   auto graph = std::make_shared<hlir::framework::Graph>(*program_, target);
 
   hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "CommonSubexprElimination");
+  hlir::framework::ApplyPass(graph.get(), "WeightFolding");
 #ifndef CINN_WITH_CUDA
-  if (target.arch == Target::Arch::X86) {
+  if (target.is_cpu()) {
     hlir::framework::ApplyPass(graph.get(), "AlterLayout");
   }
 #endif
+#ifdef CINN_WITH_CUDNN
+  // the cudnn convs are altered to NHWC before ConstPropagate, so their weights are prepacked to OHWI
+  if (target.arch == Target::Arch::NVGPU) {
+    hlir::framework::ApplyPass(graph.get(), "AlterLayout");
+  }
+#endif
+  // after AlterLayout to cancel the layout conversions it inserts back to back
+  hlir::framework::ApplyPass(graph.get(), "TransformCancellation");
+  if (FLAGS_cinn_use_fp16 && target.arch == Target::Arch::NVGPU) {
+    hlir::framework::ApplyPass(graph.get(), "AutoMixedPrecision");
+  }
+  // cancel and hoist the casts inserted by AutoMixedPrecision before they are fused
+  hlir::framework::ApplyPass(graph.get(), "CastSimplification");
   hlir::framework::ApplyPass(graph.get(), "ConstPropagate");
   hlir::framework::ApplyPass(graph.get(), "OpFusion");
   // Target target = common::DefaultHostTarget();
   scope_ = hlir::framework::BuildScope(target, graph, scope_);
   graph_compiler_.reset(new hlir::framework::GraphCompiler(target, scope_, graph));
   runtime_program_ = graph_compiler_->Build();
-  runtime_program_->PreRun();
+  // The unpacked weights are only dropped from the scope of this bucket, the parameter scope keeps them for the
+  // other buckets.
+  runtime_program_->PrePack();
 }
 
 std::shared_ptr<hlir::framework::Scope> Interpreter::scope() {
@@ -16,6 +16,10 @@
 #include <absl/container/flat_hash_map.h>
 
 #include <algorithm>
+#include <functional>
+#include <future>
+#include <limits>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -32,6 +36,18 @@ namespace frontend {
  */
 class Interpreter final {
  public:
+  //! Map the shape of an input to the shape of the bucket to compile for.
+  using ShapeBucketFn =
+      std::function<hlir::framework::shape_t(const std::string& input_name, const hlir::framework::shape_t& shape)>;
+
+  //! The options of RunMicroBatched.
+  struct MicroBatchOptions {
+    //! The bytes the program of a micro-batch may hold, i.e. its parameters, intermediates and workspaces.
+    size_t memory_budget{std::numeric_limits<size_t>::max()};
+    //! The micro-batch size to run if positive, instead of the one chosen for the memory budget.
+    int micro_batch{};
+  };
+
   Interpreter(const std::vector<std::string>& input_names, const std::vector<hlir::framework::shape_t>& input_shapes);
 
   /**
@@ -46,6 +62,106 @@ class Interpreter final {
    */
   void Run();
 
+  /**
+   * Run the program of the bucket of \p input_shapes on the host buffers, compile it if its bucket is not cached. It
+   * can be called concurrently by many threads, each run takes a clone of the program sharing the parameters, which
+   * is created on demand and reused by the later runs.
+   * @param inputs The data of the inputs in the order of the input names, each in its shape of \p input_shapes, they
+   * are padded with zeros to the bucket shapes.
+   * @param outputs The buffers of the outputs by their names, each receives the whole output of the bucket.
+   */
+  void Run(const std::vector<const void*>& inputs,
+           const std::vector<hlir::framework::shape_t>& input_shapes,
+           const std::map<std::string, void*>& outputs);
+
+  /**
+   * Run the program of the bucket of the shapes of \p inputs with the buffers bound to its inputs and \p outputs, so
+   * the data are read and written in place without any copy. The buffers should be in the shapes of a bucket, i.e.
+   * the ones SetInputShapes returns, and on the host, so it only works for the X86 target. It can be called
+   * concurrently like Run, and the buffers are unbound when it returns.
+   * @param inputs The buffers of the inputs in the order of the input names.
+   * @param outputs The buffers of the outputs by their names, each in the shape of the output of the bucket.
+   */
+  void RunBound(const std::vector<cinn_buffer_t*>& inputs, const std::map<std::string, cinn_buffer_t*>& outputs);
+
+  /**
+   * Run a batch too large for the memory as a pipeline of micro-batches, by the program compiled for the micro-batch
+   * size, see ChooseMicroBatch. The first dimension of the inputs and the outputs is the batch, and the samples should
+   * be independent of each other. Each micro-batch binds the views of its rows of the buffers, so the inputs are read
+   * and the outputs are written in place without any gather or copy, and the last one is moved back to end at the last
+   * row, recomputing a few rows, if the batch is not a multiple of the micro-batch size. The buffers should be in the
+   * memory of the target, i.e. on the device for NVGPU, where the views not aligned to the vectorized accesses of the
+   * kernels are copied through the memory of the program instead. The micro-batched runs of a bucket are serialized, as
+   * they run on the program of the bucket instead of a clone, whose memory would be over the budget.
+   * @param inputs The buffers of the inputs in the order of the input names, of the same batch size.
+   * @param outputs The buffers of the outputs by their names, each holding the outputs of the whole batch.
+   */
+  void RunMicroBatched(const std::vector<cinn_buffer_t*>& inputs,
+                       const std::map<std::string, cinn_buffer_t*>& outputs,
+                       const MicroBatchOptions& options);
+
+  /**
+   * Choose the largest micro-batch size whose program fits in \p memory_budget bytes for the inputs of
+   * \p input_shapes. The memory is estimated linearly in the batch by the programs compiled for the batches of 1 and
+   * 2, the parameters being the constant part. The size is rounded down to a power of two to share the compiled
+   * programs across the batches, unless the whole batch fits, and checked by the program compiled for it, halving it
+   * until it fits. The whole batch is only compiled if it is estimated to fit, so the probes don't run out of memory.
+   */
+  int ChooseMicroBatch(const std::vector<hlir::framework::shape_t>& input_shapes, size_t memory_budget);
+
+  /**
+   * Schedule a Run on the host buffers to the worker threads of the interpreter and return at once, so that the caller
+   * overlaps its own work, e.g. preprocessing the next batch, with the execution. The buffers should be kept alive and
+   * untouched until the returned future is ready.
+   */
+  std::shared_future<void> RunAsync(std::vector<const void*> inputs,
+                                    std::vector<hlir::framework::shape_t> input_shapes,
+                                    std::map<std::string, void*> outputs);
+
+  //! Set the number of worker threads of RunAsync, 4 by default. It takes effect before the first RunAsync.
+  void SetNumAsyncThreads(int num_threads);
+
+  /**
+   * Save the program of the current bucket to \p path with the parameters, so that another Interpreter restores it
+   * by LoadCompiledProgram without converting and compiling the model again.
+   */
+  void SaveCompiledProgram(const std::string& path);
+
+  /**
+   * Restore a program saved by SaveCompiledProgram as the bucket of its input shapes, it can be called several times
+   * to restore several buckets, each of which holds its own parameters. The other buckets can only be compiled if the
+   * Paddle model is loaded too.
+   */
+  void LoadCompiledProgram(const std::string& path, const Target& target);
+
+  /**
+   * Set the policy to map the input shapes to the bucket shapes. The programs are compiled for each bucket on its
+   * first use and cached, and they share the parameters. By default, each distinct input shape is a bucket.
+   */
+  void SetShapeBucketFn(ShapeBucketFn fn);
+
+  /**
+   * Switch to the program for \p input_shapes, compile it if its bucket is not cached.
+   * @return The shapes of the bucket, the inputs should be fed in them with the extra part padded.
+   */
+  std::vector<hlir::framework::shape_t> SetInputShapes(const std::vector<hlir::framework::shape_t>& input_shapes);
+
+  //! A bucket policy rounding the first(batch) dimension up to a power of two.
+  static hlir::framework::shape_t RoundBatchToPowerOfTwo(const std::string& input_name,
+                                                         const hlir::framework::shape_t& shape);
+
+  /**
+   * A bucket policy rounding the first(batch) dimension up to the smallest of \p batch_sizes holding it, e.g. the ones
+   * chosen for the real traffic by ExecutionProfile::ChooseBatchBuckets. The larger batches are kept as they are.
+   */
+  static ShapeBucketFn RoundBatchToBuckets(std::vector<int> batch_sizes);
+
+  //! Get the number of programs compiled.
+  size_t num_compiled_programs() const;
+
+  //! The names of the inputs in the order the inputs are fed.
+  const std::vector<std::string>& input_names() const;
+
   hlir::framework::Tensor GetTensor(const std::string& name);
 
   std::shared_ptr<hlir::framework::Scope> scope();
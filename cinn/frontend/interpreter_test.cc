@@ -16,8 +16,18 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#include "cinn/common/test_helper.h"
 #include "cinn/runtime/use_extern_funcs.h"
 
+#ifdef CINN_WITH_CUDA
+#include "cinn/runtime/cuda/cuda_util.h"
+#endif
+
 DEFINE_string(model_dir, "", "");
 
 namespace cinn::frontend {
@@ -29,4 +39,136 @@ TEST(Interpreter, basic) {
   executor.GetTensor("fc_0.tmp_2");
 }
 
+TEST(Interpreter, shape_bucket) {
+  Interpreter executor({"A"}, {{1, 30}});
+  executor.SetShapeBucketFn(&Interpreter::RoundBatchToPowerOfTwo);
+  executor.LoadPaddleModel(FLAGS_model_dir, common::DefaultHostTarget());
+  ASSERT_EQ(executor.num_compiled_programs(), 1UL);
+
+  // batch 3 and 4 share the bucket of batch 4
+  auto shapes = executor.SetInputShapes({{3, 30}});
+  ASSERT_EQ(shapes, std::vector<hlir::framework::shape_t>({{4, 30}}));
+  executor.Run();
+  ASSERT_EQ(executor.GetTensor("fc_0.tmp_2")->shape().data()[0], 4);
+  executor.SetInputShapes({{4, 30}});
+  executor.Run();
+  ASSERT_EQ(executor.num_compiled_programs(), 2UL);
+
+  // switch back to the cached bucket of batch 1
+  executor.SetInputShapes({{1, 30}});
+  executor.Run();
+  ASSERT_EQ(executor.num_compiled_programs(), 2UL);
+  ASSERT_EQ(executor.GetTensor("fc_0.tmp_2")->shape().data()[0], 1);
+}
+
+TEST(Interpreter, compiled_program) {
+  auto target = common::DefaultHostTarget();
+  Interpreter executor({"A"}, {{1, 30}});
+  executor.LoadPaddleModel(FLAGS_model_dir, target);
+  std::vector<float> a(30);
+  for (int i = 0; i < a.size(); i++) a[i] = i * 0.1f;
+  std::vector<float> expected(executor.GetTensor("fc_0.tmp_2")->shape().numel());
+  executor.Run({a.data()}, {{1, 30}}, {{"fc_0.tmp_2", expected.data()}});
+
+  std::string path = "interpreter_test.cinnprog";
+  executor.SaveCompiledProgram(path);
+  Interpreter restored({"A"}, {{1, 30}});
+  restored.LoadCompiledProgram(path, target);
+  std::remove(path.c_str());
+  std::remove((path + ".vars").c_str());
+  ASSERT_EQ(restored.num_compiled_programs(), 1UL);
+
+  // the concurrent runs take their own clones of the restored program
+  std::vector<std::vector<float>> outs(4, std::vector<float>(expected.size()));
+  std::vector<std::thread> threads;
+  for (auto& out : outs) {
+    threads.emplace_back([&] { restored.Run({a.data()}, {{1, 30}}, {{"fc_0.tmp_2", out.data()}}); });
+  }
+  for (auto& thread : threads) thread.join();
+  for (auto& out : outs) ASSERT_EQ(out, expected);
+}
+
+TEST(Interpreter, run_async) {
+  Interpreter executor({"A"}, {{1, 30}});
+  executor.LoadPaddleModel(FLAGS_model_dir, common::DefaultHostTarget());
+  std::vector<float> a(30);
+  for (int i = 0; i < a.size(); i++) a[i] = i * 0.1f;
+  std::vector<float> expected(executor.GetTensor("fc_0.tmp_2")->shape().numel());
+  executor.Run({a.data()}, {{1, 30}}, {{"fc_0.tmp_2", expected.data()}});
+
+  executor.SetNumAsyncThreads(2);
+  std::vector<std::vector<float>> outs(4, std::vector<float>(expected.size()));
+  std::vector<std::shared_future<void>> futures;
+  for (auto& out : outs) {
+    futures.push_back(executor.RunAsync({a.data()}, {{1, 30}}, {{"fc_0.tmp_2", out.data()}}));
+  }
+  for (auto& future : futures) future.get();
+  for (auto& out : outs) ASSERT_EQ(out, expected);
+}
+
+TEST(Interpreter, micro_batched) {
+  Interpreter executor({"A"}, {{1, 30}});
+  executor.LoadPaddleModel(FLAGS_model_dir, common::DefaultHostTarget());
+  const int batch = 7;
+  std::vector<float> a(batch * 30);
+  for (int i = 0; i < a.size(); i++) a[i] = i * 0.01f;
+  int sample_numel = executor.GetTensor("fc_0.tmp_2")->shape().numel();
+  std::vector<float> expected(batch * sample_numel);
+  for (int i = 0; i < batch; i++) {
+    executor.Run({a.data() + i * 30}, {{1, 30}}, {{"fc_0.tmp_2", expected.data() + i * sample_numel}});
+  }
+  // the whole batch fits in an unlimited budget
+  ASSERT_EQ(executor.ChooseMicroBatch({{batch, 30}}, std::numeric_limits<size_t>::max()), batch);
+
+  auto* in  = common::BufferBuilder(Float(32), {batch, 30}).Build();
+  auto* out = common::BufferBuilder(Float(32), {batch, sample_numel}).set_zero().Build();
+  std::memcpy(in->memory, a.data(), a.size() * sizeof(float));
+  // 4 micro-batches, the last one recomputing a row of the third
+  Interpreter::MicroBatchOptions options;
+  options.micro_batch = 2;
+  executor.RunMicroBatched({in}, {{"fc_0.tmp_2", out}}, options);
+  auto* data = reinterpret_cast<float*>(out->memory);
+  for (int i = 0; i < expected.size(); i++) ASSERT_NEAR(data[i], expected[i], 1e-5);
+}
+
+#ifdef CINN_WITH_CUDA
+// the rows of 120 bytes start the micro-batches off the alignment of the vectorized kernels
+TEST(Interpreter, micro_batched_nvgpu) {
+  Interpreter executor({"A"}, {{1, 30}});
+  executor.LoadPaddleModel(FLAGS_model_dir, common::DefaultNVGPUTarget());
+  const int batch = 7;
+  std::vector<float> a(batch * 30);
+  for (int i = 0; i < a.size(); i++) a[i] = i * 0.01f;
+  int sample_numel = executor.GetTensor("fc_0.tmp_2")->shape().numel();
+  std::vector<float> expected(batch * sample_numel);
+  for (int i = 0; i < batch; i++) {
+    executor.Run({a.data() + i * 30}, {{1, 30}}, {{"fc_0.tmp_2", expected.data() + i * sample_numel}});
+  }
+
+  auto* in  = common::BufferBuilder(Float(32), {batch, 30}).Build();
+  auto* out = common::BufferBuilder(Float(32), {batch, sample_numel}).Build();
+  uint8_t *in_host = in->memory, *out_host = out->memory;
+  CUDA_CALL(cudaMalloc(&in->memory, in->memory_size));
+  CUDA_CALL(cudaMalloc(&out->memory, out->memory_size));
+  CUDA_CALL(cudaMemcpy(in->memory, a.data(), a.size() * sizeof(float), cudaMemcpyHostToDevice));
+  std::vector<float> data(expected.size());
+  for (int micro_batch : {1, 2}) {
+    CUDA_CALL(cudaMemset(out->memory, 0, out->memory_size));
+    Interpreter::MicroBatchOptions options;
+    options.micro_batch = micro_batch;
+    executor.RunMicroBatched({in}, {{"fc_0.tmp_2", out}}, options);
+    CUDA_CALL(cudaMemcpy(data.data(), out->memory, data.size() * sizeof(float), cudaMemcpyDeviceToHost));
+    for (int i = 0; i < expected.size(); i++) ASSERT_NEAR(data[i], expected[i], 1e-5);
+  }
+  // the variables are unbound, so the program runs on its own memory again
+  std::vector<float> single(sample_numel);
+  executor.Run({a.data()}, {{1, 30}}, {{"fc_0.tmp_2", single.data()}});
+  for (int i = 0; i < sample_numel; i++) ASSERT_NEAR(single[i], expected[i], 1e-5);
+  CUDA_CALL(cudaFree(in->memory));
+  CUDA_CALL(cudaFree(out->memory));
+  in->memory  = in_host;
+  out->memory = out_host;
+}
+#endif
+
 }  // namespace cinn::frontend
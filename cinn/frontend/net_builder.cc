@@ -129,6 +129,85 @@ Variable NetBuilder::reverse(const Variable& x, const std::vector<int>& axis) {
   return instr.GetOutput(0);
 }
 
+Variable NetBuilder::gather(const Variable& x, const Variable& index, int axis) {
+  Instruction instr("gather", {x, index});
+  instr.SetAttr("axis", axis);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::gather_nd(const Variable& x, const Variable& index) {
+  Instruction instr("gather_nd", {x, index});
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::scatter_add(const Variable& x, const Variable& index, const Variable& updates, int axis) {
+  Instruction instr("scatter_add", {x, index, updates});
+  instr.SetAttr("axis", axis);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::lookup_table(const Variable& table, const Variable& ids, int padding_idx) {
+  Instruction instr("lookup_table", {table, ids});
+  instr.SetAttr("padding_idx", padding_idx);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::resize(const Variable& x,
+                            const std::vector<int>& out_size,
+                            const std::string& method,
+                            const std::string& data_format) {
+  Instruction instr("resize", {x});
+  instr.SetAttr("out_size", out_size);
+  instr.SetAttr("method", method);
+  instr.SetAttr("data_format", data_format);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::crop(const Variable& x,
+                          const std::vector<int>& offsets,
+                          const std::vector<int>& crop_size,
+                          const std::string& data_format) {
+  Instruction instr("crop", {x});
+  instr.SetAttr("offsets", offsets);
+  instr.SetAttr("crop_size", crop_size);
+  instr.SetAttr("data_format", data_format);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::normalize(const Variable& x,
+                               const std::vector<float>& mean,
+                               const std::vector<float>& stddev,
+                               const std::string& data_format) {
+  Instruction instr("normalize", {x});
+  instr.SetAttr("mean", mean);
+  instr.SetAttr("std", stddev);
+  instr.SetAttr("data_format", data_format);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::image_to_tensor(const Variable& x, float scale, bool reverse_channels) {
+  Instruction instr("image_to_tensor", {x});
+  instr.SetAttr("scale", scale);
+  instr.SetAttr("reverse_channels", reverse_channels);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
 Variable NetBuilder::conv2d(const Variable& a,
                             const Variable& b,
                             const std::vector<int>& strides,
@@ -207,7 +286,8 @@ std::vector<Variable> NetBuilder::batchnorm(const Variable& a,
                                             float epsilon,
                                             float momentum,
                                             const std::string& data_layout,
-                                            bool is_test) {
+                                            bool is_test,
+                                            bool fuse_relu) {
   std::unique_ptr<Instruction> instr;
   if (is_test) {
     instr = std::make_unique<Instruction>("batchnorm");
@@ -218,6 +298,10 @@ std::vector<Variable> NetBuilder::batchnorm(const Variable& a,
   instr->SetAttr("epsilon", epsilon);
   instr->SetAttr("momentum", momentum);
   instr->SetAttr("data_layout", data_layout);
+  if (fuse_relu) {
+    CHECK(!is_test) << "Only the batch norm in the training fuses relu";
+    instr->SetAttr("fuse_relu", fuse_relu);
+  }
   InferShape(*instr);
   AppendInstruction(*instr);
   return instr->GetOutputs();
@@ -259,6 +343,14 @@ Variable NetBuilder::softmax(const Variable& a, int axis, const std::string& dat
   return instr.GetOutput(0);
 }
 
+Variable NetBuilder::log_softmax(const Variable& a, int axis) {
+  Instruction instr("log_softmax", {a});
+  instr.SetAttr("axis", axis);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
 Variable NetBuilder::sigmoid(const Variable& a) {
   Instruction instr("sigmoid", {a});
   InferShape(instr);
@@ -292,6 +384,30 @@ Variable NetBuilder::dropout_infer(const Variable& a, float dropout_prob, const
   return instr.GetOutput(0);
 }
 
+Variable NetBuilder::dropout(const Variable& a,
+                             const Variable& seed_offset,
+                             float dropout_prob,
+                             const std::string& dropout_implementation) {
+  Instruction instr("dropout", {a, seed_offset});
+  instr.SetAttr("dropout_prob", dropout_prob);
+  instr.SetAttr("dropout_implementation", dropout_implementation);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::dropout_grad(const Variable& dout,
+                                  const Variable& seed_offset,
+                                  float dropout_prob,
+                                  const std::string& dropout_implementation) {
+  Instruction instr("dropout_grad", {dout, seed_offset});
+  instr.SetAttr("dropout_prob", dropout_prob);
+  instr.SetAttr("dropout_implementation", dropout_implementation);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
 Variable NetBuilder::sum(const std::vector<Variable>& inputs) {
   Instruction instr("sum", inputs);
   InferShape(instr);
@@ -299,6 +415,87 @@ Variable NetBuilder::sum(const std::vector<Variable>& inputs) {
   return instr.GetOutput(0);
 }
 
+std::vector<Variable> NetBuilder::layer_norm(
+    const Variable& a, const Variable& scale, const Variable& bias, float epsilon, int begin_norm_axis) {
+  Instruction instr("layer_norm", {a, scale, bias});
+  instr.SetAttr("epsilon", epsilon);
+  instr.SetAttr("begin_norm_axis", begin_norm_axis);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutputs();
+}
+
+Variable NetBuilder::gelu(const Variable& a, bool approximate) {
+  Instruction instr("gelu", {a});
+  instr.SetAttr("approximate", approximate);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::bias_gelu(const Variable& a, const Variable& bias, bool approximate) {
+  Instruction instr("bias_gelu", {a, bias});
+  instr.SetAttr("approximate", approximate);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::fused_softmax_mask(const Variable& a, const Variable& mask, float scale) {
+  Instruction instr("fused_softmax_mask", {a, mask});
+  instr.SetAttr("scale", scale);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::multihead_attention(
+    const Variable& q, const Variable& k, const Variable& v, int num_heads, float scale) {
+  Instruction instr("multihead_attention", {q, k, v});
+  instr.SetAttr("num_heads", num_heads);
+  instr.SetAttr("scale", scale);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::multihead_attention(
+    const Variable& q, const Variable& k, const Variable& v, const Variable& mask, int num_heads, float scale) {
+  Instruction instr("multihead_attention", {q, k, v, mask});
+  instr.SetAttr("num_heads", num_heads);
+  instr.SetAttr("scale", scale);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::argmax(const Variable& a, int axis, bool keep_dim) {
+  Instruction instr("argmax", {a});
+  instr.SetAttr("axis", axis);
+  instr.SetAttr("keep_dim", keep_dim);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+Variable NetBuilder::argmin(const Variable& a, int axis, bool keep_dim) {
+  Instruction instr("argmin", {a});
+  instr.SetAttr("axis", axis);
+  instr.SetAttr("keep_dim", keep_dim);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+std::vector<Variable> NetBuilder::top_k(const Variable& a, int k, bool largest) {
+  Instruction instr("top_k", {a});
+  instr.SetAttr("k", k);
+  instr.SetAttr("largest", largest);
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutputs();
+}
+
 // conv2d grad, output(grad_x, grad_w)
 std::vector<Variable> NetBuilder::conv2d_grad(const Variable& dy,
                                               const Variable& x,
@@ -322,5 +519,83 @@ std::vector<Variable> NetBuilder::conv2d_grad(const Variable& dy,
   return instr.GetOutputs();
 }
 
+namespace {
+// The inputs of a multi-tensor optimizer, the lists of the same number of tensors followed by the master weights.
+std::vector<Variable> ConcatTensorLists(const std::vector<std::vector<Variable>>& lists,
+                                        const std::vector<Variable>& master_params) {
+  std::vector<Variable> inputs;
+  for (auto& list : lists) {
+    CHECK_EQ(list.size(), lists.front().size()) << "The lists of the multi-tensor optimizer should be of the same size";
+    inputs.insert(inputs.end(), list.begin(), list.end());
+  }
+  if (!master_params.empty()) {
+    CHECK_EQ(master_params.size(), lists.front().size()) << "Each param should have its master weight";
+    inputs.insert(inputs.end(), master_params.begin(), master_params.end());
+  }
+  return inputs;
+}
+}  // namespace
+
+std::vector<Variable> NetBuilder::AppendMultiTensorOptimizer(Instruction instr, int num_grads) {
+  for (int i = num_grads; i < instr->inputs.size(); i++) instr->outputs.push_back(Variable());
+  InferShape(instr);
+  AppendInstruction(instr);
+  return instr.GetOutputs();
+}
+
+std::vector<Variable> NetBuilder::multi_tensor_sgd(const std::vector<Variable>& params,
+                                                   const std::vector<Variable>& grads,
+                                                   float learning_rate,
+                                                   float weight_decay,
+                                                   const std::vector<Variable>& master_params) {
+  Instruction instr("multi_tensor_sgd", ConcatTensorLists({params, grads}, master_params));
+  instr.SetAttr("learning_rate", learning_rate);
+  instr.SetAttr("weight_decay", weight_decay);
+  instr.SetAttr("multi_precision", !master_params.empty());
+  return AppendMultiTensorOptimizer(instr, grads.size());
+}
+
+std::vector<Variable> NetBuilder::multi_tensor_momentum(const std::vector<Variable>& params,
+                                                        const std::vector<Variable>& grads,
+                                                        const std::vector<Variable>& velocities,
+                                                        float learning_rate,
+                                                        float momentum,
+                                                        bool use_nesterov,
+                                                        float weight_decay,
+                                                        const std::vector<Variable>& master_params) {
+  Instruction instr("multi_tensor_momentum", ConcatTensorLists({params, grads, velocities}, master_params));
+  instr.SetAttr("learning_rate", learning_rate);
+  instr.SetAttr("momentum", momentum);
+  instr.SetAttr("use_nesterov", use_nesterov);
+  instr.SetAttr("weight_decay", weight_decay);
+  instr.SetAttr("multi_precision", !master_params.empty());
+  return AppendMultiTensorOptimizer(instr, grads.size());
+}
+
+std::vector<Variable> NetBuilder::multi_tensor_adam(const std::vector<Variable>& params,
+                                                    const std::vector<Variable>& grads,
+                                                    const std::vector<Variable>& moment1,
+                                                    const std::vector<Variable>& moment2,
+                                                    const Variable& beta1_pow,
+                                                    const Variable& beta2_pow,
+                                                    float learning_rate,
+                                                    float beta1,
+                                                    float beta2,
+                                                    float epsilon,
+                                                    float weight_decay,
+                                                    const std::vector<Variable>& master_params) {
+  auto inputs = ConcatTensorLists({params, grads, moment1, moment2}, master_params);
+  inputs.push_back(beta1_pow);
+  inputs.push_back(beta2_pow);
+  Instruction instr("multi_tensor_adam", inputs);
+  instr.SetAttr("learning_rate", learning_rate);
+  instr.SetAttr("beta1", beta1);
+  instr.SetAttr("beta2", beta2);
+  instr.SetAttr("epsilon", epsilon);
+  instr.SetAttr("weight_decay", weight_decay);
+  instr.SetAttr("multi_precision", !master_params.empty());
+  return AppendMultiTensorOptimizer(instr, grads.size());
+}
+
 }  // namespace frontend
 }  // namespace cinn
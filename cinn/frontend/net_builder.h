@@ -96,6 +96,67 @@ class NetBuilder : public BaseBuilder {
    */
   Variable reverse(const Variable& x, const std::vector<int>& axis);
 
+  /**
+   * Gather the slices of x along the axis by the integer index.
+   * Example: x = [[0, 1], [2, 3], [4, 5]], index = [2, 0], axis = 0
+   *          output = [[4, 5], [0, 1]]
+   */
+  Variable gather(const Variable& x, const Variable& index, int axis = 0);
+
+  /**
+   * Gather the slices of x by the last axis of the integer index, which indexes the leading axes of x.
+   * Example: x = [[0, 1], [2, 3], [4, 5]], index = [[2, 1], [0, 0]]
+   *          output = [5, 0]
+   */
+  Variable gather_nd(const Variable& x, const Variable& index);
+
+  /**
+   * Add the slices of updates along the axis to the slices of x indexed by the 1-D index, the duplicated indices
+   * accumulate.
+   */
+  Variable scatter_add(const Variable& x, const Variable& index, const Variable& updates, int axis = 0);
+
+  /**
+   * Look up the rows of the embedding table in [vocab, dim] by the integer ids, the rows of padding_idx are zeros
+   * if it is not -1.
+   */
+  Variable lookup_table(const Variable& table, const Variable& ids, int padding_idx = -1);
+
+  /**
+   * Resize the 4-D images to out_size {h, w} by the method, bilinear in float32 like OpenCV's INTER_LINEAR or
+   * nearest in the type of x.
+   */
+  Variable resize(const Variable& x,
+                  const std::vector<int>& out_size,
+                  const std::string& method      = "bilinear",
+                  const std::string& data_format = "NCHW");
+
+  /**
+   * Crop the window of crop_size {h, w} from the pixel offsets {h, w} of the 4-D images.
+   */
+  Variable crop(const Variable& x,
+                const std::vector<int>& offsets,
+                const std::vector<int>& crop_size,
+                const std::string& data_format = "NCHW");
+
+  /**
+   * Normalize the channels of the 4-D images in float32 by (x - mean[c]) / stddev[c], a single mean or stddev is of
+   * all the channels.
+   */
+  Variable normalize(const Variable& x,
+                     const std::vector<float>& mean,
+                     const std::vector<float>& stddev,
+                     const std::string& data_format = "NCHW");
+
+  /**
+   * Convert the NHWC images, e.g. the uint8 decoded frames, to the NCHW float32 tensor times scale, with the channels
+   * reversed if reverse_channels, e.g. from BGR to RGB.
+   * Example: the frames preprocessed for a conv net on the device,
+   *          x = image_to_tensor(frames, 1 / 255.f, true)
+   *          x = normalize(resize(x, {224, 224}), {0.485, 0.456, 0.406}, {0.229, 0.224, 0.225})
+   */
+  Variable image_to_tensor(const Variable& x, float scale = 1.f, bool reverse_channels = false);
+
   /**
    * The convolution2D layer calculates the output based on the input, filter
    * and strides, paddings, dilations, groups parameters.
@@ -134,7 +195,8 @@ class NetBuilder : public BaseBuilder {
    * The batchnorm layer can be used as a normalizer function
    * for convolution or fully_connected operations.
    * is_test(true): batch norm infer (default), output{y}
-   * is_test(false): batch norm training, output{y, moving_mean, moving_variance, save_mean, save_variance}
+   * is_test(false): batch norm training, output{y, save_mean, save_variance, moving_mean, moving_variance}, and y is
+   * activated by relu if fuse_relu.
    */
   std::vector<Variable> batchnorm(const Variable& a,
                                   const Variable& scale,
@@ -144,7 +206,8 @@ class NetBuilder : public BaseBuilder {
                                   float epsilon                  = 1e-5f,
                                   float momentum                 = 0.9f,
                                   const std::string& data_layout = "NCHW",
-                                  bool is_test                   = false);
+                                  bool is_test                   = false,
+                                  bool fuse_relu                 = false);
 
   // batch norm grad, output(grad_x, grad_scale, grad_bias)
   std::vector<Variable> batch_norm_grad(const Variable& dy,
@@ -159,6 +222,8 @@ class NetBuilder : public BaseBuilder {
 
   Variable softmax(const Variable& a, int axis = -1, const std::string& data_format = "AnyLayout");
 
+  Variable log_softmax(const Variable& a, int axis = -1);
+
   Variable sigmoid(const Variable& a);
 
   Variable slice(const Variable& a,
@@ -172,8 +237,65 @@ class NetBuilder : public BaseBuilder {
                          float dropout_prob                        = 0.5f,
                          const std::string& dropout_implementation = "downgrade_in_infer");
 
+  /**
+   * Drop the units of a in the training by the mask generated in the kernel from \p seed_offset, the int32 seed and
+   * offset of the Philox RNG in [2], which the caller advances by the step. dropout_grad regenerates the same mask by
+   * the same seed_offset instead of storing it.
+   */
+  Variable dropout(const Variable& a,
+                   const Variable& seed_offset,
+                   float dropout_prob                        = 0.5f,
+                   const std::string& dropout_implementation = "downgrade_in_infer");
+
+  Variable dropout_grad(const Variable& dout,
+                        const Variable& seed_offset,
+                        float dropout_prob                        = 0.5f,
+                        const std::string& dropout_implementation = "downgrade_in_infer");
+
   Variable sum(const std::vector<Variable>& inputs);
 
+  /**
+   * The layer normalization over the axes from begin_norm_axis, whose scale and bias are in the normalized shape or
+   * flattened. Output {y, mean, variance}, where the mean and the variance are in the shape of the leading axes.
+   */
+  std::vector<Variable> layer_norm(const Variable& a,
+                                   const Variable& scale,
+                                   const Variable& bias,
+                                   float epsilon       = 1e-5f,
+                                   int begin_norm_axis = 1);
+
+  // The GELU activation by the erf, or by its tanh approximation if approximate.
+  Variable gelu(const Variable& a, bool approximate = false);
+
+  // The GELU activation of a + bias in a single kernel, where the bias is broadcast to the trailing axes of a.
+  Variable bias_gelu(const Variable& a, const Variable& bias, bool approximate = false);
+
+  // The softmax over the last axis of a * scale + mask in a single op, where the mask is broadcast to a.
+  Variable fused_softmax_mask(const Variable& a, const Variable& mask, float scale = 1.0f);
+
+  /**
+   * The scaled dot-product attention of num_heads heads, where q is in [batch, seq_q, hidden] and k, v are in
+   * [batch, seq_k, hidden]. The mask, if any, is added to the scores in [batch, num_heads, seq_q, seq_k]. The scale of
+   * 0 is 1 / sqrt(hidden / num_heads).
+   */
+  Variable multihead_attention(
+      const Variable& q, const Variable& k, const Variable& v, int num_heads, float scale = 0.0f);
+  Variable multihead_attention(const Variable& q,
+                               const Variable& k,
+                               const Variable& v,
+                               const Variable& mask,
+                               int num_heads,
+                               float scale = 0.0f);
+
+  // The int32 indices of the maximum along the axis, the first one of the ties.
+  Variable argmax(const Variable& a, int axis = -1, bool keep_dim = false);
+
+  // The int32 indices of the minimum along the axis, the first one of the ties.
+  Variable argmin(const Variable& a, int axis = -1, bool keep_dim = false);
+
+  // The k largest, or smallest, elements of the last axis in order. Output {values, int32 indices}.
+  std::vector<Variable> top_k(const Variable& a, int k, bool largest = true);
+
   // conv2d grad, output(grad_x, grad_w)
   std::vector<Variable> conv2d_grad(const Variable& dy,
                                     const Variable& x,
@@ -184,6 +306,52 @@ class NetBuilder : public BaseBuilder {
                                     const int groups                     = 1,
                                     const std::string& data_format       = "NCHW",
                                     const std::string& padding_algorithm = "EXPLICIT");
+
+  /**
+   * Update the params by their grads by sgd in a single op, param -= learning_rate * (grad + weight_decay * param).
+   * With the float32 master_params, the params and the grads are float16 and the masters are updated, then cast to the
+   * params. Output the updated params, followed by the updated master_params if any.
+   */
+  std::vector<Variable> multi_tensor_sgd(const std::vector<Variable>& params,
+                                         const std::vector<Variable>& grads,
+                                         float learning_rate,
+                                         float weight_decay                         = 0.f,
+                                         const std::vector<Variable>& master_params = {});
+
+  /**
+   * Update the params and their velocities by momentum in a single op, see multi_tensor_sgd for the master_params.
+   * Output the updated params and velocities, followed by the updated master_params if any.
+   */
+  std::vector<Variable> multi_tensor_momentum(const std::vector<Variable>& params,
+                                              const std::vector<Variable>& grads,
+                                              const std::vector<Variable>& velocities,
+                                              float learning_rate,
+                                              float momentum                             = 0.9f,
+                                              bool use_nesterov                          = false,
+                                              float weight_decay                         = 0.f,
+                                              const std::vector<Variable>& master_params = {});
+
+  /**
+   * Update the params and their moments by adam in a single op, the beta1_pow and beta2_pow are the powers of the
+   * betas of the current step in the shape [1]. See multi_tensor_sgd for the master_params. Output the updated params,
+   * moment1 and moment2, the updated master_params if any, and the beta1_pow and beta2_pow of the next step.
+   */
+  std::vector<Variable> multi_tensor_adam(const std::vector<Variable>& params,
+                                          const std::vector<Variable>& grads,
+                                          const std::vector<Variable>& moment1,
+                                          const std::vector<Variable>& moment2,
+                                          const Variable& beta1_pow,
+                                          const Variable& beta2_pow,
+                                          float learning_rate,
+                                          float beta1                                = 0.9f,
+                                          float beta2                                = 0.999f,
+                                          float epsilon                              = 1e-8f,
+                                          float weight_decay                         = 0.f,
+                                          const std::vector<Variable>& master_params = {});
+
+ private:
+  // Append the multi-tensor optimizer \p instr with an output for each input but the \p num_grads grads.
+  std::vector<Variable> AppendMultiTensorOptimizer(Instruction instr, int num_grads);
 };
 
 }  // namespace frontend
@@ -27,6 +27,7 @@
 #include "cinn/hlir/framework/graph_compiler.h"
 #include "cinn/hlir/framework/tensor.h"
 #include "cinn/hlir/op/use_ops.h"
+#include "cinn/runtime/cpu/host_intrinsics.h"
 #ifdef CINN_WITH_CUDA
 #include <cuda_runtime.h>
 #endif
@@ -189,5 +190,165 @@ TEST(net_build, program_execute_reverse) {
   runtime_program->Execute();
 }
 
+TEST(net_build, program_execute_image_preprocess) {
+  const int H = 4;
+  const int W = 6;
+  const int C = 3;
+
+  NetBuilder builder("net_builder");
+  Placeholder frames = builder.CreateInput(UInt(8), {1, H, W, C}, "Frames");
+  auto x             = builder.image_to_tensor(frames, 1.f / 255.f, true);
+  x                  = builder.resize(x, {H / 2, W / 2});
+  x                  = builder.crop(x, {0, 1}, {2, 2});
+  auto out           = builder.normalize(x, {0.5f}, {0.25f});
+  EXPECT_EQ(out->shape, std::vector<int>({1, C, 2, 2}));
+  auto program = builder.Build();
+
+  Target target = common::DefaultHostTarget();
+  auto graph    = std::make_shared<hlir::framework::Graph>(program, target);
+  auto scope    = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+
+  auto pixel   = [&](int h, int w, int c) { return (h * W + w) * C + c; };
+  auto* pixels = scope->GetTensor("Frames")->mutable_data<uint8_t>(target);
+  for (int i = 0; i < H * W * C; i++) pixels[i] = i;
+  runtime_program->Execute();
+
+  // the halved images sample the centers of the 2x2 blocks, and the channels are reversed
+  auto* res = scope->GetTensor(out->id)->data<float>();
+  for (int c = 0; c < C; c++) {
+    for (int y = 0; y < 2; y++) {
+      for (int x = 0; x < 2; x++) {
+        int h = 2 * y, w = 2 * (x + 1);
+        float mean = (pixel(h, w, C - 1 - c) + pixel(h, w + 1, C - 1 - c) + pixel(h + 1, w, C - 1 - c) +
+                      pixel(h + 1, w + 1, C - 1 - c)) /
+                     4.f / 255.f;
+        ASSERT_NEAR(res[(c * 2 + y) * 2 + x], (mean - 0.5f) / 0.25f, 1e-5);
+      }
+    }
+  }
+}
+
+TEST(net_build, program_execute_transformer_layer) {
+  constexpr int B = 2;  // batch size
+  constexpr int S = 16;
+  constexpr int H = 64;
+  constexpr int N = 4;  // number of heads
+
+  NetBuilder builder("net_builder");
+  auto x     = builder.CreateInput(Float(32), {B, S, H}, "X");
+  auto scale = builder.CreateInput(Float(32), {H}, "Scale");
+  auto bias  = builder.CreateInput(Float(32), {H}, "Bias");
+  auto mask  = builder.CreateInput(Float(32), {B, 1, 1, S}, "Mask");
+
+  auto norm_outs = builder.layer_norm(x, scale, bias, 1e-5f, 2);
+  ASSERT_EQ(norm_outs.size(), 3UL);
+  EXPECT_EQ(norm_outs[1]->shape, std::vector<int>({B, S}));
+  auto attention = builder.multihead_attention(norm_outs[0], norm_outs[0], norm_outs[0], mask, N);
+  auto gelu_out  = builder.bias_gelu(attention, bias, true);
+  auto program   = builder.Build();
+
+#ifdef CINN_WITH_CUDA
+  Target target = common::DefaultNVGPUTarget();
+#else
+  Target target = common::DefaultHostTarget();
+#endif
+
+  auto graph = std::make_shared<hlir::framework::Graph>(program, target);
+  auto scope = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+
+  for (auto& input : {x, scale, bias, mask}) {
+    scope->Var<hlir::framework::Tensor>(std::string(input.id()));
+    SetRandData(scope->GetTensor(std::string(input.id())), target);
+  }
+  runtime_program->Execute();
+}
+
+TEST(net_build, program_execute_multi_tensor_momentum) {
+  NetBuilder builder("net_builder");
+  std::vector<Variable> params, grads, velocities;
+  for (auto& shape : std::vector<std::vector<int>>{{4, 3}, {5}}) {
+    params.push_back(builder.CreateInput(Float(32), shape));
+    grads.push_back(builder.CreateInput(Float(32), shape));
+    velocities.push_back(builder.CreateInput(Float(32), shape));
+  }
+  auto outs = builder.multi_tensor_momentum(params, grads, velocities, 0.1f, 0.9f);
+  ASSERT_EQ(outs.size(), 4UL);
+  EXPECT_EQ(outs[1]->shape, std::vector<int>({5}));
+  auto program = builder.Build();
+
+  // a single instruction updates all the params
+  Target target = common::DefaultHostTarget();
+  auto graph    = std::make_shared<hlir::framework::Graph>(program, target);
+  auto scope    = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  ASSERT_EQ(runtime_program->size(), 1UL);
+
+  auto fill = [&](Variable var, float value) {
+    auto tensor = scope->GetTensor(var->id);
+    auto* data  = tensor->mutable_data<float>(target);
+    std::fill(data, data + tensor->shape().numel(), value);
+  };
+  for (int t = 0; t < 2; t++) {
+    fill(params[t], 1.f);
+    fill(grads[t], t + 1.f);
+    fill(velocities[t], 1.f);
+  }
+  runtime_program->Execute();
+  for (int t = 0; t < 2; t++) {
+    float v       = 0.9f + t + 1.f;
+    auto param    = scope->GetTensor(outs[t]->id);
+    auto velocity = scope->GetTensor(outs[2 + t]->id);
+    for (int i = 0; i < param->shape().numel(); i++) {
+      ASSERT_FLOAT_EQ(param->data<float>()[i], 1.f - 0.1f * v);
+      ASSERT_FLOAT_EQ(velocity->data<float>()[i], v);
+    }
+  }
+}
+
+TEST(net_build, program_execute_dropout) {
+  NetBuilder builder("net_builder");
+  Placeholder x           = builder.CreateInput(Float(32), {16, 64}, "X");
+  Placeholder dout        = builder.CreateInput(Float(32), {16, 64}, "DOut");
+  Placeholder seed_offset = builder.CreateInput(Int(32), {2}, "SeedOffset");
+  auto out                = builder.dropout(x, seed_offset, 0.25f, "upscale_in_train");
+  auto dx                 = builder.dropout_grad(dout, seed_offset, 0.25f, "upscale_in_train");
+  auto program            = builder.Build();
+
+  Target target = common::DefaultHostTarget();
+  auto graph    = std::make_shared<hlir::framework::Graph>(program, target);
+  auto scope    = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+
+  auto fill = [&](const std::string& name, float value) {
+    auto tensor = scope->GetTensor(name);
+    auto* data  = tensor->mutable_data<float>(target);
+    std::fill(data, data + tensor->shape().numel(), value);
+  };
+  fill("X", 2.f);
+  fill("DOut", 1.f);
+  auto* seeds = scope->GetTensor("SeedOffset")->mutable_data<int>(target);
+  seeds[0]    = 2021;
+  seeds[1]    = 3;
+  runtime_program->Execute();
+
+  // the backward regenerates the mask of the forward
+  auto out_tensor = scope->GetTensor(out->id);
+  auto dx_tensor  = scope->GetTensor(dx->id);
+  int kept        = 0;
+  for (int i = 0; i < out_tensor->shape().numel(); i++) {
+    bool keep = cinn_host_philox_uniform(2021, 3, i) >= 0.25f;
+    ASSERT_FLOAT_EQ(out_tensor->data<float>()[i], keep ? 2.f / 0.75f : 0.f);
+    ASSERT_FLOAT_EQ(dx_tensor->data<float>()[i], keep ? 1.f / 0.75f : 0.f);
+    kept += keep;
+  }
+  ASSERT_NEAR(kept / 1024., 0.75, 0.05);
+}
+
 }  // namespace frontend
 }  // namespace cinn
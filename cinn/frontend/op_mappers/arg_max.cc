@@ -0,0 +1,64 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <functional>
+#include <numeric>
+
+#include "cinn/frontend/op_mapper_registry.h"
+#include "cinn/frontend/op_mappers/common_utils.h"
+
+namespace cinn {
+namespace frontend {
+namespace op_mappers {
+
+void ArgReduceOpMapper(const paddle::cpp::OpDesc& op_desc, const OpMapperContext& ctx, bool is_max) {
+  CHECK_EQ(op_desc.Input("X").size(), 1UL);
+  auto x_name = op_desc.Input("X").front();
+  CHECK_EQ(op_desc.Output("Out").size(), 1UL);
+  auto out_name = op_desc.Output("Out").front();
+
+  auto axis     = utils::GetAttrOrDefault<int64_t>(op_desc, "axis", -1);
+  auto keepdims = utils::GetAttrOrDefault<bool>(op_desc, "keepdims", false);
+  auto flatten  = utils::GetAttrOrDefault<bool>(op_desc, "flatten", false);
+
+  auto x = ctx.GetVar(x_name);
+  if (flatten) {
+    int numel = std::accumulate(x->shape.begin(), x->shape.end(), 1, std::multiplies<int>());
+    x         = ctx.Builder()->reshape(x, {numel});
+    axis      = 0;
+  }
+  // the indices are int32 instead of the int64 of Paddle
+  auto out = is_max ? ctx.Builder()->argmax(x, static_cast<int>(axis), keepdims)
+                    : ctx.Builder()->argmin(x, static_cast<int>(axis), keepdims);
+  ctx.AddVar(out_name, out);
+  ctx.AddVarModelToProgram(out_name, out->id);
+}
+
+void ArgMaxOpMapper(const paddle::cpp::OpDesc& op_desc, const OpMapperContext& ctx) {
+  ArgReduceOpMapper(op_desc, ctx, true);
+}
+
+void ArgMinOpMapper(const paddle::cpp::OpDesc& op_desc, const OpMapperContext& ctx) {
+  ArgReduceOpMapper(op_desc, ctx, false);
+}
+
+}  // namespace op_mappers
+}  // namespace frontend
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(arg_max) {
+  CINN_REGISTER_OP_MAPPER(arg_max, cinn::frontend::op_mappers::ArgMaxOpMapper)
+  CINN_REGISTER_OP_MAPPER(arg_min, cinn::frontend::op_mappers::ArgMinOpMapper)
+  return true;
+}
@@ -72,7 +72,7 @@ void DepthwiseConv2dOpMapper(const paddle::cpp::OpDesc& op_desc, const OpMapperC
   auto y                 = ctx.GetVar(y_name);
 
   Variable out;
-  if (ctx.Target().arch == Target::Arch::X86) {
+  if (ctx.Target().is_cpu()) {
     out = ctx.Builder()->conv2d(x, y, strides, paddings, dilations, groups, data_format, padding_algorithm);
   } else {
     out = ctx.Builder()->depthwise_conv2d(x, y, strides, paddings, dilations, groups, data_format, padding_algorithm);
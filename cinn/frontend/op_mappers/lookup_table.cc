@@ -0,0 +1,48 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/frontend/op_mapper_registry.h"
+#include "cinn/frontend/op_mappers/common_utils.h"
+
+namespace cinn {
+namespace frontend {
+namespace op_mappers {
+
+void LookupTableV2OpMapper(const paddle::cpp::OpDesc& op_desc, const OpMapperContext& ctx) {
+  CHECK_EQ(op_desc.Input("W").size(), 1UL);
+  auto w_name = op_desc.Input("W").front();
+  CHECK_EQ(op_desc.Input("Ids").size(), 1UL);
+  auto ids_name = op_desc.Input("Ids").front();
+  CHECK_EQ(op_desc.Output("Out").size(), 1UL);
+  auto out_name = op_desc.Output("Out").front();
+
+  auto padding_idx = utils::GetAttrOrDefault<int64_t>(op_desc, "padding_idx", -1);
+
+  auto w   = ctx.GetVar(w_name);
+  auto ids = ctx.GetVar(ids_name);
+  // the negative padding_idx except -1 counts from the end of the vocabulary
+  if (padding_idx < -1) padding_idx += w->shape[0];
+  auto out = ctx.Builder()->lookup_table(w, ids, static_cast<int>(padding_idx));
+  ctx.AddVar(out_name, out);
+  ctx.AddVarModelToProgram(out_name, out->id);
+}
+
+}  // namespace op_mappers
+}  // namespace frontend
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(lookup_table) {
+  CINN_REGISTER_OP_MAPPER(lookup_table_v2, cinn::frontend::op_mappers::LookupTableV2OpMapper)
+  return true;
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/frontend/op_mapper_registry.h"
+#include "cinn/frontend/op_mappers/common_utils.h"
+
+namespace cinn {
+namespace frontend {
+namespace op_mappers {
+
+// The multihead_matmul of the Paddle inference passes, which projects the input to the query, key and value by the
+// weight in [hidden, 3, hidden] and the bias in [3, hidden], then attends them by the BiasQK mask.
+void MultiHeadMatMulOpMapper(const paddle::cpp::OpDesc& op_desc, const OpMapperContext& ctx) {
+  auto get_input_name = [&op_desc](const std::string& op_name) {
+    CHECK_EQ(op_desc.Input(op_name).size(), 1UL);
+    return op_desc.Input(op_name).front();
+  };
+  auto x    = ctx.GetVar(get_input_name("Input"));
+  auto w    = ctx.GetVar(get_input_name("W"));
+  auto bias = ctx.GetVar(get_input_name("Bias"));
+  CHECK_EQ(op_desc.Output("Out").size(), 1UL);
+  auto out_name = op_desc.Output("Out").front();
+
+  auto alpha       = utils::GetAttrOrDefault<float>(op_desc, "alpha", 1.0f);
+  auto head_number = utils::GetAttrOrDefault<int>(op_desc, "head_number", 1);
+
+  CHECK_EQ(x->shape.size(), 3UL) << "The input of multihead_matmul should be in [batch, seq, hidden]";
+  int hidden = x->shape[2];
+  CHECK_EQ(w->shape.size(), 3UL) << "The weight of multihead_matmul should be in [hidden, 3, hidden]";
+
+  // the projections of the query, key and value in a single mul, in the weight layout of the mul op mapper
+  auto w_2d = ctx.Builder()->reshape(w, {hidden, 3 * hidden});
+  Variable tran_w;
+#ifdef CINN_WITH_CUDNN
+  if (ctx.Target().arch == Target::Arch::NVGPU) {
+    tran_w = ctx.Builder()->reshape(w_2d, {3 * hidden, hidden});
+  } else {
+    tran_w = ctx.Builder()->transpose(w_2d, {1, 0});
+  }
+#else
+  tran_w = ctx.Builder()->transpose(w_2d, {1, 0});
+#endif
+  auto qkv = ctx.Builder()->mul(x, tran_w, 2, 1);
+  qkv      = ctx.Builder()->elementwise_add(qkv, ctx.Builder()->reshape(bias, {3 * hidden}));
+
+  auto q = ctx.Builder()->slice(qkv, {2}, {0}, {hidden});
+  auto k = ctx.Builder()->slice(qkv, {2}, {hidden}, {2 * hidden});
+  auto v = ctx.Builder()->slice(qkv, {2}, {2 * hidden}, {3 * hidden});
+
+  Variable out;
+  if (op_desc.HasInput("BiasQK") && !op_desc.Input("BiasQK").empty()) {
+    auto mask = ctx.GetVar(op_desc.Input("BiasQK").front());
+    out       = ctx.Builder()->multihead_attention(q, k, v, mask, head_number, alpha);
+  } else {
+    out = ctx.Builder()->multihead_attention(q, k, v, head_number, alpha);
+  }
+  ctx.AddVar(out_name, out);
+  ctx.AddVarModelToProgram(out_name, out->id);
+}
+
+}  // namespace op_mappers
+}  // namespace frontend
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(multihead_matmul) {
+  CINN_REGISTER_OP_MAPPER(multihead_matmul, cinn::frontend::op_mappers::MultiHeadMatMulOpMapper)
+  return true;
+}
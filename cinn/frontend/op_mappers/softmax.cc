@@ -34,11 +34,42 @@ void SoftmaxOpMapper(const paddle::cpp::OpDesc& op_desc, const OpMapperContext&
   ctx.AddVarModelToProgram(out_name, out->id);
 }
 
+void LogSoftmaxOpMapper(const paddle::cpp::OpDesc& op_desc, const OpMapperContext& ctx) {
+  CHECK_EQ(op_desc.Input("X").size(), 1UL);
+  auto x_name = op_desc.Input("X").front();
+  CHECK_EQ(op_desc.Output("Out").size(), 1UL);
+  auto out_name = op_desc.Output("Out").front();
+
+  auto axis = utils::GetAttrOrDefault<int>(op_desc, "axis", -1);
+
+  auto x   = ctx.GetVar(x_name);
+  auto out = ctx.Builder()->log_softmax(x, axis);
+  ctx.AddVar(out_name, out);
+  ctx.AddVarModelToProgram(out_name, out->id);
+}
+
+void FusedSoftmaxMaskOpMapper(const paddle::cpp::OpDesc& op_desc, const OpMapperContext& ctx) {
+  CHECK_EQ(op_desc.Input("X").size(), 1UL);
+  auto x_name = op_desc.Input("X").front();
+  CHECK_EQ(op_desc.Input("Mask").size(), 1UL);
+  auto mask_name = op_desc.Input("Mask").front();
+  CHECK_EQ(op_desc.Output("Out").size(), 1UL);
+  auto out_name = op_desc.Output("Out").front();
+
+  auto x    = ctx.GetVar(x_name);
+  auto mask = ctx.GetVar(mask_name);
+  auto out  = ctx.Builder()->fused_softmax_mask(x, mask);
+  ctx.AddVar(out_name, out);
+  ctx.AddVarModelToProgram(out_name, out->id);
+}
+
 }  // namespace op_mappers
 }  // namespace frontend
 }  // namespace cinn
 
 CINN_REGISTER_HELPER(softmax) {
   CINN_REGISTER_OP_MAPPER(softmax, cinn::frontend::op_mappers::SoftmaxOpMapper)
+  CINN_REGISTER_OP_MAPPER(log_softmax, cinn::frontend::op_mappers::LogSoftmaxOpMapper)
+  CINN_REGISTER_OP_MAPPER(fused_softmax_mask, cinn::frontend::op_mappers::FusedSoftmaxMaskOpMapper)
   return true;
 }
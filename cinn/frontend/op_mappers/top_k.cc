@@ -0,0 +1,67 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <numeric>
+#include <utility>
+
+#include "cinn/frontend/op_mapper_registry.h"
+#include "cinn/frontend/op_mappers/common_utils.h"
+
+namespace cinn {
+namespace frontend {
+namespace op_mappers {
+
+void TopKOpMapper(const paddle::cpp::OpDesc& op_desc, const OpMapperContext& ctx) {
+  CHECK_EQ(op_desc.Input("X").size(), 1UL);
+  auto x_name = op_desc.Input("X").front();
+  CHECK_EQ(op_desc.Output("Out").size(), 1UL);
+  auto out_name = op_desc.Output("Out").front();
+  CHECK_EQ(op_desc.Output("Indices").size(), 1UL);
+  auto indices_name = op_desc.Output("Indices").front();
+
+  auto k       = utils::GetAttrOrDefault<int>(op_desc, "k", 1);
+  auto axis    = utils::GetAttrOrDefault<int>(op_desc, "axis", -1);
+  auto largest = utils::GetAttrOrDefault<bool>(op_desc, "largest", true);
+
+  auto x   = ctx.GetVar(x_name);
+  int ndim = x->shape.size();
+  if (axis < 0) axis += ndim;
+  CHECK(axis >= 0 && axis < ndim) << "The axis of top_k should be in [-ndim, ndim)";
+  // top_k selects along the last axis, which the axis is swapped with
+  std::vector<int> perm(ndim);
+  std::iota(perm.begin(), perm.end(), 0);
+  std::swap(perm[axis], perm.back());
+  if (axis != ndim - 1) x = ctx.Builder()->transpose(x, perm);
+
+  auto outs = ctx.Builder()->top_k(x, k, largest);
+  CHECK_EQ(outs.size(), 2UL) << "top_k API's should return 2 Variables!";
+  if (axis != ndim - 1) {
+    for (auto& out : outs) out = ctx.Builder()->transpose(out, perm);
+  }
+  // the indices are int32 instead of the int64 of Paddle
+  ctx.AddVar(out_name, outs[0]);
+  ctx.AddVarModelToProgram(out_name, outs[0]->id);
+  ctx.AddVar(indices_name, outs[1]);
+  ctx.AddVarModelToProgram(indices_name, outs[1]->id);
+}
+
+}  // namespace op_mappers
+}  // namespace frontend
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(top_k) {
+  CINN_REGISTER_OP_MAPPER(top_k, cinn::frontend::op_mappers::TopKOpMapper)
+  CINN_REGISTER_OP_MAPPER(top_k_v2, cinn::frontend::op_mappers::TopKOpMapper)
+  return true;
+}
@@ -30,3 +30,9 @@ CINN_USE_REGISTER(pool2d)
 CINN_USE_REGISTER(conv2d)
 CINN_USE_REGISTER(transpose)
 CINN_USE_REGISTER(reshape)
+CINN_USE_REGISTER(layer_norm)
+CINN_USE_REGISTER(gelu)
+CINN_USE_REGISTER(multihead_matmul)
+CINN_USE_REGISTER(lookup_table)
+CINN_USE_REGISTER(arg_max)
+CINN_USE_REGISTER(top_k)
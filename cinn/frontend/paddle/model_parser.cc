@@ -14,7 +14,19 @@
 
 #include "cinn/frontend/paddle/model_parser.h"
 
+#include <fcntl.h>
+#include <gflags/gflags.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <numeric>
+#include <streambuf>
 #include <vector>
 
 #include "cinn/backends/codegen_cuda_dev.h"
@@ -23,6 +35,16 @@
 #include "cinn/backends/cuda_util.h"
 #include "cinn/common/common.h"
 #include "cinn/frontend/paddle/compatible_pb.h"
+#include "cinn/utils/thread_pool.h"
+
+DEFINE_bool(cinn_mmap_params,
+            false,
+            "Whether to load the combined params by mapping the file into memory, the host tensors refer to the mapped "
+            "memory without copies and the device tensors are copied from it by the chunks staged in pinned memory.");
+DEFINE_int32(cinn_param_load_threads,
+             4,
+             "The number of threads loading the parameters in parallel, each of which uploads its tensors to the "
+             "device on its own stream.");
 
 namespace cinn::frontend::paddle {
 
@@ -46,8 +68,8 @@ int SizeOfType(framework_proto::VarType::Type type) {
   return -1;
 }
 
-void TensorFromStream(std::istream &is, hlir::framework::_Tensor_ *tensor, const common::Target &target) {
-  using Type = framework_proto::VarType::Type;
+// Read the version and the desc of a tensor, and resize the tensor by it.
+framework_proto::VarType::TensorDesc ReadTensorDesc(std::istream &is, hlir::framework::_Tensor_ *tensor) {
   uint32_t version;
   is.read(reinterpret_cast<char *>(&version), sizeof(version));
   CHECK_EQ(version, 0U) << "Only version 0 is supported";
@@ -63,15 +85,23 @@ void TensorFromStream(std::istream &is, hlir::framework::_Tensor_ *tensor, const
     CHECK(desc.ParseFromArray(buf.get(), size)) << "Cannot parse tensor desc";
   }
 
-  // read tensor
   std::vector<int32_t> dims_vec;
   std::copy(desc.dims().begin(), desc.dims().end(), std::back_inserter(dims_vec));
   hlir::framework::Shape dims(dims_vec);
   tensor->Resize(dims);
+  return desc;
+}
+
+// Read the data of the tensor described by \p desc.
+void ReadTensorData(std::istream &is,
+                    const framework_proto::VarType::TensorDesc &desc,
+                    hlir::framework::_Tensor_ *tensor,
+                    const common::Target &target) {
+  using Type = framework_proto::VarType::Type;
   void *buf;
   size_t size = tensor->shape().numel() * SizeOfType(desc.data_type());
   // alllocate memory
-  if (target.arch == Target::Arch::X86) {
+  if (target.is_cpu()) {
     switch (static_cast<int>(desc.data_type())) {
 #define SET_TENSOR(desc, type, precision)     \
   case Type::VarType_Type_##desc:             \
@@ -108,8 +138,13 @@ void TensorFromStream(std::istream &is, hlir::framework::_Tensor_ *tensor, const
   }
 }
 
-void LoadLoDTensor(std::istream &is, hlir::framework::Variable *var, const common::Target &target) {
-  auto &tensor = absl::get<hlir::framework::Tensor>(*var);
+void TensorFromStream(std::istream &is, hlir::framework::_Tensor_ *tensor, const common::Target &target) {
+  auto desc = ReadTensorDesc(is, tensor);
+  ReadTensorData(is, desc, tensor, target);
+}
+
+// Skip the version and the LoD information before a tensor.
+void SkipLoD(std::istream &is) {
   uint32_t version{};
   is.read(reinterpret_cast<char *>(&version), sizeof(version));
   VLOG(3) << "model version " << version;
@@ -125,10 +160,299 @@ void LoadLoDTensor(std::istream &is, hlir::framework::Variable *var, const commo
     is.read(reinterpret_cast<char *>(tmp.data()), static_cast<std::streamsize>(size));
     // lod[i] = tmp;
   }
+}
 
+void LoadLoDTensor(std::istream &is, hlir::framework::Variable *var, const common::Target &target) {
+  auto &tensor = absl::get<hlir::framework::Tensor>(*var);
+  SkipLoD(is);
   TensorFromStream(is, tensor.operator->(), target);
 }
 
+namespace {
+
+// A private mapping of a whole file, the pages written by the tensors referring to it are copied on write.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    CHECK_GE(fd, 0) << "Cannot open file: " << path;
+    struct stat st;
+    CHECK_EQ(fstat(fd, &st), 0) << "Cannot stat file: " << path;
+    size_ = st.st_size;
+    if (size_ > 0) {
+      void *data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      CHECK(data != MAP_FAILED) << "Cannot map file: " << path << ", " << std::strerror(errno);
+      data_ = static_cast<char *>(data);
+      madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+    close(fd);
+  }
+  ~MappedFile() {
+    if (data_) munmap(data_, size_);
+  }
+
+  char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  char *data_{nullptr};
+  size_t size_{0};
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(MappedFile);
+};
+
+// Read the memory of a mapped file as a seekable stream.
+class MemoryStreamBuf : public std::streambuf {
+ public:
+  MemoryStreamBuf(char *data, size_t size) { setg(data, data, data + size); }
+
+ protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+    char *base = dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr();
+    if (base + off < eback() || base + off > egptr()) return pos_type(off_type(-1));
+    setg(eback(), base + off, egptr());
+    return pos_type(gptr() - eback());
+  }
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+  }
+};
+
+// Where the data of a tensor is in the combined params file.
+struct ParamEntry {
+  hlir::framework::_Tensor_ *tensor;
+  framework_proto::VarType::TensorDesc desc;
+  size_t offset;
+  size_t size;
+};
+
+// Read the descs of the combined \p params and resize their tensors, skipping over the data.
+std::vector<ParamEntry> IndexCombinedParams(std::istream &is,
+                                            hlir::framework::Scope *scope,
+                                            const std::vector<std::string> &params) {
+  std::vector<ParamEntry> entries;
+  for (auto &param : params) {
+    auto &tensor = absl::get<hlir::framework::Tensor>(*scope->Var<hlir::framework::Tensor>(param));
+    CHECK(static_cast<bool>(is)) << "There is a problem with loading model parameters";
+    SkipLoD(is);
+    ParamEntry entry;
+    entry.tensor = tensor.operator->();
+    entry.desc   = ReadTensorDesc(is, entry.tensor);
+    entry.offset = is.tellg();
+    entry.size   = entry.tensor->shape().numel() * SizeOfType(entry.desc.data_type());
+    is.seekg(entry.size, std::ios_base::cur);
+    CHECK(static_cast<bool>(is)) << "The params file is truncated at " << param;
+    entries.push_back(std::move(entry));
+  }
+  is.peek();
+  CHECK(is.eof()) << "You are not allowed to load partial data via"
+                  << " LoadCombinedParamsPb, use LoadParam instead.";
+  return entries;
+}
+
+/**
+ * Run \p load(begin, end) over the shards of [0, \p num_tasks) in parallel, each shard is about the same of the total
+ * \p task_bytes, and runs on the current device of the caller on NVGPU.
+ */
+void ParallelLoad(const std::vector<size_t> &task_bytes,
+                  const common::Target &target,
+                  const std::function<void(int, int)> &load) {
+  int num_tasks   = task_bytes.size();
+  int num_threads = std::max(1, std::min<int>(FLAGS_cinn_param_load_threads, num_tasks));
+  if (num_threads <= 1) {
+    load(0, num_tasks);
+    return;
+  }
+  size_t total_bytes = std::accumulate(task_bytes.begin(), task_bytes.end(), size_t(0));
+  std::vector<std::pair<int, int>> shards;
+  size_t bytes = 0;
+  for (int i = 0, begin = 0; i < num_tasks; i++) {
+    bytes += task_bytes[i];
+    // a shard is closed when it reaches its share of the total bytes, and the last one takes the rest
+    bool full = shards.size() + 1 < num_threads && bytes * num_threads >= total_bytes * (shards.size() + 1);
+    if (i + 1 == num_tasks || full) {
+      shards.emplace_back(begin, i + 1);
+      begin = i + 1;
+    }
+  }
+
+  int device = 0;
+#ifdef CINN_WITH_CUDA
+  if (target.arch == Target::Arch::NVGPU) CUDA_CALL(cudaGetDevice(&device));
+#endif
+  utils::ThreadPool pool(shards.size());
+  for (auto &shard : shards) {
+    pool.Schedule([&, shard] {
+#ifdef CINN_WITH_CUDA
+      if (target.arch == Target::Arch::NVGPU) CUDA_CALL(cudaSetDevice(device));
+#endif
+      load(shard.first, shard.second);
+    });
+  }
+}
+
+#ifdef CINN_WITH_CUDA
+constexpr size_t kStagingChunkBytes = 4 << 20;
+
+// Copy the host data to the device by the chunks staged in two pinned buffers, so that the read of a chunk into the
+// pinned memory overlaps with the transfer of the previous one.
+class PinnedStager {
+ public:
+  PinnedStager() {
+    CUDA_CALL(cudaStreamCreateWithFlags(&stream_, cudaStreamNonBlocking));
+    for (int i = 0; i < 2; i++) {
+      CUDA_CALL(cudaMallocHost(&chunks_[i], kStagingChunkBytes));
+      CUDA_CALL(cudaEventCreateWithFlags(&events_[i], cudaEventDisableTiming));
+    }
+  }
+  ~PinnedStager() {
+    CUDA_CALL(cudaStreamSynchronize(stream_));
+    for (int i = 0; i < 2; i++) {
+      CUDA_CALL(cudaFreeHost(chunks_[i]));
+      CUDA_CALL(cudaEventDestroy(events_[i]));
+    }
+    CUDA_CALL(cudaStreamDestroy(stream_));
+  }
+
+  //! Copy \p size bytes to \p dst, each chunk is filled by \p read(chunk, bytes) in order.
+  void Copy(void *dst, size_t size, const std::function<void(char *, size_t)> &read) {
+    for (size_t offset = 0; offset < size; offset += kStagingChunkBytes) {
+      size_t bytes = std::min(kStagingChunkBytes, size - offset);
+      // wait until the transfer of the chunk two steps before is done to reuse its pinned buffer
+      CUDA_CALL(cudaEventSynchronize(events_[next_]));
+      read(static_cast<char *>(chunks_[next_]), bytes);
+      CUDA_CALL(cudaMemcpyAsync(
+          static_cast<char *>(dst) + offset, chunks_[next_], bytes, cudaMemcpyHostToDevice, stream_));
+      CUDA_CALL(cudaEventRecord(events_[next_], stream_));
+      next_ = 1 - next_;
+    }
+  }
+
+ private:
+  cudaStream_t stream_;
+  void *chunks_[2];
+  cudaEvent_t events_[2];
+  int next_{0};
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(PinnedStager);
+};
+
+float *MutableDeviceData(const framework_proto::VarType::TensorDesc &desc,
+                         hlir::framework::_Tensor_ *tensor,
+                         const common::Target &target) {
+  if (desc.data_type() != framework_proto::VarType::FP32) LOG(FATAL) << "[CUDA] The type is not fp32!!";
+  auto *data = tensor->mutable_data<float>(target);
+  tensor->set_type(Float(32));
+  return data;
+}
+#endif
+
+// The generated host code loads the vectors aligned to at most 8 bytes.
+constexpr size_t kMappedTensorAlignment = 8;
+
+// Load the combined \p params from the mapping of the file at \p path.
+void LoadCombinedParamsMapped(const std::string &path,
+                              hlir::framework::Scope *scope,
+                              const std::vector<std::string> &params,
+                              const common::Target &target) {
+  auto file = std::make_shared<MappedFile>(path);
+  MemoryStreamBuf buf(file->data(), file->size());
+  std::istream is(&buf);
+  auto entries = IndexCombinedParams(is, scope, params);
+
+  std::vector<size_t> task_bytes;
+  for (auto &entry : entries) task_bytes.push_back(entry.size);
+  std::atomic<int> num_shared{0};
+  ParallelLoad(task_bytes, target, [&](int begin, int end) {
+#ifdef CINN_WITH_CUDA
+    std::unique_ptr<PinnedStager> stager;
+#endif
+    for (int i = begin; i < end; i++) {
+      auto &entry = entries[i];
+      auto *data  = reinterpret_cast<uint8_t *>(file->data() + entry.offset);
+      using Type  = framework_proto::VarType::Type;
+      if (target.is_cpu() && reinterpret_cast<uintptr_t>(data) % kMappedTensorAlignment == 0) {
+        switch (static_cast<int>(entry.desc.data_type())) {
+#define SHARE_TENSOR(desc, type)                                 \
+  case Type::VarType_Type_##desc:                                \
+    entry.tensor->share_external_data<type>(data, target, file); \
+    break
+
+          SHARE_TENSOR(FP32, float);
+          SHARE_TENSOR(INT8, int8_t);
+          SHARE_TENSOR(INT16, int16_t);
+          SHARE_TENSOR(INT32, int32_t);
+          SHARE_TENSOR(INT64, int64_t);
+#undef SHARE_TENSOR
+          default:
+            LOG(FATAL) << "unknown type " << entry.desc.data_type();
+        }
+        num_shared++;
+      } else if (target.arch == Target::Arch::NVGPU) {
+#ifdef CINN_WITH_CUDA
+        if (!stager) stager.reset(new PinnedStager);
+        const char *src = reinterpret_cast<const char *>(data);
+        stager->Copy(MutableDeviceData(entry.desc, entry.tensor, target), entry.size, [&](char *chunk, size_t bytes) {
+          std::memcpy(chunk, src, bytes);
+          src += bytes;
+        });
+#else
+        LOG(FATAL) << "To use CUDA backends, you need to set WITH_CUDA ON!";
+#endif
+      } else {
+        // the misaligned host tensors are copied out of the mapping
+        MemoryStreamBuf tensor_buf(file->data() + entry.offset, entry.size);
+        std::istream tensor_is(&tensor_buf);
+        ReadTensorData(tensor_is, entry.desc, entry.tensor, target);
+      }
+    }
+  });
+  VLOG(3) << "Load " << params.size() << " params from the mapping of " << path << ", " << num_shared
+          << " of them refer to the mapped memory";
+}
+
+// Load the combined \p params from the file at \p path, the threads read their tensors by their own streams.
+void LoadCombinedParamsParallel(const std::string &path,
+                                hlir::framework::Scope *scope,
+                                const std::vector<std::string> &params,
+                                const common::Target &target) {
+  std::vector<ParamEntry> entries;
+  {
+    std::ifstream fin(path, std::ios::binary);
+    CHECK(fin.is_open()) << "Cannot open file: " << path;
+    entries = IndexCombinedParams(fin, scope, params);
+  }
+
+  std::vector<size_t> task_bytes;
+  for (auto &entry : entries) task_bytes.push_back(entry.size);
+  ParallelLoad(task_bytes, target, [&](int begin, int end) {
+    std::ifstream fin(path, std::ios::binary);
+    CHECK(fin.is_open()) << "Cannot open file: " << path;
+#ifdef CINN_WITH_CUDA
+    std::unique_ptr<PinnedStager> stager;
+#endif
+    for (int i = begin; i < end; i++) {
+      auto &entry = entries[i];
+      fin.seekg(entry.offset);
+      if (target.arch == Target::Arch::NVGPU) {
+#ifdef CINN_WITH_CUDA
+        if (!stager) stager.reset(new PinnedStager);
+        stager->Copy(MutableDeviceData(entry.desc, entry.tensor, target),
+                     entry.size,
+                     [&](char *chunk, size_t bytes) { fin.read(chunk, bytes); });
+#else
+        LOG(FATAL) << "To use CUDA backends, you need to set WITH_CUDA ON!";
+#endif
+      } else {
+        ReadTensorData(fin, entry.desc, entry.tensor, target);
+      }
+      CHECK(static_cast<bool>(fin)) << "There is a problem with loading model parameters";
+    }
+  });
+}
+
+}  // namespace
+
 void ReadBinaryFile(const std::string &filename, std::string *contents) {
   std::ifstream fin(filename, std::ios::in | std::ios::binary);
   CHECK(fin.is_open()) << "Cannot open file: " << filename;
@@ -188,6 +512,16 @@ void LoadCombinedParamsPb(const std::string &path,
   }
   std::sort(paramlist.begin(), paramlist.end());
 
+  if (!params_from_memory && (FLAGS_cinn_mmap_params || FLAGS_cinn_param_load_threads > 1)) {
+    for (auto &param : paramlist) param = utils::TransValidVarName(param);
+    if (FLAGS_cinn_mmap_params) {
+      LoadCombinedParamsMapped(path, scope, paramlist, target);
+    } else {
+      LoadCombinedParamsParallel(path, scope, paramlist, target);
+    }
+    return;
+  }
+
   // Load vars
   auto load_var_func = [&](std::istream &is) {
     for (size_t i = 0; i < paramlist.size(); ++i) {
@@ -248,21 +582,30 @@ void LoadModelPb(const std::string &model_dir,
     LoadCombinedParamsPb(param_file_temp, scope, *cpp_prog, model_from_memory, target);
   } else {
     auto main_block = pb_proto_prog.blocks(0);
+    // The variables are created in order before the files are read in parallel.
+    std::vector<std::pair<std::string, hlir::framework::Variable *>> weights;
+    std::vector<size_t> file_bytes;
     for (auto &var : main_block.vars()) {
       if (var.name() == "feed" || var.name() == "fetch" || !var.persistable()) continue;
 
       std::string file_path = model_dir + "/" + var.name();
-      VLOG(4) << "reading weight " << var.name();
-
-      std::ifstream file(file_path, std::ios::binary);
       switch (var.type().type()) {
         case framework_proto::VarType_Type_LOD_TENSOR:
-          LoadLoDTensor(file, scope->Var<hlir::framework::Tensor>(utils::TransValidVarName(var.name())), target);
+          weights.emplace_back(file_path, scope->Var<hlir::framework::Tensor>(utils::TransValidVarName(var.name())));
           break;
         default:
           LOG(FATAL) << "unknown weight type";
       }
+      struct stat st;
+      file_bytes.push_back(stat(file_path.c_str(), &st) == 0 ? st.st_size : 0);
     }
+    ParallelLoad(file_bytes, target, [&](int begin, int end) {
+      for (int i = begin; i < end; i++) {
+        VLOG(4) << "reading weight " << weights[i].first;
+        std::ifstream file(weights[i].first, std::ios::binary);
+        LoadLoDTensor(file, weights[i].second, target);
+      }
+    });
   }
 
   VLOG(4) << "Load protobuf model in [" << model_dir << "] successfully";
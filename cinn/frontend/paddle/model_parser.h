@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #pragma once
+#include <gflags/gflags.h>
+
 #include <algorithm>
 #include <memory>
 #include <string>
@@ -26,6 +28,9 @@
 #include "cinn/hlir/framework/scope.h"
 #include "cinn/hlir/framework/tensor.h"
 
+DECLARE_bool(cinn_mmap_params);
+DECLARE_int32(cinn_param_load_threads);
+
 namespace cinn::frontend::paddle {
 namespace framework_proto = ::paddle::framework::proto;
 
@@ -50,9 +55,10 @@ void LoadParams(const std::string& path);
 // Load a single parameter to an output tensor.
 void LoadParam(const std::string& path, hlir::framework::Variable* out, const common::Target& target);
 
+// Load the combined parameters, from the mapping of the file if FLAGS_cinn_mmap_params is set.
 void LoadCombinedParamsPb(const std::string& path,
                           hlir::framework::Scope* scope,
-                          const pb::ProgramDesc& prog,
+                          const cpp::ProgramDesc& cpp_prog,
                           bool params_from_memory      = false,
                           const common::Target& target = common::DefaultHostTarget());
 
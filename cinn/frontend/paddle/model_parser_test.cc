@@ -17,6 +17,9 @@
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <fstream>
+
 DEFINE_string(model_dir, "<NOTEXIST>", "model directory path");
 
 namespace cinn::frontend::paddle {
@@ -42,4 +45,72 @@ TEST(LoadModelPb, naive_model) {
   // fetch
 }
 
+// Write a combined params file of the float tensors in the order of their names.
+void WriteCombinedParams(const std::string& path, const std::vector<std::vector<int>>& shapes) {
+  std::ofstream os(path, std::ios::binary);
+  for (int i = 0; i < shapes.size(); i++) {
+    uint32_t version   = 0;
+    uint64_t lod_level = 0;
+    os.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    os.write(reinterpret_cast<const char*>(&lod_level), sizeof(lod_level));
+    os.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    framework_proto::VarType::TensorDesc desc;
+    desc.set_data_type(framework_proto::VarType::FP32);
+    int numel = 1;
+    for (int dim : shapes[i]) {
+      desc.add_dims(dim);
+      numel *= dim;
+    }
+    std::string desc_str = desc.SerializeAsString();
+    int32_t desc_size    = desc_str.size();
+    os.write(reinterpret_cast<const char*>(&desc_size), sizeof(desc_size));
+    os.write(desc_str.data(), desc_size);
+    std::vector<float> data(numel);
+    for (int j = 0; j < numel; j++) data[j] = i * 100 + j;
+    os.write(reinterpret_cast<const char*>(data.data()), numel * sizeof(float));
+  }
+}
+
+TEST(LoadCombinedParamsPb, parallel_and_mmap) {
+  // The data of a starts at the 24th byte of the file, and the data of b at the 74th.
+  std::string path = "mmap_params_test.bin";
+  WriteCombinedParams(path, {{6}, {2, 2}});
+  cpp::ProgramDesc program_desc;
+  auto* block = program_desc.AddBlock<cpp::BlockDesc>();
+  for (auto& name : {"b", "a"}) {
+    auto* var = block->AddVar<cpp::VarDesc>();
+    var->SetName(name);
+    var->SetType(cpp::VarDescAPI::Type::LOD_TENSOR);
+    var->SetPersistable(true);
+  }
+
+  // the sequential stream, the parallel streams and the mapping
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  FLAGS_cinn_param_load_threads = 1;
+  hlir::framework::Scope scope;
+  LoadCombinedParamsPb(path, &scope, program_desc);
+  FLAGS_cinn_param_load_threads = 2;
+  hlir::framework::Scope parallel_scope;
+  LoadCombinedParamsPb(path, &parallel_scope, program_desc);
+  FLAGS_cinn_mmap_params = true;
+  hlir::framework::Scope mapped_scope;
+  LoadCombinedParamsPb(path, &mapped_scope, program_desc);
+  std::remove(path.c_str());
+
+  // the aligned a refers to the mapping, which outlives the removal of the file, and the misaligned b is copied out.
+  ASSERT_FALSE(mapped_scope.GetTensor("a")->owns_memory());
+  ASSERT_TRUE(mapped_scope.GetTensor("b")->owns_memory());
+  for (auto& name : {"a", "b"}) {
+    auto expected = scope.GetTensor(name);
+    for (auto* actual_scope : {&parallel_scope, &mapped_scope}) {
+      auto actual = actual_scope->GetTensor(name);
+      ASSERT_EQ(actual->shape().data(), expected->shape().data());
+      for (int i = 0; i < expected->shape().numel(); i++) {
+        ASSERT_EQ(actual->data<float>()[i], expected->data<float>()[i]);
+      }
+    }
+  }
+  ASSERT_EQ(mapped_scope.GetTensor("b")->data<float>()[3], 103.f);
+}
+
 }  // namespace cinn::frontend::paddle
@@ -429,7 +429,7 @@ void PaddleModelToProgram::AddOpMapper_depthwise_conv2d() {
     auto x               = GetVar(TransValidVarName(x_name));
     auto y               = GetVar(TransValidVarName(y_name));
     Variable out;
-    if (target_.arch == Target::Arch::X86) {
+    if (target_.is_cpu()) {
       out = program_->conv2d(x, y, attrs);
     } else {
       out = program_->depthwise_conv2d(x, y, attrs);
@@ -621,7 +621,7 @@ void PaddleModelToProgram::TransposeVar(const std::string& name) {
   auto* var = scope_->FindVar(name);
   if (var) {
     auto& tensor = absl::get<hlir::framework::Tensor>(*var);
-    if (target_.arch == Target::Arch::X86) {
+    if (target_.is_cpu()) {
       float* data = tensor->mutable_data<float>(target_);
       CHECK(tensor->shape().size() == 2) << "The y data's shape size of op [mul] is not equal to 2! Please check.";
       TransposeData(data, tensor->shape().data()[0], tensor->shape().data()[1]);
@@ -667,7 +667,7 @@ void PaddleModelToProgram::ReverseHWVar(const std::string& name) {
   auto* var = scope_->FindVar(name);
   if (var) {
     auto& tensor = absl::get<hlir::framework::Tensor>(*var);
-    if (target_.arch == Target::Arch::X86) {
+    if (target_.is_cpu()) {
       float* data = tensor->mutable_data<float>(target_);
       CHECK(tensor->shape().size() == 4) << "The y data's shape size of op [conv2d] is not equal to 4! Please check.";
       ReverseHWData(data, tensor->shape().data());
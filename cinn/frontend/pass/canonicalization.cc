@@ -0,0 +1,326 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <absl/container/flat_hash_map.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cinn/frontend/program_pass.h"
+
+namespace cinn {
+namespace frontend {
+namespace pass {
+
+/**
+ * Fold the no-op and the redundant instructions the converted programs are full of, before the graph is built:
+ *
+ * 1. The identities: identity(x), scale(x, 1, 0), x + 0, x * 1 of the constants filling no more than the shape of x,
+ * negative(negative(x)), and reshape(x) or broadcast_to(x) to the shape of x.
+ * 2. x + c and x * c of the float constants c are canonicalized to scale(x, 1, c) and scale(x, c, 0), and the
+ * consecutive scales are merged into one, so are the consecutive reshapes.
+ * 3. The instructions whose results are left unread by the above are removed, e.g. the constants.
+ *
+ * The readers of an identity read its input instead, and if the identity is fetched, its input is written to it by the
+ * producer instead. The fetched variables are kept, see ProgramPass::Apply.
+ */
+class CanonicalizationPass : public ProgramPass {
+ public:
+  using ProgramPass::ApplyImpl;
+  using ProgramPass::ProgramPass;
+
+  void ApplyImpl(Program* prog,
+                 const std::unordered_set<std::string>& fetch_ids,
+                 const common::Target& target) const override {
+    std::vector<Instruction> instrs;
+    for (size_t i = 0; i < prog->size(); i++) instrs.push_back((*prog)[i]);
+
+    State state;
+    state.instrs    = &instrs;
+    state.fetch_ids = fetch_ids;
+    if (fetch_ids.empty()) {
+      auto readers = CountReaders(instrs);
+      for (auto& instr : instrs) {
+        for (auto& var : instr->outputs) {
+          if (!readers.count(var->id)) state.fetch_ids.insert(var->id);
+        }
+      }
+    }
+    int rewrites = 0;
+    while (RewriteOne(&state)) rewrites++;
+    if (!rewrites) return;
+    int removed = RemoveUnread(&state);
+
+    std::vector<Variable> inputs = prog->GetInputs();
+    *prog                        = Program(std::move(instrs), std::move(inputs));
+    VLOG(3) << "Canonicalization rewrites " << rewrites << " instructions and removes " << removed;
+  }
+
+ private:
+  struct State {
+    std::vector<Instruction>* instrs;
+    std::unordered_set<std::string> fetch_ids;
+    // the variables read before the rewrites, which are removed once unread
+    std::unordered_set<std::string> originally_read;
+  };
+
+  static absl::flat_hash_map<std::string, int> CountReaders(const std::vector<Instruction>& instrs) {
+    absl::flat_hash_map<std::string, int> readers;
+    for (auto& instr : instrs) {
+      for (auto& var : instr->inputs) readers[var->id]++;
+    }
+    return readers;
+  }
+
+  template <typename T>
+  static T GetAttr(const Instruction& instr, const std::string& key, const T& default_value) {
+    auto it = instr->attrs.find(key);
+    return it == instr->attrs.end() ? default_value : absl::get<T>(it->second);
+  }
+
+  static int64_t Numel(const std::vector<int>& shape) {
+    int64_t numel = 1;
+    for (int dim : shape) numel *= dim;
+    return numel;
+  }
+
+  static bool IsFloat(const Variable& var) { return var->type.is_float(); }
+
+  // Get the value of \p var if it is a constant filled by fill_constant and broadcast_to, and its shape in \p shape.
+  static bool GetConstant(const Variable& var,
+                          const absl::flat_hash_map<std::string, int>& producer,
+                          const std::vector<Instruction>& instrs,
+                          double* value,
+                          std::vector<int>* shape) {
+    auto it = producer.find(var->id);
+    if (it == producer.end()) return false;
+    auto& instr = instrs[it->second];
+    if (instr->op_type == "broadcast_to") {
+      auto out_shape = instr->attrs.find("out_shape");
+      if (out_shape == instr->attrs.end() || instr->inputs.size() != 1U) return false;
+      if (!GetConstant(instr->inputs[0], producer, instrs, value, shape)) return false;
+      *shape = absl::get<std::vector<int>>(out_shape->second);
+      return true;
+    }
+    if (instr->op_type != "fill_constant" || !instr->attrs.count("value") || !instr->attrs.count("shape")) return false;
+    auto& attr = instr->attrs.at("value");
+    if (auto* v = absl::get_if<float>(&attr)) {
+      *value = *v;
+    } else if (auto* v = absl::get_if<int>(&attr)) {
+      *value = *v;
+    } else if (auto* v = absl::get_if<bool>(&attr)) {
+      *value = *v;
+    } else {
+      return false;
+    }
+    *shape = absl::get<std::vector<int>>(instr->attrs.at("shape"));
+    return true;
+  }
+
+  // Whether the constant of \p shape is broadcast to the shape of \p x only, so that x op c has the shape of x.
+  static bool FitsShape(const std::vector<int>& shape, const Variable& x) {
+    if (x->shape.empty()) return false;
+    return shape == x->shape || (Numel(shape) == 1 && shape.size() <= x->shape.size());
+  }
+
+  // Copy \p instr to be rewritten, the other programs sharing it are left as they are.
+  static Instruction Copy(const Instruction& instr) {
+    Instruction copy(instr->op_type, instr->inputs, instr->parent_program);
+    copy->attrs         = instr->attrs;
+    copy->attrs_ordered = instr->attrs_ordered;
+    copy->outputs       = instr->outputs;
+    return copy;
+  }
+
+  // Replace \p instr by the scale of \p x by y = scale * x + bias, which writes the same output.
+  static void MakeScale(Instruction* instr, const Variable& x, float scale, float bias) {
+    Instruction res("scale", {x}, (*instr)->parent_program);
+    res->outputs = (*instr)->outputs;
+    res.SetAttr("scale", scale);
+    res.SetAttr("bias", bias);
+    res.SetAttr("bias_after_scale", true);
+    *instr = res;
+  }
+
+  // Whether \p instr is an identity, whose output equals \p input.
+  static bool IsIdentity(const Instruction& instr,
+                         const absl::flat_hash_map<std::string, int>& producer,
+                         const std::vector<Instruction>& instrs,
+                         Variable* input) {
+    if (instr->outputs.size() != 1U || instr->inputs.empty()) return false;
+    auto& op_type = instr->op_type;
+    auto& x       = instr->inputs[0];
+    auto& out     = instr->outputs[0];
+    *input        = x;
+    if (op_type == "identity" && instr->inputs.size() == 1U) return true;
+    if (op_type == "scale" && GetAttr<float>(instr, "scale", 1.f) == 1.f && GetAttr<float>(instr, "bias", 0.f) == 0.f) {
+      return true;
+    }
+    if ((op_type == "reshape" || op_type == "broadcast_to") && !x->shape.empty() && x->shape == out->shape) return true;
+    if (op_type == "negative") {
+      auto it = producer.find(x->id);
+      if (it == producer.end() || instrs[it->second]->op_type != "negative") return false;
+      *input = instrs[it->second]->inputs[0];
+      return true;
+    }
+    if ((op_type == "elementwise_add" || op_type == "elementwise_mul") && instr->inputs.size() == 2U) {
+      double identity = op_type == "elementwise_add" ? 0. : 1.;
+      for (int i = 0; i < 2; i++) {
+        double value;
+        std::vector<int> shape;
+        auto& operand = instr->inputs[1 - i];
+        if (GetConstant(instr->inputs[i], producer, instrs, &value, &shape) && value == identity &&
+            FitsShape(shape, operand) && operand->type == out->type) {
+          *input = operand;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // Apply the first rewrite found, return false if none is.
+  static bool RewriteOne(State* state) {
+    auto& instrs = *state->instrs;
+    absl::flat_hash_map<std::string, int> producer;
+    for (int i = 0; i < instrs.size(); i++) {
+      for (auto& var : instrs[i]->outputs) producer[var->id] = i;
+    }
+    auto readers = CountReaders(instrs);
+    for (auto& item : readers) state->originally_read.insert(item.first);
+    // the variable \p id can be folded into its reader if the reader is the only one
+    auto is_folded = [&](const std::string& id) {
+      return producer.count(id) && readers.at(id) == 1 && !state->fetch_ids.count(id);
+    };
+
+    for (int i = 0; i < instrs.size(); i++) {
+      auto& instr = instrs[i];
+      Variable x;
+      if (IsIdentity(instr, producer, instrs, &x)) {
+        Variable out = instr->outputs[0];
+        if (!state->fetch_ids.count(out->id)) {
+          for (auto& reader : instrs) {
+            auto& inputs = reader->inputs;
+            if (std::none_of(inputs.begin(), inputs.end(), [&](const Variable& var) { return var->id == out->id; })) {
+              continue;
+            }
+            reader = Copy(reader);
+            for (auto& var : reader->inputs) {
+              if (var->id == out->id) var = x;
+            }
+          }
+        } else if (instr->inputs[0]->id == x->id && is_folded(x->id) && x->type == out->type) {
+          // the producer writes the fetched variable directly, unless x is read by another identity like negative
+          auto& source = instrs[producer.at(x->id)];
+          source       = Copy(source);
+          for (auto& var : source->outputs) {
+            if (var->id == x->id) var = out;
+          }
+        } else {
+          continue;
+        }
+        VLOG(4) << "Fold the identity " << instr->op_type << " of " << x->id << " to " << out->id;
+        instrs.erase(instrs.begin() + i);
+        return true;
+      }
+
+      if ((instr->op_type == "elementwise_add" || instr->op_type == "elementwise_mul") && instr->inputs.size() == 2U &&
+          instr->outputs.size() == 1U) {
+        for (int j = 0; j < 2; j++) {
+          double value;
+          std::vector<int> shape;
+          auto operand = instr->inputs[1 - j];
+          if (!IsFloat(operand) || operand->type != instr->outputs[0]->type ||
+              !GetConstant(instr->inputs[j], producer, instrs, &value, &shape) || !FitsShape(shape, operand)) {
+            continue;
+          }
+          bool is_add = instr->op_type == "elementwise_add";
+          VLOG(4) << "Canonicalize " << instr->op_type << " of " << operand->id << " by " << value << " to scale";
+          MakeScale(&instr, operand, is_add ? 1.f : value, is_add ? value : 0.f);
+          return true;
+        }
+      }
+
+      if (instr->op_type == "scale" && instr->inputs.size() == 1U && IsFloat(instr->inputs[0]) &&
+          is_folded(instr->inputs[0]->id)) {
+        auto& inner = instrs[producer.at(instr->inputs[0]->id)];
+        if (inner->op_type == "scale" && inner->inputs.size() == 1U) {
+          // s2 * (s1 * x + b1) + b2 = s1 * s2 * x + (s2 * b1 + b2), with the biases after the scales
+          auto bias_after = [](const Instruction& scale) {
+            float s = GetAttr<float>(scale, "scale", 1.f);
+            float b = GetAttr<float>(scale, "bias", 0.f);
+            return GetAttr<bool>(scale, "bias_after_scale", true) ? b : s * b;
+          };
+          float s1 = GetAttr<float>(inner, "scale", 1.f);
+          float s2 = GetAttr<float>(instr, "scale", 1.f);
+          float b  = s2 * bias_after(inner) + bias_after(instr);
+          VLOG(4) << "Merge the scales of " << inner->inputs[0]->id << " into " << instr->outputs[0]->id;
+          MakeScale(&instr, inner->inputs[0], s1 * s2, b);
+          return true;
+        }
+      }
+
+      if (instr->op_type == "reshape" && instr->inputs.size() == 1U && is_folded(instr->inputs[0]->id)) {
+        auto& inner = instrs[producer.at(instr->inputs[0]->id)];
+        auto shape  = GetAttr<std::vector<int>>(instr, "shape", {});
+        // the dimensions 0 copy those of the input, which the merge changes
+        if (inner->op_type == "reshape" && inner->inputs.size() == 1U &&
+            std::find(shape.begin(), shape.end(), 0) == shape.end()) {
+          VLOG(4) << "Merge the reshapes of " << inner->inputs[0]->id << " into " << instr->outputs[0]->id;
+          Variable input = inner->inputs[0];
+          instr          = Copy(instr);
+          instr->inputs  = {input};
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // Remove the instructions whose results are read before the rewrites but not after, return the number removed.
+  static int RemoveUnread(State* state) {
+    auto& instrs = *state->instrs;
+    auto readers = CountReaders(instrs);
+    std::vector<bool> removed(instrs.size());
+    int count = 0;
+    for (int i = instrs.size() - 1; i >= 0; i--) {
+      auto& outputs = instrs[i]->outputs;
+      bool unread   = !outputs.empty() && std::all_of(outputs.begin(), outputs.end(), [&](const Variable& var) {
+        return state->originally_read.count(var->id) && !readers[var->id] && !state->fetch_ids.count(var->id);
+      });
+      if (!unread) continue;
+      removed[i] = true;
+      count++;
+      for (auto& var : instrs[i]->inputs) readers[var->id]--;
+    }
+    std::vector<Instruction> result;
+    for (int i = 0; i < instrs.size(); i++) {
+      if (!removed[i]) result.push_back(instrs[i]);
+    }
+    instrs = std::move(result);
+    return count;
+  }
+};
+
+}  // namespace pass
+}  // namespace frontend
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(Canonicalization) {
+  CINN_REGISTER_PROGRAM_PASS(Canonicalization, ::cinn::frontend::pass::CanonicalizationPass);
+
+  return true;
+}
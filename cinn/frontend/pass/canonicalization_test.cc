@@ -0,0 +1,104 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "cinn/frontend/net_builder.h"
+#include "cinn/frontend/pass/test_helper.h"
+#include "cinn/frontend/pass/use_program_pass.h"
+#include "cinn/frontend/program_pass.h"
+#include "cinn/frontend/syntax.h"
+
+namespace cinn::frontend {
+
+TEST(Canonicalization, identities) {
+  NetBuilder builder("net_builder");
+  auto x    = builder.CreateInput(Float(32), {32, 16}, "X");
+  auto y    = builder.identity(x);
+  auto z    = builder.scale(y, 1.f, 0.f);
+  auto w    = builder.reshape(z, {32, 16});
+  auto out  = builder.relu(w);
+  auto prog = builder.Build();
+  ProgramPass::Apply(&prog, common::DefaultHostTarget(), {"Canonicalization"});
+
+  // relu reads the input directly
+  ASSERT_EQ(prog.size(), 1);
+  ASSERT_EQ(prog[0]->op_type, "relu");
+  ASSERT_EQ(prog[0]->inputs[0]->id, "X");
+  ASSERT_EQ(prog[0]->outputs[0]->id, out->id);
+}
+
+TEST(Canonicalization, merge_scales) {
+  NetBuilder builder("net_builder");
+  auto x    = builder.CreateInput(Float(32), {32, 16}, "X");
+  auto y    = builder.relu(x);
+  auto z    = builder.scale(y, 2.f, 1.f);
+  auto out  = builder.scale(z, 3.f, 0.5f);
+  auto prog = builder.Build();
+  ProgramPass::Apply(&prog, common::DefaultHostTarget(), {"Canonicalization"});
+
+  // 3 * (2 * y + 1) + 0.5 = 6 * y + 3.5
+  ASSERT_EQ(prog.size(), 2);
+  ASSERT_EQ(CountInstrs(prog, "scale"), 1);
+  auto& scale = prog[1];
+  ASSERT_EQ(scale->inputs[0]->id, y->id);
+  ASSERT_EQ(scale->outputs[0]->id, out->id);
+  ASSERT_FLOAT_EQ(absl::get<float>(scale->attrs.at("scale")), 6.f);
+  ASSERT_FLOAT_EQ(absl::get<float>(scale->attrs.at("bias")), 3.5f);
+}
+
+// x + 0 is folded and x * 2 is a scale, the constants are removed once unread
+TEST(Canonicalization, constants) {
+  Placeholder x(Float(32), {32, 16}, "X");
+  Program prog;
+  auto zero = prog.fill_constant<float>({1}, 0.f, "", false, "zero");
+  auto two  = prog.fill_constant<float>({1}, 2.f, "", false, "two");
+  auto y    = prog.relu(x);
+  auto z    = prog.elementwise_add(y, zero);
+  auto out  = prog.elementwise_mul(z, two);
+  for (auto var : {zero, two, y, z, out}) var->type = Float(32);
+  for (auto var : {y, z, out}) var->shape = {32, 16};
+  zero->shape = two->shape = {1};
+  prog.SetInputs({x});
+  ProgramPass::Apply(&prog, {out->id}, common::DefaultHostTarget(), {"Canonicalization"});
+
+  ASSERT_EQ(prog.size(), 2);
+  ASSERT_EQ(prog[0]->op_type, "relu");
+  ASSERT_EQ(prog[1]->op_type, "scale");
+  ASSERT_EQ(prog[1]->inputs[0]->id, y->id);
+  ASSERT_EQ(prog[1]->outputs[0]->id, out->id);
+  ASSERT_FLOAT_EQ(absl::get<float>(prog[1]->attrs.at("scale")), 2.f);
+  ASSERT_FLOAT_EQ(absl::get<float>(prog[1]->attrs.at("bias")), 0.f);
+}
+
+// the fetched identity is written by the producer of its input
+TEST(Canonicalization, fetched_identity) {
+  NetBuilder builder("net_builder");
+  auto x    = builder.CreateInput(Float(32), {32, 16}, "X");
+  auto y    = builder.relu(x);
+  auto out  = builder.identity(y);
+  auto prog = builder.Build();
+  ProgramPass::Apply(&prog, {y->id, out->id}, common::DefaultHostTarget(), {"Canonicalization"});
+  // y is fetched as well, so the identity is kept
+  ASSERT_EQ(prog.size(), 2);
+
+  ProgramPass::Apply(&prog, {out->id}, common::DefaultHostTarget(), {"Canonicalization"});
+  ASSERT_EQ(prog.size(), 1);
+  ASSERT_EQ(prog[0]->op_type, "relu");
+  ASSERT_EQ(prog[0]->outputs[0]->id, out->id);
+}
+
+}  // namespace cinn::frontend
@@ -0,0 +1,173 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cinn/frontend/program_pass.h"
+#include "cinn/hlir/framework/op.h"
+
+DEFINE_int64(cinn_rematerialization_budget,
+             0,
+             "The max bytes of the forward activations kept alive until their backward readers by the "
+             "Rematerialization pass, the cheap ones beyond it are recomputed in the backward region, 0 to recompute "
+             "all of them.");
+
+namespace cinn {
+namespace frontend {
+namespace pass {
+
+/**
+ * The training programs keep the forward activations read by the gradient ops alive through the backward region. When
+ * they take more memory than the budget, the elementwise and broadcast activations are recomputed instead: their
+ * producers are cloned right before each backward reader, so that the clones are fused into the readers and the
+ * original activations die in the forward region. The inputs of a clone are kept alive in turn, so an activation is
+ * only recomputed when it saves more memory than the inputs it keeps. It should be applied before the Decomposer.
+ */
+class RematerializationPass : public ProgramPass {
+ public:
+  using ProgramPass::ProgramPass;
+
+  void ApplyImpl(Program* prog, const common::Target& target) const {
+    std::vector<Instruction> instrs;
+    for (size_t i = 0; i < prog->size(); i++) instrs.push_back((*prog)[i]);
+
+    std::unordered_set<std::string> recomputed_vars;
+    while (RecomputeOne(&instrs, &recomputed_vars)) {
+    }
+    if (recomputed_vars.empty()) return;
+
+    std::vector<Variable> inputs = prog->GetInputs();
+    *prog                        = Program(std::move(instrs), std::move(inputs));
+    VLOG(3) << "Rematerialization recomputes " << recomputed_vars.size() << " activations in the backward region";
+  }
+
+ private:
+  static bool IsGradOp(const Instruction& instr) {
+    const std::string& op_type = instr->op_type;
+    return op_type.size() > 5 && op_type.compare(op_type.size() - 5, 5, "_grad") == 0;
+  }
+
+  static bool IsCheap(const Instruction& instr) {
+    static auto& op_pattern_dict = hlir::framework::Operator::GetAttrs<hlir::framework::OpPatternKind>("OpPattern");
+    auto* op = hlir::framework::OpRegistry::Global()->Find(instr->op_type);
+    return op && instr->outputs.size() == 1 &&
+           op_pattern_dict.Get(op, hlir::framework::kOpaque) <= hlir::framework::kBroadcast;
+  }
+
+  static int64_t Bytes(const Variable& var) {
+    int64_t numel = 1;
+    for (int dim : var->shape) numel *= dim;
+    return numel * std::max(var->type.bits() / 8, 1);
+  }
+
+  // Recompute the activation saving the most memory if the saved ones exceed the budget, return false if none is done.
+  // The outputs of the clones are recorded in \p recomputed_vars.
+  static bool RecomputeOne(std::vector<Instruction>* instrs, std::unordered_set<std::string>* recomputed_vars) {
+    // the backward region is the gradient ops, the clones and all the instructions reading their results
+    std::vector<bool> is_backward(instrs->size());
+    std::unordered_set<std::string> backward_vars;
+    absl::flat_hash_map<std::string, int> producer;
+    for (int i = 0; i < instrs->size(); i++) {
+      auto& instr = (*instrs)[i];
+      is_backward[i] = IsGradOp(instr) || (!instr->outputs.empty() && recomputed_vars->count(instr->outputs[0]->id)) ||
+                       std::any_of(instr->inputs.begin(), instr->inputs.end(), [&](const Variable& var) {
+                         return backward_vars.count(var->id);
+                       });
+      for (auto& var : instr->outputs) {
+        producer[var->id] = i;
+        if (is_backward[i]) backward_vars.insert(var->id);
+      }
+    }
+
+    // the forward activations read by the backward region are saved until then
+    std::unordered_set<std::string> saved, forward_read;
+    int64_t saved_bytes = 0;
+    for (int i = 0; i < instrs->size(); i++) {
+      for (auto& var : (*instrs)[i]->inputs) {
+        auto it = producer.find(var->id);
+        if (it == producer.end() || is_backward[it->second]) continue;
+        if (!is_backward[i]) {
+          forward_read.insert(var->id);
+        } else if (saved.insert(var->id).second) {
+          saved_bytes += Bytes(var);
+        }
+      }
+    }
+    if (saved_bytes <= FLAGS_cinn_rematerialization_budget) return false;
+
+    // The activation with no forward reader can't die earlier, and the forward activations read by a clone are kept
+    // alive to the backward region, which costs their memory unless they are saved already.
+    std::string best;
+    int64_t best_gain = 0;
+    for (int i = 0; i < instrs->size(); i++) {
+      auto& instr = (*instrs)[i];
+      if (is_backward[i] || !IsCheap(instr)) continue;
+      auto& id = instr->outputs[0]->id;
+      if (!saved.count(id) || !forward_read.count(id)) continue;
+      int64_t gain = Bytes(instr->outputs[0]);
+      std::unordered_set<std::string> kept;
+      for (auto& var : instr->inputs) {
+        if (producer.count(var->id) && !saved.count(var->id) && kept.insert(var->id).second) {
+          gain -= Bytes(var);
+        }
+      }
+      if (gain > best_gain) {
+        best      = id;
+        best_gain = gain;
+      }
+    }
+    if (best.empty()) return false;
+
+    // clone the producer right before each backward reader, so that each clone has one reader to be fused into
+    auto& origin = (*instrs)[producer.at(best)];
+    std::vector<Instruction> result;
+    for (int i = 0; i < instrs->size(); i++) {
+      auto& instr  = (*instrs)[i];
+      auto& inputs = instr->inputs;
+      if (is_backward[i] &&
+          std::any_of(inputs.begin(), inputs.end(), [&](const Variable& var) { return var->id == best; })) {
+        Instruction clone(origin->op_type, origin->inputs);
+        clone->attrs         = origin->attrs;
+        clone->attrs_ordered = origin->attrs_ordered;
+        auto& out            = clone->outputs[0];
+        out->type            = origin->outputs[0]->type;
+        out->shape           = origin->outputs[0]->shape;
+        recomputed_vars->insert(out->id);
+        VLOG(4) << "Recompute " << best << " as " << out->id << " for " << instr->op_type;
+        for (auto& var : inputs) {
+          if (var->id == best) var = out;
+        }
+        result.push_back(clone);
+      }
+      result.push_back(instr);
+    }
+    *instrs = std::move(result);
+    return true;
+  }
+};
+
+}  // namespace pass
+}  // namespace frontend
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(Rematerialization) {
+  CINN_REGISTER_PROGRAM_PASS(Rematerialization, ::cinn::frontend::pass::RematerializationPass);
+
+  return true;
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+#include "cinn/frontend/decomposer/use_decomposer.h"
+#include "cinn/frontend/net_builder.h"
+#include "cinn/frontend/pass/test_helper.h"
+#include "cinn/frontend/pass/use_program_pass.h"
+#include "cinn/frontend/program_pass.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/framework/tensor.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+DECLARE_int64(cinn_rematerialization_budget);
+
+namespace cinn::frontend {
+
+int FindInstr(const Program& prog, const std::string& op_type) {
+  for (int i = 0; i < prog.size(); i++) {
+    if (prog[i]->op_type == op_type) return i;
+  }
+  return -1;
+}
+
+// y = relu(x), out = y + w, dx = relu_grad(dout, y)
+Program CreateReluProgram(bool relu_of_intermediate) {
+  NetBuilder builder("net_builder");
+  auto x    = builder.CreateInput(Float(32), {32, 16}, "X");
+  auto w    = builder.CreateInput(Float(32), {32, 16}, "W");
+  auto dout = builder.CreateInput(Float(32), {32, 16}, "Dout");
+  auto y    = builder.relu(relu_of_intermediate ? builder.add(x, w) : Variable(x));
+  builder.add(y, w);
+  builder.relu_grad(dout, y);
+  return builder.Build();
+}
+
+// Decompose and run the program on X86, the inputs are filled by the same random values, and return dx. The
+// Decomposer shares the instructions left as they are, so the program should not be used again.
+std::vector<float> RunProgram(Program prog) {
+  Target target = common::DefaultHostTarget();
+  ProgramPass::Apply(&prog, target, {"Decomposer"});
+  auto graph = std::make_shared<hlir::framework::Graph>(prog, target);
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  auto scope = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  for (auto name : {"X", "W", "Dout"}) {
+    auto tensor = scope->GetTensor(name);
+    auto* data  = tensor->mutable_data<float>(target);
+    for (int i = 0; i < tensor->shape().numel(); i++) data[i] = dist(rng);
+  }
+  runtime_program->Execute();
+  auto dx    = scope->GetTensor(prog[prog.size() - 1]->outputs[0]->id);
+  auto* data = dx->data<float>();
+  return std::vector<float>(data, data + dx->shape().numel());
+}
+
+TEST(Rematerialization, relu) {
+  auto expected = RunProgram(CreateReluProgram(false));
+  auto prog     = CreateReluProgram(false);
+  Target target = common::DefaultHostTarget();
+  ProgramPass::Apply(&prog, target, {"Rematerialization"});
+
+  // relu of the input is recomputed right before relu_grad
+  ASSERT_EQ(CountInstrs(prog, "relu"), 2);
+  int grad = FindInstr(prog, "relu_grad");
+  ASSERT_EQ(prog[grad - 1]->op_type, "relu");
+  ASSERT_EQ(prog[grad]->inputs[1]->id, prog[grad - 1]->outputs[0]->id);
+  ASSERT_EQ(prog[grad - 1]->inputs[0]->id, "X");
+
+  auto res = RunProgram(prog);
+  ASSERT_EQ(res.size(), expected.size());
+  for (int i = 0; i < res.size(); i++) ASSERT_FLOAT_EQ(res[i], expected[i]);
+}
+
+// relu of an intermediate would keep the intermediate alive instead, which saves nothing
+TEST(Rematerialization, no_gain) {
+  auto prog = CreateReluProgram(true);
+  ProgramPass::Apply(&prog, common::DefaultHostTarget(), {"Rematerialization"});
+  ASSERT_EQ(CountInstrs(prog, "relu"), 1);
+}
+
+// nothing is recomputed when the saved activations fit in the budget
+TEST(Rematerialization, budget) {
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  auto prog                           = CreateReluProgram(false);
+  FLAGS_cinn_rematerialization_budget = 32 * 16 * sizeof(float);
+  ProgramPass::Apply(&prog, common::DefaultHostTarget(), {"Rematerialization"});
+  ASSERT_EQ(CountInstrs(prog, "relu"), 1);
+}
+
+}  // namespace cinn::frontend
@@ -0,0 +1,30 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "cinn/frontend/syntax.h"
+
+namespace cinn::frontend {
+
+//! The number of the instructions of \p op_type in the program.
+inline int CountInstrs(const Program& prog, const std::string& op_type) {
+  int count = 0;
+  for (int i = 0; i < prog.size(); i++) count += prog[i]->op_type == op_type;
+  return count;
+}
+
+}  // namespace cinn::frontend
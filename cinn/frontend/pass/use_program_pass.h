@@ -16,4 +16,6 @@
 
 #include "cinn/common/macros.h"
 
+CINN_USE_REGISTER(Canonicalization)
 CINN_USE_REGISTER(Decomposer)
+CINN_USE_REGISTER(Rematerialization)
@@ -14,17 +14,27 @@
 
 #include "cinn/frontend/program_pass.h"
 
+#include "cinn/utils/compile_tracer.h"
+
 namespace cinn {
 namespace frontend {
 
 void ProgramPass::Apply(Program* prog, const common::Target& target, const std::vector<std::string>& passes) {
+  Apply(prog, {}, target, passes);
+}
+
+void ProgramPass::Apply(Program* prog,
+                        const std::unordered_set<std::string>& fetch_ids,
+                        const common::Target& target,
+                        const std::vector<std::string>& passes) {
   std::vector<const ProgramPass*> fpass;
   for (auto& name : passes) {
     auto pass = ProgramPassRegistry::Global()->Get(name);
     fpass.push_back(pass);
   }
-  for (auto& pass : fpass) {
-    pass->ApplyImpl(prog, target);
+  for (int i = 0; i < fpass.size(); i++) {
+    utils::CompileStageTimer timer("pass:" + passes[i]);
+    fpass[i]->ApplyImpl(prog, fetch_ids, target);
   }
 }
 
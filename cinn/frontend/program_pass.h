@@ -17,6 +17,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "cinn/frontend/syntax.h"
@@ -36,7 +37,20 @@ class ProgramPass {
    * @return The program after being modified by the passes.
    */
   static void Apply(Program* prog, const common::Target& target, const std::vector<std::string>& passes);
+  /**
+   * \brief Apply a sequence of passes on a program whose variables \p fetch_ids are fetched, which the passes keep.
+   * Without them, the passes removing the variables take those read by no instruction as the fetched ones.
+   */
+  static void Apply(Program* prog,
+                    const std::unordered_set<std::string>& fetch_ids,
+                    const common::Target& target,
+                    const std::vector<std::string>& passes);
   virtual void ApplyImpl(Program* prog, const common::Target& target) const {}
+  virtual void ApplyImpl(Program* prog,
+                         const std::unordered_set<std::string>& fetch_ids,
+                         const common::Target& target) const {
+    ApplyImpl(prog, target);
+  }
 
   const std::string& name() { return name_; }
 
@@ -0,0 +1,203 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/frontend/request_batcher.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace cinn::frontend {
+
+namespace {
+
+constexpr size_t kAlignment = 64;
+
+// The memory of the variables of a batch, the buffers refer to its ranges.
+struct BatchMemory {
+  std::vector<cinn_buffer_t> inputs;
+  std::map<std::string, cinn_buffer_t> outputs;
+  uint8_t* memory{};
+
+  ~BatchMemory() { std::free(memory); }
+};
+
+size_t AlignUp(size_t x) { return (x + kAlignment - 1) / kAlignment * kAlignment; }
+
+// The buffer of \p tensor without its memory, sized to the elements exactly.
+cinn_buffer_t BufferTemplate(hlir::framework::Tensor tensor) {
+  cinn_buffer_t buffer = *tensor->buffer();
+  buffer.memory        = nullptr;
+  buffer.memory_size   = tensor->num_bytes();
+  return buffer;
+}
+
+}  // namespace
+
+RequestBatcher::RequestBatcher(Interpreter* interpreter,
+                               const std::vector<hlir::framework::shape_t>& sample_shapes,
+                               const std::vector<std::string>& output_names,
+                               const Options& options)
+    : interpreter_(interpreter), options_(options), output_names_(output_names), sample_shapes_(sample_shapes) {
+  CHECK(interpreter_);
+  CHECK(!options_.batch_sizes.empty());
+  CHECK_EQ(sample_shapes.size(), interpreter_->input_names().size());
+  std::sort(options_.batch_sizes.begin(), options_.batch_sizes.end());
+  for (int batch_size : options_.batch_sizes) {
+    CHECK_GT(batch_size, 0);
+    std::vector<hlir::framework::shape_t> shapes;
+    for (auto& sample_shape : sample_shapes) {
+      shapes.push_back({batch_size});
+      shapes.back().insert(shapes.back().end(), sample_shape.begin(), sample_shape.end());
+    }
+    // compile the program of the bucket, whose variables are the templates of the buffers bound
+    CHECK(interpreter_->SetInputShapes(shapes) == shapes)
+        << "The shape bucket policy of the interpreter should keep the batch size " << batch_size;
+    Bucket bucket;
+    bucket.batch_size = batch_size;
+    for (auto& name : interpreter_->input_names()) {
+      bucket.inputs.push_back(BufferTemplate(interpreter_->GetTensor(name)));
+    }
+    for (auto& name : output_names_) {
+      auto tensor = interpreter_->GetTensor(name);
+      auto& shape = tensor->shape().data();
+      CHECK(!shape.empty() && shape[0] == batch_size) << "The output [" << name << "] should be batched";
+      bucket.outputs[name]        = BufferTemplate(tensor);
+      sample_output_shapes_[name] = hlir::framework::shape_t(shape.begin() + 1, shape.end());
+    }
+    buckets_.push_back(std::move(bucket));
+  }
+  worker_ = std::thread([this] { WorkerLoop(); });
+}
+
+RequestBatcher::~RequestBatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  worker_.join();
+}
+
+std::future<RequestBatcher::Response> RequestBatcher::Submit(std::vector<const void*> inputs) {
+  CHECK_EQ(inputs.size(), interpreter_->input_names().size());
+  Request request;
+  request.inputs   = std::move(inputs);
+  request.deadline = std::chrono::steady_clock::now() + options_.max_delay;
+  auto future      = request.promise.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CHECK(!stop_) << "The batcher is stopped";
+    queue_.push_back(std::move(request));
+  }
+  cond_.notify_all();
+  return future;
+}
+
+const hlir::framework::shape_t& RequestBatcher::sample_output_shape(const std::string& name) const {
+  auto it = sample_output_shapes_.find(name);
+  CHECK(it != sample_output_shapes_.end()) << "The output [" << name << "] is not fetched";
+  return it->second;
+}
+
+size_t RequestBatcher::num_batches() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_batches_;
+}
+
+void RequestBatcher::WorkerLoop() {
+  size_t max_batch_size = buckets_.back().batch_size;
+  while (true) {
+    std::vector<Request> requests;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+      // the queued requests are all run before stopping
+      if (queue_.empty()) return;
+      auto deadline = queue_.front().deadline;
+      cond_.wait_until(lock, deadline, [&] { return stop_ || queue_.size() >= max_batch_size; });
+      size_t num_requests = std::min(queue_.size(), max_batch_size);
+      for (size_t i = 0; i < num_requests; i++) {
+        requests.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+      num_batches_++;
+    }
+    RunBatch(std::move(requests));
+  }
+}
+
+void RequestBatcher::RunBatch(std::vector<Request> requests) {
+  auto& bucket = *std::find_if(
+      buckets_.begin(), buckets_.end(), [&](const Bucket& x) { return x.batch_size >= requests.size(); });
+  VLOG(3) << "Run " << requests.size() << " requests in the bucket of batch " << bucket.batch_size;
+  if (options_.profile) {
+    // the shapes the requests would be fed in without the buckets
+    for (int i = 0; i < sample_shapes_.size(); i++) {
+      hlir::framework::shape_t shape{static_cast<int>(requests.size())};
+      shape.insert(shape.end(), sample_shapes_[i].begin(), sample_shapes_[i].end());
+      options_.profile->RecordInputShape(interpreter_->input_names()[i], shape);
+    }
+  }
+
+  // all the variables of the batch are in a single allocation
+  auto batch     = std::make_shared<BatchMemory>();
+  batch->inputs  = bucket.inputs;
+  batch->outputs = bucket.outputs;
+  size_t size    = 0;
+  std::vector<size_t> offsets;
+  for (auto& buffer : batch->inputs) {
+    offsets.push_back(size);
+    size += AlignUp(buffer.memory_size);
+  }
+  for (auto& item : batch->outputs) {
+    offsets.push_back(size);
+    size += AlignUp(item.second.memory_size);
+  }
+  batch->memory = static_cast<uint8_t*>(std::aligned_alloc(kAlignment, std::max(size, kAlignment)));
+  CHECK(batch->memory) << "Failed to allocate " << size << " bytes for the batch";
+
+  std::vector<cinn_buffer_t*> inputs;
+  for (int i = 0; i < batch->inputs.size(); i++) {
+    auto& buffer     = batch->inputs[i];
+    buffer.memory    = batch->memory + offsets[i];
+    size_t row_bytes = buffer.memory_size / bucket.batch_size;
+    for (int r = 0; r < requests.size(); r++) {
+      std::memcpy(buffer.memory + r * row_bytes, requests[r].inputs[i], row_bytes);
+    }
+    std::memset(buffer.memory + requests.size() * row_bytes, 0, buffer.memory_size - requests.size() * row_bytes);
+    inputs.push_back(&buffer);
+  }
+  std::map<std::string, cinn_buffer_t*> outputs;
+  int k = batch->inputs.size();
+  for (auto& item : batch->outputs) {
+    item.second.memory   = batch->memory + offsets[k++];
+    outputs[item.first] = &item.second;
+  }
+
+  interpreter_->RunBound(inputs, outputs);
+
+  for (int r = 0; r < requests.size(); r++) {
+    Response response;
+    response.batch_size = bucket.batch_size;
+    response.batch      = batch;
+    for (auto& item : batch->outputs) {
+      response.outputs[item.first] = item.second.memory + r * (item.second.memory_size / bucket.batch_size);
+    }
+    requests[r].promise.set_value(std::move(response));
+  }
+}
+
+}  // namespace cinn::frontend
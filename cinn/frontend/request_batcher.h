@@ -0,0 +1,132 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cinn/frontend/interpreter.h"
+#include "cinn/hlir/framework/execution_profile.h"
+
+namespace cinn {
+namespace frontend {
+
+/**
+ * Coalesce the single requests to a model into batches of the shape buckets compiled by an Interpreter. Each request
+ * is queued with a deadline of its arrival plus the max delay, and a batch is run once the largest bucket is full or
+ * the oldest request reaches its deadline. The batch takes the smallest bucket holding all the requests queued, their
+ * inputs are gathered into the rows of the bucket inputs with the rest padded by zeros, and the program runs on the
+ * buffers bound by Interpreter::RunBound. The outputs are not scattered by copies, each request gets its rows of the
+ * batch outputs, which are kept alive by its response.
+ *
+ * The first dimension of the inputs and outputs is the batch, and the programs of all the buckets are compiled in the
+ * constructor. It binds the host buffers, so the interpreter should be for the X86 target.
+ */
+class RequestBatcher {
+ public:
+  struct Options {
+    //! The batch sizes of the buckets to run.
+    std::vector<int> batch_sizes{1, 2, 4, 8, 16};
+    //! The longest time a request waits for the others to join its batch.
+    std::chrono::microseconds max_delay{2000};
+    //! The profile to record the shape of each batch of the requests to, so that the batch sizes of the real traffic
+    //! tell the buckets to compile, see ExecutionProfile::ChooseBatchBuckets. It should outlive the batcher.
+    hlir::framework::ExecutionProfile* profile{};
+  };
+
+  struct Response {
+    //! The data of the outputs of the request by their names, each a sample of the batch output.
+    std::map<std::string, const void*> outputs;
+    //! The batch size of the bucket the request ran in.
+    int batch_size{};
+    //! Keep the buffers of the batch alive while the outputs are used.
+    std::shared_ptr<const void> batch;
+  };
+
+  /**
+   * @param interpreter The interpreter with the model loaded, which should outlive the batcher.
+   * @param sample_shapes The shapes of the inputs of a single request without the batch dimension, in the order of
+   * the input names of the interpreter.
+   * @param output_names The names of the outputs to fetch.
+   */
+  RequestBatcher(Interpreter* interpreter,
+                 const std::vector<hlir::framework::shape_t>& sample_shapes,
+                 const std::vector<std::string>& output_names,
+                 const Options& options);
+  RequestBatcher(Interpreter* interpreter,
+                 const std::vector<hlir::framework::shape_t>& sample_shapes,
+                 const std::vector<std::string>& output_names)
+      : RequestBatcher(interpreter, sample_shapes, output_names, Options()) {}
+
+  //! Run the requests queued and stop.
+  ~RequestBatcher();
+
+  /**
+   * Queue a request of a single sample, the data of \p inputs are copied into its batch, so they should be kept alive
+   * until the returned future is ready.
+   */
+  std::future<Response> Submit(std::vector<const void*> inputs);
+
+  //! The shape of the output \p name of a single request without the batch dimension.
+  const hlir::framework::shape_t& sample_output_shape(const std::string& name) const;
+
+  //! Get the number of the batches run.
+  size_t num_batches() const;
+
+ private:
+  // The buffers of the variables of a bucket, the memory is allocated for each batch.
+  struct Bucket {
+    int batch_size{};
+    std::vector<cinn_buffer_t> inputs;
+    std::map<std::string, cinn_buffer_t> outputs;
+  };
+
+  struct Request {
+    std::vector<const void*> inputs;
+    std::chrono::steady_clock::time_point deadline;
+    std::promise<Response> promise;
+  };
+
+  void WorkerLoop();
+
+  // Run the requests in the smallest bucket holding them.
+  void RunBatch(std::vector<Request> requests);
+
+  Interpreter* interpreter_;
+  Options options_;
+  std::vector<std::string> output_names_;
+  std::vector<hlir::framework::shape_t> sample_shapes_;
+  std::map<std::string, hlir::framework::shape_t> sample_output_shapes_;
+  // The buckets in the ascending order of the batch sizes.
+  std::vector<Bucket> buckets_;
+
+  std::deque<Request> queue_;
+  size_t num_batches_{};
+  mutable std::mutex mutex_;
+  std::condition_variable cond_;
+  bool stop_{false};
+  std::thread worker_;
+};
+
+}  // namespace frontend
+}  // namespace cinn
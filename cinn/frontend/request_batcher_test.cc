@@ -0,0 +1,91 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/frontend/request_batcher.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <thread>
+
+#include "cinn/runtime/use_extern_funcs.h"
+
+DEFINE_string(model_dir, "", "");
+
+namespace cinn::frontend {
+
+TEST(RequestBatcher, coalesce) {
+  Interpreter executor({"A"}, {{1, 30}});
+  executor.LoadPaddleModel(FLAGS_model_dir, common::DefaultHostTarget());
+  const int num_requests = 16;
+  std::vector<std::vector<float>> inputs(num_requests, std::vector<float>(30));
+  std::vector<std::vector<float>> expected(num_requests);
+  for (int r = 0; r < num_requests; r++) {
+    for (int i = 0; i < 30; i++) inputs[r][i] = (r + 1) * 0.01f * i;
+    expected[r].resize(executor.GetTensor("fc_0.tmp_2")->shape().numel());
+    executor.Run({inputs[r].data()}, {{1, 30}}, {{"fc_0.tmp_2", expected[r].data()}});
+  }
+
+  RequestBatcher::Options options;
+  options.max_delay = std::chrono::seconds(10);
+  RequestBatcher batcher(&executor, {{30}}, {"fc_0.tmp_2"}, options);
+  ASSERT_EQ(executor.num_compiled_programs(), 5UL);
+  auto& out_shape = batcher.sample_output_shape("fc_0.tmp_2");
+  ASSERT_EQ(out_shape.size(), 1UL);
+  ASSERT_EQ(out_shape[0], expected[0].size());
+
+  auto check = [&](int r, const RequestBatcher::Response& response) {
+    auto* out = static_cast<const float*>(response.outputs.at("fc_0.tmp_2"));
+    for (int i = 0; i < expected[r].size(); i++) ASSERT_NEAR(out[i], expected[r][i], 1e-5) << "request " << r;
+  };
+
+  // the full bucket runs at once without waiting for the deadline
+  std::vector<std::future<RequestBatcher::Response>> futures(num_requests);
+  std::vector<std::thread> threads;
+  for (int r = 0; r < num_requests; r++) {
+    threads.emplace_back([&, r] { futures[r] = batcher.Submit({inputs[r].data()}); });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int r = 0; r < num_requests; r++) {
+    auto response = futures[r].get();
+    ASSERT_EQ(response.batch_size, 16);
+    check(r, response);
+  }
+  ASSERT_EQ(batcher.num_batches(), 1UL);
+}
+
+TEST(RequestBatcher, deadline) {
+  Interpreter executor({"A"}, {{1, 30}});
+  executor.LoadPaddleModel(FLAGS_model_dir, common::DefaultHostTarget());
+  std::vector<float> a(30);
+  for (int i = 0; i < a.size(); i++) a[i] = i * 0.1f;
+  std::vector<float> expected(executor.GetTensor("fc_0.tmp_2")->shape().numel());
+  executor.Run({a.data()}, {{1, 30}}, {{"fc_0.tmp_2", expected.data()}});
+
+  RequestBatcher::Options options;
+  options.max_delay = std::chrono::milliseconds(20);
+  RequestBatcher batcher(&executor, {{30}}, {"fc_0.tmp_2"}, options);
+  // 3 requests are padded to the bucket of 4 once the first one reaches its deadline
+  std::vector<std::future<RequestBatcher::Response>> futures;
+  for (int r = 0; r < 3; r++) futures.push_back(batcher.Submit({a.data()}));
+  for (auto& future : futures) {
+    auto response = future.get();
+    ASSERT_EQ(response.batch_size, 4);
+    auto* out = static_cast<const float*>(response.outputs.at("fc_0.tmp_2"));
+    for (int i = 0; i < expected.size(); i++) ASSERT_NEAR(out[i], expected[i], 1e-5);
+  }
+  ASSERT_EQ(batcher.num_batches(), 1UL);
+}
+
+}  // namespace cinn::frontend
@@ -0,0 +1,414 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/auto_tuner.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <unordered_set>
+
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pe/nn.h"
+#include "cinn/hlir/pe/schedule.h"
+#include "cinn/utils/timer.h"
+
+#ifdef CINN_WITH_CUDA
+#include "cinn/backends/cuda_util.h"
+#endif
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+
+std::vector<int> Divisors(int n, int max_divisor) {
+  std::vector<int> res;
+  for (int i = 1; i <= std::min(n, max_divisor); i++) {
+    if (n % i == 0) res.push_back(i);
+  }
+  return res;
+}
+
+template <typename T>
+T GetAttr(const absl::flat_hash_map<std::string, frontend::Program::attr_t>& attrs,
+          const std::string& name,
+          const T& default_value) {
+  auto it = attrs.find(name);
+  return it == attrs.end() ? default_value : absl::get<T>(it->second);
+}
+
+}  // namespace
+
+AutoTuner::AutoTuner(const common::Target& target, const Options& options) : target_(target), options_(options) {
+  CHECK(target_.is_cpu() || target_.arch == common::Target::Arch::NVGPU)
+      << "AutoTuner only tunes the CPU convs and the NVGPU kernels now";
+  options_.log_file = target_.is_cpu() ? pe::GetTuningLogPath(options_.log_file)
+                                       : pe::GetCudaTuningLogPath(options_.log_file);
+  if (!options_.log_file.empty() && std::ifstream(options_.log_file).good()) {
+    pe::LoadSerialData(&log_params_, options_.log_file);
+  }
+}
+
+int AutoTuner::Tune(const frontend::Program& program) {
+  if (target_.arch == common::Target::Arch::NVGPU) return TuneCudaLaunch(program);
+  auto graph = std::make_shared<Graph>(program, target_);
+  ApplyPass(graph.get(), "InferShape");
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+
+  // the conv instances of each key in the order they appear, with the time of their groups in the profile
+  struct ConvInstance {
+    std::string key;
+    Node* node;
+    double time_us;
+  };
+  std::vector<ConvInstance> instances;
+  absl::flat_hash_map<std::string, int> instance_index;
+  auto store_nodes = std::get<0>(graph->topological_order());
+  for (auto* graph_node : store_nodes) {
+    auto* node = graph_node->safe_as<Node>();
+    if (!node || node->op()->name != "conv2d") continue;
+    auto& attrs = node->attrs.attr_store;
+    // only the NCHW forward convs without groups are scheduled by the params
+    if (GetAttr<int>(attrs, "groups", 1) != 1 || GetAttr<std::string>(attrs, "data_format", "NCHW") != "NCHW" ||
+        GetAttr<std::string>(attrs, "conv_type", "forward") != "forward") {
+      continue;
+    }
+    auto& inlinks = node->inlinks_in_order(true);
+    CHECK_EQ(inlinks.size(), 2U) << "conv2d should have 2 inputs";
+    auto& input_shape  = shape_dict.at(inlinks[0]->source()->id());
+    auto& weight_shape = shape_dict.at(inlinks[1]->source()->id());
+    auto& output_shape = shape_dict.at(node->outlinks_in_order(true)[0]->sink()->id());
+    // the same key as AlterLayout generates for the conv
+    std::string key = pe::GenerateX86ConvKey(input_shape,
+                                             weight_shape,
+                                             GetAttr<std::vector<int>>(attrs, "stride", {1, 1}),
+                                             GetAttr<std::vector<int>>(attrs, "padding", {0, 0}),
+                                             GetAttr<std::vector<int>>(attrs, "dilation", {1, 1}));
+    double time_us = 0.;
+    if (options_.profile) {
+      time_us = options_.profile->TotalTime(node->id());
+      if (time_us == 0.) time_us = options_.profile->TotalTime(node->outlinks_in_order(true)[0]->sink()->id());
+    }
+    auto it = instance_index.find(key);
+    if (it != instance_index.end()) {
+      instances[it->second].time_us += time_us;
+      continue;
+    }
+    // the Winograd convs are not scheduled by the params
+    if (pe::GetConv2dWinogradTile(input_shape,
+                                  weight_shape,
+                                  GetAttr<std::vector<int>>(attrs, "padding", {0, 0}),
+                                  GetAttr<std::vector<int>>(attrs, "stride", {1, 1}),
+                                  GetAttr<std::vector<int>>(attrs, "dilation", {1, 1}),
+                                  1) > 0) {
+      VLOG(3) << "Skip the Winograd conv " << key;
+      continue;
+    }
+    if (!options_.retune && log_params_.count(key)) {
+      VLOG(3) << "Skip the tuned conv " << key;
+      continue;
+    }
+    instance_index[key] = instances.size();
+    instances.push_back({key, node, time_us});
+  }
+  if (options_.profile) {
+    std::stable_sort(instances.begin(), instances.end(), [](const ConvInstance& a, const ConvInstance& b) {
+      return a.time_us > b.time_us;
+    });
+  }
+
+  int num_tuned = 0;
+  for (auto& instance : instances) {
+    if (options_.max_tuned > 0 && num_tuned >= options_.max_tuned) break;
+    if (options_.profile && instance.time_us == 0.) {
+      VLOG(3) << "Skip the conv " << instance.key << " not run in the profile";
+      continue;
+    }
+    auto* node         = instance.node;
+    auto& inlinks      = node->inlinks_in_order(true);
+    auto& input_shape  = shape_dict.at(inlinks[0]->source()->id());
+    auto& weight_shape = shape_dict.at(inlinks[1]->source()->id());
+    auto& output_shape = shape_dict.at(node->outlinks_in_order(true)[0]->sink()->id());
+    VLOG(3) << "Tune the conv " << instance.key << " taking " << instance.time_us << " us in the profile";
+    TuneConv2d(instance.key, input_shape, weight_shape, output_shape, node->attrs.attr_store);
+    num_tuned++;
+  }
+
+  if (num_tuned && !options_.log_file.empty()) pe::SaveSerialData(log_params_, options_.log_file);
+  return num_tuned;
+}
+
+void AutoTuner::TuneConv2d(const std::string& key,
+                           const std::vector<int>& input_shape,
+                           const std::vector<int>& weight_shape,
+                           const std::vector<int>& output_shape,
+                           const absl::flat_hash_map<std::string, frontend::Program::attr_t>& attrs) {
+  frontend::Placeholder input(Float(32), input_shape, "tune_input");
+  frontend::Placeholder weight(Float(32), weight_shape, "tune_weight", true);
+  frontend::Program program;
+  program.conv2d(input, weight, attrs);
+  program.SetInputs({input, weight});
+  program.Validate();
+
+  auto& params    = pe::GetX86ConvParams();
+  auto candidates = GenerateCandidates(input_shape, weight_shape, output_shape);
+  // the params scheduling the conv now, from the static table or the heuristics, are measured first
+  if (params.count(key)) {
+    candidates.insert(candidates.begin(), params.at(key));
+    candidates.resize(std::min<int>(candidates.size(), std::max(options_.max_trials, 1)));
+  }
+
+  // the features are extracted from the lowered functions, which is much faster than compiling and measuring them
+  bool rank       = options_.cost_model && options_.cost_model->trained();
+  bool log_sample = !options_.sample_log.empty();
+  std::vector<std::vector<float>> features(candidates.size());
+  if (rank || log_sample) {
+    for (int i = 0; i < candidates.size(); i++) {
+      params[key] = candidates[i];
+      features[i] = ExtractFeatures(BuildGraph(program));
+    }
+  }
+  std::vector<int> order(candidates.size());
+  std::iota(order.begin(), order.end(), 0);
+  if (rank) {
+    std::vector<float> costs(candidates.size());
+    for (int i = 0; i < candidates.size(); i++) costs[i] = options_.cost_model->Predict(features[i]);
+    std::stable_sort(order.begin() + 1, order.end(), [&](int a, int b) { return costs[a] < costs[b]; });
+    order.resize(std::min<int>(order.size(), std::max(options_.num_measured, 1)));
+  }
+
+  std::ofstream samples;
+  if (log_sample) samples.open(options_.sample_log, std::ios::app);
+  Record record;
+  record.key          = key;
+  record.time_ms      = std::numeric_limits<float>::max();
+  record.num_measured = order.size();
+  for (int i : order) {
+    params[key] = candidates[i];
+    float time  = Measure(BuildGraph(program));
+    VLOG(3) << "Candidate " << i << " of " << key << " takes " << time << " ms";
+    if (i == 0) record.heuristic_time_ms = time;
+    if (time < record.time_ms) {
+      record.time_ms = time;
+      record.params  = candidates[i];
+    }
+    if (log_sample) {
+      samples << time;
+      for (float feature : features[i]) samples << " " << feature;
+      samples << "\n";
+    }
+  }
+  params[key]      = record.params;
+  log_params_[key] = record.params;
+  LOG(INFO) << "Tuned " << key << ": " << record.heuristic_time_ms << " ms -> " << record.time_ms << " ms";
+  records_.push_back(std::move(record));
+}
+
+std::vector<AutoTuner::Params> AutoTuner::GenerateCandidates(const std::vector<int>& input_shape,
+                                                             const std::vector<int>& weight_shape,
+                                                             const std::vector<int>& output_shape) const {
+  int ic       = input_shape[1];
+  int oc       = weight_shape[0];
+  int oh       = output_shape[2];
+  int ow       = output_shape[3];
+  bool is_1x1  = weight_shape[2] == 1 && weight_shape[3] == 1;
+  auto Blocked = [](int extent, int block) { return std::vector<int>({extent / block, block}); };
+
+  // the heuristics without the saved params
+  absl::flat_hash_map<std::string, int> factors;
+  pe::GetConv2dFactors(&factors, oc, ic, ic, is_1x1 ? oh : -1, ow, Float(32), target_, "", false);
+  Params heuristic = {{"ic_bn", Blocked(ic, factors["ic_bn"])},
+                      {"oc_bn", Blocked(oc, factors["oc_bn"])},
+                      {"ow_bn", Blocked(ow, factors["ow_bn"])},
+                      {"unroll_kw", {0}}};
+  if (is_1x1) heuristic["oh_bn"] = Blocked(oh, factors.count("oh_bn") ? factors["oh_bn"] : 1);
+
+  // the products of the blocks are kept in the registers, so the width blocks are at most 16
+  std::vector<Params> space;
+  for (int ic_bn : Divisors(ic, 64)) {
+    for (int oc_bn : Divisors(oc, 64)) {
+      for (int ow_bn : Divisors(ow, 16)) {
+        Params params = {{"ic_bn", Blocked(ic, ic_bn)}, {"oc_bn", Blocked(oc, oc_bn)}, {"ow_bn", Blocked(ow, ow_bn)}};
+        if (is_1x1) {
+          params["unroll_kw"] = {0};
+          for (int oh_bn : Divisors(oh, 16 / ow_bn)) {
+            params["oh_bn"] = Blocked(oh, oh_bn);
+            space.push_back(params);
+          }
+        } else {
+          for (int unroll_kw : {0, 1}) {
+            params["unroll_kw"] = {unroll_kw};
+            space.push_back(params);
+          }
+        }
+      }
+    }
+  }
+  space.erase(std::remove(space.begin(), space.end(), heuristic), space.end());
+  std::mt19937 rng(0);
+  std::shuffle(space.begin(), space.end(), rng);
+
+  std::vector<Params> candidates = {heuristic};
+  for (int i = 0; i < space.size() && candidates.size() < options_.max_trials; i++) candidates.push_back(space[i]);
+  return candidates;
+}
+
+int AutoTuner::TuneCudaLaunch(const frontend::Program& program) {
+  // the keys of the kernels are recorded by lowering the program, which is the same as compiling it
+  std::vector<std::string> keys;
+  {
+    pe::CudaLaunchKeyRecorder recorder;
+    auto graph = BuildGraph(program);
+    GraphCompiler gc(target_, BuildScope(target_, graph), graph);
+    gc.Lower();
+    keys = recorder.keys();
+  }
+
+  int num_tuned = 0;
+  std::unordered_set<std::string> visited;
+  for (auto& key : keys) {
+    if (!visited.insert(key).second) continue;
+    if (!options_.retune && log_params_.count(key)) {
+      VLOG(3) << "Skip the tuned kernel " << key;
+      continue;
+    }
+    TuneCudaInjective(key);
+    num_tuned++;
+  }
+
+  if (num_tuned && !options_.log_file.empty()) pe::SaveSerialData(log_params_, options_.log_file);
+  return num_tuned;
+}
+
+void AutoTuner::TuneCudaInjective(const std::string& key) {
+  int numel = 0, lanes = 1;
+  CHECK(pe::ParseCudaInjectiveKey(key, &numel, &lanes)) << "Invalid CUDA injective key: " << key;
+  // An elementwise add of the same fused loop and vector lanes, the launch params rarely depend on the computation of
+  // the memory bound kernels. The innermost extent 1 keeps the float32 elements from being vectorized.
+  Type type              = lanes == 2 ? Float(16) : Float(32);
+  std::vector<int> shape = lanes > 1 ? std::vector<int>({numel * lanes}) : std::vector<int>({numel, 1});
+  frontend::Placeholder x(type, shape, "tune_input");
+  frontend::Placeholder y(type, shape, "tune_weight");
+  frontend::Program program;
+  program.add(x, y);
+  program.SetInputs({x, y});
+  program.Validate();
+
+  auto& params    = pe::GetCudaTunedLaunchParams();
+  auto candidates = GenerateCudaLaunchCandidates(key, numel);
+  Record record;
+  record.key          = key;
+  record.time_ms      = std::numeric_limits<float>::max();
+  record.num_measured = candidates.size();
+  for (int i = 0; i < candidates.size(); i++) {
+    params[key] = candidates[i];
+    float time  = Measure(BuildGraph(program));
+    VLOG(3) << "Candidate " << i << " of " << key << " takes " << time << " ms";
+    if (i == 0) record.heuristic_time_ms = time;
+    if (time < record.time_ms) {
+      record.time_ms = time;
+      record.params  = candidates[i];
+    }
+  }
+  params[key]      = record.params;
+  log_params_[key] = record.params;
+  LOG(INFO) << "Tuned " << key << ": " << record.heuristic_time_ms << " ms -> " << record.time_ms << " ms";
+  records_.push_back(std::move(record));
+}
+
+std::vector<AutoTuner::Params> AutoTuner::GenerateCudaLaunchCandidates(const std::string& key, int numel) const {
+  // the params scheduling the kernel now, the tuned or the heuristic ones
+  Params current = pe::GetCudaLaunchParams(key, numel, target_);
+
+  // the grid covers the loop when each thread computes a single iteration, otherwise the iterations of a thread are
+  // strided by the grid, and may be unrolled
+  std::vector<Params> space;
+  for (int num_thread = 64; num_thread <= target_.max_num_threads(); num_thread *= 2) {
+    for (int work : {1, 2, 4, 8}) {
+      int num_block = (numel + num_thread * work - 1) / (num_thread * work);
+      for (int unroll : {0, 1}) {
+        if (unroll && work == 1) continue;
+        Params params = {{"num_thread", {num_thread}}, {"num_block", {num_block}}, {"unroll", {unroll}}};
+        if (params != current && std::find(space.begin(), space.end(), params) == space.end()) {
+          space.push_back(params);
+        }
+      }
+    }
+  }
+  std::mt19937 rng(0);
+  std::shuffle(space.begin(), space.end(), rng);
+
+  std::vector<Params> candidates = {current};
+  for (int i = 0; i < space.size() && candidates.size() < options_.max_trials; i++) candidates.push_back(space[i]);
+  return candidates;
+}
+
+std::shared_ptr<Graph> AutoTuner::BuildGraph(const frontend::Program& program) const {
+  auto graph = std::make_shared<Graph>(program, target_);
+  ApplyPass(graph.get(), "InferShape");
+  ApplyPass(graph.get(), "AlterLayout");
+  ApplyPass(graph.get(), "ConstPropagate");
+  ApplyPass(graph.get(), "OpFusion");
+  return graph;
+}
+
+std::vector<float> AutoTuner::ExtractFeatures(const std::shared_ptr<Graph>& graph) const {
+  GraphCompiler gc(target_, BuildScope(target_, graph), graph);
+  return ExtractScheduleFeatures(gc.Lower());
+}
+
+float AutoTuner::Measure(const std::shared_ptr<Graph>& graph) const {
+  auto scope = BuildScope(target_, graph);
+  GraphCompiler gc(target_, scope, graph);
+  auto runtime_program = gc.Build();
+  for (auto name : {"tune_input", "tune_weight"}) {
+    auto tensor = scope->GetTensor(name);
+    // the kernels on NVGPU are timed on the uninitialized inputs, their time doesn't depend on the values
+    if (!target_.is_cpu()) {
+      tensor->mutable_data(target_);
+      continue;
+    }
+    auto* data = tensor->mutable_data<float>(target_);
+    std::fill(data, data + tensor->shape().numel(), 0.5f);
+  }
+  auto synchronize = [&] {
+#ifdef CINN_WITH_CUDA
+    if (target_.arch == common::Target::Arch::NVGPU) CUDA_CALL(cudaDeviceSynchronize());
+#endif
+  };
+  // the weight layout transforms run once, and the first execution warms up the caches
+  runtime_program->PrePack();
+  runtime_program->Execute();
+  synchronize();
+
+  float best = std::numeric_limits<float>::max();
+  utils::Timer timer;
+  for (int i = 0; i < options_.repeats; i++) {
+    timer.Start();
+    runtime_program->Execute();
+    synchronize();
+    best = std::min(best, timer.Stop());
+  }
+  return best;
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
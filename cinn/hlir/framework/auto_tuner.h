@@ -0,0 +1,139 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cinn/common/target.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/cost_model.h"
+#include "cinn/hlir/framework/execution_profile.h"
+#include "cinn/hlir/framework/graph.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * Tune the schedule params of the X86 convs by measurement. For each conv2d instance of a program, the candidates of
+ * the channel blocking(ic_bn, oc_bn), the width blocking(ow_bn, with oh_bn for 1x1 kernels) and the kernel width
+ * unrolling(unroll_kw) are compiled and executed one by one, and the fastest is kept in the params returned by
+ * pe::GetX86ConvParams, so that the following compilations use it automatically. The tuned params are saved to the
+ * tuning log, which is loaded by setting FLAGS_cinn_tuning_log in the later runs.
+ *
+ * With a trained cost model, the candidates are lowered and ranked by the predicted costs of their features, and only
+ * the best few are measured. The measured samples can be logged to train the cost model.
+ *
+ * With the execution profile of the program, e.g. exported from the production runs, the convs are tuned in the
+ * descending order of the time their groups take, and the ones not run in the profile are skipped, so that a budget of
+ * max_tuned convs goes to the hottest ones.
+ *
+ * On NVGPU, the launch params of the injective kernels of a program are tuned instead, see pe::GetCudaLaunchParams.
+ * For each fused loop bound by them, the candidates of the threads per block, the iterations per thread, which decide
+ * the blocks, and the unrolling of these iterations are measured on a standalone elementwise kernel of the same loop,
+ * and the fastest is kept in pe::GetCudaTunedLaunchParams and saved to the log for FLAGS_cinn_cuda_tuning_log. As the
+ * best params differ among the GPU generations, the {device} in the log file is replaced by the GPU name and its
+ * compute capability.
+ *
+ * A typical usage:
+ *
+ *   AutoTuner::Options options;
+ *   options.log_file = "conv_tuning.log";
+ *   AutoTuner(common::DefaultHostTarget(), options).Tune(program);
+ */
+class AutoTuner {
+ public:
+  using Params = absl::flat_hash_map<std::string, std::vector<int>>;
+
+  struct Options {
+    // The max number of candidates measured for each conv or kernel, the params scheduling it now are always the first.
+    int max_trials = 16;
+    // The number of executions timed for each candidate, the fastest one is taken as its time.
+    int repeats = 10;
+    // The file to save the tuned params, empty to keep them in memory only. The params in it are merged.
+    // The {device} in it is replaced by the CPU model name, or the GPU name on NVGPU, see pe::GetTuningLogPath.
+    std::string log_file;
+    // Whether to tune the convs or the kernels with params in the log file again.
+    bool retune = false;
+    // The model ranking the candidates, if it is trained, only the params scheduling the conv now and the best
+    // num_measured - 1 candidates by the predicted costs are measured.
+    const CostModel* cost_model = nullptr;
+    int num_measured            = 4;
+    // The file to append the time and the features of each measured candidate to, see CostModel::LoadSamples.
+    std::string sample_log;
+    // The profile of the program to tune the hottest convs first, and the max number of the convs tuned, 0 for all.
+    const ExecutionProfile* profile = nullptr;
+    int max_tuned                   = 0;
+  };
+
+  struct Record {
+    std::string key;
+    Params params;
+    // The time of the tuned params and the heuristic ones in milliseconds.
+    float time_ms;
+    float heuristic_time_ms;
+    // The number of the candidates measured.
+    int num_measured;
+  };
+
+  AutoTuner(const common::Target& target, const Options& options);
+
+  //! Tune all the conv2d instances in \p program, or its injective kernels on NVGPU, and return the number tuned.
+  int Tune(const frontend::Program& program);
+
+  const std::vector<Record>& records() const { return records_; }
+
+ private:
+  // Measure the candidates of the conv with the shapes and \p attrs, and keep the fastest ones in the params.
+  void TuneConv2d(const std::string& key,
+                  const std::vector<int>& input_shape,
+                  const std::vector<int>& weight_shape,
+                  const std::vector<int>& output_shape,
+                  const absl::flat_hash_map<std::string, frontend::Program::attr_t>& attrs);
+
+  std::vector<Params> GenerateCandidates(const std::vector<int>& input_shape,
+                                         const std::vector<int>& weight_shape,
+                                         const std::vector<int>& output_shape) const;
+
+  // Tune the launch params of the injective kernels in the program.
+  int TuneCudaLaunch(const frontend::Program& program);
+
+  // Measure the launch params of the injective kernel of \p key, and keep the fastest ones in the tuned params.
+  void TuneCudaInjective(const std::string& key);
+
+  std::vector<Params> GenerateCudaLaunchCandidates(const std::string& key, int numel) const;
+
+  // Build the graph of the program and apply the passes the execution applies.
+  std::shared_ptr<Graph> BuildGraph(const frontend::Program& program) const;
+
+  // Lower the graph and extract the features of the schedule.
+  std::vector<float> ExtractFeatures(const std::shared_ptr<Graph>& graph) const;
+
+  // Compile the graph and return its fastest execution time in milliseconds.
+  float Measure(const std::shared_ptr<Graph>& graph) const;
+
+  common::Target target_;
+  Options options_;
+  absl::flat_hash_map<std::string, Params> log_params_;
+  std::vector<Record> records_;
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
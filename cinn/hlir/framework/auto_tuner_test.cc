@@ -0,0 +1,187 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/auto_tuner.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <random>
+
+#include "cinn/cinn.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+#include "cinn/hlir/pe/schedule.h"
+
+#ifdef CINN_WITH_CUDA
+#include "cinn/backends/cuda_util.h"
+#endif
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+using frontend::Placeholder;
+
+frontend::Program CreateConvProgram() {
+  Placeholder A(Float(32), {1, 8, 10, 10}, "A");
+  Placeholder W(Float(32), {16, 8, 3, 3}, "W", true);
+  frontend::Program program;
+  absl::flat_hash_map<std::string, frontend::Program::attr_t> attrs;
+  attrs["stride"]   = std::vector<int>({1, 1});
+  attrs["dilation"] = std::vector<int>({1, 1});
+  attrs["padding"]  = std::vector<int>({1, 1});
+  program.conv2d(A, W, attrs);
+  program.SetInputs({A, W});
+  program.Validate();
+  return program;
+}
+
+TEST(AutoTuner, conv2d) {
+  Target target        = common::DefaultHostTarget();
+  std::string log_file = "auto_tuner_test.log";
+  std::remove(log_file.c_str());
+  auto program = CreateConvProgram();
+
+  AutoTuner::Options options;
+  options.max_trials = 3;
+  options.repeats    = 1;
+  options.log_file   = log_file;
+  AutoTuner tuner(target, options);
+  ASSERT_EQ(tuner.Tune(program), 1);
+  ASSERT_EQ(tuner.records().size(), 1U);
+  auto& record = tuner.records()[0];
+  ASSERT_LE(record.time_ms, record.heuristic_time_ms);
+  // the tuned params are used by the later compilations and saved to the log
+  ASSERT_EQ(pe::GetX86ConvParams().at(record.key), record.params);
+  absl::flat_hash_map<std::string, AutoTuner::Params> log_params;
+  pe::LoadSerialData(&log_params, log_file);
+  ASSERT_EQ(log_params.at(record.key), record.params);
+
+  // the conv in the log is not tuned again
+  ASSERT_EQ(AutoTuner(target, options).Tune(program), 0);
+
+  // the conv scheduled by the tuned params is still correct
+  auto graph = std::make_shared<Graph>(program, target);
+  ApplyPass(graph.get(), "InferShape");
+  ApplyPass(graph.get(), "AlterLayout");
+  ApplyPass(graph.get(), "ConstPropagate");
+  ApplyPass(graph.get(), "OpFusion");
+  auto scope = BuildScope(target, graph);
+  GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  std::vector<float> a(1 * 8 * 10 * 10), w(16 * 8 * 3 * 3);
+  for (auto& v : a) v = dist(rng);
+  for (auto& v : w) v = dist(rng);
+  std::copy(a.begin(), a.end(), scope->GetTensor("A")->mutable_data<float>(target));
+  std::copy(w.begin(), w.end(), scope->GetTensor("W")->mutable_data<float>(target));
+  runtime_program->PrePack();
+  runtime_program->Execute();
+
+  auto out   = scope->GetTensor(program[0]->outputs[0]->id);
+  auto* data = out->data<float>();
+  ASSERT_EQ(out->shape().numel(), 16 * 10 * 10);
+  for (int oc = 0; oc < 16; oc++) {
+    for (int h = 0; h < 10; h++) {
+      for (int x = 0; x < 10; x++) {
+        float expected = 0.f;
+        for (int ic = 0; ic < 8; ic++) {
+          for (int kh = 0; kh < 3; kh++) {
+            for (int kw = 0; kw < 3; kw++) {
+              int ih = h + kh - 1, iw = x + kw - 1;
+              if (ih < 0 || ih >= 10 || iw < 0 || iw >= 10) continue;
+              expected += a[(ic * 10 + ih) * 10 + iw] * w[((oc * 8 + ic) * 3 + kh) * 3 + kw];
+            }
+          }
+        }
+        ASSERT_NEAR(data[(oc * 10 + h) * 10 + x], expected, 1e-4) << "at " << oc << ", " << h << ", " << x;
+      }
+    }
+  }
+  std::remove(log_file.c_str());
+}
+
+TEST(AutoTuner, cuda_injective_key) {
+  int numel = 0, lanes = 0;
+  ASSERT_TRUE(pe::ParseCudaInjectiveKey(pe::GenerateCudaInjectiveKey(1000, 4), &numel, &lanes));
+  ASSERT_EQ(numel, 1000);
+  ASSERT_EQ(lanes, 4);
+  ASSERT_FALSE(pe::ParseCudaInjectiveKey("X86ScheduleConv input 1 8 10 10", &numel, &lanes));
+
+  // the heuristic params without the tuned ones
+  auto params = pe::GetCudaLaunchParams("", 1 << 20, common::DefaultNVGPUTarget());
+  ASSERT_LE(params.at("num_thread")[0], common::DefaultNVGPUTarget().max_num_threads());
+  ASSERT_EQ(params.at("unroll")[0], 0);
+}
+
+#ifdef CINN_WITH_CUDA
+TEST(AutoTuner, cuda_launch) {
+  Target target        = common::DefaultNVGPUTarget();
+  std::string log_file = "auto_tuner_cuda_test.log";
+  std::remove(log_file.c_str());
+  Placeholder A(Float(32), {64, 1000}, "A");
+  Placeholder B(Float(32), {64, 1000}, "B");
+  frontend::Program program;
+  program.relu(program.add(A, B));
+  program.SetInputs({A, B});
+  program.Validate();
+
+  AutoTuner::Options options;
+  options.max_trials = 4;
+  options.repeats    = 2;
+  options.log_file   = log_file;
+  AutoTuner tuner(target, options);
+  ASSERT_GE(tuner.Tune(program), 1);
+  auto& record = tuner.records()[0];
+  ASSERT_LE(record.time_ms, record.heuristic_time_ms);
+  ASSERT_EQ(pe::GetCudaTunedLaunchParams().at(record.key), record.params);
+  absl::flat_hash_map<std::string, AutoTuner::Params> log_params;
+  pe::LoadSerialData(&log_params, log_file);
+  ASSERT_EQ(log_params.at(record.key), record.params);
+  ASSERT_EQ(AutoTuner(target, options).Tune(program), 0);
+
+  // the kernels launched by the tuned params are still correct
+  auto graph = std::make_shared<Graph>(program, target);
+  ApplyPass(graph.get(), "InferShape");
+  ApplyPass(graph.get(), "OpFusion");
+  auto scope = BuildScope(target, graph);
+  GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  std::vector<float> a(64 * 1000), b(64 * 1000), out(64 * 1000);
+  for (int i = 0; i < a.size(); i++) {
+    a[i] = i % 7 - 3.f;
+    b[i] = i % 5 - 2.f;
+  }
+  CUDA_CALL(cudaMemcpy(
+      scope->GetTensor("A")->mutable_data<float>(target), a.data(), a.size() * sizeof(float), cudaMemcpyHostToDevice));
+  CUDA_CALL(cudaMemcpy(
+      scope->GetTensor("B")->mutable_data<float>(target), b.data(), b.size() * sizeof(float), cudaMemcpyHostToDevice));
+  runtime_program->Execute();
+  CUDA_CALL(cudaMemcpy(out.data(),
+                       scope->GetTensor(program[1]->outputs[0]->id)->data<float>(),
+                       out.size() * sizeof(float),
+                       cudaMemcpyDeviceToHost));
+  for (int i = 0; i < out.size(); i++) ASSERT_FLOAT_EQ(out[i], std::max(a[i] + b[i], 0.f)) << "at " << i;
+  std::remove(log_file.c_str());
+}
+#endif
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -14,6 +14,15 @@
 
 #include "cinn/hlir/framework/buffer.h"
 
+#include <algorithm>
+#include <utility>
+
+#include "cinn/hlir/framework/resource_manager.h"
+
+#ifdef CINN_WITH_CUDA
+#include "cinn/runtime/cuda/cuda_util.h"
+#endif
+
 namespace cinn {
 namespace hlir {
 namespace framework {
@@ -27,6 +36,7 @@ void Buffer::Resize(uint32_t size) {
   if (size_ != size) {
     data_.memory      = reinterpret_cast<uint8_t*>(Malloc(size));
     data_.memory_size = size;
+    data_.align       = CINN_BUFFER_ALIGNMENT;
     size_             = size;
   }
 }
@@ -40,13 +50,67 @@ void Buffer::Resize(uint32_t alignment, uint32_t size) {
   if (size_ != size) {
     data_.memory      = reinterpret_cast<uint8_t*>(AlignedAlloc(alignment, size));
     data_.memory_size = size;
+    data_.align       = std::max<uint32_t>(alignment, CINN_BUFFER_ALIGNMENT);
     size_             = size;
   }
 }
 
+void Buffer::ChargeTenant(uint32_t size) {
+  tenant_ = Tenant::Current();
+  if (tenant_) tenant_->Allocate(size);
+}
+
+void Buffer::ReleaseTenant() {
+  tenant_->Free(size_);
+  tenant_.reset();
+}
+
+void Buffer::ResizePinned(uint32_t size) {
+  if (!is_pinned_) {
+    Free();
+    target_           = common::DefaultHostTarget();
+    memory_mng_cache_ = MemoryManager::Global().RetrievePinnedHost();
+    is_pinned_        = true;
+#ifdef CINN_WITH_CUDA
+    data_.set_on_pinned_host(true);
+#endif
+  }
+  Resize(size);
+}
+
 void Buffer::SetTarget(const common::Target& target) {
   target_           = target;
   memory_mng_cache_ = MemoryManager::Global().RetrieveSafely(target_.arch);
+  is_pinned_        = false;
+  data_.set_on_pinned_host(false);
+}
+
+#ifdef CINN_WITH_CUDA
+cudaEvent_t Buffer::CopyFromAsync(const Buffer& src, cudaStream_t stream) {
+  CHECK_LE(src.size_, size_) << "The buffer is smaller than the source buffer";
+  if (src.target_.arch != common::Target::Arch::NVGPU) {
+    CHECK_EQ(target_.arch, common::Target::Arch::NVGPU) << "Only the copies between host and NVGPU are supported";
+    return runtime::cuda::cinn_buffer_copy_to_device_async(&src.data_, &data_, stream);
+  }
+  CHECK_NE(target_.arch, common::Target::Arch::NVGPU) << "Only the copies between host and NVGPU are supported";
+  return runtime::cuda::cinn_buffer_copy_to_host_async(&src.data_, &data_, stream);
+}
+#endif
+
+void Buffer::ShareExternalMemory(uint8_t* memory,
+                                 uint32_t size,
+                                 const common::Target& target,
+                                 std::shared_ptr<void> owner) {
+  Free();
+  if (target.arch != target_.arch || is_pinned_) SetTarget(target);
+  // the alignment is the largest power of 2 dividing the address, up to CINN_BUFFER_ALIGNMENT
+  auto address      = reinterpret_cast<uintptr_t>(memory);
+  data_.memory      = memory;
+  data_.memory_size = size;
+  data_.align       = std::min<uintptr_t>(address & -address, CINN_BUFFER_ALIGNMENT);
+  size_             = size;
+  is_external_      = true;
+  external_owner_   = std::move(owner);
 }
 
 void Buffer::ResizeLazy(uint32_t size) {
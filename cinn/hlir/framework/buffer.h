@@ -19,6 +19,10 @@
 
 #include <memory>
 
+#ifdef CINN_WITH_CUDA
+#include <cuda_runtime.h>
+#endif
+
 #include "cinn/common/macros.h"
 #include "cinn/common/target.h"
 #include "cinn/hlir/framework/memory.h"
@@ -28,12 +32,17 @@ namespace cinn {
 namespace hlir {
 namespace framework {
 
+class Tenant;
+
 /**
  * Buffer helps to hold the memory, and offers a set of methods to help manage the memory.
  */
 struct Buffer final {
   Buffer() = default;
   explicit Buffer(const common::Target& target) { SetTarget(target); }
+  ~Buffer() {
+    if (tenant_) ReleaseTenant();
+  }
 
   //! Resize the memory hold by this buffer *exactlly* to \p size.
   void Resize(uint32_t size);
@@ -51,28 +60,84 @@ struct Buffer final {
   void ResizeLazy(uint32_t size, const common::Target& target);
   void ResizeLazy(uint32_t alignment, uint32_t size, const common::Target& target);
 
+  /**
+   * Resize the memory to \p size bytes of page-locked host memory, which can be copied to or from the device
+   * asynchronously, e.g. the staging buffer of the inputs and outputs. The buffer keeps pinned in the later resizes
+   * until the target is set again.
+   */
+  void ResizePinned(uint32_t size);
+
+  bool is_pinned() const { return is_pinned_; }
+
   void SetTarget(const common::Target& target);
 
+  //! The place where the memory of this buffer locates.
+  const common::Target& target() const { return target_; }
+
+#ifdef CINN_WITH_CUDA
+  /**
+   * Copy the memory of \p src to this buffer on \p stream asynchronously, one of them should be on host and the other
+   * on NVGPU. Return an event recorded after the copy, which the caller owns. The copy only overlaps with the work on
+   * other streams if the host buffer is pinned, and the host buffer should not be touched before the event completes.
+   */
+  cudaEvent_t CopyFromAsync(const Buffer& src, cudaStream_t stream);
+#endif
+
+  /**
+   * Let this buffer refer to \p size bytes of memory owned by others, such as a slice of a memory arena. The buffer
+   * will not free the external memory. If \p owner is given, the buffer keeps it alive until the memory is released,
+   * e.g. the mapping of the file the memory is in.
+   */
+  void ShareExternalMemory(uint8_t* memory,
+                           uint32_t size,
+                           const common::Target& target,
+                           std::shared_ptr<void> owner = nullptr);
+
+  /**
+   * Let the later allocations and the free of the memory be ordered on \p stream, e.g. the stream of the instruction
+   * producing it, for the stream-ordered allocators, see --cinn_use_cuda_malloc_async. Null means the default stream.
+   */
+  void SetStream(void* stream) { stream_ = stream; }
+  void* stream() const { return stream_; }
+
+  //! Number of bytes of the memory hold by this buffer.
+  uint32_t size() const { return size_; }
+
+  //! Whether the memory is owned by others, e.g. a slice of a memory arena.
+  bool is_external() const { return is_external_; }
+
   const cinn_buffer_t* data() const { return &data_; }
   cinn_buffer_t* data() { return &data_; }
 
   //! Free all the memory owned by this buffer.
   void Free() {
     if (!data_.memory) return;
-    memory_mng_cache_->free(data_.memory);
+    if (!is_external_) memory_mng_cache_->stream_free(data_.memory, stream_);
+    if (tenant_) ReleaseTenant();
+    data_.memory = nullptr;
+    size_        = 0;
+    is_external_ = false;
+    external_owner_.reset();
   }
 
  private:
   inline void* Malloc(uint32_t size) CINN_RESULT_SHOULD_USE {
     CHECK(memory_mng_cache_) << "Should set target first";
-    return memory_mng_cache_->malloc(size);
+    ChargeTenant(size);
+    return memory_mng_cache_->stream_malloc(size, stream_);
   }
 
   inline void* AlignedAlloc(uint32_t alignment, uint32_t size) CINN_RESULT_SHOULD_USE {
     CHECK(memory_mng_cache_) << "Should set target first";
+    ChargeTenant(size);
     return memory_mng_cache_->aligned_alloc(alignment, size);
   }
 
+  //! Charge the memory to allocate to the tenant of the calling thread, if any, see TenantScope.
+  void ChargeTenant(uint32_t size);
+  //! Release the memory charged to the tenant.
+  void ReleaseTenant();
+
  private:
   cinn_buffer_t data_;
 
@@ -84,6 +149,21 @@ struct Buffer final {
 
   //! Hold the corresponding memory manager for speed.
   MemoryInterface* memory_mng_cache_{};
+
+  //! Whether the memory is owned by others.
+  bool is_external_{false};
+
+  //! What the external memory belongs to, if it should be kept alive by the buffer.
+  std::shared_ptr<void> external_owner_;
+
+  //! Whether the memory is page-locked host memory.
+  bool is_pinned_{false};
+
+  //! The stream the memory is allocated and freed on.
+  void* stream_{};
+
+  //! The tenant the memory is charged to.
+  std::shared_ptr<Tenant> tenant_;
 };
 
 }  // namespace framework
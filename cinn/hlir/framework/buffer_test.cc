@@ -16,10 +16,13 @@
 #ifdef CINN_WITH_CUDA
 #include "cinn/backends/cuda_util.h"
 #endif
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
 #include <vector>
 
+DECLARE_string(cinn_cpu_huge_pages);
+
 namespace cinn {
 namespace hlir {
 namespace framework {
@@ -31,6 +34,40 @@ TEST(Buffer, basic) {
   for (int i = 0; i < 10; i++) data[i] = i;
 }
 
+TEST(Buffer, pinned) {
+  Buffer buffer(common::DefaultHostTarget());
+  buffer.ResizePinned(10 * sizeof(float));
+  ASSERT_TRUE(buffer.is_pinned());
+  auto* data = reinterpret_cast<float*>(buffer.data()->memory);
+  for (int i = 0; i < 10; i++) data[i] = i;
+  // Resizing keeps the buffer pinned until the target is set again.
+  buffer.Resize(20 * sizeof(float));
+  ASSERT_TRUE(buffer.is_pinned());
+  buffer.SetTarget(common::DefaultHostTarget());
+  ASSERT_FALSE(buffer.is_pinned());
+  ASSERT_FALSE(buffer.data()->on_pinned_host());
+}
+
+TEST(Buffer, alignment) {
+  Buffer buffer(common::DefaultHostTarget());
+  buffer.Resize(10);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(buffer.data()->memory) % CINN_BUFFER_ALIGNMENT, 0);
+  ASSERT_EQ(buffer.data()->align, CINN_BUFFER_ALIGNMENT);
+  // the external memory keeps its own alignment
+  Buffer slice(common::DefaultHostTarget());
+  slice.ShareExternalMemory(buffer.data()->memory + 4, 4, common::DefaultHostTarget());
+  ASSERT_EQ(slice.data()->align, 4);
+
+  // the large allocations are backed by the transparent huge pages
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  FLAGS_cinn_cpu_huge_pages = "transparent";
+  Buffer large(common::DefaultHostTarget());
+  large.Resize(5 << 20);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(large.data()->memory) % (2 << 20), 0);
+  large.data()->memory[(5 << 20) - 1] = 1;
+  large.Free();
+}
+
 #ifdef CINN_WITH_CUDA
 TEST(Buffer, nvgpu) {
   const int num_elements = 10;
@@ -54,6 +91,36 @@ TEST(Buffer, nvgpu) {
     ASSERT_EQ(host_target[i], i);
   }
 }
+
+TEST(Buffer, async_copy) {
+  const int num_elements = 1024;
+  Buffer input, output;
+  input.ResizePinned(num_elements * sizeof(float));
+  output.ResizePinned(num_elements * sizeof(float));
+  ASSERT_TRUE(input.data()->on_pinned_host());
+  Buffer device(common::DefaultNVGPUTarget());
+  device.Resize(num_elements * sizeof(float));
+
+  auto* input_data  = reinterpret_cast<float*>(input.data()->memory);
+  auto* output_data = reinterpret_cast<float*>(output.data()->memory);
+  for (int i = 0; i < num_elements; i++) {
+    input_data[i]  = i;
+    output_data[i] = 0;
+  }
+
+  cudaStream_t stream;
+  CUDA_CALL(cudaStreamCreate(&stream));
+  cudaEvent_t uploaded = device.CopyFromAsync(input, stream);
+  cudaEvent_t fetched  = output.CopyFromAsync(device, stream);
+  CUDA_CALL(cudaEventSynchronize(fetched));
+  ASSERT_EQ(cudaEventQuery(uploaded), cudaSuccess);
+  for (int i = 0; i < num_elements; i++) {
+    ASSERT_EQ(output_data[i], i);
+  }
+  CUDA_CALL(cudaEventDestroy(uploaded));
+  CUDA_CALL(cudaEventDestroy(fetched));
+  CUDA_CALL(cudaStreamDestroy(stream));
+}
 #endif
 
 }  // namespace framework
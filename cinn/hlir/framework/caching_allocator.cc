@@ -0,0 +1,185 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/caching_allocator.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+std::ostream& operator<<(std::ostream& os, const AllocatorStats& stats) {
+  os << "allocated: " << stats.allocated_bytes << " bytes, cached: " << stats.cached_bytes()
+     << " bytes, reserved: " << stats.reserved_bytes << " bytes, peak allocated: " << stats.peak_allocated_bytes
+     << " bytes, allocs: " << stats.num_allocs << ", cache hits: " << stats.num_cache_hits
+     << ", segment allocs: " << stats.num_segment_allocs;
+  return os;
+}
+
+size_t CachingAllocator::RoundSize(size_t nbytes) {
+  if (nbytes < kMinBlockSize) return kMinBlockSize;
+  return (nbytes + kMinBlockSize - 1) / kMinBlockSize * kMinBlockSize;
+}
+
+size_t CachingAllocator::SegmentSize(size_t nbytes) {
+  if (nbytes <= kSmallSize) return kSmallSegmentSize;
+  return (nbytes + kLargeSegmentRound - 1) / kLargeSegmentRound * kLargeSegmentRound;
+}
+
+void* CachingAllocator::Malloc(size_t nbytes, void* stream) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t size     = RoundSize(nbytes);
+  bool is_small   = size <= kSmallSize;
+  BlockPool* pool = is_small ? &small_pool_ : &large_pool_;
+  stats_.num_allocs++;
+
+  Block* block = FindFreeBlock(pool, size, stream);
+  if (block) {
+    stats_.num_cache_hits++;
+  } else {
+    size_t segment_size = SegmentSize(size);
+    auto* ptr           = reinterpret_cast<uint8_t*>(underlying_->aligned_alloc(kMinBlockSize, segment_size));
+    if (!ptr) ptr = reinterpret_cast<uint8_t*>(underlying_->malloc(segment_size));
+    if (!ptr) {
+      // Release the cached segments and retry.
+      ReleaseCachedSegments();
+      ptr = reinterpret_cast<uint8_t*>(underlying_->malloc(segment_size));
+    }
+    CHECK(ptr) << "Failed to allocate a segment of " << segment_size << " bytes, " << stats_;
+    block           = new Block;
+    block->ptr      = ptr;
+    block->size     = segment_size;
+    block->stream   = stream;
+    block->is_small = is_small;
+    stats_.reserved_bytes += segment_size;
+    stats_.num_segment_allocs++;
+  }
+
+  MaybeSplit(pool, block, size);
+  block->allocated              = true;
+  allocated_blocks_[block->ptr] = block;
+  stats_.allocated_bytes += block->size;
+  stats_.peak_allocated_bytes = std::max(stats_.peak_allocated_bytes, stats_.allocated_bytes);
+  return block->ptr;
+}
+
+void* CachingAllocator::aligned_alloc(size_t alignment, size_t nbytes) {
+  CHECK_EQ(kMinBlockSize % alignment, 0) << "CachingAllocator doesn't support the alignment " << alignment;
+  return Malloc(nbytes, nullptr);
+}
+
+void CachingAllocator::free(void* data) {
+  if (!data) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = allocated_blocks_.find(data);
+  CHECK(it != allocated_blocks_.end()) << "The memory " << data << " is not allocated by CachingAllocator";
+  Block* block = it->second;
+  allocated_blocks_.erase(it);
+  block->allocated = false;
+  stats_.allocated_bytes -= block->size;
+  Coalesce(block->is_small ? &small_pool_ : &large_pool_, block);
+}
+
+CachingAllocator::Block* CachingAllocator::FindFreeBlock(BlockPool* pool, size_t size, void* stream) {
+  Block key;
+  key.stream = stream;
+  key.size   = size;
+  auto it    = pool->lower_bound(&key);
+  if (it == pool->end() || (*it)->stream != stream) return nullptr;
+  Block* block = *it;
+  pool->erase(it);
+  return block;
+}
+
+void CachingAllocator::MaybeSplit(BlockPool* pool, Block* block, size_t size) {
+  size_t remaining = block->size - size;
+  // The large blocks are only split when the remaining is not small, to keep them for the large requests.
+  bool should_split = block->is_small ? remaining >= kMinBlockSize : remaining > kSmallSize;
+  if (!should_split) return;
+  auto* rest     = new Block;
+  rest->ptr      = block->ptr + size;
+  rest->size     = remaining;
+  rest->stream   = block->stream;
+  rest->is_small = block->is_small;
+  rest->prev     = block;
+  rest->next     = block->next;
+  if (block->next) block->next->prev = rest;
+  block->next = rest;
+  block->size = size;
+  pool->insert(rest);
+}
+
+void CachingAllocator::Coalesce(BlockPool* pool, Block* block) {
+  for (Block* neighbor : {block->prev, block->next}) {
+    if (!neighbor || neighbor->allocated) continue;
+    pool->erase(neighbor);
+    if (neighbor == block->prev) {
+      block->ptr  = neighbor->ptr;
+      block->prev = neighbor->prev;
+      if (block->prev) block->prev->next = block;
+    } else {
+      block->next = neighbor->next;
+      if (block->next) block->next->prev = block;
+    }
+    block->size += neighbor->size;
+    delete neighbor;
+  }
+  pool->insert(block);
+}
+
+void CachingAllocator::EmptyCache() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ReleaseCachedSegments();
+}
+
+size_t CachingAllocator::ReleaseCache() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t reserved_bytes = stats_.reserved_bytes;
+  ReleaseCachedSegments();
+  return reserved_bytes - stats_.reserved_bytes;
+}
+
+void CachingAllocator::ReleaseCachedSegments() {
+  for (BlockPool* pool : {&small_pool_, &large_pool_}) {
+    std::vector<Block*> segments;
+    for (Block* block : *pool) {
+      // Only the blocks covering a whole segment can be returned.
+      if (!block->prev && !block->next) segments.push_back(block);
+    }
+    for (Block* block : segments) {
+      pool->erase(block);
+      underlying_->free(block->ptr);
+      stats_.reserved_bytes -= block->size;
+      delete block;
+    }
+  }
+}
+
+AllocatorStats CachingAllocator::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+CachingAllocator::~CachingAllocator() {
+  EmptyCache();
+  if (!allocated_blocks_.empty()) {
+    LOG(WARNING) << allocated_blocks_.size() << " blocks are still in use when CachingAllocator is destroyed";
+  }
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,138 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "cinn/common/macros.h"
+#include "cinn/hlir/framework/memory.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+struct AllocatorStats {
+  //! Number of bytes handed out to the users.
+  size_t allocated_bytes{};
+  //! Number of bytes held from the underlying allocator, including the cached ones.
+  size_t reserved_bytes{};
+  //! The peak of allocated_bytes.
+  size_t peak_allocated_bytes{};
+  //! Number of allocation requests.
+  size_t num_allocs{};
+  //! Number of allocation requests served by the cached blocks.
+  size_t num_cache_hits{};
+  //! Number of calls to the underlying allocator.
+  size_t num_segment_allocs{};
+
+  //! Number of bytes cached but not used.
+  size_t cached_bytes() const { return reserved_bytes - allocated_bytes; }
+};
+
+std::ostream& operator<<(std::ostream& os, const AllocatorStats& stats);
+
+/**
+ * CachingAllocator is a MemoryInterface which caches the memory freed by users and reuses it for the later
+ * allocations, to avoid the expensive system calls like cudaMalloc/cudaFree on the execution path.
+ *
+ * The memory is got from the underlying allocator in segments, and each segment is split into blocks. The requests
+ * are rounded to size classes and served by the best-fit free block, the rest of the block is split off, and the
+ * adjacent free blocks in a segment are coalesced on free. Free blocks are kept separately for each stream, so that a
+ * block freed on one stream is never handed to another stream before the work on it finishes.
+ */
+class CachingAllocator : public MemoryInterface {
+ public:
+  //! The minimum size of a block, all the block sizes and offsets are multiples of it.
+  static constexpr size_t kMinBlockSize = 1024;
+  //! Requests no larger than it are served from the small segments.
+  static constexpr size_t kSmallSize = 1 << 20;
+  //! The size of the small segments.
+  static constexpr size_t kSmallSegmentSize = 2 << 20;
+  //! The large segments are rounded up to the multiple of it.
+  static constexpr size_t kLargeSegmentRound = 2 << 20;
+
+  /**
+   * Constructor.
+   * @param underlying The allocator to get segments from, the caching allocator takes its ownership.
+   */
+  explicit CachingAllocator(MemoryInterface* underlying) : underlying_(underlying) {}
+
+  void* malloc(size_t nbytes) override { return Malloc(nbytes, nullptr); }
+  void free(void* data) override;
+  void* aligned_alloc(size_t alignment, size_t nbytes) override;
+  void* stream_malloc(size_t nbytes, void* stream) override { return Malloc(nbytes, stream); }
+
+  //! Allocate memory used on \p stream.
+  void* Malloc(size_t nbytes, void* stream);
+
+  //! Return all the cached segments that are not used to the underlying allocator.
+  void EmptyCache();
+  //! EmptyCache, returning the bytes of the segments returned.
+  size_t ReleaseCache() override;
+
+  AllocatorStats GetStats() const;
+
+  ~CachingAllocator();
+
+ private:
+  struct Block {
+    uint8_t* ptr{};
+    size_t size{};
+    void* stream{};
+    bool allocated{false};
+    bool is_small{false};
+    Block* prev{};
+    Block* next{};
+  };
+
+  struct BlockComparator {
+    bool operator()(const Block* a, const Block* b) const {
+      if (a->stream != b->stream) return a->stream < b->stream;
+      if (a->size != b->size) return a->size < b->size;
+      return a->ptr < b->ptr;
+    }
+  };
+  using BlockPool = std::set<Block*, BlockComparator>;
+
+  static size_t RoundSize(size_t nbytes);
+  static size_t SegmentSize(size_t nbytes);
+
+  //! Find the best-fit free block of \p stream, return null if not found.
+  Block* FindFreeBlock(BlockPool* pool, size_t size, void* stream);
+  //! Split the block if the remaining part is large enough to be reused.
+  void MaybeSplit(BlockPool* pool, Block* block, size_t size);
+  //! Merge \p block with its adjacent free blocks in the same segment.
+  void Coalesce(BlockPool* pool, Block* block);
+  //! Return the free segments to the underlying allocator, the caller should hold the lock.
+  void ReleaseCachedSegments();
+
+  std::unique_ptr<MemoryInterface> underlying_;
+  BlockPool small_pool_;
+  BlockPool large_pool_;
+  absl::flat_hash_map<void*, Block*> allocated_blocks_;
+  AllocatorStats stats_;
+  mutable std::mutex mutex_;
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(CachingAllocator);
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
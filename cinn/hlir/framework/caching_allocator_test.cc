@@ -0,0 +1,97 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/caching_allocator.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+class CountingMemoryMng : public MemoryInterface {
+ public:
+  explicit CountingMemoryMng(int* counter) : counter_(counter) {}
+  void* malloc(size_t nbytes) override {
+    (*counter_)++;
+    return ::malloc(nbytes);
+  }
+  void free(void* data) override { ::free(data); }
+
+ private:
+  int* counter_{};
+};
+
+TEST(CachingAllocator, reuse) {
+  int num_mallocs = 0;
+  CachingAllocator allocator(new CountingMemoryMng(&num_mallocs));
+  void* a = allocator.malloc(1000);
+  void* b = allocator.malloc(3000);
+  // both are served by one small segment
+  ASSERT_EQ(num_mallocs, 1);
+  ASSERT_EQ(reinterpret_cast<uint8_t*>(b) - reinterpret_cast<uint8_t*>(a), CachingAllocator::kMinBlockSize);
+
+  auto stats = allocator.GetStats();
+  ASSERT_EQ(stats.allocated_bytes, 4 * CachingAllocator::kMinBlockSize);
+  ASSERT_EQ(stats.reserved_bytes, CachingAllocator::kSmallSegmentSize);
+
+  allocator.free(a);
+  // reuse the freed block
+  void* c = allocator.malloc(512);
+  ASSERT_EQ(a, c);
+  allocator.free(b);
+  allocator.free(c);
+
+  stats = allocator.GetStats();
+  ASSERT_EQ(stats.allocated_bytes, 0UL);
+  ASSERT_EQ(stats.peak_allocated_bytes, 4 * CachingAllocator::kMinBlockSize);
+  ASSERT_EQ(stats.num_cache_hits, 2UL);
+
+  // the blocks are coalesced into the whole segment
+  void* d = allocator.malloc(CachingAllocator::kSmallSize);
+  ASSERT_EQ(a, d);
+  ASSERT_EQ(num_mallocs, 1);
+  allocator.free(d);
+
+  allocator.EmptyCache();
+  ASSERT_EQ(allocator.GetStats().reserved_bytes, 0UL);
+}
+
+TEST(CachingAllocator, streams) {
+  int num_mallocs = 0;
+  CachingAllocator allocator(new CountingMemoryMng(&num_mallocs));
+  int stream0, stream1;
+  void* a = allocator.Malloc(4096, &stream0);
+  allocator.free(a);
+  // the cached block of stream0 is not used by stream1
+  void* b = allocator.Malloc(4096, &stream1);
+  ASSERT_EQ(num_mallocs, 2);
+  void* c = allocator.Malloc(4096, &stream0);
+  ASSERT_EQ(a, c);
+  allocator.free(b);
+  allocator.free(c);
+
+  // the streams passed by the MemoryInterface, e.g. those of the buffers
+  MemoryInterface* memory = &allocator;
+  void* d                 = memory->stream_malloc(4096, &stream1);
+  ASSERT_EQ(d, b);
+  memory->stream_free(d, &stream1);
+  ASSERT_EQ(num_mallocs, 2);
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,77 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/calibrator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "cinn/hlir/framework/pass.h"
+
+#ifdef CINN_WITH_CUDA
+#include "cinn/runtime/cuda/cuda_util.h"
+#endif
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+Calibrator::Calibrator(const frontend::Program& program, const Target& target) : target_(target) {
+  graph_ = std::make_shared<Graph>(program, target);
+  ApplyPass(graph_.get(), "InferShape");
+  // no OpFusion, so each op is a group of its own and all the intermediate variables are kept in the scope
+  scope_ = BuildScope(target, graph_);
+  GraphCompiler gc(target, scope_, graph_);
+  runtime_program_ = gc.Build();
+}
+
+void Calibrator::Run() {
+  runtime_program_->Execute();
+
+  auto& dtype_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, common::Type>>("inferdtype");
+  std::vector<float> host_data;
+  for (auto& name_view : scope_->var_names()) {
+    std::string name({name_view.data(), name_view.size()});
+    auto dtype = dtype_dict.find(name);
+    if (dtype == dtype_dict.end() || dtype->second != Float(32)) continue;
+    auto tensor  = scope_->GetTensor(name);
+    auto* buffer = tensor->buffer();
+    if (!buffer->memory) continue;
+    int numel         = tensor->shape().numel();
+    const float* data = reinterpret_cast<const float*>(buffer->memory);
+    if (target_.arch == Target::Arch::NVGPU) {
+#ifdef CINN_WITH_CUDA
+      host_data.resize(numel);
+      CUDA_CALL(cudaMemcpy(host_data.data(), buffer->memory, numel * sizeof(float), cudaMemcpyDeviceToHost));
+      data = host_data.data();
+#else
+      CINN_NOT_IMPLEMENTED
+#endif
+    }
+    float max_abs = 0.f;
+    for (int i = 0; i < numel; i++) max_abs = std::max(max_abs, std::abs(data[i]));
+    auto& range = ranges_[name];
+    range       = std::max(range, max_abs);
+  }
+}
+
+void Calibrator::AttachRanges(Graph* graph) const {
+  CHECK(!ranges_.empty()) << "The calibrator should Run at least once before attaching the ranges";
+  graph->attrs["calibration_ranges"] = std::make_shared<absl::any>(ranges_);
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,75 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include <memory>
+#include <string>
+
+#include "cinn/common/target.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/scope.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * Collect the ranges of the float32 variables of a program for the post-training quantization. The program is
+ * compiled without fusion, so that each intermediate variable is written to the scope, then it is executed on a set of
+ * calibration inputs fed by the caller, and the max absolute value of each variable over all the runs is recorded.
+ *
+ * A typical usage:
+ *
+ *   Calibrator calibrator(program, target);
+ *   for (auto& batch : batches) {
+ *     // fill the inputs in calibrator.scope()
+ *     calibrator.Run();
+ *   }
+ *   auto graph = std::make_shared<Graph>(program, target);
+ *   calibrator.AttachRanges(graph.get());
+ *   ApplyPass(graph.get(), "InferShape");
+ *   ApplyPass(graph.get(), "Quantization");
+ */
+class Calibrator {
+ public:
+  Calibrator(const frontend::Program& program, const Target& target);
+
+  //! The scope holding the variables of the program, the inputs should be filled before each Run.
+  Scope* scope() { return scope_.get(); }
+
+  //! Execute the program once and update the ranges by the values of the variables.
+  void Run();
+
+  //! The max absolute value of each float32 variable in the runs so far.
+  const absl::flat_hash_map<std::string, float>& ranges() const { return ranges_; }
+
+  //! Set the ranges to the attribute "calibration_ranges" of \p graph, which is built from the same program.
+  void AttachRanges(Graph* graph) const;
+
+ private:
+  Target target_;
+  std::shared_ptr<Graph> graph_;
+  std::shared_ptr<Scope> scope_;
+  std::unique_ptr<Program> runtime_program_;
+  absl::flat_hash_map<std::string, float> ranges_;
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
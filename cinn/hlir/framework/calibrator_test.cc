@@ -0,0 +1,63 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/calibrator.h"
+
+#include <gtest/gtest.h>
+
+#include "cinn/cinn.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/test_helper.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+using frontend::Placeholder;
+using pass::Fill;
+
+// the ranges are the max absolute values of the inputs and the intermediate variables over all the runs
+TEST(Calibrator, ranges) {
+  Placeholder A(Float(32), {2, 2}, "A");
+  Placeholder B(Float(32), {2, 2}, "B");
+  frontend::Program program;
+  auto c = program.add(A, B);
+  auto d = program.relu(c);
+  program.SetInputs({A, B});
+  program.Validate();
+
+  Target target = common::DefaultHostTarget();
+  Calibrator calibrator(program, target);
+  Fill(calibrator.scope(), "A", {1.f, -2.f, 3.f, -4.f}, target);
+  Fill(calibrator.scope(), "B", {0.5f, 0.5f, 0.5f, 0.5f}, target);
+  calibrator.Run();
+  Fill(calibrator.scope(), "A", {-6.f, 0.f, 0.f, 0.f}, target);
+  calibrator.Run();
+
+  auto& ranges = calibrator.ranges();
+  ASSERT_FLOAT_EQ(ranges.at("A"), 6.f);
+  ASSERT_FLOAT_EQ(ranges.at("B"), 0.5f);
+  ASSERT_FLOAT_EQ(ranges.at(c->id), 5.5f);
+  ASSERT_FLOAT_EQ(ranges.at(d->id), 3.5f);
+
+  auto graph = std::make_shared<Graph>(program, target);
+  calibrator.AttachRanges(graph.get());
+  ASSERT_FLOAT_EQ((graph->GetAttrs<absl::flat_hash_map<std::string, float>>("calibration_ranges").at("A")), 6.f);
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,419 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/cost_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+#include "cinn/ir/collect_ir_nodes.h"
+#include "cinn/ir/ir_mutator.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+
+float Log(double x) { return std::log2(1. + std::max(x, 0.)); }
+
+bool HasVar(const Expr& expr, const std::string& var) {
+  return !ir::CollectIRNodes(expr, [&](const Expr* x) {
+            auto* v = x->As<ir::_Var_>();
+            return v && v->name == var;
+          }).empty();
+}
+
+// The coefficient of the variable in the linear expression, 0 if it is absent and -1 if the expression isn't linear.
+int64_t Coefficient(const Expr& expr, const std::string& var) {
+  if (auto* v = expr.As<ir::_Var_>()) return v->name == var;
+  if (expr.is_constant()) return 0;
+  if (auto* add = expr.As<ir::Add>()) {
+    int64_t a = Coefficient(add->a(), var), b = Coefficient(add->b(), var);
+    return a < 0 || b < 0 ? -1 : a + b;
+  }
+  if (auto* sub = expr.As<ir::Sub>()) {
+    int64_t a = Coefficient(sub->a(), var), b = Coefficient(sub->b(), var);
+    return a < 0 || b < 0 ? -1 : std::abs(a - b);
+  }
+  if (auto* mul = expr.As<ir::Mul>()) {
+    if (mul->a().is_constant()) return Coefficient(mul->b(), var) * std::abs(mul->a().get_constant());
+    if (mul->b().is_constant()) return Coefficient(mul->a(), var) * std::abs(mul->b().get_constant());
+  }
+  return HasVar(expr, var) ? -1 : 0;
+}
+
+class FeatureExtractor : public ir::IRMutator<const Expr*> {
+ public:
+  void operator()(const Expr* expr) { ir::IRMutator<const Expr*>::Visit(expr, expr); }
+
+  std::vector<float> Features() const {
+    double stores = std::max(stores_, 1.);
+    double loads  = std::max(loads_, 1.);
+    return {Log(stores_),
+            Log(loads_),
+            Log(arith_),
+            static_cast<float>(max_depth_),
+            Log(num_loops_),
+            static_cast<float>(vectorized_ / stores),
+            static_cast<float>(max_lanes_),
+            static_cast<float>(parallel_ / stores),
+            Log(parallel_extent_),
+            static_cast<float>(unrolled_ / stores),
+            static_cast<float>(innermost_ / stores),
+            static_cast<float>(zero_stride_ / loads),
+            static_cast<float>(unit_stride_ / loads),
+            static_cast<float>((loads_ - zero_stride_ - unit_stride_) / loads),
+            Log(gpu_threads_),
+            Log(gpu_blocks_)};
+  }
+
+  void VisitFunc(const ir::LoweredFunc& func) {
+    if (func->cuda_axis_info.valid()) {
+      int threads = 1, blocks = 1;
+      for (int i = 0; i < 3; i++) {
+        threads *= func->cuda_axis_info.block_dim(i);
+        blocks *= func->cuda_axis_info.grid_dim(i);
+      }
+      gpu_threads_ = std::max<double>(gpu_threads_, threads);
+      gpu_blocks_  = std::max<double>(gpu_blocks_, blocks);
+    }
+    (*this)(&func->body);
+  }
+
+ private:
+  struct Loop {
+    std::string var;
+    double extent;
+    const ir::ForBase* info;
+  };
+
+  void Visit(const ir::For* op, const Expr* expr) override {
+    VisitLoop({op->loop_var->name, op->extent.is_constant() ? op->extent.get_constant() : 1., op}, op, expr);
+  }
+
+  void Visit(const ir::PolyFor* op, const Expr* expr) override {
+    Expr extent         = op->ExtractExtent();
+    double extent_value = extent.defined() && extent.is_constant() ? extent.get_constant() : 1.;
+    VisitLoop({op->iterator->name, extent_value, op}, op, expr);
+  }
+
+  template <typename T>
+  void VisitLoop(const Loop& loop, const T* op, const Expr* expr) {
+    loops_.push_back(loop);
+    num_loops_++;
+    max_depth_ = std::max<int>(max_depth_, loops_.size());
+    ir::IRMutator<const Expr*>::Visit(op, expr);
+    loops_.pop_back();
+  }
+
+  double Iterations() const {
+    double res = 1.;
+    for (auto& loop : loops_) res *= std::max(loop.extent, 1.);
+    return res;
+  }
+
+  void Visit(const ir::Store* op, const Expr* expr) override {
+    double iters           = Iterations();
+    int lanes              = std::max(op->type().lanes(), op->value.type().lanes());
+    bool vectorized        = lanes > 1;
+    bool parallel          = false;
+    bool unrolled          = false;
+    double parallel_extent = 1.;
+    for (auto& loop : loops_) {
+      vectorized |= loop.info->is_vectorized();
+      unrolled |= loop.info->is_unrolled();
+      if (loop.info->is_parallel()) {
+        parallel = true;
+        parallel_extent *= loop.extent;
+      }
+    }
+    stores_ += iters;
+    if (vectorized) vectorized_ += iters;
+    if (parallel) parallel_ += iters;
+    if (unrolled) unrolled_ += iters;
+    max_lanes_       = std::max(max_lanes_, lanes);
+    parallel_extent_ = std::max(parallel_extent_, parallel_extent);
+    innermost_ += iters * (loops_.empty() ? 0.f : Log(loops_.back().extent));
+    ir::IRMutator<const Expr*>::Visit(op, expr);
+  }
+
+  void Visit(const ir::Load* op, const Expr* expr) override {
+    double iters = Iterations();
+    loads_ += iters;
+    // the vector lanes are the innermost dimension if the last index is a ramp
+    int64_t stride = 0;
+    auto* ramp     = op->indices.empty() ? nullptr : op->indices.back().As<ir::Ramp>();
+    if (ramp) {
+      stride = ramp->stride.is_constant() ? std::abs(ramp->stride.get_constant()) : -1;
+    } else if (!loops_.empty()) {
+      auto& var = loops_.back().var;
+      for (int i = 0; i < op->indices.size(); i++) {
+        int64_t coef = Coefficient(op->indices[i], var);
+        if (coef == 0) continue;
+        // the variable in the outer dimensions jumps over the inner ones
+        stride = i + 1 == op->indices.size() && stride == 0 ? coef : -1;
+      }
+    }
+    if (stride == 0) zero_stride_ += iters;
+    if (stride == 1) unit_stride_ += iters;
+    ir::IRMutator<const Expr*>::Visit(op, expr);
+  }
+
+#define VISIT_ARITH(op__)                                     \
+  void Visit(const ir::op__* op, const Expr* expr) override { \
+    arith_ += Iterations() * std::max(op->type().lanes(), 1); \
+    ir::IRMutator<const Expr*>::Visit(op, expr);              \
+  }
+  VISIT_ARITH(Add)
+  VISIT_ARITH(Sub)
+  VISIT_ARITH(Mul)
+  VISIT_ARITH(Div)
+  VISIT_ARITH(Min)
+  VISIT_ARITH(Max)
+#undef VISIT_ARITH
+
+  std::vector<Loop> loops_;
+  double stores_{0.}, loads_{0.}, arith_{0.};
+  int max_depth_{0};
+  double num_loops_{0.};
+  double vectorized_{0.}, parallel_{0.}, unrolled_{0.}, innermost_{0.};
+  int max_lanes_{1};
+  double parallel_extent_{1.};
+  double zero_stride_{0.}, unit_stride_{0.};
+  double gpu_threads_{1.}, gpu_blocks_{1.};
+};
+
+// Count the work of the lowered function, weighting each op by the iterations of the loops enclosing it.
+class KernelCostCounter : public ir::IRMutator<const Expr*> {
+ public:
+  void operator()(const Expr* expr) { ir::IRMutator<const Expr*>::Visit(expr, expr); }
+
+  const KernelCost& cost() const { return cost_; }
+
+ private:
+  void Visit(const ir::For* op, const Expr* expr) override {
+    VisitLoop(op->extent.is_constant() ? op->extent.get_constant() : 1., op, expr);
+  }
+
+  void Visit(const ir::PolyFor* op, const Expr* expr) override {
+    Expr extent = op->ExtractExtent();
+    VisitLoop(extent.defined() && extent.is_constant() ? extent.get_constant() : 1., op, expr);
+  }
+
+  template <typename T>
+  void VisitLoop(double extent, const T* op, const Expr* expr) {
+    double outer = iterations_;
+    iterations_ *= std::max(extent, 1.);
+    ir::IRMutator<const Expr*>::Visit(op, expr);
+    iterations_ = outer;
+  }
+
+  static double Bytes(const Type& type) { return (type.bits() + 7) / 8 * std::max(type.lanes(), 1); }
+
+  void Visit(const ir::Store* op, const Expr* expr) override {
+    cost_.bytes_written += iterations_ * Bytes(op->value.type());
+    ir::IRMutator<const Expr*>::Visit(op, expr);
+  }
+
+  void Visit(const ir::Load* op, const Expr* expr) override {
+    cost_.bytes_read += iterations_ * Bytes(op->type());
+    ir::IRMutator<const Expr*>::Visit(op, expr);
+  }
+
+  // the math functions like exp and tanh count as single ops
+  void Visit(const ir::Call* op, const Expr* expr) override {
+    if (op->type().is_float() && !op->read_args.empty()) CountFlops(op->type());
+    ir::IRMutator<const Expr*>::Visit(op, expr);
+  }
+
+  void CountFlops(const Type& type) {
+    // the index and the condition arithmetic is not counted
+    if (type.is_float()) cost_.flops += iterations_ * std::max(type.lanes(), 1);
+  }
+
+#define VISIT_ARITH(op__)                                     \
+  void Visit(const ir::op__* op, const Expr* expr) override { \
+    CountFlops(op->type());                                   \
+    ir::IRMutator<const Expr*>::Visit(op, expr);              \
+  }
+  VISIT_ARITH(Add)
+  VISIT_ARITH(Sub)
+  VISIT_ARITH(Mul)
+  VISIT_ARITH(Div)
+  VISIT_ARITH(Min)
+  VISIT_ARITH(Max)
+#undef VISIT_ARITH
+
+  double iterations_{1.};
+  KernelCost cost_;
+};
+
+}  // namespace
+
+KernelCost EstimateKernelCost(const ir::LoweredFunc& func) {
+  KernelCostCounter counter;
+  counter(&func->body);
+  return counter.cost();
+}
+
+std::vector<float> ExtractScheduleFeatures(const std::vector<ir::LoweredFunc>& funcs) {
+  FeatureExtractor extractor;
+  for (auto& func : funcs) extractor.VisitFunc(func);
+  auto features = extractor.Features();
+  CHECK_EQ(features.size(), kNumScheduleFeatures);
+  return features;
+}
+
+void CostModel::Train(const std::vector<std::vector<float>>& features, const std::vector<float>& costs) {
+  CHECK_EQ(features.size(), costs.size()) << "Each sample should have a cost";
+  CHECK(!features.empty()) << "No samples to train the cost model";
+  int n = features.size();
+  std::vector<float> targets(n);
+  for (int i = 0; i < n; i++) {
+    CHECK_GT(costs[i], 0.f) << "The costs should be positive";
+    targets[i] = std::log(costs[i]);
+  }
+  base_ = std::accumulate(targets.begin(), targets.end(), 0.f) / n;
+  trees_.clear();
+
+  std::vector<float> preds(n, base_), residuals(n);
+  std::vector<int> samples(n);
+  std::iota(samples.begin(), samples.end(), 0);
+  for (int t = 0; t < options_.num_trees; t++) {
+    for (int i = 0; i < n; i++) residuals[i] = targets[i] - preds[i];
+    Tree tree;
+    BuildNode(features, residuals, samples, 0, &tree);
+    for (int i = 0; i < n; i++) preds[i] += PredictTree(tree, features[i]);
+    trees_.push_back(std::move(tree));
+  }
+  VLOG(3) << "Train the cost model of " << trees_.size() << " trees on " << n << " samples";
+}
+
+int CostModel::BuildNode(const std::vector<std::vector<float>>& features,
+                         const std::vector<float>& residuals,
+                         std::vector<int> samples,
+                         int depth,
+                         Tree* tree) const {
+  int index = tree->size();
+  tree->emplace_back();
+  double sum = 0.;
+  for (int i : samples) sum += residuals[i];
+  int n                = samples.size();
+  (*tree)[index].value = options_.learning_rate * sum / n;
+  if (depth >= options_.max_depth || n < 2 * options_.min_leaf_samples) return index;
+
+  // find the split reducing the most squared error, that is maximizing sum_l^2 / n_l + sum_r^2 / n_r
+  double best_gain     = 1e-12;
+  int best_feature     = -1;
+  float best_threshold = 0.f;
+  for (int f = 0; f < features[samples[0]].size(); f++) {
+    std::sort(samples.begin(), samples.end(), [&](int a, int b) { return features[a][f] < features[b][f]; });
+    double left_sum = 0.;
+    for (int k = 1; k < n; k++) {
+      left_sum += residuals[samples[k - 1]];
+      if (k < options_.min_leaf_samples || n - k < options_.min_leaf_samples) continue;
+      float lo = features[samples[k - 1]][f], hi = features[samples[k]][f];
+      if (lo == hi) continue;
+      double right_sum = sum - left_sum;
+      double gain      = left_sum * left_sum / k + right_sum * right_sum / (n - k) - sum * sum / n;
+      if (gain > best_gain) {
+        best_gain      = gain;
+        best_feature   = f;
+        best_threshold = (lo + hi) / 2;
+      }
+    }
+  }
+  if (best_feature < 0) return index;
+
+  std::vector<int> left, right;
+  for (int i : samples) (features[i][best_feature] < best_threshold ? left : right).push_back(i);
+  int left_index  = BuildNode(features, residuals, std::move(left), depth + 1, tree);
+  int right_index = BuildNode(features, residuals, std::move(right), depth + 1, tree);
+  auto& node      = (*tree)[index];
+  node.feature    = best_feature;
+  node.threshold  = best_threshold;
+  node.left       = left_index;
+  node.right      = right_index;
+  return index;
+}
+
+float CostModel::PredictTree(const Tree& tree, const std::vector<float>& features) {
+  int index = 0;
+  while (tree[index].feature >= 0) {
+    index = features[tree[index].feature] < tree[index].threshold ? tree[index].left : tree[index].right;
+  }
+  return tree[index].value;
+}
+
+float CostModel::Predict(const std::vector<float>& features) const {
+  float res = base_;
+  for (auto& tree : trees_) res += PredictTree(tree, features);
+  return res;
+}
+
+void CostModel::Save(const std::string& path) const {
+  std::ofstream out(path);
+  CHECK(out.good()) << "Failed to open " << path;
+  out << std::setprecision(9) << base_ << " " << trees_.size() << "\n";
+  for (auto& tree : trees_) {
+    out << tree.size() << "\n";
+    for (auto& node : tree) {
+      out << node.feature << " " << node.threshold << " " << node.left << " " << node.right << " " << node.value
+          << "\n";
+    }
+  }
+}
+
+void CostModel::Load(const std::string& path) {
+  std::ifstream in(path);
+  CHECK(in.good()) << "Failed to open " << path;
+  size_t num_trees = 0;
+  in >> base_ >> num_trees;
+  trees_.resize(num_trees);
+  for (auto& tree : trees_) {
+    size_t num_nodes = 0;
+    in >> num_nodes;
+    tree.resize(num_nodes);
+    for (auto& node : tree) in >> node.feature >> node.threshold >> node.left >> node.right >> node.value;
+  }
+  CHECK(!in.fail()) << "Failed to parse the cost model in " << path;
+}
+
+void CostModel::LoadSamples(const std::string& path,
+                            std::vector<std::vector<float>>* features,
+                            std::vector<float>* costs) {
+  std::ifstream in(path);
+  CHECK(in.good()) << "Failed to open " << path;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream ss(line);
+    float cost;
+    if (!(ss >> cost)) continue;
+    std::vector<float> sample;
+    float value;
+    while (ss >> value) sample.push_back(value);
+    CHECK_EQ(sample.size(), kNumScheduleFeatures) << "Wrong number of features in " << path << ": " << line;
+    features->push_back(std::move(sample));
+    costs->push_back(cost);
+  }
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
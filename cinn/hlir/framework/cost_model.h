@@ -0,0 +1,119 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "cinn/ir/lowered_func.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * The features of the lowered functions of a schedule, they are:
+ *  - the log of the executed stores, loads and arithmetic ops, counted by the extents of the enclosing loops,
+ *  - the max loop depth and the log of the number of loops,
+ *  - the ratios of the stores executed in vectorized, parallel and unrolled loops, the max vector lanes and the log of
+ *    the parallel extent,
+ *  - the log of the innermost extent, weighted by the stores,
+ *  - the ratios of the loads with zero, unit and other strides on the innermost loop or the vector lanes,
+ *  - the log of the GPU threads per block and the GPU blocks.
+ */
+constexpr int kNumScheduleFeatures = 16;
+std::vector<float> ExtractScheduleFeatures(const std::vector<ir::LoweredFunc>& funcs);
+
+//! The work of a lowered function, statically counted from its IR by the extents of the enclosing loops.
+struct KernelCost {
+  //! The floating point arithmetic ops and math calls, each vector op counts all its lanes.
+  double flops{0.};
+  double bytes_read{0.};
+  double bytes_written{0.};
+
+  double bytes() const { return bytes_read + bytes_written; }
+  //! The FLOPs per byte, i.e. the arithmetic intensity on the roofline.
+  double intensity() const { return bytes() > 0 ? flops / bytes() : 0.; }
+};
+
+/**
+ * Count the FLOPs and the bytes loaded and stored by \p func. Each load and store is counted as a memory access, so
+ * the bytes are an upper bound of the DRAM traffic when the data is reused in the caches.
+ */
+KernelCost EstimateKernelCost(const ir::LoweredFunc& func);
+
+/**
+ * A gradient-boosted regression tree model predicting the cost of a schedule from its features, which ranks the
+ * candidates to measure in tuning. The costs are fitted in log scale, as only their orders matter.
+ */
+class CostModel {
+ public:
+  struct Options {
+    int num_trees       = 50;
+    int max_depth       = 3;
+    float learning_rate = 0.3f;
+    // The min number of samples in a leaf.
+    int min_leaf_samples = 1;
+  };
+
+  CostModel() = default;
+  explicit CostModel(const Options& options) : options_(options) {}
+
+  //! Fit the model to the \p costs(e.g. the times in milliseconds, all positive) of the \p features.
+  void Train(const std::vector<std::vector<float>>& features, const std::vector<float>& costs);
+
+  bool trained() const { return !trees_.empty(); }
+
+  //! Predict the log cost, which keeps the order of the costs.
+  float Predict(const std::vector<float>& features) const;
+
+  void Save(const std::string& path) const;
+  void Load(const std::string& path);
+
+  /**
+   * Read the samples logged by the AutoTuner, each line is the measured time followed by the features. The samples are
+   * appended to \p features and \p costs.
+   */
+  static void LoadSamples(const std::string& path,
+                          std::vector<std::vector<float>>* features,
+                          std::vector<float>* costs);
+
+ private:
+  // The leaves have no children and hold the values, the others split the samples by feature < threshold.
+  struct TreeNode {
+    int feature{-1};
+    float threshold{0.f};
+    int left{-1};
+    int right{-1};
+    float value{0.f};
+  };
+  using Tree = std::vector<TreeNode>;
+
+  int BuildNode(const std::vector<std::vector<float>>& features,
+                const std::vector<float>& residuals,
+                std::vector<int> samples,
+                int depth,
+                Tree* tree) const;
+
+  static float PredictTree(const Tree& tree, const std::vector<float>& features);
+
+  Options options_;
+  float base_{0.f};
+  std::vector<Tree> trees_;
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
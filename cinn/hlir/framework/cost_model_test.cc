@@ -0,0 +1,192 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/cost_model.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+#include "cinn/cinn.h"
+#include "cinn/hlir/framework/auto_tuner.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+#include "cinn/hlir/pe/schedule.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+using frontend::Placeholder;
+
+std::vector<float> ExtractFeatures(const frontend::Program& program, const Target& target) {
+  auto graph = std::make_shared<Graph>(program, target);
+  ApplyPass(graph.get(), "InferShape");
+  ApplyPass(graph.get(), "OpFusion");
+  GraphCompiler gc(target, BuildScope(target, graph), graph);
+  return ExtractScheduleFeatures(gc.Lower());
+}
+
+TEST(CostModel, ExtractScheduleFeatures) {
+  Target target = common::DefaultHostTarget();
+  Placeholder A(Float(32), {16, 32}, "A");
+  Placeholder B(Float(32), {16, 32}, "B");
+  frontend::Program small;
+  small.add(A, B);
+  small.SetInputs({A, B});
+  small.Validate();
+
+  Placeholder C(Float(32), {64, 256}, "C");
+  Placeholder D(Float(32), {64, 256}, "D");
+  frontend::Program large;
+  large.add(C, D);
+  large.SetInputs({C, D});
+  large.Validate();
+
+  auto small_features = ExtractFeatures(small, target);
+  auto large_features = ExtractFeatures(large, target);
+  ASSERT_EQ(small_features.size(), kNumScheduleFeatures);
+  ASSERT_EQ(large_features.size(), kNumScheduleFeatures);
+  // the larger elementwise op stores and loads more
+  ASSERT_GT(large_features[0], small_features[0]);
+  ASSERT_GT(large_features[1], small_features[1]);
+  ASSERT_NE(small_features, large_features);
+}
+
+TEST(CostModel, EstimateKernelCost) {
+  Target target = common::DefaultHostTarget();
+  Placeholder A(Float(32), {64, 256}, "A");
+  Placeholder B(Float(32), {64, 256}, "B");
+  frontend::Program program;
+  program.add(A, B);
+  program.SetInputs({A, B});
+  program.Validate();
+
+  auto graph = std::make_shared<Graph>(program, target);
+  ApplyPass(graph.get(), "InferShape");
+  ApplyPass(graph.get(), "OpFusion");
+  GraphCompiler gc(target, BuildScope(target, graph), graph);
+  auto funcs = gc.Lower();
+  ASSERT_EQ(funcs.size(), 1UL);
+  // an add, two loads and a store of float32 per element
+  auto cost = EstimateKernelCost(funcs[0]);
+  ASSERT_EQ(cost.flops, 64 * 256);
+  ASSERT_EQ(cost.bytes_read, 2 * 64 * 256 * 4);
+  ASSERT_EQ(cost.bytes_written, 64 * 256 * 4);
+  ASSERT_DOUBLE_EQ(cost.intensity(), 1. / 12);
+}
+
+TEST(CostModel, Train) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  std::vector<std::vector<float>> features(200, std::vector<float>(kNumScheduleFeatures));
+  std::vector<float> costs;
+  for (auto& f : features) {
+    for (auto& v : f) v = dist(rng);
+    // only two of the features matter
+    costs.push_back(1.f + 4.f * f[2] + (f[5] > 0.5f ? 8.f : 0.f));
+  }
+  CostModel model;
+  ASSERT_FALSE(model.trained());
+  model.Train(features, costs);
+  ASSERT_TRUE(model.trained());
+
+  // the model ranks the samples in the order of the costs
+  int num_pairs = 0, num_ordered = 0;
+  for (int i = 0; i < features.size(); i++) {
+    for (int j = i + 1; j < features.size(); j++) {
+      if (std::abs(costs[i] - costs[j]) < 1.f) continue;
+      num_pairs++;
+      num_ordered += (costs[i] < costs[j]) == (model.Predict(features[i]) < model.Predict(features[j]));
+    }
+  }
+  ASSERT_GT(num_ordered, num_pairs * 0.9);
+
+  // the saved model predicts the same
+  std::string path = "cost_model_test.model";
+  model.Save(path);
+  CostModel loaded;
+  loaded.Load(path);
+  for (auto& f : features) ASSERT_FLOAT_EQ(loaded.Predict(f), model.Predict(f));
+  std::remove(path.c_str());
+}
+
+TEST(CostModel, LoadSamples) {
+  std::string path = "cost_model_test.samples";
+  {
+    std::ofstream os(path);
+    for (int i = 0; i < 3; i++) {
+      os << i + 1;
+      for (int j = 0; j < kNumScheduleFeatures; j++) os << " " << i * j;
+      os << "\n";
+    }
+  }
+  std::vector<std::vector<float>> features;
+  std::vector<float> costs;
+  CostModel::LoadSamples(path, &features, &costs);
+  ASSERT_EQ(features.size(), 3U);
+  ASSERT_EQ(costs, std::vector<float>({1.f, 2.f, 3.f}));
+  ASSERT_EQ(features[2][kNumScheduleFeatures - 1], 2.f * (kNumScheduleFeatures - 1));
+  std::remove(path.c_str());
+}
+
+TEST(CostModel, AutoTuner) {
+  Target target          = common::DefaultHostTarget();
+  std::string sample_log  = "cost_model_test.log";
+  std::remove(sample_log.c_str());
+  // the few input channels keep the conv from Winograd, which is not tuned
+  Placeholder A(Float(32), {1, 8, 12, 12}, "A");
+  Placeholder W(Float(32), {16, 8, 3, 3}, "W", true);
+  frontend::Program program;
+  absl::flat_hash_map<std::string, frontend::Program::attr_t> attrs;
+  attrs["stride"]   = std::vector<int>({1, 1});
+  attrs["dilation"] = std::vector<int>({1, 1});
+  attrs["padding"]  = std::vector<int>({1, 1});
+  program.conv2d(A, W, attrs);
+  program.SetInputs({A, W});
+  program.Validate();
+
+  // the samples measured without the model train it
+  AutoTuner::Options options;
+  options.max_trials = 6;
+  options.repeats    = 1;
+  options.sample_log = sample_log;
+  AutoTuner(target, options).Tune(program);
+  std::vector<std::vector<float>> features;
+  std::vector<float> costs;
+  CostModel::LoadSamples(sample_log, &features, &costs);
+  ASSERT_GT(costs.size(), 1U);
+  CostModel model;
+  model.Train(features, costs);
+
+  // only the best candidates predicted are measured with the model
+  options.cost_model   = &model;
+  options.num_measured = 2;
+  options.retune       = true;
+  options.sample_log   = "";
+  AutoTuner tuner(target, options);
+  ASSERT_EQ(tuner.Tune(program), 1);
+  ASSERT_EQ(tuner.records()[0].num_measured, 2);
+  ASSERT_LE(tuner.records()[0].time_ms, tuner.records()[0].heuristic_time_ms);
+  std::remove(sample_log.c_str());
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -145,6 +145,47 @@ TEST(GraphCompiler, RunModel) {
     EXPECT_NEAR(host_data3[i], 2 * (host_data2[i] + target_mul[i]) + 0.5, 1e-5);
   }
 }
+
+TEST(GraphCompiler, RunModelWithCudaGraph) {
+  frontend::Program prog;
+  frontend::Variable a("A");
+  frontend::Variable b("B");
+  a->shape = {32, 32};
+  b->shape = {32, 32};
+  a->type  = Float(32);
+  b->type  = Float(32);
+  // two independent branches: relu(A) and relu(B)
+  auto c = prog.relu(a);
+  auto d = prog.relu(b);
+  auto e = prog.add(c, d);
+  Target target(Target::OS::Linux, Target::Arch::NVGPU, Target::Bit::k64, {});
+  auto g = std::make_shared<Graph>(prog, target);
+  ApplyPass(g.get(), "InferShape");
+
+  auto scope = BuildScope(target, g);
+  GraphCompiler gc(target, scope, g);
+  GraphCompiler::CompileOptions options;
+  options.with_instantiate_variables = true;
+  options.num_streams                = 2;
+  options.with_cuda_graph            = true;
+  auto program                       = std::move(gc.Build(options).runtime_program);
+
+  auto A = GetTensor(scope, "A");
+  auto B = GetTensor(scope, "B");
+  CudaSetRandData(A, target);
+  CudaSetRandData(B, target);
+  // the first run warms up, the second captures and the third replays the graph.
+  for (int i = 0; i < 3; i++) {
+    program->Execute();
+  }
+  auto host_a   = CudaGetData(A, target);
+  auto host_b   = CudaGetData(B, target);
+  auto host_out = CudaGetData(GetTensor(scope, e->id), target);
+  for (int i = 0; i < host_out.size(); i++) {
+    EXPECT_NEAR(host_out[i], std::max(host_a[i], 0.f) + std::max(host_b[i], 0.f), 1e-5);
+  }
+}
+
 }  // namespace framework
 
 }  // namespace hlir
@@ -0,0 +1,105 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/device_replicas.h"
+
+#ifdef CINN_WITH_CUDA
+#include <cuda_runtime.h>
+
+#include <condition_variable>
+#include <mutex>  // NOLINT
+#include <thread>
+
+#include "cinn/backends/cuda_util.h"
+#include "cinn/runtime/cuda/cuda_util.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+DeviceReplicas::DeviceReplicas(const Program& program,
+                               const std::vector<std::string>& param_vars,
+                               const std::vector<int>& devices)
+    : devices_(devices) {
+  if (devices_.empty()) {
+    int num_devices = 0;
+    CUDA_CALL(cudaGetDeviceCount(&num_devices));
+    for (int device = 0; device < num_devices; device++) devices_.push_back(device);
+  }
+  CHECK(!devices_.empty()) << "No available devices";
+  for (int device : devices_) CHECK_LT(device, runtime::cuda::kCUDAMaxCards);
+  std::vector<std::string> copied_vars = param_vars;
+  copied_vars.insert(copied_vars.end(), program.prepacked_vars().begin(), program.prepacked_vars().end());
+
+  replicas_.resize(devices_.size());
+  for (int i = 0; i < devices_.size(); i++) {
+    // The memory of the replica is allocated on the current device of the cloning thread.
+    std::thread([&, i] {
+      runtime::cuda::SetCurrentDevice(devices_[i]);
+      replicas_[i] = program.Clone({}, copied_vars);
+      CUDA_CALL(cudaDeviceSynchronize());
+    }).join();
+    VLOG(3) << "Replicate the program on device " << devices_[i];
+  }
+  pool_.reset(new utils::ThreadPool(devices_.size()));
+}
+
+void DeviceReplicas::Execute(int i, const std::map<std::string, cinn_pod_value_t>* name2podargs) {
+  runtime::cuda::SetCurrentDevice(devices_.at(i));
+  replicas_[i]->Execute(name2podargs);
+}
+
+void DeviceReplicas::RunSlice(int i,
+                              const std::map<std::string, const void*>& inputs,
+                              const std::map<std::string, void*>& outputs) {
+  runtime::cuda::SetCurrentDevice(devices_[i]);
+  auto& scope = replicas_[i]->GetScope();
+  for (auto& item : inputs) {
+    auto tensor  = scope->GetTensor(item.first);
+    size_t bytes = tensor->num_bytes();
+    CUDA_CALL(cudaMemcpy(tensor->buffer()->memory,
+                         static_cast<const uint8_t*>(item.second) + i * bytes,
+                         bytes,
+                         cudaMemcpyHostToDevice));
+  }
+  replicas_[i]->Execute();
+  for (auto& item : outputs) {
+    auto tensor  = scope->GetTensor(item.first);
+    size_t bytes = tensor->num_bytes();
+    CUDA_CALL(cudaMemcpy(
+        static_cast<uint8_t*>(item.second) + i * bytes, tensor->buffer()->memory, bytes, cudaMemcpyDeviceToHost));
+  }
+}
+
+void DeviceReplicas::Run(const std::map<std::string, const void*>& inputs,
+                         const std::map<std::string, void*>& outputs) {
+  std::mutex mutex;
+  std::condition_variable cond;
+  int pending = size();
+  for (int i = 0; i < size(); i++) {
+    pool_->Schedule([&, i] {
+      RunSlice(i, inputs, outputs);
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--pending == 0) cond.notify_one();
+    });
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  cond.wait(lock, [&] { return pending == 0; });
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
+
+#endif  // CINN_WITH_CUDA
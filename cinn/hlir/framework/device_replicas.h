@@ -0,0 +1,92 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#ifdef CINN_WITH_CUDA
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cinn/common/macros.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/utils/thread_pool.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * DeviceReplicas runs one replica of an NVGPU program on each GPU for the data-parallel inference. The replicas share
+ * the compiled artifact: the host functions and the PTX or CUBIN are compiled once, and the kernels are loaded on each
+ * device on their first launch there. Each replica has its own variables allocated on its device, and the parameters
+ * are broadcast from the origin program once at construction.
+ *
+ * A typical usage, where the program is compiled for a batch of 8 and the host data hold size() batches:
+ *
+ *   DeviceReplicas replicas(*program, {"conv_weight", "fc_weight"});
+ *   replicas.Run({{"x", x_data}}, {{"y", y_data}});
+ *
+ * Or run replica i on a serving thread with its inputs fed by replica(i)->BindInput:
+ *
+ *   replicas.Execute(i);
+ */
+class DeviceReplicas {
+ public:
+  /**
+   * Constructor.
+   * @param program The program to replicate, with the variables instantiated on the current device.
+   * @param param_vars The variables whose data are copied to each replica, e.g. the parameters. The prepacked
+   * variables are always copied, and the others only get their own memory.
+   * @param devices The devices to place the replicas on, all the devices by default.
+   */
+  DeviceReplicas(const Program& program,
+                 const std::vector<std::string>& param_vars,
+                 const std::vector<int>& devices = {});
+
+  int size() const { return replicas_.size(); }
+  Program* replica(int i) { return replicas_.at(i).get(); }
+  int device(int i) const { return devices_.at(i); }
+
+  /**
+   * Execute replica \p i on the calling thread, the kernels are launched on its device and the call waits for them
+   * to finish. The replicas can be executed concurrently by different threads.
+   */
+  void Execute(int i, const std::map<std::string, cinn_pod_value_t>* name2podargs = nullptr);
+
+  /**
+   * Split a batch along the first dimension across the replicas and run them concurrently, then gather the outputs.
+   * The host memory of each variable in \p inputs and \p outputs holds the data of all the replicas in order, that is
+   * size() times the size of the variable in a replica, and the slice of replica i is at the i-th part.
+   */
+  void Run(const std::map<std::string, const void*>& inputs, const std::map<std::string, void*>& outputs);
+
+ private:
+  // Copy the slice of replica i in, execute it and copy its outputs out.
+  void RunSlice(int i, const std::map<std::string, const void*>& inputs, const std::map<std::string, void*>& outputs);
+
+  std::vector<int> devices_;
+  std::vector<std::unique_ptr<Program>> replicas_;
+  // The workers running the replicas in Run.
+  std::unique_ptr<utils::ThreadPool> pool_;
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(DeviceReplicas);
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
+
+#endif  // CINN_WITH_CUDA
@@ -0,0 +1,81 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/device_replicas.h"
+
+#include <cuda_runtime.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "cinn/backends/cuda_util.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+TEST(DeviceReplicas, run) {
+  frontend::Program prog;
+  frontend::Variable a("A");
+  frontend::Variable b("B");
+  Type t   = Float(32);
+  a->shape = {100, 32};
+  b->shape = {100, 32};
+  a->type  = t;
+  b->type  = t;
+  auto c   = prog.add(a, b);
+  auto d   = prog.add(c, b);
+  Target target(common::DefaultNVGPUTarget());
+
+  auto g = std::make_shared<Graph>(prog, target);
+  ApplyPass(g.get(), "InferShape");
+  auto scope = BuildScope(target, g);
+  GraphCompiler gc(target, scope, g);
+  GraphCompiler::CompileOptions options;
+  options.with_instantiate_variables = true;
+  auto&& program                     = gc.Build(options).runtime_program;
+  std::vector<float> b_host(100 * 32, 2.f);
+  auto* b_data = scope->GetTensor("B")->mutable_data<float>(target);
+  CUDA_CALL(cudaMemcpy(b_data, b_host.data(), b_host.size() * sizeof(float), cudaMemcpyHostToDevice));
+
+  DeviceReplicas replicas(*program, {"B"});
+  int num_devices = 0;
+  CUDA_CALL(cudaGetDeviceCount(&num_devices));
+  ASSERT_EQ(replicas.size(), num_devices);
+  // the parameter is broadcast to each replica, so it is not affected by the origin any more
+  CUDA_CALL(cudaMemset(b_data, 0, b_host.size() * sizeof(float)));
+
+  // each replica gets a slice of the batch filled with its index
+  std::vector<float> inputs(replicas.size() * 100 * 32), outputs(inputs.size());
+  for (int i = 0; i < inputs.size(); i++) inputs[i] = i / (100 * 32);
+  replicas.Run({{"A", inputs.data()}}, {{d->id, outputs.data()}});
+  for (int i = 0; i < outputs.size(); i++) {
+    ASSERT_NEAR(outputs[i], inputs[i] + 2 * 2.f, 1e-5);
+  }
+
+  // the replicas can also be executed by the serving threads directly
+  std::vector<std::thread> threads;
+  for (int i = 0; i < replicas.size(); i++) {
+    threads.emplace_back([&, i] { replicas.Execute(i); });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
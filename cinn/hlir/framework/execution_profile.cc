@@ -0,0 +1,299 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/execution_profile.h"
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+
+#include "cinn/utils/string.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+
+std::vector<std::string> SplitFields(const std::string& line, char sep) {
+  std::vector<std::string> fields;
+  std::stringstream ss(line);
+  std::string field;
+  while (std::getline(ss, field, sep)) fields.push_back(field);
+  // the trailing empty field is dropped by getline
+  if (!line.empty() && line.back() == sep) fields.emplace_back();
+  return fields;
+}
+
+// The names of the variables in the shapes of the profile args, e.g. "x, y" of "x[2,3], y[3]".
+std::vector<std::string> ArgNames(const std::string& shapes) {
+  std::vector<std::string> names;
+  int depth = 0;
+  std::string name;
+  for (char c : shapes) {
+    if (c == '[') depth++;
+    if (depth == 0 && c != ',' && c != ' ') name += c;
+    if (c == ']') depth--;
+    if (depth == 0 && c == ',' && !name.empty()) {
+      names.push_back(name);
+      name.clear();
+    }
+  }
+  if (!name.empty()) names.push_back(name);
+  return names;
+}
+
+}  // namespace
+
+void ExecutionProfile::AddGroup(const std::string& key, const Group& group) {
+  auto it = groups_.find(key);
+  if (it == groups_.end()) {
+    groups_.emplace(key, group);
+    return;
+  }
+  auto& res = it->second;
+  res.count += group.count;
+  res.total_us += group.total_us;
+  res.max_us = std::max(res.max_us, group.max_us);
+}
+
+void ExecutionProfile::AddEvents(const Profiler& profiler) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& event : profiler.events()) {
+    if (event.category != "instruction") continue;
+    Group group;
+    group.function_name = event.name;
+    auto nodes          = event.args.find("nodes");
+    if (nodes != event.args.end()) group.node_ids = SplitFields(nodes->second, ',');
+    auto outputs = event.args.find("outputs");
+    if (outputs != event.args.end()) group.outputs = ArgNames(outputs->second);
+    auto inputs = event.args.find("inputs");
+    if (inputs != event.args.end()) group.shapes = inputs->second;
+    group.count    = 1;
+    group.total_us = event.duration_us;
+    group.max_us   = event.duration_us;
+    AddGroup(group.node_ids.empty() ? event.name : utils::Join(group.node_ids, ","), group);
+  }
+}
+
+void ExecutionProfile::RecordInputShape(const std::string& name, const shape_t& shape, int64_t count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  input_shapes_[name][shape] += count;
+}
+
+void ExecutionProfile::Merge(const ExecutionProfile& other) {
+  CHECK_NE(&other, this);
+  std::map<std::string, Group> groups;
+  std::map<std::string, std::map<shape_t, int64_t>> input_shapes;
+  std::set<std::string> unfused_nodes;
+  {
+    std::lock_guard<std::mutex> lock(other.mutex_);
+    groups        = other.groups_;
+    input_shapes  = other.input_shapes_;
+    unfused_nodes = other.unfused_nodes_;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& item : groups) AddGroup(item.first, item.second);
+  for (auto& item : input_shapes) {
+    for (auto& shape : item.second) input_shapes_[item.first][shape.first] += shape.second;
+  }
+  unfused_nodes_.insert(unfused_nodes.begin(), unfused_nodes.end());
+}
+
+std::vector<ExecutionProfile::Group> ExecutionProfile::HottestGroups() const {
+  std::vector<Group> res;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& item : groups_) res.push_back(item.second);
+  }
+  std::stable_sort(res.begin(), res.end(), [](const Group& a, const Group& b) { return a.total_us > b.total_us; });
+  return res;
+}
+
+double ExecutionProfile::TotalTime(const std::string& id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  double res = 0.;
+  for (auto& item : groups_) {
+    auto& group = item.second;
+    if (std::find(group.node_ids.begin(), group.node_ids.end(), id) != group.node_ids.end() ||
+        std::find(group.outputs.begin(), group.outputs.end(), id) != group.outputs.end()) {
+      res += group.total_us;
+    }
+  }
+  return res;
+}
+
+std::map<shape_t, int64_t> ExecutionProfile::input_shapes(const std::string& name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = input_shapes_.find(name);
+  return it == input_shapes_.end() ? std::map<shape_t, int64_t>() : it->second;
+}
+
+std::vector<int> ExecutionProfile::ChooseBatchBuckets(const std::string& name, int max_buckets) const {
+  CHECK_GT(max_buckets, 0);
+  std::map<int, int64_t> batch_counts;
+  for (auto& item : input_shapes(name)) {
+    if (!item.first.empty() && item.first[0] > 0) batch_counts[item.first[0]] += item.second;
+  }
+  if (batch_counts.empty()) return {};
+  std::vector<int> sizes;
+  std::vector<int64_t> counts;
+  for (auto& item : batch_counts) {
+    sizes.push_back(item.first);
+    counts.push_back(item.second);
+  }
+  int n = sizes.size();
+  int k = std::min(max_buckets, n);
+  // pad(l, r) is the padding of the batches l..r run in the bucket of sizes[r]
+  auto pad = [&](int l, int r) {
+    double res = 0.;
+    for (int i = l; i <= r; i++) res += static_cast<double>(counts[i]) * (sizes[r] - sizes[i]);
+    return res;
+  };
+  // cost[j][r] is the least padding of the batches 0..r in j + 1 buckets with the largest one of sizes[r], and
+  // from[j][r] is the last batch in the previous bucket
+  const double kInf = std::numeric_limits<double>::infinity();
+  std::vector<std::vector<double>> cost(k, std::vector<double>(n, kInf));
+  std::vector<std::vector<int>> from(k, std::vector<int>(n, -1));
+  for (int r = 0; r < n; r++) cost[0][r] = pad(0, r);
+  for (int j = 1; j < k; j++) {
+    for (int r = j; r < n; r++) {
+      for (int l = j - 1; l < r; l++) {
+        double c = cost[j - 1][l] + pad(l + 1, r);
+        if (c < cost[j][r]) {
+          cost[j][r] = c;
+          from[j][r] = l;
+        }
+      }
+    }
+  }
+  int best = 0;
+  for (int j = 1; j < k; j++) {
+    if (cost[j][n - 1] < cost[best][n - 1]) best = j;
+  }
+  std::vector<int> res;
+  for (int j = best, r = n - 1; j >= 0 && r >= 0; r = from[j][r], j--) res.push_back(sizes[r]);
+  std::reverse(res.begin(), res.end());
+  VLOG(3) << "Choose the batch buckets [" << utils::Join(res, ", ") << "] of " << name << " with the padding of "
+          << cost[best][n - 1] << " samples";
+  return res;
+}
+
+std::vector<std::vector<std::string>> ExecutionProfile::FindSlowFusions(const ExecutionProfile& unfused,
+                                                                       float margin) const {
+  // the mean time of each node unfused
+  absl::flat_hash_map<std::string, double> node_us;
+  for (auto& group : unfused.HottestGroups()) {
+    if (group.node_ids.size() == 1) node_us[group.node_ids[0]] += group.mean_us();
+  }
+  std::vector<std::vector<std::string>> res;
+  for (auto& group : HottestGroups()) {
+    if (group.node_ids.size() < 2) continue;
+    double parts_us = 0.;
+    bool measured   = false;
+    for (auto& id : group.node_ids) {
+      auto it = node_us.find(id);
+      if (it == node_us.end()) continue;
+      parts_us += it->second;
+      measured = true;
+    }
+    if (!measured || group.mean_us() <= parts_us * (1. + margin)) continue;
+    LOG(INFO) << "The fused group of [" << utils::Join(group.node_ids, ", ") << "] takes " << group.mean_us()
+              << " us, slower than its parts of " << parts_us << " us";
+    res.push_back(group.node_ids);
+  }
+  return res;
+}
+
+void ExecutionProfile::AddUnfusedNodes(const std::vector<std::vector<std::string>>& groups) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& group : groups) unfused_nodes_.insert(group.begin(), group.end());
+}
+
+std::set<std::string> ExecutionProfile::unfused_nodes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return unfused_nodes_;
+}
+
+void ExecutionProfile::ApplyToGraph(Graph* graph) const {
+  CHECK(graph);
+  auto nodes = unfused_nodes();
+  graph->attrs["unfused_nodes"] =
+      std::make_shared<absl::any>(absl::flat_hash_set<std::string>(nodes.begin(), nodes.end()));
+}
+
+void ExecutionProfile::Save(const std::string& path) const {
+  std::ofstream os(path);
+  CHECK(os.good()) << "Failed to open " << path;
+  os.precision(std::numeric_limits<double>::max_digits10);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& item : groups_) {
+    auto& group = item.second;
+    os << "group\t" << group.function_name << "\t" << utils::Join(group.node_ids, ",") << "\t"
+       << utils::Join(group.outputs, ",") << "\t" << group.shapes << "\t" << group.count << "\t" << group.total_us
+       << "\t" << group.max_us << "\n";
+  }
+  for (auto& item : input_shapes_) {
+    for (auto& shape : item.second) {
+      os << "input\t" << item.first << "\t" << utils::Join(shape.first, ",") << "\t" << shape.second << "\n";
+    }
+  }
+  for (auto& id : unfused_nodes_) os << "unfused\t" << id << "\n";
+  CHECK(os.good()) << "Failed to write " << path;
+}
+
+void ExecutionProfile::Load(const std::string& path) {
+  std::ifstream is(path);
+  CHECK(is.good()) << "Failed to open " << path;
+  auto split = [](const std::string& field) {
+    return field.empty() ? std::vector<std::string>() : SplitFields(field, ',');
+  };
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string line;
+  while (std::getline(is, line)) {
+    if (line.empty()) continue;
+    auto fields = SplitFields(line, '\t');
+    if (fields[0] == "group") {
+      CHECK_EQ(fields.size(), 8UL) << "Bad record in " << path << ": " << line;
+      Group group;
+      group.function_name = fields[1];
+      group.node_ids      = split(fields[2]);
+      group.outputs       = split(fields[3]);
+      group.shapes        = fields[4];
+      group.count         = std::stoll(fields[5]);
+      group.total_us      = std::stod(fields[6]);
+      group.max_us        = std::stod(fields[7]);
+      AddGroup(group.node_ids.empty() ? group.function_name : fields[2], group);
+    } else if (fields[0] == "input") {
+      CHECK_EQ(fields.size(), 4UL) << "Bad record in " << path << ": " << line;
+      shape_t shape;
+      for (auto& dim : split(fields[2])) shape.push_back(std::stoi(dim));
+      input_shapes_[fields[1]][shape] += std::stoll(fields[3]);
+    } else if (fields[0] == "unfused") {
+      CHECK_EQ(fields.size(), 2UL) << "Bad record in " << path << ": " << line;
+      unfused_nodes_.insert(fields[1]);
+    } else {
+      LOG(FATAL) << "Unknown record in " << path << ": " << line;
+    }
+  }
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
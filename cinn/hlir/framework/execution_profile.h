@@ -0,0 +1,143 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/profiler.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * ExecutionProfile aggregates what a program does in production to guide its recompilation offline: the time of each
+ * fused group, keyed by the ids of its graph nodes so that it matches the graph built again from the same program,
+ * and the distribution of the shapes of the inputs fed by the real traffic.
+ *
+ * The offline loop from a production profile to a tuned artifact:
+ *
+ *   // in production, with the program profiled and the requests recorded, see RequestBatcher::Options::profile
+ *   program->EnableProfiling();
+ *   ...
+ *   profile.AddEvents(*program->profiler());
+ *   profile.Save("model.profile");
+ *
+ *   // offline, tune the hottest convs, choose the buckets of the traffic and keep the slow fusions apart
+ *   ExecutionProfile profile;
+ *   profile.Load("model.profile");
+ *   AutoTuner::Options options;
+ *   options.profile   = &profile;
+ *   options.max_tuned = 8;
+ *   AutoTuner(target, options).Tune(program);
+ *   auto batch_sizes = profile.ChooseBatchBuckets("x", 4);
+ *   profile.AddUnfusedNodes(profile.FindSlowFusions(unfused_profile));
+ *   profile.ApplyToGraph(graph.get());  // before OpFusion
+ *
+ * where unfused_profile is measured by running the program with every node in the unfused nodes of the graph. The
+ * profile is saved as text, see Save.
+ */
+class ExecutionProfile {
+ public:
+  //! The runs of a fused group, i.e. an instruction.
+  struct Group {
+    std::string function_name;
+    //! The ids of the fused graph nodes, empty if the instruction is not from a graph.
+    std::vector<std::string> node_ids;
+    //! The names of the variables written.
+    std::vector<std::string> outputs;
+    //! The shapes of the arguments like "x[2,3], w[3,4]", which tell the hot shapes.
+    std::string shapes;
+    int64_t count{};
+    double total_us{};
+    double max_us{};
+
+    double mean_us() const { return count ? total_us / count : 0.; }
+  };
+
+  ExecutionProfile() = default;
+
+  //! Aggregate the finished "instruction" events of \p profiler, each of which is a run of its group.
+  void AddEvents(const Profiler& profiler);
+
+  //! Record that the input \p name is fed in \p shape by \p count requests, it can be called by many threads.
+  void RecordInputShape(const std::string& name, const shape_t& shape, int64_t count = 1);
+
+  //! Add the runs and the shapes of \p other, e.g. the profile of another process.
+  void Merge(const ExecutionProfile& other);
+
+  //! Get the groups in the descending order of their total time.
+  std::vector<Group> HottestGroups() const;
+
+  //! Get the total time in microseconds of the groups which fuse the node \p id or write the variable \p id.
+  double TotalTime(const std::string& id) const;
+
+  //! Get the observed shapes of the input \p name with the number of requests in each.
+  std::map<shape_t, int64_t> input_shapes(const std::string& name) const;
+
+  /**
+   * Choose at most \p max_buckets batch sizes for the input \p name, which minimize the padding of the observed
+   * requests if each is run in the smallest bucket holding its batch, i.e. the first dimension of its shape. The
+   * largest observed batch is always a bucket, and the sizes are in the ascending order.
+   */
+  std::vector<int> ChooseBatchBuckets(const std::string& name, int max_buckets) const;
+
+  /**
+   * Find the fused groups which run slower than their parts, whose times are in \p unfused, the profile of the same
+   * traffic with the nodes unfused. A group is slow if its mean time exceeds the sum of the mean times of its nodes by
+   * more than \p margin of the latter.
+   * @return The node ids of each slow group.
+   */
+  std::vector<std::vector<std::string>> FindSlowFusions(const ExecutionProfile& unfused, float margin = 0.05) const;
+
+  //! Keep the nodes of \p groups out of the fusion in the recompilation.
+  void AddUnfusedNodes(const std::vector<std::vector<std::string>>& groups);
+  std::set<std::string> unfused_nodes() const;
+
+  //! Save the unfused nodes to the graph attribute "unfused_nodes", which OpFusion respects. It should be applied
+  //! before OpFusion.
+  void ApplyToGraph(Graph* graph) const;
+
+  /**
+   * Save the profile as text, a record per line with the tab separated fields:
+   *   group <function name> <node ids> <outputs> <shapes> <count> <total us> <max us>
+   *   input <name> <shape> <count>
+   *   unfused <node id>
+   * where the lists are separated by commas.
+   */
+  void Save(const std::string& path) const;
+
+  //! Load the profile saved by Save and merge it into this one.
+  void Load(const std::string& path);
+
+ private:
+  void AddGroup(const std::string& key, const Group& group);
+
+  // The groups by the node ids joined, or the function names of the instructions not from a graph.
+  std::map<std::string, Group> groups_;
+  std::map<std::string, std::map<shape_t, int64_t>> input_shapes_;
+  std::set<std::string> unfused_nodes_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,138 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/execution_profile.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/instruction.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+void EmptyProfiledKernel(void* args, int32_t num_args) {}
+
+TEST(ExecutionProfile, events) {
+  Scope scope;
+  for (auto& name : std::vector<std::string>({"x", "y"})) {
+    auto* var    = scope.Var<Tensor>(name);
+    auto& tensor = absl::get<Tensor>(*var);
+    tensor->Resize(Shape{{2, 3}});
+  }
+  auto target = common::DefaultHostTarget();
+  Instruction instr(target, &scope, {"x"}, {"y"}, "fn_relu_0");
+  instr.SetLoweredFunc(&EmptyProfiledKernel, "fn_relu_0");
+  instr.SetNodeIds({"relu_0"});
+
+  Profiler profiler;
+  instr.SetProfiler(&profiler);
+  for (int i = 0; i < 3; i++) instr.Run();
+  profiler.Synchronize();
+
+  ExecutionProfile profile;
+  profile.AddEvents(profiler);
+  profile.RecordInputShape("x", {2, 3}, 3);
+  auto groups = profile.HottestGroups();
+  ASSERT_EQ(groups.size(), 1UL);
+  ASSERT_EQ(groups[0].node_ids, std::vector<std::string>({"relu_0"}));
+  ASSERT_EQ(groups[0].outputs, std::vector<std::string>({"y"}));
+  ASSERT_EQ(groups[0].shapes, "x[2,3]");
+  ASSERT_EQ(groups[0].count, 3);
+  // the group is found by its node or the variable it writes
+  ASSERT_EQ(profile.TotalTime("relu_0"), groups[0].total_us);
+  ASSERT_EQ(profile.TotalTime("y"), groups[0].total_us);
+  ASSERT_EQ(profile.TotalTime("x"), 0.);
+
+  // the saved profile is merged when loaded
+  std::string path = "./execution_profile_test.profile";
+  profile.Save(path);
+  ExecutionProfile loaded;
+  loaded.Load(path);
+  loaded.Load(path);
+  auto loaded_groups = loaded.HottestGroups();
+  ASSERT_EQ(loaded_groups.size(), 1UL);
+  ASSERT_EQ(loaded_groups[0].count, 6);
+  ASSERT_NEAR(loaded_groups[0].total_us, groups[0].total_us * 2, 1e-6);
+  ASSERT_EQ(loaded_groups[0].outputs, groups[0].outputs);
+  ASSERT_EQ(loaded.input_shapes("x").at({2, 3}), 6);
+}
+
+TEST(ExecutionProfile, batch_buckets) {
+  ExecutionProfile profile;
+  ASSERT_TRUE(profile.ChooseBatchBuckets("x", 3).empty());
+  std::vector<std::pair<int, int>> batches = {{1, 50}, {2, 30}, {3, 5}, {7, 10}, {8, 5}, {16, 1}};
+  for (auto& batch : batches) profile.RecordInputShape("x", {batch.first, 32}, batch.second);
+  // the buckets padding the fewest samples, with the largest batch always one of them
+  ASSERT_EQ(profile.ChooseBatchBuckets("x", 1), std::vector<int>({16}));
+  ASSERT_EQ(profile.ChooseBatchBuckets("x", 3), std::vector<int>({2, 8, 16}));
+  ASSERT_EQ(profile.ChooseBatchBuckets("x", 8), std::vector<int>({1, 2, 3, 7, 8, 16}));
+}
+
+TEST(ExecutionProfile, slow_fusions) {
+  frontend::Placeholder A(Float(32), {32, 64}, "A");
+  frontend::Placeholder B(Float(32), {32, 64}, "B");
+  frontend::Program program;
+  auto c = program.elementwise_add(A, B);
+  auto d = program.relu(c);
+  program.SetInputs({A, B});
+  program.Validate();
+  auto target = common::DefaultHostTarget();
+
+  auto graph = std::make_shared<Graph>(program, target);
+  ApplyPass(graph.get(), "InferShape");
+  ApplyPass(graph.get(), "OpFusion");
+  ASSERT_EQ(graph->groups.size(), 1UL);
+  ASSERT_EQ(graph->groups[0].size(), 2UL);
+  std::string add_id  = graph->groups[0][0]->id();
+  std::string relu_id = graph->groups[0][1]->id();
+
+  // the fused group takes 10us while its parts take 3us and 4us
+  std::string fused_path   = "./execution_profile_test_fused.profile";
+  std::string unfused_path = "./execution_profile_test_unfused.profile";
+  std::ofstream(fused_path) << "group\tfn_fused\t" << add_id << "," << relu_id << "\t" << d->id << "\t\t2\t20\t11\n";
+  std::ofstream(unfused_path) << "group\tfn_add\t" << add_id << "\t" << c->id << "\t\t2\t6\t3\n"
+                              << "group\tfn_relu\t" << relu_id << "\t" << d->id << "\t\t2\t8\t4\n";
+  ExecutionProfile fused, unfused;
+  fused.Load(fused_path);
+  unfused.Load(unfused_path);
+  auto slow = fused.FindSlowFusions(unfused);
+  ASSERT_EQ(slow.size(), 1UL);
+  ASSERT_EQ(slow[0], std::vector<std::string>({add_id, relu_id}));
+  // not slower beyond the margin
+  ASSERT_TRUE(fused.FindSlowFusions(unfused, 0.5).empty());
+
+  // the graph built again from the program has the same node ids, and keeps them apart
+  fused.AddUnfusedNodes(slow);
+  auto recompiled = std::make_shared<Graph>(program, target);
+  ApplyPass(recompiled.get(), "InferShape");
+  fused.ApplyToGraph(recompiled.get());
+  ApplyPass(recompiled.get(), "OpFusion");
+  ASSERT_EQ(recompiled->groups.size(), 2UL);
+  ASSERT_EQ(recompiled->groups[0][0]->id(), add_id);
+  ASSERT_EQ(recompiled->groups[1][0]->id(), relu_id);
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
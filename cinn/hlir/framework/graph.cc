@@ -14,6 +14,8 @@
 
 #include "cinn/hlir/framework/graph.h"
 
+#include <algorithm>
+
 namespace cinn {
 namespace hlir {
 namespace framework {
@@ -55,6 +57,17 @@ Graph::Graph(const frontend::Program& prog, const Target& target) {
   this->attrs["inferdtype"] = std::make_shared<absl::any>(dtype_dict);
 }
 
+Graph::Graph(const frontend::Program& prog, const std::unordered_set<std::string>& fetch_var_ids, const Target& target)
+    : Graph(prog, target) {
+  for (auto& id : fetch_var_ids) {
+    auto* node = this->RetrieveNode(id);
+    CHECK(node && node->safe_as<NodeData>()) << "The variable to fetch [" << id << "] is not in the program";
+    outputs.push_back(node->safe_as<NodeData>());
+  }
+  // the set is unordered, sort the outputs to keep the passes deterministic
+  std::sort(outputs.begin(), outputs.end(), [](NodeData* a, NodeData* b) { return a->id() < b->id(); });
+}
+
 }  // namespace framework
 }  // namespace hlir
 }  // namespace cinn
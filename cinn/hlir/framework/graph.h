@@ -18,6 +18,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "cinn/common/graph_utils.h"
@@ -35,6 +36,9 @@ namespace framework {
 class Graph : public cinn::common::Graph {
  public:
   Graph(const frontend::Program& prog, const Target& target);
+  //! The variables in \p fetch_var_ids are declared as the outputs of the graph, the passes keep the nodes computing
+  //! them and may drop the others.
+  Graph(const frontend::Program& prog, const std::unordered_set<std::string>& fetch_var_ids, const Target& target);
 
   Target target_;
   /** \brief outputs of the computation graph. */
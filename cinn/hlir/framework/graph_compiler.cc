@@ -15,19 +15,136 @@
 #include "cinn/hlir/framework/graph_compiler.h"
 
 #include <absl/container/flat_hash_map.h>
+#include <gflags/gflags.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <mutex>  // NOLINT
+#include <numeric>
+#include <sstream>
 #include <unordered_set>
 
 #include "cinn/backends/codegen_cuda_dev.h"
+#include "cinn/common/context.h"
+#include "cinn/common/precision.h"
 #include "cinn/hlir/framework/instruction.h"
+#include "cinn/hlir/framework/program_artifact.h"
 #include "cinn/hlir/framework/tensor.h"
 #include "cinn/hlir/pe/schedule.h"
+#include "cinn/hlir/pe/transform.h"
 #include "cinn/lang/lower.h"
 #include "cinn/poly/stage.h"
+#include "cinn/runtime/cpu/thread_backend.h"
+#include "cinn/utils/compile_tracer.h"
+#include "cinn/utils/thread_pool.h"
+
+#ifdef CINN_WITH_CUDA
+#include "cinn/runtime/cuda/cuda_util.h"
+#endif
+
+DEFINE_int32(cinn_priority_yield_max_us,
+             2000,
+             "The longest time in microseconds a program run waits between two instructions for the runs of higher "
+             "priorities in progress, so that the bulk runs still progress under the latency-critical load, 0 to never "
+             "yield.");
 
 namespace cinn {
 namespace hlir {
 namespace framework {
+// The name of the host function calling the kernels of a whole program.
+constexpr char kFusedHostFunctionName[] = "fn_fused_host_entry";
+
+namespace {
+// The program runs of the positive priorities in progress in the process, which the runs of lower priorities yield
+// to between their instructions.
+class PriorityGate {
+ public:
+  static PriorityGate& Global() {
+    static auto* gate = new PriorityGate;
+    return *gate;
+  }
+
+  void Enter(int priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    counts_[priority]++;
+    highest_ = counts_.rbegin()->first;
+  }
+
+  void Leave(int priority) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--counts_[priority] == 0) counts_.erase(priority);
+      highest_ = counts_.empty() ? 0 : counts_.rbegin()->first;
+    }
+    cond_.notify_all();
+  }
+
+  // Wait while a run of a higher priority than \p priority is in progress, for FLAGS_cinn_priority_yield_max_us at
+  // most.
+  void Yield(int priority) {
+    if (highest_.load(std::memory_order_relaxed) <= priority || FLAGS_cinn_priority_yield_max_us <= 0) return;
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait_for(lock, std::chrono::microseconds(FLAGS_cinn_priority_yield_max_us), [&] {
+      return highest_.load(std::memory_order_relaxed) <= priority;
+    });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::map<int, int> counts_;
+  std::atomic<int> highest_{0};
+};
+
+// Run at \p priority while it is alive: the parallel kernels launched by the thread take the priority, and the runs
+// of lower priorities yield to it if it is positive.
+class RunPriorityScope {
+ public:
+  explicit RunPriorityScope(int priority) : priority_(priority) {
+    prev_priority_ = cinn_set_thread_launch_priority(priority);
+    if (priority_ > 0) PriorityGate::Global().Enter(priority_);
+  }
+  ~RunPriorityScope() {
+    if (priority_ > 0) PriorityGate::Global().Leave(priority_);
+    cinn_set_thread_launch_priority(prev_priority_);
+  }
+
+ private:
+  int priority_;
+  int prev_priority_;
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(RunPriorityScope);
+};
+
+int64_t SteadyClockUs() {
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+// Hold the run lock of a program while it executes, and record when the execution finishes.
+class ExecuteScope {
+ public:
+  ExecuteScope(std::mutex* mutex, std::atomic<int64_t>* last_run_us) : lock_(*mutex), last_run_us_(last_run_us) {}
+  ~ExecuteScope() { last_run_us_->store(SteadyClockUs(), std::memory_order_relaxed); }
+
+ private:
+  std::lock_guard<std::mutex> lock_;
+  std::atomic<int64_t>* last_run_us_;
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(ExecuteScope);
+};
+}  // namespace
+
 // Store params from node to instruction
 void AddAttrs(const absl::flat_hash_map<std::string, AttrType>& attrs_store,
               const std::vector<std::string>& attrs_name,
@@ -53,7 +170,7 @@ void AddAttrs(const absl::flat_hash_map<std::string, AttrType>& attrs_store,
 }
 
 Program::Program(const std::shared_ptr<Scope>& scope, std::vector<std::unique_ptr<Instruction>>&& instrs)
-    : scope_(scope) {
+    : scope_(scope), last_run_us_(SteadyClockUs()) {
   for (auto& ins : instrs) {
     if (ins->pre_run) {
       prerun_instrs_.push_back(std::move(ins));
@@ -61,14 +178,124 @@ Program::Program(const std::shared_ptr<Scope>& scope, std::vector<std::unique_pt
       instrs_.push_back(std::move(ins));
     }
   }
+  // The slots are assigned before running, as the instructions may run concurrently.
+  for (auto* instrs : {&prerun_instrs_, &instrs_}) {
+    for (auto& ins : *instrs) ins->ResolveArgSlots();
+  }
+}
+
+void Program::InstantiateLazyVars() const {
+  if (lazy_vars_.empty() && !trimmed_) return;
+  const Target& target = instrs_.empty() ? prerun_instrs_.front()->target_ : instrs_.front()->target_;
+  // the planned variables released by Trim take the same offsets in the arena allocated again
+  if (trimmed_arena_size_) {
+    if (target == common::DefaultHostTarget()) {
+      memory_arena_->Resize(MemoryPlanner::kAlignment, trimmed_arena_size_);
+    } else {
+      memory_arena_->Resize(trimmed_arena_size_);
+    }
+    auto* memory = memory_arena_->data()->memory;
+    CHECK(memory) << "Failed to allocate memory arena of " << trimmed_arena_size_ << " bytes";
+    for (auto& item : trimmed_arena_vars_) {
+      scope_->GetTensor(item.first)->share_external_data(memory + item.second, target);
+    }
+    trimmed_arena_vars_.clear();
+    trimmed_arena_size_ = 0;
+  }
+  for (auto& name : lazy_vars_) {
+    auto tensor = scope_->GetTensor(name);
+    // the views share the buffers, which may be allocated by others already
+    if (!tensor->buffer()->memory) tensor->mutable_data(target);
+  }
+  VLOG(3) << "Instantiate " << lazy_vars_.size() << " lazy variables";
+  lazy_vars_.clear();
+  for (auto& name : trimmed_slices_) {
+    auto& slice = slice_vars_.at(name);
+    auto root   = scope_->GetTensor(slice.root);
+    // the roots bound after Trim keep their own memory released
+    if (root->buffer()->memory) scope_->GetTensor(name)->ShareSliceOf(*root, slice.offset, target);
+  }
+  trimmed_slices_.clear();
+  trimmed_ = false;
 }
 
 void Program::PreRun(const std::map<std::string, cinn_pod_value_t>* name2podargs) {
+  TenantScope tenant_scope(tenant_);
+  InstantiateLazyVars();
   for (auto& ins : prerun_instrs_) {
     ins->Run(name2podargs);
   }
 }
 
+std::vector<std::string> Program::PrePack(const std::unordered_set<std::string>& keep_vars) {
+  PreRun();
+  std::unordered_set<std::string> run_vars;
+  for (auto& instr : instrs_) {
+    for (auto& args : instr->GetInArgs()) run_vars.insert(args.begin(), args.end());
+    for (auto& args : instr->GetOutArgs()) run_vars.insert(args.begin(), args.end());
+  }
+
+  std::vector<std::string> dropped_vars;
+  std::unordered_set<std::string> visited;
+  for (auto& instr : prerun_instrs_) {
+    for (auto& args : instr->GetInArgs()) {
+      for (auto& name : args) {
+        if (run_vars.count(name) || keep_vars.count(name) || !visited.insert(name).second) continue;
+        if (scope_->EraseVar(name)) dropped_vars.push_back(name);
+      }
+    }
+    for (auto& args : instr->GetOutArgs()) {
+      for (auto& name : args) {
+        if (!visited.insert(name).second) continue;
+        if (run_vars.count(name) || keep_vars.count(name)) {
+          prepacked_vars_.push_back(name);
+        } else if (scope_->EraseVar(name)) {
+          dropped_vars.push_back(name);
+        }
+      }
+    }
+  }
+  VLOG(3) << "PrePack " << prerun_instrs_.size() << " instructions, keep " << prepacked_vars_.size()
+          << " prepacked variables and drop " << dropped_vars.size()
+          << " variables: " << utils::Join(dropped_vars, ", ");
+  prerun_instrs_.clear();
+  return dropped_vars;
+}
+
+void Program::PackParams(const std::vector<std::string>& params) {
+  CHECK(!param_arena_) << "The parameters of the program are packed already";
+  CHECK(!instrs_.empty() || !prerun_instrs_.empty()) << "The program is empty";
+  const Target& target = instrs_.empty() ? prerun_instrs_.front()->target_ : instrs_.front()->target_;
+  std::unordered_set<std::string> candidates(params.begin(), params.end());
+  candidates.insert(prepacked_vars_.begin(), prepacked_vars_.end());
+  // the views and the slices follow the buffers they refer to
+  for (auto& item : view_vars_) candidates.erase(item.first);
+  for (auto& item : slice_vars_) candidates.erase(item.first);
+
+  std::vector<std::string> ordered;
+  std::unordered_set<std::string> visited;
+  for (auto* instrs : {&prerun_instrs_, &instrs_}) {
+    for (auto& instr : *instrs) {
+      for (auto& args : instr->GetInArgs()) {
+        for (auto& name : args) {
+          if (candidates.count(name) && visited.insert(name).second) ordered.push_back(name);
+        }
+      }
+    }
+  }
+  // the parameters not read by any instruction go last
+  for (auto& name : params) {
+    if (candidates.count(name) && visited.insert(name).second) ordered.push_back(name);
+  }
+  param_arena_ = scope_->PackTensors(ordered, target);
+  if (!param_arena_) return;
+  for (auto& item : slice_vars_) {
+    if (!visited.count(item.second.root)) continue;
+    scope_->GetTensor(item.first)->ShareSliceOf(*scope_->GetTensor(item.second.root), item.second.offset, target);
+  }
+  VLOG(3) << "Pack " << ordered.size() << " parameters into the arena of " << param_arena_->size() << " bytes";
+}
+
 void Program::Export(const std::vector<std::string>& persistent_vars, const std::string& filename) {
   auto writeplaceholder = [=](int s, int n, FILE* f) -> int {
     int pos = ftell(f);
@@ -145,9 +372,8 @@ void Program::Export(const std::vector<std::string>& persistent_vars, const std:
   // persistent_buffers
   int pbuffer = writeplaceholder(4, 1, f);
   for (auto& p : pvars) {
-    if (p.first->align) {
-      padding(p.first->align, 0, f);
-    }
+    // the loader aligns the program to 64 bytes
+    padding(std::max<int>(p.first->align, 64), 0, f);
     tellplaceholder(p.second, f);
     fwrite(p.first->memory, p.first->memory_size, 1, f);
   }
@@ -192,15 +418,1080 @@ void Program::Export(const std::vector<std::string>& persistent_vars, const std:
   fclose(f);
 }
 
-void Program::Execute(const std::map<std::string, cinn_pod_value_t>* name2podargs) {
-  for (auto& ins : instrs_) {
-    ins->Run(name2podargs);
+namespace {
+// The C type of the elements of \p type in the header of an exported library.
+std::string CTypeOf(const Type& type) {
+  if (type.is_float(32)) return "float";
+  if (type.is_float(64)) return "double";
+  // the float16 values are passed by their bits
+  if (type.is_float(16)) return "uint16_t";
+  if (type.is_bool()) return "uint8_t";
+  for (int bits : {8, 16, 32, 64}) {
+    if (type.is_int(bits)) return "int" + std::to_string(bits) + "_t";
+    if (type.is_uint(bits)) return "uint" + std::to_string(bits) + "_t";
+  }
+  LOG(FATAL) << "The type " << type << " is not supported by the exported libraries";
+  return "";
+}
+
+// The C identifier of the variable \p name.
+std::string CIdentifierOf(const std::string& name) {
+  std::string res = name;
+  for (auto& c : res) {
+    if (!std::isalnum(static_cast<unsigned char>(c))) c = '_';
+  }
+  return std::isdigit(static_cast<unsigned char>(res[0])) ? "_" + res : res;
+}
+}  // namespace
+
+void Program::ExportLibrary(const std::string& dir, const LibraryExportOptions& options) {
+  CHECK(compiler_) << "The program has no compiled code to export";
+  CHECK(!instrs_.empty()) << "The program is empty";
+  CHECK(instrs_.front()->target_.arch == Target::Arch::X86) << "Only the X86 programs can be exported as libraries";
+  CHECK(view_vars_.empty() && slice_vars_.empty())
+      << "The views and the slices can't be exported, compile with with_reshape_view, with_slice_view and "
+         "with_concat_slice off";
+  std::vector<std::string> fn_names;
+  for (auto& instr : instrs_) {
+    CHECK(!instr->IsMultiTensorOptimizer() && !instr->IsCollective())
+        << "The instruction of " << instr->function_name() << " runs by a runtime kernel, which can't be exported";
+    for (auto& name : instr->GetFnNames()) {
+      if (std::find(fn_names.begin(), fn_names.end(), name) == fn_names.end()) fn_names.push_back(name);
+    }
+  }
+
+  std::vector<std::string> persistent_vars = options.persistent_vars;
+  persistent_vars.insert(persistent_vars.end(), prepacked_vars_.begin(), prepacked_vars_.end());
+  for (auto& instr : prerun_instrs_) {
+    for (auto& args : instr->GetOutArgs()) persistent_vars.insert(persistent_vars.end(), args.begin(), args.end());
+  }
+  std::string program_path = dir + "/" + options.name + ".cinn";
+  Export(persistent_vars, program_path);
+  std::map<std::string, std::string> data;
+  if (options.embed_program) {
+    std::ifstream is(program_path, std::ios::binary);
+    CHECK(is.good()) << "Failed to read the program file " << program_path;
+    data[options.name + "_program"] = std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    std::remove(program_path.c_str());
+  }
+  compiler_->ExportStaticLibrary(dir + "/lib" + options.name + ".a", data);
+
+  const std::string& name = options.name;
+  std::stringstream os;
+  os << "// Generated by CINN, do not edit.\n#pragma once\n\n#include <stdint.h>\n#include <string.h>\n\n";
+  os << "#include \"tiny_runtime.h\"\n\n#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n";
+  for (auto& fn_name : fn_names) os << "void " << fn_name << "(void* args, int32_t nargs);\n";
+  if (options.embed_program) {
+    os << "extern const uint8_t " << name << "_program[];\n";
+    os << "extern const int64_t " << name << "_program_size;\n\n";
+    os << "//! Load the model, return NULL if it fails.\n";
+    os << "static inline void* " << name << "_load(void) {\n";
+    os << "  void* ctx = load_program_from_memory(" << name << "_program, " << name << "_program_size);\n";
+  } else {
+    os << "\n//! Load the model from the program file " << name << ".cinn at \\p path, return NULL if it fails.\n";
+    os << "static inline void* " << name << "_load(const char* path) {\n";
+    os << "  void* ctx = load_program(path);\n";
+  }
+  os << "  if (!ctx) return NULL;\n";
+  for (auto& fn_name : fn_names) os << "  bind_program_function(ctx, \"" << fn_name << "\", " << fn_name << ");\n";
+  os << "  return ctx;\n}\n\n";
+
+  // The inputs are copied into the buffers of the program, and the outputs out of them.
+  std::vector<std::string> params;
+  std::stringstream doc, body;
+  for (int k = 0; k < 2; k++) {
+    for (auto& var : k == 0 ? options.inputs : options.outputs) {
+      auto tensor     = scope_->GetTensor(var);
+      size_t bytes    = tensor->shape().numel() * tensor->type().bits() / 8;
+      std::string arg = CIdentifierOf(var);
+      params.push_back((k == 0 ? "const " : "") + CTypeOf(tensor->type()) + "* " + arg);
+      doc << " * " << arg << ": " << CTypeOf(tensor->type()) << "[" << utils::Join(tensor->shape().data(), ", ")
+          << "]\n";
+      if (k == 1 && var == options.outputs.front()) body << "  run_program(ctx);\n";
+      body << "  buffer = get_buffer(ctx, \"" << var << "\");\n  if (!buffer) return -1;\n";
+      body << (k == 0 ? "  memcpy(buffer->memory, " + arg : "  memcpy(" + arg + ", buffer->memory") << ", " << bytes
+           << ");\n";
+    }
+  }
+  if (options.outputs.empty()) body << "  run_program(ctx);\n";
+  os << "/**\n * Run the model on the inputs and the outputs in the row-major order, return 0 on success.\n";
+  os << doc.str() << " */\n";
+  os << "static inline int " << name << "_run(void* ctx" << (params.empty() ? "" : ", ") << utils::Join(params, ", ")
+     << ") {\n  cinn_buffer_t* buffer = NULL;\n" << body.str() << "  return 0;\n}\n\n";
+  os << "static inline void " << name << "_free(void* ctx) { free_program(ctx); }\n\n";
+  os << "#ifdef __cplusplus\n}  // extern \"C\"\n#endif\n";
+
+  std::ofstream header(dir + "/" + name + ".h");
+  CHECK(header.good()) << "Failed to write the header to " << dir;
+  header << os.str();
+}
+
+void Program::Save(const std::string& path, const std::vector<std::string>& persistent_vars) {
+  CHECK(compiler_) << "The program has no compiled code to save";
+  CHECK(!instrs_.empty() || !prerun_instrs_.empty()) << "The program is empty";
+  const Target& target = instrs_.empty() ? prerun_instrs_.front()->target_ : instrs_.front()->target_;
+  InstantiateLazyVars();
+
+  ProgramArtifact artifact;
+  artifact.arch = target.arch;
+  artifact.code = compiler_->GetCompiledCode();
+
+  std::unordered_set<std::string> persistent(persistent_vars.begin(), persistent_vars.end());
+  persistent.insert(prepacked_vars_.begin(), prepacked_vars_.end());
+  // the packed parameters are saved as the whole arena, copied from the device in one transfer
+  std::string param_arena;
+  uint8_t* param_begin = nullptr;
+  uint8_t* param_end   = nullptr;
+  if (param_arena_) {
+    param_begin = param_arena_->data()->memory;
+    param_end   = param_begin + param_arena_->size();
+    param_arena.resize(param_arena_->size());
+    if (target.arch == Target::Arch::NVGPU) {
+#ifdef CINN_WITH_CUDA
+      CUDA_CALL(cudaMemcpy(&param_arena[0], param_begin, param_arena.size(), cudaMemcpyDeviceToHost));
+#else
+      CINN_NOT_IMPLEMENTED
+#endif
+    } else {
+      std::memcpy(&param_arena[0], param_begin, param_arena.size());
+    }
+    artifact.param_arena      = reinterpret_cast<const uint8_t*>(param_arena.data());
+    artifact.param_arena_size = param_arena.size();
+  }
+  for (auto& name_view : scope_->var_names()) {
+    std::string name({name_view.data(), name_view.size()});
+    auto tensor = scope_->GetTensor(name);
+    ProgramArtifact::Variable var;
+    var.name  = name;
+    var.shape = tensor->shape().data();
+    // the tensors of unknown types are allocated as float32
+    var.dtype = tensor->type().is_unk() ? "float32" : common::Type2Str(tensor->type());
+    auto view = view_vars_.find(name);
+    if (view != view_vars_.end() && scope_->FindVar(view->second)) {
+      var.view_of = view->second;
+      artifact.variables.push_back(std::move(var));
+      continue;
+    }
+    auto slice = slice_vars_.find(name);
+    if (slice != slice_vars_.end()) {
+      var.slice_of     = slice->second.root;
+      var.slice_offset = slice->second.offset;
+      artifact.variables.push_back(std::move(var));
+      continue;
+    }
+    uint8_t* memory = tensor->buffer()->memory;
+    if (memory && memory >= param_begin && memory < param_end) {
+      var.arena_offset = memory - param_begin;
+      artifact.variables.push_back(std::move(var));
+      continue;
+    }
+    if (persistent.count(name)) {
+      auto* buffer = tensor->buffer();
+      CHECK(buffer->memory) << "The persistent variable " << name << " is not instantiated";
+      var.data.resize(buffer->memory_size);
+      if (target.arch == Target::Arch::NVGPU) {
+#ifdef CINN_WITH_CUDA
+        CUDA_CALL(cudaMemcpy(&var.data[0], buffer->memory, buffer->memory_size, cudaMemcpyDeviceToHost));
+#else
+        CINN_NOT_IMPLEMENTED
+#endif
+      } else {
+        std::memcpy(&var.data[0], buffer->memory, buffer->memory_size);
+      }
+    }
+    artifact.variables.push_back(std::move(var));
+  }
+
+  for (auto* instrs : {&prerun_instrs_, &instrs_}) {
+    for (auto& instr : *instrs) {
+      ProgramArtifact::Instr desc;
+      desc.function_name  = instr->function_name();
+      desc.in_args        = instr->GetInArgs();
+      desc.out_args       = instr->GetOutArgs();
+      desc.fn_names       = instr->GetFnNames();
+      desc.attrs          = instr->attrs;
+      desc.str_attrs      = instr->str_attrs;
+      desc.pre_run        = instr->pre_run;
+      desc.node_ids       = instr->node_ids();
+      desc.precision_mode = instr->precision_mode();
+      artifact.instrs.push_back(std::move(desc));
+    }
+  }
+  artifact.Save(path);
+}
+
+std::unique_ptr<Program> Program::Load(const std::string& path, const Target& target) {
+  auto artifact = ProgramArtifact::Load(path);
+  CHECK(artifact.arch == target.arch) << "The program " << path << " is compiled for another target";
+  std::shared_ptr<backends::Compiler> compiler = backends::Compiler::Create(target);
+  compiler->Load(artifact.code);
+
+  // the packed parameters are mapped from the file on X86, or uploaded in one transfer
+  std::shared_ptr<Buffer> param_arena;
+  if (artifact.param_arena_size) {
+    CHECK_LE(artifact.param_arena_size, std::numeric_limits<uint32_t>::max());
+    param_arena = std::make_shared<Buffer>(target);
+    if (target.arch == Target::Arch::NVGPU) {
+#ifdef CINN_WITH_CUDA
+      param_arena->Resize(artifact.param_arena_size);
+      CHECK(param_arena->data()->memory) << "Failed to allocate the parameter arena of " << path;
+      CUDA_CALL(cudaMemcpy(param_arena->data()->memory,
+                           artifact.param_arena,
+                           artifact.param_arena_size,
+                           cudaMemcpyHostToDevice));
+#else
+      CINN_NOT_IMPLEMENTED
+#endif
+    } else {
+      // the file is mapped privately, the pages are copied only if written
+      param_arena->ShareExternalMemory(
+          const_cast<uint8_t*>(artifact.param_arena), artifact.param_arena_size, target, artifact.file);
+    }
   }
+
+  auto scope = std::make_shared<Scope>();
+  absl::flat_hash_map<std::string, std::string> view_vars;
+  absl::flat_hash_map<std::string, SliceVar> slice_vars;
+  for (auto& var : artifact.variables) {
+    auto& tensor = absl::get<Tensor>(*scope->Var<Tensor>(var.name));
+    tensor->Resize(Shape(var.shape));
+    if (!var.view_of.empty()) {
+      view_vars[var.name] = var.view_of;
+      continue;
+    }
+    tensor->set_type(common::Str2Type(var.dtype));
+    if (!var.slice_of.empty()) {
+      slice_vars[var.name] = {var.slice_of, var.slice_offset};
+      continue;
+    }
+    if (var.arena_offset >= 0) {
+      CHECK(param_arena) << "The program artifact " << path << " has no parameter arena for " << var.name;
+      CHECK_LE(var.arena_offset + tensor->num_bytes(), param_arena->size())
+          << "The packed parameter " << var.name << " is out of the arena";
+      tensor->share_external_data(param_arena->data()->memory + var.arena_offset, target, param_arena);
+      continue;
+    }
+    tensor->mutable_data(target);
+    if (var.data.empty()) continue;
+    auto* buffer = tensor->buffer();
+    CHECK_EQ(var.data.size(), buffer->memory_size) << "The saved data of " << var.name << " doesn't match its shape";
+    if (target.arch == Target::Arch::NVGPU) {
+#ifdef CINN_WITH_CUDA
+      CUDA_CALL(cudaMemcpy(buffer->memory, var.data.data(), var.data.size(), cudaMemcpyHostToDevice));
+#else
+      CINN_NOT_IMPLEMENTED
+#endif
+    } else {
+      std::memcpy(buffer->memory, var.data.data(), var.data.size());
+    }
+  }
+
+  std::vector<std::unique_ptr<Instruction>> instrs;
+  for (auto& desc : artifact.instrs) {
+    CHECK(!desc.in_args.empty());
+    CHECK_EQ(desc.in_args.size(), desc.out_args.size());
+    auto instr = std::unique_ptr<Instruction>(
+        new Instruction(target, scope.get(), desc.in_args[0], desc.out_args[0], desc.function_name));
+    for (int i = 1; i < desc.in_args.size(); i++) {
+      instr->AddInArgs(desc.in_args[i]);
+      instr->AddOutArgs(desc.out_args[i]);
+    }
+    for (auto& fn_name : desc.fn_names) {
+      auto* fn = compiler->Lookup(fn_name);
+      CHECK(fn) << "The function " << fn_name << " is not found in the compiled code of " << path;
+      instr->SetLoweredFunc(fn, fn_name);
+    }
+    instr->attrs     = desc.attrs;
+    instr->str_attrs = desc.str_attrs;
+    instr->pre_run   = desc.pre_run;
+    instr->SetNodeIds(desc.node_ids);
+    instr->SetPrecisionMode(desc.precision_mode);
+    instrs.push_back(std::move(instr));
+  }
+
+  for (auto& item : slice_vars) {
+    scope->GetTensor(item.first)->ShareSliceOf(*scope->GetTensor(item.second.root), item.second.offset, target);
+  }
+  for (auto& item : view_vars) {
+    scope->GetTensor(item.first)->ShareBufferWith(*scope->GetTensor(item.second));
+  }
+
+  std::unique_ptr<Program> program(new Program(scope, std::move(instrs)));
+  program->SetCompiler(compiler);
+  program->SetViewVars(view_vars);
+  program->SetSliceVars(slice_vars);
+  program->param_arena_ = param_arena;
+  return program;
+}
+
+std::unique_ptr<Program> Program::Clone(const std::vector<std::string>& shared_vars,
+                                        const std::vector<std::string>& copied_vars) const {
+  CHECK(!instrs_.empty() || !prerun_instrs_.empty()) << "The program is empty";
+  const Target& target = instrs_.empty() ? prerun_instrs_.front()->target_ : instrs_.front()->target_;
+  TenantScope tenant_scope(tenant_);
+  InstantiateLazyVars();
+
+  // The planned variables take the same offsets in a new arena.
+  std::shared_ptr<Buffer> arena;
+  uint8_t* arena_begin = nullptr;
+  uint8_t* arena_end   = nullptr;
+  if (memory_arena_ && memory_arena_->data()->memory) {
+    uint32_t size = memory_arena_->data()->memory_size;
+    arena_begin   = memory_arena_->data()->memory;
+    arena_end     = arena_begin + size;
+    arena         = std::make_shared<Buffer>(target);
+    if (target == common::DefaultHostTarget()) {
+      arena->Resize(MemoryPlanner::kAlignment, size);
+    } else {
+      arena->Resize(size);
+    }
+    CHECK(arena->data()->memory) << "Failed to allocate memory arena of " << size << " bytes";
+  }
+
+  auto scope = std::make_shared<Scope>();
+  std::unordered_set<std::string> shared(shared_vars.begin(), shared_vars.end());
+  // the packed parameters and their slices are read only, so the clones share them
+  if (param_arena_) {
+    uint8_t* param_begin = param_arena_->data()->memory;
+    uint8_t* param_end   = param_begin + param_arena_->size();
+    for (auto& name_view : scope_->var_names()) {
+      std::string name({name_view.data(), name_view.size()});
+      uint8_t* memory = scope_->GetTensor(name)->buffer()->memory;
+      if (memory && memory >= param_begin && memory < param_end) shared.insert(name);
+    }
+  }
+  std::unordered_set<std::string> copied(copied_vars.begin(), copied_vars.end());
+  // The tensors sharing one buffer, e.g. written in place, keep sharing in the clone.
+  absl::flat_hash_map<cinn_buffer_t*, Tensor> cloned_buffers;
+  for (auto& name_view : scope_->var_names()) {
+    std::string name({name_view.data(), name_view.size()});
+    auto tensor = scope_->GetTensor(name);
+    auto slice = slice_vars_.find(name);
+    if (shared.count(name) || (slice != slice_vars_.end() && shared.count(slice->second.root))) {
+      *scope->Var<Tensor>(name) = tensor;
+      continue;
+    }
+    auto& new_tensor = absl::get<Tensor>(*scope->Var<Tensor>(name));
+    new_tensor->Resize(tensor->shape());
+    new_tensor->set_type(tensor->type());
+    // the slices are bound to the ranges of their cloned roots below
+    if (slice != slice_vars_.end()) continue;
+    auto it = cloned_buffers.find(tensor->buffer());
+    if (it != cloned_buffers.end()) {
+      new_tensor->ShareBufferWith(*it->second);
+      continue;
+    }
+    cloned_buffers.emplace(tensor->buffer(), new_tensor);
+    uint8_t* memory = tensor->buffer()->memory;
+    if (memory && memory >= arena_begin && memory < arena_end) {
+      new_tensor->share_external_data(arena->data()->memory + (memory - arena_begin), target);
+    } else if (memory) {
+      new_tensor->mutable_data(target);
+    }
+    if (memory && copied.count(name)) {
+      if (target.is_cpu()) {
+        std::memcpy(new_tensor->buffer()->memory, memory, tensor->buffer()->memory_size);
+      } else {
+#ifdef CINN_WITH_CUDA
+        // The clone may be on another device, the driver copies across the devices by the peer access or the host.
+        CUDA_CALL(cudaMemcpy(new_tensor->buffer()->memory, memory, tensor->buffer()->memory_size, cudaMemcpyDefault));
+#else
+        LOG(FATAL) << "Only the variables on the host can be copied to the clone";
+#endif
+      }
+    }
+  }
+
+  for (auto& item : slice_vars_) {
+    auto root = scope->GetTensor(item.second.root);
+    if (shared.count(item.second.root) || !root->buffer()->memory) continue;
+    scope->GetTensor(item.first)->ShareSliceOf(*root, item.second.offset, target);
+  }
+
+  std::vector<std::unique_ptr<Instruction>> instrs;
+  for (auto* origin_instrs : {&prerun_instrs_, &instrs_}) {
+    for (auto& instr : *origin_instrs) {
+      instrs.push_back(instr->Clone(scope.get()));
+    }
+  }
+  std::unique_ptr<Program> program(new Program(scope, std::move(instrs)));
+  program->SetMemoryArena(arena);
+  program->param_arena_ = param_arena_;
+  program->SetCompiler(compiler_);
+  program->SetViewVars(view_vars_);
+  program->SetSliceVars(slice_vars_);
+  program->SetTenant(tenant_);
+  return program;
+}
+
+std::string Program::DebugString() const {
+  std::stringstream ss;
+  auto find_tensor = [&](const std::string& name) -> _Tensor_* {
+    auto* var = scope_->FindVar(name);
+    return var ? absl::get<Tensor>(*var).self() : nullptr;
+  };
+  for (auto* instrs : {&prerun_instrs_, &instrs_}) {
+    for (auto& instr : *instrs) {
+      auto fn_names = instr->GetFnNames();
+      auto in_args  = instr->GetInArgs();
+      auto out_args = instr->GetOutArgs();
+      for (int i = 0; i < in_args.size(); i++) {
+        ss << (instr->pre_run ? "[pre_run] " : "") << (i < fn_names.size() ? fn_names[i] : instr->function_name())
+           << "(" << utils::Join(in_args[i], ", ") << ") -> (";
+        for (int j = 0; j < out_args[i].size(); j++) {
+          auto& out = out_args[i][j];
+          ss << (j > 0 ? ", " : "") << out;
+          auto* out_tensor = find_tensor(out);
+          auto slice       = slice_vars_.find(out);
+          if (slice != slice_vars_.end()) {
+            ss << " [slice of " << slice->second.root << " at " << slice->second.offset << "]";
+          }
+          for (auto& in : in_args[i]) {
+            auto* in_tensor = find_tensor(in);
+            if (out_tensor && in_tensor && in != out && out_tensor->SharesBufferWith(*in_tensor)) {
+              ss << " [in place of " << in << "]";
+              break;
+            }
+          }
+        }
+        ss << ")\n";
+      }
+    }
+  }
+  return ss.str();
+}
+
+std::ostream& operator<<(std::ostream& os, const MemoryReport& report) {
+  os << "total: " << report.total_bytes() << " bytes, parameters: " << report.parameter_bytes
+     << " bytes, intermediates: " << report.intermediate_bytes << " bytes, workspace: " << report.workspace_bytes
+     << " bytes, peak: " << report.peak_bytes << " bytes";
+  if (report.num_trims) {
+    os << ", trims: " << report.num_trims << " releasing " << report.trimmed_bytes << " bytes"
+       << (report.trimmed ? " (trimmed now)" : "");
+  }
+  return os;
+}
+
+std::ostream& operator<<(std::ostream& os, const WarmupReport& report) {
+  os << "total: " << report.total_ms << " ms, prepare: " << report.prepare_ms << " ms, first run: "
+     << report.first_run_ms << " ms, last run: " << report.last_run_ms << " ms";
+  return os;
+}
+
+WarmupReport Program::Warmup(const WarmupOptions& options) {
+  CHECK(!instrs_.empty() || !prerun_instrs_.empty()) << "The program is empty";
+  CHECK_GE(options.runs, 1) << "Warmup runs the program at least once";
+  const Target& target = instrs_.empty() ? prerun_instrs_.front()->target_ : instrs_.front()->target_;
+  TenantScope tenant_scope(tenant_);
+  WarmupReport report;
+  utils::Timer total_timer, timer;
+  total_timer.Start();
+  timer.Start();
+
+  if (compiler_ && options.wait_optimized) compiler_->WaitOptimized();
+  InstantiateLazyVars();
+  for (auto* instrs : {&prerun_instrs_, &instrs_}) {
+    for (auto& instr : *instrs) {
+      instr->PrepareLibraryCall();
+      instr->ResolveArgSlots();
+    }
+  }
+  // the first touches of the arenas fault in their pages, the packed parameters may be mapped from the file
+  if (target.is_cpu()) {
+    constexpr size_t kPageSize = 4096;
+    if (memory_arena_ && memory_arena_->data()->memory) {
+      std::memset(memory_arena_->data()->memory, 0, memory_arena_->size());
+    }
+    if (param_arena_) {
+      volatile uint8_t sum = 0;
+      auto* memory         = param_arena_->data()->memory;
+      for (size_t i = 0; i < param_arena_->size(); i += kPageSize) sum += memory[i];
+    }
+  }
+  for (auto& name : options.inputs) {
+    auto tensor = scope_->GetTensor(name);
+    auto* data  = tensor->mutable_data(target);
+    if (target.arch == Target::Arch::NVGPU) {
+#ifdef CINN_WITH_CUDA
+      CUDA_CALL(cudaMemset(data, 0, tensor->memory_bytes()));
+#else
+      CINN_NOT_IMPLEMENTED
+#endif
+    } else {
+      std::memset(data, 0, tensor->memory_bytes());
+    }
+  }
+  report.prepare_ms = timer.Stop();
+
+  for (int i = 0; i < options.runs; i++) {
+    timer.Start();
+    if (i == 0 && !prerun_instrs_.empty()) PreRun();
+    Execute();
+#ifdef CINN_WITH_CUDA
+    if (target.arch == Target::Arch::NVGPU) CUDA_CALL(cudaDeviceSynchronize());
+#endif
+    float ms = timer.Stop();
+    if (i == 0) report.first_run_ms = ms;
+    report.last_run_ms = ms;
+  }
+  report.total_ms = total_timer.Stop();
+  ready_.store(true, std::memory_order_release);
+  LOG(INFO) << "The program is warmed up and ready, " << report;
+  return report;
+}
+
+MemoryReport Program::GetMemoryReport() const {
+  MemoryReport report;
+  report.tensors = scope_->TensorMemorySizes();
+  std::unordered_set<std::string> produced;
+  for (auto& instr : instrs_) {
+    for (auto& args : instr->GetOutArgs()) produced.insert(args.begin(), args.end());
+  }
+  std::unordered_set<cinn_buffer_t*> counted;
+  for (auto& item : report.tensors) {
+    auto tensor = scope_->GetTensor(item.first);
+    // The planned variables and the packed parameters refer to their arenas, which are counted as a whole.
+    if (!tensor->owns_memory() || !counted.insert(tensor->buffer()).second) continue;
+    (produced.count(item.first) ? report.intermediate_bytes : report.parameter_bytes) += item.second;
+  }
+  if (memory_arena_) report.intermediate_bytes += memory_arena_->size();
+  if (param_arena_) report.parameter_bytes += param_arena_->size();
+#ifdef CINN_WITH_CUDA
+  if (!instrs_.empty() && instrs_[0]->target_.arch == Target::Arch::NVGPU) {
+    report.workspace_bytes = runtime::cuda::LibraryHandles::TotalWorkSpaceSize();
+  }
+#endif
+  report.peak_bytes    = std::max(peak_memory_bytes_, report.total_bytes());
+  report.trimmed       = trimmed_;
+  report.num_trims     = num_trims_;
+  report.trimmed_bytes = trimmed_bytes_;
+  report.idle_us       = idle_us();
+  return report;
+}
+
+size_t Program::Trim(const std::unordered_set<std::string>& keep_vars) {
+  std::lock_guard<std::mutex> lock(run_mutex_);
+  return TrimLocked(keep_vars);
+}
+
+size_t Program::TrimLocked(const std::unordered_set<std::string>& keep_vars) {
+  std::unordered_set<std::string> produced;
+  for (auto& instr : instrs_) {
+    for (auto& args : instr->GetOutArgs()) produced.insert(args.begin(), args.end());
+  }
+  uint8_t* arena_begin = memory_arena_ ? memory_arena_->data()->memory : nullptr;
+  uint8_t* arena_end   = arena_begin ? arena_begin + memory_arena_->size() : nullptr;
+  auto in_arena        = [&](uint8_t* memory) { return memory && memory >= arena_begin && memory < arena_end; };
+
+  // The buffers of the variables kept, which the views and the variables written in place of them share, and the
+  // roots of the slices kept.
+  std::unordered_set<cinn_buffer_t*> kept;
+  bool keep_arena = false;
+  for (auto& name_view : scope_->var_names()) {
+    std::string name({name_view.data(), name_view.size()});
+    if (produced.count(name) && !keep_vars.count(name)) continue;
+    auto slice  = slice_vars_.find(name);
+    auto tensor = scope_->GetTensor(slice == slice_vars_.end() ? name : slice->second.root);
+    kept.insert(tensor->buffer());
+    keep_arena |= in_arena(tensor->buffer()->memory);
+  }
+
+  size_t released = 0;
+  std::unordered_set<cinn_buffer_t*> freed;
+  for (auto& name_view : scope_->var_names()) {
+    std::string name({name_view.data(), name_view.size()});
+    if (!produced.count(name) || slice_vars_.count(name)) continue;
+    auto tensor  = scope_->GetTensor(name);
+    auto* buffer = tensor->buffer();
+    if (freed.count(buffer)) {
+      if (!bound_vars_.count(name)) lazy_vars_.insert(name);
+      continue;
+    }
+    if (!buffer->memory || kept.count(buffer)) continue;
+    if (in_arena(buffer->memory)) {
+      if (keep_arena) continue;
+      trimmed_arena_vars_.emplace_back(name, buffer->memory - arena_begin);
+      tensor->FreeMemory();
+      continue;
+    }
+    // the memory owned by others, e.g. mapped from the file of a saved program
+    if (!tensor->owns_memory()) continue;
+    released += tensor->memory_bytes();
+    freed.insert(buffer);
+    tensor->FreeMemory();
+    if (!bound_vars_.count(name)) lazy_vars_.insert(name);
+  }
+  if (arena_begin && !keep_arena) {
+    released += memory_arena_->size();
+    trimmed_arena_size_ = memory_arena_->size();
+    memory_arena_->Free();
+  }
+  // the slices of the roots released refer to nothing until the roots are allocated again
+  for (auto& item : slice_vars_) {
+    auto slice = scope_->GetTensor(item.first);
+    if (!slice->buffer()->memory || scope_->GetTensor(item.second.root)->buffer()->memory) continue;
+    slice->FreeMemory();
+    if (!bound_vars_.count(item.second.root)) trimmed_slices_.push_back(item.first);
+  }
+  if (!released) return 0;
+  // the captured graph refers to the memory released
+  ResetCudaGraph();
+  trimmed_ = true;
+  num_trims_++;
+  trimmed_bytes_ += released;
+  VLOG(3) << "Trim " << released << " bytes of the intermediates";
+  return released;
+}
+
+void Program::EnableIdleTrim(bool enable, const std::unordered_set<std::string>& keep_vars) {
+  if (idle_releaser_id_ >= 0) MemoryManager::Global().RemoveReleaser(idle_releaser_id_);
+  idle_releaser_id_ = -1;
+  if (!enable) return;
+  idle_releaser_id_ = MemoryManager::Global().AddReleaser([this, keep_vars](int64_t idle_us) -> size_t {
+    // the program running is busy, and the next checks find it idle later
+    std::unique_lock<std::mutex> lock(run_mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || trimmed_ || this->idle_us() < idle_us) return 0;
+    return TrimLocked(keep_vars);
+  });
+}
+
+int64_t Program::idle_us() const { return SteadyClockUs() - last_run_us_.load(std::memory_order_relaxed); }
+
+void Program::Execute(const std::map<std::string, cinn_pod_value_t>* name2podargs, int priority) {
+  ExecuteScope execute_scope(&run_mutex_, &last_run_us_);
+  TenantScope tenant_scope(tenant_, /*record_run=*/true);
+  RunPriorityScope priority_scope(priority);
+  run_priority_ = priority;
+  InstantiateLazyVars();
+  if (fused_host_fn_ && !profiler_) {
+    if (!name2podargs) {
+      fused_host_fn_(nullptr, 0);
+      if (track_memory_) peak_memory_bytes_ = GetMemoryReport().peak_bytes;
+      return;
+    }
+    // The arguments passed by name2podargs replace the prepared ones referred by the fused function.
+    LOG(WARNING) << "The fused host function doesn't support name2podargs, fall back to the instructions";
+    fused_host_fn_ = nullptr;
+  }
+#ifdef CINN_WITH_CUDA
+  if (use_cuda_graph_ && !profiler_) {
+    ExecuteCudaGraph(name2podargs);
+    if (track_memory_) peak_memory_bytes_ = GetMemoryReport().peak_bytes;
+    return;
+  }
+#endif
+  if (parallel_executor_) {
+    parallel_executor_->Run(name2podargs, priority);
+  } else {
+    UsePriorityStream(priority);
+    LaunchInstructions(name2podargs);
+  }
+#ifdef CINN_WITH_CUDA
+  if (instrs_[0]->target_.arch == Target::Arch::NVGPU) {
+    if (run_stream_) {
+      CUDA_CALL(cudaStreamSynchronize(run_stream_));
+    } else {
+      CUDA_CALL(cudaDeviceSynchronize());
+    }
+  }
+#endif
+  if (profiler_) profiler_->Synchronize();
+  if (track_memory_) peak_memory_bytes_ = GetMemoryReport().peak_bytes;
+}
+
+void Program::Execute(const std::vector<const cinn_pod_value_t*>& slot2podargs, int priority) {
+  CHECK(!parallel_executor_ && !use_cuda_graph_)
+      << "The parallel executor and the CUDA graph take the feeds by name2podargs instead of the slots";
+  ExecuteScope execute_scope(&run_mutex_, &last_run_us_);
+  TenantScope tenant_scope(tenant_, /*record_run=*/true);
+  RunPriorityScope priority_scope(priority);
+  run_priority_ = priority;
+  InstantiateLazyVars();
+  if (fused_host_fn_) {
+    LOG(WARNING) << "The fused host function doesn't support the feeds, fall back to the instructions";
+    fused_host_fn_ = nullptr;
+  }
+  UsePriorityStream(priority);
+  LaunchInstructions(&slot2podargs);
 #ifdef CINN_WITH_CUDA
   if (instrs_[0]->target_.arch == Target::Arch::NVGPU) {
+    if (run_stream_) {
+      CUDA_CALL(cudaStreamSynchronize(run_stream_));
+    } else {
+      CUDA_CALL(cudaDeviceSynchronize());
+    }
+  }
+#endif
+  if (profiler_) profiler_->Synchronize();
+  if (track_memory_) peak_memory_bytes_ = GetMemoryReport().peak_bytes;
+}
+
+void Program::BindInput(const std::string& name, cinn_buffer_t* buffer) {
+  CHECK(buffer) << "The buffer bound to [" << name << "] is null";
+  BindVar(name, buffer);
+}
+
+void Program::UnbindInput(const std::string& name) { BindVar(name, nullptr); }
+
+void Program::BindVar(const std::string& name, cinn_buffer_t* buffer) {
+  if (var_instrs_.empty()) {
+    for (auto* instrs : {&prerun_instrs_, &instrs_}) {
+      for (auto& ins : *instrs) {
+        std::unordered_set<std::string> names;
+        for (auto& args : ins->GetInArgs()) names.insert(args.begin(), args.end());
+        for (auto& args : ins->GetOutArgs()) names.insert(args.begin(), args.end());
+        for (auto& arg : names) var_instrs_[arg].push_back(ins.get());
+      }
+    }
+  }
+  CHECK(!slice_vars_.count(name)) << "The variable [" << name << "] is a slice of [" << slice_vars_.at(name).root
+                                  << "], which should be bound instead";
+  // The views and the variable they view share the memory, so they are bound together.
+  auto root_it     = view_vars_.find(name);
+  const auto& root = root_it == view_vars_.end() ? name : root_it->second;
+  std::vector<std::string> names{root};
+  for (auto& item : view_vars_) {
+    if (item.second == root) names.push_back(item.first);
+  }
+  bool bound = false;
+  for (auto& var_name : names) {
+    auto* var_buffer = buffer ? buffer : scope_->GetTensor(var_name)->buffer();
+    if (buffer) {
+      // the bound variables don't need their own memory
+      lazy_vars_.erase(var_name);
+      bound_vars_.insert(var_name);
+    } else {
+      bound_vars_.erase(var_name);
+      if (!var_buffer->memory) lazy_vars_.insert(var_name);
+    }
+    auto it = var_instrs_.find(var_name);
+    if (it == var_instrs_.end()) continue;
+    for (auto* ins : it->second) ins->BindArg(var_name, var_buffer);
+    bound = true;
+  }
+  // The slices of the root are bound to the ranges of the buffer, which keep their own shapes.
+  for (auto& item : slice_vars_) {
+    if (item.second.root != root) continue;
+    auto* slice_buffer = scope_->GetTensor(item.first)->buffer();
+    if (buffer) {
+      auto& range = slice_buffers_[item.first];
+      if (!range) range.reset(new cinn_buffer_t(*slice_buffer));
+      range->memory      = buffer->memory + item.second.offset;
+      range->memory_size = slice_buffer->memory_size;
+      slice_buffer       = range.get();
+    } else if (!slice_buffer->memory &&
+               std::find(trimmed_slices_.begin(), trimmed_slices_.end(), item.first) == trimmed_slices_.end()) {
+      // sliced again once the root is allocated
+      trimmed_slices_.push_back(item.first);
+      trimmed_ = true;
+    }
+    auto it = var_instrs_.find(item.first);
+    if (it == var_instrs_.end()) continue;
+    for (auto* ins : it->second) ins->BindArg(item.first, slice_buffer);
+    bound = true;
+  }
+  CHECK(bound) << "No instruction uses the variable [" << name << "] to bind";
+#ifdef CINN_WITH_CUDA
+  graph_args_changed_ = true;
+#endif
+}
+
+void Program::SetFusedHostFunction(const std::string& name) {
+  CHECK(compiler_) << "The compiler should be set before the fused host function";
+  auto* fn    = compiler_->Lookup(name);
+  auto* args  = reinterpret_cast<void**>(compiler_->Lookup(name + "_args"));
+  auto* nargs = reinterpret_cast<int32_t*>(compiler_->Lookup(name + "_nargs"));
+  CHECK(fn && args && nargs) << "The fused host function [" << name << "] is not compiled";
+  int k = 0;
+  for (auto& ins : instrs_) {
+    ins->Run(nullptr, /*dryrun=*/true);
+    auto& prepared_args = ins->GetPreparedArgs();
+    CHECK_EQ(prepared_args.size(), ins->GetFnNames().size()) << "The arguments of each function should be prepared";
+    // The prepared arguments are patched in place by the bindings, so the addresses keep valid.
+    for (auto& pod_args : prepared_args) {
+      args[k]  = const_cast<cinn_pod_value_t*>(pod_args.data());
+      nargs[k] = pod_args.size();
+      k++;
+    }
+  }
+  VLOG(3) << "The fused host function [" << name << "] calls " << k << " functions";
+  fused_host_fn_ = fn;
+}
+
+void Program::EnableProfiling(bool enable) {
+  if (enable && !profiler_) profiler_.reset(new Profiler);
+  if (!enable) profiler_.reset();
+  for (auto& ins : instrs_) ins->SetProfiler(profiler_.get());
+}
+
+void Program::LaunchInstructions(const std::map<std::string, cinn_pod_value_t>* name2podargs) {
+  if (!name2podargs) {
+    LaunchInstructions(static_cast<const std::vector<const cinn_pod_value_t*>*>(nullptr));
+    return;
+  }
+  slot2podargs_.assign(scope_->num_slots(), nullptr);
+  for (auto& item : *name2podargs) {
+    int slot = scope_->Slot(item.first);
+    if (slot >= slot2podargs_.size()) slot2podargs_.resize(slot + 1, nullptr);
+    slot2podargs_[slot] = &item.second;
+  }
+  LaunchInstructions(&slot2podargs_);
+}
+
+void Program::LaunchInstructions(const std::vector<const cinn_pod_value_t*>* slot2podargs) {
+  auto run = [&](Instruction* ins) { slot2podargs ? ins->Run(*slot2podargs) : ins->Run(); };
+  // The CUDA graph is being captured by the launches, which are not run in between.
+  bool yield = !use_cuda_graph_ || !graph_warmed_up_;
+#ifdef CINN_WITH_CUDA
+  if (!streams_.empty()) {
+    for (int i = 0; i < instrs_.size(); i++) {
+      if (yield && i > 0) PriorityGate::Global().Yield(run_priority_);
+      auto stream = streams_[stream_assignment_.stream_of[i]];
+      for (int p : stream_assignment_.waits[i]) {
+        CUDA_CALL(cudaStreamWaitEvent(stream, events_[p], 0));
+      }
+      run(instrs_[i].get());
+      if (events_[i]) CUDA_CALL(cudaEventRecord(events_[i], stream));
+    }
+    return;
+  }
+#endif
+  for (int i = 0; i < instrs_.size(); i++) {
+    if (yield && i > 0) PriorityGate::Global().Yield(run_priority_);
+    run(instrs_[i].get());
+  }
+}
+
+void Program::SetNumStreams(int num_streams) {
+  CHECK_GT(num_streams, 0);
+  ResetCudaGraph();
+  ResetStreams();
+  if (num_streams == 1 || instrs_.empty() || instrs_[0]->target_.arch != Target::Arch::NVGPU) return;
+#ifdef CINN_WITH_CUDA
+  std::vector<Instruction*> instrs;
+  // The cuDNN and cuBLAS calls run by the handles and workspace of their own streams, so they are not pinned.
+  for (auto& ins : instrs_) instrs.push_back(ins.get());
+  // The collectives run on an extra stream of their own, so that the allreduces of the gradients overlap with the
+  // rest of the backward computation.
+  std::vector<bool> communication;
+  for (auto& ins : instrs_) communication.push_back(ins->IsCollective());
+  if (std::count(communication.begin(), communication.end(), true)) {
+    num_streams++;
+  } else {
+    communication.clear();
+  }
+  InstructionDAG dag(instrs, scope_.get());
+  stream_assignment_ = dag.AssignStreams(num_streams, {}, communication);
+
+  streams_.resize(num_streams);
+  for (auto& stream : streams_) {
+    CUDA_CALL(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+  }
+  events_.resize(instrs_.size(), nullptr);
+  for (int i = 0; i < instrs_.size(); i++) {
+    instrs_[i]->SetStream(streams_[stream_assignment_.stream_of[i]]);
+    if (stream_assignment_.record_event[i]) {
+      CUDA_CALL(cudaEventCreateWithFlags(&events_[i], cudaEventDisableTiming));
+    }
+  }
+  VLOG(3) << "Run " << instrs_.size() << " instructions on " << num_streams << " streams";
+#else
+  LOG(FATAL) << "Multi-stream execution needs CINN built with CUDA";
+#endif
+}
+
+void Program::ResetStreams() {
+#ifdef CINN_WITH_CUDA
+  if (streams_.empty() && priority_streams_.empty()) return;
+  CUDA_CALL(cudaDeviceSynchronize());
+  for (auto& ins : instrs_) ins->SetStream(nullptr);
+  for (auto event : events_) {
+    if (event) CUDA_CALL(cudaEventDestroy(event));
+  }
+  for (auto stream : streams_) CUDA_CALL(cudaStreamDestroy(stream));
+  for (auto& item : priority_streams_) CUDA_CALL(cudaStreamDestroy(item.second));
+  events_.clear();
+  streams_.clear();
+  priority_streams_.clear();
+  run_stream_        = nullptr;
+  stream_assignment_ = StreamAssignment();
+#endif
+}
+
+void Program::UsePriorityStream(int priority) {
+#ifdef CINN_WITH_CUDA
+  // The multi-stream execution and the CUDA graph run the instructions on their own streams.
+  if (instrs_.empty() || instrs_[0]->target_.arch != Target::Arch::NVGPU || !streams_.empty() || use_cuda_graph_) {
+    return;
+  }
+  cudaStream_t stream = nullptr;
+  if (priority != 0) {
+    auto& priority_stream = priority_streams_[priority];
+    if (!priority_stream) {
+      // The lower the number of a CUDA stream priority is, the higher the priority is, e.g. [-5, 0] on most devices.
+      int least = 0, greatest = 0;
+      CUDA_CALL(cudaDeviceGetStreamPriorityRange(&least, &greatest));
+      int cuda_priority = std::min(std::max(-priority, greatest), least);
+      CUDA_CALL(cudaStreamCreateWithPriority(&priority_stream, cudaStreamNonBlocking, cuda_priority));
+      VLOG(3) << "Create the stream of priority " << priority << " at the CUDA stream priority " << cuda_priority;
+    }
+    stream = priority_stream;
+  }
+  if (stream == run_stream_) return;
+  // The kernels of the previous run on the other stream finish before these ones overwrite the same buffers.
+  if (run_stream_) {
+    CUDA_CALL(cudaStreamSynchronize(run_stream_));
+  }
+  for (auto& ins : instrs_) ins->SetStream(stream);
+  run_stream_ = stream;
+#endif
+}
+
+void Program::SetNumInterOpThreads(int inter_op_threads, int intra_op_threads) {
+  CHECK_GT(inter_op_threads, 0);
+  parallel_executor_.reset();
+  if (inter_op_threads == 1 || instrs_.empty() || !instrs_[0]->target_.is_cpu()) return;
+  std::vector<Instruction*> instrs;
+  for (auto& ins : instrs_) instrs.push_back(ins.get());
+  parallel_executor_.reset(new ParallelExecutor(instrs, scope_.get(), inter_op_threads, intra_op_threads));
+  VLOG(3) << "Run " << instrs_.size() << " instructions on " << inter_op_threads << " threads";
+}
+
+void Program::SetUseCudaGraph(bool use_cuda_graph) {
+  ResetCudaGraph();
+  UsePriorityStream(0);
+  if (!use_cuda_graph || instrs_.empty() || instrs_[0]->target_.arch != Target::Arch::NVGPU) {
+    use_cuda_graph_ = false;
+    return;
+  }
+#ifdef CINN_WITH_CUDA
+  use_cuda_graph_ = true;
+#else
+  LOG(FATAL) << "CUDA Graph needs CINN built with CUDA";
+#endif
+}
+
+void Program::ExecuteCudaGraph(const std::map<std::string, cinn_pod_value_t>* name2podargs) {
+#ifdef CINN_WITH_CUDA
+  // the graph refers to the workspaces released by MemoryManager::ReleaseCache, which are allocated again before the
+  // capture by warming up once more
+  uint64_t workspace_generation = runtime::cuda::LibraryHandles::WorkSpaceGeneration();
+  if (graph_warmed_up_ && workspace_generation != graph_workspace_generation_) ResetCudaGraph();
+  if (!graph_warmed_up_) {
+    LaunchInstructions(name2podargs);
     CUDA_CALL(cudaDeviceSynchronize());
+    graph_warmed_up_            = true;
+    graph_workspace_generation_ = workspace_generation;
+    return;
   }
+  std::vector<void*> signature;
+  if (name2podargs) {
+    for (auto& item : *name2podargs) {
+      if (item.second.type_code() != ::cinn_type_code<cinn_buffer_t*>()) continue;
+      cinn_buffer_t* buffer = item.second;
+      signature.push_back(buffer);
+      signature.push_back(buffer->memory);
+    }
+  }
+  if (!graph_exec_ || graph_args_changed_ || signature != graph_args_signature_) {
+    CaptureCudaGraph(name2podargs);
+    graph_args_signature_ = signature;
+    graph_args_changed_   = false;
+  }
+  auto stream = streams_.empty() ? graph_stream_ : streams_[0];
+  CUDA_CALL(cudaGraphLaunch(graph_exec_, stream));
+  CUDA_CALL(cudaStreamSynchronize(stream));
+#endif
+}
+
+void Program::CaptureCudaGraph(const std::map<std::string, cinn_pod_value_t>* name2podargs) {
+#ifdef CINN_WITH_CUDA
+  if (streams_.empty() && !graph_stream_) {
+    CUDA_CALL(cudaStreamCreateWithFlags(&graph_stream_, cudaStreamNonBlocking));
+    for (auto& ins : instrs_) ins->SetStream(graph_stream_);
+  }
+  if (streams_.size() > 1 && graph_fork_join_events_.empty()) {
+    graph_fork_join_events_.resize(streams_.size());
+    for (auto& event : graph_fork_join_events_) {
+      CUDA_CALL(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+    }
+  }
+
+  auto origin = streams_.empty() ? graph_stream_ : streams_[0];
+  CUDA_CALL(cudaStreamBeginCapture(origin, cudaStreamCaptureModeThreadLocal));
+  // The other streams join the capture by waiting for an event recorded on the capturing stream.
+  if (!graph_fork_join_events_.empty()) {
+    CUDA_CALL(cudaEventRecord(graph_fork_join_events_[0], origin));
+    for (int s = 1; s < streams_.size(); s++) {
+      CUDA_CALL(cudaStreamWaitEvent(streams_[s], graph_fork_join_events_[0], 0));
+    }
+  }
+  LaunchInstructions(name2podargs);
+  if (!graph_fork_join_events_.empty()) {
+    for (int s = 1; s < streams_.size(); s++) {
+      CUDA_CALL(cudaEventRecord(graph_fork_join_events_[s], streams_[s]));
+      CUDA_CALL(cudaStreamWaitEvent(origin, graph_fork_join_events_[s], 0));
+    }
+  }
+  cudaGraph_t graph;
+  CUDA_CALL(cudaStreamEndCapture(origin, &graph));
+
+  if (graph_exec_) {
+    // Only the kernel parameters change, try to update the instantiated graph in place.
+    cudaGraphNode_t error_node;
+    cudaGraphExecUpdateResult result;
+    if (cudaGraphExecUpdate(graph_exec_, graph, &error_node, &result) != cudaSuccess) {
+      VLOG(3) << "Failed to update the CUDA Graph in place, instantiate it again";
+      cudaGetLastError();
+      CUDA_CALL(cudaGraphExecDestroy(graph_exec_));
+      graph_exec_ = nullptr;
+    }
+  }
+  if (!graph_exec_) {
+    CUDA_CALL(cudaGraphInstantiate(&graph_exec_, graph, nullptr, nullptr, 0));
+  }
+  CUDA_CALL(cudaGraphDestroy(graph));
+  VLOG(3) << "Captured " << instrs_.size() << " instructions into a CUDA Graph";
+#endif
+}
+
+void Program::ResetCudaGraph() {
+#ifdef CINN_WITH_CUDA
+  if (graph_exec_) CUDA_CALL(cudaGraphExecDestroy(graph_exec_));
+  for (auto event : graph_fork_join_events_) CUDA_CALL(cudaEventDestroy(event));
+  if (graph_stream_) {
+    CUDA_CALL(cudaStreamSynchronize(graph_stream_));
+    for (auto& ins : instrs_) ins->SetStream(nullptr);
+    CUDA_CALL(cudaStreamDestroy(graph_stream_));
+  }
+  graph_exec_   = nullptr;
+  graph_stream_ = nullptr;
+  graph_fork_join_events_.clear();
+  graph_args_signature_.clear();
 #endif
+  graph_warmed_up_ = false;
+}
+
+void Program::SetCompiler(const std::shared_ptr<backends::Compiler>& compiler) {
+  if (compiler_) compiler_->RemoveOptimizedCallback(this);
+  compiler_ = compiler;
+  if (!compiler_) return;
+  // The instructions are fixed once the program is created, the pre-run ones may be dropped and run only once.
+  compiler_->AddOptimizedCallback(this, [this] {
+    for (auto& instr : instrs_) {
+      auto fn_names = instr->GetFnNames();
+      for (int i = 0; i < fn_names.size(); i++) {
+        if (auto fn = compiler_->LookupOptimized(fn_names[i])) instr->SwapLoweredFunc(i, fn);
+      }
+    }
+  });
+}
+
+Program::~Program() {
+  EnableIdleTrim(false);
+  if (compiler_) compiler_->RemoveOptimizedCallback(this);
+  ResetCudaGraph();
+  ResetStreams();
 }
 
 void Program::ExecuteTest(int repeat_) {
@@ -262,7 +1553,14 @@ std::string GraphCompiler::GenSourceCode() {
   return compiler_->GetSourceCode(build_module);
 }
 
+// Whether the \p node runs by the runtime kernel of its instruction, which has no lowered functions.
+bool IsMultiTensorOptimizer(const Node* node) {
+  auto& name = node->op()->name;
+  return name == "multi_tensor_sgd" || name == "multi_tensor_momentum" || name == "multi_tensor_adam";
+}
+
 std::vector<ir::LoweredFunc> GraphCompiler::GetOpFunc(const Node* node) {
+  if (IsMultiTensorOptimizer(node)) return {};
   auto& strategy   = Operator::GetAttrs<StrategyFunction>("CINNStrategy");
   auto& shape_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
   auto& dtype_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
@@ -274,15 +1572,19 @@ std::vector<ir::LoweredFunc> GraphCompiler::GetOpFunc(const Node* node) {
     std::string input_id = i->source()->as<NodeData>()->id();
     auto in_shape        = shape_dict.at(input_id);
     Type dtype           = dtype_dict.at(input_id);
-    CHECK(dtype == Float(32) || dtype.is_bool() || dtype == Int(32))
+    CHECK(dtype == Float(32) || dtype == Float(16) || dtype.is_bool() || dtype == Int(32) || dtype == Int(8))
         << "The dtype of node " << input_id << " is not float or bool or int! Other dtype is not implemented yet.";
     ir::Tensor temp;
     if (dtype == Float(32)) {
       temp = lang::Placeholder<float>(input_id, in_shape);
+    } else if (dtype == Float(16)) {
+      temp = lang::CreatePlaceHolder(std::vector<Expr>(in_shape.begin(), in_shape.end()), dtype, input_id);
     } else if (dtype.is_bool()) {
       temp = lang::Placeholder<bool>(input_id, in_shape);
     } else if (dtype == Int(32)) {
       temp = lang::Placeholder<int>(input_id, in_shape);
+    } else if (dtype == Int(8)) {
+      temp = lang::Placeholder<int8_t>(input_id, in_shape);
     }
     inputs.push_back(temp);
     cinn_inputs.push_back(common::CINNValue(temp));
@@ -319,6 +1621,144 @@ std::vector<ir::LoweredFunc> GraphCompiler::GetOpFunc(const Node* node) {
   return func;
 }
 
+// Whether the variable is only read by the nodes in the \p group, so that it is computed inline instead of written out.
+bool IsReadInGroup(const NodeData* var, const std::vector<Node*>& group) {
+  if (var->outlinks().empty()) return false;
+  for (auto& link : var->outlinks()) {
+    if (std::find(group.begin(), group.end(), link->sink()->safe_as<Node>()) == group.end()) return false;
+  }
+  return true;
+}
+
+// Whether the \p group is a cudnn or cublas call with the epilogue ops attached by OpFusion, which is lowered and built
+// as its first node.
+bool HasLibraryEpilogue(const std::vector<Node*>& group) {
+  return group.size() > 1 && group[0]->attrs.attr_store.count("library_epilogue");
+}
+
+// Whether the \p group is a bucket of the allreduces packed by AllReduceFusion, which runs as one NCCL call and is
+// lowered as its first node.
+bool IsCollectiveBucket(const std::vector<Node*>& group) {
+  return group.size() > 1 && group[0]->attrs.attr_store.count("collective_bucket");
+}
+
+// Whether the \p group is lowered to the functions of its first node.
+bool IsLoweredAsFirstNode(const std::vector<Node*>& group) {
+  return group.size() == 1 || HasLibraryEpilogue(group) || IsCollectiveBucket(group);
+}
+
+// Whether the mul \p node is computed by the unrolled kernel of pe::MatmulSmall instead of cuBLAS.
+bool IsSmallMulNode(const Node* node, const Graph* graph) {
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  auto& inlinks    = node->inlinks_in_order();
+  if (inlinks.size() != 2) return false;
+  auto& x_shape = shape_dict.at(inlinks[0]->source()->safe_as<NodeData>()->id());
+  auto& y_shape = shape_dict.at(inlinks[1]->source()->safe_as<NodeData>()->id());
+  return pe::UseSmallMul(
+      x_shape, y_shape, GetIntAttr(node, "x_num_col_dims", 1), GetIntAttr(node, "y_num_col_dims", 1));
+}
+
+// Set the attributes the multi-tensor optimizer of \p instr is built from, see Instruction::IsMultiTensorOptimizer.
+void SetMultiTensorOptimizerAttrs(const Node* node,
+                                  const absl::flat_hash_map<std::string, shape_t>& shape_dict,
+                                  const std::vector<std::string>& input_names,
+                                  Instruction* instr) {
+  auto& attr_store = node->attrs.attr_store;
+  auto get_bool    = [&](const std::string& name) {
+    return attr_store.count(name) && absl::get<bool>(attr_store.at(name));
+  };
+  auto kind            = runtime::OptimizerKindOf(node->op()->name);
+  bool multi_precision = get_bool("multi_precision");
+  int lists            = 2 + runtime::NumOptimizerStates(kind) + multi_precision;
+  int n                = (input_names.size() - (kind == runtime::OptimizerKind::kAdam ? 2 : 0)) / lists;
+  instr->attrs         = {get_bool("use_nesterov"), multi_precision};
+  for (int t = 0; t < n; t++) {
+    auto& shape = shape_dict.at(input_names[t]);
+    instr->attrs.push_back(std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<int>()));
+  }
+  // the defaults are those of runtime::MultiTensorOptimizerAttrs
+  runtime::MultiTensorOptimizerAttrs defaults;
+  instr->str_attrs.clear();
+  for (auto& item : std::vector<std::pair<std::string, float>>{{"learning_rate", defaults.learning_rate},
+                                                               {"momentum", defaults.momentum},
+                                                               {"beta1", defaults.beta1},
+                                                               {"beta2", defaults.beta2},
+                                                               {"epsilon", defaults.epsilon},
+                                                               {"weight_decay", defaults.weight_decay}}) {
+    float value = attr_store.count(item.first) ? absl::get<float>(attr_store.at(item.first)) : item.second;
+    std::stringstream ss;
+    ss << std::setprecision(9) << value;
+    instr->str_attrs.push_back(ss.str());
+  }
+}
+
+// Set the shape and the blocks the block-sparse matmul of \p instr is built from, see Instruction::IsBlockSparseMul.
+void SetBlockSparseMulAttrs(const Node* node,
+                            const absl::flat_hash_map<std::string, shape_t>& shape_dict,
+                            const std::vector<std::string>& input_names,
+                            Instruction* instr) {
+  auto& attr_store   = node->attrs.attr_store;
+  auto& x_shape      = shape_dict.at(input_names[0]);
+  auto& w_shape      = shape_dict.at(input_names[1]);
+  int x_num_col_dims = GetIntAttr(node, "x_num_col_dims", 1);
+  CHECK_EQ(w_shape.size(), 2U) << "The weight of the block-sparse mul " << node->id() << " should be [N, K]";
+  auto product = [](const shape_t& shape, int begin, int end) {
+    return std::accumulate(shape.begin() + begin, shape.begin() + end, 1, std::multiplies<int>());
+  };
+  // the defaults are those of runtime::BlockSparseMatmulAttrs
+  runtime::BlockSparseMatmulAttrs defaults;
+  instr->attrs = {product(x_shape, 0, x_num_col_dims),
+                  w_shape[0],
+                  product(x_shape, x_num_col_dims, x_shape.size()),
+                  GetIntAttr(node, "block_n", defaults.block_n),
+                  GetIntAttr(node, "block_k", defaults.block_k)};
+  float threshold  = attr_store.count("density_threshold") ? absl::get<float>(attr_store.at("density_threshold"))
+                                                           : defaults.density_threshold;
+  std::stringstream ss;
+  ss << std::setprecision(9) << threshold;
+  instr->str_attrs = {ss.str()};
+}
+
+// The offset in elements of the output of a slice in its input, if the output is a contiguous range of the input, that
+// is, the dims before the last sliced one are sliced to single elements.
+bool GetContiguousSliceOffset(const Node* node, const shape_t& in_shape, int64_t* offset) {
+  auto& attrs   = node->attrs.attr_store;
+  auto get_attr = [&](const std::string& name) {
+    return attrs.count(name) ? absl::get<std::vector<int>>(attrs.at(name)) : std::vector<int>();
+  };
+  auto starts = get_attr("starts");
+  auto ends   = get_attr("ends");
+  auto axes   = get_attr("axes");
+  int rank    = in_shape.size();
+  if (axes.empty()) {
+    for (int i = 0; i < starts.size(); i++) axes.push_back(i);
+  }
+  if (starts.empty() || starts.size() != ends.size() || starts.size() != axes.size()) return false;
+  // the same bounds as InferShapeForSlice
+  std::vector<int> begin(rank, 0), extent(in_shape);
+  for (int i = 0; i < axes.size(); i++) {
+    if (axes[i] < 0 || axes[i] >= rank) return false;
+    int dim   = in_shape[axes[i]];
+    int start = std::min(starts[i] < 0 ? starts[i] + dim : starts[i], dim);
+    int end   = std::min(ends[i] < 0 ? ends[i] + dim : ends[i], dim);
+    if (start < 0 || end <= start) return false;
+    begin[axes[i]]  = start;
+    extent[axes[i]] = end - start;
+  }
+  int last = rank - 1;
+  while (last >= 0 && extent[last] == in_shape[last]) last--;
+  for (int i = 0; i < last; i++) {
+    if (extent[i] != 1) return false;
+  }
+  *offset        = 0;
+  int64_t stride = 1;
+  for (int i = rank - 1; i >= 0; i--) {
+    *offset += begin[i] * stride;
+    stride *= in_shape[i];
+  }
+  return true;
+}
+
 // get the most complex op's index in the fused groups according to the OpPattern. If the OpPattern is same, we will
 // take the latter.
 int GetMasterRefNode(const std::vector<Node*>& nodes) {
@@ -330,6 +1770,11 @@ int GetMasterRefNode(const std::vector<Node*>& nodes) {
     master_index   = pattern >= master_pattern ? i : master_index;
     master_pattern = std::max(pattern, master_pattern);
   }
+  if (master_pattern == framework::kCommReduce && master_index != nodes.size() - 1) {
+    // The reduction has an epilogue, whose output may be of another shape, so the last op schedules the group and the
+    // reduction is computed into a temporary buffer before it.
+    master_index = nodes.size() - 1;
+  }
   VLOG(3) << "master_index: " << master_index << ", master op: " << nodes[master_index]->op()->name;
   return master_index;
 }
@@ -350,7 +1795,14 @@ std::vector<ir::LoweredFunc> GraphCompiler::GetOpFunc(const std::vector<Node*>&
   std::unordered_set<NodeData*> out_vars;
   absl::flat_hash_map<NodeData*, Expr> temp_var_map;
   ir::Tensor master_out_tensor;
-  int master_index = GetMasterRefNode(nodes);
+  // The reductions followed by an epilogue in the group, which are kept in the local buffers on NVGPU.
+  std::vector<ir::Tensor> reduce_temps;
+  // The final outputs of the other groups packed horizontally with the last one.
+  std::vector<ir::Tensor> sibling_outs;
+  // The reductions followed by an epilogue in the group, which are kept in the temporary buffers on X86.
+  std::vector<ir::Tensor> buffer_temps;
+  int master_index      = GetMasterRefNode(nodes);
+  auto& op_pattern_dict = Operator::GetAttrs<OpPatternKind>("OpPattern");
   for (auto& node : nodes) {
     std::vector<ir::Tensor> temp_inputs;
     std::vector<common::CINNValue> cinn_inputs;
@@ -370,15 +1822,19 @@ std::vector<ir::LoweredFunc> GraphCompiler::GetOpFunc(const std::vector<Node*>&
         std::string input_id = source_data->id();
         auto in_shape        = shape_dict.at(input_id);
         Type dtype           = dtype_dict.at(input_id);
-        CHECK(dtype == Float(32) || dtype.is_bool() || dtype == Int(32))
+        CHECK(dtype == Float(32) || dtype == Float(16) || dtype.is_bool() || dtype == Int(32) || dtype == Int(8))
             << "The dtype of node " << input_id << " is not float or bool or int! Other dtype is not implemented yet.";
         ir::Tensor temp_in;
         if (dtype == Float(32)) {
           temp_in = lang::Placeholder<float>(input_id, in_shape);
+        } else if (dtype == Float(16)) {
+          temp_in = lang::CreatePlaceHolder(std::vector<Expr>(in_shape.begin(), in_shape.end()), dtype, input_id);
         } else if (dtype.is_bool()) {
           temp_in = lang::Placeholder<bool>(input_id, in_shape);
         } else if (dtype == Int(32)) {
           temp_in = lang::Placeholder<int>(input_id, in_shape);
+        } else if (dtype == Int(8)) {
+          temp_in = lang::Placeholder<int8_t>(input_id, in_shape);
         }
         inputs.push_back(temp_in);
         temp_inputs.push_back(temp_in);
@@ -401,8 +1857,13 @@ std::vector<ir::LoweredFunc> GraphCompiler::GetOpFunc(const std::vector<Node*>&
       output_shapes.push_back(out_shape);
       out_types.push_back(dtype);
     }
-    auto impl =
-        OpStrategy::SelectImpl(strategy[node->op()](node->attrs, temp_inputs, out_types, output_shapes, target_));
+    auto attrs = node->attrs;
+    if (index < fuse_number - 1 || !sibling_outs.empty()) {
+      // the op with an epilogue or siblings is computed in their loop nest, so it can not be split into kernels
+      attrs.attr_store["one_kernel"] = true;
+      if (op_pattern_dict[node->op()] == framework::kCommReduce) attrs.attr_store["reduce_per_thread"] = true;
+    }
+    auto impl = OpStrategy::SelectImpl(strategy[node->op()](attrs, temp_inputs, out_types, output_shapes, target_));
 
     common::CINNValuePack C = impl->fcompute(common::CINNValuePack{cinn_inputs});
     if (index == master_index) {
@@ -413,8 +1874,9 @@ std::vector<ir::LoweredFunc> GraphCompiler::GetOpFunc(const std::vector<Node*>&
       master_out_tensor = out.as_tensor_ref();
     }
     CHECK_GE(C.size(), 2);
-    CHECK_LE(C.size() - 1, node->outlinks_in_order().size());
-    for (int i = 0; i < C.size() - 1; i++) {
+    // the last op may compute temporary tensors besides its outputs, e.g. the partial results of a reduction
+    CHECK(C.size() - 1 <= node->outlinks_in_order().size() || index == fuse_number - 1);
+    for (int i = 0; i < std::min<int>(C.size() - 1, temp_outvars.size()); i++) {
       temp_var_map[temp_outvars[i]] = C[i];
     }
     poly::StageMap temp_stages = C.back();
@@ -423,10 +1885,16 @@ std::vector<ir::LoweredFunc> GraphCompiler::GetOpFunc(const std::vector<Node*>&
       auto tensor = ir::Tensor(i.second->tensor());
       stages->InsertLazily(tensor, i.second.get());
     }
+    // The final output of a group packed horizontally, which is not read by the later nodes.
+    bool is_sibling_out = index < fuse_number - 1 && !IsReadInGroup(temp_outvars[0], nodes);
     for (int i = 0; i < C->size() - 1; i++) {
       ir::Expr temp = C[i];
       stages->InsertLazily(temp.as_tensor_ref(), temp_stages[temp.as_tensor_ref()]);
-      if (index < fuse_number - 1 && !temp.as_tensor_ref()->is_reduce_tensor()) {
+      if (i == 0 && is_sibling_out) {
+        VLOG(3) << "sibling output " << temp.as_tensor_ref()->name;
+        outputs.push_back(temp.as_tensor_ref());
+        sibling_outs.push_back(temp.as_tensor_ref());
+      } else if (index < fuse_number - 1 && !temp.as_tensor_ref()->is_reduce_tensor()) {
         // assume that only the first out_var links to other op node which will compute inline
         if (i == 0) {
           VLOG(3) << "inline " << temp.as_tensor_ref()->name;
@@ -437,12 +1905,18 @@ std::vector<ir::LoweredFunc> GraphCompiler::GetOpFunc(const std::vector<Node*>&
         }
       } else if (index < fuse_number - 1 && temp.as_tensor_ref()->is_reduce_tensor()) {
         VLOG(3) << "temp buffer " << temp.as_tensor_ref()->name;
-        if (target_.arch == Target::Arch::X86) {
-          CHECK_NE(i, 0);
-          outputs.push_back(temp.as_tensor_ref());
+        if (target_.is_cpu()) {
+          if (i == 0) {
+            // the reduction followed by its epilogue
+            temp.as_tensor_ref()->WithBuffer("global", "_" + temp.as_tensor_ref()->name + "_temp_buffer");
+            buffer_temps.push_back(temp.as_tensor_ref());
+          } else {
+            outputs.push_back(temp.as_tensor_ref());
+          }
         } else {
           temp.as_tensor_ref()->WithBuffer("local", "_" + temp.as_tensor_ref()->name + "_temp_buffer");
           stages[temp.as_tensor_ref()]->SetScope(poly::ScopeKind::kLocal);
+          if (i == 0) reduce_temps.push_back(temp.as_tensor_ref());
         }
       } else {
         if (index == fuse_number - 1) {
@@ -465,6 +1939,33 @@ std::vector<ir::LoweredFunc> GraphCompiler::GetOpFunc(const std::vector<Node*>&
     stages[final_out_tensor]->CopyTransform(stages[master_out_tensor]);
     stages[final_out_tensor]->CopyLoopInfo(stages[master_out_tensor]);
   }
+  for (auto& tensor : sibling_outs) {
+    if (tensor->is_reduce_tensor()) {
+      // the sibling reductions of the same input are each reduced in the innermost output loop of the final one, so
+      // the slice of the input they read stays in the cache.
+      CHECK(final_out_tensor->is_reduce_tensor()) << "The sibling reduction " << tensor->name << " is packed with "
+                                                  << final_out_tensor->name << ", which is not a reduction";
+      VLOG(3) << "compute the sibling reduction " << tensor->name << " in " << final_out_tensor->name;
+      stages[tensor]->ComputeAt2(stages[final_out_tensor], final_out_tensor->shape.size() - 1);
+      continue;
+    }
+    // the siblings have the same shape as the final output, so they are computed in its loop nest.
+    stages[tensor]->CopyTransform(stages[master_out_tensor]);
+    stages[tensor]->CopyLoopInfo(stages[master_out_tensor]);
+    if (target_.arch == Target::Arch::NVGPU) {
+      stages[tensor]->ComputeAt2(stages[final_out_tensor], stages[final_out_tensor]->n_out_dims() - 1);
+    }
+  }
+  for (auto& tensor : reduce_temps) {
+    // each thread computes the reduced values it reads, so the local buffer is enough.
+    stages[tensor]->ComputeAt(stages[final_out_tensor], stages[final_out_tensor]->n_out_dims() - 1);
+  }
+  for (auto& tensor : buffer_temps) {
+    // compute the reduction in the deepest legal loop of the final output, so the buffer keeps only a tile of it.
+    int level = stages[tensor]->GetDeepestComputeAtLevel(stages[final_out_tensor]);
+    VLOG(3) << "compute " << tensor->name << " at level " << level << " of " << final_out_tensor->name;
+    if (level >= 0) stages[tensor]->ComputeAt(stages[final_out_tensor], level);
+  }
 
   for (auto& s : stages) {
     auto& compute_ats = s.second->GetComputeAts();
@@ -499,12 +2000,35 @@ std::vector<ir::LoweredFunc> GraphCompiler::GetOpFunc(const std::vector<Node*>&
 }
 
 void GraphCompiler::ProcessFunction(const std::vector<ir::LoweredFunc>& lowered_func) {
+  // The symbolic dims the functions take are filled from the shapes of their buffer arguments at runtime.
+  for (auto& func : lowered_func) {
+    auto sources = func->GetDimArgSources();
+    if (sources.empty()) continue;
+    std::vector<std::pair<std::string, int>> dim_args;
+    for (int i = 0; i < sources.size(); i++) {
+      CHECK_GE(sources[i].arg, 0) << "The scalar argument " << i << " of function [" << func->name
+                                  << "] is not a symbolic dim of the buffers, which is not supported in the programs";
+      std::string name = func->args[sources[i].arg].name();
+      if (name[0] == '_') name = name.substr(1);
+      dim_args.emplace_back(name, sources[i].dim);
+    }
+    function2dim_args_[func->name] = dim_args;
+  }
+  // The instructions launch the kernels directly by their dims instead of calling the host functions.
+  for (auto& func : lowered_func) {
+    if (target_.arch != Target::Arch::NVGPU || !func->cuda_axis_info.valid()) continue;
+    auto& info                        = func->cuda_axis_info;
+    function2launch_dims_[func->name] = {{info.grid_dim(0), info.grid_dim(1), info.grid_dim(2)},
+                                         {info.block_dim(0), info.block_dim(1), info.block_dim(2)}};
+  }
   if (lowered_func.size() > 1) {
     for (auto& i : lowered_func) {
       VLOG(3) << "In lowered_func, its name is : " << i->name;
       std::vector<std::string> input_args;
       std::vector<std::string> output_args;
       for (auto& j : i->args) {
+        // the scalars are filled by the instruction, see function2dim_args_
+        if (j.is_var()) continue;
         std::string temp_arg = j.name();
         if (temp_arg[0] == '_') temp_arg = temp_arg.substr(1);
         if (j.io == ir::Argument::IO::kOutput)
@@ -521,17 +2045,20 @@ void GraphCompiler::ProcessFunction(const std::vector<ir::LoweredFunc>& lowered_
           VLOG(3) << "Tensor " << temp_arg << " is not found in scope. Now create it with shape:";
           for (auto& shape_dim : j.buffer_arg()->shape) {
             VLOG(3) << shape_dim << ",";
-            CHECK(shape_dim.is_constant());
+            if (!shape_dim.is_constant()) break;
             shape.push_back(static_cast<int>(shape_dim.get_constant()));
           }
-          tensor->Resize(Shape{shape});
+          // the tensors of the symbolic shapes are resized or bound by the caller before running
+          if (shape.size() == j.buffer_arg()->shape.size()) tensor->Resize(Shape{shape});
         }
       }
       function2input_args_[i->name]  = input_args;
       function2output_args_[i->name] = output_args;
+      function2cost_[i->name]        = EstimateKernelCost(i);
       m_builder_.AddFunction(i);
     }
   } else {
+    function2cost_[lowered_func[0]->name] = EstimateKernelCost(lowered_func[0]);
     m_builder_.AddFunction(lowered_func[0]);
   }
 }
@@ -545,62 +2072,239 @@ std::unique_ptr<Program> GraphCompiler::Build(const std::string& code) {
   return std::move(result.runtime_program);
 }
 
+std::vector<ir::LoweredFunc> GraphCompiler::Lower() {
+  std::vector<ir::LoweredFunc> funcs;
+  auto append = [&](const std::vector<ir::LoweredFunc>& lowered) {
+    funcs.insert(funcs.end(), lowered.begin(), lowered.end());
+  };
+  if (graph_->groups.empty()) {
+    for (auto* graph_node : std::get<0>(graph_->topological_order())) {
+      auto* node = graph_node->safe_as<Node>();
+      if (node) append(GetOpFunc(node));
+    }
+    return funcs;
+  }
+  for (auto& group : graph_->groups) {
+    append(IsLoweredAsFirstNode(group) ? GetOpFunc(group[0]) : GetOpFunc(group));
+  }
+  return funcs;
+}
+
 GraphCompiler::CompilationResult GraphCompiler::Build(const GraphCompiler::CompileOptions& options) {
+  utils::NvtxRange nvtx("GraphCompiler::Build");
+  common::PrecisionScope precision_scope(options.precision_mode);
+  precision_mode_ = options.precision_mode;
   auto topo_order = graph_->topological_order();
   auto& nodes     = std::get<0>(topo_order);
   auto& edges     = std::get<1>(topo_order);
 
   auto& groups = graph_->groups;
 
-  if (!groups.empty()) {
-    for (int i = 0; i < groups.size(); i++) {
-      std::vector<ir::LoweredFunc> lowered_func;
-      if (groups[i].size() == 1) {
-        lowered_func = GetOpFunc(groups[i][0]);
-      } else {
-        lowered_func = GetOpFunc(groups[i]);
-      }
-      this->ProcessFunction(lowered_func);
-    }
-  } else {
+  if (groups.empty()) {
     VLOG(3) << "not run opfusion pass";
     for (auto& node : nodes) {
       auto op_node = node->safe_as<Node>();
       if (op_node) {
-        auto lowered_func = GetOpFunc(op_node);
-        this->ProcessFunction(lowered_func);
         graph_->groups.push_back({op_node});
       }
     }
   }
+  absl::flat_hash_map<std::string, std::string> view_vars;
+  absl::flat_hash_map<std::string, SliceVar> slice_vars;
+  if ((options.with_reshape_view || options.with_slice_view) && options.with_instantiate_variables) {
+    view_vars = PlanViews(options, &slice_vars);
+  }
+  if (options.with_concat_slice && options.with_instantiate_variables) {
+    auto concat_slices = PlanSlices(options.fetch_var_ids, view_vars, slice_vars);
+    slice_vars.insert(concat_slices.begin(), concat_slices.end());
+  }
+
+  // The group whose functions each group reuses, the first one of the same signature.
+  std::vector<int> reused_group(groups.size());
+  absl::flat_hash_map<std::string, int> signature_to_group;
+  std::vector<int> groups_to_lower;
+  for (int i = 0; i < groups.size(); i++) {
+    reused_group[i] = i;
+    if (options.with_kernel_dedup) {
+      reused_group[i] = signature_to_group.emplace(GenGroupSignature(groups[i]), i).first->second;
+    }
+    if (reused_group[i] == i) groups_to_lower.push_back(i);
+  }
+
+  std::vector<std::vector<ir::LoweredFunc>> lowered_funcs(groups.size());
+  auto lower_group = [&](int i) {
+    utils::CompileGroupScope group_scope(GenGroupFuncName(groups[i]));
+    utils::CompileStageTimer timer("Lower");
+    if (IsLoweredAsFirstNode(groups[i])) {
+      lowered_funcs[i] = GetOpFunc(groups[i][0]);
+    } else {
+      lowered_funcs[i] = GetOpFunc(groups[i]);
+    }
+  };
+  if (options.num_compile_threads > 1 && groups_to_lower.size() > 1) {
+    // The groups are lowered independently, and the functions are processed in order after all of them are done, so
+    // the module keeps the same order of functions as the serial one.
+    VLOG(3) << "Lower " << groups_to_lower.size() << " groups on " << options.num_compile_threads << " threads";
+    // the workers generate the names by the generator of the calling thread, so they stay unique in its scope
+    auto* names = &common::Context::Global().name_generator();
+    utils::ThreadPool pool(std::min<int>(options.num_compile_threads, groups_to_lower.size()));
+    for (int i : groups_to_lower) {
+      pool.Schedule([&, i] {
+        common::NameScope name_scope(names);
+        common::PrecisionScope precision_scope(options.precision_mode);
+        lower_group(i);
+      });
+    }
+  } else {
+    for (int i : groups_to_lower) {
+      lower_group(i);
+    }
+  }
+  dedup_func_names_.clear();
+  for (int i = 0; i < groups.size(); i++) {
+    if (reused_group[i] != i && lowered_funcs[reused_group[i]].size() != 1) {
+      // The temporary variables passed between the functions are named after the group, so it can't be reused.
+      lower_group(i);
+      reused_group[i] = i;
+    }
+    if (reused_group[i] == i) {
+      this->ProcessFunction(lowered_funcs[i]);
+    } else {
+      dedup_func_names_[GenGroupFuncName(groups[i])] = GenGroupFuncName(groups[reused_group[i]]);
+    }
+  }
+  VLOG(3) << "Lowered " << groups.size() - dedup_func_names_.size() << " groups, " << dedup_func_names_.size()
+          << " groups reuse the functions of the others";
 
   // compile the module
   if (!compiler_) {
     compiler_ = backends::Compiler::Create(target_);
   }
+  compiler_->SetNumThreads(options.num_compile_threads);
+  compiler_->SetPrecisionMode(options.precision_mode);
 
   auto build_module = m_builder_.Build();
 
   if (this->target_.arch == Target::Arch::X86) {
-    CodeGenCX86 codegen(this->target_, CodeGenCX86::Feature::AVX512);
+    CodeGenCX86 codegen(this->target_, CodeGenCX86::GetFeature(this->target_));
     codegen.SetInlineBuiltinCodes(false);
     auto out = codegen.Compile(build_module, CodeGenC::OutputKind::CImpl);
     VLOG(3) << "[X86] C Code is:\n" << out;
   }
 
-  compiler_->Build(build_module, options.attached_code);
+  // The arguments of the fused host function are prepared from the instantiated variables.
+  // The runtime kernels of the multi-tensor optimizers and the block-sparse muls are not in the module the fused host
+  // function calls.
+  bool with_fused_host_function =
+      options.with_fused_host_function && target_.is_cpu() && options.with_instantiate_variables &&
+      options.inter_op_threads <= 1 && std::none_of(groups.begin(), groups.end(), [](const std::vector<Node*>& group) {
+        return IsMultiTensorOptimizer(group[0]) || group[0]->op()->name == "block_sparse_mul";
+      });
+  if (with_fused_host_function) {
+    compiler_->SetEntryFunction(kFusedHostFunctionName, GenRunFuncNames());
+  }
+
+  {
+    utils::CompileStageTimer timer("Backend");
+    compiler_->Build(build_module, options.attached_code);
+  }
+  if (FLAGS_cinn_trace_compile) {
+    LOG(INFO) << "The compile time so far:\n" << utils::CompileTracer::Global().Report();
+  }
+
+  std::vector<std::unique_ptr<Instruction>> instructions;
+  {
+    utils::NvtxRange nvtx("BuildInstructions");
+    instructions = BuildInstructions();
+  }
+  if (options.prepare_library_calls && target_.arch == Target::Arch::NVGPU) {
+    utils::CompileStageTimer timer("PrepareLibraryCalls");
+    for (auto& instr : instructions) instr->PrepareLibraryCall();
+  }
+  absl::flat_hash_map<std::string, std::string> inplace_vars;
+  if (options.with_inplace && options.with_instantiate_variables) {
+    inplace_vars = PlanInplace(instructions, options.fetch_var_ids, view_vars, slice_vars);
+  }
+  // The views share the memory of the variables they view, which may be written in place too.
+  auto shared_vars = inplace_vars;
+  for (auto& item : view_vars) {
+    auto it                 = inplace_vars.find(item.second);
+    shared_vars[item.first] = it == inplace_vars.end() ? item.second : it->second;
+  }
+
+  GraphCompiler::CompilationResult result;
+  result.runtime_program.reset(new Program(scope_, std::move(instructions)));
+  result.runtime_program->SetCompiler(compiler_);
   if (options.with_instantiate_variables) {
+    std::unique_ptr<MemoryPlanner> planner;
+    if (options.with_memory_plan) {
+      VLOG(3) << "Plan the memory of the intermediate variables";
+      std::vector<Instruction*> instrs;
+      for (auto& instr : result.runtime_program->GetRunInstructions()) {
+        instrs.push_back(instr.get());
+      }
+      planner.reset(new MemoryPlanner(target_, scope_.get(), options.fetch_var_ids));
+      planner->SetInplaceVars(shared_vars);
+      // the roots of the slices may be written in place too
+      absl::flat_hash_map<std::string, std::string> slice_roots;
+      for (auto& item : slice_vars) {
+        auto it                 = shared_vars.find(item.second.root);
+        slice_roots[item.first] = it == shared_vars.end() ? item.second.root : it->second;
+      }
+      planner->SetSliceVars(slice_roots);
+      planner->Plan(instrs);
+      result.runtime_program->SetMemoryArena(planner->Apply());
+    }
     VLOG(3) << "Initantiate all variables on compile-time";
-    // All variables reside in scope_, so traverse it to instantiate each one
+    // The slices and the outputs written in place refer to the memory of their roots, which can't be deferred, since
+    // binding a root doesn't bind them.
+    std::unordered_set<std::string> eager_vars;
+    for (auto& item : slice_vars) eager_vars.insert(item.second.root);
+    for (auto& item : inplace_vars) eager_vars.insert(item.second);
+    std::unordered_set<std::string> lazy_vars;
+    // All variables reside in scope_, so traverse it to instantiate each one by the element size of its dtype
     for (auto& name : scope_->var_names()) {
-      auto* var    = scope_->Var<Tensor>(std::string({name.data(), name.size()}));
+      std::string var_name({name.data(), name.size()});
+      if (planner && planner->IsPlanned(var_name)) continue;
+      if (shared_vars.count(var_name) || slice_vars.count(var_name)) continue;
+      if (options.with_lazy_instantiation && !eager_vars.count(var_name)) {
+        lazy_vars.insert(var_name);
+        continue;
+      }
+      auto* var    = scope_->Var<Tensor>(var_name);
       auto& tensor = absl::get<Tensor>(*var);
-      tensor->mutable_data<float>(target_);
+      tensor->mutable_data(target_);
+    }
+    for (auto& item : inplace_vars) {
+      VLOG(3) << "Variable [" << item.first << "] is written in place of [" << item.second << "]";
+      scope_->GetTensor(item.first)->ShareBufferWith(*scope_->GetTensor(item.second));
+    }
+    for (auto& item : view_vars) {
+      VLOG(3) << "Variable [" << item.first << "] is a view of [" << item.second << "]";
+      scope_->GetTensor(item.first)->ShareBufferWith(*scope_->GetTensor(item.second));
+    }
+    for (auto& item : slice_vars) {
+      VLOG(3) << "Variable [" << item.first << "] is a slice of [" << item.second.root << "] at " << item.second.offset;
+      scope_->GetTensor(item.first)->ShareSliceOf(*scope_->GetTensor(item.second.root), item.second.offset, target_);
+    }
+    result.runtime_program->SetViewVars(view_vars);
+    result.runtime_program->SetSliceVars(slice_vars);
+    result.runtime_program->SetLazyVars(lazy_vars);
+    if (options.num_streams > 1) {
+      result.runtime_program->SetNumStreams(options.num_streams);
+    }
+    if (options.with_cuda_graph) {
+      result.runtime_program->SetUseCudaGraph(true);
+    }
+    if (options.inter_op_threads > 1) {
+      result.runtime_program->SetNumInterOpThreads(options.inter_op_threads, options.intra_op_threads);
+    }
+    if (with_fused_host_function) {
+      // the arguments written to the arrays of the fused function refer to the memory
+      result.runtime_program->InstantiateLazyVars();
+      result.runtime_program->SetFusedHostFunction(kFusedHostFunctionName);
     }
   }
-
-  GraphCompiler::CompilationResult result;
-  result.runtime_program.reset(new Program(scope_, BuildInstructions()));
   return result;
 }
 
@@ -610,18 +2314,72 @@ std::vector<std::unique_ptr<Instruction>> GraphCompiler::BuildInstructions() {
   auto& nodes     = std::get<0>(topo_order);
   auto& edges     = std::get<1>(topo_order);
 
-  auto& groups = graph_->groups;
+  auto& groups  = graph_->groups;
+  auto op_names = [](const std::vector<Node*>& group) {
+    std::vector<std::string> names;
+    for (auto* node : group) names.push_back(node->op()->name);
+    return names;
+  };
+  auto node_ids = [](const std::vector<Node*>& group) {
+    std::vector<std::string> ids;
+    for (auto* node : group) ids.push_back(node->id());
+    return ids;
+  };
   for (auto& group : groups) {
-    if (group.size() == 1) {
-      auto node  = group[0];
+    if (IsLoweredAsFirstNode(group)) {
+      auto node         = group[0];
+      auto input_names  = OpGetInputNames(node);
+      auto output_names = OpGetOutputNames(node);
+      if (IsCollectiveBucket(group)) {
+        // The bucket reads the inputs and writes the outputs of all its members in order.
+        for (int i = 1; i < group.size(); i++) {
+          for (auto& name : OpGetInputNames(group[i])) input_names.push_back(name);
+          for (auto& name : OpGetOutputNames(group[i])) output_names.push_back(name);
+        }
+      } else {
+        // The library call also reads the operands of its epilogue ops, bias first and then residual, and writes the
+        // output of the last one.
+        for (int i = 1; i < group.size(); i++) {
+          for (auto& name : OpGetInputNames(group[i])) {
+            if (name != OpGetOutputNames(group[i - 1]).front()) input_names.push_back(name);
+          }
+          output_names.front() = OpGetOutputNames(group[i]).front();
+        }
+      }
       auto instr = std::unique_ptr<Instruction>(
-          new Instruction(target_, scope_.get(), OpGetInputNames(node), OpGetOutputNames(node), node->op()->name));
+          new Instruction(target_, scope_.get(), input_names, output_names, node->op()->name));
+      if (instr->IsCollective()) {
+        bool with_nccl = false;
+#ifdef CINN_WITH_NCCL
+        with_nccl = target_.arch == Target::Arch::NVGPU;
+#endif
+        // The kernels of the collectives only compute the result of a single rank.
+        CHECK(with_nccl || GetIntAttr(node, "nranks", 1) == 1)
+            << "The collective " << node->id() << " across ranks needs CINN built with NCCL on NVGPU";
+      }
+      if (instr->IsMultiTensorOptimizer()) {
+        // it runs by the runtime kernel built from the attributes, without the functions to look up
+        auto& shape_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+        SetMultiTensorOptimizerAttrs(node, shape_dict, input_names, instr.get());
+        instr->SetOpNames(op_names(group));
+        instr->SetNodeIds(node_ids(group));
+        instr->SetPrecisionMode(precision_mode_);
+        instructions.push_back(std::move(instr));
+        continue;
+      }
       if (target_.arch == Target::Arch::NVGPU) {
+        // the library calls take the shapes in the NCHW order, also for the NHWC data and the OHWI weights
+        bool nhwc       = node->attrs.attr_store.count("data_format") &&
+                    absl::get<std::string>(node->attrs.attr_store.at("data_format")) == "NHWC";
+        auto nchw_order = [&](shape_t shape) {
+          if (nhwc && shape.size() == 4) std::rotate(shape.begin() + 1, shape.begin() + 3, shape.end());
+          return shape;
+        };
         if (node->op()->name == "conv2d") {
           auto& shape_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
           for (auto& in_node : node->inlinks_in_order()) {
             std::string in_id = in_node->source()->safe_as<NodeData>()->id();
-            auto in_shape     = shape_dict.at(in_id);
+            auto in_shape     = nchw_order(shape_dict.at(in_id));
             instr->attrs.insert(instr->attrs.end(), in_shape.begin(), in_shape.end());
           }
           // padding stride dilation  group
@@ -636,9 +2394,10 @@ std::vector<std::unique_ptr<Instruction>> GraphCompiler::BuildInstructions() {
           CHECK(!node->outlinks_in_order().empty());
           auto& out_node     = node->outlinks_in_order().front();
           std::string out_id = out_node->sink()->safe_as<NodeData>()->id();
-          auto out_shape     = shape_dict.at(out_id);
+          auto out_shape     = nchw_order(shape_dict.at(out_id));
           instr->attrs.insert(instr->attrs.end(), out_shape.begin(), out_shape.end());
           CHECK_EQ(instr->attrs.size(), 19UL);
+          if (nhwc) instr->attrs.push_back(1);
           // conv type {forward, backward_data, backward_filter}
           std::string type = "forward";
           if (node->attrs.attr_store.find("conv_type") != node->attrs.attr_store.end()) {
@@ -677,7 +2436,7 @@ std::vector<std::unique_ptr<Instruction>> GraphCompiler::BuildInstructions() {
           auto& shape_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
           for (auto& in_node : node->inlinks_in_order()) {
             std::string in_id = in_node->source()->safe_as<NodeData>()->id();
-            auto in_shape     = shape_dict.at(in_id);
+            auto in_shape     = nchw_order(shape_dict.at(in_id));
             CHECK_EQ(in_shape.size(), 4UL);
             instr->attrs.insert(instr->attrs.end(), in_shape.begin(), in_shape.end());
           }
@@ -710,7 +2469,7 @@ std::vector<std::unique_ptr<Instruction>> GraphCompiler::BuildInstructions() {
 
           for (auto& out_node : node->outlinks_in_order()) {
             std::string out_id = out_node->sink()->safe_as<NodeData>()->id();
-            auto out_shape     = shape_dict.at(out_id);
+            auto out_shape     = nchw_order(shape_dict.at(out_id));
             instr->attrs.insert(instr->attrs.end(), out_shape.begin(), out_shape.end());
           }
           if (node->attrs.attr_store.find("adaptive") != node->attrs.attr_store.end()) {
@@ -722,6 +2481,7 @@ std::vector<std::unique_ptr<Instruction>> GraphCompiler::BuildInstructions() {
           }
           CHECK_EQ(instr->attrs.size(), 17UL);
           CHECK_EQ(instr->str_attrs.size(), 1UL);
+          if (nhwc) instr->str_attrs.push_back("NHWC");
         } else if (node->op()->name == "softmax") {
           auto& shape_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
           for (auto& in_node : node->inlinks_in_order()) {
@@ -730,7 +2490,8 @@ std::vector<std::unique_ptr<Instruction>> GraphCompiler::BuildInstructions() {
             instr->attrs.insert(instr->attrs.end(), in_shape.begin(), in_shape.end());
           }
           AddAttrs(node->attrs.attr_store, {"axis"}, instr.get());
-        } else if (node->op()->name == "mul") {
+        } else if (node->op()->name == "mul" && !IsSmallMulNode(node, graph_.get())) {
+          // the tiny muls are left to the unrolled kernels of pe::MatmulSmall
           auto& shape_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
           for (auto& in_node : node->inlinks_in_order()) {
             std::string in_id = in_node->source()->safe_as<NodeData>()->id();
@@ -749,10 +2510,72 @@ std::vector<std::unique_ptr<Instruction>> GraphCompiler::BuildInstructions() {
           } else {
             instr->attrs.push_back(1);
           }
+        } else if (node->op()->name == "matmul" && FLAGS_cinn_matmul_library != "kernel") {
+          auto& shape_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+          auto& dtype_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+          auto& inlinks    = node->inlinks_in_order();
+          auto& a_shape    = shape_dict.at(inlinks[0]->source()->safe_as<NodeData>()->id());
+          auto& b_shape    = shape_dict.at(inlinks[1]->source()->safe_as<NodeData>()->id());
+          auto dtype       = dtype_dict.at(OpGetOutputNames(node).front());
+          auto& attr_store = node->attrs.attr_store;
+          bool trans_a     = attr_store.count("trans_a") && absl::get<bool>(attr_store.at("trans_a"));
+          bool trans_b     = attr_store.count("trans_b") && absl::get<bool>(attr_store.at("trans_b"));
+          float alpha      = attr_store.count("alpha") ? absl::get<float>(attr_store.at("alpha")) : 1.f;
+          int batch_a      = 1;
+          int batch_b      = 1;
+          for (int i = 0; i + 2 < a_shape.size(); i++) batch_a *= a_shape[i];
+          for (int i = 0; i + 2 < b_shape.size(); i++) batch_b *= b_shape[i];
+          // cuBLAS runs the float and half matmuls of the matrices, whose batches are flattened, while the vectors
+          // are left to the generated kernels.
+          if (a_shape.size() >= 2 && a_shape.size() == b_shape.size() &&
+              (batch_a == batch_b || batch_a == 1 || batch_b == 1) && (dtype == Float(32) || dtype == Float(16))) {
+            int rank = a_shape.size();
+            int m    = trans_a ? a_shape[rank - 1] : a_shape[rank - 2];
+            int k    = trans_a ? a_shape[rank - 2] : a_shape[rank - 1];
+            int n    = trans_b ? b_shape[rank - 2] : b_shape[rank - 1];
+            // the unrolled kernels of pe::MatmulSmall beat the launches of cuBLAS on the tiny matrices
+            if (FLAGS_cinn_matmul_library == "cublas" || !pe::UseSmallMatmul(m, n, k)) {
+              instr->attrs.insert(instr->attrs.end(), {batch_a, batch_b, m, n, k, trans_a, trans_b});
+              std::stringstream ss;
+              ss << std::setprecision(9) << alpha;
+              instr->str_attrs.push_back(ss.str());
+            }
+          }
+        } else if (instr->IsCollective()) {
+          // the ring and the number of elements of each input, the bucketed allreduces have several
+          auto& shape_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+          auto& dtype_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+          auto& attr_store = node->attrs.attr_store;
+          instr->attrs     = {GetIntAttr(node, "ring_id", 0), GetIntAttr(node, "nranks", 1)};
+          for (auto& name : input_names) {
+            auto& shape = shape_dict.at(name);
+            instr->attrs.push_back(std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<int>()));
+          }
+          std::stringstream dtype;
+          dtype << dtype_dict.at(input_names.front());
+          instr->str_attrs = {
+              attr_store.count("reduce_type") ? absl::get<std::string>(attr_store.at("reduce_type")) : "sum",
+              dtype.str()};
+        }
+        if (node->attrs.attr_store.count("library_epilogue")) {
+          auto& epilogue = absl::get<std::vector<std::string>>(node->attrs.attr_store.at("library_epilogue"));
+          instr->str_attrs.insert(instr->str_attrs.end(), epilogue.begin(), epilogue.end());
+        }
+        if (node->op()->name == "conv2d" || ((node->op()->name == "mul" || node->op()->name == "matmul") &&
+                                             !instr->attrs.empty())) {
+          // the float16 convs, muls and matmuls, e.g. by AutoMixedPrecision, run cudnn and cublas in half
+          auto& dtype_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+          if (dtype_dict.at(OpGetOutputNames(node).front()) == Float(16)) instr->str_attrs.push_back("float16");
         }
       }
+      if (instr->IsBlockSparseMul()) {
+        // it also has the functions of the dense mul, which run if the weight turns out dense
+        auto& shape_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+        SetBlockSparseMulAttrs(node, shape_dict, input_names, instr.get());
+      }
       std::string op_func_name = GenOpFuncName(node);
-      auto* fn                 = compiler_->Lookup(op_func_name);
+      if (dedup_func_names_.count(op_func_name)) op_func_name = dedup_func_names_.at(op_func_name);
+      auto* fn = compiler_->Lookup(op_func_name);
       CHECK(fn);
       instr->SetLoweredFunc(fn, op_func_name);
       int i                   = 1;
@@ -774,6 +2597,9 @@ std::vector<std::unique_ptr<Instruction>> GraphCompiler::BuildInstructions() {
       if (node->attrs.attr_store.count("pre_run")) {
         instr->pre_run = absl::get<bool>(node->attrs.attr_store["pre_run"]);
       }
+      instr->SetOpNames(op_names(group));
+      instr->SetNodeIds(node_ids(group));
+      instr->SetPrecisionMode(precision_mode_);
       instructions.push_back(std::move(instr));
     } else {
       CHECK_GT(group.size(), 1U) << "fuse number should be greater than 1";
@@ -798,8 +2624,10 @@ std::vector<std::unique_ptr<Instruction>> GraphCompiler::BuildInstructions() {
         for (int j = 0; j < temp_outputnames.size(); j++) {
           if (!names_set.count(temp_outputnames[j])) {
             names_set.insert(temp_outputnames[j]);
-            // assume that the first out_var of the op node is the fused var
-            if (j == 0 && i != group.size() - 1) continue;
+            // assume that the first out_var of the op node is the fused var, except the final outputs of the groups
+            // packed horizontally
+            auto* out_var = node->outlinks_in_order().front()->sink()->safe_as<NodeData>();
+            if (j == 0 && i != group.size() - 1 && IsReadInGroup(out_var, group)) continue;
             if (j == 0 && i == group.size() - 1) {
               outputNames.insert(outputNames.begin(), temp_outputnames[0]);
             } else {
@@ -809,6 +2637,7 @@ std::vector<std::unique_ptr<Instruction>> GraphCompiler::BuildInstructions() {
         }
       }
       fuse_name += "fused";
+      if (dedup_func_names_.count(fuse_name)) fuse_name = dedup_func_names_.at(fuse_name);
       VLOG(3) << fuse_name;
       auto instr =
           std::unique_ptr<Instruction>(new Instruction(target_, scope_.get(), inputNames, outputNames, fuse_name));
@@ -817,12 +2646,336 @@ std::vector<std::unique_ptr<Instruction>> GraphCompiler::BuildInstructions() {
       auto* fn = compiler_->Lookup(fuse_name);
       CHECK(fn);
       instr->SetLoweredFunc(fn, fuse_name);
+      // the group lowered into several kernels on NVGPU runs them in order
+      if (function2input_args_.count(fuse_name + "_1")) {
+        CHECK_GT(function2input_args_.count(fuse_name), 0);
+        instr->AddInArgs(function2input_args_[fuse_name]);
+        instr->AddOutArgs(function2output_args_[fuse_name]);
+        for (int i = 1; function2input_args_.count(fuse_name + "_" + std::to_string(i)); i++) {
+          std::string func_name = fuse_name + "_" + std::to_string(i);
+          auto* fn2             = compiler_->Lookup(func_name);
+          CHECK(fn2);
+          instr->SetLoweredFunc(fn2, func_name);
+          instr->AddInArgs(function2input_args_[func_name]);
+          instr->AddOutArgs(function2output_args_[func_name]);
+        }
+      }
+      // OpFusion only fuses a constant region within itself
+      auto& attrs = group[0]->attrs.attr_store;
+      if (attrs.count("pre_run")) {
+        instr->pre_run = absl::get<bool>(attrs.at("pre_run"));
+      }
+      instr->SetOpNames(op_names(group));
+      instr->SetNodeIds(node_ids(group));
+      instr->SetPrecisionMode(precision_mode_);
       instructions.push_back(std::move(instr));
     }
   }
+  // the profiler reports the achieved rates of the kernels by their static costs
+  for (auto& instr : instructions) {
+    auto fn_names = instr->GetFnNames();
+    for (int i = 0; i < fn_names.size(); i++) {
+      auto it = function2cost_.find(fn_names[i]);
+      if (it != function2cost_.end()) instr->SetKernelCost(i, it->second);
+      auto dims = function2dim_args_.find(fn_names[i]);
+      if (dims != function2dim_args_.end()) instr->SetDimArgs(i, dims->second);
+      auto launch = function2launch_dims_.find(fn_names[i]);
+      if (launch != function2launch_dims_.end()) instr->SetLaunchDims(i, launch->second.first, launch->second.second);
+    }
+  }
   return instructions;
 }
 
+absl::flat_hash_map<std::string, std::string> GraphCompiler::PlanInplace(
+    const std::vector<std::unique_ptr<Instruction>>& instrs,
+    const std::unordered_set<std::string>& reserved_vars,
+    const absl::flat_hash_map<std::string, std::string>& view_vars,
+    const absl::flat_hash_map<std::string, SliceVar>& slice_vars) {
+  auto& op_pattern_dict = Operator::GetAttrs<OpPatternKind>("OpPattern");
+  auto& shape_dict      = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  auto& dtype_dict      = graph_->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  auto& groups          = graph_->groups;
+  CHECK_EQ(groups.size(), instrs.size()) << "Each group should be built into one instruction";
+
+  // The last instruction reading each variable, and the variables produced by the instructions.
+  absl::flat_hash_map<std::string, int> last_read;
+  std::unordered_set<std::string> produced;
+  for (int t = 0; t < instrs.size(); t++) {
+    if (instrs[t]->pre_run) continue;
+    for (auto& args : instrs[t]->GetInArgs()) {
+      for (auto& name : args) last_read[name] = t;
+    }
+    for (auto& args : instrs[t]->GetOutArgs()) {
+      produced.insert(args.begin(), args.end());
+    }
+  }
+
+  // The views and the variables they view are read through each other, and so are the slices and their roots.
+  std::unordered_set<std::string> viewed_vars;
+  for (auto& item : view_vars) {
+    viewed_vars.insert(item.first);
+    viewed_vars.insert(item.second);
+  }
+  for (auto& item : slice_vars) {
+    viewed_vars.insert(item.first);
+    viewed_vars.insert(item.second.root);
+  }
+
+  absl::flat_hash_map<std::string, std::string> inplace_vars;
+  for (int t = 0; t < instrs.size(); t++) {
+    if (instrs[t]->pre_run) continue;
+    auto in_args  = instrs[t]->GetInArgs();
+    auto out_args = instrs[t]->GetOutArgs();
+    // With more functions or outputs, the input might be read after the output is written.
+    if (in_args.size() != 1 || out_args[0].size() != 1) continue;
+    bool elementwise = std::all_of(groups[t].begin(), groups[t].end(), [&](Node* node) {
+      return op_pattern_dict[node->op()] <= OpPatternKind::kBroadcast;
+    });
+    if (!elementwise) continue;
+
+    auto& out = out_args[0][0];
+    if (slice_vars.count(out)) continue;
+    for (auto& in : in_args[0]) {
+      if (in == out || !produced.count(in) || reserved_vars.count(in) || viewed_vars.count(in) || last_read[in] != t) {
+        continue;
+      }
+      if (shape_dict.at(in) != shape_dict.at(out) || dtype_dict.at(in) != dtype_dict.at(out)) continue;
+      auto it           = inplace_vars.find(in);
+      inplace_vars[out] = it == inplace_vars.end() ? in : it->second;
+      break;
+    }
+  }
+  VLOG(3) << "Found " << inplace_vars.size() << " variables to write in place";
+  return inplace_vars;
+}
+
+absl::flat_hash_map<std::string, std::string> GraphCompiler::PlanViews(
+    const CompileOptions& options, absl::flat_hash_map<std::string, SliceVar>* slice_vars) {
+  auto& dtype_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  auto& shape_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  // the slices can't be bound, so the outputs of the program are not sliced
+  std::unordered_set<std::string> read_vars;
+  for (auto& group : graph_->groups) {
+    for (auto* node : group) {
+      for (auto& name : OpGetInputNames(node)) read_vars.insert(name);
+    }
+  }
+  auto can_slice = [&](const std::string& name) {
+    return options.with_slice_view && read_vars.count(name) && !options.fetch_var_ids.count(name);
+  };
+
+  absl::flat_hash_map<std::string, std::string> view_vars;
+  std::vector<std::vector<Node*>> groups;
+  for (auto& group : graph_->groups) {
+    auto* node  = group[0];
+    auto& attrs = node->attrs.attr_store;
+    // the pre-run reshapes are run once by PrePack, and their inputs may be dropped after that
+    bool pre_run = attrs.count("pre_run") && absl::get<bool>(attrs.at("pre_run"));
+    if (group.size() != 1 || pre_run) {
+      groups.push_back(group);
+      continue;
+    }
+    auto& op_name = node->op()->name;
+    auto in       = OpGetInputNames(node).front();
+    auto out      = OpGetOutputNames(node).front();
+    if (op_name == "reshape" && options.with_reshape_view && dtype_dict.at(in) == dtype_dict.at(out)) {
+      // the groups are in the topological order, so the variable viewed is already mapped if it is a view or a slice
+      auto slice = slice_vars->find(in);
+      if (slice != slice_vars->end()) {
+        if (can_slice(out)) {
+          auto range         = slice->second;
+          (*slice_vars)[out] = range;
+          continue;
+        }
+      } else {
+        auto it        = view_vars.find(in);
+        view_vars[out] = it == view_vars.end() ? in : it->second;
+        continue;
+      }
+    }
+    int64_t offset = 0;
+    if (op_name == "slice" && can_slice(out) && dtype_dict.at(in) == dtype_dict.at(out) &&
+        GetContiguousSliceOffset(node, shape_dict.at(in), &offset)) {
+      auto view = view_vars.find(in);
+      SliceVar range{view == view_vars.end() ? in : view->second, 0};
+      auto slice = slice_vars->find(range.root);
+      if (slice != slice_vars->end()) range = slice->second;
+      range.offset += offset * scope_->GetTensor(in)->element_bytes();
+      if (range.offset % kSliceAlignment == 0) {
+        (*slice_vars)[out] = range;
+        continue;
+      }
+    }
+    groups.push_back(group);
+  }
+  VLOG(3) << "Found " << view_vars.size() << " reshapes to run as views, and " << slice_vars->size()
+          << " reshapes or slices to run as slices";
+  graph_->groups = std::move(groups);
+  return view_vars;
+}
+
+absl::flat_hash_map<std::string, SliceVar> GraphCompiler::PlanSlices(
+    const std::unordered_set<std::string>& reserved_vars,
+    const absl::flat_hash_map<std::string, std::string>& view_vars,
+    const absl::flat_hash_map<std::string, SliceVar>& slice_views) {
+  auto& shape_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  auto is_pre_run  = [](const Node* node) {
+    auto& attrs = node->attrs.attr_store;
+    return attrs.count("pre_run") && absl::get<bool>(attrs.at("pre_run"));
+  };
+  auto is_concat = [&](const std::vector<Node*>& group) {
+    return group.size() == 1 && group[0]->op()->name == "concat" && !is_pre_run(group[0]);
+  };
+  // the variables written by the instructions run each time, which the slices are taken from, the outputs of the
+  // concats kept are added below
+  std::unordered_set<std::string> produced, viewed;
+  for (auto& group : graph_->groups) {
+    if (is_concat(group) || is_pre_run(group[0])) continue;
+    for (auto* node : group) {
+      for (auto& name : OpGetOutputNames(node)) produced.insert(name);
+    }
+  }
+  for (auto& item : view_vars) {
+    viewed.insert(item.first);
+    viewed.insert(item.second);
+  }
+  for (auto& item : slice_views) {
+    viewed.insert(item.first);
+    viewed.insert(item.second.root);
+  }
+
+  absl::flat_hash_map<std::string, SliceVar> slice_vars;
+  std::unordered_set<std::string> roots;
+  std::vector<std::vector<Node*>> groups;
+  for (auto& group : graph_->groups) {
+    if (!is_concat(group)) {
+      groups.push_back(group);
+      continue;
+    }
+    auto inputs      = OpGetInputNames(group[0]);
+    auto out         = OpGetOutputNames(group[0]).front();
+    auto& out_shape  = shape_dict.at(out);
+    int axis         = GetIntAttr(group[0], "axis", 0);
+    axis             = axis < 0 ? axis + out_shape.size() : axis;
+    int outer        = std::accumulate(out_shape.begin(), out_shape.begin() + axis, 1, std::multiplies<int>());
+    int inner        = std::accumulate(out_shape.begin() + axis + 1, out_shape.end(), 1, std::multiplies<int>());
+    auto elem_bytes  = scope_->GetTensor(out)->element_bytes();
+    bool contiguous  = outer == 1 && !viewed.count(out);
+    std::unordered_set<std::string> distinct;
+    std::vector<uint32_t> offsets;
+    uint32_t offset = 0;
+    for (auto& in : inputs) {
+      if (!contiguous) break;
+      contiguous = (produced.count(in) || roots.count(in)) && !reserved_vars.count(in) && !viewed.count(in) &&
+                   !slice_vars.count(in) && distinct.insert(in).second && offset % kSliceAlignment == 0;
+      offsets.push_back(offset);
+      offset += shape_dict.at(in)[axis] * inner * elem_bytes;
+    }
+    if (!contiguous) {
+      groups.push_back(group);
+      produced.insert(out);
+      continue;
+    }
+    for (int i = 0; i < inputs.size(); i++) {
+      // the slices of an input concatenated again are moved into the new output
+      for (auto& item : slice_vars) {
+        if (item.second.root == inputs[i]) item.second = {out, item.second.offset + offsets[i]};
+      }
+      roots.erase(inputs[i]);
+      slice_vars[inputs[i]] = {out, offsets[i]};
+    }
+    roots.insert(out);
+  }
+  VLOG(3) << "Found " << graph_->groups.size() - groups.size() << " concats to run as no-ops, whose inputs are "
+          << slice_vars.size() << " slices";
+  graph_->groups = std::move(groups);
+  return slice_vars;
+}
+
+std::string GraphCompiler::GenGroupFuncName(const std::vector<Node*>& group) const {
+  if (IsLoweredAsFirstNode(group)) return GenOpFuncName(group[0]);
+  std::string fuse_name = "fn_";
+  for (auto* node : group) fuse_name += node->id() + "_";
+  return fuse_name + "fused";
+}
+
+namespace {
+
+struct AttrPrinter {
+  std::ostream& os;
+
+  template <typename T>
+  void operator()(const T& value) {
+    os << value;
+  }
+
+  template <typename T>
+  void operator()(const std::vector<T>& values) {
+    os << "[";
+    for (const auto& value : values) os << value << ",";
+    os << "]";
+  }
+};
+
+}  // namespace
+
+std::string GraphCompiler::GenGroupSignature(const std::vector<Node*>& group) const {
+  auto& shape_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  auto& dtype_dict = graph_->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  std::stringstream ss;
+  // Print the floats exactly, or the attributes differing slightly are mistaken as the same.
+  ss << std::hexfloat;
+  auto print_var = [&](const std::string& name) {
+    ss << "(" << utils::Join(shape_dict.at(name), ",") << ")" << dtype_dict.at(name);
+  };
+  // The outputs of the nodes in the group are referred to by their indice, and the inputs from outside by the order
+  // they appear.
+  absl::flat_hash_map<std::string, std::string> var_ids;
+  for (int i = 0; i < group.size(); i++) {
+    auto* node = group[i];
+    ss << node->op()->name << "{";
+    std::map<std::string, AttrType> attrs(node->attrs.attr_store.begin(), node->attrs.attr_store.end());
+    for (auto& attr : attrs) {
+      ss << attr.first << "=" << attr.second.index() << ":";
+      absl::visit(AttrPrinter{ss}, attr.second);
+      ss << ";";
+    }
+    ss << "}(";
+    for (auto& name : OpGetInputNames(node)) {
+      auto it = var_ids.find(name);
+      if (it == var_ids.end()) it = var_ids.emplace(name, "in" + std::to_string(var_ids.size())).first;
+      ss << it->second;
+      print_var(name);
+      ss << ",";
+    }
+    ss << ")->(";
+    auto output_names = OpGetOutputNames(node);
+    for (int j = 0; j < output_names.size(); j++) {
+      var_ids[output_names[j]] = "out" + std::to_string(i) + "." + std::to_string(j);
+      print_var(output_names[j]);
+      ss << ",";
+    }
+    ss << ");";
+  }
+  return ss.str();
+}
+
+std::vector<std::string> GraphCompiler::GenRunFuncNames() const {
+  std::vector<std::string> names;
+  for (auto& group : graph_->groups) {
+    auto& attrs = group[0]->attrs.attr_store;
+    if (attrs.count("pre_run") && absl::get<bool>(attrs.at("pre_run"))) continue;
+    std::string name = GenGroupFuncName(group);
+    if (dedup_func_names_.count(name)) name = dedup_func_names_.at(name);
+    names.push_back(name);
+    if (group.size() > 1) continue;
+    for (int i = 1; function2input_args_.count(name + "_" + std::to_string(i)); i++) {
+      names.push_back(name + "_" + std::to_string(i));
+    }
+  }
+  return names;
+}
+
 std::vector<std::string> GraphCompiler::OpGetInputNames(const Node* node) const {
   std::vector<std::string> res;
   for (auto& i : node->inlinks_in_order()) {
@@ -843,6 +2996,10 @@ std::shared_ptr<Scope> BuildScope(Target target, const std::shared_ptr<Graph>& g
   auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
   auto& dtype_dict = graph->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
   if (!scope) scope = std::make_shared<Scope>();
+  if (graph->HasAttr("eliminated_vars")) {
+    // the variables dropped from the graph, e.g. by DeadCodeElimination, are not instantiated in the given scope either
+    for (auto& name : graph->GetAttrs<std::vector<std::string>>("eliminated_vars")) scope->EraseVar(name);
+  }
   for (auto& iter : shape_dict) {
     auto* var    = scope->Var<Tensor>(iter.first);
     auto& tensor = absl::get<Tensor>(*var);
@@ -852,9 +3009,12 @@ std::shared_ptr<Scope> BuildScope(Target target, const std::shared_ptr<Graph>& g
     }
     VLOG(3) << "Tensor [" << iter.first << "] resize to " << utils::Join(shape, ",");
     tensor->Resize(Shape{shape});
-    CHECK(dtype_dict.at(iter.first) == Float(32) || dtype_dict.at(iter.first).is_bool() ||
-          dtype_dict.at(iter.first) == Int(32))
+    auto& dtype = dtype_dict.at(iter.first);
+    CHECK(dtype == Float(32) || dtype == Float(16) || dtype == BFloat16() || dtype == Float(64) || dtype.is_bool() ||
+          dtype == Int(32) || dtype == Int(64) || dtype == Int(8))
         << "The dtype of node " << iter.first << " is not float or bool or int! Other dtype is not implemented yet.";
+    // the tensors are allocated by the element size of their dtypes
+    tensor->set_type(dtype);
   }
   return scope;
 }
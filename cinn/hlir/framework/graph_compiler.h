@@ -14,18 +14,29 @@
 
 #pragma once
 
+#include <absl/container/flat_hash_map.h>
+
+#include <array>
+#include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "cinn/backends/compiler.h"
 #include "cinn/backends/cuda_util.h"
 #include "cinn/common/macros.h"
+#include "cinn/common/precision.h"
 #include "cinn/hlir/framework/graph.h"
 #include "cinn/hlir/framework/instruction.h"
+#include "cinn/hlir/framework/instruction_dag.h"
+#include "cinn/hlir/framework/memory_planner.h"
 #include "cinn/hlir/framework/op_strategy.h"
+#include "cinn/hlir/framework/parallel_executor.h"
+#include "cinn/hlir/framework/resource_manager.h"
 #include "cinn/hlir/framework/scope.h"
 #include "cinn/ir/lowered_func.h"
 #include "cinn/lang/packed_func.h"
@@ -35,6 +46,82 @@ namespace cinn {
 namespace hlir {
 namespace framework {
 
+/**
+ * The memory held by a program, in bytes.
+ */
+struct MemoryReport {
+  //! The bytes of each variable in descending order, the planned ones refer to the memory arena.
+  std::vector<std::pair<std::string, size_t>> tensors;
+  //! The variables not produced by the instructions, e.g. the parameters, the prepacked weights and the inputs.
+  size_t parameter_bytes{};
+  //! The variables produced by the instructions, including the memory arena.
+  size_t intermediate_bytes{};
+  //! The workspace of the external libraries, only cuDNN allocates it explicitly for now.
+  size_t workspace_bytes{};
+  //! The peak of the total bytes observed after each Execute while tracking, or the current total if not tracked.
+  size_t peak_bytes{};
+  //! Whether the intermediates are released by Program::Trim now, the next Execute allocates them again.
+  bool trimmed{};
+  //! The number of the trims releasing any memory, and the bytes they released in total.
+  int num_trims{};
+  size_t trimmed_bytes{};
+  //! The microseconds since the last Execute finished, or since the program was created.
+  int64_t idle_us{};
+
+  size_t total_bytes() const { return parameter_bytes + intermediate_bytes + workspace_bytes; }
+};
+
+std::ostream& operator<<(std::ostream& os, const MemoryReport& report);
+
+//! The options of Program::Warmup.
+struct WarmupOptions {
+  //! The variables filled with zeros as the synthetic inputs, e.g. the feeds, zeros being valid indices of the gathers
+  //! and the embeddings. The other variables run with the data they hold, so the parameters should be loaded first.
+  std::vector<std::string> inputs;
+  //! The runs on the synthetic inputs. The first one selects between the library calls and the kernels and loads the
+  //! CUDA modules, the second one captures the CUDA graph if used.
+  int runs{2};
+  //! Whether to wait for the functions optimized in the background by the tiered compilation.
+  bool wait_optimized{true};
+};
+
+//! The time in milliseconds Program::Warmup takes, the gap between the first and the last runs is the first-run cost.
+struct WarmupReport {
+  //! Waiting for the optimized functions, resolving the library calls, reserving the workspaces and the page faults.
+  double prepare_ms{};
+  double first_run_ms{};
+  double last_run_ms{};
+  double total_ms{};
+};
+
+std::ostream& operator<<(std::ostream& os, const WarmupReport& report);
+
+/**
+ * A variable referring to a contiguous range of the buffer of another one without owning any memory, e.g. an input of
+ * a concat whose producer writes it straight into the output of the concat.
+ */
+struct SliceVar {
+  //! The variable whose buffer it refers to, which is not a slice itself.
+  std::string root;
+  //! The offset of the range in bytes.
+  uint32_t offset{};
+};
+
+/**
+ * The options of exporting a program as an ahead-of-time compiled library, see Program::ExportLibrary.
+ */
+struct LibraryExportOptions {
+  //! The prefix of the files and the symbols exported, e.g. `lib<name>.a`, `<name>.h` and `<name>_run`.
+  std::string name{"model"};
+  //! The variables `<name>_run` feeds and fetches, in the order of its arguments.
+  std::vector<std::string> inputs;
+  std::vector<std::string> outputs;
+  //! The variables saved with their data, e.g. the parameters, the outputs of the pre-run instructions are saved too.
+  std::vector<std::string> persistent_vars;
+  //! Whether to embed the program file in the library, or load it from `<name>.cinn` by the path given at runtime.
+  bool embed_program{true};
+};
+
 /**
  * The Program is the runtime instance for running a computation.
  */
@@ -49,12 +136,64 @@ class Program {
 
   void PreRun(const std::map<std::string, cinn_pod_value_t>* name2podargs = nullptr);
 
+  /**
+   * Run the pre-run instructions once as a prepack stage, e.g. the layout transforms of the constant weights inserted
+   * by AlterLayout, then drop them together with the variables only used by them(e.g. the unpacked weights) from the
+   * scope, except the \p keep_vars. The packed results are kept as the prepacked variables.
+   * @return The names of the variables dropped.
+   */
+  std::vector<std::string> PrePack(const std::unordered_set<std::string>& keep_vars = {});
+
+  //! The variables produced by PrePack and used by the instructions.
+  const std::vector<std::string>& prepacked_vars() const { return prepacked_vars_; }
+
+  /**
+   * Pack the parameters \p params, together with the prepacked variables, into one arena in the order of their first
+   * use by the instructions, see Scope::PackTensors, so that they are one allocation read in order instead of many
+   * scattered buffers. The packed parameters should be read only while running: Save keeps the arena as a whole, so
+   * that Load uploads it in one transfer, or maps it from the file on X86, and Clone shares them with the clones.
+   * It should be called before the first Execute, e.g. right after the parameters are loaded or PrePack.
+   */
+  void PackParams(const std::vector<std::string>& params);
+
+  //! The arena of the parameters packed by PackParams, null if not packed.
+  const std::shared_ptr<Buffer>& param_arena() const { return param_arena_; }
+
   void Export(const std::vector<std::string>& persistent_vars, const std::string& filename);
 
+  /**
+   * Export the program compiled for X86 to the directory \p dir as a static library `lib<name>.a` of the lowered
+   * functions and a C header `<name>.h`, to run on the machines without CINN and LLVM. The program file written by
+   * Export, with the buffers and the arguments of the instructions, is embedded in the library or written beside it.
+   * The header defines `<name>_load`, `<name>_run(ctx, inputs..., outputs...)` with the typed pointers to the data of
+   * the inputs and the outputs, and `<name>_free`, which call the minimal runtime `tiny_runtime.h`. The application
+   * links the library with tiny_runtime and cinn_runtime, and starts without compiling anything. The views and the
+   * slices share the buffers of others, which the program file doesn't keep, so the program should be compiled with
+   * with_reshape_view, with_slice_view and with_concat_slice off.
+   */
+  void ExportLibrary(const std::string& dir, const LibraryExportOptions& options);
+
   /**
    * Execute the program -- that is running all the instructions inside it.
+   *
+   * The runs of a positive \p priority are latency-critical: on GPU the kernels run on a stream of a higher CUDA
+   * priority, so the pending blocks of theirs are scheduled before those of the other streams, and on CPU the idle
+   * workers of cinn_backend_parallel_launch serve their parallel kernels first. The runs of lower priorities yield to
+   * them between the instructions, waiting up to FLAGS_cinn_priority_yield_max_us each time, so a long program
+   * doesn't hold the devices while a short request of a higher priority is in progress. The multi-stream execution
+   * and the CUDA graph keep their own streams and only yield.
    */
-  void Execute(const std::map<std::string, cinn_pod_value_t>* name2podargs = nullptr);
+  void Execute(const std::map<std::string, cinn_pod_value_t>* name2podargs = nullptr, int priority = 0);
+
+  /**
+   * Execute the program with the arguments fed by the slots got from GetSlot, the null ones are taken from the scope.
+   * The names of the feeds are resolved once by the caller, so nothing is looked up by name while running. Passing
+   * name2podargs to Execute resolves them once per run in the same way, except for the parallel executor.
+   */
+  void Execute(const std::vector<const cinn_pod_value_t*>& slot2podargs, int priority = 0);
+
+  //! The slot of the variable \p name to feed it by, see Scope::Slot.
+  int GetSlot(const std::string& name) { return scope_->Slot(name); }
 
   void ExecuteTest(int repeat_);
 
@@ -63,16 +202,283 @@ class Program {
    */
   size_t size() const { return instrs_.size(); }
 
+  //! The scope holding the variables of the program.
+  const std::shared_ptr<Scope>& GetScope() const { return scope_; }
+
   const std::vector<std::unique_ptr<Instruction>>& GetPreRunInstructions() { return prerun_instrs_; }
   const std::vector<std::unique_ptr<Instruction>>& GetRunInstructions() { return instrs_; }
 
+  //! Hold the memory arena shared by the planned intermediate variables.
+  void SetMemoryArena(const std::shared_ptr<Buffer>& arena) { memory_arena_ = arena; }
+
+  /**
+   * Record the variables sharing the buffer of another one without any instruction writing them, e.g. the outputs of
+   * the reshapes run as views, so that binding any of them binds the others too, and Save keeps the sharing.
+   */
+  void SetViewVars(const absl::flat_hash_map<std::string, std::string>& view_vars) { view_vars_ = view_vars; }
+
+  /**
+   * Record the variables referring to the slices of the buffers of others, e.g. the inputs of the concats run as
+   * no-ops, so that binding a root binds its slices to the ranges of the bound buffer, and Save and Clone keep them.
+   * The slices themselves can't be bound.
+   */
+  void SetSliceVars(const absl::flat_hash_map<std::string, SliceVar>& slice_vars) { slice_vars_ = slice_vars; }
+
+  /**
+   * Record the variables whose memory is allocated on the first use instead of at compile time, see
+   * CompileOptions::with_lazy_instantiation. Binding a variable drops it together with its views from them.
+   */
+  void SetLazyVars(const std::unordered_set<std::string>& lazy_vars) { lazy_vars_ = lazy_vars; }
+
+  //! Allocate the memory of the lazy variables not allocated yet, which Execute, PreRun, Save and Clone call first.
+  void InstantiateLazyVars() const;
+
+  /**
+   * Hold the compiler owning the JIT-compiled functions called by the instructions. With the tiered compilation, the
+   * functions of the instructions are swapped for the optimized ones once they are compiled.
+   */
+  void SetCompiler(const std::shared_ptr<backends::Compiler>& compiler);
+
+  /**
+   * Save the program to \p path with its compiled code, so that it can be restored by Load without compiling again.
+   * The data of \p persistent_vars, e.g. the parameters, are saved as well, and the other variables only keep their
+   * shapes. If PrePack has been called, the prepacked variables are always saved, so that the loaded program needs
+   * neither the unpacked weights nor the transforms.
+   */
+  void Save(const std::string& path, const std::vector<std::string>& persistent_vars = {});
+
+  /**
+   * Restore a program saved by Save for \p target, all the variables are instantiated in a new scope, and the
+   * persistent ones are filled with the saved data.
+   */
+  static std::unique_ptr<Program> Load(const std::string& path, const Target& target);
+
+  /**
+   * Run the instructions on a pool of \p num_streams CUDA streams, so that the independent instructions may execute
+   * concurrently, the dependencies across streams are kept by CUDA events. It only works for the NVGPU target, and
+   * should be called after the variables are instantiated. Set \p num_streams to 1 to go back to the default stream.
+   * The collectives, if any, run on an extra communication stream.
+   */
+  void SetNumStreams(int num_streams);
+
+  /**
+   * Capture all the instructions into a CUDA Graph and replay it with a single launch in each Execute, to remove the
+   * CPU overhead of launching the kernels one by one. The first Execute runs the instructions directly to warm up the
+   * cuDNN algorithm search and workspace allocation, which can't be captured, and the graph is captured in the next
+   * one. It only works for the NVGPU target with static shapes. When the buffers passed by name2podargs change, the
+   * graph is re-captured and the instantiated graph is updated in place if possible.
+   */
+  void SetUseCudaGraph(bool use_cuda_graph);
+
+  /**
+   * Run the independent instructions concurrently on \p inter_op_threads CPU threads, and let each kernel run on
+   * \p intra_op_threads threads(0 to keep the default). It only works for the X86 target, and should be called after
+   * the variables are instantiated. Set \p inter_op_threads to 1 to go back to the sequential execution.
+   */
+  void SetNumInterOpThreads(int inter_op_threads, int intra_op_threads = 0);
+
+  /**
+   * Bind an external buffer to the variable \p name, the instructions read or write the buffer directly instead of
+   * the tensor in scope, so the framework-owned memory can be fed and fetched without copies. The binding patches the
+   * prepared arguments once, which is much cheaper than passing name2podargs in each Execute. The buffer should match
+   * the shape of the variable and keep alive while it is bound. Its memory pointer can be updated in place, except
+   * with CUDA Graph, which needs BindInput again to re-capture.
+   */
+  void BindInput(const std::string& name, cinn_buffer_t* buffer);
+  void BindOutput(const std::string& name, cinn_buffer_t* buffer) { BindInput(name, buffer); }
+
+  /**
+   * Bind the variable \p name back to its own tensor in scope, undoing BindInput. Its memory released by Trim or never
+   * instantiated is allocated by the next Execute, like the other lazy variables.
+   */
+  void UnbindInput(const std::string& name);
+
+  /**
+   * Record the time of each instruction and each kernel inside it in the following executions, the records can be
+   * got from profiler() and exported as a Chrome trace. The CUDA Graph is not used while profiling.
+   */
+  void EnableProfiling(bool enable = true);
+  Profiler* profiler() { return profiler_.get(); }
+
+  /**
+   * Report the memory held by the program, the buffers shared by variables are counted once. The memory may grow
+   * during execution, e.g. the cuDNN workspace, so enable the tracking to record the peak after each Execute.
+   */
+  MemoryReport GetMemoryReport() const;
+  void EnableMemoryTracking(bool enable = true) { track_memory_ = enable; }
+
+  /**
+   * Release the memory of the intermediate variables, i.e. those written by the instructions, together with the
+   * memory arena, e.g. while the program is idle on a host serving several models. The parameters, the prepacked
+   * variables, the inputs and \p keep_vars, e.g. the outputs still to fetch, are kept with the variables sharing their
+   * memory. The released memory is allocated again by the next Execute like the lazy variables, so the program runs
+   * the same after paying the allocations once more, and the CUDA graph is captured again. It waits for the running
+   * Execute. Call MemoryManager::ReleaseCache after it to return the memory cached by the allocators to the system.
+   * @return The bytes released.
+   */
+  size_t Trim(const std::unordered_set<std::string>& keep_vars = {});
+
+  /**
+   * Let MemoryManager::ReleaseIdle trim the program once no Execute has run for its idle timeout, keeping
+   * \p keep_vars, see Trim. The program running is never trimmed.
+   */
+  void EnableIdleTrim(bool enable = true, const std::unordered_set<std::string>& keep_vars = {});
+
+  //! The microseconds since the last Execute finished, or since the program was created.
+  int64_t idle_us() const;
+
+  /**
+   * Pay all the lazy first-run costs before the traffic comes: wait for the tiered compilation, resolve the library
+   * calls(e.g. the cuDNN algorithm search), reserve their workspaces, allocate the lazy variables, fault in the pages
+   * of the memory arenas on X86, then run the program on the synthetic inputs, which selects between the library calls
+   * and the kernels, loads the CUDA modules and captures the CUDA graph. The runs overwrite the outputs and the
+   * intermediates, so it is meant for the inference programs, and should be called before the bindings, from one
+   * thread. The program is ready once it returns, the clones warm up on their own, which is cheap as the selections
+   * are cached by the process.
+   */
+  WarmupReport Warmup(const WarmupOptions& options = {});
+
+  //! Whether Warmup has finished, e.g. for the load balancer to route the traffic to the program.
+  bool ready() const { return ready_.load(std::memory_order_acquire); }
+
+  /**
+   * Run the program as \p tenant of the process resources, see ResourceManager. Execute and PreRun install the tenant
+   * on the calling thread and the inter-op threads, so that the kernels run within its thread budget, the lazy
+   * variables and the workspaces are charged to its memory quota, and the runs are recorded in its usage. The clones
+   * run as the same tenant. The memory allocated at compile time is charged if the build runs in a TenantScope.
+   */
+  void SetTenant(const std::shared_ptr<Tenant>& tenant) { tenant_ = tenant; }
+  const std::shared_ptr<Tenant>& tenant() const { return tenant_; }
+
+  /**
+   * Execute the program by the compiled function \p name, which calls the kernels of all the instructions in order,
+   * see ExecutionEngine::SetEntryFunction. The arguments of the instructions are prepared and written to its argument
+   * arrays here, so it should be called after the variables are instantiated. The bindings keep working since they
+   * patch the prepared arguments in place, while name2podargs and the profiling fall back to the instructions.
+   */
+  void SetFusedHostFunction(const std::string& name);
+  bool has_fused_host_function() const { return fused_host_fn_ != nullptr; }
+
+  /**
+   * Create a program sharing the compiled functions and the \p shared_vars(e.g. the read-only parameters) with this
+   * one, while all the other variables have their own memory, and the planned intermediate variables have their own
+   * memory arena of the same plan. So the clones can be executed concurrently by different threads with one
+   * compilation. The running options like the streams, the CUDA Graph and the profiling are not copied. The data of
+   * \p copied_vars are copied to their own memory, e.g. the parameters of a replica on another NUMA node. On NVGPU,
+   * the memory of the clone is allocated on the current device, which may differ from the one of this program. The
+   * parameters packed by PackParams are always shared.
+   *
+   * NOTE The CUDA streams of the kernels are held globally, so the clones should run on the default stream, unless
+   * they run on other devices by DeviceReplicas.
+   */
+  std::unique_ptr<Program> Clone(const std::vector<std::string>& shared_vars,
+                                 const std::vector<std::string>& copied_vars = {}) const;
+
+  /**
+   * Dump the instructions in the execution order, each function with its arguments, and the outputs sharing memory
+   * with an input of the same function are marked as in place.
+   */
+  std::string DebugString() const;
+
+  ~Program();
+
  private:
+  // Launch the instructions on the streams they are assigned to, the feeds by name are resolved to the slots first.
+  void LaunchInstructions(const std::map<std::string, cinn_pod_value_t>* name2podargs);
+  void LaunchInstructions(const std::vector<const cinn_pod_value_t*>* slot2podargs);
+  // Release the streams and events of the multi-stream execution and the streams of the priorities.
+  void ResetStreams();
+  // Run the instructions on the stream of \p priority, the default stream for 0.
+  void UsePriorityStream(int priority);
+
+  // Replay the captured graph, capture it first if needed.
+  void ExecuteCudaGraph(const std::map<std::string, cinn_pod_value_t>* name2podargs);
+  void CaptureCudaGraph(const std::map<std::string, cinn_pod_value_t>* name2podargs);
+  // Release the captured graph and its resources.
+  void ResetCudaGraph();
+  // Trim the program, the caller holds run_mutex_.
+  size_t TrimLocked(const std::unordered_set<std::string>& keep_vars);
+
+  // Bind the variable and its views and slices to \p buffer, or back to their own tensors if it is null.
+  void BindVar(const std::string& name, cinn_buffer_t* buffer);
+
   // We need to hold scope to assure tensors alive used in instructions.
   std::shared_ptr<Scope> scope_;
+  // The compiler to assure the compiled functions alive.
+  std::shared_ptr<backends::Compiler> compiler_;
+  // The memory arena referred by the planned tensors in scope.
+  std::shared_ptr<Buffer> memory_arena_;
+  // The arena referred by the packed parameters in scope.
+  std::shared_ptr<Buffer> param_arena_;
   // prerun instructions
   std::vector<std::unique_ptr<Instruction>> prerun_instrs_;
   // only runtime instructions
   std::vector<std::unique_ptr<Instruction>> instrs_;
+  // The variables produced by PrePack.
+  std::vector<std::string> prepacked_vars_;
+  // The feeds of name2podargs by the slots, reused across the runs.
+  std::vector<const cinn_pod_value_t*> slot2podargs_;
+  // Run instrs_ concurrently on CPU if set.
+  std::unique_ptr<ParallelExecutor> parallel_executor_;
+  // The function running all the instructions by one call if set.
+  lower_func_ptr_t fused_host_fn_{};
+  std::unique_ptr<Profiler> profiler_;
+  std::shared_ptr<Tenant> tenant_;
+  // The priority of the current run, which LaunchInstructions yields by.
+  int run_priority_{0};
+  bool track_memory_{false};
+  size_t peak_memory_bytes_{};
+  std::atomic<bool> ready_{false};
+  // The instructions using each variable, built on the first binding.
+  absl::flat_hash_map<std::string, std::vector<Instruction*>> var_instrs_;
+  // Mapping each view to the variable whose buffer it shares.
+  absl::flat_hash_map<std::string, std::string> view_vars_;
+  // Mapping each slice to the range of the buffer it refers to.
+  absl::flat_hash_map<std::string, SliceVar> slice_vars_;
+  // The buffers bound to the slices when their roots are bound, whose addresses keep valid across the bindings.
+  absl::flat_hash_map<std::string, std::unique_ptr<cinn_buffer_t>> slice_buffers_;
+  // The variables to allocate on the first use, cleared once they are allocated.
+  mutable std::unordered_set<std::string> lazy_vars_;
+  // The planned variables released by Trim with their offsets in the memory arena, the size of the arena, and the
+  // slices of the roots released, which are allocated again with the lazy variables.
+  mutable std::vector<std::pair<std::string, uint32_t>> trimmed_arena_vars_;
+  mutable uint32_t trimmed_arena_size_{};
+  mutable std::vector<std::string> trimmed_slices_;
+  mutable bool trimmed_{false};
+  int num_trims_{};
+  size_t trimmed_bytes_{};
+  // The variables bound by BindInput, which don't need their own memory after Trim.
+  std::unordered_set<std::string> bound_vars_;
+  // Held by Execute and Trim, so the program is never trimmed while running.
+  std::mutex run_mutex_;
+  // The time the last Execute finished, in the microseconds of the steady clock.
+  std::atomic<int64_t> last_run_us_{};
+  // The id of the releaser added by EnableIdleTrim, -1 if not enabled.
+  int idle_releaser_id_{-1};
+#ifdef CINN_WITH_CUDA
+  // The stream assignment of instrs_ in the multi-stream execution.
+  StreamAssignment stream_assignment_;
+  std::vector<cudaStream_t> streams_;
+  // The event recorded after each instruction, null if no instruction on the other streams waits for it.
+  std::vector<cudaEvent_t> events_;
+  // The streams created for the priorities of the runs, and the one the instructions are on, null for the default.
+  std::map<int, cudaStream_t> priority_streams_;
+  cudaStream_t run_stream_{};
+
+  // The stream to capture the graph on when the instructions run on the default stream.
+  cudaStream_t graph_stream_{};
+  // Fork the multiple streams from the capturing stream and join them back.
+  std::vector<cudaEvent_t> graph_fork_join_events_;
+  cudaGraphExec_t graph_exec_{};
+  // The buffers and their memory passed by name2podargs when capturing the graph.
+  std::vector<void*> graph_args_signature_;
+  // Whether the bound buffers changed after the graph is captured.
+  bool graph_args_changed_{false};
+  // The generation of the workspaces the graph is warmed up with, see LibraryHandles::WorkSpaceGeneration.
+  uint64_t graph_workspace_generation_{};
+#endif
+  bool use_cuda_graph_{false};
+  bool graph_warmed_up_{false};
 };
 
 /**
@@ -90,6 +496,55 @@ class GraphCompiler final {
   struct CompileOptions {
     std::string attached_code       = "";
     bool with_instantiate_variables = false;
+    // Whether to let the intermediate variables with disjoint lifetime share one memory arena, only works when
+    // with_instantiate_variables is true.
+    bool with_memory_plan = false;
+    // The variables to fetch after execution, they won't be planned to share memory with others.
+    std::unordered_set<std::string> fetch_var_ids;
+    // The number of CUDA streams to run the independent instructions concurrently, only works for NVGPU when
+    // with_instantiate_variables is true.
+    int num_streams = 1;
+    // Whether to replay the program by a CUDA Graph, only works for NVGPU when with_instantiate_variables is true.
+    bool with_cuda_graph = false;
+    // The number of CPU threads to run the independent instructions concurrently and the number of threads each
+    // kernel runs on(0 for the default), only works for X86 when with_instantiate_variables is true.
+    int inter_op_threads = 1;
+    int intra_op_threads = 0;
+    // The number of threads to lower the fused groups and compile the generated code concurrently.
+    int num_compile_threads = 1;
+    // Whether to lower the groups with the same ops, attributes, shapes and data types only once, and let their
+    // instructions call the same compiled function with different arguments.
+    bool with_kernel_dedup = true;
+    // Whether to let the elementwise ops write their output in place of an input which is not used later, only works
+    // when with_instantiate_variables is true. The variables to fetch should be in fetch_var_ids, or they may be
+    // overwritten.
+    bool with_inplace = false;
+    // Whether to generate one host function calling the kernels of all the instructions directly, so that Execute
+    // runs the whole program by a single call and the kernels can be inlined across the groups. It only works for X86
+    // when with_instantiate_variables is true and inter_op_threads is 1, and the module is compiled on one thread.
+    bool with_fused_host_function = false;
+    // Whether to run the reshapes not fused with other ops as views, that is, their outputs share the buffers of their
+    // inputs and no instructions are built for them. It only works when with_instantiate_variables is true.
+    bool with_reshape_view = true;
+    // Whether to run the slices not fused with other ops as views too, if their outputs are contiguous ranges of their
+    // inputs, e.g. the slices of the leading dims. Such an output refers to a range of the buffer of the input, and
+    // is not sliced if nothing in the program reads it or it is to fetch, since a slice can't be bound.
+    bool with_slice_view = true;
+    // Whether to let the producers of the inputs of the concats not fused with other ops write them straight into the
+    // slices of the outputs, so that no instructions are built for the concats. It only works when
+    // with_instantiate_variables is true, and for the concats whose inputs are contiguous in their outputs.
+    bool with_concat_slice = true;
+    // Whether to build the cuDNN and cuBLAS calls of the instructions at compile time, so that the algorithms of the
+    // convolutions are searched here instead of in the first run. It only works for NVGPU with cuDNN.
+    bool prepare_library_calls = false;
+    // Whether to defer the allocation of the variables not planned by the memory planner to the first Execute, so
+    // that the variables bound to the external buffers before are never allocated. The roots of the slices and of the
+    // outputs written in place are still allocated at compile time. It only works when with_instantiate_variables is
+    // true.
+    bool with_lazy_instantiation = false;
+    // The trade-off between the accuracy and the speed of the float math, which the lowering, the LLVM and NVRTC
+    // compilation and the cuDNN and cuBLAS calls of the instructions all follow, see common::PrecisionMode.
+    common::PrecisionMode precision_mode = common::DefaultPrecisionMode();
   };
 
   // Compile with a packing option and result, to be extended easily.
@@ -100,10 +555,19 @@ class GraphCompiler final {
 
   std::string GenSourceCode();
 
+  /**
+   * Lower the fused groups of the graph, or each op if OpFusion is not applied, to the functions Build compiles, but
+   * generate no code, e.g. to extract the features of a schedule before measuring it.
+   */
+  std::vector<ir::LoweredFunc> Lower();
+
   void PrintFunc();
 
   const std::shared_ptr<Scope>& GetScope() const { return scope_; }
 
+  //! The alignment of the slices in bytes, so that the vectorized accesses of their producers keep aligned.
+  static constexpr uint32_t kSliceAlignment = 64;
+
  private:
   std::vector<ir::LoweredFunc> GetOpFunc(const std::vector<Node*>& nodes);
 
@@ -111,6 +575,15 @@ class GraphCompiler final {
 
   std::string GenOpFuncName(const Node* node) const { return "fn_" + node->id(); }
 
+  std::string GenGroupFuncName(const std::vector<Node*>& group) const;
+
+  /**
+   * The signature of the kernel lowered from a group, which consists of the ops and their attributes, the shapes and
+   * data types of the inputs and outputs, and how the nodes are connected inside the group. The groups of the same
+   * signature are lowered to the same functions, except the names.
+   */
+  std::string GenGroupSignature(const std::vector<Node*>& group) const;
+
   // TODO(haozech) add implementation
   std::vector<std::string> OpGetInputNames(const Node* node) const;
   // TODO(haozech) add implementation
@@ -118,7 +591,54 @@ class GraphCompiler final {
 
   std::vector<std::unique_ptr<Instruction>> BuildInstructions();
 
+  /**
+   * Find the outputs that can be written in place of an input of the same instruction, that is, the instruction has
+   * only one function and one output, all its ops are elementwise or broadcast, and the input has the same shape and
+   * type as the output, is produced by an earlier instruction, not reserved and not read by any later instruction.
+   * The variables viewed by a reshape are not overwritten either, as the views may be read later, and the slices of
+   * the concats neither write in place nor are overwritten, as they live in the memory of the concats.
+   * @param instrs The instructions built from the groups of the graph, in the same order.
+   * @param view_vars The views planned by PlanViews.
+   * @param slice_vars The slices planned by PlanSlices.
+   * @return The map from each such output to the variable whose memory it reuses.
+   */
+  absl::flat_hash_map<std::string, std::string> PlanInplace(
+      const std::vector<std::unique_ptr<Instruction>>& instrs,
+      const std::unordered_set<std::string>& reserved_vars,
+      const absl::flat_hash_map<std::string, std::string>& view_vars,
+      const absl::flat_hash_map<std::string, SliceVar>& slice_vars);
+
+  /**
+   * Find the groups of a single reshape or contiguous slice which are not pre-run, and remove them from the groups of
+   * the graph, so no functions or instructions are built for them, since they don't move the data. The output of each
+   * such reshape is a view sharing the buffer of its input, or a slice of the same range if the input is a slice, and
+   * the output of each such slice refers to the range of the buffer, if its offset is aligned to kSliceAlignment.
+   * @param options The options deciding which ops run as views, and the variables to fetch, which are not sliced.
+   * @param slice_vars The map from each slice to the range of the buffer it refers to, whose root is not a view.
+   * @return The map from each view to the variable whose buffer it shares, which is not a view or a slice itself.
+   */
+  absl::flat_hash_map<std::string, std::string> PlanViews(const CompileOptions& options,
+                                                          absl::flat_hash_map<std::string, SliceVar>* slice_vars);
+
+  /**
+   * Find the groups of a single concat which are not pre-run, and whose inputs are contiguous in the output, that is,
+   * all the dims before the axis are 1, and remove them from the groups of the graph. Each input of such a concat is
+   * then a slice of its output, which its producer writes into directly. An input qualifies only if it is produced by
+   * a group of the graph, or is the output of another such concat, it is neither reserved nor viewed, it is not a
+   * slice of another concat yet, and its offset keeps the buffer aligned to kSliceAlignment.
+   * @param reserved_vars The variables to fetch, which keep their own memory.
+   * @param view_vars The views planned by PlanViews.
+   * @param slice_views The slices planned by PlanViews, which are neither the inputs nor the outputs of the concats.
+   * @return The map from each slice to the range of the buffer it refers to, whose root is not a slice itself.
+   */
+  absl::flat_hash_map<std::string, SliceVar> PlanSlices(const std::unordered_set<std::string>& reserved_vars,
+                                                        const absl::flat_hash_map<std::string, std::string>& view_vars,
+                                                        const absl::flat_hash_map<std::string, SliceVar>& slice_views);
+
  private:
+  // The functions called by the instructions except the pre-run ones in order, the same as BuildInstructions sets.
+  std::vector<std::string> GenRunFuncNames() const;
+
   void ProcessFunction(const std::vector<ir::LoweredFunc>& lowered_func);
   Target target_;
   std::shared_ptr<Graph> graph_;
@@ -127,8 +647,18 @@ class GraphCompiler final {
   std::map<std::string, std::vector<std::string>> function2input_args_;
   // mapping a function's name to its output artuments' names
   std::map<std::string, std::vector<std::string>> function2output_args_;
+  // mapping a function's name to its FLOPs and bytes counted from the IR
+  std::map<std::string, KernelCost> function2cost_;
+  // mapping a function's name to the argument and the dim each of its symbolic dims is filled from
+  std::map<std::string, std::vector<std::pair<std::string, int>>> function2dim_args_;
+  // mapping the name of a CUDA kernel's host function to the grid dims and the block dims of the kernel
+  std::map<std::string, std::pair<std::array<int, 3>, std::array<int, 3>>> function2launch_dims_;
 
-  std::unique_ptr<backends::Compiler> compiler_;
+  std::shared_ptr<backends::Compiler> compiler_;
+  // The precision mode of the last Build, which the instructions built follow.
+  common::PrecisionMode precision_mode_{common::DefaultPrecisionMode()};
+  // Mapping the name of a deduplicated function to the one it reuses.
+  absl::flat_hash_map<std::string, std::string> dedup_func_names_;
 
   ir::Module::Builder m_builder_;
 
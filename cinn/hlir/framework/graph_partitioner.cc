@@ -0,0 +1,314 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/graph_partitioner.h"
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#ifdef CINN_WITH_CUDA
+#include <cuda_runtime.h>
+
+#include "cinn/backends/cuda_util.h"
+#endif
+#include "cinn/utils/string.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+
+std::vector<std::string> GetInputNames(const Node* node) {
+  std::vector<std::string> res;
+  for (auto& link : node->inlinks_in_order()) res.push_back(link->source()->as<NodeData>()->id());
+  return res;
+}
+
+std::vector<std::string> GetOutputNames(const Node* node) {
+  std::vector<std::string> res;
+  for (auto& link : node->outlinks_in_order()) res.push_back(link->sink()->as<NodeData>()->id());
+  return res;
+}
+
+//! The variables \p groups read but don't produce, in the order they are first read, and the ones they produce.
+void CollectVars(const std::vector<std::vector<Node*>>& groups,
+                 std::vector<std::string>* inputs,
+                 std::vector<std::string>* outputs) {
+  absl::flat_hash_set<std::string> produced, read;
+  for (auto& group : groups) {
+    for (auto* node : group) {
+      for (auto& name : GetInputNames(node)) {
+        if (!produced.count(name) && read.insert(name).second) inputs->push_back(name);
+      }
+      for (auto& name : GetOutputNames(node)) {
+        if (produced.insert(name).second) outputs->push_back(name);
+      }
+    }
+  }
+}
+
+//! The scope of the variables in \p vars only, so a partition instantiates the ones it accesses.
+std::shared_ptr<Scope> BuildPartialScope(const Target& target,
+                                         const std::shared_ptr<Graph>& graph,
+                                         const absl::flat_hash_set<std::string>& vars) {
+  auto scope = BuildScope(target, graph);
+  std::vector<std::string> erased;
+  for (auto& name : scope->var_names()) {
+    if (!vars.count(name)) erased.emplace_back(name.data(), name.size());
+  }
+  for (auto& name : erased) scope->EraseVar(name);
+  return scope;
+}
+
+}  // namespace
+
+bool IsOpSupported(const Operator* op, const Target& target) {
+  static const std::vector<Target::Arch> kAllArchs;
+  auto& archs = Operator::GetAttrs<std::vector<Target::Arch>>("CINNSupportedArchs").Get(op, kAllArchs);
+  return archs.empty() || std::find(archs.begin(), archs.end(), target.arch) != archs.end();
+}
+
+std::vector<GraphPartition> PartitionGraph(Graph* graph, const PartitionOptions& options) {
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  auto& dtype_dict = graph->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  auto var_bytes   = [&](const std::string& name) {
+    auto it = shape_dict.find(name);
+    if (it == shape_dict.end()) return 0.;
+    auto& dtype = dtype_dict.at(name);
+    // the same element size as the tensors built by BuildScope
+    bool narrow = dtype == Float(16) || dtype == BFloat16() || dtype == Int(8);
+    double res  = narrow ? dtype.bits() / 8 : sizeof(float);
+    for (int dim : it->second) res *= dim;
+    return res;
+  };
+
+  auto groups = graph->groups;
+  if (groups.empty()) {
+    for (auto* graph_node : std::get<0>(graph->topological_order())) {
+      auto* node = graph_node->safe_as<Node>();
+      if (node) groups.push_back({node});
+    }
+  }
+
+  // 0 for the host and 1 for the device, a single side if the device is a CPU too.
+  const int num_sides    = options.device_target.is_cpu() ? 1 : 2;
+  const Target targets[] = {num_sides == 1 ? options.device_target : common::DefaultHostTarget(),
+                            options.device_target};
+  // The sides holding a copy of each variable, the inputs of the graph are on the host.
+  absl::flat_hash_map<std::string, std::array<bool, 2>> placed;
+  auto is_placed = [&](const std::string& name, int side) {
+    auto it = placed.find(name);
+    return it == placed.end() ? side == 0 : it->second[side];
+  };
+  auto transfer_cost = [&](const std::string& name) {
+    return options.transfer_latency + var_bytes(name) / options.transfer_bandwidth;
+  };
+
+  std::vector<GraphPartition> partitions;
+  for (auto& group : groups) {
+    std::vector<std::string> inputs, outputs;
+    CollectVars({group}, &inputs, &outputs);
+    double bytes = 0.;
+    for (auto& name : inputs) bytes += var_bytes(name);
+    for (auto& name : outputs) bytes += var_bytes(name);
+
+    int best_side    = -1;
+    double best_cost = std::numeric_limits<double>::infinity();
+    for (int side = 0; side < num_sides; side++) {
+      bool supported = std::all_of(
+          group.begin(), group.end(), [&](Node* node) { return IsOpSupported(node->op(), targets[side]); });
+      if (!supported) continue;
+      double cost =
+          side == 0 ? bytes / options.host_bandwidth : options.launch_latency + bytes / options.device_bandwidth;
+      for (auto& name : inputs) {
+        if (!is_placed(name, side) && !options.param_vars.count(name)) cost += transfer_cost(name);
+      }
+      if (side == 1) {
+        for (auto& name : outputs) {
+          if (options.fetch_var_ids.count(name)) cost += transfer_cost(name);
+        }
+      }
+      if (cost < best_cost) {
+        best_side = side;
+        best_cost = cost;
+      }
+    }
+    std::vector<std::string> op_names;
+    for (auto* node : group) op_names.push_back(node->op()->name);
+    CHECK_GE(best_side, 0) << "The group of [" << utils::Join(op_names, ", ")
+                           << "] is supported on neither the host nor the device";
+    VLOG(3) << "Assign the group of [" << utils::Join(op_names, ", ") << "] to " << targets[best_side]
+            << ", the estimated cost is " << best_cost << "s";
+
+    for (auto& name : inputs) {
+      if (!placed.count(name)) placed[name] = {true, false};
+      placed[name][best_side] = true;
+    }
+    for (auto& name : outputs) {
+      placed[name]            = {false, false};
+      placed[name][best_side] = true;
+    }
+    if (partitions.empty() || !(partitions.back().target == targets[best_side])) {
+      partitions.emplace_back();
+      partitions.back().target = targets[best_side];
+    }
+    partitions.back().groups.push_back(group);
+    partitions.back().cost += best_cost;
+  }
+
+  // The outputs of a partition are the variables it produces which the later ones read or are to fetch.
+  absl::flat_hash_set<std::string> crossing = {options.fetch_var_ids.begin(), options.fetch_var_ids.end()};
+  for (auto& partition : partitions) {
+    std::vector<std::string> outputs;
+    CollectVars(partition.groups, &partition.inputs, &outputs);
+    crossing.insert(partition.inputs.begin(), partition.inputs.end());
+  }
+  for (auto& partition : partitions) {
+    std::vector<std::string> inputs, outputs;
+    CollectVars(partition.groups, &inputs, &outputs);
+    for (auto& name : outputs) {
+      if (crossing.count(name)) partition.outputs.push_back(name);
+    }
+  }
+  VLOG(3) << "Partition the graph into " << partitions.size() << " partitions";
+  return partitions;
+}
+
+void HeteroProgram::Copy(const Transfer& transfer) {
+  size_t bytes = transfer.src->shape().numel() * transfer.src->element_bytes();
+  auto* dst    = transfer.dst->mutable_data(transfer.dst_target);
+  auto* src    = transfer.src->buffer()->memory;
+  CHECK(src) << "The variable to copy is not allocated";
+#ifdef CINN_WITH_CUDA
+  auto kind = transfer.dst_target.arch == Target::Arch::NVGPU ? cudaMemcpyHostToDevice : cudaMemcpyDeviceToHost;
+  // on the default stream which the kernels are launched on, so they are ordered
+  CUDA_CALL(cudaMemcpyAsync(dst, src, bytes, kind, nullptr));
+#else
+  LOG(FATAL) << "Copying the variables from " << transfer.src_target << " to " << transfer.dst_target
+             << " is only supported with CUDA";
+#endif
+}
+
+void HeteroProgram::Synchronize() {
+#ifdef CINN_WITH_CUDA
+  CUDA_CALL(cudaStreamSynchronize(nullptr));
+#endif
+}
+
+void HeteroProgram::Execute() {
+  bool has_transfers = false;
+  for (auto& stage : stages_) {
+    bool to_host = false;
+    for (auto& transfer : stage.transfers_in) {
+      if (transfer.once && params_copied_) continue;
+      Copy(transfer);
+      to_host |= transfer.dst_target.is_cpu();
+    }
+    if (to_host) Synchronize();
+    stage.program->Execute();
+    for (auto& transfer : stage.transfers_out) Copy(transfer);
+    has_transfers |= !stage.transfers_in.empty() || !stage.transfers_out.empty();
+  }
+  // the fetched variables copied to the host
+  if (has_transfers) Synchronize();
+  params_copied_ = true;
+}
+
+std::unique_ptr<HeteroProgram> HeteroGraphCompiler::Build(const GraphCompiler::CompileOptions& options) {
+  const Target& host = common::DefaultHostTarget();
+  std::unique_ptr<HeteroProgram> program(new HeteroProgram);
+  program->partitions_ = PartitionGraph(graph_.get(), options_);
+  auto& partitions     = program->partitions_;
+
+  // The partition producing each variable, the others are the inputs of the graph.
+  absl::flat_hash_map<std::string, int> producers;
+  for (int i = 0; i < partitions.size(); i++) {
+    std::vector<std::string> inputs, outputs;
+    CollectVars(partitions[i].groups, &inputs, &outputs);
+    for (auto& name : outputs) producers[name] = i;
+  }
+  absl::flat_hash_set<std::string> host_vars = {options_.fetch_var_ids.begin(), options_.fetch_var_ids.end()};
+  for (auto& partition : partitions) {
+    for (auto& name : partition.inputs) {
+      if (!producers.count(name)) host_vars.insert(name);
+    }
+  }
+  program->scope_ = BuildPartialScope(host, graph_, host_vars);
+  for (auto& name : host_vars) {
+    if (!producers.count(name)) program->scope_->GetTensor(name)->mutable_data(host);
+  }
+
+  auto groups = graph_->groups;
+  for (int i = 0; i < partitions.size(); i++) {
+    auto& partition = partitions[i];
+    absl::flat_hash_set<std::string> vars;
+    {
+      std::vector<std::string> inputs, outputs;
+      CollectVars(partition.groups, &inputs, &outputs);
+      vars.insert(inputs.begin(), inputs.end());
+      vars.insert(outputs.begin(), outputs.end());
+    }
+    auto scope = BuildPartialScope(partition.target, graph_, vars);
+
+    HeteroProgram::Stage stage;
+    for (auto& name : partition.inputs) {
+      auto it         = producers.find(name);
+      bool from_host  = it == producers.end();
+      auto src        = from_host ? program->scope_->GetTensor(name)
+                                  : program->stages_[it->second].program->GetScope()->GetTensor(name);
+      auto src_target = from_host ? host : partitions[it->second].target;
+      auto dst        = scope->GetTensor(name);
+      if (src_target.is_cpu() == partition.target.is_cpu()) {
+        // shared before the build, so the instructions refer to the buffer of the source
+        dst->ShareBufferWith(*src);
+      } else {
+        bool once = from_host && options_.param_vars.count(name);
+        stage.transfers_in.push_back({src, src_target, dst, partition.target, once});
+      }
+    }
+
+    auto partition_options                       = options;
+    partition_options.with_instantiate_variables = true;
+    partition_options.fetch_var_ids.insert(partition.inputs.begin(), partition.inputs.end());
+    partition_options.fetch_var_ids.insert(partition.outputs.begin(), partition.outputs.end());
+    graph_->groups = partition.groups;
+    GraphCompiler compiler(partition.target, scope, graph_);
+    stage.program = compiler.Build(partition_options).runtime_program;
+    VLOG(3) << "Compile partition " << i << " of " << partition.groups.size() << " groups for " << partition.target;
+
+    for (auto& name : partition.outputs) {
+      if (!options_.fetch_var_ids.count(name)) continue;
+      auto src = scope->GetTensor(name);
+      auto dst = program->scope_->GetTensor(name);
+      if (partition.target.is_cpu()) {
+        // shared after the build, which may let the variable share the buffer of another
+        dst->ShareBufferWith(*src);
+      } else {
+        stage.transfers_out.push_back({src, partition.target, dst, host});
+      }
+    }
+    program->stages_.push_back(std::move(stage));
+  }
+  graph_->groups = std::move(groups);
+  return program;
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
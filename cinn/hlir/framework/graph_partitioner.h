@@ -0,0 +1,158 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cinn/common/macros.h"
+#include "cinn/common/target.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/scope.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * Whether \p op can be compiled for \p target. The ops whose strategies only work on some archs register them by the
+ * attribute CINNSupportedArchs of std::vector<Target::Arch>, and the others are supported on all the archs.
+ */
+bool IsOpSupported(const Operator* op, const Target& target);
+
+struct PartitionOptions {
+  // The device to offload the groups to, the groups it doesn't support or runs slower fall back to the host.
+  Target device_target = common::DefaultNVGPUTarget();
+  // The bandwidths in bytes per second and the latencies in seconds the cost model estimates a group by, that is,
+  // the bytes it reads and writes over the memory bandwidth, plus the launch latency on the device and the copies of
+  // the inputs from the other side.
+  double host_bandwidth     = 20e9;
+  double device_bandwidth   = 500e9;
+  double transfer_bandwidth = 25e9;
+  double launch_latency     = 5e-6;
+  double transfer_latency   = 10e-6;
+  // The variables to fetch after execution, they are copied back to the host.
+  std::unordered_set<std::string> fetch_var_ids;
+  // The inputs not changed across the runs, e.g. the weights, which are copied to the device on the first run only
+  // and are not counted in the costs.
+  std::unordered_set<std::string> param_vars;
+};
+
+/**
+ * A run of the groups in the topological order compiled for the same target.
+ */
+struct GraphPartition {
+  Target target;
+  std::vector<std::vector<Node*>> groups;
+  //! The variables the groups read but don't produce, in the order they are first read.
+  std::vector<std::string> inputs;
+  //! The variables the groups produce which the later partitions read or are to fetch.
+  std::vector<std::string> outputs;
+  //! The estimated seconds to run the groups, including the copies of the inputs from the other side.
+  double cost{0.};
+};
+
+/**
+ * Assign each fused group of \p graph, or each op if OpFusion is not applied, to the device or the host greedily in
+ * the topological order, by the op support and the cost model in \p options, and merge the adjacent groups of the same
+ * target into the partitions. The inputs of the graph are assumed on the host.
+ */
+std::vector<GraphPartition> PartitionGraph(Graph* graph, const PartitionOptions& options);
+
+/**
+ * The runtime program of a partitioned graph, which runs the program of each partition in order and copies the
+ * variables crossing the host and the device between them. The inputs of the graph are fed and the fetched variables
+ * are read in GetScope() on the host.
+ */
+class HeteroProgram {
+ public:
+  //! The scope of the inputs and the fetched variables on the host.
+  const std::shared_ptr<Scope>& GetScope() const { return scope_; }
+
+  int num_partitions() const { return partitions_.size(); }
+  const GraphPartition& partition(int i) const { return partitions_.at(i); }
+  Program* program(int i) { return stages_.at(i).program.get(); }
+
+  /**
+   * Copy the inputs to each partition from the other side asynchronously before running it, and wait for the copies
+   * to the host before a host partition and at the end.
+   */
+  void Execute();
+
+ private:
+  friend class HeteroGraphCompiler;
+
+  struct Transfer {
+    Tensor src;
+    Target src_target;
+    Tensor dst;
+    Target dst_target;
+    // Whether it copies a parameter, which is done on the first run only.
+    bool once{false};
+  };
+
+  struct Stage {
+    std::unique_ptr<Program> program;
+    std::vector<Transfer> transfers_in;
+    // The copies of the fetched variables to the host.
+    std::vector<Transfer> transfers_out;
+  };
+
+  HeteroProgram() = default;
+
+  void Copy(const Transfer& transfer);
+
+  void Synchronize();
+
+  std::shared_ptr<Scope> scope_;
+  std::vector<GraphPartition> partitions_;
+  std::vector<Stage> stages_;
+  bool params_copied_{false};
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(HeteroProgram);
+};
+
+/**
+ * HeteroGraphCompiler partitions a graph by PartitionGraph and compiles each partition by a GraphCompiler of its
+ * target, so its own backends::Compiler, to a HeteroProgram. Each partition has its own scope holding the variables it
+ * accesses, the variables passed between the partitions of the same target share the buffers, and the others are
+ * copied.
+ */
+class HeteroGraphCompiler final {
+ public:
+  HeteroGraphCompiler(const std::shared_ptr<Graph>& graph, const PartitionOptions& options)
+      : graph_(graph), options_(options) {}
+
+  /**
+   * Compile the partitions with \p options, the variables are always instantiated. The variables crossing the
+   * partitions are added to the fetch_var_ids of each partition, so they are neither planned to share the memory with
+   * others nor written in place.
+   */
+  std::unique_ptr<HeteroProgram> Build(const GraphCompiler::CompileOptions& options = GraphCompiler::CompileOptions());
+
+ private:
+  std::shared_ptr<Graph> graph_;
+  PartitionOptions options_;
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(HeteroGraphCompiler);
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
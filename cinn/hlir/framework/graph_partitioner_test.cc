@@ -0,0 +1,131 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/graph_partitioner.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+// e = (a + b) + ((a + b) + b)
+std::shared_ptr<Graph> BuildGraph(int rows, int cols, std::string* out) {
+  frontend::Program prog;
+  frontend::Variable a("A");
+  frontend::Variable b("B");
+  a->shape = {rows, cols};
+  b->shape = {rows, cols};
+  a->type  = Float(32);
+  b->type  = Float(32);
+  auto c   = prog.add(a, b);
+  auto d   = prog.add(c, b);
+  auto e   = prog.add(c, d);
+  *out     = e->id;
+  auto g   = std::make_shared<Graph>(prog, common::DefaultHostTarget());
+  ApplyPass(g.get(), "InferShape");
+  return g;
+}
+
+void FeedAndCheck(HeteroProgram* program, const std::string& out, int numel) {
+  auto scope = program->GetScope();
+  auto* a    = scope->GetTensor("A")->mutable_data<float>(common::DefaultHostTarget());
+  auto* b    = scope->GetTensor("B")->mutable_data<float>(common::DefaultHostTarget());
+  for (int i = 0; i < numel; i++) {
+    a[i] = i % 7;
+    b[i] = i % 5;
+  }
+  program->Execute();
+  auto* e = scope->GetTensor(out)->data<float>();
+  ASSERT_NE(e, nullptr);
+  for (int i = 0; i < numel; i++) ASSERT_NEAR(e[i], 2 * a[i] + 3 * b[i], 1e-5);
+}
+}  // namespace
+
+TEST(GraphPartitioner, op_support) {
+  ASSERT_FALSE(IsOpSupported(Operator::Get("conv2d_NCHWc"), common::DefaultNVGPUTarget()));
+  ASSERT_TRUE(IsOpSupported(Operator::Get("conv2d_NCHWc"), common::DefaultHostTarget()));
+  ASSERT_TRUE(IsOpSupported(Operator::Get("elementwise_add"), common::DefaultNVGPUTarget()));
+  ASSERT_TRUE(IsOpSupported(Operator::Get("elementwise_add"), common::DefaultHostTarget()));
+}
+
+TEST(GraphPartitioner, cost_model) {
+  std::string out;
+  PartitionOptions options;
+
+  // the launch latency dominates the small ops, which stay on the host
+  auto small            = BuildGraph(2, 2, &out);
+  options.fetch_var_ids = {out};
+  auto partitions       = PartitionGraph(small.get(), options);
+  ASSERT_EQ(partitions.size(), 1UL);
+  ASSERT_TRUE(partitions[0].target.is_cpu());
+  ASSERT_EQ(partitions[0].groups.size(), 3UL);
+
+  // the large ones are offloaded, reading the inputs and writing the output across the host and the device
+  auto large            = BuildGraph(1024, 1024, &out);
+  options.fetch_var_ids = {out};
+  partitions            = PartitionGraph(large.get(), options);
+  ASSERT_EQ(partitions.size(), 1UL);
+  ASSERT_EQ(partitions[0].target.arch, Target::Arch::NVGPU);
+  ASSERT_EQ(partitions[0].inputs, (std::vector<std::string>{"A", "B"}));
+  ASSERT_EQ(partitions[0].outputs, std::vector<std::string>{out});
+
+  // without the device, all run on the host
+  options.device_target = common::DefaultHostTarget();
+  partitions            = PartitionGraph(large.get(), options);
+  ASSERT_EQ(partitions.size(), 1UL);
+  ASSERT_TRUE(partitions[0].target.is_cpu());
+}
+
+TEST(HeteroGraphCompiler, host_only) {
+  std::string out;
+  auto graph = BuildGraph(100, 32, &out);
+  PartitionOptions options;
+  options.device_target = common::DefaultHostTarget();
+  options.fetch_var_ids = {out};
+  HeteroGraphCompiler compiler(graph, options);
+  auto program = compiler.Build();
+  ASSERT_EQ(program->num_partitions(), 1);
+  FeedAndCheck(program.get(), out, 100 * 32);
+}
+
+#ifdef CINN_WITH_CUDA
+TEST(HeteroGraphCompiler, device) {
+  std::string out;
+  auto graph = BuildGraph(1024, 1024, &out);
+  PartitionOptions options;
+  options.fetch_var_ids = {out};
+  HeteroGraphCompiler compiler(graph, options);
+  auto program = compiler.Build();
+  ASSERT_EQ(program->num_partitions(), 1);
+  ASSERT_EQ(program->partition(0).target.arch, Target::Arch::NVGPU);
+  FeedAndCheck(program.get(), out, 1024 * 1024);
+  // run again with the inputs copied again
+  FeedAndCheck(program.get(), out, 1024 * 1024);
+}
+#endif
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
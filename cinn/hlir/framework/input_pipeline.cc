@@ -0,0 +1,108 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/input_pipeline.h"
+
+#ifdef CINN_WITH_CUDA
+#include <cstring>
+
+#include "cinn/backends/cuda_util.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+InputPipeline::InputPipeline(Program* program, const std::vector<std::string>& feed_vars, int num_sets)
+    : program_(program), feed_vars_(feed_vars) {
+  CHECK(program_);
+  CHECK_GE(num_sets, 2) << "The pipeline needs at least 2 buffer sets to overlap the uploads";
+  CHECK(!feed_vars_.empty());
+  auto target = common::DefaultNVGPUTarget();
+  sets_.resize(num_sets);
+  for (int k = 0; k < num_sets; k++) {
+    auto& set = sets_[k];
+    for (auto& name : feed_vars_) {
+      auto origin = program_->GetScope()->GetTensor(name);
+      Tensor tensor;
+      tensor->set_type(origin->type());
+      tensor->Resize(origin->shape());
+      tensor->mutable_data(target);
+      set.device.push_back(tensor);
+      set.staging.emplace_back(new Buffer);
+      set.staging.back()->ResizePinned(tensor->num_bytes());
+    }
+    CUDA_CALL(cudaEventCreateWithFlags(&set.uploaded, cudaEventDisableTiming));
+    free_sets_.push_back(k);
+  }
+  CUDA_CALL(cudaStreamCreateWithFlags(&copy_stream_, cudaStreamNonBlocking));
+}
+
+void InputPipeline::Upload(const std::map<std::string, const void*>& inputs) {
+  CHECK_EQ(inputs.size(), feed_vars_.size()) << "All the feed variables should be uploaded together";
+  int k = 0;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&] { return !free_sets_.empty(); });
+    k = free_sets_.front();
+    free_sets_.pop_front();
+  }
+  auto& set = sets_[k];
+  for (int i = 0; i < feed_vars_.size(); i++) {
+    auto it = inputs.find(feed_vars_[i]);
+    CHECK(it != inputs.end()) << "The feed variable [" << feed_vars_[i] << "] is not uploaded";
+    size_t bytes  = set.device[i]->num_bytes();
+    auto* staging = set.staging[i]->data()->memory;
+    // The set is free after the execution on it, which waited for its last upload from the staging buffers.
+    std::memcpy(staging, it->second, bytes);
+    CUDA_CALL(
+        cudaMemcpyAsync(set.device[i]->buffer()->memory, staging, bytes, cudaMemcpyHostToDevice, copy_stream_));
+  }
+  CUDA_CALL(cudaEventRecord(set.uploaded, copy_stream_));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_sets_.push_back(k);
+  }
+  cond_.notify_all();
+}
+
+void InputPipeline::Execute() {
+  int k = 0;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&] { return !ready_sets_.empty(); });
+    k = ready_sets_.front();
+    ready_sets_.pop_front();
+  }
+  auto& set = sets_[k];
+  CUDA_CALL(cudaEventSynchronize(set.uploaded));
+  for (int i = 0; i < feed_vars_.size(); i++) program_->BindInput(feed_vars_[i], set.device[i]->buffer());
+  program_->Execute();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_sets_.push_back(k);
+  }
+  cond_.notify_all();
+}
+
+InputPipeline::~InputPipeline() {
+  CUDA_CALL(cudaStreamSynchronize(copy_stream_));
+  for (auto& set : sets_) CUDA_CALL(cudaEventDestroy(set.uploaded));
+  CUDA_CALL(cudaStreamDestroy(copy_stream_));
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
+
+#endif  // CINN_WITH_CUDA
@@ -0,0 +1,108 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#ifdef CINN_WITH_CUDA
+
+#include <cuda_runtime.h>
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "cinn/common/macros.h"
+#include "cinn/hlir/framework/buffer.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * InputPipeline overlaps the uploads of the inputs of the next batches with the execution of an NVGPU program. Each
+ * feed variable has num_sets sets of device buffers, together with the pinned host staging buffers. A batch is copied
+ * into the staging buffers of a free set and then to its device buffers on a copy stream, and the program is executed
+ * with the inputs bound to the oldest uploaded set, which is free again after the execution. The sets rotate, so the
+ * host-to-device copies of up to num_sets - 1 batches are hidden behind the running one.
+ *
+ * A typical usage on a single thread, where the outputs are read from the scope of the program after each Execute:
+ *
+ *   InputPipeline pipeline(program.get(), {"x"});
+ *   pipeline.Upload({{"x", batches[0]}});
+ *   for (int i = 1; i < batches.size(); i++) {
+ *     pipeline.Upload({{"x", batches[i]}});
+ *     pipeline.Execute();
+ *   }
+ *   pipeline.Execute();
+ *
+ * Or Upload on a loading thread and Execute on the serving thread, which take the sets in order.
+ */
+class InputPipeline {
+ public:
+  /**
+   * Constructor.
+   * @param program The program to feed, with the variables instantiated on the current device.
+   * @param feed_vars The variables uploaded per batch, with the shapes and types of those in the scope of the program.
+   * @param num_sets The number of the buffer sets of each variable, at least 2.
+   */
+  InputPipeline(Program* program, const std::vector<std::string>& feed_vars, int num_sets = 2);
+
+  int num_sets() const { return sets_.size(); }
+
+  /**
+   * Copy the host data of a batch for all the feed variables into a free set and start uploading it. It blocks until
+   * a set is free, so a single thread can upload at most num_sets batches ahead of Execute.
+   */
+  void Upload(const std::map<std::string, const void*>& inputs);
+
+  /**
+   * Execute the program on the oldest uploaded batch after its upload finishes, the set is free to upload again when
+   * it returns. It blocks until a batch is uploaded.
+   */
+  void Execute();
+
+  ~InputPipeline();
+
+ private:
+  struct BufferSet {
+    // The device buffers bound to the program and the staging buffers of each feed variable.
+    std::vector<Tensor> device;
+    std::vector<std::unique_ptr<Buffer>> staging;
+    // Recorded after the upload on the copy stream.
+    cudaEvent_t uploaded{};
+  };
+
+  Program* program_;
+  std::vector<std::string> feed_vars_;
+  std::vector<BufferSet> sets_;
+  cudaStream_t copy_stream_{};
+
+  // The sets free to upload and the uploaded ones, in order.
+  std::deque<int> free_sets_;
+  std::deque<int> ready_sets_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(InputPipeline);
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
+
+#endif  // CINN_WITH_CUDA
@@ -0,0 +1,91 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/input_pipeline.h"
+
+#include <cuda_runtime.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "cinn/backends/cuda_util.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+TEST(InputPipeline, rotate) {
+  frontend::Program prog;
+  frontend::Variable a("A");
+  frontend::Variable b("B");
+  Type t   = Float(32);
+  a->shape = {100, 32};
+  b->shape = {100, 32};
+  a->type  = t;
+  b->type  = t;
+  auto c   = prog.add(a, b);
+  auto d   = prog.add(c, b);
+  Target target(common::DefaultNVGPUTarget());
+
+  auto g = std::make_shared<Graph>(prog, target);
+  ApplyPass(g.get(), "InferShape");
+  auto scope = BuildScope(target, g);
+  GraphCompiler gc(target, scope, g);
+  GraphCompiler::CompileOptions options;
+  options.with_instantiate_variables = true;
+  auto&& program                     = gc.Build(options).runtime_program;
+  std::vector<float> b_host(100 * 32, 2.f);
+  auto* b_data = scope->GetTensor("B")->mutable_data<float>(target);
+  CUDA_CALL(cudaMemcpy(b_data, b_host.data(), b_host.size() * sizeof(float), cudaMemcpyHostToDevice));
+
+  const int num_batches = 5;
+  std::vector<std::vector<float>> batches;
+  for (int i = 0; i < num_batches; i++) batches.emplace_back(100 * 32, i);
+  std::vector<float> out(100 * 32);
+  auto check = [&](int i) {
+    auto* d_data = scope->GetTensor(d->id)->data<float>();
+    CUDA_CALL(cudaMemcpy(out.data(), d_data, out.size() * sizeof(float), cudaMemcpyDeviceToHost));
+    for (auto value : out) ASSERT_NEAR(value, i + 2 * 2.f, 1e-5);
+  };
+
+  // the next batch is uploaded before executing the current one
+  InputPipeline pipeline(program.get(), {"A"}, 3);
+  ASSERT_EQ(pipeline.num_sets(), 3);
+  pipeline.Upload({{"A", batches[0].data()}});
+  for (int i = 1; i < num_batches; i++) {
+    pipeline.Upload({{"A", batches[i].data()}});
+    pipeline.Execute();
+    check(i - 1);
+  }
+  pipeline.Execute();
+  check(num_batches - 1);
+
+  // uploaded by a loading thread
+  std::thread loader([&] {
+    for (auto& batch : batches) pipeline.Upload({{"A", batch.data()}});
+  });
+  for (int i = 0; i < num_batches; i++) {
+    pipeline.Execute();
+    check(i);
+  }
+  loader.join();
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -14,18 +14,91 @@
 
 #include "cinn/hlir/framework/instruction.h"
 
+#include <algorithm>
+#include <functional>
+#include <sstream>
+
+#include "cinn/backends/llvm/runtime_symbol_registry.h"
 #include "cinn/common/test_helper.h"
+#include "cinn/utils/string.h"
+
+DEFINE_string(cinn_matmul_library,
+              "auto",
+              "How the matmuls on NVGPU run: cublas, kernel for the generated kernels, or auto to time both on the "
+              "first run and keep the faster one.");
+DEFINE_string(cinn_conv2d_library,
+              "auto",
+              "How the forward NCHW float convs with no epilogue on NVGPU run: cudnn, kernel for the generated "
+              "kernels, e.g. the implicit GEMM ones, or auto to time both on the first run and keep the faster one.");
+DEFINE_int32(cinn_output_summary_period,
+             0,
+             "Log the sum, min, max and NaN/Inf counts of the outputs of each instruction once every this many runs of "
+             "it, e.g. to find where the NaNs come from under the production load, 0 to disable.");
 
 namespace cinn {
 namespace hlir {
 namespace framework {
 
+void Instruction::MergeArgs() {
+  if (fn_.size() > 1 && fn_.size() != in_args_.size()) {
+    out_args_.back()[0] = out_args_.front()[0];
+    out_args_.erase(out_args_.begin());
+    in_args_.erase(in_args_.begin());
+  }
+}
+
+void Instruction::ResolveArgSlots() {
+  if (!arg_slots_.empty()) return;
+  MergeArgs();
+  CHECK(scope_) << "The slots of the arguments are resolved in the scope";
+  for (int i = 0; i < in_args_.size(); i++) {
+    arg_slots_.emplace_back();
+    for (auto* args : {&in_args_[i], &out_args_[i]}) {
+      for (auto& arg : *args) arg_slots_.back().push_back(scope_->Slot(arg));
+    }
+  }
+}
+
+cinn_pod_value_t Instruction::ScopeArg(const std::string& arg, int slot) const {
+  if (!bound_args_.empty()) {
+    auto it = bound_args_.find(arg);
+    if (it != bound_args_.end()) return cinn_pod_value_t(it->second);
+  }
+  auto* var = scope_->VarAt(slot);
+  CHECK(var) << "Argument [" << arg << "] not found in the scope";
+  // TODO(Superjomn) Support other types.
+  return cinn_pod_value_t(absl::get<Tensor>(*var)->buffer());
+}
+
+std::vector<cinn_pod_value_t>& Instruction::PrepareFedArgs(int i) {
+  ResolveArgSlots();
+  if (fed_args_.size() <= i) fed_args_.resize(i + 1);
+  auto& args       = fed_args_[i];
+  auto& slots      = arg_slots_[i];
+  int num_dim_args = i < dim_args_.size() ? dim_args_[i].size() : 0;
+  args.resize(num_dim_args + slots.size());
+  int j = 0;
+  for (auto* names : {&in_args_[i], &out_args_[i]}) {
+    for (auto& arg : *names) {
+      int slot                    = slots[j];
+      const cinn_pod_value_t* fed = slot < slot2podargs_->size() ? (*slot2podargs_)[slot] : nullptr;
+      args[num_dim_args + j]      = fed ? *fed : ScopeArg(arg, slot);
+      j++;
+    }
+  }
+  return FillDimArgs(i, &args);
+}
+
 std::vector<cinn_pod_value_t>& Instruction::PreparePodArgs(
     int i, const std::map<std::string, cinn_pod_value_t>* name2podargs) {
-  if (args_cached_.size() > i) return args_cached_[i];
+  if (slot2podargs_) return PrepareFedArgs(i);
+  if (args_cached_.size() > i) return FillDimArgs(i, &args_cached_[i]);
   common::ArgsBuilder builder;
   std::vector<std::string> all_args(in_args_[i].begin(), in_args_[i].end());
   all_args.insert(std::end(all_args), out_args_[i].begin(), out_args_[i].end());
+  // the placeholders of the dims, filled below
+  int num_dim_args = i < dim_args_.size() ? dim_args_[i].size() : 0;
+  for (int j = 0; j < num_dim_args; j++) builder.Add(static_cast<int32_t>(0));
 
   if (name2podargs != nullptr) {
     for (auto& arg : all_args) {
@@ -33,103 +106,542 @@ std::vector<cinn_pod_value_t>& Instruction::PreparePodArgs(
       builder.Add(name2podargs->at(arg));
     }
   } else {
-    for (auto& arg : all_args) {
-      auto* var = scope_->FindVar(arg);
-      CHECK(var) << "Argument [" << arg << "] not found in the scope";
-
-      // TODO(Superjomn) Support other types.
-      auto& tensor = absl::get<Tensor>(*var);
-      builder.Add(tensor->buffer());
-    }
+    ResolveArgSlots();
+    for (int j = 0; j < all_args.size(); j++) builder.Add(ScopeArg(all_args[j], arg_slots_[i][j]));
   }
 
   args_cached_.emplace_back(builder.Build());
   CHECK(args_cached_.size() > i);
-  return args_cached_[i];
+  return FillDimArgs(i, &args_cached_[i]);
 }
 
-void Instruction::Run(const std::map<std::string, cinn_pod_value_t>* name2podargs, bool dryrun) {
-  if (fn_.size() > 1 && fn_.size() != in_args_.size()) {
-    out_args_.back()[0] = out_args_.front()[0];
-    out_args_.erase(out_args_.begin());
-    in_args_.erase(in_args_.begin());
+std::vector<cinn_pod_value_t>& Instruction::FillDimArgs(int i, std::vector<cinn_pod_value_t>* args) {
+  if (i >= dim_args_.size()) return *args;
+  auto& dim_args = dim_args_[i];
+  for (int j = 0; j < dim_args.size(); j++) {
+    cinn_buffer_t* buffer = (*args)[dim_args.size() + dim_args[j].first];
+    CHECK_LT(dim_args[j].second, buffer->dimensions) << "The buffer of the symbolic dim has fewer dims";
+    (*args)[j] = cinn_pod_value_t(static_cast<int32_t>(buffer->dims[dim_args[j].second]));
   }
+  return *args;
+}
+
+void Instruction::SetDimArgs(int i, const std::vector<std::pair<std::string, int>>& dim_args) {
+  CHECK_LT(i, in_args_.size()) << "The arguments of the function should be added before its dims";
+  CHECK(args_cached_.empty()) << "The dims should be set before the first run";
+  std::vector<std::string> all_args(in_args_[i].begin(), in_args_[i].end());
+  all_args.insert(all_args.end(), out_args_[i].begin(), out_args_[i].end());
+  if (dim_args_.size() <= i) dim_args_.resize(i + 1);
+  dim_args_[i].clear();
+  for (auto& item : dim_args) {
+    auto it = std::find(all_args.begin(), all_args.end(), item.first);
+    CHECK(it != all_args.end()) << "The symbolic dim is of [" << item.first << "], which is not an argument";
+    dim_args_[i].emplace_back(it - all_args.begin(), item.second);
+  }
+}
+
+void Instruction::SetLaunchDims(int i, const std::array<int, 3>& grid_dims, const std::array<int, 3>& block_dims) {
+  CHECK_LT(i, fn_.size()) << "The function should be set before its launch dims";
+  if (launch_dims_.size() <= i) launch_dims_.resize(i + 1);
+  launch_dims_[i].assign(grid_dims.begin(), grid_dims.end());
+  launch_dims_[i].insert(launch_dims_[i].end(), block_dims.begin(), block_dims.end());
+}
+
+#ifdef CINN_WITH_CUDNN
+runtime::cuda::KernelLaunch* Instruction::ResolveKernelLaunch(int i, std::vector<cinn_pod_value_t>* args) {
+  if (i >= launch_dims_.size() || launch_dims_[i].empty()) return nullptr;
+  if (kernel_launches_.size() <= i) {
+    kernel_launches_.resize(fn_.size());
+    launch_bound_.resize(fn_.size(), false);
+  }
+  auto& launch = kernel_launches_[i];
+  if (!launch) {
+    // the kernel the host function fn_X launches is held by the global variable fn_X_kernel_ptr_
+    auto* kernel_ptr = backends::RuntimeSymbolRegistry::Global().Lookup(fn_names_[i] + "_kernel_ptr_");
+    if (!kernel_ptr) {
+      launch_dims_[i].clear();
+      return nullptr;
+    }
+    launch.reset(new runtime::cuda::KernelLaunch);
+    launch->function = *reinterpret_cast<CUfunction*>(kernel_ptr);
+    std::copy(launch_dims_[i].begin(), launch_dims_[i].begin() + 3, launch->grid_dims.begin());
+    std::copy(launch_dims_[i].begin() + 3, launch_dims_[i].end(), launch->block_dims.begin());
+  }
+  // the fed arguments change in each run, so they are bound in each call
+  if (slot2podargs_ || !launch_bound_[i]) {
+    launch->BindArgs(args->data(), args->size());
+    launch_bound_[i] = !slot2podargs_;
+  }
+  return launch.get();
+}
+#endif
+
+void Instruction::CallFunction(int i, std::vector<cinn_pod_value_t>* args) {
+#ifdef CINN_WITH_CUDNN
+  if (auto* launch = ResolveKernelLaunch(i, args)) {
+    launch->Launch(stream_);
+    return;
+  }
+#endif
+  fn_[i].load(std::memory_order_acquire)(args->data(), args->size());
+}
+
+void Instruction::BindArg(const std::string& name, cinn_buffer_t* buffer) {
+  CHECK(buffer) << "The buffer bound to [" << name << "] should not be null";
+  bound_args_[name] = buffer;
+#ifdef CINN_WITH_CUDNN
+  launch_bound_.assign(launch_bound_.size(), false);
+#endif
+  for (int i = 0; i < args_cached_.size(); i++) {
+    int j = i < dim_args_.size() ? dim_args_[i].size() : 0;
+    for (auto* args : {&in_args_[i], &out_args_[i]}) {
+      for (auto& arg : *args) {
+        if (arg == name) args_cached_[i][j] = cinn_pod_value_t(buffer);
+        j++;
+      }
+    }
+  }
+}
+
+std::unique_ptr<Instruction> Instruction::Clone(Scope* scope) const {
+  std::unique_ptr<Instruction> instr(new Instruction(target_, scope, {}, {}, function_name_));
+  instr->in_args_  = in_args_;
+  instr->out_args_ = out_args_;
+  for (auto& fn : fn_) instr->fn_.emplace_back(fn.load(std::memory_order_acquire));
+  instr->fn_names_       = fn_names_;
+  instr->fn_costs_       = fn_costs_;
+  instr->dim_args_       = dim_args_;
+  instr->launch_dims_    = launch_dims_;
+  instr->op_names_       = op_names_;
+  instr->node_ids_       = node_ids_;
+  instr->precision_mode_ = precision_mode_;
+  instr->attrs           = attrs;
+  instr->str_attrs       = str_attrs;
+  instr->pre_run         = pre_run;
+  return instr;
+}
+
+KernelCost Instruction::cost() const {
+  KernelCost res;
+  for (auto& cost : fn_costs_) {
+    res.flops += cost.flops;
+    res.bytes_read += cost.bytes_read;
+    res.bytes_written += cost.bytes_written;
+  }
+  return res;
+}
+
+void Instruction::SetStream(void* stream) {
+  stream_ = stream;
+  if (target_.arch != Target::Arch::NVGPU) return;
+  // The outputs are tied to the stream producing them, so that the stream-ordered allocators free them after the work.
+  for (auto& args : out_args_) {
+    for (auto& arg : args) {
+      auto* var = scope_ ? scope_->FindVar(arg) : nullptr;
+      if (var && absl::holds_alternative<Tensor>(*var)) absl::get<Tensor>(*var)->SetStream(stream);
+    }
+  }
+  // The host function of kernel fn_X launches it on the stream held by the global variable fn_X_kernel_stream_ptr_.
+  stream_slots_.clear();
+  for (auto& fn_name : fn_names_) {
+    auto* stream_ptr = backends::RuntimeSymbolRegistry::Global().Lookup(fn_name + "_kernel_stream_ptr_");
+    if (!stream_ptr) continue;
+    stream_slots_.push_back(reinterpret_cast<void**>(stream_ptr));
+    *stream_slots_.back() = stream;
+  }
+  ReserveWorkSpace();
+}
+
+bool Instruction::IsLibraryCall() const {
+#ifdef CINN_WITH_CUDNN
+  if (target_.arch != Target::Arch::NVGPU) return false;
+  // The matmuls and the muls get the attributes of the library call only if cuBLAS runs them, see pe::UseSmallMatmul.
+#ifdef CINN_WITH_NCCL
+  if (IsCollective()) return true;
+#endif
+  return function_name_ == "conv2d" || function_name_ == "depthwise_conv2d" || function_name_ == "pool2d" ||
+         function_name_ == "softmax" || ((function_name_ == "mul" || function_name_ == "matmul") && !attrs.empty());
+#else
+  return false;
+#endif
+}
+
+bool Instruction::IsCollective() const {
+  return function_name_ == "allreduce" || function_name_ == "allgather" || function_name_ == "reduce_scatter";
+}
+
+bool Instruction::IsMultiTensorOptimizer() const {
+  return function_name_ == "multi_tensor_sgd" || function_name_ == "multi_tensor_momentum" ||
+         function_name_ == "multi_tensor_adam";
+}
+
+void Instruction::ResolveMultiTensorOptimizer() {
+  CHECK_GE(attrs.size(), 3UL) << "The multi-tensor optimizer " << function_name_ << " should update some params";
+  CHECK_EQ(str_attrs.size(), 6UL) << "The multi-tensor optimizer " << function_name_ << " misses the hyperparameters";
+  runtime::MultiTensorOptimizerAttrs optimizer;
+  optimizer.kind            = runtime::OptimizerKindOf(function_name_);
+  optimizer.use_nesterov    = attrs[0];
+  optimizer.multi_precision = attrs[1];
+  optimizer.numels.assign(attrs.begin() + 2, attrs.end());
+  optimizer.learning_rate = std::stof(str_attrs[0]);
+  optimizer.momentum      = std::stof(str_attrs[1]);
+  optimizer.beta1         = std::stof(str_attrs[2]);
+  optimizer.beta2         = std::stof(str_attrs[3]);
+  optimizer.epsilon       = std::stof(str_attrs[4]);
+  optimizer.weight_decay  = std::stof(str_attrs[5]);
+  optimizer_.reset(new runtime::MultiTensorOptimizer(optimizer, target_));
+  CHECK_EQ(in_args_.size(), 1UL);
+  CHECK_EQ(in_args_[0].size(), optimizer_->num_inputs()) << "The multi-tensor optimizer got wrong number of inputs";
+  CHECK_EQ(out_args_[0].size(), optimizer_->num_outputs()) << "The multi-tensor optimizer got wrong number of outputs";
+}
+
+bool Instruction::IsBlockSparseMul() const { return function_name_ == "block_sparse_mul"; }
+
+void Instruction::ResolveBlockSparseMul() {
+  CHECK_EQ(attrs.size(), 5UL) << "The block-sparse mul should have the attrs M, N, K, block_n and block_k";
+  CHECK_EQ(str_attrs.size(), 1UL) << "The block-sparse mul misses the density_threshold";
+  runtime::BlockSparseMatmulAttrs matmul;
+  matmul.M                 = attrs[0];
+  matmul.N                 = attrs[1];
+  matmul.K                 = attrs[2];
+  matmul.block_n           = attrs[3];
+  matmul.block_k           = attrs[4];
+  matmul.density_threshold = std::stof(str_attrs[0]);
+  sparse_matmul_.reset(new runtime::BlockSparseMatmul(matmul, target_));
+}
+
+void Instruction::PrepareLibraryCall() {
+#ifdef CINN_WITH_CUDNN
+  if (!library_call_resolved_) ResolveLibraryCall();
+  ReserveWorkSpace();
+#endif
+}
+
+void Instruction::ReserveWorkSpace() {
+#ifdef CINN_WITH_CUDNN
+  if (!library_call_ || !library_call_->workspace_size()) return;
+  // Reserve the workspace of the stream ahead, so it is not reallocated in running.
+  auto& handles = runtime::cuda::LibraryHandles::Get(static_cast<cudaStream_t>(stream_));
+  std::lock_guard<std::mutex> lock(handles.mutex());
+  handles.GetWorkSpace(library_call_->workspace_size());
+#endif
+}
+
+void Instruction::Run(const std::vector<const cinn_pod_value_t*>& slot2podargs, bool dryrun) {
+  slot2podargs_ = &slot2podargs;
+  Run(nullptr, dryrun);
+  slot2podargs_ = nullptr;
+}
+
+void Instruction::Run(const std::map<std::string, cinn_pod_value_t>* name2podargs, bool dryrun) {
+  MergeArgs();
 
   if (name2podargs != nullptr) {
     args_cached_.clear();
+#ifdef CINN_WITH_CUDNN
+    launch_bound_.assign(launch_bound_.size(), false);
+#endif
   }
 
   VLOG(2) << "Run function " << function_name_;
 
+  // the range links the anonymous kernels on the Nsight timeline back to the fused group and its ops
+  if (utils::NvtxRange::enabled() && nvtx_name_.empty()) {
+    nvtx_name_ = function_name_;
+    if (!op_names_.empty()) nvtx_name_ += " [" + utils::Join(op_names_, ", ") + "]";
+  }
+  utils::NvtxRange nvtx(nvtx_name_);
+
+  if (!profiler_ || dryrun) {
+    RunImpl(name2podargs, dryrun);
+  } else {
+    int id = profiler_->Start(target_, stream_);
+    RunImpl(name2podargs, dryrun);
+    auto total = cost();
+    profiler_->Stop(id, function_name_, "instruction", ProfileArgs(), total.flops, total.bytes());
+  }
+  if (FLAGS_cinn_output_summary_period > 0 && !dryrun && summary_runs_++ % FLAGS_cinn_output_summary_period == 0) {
+    SummarizeOutputs(name2podargs);
+  }
+}
+
+void Instruction::SummarizeOutputs(const std::map<std::string, cinn_pod_value_t>* name2podargs) {
+#ifdef CINN_WITH_CUDA
+  if (target_.arch == Target::Arch::NVGPU) CUDA_CALL(cudaStreamSynchronize(static_cast<cudaStream_t>(stream_)));
+#endif
+  auto is_float32 = [](const cinn_buffer_t* buffer) {
+    return buffer->type.code == cinn_type_float && buffer->type.bits == 32;
+  };
+  for (int i = 0; i < out_args_.size(); i++) {
+    for (int k = 0; k < out_args_[i].size(); k++) {
+      auto& arg                   = out_args_[i][k];
+      cinn_buffer_t* buffer       = nullptr;
+      bool float32                = false;
+      const cinn_pod_value_t* fed = nullptr;
+      if (slot2podargs_) {
+        int slot = arg_slots_[i][in_args_[i].size() + k];
+        if (slot < slot2podargs_->size()) fed = (*slot2podargs_)[slot];
+      }
+      if (name2podargs) {
+        auto it = name2podargs->find(arg);
+        if (it == name2podargs->end()) continue;
+        buffer  = it->second;
+        float32 = is_float32(buffer);
+      } else if (fed) {
+        buffer  = *fed;
+        float32 = is_float32(buffer);
+      } else if (bound_args_.count(arg)) {
+        buffer  = bound_args_.at(arg);
+        float32 = is_float32(buffer);
+      } else {
+        // the tensors of unknown types are allocated as float32
+        auto* var = scope_->FindVar(arg);
+        if (!var || !absl::holds_alternative<Tensor>(*var)) continue;
+        auto& tensor = absl::get<Tensor>(*var);
+        buffer       = tensor->buffer();
+        float32      = tensor->type().is_float(32) || tensor->type().is_unk();
+      }
+      if (!float32 || !buffer || !buffer->memory) continue;
+      auto summary = SummarizeBuffer(*buffer, target_);
+      if (summary.all_finite()) {
+        LOG(INFO) << "The output " << arg << " of " << function_name_ << ": " << summary.DebugString();
+      } else {
+        LOG(WARNING) << "The output " << arg << " of " << function_name_ << " is not finite: " << summary.DebugString();
+      }
+    }
+  }
+}
+
+void Instruction::RunImpl(const std::map<std::string, cinn_pod_value_t>* name2podargs, bool dryrun) {
+  if (IsMultiTensorOptimizer()) {
+    if (!optimizer_) ResolveMultiTensorOptimizer();
+    // the instruction has a single list of the inputs and the outputs, which the optimizer takes as they are
+    auto& pod_args = PreparePodArgs(0, name2podargs);
+    if (!dryrun) {
+      int id = profiler_ ? profiler_->Start(target_, stream_) : -1;
+      optimizer_->Run(pod_args, stream_);
+      if (profiler_) profiler_->Stop(id, function_name_, "kernel", ProfileArgs());
+    }
+    return;
+  }
+  // the single dense function takes X, W and the output first, and the weight is packed into BSR on the first run
+  if (IsBlockSparseMul() && fn_.size() == 1 && dim_args_.empty() && !dryrun) {
+    if (!sparse_matmul_) ResolveBlockSparseMul();
+    auto& pod_args = PreparePodArgs(0, name2podargs);
+    if (sparse_matmul_->Prepare(pod_args)) {
+      int id = profiler_ ? profiler_->Start(target_, stream_) : -1;
+      sparse_matmul_->Run(pod_args, stream_);
+      if (profiler_) profiler_->Stop(id, function_name_, "kernel", ProfileArgs());
+      return;
+    }
+  }
+#ifdef CINN_WITH_CUDNN
+  if (!library_call_resolved_) ResolveLibraryCall();
+  if (library_call_ && !library_call_selected_ && !dryrun) SelectLibraryCall(name2podargs);
+  if (library_call_) {
+    auto& pod_args = PreparePodArgs(0, name2podargs);
+    if (!dryrun) {
+      auto& handles = runtime::cuda::LibraryHandles::Get(static_cast<cudaStream_t>(stream_));
+      std::lock_guard<std::mutex> lock(handles.mutex());
+      int id = profiler_ ? profiler_->Start(target_, stream_) : -1;
+      library_call_->Run(pod_args, &handles);
+      if (profiler_) {
+        // the library computes the same as the generated kernels
+        auto total = cost();
+        profiler_->Stop(id, function_name_, "library", ProfileArgs(), total.flops, total.bytes());
+      }
+    }
+    return;
+  }
+  // The replicas on other devices launch the kernels on their own streams held by the thread.
+  runtime::cuda::SetThreadLaunchStream(stream_);
+#endif
+  // The functions may be shared with the instructions on other streams, e.g. the deduplicated kernels, so the streams
+  // are set again before launching.
+  for (auto* slot : stream_slots_) *slot = stream_;
+  int i = 0;
+  for (auto& fn : fn_) {
+    auto& pod_args = PreparePodArgs(i, name2podargs);
+    CHECK(fn.load(std::memory_order_acquire))
+        << "The LoweredFunc address should be set first by calling SetLoweredFunc method";
+    if (!dryrun) {
+      int id = profiler_ ? profiler_->Start(target_, stream_) : -1;
+      CallFunction(i, &pod_args);
+      if (profiler_) {
+        auto& cost = fn_costs_[i];
+        profiler_->Stop(id, fn_names_[i], "kernel", {{"instruction", function_name_}}, cost.flops, cost.bytes());
+      }
+    }
+    i++;
+  }
+}
+
+const std::map<std::string, std::string>& Instruction::ProfileArgs() {
+  if (!profile_args_.empty()) return profile_args_;
+  auto shapes = [&](const std::vector<std::vector<std::string>>& args_list) {
+    std::stringstream ss;
+    bool first = true;
+    for (auto& args : args_list) {
+      for (auto& arg : args) {
+        if (!first) ss << ", ";
+        first     = false;
+        auto* var = scope_->FindVar(arg);
+        ss << arg;
+        if (!var || !absl::holds_alternative<Tensor>(*var)) continue;
+        ss << "[" << utils::Join(absl::get<Tensor>(*var)->shape().data(), ",") << "]";
+      }
+    }
+    return ss.str();
+  };
+  std::stringstream target;
+  target << target_;
+  profile_args_["target"]  = target.str();
+  profile_args_["inputs"]  = shapes(in_args_);
+  profile_args_["outputs"] = shapes(out_args_);
+  if (!node_ids_.empty()) profile_args_["nodes"] = utils::Join(node_ids_, ",");
+  return profile_args_;
+}
+
 #ifdef CINN_WITH_CUDNN
-  auto& pod_args = PreparePodArgs(0, name2podargs);
+void Instruction::ResolveLibraryCall() {
+  library_call_resolved_ = true;
+  if (!IsLibraryCall()) return;
+  using runtime::cuda::Conv2dAttrs;
+  using runtime::cuda::Conv2dKind;
+  // The conv2d and mul in float16 are marked by a trailing "float16" in the str_attrs.
+  bool fp16 = !str_attrs.empty() && str_attrs.back() == "float16";
+  std::vector<std::string> str_attrs(this->str_attrs.begin(), this->str_attrs.end() - fp16);
   // Here conv2d and depthwise_conv2d are implemented by one cudnn api cudnnConvolutionForward
-  if ((function_name_ == "conv2d" || function_name_ == "depthwise_conv2d") && target_.arch == Target::Arch::NVGPU) {
+  if (function_name_ == "conv2d" || function_name_ == "depthwise_conv2d") {
+    CHECK_GE(attrs.size(), 19);
+    // attrs holds three shapes at [0, 4), [4, 8) and [15, 19) and the conv configurations at [8, 15), the roles of
+    // the shapes depend on the direction. An extra 1 at 19 marks the NHWC data and the OHWI filter, whose shapes are
+    // still given in the NCHW order.
+    auto make_attrs = [&](int in, int weights, int out) {
+      return Conv2dAttrs{attrs[in],
+                         attrs[in + 1],
+                         attrs[in + 2],
+                         attrs[in + 3],
+                         attrs[weights],
+                         attrs[weights + 1],
+                         attrs[weights + 2],
+                         attrs[weights + 3],
+                         attrs[8],
+                         attrs[9],
+                         attrs[10],
+                         attrs[11],
+                         attrs[12],
+                         attrs[13],
+                         attrs[14],
+                         attrs[out],
+                         attrs[out + 1],
+                         attrs[out + 2],
+                         attrs[out + 3],
+                         attrs.size() > 19 && attrs[19] == 1,
+                         fp16,
+                         precision_mode_};
+    };
     if (str_attrs[0] == "forward") {
-      absl::flat_hash_map<std::string, int> attrs_map = {
-          {"input_n", attrs[0]},     {"input_c", attrs[1]},     {"input_h", attrs[2]},   {"input_w", attrs[3]},
-          {"weights_n", attrs[4]},   {"weights_c", attrs[5]},   {"weights_h", attrs[6]}, {"weights_w", attrs[7]},
-          {"pad_h", attrs[8]},       {"pad_w", attrs[9]},       {"stride_h", attrs[10]}, {"stride_w", attrs[11]},
-          {"dilation_h", attrs[12]}, {"dilation_w", attrs[13]}, {"groups", attrs[14]},   {"output_n", attrs[15]},
-          {"output_c", attrs[16]},   {"output_h", attrs[17]},   {"output_w", attrs[18]},
-      };
-      // input weight output
-      runtime::cuda::cinn_gpu_cudnn_conv2d(attrs_map, pod_args[0], pod_args[1], pod_args[2]);
+      // input weight output, followed by the epilogue attached by OpFusion if any.
+      std::vector<std::string> epilogue(str_attrs.begin() + 1, str_attrs.end());
+      library_call_.reset(new runtime::cuda::CudnnConv2d(make_attrs(0, 4, 15), Conv2dKind::kForward, epilogue));
     } else if (str_attrs[0] == "backward_data") {
       // w, dy, dx
-      absl::flat_hash_map<std::string, int> attrs_map = {
-          {"input_n", attrs[15]},    {"input_c", attrs[16]},    {"input_h", attrs[17]},  {"input_w", attrs[18]},
-          {"weights_n", attrs[0]},   {"weights_c", attrs[1]},   {"weights_h", attrs[2]}, {"weights_w", attrs[3]},
-          {"pad_h", attrs[8]},       {"pad_w", attrs[9]},       {"stride_h", attrs[10]}, {"stride_w", attrs[11]},
-          {"dilation_h", attrs[12]}, {"dilation_w", attrs[13]}, {"groups", attrs[14]},   {"output_n", attrs[4]},
-          {"output_c", attrs[5]},    {"output_h", attrs[6]},    {"output_w", attrs[7]},
-      };
-      // w, dy, dx
-      runtime::cuda::cinn_gpu_cudnn_conv2d_backward_data(attrs_map, pod_args[0], pod_args[1], pod_args[2]);
+      library_call_.reset(new runtime::cuda::CudnnConv2d(make_attrs(15, 0, 4), Conv2dKind::kBackwardData));
     } else {
       // x, dy, w
-      absl::flat_hash_map<std::string, int> attrs_map = {
-          {"input_n", attrs[0]},     {"input_c", attrs[1]},     {"input_h", attrs[2]},    {"input_w", attrs[3]},
-          {"weights_n", attrs[15]},  {"weights_c", attrs[16]},  {"weights_h", attrs[17]}, {"weights_w", attrs[18]},
-          {"pad_h", attrs[8]},       {"pad_w", attrs[9]},       {"stride_h", attrs[10]},  {"stride_w", attrs[11]},
-          {"dilation_h", attrs[12]}, {"dilation_w", attrs[13]}, {"groups", attrs[14]},    {"output_n", attrs[4]},
-          {"output_c", attrs[5]},    {"output_h", attrs[6]},    {"output_w", attrs[7]},
-      };
-      // x, dy, w
-      runtime::cuda::cinn_gpu_cudnn_conv2d_backward_filter(attrs_map, pod_args[0], pod_args[1], pod_args[2]);
+      library_call_.reset(new runtime::cuda::CudnnConv2d(make_attrs(0, 15, 4), Conv2dKind::kBackwardFilter));
     }
-  } else if (function_name_ == "pool2d" && target_.arch == Target::Arch::NVGPU) {
-    runtime::cuda::cinn_gpu_cudnn_pool2d(attrs, str_attrs, pod_args[0], pod_args[1]);
-  } else if (function_name_ == "softmax" && target_.arch == Target::Arch::NVGPU) {
-    CHECK_EQ(pod_args.size(), 3);
-    runtime::cuda::cinn_gpu_cudnn_softmax(attrs, pod_args[0], pod_args[1]);
-  } else if (function_name_ == "mul" && target_.arch == Target::Arch::NVGPU) {
-    CHECK_EQ(pod_args.size(), 4);
-    runtime::cuda::cinn_gpu_cublas_mul(attrs, pod_args[0], pod_args[1], pod_args[2]);
-  } else {
-    int i = 0;
-    for (auto& it_fn : fn_) {
-      auto& pod_args = PreparePodArgs(i, name2podargs);
-      CHECK(it_fn) << "The LoweredFunc address should be set first by calling SetLoweredFunc method";
-      if (!dryrun) {
-        it_fn(pod_args.data(), pod_args.size());
-      }
-      i++;
+  } else if (function_name_ == "pool2d") {
+    library_call_.reset(new runtime::cuda::CudnnPool2d(attrs, str_attrs));
+  } else if (function_name_ == "softmax") {
+    library_call_.reset(new runtime::cuda::CudnnSoftmax(attrs));
+  } else if (function_name_ == "mul") {
+    if (str_attrs.empty()) {
+      library_call_.reset(new runtime::cuda::CublasMul(attrs, fp16, precision_mode_));
+    } else {
+      library_call_.reset(new runtime::cuda::CublasLtMul(attrs, str_attrs, fp16, precision_mode_));
     }
+  } else if (function_name_ == "matmul") {
+    // the alpha is kept in the str_attrs
+    CHECK_EQ(str_attrs.size(), 1UL);
+    library_call_.reset(new runtime::cuda::CublasMatmul(attrs, std::stof(str_attrs[0]), fp16, precision_mode_));
   }
-#else
-  int i = 0;
-  for (auto& it_fn : fn_) {
-    auto& pod_args = PreparePodArgs(i, name2podargs);
-    CHECK(it_fn) << "The LoweredFunc address should be set first by calling SetLoweredFunc method";
-    if (!dryrun) {
-      it_fn(pod_args.data(), pod_args.size());
-    }
-    i++;
+#ifdef CINN_WITH_NCCL
+  using runtime::cuda::CollectiveKind;
+  if (IsCollective()) {
+    auto kind = function_name_ == "allreduce"   ? CollectiveKind::kAllReduce
+                : function_name_ == "allgather" ? CollectiveKind::kAllGather
+                                                : CollectiveKind::kReduceScatter;
+    library_call_.reset(new runtime::cuda::NcclCollective(kind, attrs, this->str_attrs));
   }
 #endif
 }
 
+namespace {
+// Time \p run on \p stream after a warm-up run, and return the average in milliseconds.
+float TimeOnStream(cudaStream_t stream, const std::function<void()>& run, int repeats = 10) {
+  run();
+  cudaEvent_t start, stop;
+  CUDA_CALL(cudaEventCreate(&start));
+  CUDA_CALL(cudaEventCreate(&stop));
+  CUDA_CALL(cudaEventRecord(start, stream));
+  for (int i = 0; i < repeats; i++) run();
+  CUDA_CALL(cudaEventRecord(stop, stream));
+  CUDA_CALL(cudaEventSynchronize(stop));
+  float ms = 0.f;
+  CUDA_CALL(cudaEventElapsedTime(&ms, start, stop));
+  CUDA_CALL(cudaEventDestroy(start));
+  CUDA_CALL(cudaEventDestroy(stop));
+  return ms / repeats;
+}
+}  // namespace
+
+void Instruction::SelectLibraryCall(const std::map<std::string, cinn_pod_value_t>* name2podargs) {
+  // Only the matmuls and the forward NCHW convs with no epilogue in the library call are lowered to the kernels too.
+  bool conv2d_kernels = function_name_ == "conv2d" && attrs.size() == 19UL && str_attrs.size() == 1UL &&
+                        str_attrs[0] == "forward" && FLAGS_cinn_conv2d_library != "cudnn";
+  bool matmul_kernels = function_name_ == "matmul" && FLAGS_cinn_matmul_library != "cublas";
+  if (!conv2d_kernels && !matmul_kernels) {
+    library_call_selected_ = true;
+    return;
+  }
+  if (conv2d_kernels && FLAGS_cinn_conv2d_library == "kernel") {
+    library_call_selected_ = true;
+    library_call_.reset();
+    return;
+  }
+  auto stream = static_cast<cudaStream_t>(stream_);
+  cudaStreamCaptureStatus capture_status;
+  CUDA_CALL(cudaStreamIsCapturing(stream, &capture_status));
+  // The stream can not be synchronized in capturing, so the library call runs until a later run chooses.
+  if (capture_status != cudaStreamCaptureStatusNone) return;
+  library_call_selected_ = true;
+
+  std::string key   = function_name_ + "," + utils::Join(attrs, ",") + "," + utils::Join(str_attrs, ",");
+  auto& serial_data = runtime::cuda::SerialData::get_instance();
+  int use_library   = 1;
+  if (!serial_data.FindAlgo(key, &use_library)) {
+    auto& handles    = runtime::cuda::LibraryHandles::Get(stream);
+    auto run_library = [&] {
+      std::lock_guard<std::mutex> lock(handles.mutex());
+      library_call_->Run(PreparePodArgs(0, name2podargs), &handles);
+    };
+    auto run_kernels = [&] {
+      for (auto* slot : stream_slots_) *slot = stream_;
+      for (int i = 0; i < fn_.size(); i++) CallFunction(i, &PreparePodArgs(i, name2podargs));
+    };
+    float library_ms = TimeOnStream(stream, run_library);
+    float kernel_ms  = TimeOnStream(stream, run_kernels);
+    use_library      = library_ms <= kernel_ms;
+    VLOG(3) << "The library call of " << key << " takes " << library_ms << " ms and the kernels take " << kernel_ms
+            << " ms";
+    serial_data.StoreAlgo(key, use_library);
+  }
+  if (!use_library) library_call_.reset();
+}
+#endif
+
 }  // namespace framework
 }  // namespace hlir
 }  // namespace cinn
@@ -14,18 +14,39 @@
 
 #pragma once
 
+#include <absl/container/flat_hash_map.h>
+#include <gflags/gflags.h>
+
+#include <array>
+#include <atomic>
+#include <deque>
 #include <map>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "cinn/backends/cuda_util.h"
+#include "cinn/common/precision.h"
+#include "cinn/hlir/framework/cost_model.h"
+#include "cinn/hlir/framework/profiler.h"
 #include "cinn/hlir/framework/scope.h"
+#include "cinn/hlir/framework/tensor_summary.h"
+#include "cinn/runtime/block_sparse_matmul.h"
+#include "cinn/runtime/multi_tensor_optimizer.h"
 #ifdef CINN_WITH_CUDNN
 #include "cinn/runtime/cuda/cuda_util.h"
 #endif
+#ifdef CINN_WITH_NCCL
+#include "cinn/runtime/cuda/nccl_util.h"
+#endif
+#include "cinn/utils/nvtx.h"
 #include "cinn/utils/timer.h"
 
+DECLARE_string(cinn_matmul_library);
+DECLARE_string(cinn_conv2d_library);
+DECLARE_int32(cinn_output_summary_period);
+
 namespace cinn {
 namespace hlir {
 namespace framework {
@@ -59,20 +80,127 @@ class Instruction {
    * @param fn The JIT compiled function address.
    */
   void SetLoweredFunc(lower_func_ptr_t fn, const std::string& name = "") {
-    fn_.push_back(fn);
+    fn_.emplace_back(fn);
     fn_names_.push_back(name);
+    fn_costs_.emplace_back();
   }
 
+  //! Attach the static \p cost of the \p i-th function, which the profiler reports the achieved rates by.
+  void SetKernelCost(int i, const KernelCost& cost) { fn_costs_.at(i) = cost; }
+  const std::vector<KernelCost>& kernel_costs() const { return fn_costs_; }
+  //! The total cost of all the functions.
+  KernelCost cost() const;
+
+  /**
+   * Replace the \p i-th function with \p fn computing the same, e.g. the one compiled at a higher optimization level.
+   * It is atomic, so it can be called while the instruction is running on another thread.
+   */
+  void SwapLoweredFunc(int i, lower_func_ptr_t fn) { fn_[i].store(fn, std::memory_order_release); }
+
   /**
    * Run the Instruction.
    */
   void Run(const std::map<std::string, cinn_pod_value_t>* name2podargs = nullptr, bool dryrun = false);
 
-  std::vector<std::vector<std::string>> GetInArgs() { return in_args_; }
-  std::vector<std::vector<std::string>> GetOutArgs() { return out_args_; }
-  std::vector<std::string> GetFnNames() { return fn_names_; }
+  /**
+   * Run the Instruction with the arguments fed by the slots of the variables in the scope, see Scope::Slot. The null
+   * ones and the slots out of range are taken from the scope as in the runs without feeds. The feeds are copied over
+   * the arguments by the slots resolved once, so unlike passing name2podargs, no name is looked up and the arguments
+   * prepared for the runs without feeds are kept.
+   */
+  void Run(const std::vector<const cinn_pod_value_t*>& slot2podargs, bool dryrun = false);
+
+  /**
+   * Resolve the names of the arguments to the slots of the scope, which is done on the first run if not called. It
+   * assigns the slots of the new names, so it should be called before running the instructions sharing the scope on
+   * multiple threads.
+   */
+  void ResolveArgSlots();
+
+  std::vector<std::vector<std::string>> GetInArgs() const { return in_args_; }
+  std::vector<std::vector<std::string>> GetOutArgs() const { return out_args_; }
+  std::vector<std::string> GetFnNames() const { return fn_names_; }
+  //! The arguments prepared for each function, they are empty before the first run.
+  const std::vector<std::vector<cinn_pod_value_t>>& GetPreparedArgs() const { return args_cached_; }
+  const std::string& function_name() const { return function_name_; }
   void AddInArgs(const std::vector<std::string>& in_args) { in_args_.push_back(in_args); }
   void AddOutArgs(const std::vector<std::string>& out_args) { out_args_.push_back(out_args); }
+
+  /**
+   * Let the \p i-th function take the symbolic dims as its leading scalar arguments, each is the dim of the argument
+   * named by the pair. They are filled from the buffers before each run, so the buffers bound later may have different
+   * shapes.
+   */
+  void SetDimArgs(int i, const std::vector<std::pair<std::string, int>>& dim_args);
+
+  /**
+   * Set the grid and the block dims of the CUDA kernel of the i-th function, so that the instruction launches the
+   * kernel directly by the parameters resolved on the first run instead of calling the host function, which resolves
+   * them from the pod values in each call, see runtime::cuda::KernelLaunch.
+   */
+  void SetLaunchDims(int i, const std::array<int, 3>& grid_dims, const std::array<int, 3>& block_dims);
+
+  /**
+   * Set the CUDA stream to launch the kernels of this instruction on, null means the default stream. It only works
+   * for the NVGPU target. The outputs in the scope are allocated and freed on the stream later, see Buffer::SetStream.
+   */
+  void SetStream(void* stream);
+  void* stream() const { return stream_; }
+
+  /**
+   * Let the argument \p name use the external \p buffer instead of the tensor in scope. The prepared arguments are
+   * patched in place, so the later runs pass it to the kernels without looking up the scope again.
+   */
+  void BindArg(const std::string& name, cinn_buffer_t* buffer);
+
+  /**
+   * Create a copy of the instruction calling the same compiled functions with the variables in \p scope. The states
+   * of running, e.g. the prepared arguments, the bindings, the stream and the profiler, are not copied.
+   */
+  std::unique_ptr<Instruction> Clone(Scope* scope) const;
+
+  //! The names of the ops of the fused nodes, which the NVTX range of the instruction is named with.
+  void SetOpNames(const std::vector<std::string>& op_names) { op_names_ = op_names; }
+  const std::vector<std::string>& op_names() const { return op_names_; }
+
+  //! The ids of the fused nodes, which key the instruction in the profile, see ExecutionProfile.
+  void SetNodeIds(const std::vector<std::string>& node_ids) { node_ids_ = node_ids; }
+  const std::vector<std::string>& node_ids() const { return node_ids_; }
+
+  //! The precision mode of the program, which the cuDNN and cuBLAS calls resolved later follow, e.g. to use TF32.
+  void SetPrecisionMode(common::PrecisionMode mode) { precision_mode_ = mode; }
+  common::PrecisionMode precision_mode() const { return precision_mode_; }
+
+  //! Record the time of the instruction and its kernels to \p profiler if it is not null.
+  void SetProfiler(Profiler* profiler) { profiler_ = profiler; }
+
+  //! Whether the instruction is executed by the external libraries like cuDNN and cuBLAS, by the handles of its stream.
+  bool IsLibraryCall() const;
+
+  //! Whether the instruction is a collective across the ranks, e.g. an allreduce, which runs on its own stream.
+  bool IsCollective() const;
+
+  /**
+   * Whether the instruction is a multi-tensor optimizer update, which runs by runtime::MultiTensorOptimizer instead of
+   * the lowered functions. The attrs hold use_nesterov, multi_precision and the number of elements of each parameter,
+   * and the str_attrs hold the learning_rate, momentum, beta1, beta2, epsilon and weight_decay.
+   */
+  bool IsMultiTensorOptimizer() const;
+
+  /**
+   * Whether the instruction is a block_sparse_mul, which runs by runtime::BlockSparseMatmul if its weight is sparse
+   * enough when it first runs, or by the lowered functions of the dense mul otherwise. The attrs hold M, N, K, block_n
+   * and block_k, and the str_attrs hold the density_threshold.
+   */
+  bool IsBlockSparseMul() const;
+
+  /**
+   * Build the library call with its descriptors now instead of in the first run, including searching the algorithm of
+   * the convolutions, which takes long, and reserve the workspace it needs on its stream. It does nothing for the
+   * other instructions.
+   */
+  void PrepareLibraryCall();
+
   std::vector<int> attrs;
   std::vector<std::string> str_attrs;
   bool pre_run = false;
@@ -81,6 +209,51 @@ class Instruction {
  protected:
   std::vector<cinn_pod_value_t>& PreparePodArgs(int i, const std::map<std::string, cinn_pod_value_t>* name2podargs);
 
+  // Fold the arguments of the instruction into those of its functions when their numbers mismatch.
+  void MergeArgs();
+
+  // Copy the feeds of slot2podargs_ over the arguments of the i-th function.
+  std::vector<cinn_pod_value_t>& PrepareFedArgs(int i);
+
+  // The argument \p arg of \p slot taken from the bindings or the scope.
+  cinn_pod_value_t ScopeArg(const std::string& arg, int slot) const;
+
+  // Fill the leading scalars of the arguments of the i-th function from the shapes of the buffers.
+  std::vector<cinn_pod_value_t>& FillDimArgs(int i, std::vector<cinn_pod_value_t>* args);
+
+  // Call the i-th function with \p args, or launch its kernel directly if it has the launch dims.
+  void CallFunction(int i, std::vector<cinn_pod_value_t>* args);
+
+  void RunImpl(const std::map<std::string, cinn_pod_value_t>* name2podargs, bool dryrun);
+
+  // The arguments attached to the profile records, e.g. the shapes of the inputs and outputs.
+  const std::map<std::string, std::string>& ProfileArgs();
+
+  // Log the TensorSummary of each float32 output, a warning if it has NaNs or Infs, see --cinn_output_summary_period.
+  void SummarizeOutputs(const std::map<std::string, cinn_pod_value_t>* name2podargs);
+
+#ifdef CINN_WITH_CUDNN
+  // Build the library call with its descriptors from the attributes once, it is left null if the instruction runs
+  // the lowered functions.
+  void ResolveLibraryCall();
+
+  // Choose between the library call and the generated kernels by timing both on the first run, for the instructions
+  // having both, and drop the library call if the kernels are faster. The choices are kept in SerialData.
+  void SelectLibraryCall(const std::map<std::string, cinn_pod_value_t>* name2podargs);
+#endif
+#ifdef CINN_WITH_CUDNN
+  // Get the launch of the kernel of the i-th function bound to \p args, null if it has no launch dims or no kernel.
+  runtime::cuda::KernelLaunch* ResolveKernelLaunch(int i, std::vector<cinn_pod_value_t>* args);
+#endif
+  // Grow the workspace of the handles of the stream to what the resolved library call needs.
+  void ReserveWorkSpace();
+
+  // Build the multi-tensor optimizer from the attributes once.
+  void ResolveMultiTensorOptimizer();
+
+  // Build the block-sparse matmul from the attributes once.
+  void ResolveBlockSparseMul();
+
  private:
   Scope* scope_{};
   std::string function_name_;
@@ -88,9 +261,49 @@ class Instruction {
   std::vector<std::vector<std::string>> out_args_;
 
   std::vector<std::vector<cinn_pod_value_t>> args_cached_;
+  // The slot in the scope of each input and then output of each function.
+  std::vector<std::vector<int>> arg_slots_;
+  // The feeds of the current run by the slots, and the arguments prepared with them.
+  const std::vector<const cinn_pod_value_t*>* slot2podargs_{};
+  std::vector<std::vector<cinn_pod_value_t>> fed_args_;
+  // The position among the arguments and the dim of the buffer each leading scalar of each function is filled from.
+  std::vector<std::vector<std::pair<int, int>>> dim_args_;
+  // The external buffers bound to the arguments.
+  absl::flat_hash_map<std::string, cinn_buffer_t*> bound_args_;
 
-  std::vector<lower_func_ptr_t> fn_{};
+  // The functions may be swapped while running, and a deque keeps the atomics in place.
+  std::deque<std::atomic<lower_func_ptr_t>> fn_{};
   std::vector<std::string> fn_names_;
+  std::vector<KernelCost> fn_costs_;
+  // The grid dims followed by the block dims of the kernel of each function, empty to call its host function.
+  std::vector<std::vector<int>> launch_dims_;
+
+  void* stream_{};
+  // The global variables holding the streams the kernels of fn_ launch on, set in SetStream.
+  std::vector<void**> stream_slots_;
+
+  Profiler* profiler_{};
+  std::map<std::string, std::string> profile_args_;
+
+  int64_t summary_runs_{0};
+
+  std::vector<std::string> op_names_;
+  std::vector<std::string> node_ids_;
+  common::PrecisionMode precision_mode_{common::DefaultPrecisionMode()};
+  // The name of the NVTX range, built on the first run with --cinn_nvtx.
+  std::string nvtx_name_;
+
+#ifdef CINN_WITH_CUDNN
+  std::unique_ptr<runtime::cuda::CudaLibraryCall> library_call_;
+  bool library_call_resolved_{false};
+  bool library_call_selected_{false};
+  // The kernel launches resolved on the first run, and whether each is bound to the cached arguments of its function,
+  // which stay in place until they are rebuilt, unlike the fed ones.
+  std::vector<std::unique_ptr<runtime::cuda::KernelLaunch>> kernel_launches_;
+  std::vector<bool> launch_bound_;
+#endif
+  std::unique_ptr<runtime::MultiTensorOptimizer> optimizer_;
+  std::unique_ptr<runtime::BlockSparseMatmul> sparse_matmul_;
 };
 
 }  // namespace framework
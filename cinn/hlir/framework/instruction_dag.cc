@@ -0,0 +1,142 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/instruction_dag.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+
+struct AccessSet {
+  std::set<std::string> reads;
+  std::set<std::string> writes;
+};
+
+// The memory range [begin, end) of a variable, or an empty range if it is not allocated.
+std::pair<uintptr_t, uintptr_t> MemoryRange(const Scope* scope, const std::string& name) {
+  if (!scope) return {0, 0};
+  auto* var = scope->FindVar(name);
+  if (!var || !absl::holds_alternative<Tensor>(*var)) return {0, 0};
+  auto& tensor = absl::get<Tensor>(*var);
+  auto* buffer = tensor->buffer();
+  if (!buffer || !buffer->memory) return {0, 0};
+  auto begin = reinterpret_cast<uintptr_t>(buffer->memory);
+  return {begin, begin + buffer->memory_size};
+}
+
+}  // namespace
+
+InstructionDAG::InstructionDAG(const std::vector<Instruction*>& instrs, const Scope* scope) {
+  std::vector<AccessSet> accesses(instrs.size());
+  std::map<std::string, std::pair<uintptr_t, uintptr_t>> ranges;
+  for (int i = 0; i < instrs.size(); i++) {
+    for (auto& args : instrs[i]->GetInArgs()) accesses[i].reads.insert(args.begin(), args.end());
+    for (auto& args : instrs[i]->GetOutArgs()) accesses[i].writes.insert(args.begin(), args.end());
+    for (auto* names : {&accesses[i].reads, &accesses[i].writes}) {
+      for (auto& name : *names) {
+        if (!ranges.count(name)) ranges[name] = MemoryRange(scope, name);
+      }
+    }
+  }
+
+  auto alias = [&](const std::string& a, const std::string& b) {
+    if (a == b) return true;
+    auto& x = ranges[a];
+    auto& y = ranges[b];
+    return x.first < x.second && y.first < y.second && x.first < y.second && y.first < x.second;
+  };
+  auto intersect = [&](const std::set<std::string>& a, const std::set<std::string>& b) {
+    for (auto& x : a) {
+      for (auto& y : b) {
+        if (alias(x, y)) return true;
+      }
+    }
+    return false;
+  };
+
+  predecessors_.resize(instrs.size());
+  successors_.resize(instrs.size());
+  for (int i = 0; i < instrs.size(); i++) {
+    for (int j = 0; j < i; j++) {
+      bool depend = intersect(accesses[j].writes, accesses[i].reads) ||
+                    intersect(accesses[j].writes, accesses[i].writes) ||
+                    intersect(accesses[j].reads, accesses[i].writes);
+      if (!depend) continue;
+      predecessors_[i].push_back(j);
+      successors_[j].push_back(i);
+    }
+  }
+}
+
+StreamAssignment InstructionDAG::AssignStreams(int num_streams,
+                                               const std::vector<bool>& pinned,
+                                               const std::vector<bool>& communication) const {
+  CHECK_GT(num_streams, 0);
+  CHECK(pinned.empty() || pinned.size() == size());
+  CHECK(communication.empty() || (communication.size() == size() && num_streams > 1));
+  // The computation only takes the streams before the communication one.
+  int num_compute_streams = communication.empty() ? num_streams : num_streams - 1;
+  StreamAssignment res;
+  res.stream_of.resize(size());
+  res.waits.resize(size());
+  res.record_event.resize(size(), false);
+
+  // The last instruction put on each stream.
+  std::vector<int> tail(num_streams, -1);
+  // synced[s][t]: the last instruction on stream t which is known to be finished before the work later put on s.
+  std::vector<std::vector<int>> synced(num_streams, std::vector<int>(num_streams, -1));
+  for (int i = 0; i < size(); i++) {
+    int stream = -1;
+    if (!communication.empty() && communication[i]) {
+      stream = num_streams - 1;
+    } else if (!pinned.empty() && pinned[i]) {
+      stream = 0;
+    } else {
+      for (auto it = predecessors_[i].rbegin(); it != predecessors_[i].rend(); ++it) {
+        if (res.stream_of[*it] < num_compute_streams && tail[res.stream_of[*it]] == *it) {
+          stream = res.stream_of[*it];
+          break;
+        }
+      }
+      if (stream < 0) stream = std::min_element(tail.begin(), tail.begin() + num_compute_streams) - tail.begin();
+    }
+
+    // Only wait for the last predecessor on each of the other streams, the earlier ones finish before it.
+    std::vector<int> last_pred(num_streams, -1);
+    for (int p : predecessors_[i]) {
+      int s        = res.stream_of[p];
+      last_pred[s] = std::max(last_pred[s], p);
+    }
+    for (int s = 0; s < num_streams; s++) {
+      if (s == stream || last_pred[s] < 0 || last_pred[s] <= synced[stream][s]) continue;
+      res.waits[i].push_back(last_pred[s]);
+      res.record_event[last_pred[s]] = true;
+      synced[stream][s]              = last_pred[s];
+    }
+    res.stream_of[i] = stream;
+    tail[stream]     = i;
+  }
+  return res;
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
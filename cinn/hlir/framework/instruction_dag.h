@@ -0,0 +1,80 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "cinn/hlir/framework/instruction.h"
+#include "cinn/hlir/framework/scope.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * The assignment of the instructions to a pool of streams, the instructions on the same stream run in order, and the
+ * dependencies across streams are kept by recording an event after an instruction and waiting for it on another
+ * stream.
+ */
+struct StreamAssignment {
+  //! The stream index of each instruction.
+  std::vector<int> stream_of;
+  //! The instructions whose events should be waited for before launching each instruction.
+  std::vector<std::vector<int>> waits;
+  //! Whether an event should be recorded after each instruction.
+  std::vector<bool> record_event;
+};
+
+/**
+ * InstructionDAG holds the dependencies between the instructions of a program, which are sorted in the execution
+ * order. An instruction depends on an earlier one if they access the same variable and at least one of them writes
+ * it(read-after-write, write-after-read and write-after-write).
+ *
+ * Variables are also regarded as the same one if their memory overlaps, e.g. the intermediate variables sharing a
+ * memory arena, so the \p scope should be instantiated before building the DAG if it is given.
+ */
+class InstructionDAG {
+ public:
+  InstructionDAG(const std::vector<Instruction*>& instrs, const Scope* scope = nullptr);
+
+  size_t size() const { return predecessors_.size(); }
+
+  //! The indice of the instructions that the \p i-th instruction depends on, in ascending order.
+  const std::vector<int>& predecessors(int i) const { return predecessors_[i]; }
+
+  //! The indice of the instructions depending on the \p i-th instruction, in ascending order.
+  const std::vector<int>& successors(int i) const { return successors_[i]; }
+
+  /**
+   * Assign the instructions to \p num_streams streams. An instruction continues the stream of its predecessor if it
+   * is the last one on that stream, or else takes the least recently used stream, so that the independent chains of
+   * instructions are spread over the streams.
+   * @param pinned The instructions to be always put on the first stream, e.g. the ones sharing a global library handle.
+   * @param communication The instructions communicating across the ranks. If given, the last stream is reserved for
+   * them so that they overlap with the computation on the others.
+   */
+  StreamAssignment AssignStreams(int num_streams,
+                                 const std::vector<bool>& pinned        = {},
+                                 const std::vector<bool>& communication = {}) const;
+
+ private:
+  std::vector<std::vector<int>> predecessors_;
+  std::vector<std::vector<int>> successors_;
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,106 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/instruction_dag.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+TEST(InstructionDAG, dependencies) {
+  Scope scope;
+  auto target = common::DefaultHostTarget();
+  // 0: a -> b, 1: a -> c, 2: b,c -> d, 3: d -> a(write after read of 0 and 1)
+  std::vector<std::unique_ptr<Instruction>> instrs;
+  instrs.emplace_back(new Instruction(target, &scope, {"a"}, {"b"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"a"}, {"c"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"b", "c"}, {"d"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"d"}, {"a"}));
+  std::vector<Instruction*> instr_ptrs;
+  for (auto& instr : instrs) instr_ptrs.push_back(instr.get());
+
+  InstructionDAG dag(instr_ptrs);
+  ASSERT_TRUE(dag.predecessors(0).empty());
+  ASSERT_TRUE(dag.predecessors(1).empty());
+  ASSERT_EQ(dag.predecessors(2), std::vector<int>({0, 1}));
+  ASSERT_EQ(dag.predecessors(3), std::vector<int>({0, 1, 2}));
+  ASSERT_EQ(dag.successors(0), std::vector<int>({2, 3}));
+}
+
+TEST(InstructionDAG, shared_memory) {
+  Scope scope;
+  auto target = common::DefaultHostTarget();
+  for (auto& name : std::vector<std::string>({"a", "b", "c", "d"})) {
+    auto* var    = scope.Var<Tensor>(name);
+    auto& tensor = absl::get<Tensor>(*var);
+    tensor->Resize(Shape{{16}});
+  }
+  std::vector<float> memory(16);
+  scope.GetTensor("b")->share_external_data<float>(reinterpret_cast<uint8_t*>(memory.data()), target);
+  scope.GetTensor("d")->share_external_data<float>(reinterpret_cast<uint8_t*>(memory.data()), target);
+  // b and d share memory, so the two independent instructions conflict.
+  std::vector<std::unique_ptr<Instruction>> instrs;
+  instrs.emplace_back(new Instruction(target, &scope, {"a"}, {"b"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"c"}, {"d"}));
+  std::vector<Instruction*> instr_ptrs;
+  for (auto& instr : instrs) instr_ptrs.push_back(instr.get());
+
+  ASSERT_TRUE(InstructionDAG(instr_ptrs).predecessors(1).empty());
+  ASSERT_EQ(InstructionDAG(instr_ptrs, &scope).predecessors(1), std::vector<int>({0}));
+}
+
+TEST(InstructionDAG, assign_streams) {
+  Scope scope;
+  auto target = common::DefaultNVGPUTarget();
+  // two independent chains joined at the end: 0 -> 2, 1 -> 3, 2,3 -> 4
+  std::vector<std::unique_ptr<Instruction>> instrs;
+  instrs.emplace_back(new Instruction(target, &scope, {"a"}, {"b"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"c"}, {"d"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"b"}, {"e"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"d"}, {"f"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"e", "f"}, {"g"}));
+  std::vector<Instruction*> instr_ptrs;
+  for (auto& instr : instrs) instr_ptrs.push_back(instr.get());
+
+  InstructionDAG dag(instr_ptrs);
+  auto res = dag.AssignStreams(2);
+  ASSERT_EQ(res.stream_of, std::vector<int>({0, 1, 0, 1, 1}));
+  ASSERT_EQ(res.waits[4], std::vector<int>({2}));
+  ASSERT_EQ(res.record_event, std::vector<bool>({false, false, true, false, false}));
+  for (int i = 0; i < 4; i++) ASSERT_TRUE(res.waits[i].empty());
+
+  // all the instructions on one stream need no event.
+  res = dag.AssignStreams(1);
+  ASSERT_EQ(res.stream_of, std::vector<int>(5, 0));
+  ASSERT_EQ(res.record_event, std::vector<bool>(5, false));
+
+  // the pinned instructions are put on the first stream.
+  res = dag.AssignStreams(2, {false, true, false, true, false});
+  ASSERT_EQ(res.stream_of[1], 0);
+  ASSERT_EQ(res.stream_of[3], 0);
+
+  // the communication runs on the last stream, which the others do not continue.
+  res = dag.AssignStreams(3, {}, {false, false, true, false, false});
+  ASSERT_EQ(res.stream_of, std::vector<int>({0, 1, 2, 1, 1}));
+  ASSERT_EQ(res.waits[4], std::vector<int>({2}));
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
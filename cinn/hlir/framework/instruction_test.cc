@@ -153,6 +153,44 @@ TEST(Instruction, RunWithRawPodArgs) {
   check_equal_by_element();
 }
 
+TEST(Instruction, SymbolicDims) {
+  Var m("m");
+  Expr n(20);
+  Placeholder<float> x("x", {Expr(m), n});
+  Placeholder<float> y("y", {Expr(m), n});
+  auto z = Compute(
+      {Expr(m), n}, [=](Expr i, Expr j) { return x(i, j) + y(i, j); }, "z");
+  auto stages = CreateStages({z});
+  auto fn     = Lower("fn", stages, {x, y, z});
+  // the symbolic dim is taken as the leading scalar, and it is the first dim of x
+  ASSERT_TRUE(fn->args[0].is_var());
+  auto sources = fn->GetDimArgSources();
+  ASSERT_EQ(sources.size(), 1UL);
+  ASSERT_EQ(fn->args[sources[0].arg].name(), "_x");
+  ASSERT_EQ(sources[0].dim, 0);
+
+  ir::Module::Builder builder("some_module", common::DefaultHostTarget());
+  builder.AddFunction(fn);
+  auto jit = backends::SimpleJIT::Create();
+  jit->Link(builder.Build());
+  auto fn_addr = jit->Lookup("fn");
+  CHECK(fn_addr);
+
+  Scope scope;
+  Instruction instr(common::DefaultHostTarget(), &scope, {"x", "y"}, {"z"});
+  instr.SetLoweredFunc(reinterpret_cast<lower_func_ptr_t>(fn_addr));
+  instr.SetDimArgs(0, {{"x", 0}});
+  // one function runs on the different batches, the dims are read from the buffers in each run
+  for (int M : {10, 3, 16}) {
+    InstantiateScope(M, 20, &scope);
+    instr.Run();
+    auto* xd = scope.GetTensor("x")->data<float>();
+    auto* yd = scope.GetTensor("y")->data<float>();
+    auto* zd = scope.GetTensor("z")->data<float>();
+    for (int i = 0; i < M * 20; i++) ASSERT_NEAR(xd[i] + yd[i], zd[i], 1e-5);
+  }
+}
+
 #ifdef CINN_WITH_CUDNN
 
 class TestInstruction : public Instruction {
@@ -428,6 +466,46 @@ TEST(Instruction, CONV_BACKWARD_FILTER) {
   CUDA_CALL(cudaFree(dev_y));
 }
 
+TEST(Instruction, MATMUL_STRIDED_BATCHED) {
+  // x[batch, M, K] * y[K, N]^T broadcast to the batch
+  int batch   = 4, M = 32, N = 48, K = 64;
+  float alpha = 0.5f;
+
+  auto buffer_x   = common::BufferBuilder(Float(32), {batch, M, K}).set_random().Build();
+  auto buffer_y   = common::BufferBuilder(Float(32), {1, N, K}).set_random().Build();
+  auto buffer_out = common::BufferBuilder(Float(32), {batch, M, N}).set_zero().Build();
+
+  CUDA_CALL(cudaSetDevice(0));
+  std::vector<cinn_buffer_t> dev_buffers(3);
+  std::vector<cinn_buffer_t*> host_buffers = {buffer_x, buffer_y, buffer_out};
+  for (int i = 0; i < 3; i++) {
+    dev_buffers[i].memory_size = host_buffers[i]->memory_size;
+    CUDA_CALL(cudaMalloc(reinterpret_cast<void**>(&dev_buffers[i].memory), host_buffers[i]->memory_size));
+    CUDA_CALL(cudaMemcpy(
+        dev_buffers[i].memory, host_buffers[i]->memory, host_buffers[i]->memory_size, cudaMemcpyHostToDevice));
+  }
+
+  runtime::cuda::CublasMatmul matmul({batch, 1, M, N, K, 0, 1}, alpha);
+  auto& handles = runtime::cuda::LibraryHandles::Get(nullptr);
+  matmul.Run({cinn_pod_value_t(&dev_buffers[0]), cinn_pod_value_t(&dev_buffers[1]), cinn_pod_value_t(&dev_buffers[2])},
+             &handles);
+  std::vector<float> out(batch * M * N);
+  CUDA_CALL(cudaMemcpy(out.data(), dev_buffers[2].memory, out.size() * sizeof(float), cudaMemcpyDeviceToHost));
+
+  auto* x = reinterpret_cast<float*>(buffer_x->memory);
+  auto* y = reinterpret_cast<float*>(buffer_y->memory);
+  for (int b = 0; b < batch; b++) {
+    for (int i = 0; i < M; i++) {
+      for (int j = 0; j < N; j++) {
+        float expected = 0.f;
+        for (int k = 0; k < K; k++) expected += x[(b * M + i) * K + k] * y[j * K + k];
+        ASSERT_NEAR(out[(b * M + i) * N + j], alpha * expected, 1e-3);
+      }
+    }
+  }
+  for (auto& buffer : dev_buffers) CUDA_CALL(cudaFree(buffer.memory));
+}
+
 #endif
 }  // namespace framework
 }  // namespace hlir
@@ -14,13 +14,54 @@
 
 #include "cinn/hlir/framework/memory.h"
 
+#include <gflags/gflags.h>
+#include <sys/mman.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>  // NOLINT
+#include <utility>
+
+#include "cinn/backends/compilation_cache.h"
+#include "cinn/hlir/framework/caching_allocator.h"
+#include "cinn/runtime/cinn_runtime.h"
+#include "cinn/runtime/cpu/thread_backend.h"
+
 #ifdef CINN_WITH_CUDA
 #include <cuda.h>
 #include <cuda_runtime.h>
 
 #include "cinn/backends/cuda_util.h"
+#include "cinn/runtime/cuda/cuda_util.h"
 #endif
 
+DEFINE_bool(cinn_use_caching_allocator,
+            false,
+            "Whether to cache the freed memory and reuse it for the later allocations of X86 and NVGPU.");
+DEFINE_bool(cinn_cpu_first_touch,
+            false,
+            "Whether to touch the large host allocations first by the threads running the kernels, so that their pages "
+            "are placed on the NUMA nodes of the threads.");
+DEFINE_string(cinn_cpu_huge_pages,
+              "",
+              "How the host allocations of at least 2MB, e.g. the memory arenas and the large parameters, are backed "
+              "by the huge pages to reduce the TLB misses, 'transparent' to advise the transparent huge pages, "
+              "'explicit' to map the huge pages reserved by /proc/sys/vm/nr_hugepages, which falls back to the "
+              "transparent ones when there are not enough, empty for the regular pages.");
+DEFINE_bool(cinn_use_cuda_malloc_async,
+            false,
+            "Whether to allocate the NVGPU memory by cudaMallocAsync from the stream-ordered memory pools of the "
+            "devices, which needs CUDA 11.2 or later. It takes precedence over --cinn_use_caching_allocator on NVGPU.");
+DEFINE_int64(cinn_cuda_mempool_release_threshold,
+             -1,
+             "The bytes of the freed memory the pool of --cinn_use_cuda_malloc_async keeps across the synchronizations "
+             "instead of releasing it to the system, -1 to keep all.");
+
 namespace cinn {
 namespace hlir {
 namespace framework {
@@ -29,14 +70,84 @@ using common::Target;
 
 namespace {
 
+size_t RoundUp(size_t nbytes, size_t alignment) { return (nbytes + alignment - 1) / alignment * alignment; }
+
+//! The host memory aligned to CINN_BUFFER_ALIGNMENT at least, and backed by the huge pages of --cinn_cpu_huge_pages.
 class X86MemoryMng : public MemoryInterface {
  public:
-  void* malloc(size_t nbytes) override { return ::malloc(nbytes); }
+  X86MemoryMng() {
+    CHECK(FLAGS_cinn_cpu_huge_pages.empty() || FLAGS_cinn_cpu_huge_pages == "transparent" ||
+          FLAGS_cinn_cpu_huge_pages == "explicit")
+        << "Invalid --cinn_cpu_huge_pages=" << FLAGS_cinn_cpu_huge_pages
+        << ", which should be transparent, explicit or empty";
+  }
+
+  void* malloc(size_t nbytes) override { return aligned_alloc(CINN_BUFFER_ALIGNMENT, nbytes); }
   void free(void* data) override {
     if (!data) return;
+    if (!FLAGS_cinn_cpu_huge_pages.empty()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = mapped_.find(data);
+      if (it != mapped_.end()) {
+        munmap(data, it->second);
+        mapped_.erase(it);
+        return;
+      }
+    }
     ::free(data);
   }
-  void* aligned_alloc(size_t alignment, size_t nbytes) override { return ::aligned_alloc(alignment, nbytes); }
+  void* aligned_alloc(size_t alignment, size_t nbytes) override {
+    alignment  = std::max<size_t>(alignment, CINN_BUFFER_ALIGNMENT);
+    void* data = nullptr;
+    if (!FLAGS_cinn_cpu_huge_pages.empty() && nbytes >= kHugePageBytes && alignment <= kHugePageBytes) {
+      data = HugePageAlloc(nbytes);
+    }
+    // the size of aligned_alloc is a multiple of the alignment
+    if (!data) data = ::aligned_alloc(alignment, RoundUp(std::max<size_t>(nbytes, 1), alignment));
+    return FirstTouch(data, nbytes);
+  }
+  // The free memory of the heap is returned to the OS by glibc, which doesn't tell how much.
+  size_t ReleaseCache() override {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+    return 0;
+  }
+
+ private:
+  // The small allocations are likely served by the pages touched already.
+  static constexpr size_t kFirstTouchBytes = 1 << 20;
+  // The size of the huge pages of X86.
+  static constexpr size_t kHugePageBytes = 2 << 20;
+
+  void* HugePageAlloc(size_t nbytes) {
+    size_t size = RoundUp(nbytes, kHugePageBytes);
+    if (FLAGS_cinn_cpu_huge_pages == "explicit") {
+      void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (data != MAP_FAILED) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        mapped_[data] = size;
+        return data;
+      }
+      LOG_FIRST_N(WARNING, 1) << "Failed to map " << size << " bytes of the huge pages reserved, fall back to the "
+                              << "transparent huge pages";
+    }
+    void* data = ::aligned_alloc(kHugePageBytes, size);
+    if (data && madvise(data, size, MADV_HUGEPAGE) != 0) {
+      LOG_FIRST_N(WARNING, 1) << "The transparent huge pages are not enabled, see "
+                              << "/sys/kernel/mm/transparent_hugepage/enabled";
+    }
+    return data;
+  }
+
+  // The sizes of the memory mapped from the huge pages reserved.
+  std::mutex mutex_;
+  std::map<void*, size_t> mapped_;
+
+  static void* FirstTouch(void* data, size_t nbytes) {
+    if (FLAGS_cinn_cpu_first_touch && data && nbytes >= kFirstTouchBytes) cinn_backend_first_touch(data, nbytes);
+    return data;
+  }
 };
 
 #ifdef CINN_WITH_CUDA
@@ -51,16 +162,252 @@ class CudaMemoryMng : public MemoryInterface {
   void free(void* data) override { CUDA_CALL(cudaFree(data)); }
 };
 
+class CudaPinnedMemoryMng : public MemoryInterface {
+ public:
+  void* malloc(size_t nbytes) override {
+    void* data;
+    CUDA_CALL(cudaHostAlloc(&data, nbytes, cudaHostAllocDefault));
+    return data;
+  }
+
+  void free(void* data) override { CUDA_CALL(cudaFreeHost(data)); }
+};
+
+#if CUDART_VERSION >= 11020
+/**
+ * The stream-ordered allocator by cudaMallocAsync from the default memory pools of the devices. The memory is
+ * allocated and freed in the order of the work on the stream it is used on, so the memory freed on a stream is reused
+ * by the later work on it without synchronizing, and by the other streams once the driver sees the dependencies, e.g.
+ * the events between the streams and in the CUDA graphs. The memory freed without a stream is ordered on the default
+ * stream, so the non-blocking streams using it should be synchronized before.
+ */
+class CudaAsyncMemoryMng : public MemoryInterface {
+ public:
+  CudaAsyncMemoryMng() {
+    int num_devices = 0;
+    CUDA_CALL(cudaGetDeviceCount(&num_devices));
+    int64_t flag       = FLAGS_cinn_cuda_mempool_release_threshold;
+    uint64_t threshold = flag < 0 ? UINT64_MAX : flag;
+    for (int i = 0; i < num_devices; i++) {
+      int supported = 0;
+      CUDA_CALL(cudaDeviceGetAttribute(&supported, cudaDevAttrMemoryPoolsSupported, i));
+      CHECK(supported) << "The device " << i << " doesn't support cudaMallocAsync";
+      cudaMemPool_t pool;
+      CUDA_CALL(cudaDeviceGetDefaultMemPool(&pool, i));
+      CUDA_CALL(cudaMemPoolSetAttribute(pool, cudaMemPoolAttrReleaseThreshold, &threshold));
+    }
+  }
+
+  void* malloc(size_t nbytes) override { return stream_malloc(nbytes, nullptr); }
+  void free(void* data) override { stream_free(data, nullptr); }
+
+  void* stream_malloc(size_t nbytes, void* stream) override {
+    void* data;
+    CUDA_CALL(cudaMallocAsync(&data, nbytes, static_cast<cudaStream_t>(stream)));
+    return data;
+  }
+
+  void stream_free(void* data, void* stream) override {
+    if (!data) return;
+    CUDA_CALL(cudaFreeAsync(data, static_cast<cudaStream_t>(stream)));
+  }
+
+  // Trim the pools of the devices to the memory in use, the memory whose frees are still queued on the streams stays.
+  size_t ReleaseCache() override {
+    int num_devices = 0;
+    CUDA_CALL(cudaGetDeviceCount(&num_devices));
+    size_t released = 0;
+    for (int i = 0; i < num_devices; i++) {
+      cudaMemPool_t pool;
+      CUDA_CALL(cudaDeviceGetDefaultMemPool(&pool, i));
+      uint64_t reserved = 0, trimmed = 0;
+      CUDA_CALL(cudaMemPoolGetAttribute(pool, cudaMemPoolAttrReservedMemCurrent, &reserved));
+      CUDA_CALL(cudaMemPoolTrimTo(pool, 0));
+      CUDA_CALL(cudaMemPoolGetAttribute(pool, cudaMemPoolAttrReservedMemCurrent, &trimmed));
+      released += reserved - trimmed;
+    }
+    return released;
+  }
+};
+#endif
+
+/**
+ * The caching allocators of the devices. The memory is allocated from the allocator of the current device and freed
+ * to the one of the device it is on, so that the blocks cached on a device are never handed out on another one.
+ */
+class DeviceCachingAllocator : public MemoryInterface {
+ public:
+  void* malloc(size_t nbytes) override { return Malloc(nbytes, nullptr); }
+  void* aligned_alloc(size_t alignment, size_t nbytes) override {
+    return Get(CurrentDevice())->aligned_alloc(alignment, nbytes);
+  }
+  void* stream_malloc(size_t nbytes, void* stream) override {
+    return Malloc(nbytes, static_cast<cudaStream_t>(stream));
+  }
+
+  void free(void* data) override {
+    if (!data) return;
+    int device = 0;
+    if (num_devices_.load(std::memory_order_acquire) > 1) {
+      cudaPointerAttributes attrs;
+      CUDA_CALL(cudaPointerGetAttributes(&attrs, data));
+      device = attrs.device;
+    } else {
+      device = first_device_;
+    }
+    Get(device)->free(data);
+  }
+
+  void* Malloc(size_t nbytes, cudaStream_t stream) { return Get(CurrentDevice())->Malloc(nbytes, stream); }
+
+  size_t ReleaseCache() override {
+    size_t released = 0;
+    for (auto& allocator : allocators_) {
+      auto* device_allocator = allocator.load(std::memory_order_acquire);
+      if (device_allocator) released += device_allocator->ReleaseCache();
+    }
+    return released;
+  }
+
+  ~DeviceCachingAllocator() {
+    for (auto& allocator : allocators_) delete allocator.load();
+  }
+
+ private:
+  static int CurrentDevice() {
+    int device = 0;
+    CUDA_CALL(cudaGetDevice(&device));
+    return device;
+  }
+
+  CachingAllocator* Get(int device) {
+    CHECK_LT(device, runtime::cuda::kCUDAMaxCards);
+    auto* allocator = allocators_[device].load(std::memory_order_acquire);
+    if (allocator) return allocator;
+    std::lock_guard<std::mutex> lock(mutex_);
+    allocator = allocators_[device].load(std::memory_order_relaxed);
+    if (!allocator) {
+      allocator = new CachingAllocator(new CudaMemoryMng);
+      if (num_devices_.load(std::memory_order_relaxed) == 0) first_device_ = device;
+      allocators_[device].store(allocator, std::memory_order_release);
+      num_devices_.fetch_add(1, std::memory_order_release);
+    }
+    return allocator;
+  }
+
+  std::atomic<CachingAllocator*> allocators_[runtime::cuda::kCUDAMaxCards]{};
+  // The number of the devices used, the memory is freed without querying its device if there is only one.
+  std::atomic<int> num_devices_{0};
+  int first_device_{0};
+  std::mutex mutex_;
+};
+
 #endif
 
 }  // namespace
 
 MemoryManager::MemoryManager() {
   Register(Target::Arch::Unk, new X86MemoryMng);
-  Register(Target::Arch::X86, new X86MemoryMng);
+  // the ARM CPUs allocate the host memory the same as X86
+  for (auto arch : {Target::Arch::X86, Target::Arch::ARM}) {
+    if (FLAGS_cinn_use_caching_allocator) {
+      Register(arch, new CachingAllocator(new X86MemoryMng));
+    } else {
+      Register(arch, new X86MemoryMng);
+    }
+  }
+#ifdef CINN_WITH_CUDA
+  if (FLAGS_cinn_use_cuda_malloc_async) {
+#if CUDART_VERSION >= 11020
+    // The workspaces of the library calls keep being allocated by cudaMalloc, as they are freed without their streams.
+    Register(Target::Arch::NVGPU, new CudaAsyncMemoryMng);
+#else
+    LOG(FATAL) << "--cinn_use_cuda_malloc_async needs CUDA 11.2 or later";
+#endif
+  } else if (FLAGS_cinn_use_caching_allocator) {
+    auto* allocator = new DeviceCachingAllocator;
+    Register(Target::Arch::NVGPU, allocator);
+    // The workspaces of the cuDNN and cuBLAS calls are reused from the cache on their streams.
+    runtime::cuda::LibraryHandles::SetWorkSpaceAllocator(
+        [allocator](size_t nbytes, cudaStream_t stream) { return allocator->Malloc(nbytes, stream); },
+        [allocator](void* data) { allocator->free(data); });
+  } else {
+    Register(Target::Arch::NVGPU, new CudaMemoryMng);
+  }
+  // cudaHostAlloc is much more expensive than malloc, so the pinned memory is always cached.
+  pinned_host_mng_.reset(new CachingAllocator(new CudaPinnedMemoryMng));
+#else
+  pinned_host_mng_.reset(new X86MemoryMng);
+#endif
+}
+
+size_t MemoryManager::ReleaseCache() {
+  size_t released = 0;
 #ifdef CINN_WITH_CUDA
-  Register(Target::Arch::NVGPU, new CudaMemoryMng);
+  // The workspaces freed to the caching allocator are counted when its segments are returned below.
+  size_t workspace_bytes = runtime::cuda::LibraryHandles::TotalWorkSpaceSize();
+  runtime::cuda::LibraryHandles::ReleaseWorkSpaces();
+  if (FLAGS_cinn_use_cuda_malloc_async || !FLAGS_cinn_use_caching_allocator) released += workspace_bytes;
 #endif
+  for (auto& item : memory_mngs_) released += item.second->ReleaseCache();
+  released += pinned_host_mng_->ReleaseCache();
+  released += backends::CompilationCache::MemoryBytes();
+  backends::CompilationCache::ClearMemory();
+  VLOG(3) << "Release " << released << " bytes of the memory cached";
+  return released;
+}
+
+int MemoryManager::AddReleaser(releaser_t releaser) {
+  std::lock_guard<std::mutex> lock(releaser_mutex_);
+  int id          = next_releaser_id_++;
+  releasers_[id] = std::move(releaser);
+  return id;
+}
+
+void MemoryManager::RemoveReleaser(int id) {
+  std::lock_guard<std::mutex> lock(releaser_mutex_);
+  releasers_.erase(id);
+}
+
+size_t MemoryManager::ReleaseIdle(int64_t idle_us) {
+  size_t released = 0;
+  bool has_users  = false;
+  {
+    // the releasers are called under the lock, so that RemoveReleaser keeps their users alive till they return
+    std::lock_guard<std::mutex> lock(releaser_mutex_);
+    has_users = !releasers_.empty();
+    for (auto& item : releasers_) released += item.second(idle_us);
+  }
+  // The caches are kept while all the users are busy, who would fill them again right away.
+  if (released > 0 || !has_users) released += ReleaseCache();
+  if (released > 0) VLOG(3) << "Release " << released << " bytes of the memory idle for " << idle_us << " us";
+  return released;
+}
+
+void MemoryManager::StartIdleRelease(int64_t idle_us, int64_t interval_us) {
+  CHECK_GT(interval_us, 0) << "The interval of the idle release should be positive";
+  StopIdleRelease();
+  auto loop = [this, idle_us, interval_us] {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    auto stopped = [this] { return stop_idle_release_; };
+    while (!idle_cond_.wait_for(lock, std::chrono::microseconds(interval_us), stopped)) {
+      lock.unlock();
+      ReleaseIdle(idle_us);
+      lock.lock();
+    }
+  };
+  stop_idle_release_ = false;
+  idle_thread_       = std::thread(loop);
+}
+
+void MemoryManager::StopIdleRelease() {
+  if (!idle_thread_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    stop_idle_release_ = true;
+  }
+  idle_cond_.notify_all();
+  idle_thread_.join();
 }
 
 }  // namespace framework
@@ -15,13 +15,24 @@
 #pragma once
 
 #include <absl/container/flat_hash_map.h>
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 
 #include "cinn/common/macros.h"
 #include "cinn/common/target.h"
 
+DECLARE_bool(cinn_use_caching_allocator);
+DECLARE_bool(cinn_cpu_first_touch);
+DECLARE_bool(cinn_use_cuda_malloc_async);
+DECLARE_int64(cinn_cuda_mempool_release_threshold);
+
 namespace cinn {
 namespace hlir {
 namespace framework {
@@ -31,6 +42,12 @@ class MemoryInterface {
   virtual void* malloc(size_t nbytes) = 0;
   virtual void free(void* data)       = 0;
   virtual void* aligned_alloc(size_t alignment, size_t nbytes) { return nullptr; }
+  //! Allocate the memory used on \p stream, the stream-ordered allocators order the allocation after its work.
+  virtual void* stream_malloc(size_t nbytes, void* stream) { return malloc(nbytes); }
+  //! Free the memory used on \p stream, the stream-ordered allocators free it after the work queued on it.
+  virtual void stream_free(void* data, void* stream) { free(data); }
+  //! Return the memory cached but not used to the OS or the driver, return the bytes released if known.
+  virtual size_t ReleaseCache() { return 0; }
   virtual ~MemoryInterface() {}
 };
 
@@ -64,10 +81,54 @@ class MemoryManager final {
     return item;
   }
 
+  //! The MemoryInterface of the page-locked host memory, it falls back to the pageable host memory without CUDA.
+  MemoryInterface* RetrievePinnedHost() { return pinned_host_mng_.get(); }
+
+  /**
+   * Return the memory cached by the process to the OS or the driver: the free blocks of the caching allocators, the
+   * pools of cudaMallocAsync, the workspaces of the cuDNN and cuBLAS calls and the compiled code kept in the memory by
+   * CompilationCache. The memory in use is kept, and the caches fill again on the later allocations.
+   * @return The bytes released, as far as the allocators tell.
+   */
+  size_t ReleaseCache();
+
+  //! Release the memory of a user idle for at least \p idle_us microseconds, return the bytes released.
+  using releaser_t = std::function<size_t(int64_t idle_us)>;
+
+  //! Add \p releaser called by ReleaseIdle, e.g. by Program::EnableIdleTrim, return the id to remove it by.
+  int AddReleaser(releaser_t releaser);
+  //! Remove the releaser of \p id, which waits for the ReleaseIdle calling it.
+  void RemoveReleaser(int id);
+
+  /**
+   * Let the users idle for at least \p idle_us microseconds release their memory, e.g. the intermediates of the
+   * programs trimmed, then release the caches by ReleaseCache, so that the memory flows to the busy models on a host
+   * serving several of them. The memory is allocated again once the users run.
+   * @return The bytes released.
+   */
+  size_t ReleaseIdle(int64_t idle_us);
+
+  /**
+   * Call ReleaseIdle(\p idle_us) every \p interval_us microseconds on a background thread until StopIdleRelease, the
+   * thread running already is restarted with the new timeout.
+   */
+  void StartIdleRelease(int64_t idle_us, int64_t interval_us);
+  void StopIdleRelease();
+
  private:
   MemoryManager();
 
   absl::flat_hash_map<common::Target::Arch, std::unique_ptr<MemoryInterface>> memory_mngs_;
+  std::unique_ptr<MemoryInterface> pinned_host_mng_;
+
+  std::mutex releaser_mutex_;
+  std::map<int, releaser_t> releasers_;
+  int next_releaser_id_{0};
+
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cond_;
+  bool stop_idle_release_{false};
+  std::thread idle_thread_;
 
   CINN_DISALLOW_COPY_AND_ASSIGN(MemoryManager);
 };
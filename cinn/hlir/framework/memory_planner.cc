@@ -0,0 +1,146 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/memory_planner.h"
+
+#include <algorithm>
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+uint32_t MemoryPlanner::Plan(const std::vector<Instruction*>& instrs) {
+  blocks_.clear();
+  block_index_.clear();
+  arena_size_  = 0;
+  origin_size_ = 0;
+
+  // The lifetime is measured in instructions, while whether a variable is an input is decided with the finer
+  // granularity of the functions inside an instruction, so that the temporary variables passed between the functions
+  // of one instruction can be planned too.
+  // The variables sharing memory in place and the slices are regarded as the one they map to.
+  auto block_name = [&](const std::string& name) -> const std::string& {
+    auto it = inplace_vars_.find(name);
+    if (it != inplace_vars_.end()) return it->second;
+    auto slice = slice_vars_.find(name);
+    return slice == slice_vars_.end() ? name : slice->second;
+  };
+  absl::flat_hash_map<std::string, int> def_instr, last_instr, def_step, first_use_step;
+  std::unordered_set<std::string> used_vars;
+  std::vector<std::string> var_order;
+  int step = 0;
+  for (int t = 0; t < instrs.size(); t++) {
+    auto in_args  = instrs[t]->GetInArgs();
+    auto out_args = instrs[t]->GetOutArgs();
+    CHECK_EQ(in_args.size(), out_args.size());
+    for (int i = 0; i < in_args.size(); i++, step++) {
+      for (auto& arg : in_args[i]) {
+        used_vars.insert(arg);
+        auto& name = block_name(arg);
+        if (!first_use_step.count(name)) first_use_step[name] = step;
+        if (!last_instr.count(name)) var_order.push_back(name);
+        last_instr[name] = t;
+      }
+      for (auto& arg : out_args[i]) {
+        auto& name = block_name(arg);
+        if (!def_step.count(name)) {
+          def_step[name]  = step;
+          def_instr[name] = t;
+        }
+        if (!last_instr.count(name)) var_order.push_back(name);
+        last_instr[name] = t;
+      }
+    }
+  }
+
+  // A block is not planned if any variable sharing it is reserved or an output of the program.
+  std::unordered_set<std::string> unplanned_blocks;
+  for (auto& item : inplace_vars_) {
+    if (reserved_vars_.count(item.first) || !used_vars.count(item.first)) unplanned_blocks.insert(item.second);
+  }
+
+  for (auto& name : var_order) {
+    if (!def_step.count(name) || reserved_vars_.count(name) || unplanned_blocks.count(name)) continue;
+    // used before defined, it holds some value from outside.
+    if (first_use_step.count(name) && first_use_step[name] < def_step[name]) continue;
+    // never used after defined, it is an output of the program.
+    if (!first_use_step.count(name)) continue;
+    auto* var = scope_->FindVar(name);
+    if (!var) continue;
+    auto& tensor = absl::get<Tensor>(*var);
+    if (tensor->shape().numel() == 0) continue;
+
+    MemoryBlock block;
+    block.name     = name;
+    block.size     = AlignedSize(tensor->num_bytes());
+    block.def      = def_instr[name];
+    block.last_use = last_instr[name];
+
+    block_index_[name] = blocks_.size();
+    blocks_.push_back(block);
+    origin_size_ += block.size;
+  }
+
+  // Greedy by size: place the larger blocks first, each at the lowest offset which doesn't overlap the placed blocks
+  // whose lifetime intersect with it.
+  std::vector<int> order(blocks_.size());
+  for (int i = 0; i < order.size(); i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return blocks_[a].size > blocks_[b].size; });
+
+  std::vector<int> placed;
+  for (int idx : order) {
+    auto& block = blocks_[idx];
+    std::vector<int> conflicts;
+    for (int p : placed) {
+      if (blocks_[p].LifetimeOverlap(block)) conflicts.push_back(p);
+    }
+    std::sort(conflicts.begin(), conflicts.end(), [&](int a, int b) { return blocks_[a].offset < blocks_[b].offset; });
+    uint32_t offset = 0;
+    for (int c : conflicts) {
+      auto& other = blocks_[c];
+      if (offset + block.size <= other.offset) break;
+      offset = std::max(offset, other.offset + other.size);
+    }
+    block.offset = offset;
+    arena_size_  = std::max(arena_size_, offset + block.size);
+    placed.push_back(idx);
+  }
+
+  VLOG(3) << "MemoryPlanner planned " << blocks_.size() << " variables, arena size: " << arena_size_
+          << " bytes, origin size: " << origin_size_ << " bytes";
+  return arena_size_;
+}
+
+std::shared_ptr<Buffer> MemoryPlanner::Apply() {
+  auto arena = std::make_shared<Buffer>(target_);
+  if (arena_size_ == 0) return arena;
+  if (target_ == common::DefaultHostTarget()) {
+    arena->Resize(kAlignment, arena_size_);
+  } else {
+    arena->Resize(arena_size_);
+  }
+  auto* memory = arena->data()->memory;
+  CHECK(memory) << "Failed to allocate memory arena of " << arena_size_ << " bytes";
+  for (auto& block : blocks_) {
+    auto tensor = scope_->GetTensor(block.name);
+    VLOG(4) << "Tensor [" << block.name << "] uses arena memory [" << block.offset << ", "
+            << block.offset + block.size << ")";
+    tensor->share_external_data(memory + block.offset, target_);
+  }
+  return arena;
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
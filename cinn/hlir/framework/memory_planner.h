@@ -0,0 +1,120 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cinn/common/target.h"
+#include "cinn/hlir/framework/buffer.h"
+#include "cinn/hlir/framework/instruction.h"
+#include "cinn/hlir/framework/scope.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * The lifetime of an intermediate variable, measured in the index of the instructions that define and last use it.
+ */
+struct MemoryBlock {
+  std::string name;
+  uint32_t size{};
+  int def{-1};
+  int last_use{-1};
+  uint32_t offset{};
+
+  bool LifetimeOverlap(const MemoryBlock& other) const { return def <= other.last_use && other.def <= last_use; }
+};
+
+/**
+ * MemoryPlanner performs a liveness analysis on the instructions of a program, and assigns the intermediate variables
+ * whose lifetime are disjoint to the shared offsets of a single memory arena.
+ *
+ * The inputs(variables that no instruction produces), the outputs of pre-run instructions and the \p reserved_vars
+ * (e.g. the variables to fetch) keep their own memory, so are the variables never used after defined, they are
+ * regarded as the outputs of the program.
+ */
+class MemoryPlanner {
+ public:
+  //! Align the offsets to fit the aligned allocation of host tensors.
+  static constexpr uint32_t kAlignment = 1024;
+
+  MemoryPlanner(const Target& target, Scope* scope, const std::unordered_set<std::string>& reserved_vars = {})
+      : target_(target), scope_(scope), reserved_vars_(reserved_vars) {}
+
+  /**
+   * Let each variable in \p inplace_vars share the memory of the variable it maps to, e.g. the outputs written in
+   * place of the inputs. They are planned as one block whose lifetime covers all of them, and only the block is bound
+   * to the arena by Apply, the others should share its buffer. The block is not planned if any of them is not.
+   */
+  void SetInplaceVars(const absl::flat_hash_map<std::string, std::string>& inplace_vars) {
+    inplace_vars_ = inplace_vars;
+  }
+
+  /**
+   * Let each variable in \p slice_vars refer to a range of the memory of the variable it maps to, e.g. the inputs of
+   * the concats written into the outputs. They are planned in the block of the variable like SetInplaceVars, but the
+   * slices never read by the instructions are not regarded as the outputs, since they are read through the block.
+   */
+  void SetSliceVars(const absl::flat_hash_map<std::string, std::string>& slice_vars) { slice_vars_ = slice_vars; }
+
+  /**
+   * Analyze the lifetime of the variables used by \p instrs, which are sorted in the execution order, and assign each
+   * planned variable an offset in the arena.
+   * @return The number of bytes of the arena.
+   */
+  uint32_t Plan(const std::vector<Instruction*>& instrs);
+
+  /**
+   * Allocate the arena and bind the memory of all the planned variables to it.
+   * @return The buffer holding the arena, which should be kept alive as long as the variables are used.
+   */
+  std::shared_ptr<Buffer> Apply();
+
+  //! Get the planned blocks.
+  const std::vector<MemoryBlock>& blocks() const { return blocks_; }
+
+  //! Tell whether a variable is assigned to the arena.
+  bool IsPlanned(const std::string& name) const { return block_index_.count(name); }
+
+  //! The number of bytes of the arena.
+  uint32_t arena_size() const { return arena_size_; }
+
+  //! The number of bytes needed if each planned variable has its own memory.
+  uint32_t origin_size() const { return origin_size_; }
+
+ private:
+  uint32_t AlignedSize(uint32_t size) const { return (size + kAlignment - 1) / kAlignment * kAlignment; }
+
+  Target target_;
+  Scope* scope_{};
+  std::unordered_set<std::string> reserved_vars_;
+  absl::flat_hash_map<std::string, std::string> inplace_vars_;
+  absl::flat_hash_map<std::string, std::string> slice_vars_;
+
+  std::vector<MemoryBlock> blocks_;
+  absl::flat_hash_map<std::string, int> block_index_;
+  uint32_t arena_size_{};
+  uint32_t origin_size_{};
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
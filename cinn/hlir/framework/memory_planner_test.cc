@@ -0,0 +1,86 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/memory_planner.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+TEST(MemoryPlanner, chain) {
+  Scope scope;
+  for (auto& name : std::vector<std::string>({"a", "b", "c", "d", "e"})) {
+    auto* var    = scope.Var<Tensor>(name);
+    auto& tensor = absl::get<Tensor>(*var);
+    tensor->Resize(Shape{{16, 16}});
+  }
+  auto target = common::DefaultHostTarget();
+  // a -> b -> c -> d -> e
+  std::vector<std::unique_ptr<Instruction>> instrs;
+  instrs.emplace_back(new Instruction(target, &scope, {"a"}, {"b"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"b"}, {"c"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"c"}, {"d"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"d"}, {"e"}));
+  std::vector<Instruction*> instr_ptrs;
+  for (auto& instr : instrs) instr_ptrs.push_back(instr.get());
+
+  MemoryPlanner planner(target, &scope);
+  planner.Plan(instr_ptrs);
+  // the input a and the output e are not planned.
+  ASSERT_FALSE(planner.IsPlanned("a"));
+  ASSERT_FALSE(planner.IsPlanned("e"));
+  ASSERT_EQ(planner.blocks().size(), 3UL);
+  ASSERT_EQ(planner.origin_size(), 3 * 16 * 16 * sizeof(float));
+  // b and d have disjoint lifetime and share the same memory.
+  ASSERT_EQ(planner.arena_size(), 2 * 16 * 16 * sizeof(float));
+
+  auto arena = planner.Apply();
+  ASSERT_EQ(scope.GetTensor("b")->data<float>(), scope.GetTensor("d")->data<float>());
+  ASSERT_NE(scope.GetTensor("b")->data<float>(), scope.GetTensor("c")->data<float>());
+}
+
+TEST(MemoryPlanner, reserved_vars) {
+  Scope scope;
+  for (auto& name : std::vector<std::string>({"a", "b", "c", "d", "e"})) {
+    auto* var    = scope.Var<Tensor>(name);
+    auto& tensor = absl::get<Tensor>(*var);
+    tensor->Resize(Shape{{16, 16}});
+  }
+  auto target = common::DefaultHostTarget();
+  std::vector<std::unique_ptr<Instruction>> instrs;
+  instrs.emplace_back(new Instruction(target, &scope, {"a"}, {"b"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"b"}, {"c"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"c"}, {"d"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"d"}, {"e"}));
+  std::vector<Instruction*> instr_ptrs;
+  for (auto& instr : instrs) instr_ptrs.push_back(instr.get());
+
+  MemoryPlanner planner(target, &scope, {"b"});
+  planner.Plan(instr_ptrs);
+  ASSERT_FALSE(planner.IsPlanned("b"));
+  ASSERT_TRUE(planner.IsPlanned("c"));
+  ASSERT_TRUE(planner.IsPlanned("d"));
+  // c and d are alive at the same time.
+  ASSERT_EQ(planner.arena_size(), planner.origin_size());
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -170,6 +170,11 @@ NodeData* InsertGraphOpNodeBefore(
   return input_node_out;
 }
 
+int GetIntAttr(const Node* node, const std::string& name, int default_value) {
+  auto& attr_store = node->attrs.attr_store;
+  return attr_store.count(name) ? absl::get<int>(attr_store.at(name)) : default_value;
+}
+
 }  // namespace framework
 }  // namespace hlir
 }  // namespace cinn
@@ -197,6 +197,9 @@ NodeData *InsertGraphOpNodeAfter(
 NodeData *InsertGraphOpNodeBefore(
     common::Graph *graph, Node *insert_node, Node *input_node, NodeData *dst_data, int pos);
 
+//! Get the int attribute \p name of \p node, or \p default_value if it is not set.
+int GetIntAttr(const Node *node, const std::string &name, int default_value);
+
 }  // namespace framework
 }  // namespace hlir
 }  // namespace cinn
@@ -0,0 +1,65 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/numa_replicas.h"
+
+#include <thread>
+
+#include "cinn/runtime/cpu/thread_backend.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+// The node the thread is bound to by NumaReplicas, to bind it only once.
+thread_local int t_numa_node = -1;
+
+void BindCurrentThread(int numa_node) {
+  if (numa_node < 0 || t_numa_node == numa_node) return;
+  CHECK_EQ(cinn_bind_thread_to_numa_node(numa_node), 0) << "Failed to bind the thread to NUMA node " << numa_node;
+  t_numa_node = numa_node;
+}
+}  // namespace
+
+NumaReplicas::NumaReplicas(const Program& program,
+                           const std::vector<std::string>& param_vars,
+                           const std::vector<int>& numa_nodes)
+    : numa_nodes_(numa_nodes) {
+  if (numa_nodes_.empty()) {
+    for (int node = 0; node < cinn_num_numa_nodes(); node++) numa_nodes_.push_back(node);
+    if (numa_nodes_.empty()) numa_nodes_.push_back(-1);
+  }
+  std::vector<std::string> copied_vars = param_vars;
+  copied_vars.insert(copied_vars.end(), program.prepacked_vars().begin(), program.prepacked_vars().end());
+
+  replicas_.resize(numa_nodes_.size());
+  for (int i = 0; i < numa_nodes_.size(); i++) {
+    // The memory of the replica is allocated and touched first on its node.
+    std::thread([&, i] {
+      BindCurrentThread(numa_nodes_[i]);
+      replicas_[i] = program.Clone({}, copied_vars);
+    }).join();
+    VLOG(3) << "Replicate the program on NUMA node " << numa_nodes_[i];
+  }
+}
+
+void NumaReplicas::Execute(int i, const std::map<std::string, cinn_pod_value_t>* name2podargs) {
+  BindCurrentThread(numa_nodes_.at(i));
+  replicas_[i]->Execute(name2podargs);
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
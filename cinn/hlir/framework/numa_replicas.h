@@ -0,0 +1,73 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cinn/common/macros.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * NumaReplicas runs one replica of a CPU program on each NUMA node, e.g. on each socket of a dual-socket host, so that
+ * the kernels only access the memory local to their node. Each replica is cloned by a thread bound to its node, so
+ * its variables, including its own copy of the parameters, are placed on the node by the first touch, and it is
+ * executed by the threads bound to the node, whose kernels run on the workers pinned to the cores of the node.
+ *
+ * A typical usage, with one serving thread or more for each replica:
+ *
+ *   NumaReplicas replicas(*program, {"conv_weight", "fc_weight"});
+ *   // on a serving thread of replica i
+ *   replicas.replica(i)->BindInput("x", input);
+ *   replicas.Execute(i);
+ */
+class NumaReplicas {
+ public:
+  /**
+   * Constructor.
+   * @param program The program to replicate, with the variables instantiated.
+   * @param param_vars The variables whose data are copied to each replica, e.g. the parameters. The prepacked
+   * variables are always copied, and the others only get their own memory.
+   * @param numa_nodes The nodes to place the replicas on, all the nodes by default. If the NUMA topology is unknown,
+   * a single replica is created without binding.
+   */
+  NumaReplicas(const Program& program,
+               const std::vector<std::string>& param_vars,
+               const std::vector<int>& numa_nodes = {});
+
+  int size() const { return replicas_.size(); }
+  Program* replica(int i) { return replicas_.at(i).get(); }
+  //! The node of replica \p i, -1 if it is not bound.
+  int numa_node(int i) const { return numa_nodes_.at(i); }
+
+  //! Execute replica \p i on the calling thread, the thread is bound to the node of the replica first.
+  void Execute(int i, const std::map<std::string, cinn_pod_value_t>* name2podargs = nullptr);
+
+ private:
+  std::vector<int> numa_nodes_;
+  std::vector<std::unique_ptr<Program>> replicas_;
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(NumaReplicas);
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
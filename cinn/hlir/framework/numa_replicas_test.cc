@@ -0,0 +1,87 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/numa_replicas.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+#include "cinn/runtime/cpu/thread_backend.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+TEST(NumaReplicas, execute) {
+  frontend::Program prog;
+  frontend::Variable a("A");
+  frontend::Variable b("B");
+  Type t   = Float(32);
+  a->shape = {100, 32};
+  b->shape = {100, 32};
+  a->type  = t;
+  b->type  = t;
+  auto c   = prog.add(a, b);
+  auto d   = prog.add(c, b);
+  Target target(Target::OS::Linux, Target::Arch::X86, Target::Bit::k64, {});
+
+  auto g = std::make_shared<Graph>(prog, target);
+  ApplyPass(g.get(), "InferShape");
+  auto scope = BuildScope(target, g);
+  GraphCompiler gc(target, scope, g);
+  GraphCompiler::CompileOptions options;
+  options.with_instantiate_variables = true;
+  auto&& program                     = gc.Build(options).runtime_program;
+  auto* b_data                       = scope->GetTensor("B")->mutable_data<float>(target);
+  std::fill(b_data, b_data + 100 * 32, 2.f);
+
+  NumaReplicas replicas(*program, {"B"});
+  ASSERT_EQ(replicas.size(), std::max(cinn_num_numa_nodes(), 1));
+  // the parameter is copied to each replica, so it is not affected by the origin any more
+  std::fill(b_data, b_data + 100 * 32, 0.f);
+
+  std::vector<Tensor> inputs, outputs;
+  for (int i = 0; i < replicas.size(); i++) {
+    Tensor input, output;
+    for (auto* tensor : {&input, &output}) {
+      (*tensor)->Resize(Shape{{100, 32}});
+      std::fill_n((*tensor)->mutable_data<float>(target), 100 * 32, i);
+    }
+    replicas.replica(i)->BindInput("A", input->buffer());
+    replicas.replica(i)->BindOutput(d->id, output->buffer());
+    inputs.push_back(input);
+    outputs.push_back(output);
+  }
+  std::vector<std::thread> threads;
+  for (int i = 0; i < replicas.size(); i++) {
+    threads.emplace_back([&, i] { replicas.Execute(i); });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (int i = 0; i < replicas.size(); i++) {
+    for (int j = 0; j < 100 * 32; j++) {
+      ASSERT_NEAR(outputs[i]->data<float>()[j], i + 2 * 2.f, 1e-5);
+    }
+  }
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
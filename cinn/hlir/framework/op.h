@@ -178,8 +178,11 @@ class Operator {
   friend class Registry<Operator>;
   uint32_t index{0};
   Operator() { index = OpRegistry::Global()->op_counter++; }
+  // The attribute maps may be created by GetAttrs while compiling, so they are looked up under the lock too.
   static const absl::any* GetAttrMap(const std::string& key) {
-    auto& dict = OpRegistry::Global()->attrs;
+    OpRegistry* reg = OpRegistry::Global();
+    std::lock_guard<std::recursive_mutex> lock(reg->mutex);
+    auto& dict = reg->attrs;
     auto it    = dict.find(key);
     if (it != dict.end()) {
       return it->second.get();
@@ -190,7 +193,7 @@ class Operator {
   //! update the attribute OpValueType
   static void UpdateAttrMap(const std::string& key, std::function<void(absl::any*)> updater) {
     OpRegistry* reg = OpRegistry::Global();
-    std::lock_guard<std::recursive_mutex>(reg->mutex);
+    std::lock_guard<std::recursive_mutex> lock(reg->mutex);
     std::unique_ptr<absl::any>& value = reg->attrs[key];
     if (value.get() == nullptr) value.reset(new absl::any());
     if (updater != nullptr) updater(value.get());
@@ -0,0 +1,76 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/parallel_executor.h"
+
+#include "cinn/runtime/cpu/thread_backend.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+ParallelExecutor::ParallelExecutor(const std::vector<Instruction*>& instrs,
+                                   const Scope* scope,
+                                   int inter_op_threads,
+                                   int intra_op_threads)
+    : instrs_(instrs), dag_(instrs, scope), intra_op_threads_(intra_op_threads), pending_(instrs.size()) {
+  CHECK_GT(inter_op_threads, 0);
+  pool_.reset(new utils::ThreadPool(inter_op_threads));
+}
+
+void ParallelExecutor::Run(const std::map<std::string, cinn_pod_value_t>* name2podargs, int priority) {
+  if (instrs_.empty()) return;
+  tenant_       = Tenant::Current();
+  priority_     = priority;
+  num_finished_ = 0;
+  for (int i = 0; i < instrs_.size(); i++) {
+    pending_[i] = dag_.predecessors(i).size();
+  }
+  for (int i = 0; i < instrs_.size(); i++) {
+    if (dag_.predecessors(i).empty()) {
+      pool_->Schedule([this, i, name2podargs] { RunInstruction(i, name2podargs); });
+    }
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  finished_cond_.wait(lock, [this] { return num_finished_ == instrs_.size(); });
+}
+
+void ParallelExecutor::RunInstruction(int i, const std::map<std::string, cinn_pod_value_t>* name2podargs) {
+  TenantScope tenant_scope(tenant_);
+  // the workers are owned by the executor, so the cap is kept on them
+  cinn_set_thread_max_concurrency(intra_op_threads_);
+  cinn_set_thread_launch_priority(priority_);
+  while (i >= 0) {
+    instrs_[i]->Run(name2podargs);
+    // Continue with one of the ready successors on this thread to save a round trip through the pool.
+    int next = -1;
+    for (int s : dag_.successors(i)) {
+      if (--pending_[s] != 0) continue;
+      if (next < 0) {
+        next = s;
+      } else {
+        pool_->Schedule([this, s, name2podargs] { RunInstruction(s, name2podargs); });
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (++num_finished_ == instrs_.size()) finished_cond_.notify_all();
+    }
+    i = next;
+  }
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
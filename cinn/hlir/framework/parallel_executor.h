@@ -0,0 +1,84 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "cinn/common/macros.h"
+#include "cinn/hlir/framework/instruction.h"
+#include "cinn/hlir/framework/instruction_dag.h"
+#include "cinn/hlir/framework/resource_manager.h"
+#include "cinn/hlir/framework/scope.h"
+#include "cinn/utils/thread_pool.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * ParallelExecutor runs the instructions of a CPU program on a pool of worker threads, each instruction is scheduled
+ * as soon as all the instructions it depends on finish, so that the independent instructions in the wide regions of
+ * the graph run concurrently(inter-op parallelism), while each kernel parallelizes itself over \p intra_op_threads
+ * threads by cinn_backend_parallel_launch(intra-op parallelism).
+ */
+class ParallelExecutor {
+ public:
+  /**
+   * Constructor.
+   * @param instrs The instructions sorted in the execution order.
+   * @param scope The scope with the variables instantiated, used to find the variables sharing memory.
+   * @param inter_op_threads The number of instructions to run concurrently.
+   * @param intra_op_threads The number of threads each kernel runs on, 0 to keep the default. It only applies to the
+   *        kernels of the workers, and the kernels of a tenant are capped by its thread budget too.
+   */
+  ParallelExecutor(const std::vector<Instruction*>& instrs,
+                   const Scope* scope,
+                   int inter_op_threads,
+                   int intra_op_threads = 0);
+
+  /**
+   * Run all the instructions and wait for them to finish, as the tenant of the calling thread if any. The parallel
+   * kernels of the workers are launched at \p priority, see cinn_set_thread_launch_priority.
+   */
+  void Run(const std::map<std::string, cinn_pod_value_t>* name2podargs = nullptr, int priority = 0);
+
+ private:
+  void RunInstruction(int i, const std::map<std::string, cinn_pod_value_t>* name2podargs);
+
+  std::vector<Instruction*> instrs_;
+  InstructionDAG dag_;
+  int intra_op_threads_;
+  // The tenant of the current run, installed on the workers.
+  std::shared_ptr<Tenant> tenant_;
+  int priority_{0};
+  std::unique_ptr<utils::ThreadPool> pool_;
+  // The number of the unfinished predecessors of each instruction in the current run.
+  std::vector<std::atomic<int>> pending_;
+  int num_finished_{};
+  std::mutex mutex_;
+  std::condition_variable finished_cond_;
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(ParallelExecutor);
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,69 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/parallel_executor.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+std::atomic<int> g_clock{0};
+int g_finish_time[4];
+
+template <int I>
+void RecordFinish(void* args, int32_t num_args) {
+  g_finish_time[I] = g_clock++;
+}
+
+TEST(ParallelExecutor, diamond) {
+  Scope scope;
+  for (auto& name : std::vector<std::string>({"a", "b", "c", "d", "e"})) {
+    auto* var    = scope.Var<Tensor>(name);
+    auto& tensor = absl::get<Tensor>(*var);
+    tensor->Resize(Shape{{4}});
+  }
+  auto target = common::DefaultHostTarget();
+  // 0: a -> b, 1: b -> c, 2: b -> d, 3: c,d -> e
+  std::vector<std::unique_ptr<Instruction>> instrs;
+  instrs.emplace_back(new Instruction(target, &scope, {"a"}, {"b"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"b"}, {"c"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"b"}, {"d"}));
+  instrs.emplace_back(new Instruction(target, &scope, {"c", "d"}, {"e"}));
+  instrs[0]->SetLoweredFunc(&RecordFinish<0>);
+  instrs[1]->SetLoweredFunc(&RecordFinish<1>);
+  instrs[2]->SetLoweredFunc(&RecordFinish<2>);
+  instrs[3]->SetLoweredFunc(&RecordFinish<3>);
+  std::vector<Instruction*> instr_ptrs;
+  for (auto& instr : instrs) instr_ptrs.push_back(instr.get());
+
+  ParallelExecutor executor(instr_ptrs, &scope, 4);
+  for (int i = 0; i < 10; i++) {
+    g_clock = 0;
+    executor.Run();
+    ASSERT_EQ(g_clock.load(), 4);
+    ASSERT_EQ(g_finish_time[0], 0);
+    ASSERT_EQ(g_finish_time[3], 3);
+  }
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
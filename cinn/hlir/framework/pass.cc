@@ -15,6 +15,7 @@
 #include "cinn/hlir/framework/pass.h"
 
 #include "cinn/hlir/pass/use_pass.h"
+#include "cinn/utils/compile_tracer.h"
 
 namespace cinn {
 namespace hlir {
@@ -36,6 +37,7 @@ void ApplyPasses(Graph* g, const std::vector<std::string>& passes) {
         CHECK(!pass_dep) << "And the attribute is provided by pass [" << pass_dep->name << "].";
       }
     }
+    utils::CompileStageTimer timer("pass:" + r->name);
     r->body(g);
   }
 }
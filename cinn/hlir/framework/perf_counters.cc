@@ -0,0 +1,106 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/perf_counters.h"
+
+#include <glog/logging.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+DEFINE_bool(cinn_profile_perf_counters,
+            false,
+            "Whether the profiler samples the hardware performance counters around the kernels on X86, by the Linux "
+            "perf_event.");
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+PerfCounters& PerfCounters::ThreadLocal() {
+  thread_local PerfCounters counters;
+  return counters;
+}
+
+PerfCounters::PerfCounters() {
+#ifdef __linux__
+  Open("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  if (!available()) {
+    static std::atomic<bool> warned{false};
+    if (!warned.exchange(true)) {
+      LOG(WARNING) << "Failed to open the perf_event counters: " << std::strerror(errno)
+                   << ", check /proc/sys/kernel/perf_event_paranoid";
+    }
+    return;
+  }
+  Open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+  Open("llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  // FP_ARITH_INST_RETIRED with the umasks of all the packed widths, 128, 256 and 512 bits of single and double
+  if (__builtin_cpu_is("intel")) Open("fp_packed_instructions", PERF_TYPE_RAW, 0xFCC7);
+#endif
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+  for (int fd : fds_) close(fd);
+#endif
+}
+
+void PerfCounters::Open(const std::string& name, uint32_t type, uint64_t config) {
+#ifdef __linux__
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size           = sizeof(attr);
+  attr.type           = type;
+  attr.config         = config;
+  attr.read_format    = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+  // count the calling thread on any CPU
+  int fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader_, 0);
+  if (fd < 0) {
+    VLOG(3) << "The perf_event counter " << name << " is not supported: " << std::strerror(errno);
+    return;
+  }
+  if (leader_ < 0) leader_ = fd;
+  fds_.push_back(fd);
+  names_.push_back(name);
+#endif
+}
+
+std::vector<uint64_t> PerfCounters::Read() const {
+  if (!available()) return {};
+#ifdef __linux__
+  // the group is read as the number of the counters followed by their values
+  std::vector<uint64_t> buffer(names_.size() + 1);
+  auto size = read(leader_, buffer.data(), buffer.size() * sizeof(uint64_t));
+  if (size < static_cast<ssize_t>(buffer.size() * sizeof(uint64_t)) || buffer[0] != names_.size()) return {};
+  return std::vector<uint64_t>(buffer.begin() + 1, buffer.end());
+#else
+  return {};
+#endif
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
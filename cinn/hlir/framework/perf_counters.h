@@ -0,0 +1,66 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <gflags/gflags.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+DECLARE_bool(cinn_profile_perf_counters);
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * The hardware performance counters of the calling thread by the Linux perf_event, which are the cycles, the
+ * instructions, the last level cache misses and, on Intel, the packed floating point instructions retired. They are
+ * opened as a group so that they are scheduled on the PMU together.
+ *
+ * Only the calling thread is counted, so the work of a kernel parallelized to the other threads is not included.
+ */
+class PerfCounters {
+ public:
+  //! Get the counters of the calling thread, they are opened on the first call of the thread.
+  static PerfCounters& ThreadLocal();
+
+  ~PerfCounters();
+
+  //! Whether the counters are opened, they are not on other systems or if perf_event_paranoid disallows it.
+  bool available() const { return leader_ >= 0; }
+
+  //! The names of the counters, in the order of the values of Read.
+  const std::vector<std::string>& names() const { return names_; }
+
+  //! Read the current values of the counters, empty if not available.
+  std::vector<uint64_t> Read() const;
+
+ private:
+  PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  void Open(const std::string& name, uint32_t type, uint64_t config);
+
+  int leader_{-1};
+  std::vector<int> fds_;
+  std::vector<std::string> names_;
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,397 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/pipeline.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
+
+#include "cinn/hlir/framework/pass.h"
+
+#ifdef CINN_WITH_CUDA
+#include <cuda_runtime.h>
+
+#include <thread>
+
+#include "cinn/backends/cuda_util.h"
+#include "cinn/runtime/cuda/cuda_util.h"
+#endif
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+double Numel(const shape_t& shape) {
+  return std::accumulate(shape.begin(), shape.end(), 1., std::multiplies<double>());
+}
+}  // namespace
+
+double EstimateNodeFlops(const Node* node, const absl::flat_hash_map<std::string, shape_t>& shape_dict) {
+  std::vector<const shape_t*> inputs, outputs;
+  for (auto& link : node->inlinks_in_order()) inputs.push_back(&shape_dict.at(link->source()->id()));
+  for (auto& link : node->outlinks_in_order()) outputs.push_back(&shape_dict.at(link->sink()->id()));
+  if (outputs.empty()) return 0.;
+  auto& name = node->op()->name;
+  // the number of the products summed up by each element of the output
+  double k = 0.;
+  if (!inputs.empty() && (name == "mul" || name == "block_sparse_mul" || name == "weight_only_mul" ||
+                          name == "quantized_mul")) {
+    auto& x            = *inputs[0];
+    int x_num_col_dims = std::min<int>(GetIntAttr(node, "x_num_col_dims", 1), x.size());
+    k                  = Numel(shape_t(x.begin() + x_num_col_dims, x.end()));
+  } else if (!inputs.empty() && !inputs[0]->empty() && name == "matmul") {
+    auto& x      = *inputs[0];
+    auto& attrs  = node->attrs.attr_store;
+    bool trans_a = attrs.count("trans_a") && absl::get<bool>(attrs.at("trans_a"));
+    k            = trans_a && x.size() > 1 ? x[x.size() - 2] : x.back();
+  } else if (inputs.size() > 1 && !inputs[1]->empty() && (name == "conv2d" || name == "depthwise_conv2d")) {
+    // the weight is [O, C / groups, kh, kw] or its OHWI layout
+    auto& w = *inputs[1];
+    k       = Numel(w) / w[0];
+  }
+  if (k > 0.) return 2. * Numel(*outputs[0]) * k;
+  double res = 0.;
+  for (auto* shape : outputs) res += Numel(*shape);
+  return res;
+}
+
+PipelinePartition PartitionPipeline(Graph* graph, int num_stages, double flops_per_byte) {
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  auto& dtype_dict = graph->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  std::vector<Node*> nodes;
+  for (auto* graph_node : std::get<0>(graph->topological_order())) {
+    auto* node = graph_node->safe_as<Node>();
+    if (node) nodes.push_back(node);
+  }
+  int n = nodes.size();
+  CHECK_GT(num_stages, 0) << "The graph should be cut into at least 1 stage";
+  CHECK_LE(num_stages, n) << "The graph of " << n << " ops can't be cut into " << num_stages << " stages";
+  absl::flat_hash_map<const Node*, int> position;
+  for (int i = 0; i < n; i++) position[nodes[i]] = i;
+  std::vector<double> prefix_flops(n + 1, 0.);
+  for (int i = 0; i < n; i++) prefix_flops[i + 1] = prefix_flops[i] + EstimateNodeFlops(nodes[i], shape_dict);
+
+  // The activations are live across the cuts from after their producers to their last readers, cut i is before node
+  // i, and the bytes live across each cut are summed up by their differences.
+  struct Activation {
+    std::string name;
+    int producer;
+    int last_reader;
+    double bytes;
+  };
+  std::vector<Activation> activations;
+  std::vector<double> cut_bytes(n + 2, 0.);
+  for (int i = 0; i < n; i++) {
+    for (auto& link : nodes[i]->outlinks_in_order()) {
+      auto* var = link->sink()->safe_as<NodeData>();
+      int last  = i;
+      for (auto& out : var->outlinks()) last = std::max(last, position.at(out->sink()->safe_as<Node>()));
+      if (last == i) continue;
+      double bytes = Numel(shape_dict.at(var->id())) * ((dtype_dict.at(var->id()).bits() + 7) / 8);
+      activations.push_back({var->id(), i, last, bytes});
+      cut_bytes[i + 1] += bytes;
+      cut_bytes[last + 1] -= bytes;
+    }
+  }
+  for (int i = 1; i <= n; i++) cut_bytes[i] += cut_bytes[i - 1];
+
+  // cost[k][i] is the min cost of the slowest stage when the first i nodes are cut into k stages, and the last of
+  // them starts at node split[k][i].
+  const double inf = std::numeric_limits<double>::infinity();
+  std::vector<std::vector<double>> cost(num_stages + 1, std::vector<double>(n + 1, inf));
+  std::vector<std::vector<int>> split(num_stages + 1, std::vector<int>(n + 1, 0));
+  cost[0][0] = 0.;
+  for (int k = 1; k <= num_stages; k++) {
+    for (int i = k; i <= n - (num_stages - k); i++) {
+      double send = i < n ? flops_per_byte * cut_bytes[i] : 0.;
+      for (int j = k - 1; j < i; j++) {
+        if (cost[k - 1][j] == inf) continue;
+        double stage_cost = std::max(cost[k - 1][j], prefix_flops[i] - prefix_flops[j] + send);
+        if (stage_cost < cost[k][i]) {
+          cost[k][i]  = stage_cost;
+          split[k][i] = j;
+        }
+      }
+    }
+  }
+
+  std::vector<int> begins(num_stages + 1, n);
+  for (int k = num_stages; k > 0; k--) begins[k - 1] = split[k][begins[k]];
+  std::vector<int> stage_of(n);
+  PipelinePartition res;
+  res.stages.resize(num_stages);
+  res.flops.resize(num_stages);
+  res.sends.resize(num_stages);
+  res.send_bytes.resize(num_stages, 0.);
+  for (int k = 0; k < num_stages; k++) {
+    res.stages[k].assign(nodes.begin() + begins[k], nodes.begin() + begins[k + 1]);
+    res.flops[k] = prefix_flops[begins[k + 1]] - prefix_flops[begins[k]];
+    for (int i = begins[k]; i < begins[k + 1]; i++) stage_of[i] = k;
+  }
+  // the activations read by a later stage than the next are passed through the stages between
+  for (auto& activation : activations) {
+    for (int k = stage_of[activation.producer]; k < stage_of[activation.last_reader]; k++) {
+      res.sends[k].push_back(activation.name);
+      res.send_bytes[k] += activation.bytes;
+    }
+  }
+  for (int k = 0; k < num_stages; k++) {
+    VLOG(3) << "Pipeline stage " << k << " has " << res.stages[k].size() << " ops of " << res.flops[k]
+            << " FLOPs, and sends " << res.sends[k].size() << " activations of " << res.send_bytes[k] << " bytes";
+  }
+  return res;
+}
+
+#ifdef CINN_WITH_CUDA
+PipelineExecutor::PipelineExecutor(const frontend::Program& program,
+                                   const std::vector<std::string>& fetch_vars,
+                                   const Options& options) {
+  Graph graph(program, common::DefaultNVGPUTarget());
+  ApplyPass(&graph, "InferShape");
+  partition_ = PartitionPipeline(&graph, options.num_stages, options.flops_per_byte);
+  // the nodes of the graph are named by their op types and the indices of their instructions
+  absl::flat_hash_map<std::string, int> node_stages;
+  for (int i = 0; i < partition_.stages.size(); i++) {
+    for (auto* node : partition_.stages[i]) node_stages[node->id()] = i;
+  }
+  std::vector<int> instr_stages(program.size());
+  for (int j = 0; j < program.size(); j++) {
+    instr_stages[j] = node_stages.at(program[j]->op_type + "_" + std::to_string(j));
+  }
+
+  std::vector<int> devices = options.devices;
+  if (devices.empty()) {
+    int num_devices = 0;
+    CUDA_CALL(cudaGetDeviceCount(&num_devices));
+    for (int device = 0; device < num_devices; device++) devices.push_back(device);
+  }
+  CHECK(!devices.empty()) << "No available devices";
+  stages_.resize(options.num_stages);
+  for (int i = 0; i < stages_.size(); i++) {
+    stages_[i].device = devices[i % devices.size()];
+    CHECK_LT(stages_[i].device, runtime::cuda::kCUDAMaxCards);
+  }
+  produced_.resize(stages_.size());
+  consumed_.resize(stages_.size());
+  for (int i = 0; i < stages_.size(); i++) {
+    // The stages are compiled one by one, each with its memory allocated on the current device of the thread.
+    std::thread([&, i] {
+      runtime::cuda::SetCurrentDevice(stages_[i].device);
+      BuildStage(i, program, instr_stages, fetch_vars, options, &graph);
+      CUDA_CALL(cudaDeviceSynchronize());
+    }).join();
+    VLOG(3) << "Build the pipeline stage " << i << " on device " << stages_[i].device;
+  }
+  pool_.reset(new utils::ThreadPool(stages_.size()));
+}
+
+PipelineExecutor::~PipelineExecutor() {
+  if (!pool_) return;
+  ForEachStage([this](int i) {
+    if (!stages_[i].copy_stream) return;
+    runtime::cuda::SetCurrentDevice(stages_[i].device);
+    cudaStreamDestroy(static_cast<cudaStream_t>(stages_[i].copy_stream));
+  });
+}
+
+void PipelineExecutor::BuildStage(int i,
+                                  const frontend::Program& program,
+                                  const std::vector<int>& instr_stages,
+                                  const std::vector<std::string>& fetch_vars,
+                                  const Options& options,
+                                  Graph* graph) {
+  auto& stage = stages_[i];
+  std::unordered_set<std::string> program_outputs;
+  for (int j = 0; j < program.size(); j++) {
+    for (auto& var : program[j]->outputs) program_outputs.insert(var->id);
+  }
+  // the instructions of the stage in the program order, which reads the outputs of the stages before as its inputs
+  frontend::Program stage_program;
+  std::unordered_set<std::string> produced, input_names;
+  std::vector<frontend::Variable> inputs;
+  for (int j = 0; j < program.size(); j++) {
+    if (instr_stages[j] != i) continue;
+    for (auto& var : program[j]->inputs) {
+      if (produced.count(var->id) || !input_names.insert(var->id).second) continue;
+      inputs.push_back(var);
+      if (!var->is_const && !program_outputs.count(var->id)) stage.feeds.push_back(var->id);
+    }
+    for (auto& var : program[j]->outputs) produced.insert(var->id);
+    stage_program.AppendInstruction(program[j]);
+  }
+  if (!inputs.empty()) stage_program.SetInputs(inputs);
+  // the sends and the fetched outputs of the stage are kept as the outputs of its graph
+  std::unordered_set<std::string> fetch_ids;
+  for (auto& name : partition_.sends[i]) {
+    if (produced.count(name)) fetch_ids.insert(name);
+  }
+  for (auto& name : fetch_vars) {
+    if (!produced.count(name)) continue;
+    fetch_ids.insert(name);
+    stage.fetches.push_back(name);
+  }
+
+  Target target = common::DefaultNVGPUTarget();
+  stage.graph   = std::make_shared<Graph>(stage_program, fetch_ids, target);
+  for (auto& pass : options.graph_passes) ApplyPass(stage.graph.get(), pass);
+  stage.scope = BuildScope(target, stage.graph);
+  if (i > 0) {
+    // the activations passed through the stage to a later one are not in its graph
+    auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+    auto& dtype_dict = graph->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+    for (auto& name : partition_.sends[i - 1]) {
+      if (stage.scope->FindVar(name)) continue;
+      auto& tensor = absl::get<Tensor>(*stage.scope->Var<Tensor>(name));
+      tensor->Resize(Shape(shape_dict.at(name)));
+      tensor->set_type(dtype_dict.at(name));
+      tensor->mutable_data(target);
+    }
+  }
+  GraphCompiler compiler(target, stage.scope, stage.graph);
+  auto compile_options                       = options.compile_options;
+  compile_options.with_instantiate_variables = true;
+  stage.program                              = compiler.Build(compile_options).runtime_program;
+  CUDA_CALL(cudaStreamCreateWithFlags(reinterpret_cast<cudaStream_t*>(&stage.copy_stream), cudaStreamNonBlocking));
+
+  if (i > 0 && stages_[i - 1].device != stage.device) {
+    // the copies from the devices without the peer access go through the host
+    int can_access = 0;
+    CUDA_CALL(cudaDeviceCanAccessPeer(&can_access, stage.device, stages_[i - 1].device));
+    auto status = can_access ? cudaDeviceEnablePeerAccess(stages_[i - 1].device, 0) : cudaSuccess;
+    if (status == cudaErrorPeerAccessAlreadyEnabled) {
+      cudaGetLastError();
+    } else {
+      CUDA_CALL(status);
+    }
+  }
+}
+
+void PipelineExecutor::ForEachStage(const std::function<void(int)>& fn) {
+  std::mutex mutex;
+  std::condition_variable cond;
+  int pending = num_stages();
+  for (int i = 0; i < num_stages(); i++) {
+    pool_->Schedule([&, i] {
+      fn(i);
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--pending == 0) cond.notify_one();
+    });
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  cond.wait(lock, [&] { return pending == 0; });
+}
+
+void PipelineExecutor::SetParam(const std::string& name, const void* host_data) {
+  bool found = std::any_of(stages_.begin(), stages_.end(), [&](const Stage& stage) {
+    return stage.scope->FindVar(name) != nullptr;
+  });
+  CHECK(found) << "The param " << name << " is not read by the pipeline";
+  ForEachStage([&](int i) {
+    auto& stage = stages_[i];
+    if (!stage.scope->FindVar(name)) return;
+    runtime::cuda::SetCurrentDevice(stage.device);
+    auto tensor = stage.scope->GetTensor(name);
+    CUDA_CALL(cudaMemcpy(tensor->buffer()->memory, host_data, tensor->num_bytes(), cudaMemcpyHostToDevice));
+  });
+}
+
+void PipelineExecutor::RunStage(int i,
+                                int num_micro_batches,
+                                const std::map<std::string, const void*>& inputs,
+                                const std::map<std::string, void*>& outputs) {
+  auto& stage = stages_[i];
+  runtime::cuda::SetCurrentDevice(stage.device);
+  auto stream = static_cast<cudaStream_t>(stage.copy_stream);
+  bool last   = i + 1 == num_stages();
+  for (int m = 0; m < num_micro_batches; m++) {
+    if (!last) {
+      // the sends of the last micro-batch, including those passed through, are overwritten by the next
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [&] { return consumed_[i] >= m; });
+    }
+    for (auto& name : stage.feeds) {
+      auto it = inputs.find(name);
+      if (it == inputs.end()) continue;
+      auto tensor  = stage.scope->GetTensor(name);
+      size_t bytes = tensor->num_bytes();
+      CUDA_CALL(cudaMemcpyAsync(tensor->buffer()->memory,
+                                static_cast<const uint8_t*>(it->second) + m * bytes,
+                                bytes,
+                                cudaMemcpyHostToDevice,
+                                stream));
+    }
+    if (i > 0) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [&] { return produced_[i - 1] > m; });
+      }
+      auto& prev = stages_[i - 1];
+      for (auto& name : partition_.sends[i - 1]) {
+        auto src = prev.scope->GetTensor(name);
+        auto dst = stage.scope->GetTensor(name);
+        CUDA_CALL(cudaMemcpyPeerAsync(
+            dst->buffer()->memory, stage.device, src->buffer()->memory, prev.device, src->num_bytes(), stream));
+      }
+    }
+    CUDA_CALL(cudaStreamSynchronize(stream));
+    if (i > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      consumed_[i - 1] = m + 1;
+      cond_.notify_all();
+    }
+
+    stage.program->Execute();
+    for (auto& name : stage.fetches) {
+      auto it = outputs.find(name);
+      if (it == outputs.end()) continue;
+      auto tensor  = stage.scope->GetTensor(name);
+      size_t bytes = tensor->num_bytes();
+      CUDA_CALL(cudaMemcpy(
+          static_cast<uint8_t*>(it->second) + m * bytes, tensor->buffer()->memory, bytes, cudaMemcpyDeviceToHost));
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    produced_[i] = m + 1;
+    cond_.notify_all();
+  }
+}
+
+void PipelineExecutor::Run(int num_micro_batches,
+                           const std::map<std::string, const void*>& inputs,
+                           const std::map<std::string, void*>& outputs) {
+  CHECK_GT(num_micro_batches, 0) << "The pipeline should run at least 1 micro-batch";
+  for (auto& item : inputs) {
+    bool found = std::any_of(stages_.begin(), stages_.end(), [&](const Stage& stage) {
+      return std::find(stage.feeds.begin(), stage.feeds.end(), item.first) != stage.feeds.end();
+    });
+    CHECK(found) << "The input " << item.first << " is not read by the pipeline";
+  }
+  for (auto& item : outputs) {
+    bool found = std::any_of(stages_.begin(), stages_.end(), [&](const Stage& stage) {
+      return std::find(stage.fetches.begin(), stage.fetches.end(), item.first) != stage.fetches.end();
+    });
+    CHECK(found) << "The output " << item.first << " is not fetched by the pipeline";
+  }
+  std::fill(produced_.begin(), produced_.end(), 0);
+  std::fill(consumed_.begin(), consumed_.end(), 0);
+  ForEachStage([&](int i) { RunStage(i, num_micro_batches, inputs, outputs); });
+}
+#endif  // CINN_WITH_CUDA
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
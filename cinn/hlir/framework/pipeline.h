@@ -0,0 +1,172 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "cinn/common/macros.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/utils/thread_pool.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * The FLOPs of \p node estimated from the shapes of its inputs and outputs: 2 * M * N * K for the muls, the matmuls
+ * and the convolutions, and the number of the elements of the outputs for the others.
+ */
+double EstimateNodeFlops(const Node* node, const absl::flat_hash_map<std::string, shape_t>& shape_dict);
+
+//! The op nodes of a graph cut into consecutive stages of its topological order.
+struct PipelinePartition {
+  //! The op nodes of each stage in the topological order.
+  std::vector<std::vector<Node*>> stages;
+  //! The estimated FLOPs of each stage.
+  std::vector<double> flops;
+  //! The activations produced by stage i or before it and read after it, which stage i sends to stage i + 1.
+  std::vector<std::vector<std::string>> sends;
+  //! The bytes of the sends of each stage.
+  std::vector<double> send_bytes;
+};
+
+/**
+ * Cut the op nodes of \p graph into \p num_stages consecutive stages of its topological order, minimizing the cost of
+ * the slowest stage, which is its FLOPs plus the bytes it sends weighted by \p flops_per_byte, the FLOPs a device
+ * runs in the time of sending a byte to the next one. The inputs of the graph and the fetched outputs are read and
+ * written by the stages themselves, and are not sent.
+ */
+PipelinePartition PartitionPipeline(Graph* graph, int num_stages, double flops_per_byte = 500.);
+
+#ifdef CINN_WITH_CUDA
+/**
+ * PipelineExecutor runs a program too large for a GPU on several GPUs in a pipeline. The graph of the program is cut
+ * into balanced stages by PartitionPipeline, and each stage is compiled and has its variables on its own device. The
+ * program is built for a micro-batch, and a batch of micro-batches flows through the stages: stage i runs
+ * micro-batch m while stage i + 1 runs micro-batch m - 1, and the activations are sent between the devices by the
+ * async peer copies on the copy stream of the receiving stage.
+ *
+ * Each stage holds the activations of one micro-batch, and takes the next only after the following stage has copied
+ * its sends, so at most num_stages micro-batches are in flight. This is the forward half of the 1F1B schedule, as the
+ * programs have no backward pass to interleave, and the same as GPipe without it.
+ *
+ * A typical usage, where the host data of the inputs and the outputs hold 8 micro-batches:
+ *
+ *   PipelineExecutor::Options options;
+ *   options.num_stages = 4;
+ *   PipelineExecutor pipeline(program, {"y"}, options);
+ *   pipeline.SetParam("fc_weight", weight_data);
+ *   pipeline.Run(8, {{"x", x_data}}, {{"y", y_data}});
+ */
+class PipelineExecutor {
+ public:
+  struct Options {
+    int num_stages{2};
+    //! The devices of the stages, stage i is on devices[i % devices.size()], all the devices by default.
+    std::vector<int> devices;
+    //! See PartitionPipeline.
+    double flops_per_byte{500.};
+    //! The passes applied to the graph of each stage.
+    std::vector<std::string> graph_passes{"InferShape", "OpFusion"};
+    //! The options to compile each stage with, the variables are always instantiated.
+    GraphCompiler::CompileOptions compile_options;
+  };
+
+  /**
+   * Constructor.
+   * @param program The program of a micro-batch.
+   * @param fetch_vars The outputs copied out in Run.
+   * @param options The options of the stages.
+   */
+  PipelineExecutor(const frontend::Program& program,
+                   const std::vector<std::string>& fetch_vars,
+                   const Options& options);
+
+  ~PipelineExecutor();
+
+  int num_stages() const { return stages_.size(); }
+  int device(int i) const { return stages_.at(i).device; }
+  Program* stage(int i) { return stages_.at(i).program.get(); }
+  const PipelinePartition& partition() const { return partition_; }
+
+  //! Copy the host data of the parameter \p name to each stage reading it.
+  void SetParam(const std::string& name, const void* host_data);
+
+  /**
+   * Run \p num_micro_batches micro-batches through the stages. The host memory of each variable in \p inputs and
+   * \p outputs holds the data of all the micro-batches in order, and the slice of micro-batch m is at the m-th part.
+   */
+  void Run(int num_micro_batches,
+           const std::map<std::string, const void*>& inputs,
+           const std::map<std::string, void*>& outputs);
+
+ private:
+  struct Stage {
+    int device{0};
+    std::shared_ptr<Graph> graph;
+    std::shared_ptr<Scope> scope;
+    std::unique_ptr<Program> program;
+    // The inputs of the graph read by the stage, which are copied from the host for each micro-batch.
+    std::vector<std::string> feeds;
+    // The fetched outputs produced by the stage.
+    std::vector<std::string> fetches;
+    // The stream of the copies to the stage, created on its device.
+    void* copy_stream{nullptr};
+  };
+
+  // Compile stage i of the instructions of the program in it, \p graph is the graph of the whole program.
+  void BuildStage(int i,
+                  const frontend::Program& program,
+                  const std::vector<int>& instr_stages,
+                  const std::vector<std::string>& fetch_vars,
+                  const Options& options,
+                  Graph* graph);
+
+  // Run all the micro-batches on stage i, waiting for the stages before and after it.
+  void RunStage(int i,
+                int num_micro_batches,
+                const std::map<std::string, const void*>& inputs,
+                const std::map<std::string, void*>& outputs);
+
+  // Run fn(i) for each stage i on the workers and wait for all.
+  void ForEachStage(const std::function<void(int)>& fn);
+
+  PipelinePartition partition_;
+  std::vector<Stage> stages_;
+  // The micro-batches each stage has finished, and those the stage after it has copied in.
+  std::vector<int> produced_;
+  std::vector<int> consumed_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  // A worker per stage.
+  std::unique_ptr<utils::ThreadPool> pool_;
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(PipelineExecutor);
+};
+#endif  // CINN_WITH_CUDA
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,158 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/pipeline.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+constexpr int kRows   = 4;
+constexpr int kHidden = 64;
+constexpr int kLayers = 4;
+
+// y = r4 + r1, where r_i = relu(mul(r_{i-1}, w_i)) and r0 = x
+frontend::Program BuildProgram(std::string* skip, std::string* out) {
+  frontend::Program prog;
+  frontend::Variable x("x");
+  x->shape = {kRows, kHidden};
+  x->type  = Float(32);
+  frontend::Variable r = x, r1;
+  for (int i = 1; i <= kLayers; i++) {
+    frontend::Variable w("w" + std::to_string(i));
+    w->shape = {kHidden, kHidden};
+    w->type  = Float(32);
+    r        = prog.relu(prog.mul(r, w));
+    if (i == 1) r1 = r;
+  }
+  auto y = prog.add(r, r1);
+  *skip  = r1->id;
+  *out   = y->id;
+  return prog;
+}
+
+std::shared_ptr<Graph> BuildGraph(const frontend::Program& prog) {
+  auto g = std::make_shared<Graph>(prog, common::DefaultHostTarget());
+  ApplyPass(g.get(), "InferShape");
+  return g;
+}
+}  // namespace
+
+TEST(Pipeline, estimate_flops) {
+  std::string skip, out;
+  auto g           = BuildGraph(BuildProgram(&skip, &out));
+  auto& shape_dict = g->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  double total     = 0.;
+  for (auto* graph_node : std::get<0>(g->topological_order())) {
+    auto* node = graph_node->safe_as<Node>();
+    if (!node) continue;
+    double flops = EstimateNodeFlops(node, shape_dict);
+    if (node->op()->name == "mul") {
+      ASSERT_DOUBLE_EQ(flops, 2. * kRows * kHidden * kHidden);
+    } else {
+      ASSERT_DOUBLE_EQ(flops, kRows * kHidden);
+    }
+    total += flops;
+  }
+  ASSERT_DOUBLE_EQ(total, kLayers * 2. * kRows * kHidden * kHidden + (kLayers + 1) * kRows * kHidden);
+}
+
+TEST(Pipeline, partition) {
+  std::string skip, out;
+  auto g = BuildGraph(BuildProgram(&skip, &out));
+  for (int num_stages : {1, 2, 3}) {
+    auto partition = PartitionPipeline(g.get(), num_stages, 1.);
+    ASSERT_EQ(partition.stages.size(), num_stages);
+    double total   = 0.;
+    int num_ops    = 0;
+    int skip_stage = -1;
+    for (int k = 0; k < num_stages; k++) {
+      ASSERT_FALSE(partition.stages[k].empty());
+      total += partition.flops[k];
+      num_ops += partition.stages[k].size();
+      for (auto* node : partition.stages[k]) {
+        for (auto& link : node->outlinks()) {
+          if (link->sink()->id() == skip) skip_stage = k;
+        }
+      }
+    }
+    ASSERT_EQ(num_ops, 2 * kLayers + 1);
+    ASSERT_DOUBLE_EQ(total, kLayers * 2. * kRows * kHidden * kHidden + (kLayers + 1) * kRows * kHidden);
+    ASSERT_TRUE(partition.sends.back().empty());
+    // the skip is sent by the stage producing it, and passed through each stage after it up to the add in the last
+    ASSERT_GE(skip_stage, 0);
+    for (int k = 0; k < num_stages - 1; k++) {
+      auto& sends = partition.sends[k];
+      ASSERT_EQ(std::count(sends.begin(), sends.end(), skip), k >= skip_stage ? 1 : 0);
+      ASSERT_FALSE(sends.empty());
+    }
+  }
+}
+
+#ifdef CINN_WITH_CUDA
+TEST(Pipeline, executor) {
+  std::string skip, out;
+  auto prog = BuildProgram(&skip, &out);
+  PipelineExecutor::Options options;
+  options.num_stages = 2;
+  PipelineExecutor pipeline(prog, {out}, options);
+  ASSERT_EQ(pipeline.num_stages(), 2);
+
+  std::vector<std::vector<float>> weights(kLayers, std::vector<float>(kHidden * kHidden));
+  for (int i = 0; i < kLayers; i++) {
+    for (int j = 0; j < kHidden * kHidden; j++) weights[i][j] = ((i + j) % 7 - 3) * 0.05f;
+    pipeline.SetParam("w" + std::to_string(i + 1), weights[i].data());
+  }
+
+  const int num_micro_batches = 3;
+  const int numel             = kRows * kHidden;
+  std::vector<float> x(num_micro_batches * numel), y(num_micro_batches * numel, 0.f);
+  for (int i = 0; i < x.size(); i++) x[i] = (i % 11 - 5) * 0.1f;
+  pipeline.Run(num_micro_batches, {{"x", x.data()}}, {{out, y.data()}});
+
+  // the host reference, the weights are [N, K]
+  for (int m = 0; m < num_micro_batches; m++) {
+    std::vector<float> r(x.begin() + m * numel, x.begin() + (m + 1) * numel), r1;
+    for (int i = 0; i < kLayers; i++) {
+      std::vector<float> next(numel, 0.f);
+      for (int row = 0; row < kRows; row++) {
+        for (int n = 0; n < kHidden; n++) {
+          float sum = 0.f;
+          for (int k = 0; k < kHidden; k++) sum += r[row * kHidden + k] * weights[i][n * kHidden + k];
+          next[row * kHidden + n] = std::max(sum, 0.f);
+        }
+      }
+      r = std::move(next);
+      if (i == 0) r1 = r;
+    }
+    for (int i = 0; i < numel; i++) ASSERT_NEAR(y[m * numel + i], r[i] + r1[i], 1e-4);
+  }
+}
+#endif
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,306 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/profiler.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+#include "cinn/hlir/framework/perf_counters.h"
+
+DEFINE_double(cinn_cpu_peak_gflops, 0, "The peak GFLOP/s of the CPU to report the percents of, 0 if unknown.");
+DEFINE_double(cinn_cpu_peak_gbps, 0, "The peak memory bandwidth in GB/s of the CPU to report the percents of.");
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+
+std::string EscapeJson(const std::string& str) {
+  std::string res;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      res.push_back('\\');
+      res.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      // the control characters, e.g. the tabs and the newlines, are not allowed in the JSON strings
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+      res += escaped;
+    } else {
+      res.push_back(c);
+    }
+  }
+  return res;
+}
+
+std::string FormatRate(double value) {
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(2) << value;
+  return ss.str();
+}
+
+// Add the achieved rates of the work of the event to its args.
+void AttachRates(ProfileEvent* event) {
+  if (event->duration_us <= 0 || (event->flops <= 0 && event->bytes <= 0)) return;
+  double gflops         = event->flops / (event->duration_us * 1e3);
+  double gbps           = event->bytes / (event->duration_us * 1e3);
+  event->args["gflops"] = FormatRate(gflops);
+  event->args["gbps"]   = FormatRate(gbps);
+  if (event->peak.gflops > 0) event->args["peak_compute_percent"] = FormatRate(gflops / event->peak.gflops * 100);
+  if (event->peak.gbps > 0) event->args["peak_bandwidth_percent"] = FormatRate(gbps / event->peak.gbps * 100);
+}
+
+// Add the deltas of the hardware counters from \p start to \p end to the args.
+void AttachCounters(const std::vector<uint64_t>& start, const std::vector<uint64_t>& end, ProfileEvent* event) {
+  auto& names = PerfCounters::ThreadLocal().names();
+  if (start.size() != names.size() || end.size() != names.size()) return;
+  std::map<std::string, uint64_t> deltas;
+  for (int i = 0; i < names.size(); i++) {
+    auto delta            = end[i] - start[i];
+    deltas[names[i]]      = delta;
+    event->args[names[i]] = std::to_string(delta);
+  }
+  if (deltas["cycles"] > 0) event->args["ipc"] = FormatRate(1. * deltas["instructions"] / deltas["cycles"]);
+  if (deltas["instructions"] > 0 && deltas.count("llc_misses")) {
+    event->args["llc_mpki"] = FormatRate(1e3 * deltas["llc_misses"] / deltas["instructions"]);
+  }
+}
+
+}  // namespace
+
+DevicePeak QueryDevicePeak(const common::Target& target) {
+  DevicePeak peak;
+  if (target.arch != common::Target::Arch::NVGPU) {
+    peak.gflops = FLAGS_cinn_cpu_peak_gflops;
+    peak.gbps   = FLAGS_cinn_cpu_peak_gbps;
+    return peak;
+  }
+#ifdef CINN_WITH_CUDA
+  int device = 0;
+  cudaDeviceProp prop;
+  if (cudaGetDevice(&device) != cudaSuccess || cudaGetDeviceProperties(&prop, device) != cudaSuccess) {
+    cudaGetLastError();
+    return peak;
+  }
+  // the FP32 units per SM, the GP100, GV100, GA100 and GH100 have 64 and the others since Maxwell have 128
+  int units = prop.major >= 5 ? 128 : 192;
+  if ((prop.major == 6 || prop.major == 8) && prop.minor == 0) units = 64;
+  if (prop.major == 7) units = 64;
+  // each FMA counts as two, and the clock rates are in kHz
+  peak.gflops = 2. * prop.multiProcessorCount * units * prop.clockRate / 1e6;
+  peak.gbps   = 2. * prop.memoryClockRate * (prop.memoryBusWidth / 8) / 1e6;
+#endif
+  return peak;
+}
+
+Profiler::Profiler() : host_base_(std::chrono::steady_clock::now()) {
+#ifdef CINN_WITH_CUDA
+  int count = 0;
+  if (cudaGetDeviceCount(&count) == cudaSuccess && count > 0) {
+    CUDA_CALL(cudaEventCreate(&gpu_base_));
+    CUDA_CALL(cudaEventRecord(gpu_base_, nullptr));
+    CUDA_CALL(cudaEventSynchronize(gpu_base_));
+    host_base_ = std::chrono::steady_clock::now();
+  } else {
+    cudaGetLastError();
+  }
+#endif
+}
+
+Profiler::~Profiler() {
+  Clear();
+#ifdef CINN_WITH_CUDA
+  if (gpu_base_) CUDA_CALL(cudaEventDestroy(gpu_base_));
+#endif
+}
+
+double Profiler::HostMicros(std::chrono::steady_clock::time_point time) const {
+  return std::chrono::duration<double, std::micro>(time - host_base_).count();
+}
+
+int Profiler::ThreadIndex() {
+  auto id = std::this_thread::get_id();
+  auto it = thread_index_.find(id);
+  if (it != thread_index_.end()) return it->second;
+  int index = thread_index_.size();
+  thread_index_.emplace(id, index);
+  return index;
+}
+
+int Profiler::Start(const common::Target& target, void* stream) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Record record;
+  auto peak = peaks_.find(target.arch);
+  if (peak == peaks_.end()) peak = peaks_.emplace(target.arch, QueryDevicePeak(target)).first;
+  record.event.peak = peak->second;
+#ifdef CINN_WITH_CUDA
+  if (target.arch == common::Target::Arch::NVGPU && gpu_base_) {
+    record.is_gpu = true;
+    auto it       = stream_index_.find(stream);
+    if (it == stream_index_.end()) it = stream_index_.emplace(stream, stream_index_.size()).first;
+    record.event.tid = it->second;
+    record.stream    = stream;
+    CUDA_CALL(cudaEventCreate(&record.gpu_start));
+    CUDA_CALL(cudaEventCreate(&record.gpu_end));
+    CUDA_CALL(cudaEventRecord(record.gpu_start, static_cast<cudaStream_t>(stream)));
+    records_.push_back(std::move(record));
+    return records_.size() - 1;
+  }
+#endif
+  if (FLAGS_cinn_profile_perf_counters && target.arch == common::Target::Arch::X86) {
+    record.counters = PerfCounters::ThreadLocal().Read();
+  }
+  record.event.tid  = ThreadIndex();
+  record.host_start = std::chrono::steady_clock::now();
+  records_.push_back(std::move(record));
+  return records_.size() - 1;
+}
+
+void Profiler::Stop(int id,
+                    const std::string& name,
+                    const std::string& category,
+                    std::map<std::string, std::string> args,
+                    double flops,
+                    double bytes) {
+  auto end = std::chrono::steady_clock::now();
+  std::vector<uint64_t> counters;
+  if (FLAGS_cinn_profile_perf_counters) counters = PerfCounters::ThreadLocal().Read();
+  std::lock_guard<std::mutex> lock(mutex_);
+  CHECK_LT(id, records_.size());
+  auto& record          = records_[id];
+  record.event.name     = name;
+  record.event.category = category;
+  record.event.args     = std::move(args);
+  record.event.flops    = flops;
+  record.event.bytes    = bytes;
+#ifdef CINN_WITH_CUDA
+  if (record.is_gpu) {
+    CUDA_CALL(cudaEventRecord(record.gpu_end, static_cast<cudaStream_t>(record.stream)));
+    return;
+  }
+#endif
+  record.event.start_us    = HostMicros(record.host_start);
+  record.event.duration_us = HostMicros(end) - record.event.start_us;
+  record.finished          = true;
+  if (!record.counters.empty()) AttachCounters(record.counters, counters, &record.event);
+}
+
+void Profiler::Synchronize() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& record : records_) {
+#ifdef CINN_WITH_CUDA
+    if (record.is_gpu) {
+      float start_ms = 0, end_ms = 0;
+      CUDA_CALL(cudaEventSynchronize(record.gpu_end));
+      CUDA_CALL(cudaEventElapsedTime(&start_ms, gpu_base_, record.gpu_start));
+      CUDA_CALL(cudaEventElapsedTime(&end_ms, gpu_base_, record.gpu_end));
+      CUDA_CALL(cudaEventDestroy(record.gpu_start));
+      CUDA_CALL(cudaEventDestroy(record.gpu_end));
+      record.event.start_us    = start_ms * 1000.;
+      record.event.duration_us = (end_ms - start_ms) * 1000.;
+      record.finished          = true;
+    }
+#endif
+    CHECK(record.finished) << "The profile record of [" << record.event.name << "] is not stopped";
+    AttachRates(&record.event);
+    events_.push_back(std::move(record.event));
+  }
+  records_.clear();
+}
+
+void Profiler::Clear() {
+  Synchronize();
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.clear();
+}
+
+std::string Profiler::ToChromeTrace() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::stringstream ss;
+  ss << "{\"traceEvents\": [";
+  for (int i = 0; i < events_.size(); i++) {
+    auto& event = events_[i];
+    if (i > 0) ss << ",";
+    ss << "\n  {\"name\": \"" << EscapeJson(event.name) << "\", \"cat\": \"" << EscapeJson(event.category)
+       << "\", \"ph\": \"X\", \"ts\": " << event.start_us << ", \"dur\": " << event.duration_us
+       << ", \"pid\": 0, \"tid\": " << event.tid << ", \"args\": {";
+    bool first = true;
+    for (auto& arg : event.args) {
+      if (!first) ss << ", ";
+      first = false;
+      ss << "\"" << EscapeJson(arg.first) << "\": \"" << EscapeJson(arg.second) << "\"";
+    }
+    ss << "}}";
+  }
+  ss << "\n]}\n";
+  return ss.str();
+}
+
+void Profiler::ExportChromeTrace(const std::string& path) const {
+  std::ofstream os(path);
+  CHECK(os.is_open()) << "Failed to open " << path << " to export the trace";
+  os << ToChromeTrace();
+}
+
+std::string Profiler::KernelSummary() const {
+  struct Stat {
+    int count{0};
+    double total_us{0.}, flops{0.}, bytes{0.};
+    DevicePeak peak;
+  };
+  std::map<std::string, Stat> stats;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& event : events_) {
+      if (event.category != "kernel" && event.category != "library") continue;
+      auto& stat = stats[event.name];
+      stat.count++;
+      stat.total_us += event.duration_us;
+      stat.flops += event.flops;
+      stat.bytes += event.bytes;
+      stat.peak = event.peak;
+    }
+  }
+  std::vector<std::pair<std::string, Stat>> sorted(stats.begin(), stats.end());
+  std::sort(sorted.begin(), sorted.end(), [](auto& a, auto& b) { return a.second.total_us > b.second.total_us; });
+
+  auto percent = [](double value, double peak) { return peak > 0 ? FormatRate(value / peak * 100) : "-"; };
+  std::stringstream ss;
+  ss << std::left << std::setw(48) << "kernel" << std::right << std::setw(8) << "count" << std::setw(12) << "avg_us"
+     << std::setw(12) << "GFLOP/s" << std::setw(10) << "%peak" << std::setw(12) << "GB/s" << std::setw(10) << "%peak"
+     << std::setw(12) << "FLOP/byte" << "\n";
+  for (auto& item : sorted) {
+    auto& stat    = item.second;
+    double gflops = stat.total_us > 0 ? stat.flops / (stat.total_us * 1e3) : 0.;
+    double gbps   = stat.total_us > 0 ? stat.bytes / (stat.total_us * 1e3) : 0.;
+    ss << std::left << std::setw(48) << item.first << std::right << std::setw(8) << stat.count << std::setw(12)
+       << FormatRate(stat.total_us / stat.count) << std::setw(12) << FormatRate(gflops) << std::setw(10)
+       << percent(gflops, stat.peak.gflops) << std::setw(12) << FormatRate(gbps) << std::setw(10)
+       << percent(gbps, stat.peak.gbps) << std::setw(12) << FormatRate(stat.bytes > 0 ? stat.flops / stat.bytes : 0.)
+       << "\n";
+  }
+  return ss.str();
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,150 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <gflags/gflags.h>
+
+#include <chrono>  //NOLINT
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cinn/backends/cuda_util.h"
+#include "cinn/common/target.h"
+
+DECLARE_double(cinn_cpu_peak_gflops);
+DECLARE_double(cinn_cpu_peak_gbps);
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+//! The peak compute and memory bandwidth of a target, 0 if unknown.
+struct DevicePeak {
+  double gflops{0.};
+  double gbps{0.};
+};
+
+/**
+ * Get the peak of \p target. The NVGPU peak is derived from the properties of the current device with the FP32 FMA
+ * units per SM, and the CPU peak is given by the flags --cinn_cpu_peak_gflops and --cinn_cpu_peak_gbps.
+ */
+DevicePeak QueryDevicePeak(const common::Target& target);
+
+//! A timed event of the execution, the times are in microseconds since the profiler starts.
+struct ProfileEvent {
+  std::string name;
+  std::string category;
+  double start_us{};
+  double duration_us{};
+  //! The stream index on GPU, or the thread index on CPU.
+  int tid{};
+  std::map<std::string, std::string> args;
+  //! The static work of the event, 0 if unknown, see KernelCost.
+  double flops{};
+  double bytes{};
+  //! The peak of the target the event runs on.
+  DevicePeak peak;
+};
+
+/**
+ * Profiler records the start and end time of the instructions and the kernels inside them. The host work is timed by
+ * the steady clock, and the GPU work is timed by the CUDA events recorded on its stream, which are resolved in
+ * Synchronize after the device finishes the work. The records can be exported as a Chrome trace, which can be viewed
+ * by chrome://tracing or Perfetto.
+ */
+class Profiler {
+ public:
+  Profiler();
+  ~Profiler();
+
+  /**
+   * Start a record.
+   * @param target The target the work runs on.
+   * @param stream The CUDA stream the work is launched on for NVGPU, null for the default stream.
+   * @return The id of the record.
+   */
+  int Start(const common::Target& target, void* stream = nullptr);
+
+  /**
+   * Finish the record \p id started by Start, with the \p flops and \p bytes of the work if known. The records with
+   * the work get the achieved rates and their percents of the peak of the target in the args once resolved.
+   *
+   * With --cinn_profile_perf_counters, the X86 records also get the deltas of the hardware counters of the thread in
+   * the args, with the instructions per cycle and the last level cache misses per kilo instructions.
+   */
+  void Stop(int id,
+            const std::string& name,
+            const std::string& category,
+            std::map<std::string, std::string> args = {},
+            double flops                            = 0,
+            double bytes                            = 0);
+
+  //! Resolve the pending GPU records, it should be called after the device is synchronized.
+  void Synchronize();
+
+  //! Get the finished records.
+  const std::vector<ProfileEvent>& events() const { return events_; }
+
+  //! Clear all the records.
+  void Clear();
+
+  //! Dump the records in the Chrome trace event format.
+  std::string ToChromeTrace() const;
+  void ExportChromeTrace(const std::string& path) const;
+
+  /**
+   * Summarize the kernels by name in the descending order of their total time, with the achieved GFLOP/s and GB/s,
+   * their percents of the peak and the arithmetic intensity, to tell which kernels are bound by what.
+   */
+  std::string KernelSummary() const;
+
+ private:
+  struct Record {
+    ProfileEvent event;
+    bool is_gpu{false};
+    bool finished{false};
+    std::chrono::steady_clock::time_point host_start;
+    // The hardware counters at the start, see PerfCounters.
+    std::vector<uint64_t> counters;
+#ifdef CINN_WITH_CUDA
+    void* stream{};
+    cudaEvent_t gpu_start{};
+    cudaEvent_t gpu_end{};
+#endif
+  };
+
+  double HostMicros(std::chrono::steady_clock::time_point time) const;
+  int ThreadIndex();
+
+  std::chrono::steady_clock::time_point host_base_;
+#ifdef CINN_WITH_CUDA
+  // Recorded on the default stream at host_base_, to put the GPU records on the host timeline.
+  cudaEvent_t gpu_base_{};
+  std::map<void*, int> stream_index_;
+#endif
+  std::map<common::Target::Arch, DevicePeak> peaks_;
+  std::map<std::thread::id, int> thread_index_;
+  std::vector<Record> records_;
+  std::vector<ProfileEvent> events_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
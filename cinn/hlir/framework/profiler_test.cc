@@ -0,0 +1,136 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/profiler.h"
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "cinn/hlir/framework/instruction.h"
+#include "cinn/hlir/framework/perf_counters.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+void EmptyKernel(void* args, int32_t num_args) {}
+
+TEST(Profiler, instruction) {
+  Scope scope;
+  for (auto& name : std::vector<std::string>({"x", "y"})) {
+    auto* var    = scope.Var<Tensor>(name);
+    auto& tensor = absl::get<Tensor>(*var);
+    tensor->Resize(Shape{{2, 3}});
+  }
+  auto target = common::DefaultHostTarget();
+  Instruction instr(target, &scope, {"x"}, {"y"}, "relu");
+  instr.SetLoweredFunc(&EmptyKernel, "fn_relu_0");
+
+  Profiler profiler;
+  instr.SetProfiler(&profiler);
+  instr.Run();
+  profiler.Synchronize();
+
+  // the records are kept in the order they start.
+  auto& events = profiler.events();
+  ASSERT_EQ(events.size(), 2UL);
+  ASSERT_EQ(events[0].name, "relu");
+  ASSERT_EQ(events[0].category, "instruction");
+  ASSERT_EQ(events[0].args.at("inputs"), "x[2,3]");
+  ASSERT_EQ(events[0].args.at("outputs"), "y[2,3]");
+  ASSERT_EQ(events[1].name, "fn_relu_0");
+  ASSERT_EQ(events[1].category, "kernel");
+  ASSERT_LE(events[0].start_us, events[1].start_us);
+  ASSERT_GE(events[0].duration_us, events[1].duration_us);
+
+  auto trace = profiler.ToChromeTrace();
+  ASSERT_NE(trace.find("\"name\": \"fn_relu_0\""), std::string::npos);
+  ASSERT_NE(trace.find("\"ph\": \"X\""), std::string::npos);
+
+  profiler.Clear();
+  ASSERT_TRUE(profiler.events().empty());
+}
+
+// the quotes, the backslashes and the control characters of the names are escaped in the JSON of the trace
+TEST(Profiler, escape_trace) {
+  Profiler profiler;
+  int id = profiler.Start(common::DefaultHostTarget());
+  profiler.Stop(id, "op\t\"fused\"\n", "kernel", {{"path", "a\\b\x01"}});
+  profiler.Synchronize();
+  auto trace = profiler.ToChromeTrace();
+  ASSERT_NE(trace.find(R"("name": "op\u0009\"fused\"\u000a")"), std::string::npos) << trace;
+  ASSERT_NE(trace.find(R"("path": "a\\b\u0001")"), std::string::npos) << trace;
+  ASSERT_EQ(trace.find('\t'), std::string::npos);
+}
+
+TEST(Profiler, kernel_rates) {
+  Scope scope;
+  for (auto& name : std::vector<std::string>({"x", "y"})) {
+    auto* var    = scope.Var<Tensor>(name);
+    auto& tensor = absl::get<Tensor>(*var);
+    tensor->Resize(Shape{{2, 3}});
+  }
+  Instruction instr(common::DefaultHostTarget(), &scope, {"x"}, {"y"}, "relu");
+  instr.SetLoweredFunc(&EmptyKernel, "fn_relu_0");
+  KernelCost cost;
+  cost.flops         = 6;
+  cost.bytes_read    = 24;
+  cost.bytes_written = 24;
+  instr.SetKernelCost(0, cost);
+  ASSERT_EQ(instr.cost().bytes(), 48);
+
+  Profiler profiler;
+  instr.SetProfiler(&profiler);
+  instr.Run();
+  profiler.Synchronize();
+
+  auto& events = profiler.events();
+  ASSERT_EQ(events.size(), 2UL);
+  ASSERT_EQ(events[1].flops, 6);
+  ASSERT_EQ(events[1].bytes, 48);
+  if (events[1].duration_us > 0) {
+    ASSERT_TRUE(events[1].args.count("gflops"));
+    ASSERT_TRUE(events[1].args.count("gbps"));
+  }
+  auto summary = profiler.KernelSummary();
+  ASSERT_NE(summary.find("fn_relu_0"), std::string::npos);
+  ASSERT_EQ(summary.find("relu "), std::string::npos);
+}
+
+TEST(Profiler, perf_counters) {
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  FLAGS_cinn_profile_perf_counters = true;
+  Profiler profiler;
+  int id = profiler.Start(common::DefaultHostTarget());
+  volatile float sum = 0;
+  for (int i = 0; i < 10000; i++) sum += i * 0.5f;
+  profiler.Stop(id, "loop", "kernel");
+  profiler.Synchronize();
+
+  auto& events = profiler.events();
+  ASSERT_EQ(events.size(), 1UL);
+  if (!PerfCounters::ThreadLocal().available()) {
+    LOG(INFO) << "The perf_event counters are not available, skipped";
+    return;
+  }
+  for (auto& name : PerfCounters::ThreadLocal().names()) ASSERT_TRUE(events[0].args.count(name)) << name;
+  ASSERT_GT(std::stoull(events[0].args.at("instructions")), 10000UL);
+  ASSERT_TRUE(events[0].args.count("ipc"));
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,243 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/program_artifact.h"
+
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "cinn/hlir/framework/scope.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+constexpr char kMagic[]     = "CINNPROG";
+constexpr size_t kMagicSize = sizeof(kMagic) - 1;
+
+class Writer {
+ public:
+  template <typename T>
+  void WritePod(const T& value) {
+    buffer_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void WriteString(const std::string& str) {
+    WritePod<uint64_t>(str.size());
+    buffer_.append(str);
+  }
+
+  void WriteInts(const std::vector<int>& ints) {
+    WritePod<uint64_t>(ints.size());
+    buffer_.append(reinterpret_cast<const char*>(ints.data()), ints.size() * sizeof(int));
+  }
+
+  void WriteStrings(const std::vector<std::string>& strs) {
+    WritePod<uint64_t>(strs.size());
+    for (auto& str : strs) WriteString(str);
+  }
+
+  void WriteStringLists(const std::vector<std::vector<std::string>>& lists) {
+    WritePod<uint64_t>(lists.size());
+    for (auto& list : lists) WriteStrings(list);
+  }
+
+  //! Pad the buffer with zeros to a multiple of \p alignment.
+  void Align(size_t alignment) { buffer_.resize((buffer_.size() + alignment - 1) / alignment * alignment, '\0'); }
+
+  std::string& buffer() { return buffer_; }
+
+ private:
+  std::string buffer_;
+};
+
+class Reader {
+ public:
+  Reader(const char* data, size_t size, const std::string& path)
+      : begin_(data), cur_(data), end_(data + size), path_(path) {}
+
+  template <typename T>
+  T ReadPod() {
+    T value;
+    std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  std::string ReadString() {
+    auto size = ReadPod<uint64_t>();
+    return std::string(Take(size), size);
+  }
+
+  std::vector<int> ReadInts() {
+    auto size = ReadPod<uint64_t>();
+    std::vector<int> ints(size);
+    std::memcpy(ints.data(), Take(size * sizeof(int)), size * sizeof(int));
+    return ints;
+  }
+
+  std::vector<std::string> ReadStrings() {
+    auto size = ReadPod<uint64_t>();
+    std::vector<std::string> strs;
+    for (uint64_t i = 0; i < size; i++) strs.push_back(ReadString());
+    return strs;
+  }
+
+  std::vector<std::vector<std::string>> ReadStringLists() {
+    auto size = ReadPod<uint64_t>();
+    std::vector<std::vector<std::string>> lists;
+    for (uint64_t i = 0; i < size; i++) lists.push_back(ReadStrings());
+    return lists;
+  }
+
+  //! Skip the padding to a multiple of \p alignment from the beginning.
+  void Align(size_t alignment) {
+    size_t offset = cur_ - begin_;
+    Take((offset + alignment - 1) / alignment * alignment - offset);
+  }
+
+  const char* Take(size_t size) {
+    CHECK_LE(size, static_cast<size_t>(end_ - cur_)) << "The program artifact " << path_ << " is truncated";
+    const char* data = cur_;
+    cur_ += size;
+    return data;
+  }
+
+ private:
+  const char* begin_;
+  const char* cur_;
+  const char* end_;
+  std::string path_;
+};
+}  // namespace
+
+void ProgramArtifact::Save(const std::string& path) const {
+  Writer writer;
+  writer.buffer().append(kMagic, kMagicSize);
+  writer.WritePod<uint32_t>(kVersion);
+  writer.WritePod<int32_t>(static_cast<int32_t>(arch));
+
+  writer.WriteStrings(code.objects);
+  writer.WriteStrings(code.ptxs);
+  writer.WriteStringLists(code.kernel_names);
+
+  writer.WritePod<uint64_t>(variables.size());
+  for (auto& var : variables) {
+    writer.WriteString(var.name);
+    writer.WriteInts(var.shape);
+    writer.WriteString(var.data);
+    writer.WriteString(var.view_of);
+    writer.WriteString(var.dtype);
+    writer.WriteString(var.slice_of);
+    writer.WritePod<uint32_t>(var.slice_offset);
+    writer.WritePod<int64_t>(var.arena_offset);
+  }
+
+  writer.WritePod<uint64_t>(instrs.size());
+  for (auto& instr : instrs) {
+    writer.WriteString(instr.function_name);
+    writer.WriteStringLists(instr.in_args);
+    writer.WriteStringLists(instr.out_args);
+    writer.WriteStrings(instr.fn_names);
+    writer.WriteInts(instr.attrs);
+    writer.WriteStrings(instr.str_attrs);
+    writer.WritePod<uint8_t>(instr.pre_run);
+    writer.WriteStrings(instr.node_ids);
+    writer.WritePod<uint8_t>(static_cast<uint8_t>(instr.precision_mode));
+  }
+
+  writer.WritePod<uint64_t>(param_arena_size);
+  if (param_arena_size) {
+    writer.Align(Scope::kPackAlignment);
+    writer.buffer().append(reinterpret_cast<const char*>(param_arena), param_arena_size);
+  }
+
+  // Write to a temporary file and rename it, so that a partial artifact is never loaded.
+  std::string tmp_path = path + ".tmp";
+  FILE* f              = fopen(tmp_path.c_str(), "wb");
+  CHECK(f) << "Failed to open " << tmp_path;
+  size_t written = fwrite(writer.buffer().data(), 1, writer.buffer().size(), f);
+  CHECK_EQ(fclose(f), 0) << "Failed to write " << tmp_path;
+  CHECK_EQ(written, writer.buffer().size()) << "Failed to write " << tmp_path;
+  CHECK_EQ(std::rename(tmp_path.c_str(), path.c_str()), 0) << "Failed to write " << path;
+}
+
+ProgramArtifact ProgramArtifact::Load(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  CHECK_GE(fd, 0) << "Failed to open the program artifact " << path;
+  struct stat st;
+  CHECK_EQ(fstat(fd, &st), 0) << "Failed to stat the program artifact " << path;
+  size_t size = st.st_size;
+  CHECK_GE(size, kMagicSize) << "The program artifact " << path << " is truncated";
+  // writable but private, so that the parameters used in place may be written without touching the file
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  CHECK(data != MAP_FAILED) << "Failed to map the program artifact " << path;
+
+  ProgramArtifact artifact;
+  Reader reader(reinterpret_cast<const char*>(data), size, path);
+  CHECK_EQ(std::string(reader.Take(kMagicSize), kMagicSize), kMagic) << path << " is not a program artifact";
+  auto version = reader.ReadPod<uint32_t>();
+  CHECK_EQ(version, kVersion) << "The version of the program artifact " << path << " is not supported";
+  artifact.arch = static_cast<common::Target::Arch>(reader.ReadPod<int32_t>());
+
+  artifact.code.objects      = reader.ReadStrings();
+  artifact.code.ptxs         = reader.ReadStrings();
+  artifact.code.kernel_names = reader.ReadStringLists();
+
+  artifact.variables.resize(reader.ReadPod<uint64_t>());
+  for (auto& var : artifact.variables) {
+    var.name    = reader.ReadString();
+    var.shape   = reader.ReadInts();
+    var.data    = reader.ReadString();
+    var.view_of      = reader.ReadString();
+    var.dtype        = reader.ReadString();
+    var.slice_of     = reader.ReadString();
+    var.slice_offset = reader.ReadPod<uint32_t>();
+    var.arena_offset = reader.ReadPod<int64_t>();
+  }
+
+  artifact.instrs.resize(reader.ReadPod<uint64_t>());
+  for (auto& instr : artifact.instrs) {
+    instr.function_name  = reader.ReadString();
+    instr.in_args        = reader.ReadStringLists();
+    instr.out_args       = reader.ReadStringLists();
+    instr.fn_names       = reader.ReadStrings();
+    instr.attrs          = reader.ReadInts();
+    instr.str_attrs      = reader.ReadStrings();
+    instr.pre_run        = reader.ReadPod<uint8_t>();
+    instr.node_ids       = reader.ReadStrings();
+    instr.precision_mode = static_cast<common::PrecisionMode>(reader.ReadPod<uint8_t>());
+  }
+
+  artifact.param_arena_size = reader.ReadPod<uint64_t>();
+  if (!artifact.param_arena_size) {
+    munmap(data, size);
+    return artifact;
+  }
+  reader.Align(Scope::kPackAlignment);
+  artifact.param_arena = reinterpret_cast<const uint8_t*>(reader.Take(artifact.param_arena_size));
+  artifact.file        = std::shared_ptr<void>(data, [size](void* mapped) { munmap(mapped, size); });
+  return artifact;
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,96 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cinn/backends/compiler.h"
+#include "cinn/common/precision.h"
+#include "cinn/common/target.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * ProgramArtifact holds everything to rebuild a runnable Program without running the frontend, the passes, the
+ * lowering and the codegen again: the compiled code, the instructions and the variables with the optional parameters.
+ *
+ * It is saved to a binary file with the layout:
+ *   "CINNPROG" | version | target arch | code | variables | instructions | parameter arena
+ * where a string is a 64-bit size followed by its bytes, a list is a 64-bit count followed by its elements, and all
+ * the integers are in the native byte order, so the file is only loaded on the same kind of machine. The parameter
+ * arena is its 64-bit size followed by the padding to Scope::kPackAlignment in the file and its bytes, so that the
+ * mapped file can be used in place.
+ */
+struct ProgramArtifact {
+  static constexpr uint32_t kVersion = 7;
+
+  struct Variable {
+    std::string name;
+    std::vector<int> shape;
+    //! The raw data of the persistent variables, e.g. the parameters, empty for the others.
+    std::string data;
+    //! The variable whose buffer it shares as a view, e.g. the output of a reshape, empty for the others.
+    std::string view_of;
+    //! The type the buffer holds, "float16", "bfloat16", "int8" or "float32", the other int and bool variables are also
+    //! held in float32 buffers.
+    std::string dtype{"float32"};
+    //! The variable whose buffer it refers to a slice of, e.g. an input of a concat, empty for the others.
+    std::string slice_of;
+    //! The offset of the slice in bytes.
+    uint32_t slice_offset{};
+    //! The offset in bytes of the packed parameter in the parameter arena, -1 for the others.
+    int64_t arena_offset{-1};
+  };
+
+  struct Instr {
+    std::string function_name;
+    std::vector<std::vector<std::string>> in_args;
+    std::vector<std::vector<std::string>> out_args;
+    //! The names of the lowered functions called in order.
+    std::vector<std::string> fn_names;
+    std::vector<int> attrs;
+    std::vector<std::string> str_attrs;
+    bool pre_run{false};
+    //! The ids of the fused graph nodes, which key the instruction in the execution profile.
+    std::vector<std::string> node_ids;
+    //! The precision mode the library calls of the instruction follow.
+    common::PrecisionMode precision_mode{common::PrecisionMode::kFast};
+  };
+
+  common::Target::Arch arch{common::Target::Arch::Unk};
+  backends::CompiledCode code;
+  std::vector<Variable> variables;
+  std::vector<Instr> instrs;
+  //! The parameters packed by Program::PackParams, which the variables of the arena offsets refer to. The arena of a
+  //! loaded artifact points into the mapped file, which `file` keeps alive.
+  const uint8_t* param_arena{nullptr};
+  uint64_t param_arena_size{};
+  std::shared_ptr<void> file;
+
+  void Save(const std::string& path) const;
+
+  //! Load the artifact by mapping the file into memory, it fails if the file is truncated or of another version. The
+  //! file stays mapped privately while the parameter arena is in use, and is unmapped right away if there is none.
+  static ProgramArtifact Load(const std::string& path);
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
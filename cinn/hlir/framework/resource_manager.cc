@@ -0,0 +1,141 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/resource_manager.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+// The tenant installed on the thread by the innermost TenantScope.
+thread_local Tenant* t_tenant = nullptr;
+}  // namespace
+
+std::ostream& operator<<(std::ostream& os, const TenantUsage& usage) {
+  os << usage.name << ": " << usage.num_runs << " runs, " << usage.mean_run_ms() << " ms mean, " << usage.max_run_ms
+     << " ms max, " << usage.allocated_bytes << " bytes allocated, " << usage.peak_allocated_bytes << " bytes peak, "
+     << usage.busy_threads << " busy threads, " << usage.num_parallel_launches << " parallel launches of "
+     << usage.num_parallel_tasks << " tasks";
+  return os;
+}
+
+Tenant::Tenant(const std::string& name, const TenantOptions& options)
+    : name_(name), options_(options) {
+  thread_budget_ = cinn_thread_budget_create(options.max_threads, options.priority);
+}
+
+Tenant::~Tenant() { cinn_thread_budget_destroy(thread_budget_); }
+
+TenantUsage Tenant::GetUsage() const {
+  TenantUsage usage;
+  usage.name                  = name_;
+  usage.allocated_bytes       = allocated_bytes_.load(std::memory_order_relaxed);
+  usage.peak_allocated_bytes  = peak_allocated_bytes_.load(std::memory_order_relaxed);
+  usage.busy_threads          = cinn_thread_budget_busy_threads(thread_budget_);
+  usage.num_parallel_launches = cinn_thread_budget_num_launches(thread_budget_);
+  usage.num_parallel_tasks    = cinn_thread_budget_num_tasks(thread_budget_);
+  std::lock_guard<std::mutex> lock(mutex_);
+  usage.num_runs     = num_runs_;
+  usage.total_run_ms = total_run_ms_;
+  usage.max_run_ms   = max_run_ms_;
+  return usage;
+}
+
+void Tenant::Allocate(size_t nbytes) {
+  size_t allocated = allocated_bytes_.fetch_add(nbytes, std::memory_order_relaxed) + nbytes;
+  if (options_.memory_quota && allocated > options_.memory_quota) {
+    allocated_bytes_.fetch_sub(nbytes, std::memory_order_relaxed);
+    LOG(FATAL) << "The tenant [" << name_ << "] exceeds its memory quota of " << options_.memory_quota
+               << " bytes by allocating " << nbytes << " bytes with " << allocated - nbytes << " bytes allocated";
+  }
+  size_t peak = peak_allocated_bytes_.load(std::memory_order_relaxed);
+  while (allocated > peak && !peak_allocated_bytes_.compare_exchange_weak(peak, allocated)) {
+  }
+}
+
+void Tenant::Free(size_t nbytes) { allocated_bytes_.fetch_sub(nbytes, std::memory_order_relaxed); }
+
+void Tenant::RecordRun(double ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  num_runs_++;
+  total_run_ms_ += ms;
+  max_run_ms_ = std::max(max_run_ms_, ms);
+}
+
+std::shared_ptr<Tenant> Tenant::Current() { return t_tenant ? t_tenant->shared_from_this() : nullptr; }
+
+TenantScope::TenantScope(const std::shared_ptr<Tenant>& tenant, bool record_run)
+    : tenant_(tenant.get()), record_run_(record_run && tenant) {
+  if (!tenant_) return;
+  prev_tenant_ = t_tenant;
+  t_tenant     = tenant_;
+  prev_budget_ = cinn_set_thread_budget(tenant_->thread_budget_);
+  if (record_run_) start_ = std::chrono::steady_clock::now();
+}
+
+TenantScope::~TenantScope() {
+  if (!tenant_) return;
+  if (record_run_) {
+    tenant_->RecordRun(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count());
+  }
+  cinn_set_thread_budget(prev_budget_);
+  t_tenant = prev_tenant_;
+}
+
+ResourceManager& ResourceManager::Global() {
+  static auto* manager = new ResourceManager;
+  return *manager;
+}
+
+std::shared_ptr<Tenant> ResourceManager::Register(const std::string& name, const TenantOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& tenant = tenants_[name];
+  if (!tenant) {
+    tenant.reset(new Tenant(name, options));
+    VLOG(3) << "Register the tenant [" << name << "] of " << options.max_threads << " threads, "
+            << options.memory_quota << " bytes and priority " << options.priority;
+  }
+  return tenant;
+}
+
+std::shared_ptr<Tenant> ResourceManager::Get(const std::string& name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = tenants_.find(name);
+  return it == tenants_.end() ? nullptr : it->second;
+}
+
+void ResourceManager::Unregister(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tenants_.erase(name);
+}
+
+std::vector<TenantUsage> ResourceManager::GetUsage() const {
+  std::vector<std::shared_ptr<Tenant>> tenants;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& item : tenants_) tenants.push_back(item.second);
+  }
+  std::vector<TenantUsage> usages;
+  for (auto& tenant : tenants) usages.push_back(tenant->GetUsage());
+  return usages;
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,158 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "cinn/common/macros.h"
+#include "cinn/runtime/cpu/thread_backend.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+struct TenantOptions {
+  //! The max number of threads the parallel kernels of the tenant run on at once, 0 for no limit.
+  int max_threads{0};
+  //! The max bytes of the buffers allocated for the tenant, 0 for no limit. Allocating beyond it fails.
+  size_t memory_quota{0};
+  //! The idle workers of the shared thread pool serve the kernels of the tenants of higher priorities first.
+  int priority{0};
+};
+
+//! The resources a tenant has used.
+struct TenantUsage {
+  std::string name;
+  int64_t num_runs{};
+  double total_run_ms{};
+  double max_run_ms{};
+  //! The bytes of the buffers allocated for the tenant and not freed yet, and the peak of it.
+  size_t allocated_bytes{};
+  size_t peak_allocated_bytes{};
+  //! The threads running the parallel kernels of the tenant now, and the kernels and their tasks run so far.
+  int busy_threads{};
+  int64_t num_parallel_launches{};
+  int64_t num_parallel_tasks{};
+
+  double mean_run_ms() const { return num_runs ? total_run_ms / num_runs : 0.; }
+};
+
+std::ostream& operator<<(std::ostream& os, const TenantUsage& usage);
+
+/**
+ * A tenant of the process resources, e.g. a model among the many served by one process, whose programs share a thread
+ * budget in the process-wide pool of cinn_backend_parallel_launch and a memory quota of the buffers allocated by the
+ * shared allocators. The resources are charged to the tenant installed on the calling thread by a TenantScope.
+ */
+class Tenant : public std::enable_shared_from_this<Tenant> {
+ public:
+  const std::string& name() const { return name_; }
+  const TenantOptions& options() const { return options_; }
+
+  TenantUsage GetUsage() const;
+
+  //! Charge \p nbytes allocated to the tenant, it fails if the quota is exceeded.
+  void Allocate(size_t nbytes);
+  //! Release \p nbytes charged by Allocate.
+  void Free(size_t nbytes);
+
+  //! Record a run of a program of the tenant.
+  void RecordRun(double ms);
+
+  //! The tenant installed on the calling thread, null if none.
+  static std::shared_ptr<Tenant> Current();
+
+  ~Tenant();
+
+ private:
+  friend class ResourceManager;
+  friend class TenantScope;
+  Tenant(const std::string& name, const TenantOptions& options);
+
+  std::string name_;
+  TenantOptions options_;
+  cinn_thread_budget_t* thread_budget_{nullptr};
+  std::atomic<size_t> allocated_bytes_{0};
+  std::atomic<size_t> peak_allocated_bytes_{0};
+  mutable std::mutex mutex_;
+  int64_t num_runs_{0};
+  double total_run_ms_{0.};
+  double max_run_ms_{0.};
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(Tenant);
+};
+
+/**
+ * TenantScope installs \p tenant on the calling thread while it is alive, so that the parallel kernels launched by the
+ * thread run within the thread budget of the tenant, and the buffers allocated by it are charged to the tenant until
+ * they are freed, on whichever thread. If \p record_run, its lifetime is recorded as a run of the tenant. A null
+ * tenant keeps the one installed already.
+ *
+ *   auto tenant = ResourceManager::Global().Register("ranking", options);
+ *   program->SetTenant(tenant);  // Execute installs it
+ */
+class TenantScope {
+ public:
+  explicit TenantScope(const std::shared_ptr<Tenant>& tenant, bool record_run = false);
+  ~TenantScope();
+
+ private:
+  Tenant* tenant_;
+  Tenant* prev_tenant_{nullptr};
+  cinn_thread_budget_t* prev_budget_{nullptr};
+  bool record_run_;
+  std::chrono::steady_clock::time_point start_;
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(TenantScope);
+};
+
+/**
+ * ResourceManager holds the tenants of the process by their names, and reports their usage.
+ */
+class ResourceManager {
+ public:
+  static ResourceManager& Global();
+
+  //! Register a tenant, or get the registered one of \p name, whose options are kept.
+  std::shared_ptr<Tenant> Register(const std::string& name, const TenantOptions& options = {});
+
+  //! The tenant of \p name, null if not registered.
+  std::shared_ptr<Tenant> Get(const std::string& name) const;
+
+  //! Drop the tenant of \p name, the programs and the buffers holding it keep it alive.
+  void Unregister(const std::string& name);
+
+  //! The usage of each tenant ordered by the names.
+  std::vector<TenantUsage> GetUsage() const;
+
+ private:
+  ResourceManager() = default;
+
+  mutable std::mutex mutex_;
+  std::map<std::string, std::shared_ptr<Tenant>> tenants_;
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(ResourceManager);
+};
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,104 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/resource_manager.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+#include "cinn/hlir/framework/buffer.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+TEST(ResourceManager, register) {
+  TenantOptions options;
+  options.max_threads = 2;
+  auto tenant         = ResourceManager::Global().Register("test_register", options);
+  ASSERT_EQ(tenant->options().max_threads, 2);
+  // registering again gets the same tenant
+  ASSERT_EQ(ResourceManager::Global().Register("test_register"), tenant);
+  ASSERT_EQ(ResourceManager::Global().Get("test_register"), tenant);
+  ResourceManager::Global().Unregister("test_register");
+  ASSERT_EQ(ResourceManager::Global().Get("test_register"), nullptr);
+}
+
+TEST(ResourceManager, memory) {
+  auto tenant = ResourceManager::Global().Register("test_memory");
+  auto other  = ResourceManager::Global().Register("test_memory_other");
+  Buffer a(common::DefaultHostTarget()), b(common::DefaultHostTarget()), c(common::DefaultHostTarget());
+  a.Resize(1024);
+  {
+    TenantScope scope(tenant);
+    ASSERT_EQ(Tenant::Current(), tenant);
+    b.Resize(4096);
+    {
+      TenantScope inner(other);
+      c.Resize(64, 2048);
+    }
+    ASSERT_EQ(Tenant::Current(), tenant);
+    b.Resize(8192);
+  }
+  ASSERT_EQ(Tenant::Current(), nullptr);
+  // the buffer allocated outside the scopes is not charged, and the resized one is charged by its current size
+  auto usage = tenant->GetUsage();
+  ASSERT_EQ(usage.allocated_bytes, 8192);
+  ASSERT_EQ(usage.peak_allocated_bytes, 8192);
+  ASSERT_EQ(other->GetUsage().allocated_bytes, 2048);
+
+  // freed on another thread, the memory is released from the tenant it is charged to
+  std::thread([&] { b.Free(); }).join();
+  c.Free();
+  a.Free();
+  ASSERT_EQ(tenant->GetUsage().allocated_bytes, 0);
+  ASSERT_EQ(tenant->GetUsage().peak_allocated_bytes, 8192);
+  ASSERT_EQ(other->GetUsage().allocated_bytes, 0);
+  {
+    auto buffer = std::make_unique<Buffer>(common::DefaultHostTarget());
+    TenantScope scope(tenant);
+    buffer->Resize(512);
+    ASSERT_EQ(tenant->GetUsage().allocated_bytes, 512);
+  }
+  ASSERT_EQ(tenant->GetUsage().allocated_bytes, 0);
+}
+
+TEST(ResourceManager, threads) {
+  TenantOptions options;
+  options.max_threads = 2;
+  auto tenant         = ResourceManager::Global().Register("test_threads", options);
+  int outside         = max_concurrency();
+  {
+    TenantScope scope(tenant, /*record_run=*/true);
+    ASSERT_LE(max_concurrency(), 2);
+    cinn_backend_parallel_launch([](int task_id, int num_task, void* datas) { return 0; }, nullptr, 8);
+  }
+  ASSERT_EQ(max_concurrency(), outside);
+  auto usage = tenant->GetUsage();
+  ASSERT_EQ(usage.num_runs, 1);
+  ASSERT_EQ(usage.num_parallel_launches, 1);
+  ASSERT_EQ(usage.num_parallel_tasks, 8);
+  ASSERT_EQ(usage.busy_threads, 0);
+  LOG(INFO) << usage;
+
+  auto usages = ResourceManager::Global().GetUsage();
+  ASSERT_TRUE(std::any_of(usages.begin(), usages.end(), [](auto& usage) { return usage.name == "test_threads"; }));
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
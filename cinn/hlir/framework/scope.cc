@@ -14,7 +14,16 @@
 
 #include "cinn/hlir/framework/scope.h"
 
+#include <absl/container/flat_hash_set.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 #include "cinn/common/common.h"
+#ifdef CINN_WITH_CUDA
+#include "cinn/backends/cuda_util.h"
+#endif
 
 namespace cinn {
 namespace hlir {
@@ -33,6 +42,21 @@ Tensor Scope::GetTensor(const std::string& name) const {
   return absl::get<Tensor>(*var);
 }
 
+bool Scope::EraseVar(const std::string& name) {
+  auto it = slot_ids_.find(name);
+  if (it != slot_ids_.end()) slots_[it->second] = nullptr;
+  return data_.erase(name) > 0;
+}
+
+int Scope::Slot(const std::string& name) {
+  auto it = slot_ids_.find(name);
+  if (it != slot_ids_.end()) return it->second;
+  int slot = slots_.size();
+  slots_.push_back(FindVar(name));
+  slot_ids_.emplace(name, slot);
+  return slot;
+}
+
 std::vector<absl::string_view> Scope::var_names() const {
   std::vector<absl::string_view> names;
   for (auto& item : data_) {
@@ -41,6 +65,71 @@ std::vector<absl::string_view> Scope::var_names() const {
   return names;
 }
 
+std::vector<std::pair<std::string, size_t>> Scope::TensorMemorySizes() const {
+  std::vector<std::pair<std::string, size_t>> sizes;
+  for (auto& item : data_) {
+    sizes.emplace_back(item.first, absl::get<Tensor>(*item.second)->memory_bytes());
+  }
+  std::sort(sizes.begin(), sizes.end(), [](const auto& a, const auto& b) {
+    return a.second != b.second ? a.second > b.second : a.first < b.first;
+  });
+  return sizes;
+}
+
+size_t Scope::MemoryBytes() const {
+  size_t bytes = 0;
+  absl::flat_hash_set<cinn_buffer_t*> counted;
+  for (auto& item : data_) {
+    auto& tensor = absl::get<Tensor>(*item.second);
+    if (!tensor->owns_memory() || !counted.insert(tensor->buffer()).second) continue;
+    bytes += tensor->memory_bytes();
+  }
+  return bytes;
+}
+
+std::shared_ptr<Buffer> Scope::PackTensors(const std::vector<std::string>& names, const common::Target& target) {
+  // the range of each buffer in the arena, in the order of the names
+  std::vector<std::pair<Tensor, uint32_t>> packed;
+  absl::flat_hash_set<cinn_buffer_t*> seen;
+  uint64_t size = 0;
+  for (auto& name : names) {
+    auto* var = FindVar(name);
+    if (!var) continue;
+    auto& tensor = absl::get<Tensor>(*var);
+    if (!tensor->buffer()->memory || !seen.insert(tensor->buffer()).second) continue;
+    size = (size + kPackAlignment - 1) / kPackAlignment * kPackAlignment;
+    packed.emplace_back(tensor, size);
+    size += tensor->memory_bytes();
+  }
+  if (packed.empty()) return nullptr;
+  CHECK_LE(size, std::numeric_limits<uint32_t>::max()) << "The packed tensors exceed the size of a buffer";
+
+  auto arena = std::make_shared<Buffer>(target);
+  if (target == common::DefaultHostTarget()) {
+    arena->Resize(kPackAlignment, size);
+  } else {
+    arena->Resize(size);
+  }
+  uint8_t* memory = arena->data()->memory;
+  CHECK(memory) << "Failed to allocate the arena of " << size << " bytes for the packed tensors";
+  for (auto& item : packed) {
+    auto* buffer = item.first->buffer();
+    if (target.arch == common::Target::Arch::NVGPU) {
+#ifdef CINN_WITH_CUDA
+      CUDA_CALL(cudaMemcpy(memory + item.second, buffer->memory, item.first->memory_bytes(), cudaMemcpyDefault));
+#else
+      CINN_NOT_IMPLEMENTED
+#endif
+    } else {
+      std::memcpy(memory + item.second, buffer->memory, item.first->memory_bytes());
+    }
+  }
+  // the tensors sharing the buffers follow them to the arena
+  for (auto& item : packed) item.first->share_external_data(memory + item.second, target, arena);
+  VLOG(3) << "Packed " << packed.size() << " tensors into the arena of " << size << " bytes";
+  return arena;
+}
+
 }  // namespace framework
 }  // namespace hlir
 }  // namespace cinn
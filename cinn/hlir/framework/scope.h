@@ -20,9 +20,12 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "cinn/common/macros.h"
+#include "cinn/common/target.h"
+#include "cinn/hlir/framework/buffer.h"
 #include "cinn/hlir/framework/tensor.h"
 
 namespace cinn {
@@ -46,13 +49,50 @@ class Scope {
 
   Tensor GetTensor(const std::string& name) const;
 
+  //! Remove a variable, the tensor is released if no one else holds it. Return false if not exists.
+  bool EraseVar(const std::string& name);
+
+  /**
+   * Get the dense integer slot of the variable \p name, it is assigned on the first call in order and stays the same
+   * when the variable is erased and created again, so the name can be resolved once and the variable is looked up by
+   * VarAt without hashing the name. The name need not exist yet. It is not thread safe while assigning, so the slots
+   * are resolved before running, e.g. at the construction of the Program.
+   */
+  int Slot(const std::string& name);
+
+  //! The variable of \p slot, null if it doesn't exist now.
+  Variable* VarAt(int slot) const { return slots_[slot]; }
+
+  int num_slots() const { return slots_.size(); }
+
   //! Get variable names.
   std::vector<absl::string_view> var_names() const;
 
+  //! Get the number of bytes of memory each tensor holds, in descending order of the size.
+  std::vector<std::pair<std::string, size_t>> TensorMemorySizes() const;
+
+  //! Get the total number of bytes of memory owned by the tensors, the buffers shared by tensors are counted once.
+  size_t MemoryBytes() const;
+
+  //! The alignment of the offsets of the tensors packed by PackTensors.
+  static constexpr uint32_t kPackAlignment = 256;
+
+  /**
+   * Pack the tensors of \p names into one arena on \p target in the order given, each at an offset aligned to
+   * kPackAlignment, and let them refer to it instead of their own buffers, e.g. the parameters of a program, so that
+   * they are one allocation instead of one each. Their data are copied into the arena, the tensors sharing a buffer
+   * get one range, and the tensors without memory are skipped. The tensors keep the arena alive.
+   * @return The arena, null if none of the tensors holds memory.
+   */
+  std::shared_ptr<Buffer> PackTensors(const std::vector<std::string>& names, const common::Target& target);
+
   Scope() = default;
 
  private:
   absl::flat_hash_map<std::string, std::unique_ptr<Variable>> data_;
+  // The variable of each slot and the slot of each name.
+  std::vector<Variable*> slots_;
+  absl::flat_hash_map<std::string, int> slot_ids_;
 
   CINN_DISALLOW_COPY_AND_ASSIGN(Scope);
 };
@@ -64,6 +104,8 @@ Variable* Scope::Var(const std::string& name) {
   if (x) return x;
   auto* data = new Variable(T());
   data_[name].reset(data);
+  auto it = slot_ids_.find(name);
+  if (it != slot_ids_.end()) slots_[it->second] = data;
   return data;
 }
 
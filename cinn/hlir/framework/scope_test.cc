@@ -31,6 +31,50 @@ TEST(Scope, basic) {
   data[2]    = 2.f;
 }
 
+TEST(Scope, memory_bytes) {
+  Scope scope;
+  auto new_tensor = [&](const std::string& name, int numel) {
+    auto& tensor = absl::get<Tensor>(*scope.Var<Tensor>(name));
+    tensor->Resize(Shape{{numel}});
+    tensor->mutable_data<float>(common::DefaultHostTarget());
+    return tensor;
+  };
+  new_tensor("a", 10);
+  auto b = new_tensor("b", 20);
+  auto& c = absl::get<Tensor>(*scope.Var<Tensor>("c"));
+  c->Resize(Shape{{20}});
+  c->ShareBufferWith(*b);
+
+  auto sizes = scope.TensorMemorySizes();
+  ASSERT_EQ(sizes.size(), 3UL);
+  ASSERT_EQ(sizes[0], std::make_pair(std::string("b"), 20 * sizeof(float)));
+  ASSERT_EQ(sizes[1], std::make_pair(std::string("c"), 20 * sizeof(float)));
+  ASSERT_EQ(sizes[2], std::make_pair(std::string("a"), 10 * sizeof(float)));
+  // The buffer shared by b and c is counted once.
+  ASSERT_EQ(scope.MemoryBytes(), 30 * sizeof(float));
+}
+
+TEST(Scope, slots) {
+  Scope scope;
+  scope.Var<Tensor>("a");
+  int a = scope.Slot("a");
+  int b = scope.Slot("b");
+  ASSERT_EQ(a, 0);
+  ASSERT_EQ(b, 1);
+  ASSERT_EQ(scope.Slot("a"), a);
+  ASSERT_EQ(scope.num_slots(), 2);
+  ASSERT_EQ(scope.VarAt(a), scope.FindVar("a"));
+  // the variables created, erased and created again after the slot is assigned
+  ASSERT_EQ(scope.VarAt(b), nullptr);
+  auto* var_b = scope.Var<Tensor>("b");
+  ASSERT_EQ(scope.VarAt(b), var_b);
+  ASSERT_TRUE(scope.EraseVar("b"));
+  ASSERT_EQ(scope.VarAt(b), nullptr);
+  ASSERT_EQ(scope.Slot("b"), b);
+  var_b = scope.Var<Tensor>("b");
+  ASSERT_EQ(scope.VarAt(b), var_b);
+}
+
 }  // namespace framework
 }  // namespace hlir
 }  // namespace cinn
@@ -72,6 +72,71 @@ class _Tensor_ : public Object {
     return reinterpret_cast<T*>(buffer_->data()->memory);
   }
 
+  /**
+   * Let the tensor refer to the external \p memory without owning it, e.g. a slice of a memory arena. The memory should
+   * be large enough to hold all the elements. The tensor keeps \p owner alive as long as it refers to the memory.
+   */
+  template <typename T>
+  inline T* share_external_data(uint8_t* memory, const Target& target, std::shared_ptr<void> owner = nullptr) {
+    set_type(type_of<T>());
+    buffer_->ShareExternalMemory(memory, shape_.numel() * sizeof(T), target, std::move(owner));
+    return reinterpret_cast<T*>(memory);
+  }
+
+  /**
+   * Allocate the memory by the element size of the type of the tensor, which BuildScope sets by the inferred dtype,
+   * e.g. 8 bytes per element of int64 and 1 byte of bool. The tensors of unknown types are allocated as float32.
+   */
+  inline uint8_t* mutable_data(const Target& target) {
+    if (!has_type()) return reinterpret_cast<uint8_t*>(mutable_data<float>(target));
+    if (target == common::DefaultHostTarget()) {
+      buffer_->ResizeLazy(1024, num_bytes(), target);
+    } else {
+      buffer_->ResizeLazy(num_bytes(), target);
+    }
+    return buffer_->data()->memory;
+  }
+
+  //! Refer to the external \p memory like share_external_data<T>, by the element size of the tensor.
+  inline uint8_t* share_external_data(uint8_t* memory, const Target& target, std::shared_ptr<void> owner = nullptr) {
+    if (!has_type()) return reinterpret_cast<uint8_t*>(share_external_data<float>(memory, target, std::move(owner)));
+    buffer_->ShareExternalMemory(memory, num_bytes(), target, std::move(owner));
+    return memory;
+  }
+
+  /**
+   * Let the tensor refer to the memory of \p other from \p offset bytes on, keeping its own shape, e.g. a contiguous
+   * slice of its parent. The memory of \p other should be allocated and hold all the elements of the slice.
+   */
+  inline uint8_t* ShareSliceOf(const _Tensor_& other, uint32_t offset, const Target& target) {
+    auto* memory = other.buffer_->data()->memory;
+    CHECK(memory) << "The parent of the slice is not allocated";
+    CHECK_LE(offset + num_bytes(), other.memory_bytes()) << "The slice is out of its parent";
+    return share_external_data(memory + offset, target);
+  }
+
+  //! The bytes each element takes in the buffer.
+  size_t element_bytes() const { return has_type() ? (type_.bits() + 7) / 8 : sizeof(float); }
+
+  //! The bytes of the elements of the shape, which the memory allocated may exceed, see memory_bytes.
+  size_t num_bytes() const { return shape_.numel() * element_bytes(); }
+
+  /**
+   * Let the tensor share the buffer of \p other, so that both of them always refer to the same memory, e.g. the output
+   * of an op written in place of its input. The two tensors should have the same shape and type.
+   */
+  void ShareBufferWith(const _Tensor_& other) {
+    type_   = other.type_;
+    buffer_ = other.buffer_;
+  }
+
+  //! Tell whether the tensor shares the buffer with \p other.
+  bool SharesBufferWith(const _Tensor_& other) const { return buffer_ == other.buffer_; }
+
+  //! Free the memory of the tensor, or stop referring to the external memory, keeping its shape and type, so that
+  //! mutable_data allocates it again.
+  void FreeMemory() { buffer_->Free(); }
+
   template <typename T>
   const T* data() const {
     return reinterpret_cast<T*>(buffer_->data()->memory);
@@ -84,9 +149,23 @@ class _Tensor_ : public Object {
 
   cinn_buffer_t* buffer() { return buffer_->data(); }
 
+  //! Number of bytes of the memory the tensor holds, including the external memory it refers to.
+  size_t memory_bytes() const { return buffer_->size(); }
+
+  //! Whether the memory is owned by the tensor rather than referred from others, e.g. a memory arena.
+  bool owns_memory() const { return !buffer_->is_external(); }
+
+  //! The place where the memory of the tensor locates.
+  const Target& target() const { return buffer_->target(); }
+
+  //! Order the later allocations and the free of the memory on \p stream, see Buffer::SetStream.
+  void SetStream(void* stream) { buffer_->SetStream(stream); }
+
   const char* type_info() const override { return __type_info__; }
 
  private:
+  bool has_type() const { return type_.valid() && !type_.is_unk() && !type_.is_void(); }
+
   common::Type type_;
   // A shared ptr to make it easier to share buffer between tensors.
   std::shared_ptr<Buffer> buffer_;
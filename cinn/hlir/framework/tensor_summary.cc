@@ -0,0 +1,106 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/tensor_summary.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#ifdef CINN_WITH_CUDA
+#include "cinn/backends/cuda_util.h"
+#endif
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+namespace {
+
+constexpr int kLanes = 16;
+// The partial sums of the lanes are flushed to double every this many floats to bound the rounding error.
+constexpr int64_t kFlushSize = 4096;
+
+}  // namespace
+
+std::string TensorSummary::DebugString() const {
+  std::stringstream ss;
+  ss << "numel " << numel << ", sum " << sum << ", min " << min << ", max " << max << ", nan " << nan_count << ", inf "
+     << inf_count;
+  return ss.str();
+}
+
+TensorSummary SummarizeFloats(const float* data, int64_t numel) {
+  TensorSummary res;
+  res.numel = numel;
+  float mins[kLanes], maxs[kLanes], sums[kLanes];
+  int64_t nans[kLanes], infs[kLanes];
+  std::fill(mins, mins + kLanes, res.min);
+  std::fill(maxs, maxs + kLanes, res.max);
+  std::fill(nans, nans + kLanes, 0);
+  std::fill(infs, infs + kLanes, 0);
+  int64_t i = 0;
+  // tell the non-finite elements by their bits, which still works with -ffast-math
+  auto visit = [&](int lane, float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    bool non_finite = (bits & 0x7f800000u) == 0x7f800000u;
+    bool is_nan     = non_finite && (bits & 0x007fffffu);
+    nans[lane] += is_nan;
+    infs[lane] += non_finite && !is_nan;
+    sums[lane] += non_finite ? 0.f : v;
+    mins[lane] = std::min(mins[lane], non_finite ? res.min : v);
+    maxs[lane] = std::max(maxs[lane], non_finite ? res.max : v);
+  };
+  while (i + kLanes <= numel) {
+    std::fill(sums, sums + kLanes, 0.f);
+    int64_t end = std::min(numel - numel % kLanes, i + kFlushSize);
+    for (; i < end; i += kLanes) {
+      for (int lane = 0; lane < kLanes; lane++) visit(lane, data[i + lane]);
+    }
+    for (int lane = 0; lane < kLanes; lane++) res.sum += sums[lane];
+  }
+  std::fill(sums, sums + kLanes, 0.f);
+  for (int lane = 0; i < numel; i++, lane++) visit(lane, data[i]);
+  for (int lane = 0; lane < kLanes; lane++) {
+    res.sum += sums[lane];
+    res.nan_count += nans[lane];
+    res.inf_count += infs[lane];
+    res.min = std::min(res.min, mins[lane]);
+    res.max = std::max(res.max, maxs[lane]);
+  }
+  return res;
+}
+
+TensorSummary SummarizeBuffer(const cinn_buffer_t& buffer, const common::Target& target) {
+  CHECK(buffer.memory) << "The buffer to summarize is not allocated";
+  int64_t numel = buffer.num_elements();
+  if (target.arch != common::Target::Arch::NVGPU) {
+    return SummarizeFloats(reinterpret_cast<const float*>(buffer.memory), numel);
+  }
+  std::vector<float> host(numel);
+#ifdef CINN_WITH_CUDA
+  CUDA_CALL(cudaMemcpy(host.data(), buffer.memory, numel * sizeof(float), cudaMemcpyDeviceToHost));
+#else
+  LOG(FATAL) << "CINN is not built with CUDA to summarize the buffers on NVGPU";
+#endif
+  return SummarizeFloats(host.data(), numel);
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
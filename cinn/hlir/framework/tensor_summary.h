@@ -0,0 +1,53 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "cinn/common/target.h"
+#include "cinn/runtime/cinn_runtime.h"
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+/**
+ * The checksum of the elements of a float tensor, the sum, min and max are of the finite elements only, so that a
+ * few NaNs or Infs don't hide the range of the rest.
+ */
+struct TensorSummary {
+  int64_t numel{0};
+  int64_t nan_count{0};
+  int64_t inf_count{0};
+  double sum{0.};
+  float min{std::numeric_limits<float>::infinity()};
+  float max{-std::numeric_limits<float>::infinity()};
+
+  bool all_finite() const { return nan_count == 0 && inf_count == 0; }
+
+  std::string DebugString() const;
+};
+
+//! Summarize the \p numel floats of \p data on host. The loop is written in lanes of plain arrays to be vectorized.
+TensorSummary SummarizeFloats(const float* data, int64_t numel);
+
+//! Summarize the float32 \p buffer on \p target, the device memory is copied to host first.
+TensorSummary SummarizeBuffer(const cinn_buffer_t& buffer, const common::Target& target);
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,64 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/framework/tensor_summary.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace cinn {
+namespace hlir {
+namespace framework {
+
+TEST(TensorSummary, basic) {
+  // not a multiple of the lanes, and longer than a flush
+  std::vector<float> data(5003);
+  for (int i = 0; i < data.size(); i++) data[i] = i % 7 - 3;
+  data[10]   = std::numeric_limits<float>::quiet_NaN();
+  data[4999] = std::numeric_limits<float>::infinity();
+  data[5002] = -std::numeric_limits<float>::infinity();
+
+  double sum = 0;
+  for (int i = 0; i < data.size(); i++) {
+    if (std::isfinite(data[i])) sum += data[i];
+  }
+  auto summary = SummarizeFloats(data.data(), data.size());
+  ASSERT_EQ(summary.numel, 5003);
+  ASSERT_EQ(summary.nan_count, 1);
+  ASSERT_EQ(summary.inf_count, 2);
+  ASSERT_FALSE(summary.all_finite());
+  ASSERT_DOUBLE_EQ(summary.sum, sum);
+  ASSERT_EQ(summary.min, -3);
+  ASSERT_EQ(summary.max, 3);
+}
+
+TEST(TensorSummary, buffer) {
+  std::vector<float> data({1.5, -2, 4});
+  cinn_buffer_t buffer;
+  cinn_dimension_t dims[] = {3};
+  buffer.resize(dims, 1);
+  buffer.memory = reinterpret_cast<uint8_t*>(data.data());
+  auto summary  = SummarizeBuffer(buffer, common::DefaultHostTarget());
+  ASSERT_TRUE(summary.all_finite());
+  ASSERT_EQ(summary.sum, 3.5);
+  ASSERT_EQ(summary.min, -2);
+  ASSERT_EQ(summary.max, 4);
+}
+
+}  // namespace framework
+}  // namespace hlir
+}  // namespace cinn
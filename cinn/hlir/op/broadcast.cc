@@ -83,8 +83,8 @@ std::shared_ptr<OpStrategy> StrategyForBroadcast(
     poly::StageMap stages = arg_pack[1];
     CHECK(Out.as_tensor());
     if (target.arch == Target::Arch::NVGPU) {
-      pe::CudaScheduleInjective(stages[Out.as_tensor_ref()], output_shapes.front(), target);
-    } else if (target.arch == Target::Arch::X86) {
+      pe::CudaScheduleBroadcast(stages[Out.as_tensor_ref()], output_shapes.front(), target);
+    } else if (target.is_cpu()) {
       pe::ScheduleInjectiveCPU(stages[Out.as_tensor_ref()], output_shapes.front(), target);
     }
     *ret = arg_pack;
@@ -196,8 +196,8 @@ std::shared_ptr<OpStrategy> StrategyForBroadcastTo(const framework::NodeAttr &at
     poly::StageMap stages = arg_pack.back();
     CHECK(Out.as_tensor());
     if (target.arch == Target::Arch::NVGPU) {
-      pe::CudaScheduleInjective(stages[Out.as_tensor_ref()], out_shape, target);
-    } else if (target.arch == Target::Arch::X86) {
+      pe::CudaScheduleBroadcast(stages[Out.as_tensor_ref()], out_shape, target);
+    } else if (target.is_cpu()) {
       pe::ScheduleInjectiveCPU(stages[Out.as_tensor_ref()], out_shape, target);
     }
     *ret = arg_pack;
@@ -373,7 +373,8 @@ CINN_REGISTER_HELPER(broadcast_grad_ops) {
       .set_num_outputs(2)
       .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForBroadcastGrad)
       .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForBroadcastGrad))
-      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForBroadcastGrad));
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForBroadcastGrad))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kBroadcast);
 
   return true;
 }
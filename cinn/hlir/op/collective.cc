@@ -0,0 +1,196 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/op_strategy.h"
+#include "cinn/hlir/op/op_util.h"
+#include "cinn/hlir/pe/schedule.h"
+#include "cinn/ir/ir_operators.h"
+
+namespace cinn {
+namespace hlir {
+namespace op {
+using common::CINNValue;
+using common::CINNValuePack;
+using framework::OpStrategy;
+using framework::shape_t;
+using framework::StrategyFunction;
+
+/**
+ * The collectives run on the ranks of a ring, given by the attributes ring_id and nranks(1 by default), and the
+ * reductions by reduce_type, "sum"(by default), "max", "min" or "prod". On NVGPU built with NCCL, they are run by the
+ * NCCL calls on the communicators registered for their rings, see runtime::cuda::NcclComms. The kernels lowered
+ * here compute the result of a single rank, which is exact for nranks = 1 and is only the fallback of the NCCL calls.
+ */
+namespace {
+
+int GetNumRanks(const framework::AttrMapType &attrs) {
+  int nranks = attrs.count("nranks") ? absl::get<int>(attrs.at("nranks")) : 1;
+  CHECK_GT(nranks, 0) << "The number of ranks should be positive";
+  return nranks;
+}
+
+void CheckReduceType(const framework::AttrMapType &attrs) {
+  if (!attrs.count("reduce_type")) return;
+  auto &type = absl::get<std::string>(attrs.at("reduce_type"));
+  CHECK(type == "sum" || type == "max" || type == "min" || type == "prod") << "Unsupported reduce_type " << type;
+}
+
+using CollectiveFunc = std::function<Expr(const ir::Tensor &, const std::vector<Expr> &)>;
+
+// The strategy computing each element of the output from the input of the rank by \p func.
+std::shared_ptr<OpStrategy> MakeCollectiveStrategy(const std::string &op_name,
+                                                   const std::vector<std::vector<int>> &output_shapes,
+                                                   const Target &target,
+                                                   CollectiveFunc func) {
+  framework::CINNCompute compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of " << op_name << " compute is empty! Please check.";
+    CINNValuePack a = args[0];
+    CHECK(!a.empty()) << "The input tensors of " << op_name << " compute is empty! Please check.";
+    Expr A_expr = a[0];
+    CHECK(A_expr.as_tensor());
+    ir::Tensor A = A_expr.as_tensor_ref();
+    auto out     = Compute(
+        ToCinnExprs(output_shapes.front()),
+        [=](const std::vector<Expr> &indice) { return func(A, indice); },
+        UniqName(op_name + "_out"));
+    auto stages = CreateStages({A, out});
+    *ret        = CINNValuePack{{CINNValue(Expr(out.get())), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of " << op_name << " schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 2UL);
+    Expr out              = arg_pack[0];
+    poly::StageMap stages = arg_pack[1];
+    CHECK(out.as_tensor());
+    if (target.arch == Target::Arch::NVGPU) {
+      pe::CudaScheduleInjective(stages[out.as_tensor_ref()], output_shapes.front(), target);
+    } else if (target.is_cpu()) {
+      pe::ScheduleInjectiveCPU(stages[out.as_tensor_ref()], output_shapes.front(), target);
+    }
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(compute, schedule, "strategy." + op_name + ".x86", 1);
+  return strategy;
+}
+
+}  // namespace
+
+std::shared_ptr<OpStrategy> StrategyForAllReduce(const framework::NodeAttr &attrs,
+                                                 const std::vector<ir::Tensor> &inputs,
+                                                 const std::vector<Type> &out_type,
+                                                 const std::vector<std::vector<int>> &output_shapes,
+                                                 const Target &target) {
+  return MakeCollectiveStrategy(
+      "allreduce", output_shapes, target, [](const ir::Tensor &A, const std::vector<Expr> &indice) {
+        return A(indice);
+      });
+}
+
+std::shared_ptr<OpStrategy> StrategyForAllGather(const framework::NodeAttr &attrs,
+                                                 const std::vector<ir::Tensor> &inputs,
+                                                 const std::vector<Type> &out_type,
+                                                 const std::vector<std::vector<int>> &output_shapes,
+                                                 const Target &target) {
+  // every rank gets the slice of its own
+  return MakeCollectiveStrategy(
+      "allgather", output_shapes, target, [](const ir::Tensor &A, const std::vector<Expr> &indice) {
+        auto in_indice = indice;
+        in_indice[0]   = indice[0] % A->shape[0];
+        return A(in_indice);
+      });
+}
+
+std::shared_ptr<OpStrategy> StrategyForReduceScatter(const framework::NodeAttr &attrs,
+                                                     const std::vector<ir::Tensor> &inputs,
+                                                     const std::vector<Type> &out_type,
+                                                     const std::vector<std::vector<int>> &output_shapes,
+                                                     const Target &target) {
+  // the rank keeps the first slice of its input
+  return MakeCollectiveStrategy(
+      "reduce_scatter", output_shapes, target, [](const ir::Tensor &A, const std::vector<Expr> &indice) {
+        return A(indice);
+      });
+}
+
+std::vector<shape_t> InferShapeForAllReduce(const std::vector<shape_t> &inputs_shape,
+                                            const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 1UL) << "The allreduce should have 1 input";
+  CheckReduceType(attrs);
+  return {inputs_shape[0]};
+}
+
+std::vector<shape_t> InferShapeForAllGather(const std::vector<shape_t> &inputs_shape,
+                                            const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 1UL) << "The allgather should have 1 input";
+  CHECK(!inputs_shape[0].empty()) << "The input of allgather should not be a scalar";
+  auto shape = inputs_shape[0];
+  shape[0] *= GetNumRanks(attrs);
+  return {shape};
+}
+
+std::vector<shape_t> InferShapeForReduceScatter(const std::vector<shape_t> &inputs_shape,
+                                                const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 1UL) << "The reduce_scatter should have 1 input";
+  CHECK(!inputs_shape[0].empty()) << "The input of reduce_scatter should not be a scalar";
+  CheckReduceType(attrs);
+  auto shape = inputs_shape[0];
+  int nranks = GetNumRanks(attrs);
+  CHECK_EQ(shape[0] % nranks, 0) << "The first dimension " << shape[0] << " can't be scattered to " << nranks
+                                 << " ranks";
+  shape[0] /= nranks;
+  return {shape};
+}
+
+std::vector<Type> InferDtypeForCollective(const std::vector<Type> &inputs_type, const framework::AttrMapType &attrs) {
+  CHECK(!inputs_type.empty()) << "The input's type size is 0! Please check again.";
+  return {inputs_type[0]};
+}
+
+}  // namespace op
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(collective_ops) {
+#define CINN_REGISTER_COLLECTIVE(op__, op_strategy__, description__)                                                 \
+  CINN_REGISTER_OP(op__)                                                                                             \
+      .describe(description__)                                                                                       \
+      .set_num_inputs(1)                                                                                             \
+      .set_num_outputs(1)                                                                                            \
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyFor##op_strategy__) \
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeFor##op_strategy__))                          \
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForCollective))                               \
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)    \
+      .set_support_level(4);
+
+  CINN_REGISTER_COLLECTIVE(allreduce, AllReduce, "Reduce the tensors of all the ranks, every rank gets the result.");
+  CINN_REGISTER_COLLECTIVE(
+      allgather, AllGather, "Concatenate the tensors of all the ranks along the first dimension in the rank order.");
+  CINN_REGISTER_COLLECTIVE(reduce_scatter,
+                           ReduceScatter,
+                           "Reduce the tensors of all the ranks, and each rank gets its slice of the result along "
+                           "the first dimension.");
+
+#undef CINN_REGISTER_COLLECTIVE
+
+  return true;
+}
@@ -78,7 +78,7 @@ std::shared_ptr<OpStrategy> StrategyForElementwise(const framework::NodeAttr &at
     CHECK(Out.as_tensor());
     if (target.arch == Target::Arch::NVGPU) {
       pe::CudaScheduleInjective(stages[Out.as_tensor_ref()], output_shapes.front(), target);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       pe::ScheduleInjectiveCPU(stages[Out.as_tensor_ref()], output_shapes.front(), target);
     }
     *ret = arg_pack;
@@ -157,7 +157,7 @@ std::shared_ptr<OpStrategy> StrategyForScale(const framework::NodeAttr &attrs,
     CHECK(Out.as_tensor());
     if (target.arch == Target::Arch::NVGPU) {
       pe::CudaScheduleInjective(stages[Out.as_tensor_ref()], output_shapes.front(), target);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       pe::ScheduleInjectiveCPU(stages[Out.as_tensor_ref()], output_shapes.front(), target);
     }
     *ret = arg_pack;
@@ -169,6 +169,98 @@ std::shared_ptr<OpStrategy> StrategyForScale(const framework::NodeAttr &attrs,
   return strategy;
 }
 
+std::shared_ptr<OpStrategy> StrategyForCast(const framework::NodeAttr &attrs,
+                                            const std::vector<ir::Tensor> &inputs,
+                                            const std::vector<Type> &out_type,
+                                            const std::vector<std::vector<int>> &output_shapes,
+                                            const Target &target) {
+  CHECK(!out_type.empty()) << "The output type of cast is empty! Please check.";
+  Type dtype = out_type[0];
+  framework::CINNCompute cast_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of cast compute is empty! Please check.";
+    CINNValuePack a = args[0];
+    CHECK(!a.empty()) << "The input tensors of cast compute is empty! Please check.";
+    Expr A_expr = a[0];
+    CHECK(A_expr.as_tensor());
+    ir::Tensor A = A_expr.as_tensor_ref();
+    auto out     = pe::Cast(A, dtype, UniqName("Cast_out"));
+    auto stages  = CreateStages({out});
+    *ret         = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule cast_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of cast schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 2UL);
+    Expr Out              = arg_pack[0];
+    poly::StageMap stages = arg_pack[1];
+    CHECK(Out.as_tensor());
+    if (target.arch == Target::Arch::NVGPU) {
+      pe::CudaScheduleInjective(stages[Out.as_tensor_ref()], output_shapes.front(), target);
+    } else if (target.is_cpu()) {
+      pe::ScheduleInjectiveCPU(stages[Out.as_tensor_ref()], output_shapes.front(), target);
+    }
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(cast_compute, cast_schedule, "strategy.cast.x86", 1);
+
+  return strategy;
+}
+
+std::vector<Type> InferDtypeForCast(const std::vector<Type> &inputs_type, const framework::AttrMapType &attrs) {
+  CHECK(attrs.count("dtype")) << "The cast op should have the attr dtype! Please check.";
+  return {common::Str2Type(absl::get<std::string>(attrs.at("dtype")))};
+}
+
+std::shared_ptr<OpStrategy> StrategyForQuantize(const framework::NodeAttr &attrs,
+                                                const std::vector<ir::Tensor> &inputs,
+                                                const std::vector<Type> &out_type,
+                                                const std::vector<std::vector<int>> &output_shapes,
+                                                const Target &target) {
+  CHECK(attrs.attr_store.count("scale")) << "The quantize op should have the attr scale! Please check.";
+  float scale = absl::get<float>(attrs.attr_store.at("scale"));
+  CHECK_GT(scale, 0.f) << "The scale of quantize should be positive! Please check.";
+  framework::CINNCompute quantize_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of quantize compute is empty! Please check.";
+    CINNValuePack a = args[0];
+    CHECK(!a.empty()) << "The input tensors of quantize compute is empty! Please check.";
+    Expr A_expr = a[0];
+    CHECK(A_expr.as_tensor());
+    ir::Tensor A = A_expr.as_tensor_ref();
+    auto out     = pe::Quantize(A, scale, UniqName("Quantize_out"));
+    auto stages  = CreateStages({out});
+    *ret         = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule quantize_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of quantize schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 2UL);
+    Expr Out              = arg_pack[0];
+    poly::StageMap stages = arg_pack[1];
+    CHECK(Out.as_tensor());
+    if (target.arch == Target::Arch::NVGPU) {
+      pe::CudaScheduleInjective(stages[Out.as_tensor_ref()], output_shapes.front(), target);
+    } else if (target.is_cpu()) {
+      pe::ScheduleInjectiveCPU(stages[Out.as_tensor_ref()], output_shapes.front(), target);
+    }
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(quantize_compute, quantize_schedule, "strategy.quantize.x86", 1);
+
+  return strategy;
+}
+
+std::vector<Type> InferDtypeForQuantize(const std::vector<Type> &inputs_type, const framework::AttrMapType &attrs) {
+  CHECK(!inputs_type.empty()) << "The input's type size is 0! Please check again.";
+  CHECK(inputs_type[0].is_float(32)) << "The input of quantize should be float32! Please check.";
+  return {Int(8)};
+}
+
 Expr GetScalarExpr(const framework::NodeAttr::attr_t &attr) {
   Expr scalar;
   struct Visitor {
@@ -211,7 +303,7 @@ std::shared_ptr<OpStrategy> StrategyForConstScalar(const framework::NodeAttr &at
     CHECK(Out.as_tensor());
     if (target.arch == Target::Arch::NVGPU) {
       pe::CudaScheduleInjective(stages[Out.as_tensor_ref()], output_shapes.front(), target);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       pe::ScheduleInjectiveCPU(stages[Out.as_tensor_ref()], output_shapes.front(), target);
     }
     *ret = arg_pack;
@@ -313,7 +405,7 @@ std::shared_ptr<OpStrategy> StrategyForFillConstant(const framework::NodeAttr &a
     CHECK(Out.as_tensor());
     if (target.arch == Target::Arch::NVGPU) {
       pe::CudaScheduleInjective(stages[Out.as_tensor_ref()], output_shapes.front(), target);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       pe::ScheduleInjectiveCPU(stages[Out.as_tensor_ref()], output_shapes.front(), target);
     }
     *ret = arg_pack;
@@ -348,6 +440,75 @@ std::vector<std::vector<std::string>> InferLayoutForFillConstant(const std::vect
   return {{""}, input_layouts};
 }
 
+std::shared_ptr<OpStrategy> StrategyForGelu(const framework::NodeAttr &attrs,
+                                            const std::vector<ir::Tensor> &inputs,
+                                            const std::vector<Type> &out_type,
+                                            const std::vector<std::vector<int>> &output_shapes,
+                                            const Target &target) {
+  bool approximate = false;
+  if (attrs.attr_store.count("approximate")) {
+    approximate = absl::get<bool>(attrs.attr_store.at("approximate"));
+  }
+  framework::CINNCompute gelu_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of gelu compute is empty! Please check.";
+    CINNValuePack pack_args = args[0];
+    CHECK_GE(pack_args.size(), 1U) << "1 input tensor for gelu compute\n";
+    Expr A_expr = pack_args[0];
+    CHECK(A_expr.as_tensor());
+    ir::Tensor A = A_expr.as_tensor_ref();
+    // the optional second input is the bias
+    ir::Tensor out;
+    if (pack_args.size() > 1) {
+      Expr bias = pack_args[1];
+      CHECK(bias.as_tensor());
+      out = pe::BiasGelu(A, bias.as_tensor_ref(), approximate, UniqName("Gelu_out"));
+    } else {
+      out = pe::Gelu(A, approximate, UniqName("Gelu_out"));
+    }
+    auto stages = CreateStages({out});
+    *ret        = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule gelu_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of gelu schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 2UL);
+    Expr Out              = arg_pack[0];
+    poly::StageMap stages = arg_pack[1];
+    CHECK(Out.as_tensor());
+    if (target.arch == Target::Arch::NVGPU) {
+      pe::CudaScheduleInjective(stages[Out.as_tensor_ref()], output_shapes.front(), target);
+    } else if (target.is_cpu()) {
+      pe::ScheduleInjectiveCPU(stages[Out.as_tensor_ref()], output_shapes.front(), target);
+    }
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(gelu_compute, gelu_schedule, "strategy.gelu.x86", 1);
+  return strategy;
+}
+
+std::vector<shape_t> InferShapeForBiasGelu(const std::vector<shape_t> &inputs_shape,
+                                           const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 2UL) << "The inputs of bias_gelu should be the input and the bias";
+  CHECK_LE(inputs_shape[1].size(), inputs_shape[0].size()) << "The bias of bias_gelu is of higher rank than its input";
+  int offset = inputs_shape[0].size() - inputs_shape[1].size();
+  for (int i = 0; i < inputs_shape[1].size(); i++) {
+    CHECK(inputs_shape[1][i] == 1 || inputs_shape[1][i] == inputs_shape[0][offset + i])
+        << "The bias of bias_gelu can't be broadcast to the trailing axes of its input";
+  }
+  return {inputs_shape[0]};
+}
+
+std::vector<std::vector<std::string>> InferLayoutForBiasGelu(const std::vector<framework::shape_t> &input_shapes,
+                                                             const std::vector<std::string> &input_layouts,
+                                                             const framework::NodeAttr &attrs,
+                                                             const Target &target) {
+  CHECK_EQ(input_layouts.size(), 2U) << "The input's layouts size is not 2! Please check again.";
+  return {{input_layouts[0]}, input_layouts};
+}
+
 StrategyForUnary(exp, Exp);
 StrategyForUnary(erf, Erf);
 StrategyForUnary(sqrt, Sqrt);
@@ -454,6 +615,50 @@ CINN_REGISTER_HELPER(elementwise_ops) {
       .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kElemWise)
       .set_support_level(4);
 
+  CINN_REGISTER_OP(gelu)
+      .describe("The GELU activation, by the erf or by its tanh approximation if the attr approximate")
+      .set_num_inputs(1)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForGelu)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForElementwise))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForElementwise))
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForElementwise))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kElemWise)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(bias_gelu)
+      .describe("The GELU activation of the input plus the bias broadcast to its trailing axes")
+      .set_num_inputs(2)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForGelu)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForBiasGelu))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForElementwise))
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForBiasGelu))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kBroadcast)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(cast)
+      .describe("Cast the input Tensor to the type given by the attr dtype, e.g. float16")
+      .set_num_inputs(1)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForCast)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForElementwise))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForCast))
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForElementwise))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kElemWise)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(quantize)
+      .describe("Quantize the float32 input Tensor to int8 by the attr scale")
+      .set_num_inputs(1)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForQuantize)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForElementwise))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForQuantize))
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForElementwise))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kElemWise)
+      .set_support_level(4);
+
   CINN_REGISTER_OP(const_scalar)
       .describe("create const scalar with the given value")
       .set_num_inputs(0)
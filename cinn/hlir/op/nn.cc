@@ -14,7 +14,9 @@
 
 #include "cinn/hlir/pe/nn.h"
 
+#include <algorithm>
 #include <functional>
+#include <numeric>
 
 #include "cinn/hlir/framework/node.h"
 #include "cinn/hlir/framework/op.h"
@@ -61,7 +63,7 @@ std::shared_ptr<OpStrategy> StrategyForRelu(const framework::NodeAttr &attrs,
       poly::StageMap stages = arg_pack[1];
       CHECK(out.as_tensor());
       pe::CudaScheduleInjective(stages[out.as_tensor_ref()], output_shapes.front(), target);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       Expr out              = arg_pack[0];
       poly::StageMap stages = arg_pack[1];
       CHECK(out.as_tensor());
@@ -118,7 +120,7 @@ std::shared_ptr<OpStrategy> StrategyForRelu6(const framework::NodeAttr &attrs,
       poly::StageMap stages = arg_pack[1];
       CHECK(out.as_tensor());
       pe::CudaScheduleInjective(stages[out.as_tensor_ref()], output_shapes.front(), target);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       Expr out              = arg_pack[0];
       poly::StageMap stages = arg_pack[1];
       CHECK(out.as_tensor());
@@ -181,6 +183,49 @@ std::shared_ptr<OpStrategy> StrategyForConv2d(const framework::NodeAttr &attrs,
 #ifndef CINN_WITH_CUDNN
   CHECK_EQ(conv_type, "forward") << "cudnn is not found, backward_data/backward_filter is not supported!";
 #endif
+  auto to_int_shape = [](const ir::Tensor &tensor) {
+    std::vector<int> shape;
+    for (auto &dim : tensor->shape) shape.push_back(dim.is_constant() ? dim.as_int32() : -1);
+    return shape;
+  };
+  // the tile size of the Winograd conv, the weights transformed by AlterLayout already have the attr
+  int winograd_tile       = 0;
+  bool weight_transformed = false;
+  if (attrs.attr_store.find("winograd_tile") != attrs.attr_store.end()) {
+    winograd_tile      = absl::get<int>(attrs.attr_store.at("winograd_tile"));
+    weight_transformed = true;
+  } else if (data_format == "NCHW" && conv_type == "forward" && inputs.size() >= 2U) {
+    // the transforms and the batched matmul are separate kernels on NVGPU, the convs computed in the loop nest of an
+    // epilogue are not split, and those run by cudnn are not lowered at all
+#ifdef CINN_WITH_CUDNN
+    bool nvgpu_winograd = false;
+#else
+    bool nvgpu_winograd = attrs.attr_store.find("one_kernel") == attrs.attr_store.end();
+#endif
+    if ((target.is_cpu() && !use_mkldnn) || (target.arch == Target::Arch::NVGPU && nvgpu_winograd)) {
+      winograd_tile = pe::GetConv2dWinogradTile(
+          to_int_shape(inputs[0]), to_int_shape(inputs[1]), padding, stride, dilation, groups);
+    }
+  }
+  VLOG(3) << "winograd_tile: " << winograd_tile;
+  // the X86 convs whose direct NCHWc loops reuse little of the caches are computed by the GEMM over the im2col
+  bool use_im2col = false;
+  if (winograd_tile == 0 && target.is_cpu() && !use_mkldnn && data_format == "NCHW" &&
+      conv_type == "forward" && inputs.size() >= 2U) {
+    use_im2col =
+        pe::UseConv2dIm2col(to_int_shape(inputs[0]), to_int_shape(inputs[1]), padding, stride, dilation, groups);
+  }
+  VLOG(3) << "use_im2col: " << use_im2col;
+  // the NVGPU convs are computed by the implicit GEMM tiled like the matmuls, except those computed in the loop nest
+  // of an epilogue, as the GEMM and its reshape to the output are two kernels. With cudnn, the kernels are timed
+  // against the library call on the first run, see FLAGS_cinn_conv2d_library.
+  bool use_implicit_gemm = false;
+  if (winograd_tile == 0 && target.arch == Target::Arch::NVGPU && data_format == "NCHW" && conv_type == "forward" &&
+      inputs.size() >= 2U && attrs.attr_store.find("one_kernel") == attrs.attr_store.end()) {
+    use_implicit_gemm = pe::UseConv2dImplicitGemm(
+        to_int_shape(inputs[0]), to_int_shape(inputs[1]), padding, stride, dilation, groups);
+  }
+  VLOG(3) << "use_implicit_gemm: " << use_implicit_gemm;
 
   framework::CINNCompute conv2d_compute([=](lang::Args args, lang::RetValue *ret) {
     std::vector<CINNValue> res;
@@ -197,9 +242,42 @@ std::shared_ptr<OpStrategy> StrategyForConv2d(const framework::NodeAttr &attrs,
     std::vector<ir::Tensor> out;
     VLOG(3) << "input shape: " << utils::Join(A.as_tensor_ref()->shape, ", ");
     VLOG(3) << "weight shape: " << utils::Join(B.as_tensor_ref()->shape, ", ");
-    if (data_format == "NCHW") {
+    if (winograd_tile > 0) {
+      // A is input: [N, C, H, W], B is filter: [C_out, C_in, 3, 3] or the transformed [alpha * alpha, C_out, C_in]
+      ir::Tensor weight_t = weight_transformed
+                                ? B.as_tensor_ref()
+                                : pe::Conv2d_Winograd_WeightTransform(B.as_tensor_ref(), winograd_tile);
+      out = pe::Conv2d_Winograd_NCHW(A.as_tensor_ref(),
+                                     weight_t,
+                                     padding[0],
+                                     padding[1],
+                                     winograd_tile,
+                                     UniqName("Conv2d_winograd_out"));
+      if (!weight_transformed) out.push_back(weight_t);
+    } else if (use_im2col) {
+      out = pe::Conv2d_Im2col_NCHW(A.as_tensor_ref(),
+                                   B.as_tensor_ref(),
+                                   padding[0],
+                                   padding[1],
+                                   stride[0],
+                                   stride[1],
+                                   dilation[0],
+                                   dilation[1],
+                                   UniqName("Conv2d_im2col_out"),
+                                   target);
+    } else if (use_implicit_gemm) {
+      out = pe::Conv2d_ImplicitGemm_NCHW(A.as_tensor_ref(),
+                                         B.as_tensor_ref(),
+                                         padding[0],
+                                         padding[1],
+                                         stride[0],
+                                         stride[1],
+                                         dilation[0],
+                                         dilation[1],
+                                         UniqName("Conv2d_implicit_gemm_out"));
+    } else if (data_format == "NCHW") {
       // A is input: [N, C, H, W], B is filter: [C_out, C_in/group, filter_h, filter_w]
-      if (target.arch == Target::Arch::X86) {
+      if (target.is_cpu()) {
         if (groups == 1 && !use_mkldnn) {
           out = pe::Conv2d_NCHW_5D(A.as_tensor_ref(),
                                    B.as_tensor_ref(),
@@ -259,6 +337,14 @@ std::shared_ptr<OpStrategy> StrategyForConv2d(const framework::NodeAttr &attrs,
 #endif
         }
       }
+#ifdef CINN_WITH_CUDNN
+    } else if (data_format == "NHWC" && target.arch == Target::Arch::NVGPU) {
+      // as the runtime use cudnn to compute the NHWC conv2d, also for the OHWI weights prepacked by AlterLayout, we
+      // built a fake op like the backward ones.
+      out = pe::Identity(A.as_tensor_ref());
+      out.push_back(A.as_tensor_ref());
+      out.push_back(B.as_tensor_ref());
+#endif
     } else if (data_format == "NHWC") {
       // A is input: [N, H, W, C], B is filter: [C_out, C_in/group, filter_h, filter_w]
       out = pe::Conv2d_NHWC(A.as_tensor_ref(),
@@ -279,8 +365,8 @@ std::shared_ptr<OpStrategy> StrategyForConv2d(const framework::NodeAttr &attrs,
       stages->InsertLazily(t);
       res.push_back(CINNValue(t));
     }
-    CHECK(out.size() == 3U || out.size() == 2U || out.size() == 5U)
-        << "The output tensor sizes of conv2d op in conv2d op should be 2 or 3 or 5\n";
+    CHECK(out.size() == 3U || out.size() == 2U || out.size() == 4U || out.size() == 5U || out.size() == 7U)
+        << "The output tensor sizes of conv2d op in conv2d op should be 2 or 3 or 4 or 5 or 7\n";
 
     res.push_back(CINNValue(stages));
     *ret = CINNValuePack{res};
@@ -289,14 +375,90 @@ std::shared_ptr<OpStrategy> StrategyForConv2d(const framework::NodeAttr &attrs,
   framework::CINNSchedule conv2d_schedule([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input argument of conv2d schedule is empty! Please check.\n";
     CINNValuePack arg_pack = args[0];
+    if (winograd_tile > 0) {
+      CHECK(arg_pack.size() == 5UL || arg_pack.size() == 6UL);
+      poly::StageMap stages = arg_pack.back();
+      Expr out              = arg_pack[0];
+      Expr batched_matmul   = arg_pack[1];
+      Expr data_transform   = arg_pack[2];
+      Expr input_pad        = arg_pack[3];
+      CHECK(out.as_tensor());
+      CHECK(batched_matmul.as_tensor());
+      CHECK(data_transform.as_tensor());
+      CHECK(input_pad.as_tensor());
+      if (target.arch == Target::Arch::NVGPU) {
+        pe::CudaScheduleConv2dWinograd(stages,
+                                       out.as_tensor_ref(),
+                                       batched_matmul.as_tensor_ref(),
+                                       data_transform.as_tensor_ref(),
+                                       input_pad.as_tensor_ref(),
+                                       target);
+        // the kernels of the transforms and the batched matmul exchange M, V and U through the global memory
+        std::vector<CINNValue> res{arg_pack[0], arg_pack[1], arg_pack[2]};
+        if (!weight_transformed) {
+          Expr weight_t = arg_pack[4];
+          CHECK(weight_t.as_tensor());
+          std::vector<int> weight_shape;
+          for (auto &dim : weight_t.as_tensor_ref()->shape) weight_shape.push_back(dim.as_int32());
+          pe::CudaScheduleInjective(stages[weight_t.as_tensor_ref()], weight_shape, target);
+          res.push_back(arg_pack[4]);
+        }
+        res.push_back(CINNValue(stages));
+        *ret = CINNValuePack{res};
+      } else {
+        pe::Conv2d_Winograd_Schedule_CPU(stages,
+                                         out.as_tensor_ref(),
+                                         batched_matmul.as_tensor_ref(),
+                                         data_transform.as_tensor_ref(),
+                                         input_pad.as_tensor_ref(),
+                                         target);
+        if (!weight_transformed) {
+          Expr weight_t = arg_pack[4];
+          CHECK(weight_t.as_tensor());
+          stages[weight_t.as_tensor_ref()]->Fuse(0, 1);
+          stages[weight_t.as_tensor_ref()]->Parallel(0);
+        }
+        *ret = CINNValuePack{{arg_pack[0], CINNValue(stages)}};
+      }
+      return;
+    }
+    if (use_im2col) {
+      CHECK_EQ(arg_pack.size(), 8UL);
+      poly::StageMap stages = arg_pack.back();
+      std::vector<ir::Tensor> tensors;
+      for (int i = 0; i < 7; i++) {
+        Expr tensor = arg_pack[i];
+        CHECK(tensor.as_tensor());
+        tensors.push_back(tensor.as_tensor_ref());
+      }
+      pe::Conv2d_Im2col_Schedule_CPU(
+          stages, tensors[0], tensors[1], tensors[2], tensors[3], tensors[4], tensors[5], tensors[6], target);
+      *ret = CINNValuePack{{arg_pack[0], CINNValue(stages)}};
+      return;
+    }
+    if (use_implicit_gemm) {
+      CHECK_EQ(arg_pack.size(), 6UL);
+      poly::StageMap stages = arg_pack.back();
+      std::vector<ir::Tensor> tensors;
+      for (int i = 0; i < 5; i++) {
+        Expr tensor = arg_pack[i];
+        CHECK(tensor.as_tensor());
+        tensors.push_back(tensor.as_tensor_ref());
+      }
+      pe::CudaScheduleConv2dImplicitGemm(
+          stages, tensors[0], tensors[1], tensors[2], tensors[3], tensors[4], target);
+      // the GEMM kernel and the reshape kernel exchange the GEMM output through the global memory
+      *ret = CINNValuePack{{arg_pack[0], arg_pack[1], CINNValue(stages)}};
+      return;
+    }
     CHECK(arg_pack.size() == 4UL || arg_pack.size() == 3UL || arg_pack.size() == 6UL);
     poly::StageMap stages = arg_pack.back();
     if (target.arch == Target::Arch::NVGPU) {
 #ifdef CINN_WITH_CUDNN
-      // If conv_type is backward_filter or backward_data, we built a fake op.
+      // If conv_type is backward_filter or backward_data, or the data_format is NHWC, we built a fake op.
       // As runtime use cudnn to compute conv2d, this fake op is not to be called.
       // When cinn support backward_filter/backward_data code gen, this code is to be removed.
-      if (conv_type != "forward") {
+      if (conv_type != "forward" || data_format == "NHWC") {
         Expr out = arg_pack[0];
         pe::CudaScheduleInjective(stages[out.as_tensor_ref()], output_shapes.front(), target);
         *ret = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
@@ -316,7 +478,7 @@ std::shared_ptr<OpStrategy> StrategyForConv2d(const framework::NodeAttr &attrs,
       arg_pack[2] = Expr(weights_t);
       *ret        = CINNValuePack{{arg_pack[0], CINNValue(stages)}};
       return;
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       if (arg_pack.size() == 6UL) {
         Expr res              = arg_pack[0];
         Expr packed_out       = arg_pack[1];
@@ -400,6 +562,13 @@ std::shared_ptr<OpStrategy> StrategyForConv2d(const framework::NodeAttr &attrs,
 std::vector<shape_t> InferShapeForConv2d(const std::vector<shape_t> &inputs_shape,
                                          const framework::AttrMapType &attrs) {
   CHECK(!inputs_shape.empty() && !inputs_shape[0].empty()) << "The input's shape size is 0! Please check again.";
+  if (attrs.find("winograd_tile") != attrs.end() && inputs_shape.size() == 2U && inputs_shape[1].size() == 3U) {
+    // the weights transformed by AlterLayout are [alpha * alpha, C_out, C_in], infer by the original 3x3 weights
+    std::vector<shape_t> conv_inputs_shape{inputs_shape[0], {inputs_shape[1][1], inputs_shape[1][2], 3, 3}};
+    auto conv_attrs = attrs;
+    conv_attrs.erase("winograd_tile");
+    return InferShapeForConv2d(conv_inputs_shape, conv_attrs);
+  }
   std::vector<int> padding({0, 0});
   std::vector<int> stride({1, 1});
   std::vector<int> dilation({1, 1});
@@ -426,6 +595,10 @@ std::vector<shape_t> InferShapeForConv2d(const std::vector<shape_t> &inputs_shap
   } else {
     conv_type = "forward";
   }
+  std::string weights_layout = "OIHW";
+  if (attrs.find("weights_layout") != attrs.end()) {
+    weights_layout = absl::get<std::string>(attrs.at("weights_layout"));
+  }
 
   CHECK_EQ(padding.size(), 2) << "The size of padding in conv2d op is not 2! Please check.";
   CHECK_EQ(stride.size(), 2) << "The size of stride in conv2d op is not 2! Please check.";
@@ -504,11 +677,14 @@ std::vector<shape_t> InferShapeForConv2d(const std::vector<shape_t> &inputs_shap
     return {res_shape, packed_out_shape, weights_dilation_shape, input_pad_shape};
 #endif
   } else if (data_format == "NHWC") {
-    // A is input: [N, H, W, C], B is filter: [C_out, C_in/group, filter_h, filter_w]
+    // A is input: [N, H, W, C], B is filter: [C_out, C_in/group, filter_h, filter_w], or [C_out, filter_h, filter_w,
+    // C_in/group] with the OHWI weights_layout
+    CHECK(weights_layout == "OIHW" || weights_layout == "OHWI") << "unsupported weights_layout " << weights_layout;
+    int h_axis = weights_layout == "OIHW" ? 2 : 1;
     int out_shape_h =
-        (inputs_shape[0][1] - ((inputs_shape[1][2] - 1) * dilation[0] + 1) + 2 * padding[0]) / stride[0] + 1;
+        (inputs_shape[0][1] - ((inputs_shape[1][h_axis] - 1) * dilation[0] + 1) + 2 * padding[0]) / stride[0] + 1;
     int out_shape_w =
-        (inputs_shape[0][2] - ((inputs_shape[1][3] - 1) * dilation[1] + 1) + 2 * padding[1]) / stride[1] + 1;
+        (inputs_shape[0][2] - ((inputs_shape[1][h_axis + 1] - 1) * dilation[1] + 1) + 2 * padding[1]) / stride[1] + 1;
     res = {{inputs_shape[0][0], out_shape_h, out_shape_w, inputs_shape[1][0]}};
   } else {
     LOG(FATAL) << "Only support NCHW and NHWC data layout\n";
@@ -577,7 +753,7 @@ std::shared_ptr<OpStrategy> StrategyForConv2dNCHWc(const framework::NodeAttr &at
     CHECK_EQ(stride.size(), 2) << "The size of stride in conv2d_NCHWc op is not 2! Please check.";
     CHECK_EQ(dilation.size(), 2) << "The size of stride in conv2d_NCHWc op is not 2! Please check.";
     std::vector<ir::Tensor> out;
-    CHECK(target.arch == Target::Arch::X86) << "conv2d_NCHWc op is only used in x86";
+    CHECK(target.is_cpu()) << "conv2d_NCHWc op is only used on the CPUs";
     // A is input: [N, C_in_outer, H, W, C_in_inner], B is filter: [C_out, C_in_group_outer, filter_h, filter_w,
     // C_in_group_inner]
     std::string key;
@@ -724,6 +900,73 @@ std::vector<Type> InferDtypeForConv2dNCHWc(const std::vector<Type> &inputs_type,
   return res;
 }
 
+std::shared_ptr<OpStrategy> StrategyForConv2dWinogradWeightTransform(const framework::NodeAttr &attrs,
+                                                                     const std::vector<ir::Tensor> &inputs,
+                                                                     const std::vector<Type> &out_type,
+                                                                     const std::vector<std::vector<int>> &output_shapes,
+                                                                     const Target &target) {
+  CHECK(attrs.attr_store.count("winograd_tile")) << "conv2d_winograd_weight_transform op finds no winograd_tile attr";
+  int winograd_tile = absl::get<int>(attrs.attr_store.at("winograd_tile"));
+
+  framework::CINNCompute weight_transform_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of conv2d_winograd_weight_transform compute is empty! Please check.";
+    CINNValuePack a = args[0];
+    CHECK(!a.empty()) << "The input tensors of conv2d_winograd_weight_transform compute is empty! Please check.";
+    Expr A_expr = a[0];
+    CHECK(A_expr.as_tensor());
+    ir::Tensor A = A_expr.as_tensor_ref();
+
+    auto out    = pe::Conv2d_Winograd_WeightTransform(A, winograd_tile, UniqName("T_Conv2d_winograd_weight_out"));
+    auto stages = CreateStages({A, out});
+    *ret        = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule weight_transform_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of conv2d_winograd_weight_transform schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 2UL);
+    Expr Out              = arg_pack[0];
+    poly::StageMap stages = arg_pack[1];
+    CHECK(Out.as_tensor());
+    if (target.arch == Target::Arch::NVGPU) {
+      pe::CudaScheduleInjective(stages[Out.as_tensor_ref()], output_shapes.front(), target);
+    } else {
+      pe::ScheduleInjectiveCPU(stages[Out.as_tensor_ref()], output_shapes.front(), target);
+    }
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(
+      weight_transform_compute, weight_transform_schedule, "strategy.conv2d_winograd_weight_transform.x86", 1);
+  return strategy;
+}
+
+std::vector<shape_t> InferShapeForConv2dWinogradWeightTransform(const std::vector<shape_t> &inputs_shape,
+                                                                const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 1U) << "The input's shape size is not 1! Please check again.";
+  CHECK_EQ(inputs_shape[0].size(), 4U) << "The weight of conv2d_winograd_weight_transform should be 4-D";
+  CHECK(attrs.find("winograd_tile") != attrs.end()) << "conv2d_winograd_weight_transform op finds no winograd_tile attr";
+  int alpha = absl::get<int>(attrs.at("winograd_tile")) + 2;
+  return {{alpha * alpha, inputs_shape[0][0], inputs_shape[0][1]}};
+}
+
+std::vector<Type> InferDtypeForConv2dWinogradWeightTransform(const std::vector<Type> &inputs_type,
+                                                             const framework::AttrMapType &attrs) {
+  CHECK(!inputs_type.empty()) << "The input's type size is 0! Please check again.";
+  return {inputs_type[0]};
+}
+
+std::vector<std::vector<std::string>> InferLayoutForConv2dWinogradWeightTransform(
+    const std::vector<framework::shape_t> &input_shapes,
+    const std::vector<std::string> &input_layouts,
+    const framework::NodeAttr &attrs,
+    const Target &target) {
+  CHECK_EQ(input_layouts.size(), 1U) << "The input's layouts size is not 1! Please check again.";
+  // T is the alpha * alpha positions of the Winograd tiles
+  return {{"TOI"}, input_layouts};
+}
+
 std::shared_ptr<OpStrategy> StrategyForDepthwiseConv2d(const framework::NodeAttr &attrs,
                                                        const std::vector<ir::Tensor> &inputs,
                                                        const std::vector<Type> &out_type,
@@ -749,6 +992,16 @@ std::shared_ptr<OpStrategy> StrategyForDepthwiseConv2d(const framework::NodeAttr
   if (attrs.attr_store.find("key") != attrs.attr_store.end()) {
     key = absl::get<std::string>(attrs.attr_store.at("key"));
   }
+  // the X86 depthwise convs without the channel multiplier are computed by the row kernels over the vectors of channels
+  int c_bn            = pe::GetBasicFactor(Float(32), target);
+  bool use_row_kernel = false;
+  if (target.is_cpu() && data_format == "NCHW" && inputs.size() >= 2U) {
+    auto &input_shape  = inputs[0]->shape;
+    auto &weight_shape = inputs[1]->shape;
+    use_row_kernel     = input_shape.size() == 4U && weight_shape.size() == 4U && input_shape[1].is_constant() &&
+                     weight_shape[1].is_constant() && input_shape[1].as_int32() % c_bn == 0 &&
+                     weight_shape[1].as_int32() == 1;
+  }
 
   framework::CINNCompute depthwise_conv2d_compute([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input argument of depthwise_conv compute is empty! Please check.\n";
@@ -763,7 +1016,18 @@ std::shared_ptr<OpStrategy> StrategyForDepthwiseConv2d(const framework::NodeAttr
     CHECK(data_format == "NCHW" || data_format == "NHWC") << "only support NCHW/NHWC data_format.\n";
     std::vector<ir::Tensor> out;
     if (data_format == "NCHW") {
-      if (target.arch == Target::Arch::X86) {
+      if (use_row_kernel) {
+        out = pe::Depthwise_Conv2d_NCHWc_Row(A.as_tensor_ref(),
+                                             B.as_tensor_ref(),
+                                             padding[0],
+                                             padding[1],
+                                             stride[0],
+                                             stride[1],
+                                             dilation[0],
+                                             dilation[1],
+                                             c_bn,
+                                             UniqName("T_depthwise_conv2d_nchwc_row_out"));
+      } else if (target.is_cpu()) {
         out = pe::Conv2d_NCHW_5D(A.as_tensor_ref(),
                                  B.as_tensor_ref(),
                                  padding[0],
@@ -802,8 +1066,8 @@ std::shared_ptr<OpStrategy> StrategyForDepthwiseConv2d(const framework::NodeAttr
       stages->InsertLazily(t);
       res.push_back(CINNValue(t));
     }
-    CHECK(out.size() == 2U || out.size() == 1U || out.size() == 5U)
-        << "The output tensor sizes of depthwise_conv op in depthwise_conv op should be 1 or 2 or 5\n";
+    CHECK(out.size() == 2U || out.size() == 1U || out.size() == 4U || out.size() == 5U)
+        << "The output tensor sizes of depthwise_conv op in depthwise_conv op should be 1 or 2 or 4 or 5\n";
     res.push_back(CINNValue(stages));
     *ret = CINNValuePack{res};
   });
@@ -811,11 +1075,31 @@ std::shared_ptr<OpStrategy> StrategyForDepthwiseConv2d(const framework::NodeAttr
   framework::CINNSchedule depthwise_conv2d_schedule([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input argument of depthwise_conv schedule is empty! Please check.\n";
     CINNValuePack arg_pack = args[0];
-    CHECK(arg_pack.size() == 2UL || arg_pack.size() == 3UL || arg_pack.size() == 6UL);
+    CHECK(arg_pack.size() == 2UL || arg_pack.size() == 3UL || arg_pack.size() == 5UL || arg_pack.size() == 6UL);
     poly::StageMap stages = arg_pack[arg_pack.size() - 1];
     Expr Out              = arg_pack[0];
     CHECK(Out.as_tensor());
-    if (arg_pack.size() == 3UL) {
+    if (use_row_kernel) {
+      CHECK_EQ(arg_pack.size(), 5UL);
+      Expr packed_out    = arg_pack[1];
+      Expr weight_packed = arg_pack[2];
+      Expr input_pad     = arg_pack[3];
+      CHECK(packed_out.as_tensor());
+      CHECK(weight_packed.as_tensor());
+      CHECK(input_pad.as_tensor());
+      ir::Tensor packed_out_tensor = packed_out.as_tensor_ref();
+      pe::Depthwise_Conv2d_NCHWc_Row_Schedule_CPU(stages,
+                                                  Out.as_tensor_ref(),
+                                                  packed_out_tensor,
+                                                  weight_packed.as_tensor_ref(),
+                                                  input_pad.as_tensor_ref(),
+                                                  target);
+      *ret = CINNValuePack{{arg_pack[0], CINNValue(stages)}};
+      return;
+    }
+    // the NCHW depthwise conv on NVGPU stages the padded input in the shared memory itself
+    bool tiled_nvgpu = target.arch == Target::Arch::NVGPU && data_format == "NCHW" && arg_pack.size() == 3UL;
+    if (arg_pack.size() == 3UL && !tiled_nvgpu) {
       Expr input_pad = arg_pack[1];
       CHECK(input_pad.as_tensor());
       stages[input_pad.as_tensor_ref()]->ComputeInline();
@@ -823,9 +1107,16 @@ std::shared_ptr<OpStrategy> StrategyForDepthwiseConv2d(const framework::NodeAttr
     if (target.arch == Target::Arch::NVGPU) {
       ir::Tensor output = Out.as_tensor_ref();
       CHECK(Out.as_tensor());
-      pe::CudaScheduleDepthwiseConv(stages, output, target);
+      if (tiled_nvgpu) {
+        Expr input_pad = arg_pack[1];
+        CHECK(input_pad.as_tensor());
+        ir::Tensor input_pad_tensor = input_pad.as_tensor_ref();
+        pe::CudaScheduleDepthwiseConv(stages, input_pad_tensor, output, target);
+      } else {
+        pe::CudaScheduleDepthwiseConv(stages, output, target);
+      }
       arg_pack[0] = Expr(output);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       if (arg_pack.size() == 6UL) {
         Expr res              = arg_pack[0];
         Expr packed_out       = arg_pack[1];
@@ -926,6 +1217,10 @@ std::shared_ptr<OpStrategy> StrategyForBatchNorm(const framework::NodeAttr &attr
   if (attrs.attr_store.find("input_layouts") != attrs.attr_store.end()) {
     input_layouts = absl::get<std::vector<std::string>>(attrs.attr_store.at("input_layouts"));
   }
+  std::string data_layout = "NCHW";
+  if (attrs.attr_store.find("data_layout") != attrs.attr_store.end()) {
+    data_layout = absl::get<std::string>(attrs.attr_store.at("data_layout"));
+  }
   framework::CINNCompute batchnorm_compute([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input argument of batchnorm compute is empty! Please check.\n";
     CINNValuePack a = args[0];
@@ -943,7 +1238,7 @@ std::shared_ptr<OpStrategy> StrategyForBatchNorm(const framework::NodeAttr &attr
     CHECK(Variance.as_tensor());
     ir::Tensor out;
     auto tensor_input = A.as_tensor_ref();
-    if (tensor_input->shape.size() != 4 && target.arch == Target::Arch::X86) {
+    if (tensor_input->shape.size() != 4 && target.is_cpu()) {
       CHECK_EQ(input_layouts.size(), 5U) << "batch_norm_NCHWc's input layout should be 5";
       std::string input_layout = input_layouts[0];
       CHECK_GE(input_layout.size(), 5U);
@@ -956,6 +1251,14 @@ std::shared_ptr<OpStrategy> StrategyForBatchNorm(const framework::NodeAttr &attr
                                 Variance.as_tensor_ref(),
                                 epsilon,
                                 UniqName("BatchNorm_NCHWc_output"));
+    } else if (data_layout == "NHWC") {
+      out = pe::BatchNorm_NHWC(tensor_input,
+                               Scale.as_tensor_ref(),
+                               Bias.as_tensor_ref(),
+                               Mean.as_tensor_ref(),
+                               Variance.as_tensor_ref(),
+                               epsilon,
+                               UniqName("BatchNorm_NHWC_output"));
     } else {
       out = pe::BatchNorm_NCHW(tensor_input,
                                Scale.as_tensor_ref(),
@@ -978,7 +1281,7 @@ std::shared_ptr<OpStrategy> StrategyForBatchNorm(const framework::NodeAttr &attr
     CHECK(Out.as_tensor());
     if (target.arch == Target::Arch::NVGPU) {
       pe::CudaScheduleInjective(stages[Out.as_tensor_ref()], output_shapes.front(), target);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       pe::ScheduleInjectiveCPU(stages[Out.as_tensor_ref()], output_shapes.front(), target);
     }
     *ret = arg_pack;
@@ -1166,86 +1469,135 @@ std::shared_ptr<OpStrategy> StrategyForPool2d(const framework::NodeAttr &attrs,
                                               const std::vector<Type> &out_type,
                                               const std::vector<std::vector<int>> &output_shapes,
                                               const Target &target) {
+  std::vector<int> kernel_size;   // [kernel_h, kernel_w]
+  std::vector<int> stride_size;   // [stride_h, stride_w]
+  std::vector<int> padding_size;  // [padding_top, padding_left, padding_bottom, padding_right]
+  std::string pool_type   = "max";
+  bool ceil_mode          = false;
+  bool exclusive          = true;
+  bool global_pooling     = false;
+  bool adaptive           = false;
+  std::string data_format = "NCHW";
+  for (auto &iter : attrs.attr_store) {
+    if (iter.first == "kernel_size") {
+      kernel_size = absl::get<std::vector<int>>(iter.second);
+    } else if (iter.first == "stride_size") {
+      stride_size = absl::get<std::vector<int>>(iter.second);
+    } else if (iter.first == "padding_size") {
+      padding_size = absl::get<std::vector<int>>(iter.second);
+    } else if (iter.first == "pool_type") {
+      pool_type = absl::get<std::string>(iter.second);
+    } else if (iter.first == "ceil_mode") {
+      ceil_mode = absl::get<bool>(iter.second);
+    } else if (iter.first == "exclusive") {
+      exclusive = absl::get<bool>(iter.second);
+    } else if (iter.first == "data_format") {
+      data_format = absl::get<std::string>(iter.second);
+    } else if (iter.first == "global_pooling") {
+      global_pooling = absl::get<bool>(iter.second);
+    } else if (iter.first == "adaptive") {
+      adaptive = absl::get<bool>(iter.second);
+    }
+  }
+  CHECK(!kernel_size.empty()) << "kernel_size for pool2d is empty. Please check.\n";
+  CHECK(!stride_size.empty()) << "stride_size for pool2d is empty. Please check.\n";
+  CHECK(!padding_size.empty()) << "padding_size for pool2d is empty. Please check.\n";
+  int height_index = -1;
+  int width_index  = -1;
+  if (data_format == "NCHW") {
+    height_index = 2;
+    width_index  = 3;
+  } else if (data_format == "NHWC") {
+    height_index = 1;
+    width_index  = 2;
+  } else if (data_format == "AnyLayout") {
+    height_index = 2;
+    width_index  = 3;
+    data_format  = "NCHW";
+  } else if (global_pooling) {
+    LOG(FATAL) << "Only support 'NCHW' or 'NHWC' or 'AnyLayout' data_format.\n";
+  }
+  if (kernel_size.size() == padding_size.size()) {
+    padding_size.insert(padding_size.end(), padding_size.begin(), padding_size.end());
+  }
+
+  // The global pooling is reduced like the reduce ops, and the large windows of stride 1 are pooled separably instead
+  // of recomputing the overlapping parts of the windows, see pe::GlobalPool2d and pe::SeparablePool2d.
+  bool global_reduce  = false;
+  bool separable      = false;
+  int num_parts       = 1;
+  bool is_simple_pool = !adaptive && (pool_type == "max" || pool_type == "avg") && !inputs.empty();
+  if (is_simple_pool && global_pooling) {
+    const ir::Tensor &A = inputs[0];
+    global_reduce = A->shape[height_index].is_constant() && A->shape[width_index].is_constant();
+    bool is_constant = std::all_of(A->shape.begin(), A->shape.end(), [](const Expr &e) { return e.is_constant(); });
+    if (global_reduce && is_constant && width_index == A->shape.size() - 1) {
+      int reduce_numel = A->shape[height_index].as_int32() * A->shape[width_index].as_int32();
+      int output_numel = 1;
+      for (int i = 0; i < height_index; i++) output_numel *= A->shape[i].as_int32();
+      if (target.arch == Target::Arch::NVGPU) {
+        num_parts = pe::GetCudaReduceParts(output_numel, reduce_numel, target);
+      } else if (target.arch == Target::Arch::X86) {
+        num_parts = pe::GetCpuReduceParts(reduce_numel, A->type(), target);
+      }
+    }
+  } else if (is_simple_pool && !global_pooling) {
+    separable = pe::IsSeparablePool2d(kernel_size, stride_size);
+  }
+
   framework::CINNCompute pool2d_compute([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input argument of pool2d compute is empty! Please check.\n";
     CINNValuePack a = args[0];
     CHECK(!a.empty()) << "The input tensor of pool2d compute is empty! Please check.\n";
     Expr A = a[0];
     CHECK(A.as_tensor());
-    auto attr_store = attrs.attr_store;
-    std::vector<int> kernel_size;   // [kernel_h, kernel_w]
-    std::vector<int> stride_size;   // [stride_h, stride_w]
-    std::vector<int> padding_size;  // [padding_top, padding_left, padding_bottom, padding_right]
-    std::string pool_type   = "max";
-    bool ceil_mode          = false;
-    bool exclusive          = true;
-    bool global_pooling     = false;
-    bool adaptive           = false;
-    std::string data_format = "NCHW";
-    for (auto &iter : attrs.attr_store) {
-      if (iter.first == "kernel_size") {
-        kernel_size = absl::get<std::vector<int>>(iter.second);
-      } else if (iter.first == "stride_size") {
-        stride_size = absl::get<std::vector<int>>(iter.second);
-      } else if (iter.first == "padding_size") {
-        padding_size = absl::get<std::vector<int>>(iter.second);
-      } else if (iter.first == "pool_type") {
-        pool_type = absl::get<std::string>(iter.second);
-      } else if (iter.first == "ceil_mode") {
-        ceil_mode = absl::get<bool>(iter.second);
-      } else if (iter.first == "exclusive") {
-        exclusive = absl::get<bool>(iter.second);
-      } else if (iter.first == "data_format") {
-        data_format = absl::get<std::string>(iter.second);
-      } else if (iter.first == "global_pooling") {
-        global_pooling = absl::get<bool>(iter.second);
-      } else if (iter.first == "adaptive") {
-        adaptive = absl::get<bool>(iter.second);
-      }
-    }
-    CHECK(!kernel_size.empty()) << "kernel_size for pool2d is empty. Please check.\n";
-    CHECK(!stride_size.empty()) << "stride_size for pool2d is empty. Please check.\n";
-    CHECK(!padding_size.empty()) << "padding_size for pool2d is empty. Please check.\n";
-
     ir::Tensor A_tensor = A.as_tensor_ref();
     CHECK(A_tensor->shape.size() == 4U || A_tensor->shape.size() == 5U)
         << "pool2d requires tensor's shape_size to be 4 or 5\n";
-    if (global_pooling) {
-      int height_index = -1;
-      int width_index  = -1;
-      if (data_format == "NCHW") {
-        height_index = 2;
-        width_index  = 3;
-      } else if (data_format == "NHWC") {
-        height_index = 1;
-        width_index  = 2;
-      } else if (data_format == "AnyLayout") {
-        height_index = 2;
-        width_index  = 3;
-        data_format  = "NCHW";
-      } else {
-        LOG(FATAL) << "Only support 'NCHW' or 'NHWC' or 'AnyLayout' data_format.\n";
+
+    std::vector<ir::Tensor> out;
+    auto stages = CreateStages({A_tensor});
+    if (global_reduce) {
+      VLOG(3) << "The global " << pool_type << " pool2d is reduced in " << num_parts << " parts";
+      bool interleave_parts = target.arch == Target::Arch::X86;
+      out = pe::GlobalPool2d(A_tensor, pool_type, data_format, num_parts, interleave_parts, UniqName("T_Pool2d_out"));
+      if (num_parts > 1) {
+        // the reshaped input is read by the partial reduction only
+        stages->InsertLazily(out.back());
+        stages[out.back()]->ComputeInline();
+        out.pop_back();
       }
-      kernel_size  = {A_tensor->shape[height_index].as_int32(), A_tensor->shape[width_index].as_int32()};
-      padding_size = {0, 0, 0, 0};
-    }
-    if (kernel_size.size() == padding_size.size()) {
-      padding_size.insert(padding_size.end(), padding_size.begin(), padding_size.end());
+    } else if (separable) {
+      VLOG(3) << "The " << kernel_size[0] << "x" << kernel_size[1] << " pool2d of stride 1 is pooled separably";
+      out = pe::SeparablePool2d(A_tensor,
+                                kernel_size,
+                                stride_size,
+                                padding_size,
+                                pool_type,
+                                ceil_mode,
+                                exclusive,
+                                data_format,
+                                UniqName("T_Pool2d_out"));
+    } else {
+      auto pool_kernel_size  = kernel_size;
+      auto pool_padding_size = padding_size;
+      if (global_pooling) {
+        pool_kernel_size  = {A_tensor->shape[height_index].as_int32(), A_tensor->shape[width_index].as_int32()};
+        pool_padding_size = {0, 0, 0, 0};
+      }
+      out = pe::Pool2d(A_tensor,
+                       pool_kernel_size,
+                       stride_size,
+                       pool_padding_size,
+                       pool_type,
+                       ceil_mode,
+                       exclusive,
+                       data_format,
+                       adaptive,
+                       UniqName("T_Pool2d_out"));
+      CHECK(out.size() == 1U || out.size() == 2U) << "The size of pe::Pool2d's output should be 1 or 2.";
     }
 
-    auto out = pe::Pool2d(A_tensor,
-                          kernel_size,
-                          stride_size,
-                          padding_size,
-                          pool_type,
-                          ceil_mode,
-                          exclusive,
-                          data_format,
-                          adaptive,
-                          UniqName("T_Pool2d_out"));
-
-    auto stages = CreateStages({A_tensor});
-    CHECK(out.size() == 1U || out.size() == 2U) << "The size of pe::Pool2d's output should be 1 or 2.";
     std::vector<CINNValue> res;
     for (auto &t : out) {
       stages->InsertLazily(t);
@@ -1259,19 +1611,70 @@ std::shared_ptr<OpStrategy> StrategyForPool2d(const framework::NodeAttr &attrs,
   framework::CINNSchedule pool2d_schedule([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input argument of pool2d schedule is empty! Please check.\n";
     CINNValuePack arg_pack = args[0];
-    CHECK(arg_pack.size() == 2UL || arg_pack.size() == 3UL);
+    CHECK_GE(arg_pack.size(), 2UL);
     Expr Out              = arg_pack[0];
     poly::StageMap stages = arg_pack[arg_pack.size() - 1];
-    if (arg_pack.size() == 3UL) {
-      Expr input_pad = arg_pack[1];
+    CHECK(Out.as_tensor());
+    ir::Tensor temp_out = Out.as_tensor_ref();
+
+    if (global_reduce) {
+      // [out, sum of avg, partial of the parts, stages], where the reductions are scheduled as the reduce ops
+      std::vector<ir::Tensor> reduces;
+      for (int i = pool_type == "avg" ? 1 : 0; i < arg_pack.size() - 1; i++) {
+        Expr reduce = arg_pack[i];
+        CHECK(reduce.as_tensor());
+        reduces.push_back(reduce.as_tensor_ref());
+      }
+      if (target.arch == Target::Arch::NVGPU) {
+        for (auto &reduce : reduces) pe::CudaScheduleReduce(stages, reduce, target);
+        if (pool_type == "avg") {
+          std::vector<int> out_shape;
+          for (auto &dim : temp_out->shape) out_shape.push_back(dim.as_int32());
+          pe::CudaScheduleInjective(stages[temp_out], out_shape, target);
+        }
+        *ret = arg_pack;
+        return;
+      }
+      if (target.arch == Target::Arch::X86) {
+        // the sum and the partial reduction are in the same function, into the temporary buffers
+        if (num_parts > 1) {
+          pe::ScheduleReduceCPU(stages[reduces.back()], target);
+        } else if (data_format == "NHWC") {
+          pe::ScheduleReduceCPU(stages[reduces.front()], target);
+        } else {
+          pe::PoolScheduleCPU(stages, reduces.front(), target);
+        }
+      }
+      *ret = CINNValuePack{{CINNValue(Out), CINNValue(stages)}};
+      return;
+    }
+
+    // [out, rows of separable, input pad, stages]
+    int num_tensors = arg_pack.size() - 1;
+    if (num_tensors > (separable ? 2 : 1)) {
+      Expr input_pad = arg_pack[num_tensors - 1];
       CHECK(input_pad.as_tensor());
       stages[input_pad.as_tensor_ref()]->ComputeInline();
     }
-    CHECK(Out.as_tensor());
-    ir::Tensor temp_out = Out.as_tensor_ref();
+    ir::Tensor rows;
+    if (separable) {
+      Expr rows_expr = arg_pack[1];
+      CHECK(rows_expr.as_tensor());
+      rows = rows_expr.as_tensor_ref();
+    }
     if (target.arch == Target::Arch::NVGPU) {
+      if (separable) {
+        // the rows are another kernel before the output
+        pe::PoolScheduleGPU(stages, rows, target);
+        pe::PoolScheduleGPU(stages, temp_out, target);
+        *ret = CINNValuePack{{CINNValue(Out), CINNValue(rows), CINNValue(stages)}};
+        return;
+      }
       pe::PoolScheduleGPU(stages, temp_out, target);
       arg_pack[arg_pack.size() - 2] = Expr(temp_out);
+    } else if (target.arch == Target::Arch::X86) {
+      if (separable) pe::PoolScheduleCPU(stages, rows, target);
+      pe::PoolScheduleCPU(stages, temp_out, target);
     }
     *ret = CINNValuePack{{CINNValue(Out), CINNValue(stages)}};
   });
@@ -1544,6 +1947,20 @@ std::vector<std::vector<std::string>> InferLayoutForPool(const std::vector<frame
   return {input_layouts, input_layouts};
 }
 
+namespace {
+// The lse of the online softmax reduced by the blocks in a single pass over the rows, then the outputs one after
+// another.
+void CudaScheduleSoftmax(poly::StageMap stages, const ir::Tensor &out, const ir::Tensor &lse, const Target &target) {
+  std::vector<int> shape;
+  for (auto &dim : out->shape) {
+    CHECK(dim.is_constant()) << "The softmax of dynamic shape is not supported on NVGPU";
+    shape.push_back(dim.as_int32());
+  }
+  pe::CudaScheduleInjective(stages[out], shape, target);
+  pe::CudaScheduleReduce(stages, lse, target);
+}
+}  // namespace
+
 std::shared_ptr<OpStrategy> StrategyForSoftmax(const framework::NodeAttr &attrs,
                                                const std::vector<ir::Tensor> &inputs,
                                                const std::vector<Type> &out_type,
@@ -1570,21 +1987,26 @@ std::shared_ptr<OpStrategy> StrategyForSoftmax(const framework::NodeAttr &attrs,
       new_axis = A->shape.size() - 1;
     }
     std::vector<ir::Tensor> out;
-#ifdef CINN_WITH_MKLDNN
-    if (use_mkldnn) {
-      out = pe::SoftmaxMKLDNN(A, new_axis, UniqName("Softmax_mkldnn_output"));
+    if (target.arch == Target::Arch::NVGPU) {
+      // the normalizers are reduced by the blocks in a single pass over the rows
+      out = pe::SoftmaxOnline(A, new_axis, UniqName("Softmax_output"));
     } else {
-      out = pe::Softmax(A, new_axis, UniqName("Softmax_output"));
-    }
+#ifdef CINN_WITH_MKLDNN
+      if (use_mkldnn) {
+        out = pe::SoftmaxMKLDNN(A, new_axis, UniqName("Softmax_mkldnn_output"));
+      } else {
+        out = pe::Softmax(A, new_axis, UniqName("Softmax_output"));
+      }
 #else
-    out = pe::Softmax(A, new_axis, UniqName("Softmax_output"));
+      out = pe::Softmax(A, new_axis, UniqName("Softmax_output"));
 #endif
+    }
     std::vector<CINNValue> res;
     for (auto &t : out) {
       stages->InsertLazily(t);
       res.push_back(CINNValue(t));
     }
-    CHECK_EQ(out.size(), 2U) << "The size of pe::Softmax's output should be 2.";
+    CHECK(out.size() == 2U || out.size() == 3U) << "The size of pe::Softmax's output should be 2 or 3.";
     CHECK(!out_type.empty()) << "Output type of Softmax is empty! Please check.\n";
     res.push_back(CINNValue(stages));
     *ret = CINNValuePack{res};
@@ -1593,24 +2015,19 @@ std::shared_ptr<OpStrategy> StrategyForSoftmax(const framework::NodeAttr &attrs,
   framework::CINNSchedule softmax_schedule([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input arguments of softmax schedule is empty! Please check.";
     CINNValuePack arg_pack = args[0];
-    CHECK_EQ(arg_pack.size(), 3UL) << "The input tensor's size of softmax schedule is " << arg_pack.size()
-                                   << "and it should be equal to 3! Please check.";
+    CHECK(arg_pack.size() == 3UL || arg_pack.size() == 4UL)
+        << "The input tensor's size of softmax schedule is " << arg_pack.size()
+        << "and it should be equal to 3 or 4! Please check.";
     Expr out1             = arg_pack[0];
     Expr out2             = arg_pack[1];
-    poly::StageMap stages = arg_pack[2];
+    poly::StageMap stages = arg_pack.back();
     CHECK(out1.as_tensor());
     CHECK(out2.as_tensor());
     ir::Tensor tensor_a = out1.as_tensor_ref();
     ir::Tensor tensor_b = out2.as_tensor_ref();
     if (target.arch == Target::Arch::NVGPU) {
-      if (tensor_a->shape.size() > 1) {
-        stages[tensor_a]->Split(1, 5);
-        stages[tensor_a]->Bind(0, "blockIdx.x");
-        stages[tensor_a]->Bind(1, "threadIdx.x");
-        int shape_size = tensor_a->shape.size();
-        stages[tensor_b]->ComputeAt(stages[tensor_a], shape_size);
-      }
-    } else if (target.arch == Target::Arch::X86) {
+      CudaScheduleSoftmax(stages, tensor_a, tensor_b, target);
+    } else if (target.is_cpu()) {
       pe::SoftmaxScheduleCPU(stages, tensor_a, tensor_b, axis);
     }
     *ret = arg_pack;
@@ -1622,6 +2039,67 @@ std::shared_ptr<OpStrategy> StrategyForSoftmax(const framework::NodeAttr &attrs,
   return strategy;
 }
 
+std::shared_ptr<OpStrategy> StrategyForLogSoftmax(const framework::NodeAttr &attrs,
+                                                  const std::vector<ir::Tensor> &inputs,
+                                                  const std::vector<Type> &out_type,
+                                                  const std::vector<std::vector<int>> &output_shapes,
+                                                  const Target &target) {
+  int axis = -1;
+  if (attrs.attr_store.count("axis")) {
+    axis = absl::get<int>(attrs.attr_store.at("axis"));
+  }
+  framework::CINNCompute log_softmax_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of log_softmax compute is empty! Please check.";
+    CINNValuePack a = args[0];
+    CHECK(!a.empty()) << "The input tensors of log_softmax compute is empty! Please check.";
+    Expr A_expr = a[0];
+    CHECK(A_expr.as_tensor());
+    ir::Tensor A = A_expr.as_tensor_ref();
+    auto stages  = CreateStages({A});
+    int new_axis = axis < 0 ? axis + static_cast<int>(A->shape.size()) : axis;
+    auto out     = pe::LogSoftmax(A, new_axis, UniqName("LogSoftmax_output"));
+    std::vector<CINNValue> res;
+    for (auto &t : out) {
+      stages->InsertLazily(t);
+      res.push_back(CINNValue(t));
+    }
+    res.push_back(CINNValue(stages));
+    *ret = CINNValuePack{res};
+  });
+
+  framework::CINNSchedule log_softmax_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of log_softmax schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 3UL) << "The log_softmax schedule should be given out, lse and the stages";
+    Expr out              = arg_pack[0];
+    Expr lse              = arg_pack[1];
+    poly::StageMap stages = arg_pack.back();
+    CHECK(out.as_tensor());
+    CHECK(lse.as_tensor());
+    if (target.arch == Target::Arch::NVGPU) {
+      CudaScheduleSoftmax(stages, out.as_tensor_ref(), lse.as_tensor_ref(), target);
+    } else if (target.is_cpu()) {
+      pe::SoftmaxScheduleCPU(stages, out.as_tensor_ref(), lse.as_tensor_ref(), axis);
+    }
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(log_softmax_compute, log_softmax_schedule, "strategy.log_softmax.x86", 1);
+  return strategy;
+}
+
+std::vector<std::vector<int>> InferShapeForLogSoftmax(const std::vector<std::vector<int>> &inputs_shape,
+                                                      const framework::AttrMapType &attrs) {
+  CHECK(!inputs_shape.empty() && !inputs_shape[0].empty()) << "The input's shape size is 0! Please check again.";
+  return {inputs_shape[0]};
+}
+
+std::vector<Type> InferDtypeForLogSoftmax(const std::vector<Type> &inputs_type, const framework::AttrMapType &attrs) {
+  CHECK(!inputs_type.empty()) << "The input's type size is 0! Please check again.";
+  return {inputs_type[0]};
+}
+
 std::vector<std::vector<int>> InferShapeForSoftmax(const std::vector<std::vector<int>> &inputs_shape,
                                                    const framework::AttrMapType &attrs) {
   CHECK(!inputs_shape.empty() && !inputs_shape[0].empty()) << "The input's shape size is 0! Please check again.";
@@ -1875,6 +2353,73 @@ std::vector<Type> InferDtypeForDropoutInfer(const std::vector<Type> &inputs_type
   return res;
 }
 
+std::shared_ptr<OpStrategy> StrategyForDropout(const framework::NodeAttr &attrs,
+                                               const std::vector<ir::Tensor> &inputs,
+                                               const std::vector<Type> &out_type,
+                                               const std::vector<std::vector<int>> &output_shapes,
+                                               const Target &target) {
+  float dropout_prob                 = 0.5f;
+  std::string dropout_implementation = "downgrade_in_infer";
+  if (attrs.attr_store.find("dropout_prob") != attrs.attr_store.end()) {
+    dropout_prob = absl::get<float>(attrs.attr_store.at("dropout_prob"));
+  }
+  if (attrs.attr_store.find("dropout_implementation") != attrs.attr_store.end()) {
+    dropout_implementation = absl::get<std::string>(attrs.attr_store.at("dropout_implementation"));
+  }
+
+  // dropout_grad is the same compute on the grad of the output, with the mask regenerated by the same seed_offset
+  framework::CINNCompute dropout_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of dropout compute is empty! Please check.";
+    CINNValuePack a = args[0];
+    CHECK_EQ(a.size(), 2U) << "The dropout compute should take the input and the seed_offset! Please check.";
+    Expr A_expr           = a[0];
+    Expr seed_offset_expr = a[1];
+    CHECK(A_expr.as_tensor());
+    CHECK(seed_offset_expr.as_tensor());
+    ir::Tensor A           = A_expr.as_tensor_ref();
+    ir::Tensor seed_offset = seed_offset_expr.as_tensor_ref();
+
+    auto out    = pe::Dropout(A, seed_offset, dropout_prob, dropout_implementation, UniqName("T_dropout_out"));
+    auto stages = CreateStages({A, seed_offset, out});
+    *ret        = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule dropout_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of dropout schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 2UL) << "The input tensor's size of dropout schedule is " << arg_pack.size()
+                                   << "and it should be equal to 2! Please check.";
+    Expr Out              = arg_pack[0];
+    poly::StageMap stages = arg_pack[1];
+    CHECK(Out.as_tensor());
+    if (target.arch == Target::Arch::NVGPU) {
+      pe::CudaScheduleInjective(stages[Out.as_tensor_ref()], output_shapes.front(), target);
+    } else {
+      pe::ScheduleInjectiveCPU(stages[Out.as_tensor_ref()], output_shapes.front(), target);
+    }
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(dropout_compute, dropout_schedule, "strategy.dropout.x86", 1);
+
+  return strategy;
+}
+
+std::vector<std::vector<int>> InferShapeForDropout(const std::vector<std::vector<int>> &inputs_shape,
+                                                   const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 2U) << "The dropout should take the input and the seed_offset! Please check again.";
+  CHECK(!inputs_shape[0].empty()) << "The input's shape size is 0! Please check again.";
+  CHECK(inputs_shape[1] == std::vector<int>{2}) << "The seed_offset should be of the shape [2]! Please check again.";
+  return {inputs_shape[0]};
+}
+
+std::vector<Type> InferDtypeForDropout(const std::vector<Type> &inputs_type, const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_type.size(), 2U) << "The dropout should take the input and the seed_offset! Please check again.";
+  CHECK_EQ(inputs_type[1], Int(32)) << "The seed_offset should be int32! Please check again.";
+  return {inputs_type[0]};
+}
+
 std::shared_ptr<OpStrategy> StrategyForSelect(const framework::NodeAttr &attrs,
                                               const std::vector<ir::Tensor> &inputs,
                                               const std::vector<Type> &out_type,
@@ -1907,7 +2452,7 @@ std::shared_ptr<OpStrategy> StrategyForSelect(const framework::NodeAttr &attrs,
     CHECK_GE(output_shapes.size(), 1);
     if (target.arch == Target::Arch::NVGPU) {
       pe::CudaScheduleInjective(stages[out.as_tensor_ref()], output_shapes[0], target);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       pe::ScheduleInjectiveCPU(stages[out.as_tensor_ref()], output_shapes[0], target, false);
     }
     *ret = arg_pack;
@@ -1949,6 +2494,96 @@ std::vector<std::vector<std::string>> InferLayoutForUnary(const std::vector<fram
   return {input_layouts, input_layouts};
 }
 
+std::shared_ptr<OpStrategy> StrategyForBatchNormTrain(const framework::NodeAttr &attrs,
+                                                      const std::vector<ir::Tensor> &inputs,
+                                                      const std::vector<Type> &out_type,
+                                                      const std::vector<std::vector<int>> &output_shapes,
+                                                      const Target &target) {
+  float epsilon           = 1e-5f;
+  float momentum          = 0.9f;
+  std::string data_layout = "NCHW";
+  bool fuse_relu          = false;
+  if (attrs.attr_store.count("epsilon")) {
+    epsilon = absl::get<float>(attrs.attr_store.at("epsilon"));
+  }
+  if (attrs.attr_store.count("momentum")) {
+    momentum = absl::get<float>(attrs.attr_store.at("momentum"));
+  }
+  if (attrs.attr_store.count("data_layout")) {
+    data_layout = absl::get<std::string>(attrs.attr_store.at("data_layout"));
+  }
+  if (attrs.attr_store.count("fuse_relu")) {
+    fuse_relu = absl::get<bool>(attrs.attr_store.at("fuse_relu"));
+  }
+  framework::CINNCompute batch_norm_train_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of batch_norm_train compute is empty! Please check.";
+    CINNValuePack a = args[0];
+    CHECK_EQ(a.size(), 5U) << "The inputs of batch_norm_train compute should be x, scale, bias, moving_mean and "
+                              "moving_variance! Please check.";
+    std::vector<ir::Tensor> tensors;
+    for (int i = 0; i < 5; i++) {
+      Expr expr = a[i];
+      CHECK(expr.as_tensor());
+      tensors.push_back(expr.as_tensor_ref());
+    }
+    auto outs   = pe::BatchNormTrain(tensors[0],
+                                     tensors[1],
+                                     tensors[2],
+                                     tensors[3],
+                                     tensors[4],
+                                     epsilon,
+                                     momentum,
+                                     data_layout,
+                                     fuse_relu,
+                                     target,
+                                     UniqName("BatchNormTrain_output"));
+    auto stages = CreateStages(tensors);
+    std::vector<CINNValue> res;
+    for (auto &t : outs) {
+      stages->InsertLazily(t);
+      res.push_back(CINNValue(t));
+    }
+    res.push_back(CINNValue(stages));
+    *ret = CINNValuePack{res};
+  });
+
+  framework::CINNSchedule batch_norm_train_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of batch_norm_train schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 7UL) << "The batch_norm_train schedule should be given the 5 outputs, the call of the "
+                                      "statistics and the stages";
+    poly::StageMap stages = arg_pack.back();
+    std::vector<CINNValue> res;
+    for (int i = 0; i < 5; i++) {
+      Expr out = arg_pack[i];
+      CHECK(out.as_tensor());
+      auto tensor = out.as_tensor_ref();
+      // the statistics are written by the call, and the others are injective
+      if (i != 1 && i != 2) {
+        if (target.arch == Target::Arch::NVGPU) {
+          pe::CudaScheduleInjective(stages[tensor], output_shapes[i], target);
+        } else {
+          pe::ScheduleInjectiveCPU(stages[tensor], output_shapes[i], target);
+        }
+      }
+      res.push_back(CINNValue(tensor));
+    }
+    Expr call = arg_pack[5];
+    CHECK(call.as_tensor());
+    if (target.arch == Target::Arch::NVGPU) {
+      // a block reduces each channel
+      stages[call.as_tensor_ref()]->Bind(0, "blockIdx.x");
+      stages[call.as_tensor_ref()]->Bind(1, "threadIdx.x");
+    }
+    res.push_back(CINNValue(stages));
+    *ret = CINNValuePack{res};
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(batch_norm_train_compute, batch_norm_train_schedule, "strategy.batch_norm_train.x86", 1);
+  return strategy;
+}
+
 // batch norm train
 std::vector<framework::shape_t> InferShapeForBatchNormTrain(const std::vector<framework::shape_t> &inputs_shape,
                                                             const framework::AttrMapType &attrs) {
@@ -2052,6 +2687,270 @@ std::vector<Type> InferDtypeForConv2dGrad(const std::vector<Type> &inputs_type,
   return {inputs_type[0], inputs_type[0]};
 }
 
+namespace {
+
+std::vector<int> ToConstantShape(const ir::Tensor &tensor) {
+  std::vector<int> shape;
+  for (auto &dim : tensor->shape) {
+    CHECK(dim.is_constant()) << "The fused op of dynamic shape is not supported";
+    shape.push_back(dim.as_int32());
+  }
+  return shape;
+}
+
+// Schedule the elementwise tensors of a fused op as injective kernels and the reductions over their output axes.
+void ScheduleFusedOp(poly::StageMap stages,
+                     const std::vector<ir::Tensor> &injective,
+                     const std::vector<ir::Tensor> &reduce,
+                     const Target &target) {
+  for (auto &tensor : injective) {
+    if (target.arch == Target::Arch::NVGPU) {
+      pe::CudaScheduleInjective(stages[tensor], ToConstantShape(tensor), target);
+    } else if (target.is_cpu()) {
+      pe::ScheduleInjectiveCPU(stages[tensor], ToConstantShape(tensor), target);
+    }
+  }
+  for (auto &tensor : reduce) {
+    if (target.arch == Target::Arch::NVGPU) {
+      pe::CudaScheduleReduce(stages, tensor, target);
+    } else if (target.is_cpu()) {
+      stages[tensor]->Parallel(0);
+    }
+  }
+}
+
+// The tensors of a fused compute packed with their stages.
+CINNValuePack PackFusedOutputs(const std::vector<ir::Tensor> &inputs, const std::vector<ir::Tensor> &outputs) {
+  auto stages = CreateStages(inputs);
+  std::vector<CINNValue> res;
+  for (auto &t : outputs) {
+    stages->InsertLazily(t);
+    res.push_back(CINNValue(t));
+  }
+  res.push_back(CINNValue(stages));
+  return CINNValuePack{res};
+}
+
+std::vector<ir::Tensor> UnpackTensors(const CINNValuePack &pack, int begin, int end) {
+  std::vector<ir::Tensor> res;
+  for (int i = begin; i < end; i++) {
+    Expr expr = pack[i];
+    CHECK(expr.as_tensor());
+    res.push_back(expr.as_tensor_ref());
+  }
+  return res;
+}
+
+}  // namespace
+
+std::shared_ptr<OpStrategy> StrategyForLayerNorm(const framework::NodeAttr &attrs,
+                                                 const std::vector<ir::Tensor> &inputs,
+                                                 const std::vector<Type> &out_type,
+                                                 const std::vector<std::vector<int>> &output_shapes,
+                                                 const Target &target) {
+  float epsilon       = 1e-5f;
+  int begin_norm_axis = 1;
+  if (attrs.attr_store.count("epsilon")) {
+    epsilon = absl::get<float>(attrs.attr_store.at("epsilon"));
+  }
+  if (attrs.attr_store.count("begin_norm_axis")) {
+    begin_norm_axis = absl::get<int>(attrs.attr_store.at("begin_norm_axis"));
+  }
+  framework::CINNCompute layer_norm_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of layer_norm compute is empty! Please check.";
+    CINNValuePack a = args[0];
+    CHECK_EQ(a.size(), 3U) << "The inputs of layer_norm compute should be x, scale and bias! Please check.";
+    auto tensors = UnpackTensors(a, 0, 3);
+    auto out     = pe::LayerNorm(
+        tensors[0], tensors[1], tensors[2], epsilon, begin_norm_axis, target, UniqName("LayerNorm_output"));
+    *ret = PackFusedOutputs(tensors, out);
+  });
+
+  framework::CINNSchedule layer_norm_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of layer_norm schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK(arg_pack.size() == 4UL || arg_pack.size() == 6UL)
+        << "The layer_norm schedule should be given out, mean, variance, the moments on NVGPU and the stages";
+    auto tensors          = UnpackTensors(arg_pack, 0, arg_pack.size() - 1);
+    poly::StageMap stages = arg_pack.back();
+    if (tensors.size() == 5U) {
+      // the moments are reduced by the blocks, and the statistics are computed from them
+      ScheduleFusedOp(stages, {tensors[0], tensors[1], tensors[2]}, {tensors[3], tensors[4]}, target);
+    } else {
+      ScheduleFusedOp(stages, {tensors[0]}, {tensors[1], tensors[2]}, target);
+    }
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(layer_norm_compute, layer_norm_schedule, "strategy.layer_norm.x86", 1);
+  return strategy;
+}
+
+std::vector<std::vector<int>> InferShapeForLayerNorm(const std::vector<std::vector<int>> &inputs_shape,
+                                                     const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 3U) << "The inputs of layer_norm should be x, scale and bias! Please check again.";
+  int begin_norm_axis = 1;
+  if (attrs.count("begin_norm_axis")) {
+    begin_norm_axis = absl::get<int>(attrs.at("begin_norm_axis"));
+  }
+  auto &x_shape = inputs_shape[0];
+  if (begin_norm_axis < 0) begin_norm_axis += x_shape.size();
+  CHECK(begin_norm_axis > 0 && begin_norm_axis < x_shape.size()) << "The begin_norm_axis of layer_norm is out of range";
+  int normalized = std::accumulate(x_shape.begin() + begin_norm_axis, x_shape.end(), 1, std::multiplies<int>());
+  for (int i = 1; i < 3; i++) {
+    int numel = std::accumulate(inputs_shape[i].begin(), inputs_shape[i].end(), 1, std::multiplies<int>());
+    CHECK_EQ(numel, normalized) << "The scale and bias of layer_norm should be in the normalized shape";
+  }
+  std::vector<int> stat_shape(x_shape.begin(), x_shape.begin() + begin_norm_axis);
+  return {x_shape, stat_shape, stat_shape};
+}
+
+std::vector<Type> InferDtypeForLayerNorm(const std::vector<Type> &inputs_type, const framework::AttrMapType &attrs) {
+  CHECK(!inputs_type.empty()) << "The input's type size is 0! Please check again.";
+  return {inputs_type[0], inputs_type[0], inputs_type[0]};
+}
+
+std::vector<std::vector<std::string>> InferLayoutForLayerNorm(const std::vector<framework::shape_t> &input_shapes,
+                                                              const std::vector<std::string> &input_layouts,
+                                                              const framework::NodeAttr &attrs,
+                                                              const Target &target) {
+  CHECK_EQ(input_layouts.size(), 3U) << "The input's layout size is not 3! Please check again.";
+  return {{input_layouts[0], "", ""}, input_layouts};
+}
+
+std::shared_ptr<OpStrategy> StrategyForFusedSoftmaxMask(const framework::NodeAttr &attrs,
+                                                        const std::vector<ir::Tensor> &inputs,
+                                                        const std::vector<Type> &out_type,
+                                                        const std::vector<std::vector<int>> &output_shapes,
+                                                        const Target &target) {
+  float scale = 1.f;
+  if (attrs.attr_store.count("scale")) {
+    scale = absl::get<float>(attrs.attr_store.at("scale"));
+  }
+  framework::CINNCompute softmax_mask_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of fused_softmax_mask compute is empty! Please check.";
+    CINNValuePack a = args[0];
+    CHECK_EQ(a.size(), 2U) << "The inputs of fused_softmax_mask compute should be x and mask! Please check.";
+    auto tensors = UnpackTensors(a, 0, 2);
+    auto out     = pe::SoftmaxMask(tensors[0], tensors[1], scale, target, UniqName("SoftmaxMask_output"));
+    *ret         = PackFusedOutputs(tensors, out);
+  });
+
+  framework::CINNSchedule softmax_mask_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of fused_softmax_mask schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 4UL) << "The fused_softmax_mask schedule should be given out, sum, the masked input "
+                                      "and the stages";
+    auto tensors          = UnpackTensors(arg_pack, 0, 3);
+    poly::StageMap stages = arg_pack.back();
+    if (target.arch == Target::Arch::NVGPU) {
+      // the masked input is loaded by the single pass of the online normalizer, which is reduced by the blocks
+      ScheduleFusedOp(stages, {tensors[2]}, {}, target);
+      CudaScheduleSoftmax(stages, tensors[0], tensors[1], target);
+    } else if (target.is_cpu()) {
+      // the masked input is computed where it is read
+      stages[tensors[2]]->ComputeInline();
+      pe::SoftmaxScheduleCPU(stages, tensors[0], tensors[1], -1);
+    }
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(softmax_mask_compute, softmax_mask_schedule, "strategy.fused_softmax_mask.x86", 1);
+  return strategy;
+}
+
+std::vector<std::vector<int>> InferShapeForFusedSoftmaxMask(const std::vector<std::vector<int>> &inputs_shape,
+                                                            const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 2U) << "The inputs of fused_softmax_mask should be x and mask! Please check again.";
+  CHECK_LE(inputs_shape[1].size(), inputs_shape[0].size()) << "The mask of fused_softmax_mask is of higher rank";
+  return {inputs_shape[0]};
+}
+
+std::vector<Type> InferDtypeForFusedSoftmaxMask(const std::vector<Type> &inputs_type,
+                                                const framework::AttrMapType &attrs) {
+  CHECK(!inputs_type.empty()) << "The input's type size is 0! Please check again.";
+  return {inputs_type[0]};
+}
+
+std::vector<std::vector<std::string>> InferLayoutForFusedOp(const std::vector<framework::shape_t> &input_shapes,
+                                                            const std::vector<std::string> &input_layouts,
+                                                            const framework::NodeAttr &attrs,
+                                                            const Target &target) {
+  CHECK(!input_layouts.empty()) << "The input's layout size is 0! Please check again.";
+  return {{input_layouts[0]}, input_layouts};
+}
+
+std::shared_ptr<OpStrategy> StrategyForMultiHeadAttention(const framework::NodeAttr &attrs,
+                                                          const std::vector<ir::Tensor> &inputs,
+                                                          const std::vector<Type> &out_type,
+                                                          const std::vector<std::vector<int>> &output_shapes,
+                                                          const Target &target) {
+  int num_heads = 1;
+  float scale   = 0.f;
+  if (attrs.attr_store.count("num_heads")) {
+    num_heads = absl::get<int>(attrs.attr_store.at("num_heads"));
+  }
+  if (attrs.attr_store.count("scale")) {
+    scale = absl::get<float>(attrs.attr_store.at("scale"));
+  }
+  framework::CINNCompute attention_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of multihead_attention compute is empty! Please check.";
+    CINNValuePack a = args[0];
+    CHECK(a.size() == 3U || a.size() == 4U) << "The inputs of multihead_attention compute should be q, k, v and the "
+                                               "optional mask! Please check.";
+    auto tensors = UnpackTensors(a, 0, a.size());
+    ir::Tensor mask;
+    if (tensors.size() == 4U) mask = tensors[3];
+    auto out = pe::MultiHeadAttention(
+        tensors[0], tensors[1], tensors[2], mask, num_heads, scale, UniqName("MultiHeadAttention_output"));
+    *ret = PackFusedOutputs(tensors, out);
+  });
+
+  framework::CINNSchedule attention_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of multihead_attention schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 6UL) << "The multihead_attention schedule should be given out, context, sum, exp, "
+                                      "scores and the stages";
+    auto tensors          = UnpackTensors(arg_pack, 0, 5);
+    poly::StageMap stages = arg_pack.back();
+    ScheduleFusedOp(stages, {tensors[0], tensors[3]}, {tensors[4], tensors[2], tensors[1]}, target);
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(attention_compute, attention_schedule, "strategy.multihead_attention.x86", 1);
+  return strategy;
+}
+
+std::vector<std::vector<int>> InferShapeForMultiHeadAttention(const std::vector<std::vector<int>> &inputs_shape,
+                                                              const framework::AttrMapType &attrs) {
+  CHECK(inputs_shape.size() == 3U || inputs_shape.size() == 4U)
+      << "The inputs of multihead_attention should be q, k, v and the optional mask! Please check again.";
+  int num_heads = 1;
+  if (attrs.count("num_heads")) {
+    num_heads = absl::get<int>(attrs.at("num_heads"));
+  }
+  auto &q_shape = inputs_shape[0];
+  CHECK_EQ(q_shape.size(), 3U) << "The query of multihead_attention should be in [batch, seq, hidden]";
+  CHECK_EQ(q_shape[2] % num_heads, 0) << "The hidden size " << q_shape[2] << " is not divisible by " << num_heads
+                                      << " heads";
+  for (int i = 1; i < 3; i++) {
+    CHECK_EQ(inputs_shape[i].size(), 3U) << "The key and value of multihead_attention should be in [batch, seq, dim]";
+    CHECK_EQ(inputs_shape[i][0], q_shape[0]) << "The batch of the key and value should be the query's";
+    CHECK_EQ(inputs_shape[i][2], q_shape[2]) << "The hidden size of the key and value should be the query's";
+  }
+  CHECK_EQ(inputs_shape[1][1], inputs_shape[2][1]) << "The key and value of multihead_attention should be as long";
+  return {q_shape};
+}
+
+std::vector<Type> InferDtypeForMultiHeadAttention(const std::vector<Type> &inputs_type,
+                                                  const framework::AttrMapType &attrs) {
+  CHECK(!inputs_type.empty()) << "The input's type size is 0! Please check again.";
+  return {inputs_type[0]};
+}
+
 }  // namespace op
 }  // namespace hlir
 }  // namespace cinn
@@ -2115,10 +3014,25 @@ CINN_REGISTER_HELPER(nn_ops) {
 #ifndef CINN_WITH_CUDA
       .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForConv2dNCHWc))
 #endif
+      .set_attr<std::vector<cinn::common::Target::Arch>>("CINNSupportedArchs", {cinn::common::Target::Arch::X86})
       .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern",
                                                       cinn::hlir::framework::OpPatternKind::kOutEWiseFusable)
       .set_support_level(4);
 
+  CINN_REGISTER_OP(conv2d_winograd_weight_transform)
+      .describe("Transform the 3x3 weights of conv2d to the Winograd domain, the transformed weights are 3-D.")
+      .set_num_inputs(1)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>(
+          "CINNStrategy", cinn::hlir::op::StrategyForConv2dWinogradWeightTransform)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForConv2dWinogradWeightTransform))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForConv2dWinogradWeightTransform))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForConv2dWinogradWeightTransform))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
+      .set_support_level(4);
+
   CINN_REGISTER_OP(depthwise_conv2d)
       .describe("Do a 2-D depthwise convolution with an NCHW/NHWC layout.")
       .set_num_inputs(2)  // here we consider filter as another input
@@ -2206,6 +3120,19 @@ CINN_REGISTER_HELPER(nn_ops) {
       .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
       .set_support_level(4);
 
+  CINN_REGISTER_OP(log_softmax)
+      .describe("The log of the softmax along the attr axis")
+      .set_num_inputs(1)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForLogSoftmax)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForLogSoftmax))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForLogSoftmax))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForFusedOp))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
+      .set_support_level(4);
+
   CINN_REGISTER_OP(slice)
       .describe("This operator implements the slice layer")
       .set_num_inputs(1)
@@ -2232,6 +3159,27 @@ CINN_REGISTER_HELPER(nn_ops) {
       .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
       .set_support_level(4);
 
+  CINN_REGISTER_OP(dropout)
+      .describe("Drop the units of the probability dropout_prob in the training, by the mask generated in the kernel "
+                "from the seed_offset.")
+      .set_num_inputs(2)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForDropout)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForDropout))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForDropout))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kElemWise)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(dropout_grad)
+      .describe("The grad of dropout, with the mask regenerated from the same seed_offset instead of stored.")
+      .set_num_inputs(2)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForDropout)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForDropout))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForDropout))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kElemWise)
+      .set_support_level(4);
+
   CINN_REGISTER_OP(select)
       .describe("This operator implements the meta op 'Select'.")
       .set_num_inputs(3)
@@ -2262,8 +3210,10 @@ CINN_REGISTER_HELPER(nn_grad_ops) {
       .describe("This operator implements the batch normalization training forward.")
       .set_num_inputs(5)
       .set_num_outputs(5)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForBatchNormTrain)
       .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForBatchNormTrain))
       .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForBatchNormTrain))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
       .set_support_level(4);
 
   CINN_REGISTER_OP(batch_norm_grad)
@@ -2272,6 +3222,7 @@ CINN_REGISTER_HELPER(nn_grad_ops) {
       .set_num_outputs(3)
       .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForBatchNormGrad))
       .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForBatchNormGrad))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kCommReduce)
       .set_support_level(4);
 
   CINN_REGISTER_OP(conv2d_grad)
@@ -2280,6 +3231,46 @@ CINN_REGISTER_HELPER(nn_grad_ops) {
       .set_num_outputs(2)
       .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForConv2dGrad))
       .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForConv2dGrad))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(layer_norm)
+      .describe("Normalize the input over the axes from begin_norm_axis, then scale and shift it")
+      .set_num_inputs(3)
+      .set_num_outputs(3)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForLayerNorm)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForLayerNorm))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForLayerNorm))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForLayerNorm))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(fused_softmax_mask)
+      .describe("The softmax over the last axis of the input scaled and added by the mask")
+      .set_num_inputs(2)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForFusedSoftmaxMask)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForFusedSoftmaxMask))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForFusedSoftmaxMask))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForFusedOp))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(multihead_attention)
+      .describe("The scaled dot-product attention of the query, key and value split into num_heads heads")
+      .set_num_inputs(4)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForMultiHeadAttention)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForMultiHeadAttention))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForMultiHeadAttention))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForFusedOp))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
       .set_support_level(4);
 
   return true;
@@ -14,9 +14,12 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "cinn/backends/llvm/execution_engine.h"
 #include "cinn/cinn.h"
@@ -202,6 +205,111 @@ TEST(Operator, Operator_Pool2d_Test2) {
   ASSERT_EQ(pool2d->description, "Do pooling on the height and width dimension of the input tensor.");
 }
 
+namespace {
+// Build the pool2d of attrs on the NCHW input A on the host, and run it on the random data of A.
+void RunHostPool2d(const NodeAttr &attrs,
+                   Placeholder<float> &A,
+                   const std::vector<int> &a_shape,
+                   const std::vector<int> &out_shape,
+                   std::vector<float> *a_data,
+                   std::vector<float> *out_data) {
+  auto pool2d   = Operator::Get("pool2d");
+  auto strategy = Operator::GetAttrs<StrategyFunction>("CINNStrategy");
+  std::vector<ir::Tensor> inputs{A.tensor()};
+  std::vector<Type> type{Float(32)};
+  common::Target target = common::DefaultHostTarget();
+  auto impl = OpStrategy::SelectImpl(strategy[pool2d](attrs, inputs, type, {out_shape}, target));
+  common::CINNValuePack cinn_input = common::CINNValuePack{{common::CINNValue(A)}};
+  common::CINNValuePack rets       = impl->fcompute(cinn_input);
+  rets                             = impl->fschedule(rets);
+  // the intermediate tensors are in the same function
+  ASSERT_EQ(rets.size(), 2UL);
+  Expr out = rets[0];
+  inputs.push_back(out.as_tensor_ref());
+  auto func = Lower("pool2d", rets.back(), inputs);
+  LOG(INFO) << "Test Strategy Codegen:\n" << func;
+
+  Module::Builder builder("module0", target);
+  builder.AddFunction(func);
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn = reinterpret_cast<void (*)(void *, int32_t)>(jit->Lookup("pool2d"));
+  CHECK(fn);
+
+  cinn_buffer_t *A_buf   = common::BufferBuilder(Float(32), a_shape).set_random().Build();
+  cinn_buffer_t *Out_buf = common::BufferBuilder(Float(32), out_shape).set_zero().Build();
+  cinn_pod_value_t args[] = {cinn_pod_value_t(A_buf), cinn_pod_value_t(Out_buf)};
+  fn(args, 2);
+  auto *a   = reinterpret_cast<float *>(A_buf->memory);
+  auto *res = reinterpret_cast<float *>(Out_buf->memory);
+  a_data->assign(a, a + A_buf->num_elements());
+  out_data->assign(res, res + Out_buf->num_elements());
+}
+}  // namespace
+
+TEST(Operator, Operator_Pool2d_Separable) {
+  // the 5x5 windows of stride 1 are pooled separably
+  Expr N(1), C(2), H(9), W(9);
+  Placeholder<float> A("A", {N, C, H, W});
+  NodeAttr attrs;
+  attrs.attr_store["kernel_size"]  = std::vector<int>{5, 5};
+  attrs.attr_store["stride_size"]  = std::vector<int>{1, 1};
+  attrs.attr_store["padding_size"] = std::vector<int>{2, 2, 2, 2};
+  attrs.attr_store["exclusive"]    = true;
+  ASSERT_TRUE(pe::IsSeparablePool2d({5, 5}, {1, 1}));
+  ASSERT_FALSE(pe::IsSeparablePool2d({3, 3}, {1, 1}));
+  ASSERT_FALSE(pe::IsSeparablePool2d({5, 5}, {2, 2}));
+
+  for (std::string pool_type : {"max", "avg"}) {
+    attrs.attr_store["pool_type"] = pool_type;
+    std::vector<float> a, out;
+    RunHostPool2d(attrs, A, {1, 2, 9, 9}, {1, 2, 9, 9}, &a, &out);
+    for (int c = 0; c < 2; c++) {
+      for (int h = 0; h < 9; h++) {
+        for (int w = 0; w < 9; w++) {
+          float expected = pool_type == "max" ? -INFINITY : 0.f;
+          int count      = 0;
+          for (int i = std::max(h - 2, 0); i < std::min(h + 3, 9); i++) {
+            for (int j = std::max(w - 2, 0); j < std::min(w + 3, 9); j++) {
+              float x  = a[(c * 9 + i) * 9 + j];
+              expected = pool_type == "max" ? std::max(expected, x) : expected + x;
+              count++;
+            }
+          }
+          if (pool_type == "avg") expected /= count;
+          ASSERT_NEAR(out[(c * 9 + h) * 9 + w], expected, 1e-5) << pool_type << " at " << c << ", " << h << ", " << w;
+        }
+      }
+    }
+  }
+}
+
+TEST(Operator, Operator_Pool2d_Global) {
+  // the global pooling is reduced like the reduce ops, by the lanes of the vector accumulators if any
+  Expr N(2), C(3), H(16), W(16);
+  Placeholder<float> A("A", {N, C, H, W});
+  NodeAttr attrs;
+  attrs.attr_store["kernel_size"]    = std::vector<int>{2, 2};
+  attrs.attr_store["stride_size"]    = std::vector<int>{1, 1};
+  attrs.attr_store["padding_size"]   = std::vector<int>{0, 0, 0, 0};
+  attrs.attr_store["global_pooling"] = true;
+
+  for (std::string pool_type : {"max", "avg"}) {
+    attrs.attr_store["pool_type"] = pool_type;
+    std::vector<float> a, out;
+    RunHostPool2d(attrs, A, {2, 3, 16, 16}, {2, 3, 1, 1}, &a, &out);
+    for (int i = 0; i < 2 * 3; i++) {
+      float expected = pool_type == "max" ? -INFINITY : 0.f;
+      for (int j = 0; j < 16 * 16; j++) {
+        float x  = a[i * 16 * 16 + j];
+        expected = pool_type == "max" ? std::max(expected, x) : expected + x;
+      }
+      if (pool_type == "avg") expected /= 16 * 16;
+      ASSERT_NEAR(out[i], expected, 1e-4) << pool_type << " at " << i;
+    }
+  }
+}
+
 TEST(Operator, Operator_Pool3d_Test0) {
   auto pool3d   = Operator::Get("pool3d");
   Operator temp = *pool3d;
@@ -391,6 +499,199 @@ TEST(Operator, Operator_Select_Test0) {
   ASSERT_EQ(select->description, "This operator implements the meta op 'Select'.");
 }
 
+TEST(Operator, Operator_LogSoftmax_Test0) {
+  auto log_softmax = Operator::Get("log_softmax");
+  auto strategy    = Operator::GetAttrs<StrategyFunction>("CINNStrategy");
+
+  constexpr int M = 4, N = 300;
+  Placeholder<float> X("X", {Expr(M), Expr(N)});
+
+  NodeAttr attrs;
+  attrs.attr_store["axis"] = -1;
+  std::vector<ir::Tensor> inputs{X.tensor()};
+  std::vector<Type> type{Float(32)};
+  const common::Target target = common::DefaultHostTarget();
+
+  auto impl = OpStrategy::SelectImpl(strategy[log_softmax](attrs, inputs, type, {{M, N}}, target));
+  common::CINNValuePack cinn_input = common::CINNValuePack{{common::CINNValue(X)}};
+  common::CINNValuePack rets       = impl->fcompute(cinn_input);
+  rets                             = impl->fschedule(rets);
+  // the output, the lse and the StageMap
+  ASSERT_EQ(rets.size(), 3UL);
+  for (int i = 0; i < rets->size() - 1; i++) {
+    Expr temp = rets[i];
+    inputs.push_back(temp.as_tensor_ref());
+  }
+  auto func = Lower("log_softmax", rets.back(), inputs);
+
+  Module::Builder builder("module0", target);
+  builder.AddFunction(func);
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn_ = reinterpret_cast<void (*)(void *, int32_t)>(jit->Lookup("log_softmax"));
+  CHECK(fn_);
+
+  cinn_buffer_t *x_buf   = common::BufferBuilder(Float(32), {M, N}).set_random().Build();
+  cinn_buffer_t *out_buf = common::BufferBuilder(Float(32), {M, N}).set_zero().Build();
+  cinn_buffer_t *lse_buf = common::BufferBuilder(Float(32), {M}).set_zero().Build();
+  cinn_pod_value_t args[] = {cinn_pod_value_t(x_buf), cinn_pod_value_t(out_buf), cinn_pod_value_t(lse_buf)};
+  fn_(args, 3);
+
+  auto *x   = reinterpret_cast<float *>(x_buf->memory);
+  auto *out = reinterpret_cast<float *>(out_buf->memory);
+  for (int i = 0; i < M; i++) {
+    double sum = 0;
+    for (int j = 0; j < N; j++) sum += std::exp(x[i * N + j]);
+    for (int j = 0; j < N; j++) {
+      ASSERT_NEAR(out[i * N + j], x[i * N + j] - std::log(sum), 1e-4);
+    }
+  }
+}
+
+TEST(Operator, Operator_LookupTable_Test0) {
+  auto lookup_table = Operator::Get("lookup_table");
+  auto strategy     = Operator::GetAttrs<StrategyFunction>("CINNStrategy");
+
+  constexpr int V = 100, D = 64, N = 200, kPadding = 3;
+  Placeholder<float> W("W", {Expr(V), Expr(D)});
+  Placeholder<int32_t> Ids("Ids", {Expr(N)});
+
+  NodeAttr attrs;
+  attrs.attr_store["padding_idx"] = kPadding;
+  std::vector<ir::Tensor> inputs{W.tensor(), Ids.tensor()};
+  std::vector<Type> type{Float(32)};
+  const common::Target target = common::DefaultHostTarget();
+
+  auto impl = OpStrategy::SelectImpl(strategy[lookup_table](attrs, inputs, type, {{N, D}}, target));
+  common::CINNValuePack cinn_input = common::CINNValuePack{{common::CINNValue(W), common::CINNValue(Ids)}};
+  common::CINNValuePack rets       = impl->fcompute(cinn_input);
+  rets                             = impl->fschedule(rets);
+  ASSERT_EQ(rets.size(), 2UL);
+  Expr out = rets[0];
+  inputs.push_back(out.as_tensor_ref());
+  auto func = Lower("lookup_table", rets.back(), inputs);
+
+  Module::Builder builder("module0", target);
+  builder.AddFunction(func);
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn_ = reinterpret_cast<void (*)(void *, int32_t)>(jit->Lookup("lookup_table"));
+  CHECK(fn_);
+
+  cinn_buffer_t *w_buf   = common::BufferBuilder(Float(32), {V, D}).set_random().Build();
+  cinn_buffer_t *ids_buf = common::BufferBuilder(Int(32), {N}).set_zero().Build();
+  cinn_buffer_t *out_buf = common::BufferBuilder(Float(32), {N, D}).set_zero().Build();
+  auto *ids              = reinterpret_cast<int32_t *>(ids_buf->memory);
+  for (int i = 0; i < N; i++) ids[i] = (i * 37) % V;
+  cinn_pod_value_t args[] = {cinn_pod_value_t(w_buf), cinn_pod_value_t(ids_buf), cinn_pod_value_t(out_buf)};
+  fn_(args, 3);
+
+  auto *w   = reinterpret_cast<float *>(w_buf->memory);
+  auto *res = reinterpret_cast<float *>(out_buf->memory);
+  for (int i = 0; i < N; i++) {
+    for (int j = 0; j < D; j++) {
+      ASSERT_EQ(res[i * D + j], ids[i] == kPadding ? 0.f : w[ids[i] * D + j]);
+    }
+  }
+}
+
+TEST(Operator, Operator_Argmax_Test0) {
+  auto argmax   = Operator::Get("argmax");
+  auto strategy = Operator::GetAttrs<StrategyFunction>("CINNStrategy");
+
+  constexpr int M = 8, N = 100;
+  Placeholder<float> X("X", {Expr(M), Expr(N)});
+
+  NodeAttr attrs;
+  attrs.attr_store["axis"] = 1;
+  std::vector<ir::Tensor> inputs{X.tensor()};
+  std::vector<Type> type{Int(32)};
+  const common::Target target = common::DefaultHostTarget();
+
+  auto impl = OpStrategy::SelectImpl(strategy[argmax](attrs, inputs, type, {{M}}, target));
+  common::CINNValuePack cinn_input = common::CINNValuePack{{common::CINNValue(X)}};
+  common::CINNValuePack rets       = impl->fcompute(cinn_input);
+  rets                             = impl->fschedule(rets);
+  ASSERT_EQ(rets.size(), 2UL);
+  Expr out = rets[0];
+  inputs.push_back(out.as_tensor_ref());
+  auto func = Lower("argmax", rets.back(), inputs);
+
+  Module::Builder builder("module0", target);
+  builder.AddFunction(func);
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn_ = reinterpret_cast<void (*)(void *, int32_t)>(jit->Lookup("argmax"));
+  CHECK(fn_);
+
+  cinn_buffer_t *x_buf   = common::BufferBuilder(Float(32), {M, N}).set_random().Build();
+  cinn_buffer_t *out_buf = common::BufferBuilder(Int(32), {M}).set_zero().Build();
+  auto *x                = reinterpret_cast<float *>(x_buf->memory);
+  // a tie of the maximum in the first row
+  x[3] = x[7] = 10.f;
+  cinn_pod_value_t args[] = {cinn_pod_value_t(x_buf), cinn_pod_value_t(out_buf)};
+  fn_(args, 2);
+
+  auto *res = reinterpret_cast<int32_t *>(out_buf->memory);
+  for (int i = 0; i < M; i++) {
+    ASSERT_EQ(res[i], std::max_element(x + i * N, x + (i + 1) * N) - (x + i * N));
+  }
+  ASSERT_EQ(res[0], 3);
+}
+
+TEST(Operator, Operator_TopK_Test0) {
+  auto top_k    = Operator::Get("top_k");
+  auto strategy = Operator::GetAttrs<StrategyFunction>("CINNStrategy");
+
+  constexpr int M = 16, N = 1000;
+  const common::Target target = common::DefaultHostTarget();
+  // the heap for a small k, and the partial sort for a large one
+  for (int k : {5, 300}) {
+    Placeholder<float> X("X", {Expr(M), Expr(N)});
+    NodeAttr attrs;
+    attrs.attr_store["k"] = k;
+    std::vector<ir::Tensor> inputs{X.tensor()};
+    std::vector<Type> type{Float(32), Int(32)};
+
+    auto impl = OpStrategy::SelectImpl(strategy[top_k](attrs, inputs, type, {{M, k}, {M, k}}, target));
+    common::CINNValuePack cinn_input = common::CINNValuePack{{common::CINNValue(X)}};
+    common::CINNValuePack rets       = impl->fcompute(cinn_input);
+    rets                             = impl->fschedule(rets);
+    ASSERT_EQ(rets.size(), 3UL);
+    for (int i = 0; i < rets->size() - 1; i++) {
+      Expr temp = rets[i];
+      inputs.push_back(temp.as_tensor_ref());
+    }
+    auto func = Lower("top_k", rets.back(), inputs);
+
+    Module::Builder builder("module0", target);
+    builder.AddFunction(func);
+    auto jit = backends::ExecutionEngine::Create({});
+    jit->Link(builder.Build());
+    auto fn_ = reinterpret_cast<void (*)(void *, int32_t)>(jit->Lookup("top_k"));
+    CHECK(fn_);
+
+    cinn_buffer_t *x_buf       = common::BufferBuilder(Float(32), {M, N}).set_random().Build();
+    cinn_buffer_t *values_buf  = common::BufferBuilder(Float(32), {M, k}).set_zero().Build();
+    cinn_buffer_t *indices_buf = common::BufferBuilder(Int(32), {M, k}).set_zero().Build();
+    cinn_pod_value_t args[]    = {
+        cinn_pod_value_t(x_buf), cinn_pod_value_t(values_buf), cinn_pod_value_t(indices_buf)};
+    fn_(args, 3);
+
+    auto *x       = reinterpret_cast<float *>(x_buf->memory);
+    auto *values  = reinterpret_cast<float *>(values_buf->memory);
+    auto *indices = reinterpret_cast<int32_t *>(indices_buf->memory);
+    for (int i = 0; i < M; i++) {
+      std::vector<float> row(x + i * N, x + (i + 1) * N);
+      std::sort(row.begin(), row.end(), std::greater<float>());
+      for (int j = 0; j < k; j++) {
+        ASSERT_EQ(values[i * k + j], row[j]);
+        ASSERT_EQ(x[i * N + indices[i * k + j]], row[j]);
+      }
+    }
+  }
+}
+
 TEST(Operator, Operator_Reverse_Test0) {
   auto reverse  = Operator::Get("reverse");
   Operator temp = *reverse;
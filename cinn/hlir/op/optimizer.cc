@@ -0,0 +1,133 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/op_strategy.h"
+#include "cinn/runtime/multi_tensor_optimizer.h"
+
+namespace cinn {
+namespace hlir {
+namespace op {
+using framework::OpStrategy;
+using framework::shape_t;
+using framework::StrategyFunction;
+using runtime::OptimizerKind;
+
+/**
+ * The multi-tensor optimizers update n parameters in one op, see runtime::MultiTensorOptimizer for the order of the
+ * inputs and the outputs. With the attribute multi_precision, the parameters and the gradients are float16 and
+ * updated by the float32 master weights. They are not lowered but run by the runtime kernel of the instruction, which
+ * processes all the parameters in a single parallel loop on CPU, or a single launch on NVGPU.
+ */
+namespace {
+
+bool IsMultiPrecision(const framework::AttrMapType &attrs) {
+  return attrs.count("multi_precision") && absl::get<bool>(attrs.at("multi_precision"));
+}
+
+// The number of the parameters of the inputs.
+int NumParams(OptimizerKind kind, size_t num_inputs, const framework::AttrMapType &attrs) {
+  int lists = 2 + runtime::NumOptimizerStates(kind) + IsMultiPrecision(attrs);
+  int pows  = kind == OptimizerKind::kAdam ? 2 : 0;
+  CHECK(num_inputs > pows && (num_inputs - pows) % lists == 0)
+      << "The multi-tensor optimizer should take " << lists << " lists of the same number of tensors"
+      << (pows ? " and the beta1_pow and beta2_pow" : "") << ", but got " << num_inputs << " inputs";
+  return (num_inputs - pows) / lists;
+}
+
+}  // namespace
+
+std::shared_ptr<OpStrategy> StrategyForMultiTensorOptimizer(const framework::NodeAttr &attrs,
+                                                            const std::vector<ir::Tensor> &inputs,
+                                                            const std::vector<Type> &out_type,
+                                                            const std::vector<std::vector<int>> &output_shapes,
+                                                            const Target &target) {
+  LOG(FATAL) << "The multi-tensor optimizers run by the runtime kernel of the instruction and are not lowered.";
+}
+
+template <OptimizerKind kind>
+std::vector<shape_t> InferShapeForMultiTensorOptimizer(const std::vector<shape_t> &inputs_shape,
+                                                       const framework::AttrMapType &attrs) {
+  int n          = NumParams(kind, inputs_shape.size(), attrs);
+  int num_states = runtime::NumOptimizerStates(kind);
+  for (int t = 0; t < n; t++) {
+    for (int list = 1; list < 2 + num_states + IsMultiPrecision(attrs); list++) {
+      CHECK(inputs_shape[list * n + t] == inputs_shape[t])
+          << "The shape of the input " << list * n + t << " should be the same as its param " << t;
+    }
+  }
+  if (kind == OptimizerKind::kAdam) {
+    for (int i = inputs_shape.size() - 2; i < inputs_shape.size(); i++) {
+      CHECK(inputs_shape[i] == shape_t{1}) << "The beta1_pow and beta2_pow should have a single element";
+    }
+  }
+  // the outputs are the inputs without the grads
+  std::vector<shape_t> res(inputs_shape.begin(), inputs_shape.begin() + n);
+  res.insert(res.end(), inputs_shape.begin() + 2 * n, inputs_shape.end());
+  return res;
+}
+
+template <OptimizerKind kind>
+std::vector<Type> InferDtypeForMultiTensorOptimizer(const std::vector<Type> &inputs_type,
+                                                    const framework::AttrMapType &attrs) {
+  int n      = NumParams(kind, inputs_type.size(), attrs);
+  Type param = IsMultiPrecision(attrs) ? Float(16) : Float(32);
+  for (int i = 0; i < inputs_type.size(); i++) {
+    // the params and the grads are float16 with multi_precision, and the others are float32
+    Type expected = i < 2 * n ? param : Float(32);
+    CHECK_EQ(inputs_type[i], expected) << "The input " << i << " of the multi-tensor optimizer should be " << expected;
+  }
+  std::vector<Type> res(inputs_type.begin(), inputs_type.begin() + n);
+  res.insert(res.end(), inputs_type.begin() + 2 * n, inputs_type.end());
+  return res;
+}
+
+}  // namespace op
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(optimizer_ops) {
+  using cinn::hlir::op::InferDtypeForMultiTensorOptimizer;
+  using cinn::hlir::op::InferShapeForMultiTensorOptimizer;
+  using cinn::runtime::OptimizerKind;
+#define CINN_REGISTER_MULTI_TENSOR_OPTIMIZER(op__, kind__, description__)                                              \
+  CINN_REGISTER_OP(op__)                                                                                               \
+      .describe(description__)                                                                                         \
+      .set_num_outputs(0)                                                                                              \
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy",                                               \
+                                                         cinn::hlir::op::StrategyForMultiTensorOptimizer)              \
+      .set_attr("infershape", MakeOpFunction(InferShapeForMultiTensorOptimizer<OptimizerKind::kind__>))                \
+      .set_attr("inferdtype", MakeOpFunction(InferDtypeForMultiTensorOptimizer<OptimizerKind::kind__>))                \
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)      \
+      .set_support_level(4);
+
+  CINN_REGISTER_MULTI_TENSOR_OPTIMIZER(
+      multi_tensor_sgd, kSgd, "Update the params by sgd, param -= learning_rate * grad.");
+  CINN_REGISTER_MULTI_TENSOR_OPTIMIZER(multi_tensor_momentum,
+                                       kMomentum,
+                                       "Update the params and the velocities by momentum, velocity = momentum * "
+                                       "velocity + grad, and param -= learning_rate * velocity, or by nesterov.");
+  CINN_REGISTER_MULTI_TENSOR_OPTIMIZER(multi_tensor_adam,
+                                       kAdam,
+                                       "Update the params, the moment1 and the moment2 by adam, with the learning "
+                                       "rate corrected by the beta1_pow and beta2_pow, which are advanced too.");
+
+#undef CINN_REGISTER_MULTI_TENSOR_OPTIMIZER
+
+  return true;
+}
@@ -14,6 +14,7 @@
 
 #include "cinn/hlir/pe/reduction.h"
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -47,6 +48,33 @@ using PeFunc = std::function<ir::Tensor(const ir::Tensor &, const std::vector<in
     return StrategyForReduce(attrs, inputs, out_type, output_shapes, target, #op_name__, pe__);     \
   }
 
+// The sorted dims to reduce, all the dims if \p dim is empty.
+std::vector<int> GetRealReduceDims(const ir::Tensor &A, const std::vector<int> &dim) {
+  int ndim = A->shape.size();
+  std::vector<int> real_dims;
+  for (int i : dim) real_dims.push_back(i < 0 ? i + ndim : i);
+  if (real_dims.empty()) {
+    for (int i = 0; i < ndim; i++) real_dims.push_back(i);
+  }
+  std::sort(real_dims.begin(), real_dims.end());
+  real_dims.erase(std::unique(real_dims.begin(), real_dims.end()), real_dims.end());
+  return real_dims;
+}
+
+// The sorted dims to reduce if they are the trailing dims of constant extents, otherwise empty.
+std::vector<int> GetTrailingReduceDims(const ir::Tensor &A, const std::vector<int> &dim) {
+  int ndim       = A->shape.size();
+  auto real_dims = GetRealReduceDims(A, dim);
+  if (real_dims.empty()) return {};
+  for (int i = 0; i < real_dims.size(); i++) {
+    if (real_dims[i] != ndim - real_dims.size() + i || !A->shape[real_dims[i]].is_constant()) return {};
+  }
+  for (int i = 0; i < real_dims.front(); i++) {
+    if (!A->shape[i].is_constant()) return {};
+  }
+  return real_dims;
+}
+
 std::shared_ptr<OpStrategy> StrategyForReduce(const framework::NodeAttr &attrs,
                                               const std::vector<ir::Tensor> &inputs,
                                               const std::vector<Type> &out_type,
@@ -62,36 +90,141 @@ std::shared_ptr<OpStrategy> StrategyForReduce(const framework::NodeAttr &attrs,
   if (attrs.attr_store.count("keep_dim")) {
     keep_dim = absl::get<bool>(attrs.attr_store.at("keep_dim"));
   }
+  // the reductions computed into the local buffers of their epilogues are reduced by one thread for each output
+  bool reduce_per_thread = attrs.attr_store.count("reduce_per_thread");
+  // on X86, the trailing reduced axes are split into the interleaved parts of the vector accumulators, while the
+  // reductions keeping the innermost axis, or reducing the other axes out of the trailing ones, are vectorized along it
+  std::vector<int> cpu_trailing_dims;
+  int cpu_parts           = 1;
+  bool cpu_keep_innermost = false;
+  if (target.arch == Target::Arch::X86 && !reduce_per_thread && !inputs.empty()) {
+    const ir::Tensor &A = inputs[0];
+    int ndim            = A->shape.size();
+    std::vector<int> real_dims;
+    for (int i : dim) real_dims.push_back(i < 0 ? i + ndim : i);
+    if (real_dims.empty()) {
+      for (int i = 0; i < ndim; i++) real_dims.push_back(i);
+    }
+    std::sort(real_dims.begin(), real_dims.end());
+    real_dims.erase(std::unique(real_dims.begin(), real_dims.end()), real_dims.end());
+    bool is_constant = std::all_of(A->shape.begin(), A->shape.end(), [](const Expr &e) { return e.is_constant(); });
+    if (is_constant && real_dims.back() == ndim - 1) {
+      // the run of the reduced axes ending at the innermost one
+      int reduce_numel = 1;
+      for (int i = real_dims.size() - 1; i >= 0 && real_dims[i] == ndim - real_dims.size() + i; i--) {
+        cpu_trailing_dims.insert(cpu_trailing_dims.begin(), real_dims[i]);
+        reduce_numel *= A->shape[real_dims[i]].as_int32();
+      }
+      cpu_parts          = pe::GetCpuReduceParts(reduce_numel, A->type(), target);
+      cpu_keep_innermost = cpu_parts > 1 && cpu_trailing_dims.size() < real_dims.size();
+    } else if (is_constant) {
+      cpu_keep_innermost = true;
+    }
+  }
   framework::CINNCompute reduction_compute([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input argument of " << op_name << " compute is empty! Please check.";
     CINNValuePack a = args[0];
     CHECK_EQ(a.size(), 1U) << "1 input tensor for " << op_name << " compute";
     Expr A_expr = a[0];
     CHECK(A_expr.as_tensor());
-    ir::Tensor A = A_expr.as_tensor_ref();
-    auto out     = pe_func(A, dim, keep_dim, Expr(), UniqName(op_name + "_out"));
-    auto stages  = CreateStages({A, out});
-    *ret         = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+    ir::Tensor A   = A_expr.as_tensor_ref();
+    int num_parts  = 1;
+    auto real_dims = GetTrailingReduceDims(A, dim);
+    if (target.arch == Target::Arch::NVGPU && !reduce_per_thread && !real_dims.empty()) {
+      int reduce_numel = 1;
+      for (int i : real_dims) reduce_numel *= A->shape[i].as_int32();
+      int output_numel = 1;
+      for (int i = 0; i < real_dims.front(); i++) output_numel *= A->shape[i].as_int32();
+      num_parts = pe::GetCudaReduceParts(output_numel, reduce_numel, target);
+    }
+    // the other reductions of a few outputs, e.g. the column sums, are split along the first reduced dim
+    int outer_parts  = 1;
+    bool is_constant = std::all_of(A->shape.begin(), A->shape.end(), [](const Expr &e) { return e.is_constant(); });
+    if (target.arch == Target::Arch::NVGPU && !reduce_per_thread && real_dims.empty() && is_constant) {
+      auto reduce_dims = GetRealReduceDims(A, dim);
+      int reduce_numel = 1, output_numel = 1;
+      for (int i = 0; i < A->shape.size(); i++) {
+        bool reduced = std::binary_search(reduce_dims.begin(), reduce_dims.end(), i);
+        (reduced ? reduce_numel : output_numel) *= A->shape[i].as_int32();
+      }
+      outer_parts = pe::GetCudaReduceParts(output_numel, reduce_numel, target);
+      while (outer_parts > 1 && A->shape[reduce_dims.front()].as_int32() % outer_parts != 0) outer_parts /= 2;
+    }
+    if (cpu_parts > 1) {
+      VLOG(3) << op_name << " is reduced by " << cpu_parts << " lanes of the vector accumulators";
+      bool trailing = !cpu_keep_innermost;
+      auto outs     = pe::TwoStageReduce(A,
+                                         cpu_trailing_dims,
+                                         pe_func,
+                                         cpu_parts,
+                                         trailing ? keep_dim : true,
+                                         UniqName(op_name + (trailing ? "_out" : "_inner_out")),
+                                         true);
+      auto stages = CreateStages({A, outs[0]});
+      stages->InsertLazily(outs[1]);
+      stages->InsertLazily(outs[2]);
+      stages[outs[2]]->ComputeInline();
+      if (trailing) {
+        *ret = CINNValuePack{{CINNValue(outs[0]), CINNValue(outs[1]), CINNValue(stages)}};
+      } else {
+        // the other axes are reduced out of the trailing ones kept as 1s, along the innermost kept axis
+        auto out = pe_func(outs[0], dim, keep_dim, Expr(), UniqName(op_name + "_out"));
+        stages->InsertLazily(out);
+        *ret = CINNValuePack{{CINNValue(out), CINNValue(outs[1]), CINNValue(stages)}};
+      }
+    } else if (num_parts > 1) {
+      VLOG(3) << op_name << " is reduced in " << num_parts << " parts";
+      auto outs   = pe::TwoStageReduce(A, real_dims, pe_func, num_parts, keep_dim, UniqName(op_name + "_out"));
+      auto stages = CreateStages({A, outs[0]});
+      stages->InsertLazily(outs[1]);
+      stages->InsertLazily(outs[2]);
+      stages[outs[2]]->ComputeInline();
+      *ret = CINNValuePack{{CINNValue(outs[0]), CINNValue(outs[1]), CINNValue(stages)}};
+    } else if (outer_parts > 1) {
+      VLOG(3) << op_name << " is reduced in " << outer_parts << " parts of the first reduced dim";
+      auto outs   = pe::TwoStageReduceOuter(A, dim, pe_func, outer_parts, keep_dim, UniqName(op_name + "_out"));
+      auto stages = CreateStages({A, outs[0]});
+      stages->InsertLazily(outs[1]);
+      stages->InsertLazily(outs[2]);
+      stages[outs[2]]->ComputeInline();
+      *ret = CINNValuePack{{CINNValue(outs[0]), CINNValue(outs[1]), CINNValue(stages)}};
+    } else {
+      auto out    = pe_func(A, dim, keep_dim, Expr(), UniqName(op_name + "_out"));
+      auto stages = CreateStages({A, out});
+      *ret        = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+    }
   });
 
   framework::CINNSchedule reduction_schedule([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input argument of " << op_name << " schedule is empty! Please check.";
     CINNValuePack arg_pack = args[0];
-    CHECK_EQ(arg_pack.size(), 2UL);
-    Expr Out              = arg_pack[0];
-    poly::StageMap stages = arg_pack[1];
-    CHECK(Out.as_tensor());
-    auto out = Out.as_tensor_ref();
+    CHECK(arg_pack.size() == 2UL || arg_pack.size() == 3UL);
+    poly::StageMap stages = arg_pack.back();
     if (target.arch == Target::Arch::NVGPU) {
-      if (out->shape.size() > 1) {
-        stages[out]->Split(1, 2);
-        stages[out]->Bind(0, "blockIdx.x");
-        stages[out]->Bind(1, "threadIdx.x");
-      } else {
-        stages[out]->Split(0, 2);
-        stages[out]->Bind(0, "blockIdx.x");
-        stages[out]->Bind(1, "threadIdx.x");
+      // the partial reduction of the two stages is another kernel, which is scheduled the same way
+      for (int i = 0; i < arg_pack.size() - 1; i++) {
+        Expr out = arg_pack[i];
+        CHECK(out.as_tensor());
+        if (arg_pack.size() == 2UL) {
+          arg_pack[i] = Expr(pe::CudaScheduleCachedReduce(stages, out.as_tensor_ref(), target));
+        } else {
+          pe::CudaScheduleReduce(stages, out.as_tensor_ref(), target);
+        }
+      }
+    } else if (target.arch == Target::Arch::X86) {
+      Expr out = arg_pack[0];
+      CHECK(out.as_tensor());
+      if (cpu_parts > 1) {
+        // the partial reduction is in the same function, into a temporary buffer
+        CHECK_EQ(arg_pack.size(), 3UL);
+        Expr partial = arg_pack[1];
+        CHECK(partial.as_tensor());
+        pe::ScheduleReduceCPU(stages[partial.as_tensor_ref()], target);
+        if (cpu_keep_innermost) pe::ScheduleReduceCPU(stages[out.as_tensor_ref()], target);
+        *ret = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+        return;
       }
+      if (cpu_keep_innermost) pe::ScheduleReduceCPU(stages[out.as_tensor_ref()], target);
     }
     *ret = arg_pack;
   });
@@ -159,6 +292,165 @@ std::vector<std::vector<std::string>> InferLayoutForReduction(const std::vector<
   return {{""}, new_input_layouts};
 }
 
+std::shared_ptr<OpStrategy> StrategyForArgReduce(const framework::NodeAttr &attrs,
+                                                 const std::vector<ir::Tensor> &inputs,
+                                                 const std::vector<Type> &out_type,
+                                                 const std::vector<std::vector<int>> &output_shapes,
+                                                 const Target &target,
+                                                 const std::string &op_name,
+                                                 bool is_max) {
+  int axis      = -1;
+  bool keep_dim = false;
+  if (attrs.attr_store.count("axis")) {
+    axis = absl::get<int>(attrs.attr_store.at("axis"));
+  }
+  if (attrs.attr_store.count("keep_dim")) {
+    keep_dim = absl::get<bool>(attrs.attr_store.at("keep_dim"));
+  }
+  framework::CINNCompute arg_reduce_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of " << op_name << " compute is empty! Please check.";
+    CINNValuePack a = args[0];
+    CHECK_EQ(a.size(), 1U) << "1 input tensor for " << op_name << " compute";
+    Expr A_expr = a[0];
+    CHECK(A_expr.as_tensor());
+    ir::Tensor A = A_expr.as_tensor_ref();
+    auto outs    = is_max ? pe::Argmax(A, axis, keep_dim, UniqName(op_name + "_out"))
+                          : pe::Argmin(A, axis, keep_dim, UniqName(op_name + "_out"));
+    auto stages  = CreateStages({A, outs[0], outs[1]});
+    *ret         = CINNValuePack{{CINNValue(outs[0]), CINNValue(outs[1]), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule arg_reduce_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of " << op_name << " schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 3UL);
+    Expr index            = arg_pack[0];
+    Expr value            = arg_pack[1];
+    poly::StageMap stages = arg_pack.back();
+    CHECK(index.as_tensor() && value.as_tensor());
+    if (target.arch == Target::Arch::NVGPU) {
+      // the value is reduced by a block for each output if the row is long, and the index by a thread
+      pe::CudaScheduleReduce(stages, value.as_tensor_ref(), target);
+      pe::CudaScheduleReduce(stages, index.as_tensor_ref(), target);
+    }
+    *ret = CINNValuePack{{CINNValue(index), CINNValue(stages)}};
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(arg_reduce_compute, arg_reduce_schedule, "strategy." + op_name + ".x86", 1);
+  return strategy;
+}
+
+std::shared_ptr<OpStrategy> StrategyForArgmax(const framework::NodeAttr &attrs,
+                                              const std::vector<ir::Tensor> &inputs,
+                                              const std::vector<Type> &out_type,
+                                              const std::vector<std::vector<int>> &output_shapes,
+                                              const Target &target) {
+  return StrategyForArgReduce(attrs, inputs, out_type, output_shapes, target, "argmax", true);
+}
+
+std::shared_ptr<OpStrategy> StrategyForArgmin(const framework::NodeAttr &attrs,
+                                              const std::vector<ir::Tensor> &inputs,
+                                              const std::vector<Type> &out_type,
+                                              const std::vector<std::vector<int>> &output_shapes,
+                                              const Target &target) {
+  return StrategyForArgReduce(attrs, inputs, out_type, output_shapes, target, "argmin", false);
+}
+
+std::vector<shape_t> InferShapeForArgReduce(const std::vector<shape_t> &inputs_shape,
+                                            const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 1UL);
+  int axis      = attrs.count("axis") ? absl::get<int>(attrs.at("axis")) : -1;
+  bool keep_dim = attrs.count("keep_dim") ? absl::get<bool>(attrs.at("keep_dim")) : false;
+  int ndim      = inputs_shape[0].size();
+  if (axis < 0) axis += ndim;
+  CHECK(axis >= 0 && axis < ndim) << "The axis should be in [-ndim, ndim)";
+  shape_t out_shape;
+  for (int i = 0; i < ndim; ++i) {
+    if (i != axis) {
+      out_shape.push_back(inputs_shape[0][i]);
+    } else if (keep_dim) {
+      out_shape.push_back(1);
+    }
+  }
+  if (out_shape.empty()) {
+    out_shape.push_back(1);
+  }
+  return {out_shape};
+}
+
+std::vector<Type> InferDtypeForArgReduce(const std::vector<Type> &inputs_type, const framework::AttrMapType &attrs) {
+  CHECK(!inputs_type.empty()) << "The input's type size is 0! Please check again.";
+  return {Int(32)};
+}
+
+std::shared_ptr<OpStrategy> StrategyForTopK(const framework::NodeAttr &attrs,
+                                            const std::vector<ir::Tensor> &inputs,
+                                            const std::vector<Type> &out_type,
+                                            const std::vector<std::vector<int>> &output_shapes,
+                                            const Target &target) {
+  CHECK(attrs.attr_store.count("k")) << "find no attr of k";
+  int k        = absl::get<int>(attrs.attr_store.at("k"));
+  bool largest = true;
+  if (attrs.attr_store.count("largest")) {
+    largest = absl::get<bool>(attrs.attr_store.at("largest"));
+  }
+  framework::CINNCompute top_k_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of top_k compute is empty! Please check.";
+    CINNValuePack a = args[0];
+    CHECK_EQ(a.size(), 1U) << "1 input tensor for top_k compute";
+    Expr A_expr = a[0];
+    CHECK(A_expr.as_tensor());
+    ir::Tensor A = A_expr.as_tensor_ref();
+    auto outs    = pe::TopK(A, k, largest, target, UniqName("top_k_out"));
+    auto stages  = CreateStages({A});
+    std::vector<CINNValue> res;
+    for (auto &t : outs) {
+      stages->InsertLazily(t);
+      res.push_back(CINNValue(t));
+    }
+    res.push_back(CINNValue(stages));
+    *ret = CINNValuePack{res};
+  });
+
+  framework::CINNSchedule top_k_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of top_k schedule is empty! Please check.";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 4UL);
+    Expr values           = arg_pack[0];
+    Expr indices          = arg_pack[1];
+    Expr call             = arg_pack[2];
+    poly::StageMap stages = arg_pack.back();
+    CHECK(call.as_tensor());
+    if (target.arch == Target::Arch::NVGPU) {
+      // a block selects each row
+      stages[call.as_tensor_ref()]->Bind(0, "blockIdx.x");
+      stages[call.as_tensor_ref()]->Bind(1, "threadIdx.x");
+    }
+    *ret = CINNValuePack{{CINNValue(values), CINNValue(indices), CINNValue(stages)}};
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(top_k_compute, top_k_schedule, "strategy.top_k.x86", 1);
+  return strategy;
+}
+
+std::vector<shape_t> InferShapeForTopK(const std::vector<shape_t> &inputs_shape, const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 1UL);
+  CHECK(!inputs_shape[0].empty()) << "The input of top_k should not be a scalar";
+  CHECK(attrs.count("k")) << "find no attr of k";
+  int k = absl::get<int>(attrs.at("k"));
+  CHECK(k > 0 && k <= inputs_shape[0].back()) << "The k of top_k should be in [1, " << inputs_shape[0].back() << "]";
+  shape_t out_shape = inputs_shape[0];
+  out_shape.back()  = k;
+  return {out_shape, out_shape};
+}
+
+std::vector<Type> InferDtypeForTopK(const std::vector<Type> &inputs_type, const framework::AttrMapType &attrs) {
+  CHECK(!inputs_type.empty()) << "The input's type size is 0! Please check again.";
+  return {inputs_type[0], Int(32)};
+}
+
 StrategyForReduction(reduce_sum, ReduceSum, PeFunc);
 StrategyForReduction(reduce_prod, ReduceProd, PeFunc);
 StrategyForReduction(reduce_max, ReduceMax, PeFunc);
@@ -190,5 +482,37 @@ CINN_REGISTER_HELPER(reduce_ops) {
 
 #undef CINN_REGISTER_REDUCTION
 
+  CINN_REGISTER_OP(argmax)
+      .describe("The int32 indices of the maximum along the attr axis, the first one of the ties.")
+      .set_num_inputs(1)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForArgmax)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForArgReduce))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForArgReduce))
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForReduction))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kCommReduce)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(argmin)
+      .describe("The int32 indices of the minimum along the attr axis, the first one of the ties.")
+      .set_num_inputs(1)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForArgmin)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForArgReduce))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForArgReduce))
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForReduction))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kCommReduce)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(top_k)
+      .describe("The k largest, or smallest, elements of the last axis in order, and their int32 indices.")
+      .set_num_inputs(1)
+      .set_num_outputs(2)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForTopK)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForTopK))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForTopK))
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
+      .set_support_level(4);
+
   return true;
 }
@@ -114,11 +114,68 @@ void GetMatmulNewShapes(const std::vector<std::vector<int>> &inputs_shape,
   }
 }
 
+namespace {
+// The constant shape of \p tensor, or empty if any dimension is not constant.
+std::vector<int> GetConstantShape(const ir::Tensor &tensor) {
+  std::vector<int> shape;
+  for (auto &dim : tensor->shape) {
+    if (!dim.is_constant()) return {};
+    shape.push_back(dim.as_int32());
+  }
+  return shape;
+}
+
+// Whether the matmul of \p inputs is computed by pe::MatmulSmall, see pe::UseSmallMatmul.
+bool IsSmallMatmul(const framework::NodeAttr &attrs, const std::vector<ir::Tensor> &inputs) {
+  if (inputs.size() < 2U) return false;
+  auto &attr_store = attrs.attr_store;
+  bool trans_a     = attr_store.count("trans_a") && absl::get<bool>(attr_store.at("trans_a"));
+  bool trans_b     = attr_store.count("trans_b") && absl::get<bool>(attr_store.at("trans_b"));
+  auto shape_A     = GetConstantShape(inputs[0]);
+  auto shape_B     = GetConstantShape(inputs[1]);
+  if (shape_A.empty() || shape_B.empty()) return false;
+  std::vector<int> new_shape_A = shape_A;
+  std::vector<int> new_shape_B = shape_B;
+  std::vector<int> output_shape;
+  GetMatmulNewShapes({shape_A, shape_B}, trans_a, trans_b, &new_shape_A, &new_shape_B, &output_shape);
+  int rank = new_shape_A.size();
+  int K    = trans_a ? new_shape_A[rank - 2] : new_shape_A.back();
+  return pe::UseSmallMatmul(output_shape[output_shape.size() - 2], output_shape.back(), K);
+}
+
+// Whether the mul of \p inputs is computed by pe::MatmulSmall, see pe::UseSmallMul.
+bool IsSmallMul(const framework::NodeAttr &attrs, const std::vector<ir::Tensor> &inputs) {
+  if (inputs.size() < 2U) return false;
+  auto &attr_store   = attrs.attr_store;
+  int x_num_col_dims = attr_store.count("x_num_col_dims") ? absl::get<int>(attr_store.at("x_num_col_dims")) : 1;
+  int y_num_col_dims = attr_store.count("y_num_col_dims") ? absl::get<int>(attr_store.at("y_num_col_dims")) : 1;
+  auto shape_A       = GetConstantShape(inputs[0]);
+  auto shape_B       = GetConstantShape(inputs[1]);
+  return !shape_A.empty() && !shape_B.empty() && pe::UseSmallMul(shape_A, shape_B, x_num_col_dims, y_num_col_dims);
+}
+
+// Schedule the output of pe::MatmulSmall in \p arg_pack.
+void ScheduleSmallMatmul(const CINNValuePack &arg_pack, const Target &target) {
+  CHECK_EQ(arg_pack.size(), 2UL);
+  Expr out              = arg_pack[0];
+  poly::StageMap stages = arg_pack.back();
+  CHECK(out.as_tensor());
+  auto output_shape = GetConstantShape(out.as_tensor_ref());
+  if (target.arch == Target::Arch::NVGPU) {
+    pe::CudaScheduleSmallMatmul(stages[out.as_tensor_ref()], output_shape, target);
+  } else if (target.is_cpu()) {
+    pe::ScheduleSmallMatmulCPU(stages[out.as_tensor_ref()], output_shape, target);
+  }
+}
+}  // namespace
+
 std::shared_ptr<OpStrategy> StrategyForMatMul(const framework::NodeAttr &attrs,
                                               const std::vector<ir::Tensor> &inputs,
                                               const std::vector<Type> &out_type,
                                               const std::vector<std::vector<int>> &output_shapes,
                                               const Target &target) {
+  // the tiny matrices, e.g. the batches of 3x3 ones, are unrolled instead of the library calls and the tiled schedules
+  bool use_small = IsSmallMatmul(attrs, inputs);
   framework::CINNCompute matmul_compute([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input arguments of Matmul compute is empty! Please check.\n";
     CINNValuePack a = args[0];
@@ -173,11 +230,13 @@ std::shared_ptr<OpStrategy> StrategyForMatMul(const framework::NodeAttr &attrs,
     new_A = tensor_A->Reshape(new_shape_A_e, stages);
     new_B = tensor_B->Reshape(new_shape_B_e, stages);
     std::vector<ir::Tensor> out;
-    if (target.arch == Target::Arch::X86) {
+    if (use_small) {
+      out = pe::MatmulSmall(new_A, new_B, trans_a, trans_b, alpha, UniqName("MatmulSmall_output"));
+    } else if (target.is_cpu()) {
 #ifdef CINN_WITH_MKL_CBLAS
       out = pe::MatmulMKL(new_A, new_B, trans_a, trans_b, alpha, UniqName("MatmulMKL_output"), target);
 #else
-      out = pe::MatmulV2(new_A, new_B, trans_a, trans_b, alpha, UniqName("MatmulV2_output"), target);
+      out = pe::MatmulPacked(new_A, new_B, trans_a, trans_b, alpha, UniqName("MatmulPacked_output"), target);
 #endif
     } else {
       out = pe::Matmul(new_A, new_B, trans_a, trans_b, alpha, UniqName("Matmul_output"));
@@ -196,24 +255,30 @@ std::shared_ptr<OpStrategy> StrategyForMatMul(const framework::NodeAttr &attrs,
     CHECK(!args.empty()) << "The input argument of matmul schedule is empty! Please check.\n";
     CINNValuePack arg_pack = args[0];
     int arg_size           = arg_pack.size();
-    CHECK(arg_size == 2UL || arg_size == 3UL);
+    CHECK(arg_size >= 2UL && arg_size <= 4UL);
     poly::StageMap stages = arg_pack.back();
-    if (target.arch == Target::Arch::NVGPU) {
-      Expr out = arg_pack[0];
-      CHECK(out.as_tensor());
-      stages[out.as_tensor_ref()]->Split(1, 2);
-      stages[out.as_tensor_ref()]->Bind(0, "blockIdx.x");
-      stages[out.as_tensor_ref()]->Bind(1, "threadIdx.x");
-    } else if (target.arch == Target::Arch::X86) {
+    if (use_small) {
+      ScheduleSmallMatmul(arg_pack, target);
+    } else if (target.arch == Target::Arch::NVGPU) {
+      for (int i = 0; i < arg_size - 1; i++) {
+        Expr out = arg_pack[i];
+        CHECK(out.as_tensor());
+        pe::CudaScheduleMul(stages, out.as_tensor_ref(), output_shapes.front(), target);
+      }
+    } else if (target.is_cpu()) {
 #ifdef CINN_WITH_MKL_CBLAS
       CHECK_EQ(arg_pack.size(), 3UL);
 #else
-      CHECK(arg_pack.size() == 3UL);
+      CHECK_EQ(arg_pack.size(), 4UL);
       Expr out     = arg_pack[0];
       Expr packedB = arg_pack[1];
-      CHECK(packedB.as_tensor());
+      Expr packedA = arg_pack[2];
       CHECK(out.as_tensor());
-      pe::MatmulScheduleCPU(stages, out.as_tensor_ref(), packedB.as_tensor_ref(), target);
+      CHECK(packedB.as_tensor());
+      CHECK(packedA.as_tensor());
+      pe::MatmulScheduleCPU(stages, out.as_tensor_ref(), packedB.as_tensor_ref(), packedA.as_tensor_ref(), target);
+      // the packed A is a temporary tensor rather than an output
+      arg_pack = CINNValuePack{{arg_pack[0], arg_pack[1], CINNValue(stages)}};
 #endif
     }
     *ret = arg_pack;
@@ -250,14 +315,15 @@ std::vector<std::vector<int>> InferShapeForMatMul(const std::vector<std::vector<
   CHECK_GE(new_shape_A.size(), 2U) << "new_shape_A's size should be no less than two";
   CHECK_GE(new_shape_B.size(), 2U) << "new_shape_B's size should be no less than two";
   CHECK_GE(output_shape.size(), 2U) << "output shape for matmul should be no less than two";
-  int k  = new_shape_A.back();
+  int k  = trans_a ? new_shape_A[new_shape_A.size() - 2] : new_shape_A.back();
+  int m  = output_shape[output_shape.size() - 2];
   int n  = output_shape.back();
-  int bn = pe::GetArrayPackingFactor(n, Float(32), common::DefaultHostTarget());
+  int bn = pe::GetX86GemmBlocking(m, n, k, Float(32), common::DefaultHostTarget()).nr;
 
   packedB_shape = {n / bn, k, bn};
   if (output_shape.size() > 2) {
-    CHECK_EQ(new_shape_A.size(), output_shape.size());
-    packedB_shape.insert(packedB_shape.begin(), new_shape_A.front());
+    CHECK_EQ(new_shape_B.size(), output_shape.size());
+    packedB_shape.insert(packedB_shape.begin(), new_shape_B.front());
   }
   std::vector<std::vector<int>> res{output_shape, packedB_shape};
   return res;
@@ -323,7 +389,7 @@ std::shared_ptr<OpStrategy> StrategyForReshape(const framework::NodeAttr &attrs,
     CHECK(out.as_tensor());
     if (target.arch == Target::Arch::NVGPU) {
       pe::CudaScheduleInjective(stages[out.as_tensor_ref()], output_shapes[0], target);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       pe::ScheduleInjectiveCPU(stages[out.as_tensor_ref()], output_shapes[0], target);
     }
     *ret = arg_pack;
@@ -447,7 +513,7 @@ std::shared_ptr<OpStrategy> StrategyForConcat(const framework::NodeAttr &attrs,
     CHECK(out.as_tensor());
     if (target.arch == Target::Arch::NVGPU) {
       pe::CudaScheduleInjective(stages[out.as_tensor_ref()], output_shapes.back(), target);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       pe::ScheduleInjectiveCPU(stages[out.as_tensor_ref()], output_shapes.back(), target, false);
     }
     *ret = arg_pack;
@@ -503,6 +569,7 @@ std::shared_ptr<OpStrategy> StrategyForMul(const framework::NodeAttr &attrs,
                                            const std::vector<Type> &out_type,
                                            const std::vector<std::vector<int>> &output_shapes,
                                            const Target &target) {
+  bool use_small = IsSmallMul(attrs, inputs);
   framework::CINNCompute mul_compute([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input arguments of Mul compute is empty! Please check.\n";
     CINNValuePack a = args[0];
@@ -562,11 +629,15 @@ std::shared_ptr<OpStrategy> StrategyForMul(const framework::NodeAttr &attrs,
     auto new_A = A_tensor->Reshape(new_shape_A, stages);
     auto new_B = B_tensor->Reshape(new_shape_B, stages);
     std::vector<ir::Tensor> out;
-    if (target.arch == Target::Arch::X86) {
+    if (use_small) {
+      // [M, K] * [N, K] is the GEMM of the transposed B
+      out = pe::MatmulSmall(new_A, new_B, false, true, 1.f, UniqName("Mul_small_output"));
+    } else if (target.is_cpu()) {
 #ifdef CINN_WITH_MKL_CBLAS
       out = pe::MulMKL(new_A, new_B, UniqName("Mul_mkl_output"), target);
 #else
-      out = pe::MulBase(new_A, new_B, UniqName("Mul_output"), target);
+      // [M, K] * [N, K] is the GEMM of the transposed B
+      out = pe::MatmulPacked(new_A, new_B, false, true, 1.f, UniqName("Mul_output"), target);
 #endif
     } else {
       out = pe::MulBase(new_A, new_B, UniqName("Mul_output"), target);
@@ -585,18 +656,26 @@ std::shared_ptr<OpStrategy> StrategyForMul(const framework::NodeAttr &attrs,
   framework::CINNSchedule mul_schedule([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input argument of mul schedule is empty! Please check.\n";
     CINNValuePack arg_pack = args[0];
-    CHECK(arg_pack.size() == 2UL || arg_pack.size() == 3UL);
+    CHECK(arg_pack.size() >= 2UL && arg_pack.size() <= 4UL);
     Expr out              = arg_pack[0];
     poly::StageMap stages = arg_pack.back();
     CHECK(out.as_tensor());
-    if (target.arch == Target::Arch::NVGPU) {
+    if (use_small) {
+      ScheduleSmallMatmul(arg_pack, target);
+    } else if (target.arch == Target::Arch::NVGPU) {
       pe::CudaScheduleMul(stages, out.as_tensor_ref(), output_shapes.back(), target);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
+#ifdef CINN_WITH_MKL_CBLAS
       CHECK_EQ(arg_pack.size(), 3UL);
-#ifndef CINN_WITH_MKL_CBLAS
-      Expr reduce_first = arg_pack[1];
-      CHECK(reduce_first.as_tensor());
-      pe::MulScheduleCPU(stages, out.as_tensor_ref(), reduce_first.as_tensor_ref(), target);
+#else
+      CHECK_EQ(arg_pack.size(), 4UL);
+      Expr packedB = arg_pack[1];
+      Expr packedA = arg_pack[2];
+      CHECK(packedB.as_tensor());
+      CHECK(packedA.as_tensor());
+      pe::MatmulScheduleCPU(stages, out.as_tensor_ref(), packedB.as_tensor_ref(), packedA.as_tensor_ref(), target);
+      // the packed A is a temporary tensor rather than an output
+      arg_pack = CINNValuePack{{arg_pack[0], arg_pack[1], CINNValue(stages)}};
 #endif
     }
     *ret = arg_pack;
@@ -608,6 +687,185 @@ std::shared_ptr<OpStrategy> StrategyForMul(const framework::NodeAttr &attrs,
   return strategy;
 }
 
+std::shared_ptr<OpStrategy> StrategyForQuantizedMul(const framework::NodeAttr &attrs,
+                                                    const std::vector<ir::Tensor> &inputs,
+                                                    const std::vector<Type> &out_type,
+                                                    const std::vector<std::vector<int>> &output_shapes,
+                                                    const Target &target) {
+  CHECK(target.arch == Target::Arch::X86) << "quantized_mul is only implemented on X86 now";
+  int x_num_col_dims = 1;
+  int y_num_col_dims = 1;
+  float scale        = 1.f;
+  for (auto &iter : attrs.attr_store) {
+    if (iter.first == "x_num_col_dims") {
+      x_num_col_dims = absl::get<int>(iter.second);
+    } else if (iter.first == "y_num_col_dims") {
+      y_num_col_dims = absl::get<int>(iter.second);
+    } else if (iter.first == "scale") {
+      scale = absl::get<float>(iter.second);
+    }
+  }
+  framework::CINNCompute quantized_mul_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of quantized_mul compute is empty! Please check.\n";
+    CINNValuePack a = args[0];
+    CHECK_GE(a.size(), 2U) << "at least 2 input tensors for quantized_mul compute\n";
+    Expr A = a[0];
+    Expr B = a[1];
+    CHECK(A.as_tensor());
+    CHECK(B.as_tensor());
+    auto A_tensor = A.as_tensor_ref();
+    auto B_tensor = B.as_tensor_ref();
+    auto stages   = CreateStages({A_tensor, B_tensor});
+    // flatten to 2 dims, [M, K] and [N, K]
+    auto flatten = [&](const ir::Tensor &tensor, int num_col_dims) {
+      Expr rows(1), cols(1);
+      for (int i = 0; i < tensor->shape.size(); i++) {
+        if (i < num_col_dims) {
+          rows = rows * tensor->shape[i];
+        } else {
+          cols = cols * tensor->shape[i];
+        }
+      }
+      return tensor->Reshape({common::AutoSimplify(rows), common::AutoSimplify(cols)}, stages);
+    };
+    auto out = pe::QuantizedMul(
+        flatten(A_tensor, x_num_col_dims), flatten(B_tensor, y_num_col_dims), scale, UniqName("QuantizedMul_out"));
+    std::vector<CINNValue> res;
+    for (auto &t : out) {
+      stages->InsertLazily(t);
+      res.push_back(CINNValue(t));
+    }
+    res.push_back(CINNValue(stages));
+    *ret = CINNValuePack{res};
+  });
+
+  framework::CINNSchedule quantized_mul_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of quantized_mul schedule is empty! Please check.\n";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 3UL);
+    Expr out              = arg_pack[0];
+    poly::StageMap stages = arg_pack.back();
+    CHECK(out.as_tensor());
+    pe::ScheduleInjectiveCPU(stages[out.as_tensor_ref()], output_shapes.front(), target);
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(quantized_mul_compute, quantized_mul_schedule, "strategy.quantized_mul.x86", 1);
+
+  return strategy;
+}
+
+int GetWeightOnlyBits(const framework::AttrMapType &attrs) {
+  int bits = attrs.count("bits") ? absl::get<int>(attrs.at("bits")) : 8;
+  CHECK(bits == 8 || bits == 4) << "The weight can only be quantized to 8 or 4 bits, but got " << bits;
+  return bits;
+}
+
+std::shared_ptr<OpStrategy> StrategyForQuantizePerChannel(const framework::NodeAttr &attrs,
+                                                          const std::vector<ir::Tensor> &inputs,
+                                                          const std::vector<Type> &out_type,
+                                                          const std::vector<std::vector<int>> &output_shapes,
+                                                          const Target &target) {
+  int bits   = GetWeightOnlyBits(attrs.attr_store);
+  bool trans = attrs.attr_store.count("trans") && absl::get<bool>(attrs.attr_store.at("trans"));
+  framework::CINNCompute quantize_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of quantize_per_channel compute is empty! Please check.\n";
+    CINNValuePack a = args[0];
+    CHECK(!a.empty()) << "The input tensors of quantize_per_channel compute is empty! Please check.\n";
+    Expr W = a[0];
+    CHECK(W.as_tensor());
+    auto out    = pe::QuantizePerChannel(W.as_tensor_ref(), bits, trans, UniqName("QuantizePerChannel_out"));
+    auto stages = CreateStages({W.as_tensor_ref()});
+    std::vector<CINNValue> res;
+    for (auto &t : out) {
+      stages->InsertLazily(t);
+      res.push_back(CINNValue(t));
+    }
+    res.push_back(CINNValue(stages));
+    *ret = CINNValuePack{res};
+  });
+
+  framework::CINNSchedule quantize_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of quantize_per_channel schedule is empty! Please check.\n";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 3UL);
+    poly::StageMap stages = arg_pack.back();
+    // it runs once in the prepack stage, so the quantized values and the scales are only spread over the threads
+    for (int i = 0; i < 2; i++) {
+      Expr out = arg_pack[i];
+      CHECK(out.as_tensor());
+      if (target.arch == Target::Arch::NVGPU) {
+        pe::CudaScheduleInjective(stages[out.as_tensor_ref()], output_shapes[i], target);
+      } else if (target.arch == Target::Arch::X86 && i == 0) {
+        pe::ScheduleInjectiveCPU(stages[out.as_tensor_ref()], output_shapes[i], target);
+      }
+    }
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(quantize_compute, quantize_schedule, "strategy.quantize_per_channel.x86", 1);
+
+  return strategy;
+}
+
+std::shared_ptr<OpStrategy> StrategyForWeightOnlyMul(const framework::NodeAttr &attrs,
+                                                     const std::vector<ir::Tensor> &inputs,
+                                                     const std::vector<Type> &out_type,
+                                                     const std::vector<std::vector<int>> &output_shapes,
+                                                     const Target &target) {
+  int bits           = GetWeightOnlyBits(attrs.attr_store);
+  int x_num_col_dims = attrs.attr_store.count("x_num_col_dims") ? absl::get<int>(attrs.attr_store.at("x_num_col_dims"))
+                                                                : 1;
+  framework::CINNCompute weight_only_mul_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input arguments of weight_only_mul compute is empty! Please check.\n";
+    CINNValuePack a = args[0];
+    CHECK_GE(a.size(), 3U) << "at least 3 input tensors for weight_only_mul compute\n";
+    Expr A      = a[0];
+    Expr Q      = a[1];
+    Expr scales = a[2];
+    CHECK(A.as_tensor());
+    CHECK(Q.as_tensor());
+    CHECK(scales.as_tensor());
+    auto A_tensor = A.as_tensor_ref();
+    auto stages   = CreateStages({A_tensor, Q.as_tensor_ref(), scales.as_tensor_ref()});
+    // flatten to 2 dims, [M, K]
+    Expr rows(1), cols(1);
+    for (int i = 0; i < A_tensor->shape.size(); i++) {
+      if (i < x_num_col_dims) {
+        rows = rows * A_tensor->shape[i];
+      } else {
+        cols = cols * A_tensor->shape[i];
+      }
+    }
+    auto new_A = A_tensor->Reshape({common::AutoSimplify(rows), common::AutoSimplify(cols)}, stages);
+    auto out =
+        pe::WeightOnlyMul(new_A, Q.as_tensor_ref(), scales.as_tensor_ref(), bits, UniqName("WeightOnlyMul_out"));
+    stages->InsertLazily(out);
+    *ret = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule weight_only_mul_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of weight_only_mul schedule is empty! Please check.\n";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 2UL);
+    Expr out              = arg_pack[0];
+    poly::StageMap stages = arg_pack.back();
+    CHECK(out.as_tensor());
+    // the tiles of the int8 weight are staged in the shared memory, and dequantized as they are read into registers
+    if (target.arch == Target::Arch::NVGPU) {
+      pe::CudaScheduleMatmul(stages, out.as_tensor_ref(), target);
+    }
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(weight_only_mul_compute, weight_only_mul_schedule, "strategy.weight_only_mul.x86", 1);
+
+  return strategy;
+}
+
 std::shared_ptr<OpStrategy> StrategyForMulBias(const framework::NodeAttr &attrs,
                                                const std::vector<ir::Tensor> &inputs,
                                                const std::vector<Type> &out_type,
@@ -744,8 +1002,10 @@ std::vector<std::vector<int>> InferShapeForMul(const std::vector<std::vector<int
                                      << "]! Please Check!";
   output_shape = {flatten_shape_A, flatten_shape_B};
 
-  int reduce_factor           = pe::GetMulFactor(check_dim_x, Float(32), common::DefaultHostTarget());
-  std::vector<int> temp_shape = {flatten_shape_A, flatten_shape_B, reduce_factor};
+  // the panels of the packed Y, see pe::MatmulPacked
+  auto blocking = pe::GetX86GemmBlocking(
+      flatten_shape_A, flatten_shape_B, check_dim_x, Float(32), common::DefaultHostTarget());
+  std::vector<int> temp_shape = {flatten_shape_B / blocking.nr, check_dim_x, blocking.nr};
 
   std::vector<std::vector<int>> res{output_shape, temp_shape};
   return res;
@@ -757,6 +1017,86 @@ std::vector<Type> InferDtypeForMul(const std::vector<Type> &inputs_type, const f
   return res;
 }
 
+std::vector<std::vector<int>> InferShapeForQuantizedMul(const std::vector<std::vector<int>> &inputs_shape,
+                                                        const framework::AttrMapType &attrs) {
+  framework::AttrMapType mul_attrs = attrs;
+  mul_attrs.erase("scale");
+  auto output_shape = InferShapeForMul(inputs_shape, mul_attrs)[0];
+  // the output and the int32 accumulation
+  return {output_shape, output_shape};
+}
+
+// The dense mul the block-sparse one runs if its weight is not sparse enough, see runtime::BlockSparseMatmul.
+std::vector<std::vector<int>> InferShapeForBlockSparseMul(const std::vector<std::vector<int>> &inputs_shape,
+                                                          const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape[1].size(), 2U) << "The weight of block_sparse_mul should be [N, K]";
+  framework::AttrMapType mul_attrs = attrs;
+  for (auto &name : {"block_n", "block_k", "density_threshold"}) mul_attrs.erase(name);
+  return InferShapeForMul(inputs_shape, mul_attrs);
+}
+
+std::vector<Type> InferDtypeForQuantizedMul(const std::vector<Type> &inputs_type, const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_type.size(), 2U) << "The input's type size is not 2! Please check again.";
+  CHECK(inputs_type[0].is_int(8) && inputs_type[1].is_int(8)) << "The inputs of quantized_mul should be int8";
+  return {Float(32), Int(32)};
+}
+
+std::vector<std::vector<int>> InferShapeForQuantizePerChannel(const std::vector<std::vector<int>> &inputs_shape,
+                                                              const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 1U) << "The input's shape size is not 1! Please check again.";
+  CHECK_EQ(inputs_shape[0].size(), 2U) << "The weight to quantize should be 2-D! Please check.";
+  bool trans = attrs.count("trans") && absl::get<bool>(attrs.at("trans"));
+  int N      = trans ? inputs_shape[0][1] : inputs_shape[0][0];
+  int K      = trans ? inputs_shape[0][0] : inputs_shape[0][1];
+  if (GetWeightOnlyBits(attrs) == 4) {
+    CHECK_EQ(K % 2, 0) << "The weight quantized to 4 bits should have an even number of inputs";
+    K /= 2;
+  }
+  // the quantized weight and the scales
+  return {{N, K}, {N}};
+}
+
+std::vector<Type> InferDtypeForQuantizePerChannel(const std::vector<Type> &inputs_type,
+                                                  const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_type.size(), 1U) << "The input's type size is not 1! Please check again.";
+  CHECK(inputs_type[0].is_float(32)) << "The weight of quantize_per_channel should be float32! Please check.";
+  return {Int(8), Float(32)};
+}
+
+std::vector<std::vector<int>> InferShapeForWeightOnlyMul(const std::vector<std::vector<int>> &inputs_shape,
+                                                         const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 3U) << "The input's shape size is not 3! Please check again.";
+  int x_num_col_dims = attrs.count("x_num_col_dims") ? absl::get<int>(attrs.at("x_num_col_dims")) : 1;
+  int M = 1, K = 1;
+  for (int i = 0; i < inputs_shape[0].size(); i++) {
+    (i < x_num_col_dims ? M : K) *= inputs_shape[0][i];
+  }
+  int N        = inputs_shape[1][0];
+  int packed_k = GetWeightOnlyBits(attrs) == 4 ? K / 2 : K;
+  CHECK(inputs_shape[1] == (std::vector<int>{N, packed_k})) << "The quantized weight doesn't match the input X";
+  CHECK(inputs_shape[2] == std::vector<int>{N}) << "The scales should be one per channel of the weight";
+  return {{M, N}};
+}
+
+std::vector<Type> InferDtypeForWeightOnlyMul(const std::vector<Type> &inputs_type,
+                                             const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_type.size(), 3U) << "The input's type size is not 3! Please check again.";
+  CHECK(inputs_type[0].is_float(16) || inputs_type[0].is_float(32))
+      << "The input X of weight_only_mul should be float16 or float32";
+  CHECK(inputs_type[1].is_int(8)) << "The quantized weight of weight_only_mul should be int8";
+  CHECK(inputs_type[2].is_float(32)) << "The scales of weight_only_mul should be float32";
+  return {inputs_type[0]};
+}
+
+std::vector<std::vector<std::string>> InferLayoutForWeightOnly(const std::vector<framework::shape_t> &input_shapes,
+                                                               const std::vector<std::string> &input_layouts,
+                                                               const framework::NodeAttr &attrs,
+                                                               const Target &target) {
+  // quantize_per_channel has the weight and the scales as the outputs, weight_only_mul has one
+  std::vector<std::string> out_layouts(input_shapes.size() == 1U ? 2 : 1, "");
+  return {out_layouts, input_layouts};
+}
+
 std::vector<std::vector<std::string>> InferLayoutForMul(const std::vector<framework::shape_t> &input_shapes,
                                                         const std::vector<std::string> &input_layouts,
                                                         const framework::NodeAttr &attrs,
@@ -828,20 +1168,45 @@ std::shared_ptr<OpStrategy> StrategyForLayoutTransform(const framework::NodeAttr
                                                        const std::vector<Type> &out_type,
                                                        const std::vector<std::vector<int>> &output_shapes,
                                                        const Target &target) {
+  std::string src_layout;
+  std::string dst_layout;
+  if (attrs.attr_store.find("src_layout") != attrs.attr_store.end()) {
+    src_layout = absl::get<std::string>(attrs.attr_store.at("src_layout"));
+  }
+  if (attrs.attr_store.find("dst_layout") != attrs.attr_store.end()) {
+    dst_layout = absl::get<std::string>(attrs.attr_store.at("dst_layout"));
+  }
+  // the layout transforms moving the innermost axis are tiled transposes of the input split on NVGPU
+  std::vector<int> tile_shape;
+  std::vector<int> tile_axis;
+  bool tiled = false;
+  if (target.arch == Target::Arch::NVGPU && !inputs.empty() && inputs[0]->type().is_float(32)) {
+    std::vector<int> input_shape;
+    for (auto &dim : inputs[0]->shape) input_shape.push_back(dim.as_int32());
+    std::vector<int> view_shape;
+    std::vector<int> view_axis;
+    tiled = pe::GetLayoutTransformAxis(input_shape, src_layout, dst_layout, &view_shape, &view_axis) &&
+            pe::NormalizeTranspose(view_shape, view_axis, &tile_shape, &tile_axis);
+  }
+
   framework::CINNCompute layout_transform_compute([=](lang::Args args, lang::RetValue *ret) {
-    std::string src_layout;
-    std::string dst_layout;
-    if (attrs.attr_store.find("src_layout") != attrs.attr_store.end()) {
-      src_layout = absl::get<std::string>(attrs.attr_store.at("src_layout"));
-    }
-    if (attrs.attr_store.find("dst_layout") != attrs.attr_store.end()) {
-      dst_layout = absl::get<std::string>(attrs.attr_store.at("dst_layout"));
-    }
     CHECK(!args.empty()) << "The input argument of layout_transform compute is empty! Please check.\n";
     CINNValuePack a = args[0];
     CHECK(!a.empty()) << "at least one input tensor for layout_transform compute\n";
     Expr A = a[0];
     CHECK(A.as_tensor());
+    if (tiled) {
+      auto outs   = pe::TiledTranspose(A.as_tensor_ref(), tile_shape, tile_axis, UniqName("layout_transform_output"));
+      auto stages = CreateStages({A.as_tensor_ref()});
+      std::vector<CINNValue> res;
+      for (auto &t : outs) {
+        stages->InsertLazily(t);
+        res.push_back(CINNValue(t));
+      }
+      res.push_back(CINNValue(stages));
+      *ret = CINNValuePack{res};
+      return;
+    }
 
     auto out    = pe::LayoutTransform(A.as_tensor_ref(), src_layout, dst_layout, UniqName("layout_transform_output"));
     auto stages = CreateStages({A.as_tensor_ref()});
@@ -854,6 +1219,16 @@ std::shared_ptr<OpStrategy> StrategyForLayoutTransform(const framework::NodeAttr
   framework::CINNSchedule layout_transform_schedule([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input argument of layout_transform schedule is empty! Please check.\n";
     CINNValuePack arg_pack = args[0];
+    if (tiled) {
+      CHECK_EQ(arg_pack.size(), 3UL);
+      Expr out              = arg_pack[0];
+      Expr call             = arg_pack[1];
+      poly::StageMap stages = arg_pack.back();
+      CHECK(call.as_tensor());
+      pe::CudaScheduleTiledTranspose(stages[call.as_tensor_ref()]);
+      *ret = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+      return;
+    }
     CHECK_EQ(arg_pack.size(), 2UL);
     Expr out              = arg_pack[0];
     poly::StageMap stages = arg_pack[1];
@@ -863,7 +1238,9 @@ std::shared_ptr<OpStrategy> StrategyForLayoutTransform(const framework::NodeAttr
     for (auto shape : tensor_out->shape) {
       out_shape.push_back(shape.as_int32());
     }
-    if (target.arch == Target::Arch::X86) {
+    if (target.arch == Target::Arch::NVGPU) {
+      pe::CudaScheduleInjective(stages[tensor_out], out_shape, target);
+    } else if (target.is_cpu()) {
       pe::ScheduleInjectiveCPU(stages[tensor_out], out_shape, target);
     }
     *ret = arg_pack;
@@ -957,7 +1334,7 @@ std::shared_ptr<OpStrategy> StrategyForReverse(const framework::NodeAttr &attrs,
     CHECK(out.as_tensor());
     if (target.arch == Target::Arch::NVGPU) {
       pe::CudaScheduleInjective(stages[out.as_tensor_ref()], output_shapes[0], target);
-    } else if (target.arch == Target::Arch::X86) {
+    } else if (target.is_cpu()) {
       pe::ScheduleInjectiveCPU(stages[out.as_tensor_ref()], output_shapes[0], target);
     }
     *ret = arg_pack;
@@ -1056,12 +1433,34 @@ std::shared_ptr<OpStrategy> StrategyForTranspose(const framework::NodeAttr &attr
     LOG(FATAL) << "axis is not be set! Please check.";
   }
 
+  // the transposes moving the innermost axis are tiled on NVGPU, to coalesce both their reads and writes
+  std::vector<int> tile_shape;
+  std::vector<int> tile_axis;
+  bool tiled = false;
+  if (target.arch == Target::Arch::NVGPU && out_type[0] == Float(32)) {
+    std::vector<int> shape;
+    for (auto &dim : input_shape) shape.push_back(dim.as_int32());
+    tiled = pe::NormalizeTranspose(shape, axis, &tile_shape, &tile_axis);
+  }
+
   framework::CINNCompute transpose_compute([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input argument of transpose compute is empty! Please check.\n";
     CINNValuePack a = args[0];
     CHECK(!a.empty()) << "at least one input tensor for transpose compute\n";
     Expr A = a[0];
     CHECK(A.as_tensor());
+    if (tiled) {
+      auto outs   = pe::TiledTranspose(A.as_tensor_ref(), tile_shape, tile_axis, UniqName("Transpose_output"));
+      auto stages = CreateStages({A.as_tensor_ref()});
+      std::vector<CINNValue> res;
+      for (auto &t : outs) {
+        stages->InsertLazily(t);
+        res.push_back(CINNValue(t));
+      }
+      res.push_back(CINNValue(stages));
+      *ret = CINNValuePack{res};
+      return;
+    }
     auto out    = pe::Transpose(A.as_tensor_ref(), axis, UniqName("Transpose_output"));
     auto stages = CreateStages({out});
     *ret        = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
@@ -1070,6 +1469,16 @@ std::shared_ptr<OpStrategy> StrategyForTranspose(const framework::NodeAttr &attr
   framework::CINNSchedule transpose_schedule([=](lang::Args args, lang::RetValue *ret) {
     CHECK(!args.empty()) << "The input argument of transpose schedule is empty! Please check.\n";
     CINNValuePack arg_pack = args[0];
+    if (tiled) {
+      CHECK_EQ(arg_pack.size(), 3UL);
+      Expr out              = arg_pack[0];
+      Expr call             = arg_pack[1];
+      poly::StageMap stages = arg_pack.back();
+      CHECK(call.as_tensor());
+      pe::CudaScheduleTiledTranspose(stages[call.as_tensor_ref()]);
+      *ret = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+      return;
+    }
     CHECK_EQ(arg_pack.size(), 2UL);
     Expr out              = arg_pack[0];
     poly::StageMap stages = arg_pack[1];
@@ -1148,6 +1557,246 @@ std::vector<std::vector<std::string>> InferLayoutForTranspose(const std::vector<
   return {{output_layout}, new_input_layouts};
 }
 
+namespace {
+//! Schedule the gathered \p out of \p output_shape by the rows.
+void ScheduleGather(poly::StageMap stages,
+                    const ir::Tensor &out,
+                    const std::vector<int> &output_shape,
+                    const Target &target) {
+  if (target.arch == Target::Arch::NVGPU) {
+    pe::CudaScheduleGather(stages[out], output_shape, target);
+  } else if (target.is_cpu()) {
+    pe::ScheduleGatherCPU(stages[out], output_shape, target);
+  }
+}
+
+int GetAxisAttr(const framework::AttrMapType &attrs, int rank) {
+  int axis = attrs.count("axis") ? absl::get<int>(attrs.at("axis")) : 0;
+  CHECK(axis >= -rank && axis < rank) << "axis is not in [-n_dim, n_dim), Please check.";
+  return axis < 0 ? axis + rank : axis;
+}
+}  // namespace
+
+std::shared_ptr<OpStrategy> StrategyForGather(const framework::NodeAttr &attrs,
+                                              const std::vector<ir::Tensor> &inputs,
+                                              const std::vector<Type> &out_type,
+                                              const std::vector<std::vector<int>> &output_shapes,
+                                              const Target &target) {
+  CHECK(!output_shapes.empty() && !output_shapes[0].empty()) << "Output shape is empty! Please check.\n";
+  CHECK_EQ(inputs.size(), 2U) << "The input tensors of gather should be the input and the index";
+  int axis = GetAxisAttr(attrs.attr_store, inputs[0]->shape.size());
+
+  framework::CINNCompute gather_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of gather compute is empty! Please check.\n";
+    CINNValuePack a = args[0];
+    CHECK_EQ(a.size(), 2U) << "2 input tensors for gather compute\n";
+    Expr A = a[0];
+    Expr B = a[1];
+    CHECK(A.as_tensor() && B.as_tensor());
+    auto out    = pe::Gather(A.as_tensor_ref(), B.as_tensor_ref(), axis, UniqName("Gather_output"));
+    auto stages = CreateStages({A.as_tensor_ref(), B.as_tensor_ref(), out});
+    *ret        = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule gather_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of gather schedule is empty! Please check.\n";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 2UL);
+    Expr out              = arg_pack[0];
+    poly::StageMap stages = arg_pack[1];
+    CHECK(out.as_tensor());
+    ScheduleGather(stages, out.as_tensor_ref(), output_shapes[0], target);
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(gather_compute, gather_schedule, "strategy.gather.x86", 1);
+  return strategy;
+}
+
+std::vector<framework::shape_t> InferShapeForGather(const std::vector<framework::shape_t> &inputs_shape,
+                                                    const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 2U) << "The input's shape size is not 2! Please check again.";
+  auto &input = inputs_shape[0];
+  int axis    = GetAxisAttr(attrs, input.size());
+  framework::shape_t res(input.begin(), input.begin() + axis);
+  res.insert(res.end(), inputs_shape[1].begin(), inputs_shape[1].end());
+  res.insert(res.end(), input.begin() + axis + 1, input.end());
+  return {res};
+}
+
+std::shared_ptr<OpStrategy> StrategyForGatherNd(const framework::NodeAttr &attrs,
+                                                const std::vector<ir::Tensor> &inputs,
+                                                const std::vector<Type> &out_type,
+                                                const std::vector<std::vector<int>> &output_shapes,
+                                                const Target &target) {
+  CHECK(!output_shapes.empty() && !output_shapes[0].empty()) << "Output shape is empty! Please check.\n";
+
+  framework::CINNCompute gather_nd_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of gather_nd compute is empty! Please check.\n";
+    CINNValuePack a = args[0];
+    CHECK_EQ(a.size(), 2U) << "2 input tensors for gather_nd compute\n";
+    Expr A = a[0];
+    Expr B = a[1];
+    CHECK(A.as_tensor() && B.as_tensor());
+    auto out    = pe::GatherNd(A.as_tensor_ref(), B.as_tensor_ref(), UniqName("GatherNd_output"));
+    auto stages = CreateStages({A.as_tensor_ref(), B.as_tensor_ref(), out});
+    *ret        = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule gather_nd_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of gather_nd schedule is empty! Please check.\n";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 2UL);
+    Expr out              = arg_pack[0];
+    poly::StageMap stages = arg_pack[1];
+    CHECK(out.as_tensor());
+    ScheduleGather(stages, out.as_tensor_ref(), output_shapes[0], target);
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(gather_nd_compute, gather_nd_schedule, "strategy.gather_nd.x86", 1);
+  return strategy;
+}
+
+std::vector<framework::shape_t> InferShapeForGatherNd(const std::vector<framework::shape_t> &inputs_shape,
+                                                      const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 2U) << "The input's shape size is not 2! Please check again.";
+  auto &input = inputs_shape[0];
+  auto &index = inputs_shape[1];
+  CHECK(!index.empty() && index.back() <= input.size()) << "The index of gather_nd is deeper than the input";
+  framework::shape_t res(index.begin(), index.end() - 1);
+  res.insert(res.end(), input.begin() + index.back(), input.end());
+  return {res};
+}
+
+std::shared_ptr<OpStrategy> StrategyForScatterAdd(const framework::NodeAttr &attrs,
+                                                  const std::vector<ir::Tensor> &inputs,
+                                                  const std::vector<Type> &out_type,
+                                                  const std::vector<std::vector<int>> &output_shapes,
+                                                  const Target &target) {
+  CHECK(!output_shapes.empty() && !output_shapes[0].empty()) << "Output shape is empty! Please check.\n";
+  CHECK_EQ(inputs.size(), 3U) << "The input tensors of scatter_add should be the input, the index and the updates";
+  int axis = GetAxisAttr(attrs.attr_store, inputs[0]->shape.size());
+
+  framework::CINNCompute scatter_add_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of scatter_add compute is empty! Please check.\n";
+    CINNValuePack a = args[0];
+    CHECK_EQ(a.size(), 3U) << "3 input tensors for scatter_add compute\n";
+    Expr A = a[0];
+    Expr B = a[1];
+    Expr C = a[2];
+    CHECK(A.as_tensor() && B.as_tensor() && C.as_tensor());
+    auto out =
+        pe::ScatterAdd(A.as_tensor_ref(), B.as_tensor_ref(), C.as_tensor_ref(), axis, UniqName("ScatterAdd_output"));
+    auto stages = CreateStages({A.as_tensor_ref(), B.as_tensor_ref(), C.as_tensor_ref(), out[0], out[1]});
+    *ret        = CINNValuePack{{CINNValue(out[0]), CINNValue(out[1]), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule scatter_add_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of scatter_add schedule is empty! Please check.\n";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 3UL);
+    Expr out              = arg_pack[0];
+    Expr updated          = arg_pack[1];
+    poly::StageMap stages = arg_pack[2];
+    CHECK(out.as_tensor() && updated.as_tensor());
+    if (target.arch == Target::Arch::NVGPU) {
+      pe::CudaScheduleReduce(stages, updated.as_tensor_ref(), target);
+      pe::CudaScheduleInjective(stages[out.as_tensor_ref()], output_shapes[0], target);
+    } else if (target.is_cpu()) {
+      stages[updated.as_tensor_ref()]->Parallel(0);
+      pe::ScheduleInjectiveCPU(stages[out.as_tensor_ref()], output_shapes[0], target);
+    }
+    *ret = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(scatter_add_compute, scatter_add_schedule, "strategy.scatter_add.x86", 1);
+  return strategy;
+}
+
+std::vector<framework::shape_t> InferShapeForScatterAdd(const std::vector<framework::shape_t> &inputs_shape,
+                                                        const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 3U) << "The input's shape size is not 3! Please check again.";
+  int axis = GetAxisAttr(attrs, inputs_shape[0].size());
+  CHECK_EQ(inputs_shape[1].size(), 1U) << "The index of scatter_add should be 1-D";
+  auto expected  = inputs_shape[0];
+  expected[axis] = inputs_shape[1][0];
+  CHECK(inputs_shape[2] == expected) << "The updates of scatter_add should be as shaped as the indexed input";
+  return {inputs_shape[0]};
+}
+
+std::vector<std::vector<std::string>> InferLayoutForScatterAdd(const std::vector<framework::shape_t> &input_shapes,
+                                                               const std::vector<std::string> &input_layouts,
+                                                               const framework::NodeAttr &attrs,
+                                                               const Target &target) {
+  CHECK_EQ(input_layouts.size(), 3U) << "The input's layout size is not 3! Please check again.";
+  return {{input_layouts[0]}, input_layouts};
+}
+
+std::shared_ptr<OpStrategy> StrategyForLookupTable(const framework::NodeAttr &attrs,
+                                                   const std::vector<ir::Tensor> &inputs,
+                                                   const std::vector<Type> &out_type,
+                                                   const std::vector<std::vector<int>> &output_shapes,
+                                                   const Target &target) {
+  CHECK(!output_shapes.empty() && !output_shapes[0].empty()) << "Output shape is empty! Please check.\n";
+  int padding_idx = -1;
+  if (attrs.attr_store.count("padding_idx")) {
+    padding_idx = absl::get<int>(attrs.attr_store.at("padding_idx"));
+  }
+
+  framework::CINNCompute lookup_table_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of lookup_table compute is empty! Please check.\n";
+    CINNValuePack a = args[0];
+    CHECK_EQ(a.size(), 2U) << "2 input tensors for lookup_table compute\n";
+    Expr A = a[0];
+    Expr B = a[1];
+    CHECK(A.as_tensor() && B.as_tensor());
+    auto out    = pe::LookupTable(A.as_tensor_ref(), B.as_tensor_ref(), padding_idx, UniqName("LookupTable_output"));
+    auto stages = CreateStages({A.as_tensor_ref(), B.as_tensor_ref(), out});
+    *ret        = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule lookup_table_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of lookup_table schedule is empty! Please check.\n";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 2UL);
+    Expr out              = arg_pack[0];
+    poly::StageMap stages = arg_pack[1];
+    CHECK(out.as_tensor());
+    ScheduleGather(stages, out.as_tensor_ref(), output_shapes[0], target);
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(lookup_table_compute, lookup_table_schedule, "strategy.lookup_table.x86", 1);
+  return strategy;
+}
+
+std::vector<framework::shape_t> InferShapeForLookupTable(const std::vector<framework::shape_t> &inputs_shape,
+                                                         const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 2U) << "The input's shape size is not 2! Please check again.";
+  CHECK_EQ(inputs_shape[0].size(), 2U) << "The table of lookup_table should be in [vocab, dim]";
+  framework::shape_t res = inputs_shape[1];
+  res.push_back(inputs_shape[0][1]);
+  return {res};
+}
+
+std::vector<std::vector<std::string>> InferLayoutForGather(const std::vector<framework::shape_t> &input_shapes,
+                                                           const std::vector<std::string> &input_layouts,
+                                                           const framework::NodeAttr &attrs,
+                                                           const Target &target) {
+  CHECK_EQ(input_layouts.size(), 2U) << "The input's layout size is not 2! Please check again.";
+  std::vector<std::string> new_input_layouts = input_layouts;
+  if (input_shapes[0].size() > 4) {
+    // alter input layout back
+    new_input_layouts[0] = "NCHW";
+  }
+  return {{""}, new_input_layouts};
+}
+
 }  // namespace op
 }  // namespace hlir
 }  // namespace cinn
@@ -1217,7 +1866,7 @@ CINN_REGISTER_HELPER(transform_ops) {
 #ifndef CINN_WITH_CUDA
       .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForTranspose))
 #endif
-#ifdef CINN_WITH_CUDNN
+#ifdef CINN_WITH_CUDA
       .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
 #else
       .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kInjective)
@@ -1237,6 +1886,65 @@ CINN_REGISTER_HELPER(transform_ops) {
       .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
       .set_support_level(4);
 
+  CINN_REGISTER_OP(block_sparse_mul)
+      .describe("The mul of X and the [N, K] weight of a pruned model, which runs by the block-sparse kernel of the "
+                "nonzero blocks of block_n x block_k if their fraction is at most density_threshold, or as mul.")
+      .set_num_inputs(2)
+      .set_num_outputs(2)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForMul)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForBlockSparseMul))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForMul))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForMul))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(quantized_mul)
+      .describe("The mul of the int8 inputs X and Y accumulated in int32, whose result is dequantized by the attr "
+                "scale to float32.")
+      .set_num_inputs(2)
+      .set_num_outputs(2)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForQuantizedMul)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForQuantizedMul))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForQuantizedMul))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForMul))
+#endif
+      .set_attr<std::vector<cinn::common::Target::Arch>>("CINNSupportedArchs", {cinn::common::Target::Arch::X86})
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(quantize_per_channel)
+      .describe("Quantize the float32 weight to int8 or int4 by the attr bits, with a scale per output channel, which "
+                "is the first dim of the weight or the second one if the attr trans is true. The outputs are the "
+                "quantized weight, two int4 values packed in each int8, and the float32 scales.")
+      .set_num_inputs(1)
+      .set_num_outputs(2)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy",
+                                                         cinn::hlir::op::StrategyForQuantizePerChannel)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForQuantizePerChannel))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForQuantizePerChannel))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForWeightOnly))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(weight_only_mul)
+      .describe("The mul of the float16 or float32 input X and the weight quantized by quantize_per_channel, which is "
+                "dequantized by the scales of its channels as it is read and accumulated in the type of X.")
+      .set_num_inputs(3)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForWeightOnlyMul)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForWeightOnlyMul))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForWeightOnlyMul))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForWeightOnly))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
+      .set_support_level(4);
+
   CINN_REGISTER_OP(mulbias)
       .describe("This operator is used to perform matrix multiplication for input X and Y and add Z.")
       .set_num_inputs(3)
@@ -1257,6 +1965,63 @@ CINN_REGISTER_HELPER(transform_ops) {
       .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForLayoutTransform))
 #ifndef CINN_WITH_CUDA
       .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForLayoutTransform))
+#endif
+#ifdef CINN_WITH_CUDA
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
+#else
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kInjective)
+#endif
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(gather)
+      .describe("This operator gathers the slices of the input along the attr axis by the integer index.")
+      .set_num_inputs(2)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForGather)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForGather))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForReshape))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForGather))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kInjective)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(gather_nd)
+      .describe("This operator gathers the slices of the input by the last axis of the integer index.")
+      .set_num_inputs(2)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForGatherNd)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForGatherNd))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForReshape))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForGather))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kInjective)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(scatter_add)
+      .describe(
+          "This operator adds the slices of the updates along the attr axis to the input indexed by the 1-D index.")
+      .set_num_inputs(3)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForScatterAdd)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForScatterAdd))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForReshape))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForScatterAdd))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kOpaque)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(lookup_table)
+      .describe("This operator looks up the rows of the embedding table by the integer ids.")
+      .set_num_inputs(2)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForLookupTable)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForLookupTable))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForReshape))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForGather))
 #endif
       .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kInjective)
       .set_support_level(4);
@@ -0,0 +1,294 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/pe/vision.h"
+
+#include <functional>
+
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/op_strategy.h"
+#include "cinn/hlir/pe/schedule.h"
+
+namespace cinn {
+namespace hlir {
+namespace op {
+using common::CINNValue;
+using common::CINNValuePack;
+using framework::OpStrategy;
+using framework::shape_t;
+using framework::StrategyFunction;
+
+namespace {
+template <typename T>
+T GetAttr(const framework::AttrMapType &attrs, const std::string &key, const T &default_value) {
+  return attrs.count(key) ? absl::get<T>(attrs.at(key)) : default_value;
+}
+
+std::vector<int> GetSizeAttr(const framework::AttrMapType &attrs, const std::string &key) {
+  CHECK(attrs.count(key)) << "The image op finds no attr " << key;
+  auto size = absl::get<std::vector<int>>(attrs.at(key));
+  CHECK_EQ(size.size(), 2U) << "The attr " << key << " should be {h, w}";
+  return size;
+}
+
+//! The index of the height axis of the 4-D images in \p layout, the width axis follows it.
+int GetHeightAxis(const std::string &layout) {
+  CHECK(layout == "NCHW" || layout == "NHWC") << "The images should be in NCHW or NHWC";
+  return layout == "NCHW" ? 2 : 1;
+}
+
+/**
+ * The strategy of the single input image ops, which are injective and scheduled as such, so that a chain of them is
+ * fused into one kernel.
+ */
+std::shared_ptr<OpStrategy> MakeImageStrategy(const std::string &op_name,
+                                              std::function<ir::Tensor(const ir::Tensor &)> compute,
+                                              const std::vector<std::vector<int>> &output_shapes,
+                                              const Target &target) {
+  CHECK(!output_shapes.empty() && !output_shapes[0].empty()) << "Output shape is empty! Please check.\n";
+  framework::CINNCompute image_compute([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of " << op_name << " compute is empty! Please check.\n";
+    CINNValuePack a = args[0];
+    CHECK(!a.empty()) << "at least one input tensor for " << op_name << " compute\n";
+    Expr A = a[0];
+    CHECK(A.as_tensor());
+    auto out    = compute(A.as_tensor_ref());
+    auto stages = CreateStages({A.as_tensor_ref(), out});
+    *ret        = CINNValuePack{{CINNValue(out), CINNValue(stages)}};
+  });
+
+  framework::CINNSchedule image_schedule([=](lang::Args args, lang::RetValue *ret) {
+    CHECK(!args.empty()) << "The input argument of " << op_name << " schedule is empty! Please check.\n";
+    CINNValuePack arg_pack = args[0];
+    CHECK_EQ(arg_pack.size(), 2UL);
+    Expr out              = arg_pack[0];
+    poly::StageMap stages = arg_pack[1];
+    CHECK(out.as_tensor());
+    if (target.arch == Target::Arch::NVGPU) {
+      pe::CudaScheduleInjective(stages[out.as_tensor_ref()], output_shapes[0], target);
+    } else if (target.is_cpu()) {
+      pe::ScheduleInjectiveCPU(stages[out.as_tensor_ref()], output_shapes[0], target);
+    }
+    *ret = arg_pack;
+  });
+
+  auto strategy = std::make_shared<framework::OpStrategy>();
+  strategy->AddImpl(image_compute, image_schedule, "strategy." + op_name + ".x86", 1);
+  return strategy;
+}
+}  // namespace
+
+std::shared_ptr<OpStrategy> StrategyForResize(const framework::NodeAttr &attrs,
+                                              const std::vector<ir::Tensor> &inputs,
+                                              const std::vector<Type> &out_type,
+                                              const std::vector<std::vector<int>> &output_shapes,
+                                              const Target &target) {
+  auto size   = GetSizeAttr(attrs.attr_store, "out_size");
+  auto method = GetAttr<std::string>(attrs.attr_store, "method", "bilinear");
+  auto layout = GetAttr<std::string>(attrs.attr_store, "data_format", "NCHW");
+  return MakeImageStrategy(
+      "resize",
+      [=](const ir::Tensor &input) {
+        return pe::Resize(input, size[0], size[1], method, layout, UniqName("Resize_output"));
+      },
+      output_shapes,
+      target);
+}
+
+std::vector<shape_t> InferShapeForResize(const std::vector<shape_t> &inputs_shape,
+                                         const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 1U) << "The input's shape size is not 1! Please check again.";
+  CHECK_EQ(inputs_shape[0].size(), 4U) << "The images of resize should be 4-D";
+  auto size       = GetSizeAttr(attrs, "out_size");
+  int h_axis      = GetHeightAxis(GetAttr<std::string>(attrs, "data_format", "NCHW"));
+  shape_t res     = inputs_shape[0];
+  res[h_axis]     = size[0];
+  res[h_axis + 1] = size[1];
+  return {res};
+}
+
+std::vector<Type> InferDtypeForResize(const std::vector<Type> &inputs_type, const framework::AttrMapType &attrs) {
+  CHECK(!inputs_type.empty()) << "The input's type size is 0! Please check again.";
+  // the bilinear interpolation is in float32
+  if (GetAttr<std::string>(attrs, "method", "bilinear") == "nearest") return {inputs_type[0]};
+  return {Float(32)};
+}
+
+std::shared_ptr<OpStrategy> StrategyForCrop(const framework::NodeAttr &attrs,
+                                            const std::vector<ir::Tensor> &inputs,
+                                            const std::vector<Type> &out_type,
+                                            const std::vector<std::vector<int>> &output_shapes,
+                                            const Target &target) {
+  auto offsets = GetSizeAttr(attrs.attr_store, "offsets");
+  auto size    = GetSizeAttr(attrs.attr_store, "crop_size");
+  auto layout  = GetAttr<std::string>(attrs.attr_store, "data_format", "NCHW");
+  return MakeImageStrategy(
+      "crop",
+      [=](const ir::Tensor &input) {
+        return pe::Crop(input, offsets[0], offsets[1], size[0], size[1], layout, UniqName("Crop_output"));
+      },
+      output_shapes,
+      target);
+}
+
+std::vector<shape_t> InferShapeForCrop(const std::vector<shape_t> &inputs_shape, const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 1U) << "The input's shape size is not 1! Please check again.";
+  CHECK_EQ(inputs_shape[0].size(), 4U) << "The images of crop should be 4-D";
+  auto offsets = GetSizeAttr(attrs, "offsets");
+  auto size    = GetSizeAttr(attrs, "crop_size");
+  int h_axis   = GetHeightAxis(GetAttr<std::string>(attrs, "data_format", "NCHW"));
+  for (int i = 0; i < 2; i++) {
+    CHECK_LE(offsets[i] + size[i], inputs_shape[0][h_axis + i]) << "The crop window exceeds the images";
+  }
+  shape_t res     = inputs_shape[0];
+  res[h_axis]     = size[0];
+  res[h_axis + 1] = size[1];
+  return {res};
+}
+
+std::vector<Type> InferDtypeForCrop(const std::vector<Type> &inputs_type, const framework::AttrMapType &attrs) {
+  CHECK(!inputs_type.empty()) << "The input's type size is 0! Please check again.";
+  return {inputs_type[0]};
+}
+
+std::shared_ptr<OpStrategy> StrategyForNormalize(const framework::NodeAttr &attrs,
+                                                 const std::vector<ir::Tensor> &inputs,
+                                                 const std::vector<Type> &out_type,
+                                                 const std::vector<std::vector<int>> &output_shapes,
+                                                 const Target &target) {
+  auto mean   = GetAttr<std::vector<float>>(attrs.attr_store, "mean", {0.f});
+  auto stddev = GetAttr<std::vector<float>>(attrs.attr_store, "std", {1.f});
+  auto layout = GetAttr<std::string>(attrs.attr_store, "data_format", "NCHW");
+  return MakeImageStrategy(
+      "normalize",
+      [=](const ir::Tensor &input) { return pe::Normalize(input, mean, stddev, layout, UniqName("Normalize_output")); },
+      output_shapes,
+      target);
+}
+
+std::vector<shape_t> InferShapeForNormalize(const std::vector<shape_t> &inputs_shape,
+                                            const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 1U) << "The input's shape size is not 1! Please check again.";
+  CHECK_EQ(inputs_shape[0].size(), 4U) << "The images of normalize should be 4-D";
+  return {inputs_shape[0]};
+}
+
+std::shared_ptr<OpStrategy> StrategyForImageToTensor(const framework::NodeAttr &attrs,
+                                                     const std::vector<ir::Tensor> &inputs,
+                                                     const std::vector<Type> &out_type,
+                                                     const std::vector<std::vector<int>> &output_shapes,
+                                                     const Target &target) {
+  float scale           = GetAttr<float>(attrs.attr_store, "scale", 1.f);
+  bool reverse_channels = GetAttr<bool>(attrs.attr_store, "reverse_channels", false);
+  return MakeImageStrategy(
+      "image_to_tensor",
+      [=](const ir::Tensor &input) {
+        return pe::ImageToTensor(input, scale, reverse_channels, UniqName("ImageToTensor_output"));
+      },
+      output_shapes,
+      target);
+}
+
+std::vector<shape_t> InferShapeForImageToTensor(const std::vector<shape_t> &inputs_shape,
+                                                const framework::AttrMapType &attrs) {
+  CHECK_EQ(inputs_shape.size(), 1U) << "The input's shape size is not 1! Please check again.";
+  auto &shape = inputs_shape[0];
+  CHECK_EQ(shape.size(), 4U) << "The images of image_to_tensor should be 4-D NHWC";
+  return {{shape[0], shape[3], shape[1], shape[2]}};
+}
+
+std::vector<Type> InferDtypeForFloatImage(const std::vector<Type> &inputs_type, const framework::AttrMapType &attrs) {
+  CHECK(!inputs_type.empty()) << "The input's type size is 0! Please check again.";
+  return {Float(32)};
+}
+
+std::vector<std::vector<std::string>> InferLayoutForImage(const std::vector<framework::shape_t> &input_shapes,
+                                                          const std::vector<std::string> &input_layouts,
+                                                          const framework::NodeAttr &attrs,
+                                                          const Target &target) {
+  CHECK_EQ(input_layouts.size(), 1U) << "The input's layout size is not 1! Please check again.";
+  // the images are never in the blocked layouts, e.g. NCHW16c, of the convs
+  auto layout = GetAttr<std::string>(attrs.attr_store, "data_format", "NCHW");
+  return {{layout}, {layout}};
+}
+
+std::vector<std::vector<std::string>> InferLayoutForImageToTensor(const std::vector<framework::shape_t> &input_shapes,
+                                                                  const std::vector<std::string> &input_layouts,
+                                                                  const framework::NodeAttr &attrs,
+                                                                  const Target &target) {
+  CHECK_EQ(input_layouts.size(), 1U) << "The input's layout size is not 1! Please check again.";
+  return {{"NCHW"}, {"NHWC"}};
+}
+
+}  // namespace op
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(vision_ops) {
+  CINN_REGISTER_OP(resize)
+      .describe("Resize the 4-D images to the attr out_size {h, w} by the attr method, bilinear or nearest.")
+      .set_num_inputs(1)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForResize)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForResize))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForResize))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForImage))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kInjective)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(crop)
+      .describe("Crop the window of the attr crop_size {h, w} from the attr offsets {h, w} of the 4-D images.")
+      .set_num_inputs(1)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForCrop)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForCrop))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForCrop))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForImage))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kInjective)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(normalize)
+      .describe("Normalize the channels of the 4-D images in float32 by the attrs mean and std of each channel.")
+      .set_num_inputs(1)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForNormalize)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForNormalize))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForFloatImage))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForImage))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kInjective)
+      .set_support_level(4);
+
+  CINN_REGISTER_OP(image_to_tensor)
+      .describe("Convert the NHWC images, e.g. the uint8 frames, to the NCHW float32 tensor scaled by the attr scale, "
+                "with the channels reversed if the attr reverse_channels is true.")
+      .set_num_inputs(1)
+      .set_num_outputs(1)
+      .set_attr<cinn::hlir::framework::StrategyFunction>("CINNStrategy", cinn::hlir::op::StrategyForImageToTensor)
+      .set_attr("infershape", MakeOpFunction(cinn::hlir::op::InferShapeForImageToTensor))
+      .set_attr("inferdtype", MakeOpFunction(cinn::hlir::op::InferDtypeForFloatImage))
+#ifndef CINN_WITH_CUDA
+      .set_attr("inferlayout", MakeOpFunction(cinn::hlir::op::InferLayoutForImageToTensor))
+#endif
+      .set_attr<cinn::hlir::framework::OpPatternKind>("OpPattern", cinn::hlir::framework::OpPatternKind::kInjective)
+      .set_support_level(4);
+
+  return true;
+}
@@ -0,0 +1,165 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gflags/gflags.h>
+
+#include <functional>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+DEFINE_int64(cinn_allreduce_bucket_bytes,
+             32 << 20,
+             "The max bytes of the gradients packed into one NCCL allreduce by the AllReduceFusion pass, the larger "
+             "ones are reduced alone.");
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+using framework::Graph;
+using framework::Node;
+using framework::NodeData;
+
+// The allreduces are only packed with the ones of the same ring, reduction and data type.
+using BucketKey = std::tuple<int, int, std::string, std::string>;
+
+template <typename T>
+T GetAttr(const Node* node, const std::string& name, const T& default_value) {
+  auto& attr_store = node->attrs.attr_store;
+  return attr_store.count(name) ? absl::get<T>(attr_store.at(name)) : default_value;
+}
+
+/**
+ * Pack the allreduces of the small gradients into buckets, each of which runs as one NCCL call over a contiguous
+ * workspace, to save the latency of the many small collectives in the backward computation. A bucket takes the place
+ * of its last member, when the gradients of all its members are ready, so it is closed before any group reading the
+ * output of its members.
+ */
+void AllReduceFusionPass(Graph* graph) {
+  bool with_nccl = false;
+#ifdef CINN_WITH_NCCL
+  with_nccl = graph->target_.arch == common::Target::Arch::NVGPU;
+#endif
+  // Without NCCL the allreduces are the kernels of a single rank, which are not worth packing.
+  if (!with_nccl) return;
+
+  auto& groups = graph->groups;
+  if (groups.empty()) {
+    for (auto& node : std::get<0>(graph->topological_order())) {
+      auto* op_node = node->safe_as<Node>();
+      if (op_node) groups.push_back({op_node});
+    }
+  }
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, framework::shape_t>>("infershape");
+  auto& dtype_dict = graph->GetAttrs<absl::flat_hash_map<std::string, common::Type>>("inferdtype");
+
+  absl::flat_hash_map<const Node*, int> group_of;
+  for (int i = 0; i < groups.size(); i++) {
+    for (auto* node : groups[i]) group_of[node] = i;
+  }
+
+  // The members of each bucket, the last one is where the bucket is placed.
+  std::vector<std::vector<int>> buckets;
+  std::vector<int64_t> bucket_bytes;
+  std::vector<int> bucket_of(groups.size(), -1);
+  // The bucket still accepting allreduces for each key.
+  std::map<BucketKey, int> open_buckets;
+  auto close = [&](int bucket) {
+    for (auto it = open_buckets.begin(); it != open_buckets.end(); ++it) {
+      if (it->second == bucket) {
+        open_buckets.erase(it);
+        return;
+      }
+    }
+  };
+  for (int i = 0; i < groups.size(); i++) {
+    // The members of the open buckets must not move after the groups reading their outputs.
+    for (auto* node : groups[i]) {
+      for (auto& in_link : node->inlinks()) {
+        for (auto& producer_link : in_link->source()->inlinks()) {
+          auto* producer = producer_link->source()->safe_as<Node>();
+          if (!producer || !group_of.count(producer) || bucket_of[group_of.at(producer)] < 0) continue;
+          close(bucket_of[group_of.at(producer)]);
+        }
+      }
+    }
+
+    if (groups[i].size() != 1 || groups[i][0]->op()->name != "allreduce") continue;
+    auto* node    = groups[i][0];
+    auto input    = node->inlinks_in_order().front()->source()->id();
+    auto& shape   = shape_dict.at(input);
+    auto& dtype   = dtype_dict.at(input);
+    int64_t numel = std::accumulate(shape.begin(), shape.end(), int64_t(1), std::multiplies<int64_t>());
+    int64_t bytes = numel * dtype.bits() / 8;
+    if (bytes >= FLAGS_cinn_allreduce_bucket_bytes) continue;
+    std::stringstream ss;
+    ss << dtype;
+    BucketKey key(GetAttr<int>(node, "ring_id", 0),
+                  GetAttr<int>(node, "nranks", 1),
+                  GetAttr<std::string>(node, "reduce_type", "sum"),
+                  ss.str());
+
+    auto it = open_buckets.find(key);
+    if (it != open_buckets.end() && bucket_bytes[it->second] + bytes <= FLAGS_cinn_allreduce_bucket_bytes) {
+      buckets[it->second].push_back(i);
+      bucket_bytes[it->second] += bytes;
+      bucket_of[i] = it->second;
+    } else {
+      bucket_of[i]      = buckets.size();
+      open_buckets[key] = buckets.size();
+      buckets.push_back({i});
+      bucket_bytes.push_back(bytes);
+    }
+  }
+
+  std::vector<std::vector<Node*>> new_groups;
+  for (int i = 0; i < groups.size(); i++) {
+    if (bucket_of[i] < 0 || buckets[bucket_of[i]].size() == 1) {
+      new_groups.push_back(groups[i]);
+    } else if (buckets[bucket_of[i]].back() == i) {
+      std::vector<Node*> bucket;
+      for (int member : buckets[bucket_of[i]]) bucket.push_back(groups[member].front());
+      bucket.front()->attrs.attr_store["collective_bucket"] = true;
+      VLOG(3) << "Pack " << bucket.size() << " allreduces of " << bucket_bytes[bucket_of[i]] << " bytes";
+      new_groups.push_back(std::move(bucket));
+    }
+  }
+  VLOG(2) << "AllReduceFusion: " << groups.size() << " groups to " << new_groups.size();
+  groups = std::move(new_groups);
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(AllReduceFusion) {
+  CINN_REGISTER_PASS(AllReduceFusion)
+      .describe(
+          "This pass packs the allreduces of the small gradients into buckets, each of which runs as one NCCL call. "
+          "It should be applied after OpFusion, and only changes the groups when CINN is built with NCCL.")
+      .set_change_structure(false)
+      .set_body(cinn::hlir::pass::AllReduceFusionPass);
+
+  return true;
+}
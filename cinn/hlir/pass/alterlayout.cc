@@ -12,11 +12,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <unordered_set>
+
 #include "cinn/hlir/framework/graph.h"
 #include "cinn/hlir/framework/node.h"
 #include "cinn/hlir/framework/op.h"
 #include "cinn/hlir/framework/pass.h"
 #include "cinn/hlir/pass/use_pass.h"
+#include "cinn/hlir/pe/nn.h"
 #include "cinn/hlir/pe/schedule.h"
 #include "cinn/ir/layout.h"
 #include "cinn/utils/string.h"
@@ -124,9 +130,350 @@ std::vector<framework::shape_t> UpdateInferInfos(Node* node,
   return infershapes;
 }
 
+#ifdef CINN_WITH_CUDNN
+// The GPU layout policy: the convs run by cudnn are switched to NHWC with OHWI weights, which the tensor cores need,
+// and the pool2d, batchnorm and elementwise ops after them follow the layout to avoid transposing back and forth.
+class NHWCLayoutAlterer {
+ public:
+  explicit NHWCLayoutAlterer(Graph* graph)
+      : graph_(graph),
+        shape_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, framework::shape_t>>("infershape")),
+        type_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype")) {
+    if (graph->HasAttr("inferlayout")) {
+      layout_dict_ = graph->GetAttrs<absl::flat_hash_map<std::string, std::string>>("inferlayout");
+    }
+  }
+
+  void Run() {
+    auto store_nodes = std::get<0>(graph_->topological_order());
+    for (auto* graph_node : store_nodes) {
+      auto* node = graph_node->safe_as<Node>();
+      if (!node) continue;
+      if (IsTensorCoreConv(node) || ((IsPool(node) || IsBatchNorm(node)) && nhwc_vars_.count(GetInput(node, 0)))) {
+        AlterToNHWC(node);
+      } else if (ReadsNHWC(node)) {
+        if (!FollowNHWC(node)) {
+          // the op keeps NCHW, read the transposed back inputs
+          for (int i = 0; i < node->inlinks_in_order(true).size(); i++) {
+            auto* input = GetInput(node, i);
+            if (nhwc_vars_.count(input)) ReplaceInput(node, i, Transpose(input, {0, 3, 1, 2}, "NCHW"));
+          }
+        }
+      }
+    }
+    if (nhwc_vars_.empty()) return;
+    RestoreOutputs();
+    graph_->attrs["inferlayout"] = std::make_shared<absl::any>(layout_dict_);
+  }
+
+ private:
+  Graph* graph_;
+  absl::flat_hash_map<std::string, framework::shape_t>& shape_dict_;
+  absl::flat_hash_map<std::string, Type>& type_dict_;
+  absl::flat_hash_map<std::string, std::string> layout_dict_;
+  // the vars holding NHWC data
+  std::unordered_set<NodeData*> nhwc_vars_;
+  // the transposed vars keyed by the source var and the layout, shared by all the readers
+  absl::flat_hash_map<std::string, NodeData*> transposed_;
+
+  static std::string GetStrAttr(Node* node, const std::string& key, const std::string& default_value) {
+    auto& attrs = node->attrs.attr_store;
+    return attrs.count(key) ? absl::get<std::string>(attrs.at(key)) : default_value;
+  }
+
+  static NodeData* GetInput(Node* node, int i) {
+    return node->inlinks_in_order(true)[i]->source()->safe_as<NodeData>();
+  }
+
+  // the forward conv2d whose channels are multiples of 8, so cudnn can run it on the tensor cores without any padding
+  bool IsTensorCoreConv(Node* node) {
+    if (node->op()->name != "conv2d" || node->inlinks_in_order(true).size() != 2) return false;
+    if (GetStrAttr(node, "conv_type", "forward") != "forward" || GetStrAttr(node, "data_format", "NCHW") != "NCHW") {
+      return false;
+    }
+    auto& input_shape  = shape_dict_.at(GetInput(node, 0)->id());
+    auto& weight_shape = shape_dict_.at(GetInput(node, 1)->id());
+    return input_shape.size() == 4 && weight_shape.size() == 4 && input_shape[1] % 8 == 0 && weight_shape[0] % 8 == 0;
+  }
+
+  bool IsPool(Node* node) {
+    auto data_format = GetStrAttr(node, "data_format", "NCHW");
+    return node->op()->name == "pool2d" && (data_format == "NCHW" || data_format == "AnyLayout");
+  }
+
+  bool IsBatchNorm(Node* node) {
+    return node->op()->name == "batchnorm" && GetStrAttr(node, "data_layout", "NCHW") == "NCHW";
+  }
+
+  bool ReadsNHWC(Node* node) {
+    for (int i = 0; i < node->inlinks_in_order(true).size(); i++) {
+      if (nhwc_vars_.count(GetInput(node, i))) return true;
+    }
+    return false;
+  }
+
+  // replace the pos-th input of the node, keeping the order of the inputs
+  void ReplaceInput(Node* node, int pos, NodeData* var) {
+    std::vector<common::GraphNode*> sources;
+    for (auto& link : node->inlinks_in_order(true)) sources.push_back(link->source());
+    for (auto* source : sources) source->UnLinkTo(node);
+    sources[pos] = var;
+    for (auto* source : sources) source->LinkTo(node);
+  }
+
+  // the var transposed by the axis, a transpose of a constant weight is prepacked after ConstPropagate
+  NodeData* Transpose(NodeData* var, const std::vector<int>& axis, const std::string& layout) {
+    std::string key = var->id() + "_" + layout;
+    if (transposed_.count(key)) return transposed_.at(key);
+    auto* out               = AddTranspose(var, axis, key + "_transpose");
+    shape_dict_[out->id()]  = Permute(shape_dict_.at(var->id()), axis);
+    type_dict_[out->id()]   = type_dict_.at(var->id());
+    layout_dict_[out->id()] = layout;
+    if (layout == "NHWC") nhwc_vars_.insert(out);
+    transposed_[key] = out;
+    return out;
+  }
+
+  // link a transpose op from the input, writing a new var unless the output is given
+  NodeData* AddTranspose(NodeData* input,
+                         const std::vector<int>& axis,
+                         const std::string& name,
+                         NodeData* out = nullptr) {
+    std::string op_type                  = "transpose";
+    auto* trans_node                     = new Node(Operator::Get(op_type), op_type, common::UniqName(name));
+    trans_node->attrs.attr_store["axis"] = axis;
+    std::shared_ptr<Node> node_ptr(trans_node);
+    input->LinkTo(trans_node);
+    if (out) {
+      out->source_node  = node_ptr;
+      out->output_index = 0;
+    } else {
+      out = new NodeData(node_ptr, 0, 0, common::UniqName(trans_node->id() + "_out"));
+      graph_->RegisterNode(out->id(), out);
+    }
+    trans_node->LinkTo(out);
+    graph_->RegisterNode(trans_node->id(), trans_node);
+    return out;
+  }
+
+  static framework::shape_t Permute(const framework::shape_t& shape, const std::vector<int>& axis) {
+    framework::shape_t res;
+    for (int i : axis) res.push_back(shape[i]);
+    return res;
+  }
+
+  void SetNHWCOutput(Node* node) {
+    auto* out               = node->outlinks_in_order(true)[0]->sink()->safe_as<NodeData>();
+    shape_dict_[out->id()]  = Permute(shape_dict_.at(out->id()), {0, 2, 3, 1});
+    layout_dict_[out->id()] = "NHWC";
+    nhwc_vars_.insert(out);
+  }
+
+  void AlterToNHWC(Node* node) {
+    CHECK_EQ(node->outlinks_in_order(true).size(), 1U) << node->id() << " should have 1 output";
+    auto* input = GetInput(node, 0);
+    if (!nhwc_vars_.count(input)) ReplaceInput(node, 0, Transpose(input, {0, 2, 3, 1}, "NHWC"));
+    auto& attrs = node->attrs.attr_store;
+    if (node->op()->name == "conv2d") {
+      ReplaceInput(node, 1, Transpose(GetInput(node, 1), {0, 2, 3, 1}, "OHWI"));
+      attrs["data_format"]    = std::string("NHWC");
+      attrs["weights_layout"] = std::string("OHWI");
+    } else if (node->op()->name == "pool2d") {
+      attrs["data_format"] = std::string("NHWC");
+    } else {
+      attrs["data_layout"] = std::string("NHWC");
+    }
+    VLOG(3) << node->id() << " is altered to NHWC";
+    SetNHWCOutput(node);
+  }
+
+  // the elementwise ops follow the NHWC layout of their inputs, with the other 4-D inputs transposed and the axis of a
+  // 1-D input moved with its dim.
+  bool FollowNHWC(Node* node) {
+    static auto& op_pattern_dict = Operator::GetAttrs<framework::OpPatternKind>("OpPattern");
+    if (op_pattern_dict[node->op()] > framework::kBroadcast || node->op()->name == "broadcast_to") return false;
+    auto& outlinks = node->outlinks_in_order(true);
+    if (outlinks.size() != 1 || shape_dict_.at(outlinks[0]->sink()->id()).size() != 4) return false;
+    auto& attrs = node->attrs.attr_store;
+    int axis    = attrs.count("axis") ? absl::get<int>(attrs.at("axis")) : -1;
+    // the position of each NCHW dim in NHWC
+    const int nhwc_axis[] = {0, 3, 1, 2};
+    int new_axis          = axis;
+    auto& inlinks         = node->inlinks_in_order(true);
+    for (int i = 0; i < inlinks.size(); i++) {
+      auto* input = GetInput(node, i);
+      if (nhwc_vars_.count(input)) continue;
+      auto& shape = shape_dict_.at(input->id());
+      int numel   = std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<int>());
+      if (shape.size() == 4 || numel == 1) continue;
+      if (shape.size() != 1) return false;
+      new_axis = nhwc_axis[axis < 0 ? 3 : axis];
+    }
+    for (int i = 0; i < inlinks.size(); i++) {
+      auto* input = GetInput(node, i);
+      if (!nhwc_vars_.count(input) && shape_dict_.at(input->id()).size() == 4) {
+        ReplaceInput(node, i, Transpose(input, {0, 2, 3, 1}, "NHWC"));
+      }
+    }
+    if (new_axis != axis) attrs["axis"] = new_axis;
+    SetNHWCOutput(node);
+    return true;
+  }
+
+  // the vars fetched or without readers are transposed back to keep their NCHW layout, the readers of the NHWC data
+  // read a new var from the producer.
+  void RestoreOutputs() {
+    std::unordered_set<NodeData*> outputs(graph_->outputs.begin(), graph_->outputs.end());
+    std::vector<NodeData*> vars(nhwc_vars_.begin(), nhwc_vars_.end());
+    std::sort(vars.begin(), vars.end(), [](NodeData* a, NodeData* b) { return a->id() < b->id(); });
+    for (auto* var : vars) {
+      if (!var->outlinks().empty() && !outputs.count(var)) continue;
+      auto* producer = var->source_node.get();
+      CHECK(producer);
+      auto* nhwc_out = new NodeData(var->source_node, 0, 0, common::UniqName(var->id() + "_nhwc"));
+      graph_->RegisterNode(nhwc_out->id(), nhwc_out);
+      shape_dict_[nhwc_out->id()]  = shape_dict_.at(var->id());
+      type_dict_[nhwc_out->id()]   = type_dict_.at(var->id());
+      layout_dict_[nhwc_out->id()] = "NHWC";
+      std::vector<Node*> readers;
+      for (auto& link : var->outlinks()) readers.push_back(link->sink()->safe_as<Node>());
+      for (auto* reader : readers) {
+        auto& inlinks = reader->inlinks_in_order(true);
+        for (int i = 0; i < inlinks.size(); i++) {
+          if (inlinks[i]->source() == var) ReplaceInput(reader, i, nhwc_out);
+        }
+      }
+      producer->UnLinkTo(var);
+      producer->LinkTo(nhwc_out);
+
+      AddTranspose(nhwc_out, {0, 3, 1, 2}, var->id() + "_restore", var);
+      shape_dict_[var->id()]  = Permute(shape_dict_.at(var->id()), {0, 3, 1, 2});
+      layout_dict_[var->id()] = "NCHW";
+    }
+  }
+};
+#endif
+
+// keep the NCHW conv2d computed by Winograd or by the GEMM over the im2col if the shapes fit. The Winograd weights are
+// transformed by a separate op which is run ahead by ConstPropagate for the constant weights
+bool KeepNCHWConv2d(Graph* graph,
+                    Node* node,
+                    const OpValueType<InferShapeFunc>& op_infershape,
+                    const OpValueType<InferTypeFunc>& op_inferdtype,
+                    const OpValueType<InferLayoutFunc>& op_inferlayout,
+                    absl::flat_hash_map<std::string, framework::shape_t>* shape_dict,
+                    absl::flat_hash_map<std::string, Type>* type_dict,
+                    absl::flat_hash_map<std::string, std::string>* layout_dict) {
+  auto& attrs = node->attrs.attr_store;
+  if ((attrs.count("use_mkldnn") && absl::get<bool>(attrs.at("use_mkldnn"))) ||
+      (attrs.count("conv_type") && absl::get<std::string>(attrs.at("conv_type")) != "forward")) {
+    return false;
+  }
+  std::vector<int> padding({0, 0});
+  std::vector<int> stride({1, 1});
+  std::vector<int> dilation({1, 1});
+  int groups = 1;
+  if (attrs.count("padding")) padding = absl::get<std::vector<int>>(attrs.at("padding"));
+  if (attrs.count("stride")) stride = absl::get<std::vector<int>>(attrs.at("stride"));
+  if (attrs.count("dilation")) dilation = absl::get<std::vector<int>>(attrs.at("dilation"));
+  if (attrs.count("groups")) groups = absl::get<int>(attrs.at("groups"));
+
+  auto conv_inlinks = node->inlinks_in_order(true);
+  CHECK_EQ(conv_inlinks.size(), 2U) << "conv2d should have 2 inputs";
+  auto* input_data  = conv_inlinks[0]->source()->safe_as<NodeData>();
+  auto* weight_data = conv_inlinks[1]->source()->safe_as<NodeData>();
+  CHECK(input_data);
+  CHECK(weight_data);
+  CHECK(shape_dict->count(input_data->id())) << input_data->id() << " has no infershape";
+  CHECK(shape_dict->count(weight_data->id())) << weight_data->id() << " has no infershape";
+  auto input_shape  = shape_dict->at(input_data->id());
+  auto weight_shape = shape_dict->at(weight_data->id());
+  auto input_type   = type_dict->at(input_data->id());
+  auto weight_type  = type_dict->at(weight_data->id());
+  // the input altered by the former convs is NCHWc, whose channels are recovered to judge the shapes
+  auto nchw_input_shape = input_shape;
+  if (input_shape.size() == 5U) {
+    nchw_input_shape = {input_shape[0], input_shape[1] * input_shape[4], input_shape[2], input_shape[3]};
+  }
+  int winograd_tile = pe::GetConv2dWinogradTile(nchw_input_shape, weight_shape, padding, stride, dilation, groups);
+  if (winograd_tile == 0 && !pe::UseConv2dIm2col(nchw_input_shape, weight_shape, padding, stride, dilation, groups)) {
+    return false;
+  }
+  VLOG(3) << node->id() << " keeps NCHW, winograd_tile: " << winograd_tile;
+
+  std::string conv_input_layout = "NCHW";
+  if (input_shape.size() == 5U) {
+    // NCHWxc -> NCHW
+    CHECK(layout_dict->count(input_data->id())) << input_data->id() << " should have out_layout attr";
+    Node* input_trans_node;
+    NodeData* output_data;
+    std::tie(input_trans_node, output_data) =
+        InsertLayoutTransformNodeAfter(graph,
+                                       input_data,
+                                       node,
+                                       0,
+                                       layout_dict->at(input_data->id()),
+                                       conv_input_layout,
+                                       common::UniqName(node->op()->name + "_input_layout_tranform"));
+    UpdateInferInfos(input_trans_node,
+                     {input_shape},
+                     {input_type},
+                     {layout_dict->at(input_data->id())},
+                     graph->target_,
+                     op_infershape,
+                     op_inferdtype,
+                     op_inferlayout,
+                     shape_dict,
+                     type_dict,
+                     layout_dict);
+    input_shape = shape_dict->at(output_data->id());
+  }
+
+  std::string weight_layout = "OIHW";
+  if (winograd_tile > 0) {
+    // insert the weight transform
+    std::string op_type    = "conv2d_winograd_weight_transform";
+    auto weight_trans_node = new Node(Operator::Get(op_type), op_type, common::UniqName(op_type));
+    weight_trans_node->attrs.attr_store["winograd_tile"] = winograd_tile;
+    auto output_data = InsertGraphOpNodeAfter(graph, weight_trans_node, weight_data, node, 1);
+    UpdateInferInfos(weight_trans_node,
+                     {weight_shape},
+                     {weight_type},
+                     {weight_layout},
+                     graph->target_,
+                     op_infershape,
+                     op_inferdtype,
+                     op_inferlayout,
+                     shape_dict,
+                     type_dict,
+                     layout_dict);
+    weight_shape           = shape_dict->at(output_data->id());
+    weight_layout          = layout_dict->at(output_data->id());
+    attrs["winograd_tile"] = winograd_tile;
+  }
+  UpdateInferInfos(node,
+                   {input_shape, weight_shape},
+                   {input_type, weight_type},
+                   {conv_input_layout, weight_layout},
+                   graph->target_,
+                   op_infershape,
+                   op_inferdtype,
+                   op_inferlayout,
+                   shape_dict,
+                   type_dict,
+                   layout_dict);
+  return true;
+}
+
 void AlterLayoutPass(Graph* graph) {
-  // alterlayout only in X86 for it's specific layout requirements
-  if (graph->target_.arch == Target::Arch::X86) {
+#ifdef CINN_WITH_CUDNN
+  if (graph->target_.arch == Target::Arch::NVGPU) {
+    NHWCLayoutAlterer(graph).Run();
+    return;
+  }
+#endif
+  // alterlayout only on the CPUs for their specific layout requirements
+  if (graph->target_.is_cpu()) {
     auto store_nodes     = std::get<0>(graph->topological_order());
     auto& shape_dict     = graph->GetMutableAttrs<absl::flat_hash_map<std::string, framework::shape_t>>("infershape");
     auto& type_dict      = graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
@@ -175,6 +522,17 @@ void AlterLayoutPass(Graph* graph) {
             // not NCHW such as NHWC or has already been altered layout
             continue;
           }
+          if (KeepNCHWConv2d(graph,
+                             node,
+                             op_infershape,
+                             op_inferdtype,
+                             op_inferlayout,
+                             &shape_dict,
+                             &type_dict,
+                             &layout_dict)) {
+            has_altered = true;
+            continue;
+          }
           has_altered             = true;
           std::string new_op_type = node->op()->name + "_NCHWc";
           // alter conv2d op to conv2d_NCHWc
@@ -613,8 +971,8 @@ void AlterLayoutPass(Graph* graph) {
 CINN_REGISTER_HELPER(AlterLayout) {
   CINN_REGISTER_PASS(AlterLayout)
       .describe(
-          "This pass alters ops' data layouts in the graph(e.g. NCHW -> NCHWxc, OIHW -> OIHWxoxi) and saves to "
-          "g.attrs[\"inferlayout\"]")
+          "This pass alters ops' data layouts in the graph(e.g. NCHW -> NCHWxc, OIHW -> OIHWxoxi on X86, NCHW -> NHWC, "
+          "OIHW -> OHWI for the cudnn convs on GPU) and saves to g.attrs[\"inferlayout\"]")
       .set_change_structure(true)
       .provide_graph_attr("infershape")
       .provide_graph_attr("inferdtype")
@@ -0,0 +1,123 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cuda_runtime.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+
+#include "cinn/cinn.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace frontend {
+
+using hlir::framework::Graph;
+using hlir::framework::Node;
+using hlir::framework::Scope;
+
+Program CreateConvPoolProgram() {
+  Placeholder A(Float(32), {2, 16, 32, 32}, "A");
+  Placeholder B(Float(32), {32, 16, 3, 3}, "B");
+  Placeholder Bias(Float(32), {32}, "Bias");
+
+  Program program;
+  absl::flat_hash_map<std::string, Program::attr_t> attrs;
+  attrs["stride"]      = std::vector<int>({1, 1});
+  attrs["dilation"]    = std::vector<int>({1, 1});
+  attrs["padding"]     = std::vector<int>({1, 1});
+  attrs["data_format"] = std::string("NCHW");
+
+  absl::flat_hash_map<std::string, Program::attr_t> attrs2;
+  attrs2["stride_size"]  = std::vector<int>({2, 2});
+  attrs2["padding_size"] = std::vector<int>({0, 0, 0, 0});
+  attrs2["kernel_size"]  = std::vector<int>({2, 2});
+  attrs2["pool_type"]    = std::string("max");
+
+  auto c = program.conv2d(A, B, attrs);
+  auto d = program.elementwise_add(c, Bias, 1);
+  auto e = program.relu(d);
+  auto f = program.pool2d(e, attrs2);
+
+  program.SetInputs({A, B, Bias});
+  program.Validate();
+  return program;
+}
+
+std::vector<float> RunProgram(const Program& program, bool alter_layout) {
+  Target target = common::DefaultNVGPUTarget();
+  auto graph    = std::make_shared<Graph>(program, target);
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  if (alter_layout) {
+    hlir::framework::ApplyPass(graph.get(), "AlterLayout");
+    int transpose_num = 0;
+    for (auto& node : std::get<0>(graph->topological_order())) {
+      auto* op_node = node->safe_as<Node>();
+      if (!op_node) continue;
+      if (op_node->op()->name == "transpose") transpose_num++;
+      if (op_node->op()->name == "conv2d") {
+        EXPECT_EQ(absl::get<std::string>(op_node->attrs.attr_store.at("data_format")), "NHWC");
+        EXPECT_EQ(absl::get<std::string>(op_node->attrs.attr_store.at("weights_layout")), "OHWI");
+      }
+      if (op_node->op()->name == "pool2d") {
+        EXPECT_EQ(absl::get<std::string>(op_node->attrs.attr_store.at("data_format")), "NHWC");
+      }
+    }
+    // the input to NHWC, the weight to OHWI and the pool2d output back to NCHW
+    EXPECT_EQ(transpose_num, 3);
+  }
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  LOG(INFO) << "graph:\n" << graph->Visualize();
+  auto scope = BuildScope(target, graph);
+
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  for (auto& name : {"A", "B", "Bias"}) {
+    auto tensor = scope->GetTensor(name);
+    std::vector<float> data(tensor->shape().numel());
+    for (auto& v : data) v = dist(rng);
+    auto* dst = tensor->mutable_data<float>(target);
+    cudaMemcpy(dst, data.data(), data.size() * sizeof(float), cudaMemcpyHostToDevice);
+  }
+  runtime_program->Execute();
+
+  // the fetched var keeps its NCHW layout
+  auto out = scope->GetTensor(program[program.size() - 1].GetOutput(0)->id);
+  EXPECT_EQ(out->shape().data(), std::vector<int>({2, 32, 16, 16}));
+  std::vector<float> res(out->shape().numel());
+  cudaMemcpy(res.data(), out->data<float>(), res.size() * sizeof(float), cudaMemcpyDeviceToHost);
+  return res;
+}
+
+TEST(AlterLayoutNHWC, conv_bias_relu_pool) {
+  auto program = CreateConvPoolProgram();
+  auto expected = RunProgram(program, false);
+  auto res      = RunProgram(program, true);
+  ASSERT_EQ(res.size(), expected.size());
+  for (int i = 0; i < res.size(); i++) {
+    ASSERT_NEAR(res[i], expected[i], 1e-3) << "at " << i;
+  }
+}
+
+}  // namespace frontend
+}  // namespace cinn
@@ -0,0 +1,200 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+using common::GraphNode;
+using common::Type;
+using framework::Graph;
+using framework::Node;
+using framework::NodeData;
+using framework::Operator;
+using framework::shape_t;
+
+namespace {
+
+// The compute-heavy ops run in float16, the others, e.g. the reductions, softmax and batchnorm, are kept in float32.
+const std::unordered_set<std::string> kFloat16Ops = {"conv2d", "depthwise_conv2d", "mul", "matmul"};
+
+// The float16 ops read the casts of their float32 inputs and write the float16 vars cast back to the original float32
+// ones. A float16 op reading the output of another one reads the float16 var directly, and the cast pairs at the
+// boundaries are elementwise ops, which OpFusion fuses with their neighbours.
+class MixedPrecisionRewriter {
+ public:
+  explicit MixedPrecisionRewriter(Graph* graph)
+      : graph_(graph),
+        shape_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape")),
+        type_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype")) {}
+
+  int Run() {
+    auto store_nodes = std::get<0>(graph_->topological_order());
+    for (auto* graph_node : store_nodes) {
+      auto* node = graph_node->safe_as<Node>();
+      if (node && kFloat16Ops.count(node->op()->name) && CanRunInFloat16(node)) ToFloat16(node);
+    }
+    // the casts back to float32 only read by the float16 ops are not needed any more
+    for (auto* cast : out_casts_) {
+      auto* out = Outputs(cast)[0];
+      if (out->outlinks().empty() && !IsGraphOutput(out)) Unlink(cast);
+    }
+    return num_rewritten_;
+  }
+
+ private:
+  Graph* graph_;
+  absl::flat_hash_map<std::string, shape_t>& shape_dict_;
+  absl::flat_hash_map<std::string, Type>& type_dict_;
+  // The float16 var of each float32 var, either the cast of it or the output of a float16 op cast back to it.
+  absl::flat_hash_map<std::string, NodeData*> float16_vars_;
+  std::vector<Node*> out_casts_;
+  int num_rewritten_{0};
+
+  static std::vector<NodeData*> Inputs(Node* node) {
+    std::vector<NodeData*> inputs;
+    for (auto& link : node->inlinks_in_order(true)) inputs.push_back(link->source()->safe_as<NodeData>());
+    return inputs;
+  }
+
+  static std::vector<NodeData*> Outputs(Node* node) {
+    std::vector<NodeData*> outputs;
+    for (auto& link : node->outlinks_in_order(true)) outputs.push_back(link->sink()->safe_as<NodeData>());
+    return outputs;
+  }
+
+  bool IsGraphOutput(NodeData* var) const {
+    return std::find(graph_->outputs.begin(), graph_->outputs.end(), var) != graph_->outputs.end();
+  }
+
+  static void Unlink(GraphNode* node) {
+    std::vector<GraphNode*> sources, sinks;
+    for (auto& link : node->inlinks()) sources.push_back(link->source());
+    for (auto& link : node->outlinks()) sinks.push_back(link->sink());
+    for (auto* source : sources) source->UnLinkTo(node);
+    for (auto* sink : sinks) node->UnLinkTo(sink);
+  }
+
+  bool CanRunInFloat16(Node* node) const {
+    auto& attrs = node->attrs.attr_store;
+    // the backward convs produce the gradients, which are kept in float32
+    if (attrs.count("conv_type") && absl::get<std::string>(attrs.at("conv_type")) != "forward") return false;
+    for (auto* var : Inputs(node)) {
+      if (type_dict_.at(var->id()) != Float(32)) return false;
+    }
+    for (auto* var : Outputs(node)) {
+      if (type_dict_.at(var->id()) != Float(32)) return false;
+    }
+    return true;
+  }
+
+  std::shared_ptr<Node> NewCast(const std::string& dtype) {
+    std::shared_ptr<Node> cast(new Node(Operator::Get("cast"), "cast", common::UniqName("cast_amp")));
+    cast->attrs.attr_store["dtype"] = dtype;
+    graph_->RegisterNode(cast->id(), cast.get());
+    return cast;
+  }
+
+  NodeData* NewVar(const std::shared_ptr<Node>& source, int index, const std::string& id, const Type& type) {
+    auto* var = new NodeData(source, index, 0, id);
+    graph_->RegisterNode(var->id(), var);
+    type_dict_[var->id()] = type;
+    return var;
+  }
+
+  NodeData* GetFloat16Var(NodeData* var) {
+    auto it = float16_vars_.find(var->id());
+    if (it != float16_vars_.end()) return it->second;
+    auto cast = NewCast("float16");
+    auto* out = NewVar(cast, 0, common::UniqName(var->id() + "_fp16"), Float(16));
+    shape_dict_[out->id()] = shape_dict_.at(var->id());
+    var->LinkTo(cast.get());
+    cast->LinkTo(out);
+    float16_vars_[var->id()] = out;
+    return out;
+  }
+
+  void ToFloat16(Node* node) {
+    VLOG(3) << "Run " << node->id() << " in float16";
+    auto inputs = Inputs(node);
+    for (auto* input : inputs) input->UnLinkTo(node);
+    for (auto* input : inputs) GetFloat16Var(input)->LinkTo(node);
+    node->inlinks_in_order(true);
+
+    // The op writes the new float16 vars, and the original ones become their casts back to float32, which keeps the
+    // readers and the graph outputs.
+    auto outputs = Outputs(node);
+    for (auto* output : outputs) node->UnLinkTo(output);
+    for (int i = 0; i < outputs.size(); i++) {
+      auto* output = outputs[i];
+      auto* out    = NewVar(output->source_node, i, common::UniqName(output->id() + "_fp16"), Float(16));
+      shape_dict_[out->id()] = shape_dict_.at(output->id());
+      node->LinkTo(out);
+      auto cast            = NewCast("float32");
+      output->source_node  = cast;
+      output->output_index = 0;
+      out->LinkTo(cast.get());
+      cast->LinkTo(output);
+      float16_vars_[output->id()] = out;
+      out_casts_.push_back(cast.get());
+    }
+    node->outlinks_in_order(true);
+    num_rewritten_++;
+  }
+};
+
+}  // namespace
+
+void AutoMixedPrecisionPass(Graph* graph) {
+  int num_rewritten = MixedPrecisionRewriter(graph).Run();
+  if (!num_rewritten) return;
+  auto& shape_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  auto& dtype_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  absl::flat_hash_map<std::string, std::string> layout_dict;
+  auto* layout_dict_ptr = &layout_dict;
+  if (graph->HasAttr("inferlayout")) {
+    layout_dict_ptr = &graph->GetMutableAttrs<absl::flat_hash_map<std::string, std::string>>("inferlayout");
+  }
+  graph->ClearUnlinkedNodes(&shape_dict, &dtype_dict, layout_dict_ptr);
+  VLOG(3) << "AutoMixedPrecision runs " << num_rewritten << " ops in float16";
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(AutoMixedPrecision) {
+  CINN_REGISTER_PASS(AutoMixedPrecision)
+      .describe(
+          "This pass runs conv2d, depthwise_conv2d, mul and matmul in float16 and keeps the other ops in float32, by "
+          "casting their inputs to float16 and their outputs back to float32. The casts between two float16 ops are "
+          "dropped. It should be applied after InferShape and before ConstPropagate, so that the casts of the weights "
+          "run once before the others.")
+      .set_change_structure(true)
+      .provide_graph_attr("infershape")
+      .provide_graph_attr("inferdtype")
+      .set_body(cinn::hlir::pass::AutoMixedPrecisionPass);
+  return true;
+}
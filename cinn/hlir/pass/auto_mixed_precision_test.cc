@@ -0,0 +1,157 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cinn/cinn.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace frontend {
+
+using hlir::framework::Graph;
+using hlir::framework::Node;
+using hlir::framework::NodeData;
+
+Target GetTarget() {
+#ifdef CINN_WITH_CUDA
+  return common::DefaultNVGPUTarget();
+#else
+  return common::DefaultHostTarget();
+#endif
+}
+
+std::shared_ptr<Graph> RunAMP(const Program& program, const std::string& fetch_id) {
+  auto graph = std::make_shared<Graph>(program, std::unordered_set<std::string>{fetch_id}, GetTarget());
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "AutoMixedPrecision");
+  return graph;
+}
+
+std::vector<Node*> GetOps(Graph& graph, const std::string& op_type) {
+  std::vector<Node*> ops;
+  for (auto* node : graph.nodes()) {
+    auto* op_node = node->safe_as<Node>();
+    if (op_node && op_node->op()->name == op_type) ops.push_back(op_node);
+  }
+  return ops;
+}
+
+Type GetType(const Graph& graph, NodeData* var) {
+  return graph.GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype").at(var->id());
+}
+
+Type InputType(const Graph& graph, Node* node, int index) {
+  return GetType(graph, node->inlinks_in_order()[index]->source()->safe_as<NodeData>());
+}
+
+Type OutputType(const Graph& graph, Node* node, int index) {
+  return GetType(graph, node->outlinks_in_order()[index]->sink()->safe_as<NodeData>());
+}
+
+// mul runs in float16 while softmax is kept in float32
+TEST(AutoMixedPrecision, mul_softmax) {
+  Placeholder A(Float(32), {16, 32}, "A");
+  Placeholder B(Float(32), {24, 32}, "B", true);
+
+  Program program;
+  auto c = program.mul(A, B, 1, 1);
+  auto d = program.softmax(c, {{"axis", 1}});
+  program.SetInputs({A, B});
+  program.Validate();
+
+  auto graph = RunAMP(program, d->id);
+  auto muls  = GetOps(*graph, "mul");
+  ASSERT_EQ(muls.size(), 1);
+  ASSERT_EQ(InputType(*graph, muls[0], 0), Float(16));
+  ASSERT_EQ(InputType(*graph, muls[0], 1), Float(16));
+  ASSERT_EQ(OutputType(*graph, muls[0], 0), Float(16));
+  auto softmaxes = GetOps(*graph, "softmax");
+  ASSERT_EQ(softmaxes.size(), 1);
+  ASSERT_EQ(InputType(*graph, softmaxes[0], 0), Float(32));
+  // A and B cast in, the output of mul cast back
+  ASSERT_EQ(GetOps(*graph, "cast").size(), 3);
+  ASSERT_EQ(GetType(*graph, graph->outputs[0]), Float(32));
+  ASSERT_EQ(graph->outputs[0]->id(), d->id);
+}
+
+// the output of a float16 mul is read by the next one without the cast pair, and the var read by two muls is cast once
+TEST(AutoMixedPrecision, mul_chain) {
+  Placeholder A(Float(32), {16, 32}, "A");
+  Placeholder B(Float(32), {32, 32}, "B", true);
+  Placeholder C(Float(32), {32, 32}, "C", true);
+
+  Program program;
+  auto d = program.mul(A, B, 1, 1);
+  auto e = program.mul(d, C, 1, 1);
+  auto f = program.mul(A, C, 1, 1);
+  auto g = program.elementwise_add(e, f);
+  program.SetInputs({A, B, C});
+  program.Validate();
+
+  auto graph = RunAMP(program, g->id);
+  for (auto* mul : GetOps(*graph, "mul")) {
+    ASSERT_EQ(InputType(*graph, mul, 0), Float(16)) << mul->id();
+    ASSERT_EQ(InputType(*graph, mul, 1), Float(16)) << mul->id();
+  }
+  // A, B and C cast in, e and f cast back
+  ASSERT_EQ(GetOps(*graph, "cast").size(), 5);
+  auto adds = GetOps(*graph, "elementwise_add");
+  ASSERT_EQ(adds.size(), 1);
+  ASSERT_EQ(InputType(*graph, adds[0], 0), Float(32));
+  ASSERT_EQ(InputType(*graph, adds[0], 1), Float(32));
+  ASSERT_EQ(graph->outputs[0]->id(), g->id);
+}
+
+// the statistics of batchnorm after conv2d are kept in float32
+TEST(AutoMixedPrecision, conv_bn) {
+  Placeholder A(Float(32), {1, 16, 8, 8}, "A");
+  Placeholder W(Float(32), {32, 16, 3, 3}, "W", true);
+  Placeholder Scale(Float(32), {32}, "Scale", true);
+  Placeholder Bias(Float(32), {32}, "Bias", true);
+  Placeholder Mean(Float(32), {32}, "Mean", true);
+  Placeholder Var(Float(32), {32}, "Var", true);
+
+  Program program;
+  absl::flat_hash_map<std::string, Program::attr_t> attrs;
+  attrs["stride"]   = std::vector<int>({1, 1});
+  attrs["dilation"] = std::vector<int>({1, 1});
+  attrs["padding"]  = std::vector<int>({1, 1});
+  auto c            = program.conv2d(A, W, attrs);
+  auto d            = program.batchnorm(c, Scale, Bias, Mean, Var, {{"epsilon", 0.001f}});
+  program.SetInputs({A, W, Scale, Bias, Mean, Var});
+  program.Validate();
+
+  auto graph = RunAMP(program, d->id);
+  auto convs = GetOps(*graph, "conv2d");
+  ASSERT_EQ(convs.size(), 1);
+  ASSERT_EQ(OutputType(*graph, convs[0], 0), Float(16));
+  auto bns = GetOps(*graph, "batchnorm");
+  ASSERT_EQ(bns.size(), 1);
+  for (int i = 0; i < 5; i++) ASSERT_EQ(InputType(*graph, bns[0], i), Float(32));
+  // A and W cast in, the output of conv2d cast back
+  ASSERT_EQ(GetOps(*graph, "cast").size(), 3);
+}
+
+}  // namespace frontend
+}  // namespace cinn
@@ -0,0 +1,107 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+DEFINE_int32(cinn_block_sparse_block_n, 16, "The number of the outputs of the blocks of the block-sparse muls.");
+DEFINE_int32(cinn_block_sparse_block_k, 1, "The number of the inputs of the blocks of the block-sparse muls.");
+DEFINE_double(cinn_block_sparse_density_threshold,
+              0.3,
+              "The block-sparse muls run sparse if at most the fraction of the blocks of their weights are nonzero.");
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+using common::Type;
+using framework::Graph;
+using framework::Node;
+using framework::NodeData;
+using framework::Operator;
+using framework::shape_t;
+
+namespace {
+
+// Whether the mul \p node reads a const float32 [N, K] weight of float32 X, and its temporary output is not read, for
+// the sparse kernel only writes the result.
+bool IsBlockSparseCandidate(Graph* graph, Node* node) {
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  auto& type_dict  = graph->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  auto& attrs      = node->attrs.attr_store;
+  if (attrs.count("y_num_col_dims") && absl::get<int>(attrs.at("y_num_col_dims")) != 1) return false;
+  auto inlinks = node->inlinks_in_order(true);
+  if (inlinks.size() != 2U) return false;
+  auto* x      = inlinks[0]->source()->safe_as<NodeData>();
+  auto* weight = inlinks[1]->source()->safe_as<NodeData>();
+  if (type_dict.at(x->id()) != Float(32) || type_dict.at(weight->id()) != Float(32)) return false;
+  if (!weight->is_const() || shape_dict.at(weight->id()).size() != 2U) return false;
+  auto outlinks = node->outlinks_in_order(true);
+  for (int i = 1; i < outlinks.size(); i++) {
+    auto* out = outlinks[i]->sink()->safe_as<NodeData>();
+    bool is_graph_output = std::find(graph->outputs.begin(), graph->outputs.end(), out) != graph->outputs.end();
+    if (!out->outlinks().empty() || is_graph_output) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+// The muls of the const weights are rewritten to block_sparse_mul, whose instructions pack the weights into the BSR
+// layout on the first run, and run the block-sparse kernel instead of the dense mul if the weights are pruned enough.
+void BlockSparseMulPass(Graph* graph) {
+  int block_n = FLAGS_cinn_block_sparse_block_n;
+  int block_k = FLAGS_cinn_block_sparse_block_k;
+  CHECK(block_n > 0 && block_k > 0) << "The blocks should not be empty, but got " << block_n << " x " << block_k;
+  int num_rewritten = 0;
+  for (auto* graph_node : std::get<0>(graph->topological_order())) {
+    auto* node = graph_node->safe_as<Node>();
+    if (!node || node->op()->name != "mul" || !IsBlockSparseCandidate(graph, node)) continue;
+    auto& attrs                = node->attrs.attr_store;
+    attrs["block_n"]           = block_n;
+    attrs["block_k"]           = block_k;
+    attrs["density_threshold"] = static_cast<float>(FLAGS_cinn_block_sparse_density_threshold);
+    node->attrs.op             = Operator::Get("block_sparse_mul");
+    node->attrs.node_name      = "block_sparse_mul";
+    num_rewritten++;
+  }
+  VLOG(3) << "BlockSparseMul rewrites " << num_rewritten << " muls with blocks of " << block_n << " x " << block_k;
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(BlockSparseMul) {
+  CINN_REGISTER_PASS(BlockSparseMul)
+      .describe(
+          "This pass rewrites the float32 muls of the const [N, K] weights to block_sparse_mul, which runs by the "
+          "block-sparse kernel of the nonzero blocks of FLAGS_cinn_block_sparse_block_n x "
+          "FLAGS_cinn_block_sparse_block_k of the weight, 1 x 1 for CSR, if their fraction is at most "
+          "FLAGS_cinn_block_sparse_density_threshold, or as the dense mul otherwise. The weights are checked and "
+          "packed on the first run, so they should not change after it, e.g. the parameters of a pruned model. It "
+          "should be applied after InferShape.")
+      .set_change_structure(false)
+      .set_body(cinn::hlir::pass::BlockSparseMulPass);
+  return true;
+}
@@ -0,0 +1,122 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "cinn/cinn.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace frontend {
+
+using hlir::framework::Graph;
+using hlir::framework::Node;
+using hlir::framework::Scope;
+
+namespace {
+
+Node* FindOp(Graph* graph, const std::string& op_type) {
+  for (auto* node : graph->nodes()) {
+    auto* op_node = node->safe_as<Node>();
+    if (op_node && op_node->op()->name == op_type) return op_node;
+  }
+  return nullptr;
+}
+
+// Run the mul of the [N, K] weight with the blocks of 16 x 1 kept if (block row + block col) % keep_every is 0, and
+// tell whether it ran sparse, in which case the temporary output of the dense mul is not written.
+bool RunBlockSparseMul(int keep_every) {
+  const int M = 3, N = 40, K = 24;
+  Placeholder A(Float(32), {M, K}, "A");
+  Placeholder B(Float(32), {N, K}, "B", true);
+
+  Program program;
+  auto c = program.mul(A, B, 1, 1);
+  program.SetInputs({A, B});
+  program.Validate();
+
+  Target target = common::DefaultHostTarget();
+  auto graph    = std::make_shared<Graph>(program, target);
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "BlockSparseMul");
+  auto* node = FindOp(graph.get(), "block_sparse_mul");
+  EXPECT_TRUE(node);
+  if (!node) return false;
+  auto temp_name = node->outlinks_in_order(true)[1]->sink()->id();
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+
+  auto scope = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  std::vector<float> input(M * K), weight(N * K, 0.f);
+  for (int i = 0; i < input.size(); i++) input[i] = (i % 5) * 0.5f - 1.f;
+  for (int n = 0; n < N; n++) {
+    for (int k = 0; k < K; k++) {
+      if ((n / 16 + k) % keep_every == 0) weight[n * K + k] = (n * K + k) % 7 * 0.25f - 0.75f;
+    }
+  }
+  std::copy(input.begin(), input.end(), scope->GetTensor("A")->mutable_data<float>(target));
+  std::copy(weight.begin(), weight.end(), scope->GetTensor("B")->mutable_data<float>(target));
+  auto temp       = scope->GetTensor(temp_name);
+  auto* temp_data = temp->mutable_data<float>(target);
+  std::fill(temp_data, temp_data + temp->shape().numel(), -1.f);
+  runtime_program->Execute();
+
+  auto* data = scope->GetTensor(c->id)->data<float>();
+  for (int m = 0; m < M; m++) {
+    for (int n = 0; n < N; n++) {
+      float expected = 0.f;
+      for (int k = 0; k < K; k++) expected += input[m * K + k] * weight[n * K + k];
+      EXPECT_NEAR(data[m * N + n], expected, 1e-4) << "at " << m << ", " << n;
+    }
+  }
+  return std::all_of(temp_data, temp_data + temp->shape().numel(), [](float v) { return v == -1.f; });
+}
+
+}  // namespace
+
+// a fifth of the blocks are nonzero
+TEST(BlockSparseMul, sparse) { ASSERT_TRUE(RunBlockSparseMul(5)); }
+
+// half of the blocks are nonzero, which is above the default density threshold
+TEST(BlockSparseMul, dense) { ASSERT_FALSE(RunBlockSparseMul(2)); }
+
+// mul of two activations is kept dense
+TEST(BlockSparseMul, skip) {
+  Placeholder A(Float(32), {4, 8}, "A");
+  Placeholder B(Float(32), {6, 8}, "B");
+
+  Program program;
+  program.mul(A, B, 1, 1);
+  program.SetInputs({A, B});
+  program.Validate();
+
+  auto graph = std::make_shared<Graph>(program, common::DefaultHostTarget());
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "BlockSparseMul");
+  ASSERT_TRUE(FindOp(graph.get(), "mul"));
+  ASSERT_FALSE(FindOp(graph.get(), "block_sparse_mul"));
+}
+
+}  // namespace frontend
+}  // namespace cinn
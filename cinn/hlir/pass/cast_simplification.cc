@@ -0,0 +1,267 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "cinn/common/precision.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+using common::GraphNode;
+using common::Type;
+using framework::Graph;
+using framework::Node;
+using framework::NodeData;
+using framework::shape_t;
+
+namespace {
+
+// The bits of the significand of a float type, including the implicit one.
+int SignificandBits(const Type& type) {
+  if (type.is_bfloat16()) return 8;
+  if (type.is_float(16)) return 11;
+  if (type.is_float(32)) return 24;
+  return 53;
+}
+
+// Whether each value of the type from is represented exactly by the type to, so that casting to it loses nothing.
+bool IsExact(const Type& from, const Type& to) {
+  if (from == to) return true;
+  if (from.is_floating_point()) {
+    if (!to.is_floating_point() || SignificandBits(to) < SignificandBits(from)) return false;
+    // bfloat16 has the exponent of float32, which float16 doesn't have
+    return !from.is_bfloat16() || to.bits() >= 32;
+  }
+  if (from.is_int()) {
+    if (to.is_int()) return to.bits() >= from.bits();
+    return to.is_floating_point() && SignificandBits(to) >= from.bits() - 1;
+  }
+  if (from.is_uint()) {
+    if (to.is_uint()) return to.bits() >= from.bits();
+    if (to.is_int()) return to.bits() > from.bits();
+    return to.is_floating_point() && SignificandBits(to) >= from.bits();
+  }
+  return false;
+}
+
+class CastSimplifier {
+ public:
+  explicit CastSimplifier(Graph* graph)
+      : shape_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape")),
+        type_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype")),
+        outputs_(graph->outputs.begin(), graph->outputs.end()),
+        reduced_(common::CurrentPrecisionMode() == common::PrecisionMode::kReduced) {}
+
+  int Run(Graph* graph) {
+    auto store_nodes = std::get<0>(graph->topological_order());
+    for (auto* graph_node : store_nodes) {
+      auto* node = graph_node->safe_as<Node>();
+      // the casts already dropped as a part of the pairs after them
+      if (!node || node->inlinks().empty() || node->op()->name != "cast") continue;
+      Simplify(node);
+    }
+    return num_changed_;
+  }
+
+ private:
+  absl::flat_hash_map<std::string, shape_t>& shape_dict_;
+  absl::flat_hash_map<std::string, Type>& type_dict_;
+  std::unordered_set<GraphNode*> outputs_;
+  bool reduced_;
+  int num_changed_{0};
+
+  static NodeData* Input(Node* node) { return node->inlinks_in_order(true)[0]->source()->safe_as<NodeData>(); }
+  static NodeData* Output(Node* node) { return node->outlinks_in_order(true)[0]->sink()->safe_as<NodeData>(); }
+
+  const Type& DType(NodeData* var) const { return type_dict_.at(var->id()); }
+
+  // The op producing the var, null for the inputs of the graph.
+  static Node* Producer(NodeData* var) { return var->source_node.get(); }
+
+  static bool IsCast(Node* node) { return node && node->op()->name == "cast"; }
+
+  // Whether the var only passes the data from its producer to one reader.
+  bool IsInternal(NodeData* var) const { return var->outlinks().size() == 1 && !outputs_.count(var); }
+
+  static void SetInput(Node* node, NodeData* var) {
+    Input(node)->UnLinkTo(node);
+    var->LinkTo(node);
+    node->inlinks_in_order(true);
+  }
+
+  static void Unlink(Node* node) {
+    std::vector<GraphNode*> sources, sinks;
+    for (auto& link : node->inlinks()) sources.push_back(link->source());
+    for (auto& link : node->outlinks()) sinks.push_back(link->sink());
+    for (auto* source : sources) source->UnLinkTo(node);
+    for (auto* sink : sinks) node->UnLinkTo(sink);
+  }
+
+  void Simplify(Node* cast) {
+    while (true) {
+      if (DType(Input(cast)) == DType(Output(cast))) {
+        DropIdentity(cast);
+        return;
+      }
+      if (MergeWithProducer(cast)) continue;
+      if (HoistAboveProducer(cast)) continue;
+      break;
+    }
+    FoldConstant(cast);
+  }
+
+  // The cast converts to the type of its input, let the readers read the input instead. The output fetched by name or
+  // read by an op already reading the input is kept.
+  void DropIdentity(Node* cast) {
+    auto* in       = Input(cast);
+    auto* out      = Output(cast);
+    bool droppable = !outputs_.count(out);
+    for (auto& link : out->outlinks()) {
+      if (in->IsLinkedTo(link->sink())) droppable = false;
+    }
+    if (!droppable) return;
+    VLOG(3) << "Drop " << cast->id() << " casting " << in->id() << " to its own type";
+    std::vector<GraphNode*> readers;
+    for (auto& link : out->outlinks()) readers.push_back(link->sink());
+    for (auto* reader : readers) {
+      auto* reader_node = reader->safe_as<Node>();
+      CHECK(reader_node);
+      // unlink and relink afterwards to keep the order of the inputs
+      std::vector<GraphNode*> sources;
+      for (auto& link : reader_node->inlinks_in_order(true)) sources.push_back(link->source());
+      for (auto* source : sources) source->UnLinkTo(reader);
+      for (auto* source : sources) (source == out ? in : source)->LinkTo(reader);
+      reader_node->inlinks_in_order(true);
+    }
+    Unlink(cast);
+    num_changed_++;
+  }
+
+  // Whether the cast of the output of the producer cast can cast the input of the producer instead, i.e. the producer
+  // loses nothing, or it only rounds the floats, which the reduced precision mode allows to skip.
+  bool CanMerge(Node* producer, Node* cast) const {
+    if (!IsCast(producer)) return false;
+    auto& from = DType(Input(producer));
+    auto& mid  = DType(Output(producer));
+    if (IsExact(from, mid)) return true;
+    return reduced_ && from.is_floating_point() && mid.is_floating_point() &&
+           DType(Output(cast)).is_floating_point();
+  }
+
+  bool MergeWithProducer(Node* cast) {
+    auto* mid      = Input(cast);
+    auto* producer = Producer(mid);
+    if (!CanMerge(producer, cast)) return false;
+    VLOG(3) << "Merge " << producer->id() << " into " << cast->id();
+    SetInput(cast, Input(producer));
+    if (mid->outlinks().empty() && !outputs_.count(mid)) Unlink(producer);
+    num_changed_++;
+    return true;
+  }
+
+  // Move the cast before the transpose, reshape or slice producing its input, when it merges with a cast before the
+  // op, or when it is a transpose or reshape and the cast doesn't widen the data, so that the op moves fewer bytes and
+  // the cast fuses into the group of the compute op before it. Casting before a slice casts more, so the lone casts
+  // stay after the slices.
+  bool HoistAboveProducer(Node* cast) {
+    auto* mid = Input(cast);
+    auto* op  = Producer(mid);
+    if (!op || !IsInternal(mid)) return false;
+    auto& op_name = op->op()->name;
+    if (op_name != "transpose" && op_name != "reshape" && op_name != "slice") return false;
+    if (op->inlinks().size() != 1 || op->outlinks().size() != 1) return false;
+    auto* in        = Input(op);
+    auto* out       = Output(cast);
+    bool not_widens = DType(out).bits() <= DType(in).bits() && op_name != "slice";
+    if (!not_widens && !CanMerge(Producer(in), cast)) return false;
+    VLOG(3) << "Hoist " << cast->id() << " above " << op->id();
+
+    // in -> op -> mid -> cast -> out becomes in -> cast -> mid -> op -> out, with mid of the shape of in
+    in->UnLinkTo(op);
+    mid->UnLinkTo(cast);
+    op->UnLinkTo(mid);
+    cast->UnLinkTo(out);
+    in->LinkTo(cast);
+    cast->LinkTo(mid);
+    mid->LinkTo(op);
+    op->LinkTo(out);
+    std::swap(mid->source_node, out->source_node);
+    for (auto* node : {op, cast}) {
+      node->inlinks_in_order(true);
+      node->outlinks_in_order(true);
+    }
+    shape_dict_[mid->id()] = shape_dict_.at(in->id());
+    type_dict_[mid->id()]  = DType(out);
+    num_changed_++;
+    return true;
+  }
+
+  // The cast of a constant, e.g. of a float32 weight read by a float16 op, is run once by the pre-run instructions
+  // when the parameters are loaded, and PrePack drops the weight it reads if the other ops don't read it.
+  void FoldConstant(Node* cast) {
+    if (!Input(cast)->is_const()) return;
+    auto& attrs = cast->attrs.attr_store;
+    if (attrs.count("pre_run") && absl::get<bool>(attrs.at("pre_run"))) return;
+    VLOG(3) << "Fold " << cast->id() << " of the constant " << Input(cast)->id();
+    attrs["pre_run"] = true;
+    Output(cast)->set_const(true);
+  }
+};
+
+}  // namespace
+
+void CastSimplificationPass(Graph* graph) {
+  int num_changed = CastSimplifier(graph).Run(graph);
+  if (!num_changed) return;
+  auto& shape_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  auto& dtype_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  absl::flat_hash_map<std::string, std::string> layout_dict;
+  auto* layout_dict_ptr = &layout_dict;
+  if (graph->HasAttr("inferlayout")) {
+    layout_dict_ptr = &graph->GetMutableAttrs<absl::flat_hash_map<std::string, std::string>>("inferlayout");
+  }
+  graph->ClearUnlinkedNodes(&shape_dict, &dtype_dict, layout_dict_ptr);
+  VLOG(3) << "CastSimplification simplified " << num_changed << " casts";
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(CastSimplification) {
+  CINN_REGISTER_PASS(CastSimplification)
+      .describe(
+          "This pass simplifies the casts between the ops, e.g. those inserted by AutoMixedPrecision and Quantization: "
+          "the casts to the type of their inputs are dropped, a cast of a cast losing nothing casts the first input "
+          "directly (and so does a cast of a float cast in the reduced precision mode), the casts are hoisted above "
+          "the transposes, reshapes and slices to merge with the casts before them, or to fuse with the op before "
+          "them when they don't widen the data, and the casts of the constants are marked to pre-run once when the "
+          "parameters are loaded. It should be applied after InferShape and before OpFusion.")
+      .set_change_structure(true)
+      .provide_graph_attr("infershape")
+      .provide_graph_attr("inferdtype")
+      .provide_graph_attr("pre_run")
+      .set_body(cinn::hlir::pass::CastSimplificationPass);
+  return true;
+}
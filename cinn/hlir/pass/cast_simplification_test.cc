@@ -0,0 +1,183 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cinn/cinn.h"
+#include "cinn/common/precision.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace frontend {
+
+using hlir::framework::Graph;
+using hlir::framework::Node;
+using hlir::framework::NodeData;
+
+Target GetTarget() {
+#ifdef CINN_WITH_CUDA
+  return common::DefaultNVGPUTarget();
+#else
+  return common::DefaultHostTarget();
+#endif
+}
+
+Variable Cast(Program* program, const Variable& x, const std::string& dtype) {
+  Instruction instr("cast", {x});
+  instr.SetAttr("dtype", dtype);
+  program->AppendInstruction(instr);
+  return instr.GetOutput(0);
+}
+
+std::vector<Node*> GetOpNodes(const Graph& graph) {
+  std::vector<Node*> op_nodes;
+  for (auto* node : std::get<0>(graph.topological_order())) {
+    if (node->safe_as<Node>()) op_nodes.push_back(node->safe_as<Node>());
+  }
+  return op_nodes;
+}
+
+NodeData* InputOf(Node* node) { return node->inlinks_in_order(true)[0]->source()->safe_as<NodeData>(); }
+NodeData* OutputOf(Node* node) { return node->outlinks_in_order(true)[0]->sink()->safe_as<NodeData>(); }
+
+Type GetType(const Graph& graph, NodeData* var) {
+  return graph.GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype").at(var->id());
+}
+
+std::shared_ptr<Graph> ApplyCastSimplification(Program* program,
+                                               const std::vector<Variable>& inputs,
+                                               const std::string& fetch_id) {
+  program->SetInputs(inputs);
+  program->Validate();
+  auto graph = std::make_shared<Graph>(*program, std::unordered_set<std::string>{fetch_id}, GetTarget());
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "CastSimplification");
+  LOG(INFO) << "graph:\n" << graph->Visualize();
+  return graph;
+}
+
+// float32 is float64 exactly, so the round trip is dropped
+TEST(CastSimplification, exact_round_trip) {
+  Placeholder A(Float(32), {16, 32}, "A");
+  Program program;
+  auto b = Cast(&program, A, "float64");
+  auto c = Cast(&program, b, "float32");
+  auto d = program.relu(c);
+
+  auto graph    = ApplyCastSimplification(&program, {A}, d->id);
+  auto op_nodes = GetOpNodes(*graph);
+  ASSERT_EQ(op_nodes.size(), 1UL);
+  ASSERT_EQ(op_nodes[0]->op()->name, "relu");
+  ASSERT_EQ(InputOf(op_nodes[0])->id(), "A");
+}
+
+// the float16 round trip rounds A, which only the reduced precision mode skips
+TEST(CastSimplification, lossy_round_trip) {
+  Placeholder A(Float(32), {16, 32}, "A");
+  Program program;
+  auto b = Cast(&program, A, "float16");
+  auto c = Cast(&program, b, "float32");
+  auto d = program.relu(c);
+
+  {
+    common::PrecisionScope scope(common::PrecisionMode::kFast);
+    auto graph = ApplyCastSimplification(&program, {A}, d->id);
+    ASSERT_EQ(GetOpNodes(*graph).size(), 3UL);
+  }
+  common::PrecisionScope scope(common::PrecisionMode::kReduced);
+  auto graph    = ApplyCastSimplification(&program, {A}, d->id);
+  auto op_nodes = GetOpNodes(*graph);
+  ASSERT_EQ(op_nodes.size(), 1UL);
+  ASSERT_EQ(InputOf(op_nodes[0])->id(), "A");
+}
+
+// the cast after the transpose is hoisted to merge with the one before it, and they cancel each other
+TEST(CastSimplification, casts_around_transpose) {
+  Placeholder A(Float(32), {16, 32}, "A");
+  Program program;
+  auto b = Cast(&program, A, "float64");
+  auto c = program.transpose(b, {1, 0});
+  auto d = Cast(&program, c, "float32");
+  auto e = program.relu(d);
+
+  auto graph    = ApplyCastSimplification(&program, {A}, e->id);
+  auto op_nodes = GetOpNodes(*graph);
+  ASSERT_EQ(op_nodes.size(), 2UL);
+  ASSERT_EQ(op_nodes[0]->op()->name, "transpose");
+  ASSERT_EQ(InputOf(op_nodes[0])->id(), "A");
+  ASSERT_EQ(GetType(*graph, OutputOf(op_nodes[0])), Float(32));
+  ASSERT_EQ(op_nodes[1]->op()->name, "relu");
+}
+
+// the narrowing cast moves before the reshape and the fetched var is still written by the reshape, while the one
+// after the slice stays
+TEST(CastSimplification, hoist_through_layout_ops) {
+  Placeholder A(Float(32), {16, 32}, "A");
+  Program program;
+  auto b = program.relu(A);
+  auto c = program.reshape(b, {32, 16});
+  auto d = Cast(&program, c, "float16");
+
+  auto graph    = ApplyCastSimplification(&program, {A}, d->id);
+  auto op_nodes = GetOpNodes(*graph);
+  ASSERT_EQ(op_nodes.size(), 3UL);
+  ASSERT_EQ(op_nodes[1]->op()->name, "cast");
+  ASSERT_EQ(InputOf(op_nodes[1])->id(), b->id);
+  ASSERT_EQ(GetType(*graph, OutputOf(op_nodes[1])), Float(16));
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, hlir::framework::shape_t>>("infershape");
+  ASSERT_EQ(shape_dict.at(OutputOf(op_nodes[1])->id()), hlir::framework::shape_t({16, 32}));
+  ASSERT_EQ(op_nodes[2]->op()->name, "reshape");
+  ASSERT_EQ(OutputOf(op_nodes[2])->id(), d->id);
+  ASSERT_EQ(graph->outputs[0]->id(), d->id);
+
+  Program slice_program;
+  auto f = slice_program.relu(A);
+  auto g = slice_program.slice(f, {{"axes", std::vector<int>{1}}, {"starts", std::vector<int>{0}},
+                                   {"ends", std::vector<int>{8}}});
+  auto h = Cast(&slice_program, g, "float16");
+
+  auto slice_graph = ApplyCastSimplification(&slice_program, {A}, h->id);
+  auto slice_nodes = GetOpNodes(*slice_graph);
+  ASSERT_EQ(slice_nodes.size(), 3UL);
+  ASSERT_EQ(slice_nodes[1]->op()->name, "slice");
+  ASSERT_EQ(slice_nodes[2]->op()->name, "cast");
+}
+
+// the cast of the weight runs once before the others
+TEST(CastSimplification, fold_constant) {
+  Placeholder A(Float(16), {16, 32}, "A");
+  Placeholder W(Float(32), {16, 32}, "W", true);
+  Program program;
+  auto w = Cast(&program, W, "float16");
+  auto c = program.elementwise_add(A, w);
+
+  auto graph = ApplyCastSimplification(&program, {A, W}, c->id);
+  for (auto* op_node : GetOpNodes(*graph)) {
+    if (op_node->op()->name != "cast") continue;
+    ASSERT_TRUE(absl::get<bool>(op_node->attrs.attr_store.at("pre_run")));
+    ASSERT_TRUE(OutputOf(op_node)->is_const());
+  }
+}
+
+}  // namespace frontend
+}  // namespace cinn
@@ -0,0 +1,165 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+using common::GraphNode;
+using common::Type;
+using framework::Graph;
+using framework::Node;
+using framework::NodeData;
+
+namespace {
+
+struct AttrPrinter {
+  std::ostream& os;
+
+  template <typename T>
+  void operator()(const T& value) {
+    os << value;
+  }
+
+  template <typename T>
+  void operator()(const std::vector<T>& values) {
+    os << "[";
+    for (const auto& value : values) os << value << ",";
+    os << "]";
+  }
+};
+
+// The op, the attributes and the inputs of the node, which are equal for the nodes computing the same values.
+std::string GetNodeKey(const Node* node) {
+  std::stringstream ss;
+  // Print the floats exactly, or the attributes differing slightly are mistaken as the same.
+  ss << std::hexfloat << node->op()->name << "{";
+  std::map<std::string, framework::AttrType> attrs(node->attrs.attr_store.begin(), node->attrs.attr_store.end());
+  for (auto& attr : attrs) {
+    ss << attr.first << "=" << attr.second.index() << ":";
+    absl::visit(AttrPrinter{ss}, attr.second);
+    ss << ";";
+  }
+  ss << "}(";
+  for (auto& link : node->inlinks_in_order(true)) {
+    ss << link->source()->id() << ",";
+  }
+  ss << ")";
+  return ss.str();
+}
+
+// Whether the outputs of node can be replaced by those of kept. The outputs read by no op might be fetched by name, and
+// an op already reading the output of kept can't read it twice, so they are kept.
+bool CanReplace(const Graph* graph, const Node* node, const Node* kept) {
+  auto& outlinks      = node->outlinks_in_order(true);
+  auto& kept_outlinks = kept->outlinks_in_order(true);
+  if (outlinks.size() != kept_outlinks.size()) return false;
+  for (int i = 0; i < outlinks.size(); i++) {
+    auto* var = outlinks[i]->sink()->safe_as<NodeData>();
+    CHECK(var);
+    if (var->outlinks().empty()) return false;
+    if (std::find(graph->outputs.begin(), graph->outputs.end(), var) != graph->outputs.end()) return false;
+    for (auto& link : var->outlinks()) {
+      if (kept_outlinks[i]->sink()->IsLinkedTo(link->sink())) return false;
+    }
+  }
+  return true;
+}
+
+// Let the readers of the outputs of node read those of kept instead, and unlink node and its outputs from the graph.
+void ReplaceNode(Node* node, Node* kept) {
+  auto outlinks      = node->outlinks_in_order(true);
+  auto kept_outlinks = kept->outlinks_in_order(true);
+  for (int i = 0; i < outlinks.size(); i++) {
+    auto* var      = outlinks[i]->sink();
+    auto* kept_var = kept_outlinks[i]->sink();
+    std::vector<GraphNode*> readers;
+    for (auto& link : var->outlinks()) readers.push_back(link->sink());
+    for (auto* reader : readers) {
+      auto* reader_node = reader->safe_as<Node>();
+      CHECK(reader_node);
+      // unlink and relink afterwards to keep the order of the inputs
+      std::vector<GraphNode*> sources;
+      for (auto& link : reader_node->inlinks_in_order(true)) sources.push_back(link->source());
+      for (auto* source : sources) source->UnLinkTo(reader);
+      for (auto* source : sources) (source == var ? kept_var : source)->LinkTo(reader);
+      reader_node->inlinks_in_order(true);
+    }
+    node->UnLinkTo(var);
+  }
+  std::vector<GraphNode*> sources;
+  for (auto& link : node->inlinks_in_order(true)) sources.push_back(link->source());
+  for (auto* source : sources) source->UnLinkTo(node);
+}
+
+}  // namespace
+
+void CommonSubexprEliminationPass(Graph* graph) {
+  auto store_nodes = std::get<0>(graph->topological_order());
+  absl::flat_hash_map<std::string, Node*> kept_nodes;
+  int num_replaced = 0;
+  for (auto* graph_node : store_nodes) {
+    auto* node = graph_node->safe_as<Node>();
+    if (!node) continue;
+    // the readers are relinked before they are visited in the topological order, so the nodes reading the replaced
+    // outputs are found equal too.
+    auto key = GetNodeKey(node);
+    auto it  = kept_nodes.find(key);
+    if (it == kept_nodes.end()) {
+      kept_nodes.emplace(key, node);
+      continue;
+    }
+    if (!CanReplace(graph, node, it->second)) continue;
+    VLOG(3) << "Replace " << node->id() << " with " << it->second->id();
+    ReplaceNode(node, it->second);
+    num_replaced++;
+  }
+  if (!num_replaced) return;
+  auto& shape_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, framework::shape_t>>("infershape");
+  auto& dtype_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  absl::flat_hash_map<std::string, std::string> layout_dict;
+  auto* layout_dict_ptr = &layout_dict;
+  if (graph->HasAttr("inferlayout")) {
+    layout_dict_ptr = &graph->GetMutableAttrs<absl::flat_hash_map<std::string, std::string>>("inferlayout");
+  }
+  graph->ClearUnlinkedNodes(&shape_dict, &dtype_dict, layout_dict_ptr);
+  VLOG(3) << "CommonSubexprElimination replaced " << num_replaced << " nodes";
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(CommonSubexprElimination) {
+  CINN_REGISTER_PASS(CommonSubexprElimination)
+      .describe(
+          "This pass merges the op nodes computing the same op with the same attributes on the same inputs, so that "
+          "the duplicated ones are neither compiled nor run. It should be applied before OpFusion.")
+      .set_change_structure(true)
+      .provide_graph_attr("infershape")
+      .provide_graph_attr("inferdtype")
+      .set_body(cinn::hlir::pass::CommonSubexprEliminationPass);
+  return true;
+}
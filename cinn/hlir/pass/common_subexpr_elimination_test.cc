@@ -0,0 +1,100 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "cinn/cinn.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/test_helper.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace frontend {
+
+using hlir::framework::Graph;
+using hlir::framework::GraphCompiler;
+using hlir::pass::CountOpNodes;
+
+Target GetTarget() {
+#ifdef CINN_WITH_CUDA
+  return common::DefaultNVGPUTarget();
+#else
+  return common::DefaultHostTarget();
+#endif
+}
+
+// the duplicated relu and the scale reading it are merged, the scale with another factor and the outputs are kept
+TEST(CommonSubexprElimination, duplicated_chain) {
+  Placeholder A(Float(32), {32, 64}, "A");
+  Placeholder B(Float(32), {32, 64}, "B");
+
+  Program program;
+  auto b1 = program.relu(A);
+  auto b2 = program.relu(A);
+  auto c1 = program.scale(b1, {{"scale", 2.f}});
+  auto c2 = program.scale(b2, {{"scale", 2.f}});
+  auto c3 = program.scale(b2, {{"scale", 3.f}});
+  auto d1 = program.add(c1, B);
+  auto d2 = program.elementwise_mul(c2, B);
+  auto d3 = program.add(c3, B);
+
+  Target target = GetTarget();
+  program.SetInputs({A, B});
+  program.Validate();
+  auto graph = std::make_shared<Graph>(program, target);
+
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  ASSERT_EQ(CountOpNodes(*graph), 8);
+  hlir::framework::ApplyPass(graph.get(), "CommonSubexprElimination");
+  ASSERT_EQ(CountOpNodes(*graph), 6);
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, hlir::framework::shape_t>>("infershape");
+  ASSERT_FALSE(shape_dict.count(b2->id));
+  ASSERT_FALSE(shape_dict.count(c2->id));
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+
+  auto scope = BuildScope(target, graph);
+  GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+
+#ifndef CINN_WITH_CUDA
+  auto* a_data = scope->GetTensor("A")->mutable_data<float>(target);
+  auto* b_data = scope->GetTensor("B")->mutable_data<float>(target);
+  for (int i = 0; i < 32 * 64; i++) {
+    a_data[i] = i % 2 ? 1.f : -3.f;
+    b_data[i] = i % 3 ? 1.f : -2.f;
+  }
+  runtime_program->Execute();
+  auto* d1_data = scope->GetTensor(d1->id)->data<float>();
+  auto* d2_data = scope->GetTensor(d2->id)->data<float>();
+  auto* d3_data = scope->GetTensor(d3->id)->data<float>();
+  for (int i = 0; i < 32 * 64; i++) {
+    float relu = std::max(a_data[i], 0.f);
+    ASSERT_NEAR(d1_data[i], relu * 2 + b_data[i], 1e-5);
+    ASSERT_NEAR(d2_data[i], relu * 2 * b_data[i], 1e-5);
+    ASSERT_NEAR(d3_data[i], relu * 3 + b_data[i], 1e-5);
+  }
+#else
+  runtime_program->Execute();
+#endif
+}
+
+}  // namespace frontend
+}  // namespace cinn
@@ -14,7 +14,9 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "cinn/cinn.h"
 #include "cinn/frontend/syntax.h"
@@ -132,7 +134,9 @@ TEST(const_bn, const_bn) {
   auto runtime_program = gc.Build();
   auto& prerun_instrs  = runtime_program->GetPreRunInstructions();
   auto& run_instrs     = runtime_program->GetRunInstructions();
-  ASSERT_EQ(prerun_instrs.size(), 7);
+  // the scale and shift are folded by the constant regions {elementwise_add, rsqrt, elementwise_mul} and
+  // {negative, elementwise_mul, elementwise_add}, the epsilon stays alone
+  ASSERT_EQ(prerun_instrs.size(), 3);
   ASSERT_EQ(run_instrs.size(), 2);
 
   scope->Var<hlir::framework::Tensor>("A");
@@ -155,5 +159,53 @@ TEST(const_bn, const_bn) {
   runtime_program->Execute();
 }
 
+// the constant region relu(scale(B)) is fused into one pre-run instruction, which is folded into a prepacked
+// variable
+TEST(const_region, const_region) {
+  Placeholder A(Float(32), {32, 64}, "A");
+  Placeholder B(Float(32), {32, 64}, "B", true);
+
+  Program program;
+  auto b = program.scale(B, {{"scale", 2.f}});
+  auto c = program.relu(b);
+  auto d = program.add(A, c);
+
+  Target target = GetTarget();
+  program.SetInputs({A, B});
+  program.Validate();
+  auto graph = std::make_shared<hlir::framework::Graph>(program, target);
+
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "ConstPropagate");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  auto scope = BuildScope(target, graph);
+
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  ASSERT_EQ(runtime_program->GetPreRunInstructions().size(), 1);
+  ASSERT_EQ(runtime_program->GetRunInstructions().size(), 1);
+
+  SetRandData(scope->GetTensor("A"), target);
+  SetRandData(scope->GetTensor("B"), target);
+#ifndef CINN_WITH_CUDA
+  auto* b_data = scope->GetTensor("B")->data<float>();
+  std::vector<float> b_host(b_data, b_data + 32 * 64);
+#endif
+
+  auto dropped = runtime_program->PrePack();
+  ASSERT_EQ(dropped.size(), 1UL);
+  ASSERT_FALSE(scope->FindVar("B"));
+  ASSERT_TRUE(scope->FindVar(c->id));
+  runtime_program->Execute();
+
+#ifndef CINN_WITH_CUDA
+  auto* a_data = scope->GetTensor("A")->data<float>();
+  auto* d_data = scope->GetTensor(d->id)->data<float>();
+  for (int i = 0; i < 32 * 64; i++) {
+    ASSERT_NEAR(d_data[i], a_data[i] + std::max(2.f * b_host[i], 0.f), 1e-5);
+  }
+#endif
+}
+
 }  // namespace frontend
 }  // namespace cinn
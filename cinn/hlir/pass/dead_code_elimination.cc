@@ -0,0 +1,97 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+using common::GraphNode;
+using common::Type;
+using framework::Graph;
+using framework::Node;
+using framework::NodeData;
+
+void DeadCodeEliminationPass(Graph* graph) {
+  if (graph->outputs.empty()) {
+    VLOG(3) << "The graph declares no outputs, all the nodes are kept";
+    return;
+  }
+  // the nodes the outputs depend on, and all the outputs of the live op nodes, which their kernels write
+  std::unordered_set<GraphNode*> live_nodes;
+  std::vector<GraphNode*> stack(graph->outputs.begin(), graph->outputs.end());
+  while (!stack.empty()) {
+    auto* node = stack.back();
+    stack.pop_back();
+    if (!live_nodes.insert(node).second) continue;
+    for (auto& link : node->inlinks()) stack.push_back(link->source());
+    if (node->safe_as<Node>()) {
+      for (auto& link : node->outlinks()) live_nodes.insert(link->sink());
+    }
+  }
+
+  auto nodes = graph->nodes();
+  std::vector<std::string> eliminated_vars;
+  for (auto* node : nodes) {
+    if (live_nodes.count(node)) continue;
+    if (node->safe_as<NodeData>()) eliminated_vars.push_back(node->id());
+    std::vector<GraphNode*> sources, sinks;
+    for (auto& link : node->inlinks()) sources.push_back(link->source());
+    for (auto& link : node->outlinks()) sinks.push_back(link->sink());
+    for (auto* source : sources) source->UnLinkTo(node);
+    for (auto* sink : sinks) node->UnLinkTo(sink);
+  }
+  if (live_nodes.size() == nodes.size()) return;
+  VLOG(3) << "DeadCodeElimination drops " << nodes.size() - live_nodes.size() << " nodes";
+
+  auto& shape_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, framework::shape_t>>("infershape");
+  auto& dtype_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  absl::flat_hash_map<std::string, std::string> layout_dict;
+  auto* layout_dict_ptr = &layout_dict;
+  if (graph->HasAttr("inferlayout")) {
+    layout_dict_ptr = &graph->GetMutableAttrs<absl::flat_hash_map<std::string, std::string>>("inferlayout");
+  }
+  graph->ClearUnlinkedNodes(&shape_dict, &dtype_dict, layout_dict_ptr);
+  if (graph->HasAttr("eliminated_vars")) {
+    auto& vars = graph->GetMutableAttrs<std::vector<std::string>>("eliminated_vars");
+    eliminated_vars.insert(eliminated_vars.begin(), vars.begin(), vars.end());
+  }
+  graph->attrs["eliminated_vars"] = std::make_shared<absl::any>(eliminated_vars);
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(DeadCodeElimination) {
+  CINN_REGISTER_PASS(DeadCodeElimination)
+      .describe(
+          "This pass drops the op nodes and variables the declared outputs of the graph don't depend on, and saves the "
+          "names of the dropped variables to g.attrs[\"eliminated_vars\"], so that BuildScope doesn't instantiate "
+          "them. The graph without declared outputs is kept as it is.")
+      .set_change_structure(true)
+      .provide_graph_attr("infershape")
+      .provide_graph_attr("inferdtype")
+      .provide_graph_attr("eliminated_vars")
+      .set_body(cinn::hlir::pass::DeadCodeEliminationPass);
+  return true;
+}
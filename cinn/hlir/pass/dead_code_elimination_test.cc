@@ -0,0 +1,119 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "cinn/cinn.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/test_helper.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace frontend {
+
+using hlir::framework::Graph;
+using hlir::framework::GraphCompiler;
+using hlir::pass::CountOpNodes;
+using hlir::framework::Scope;
+
+Target GetTarget() {
+#ifdef CINN_WITH_CUDA
+  return common::DefaultNVGPUTarget();
+#else
+  return common::DefaultHostTarget();
+#endif
+}
+
+// the branch of c and e doesn't reach the output d, it is dropped with its variables
+TEST(DeadCodeElimination, unused_branch) {
+  Placeholder A(Float(32), {32, 64}, "A");
+  Placeholder B(Float(32), {32, 64}, "B");
+
+  Program program;
+  auto b = program.relu(A);
+  auto c = program.scale(A, {{"scale", 2.f}});
+  auto d = program.add(b, B);
+  auto e = program.relu(c);
+
+  Target target = GetTarget();
+  program.SetInputs({A, B});
+  program.Validate();
+  auto graph = std::make_shared<Graph>(program, std::unordered_set<std::string>{d->id}, target);
+  ASSERT_EQ(graph->outputs.size(), 1UL);
+
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "DeadCodeElimination");
+  ASSERT_EQ(CountOpNodes(*graph), 2);
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, hlir::framework::shape_t>>("infershape");
+  ASSERT_FALSE(shape_dict.count(c->id));
+  ASSERT_FALSE(shape_dict.count(e->id));
+  auto& eliminated_vars = graph->GetAttrs<std::vector<std::string>>("eliminated_vars");
+  ASSERT_EQ(eliminated_vars.size(), 2UL);
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+
+  // the dropped variables already in the scope are removed too
+  auto scope = std::make_shared<Scope>();
+  scope->Var<hlir::framework::Tensor>(c->id);
+  BuildScope(target, graph, scope);
+  ASSERT_FALSE(scope->FindVar(c->id));
+  ASSERT_FALSE(scope->FindVar(e->id));
+
+  GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  ASSERT_EQ(runtime_program->size(), 1UL);
+
+#ifndef CINN_WITH_CUDA
+  auto* a_data = scope->GetTensor("A")->mutable_data<float>(target);
+  auto* b_data = scope->GetTensor("B")->mutable_data<float>(target);
+  for (int i = 0; i < 32 * 64; i++) {
+    a_data[i] = i % 2 ? 1.f : -3.f;
+    b_data[i] = i % 3 ? 1.f : -2.f;
+  }
+  runtime_program->Execute();
+  auto* d_data = scope->GetTensor(d->id)->data<float>();
+  for (int i = 0; i < 32 * 64; i++) {
+    ASSERT_NEAR(d_data[i], std::max(a_data[i], 0.f) + b_data[i], 1e-5);
+  }
+#else
+  runtime_program->Execute();
+#endif
+}
+
+// without declared outputs, nothing is dropped
+TEST(DeadCodeElimination, no_outputs) {
+  Placeholder A(Float(32), {32, 64}, "A");
+
+  Program program;
+  auto b = program.relu(A);
+  auto c = program.scale(A, {{"scale", 2.f}});
+
+  program.SetInputs({A});
+  program.Validate();
+  auto graph = std::make_shared<Graph>(program, GetTarget());
+
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "DeadCodeElimination");
+  ASSERT_EQ(CountOpNodes(*graph), 2);
+  ASSERT_FALSE(graph->HasAttr("eliminated_vars"));
+}
+
+}  // namespace frontend
+}  // namespace cinn
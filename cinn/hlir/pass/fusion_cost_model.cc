@@ -0,0 +1,157 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/hlir/pass/fusion_cost_model.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "cinn/hlir/framework/op.h"
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+using framework::Node;
+using framework::NodeData;
+using framework::OpPatternKind;
+
+namespace {
+
+// the registers a thread holds for the indices and loop variables, no matter what it computes.
+constexpr int kBaseRegisters = 8;
+
+int64_t GetNumel(const FusionCandidate& candidate, const std::string& var) {
+  auto it = candidate.shape_dict->find(var);
+  CHECK(it != candidate.shape_dict->end()) << "Cannot find the shape of " << var;
+  int64_t numel = 1;
+  for (int dim : it->second) numel *= dim;
+  return numel;
+}
+
+int GetBytes(const FusionCandidate& candidate, const std::string& var) {
+  if (candidate.dtype_dict) {
+    auto it = candidate.dtype_dict->find(var);
+    if (it != candidate.dtype_dict->end() && it->second.bits() > 0) return (it->second.bits() + 7) / 8;
+  }
+  return 4;
+}
+
+std::shared_ptr<const FusionCostModel>& GlobalModel() {
+  static std::shared_ptr<const FusionCostModel> model = std::make_shared<FusionCostModel>();
+  return model;
+}
+
+}  // namespace
+
+std::ostream& operator<<(std::ostream& os, const FusionDecision& decision) {
+  os << (decision.fuse ? "fuse" : "not fuse") << ": bytes_saved " << decision.cost.bytes_saved << ", recompute_flops "
+     << decision.cost.recompute_flops << ", registers " << decision.cost.estimated_registers << ", "
+     << decision.reason;
+  return os;
+}
+
+FusionCostModel::Options FusionCostModel::GetOptions(const common::Target& target) const {
+  Options options;
+  if (target.arch == common::Target::Arch::NVGPU) {
+    options.flops_per_byte        = 10.;
+    options.kernel_overhead_bytes = 1 << 21;
+    options.max_registers         = 255;
+  } else {
+    options.flops_per_byte        = 4.;
+    options.kernel_overhead_bytes = 1 << 16;
+  }
+  return options;
+}
+
+FusionCost FusionCostModel::Estimate(const FusionCandidate& candidate) const {
+  static auto& op_pattern_dict = framework::Operator::GetAttrs<OpPatternKind>("OpPattern");
+  CHECK(candidate.shape_dict);
+  std::unordered_set<const common::GraphNode*> members(candidate.nodes.begin(), candidate.nodes.end());
+  // the flops to evaluate one element of an inlined variable, including the inlined variables it reads
+  absl::flat_hash_map<std::string, int64_t> inline_flops;
+  std::unordered_set<std::string> loaded_vars;
+  FusionCost cost;
+  for (auto* node : candidate.nodes) {
+    int64_t flops = 1;
+    for (auto& link : node->inlinks_in_order(true)) {
+      auto* source = link->source();
+      auto it      = inline_flops.find(source->id());
+      if (it != inline_flops.end()) {
+        flops += it->second;
+      } else {
+        loaded_vars.insert(source->id());
+      }
+    }
+    auto& outlinks = node->outlinks_in_order(true);
+    if (outlinks.empty() || op_pattern_dict[node->op()] > framework::kInjective) continue;
+    // the first output is computed inline when all its readers are in the group, the reductions and the complex ops
+    // are always written to a buffer.
+    auto* out_var = outlinks.front()->sink();
+    auto readers  = out_var->outlinks();
+    if (readers.empty()) continue;
+    int64_t numel       = GetNumel(candidate, out_var->id());
+    int64_t evaluations = 0;
+    bool inlined        = true;
+    for (auto& reader_link : readers) {
+      auto* reader = reader_link->sink();
+      if (!members.count(reader)) {
+        inlined = false;
+        break;
+      }
+      auto* reader_node = reader->safe_as<Node>();
+      CHECK(reader_node);
+      CHECK(!reader_node->outlinks_in_order().empty());
+      // a reader evaluates the variable once per element of its output, or once per element of the variable when it
+      // reduces it
+      evaluations += std::max(numel, GetNumel(candidate, reader_node->outlinks_in_order().front()->sink()->id()));
+    }
+    if (!inlined) continue;
+    // one write and a read per reader no longer go through memory
+    cost.bytes_saved += numel * GetBytes(candidate, out_var->id()) * (1 + readers.size());
+    cost.recompute_flops += (evaluations - numel) * flops;
+    inline_flops[out_var->id()] = flops;
+  }
+  cost.estimated_registers = kBaseRegisters + loaded_vars.size() + candidate.nodes.size();
+  return cost;
+}
+
+FusionDecision FusionCostModel::Decide(const FusionCandidate& candidate) const {
+  auto options = GetOptions(candidate.target);
+  FusionDecision decision;
+  decision.cost = Estimate(candidate);
+  auto& cost    = decision.cost;
+  double gain   = static_cast<double>(cost.bytes_saved + options.kernel_overhead_bytes);
+  double loss   = cost.recompute_flops / options.flops_per_byte;
+  if (cost.estimated_registers > options.max_registers) {
+    decision.fuse   = false;
+    decision.reason = "the registers exceed the limit " + std::to_string(options.max_registers);
+  } else if (loss > gain) {
+    decision.fuse   = false;
+    decision.reason = "the recompute outweighs the traffic saved";
+  } else {
+    decision.reason = "the traffic saved outweighs the recompute";
+  }
+  return decision;
+}
+
+std::shared_ptr<const FusionCostModel> FusionCostModel::Global() { return GlobalModel(); }
+
+void FusionCostModel::SetGlobal(std::shared_ptr<const FusionCostModel> model) {
+  GlobalModel() = model ? model : std::make_shared<FusionCostModel>();
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,104 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "cinn/common/target.h"
+#include "cinn/common/type.h"
+#include "cinn/hlir/framework/node.h"
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+/**
+ * The group the OpFusion pass forms if it merges the groups on the path from source to sink.
+ */
+struct FusionCandidate {
+  //! The op nodes of the fused group, in topological order.
+  std::vector<framework::Node*> nodes;
+  const common::GraphNode* source{nullptr};
+  const common::GraphNode* sink{nullptr};
+  const absl::flat_hash_map<std::string, framework::shape_t>* shape_dict{nullptr};
+  //! The data types of the variables, or null if the graph has no "inferdtype" attribute.
+  const absl::flat_hash_map<std::string, common::Type>* dtype_dict{nullptr};
+  common::Target target;
+};
+
+/**
+ * The estimated effect of a fusion.
+ */
+struct FusionCost {
+  //! The global memory traffic removed by computing the intermediate variables inline, in bytes.
+  int64_t bytes_saved{0};
+  //! The arithmetic repeated because an inlined variable is evaluated once per element of each reader.
+  int64_t recompute_flops{0};
+  //! The registers a thread of the fused kernel is estimated to hold.
+  int estimated_registers{0};
+};
+
+struct FusionDecision {
+  bool fuse{true};
+  FusionCost cost;
+  //! A one-line explanation of the decision for the debug dump.
+  std::string reason;
+};
+
+std::ostream& operator<<(std::ostream& os, const FusionDecision& decision);
+
+/**
+ * The cost model OpFusion consults before it merges two groups. The op patterns decide whether a fusion is legal, the
+ * cost model decides whether a legal fusion pays off.
+ *
+ * The default model weighs the bytes saved plus the work of the removed kernel against the recomputed flops, and
+ * rejects the groups estimated to spill registers. Install a subclass with SetGlobal to change the policy.
+ */
+class FusionCostModel {
+ public:
+  struct Options {
+    //! The flops the target executes in the time it moves one byte of global memory.
+    double flops_per_byte{4.};
+    //! The bytes of memory traffic the launch or loop nest removed by a fusion is worth.
+    int64_t kernel_overhead_bytes{0};
+    //! The groups estimated to hold more registers per thread are not fused.
+    int max_registers{std::numeric_limits<int>::max()};
+  };
+
+  virtual ~FusionCostModel() = default;
+
+  virtual Options GetOptions(const common::Target& target) const;
+
+  virtual FusionCost Estimate(const FusionCandidate& candidate) const;
+
+  virtual FusionDecision Decide(const FusionCandidate& candidate) const;
+
+  //! The model used by OpFusion, the default one if no model was installed.
+  static std::shared_ptr<const FusionCostModel> Global();
+
+  //! Install the model used by OpFusion. A null model restores the default one.
+  static void SetGlobal(std::shared_ptr<const FusionCostModel> model);
+};
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
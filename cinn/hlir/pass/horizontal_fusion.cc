@@ -0,0 +1,197 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+using framework::Graph;
+using framework::Node;
+using framework::NodeData;
+using framework::Operator;
+using framework::OpPatternKind;
+
+// The maximum number of groups packed into one kernel, to bound the size of the kernel and its arguments.
+constexpr int kMaxHorizontalGroups = 16;
+
+// Only the groups of elementwise and broadcast ops are packed, whose iteration space is that of the final output.
+bool CanFuseHorizontally(const std::vector<Node*>& group) {
+  static auto& op_pattern_dict = Operator::GetAttrs<OpPatternKind>("OpPattern");
+  for (auto* node : group) {
+    if (op_pattern_dict[node->op()] > framework::kBroadcast) return false;
+    auto& attrs = node->attrs.attr_store;
+    if (attrs.count("pre_run") && absl::get<bool>(attrs.at("pre_run"))) return false;
+  }
+  return true;
+}
+
+// The key of the sibling reductions packed into one loop nest, that is, the shape of the reduced input with the reduced
+// dims, or empty if the group doesn't end with a reduction whose other ops are elementwise or broadcast. Only the
+// reductions on X86 are packed, whose outputs are each reduced by one thread, while the ones on NVGPU are scheduled as
+// the block reductions of their own.
+std::string GetSiblingReductionKey(const std::vector<Node*>& group,
+                                   const absl::flat_hash_map<std::string, framework::shape_t>& shape_dict,
+                                   const common::Target& target) {
+  static auto& op_pattern_dict = Operator::GetAttrs<OpPatternKind>("OpPattern");
+  auto* reduce                 = group.back();
+  if (target.arch != common::Target::Arch::X86 || op_pattern_dict[reduce->op()] != framework::kCommReduce ||
+      reduce->inlinks().size() != 1U || reduce->outlinks().size() != 1U) {
+    return "";
+  }
+  auto& input_shape = shape_dict.at(reduce->inlinks_in_order().front()->source()->id());
+  if (!CanFuseHorizontally(std::vector<Node*>(group.begin(), group.end() - 1))) return "";
+  auto& attrs = reduce->attrs.attr_store;
+  if (!attrs.count("dim") || (attrs.count("pre_run") && absl::get<bool>(attrs.at("pre_run")))) return "";
+  int ndim = input_shape.size();
+  std::set<int> dims;
+  for (int dim : absl::get<std::vector<int>>(attrs.at("dim"))) dims.insert(dim < 0 ? dim + ndim : dim);
+  bool keep_dim = attrs.count("keep_dim") && absl::get<bool>(attrs.at("keep_dim"));
+  std::stringstream ss;
+  ss << "reduce";
+  for (int dim : input_shape) ss << " " << dim;
+  ss << " dims";
+  for (int dim : dims) ss << " " << dim;
+  ss << " keep_dim " << keep_dim;
+  return ss.str();
+}
+
+/**
+ * Pack the independent groups whose final outputs have the same shape into one group, e.g. the sibling ops reading the
+ * same input, so that they are lowered to one kernel computing all the outputs in one loop nest, that is, one launch
+ * over the same grid on NVGPU. A packed group takes the place of its first member, so each later member can only join
+ * it if all the groups it depends on are before that place.
+ *
+ * The sibling reductions reading a common input, e.g. the sum and the sum of the squares of the batch norm and the
+ * layer norm statistics, are packed likewise if they reduce the same dims of the same shape, so that the kernel
+ * computes all the outputs reduced from each slice of the input while it is in the cache. Such a pack only takes the
+ * groups reading an input of its others.
+ */
+void HorizontalFusionPass(Graph* graph) {
+  auto& groups = graph->groups;
+  if (groups.empty()) {
+    for (auto& node : std::get<0>(graph->topological_order())) {
+      auto* op_node = node->safe_as<Node>();
+      if (op_node) groups.push_back({op_node});
+    }
+  }
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, framework::shape_t>>("infershape");
+
+  absl::flat_hash_map<const Node*, int> group_of;
+  for (int i = 0; i < groups.size(); i++) {
+    for (auto* node : groups[i]) group_of[node] = i;
+  }
+
+  // The members of each pack, the first one is where the pack is placed.
+  std::vector<std::vector<int>> packs;
+  std::vector<int> pack_of(groups.size(), -1);
+  // The pack still accepting groups for each shape of the final output.
+  std::map<framework::shape_t, int> open_packs;
+  // The pack still accepting groups for each key of the sibling reductions, and the inputs read by each pack.
+  std::map<std::string, int> open_reduction_packs;
+  std::map<int, std::set<const NodeData*>> pack_inputs;
+  for (int i = 0; i < groups.size(); i++) {
+    std::string reduction_key;
+    std::set<const NodeData*> inputs;
+    if (!CanFuseHorizontally(groups[i])) {
+      reduction_key = GetSiblingReductionKey(groups[i], shape_dict, graph->target_);
+      if (reduction_key.empty()) continue;
+    }
+    int last_depended = -1;
+    for (auto* node : groups[i]) {
+      for (auto& in_link : node->inlinks()) {
+        auto* input = in_link->source()->safe_as<NodeData>();
+        if (input) inputs.insert(input);
+        for (auto& producer_link : in_link->source()->inlinks()) {
+          auto* producer = producer_link->source()->safe_as<Node>();
+          if (!producer || !group_of.count(producer) || group_of.at(producer) == i) continue;
+          last_depended = std::max(last_depended, group_of.at(producer));
+        }
+      }
+    }
+    if (!reduction_key.empty()) {
+      auto it        = open_reduction_packs.find(reduction_key);
+      bool is_shared = false;
+      if (it != open_reduction_packs.end()) {
+        for (auto* input : inputs) is_shared |= pack_inputs[it->second].count(input) > 0;
+      }
+      if (is_shared && packs[it->second].size() < kMaxHorizontalGroups && last_depended < packs[it->second].front()) {
+        packs[it->second].push_back(i);
+        pack_of[i] = it->second;
+      } else {
+        pack_of[i]                          = packs.size();
+        open_reduction_packs[reduction_key] = packs.size();
+        packs.push_back({i});
+      }
+      pack_inputs[pack_of[i]].insert(inputs.begin(), inputs.end());
+      continue;
+    }
+    auto* final_out = groups[i].back()->outlinks_in_order().front()->sink();
+    auto& shape     = shape_dict.at(final_out->id());
+    auto it         = open_packs.find(shape);
+    if (it != open_packs.end() && packs[it->second].size() < kMaxHorizontalGroups &&
+        last_depended < packs[it->second].front()) {
+      packs[it->second].push_back(i);
+      pack_of[i] = it->second;
+    } else {
+      pack_of[i]        = packs.size();
+      open_packs[shape] = packs.size();
+      packs.push_back({i});
+    }
+  }
+
+  std::vector<std::vector<Node*>> new_groups;
+  for (int i = 0; i < groups.size(); i++) {
+    if (pack_of[i] < 0 || packs[pack_of[i]].size() == 1) {
+      new_groups.push_back(groups[i]);
+    } else if (packs[pack_of[i]].front() == i) {
+      std::vector<Node*> packed;
+      for (int member : packs[pack_of[i]]) {
+        packed.insert(packed.end(), groups[member].begin(), groups[member].end());
+      }
+      VLOG(3) << "Pack " << packs[pack_of[i]].size() << " groups horizontally, " << packed.size() << " ops";
+      new_groups.push_back(std::move(packed));
+    }
+  }
+  VLOG(2) << "HorizontalFusion: " << groups.size() << " groups to " << new_groups.size();
+  groups = std::move(new_groups);
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(HorizontalFusion) {
+  CINN_REGISTER_PASS(HorizontalFusion)
+      .describe(
+          "This pass packs the independent groups of elementwise ops with the same output shape, or the sibling "
+          "reductions of a common input on X86, into one group, which is lowered to one kernel. It should be applied "
+          "after OpFusion.")
+      .set_change_structure(false)
+      .set_body(cinn::hlir::pass::HorizontalFusionPass);
+
+  return true;
+}
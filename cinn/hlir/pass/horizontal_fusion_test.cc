@@ -0,0 +1,149 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "cinn/cinn.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace frontend {
+
+using hlir::framework::Graph;
+using hlir::framework::GraphCompiler;
+
+Target GetTarget() {
+#ifdef CINN_WITH_CUDA
+  return common::DefaultNVGPUTarget();
+#else
+  return common::DefaultHostTarget();
+#endif
+}
+
+// sibling ops reading the same input, an independent chain of the same shape, and the ops reading a packed output
+TEST(HorizontalFusion, siblings) {
+  Placeholder A(Float(32), {32, 64}, "A");
+  Placeholder B(Float(32), {32, 64}, "B");
+
+  Program program;
+  auto c  = program.relu(A);
+  auto d  = program.scale(A, {{"scale", 2.f}});
+  auto e  = program.add(B, B);
+  auto f  = program.relu(e);
+  auto g1 = program.add(c, B);
+  auto g2 = program.scale(c, {{"scale", 3.f}});
+
+  Target target = GetTarget();
+  program.SetInputs({A, B});
+  program.Validate();
+  auto graph = std::make_shared<Graph>(program, target);
+
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  ASSERT_EQ(graph->groups.size(), 5UL);
+  hlir::framework::ApplyPass(graph.get(), "HorizontalFusion");
+  // g1 and g2 depend on the group of c, so they are packed after it.
+  ASSERT_EQ(graph->groups.size(), 2UL);
+  ASSERT_EQ(graph->groups[0].size(), 4UL);
+  ASSERT_EQ(graph->groups[1].size(), 2UL);
+
+  auto scope = BuildScope(target, graph);
+  GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  ASSERT_EQ(runtime_program->size(), 2UL);
+
+#ifndef CINN_WITH_CUDA
+  auto* a_data = scope->GetTensor("A")->mutable_data<float>(target);
+  auto* b_data = scope->GetTensor("B")->mutable_data<float>(target);
+  for (int i = 0; i < 32 * 64; i++) {
+    a_data[i] = i % 2 ? 1.f : -3.f;
+    b_data[i] = i % 3 ? 1.f : -2.f;
+  }
+  runtime_program->Execute();
+  auto* d_data  = scope->GetTensor(d->id)->data<float>();
+  auto* f_data  = scope->GetTensor(f->id)->data<float>();
+  auto* g1_data = scope->GetTensor(g1->id)->data<float>();
+  auto* g2_data = scope->GetTensor(g2->id)->data<float>();
+  for (int i = 0; i < 32 * 64; i++) {
+    ASSERT_NEAR(d_data[i], a_data[i] * 2, 1e-5);
+    ASSERT_NEAR(f_data[i], std::max(b_data[i] * 2, 0.f), 1e-5);
+    ASSERT_NEAR(g1_data[i], std::max(a_data[i], 0.f) + b_data[i], 1e-5);
+    ASSERT_NEAR(g2_data[i], std::max(a_data[i], 0.f) * 3, 1e-5);
+  }
+#else
+  runtime_program->Execute();
+#endif
+}
+
+// the sum and the sum of the squares of the same input, as the batch norm statistics
+TEST(HorizontalFusion, sibling_reductions) {
+  Placeholder A(Float(32), {32, 64}, "A");
+
+  Program program;
+  auto sum    = program.reduce_sum(A, {1});
+  auto square = program.multiply(A, A);
+  auto sum_sq = program.reduce_sum(square, {1});
+
+  Target target = GetTarget();
+  program.SetInputs({A});
+  program.Validate();
+  auto graph = std::make_shared<Graph>(program, target);
+
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  ASSERT_EQ(graph->groups.size(), 2UL);
+  hlir::framework::ApplyPass(graph.get(), "HorizontalFusion");
+#ifndef CINN_WITH_CUDA
+  // the reductions are computed in one loop nest over the rows
+  ASSERT_EQ(graph->groups.size(), 1UL);
+  ASSERT_EQ(graph->groups[0].size(), 3UL);
+#else
+  ASSERT_EQ(graph->groups.size(), 2UL);
+#endif
+
+  auto scope = BuildScope(target, graph);
+  GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+
+#ifndef CINN_WITH_CUDA
+  ASSERT_EQ(runtime_program->size(), 1UL);
+  auto* a_data = scope->GetTensor("A")->mutable_data<float>(target);
+  for (int i = 0; i < 32 * 64; i++) a_data[i] = (i % 7) - 3.f;
+  runtime_program->Execute();
+  auto* sum_data    = scope->GetTensor(sum->id)->data<float>();
+  auto* sum_sq_data = scope->GetTensor(sum_sq->id)->data<float>();
+  for (int i = 0; i < 32; i++) {
+    float expect_sum = 0.f, expect_sum_sq = 0.f;
+    for (int j = 0; j < 64; j++) {
+      expect_sum += a_data[i * 64 + j];
+      expect_sum_sq += a_data[i * 64 + j] * a_data[i * 64 + j];
+    }
+    ASSERT_NEAR(sum_data[i], expect_sum, 1e-4);
+    ASSERT_NEAR(sum_sq_data[i], expect_sum_sq, 1e-3);
+  }
+#else
+  runtime_program->Execute();
+#endif
+}
+
+}  // namespace frontend
+}  // namespace cinn
@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <absl/container/flat_hash_set.h>
+
 #include <algorithm>
 #include <unordered_set>
 
@@ -19,6 +21,8 @@
 #include "cinn/hlir/framework/node.h"
 #include "cinn/hlir/framework/op.h"
 #include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pass/fusion_cost_model.h"
+#include "cinn/hlir/pe/transform.h"
 #include "cinn/hlir/pass/use_pass.h"
 #include "cinn/utils/string.h"
 
@@ -75,6 +79,32 @@ void GetBroadcastPattern(Node* op_node,
   }
 }
 
+// whether the node belongs to a constant region marked by ConstPropagate, which is evaluated once by the pre-run
+// instructions. A constant region only fuses within itself.
+bool IsPreRun(GraphNode* graph_node) {
+  auto* op_node = graph_node->safe_as<Node>();
+  if (op_node) {
+    auto& attrs = op_node->attrs.attr_store;
+    return attrs.count("pre_run") && absl::get<bool>(attrs.at("pre_run"));
+  }
+  auto* node_data = graph_node->safe_as<NodeData>();
+  CHECK(node_data);
+  return node_data->is_const();
+}
+
+// Whether the op node has an output other than the first read by the other ops, e.g. the saved mean and variance of
+// batch_norm_train and layer_norm read by the backward ops of the training graphs. The lowering of a fused group only
+// passes the first output of each op to the next ones, so such an op is a boundary of the fusion.
+bool HasReadExtraOutputs(GraphNode* graph_node) {
+  auto* op_node = graph_node->safe_as<Node>();
+  if (!op_node) return false;
+  auto& out_links = op_node->outlinks_in_order(true);
+  for (int i = 1; i < out_links.size(); i++) {
+    if (!out_links[i]->sink()->outlinks().empty()) return true;
+  }
+  return false;
+}
+
 class DomTree {
  public:
   std::vector<DomNode*>& CreatePostDomTree(const std::vector<GraphNode*>& nodes) {
@@ -130,7 +160,10 @@ class DomTree {
         auto sink         = out_links[i]->sink();
         bool has_no_links = sink->outlinks().empty();
         if (i) {
-          CHECK(has_no_links) << "only the first out_var of " << node->id() << " links to other op node";
+          if (has_no_links) continue;
+          // the other outputs read later are post-dominated by the LCA of all of them, with the op not fused through
+          parent   = LCA(parent, dom_nodes_[sink->get_index()], pattern);
+          *pattern = framework::kOpaque;
         } else {
           int index = sink->get_index();
           // the first out_var is the parent of the op node
@@ -158,10 +191,10 @@ class DomTree {
         CHECK(op_node);
         auto op_pattern = op_pattern_dict[op_node->op()];
         VLOG(2) << sink->id() << "'s op pattern is " << op_pattern;
-        if (op_node->attrs.attr_store.count("pre_run") && absl::get<bool>(op_node->attrs.attr_store["pre_run"])) {
-          // not fuse pre_run opnode
+        if (IsPreRun(op_node) != IsPreRun(node_data)) {
+          // not fuse across the boundary of a constant region
           op_pattern = framework::kOpaque;
-          VLOG(3) << op_node->op()->name << " do pre_run and not fuse";
+          VLOG(3) << op_node->op()->name << " is on the boundary of a constant region and not fuse";
         }
         *pattern = FusePattern(*pattern, op_pattern);
         count++;
@@ -216,7 +249,10 @@ struct GroupNode {
 };
 class GraphPartition {
  public:
-  GraphPartition(const absl::flat_hash_map<std::string, framework::shape_t>& shape_dict) : shape_dict_(shape_dict) {}
+  GraphPartition(const absl::flat_hash_map<std::string, framework::shape_t>& shape_dict,
+                 const absl::flat_hash_map<std::string, Type>* dtype_dict,
+                 const common::Target& target)
+      : shape_dict_(shape_dict), dtype_dict_(dtype_dict), target_(target) {}
   std::vector<std::vector<Node*>> Partition(const std::vector<GraphNode*>& graph_nodes,
                                             const std::vector<DomNode*>& dom_nodes) {
     CHECK_EQ(graph_nodes.size(), dom_nodes.size());
@@ -231,11 +267,21 @@ class GraphPartition {
     return groups_;
   }
 
+  // the explanation of each fusion the cost model was consulted about
+  const std::vector<std::string>& decisions() const { return decisions_; }
+
+  // the ids of the op nodes kept alone, e.g. the ones whose fusions ran slower than their parts in the profile
+  void set_unfused_nodes(const absl::flat_hash_set<std::string>* unfused_nodes) { unfused_nodes_ = unfused_nodes; }
+
  private:
   std::vector<GroupNode*> group_nodes_;
   std::vector<std::vector<Node*>> groups_;
   std::unordered_set<GraphNode*> visited_nodes_;
   const absl::flat_hash_map<std::string, framework::shape_t>& shape_dict_;
+  const absl::flat_hash_map<std::string, Type>* dtype_dict_;
+  common::Target target_;
+  std::vector<std::string> decisions_;
+  const absl::flat_hash_set<std::string>* unfused_nodes_{};
   void InitGroups(const std::vector<GraphNode*>& graph_nodes) {
     static auto& op_pattern_dict = Operator::GetAttrs<OpPatternKind>("OpPattern");
     for (int i = 0; i < graph_nodes.size(); i++) {
@@ -247,11 +293,20 @@ class GraphPartition {
       group_node->index    = graph_node->get_index();
       if (op_node) {
         auto pattern = op_pattern_dict[op_node->op()];
-        if (op_node->attrs.attr_store.count("pre_run") && absl::get<bool>(op_node->attrs.attr_store["pre_run"])) {
-          // not fuse pre_run opnode
+        if (IsPreRun(op_node) && op_node->inlinks().empty()) {
+          // the pre_run ops without inputs like const_scalar and fill_constant stay alone, the rest of the constant
+          // region fuses like the other ops
           pattern = framework::kOpaque;
           VLOG(3) << op_node->op()->name << " do pre_run and not fuse";
         }
+        if (HasReadExtraOutputs(op_node)) {
+          pattern = framework::kOpaque;
+          VLOG(3) << op_node->id() << " has the other outputs read later and not fuse";
+        }
+        if (unfused_nodes_ && unfused_nodes_->count(op_node->id())) {
+          pattern = framework::kOpaque;
+          VLOG(3) << op_node->id() << " is kept unfused";
+        }
         group_node->pattern        = pattern;
         group_node->op_nodes_count = 1;
         if (pattern == framework::kOutEWiseFusable) {
@@ -315,6 +370,7 @@ class GraphPartition {
   bool CanFuse(GraphNode* source, GraphNode* sink, T fn) {
     if (visited_nodes_.count(source)) return true;
     visited_nodes_.insert(source);
+    if (IsPreRun(source) != IsPreRun(sink)) return false;
     if (!fn(GetRootPattern(source), source == sink)) return false;
     if (source == sink) return true;
     auto op_node = source->safe_as<Node>();
@@ -325,8 +381,9 @@ class GraphPartition {
         // judge only the first out var of the op node can fuse
         if (!i) {
           if (!CanFuse(new_source, sink, fn)) return false;
-        } else {
-          CHECK(new_source->outlinks().empty()) << "only the first out_var of the op node can link to other op node";
+        } else if (!new_source->outlinks().empty()) {
+          // only the first out var of the op node can link to the other op nodes in a group
+          return false;
         }
       }
     } else {
@@ -345,6 +402,7 @@ class GraphPartition {
     auto op_node                 = source->safe_as<Node>();
     visited_nodes_.clear();
     CHECK(source != sink);
+    if (IsPreRun(source) != IsPreRun(sink)) return false;
     auto sink_op_node = sink->safe_as<Node>();
     if (sink_op_node && GetRootPattern(source) == framework::kOutEWiseFusable &&
         op_pattern_dict[sink_op_node->op()] >= framework::kBroadcast) {
@@ -363,8 +421,8 @@ class GraphPartition {
         if (!i) {
           // verify all the nodes in the fuse path recursively
           if (!CanFuse(new_source, sink, fn)) return false;
-        } else {
-          CHECK(new_source->outlinks().empty()) << "only the first out_var of op_node links to other op_node";
+        } else if (!new_source->outlinks().empty()) {
+          return false;
         }
       }
     } else {
@@ -386,6 +444,11 @@ class GraphPartition {
     parent->nodes_count += child->nodes_count;
     parent->op_nodes_count += child->op_nodes_count;
     child->parent = parent;
+    if (child->pattern == framework::kCommReduce) {
+      // the group keeps the pattern of its reduction, so that it only fuses the elementwise or broadcast ops after it
+      // and never chains another reduction.
+      parent->pattern = std::max(parent->pattern, child->pattern);
+    }
     if (child->master_node) {
       CHECK(!parent->master_node);
       parent->master_node = child->master_node;
@@ -429,6 +492,32 @@ class GraphPartition {
     CHECK(source != sink);
     Fuse(source, sink, group_node);
   }
+  // ask the fusion cost model whether merging the groups on the path from source to sink pays off. It must follow a
+  // successful VerifyFuse, which leaves the nodes of the path in visited_nodes_.
+  bool IsProfitable(const std::vector<GraphNode*>& graph_nodes, GraphNode* source, GraphNode* sink) {
+    // an op node always joins the group of its output var
+    if (sink->safe_as<NodeData>()) return true;
+    std::unordered_set<GroupNode*> roots{group_nodes_[source->get_index()]->GetRootNode()};
+    for (auto* node : visited_nodes_) {
+      roots.insert(group_nodes_[node->get_index()]->GetRootNode());
+    }
+    FusionCandidate candidate;
+    candidate.source     = source;
+    candidate.sink       = sink;
+    candidate.shape_dict = &shape_dict_;
+    candidate.dtype_dict = dtype_dict_;
+    candidate.target     = target_;
+    for (auto* graph_node : graph_nodes) {
+      auto* op_node = graph_node->safe_as<Node>();
+      if (op_node && roots.count(group_nodes_[graph_node->get_index()]->GetRootNode())) {
+        candidate.nodes.push_back(op_node);
+      }
+    }
+    auto decision = FusionCostModel::Global()->Decide(candidate);
+    decisions_.push_back(source->id() + " -> " + sink->id() + ": " + utils::GetStreamCnt(decision));
+    VLOG(2) << decisions_.back();
+    return decision.fuse;
+  }
   void FuseGroups(const std::vector<GraphNode*>& graph_nodes, const std::vector<DomNode*>& dom_nodes, int phase) {
     CHECK_EQ(graph_nodes.size(), dom_nodes.size());
     CHECK_EQ(group_nodes_.size(), dom_nodes.size());
@@ -449,7 +538,7 @@ class GraphPartition {
         if (dom_node->pattern <= framework::kBroadcast) {
           auto fn       = [](OpPatternKind pattern, bool is_sink) { return pattern <= framework::kBroadcast; };
           auto lca_node = dom_node->parent->ref_node;
-          if (VerifyFuse(graph_node, lca_node, fn)) {
+          if (VerifyFuse(graph_node, lca_node, fn) && IsProfitable(graph_nodes, graph_node, lca_node)) {
             VLOG(2) << "fuse between " << graph_node->id() << " and " << lca_node->id();
             DoFuse(graph_node, lca_node);
           }
@@ -464,17 +553,28 @@ class GraphPartition {
             }
           };
           auto lca_node = dom_node->parent->ref_node;
-          if (VerifyFuse(graph_node, lca_node, fn)) {
+          if (VerifyFuse(graph_node, lca_node, fn) && IsProfitable(graph_nodes, graph_node, lca_node)) {
             VLOG(2) << "fuse between " << graph_node->id() << " and " << lca_node->id();
             DoFuse(graph_node, lca_node);
           }
         }
+      } else if (group_node->pattern == framework::kCommReduce) {
+        // fuse the elementwise or broadcast epilogue of a reduction, e.g. the scale after a sum, or the ops reading the
+        // reduced result broadcast back like the normalization of softmax and layer_norm.
+        if (dom_node->pattern <= framework::kBroadcast) {
+          auto fn       = [](OpPatternKind pattern, bool is_sink) { return pattern <= framework::kBroadcast; };
+          auto lca_node = dom_node->parent->ref_node;
+          if (VerifyFuse(graph_node, lca_node, fn) && IsProfitable(graph_nodes, graph_node, lca_node)) {
+            VLOG(2) << "fuse reduction " << graph_node->id() << " and " << lca_node->id();
+            DoFuse(graph_node, lca_node);
+          }
+        }
       } else if (group_node->pattern == framework::kInjective && phase == 1) {
         // fuse injective ops in the second phase so that conv2d can always finish fusing
         if (dom_node->pattern <= framework::kInjective) {
           auto fn       = [](OpPatternKind pattern, bool is_sink) { return pattern <= framework::kInjective; };
           auto lca_node = dom_node->parent->ref_node;
-          if (VerifyFuse(graph_node, lca_node, fn)) {
+          if (VerifyFuse(graph_node, lca_node, fn) && IsProfitable(graph_nodes, graph_node, lca_node)) {
             VLOG(2) << "fuse between " << graph_node->id() << " and " << lca_node->id();
             DoFuse(graph_node, lca_node);
           }
@@ -510,6 +610,137 @@ class GraphPartition {
   }
 };
 
+#ifdef CINN_WITH_CUDNN
+// the op reading var, if var is read only by it and is not an output of the graph.
+Node* GetOnlyReader(Graph* graph, NodeData* var) {
+  if (var->outlinks().size() != 1) return nullptr;
+  if (std::find(graph->outputs.begin(), graph->outputs.end(), var) != graph->outputs.end()) return nullptr;
+  return (*var->outlinks().begin())->sink()->safe_as<Node>();
+}
+
+// the kind of the epilogue op reading the result out of the library call, "bias", "residual" or "relu", or an empty
+// string if it can't be run by the library call. channel_axis is the axis of out the bias is added along.
+std::string GetEpilogueKind(Node* op_node,
+                            NodeData* out,
+                            int channel_axis,
+                            const std::vector<std::string>& epilogue,
+                            const absl::flat_hash_map<std::string, framework::shape_t>& shape_dict) {
+  bool has_bias     = !epilogue.empty();
+  bool has_relu     = has_bias && epilogue.back() == "relu";
+  bool has_residual = std::find(epilogue.begin(), epilogue.end(), "residual") != epilogue.end();
+  if (has_relu || IsPreRun(op_node) != IsPreRun(out)) return "";
+  if (op_node->op()->name == "relu") return has_bias ? "relu" : "";
+  if (op_node->op()->name != "elementwise_add" || op_node->inlinks_in_order(true).size() != 2) return "";
+  NodeData* operand = nullptr;
+  for (auto& link : op_node->inlinks_in_order()) {
+    auto* source = link->source()->safe_as<NodeData>();
+    if (source != out) operand = source;
+  }
+  if (!operand) return "";
+  auto& out_shape     = shape_dict.at(out->id());
+  auto& operand_shape = shape_dict.at(operand->id());
+  if (!has_bias) {
+    int axis = -1;
+    if (op_node->attrs.attr_store.count("axis")) axis = absl::get<int>(op_node->attrs.attr_store.at("axis"));
+    if (axis < 0) axis = out_shape.size() - 1;
+    bool is_bias = operand_shape.size() == 1 && axis == channel_axis && operand_shape[0] == out_shape[channel_axis];
+    return is_bias ? "bias" : "";
+  }
+  return !has_residual && operand_shape == out_shape ? "residual" : "";
+}
+
+// Attach the bias add, residual add and relu after a conv2d run by cudnn or a mul run by cublas to the group of the
+// library call, so they run as its epilogue instead of separate kernels. The epilogue is recorded in the attribute
+// "library_epilogue" of the library op, and the group is moved to the position of the last group it absorbs.
+void FuseLibraryEpilogues(Graph* graph) {
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, framework::shape_t>>("infershape");
+  auto& dtype_dict = graph->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  auto& groups     = graph->groups;
+  absl::flat_hash_map<Node*, int> group_of;
+  for (int i = 0; i < groups.size(); i++) {
+    for (auto* node : groups[i]) group_of[node] = i;
+  }
+  // the group each group is merged into, a library group with an epilogue is merged into itself, and the position each
+  // merged group is placed at
+  std::vector<int> merged_into(groups.size(), -1);
+  absl::flat_hash_map<int, int> placed_at;
+  for (int i = 0; i < groups.size(); i++) {
+    if (groups[i].size() != 1 || merged_into[i] >= 0) continue;
+    auto* node       = groups[i][0];
+    auto& attr_store = node->attrs.attr_store;
+    int channel_axis = -1;
+    if (node->op()->name == "conv2d") {
+      auto get_str_attr = [&](const std::string& key, const std::string& default_value) {
+        return attr_store.count(key) ? absl::get<std::string>(attr_store.at(key)) : default_value;
+      };
+      if (get_str_attr("conv_type", "forward") == "forward") {
+        auto data_format = get_str_attr("data_format", "NCHW");
+        channel_axis     = data_format == "NCHW" ? 1 : (data_format == "NHWC" ? 3 : -1);
+      }
+    } else if (node->op()->name == "mul") {
+      // the tiny muls run the unrolled kernels of pe::MatmulSmall rather than cuBLAS
+      auto& inlinks = node->inlinks_in_order();
+      auto get_int  = [&](const std::string& key) {
+        return attr_store.count(key) ? absl::get<int>(attr_store.at(key)) : 1;
+      };
+      if (inlinks.size() != 2 || !pe::UseSmallMul(shape_dict.at(inlinks[0]->source()->id()),
+                                                  shape_dict.at(inlinks[1]->source()->id()),
+                                                  get_int("x_num_col_dims"),
+                                                  get_int("y_num_col_dims"))) {
+        channel_axis = 1;
+      }
+    }
+    if (channel_axis < 0 || node->outlinks_in_order(true).empty()) continue;
+    auto* out = node->outlinks_in_order().front()->sink()->safe_as<NodeData>();
+    if (dtype_dict.at(out->id()) != Float(32)) continue;
+    if (node->op()->name == "mul" && shape_dict.at(out->id()).size() != 2) continue;
+    std::vector<std::string> epilogue;
+    std::vector<Node*> chain;
+    while (auto* reader = GetOnlyReader(graph, out)) {
+      if (merged_into[group_of.at(reader)] >= 0) break;
+      auto kind = GetEpilogueKind(reader, out, channel_axis, epilogue, shape_dict);
+      if (kind.empty()) break;
+      epilogue.push_back(kind);
+      chain.push_back(reader);
+      out = reader->outlinks_in_order(true).front()->sink()->safe_as<NodeData>();
+    }
+    // the epilogue ops are already fused by the pattern rules, only attach the groups consisting of them entirely
+    std::vector<int> absorbed;
+    while (!chain.empty()) {
+      absl::flat_hash_map<int, int> covered;
+      for (auto* reader : chain) covered[group_of.at(reader)]++;
+      bool is_whole = std::all_of(covered.begin(), covered.end(), [&](const std::pair<const int, int>& it) {
+        return groups[it.first].size() == it.second;
+      });
+      if (is_whole) {
+        for (auto& it : covered) absorbed.push_back(it.first);
+        break;
+      }
+      chain.pop_back();
+      epilogue.pop_back();
+    }
+    if (chain.empty()) continue;
+    VLOG(2) << "attach the epilogue " << utils::Join(epilogue, ", ") << " to " << node->id();
+    attr_store["library_epilogue"] = epilogue;
+    groups[i].insert(groups[i].end(), chain.begin(), chain.end());
+    for (int j : absorbed) merged_into[j] = i;
+    int last_absorbed        = *std::max_element(absorbed.begin(), absorbed.end());
+    merged_into[i]         = i;
+    placed_at[last_absorbed] = i;
+  }
+  if (placed_at.empty()) return;
+  std::vector<std::vector<Node*>> new_groups;
+  for (int i = 0; i < groups.size(); i++) {
+    if (placed_at.count(i)) {
+      new_groups.push_back(std::move(groups[placed_at.at(i)]));
+    } else if (merged_into[i] < 0) {
+      new_groups.push_back(std::move(groups[i]));
+    }
+  }
+  groups = std::move(new_groups);
+}
+#endif
+
 void OpFusionPass(Graph* graph) {
   auto store_nodes = std::get<0>(graph->topological_order());
   int node_size    = store_nodes.size();
@@ -518,8 +749,17 @@ void OpFusionPass(Graph* graph) {
   auto& dom_nodes = tree.CreatePostDomTree(store_nodes);
   // graph partition
   auto& shape_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, framework::shape_t>>("infershape");
-  GraphPartition partition(shape_dict);
-  graph->groups = partition.Partition(store_nodes, dom_nodes);
+  auto* dtype_dict =
+      graph->HasAttr("inferdtype") ? &graph->GetAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype") : nullptr;
+  GraphPartition partition(shape_dict, dtype_dict, graph->target_);
+  if (graph->HasAttr("unfused_nodes")) {
+    partition.set_unfused_nodes(&graph->GetAttrs<absl::flat_hash_set<std::string>>("unfused_nodes"));
+  }
+  graph->groups                    = partition.Partition(store_nodes, dom_nodes);
+  graph->attrs["fusion_decisions"] = std::make_shared<absl::any>(partition.decisions());
+#ifdef CINN_WITH_CUDNN
+  if (graph->target_.arch == common::Target::Arch::NVGPU) FuseLibraryEpilogues(graph);
+#endif
 }
 
 }  // namespace pass
@@ -528,8 +768,11 @@ void OpFusionPass(Graph* graph) {
 
 CINN_REGISTER_HELPER(OpFusion) {
   CINN_REGISTER_PASS(OpFusion)
-      .describe("This pass traverse the graph and fuse all ops.")
+      .describe(
+          "This pass traverse the graph and fuse all ops except the ones in g.attrs[\"unfused_nodes\"], and save the "
+          "explanation of each fusion decision to g.attrs[\"fusion_decisions\"].")
       .set_change_structure(false)
+      .provide_graph_attr("fusion_decisions")
       .set_body(cinn::hlir::pass::OpFusionPass);
 
   return true;
@@ -17,11 +17,13 @@
 #include <memory>
 
 #include "cinn/cinn.h"
+#include "cinn/frontend/net_builder.h"
 #include "cinn/frontend/syntax.h"
 #include "cinn/hlir/framework/graph.h"
 #include "cinn/hlir/framework/graph_compiler.h"
 #include "cinn/hlir/framework/pass.h"
 #include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/fusion_cost_model.h"
 #include "cinn/hlir/pass/use_pass.h"
 
 DEFINE_string(model_dir, "", "");
@@ -562,5 +564,321 @@ TEST(conv_bn, conv_bn) {
   runtime_program->Execute();
 }
 
+// relu+reduce_sum+scale
+TEST(fuse_reduce_epilogue, fuse_reduce_epilogue) {
+  Placeholder A(Float(32), {32, 64}, "A");
+
+  Program program;
+  auto b = program.relu(A);
+  auto c = program.reduce_sum(b, {1});
+  auto d = program.scale(c, {{"scale", 0.5f}});
+
+  Target target = GetTarget();
+  program.SetInputs({A});
+  program.Validate();
+  LOG(INFO) << "Program:\n" << program;
+  auto graph = std::make_shared<hlir::framework::Graph>(program, target);
+
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  auto scope = BuildScope(target, graph);
+  LOG(INFO) << "graph:\n" << graph->Visualize();
+  // the prologue and the epilogue are fused with the reduction.
+  ASSERT_EQ(graph->groups.size(), 1UL);
+
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+
+  auto A1 = scope->GetTensor("A");
+  SetRandData(A1, target);
+  runtime_program->Execute();
+#ifndef CINN_WITH_CUDA
+  auto* a_data = A1->data<float>();
+  auto* d_data = scope->GetTensor(d->id)->data<float>();
+  for (int i = 0; i < 32; i++) {
+    float sum = 0.f;
+    for (int j = 0; j < 64; j++) sum += std::max(a_data[i * 64 + j], 0.f);
+    ASSERT_NEAR(d_data[i], sum * 0.5f, 1e-4);
+  }
+#endif
+}
+
+// relu+reduce_sum of few long rows, which are reduced in two stages on NVGPU
+TEST(fuse_reduce_long_rows, fuse_reduce_long_rows) {
+  Placeholder A(Float(32), {4, 8192}, "A");
+
+  Program program;
+  auto b = program.relu(A);
+  auto c = program.reduce_sum(b, {1});
+
+  Target target = GetTarget();
+  program.SetInputs({A});
+  program.Validate();
+  LOG(INFO) << "Program:\n" << program;
+  auto graph = std::make_shared<hlir::framework::Graph>(program, target);
+
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  auto scope = BuildScope(target, graph);
+  LOG(INFO) << "graph:\n" << graph->Visualize();
+  ASSERT_EQ(graph->groups.size(), 1UL);
+
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+
+  auto A1 = scope->GetTensor("A");
+  SetRandData(A1, target);
+  runtime_program->Execute();
+#ifndef CINN_WITH_CUDA
+  auto* a_data = A1->data<float>();
+  auto* c_data = scope->GetTensor(c->id)->data<float>();
+  for (int i = 0; i < 4; i++) {
+    float sum = 0.f;
+    for (int j = 0; j < 8192; j++) sum += std::max(a_data[i * 8192 + j], 0.f);
+    ASSERT_NEAR(c_data[i], sum, 1e-4 * std::max(1.f, sum));
+  }
+#endif
+}
+
+// reduce_sum+elementwise_mul, the reduced result is broadcast back
+TEST(fuse_reduce_broadcast, fuse_reduce_broadcast) {
+  Placeholder A(Float(32), {32, 64}, "A");
+
+  Program program;
+  auto b = program.reduce_sum(A, {1});
+  auto c = program.elementwise_mul(A, b, 0);
+
+  Target target = GetTarget();
+  program.SetInputs({A});
+  program.Validate();
+  LOG(INFO) << "Program:\n" << program;
+  auto graph = std::make_shared<hlir::framework::Graph>(program, target);
+
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  auto scope = BuildScope(target, graph);
+  LOG(INFO) << "graph:\n" << graph->Visualize();
+  ASSERT_EQ(graph->groups.size(), 1UL);
+
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+
+  auto A1 = scope->GetTensor("A");
+  SetRandData(A1, target);
+  runtime_program->Execute();
+#ifndef CINN_WITH_CUDA
+  auto* a_data = A1->data<float>();
+  auto* c_data = scope->GetTensor(c->id)->data<float>();
+  for (int i = 0; i < 32; i++) {
+    float sum = 0.f;
+    for (int j = 0; j < 64; j++) sum += a_data[i * 64 + j];
+    for (int j = 0; j < 64; j++) ASSERT_NEAR(c_data[i * 64 + j], a_data[i * 64 + j] * sum, 1e-3);
+  }
+#endif
+}
+
+// the mean of layer_norm is read as well as its output, as the saved statistics read by the backward ops
+TEST(multi_output_read, layer_norm) {
+  NetBuilder builder("net_builder");
+  auto x       = builder.CreateInput(Float(32), {8, 32}, "X");
+  auto scale   = builder.CreateInput(Float(32), {32}, "Scale");
+  auto bias    = builder.CreateInput(Float(32), {32}, "Bias");
+  auto outs    = builder.layer_norm(x, scale, bias);
+  builder.relu(outs[0]);
+  auto mean_2  = builder.scale(outs[1], 2.f);
+  auto program = builder.Build();
+
+  Target target = GetTarget();
+  auto graph    = std::make_shared<hlir::framework::Graph>(program, target);
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  // layer_norm is the boundary of the fusion, its readers are each a group
+  ASSERT_EQ(graph->groups.size(), 3UL);
+  for (auto& group : graph->groups) ASSERT_EQ(group.size(), 1UL);
+
+  auto scope = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  for (auto name : {"X", "Scale", "Bias"}) SetRandData(scope->GetTensor(name), target);
+  runtime_program->Execute();
+#ifndef CINN_WITH_CUDA
+  auto* x_data      = scope->GetTensor("X")->data<float>();
+  auto* mean_2_data = scope->GetTensor(mean_2->id)->data<float>();
+  for (int i = 0; i < 8; i++) {
+    float sum = 0.f;
+    for (int j = 0; j < 32; j++) sum += x_data[i * 32 + j];
+    ASSERT_NEAR(mean_2_data[i], sum / 32 * 2, 1e-4);
+  }
+#endif
+}
+
+// relu_grad+elementwise_add_grad, the backward chain of add+relu is fused into one group
+TEST(fuse_backward, relu_grad_add_grad) {
+  NetBuilder builder("net_builder");
+  auto x     = builder.CreateInput(Float(32), {32, 64}, "X");
+  auto y     = builder.CreateInput(Float(32), {32, 64}, "Y");
+  auto out   = builder.CreateInput(Float(32), {32, 64}, "Out");
+  auto dout  = builder.CreateInput(Float(32), {32, 64}, "DOut");
+  auto d_add = builder.relu_grad(dout, out);
+  builder.elementwise_add_grad(d_add, x, y);
+  auto program = builder.Build();
+
+  Target target = GetTarget();
+  auto graph    = std::make_shared<hlir::framework::Graph>(program, target);
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  LOG(INFO) << "graph:\n" << graph->Visualize();
+  ASSERT_EQ(graph->groups.size(), 1UL);
+  ASSERT_EQ(graph->groups[0].size(), 2UL);
+}
+
+class NoFusionCostModel : public hlir::pass::FusionCostModel {
+ public:
+  hlir::pass::FusionDecision Decide(const hlir::pass::FusionCandidate& candidate) const override {
+    hlir::pass::FusionDecision decision;
+    decision.cost   = Estimate(candidate);
+    decision.fuse   = false;
+    decision.reason = "fusion disabled";
+    return decision;
+  }
+};
+
+// a legal fusion is not done if the installed cost model rejects it
+TEST(fusion_cost_model, custom_model) {
+  Placeholder A(Float(32), {32, 64}, "A");
+  Placeholder B(Float(32), {32, 64}, "B");
+
+  Program program;
+  auto c = program.add(A, B);
+  auto d = program.relu(c);
+
+  Target target = GetTarget();
+  program.SetInputs({A, B});
+  program.Validate();
+
+  auto graph = std::make_shared<hlir::framework::Graph>(program, target);
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  ASSERT_EQ(graph->groups.size(), 1UL);
+  auto& decisions = graph->GetAttrs<std::vector<std::string>>("fusion_decisions");
+  ASSERT_EQ(decisions.size(), 1UL);
+  LOG(INFO) << decisions[0];
+  // c is computed inline: its write and its read are saved.
+  ASSERT_NE(decisions[0].find("bytes_saved 16384"), std::string::npos);
+
+  hlir::pass::FusionCostModel::SetGlobal(std::make_shared<NoFusionCostModel>());
+  graph = std::make_shared<hlir::framework::Graph>(program, target);
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  hlir::pass::FusionCostModel::SetGlobal(nullptr);
+  ASSERT_EQ(graph->groups.size(), 2UL);
+  ASSERT_NE(graph->GetAttrs<std::vector<std::string>>("fusion_decisions")[0].find("not fuse"), std::string::npos);
+
+  auto scope = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  SetRandData(scope->GetTensor("A"), target);
+  SetRandData(scope->GetTensor("B"), target);
+  runtime_program->Execute();
+}
+
+#ifndef CINN_WITH_CUDA
+// the relu of the small bias is recomputed for every element of the large add, which costs more than it saves on x86
+TEST(fusion_cost_model, broadcast_recompute) {
+  Placeholder A(Float(32), {1, 64, 112, 112}, "A");
+  Placeholder B(Float(32), {64}, "B");
+
+  Program program;
+  auto c = program.relu(B);
+  auto d = program.elementwise_add(A, c, 1);
+
+  Target target = GetTarget();
+  program.SetInputs({A, B});
+  program.Validate();
+
+  auto graph = std::make_shared<hlir::framework::Graph>(program, target);
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  ASSERT_EQ(graph->groups.size(), 2UL);
+  auto& decisions = graph->GetAttrs<std::vector<std::string>>("fusion_decisions");
+  ASSERT_EQ(decisions.size(), 1UL);
+  LOG(INFO) << decisions[0];
+  ASSERT_NE(decisions[0].find("not fuse"), std::string::npos);
+}
+#endif
+
+#ifdef CINN_WITH_CUDNN
+// run the program on the same random inputs, and return the data of the output
+std::vector<float> RunProgram(const Program& program,
+                              const std::vector<std::string>& input_names,
+                              const std::string& output_name,
+                              bool with_fusion,
+                              size_t* num_groups) {
+  Target target = GetTarget();
+  auto graph    = std::make_shared<hlir::framework::Graph>(program, target);
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  if (with_fusion) hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  *num_groups = graph->groups.size();
+  auto scope  = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  srand(0);
+  for (auto& name : input_names) SetRandData(scope->GetTensor(name), target);
+  runtime_program->Execute();
+  auto out = scope->GetTensor(output_name);
+  std::vector<float> data(out->shape().numel());
+  CUDA_CALL(cudaMemcpy(data.data(), out->data<float>(), data.size() * sizeof(float), cudaMemcpyDeviceToHost));
+  return data;
+}
+
+// conv+add+add+relu, the bias add, residual add and relu run by cudnnConvolutionBiasActivationForward
+TEST(library_epilogue, conv_bias_residual_relu) {
+  Placeholder A(Float(32), {1, 3, 32, 32}, "A");
+  Placeholder W(Float(32), {8, 3, 3, 3}, "W");
+  Placeholder Bias(Float(32), {8}, "Bias");
+  Placeholder R(Float(32), {1, 8, 32, 32}, "R");
+
+  Program program;
+  absl::flat_hash_map<std::string, Program::attr_t> attrs;
+  attrs["stride"]   = std::vector<int>({1, 1});
+  attrs["dilation"] = std::vector<int>({1, 1});
+  attrs["padding"]  = std::vector<int>({1, 1});
+  auto c            = program.conv2d(A, W, attrs);
+  auto d            = program.elementwise_add(c, Bias, 1);
+  auto e            = program.elementwise_add(d, R);
+  auto f            = program.relu(e);
+  program.SetInputs({A, W, Bias, R});
+  program.Validate();
+
+  size_t num_groups = 0;
+  auto expected     = RunProgram(program, {"A", "W", "Bias", "R"}, f->id, false, &num_groups);
+  auto actual       = RunProgram(program, {"A", "W", "Bias", "R"}, f->id, true, &num_groups);
+  ASSERT_EQ(num_groups, 1UL);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (int i = 0; i < actual.size(); i++) ASSERT_NEAR(actual[i], expected[i], 1e-3);
+}
+
+// mul+add+relu, the bias add and relu run as the epilogue of cublasLtMatmul
+TEST(library_epilogue, mul_bias_relu) {
+  Placeholder A(Float(32), {16, 32}, "A");
+  Placeholder B(Float(32), {64, 32}, "B");
+  Placeholder Bias(Float(32), {64}, "Bias");
+
+  Program program;
+  auto c = program.mul(A, B);
+  auto d = program.elementwise_add(c, Bias);
+  auto e = program.relu(d);
+  program.SetInputs({A, B, Bias});
+  program.Validate();
+
+  size_t num_groups = 0;
+  auto expected     = RunProgram(program, {"A", "B", "Bias"}, e->id, false, &num_groups);
+  auto actual       = RunProgram(program, {"A", "B", "Bias"}, e->id, true, &num_groups);
+  ASSERT_EQ(num_groups, 1UL);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (int i = 0; i < actual.size(); i++) ASSERT_NEAR(actual[i], expected[i], 1e-3);
+}
+#endif
+
 }  // namespace frontend
 }  // namespace cinn
@@ -0,0 +1,171 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+using common::Type;
+using framework::Graph;
+using framework::Node;
+using framework::NodeData;
+using framework::Operator;
+using framework::shape_t;
+
+namespace {
+
+// The int8 values are symmetric in [-127, 127], so the scale of a var is its range divided by 127.
+constexpr float kInt8Max = 127.f;
+
+// The muls with the ranges of both inputs are rewritten to quantized_mul reading the int8 quantizations of the inputs.
+// The products are accumulated in int32 and dequantized to float32 by the product of the two scales inside the
+// quantized_mul, so the float32 output and its readers are kept as they are. The weights are const, and their
+// quantizations run once before the others by ConstPropagate.
+class QuantizationRewriter {
+ public:
+  QuantizationRewriter(Graph* graph, const absl::flat_hash_map<std::string, float>& ranges)
+      : graph_(graph),
+        ranges_(ranges),
+        shape_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape")),
+        type_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype")) {}
+
+  int Run() {
+    auto store_nodes = std::get<0>(graph_->topological_order());
+    for (auto* graph_node : store_nodes) {
+      auto* node = graph_node->safe_as<Node>();
+      if (node && node->op()->name == "mul" && CanQuantize(node)) Quantize(node);
+    }
+    return num_rewritten_;
+  }
+
+ private:
+  Graph* graph_;
+  const absl::flat_hash_map<std::string, float>& ranges_;
+  absl::flat_hash_map<std::string, shape_t>& shape_dict_;
+  absl::flat_hash_map<std::string, Type>& type_dict_;
+  // The int8 quantization of each float32 var, shared by all the quantized_muls reading it.
+  absl::flat_hash_map<std::string, NodeData*> int8_vars_;
+  int num_rewritten_{0};
+
+  static std::vector<NodeData*> Inputs(Node* node) {
+    std::vector<NodeData*> inputs;
+    for (auto& link : node->inlinks_in_order(true)) inputs.push_back(link->source()->safe_as<NodeData>());
+    return inputs;
+  }
+
+  static std::vector<NodeData*> Outputs(Node* node) {
+    std::vector<NodeData*> outputs;
+    for (auto& link : node->outlinks_in_order(true)) outputs.push_back(link->sink()->safe_as<NodeData>());
+    return outputs;
+  }
+
+  float Scale(NodeData* var) const { return ranges_.at(var->id()) / kInt8Max; }
+
+  bool CanQuantize(Node* node) const {
+    auto inputs = Inputs(node);
+    if (inputs.size() != 2) return false;
+    // only the weights are quantized offline, a mul of two activations is kept in float32
+    if (!inputs[1]->is_const()) return false;
+    for (auto* var : inputs) {
+      if (type_dict_.at(var->id()) != Float(32)) return false;
+      auto range = ranges_.find(var->id());
+      if (range == ranges_.end() || range->second <= 0.f) return false;
+    }
+    return true;
+  }
+
+  NodeData* GetInt8Var(NodeData* var) {
+    auto it = int8_vars_.find(var->id());
+    if (it != int8_vars_.end()) return it->second;
+    std::shared_ptr<Node> quantize(
+        new Node(Operator::Get("quantize"), "quantize", common::UniqName("quantize_" + var->id())));
+    quantize->attrs.attr_store["scale"] = Scale(var);
+    graph_->RegisterNode(quantize->id(), quantize.get());
+    auto* out = new NodeData(quantize, 0, 0, common::UniqName(var->id() + "_int8"));
+    graph_->RegisterNode(out->id(), out);
+    shape_dict_[out->id()] = shape_dict_.at(var->id());
+    type_dict_[out->id()]  = Int(8);
+    var->LinkTo(quantize.get());
+    quantize->LinkTo(out);
+    int8_vars_[var->id()] = out;
+    return out;
+  }
+
+  void Quantize(Node* node) {
+    VLOG(3) << "Quantize " << node->id() << " to int8";
+    auto inputs = Inputs(node);
+    float scale = Scale(inputs[0]) * Scale(inputs[1]);
+    for (auto* input : inputs) input->UnLinkTo(node);
+    for (auto* input : inputs) GetInt8Var(input)->LinkTo(node);
+    node->inlinks_in_order(true);
+
+    auto& attr_store = node->attrs.attr_store;
+    absl::flat_hash_map<std::string, framework::AttrType> attrs;
+    for (std::string name : {"x_num_col_dims", "y_num_col_dims"}) {
+      if (attr_store.count(name)) attrs[name] = attr_store.at(name);
+    }
+    attrs["scale"]        = scale;
+    attr_store            = std::move(attrs);
+    node->attrs.op        = Operator::Get("quantized_mul");
+    node->attrs.node_name = "quantized_mul";
+
+    // the second output is the int32 accumulation instead of the temporary of the float32 mul
+    auto outputs                  = Outputs(node);
+    shape_dict_[outputs[1]->id()] = shape_dict_.at(outputs[0]->id());
+    type_dict_[outputs[1]->id()]  = Int(32);
+    num_rewritten_++;
+  }
+};
+
+}  // namespace
+
+void QuantizationPass(Graph* graph) {
+  // quantized_mul is only implemented on X86 now
+  if (graph->target_.arch != Target::Arch::X86) return;
+  if (!graph->HasAttr("calibration_ranges")) {
+    LOG(WARNING) << "No calibration ranges in the graph, skip the quantization";
+    return;
+  }
+  auto& ranges      = graph->GetAttrs<absl::flat_hash_map<std::string, float>>("calibration_ranges");
+  int num_rewritten = QuantizationRewriter(graph, ranges).Run();
+  VLOG(3) << "Quantization rewrites " << num_rewritten << " muls to int8";
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(Quantization) {
+  CINN_REGISTER_PASS(Quantization)
+      .describe(
+          "This pass rewrites the muls with const weights to quantized_mul on the int8 quantizations of their inputs, "
+          "by the ranges collected by the Calibrator in the graph attribute \"calibration_ranges\", only on X86 now. "
+          "The int8 products are accumulated in int32 and dequantized to float32 in the same kernel. It should be "
+          "applied after InferShape and before ConstPropagate, so that the quantizations of the weights run once "
+          "before the others.")
+      .set_change_structure(true)
+      .provide_graph_attr("infershape")
+      .provide_graph_attr("inferdtype")
+      .set_body(cinn::hlir::pass::QuantizationPass);
+  return true;
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "cinn/cinn.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/calibrator.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/test_helper.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace frontend {
+
+using hlir::framework::Calibrator;
+using hlir::framework::Graph;
+using hlir::framework::Node;
+using hlir::framework::Scope;
+using hlir::pass::CountOps;
+using hlir::pass::Fill;
+using hlir::pass::RandomData;
+
+// mul with a const weight runs in int8 by the calibrated ranges, and stays close to the float32 results
+TEST(Quantization, mul) {
+  const int M = 16, N = 24, K = 64;
+  Placeholder A(Float(32), {M, K}, "A");
+  Placeholder B(Float(32), {N, K}, "B", true);
+
+  Program program;
+  auto c = program.mul(A, B, 1, 1);
+  auto d = program.relu(c);
+  program.SetInputs({A, B});
+  program.Validate();
+
+  Target target = common::DefaultHostTarget();
+  auto weight   = RandomData(N * K, 0);
+  Calibrator calibrator(program, target);
+  Fill(calibrator.scope(), "B", weight, target);
+  for (int i = 0; i < 4; i++) {
+    Fill(calibrator.scope(), "A", RandomData(M * K, i + 1), target);
+    calibrator.Run();
+  }
+
+  auto graph = std::make_shared<Graph>(program, target);
+  calibrator.AttachRanges(graph.get());
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "Quantization");
+  ASSERT_EQ(CountOps(*graph, "mul"), 0);
+  ASSERT_EQ(CountOps(*graph, "quantized_mul"), 1);
+  ASSERT_EQ(CountOps(*graph, "quantize"), 2);
+  hlir::framework::ApplyPass(graph.get(), "ConstPropagate");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+
+  auto scope = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  auto input           = RandomData(M * K, 1);
+  Fill(scope.get(), "A", input, target);
+  Fill(scope.get(), "B", weight, target);
+  runtime_program->PrePack();
+  runtime_program->Execute();
+
+  auto out   = scope->GetTensor(d->id);
+  auto* data = out->data<float>();
+  ASSERT_EQ(out->shape().numel(), M * N);
+  // each int8 value is off by at most half a step, and the errors of the K products mostly cancel out
+  for (int m = 0; m < M; m++) {
+    for (int n = 0; n < N; n++) {
+      float expected = 0.f;
+      for (int k = 0; k < K; k++) expected += input[m * K + k] * weight[n * K + k];
+      expected = std::max(expected, 0.f);
+      ASSERT_NEAR(data[m * N + n], expected, 0.1f) << "at " << m << ", " << n;
+    }
+  }
+}
+
+// mul of two activations and mul without the ranges are kept in float32
+TEST(Quantization, skip) {
+  Placeholder A(Float(32), {4, 8}, "A");
+  Placeholder B(Float(32), {6, 8}, "B");
+  Placeholder W(Float(32), {6, 8}, "W", true);
+
+  Program program;
+  auto c = program.mul(A, B, 1, 1);
+  auto d = program.mul(A, W, 1, 1);
+  program.add(c, d);
+  program.SetInputs({A, B, W});
+  program.Validate();
+
+  Target target = common::DefaultHostTarget();
+  auto graph    = std::make_shared<Graph>(program, target);
+  absl::flat_hash_map<std::string, float> ranges = {{"A", 1.f}, {"B", 1.f}};
+  graph->attrs["calibration_ranges"]             = std::make_shared<absl::any>(ranges);
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "Quantization");
+  ASSERT_EQ(CountOps(*graph, "mul"), 2);
+  ASSERT_EQ(CountOps(*graph, "quantize"), 0);
+}
+
+}  // namespace frontend
+}  // namespace cinn
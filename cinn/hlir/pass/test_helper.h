@@ -0,0 +1,70 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cinn/common/target.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/scope.h"
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+//! The number of the ops of \p op_type in the graph.
+inline int CountOps(const framework::Graph& graph, const std::string& op_type) {
+  auto nodes = graph.nodes();
+  return std::count_if(nodes.begin(), nodes.end(), [&](const common::GraphNode* node) {
+    auto* op_node = node->safe_as<framework::Node>();
+    return op_node && op_node->op()->name == op_type;
+  });
+}
+
+//! The number of the op nodes in the graph.
+inline int CountOpNodes(const framework::Graph& graph) {
+  auto nodes = graph.nodes();
+  return std::count_if(
+      nodes.begin(), nodes.end(), [](const common::GraphNode* node) { return node->safe_as<framework::Node>(); });
+}
+
+//! The values uniform in [-1, 1) generated by \p seed.
+inline std::vector<float> RandomData(int numel, int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  std::vector<float> data(numel);
+  for (auto& v : data) v = dist(rng);
+  return data;
+}
+
+//! Copy \p values to the float tensor \p name in scope, which should be on the host.
+inline void Fill(framework::Scope* scope,
+                 const std::string& name,
+                 const std::vector<float>& values,
+                 const common::Target& target) {
+  auto tensor = scope->GetTensor(name);
+  ASSERT_EQ(tensor->shape().numel(), values.size());
+  std::copy(values.begin(), values.end(), tensor->mutable_data<float>(target));
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,334 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+using common::GraphNode;
+using common::Type;
+using framework::Graph;
+using framework::Node;
+using framework::NodeData;
+using framework::Operator;
+using framework::shape_t;
+
+namespace {
+
+// The indices of the dims larger than 1, which decide the order of the data in memory.
+std::vector<int> NonUnitDims(const shape_t& shape) {
+  std::vector<int> dims;
+  for (int i = 0; i < shape.size(); i++) {
+    if (shape[i] != 1) dims.push_back(i);
+  }
+  return dims;
+}
+
+// Whether the reshape only inserts or removes the dims of size 1, so the dims larger than 1 keep their order.
+bool IsUnitReshape(const shape_t& in_shape, const shape_t& out_shape) {
+  auto in_dims  = NonUnitDims(in_shape);
+  auto out_dims = NonUnitDims(out_shape);
+  if (in_dims.size() != out_dims.size()) return false;
+  for (int i = 0; i < in_dims.size(); i++) {
+    if (in_shape[in_dims[i]] != out_shape[out_dims[i]]) return false;
+  }
+  return true;
+}
+
+class TransformCanceller {
+ public:
+  explicit TransformCanceller(Graph* graph)
+      : graph_(graph),
+        shape_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape")),
+        type_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype")),
+        outputs_(graph->outputs.begin(), graph->outputs.end()) {}
+
+  int Run() {
+    auto store_nodes = std::get<0>(graph_->topological_order());
+    for (auto* graph_node : store_nodes) {
+      auto* node = graph_node->safe_as<Node>();
+      // the nodes already dropped as a part of the chains after them
+      if (!node || node->inlinks().empty()) continue;
+      auto& op_name = node->op()->name;
+      if (op_name == "layout_transform") {
+        CancelLayoutTransforms(node);
+      } else if (op_name == "reshape" || op_name == "transpose") {
+        SimplifyChain(node);
+      }
+    }
+    return num_changed_;
+  }
+
+ private:
+  Graph* graph_;
+  absl::flat_hash_map<std::string, shape_t>& shape_dict_;
+  absl::flat_hash_map<std::string, Type>& type_dict_;
+  std::unordered_set<GraphNode*> outputs_;
+  int num_changed_{0};
+
+  static NodeData* Input(Node* node) { return node->inlinks_in_order(true)[0]->source()->safe_as<NodeData>(); }
+  static NodeData* Output(Node* node) { return node->outlinks_in_order(true)[0]->sink()->safe_as<NodeData>(); }
+
+  const shape_t& Shape(NodeData* var) const { return shape_dict_.at(var->id()); }
+
+  // The op producing the var, null for the inputs of the graph.
+  static Node* Producer(NodeData* var) { return var->source_node.get(); }
+
+  // Whether the var only passes the data from its producer to one reader, so the producer can be dropped when the
+  // reader doesn't read it any more.
+  bool IsInternal(NodeData* var) const { return var->outlinks().size() == 1 && !outputs_.count(var); }
+
+  // Whether the node is a transpose, or a reshape only inserting or removing the dims of size 1.
+  bool IsLayoutOnly(Node* node) const {
+    if (node->op()->name == "transpose") return true;
+    return node->op()->name == "reshape" && IsUnitReshape(Shape(Input(node)), Shape(Output(node)));
+  }
+
+  static void SetInput(Node* node, NodeData* var) {
+    Input(node)->UnLinkTo(node);
+    var->LinkTo(node);
+    node->inlinks_in_order(true);
+  }
+
+  static void Unlink(Node* node) {
+    std::vector<GraphNode*> sources, sinks;
+    for (auto& link : node->inlinks()) sources.push_back(link->source());
+    for (auto& link : node->outlinks()) sinks.push_back(link->sink());
+    for (auto* source : sources) source->UnLinkTo(node);
+    for (auto* sink : sinks) node->UnLinkTo(sink);
+  }
+
+  static void ToReshape(Node* node, const shape_t& shape) {
+    node->attrs.op        = Operator::Get("reshape");
+    node->attrs.node_name = "reshape";
+    node->attrs.attr_store.clear();
+    node->attrs.attr_store["shape"] = shape;
+  }
+
+  static void ToTranspose(Node* node, const std::vector<int>& axis) {
+    node->attrs.op        = Operator::Get("transpose");
+    node->attrs.node_name = "transpose";
+    node->attrs.attr_store.clear();
+    node->attrs.attr_store["axis"] = axis;
+  }
+
+  // Add a transpose reading the var before the node.
+  NodeData* AddTranspose(NodeData* var, const std::vector<int>& axis, Node* node) {
+    auto* trans_node = new Node(Operator::Get("transpose"), "transpose", common::UniqName(node->id() + "_transpose"));
+    trans_node->attrs.attr_store["axis"] = axis;
+    std::shared_ptr<Node> node_ptr(trans_node);
+    auto* out = new NodeData(node_ptr, 0, 0, common::UniqName(trans_node->id() + "_out"));
+    var->LinkTo(trans_node);
+    trans_node->LinkTo(out);
+    graph_->RegisterNode(trans_node->id(), trans_node);
+    graph_->RegisterNode(out->id(), out);
+    shape_t shape;
+    for (int i : axis) shape.push_back(Shape(var)[i]);
+    shape_dict_[out->id()] = shape;
+    type_dict_[out->id()]  = type_dict_.at(var->id());
+    return out;
+  }
+
+  // The node copies its input without any change, let the readers read the input instead. The output fetched by name
+  // or read by an op already reading the input is kept, by a reshape which runs as a view of the input.
+  void DropIdentity(Node* node) {
+    auto* in       = Input(node);
+    auto* out      = Output(node);
+    bool droppable = !outputs_.count(out) && !out->outlinks().empty();
+    for (auto& link : out->outlinks()) {
+      if (in->IsLinkedTo(link->sink())) droppable = false;
+    }
+    if (!droppable) {
+      if (node->op()->name != "reshape") ToReshape(node, Shape(out));
+      return;
+    }
+    VLOG(3) << "Drop " << node->id() << " copying " << in->id() << " to " << out->id();
+    std::vector<GraphNode*> readers;
+    for (auto& link : out->outlinks()) readers.push_back(link->sink());
+    for (auto* reader : readers) {
+      auto* reader_node = reader->safe_as<Node>();
+      CHECK(reader_node);
+      // unlink and relink afterwards to keep the order of the inputs
+      std::vector<GraphNode*> sources;
+      for (auto& link : reader_node->inlinks_in_order(true)) sources.push_back(link->source());
+      for (auto* source : sources) source->UnLinkTo(reader);
+      for (auto* source : sources) (source == out ? in : source)->LinkTo(reader);
+      reader_node->inlinks_in_order(true);
+    }
+    Unlink(node);
+  }
+
+  // Two layout_transforms converting back to the source layout cancel each other.
+  void CancelLayoutTransforms(Node* node) {
+    auto* mid      = Input(node);
+    auto* producer = Producer(mid);
+    if (!producer || producer->op()->name != "layout_transform") return;
+    auto layout = [](Node* n, const std::string& key) {
+      auto& attrs = n->attrs.attr_store;
+      return attrs.count(key) ? absl::get<std::string>(attrs.at(key)) : std::string();
+    };
+    if (layout(producer, "src_layout") != layout(node, "dst_layout") ||
+        layout(producer, "dst_layout") != layout(node, "src_layout")) {
+      return;
+    }
+    auto* in = Input(producer);
+    if (Shape(in) != Shape(Output(node))) return;
+    SetInput(node, in);
+    if (mid->outlinks().empty() && !outputs_.count(mid)) Unlink(producer);
+    DropIdentity(node);
+    num_changed_++;
+  }
+
+  void SimplifyChain(Node* node) {
+    auto* out = Output(node);
+    // a reshape of a reshape reshapes the first input directly
+    if (node->op()->name == "reshape") {
+      auto* mid      = Input(node);
+      auto* producer = Producer(mid);
+      if (producer && producer->op()->name == "reshape") {
+        SetInput(node, Input(producer));
+        node->attrs.attr_store["shape"] = Shape(out);
+        if (mid->outlinks().empty() && !outputs_.count(mid)) Unlink(producer);
+        num_changed_++;
+      }
+      if (Shape(Input(node)) == Shape(out)) {
+        DropIdentity(node);
+        return;
+      }
+    }
+    if (!IsLayoutOnly(node)) return;
+
+    // the chain of the layout only nodes ending at the node, whose intermediate vars are read by the chain only
+    std::vector<Node*> chain{node};
+    while (true) {
+      auto* var      = Input(chain.back());
+      auto* producer = Producer(var);
+      if (!producer || !IsInternal(var) || !IsLayoutOnly(producer)) break;
+      chain.push_back(producer);
+    }
+    auto* in           = Input(chain.back());
+    int num_transposes = std::count_if(
+        chain.begin(), chain.end(), [](Node* chain_node) { return chain_node->op()->name == "transpose"; });
+
+    // label each dim of the vars along the chain by which dim larger than 1 of the input it is, -1 for the dims of
+    // size 1, then the labels of the output tell how the chain permutes the data.
+    auto in_dims = NonUnitDims(Shape(in));
+    std::vector<int> labels(Shape(in).size(), -1);
+    for (int i = 0; i < in_dims.size(); i++) labels[in_dims[i]] = i;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+      std::vector<int> new_labels;
+      if ((*it)->op()->name == "transpose") {
+        for (int axis : absl::get<std::vector<int>>((*it)->attrs.attr_store.at("axis"))) {
+          new_labels.push_back(labels[axis]);
+        }
+      } else {
+        std::vector<int> order;
+        for (int label : labels) {
+          if (label >= 0) order.push_back(label);
+        }
+        auto& shape = Shape(Output(*it));
+        new_labels.assign(shape.size(), -1);
+        auto dims = NonUnitDims(shape);
+        for (int i = 0; i < dims.size(); i++) new_labels[dims[i]] = order[i];
+      }
+      labels = new_labels;
+    }
+    auto out_dims = NonUnitDims(Shape(out));
+    std::vector<int> order;
+    for (int dim : out_dims) order.push_back(labels[dim]);
+    bool keeps_order = std::is_sorted(order.begin(), order.end());
+
+    if (keeps_order) {
+      // the chain only changes the shape, which a reshape does as a view
+      if (chain.size() == 1 && node->op()->name == "reshape") return;
+      VLOG(3) << "Replace the chain of " << chain.size() << " nodes ending at " << node->id() << " with a reshape";
+      SetInput(node, in);
+      ToReshape(node, Shape(out));
+    } else if (Shape(in).size() == Shape(out).size()) {
+      if (chain.size() == 1) return;
+      // one transpose moving the dims larger than 1 by the chain and those of size 1 in their order
+      std::vector<int> axis;
+      int next_unit = 0;
+      for (int label : labels) {
+        if (label >= 0) {
+          axis.push_back(in_dims[label]);
+          continue;
+        }
+        while (Shape(in)[next_unit] != 1) next_unit++;
+        axis.push_back(next_unit++);
+      }
+      VLOG(3) << "Replace the chain of " << chain.size() << " nodes ending at " << node->id() << " with a transpose";
+      SetInput(node, in);
+      ToTranspose(node, axis);
+    } else {
+      // a transpose keeping the dims of size 1 in place, followed by a reshape as a view
+      if (num_transposes <= 1 && chain.size() <= 2) return;
+      std::vector<int> axis(Shape(in).size());
+      for (int i = 0; i < axis.size(); i++) axis[i] = i;
+      for (int i = 0; i < in_dims.size(); i++) axis[in_dims[i]] = in_dims[order[i]];
+      VLOG(3) << "Replace the chain of " << chain.size() << " nodes ending at " << node->id()
+              << " with a transpose and a reshape";
+      SetInput(node, AddTranspose(in, axis, node));
+      ToReshape(node, Shape(out));
+    }
+    for (int i = 1; i < chain.size(); i++) Unlink(chain[i]);
+    num_changed_++;
+    if (Shape(Input(node)) == Shape(out) && node->op()->name == "reshape") DropIdentity(node);
+  }
+};
+
+}  // namespace
+
+void TransformCancellationPass(Graph* graph) {
+  int num_changed = TransformCanceller(graph).Run();
+  if (!num_changed) return;
+  auto& shape_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  auto& dtype_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  absl::flat_hash_map<std::string, std::string> layout_dict;
+  auto* layout_dict_ptr = &layout_dict;
+  if (graph->HasAttr("inferlayout")) {
+    layout_dict_ptr = &graph->GetMutableAttrs<absl::flat_hash_map<std::string, std::string>>("inferlayout");
+  }
+  graph->ClearUnlinkedNodes(&shape_dict, &dtype_dict, layout_dict_ptr);
+  VLOG(3) << "TransformCancellation simplified " << num_changed << " nodes";
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(TransformCancellation) {
+  CINN_REGISTER_PASS(TransformCancellation)
+      .describe(
+          "This pass simplifies the chains of transposes and reshapes: the adjacent transposes are composed into one, "
+          "the chains only moving the dims of size 1 become reshapes, the adjacent reshapes are merged, and the "
+          "inverse pairs of transposes or layout_transforms are dropped. The reshapes left are run as views of their "
+          "inputs by GraphCompiler. It should be applied before OpFusion.")
+      .set_change_structure(true)
+      .provide_graph_attr("infershape")
+      .provide_graph_attr("inferdtype")
+      .set_body(cinn::hlir::pass::TransformCancellationPass);
+  return true;
+}
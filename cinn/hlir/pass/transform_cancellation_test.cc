@@ -0,0 +1,160 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "cinn/cinn.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace frontend {
+
+using hlir::framework::Graph;
+using hlir::framework::Node;
+using hlir::framework::Scope;
+
+Target GetTarget() {
+#ifdef CINN_WITH_CUDA
+  return common::DefaultNVGPUTarget();
+#else
+  return common::DefaultHostTarget();
+#endif
+}
+
+std::vector<Node*> GetOpNodes(const Graph& graph) {
+  std::vector<Node*> op_nodes;
+  for (auto* node : std::get<0>(graph.topological_order())) {
+    if (node->safe_as<Node>()) op_nodes.push_back(node->safe_as<Node>());
+  }
+  return op_nodes;
+}
+
+std::shared_ptr<Graph> ApplyTransformCancellation(Program* program, const std::vector<Variable>& inputs) {
+  program->SetInputs(inputs);
+  program->Validate();
+  auto graph = std::make_shared<Graph>(*program, GetTarget());
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "TransformCancellation");
+  LOG(INFO) << "graph:\n" << graph->Visualize();
+  return graph;
+}
+
+// the inverse transposes cancel each other, and relu reads A directly
+TEST(TransformCancellation, inverse_transposes) {
+  Placeholder A(Float(32), {2, 3, 4}, "A");
+  Program program;
+  auto b = program.transpose(A, {1, 2, 0});
+  auto c = program.transpose(b, {2, 0, 1});
+  auto d = program.relu(c);
+
+  auto graph    = ApplyTransformCancellation(&program, {A});
+  auto op_nodes = GetOpNodes(*graph);
+  ASSERT_EQ(op_nodes.size(), 1UL);
+  ASSERT_EQ(op_nodes[0]->op()->name, "relu");
+  ASSERT_EQ(op_nodes[0]->inlinks_in_order(true)[0]->source()->id(), "A");
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, hlir::framework::shape_t>>("infershape");
+  ASSERT_FALSE(shape_dict.count(b->id));
+  ASSERT_FALSE(shape_dict.count(c->id));
+}
+
+// the adjacent transposes are composed into one
+TEST(TransformCancellation, composed_transposes) {
+  Placeholder A(Float(32), {2, 3, 4, 5}, "A");
+  Program program;
+  auto b = program.transpose(A, {0, 2, 1, 3});
+  auto c = program.transpose(b, {0, 1, 3, 2});
+  auto d = program.relu(c);
+
+  auto graph    = ApplyTransformCancellation(&program, {A});
+  auto op_nodes = GetOpNodes(*graph);
+  ASSERT_EQ(op_nodes.size(), 2UL);
+  ASSERT_EQ(op_nodes[0]->op()->name, "transpose");
+  ASSERT_EQ(op_nodes[0]->inlinks_in_order(true)[0]->source()->id(), "A");
+  ASSERT_EQ(absl::get<std::vector<int>>(op_nodes[0]->attrs.attr_store.at("axis")), std::vector<int>({0, 2, 3, 1}));
+  auto& shape_dict = graph->GetAttrs<absl::flat_hash_map<std::string, hlir::framework::shape_t>>("infershape");
+  ASSERT_EQ(shape_dict.at(c->id), std::vector<int>({2, 4, 5, 3}));
+}
+
+// the adjacent reshapes are merged, and the layout_transforms converting back cancel each other
+TEST(TransformCancellation, reshapes_and_layout_transforms) {
+  Placeholder A(Float(32), {4, 32}, "A");
+  Placeholder B(Float(32), {1, 32, 4, 4}, "B");
+  Program program;
+  auto a1 = program.reshape(A, {2, 64});
+  auto a2 = program.reshape(a1, {128});
+  auto a3 = program.relu(a2);
+  auto b1 = program.layout_transform(B, {{"src_layout", std::string("NCHW")}, {"dst_layout", std::string("NCHW16c")}});
+  auto b2 = program.layout_transform(b1, {{"src_layout", std::string("NCHW16c")}, {"dst_layout", std::string("NCHW")}});
+  auto b3 = program.relu(b2);
+
+  auto graph    = ApplyTransformCancellation(&program, {A, B});
+  auto op_nodes = GetOpNodes(*graph);
+  ASSERT_EQ(op_nodes.size(), 3UL);
+  for (auto* node : op_nodes) {
+    if (node->op()->name == "reshape") {
+      ASSERT_EQ(node->inlinks_in_order(true)[0]->source()->id(), "A");
+      ASSERT_EQ(absl::get<std::vector<int>>(node->attrs.attr_store.at("shape")), std::vector<int>({128}));
+    } else {
+      ASSERT_EQ(node->op()->name, "relu");
+    }
+  }
+}
+
+// transpose -> reshape -> transpose only moves the dims of size 1, so it becomes a reshape, which runs as a view of
+// the output of relu without any instruction
+TEST(TransformCancellation, reshape_view) {
+  Placeholder A(Float(32), {4, 1, 8}, "A");
+  Program program;
+  auto b = program.relu(A);
+  auto c = program.transpose(b, {2, 1, 0});
+  auto d = program.reshape(c, {8, 4});
+  auto e = program.transpose(d, {1, 0});
+
+  Target target = GetTarget();
+  auto graph    = ApplyTransformCancellation(&program, {A});
+  auto op_nodes = GetOpNodes(*graph);
+  ASSERT_EQ(op_nodes.size(), 2UL);
+  ASSERT_EQ(op_nodes[1]->op()->name, "reshape");
+  ASSERT_EQ(op_nodes[1]->inlinks_in_order(true)[0]->source()->id(), b->id);
+  ASSERT_EQ(op_nodes[1]->outlinks_in_order(true)[0]->sink()->id(), e->id);
+
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  auto scope = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  ASSERT_EQ(runtime_program->GetRunInstructions().size(), 1UL);
+  ASSERT_TRUE(scope->GetTensor(e->id)->SharesBufferWith(*scope->GetTensor(b->id)));
+
+#ifndef CINN_WITH_CUDA
+  auto* a_data = scope->GetTensor("A")->mutable_data<float>(target);
+  for (int i = 0; i < 32; i++) a_data[i] = i % 2 ? i : -i;
+  runtime_program->Execute();
+  auto* e_data = scope->GetTensor(e->id)->data<float>();
+  for (int i = 0; i < 32; i++) {
+    ASSERT_EQ(e_data[i], std::max(a_data[i], 0.f));
+  }
+#endif
+}
+
+}  // namespace frontend
+}  // namespace cinn
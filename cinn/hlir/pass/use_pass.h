@@ -18,5 +18,16 @@
 
 CINN_USE_REGISTER(InferShape)
 CINN_USE_REGISTER(OpFusion)
+CINN_USE_REGISTER(HorizontalFusion)
+CINN_USE_REGISTER(AllReduceFusion)
 CINN_USE_REGISTER(AlterLayout)
 CINN_USE_REGISTER(ConstPropagate)
+CINN_USE_REGISTER(CommonSubexprElimination)
+CINN_USE_REGISTER(DeadCodeElimination)
+CINN_USE_REGISTER(TransformCancellation)
+CINN_USE_REGISTER(CastSimplification)
+CINN_USE_REGISTER(WeightFolding)
+CINN_USE_REGISTER(AutoMixedPrecision)
+CINN_USE_REGISTER(Quantization)
+CINN_USE_REGISTER(WeightOnlyQuantization)
+CINN_USE_REGISTER(BlockSparseMul)
@@ -0,0 +1,268 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+using common::GraphNode;
+using common::Type;
+using framework::Graph;
+using framework::Node;
+using framework::NodeData;
+using framework::Operator;
+using framework::shape_t;
+
+namespace {
+
+template <typename T>
+T GetAttr(const Node* node, const std::string& key, const T& default_value) {
+  auto& attrs = node->attrs.attr_store;
+  return attrs.count(key) ? absl::get<T>(attrs.at(key)) : default_value;
+}
+
+// The affine ops on the outputs of conv2d and mul are folded into their constant weights, the folded weights are
+// computed by the ops on the constants, which ConstPropagate marks to run once before the others.
+class WeightFolder {
+ public:
+  explicit WeightFolder(Graph* graph)
+      : graph_(graph),
+        shape_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape")),
+        type_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype")) {}
+
+  int Run() {
+    auto store_nodes = std::get<0>(graph_->topological_order());
+    for (auto* graph_node : store_nodes) {
+      auto* node = graph_node->safe_as<Node>();
+      if (!node || node->inlinks().empty()) continue;
+      if (node->op()->name == "batchnorm") {
+        FoldBatchNorm(node);
+      } else if (node->op()->name == "scale") {
+        FoldScale(node);
+      }
+    }
+    return num_folded_;
+  }
+
+ private:
+  Graph* graph_;
+  absl::flat_hash_map<std::string, shape_t>& shape_dict_;
+  absl::flat_hash_map<std::string, Type>& type_dict_;
+  int num_folded_{0};
+
+  static std::vector<NodeData*> Inputs(Node* node) {
+    std::vector<NodeData*> inputs;
+    for (auto& link : node->inlinks_in_order(true)) inputs.push_back(link->source()->safe_as<NodeData>());
+    return inputs;
+  }
+
+  static std::vector<NodeData*> Outputs(Node* node) {
+    std::vector<NodeData*> outputs;
+    for (auto& link : node->outlinks_in_order(true)) outputs.push_back(link->sink()->safe_as<NodeData>());
+    return outputs;
+  }
+
+  // Whether the var is only read by one op and not an output of the graph, so it can be dropped or rewritten.
+  bool IsInternal(NodeData* var) const {
+    return var->outlinks().size() == 1 &&
+           std::find(graph_->outputs.begin(), graph_->outputs.end(), var) == graph_->outputs.end();
+  }
+
+  static bool IsConst(NodeData* var) { return var->is_const(); }
+
+  // Relink the inputs of the node to the given ones in order.
+  static void SetInputs(Node* node, const std::vector<NodeData*>& inputs) {
+    for (auto* input : Inputs(node)) input->UnLinkTo(node);
+    for (auto* input : inputs) input->LinkTo(node);
+    node->inlinks_in_order(true);
+  }
+
+  static void Unlink(GraphNode* node) {
+    std::vector<GraphNode*> sources, sinks;
+    for (auto& link : node->inlinks()) sources.push_back(link->source());
+    for (auto& link : node->outlinks()) sinks.push_back(link->sink());
+    for (auto* source : sources) source->UnLinkTo(node);
+    for (auto* sink : sinks) node->UnLinkTo(sink);
+  }
+
+  // Add an op reading the inputs, whose output has the shape and the type of the like var.
+  NodeData* AddOp(const std::string& op_type,
+                  const std::vector<NodeData*>& inputs,
+                  const framework::AttrMapType& attrs,
+                  NodeData* like) {
+    auto* node = new Node(Operator::Get(op_type), op_type, common::UniqName(op_type + "_folding"));
+    node->attrs.attr_store = attrs;
+    std::shared_ptr<Node> node_ptr(node);
+    auto* out = new NodeData(node_ptr, 0, 0, common::UniqName(node->id() + "_out"));
+    for (auto* input : inputs) input->LinkTo(node);
+    node->LinkTo(out);
+    graph_->RegisterNode(node->id(), node);
+    graph_->RegisterNode(out->id(), out);
+    shape_dict_[out->id()] = shape_dict_.at(like->id());
+    type_dict_[out->id()]  = type_dict_.at(like->id());
+    return out;
+  }
+
+  // Let the producer write the output of the node reading its output var, and drop the node with the var.
+  static void BypassNode(Node* producer, NodeData* var, Node* node) {
+    auto* out     = Outputs(node)[0];
+    auto outputs  = Outputs(producer);
+    int index     = std::find(outputs.begin(), outputs.end(), var) - outputs.begin();
+    outputs[index] = out;
+    Unlink(node);
+    for (auto* output : Outputs(producer)) producer->UnLinkTo(output);
+    for (auto* output : outputs) producer->LinkTo(output);
+    producer->outlinks_in_order(true);
+    out->source_node  = var->source_node;
+    out->output_index = index;
+    var->source_node.reset();
+  }
+
+  // batchnorm(conv2d(x, w) [+ bias], scale, shift, mean, variance) = conv2d(x, w * s) + (shift - (mean - bias) * s),
+  // where s = scale / sqrt(variance + epsilon) for each output channel.
+  void FoldBatchNorm(Node* bn) {
+    auto bn_inputs = Inputs(bn);
+    if (bn_inputs.size() != 5 || GetAttr<std::string>(bn, "data_layout", "NCHW") != "NCHW") return;
+    for (int i = 1; i < 5; i++) {
+      if (!IsConst(bn_inputs[i])) return;
+    }
+    auto* conv_out = bn_inputs[0];
+    if (!IsInternal(conv_out) || !conv_out->source_node.get()) return;
+    auto* producer = conv_out->source_node.get();
+    // the bias added to the output channels of conv2d
+    Node* add      = nullptr;
+    NodeData* bias = nullptr;
+    if (producer->op()->name == "elementwise_add" && GetAttr<int>(producer, "axis", -1) == 1) {
+      auto add_inputs = Inputs(producer);
+      if (add_inputs.size() != 2 || !IsConst(add_inputs[1]) || !IsInternal(add_inputs[0])) return;
+      if (shape_dict_.at(add_inputs[1]->id()).size() != 1 || !add_inputs[0]->source_node.get()) return;
+      add      = producer;
+      bias     = add_inputs[1];
+      conv_out = add_inputs[0];
+      producer = conv_out->source_node.get();
+    }
+    auto& conv_type = producer->op()->name;
+    if (conv_type != "conv2d" && conv_type != "depthwise_conv2d") return;
+    if (GetAttr<std::string>(producer, "data_format", "NCHW") != "NCHW" ||
+        GetAttr<std::string>(producer, "conv_type", "forward") != "forward" ||
+        GetAttr<std::string>(producer, "weights_layout", "OIHW") != "OIHW") {
+      return;
+    }
+    auto conv_inputs = Inputs(producer);
+    if (conv_inputs.size() != 2 || !IsConst(conv_inputs[1]) || Outputs(producer)[0] != conv_out) return;
+    auto* weight = conv_inputs[1];
+    int channels = shape_dict_.at(conv_out->id())[1];
+    if (shape_dict_.at(weight->id())[0] != channels) return;
+    for (int i = 1; i < 5; i++) {
+      if (shape_dict_.at(bn_inputs[i]->id()) != shape_t{channels}) return;
+    }
+    if (bias && shape_dict_.at(bias->id()) != shape_t{channels}) return;
+    VLOG(3) << "Fold " << bn->id() << " into " << producer->id();
+
+    float epsilon = GetAttr<float>(bn, "epsilon", 0.00001f);
+    auto* scale   = bn_inputs[1];
+    auto* shift   = bn_inputs[2];
+    auto* mean    = bn_inputs[3];
+    auto* var     = bn_inputs[4];
+    auto* var_eps = AddOp("scale", {var}, {{"scale", 1.f}, {"bias", epsilon}}, var);
+    auto* inv_std = AddOp("rsqrt", {var_eps}, {}, var);
+    auto* factor  = AddOp("elementwise_mul", {scale, inv_std}, {}, scale);
+    auto* new_w   = AddOp("elementwise_mul", {weight, factor}, {{"axis", 0}}, weight);
+    if (bias) mean = AddOp("substract", {mean, bias}, {}, mean);
+    auto* offset   = AddOp("elementwise_mul", {mean, factor}, {}, mean);
+    auto* new_bias = AddOp("substract", {shift, offset}, {}, shift);
+
+    SetInputs(producer, {conv_inputs[0], new_w});
+    // the batchnorm becomes the bias add, keeping its output for the readers
+    bn->attrs.op        = Operator::Get("elementwise_add");
+    bn->attrs.node_name = "elementwise_add";
+    bn->attrs.attr_store.clear();
+    bn->attrs.attr_store["axis"] = 1;
+    SetInputs(bn, {conv_out, new_bias});
+    if (add) Unlink(add);
+    num_folded_++;
+  }
+
+  // scale(mul(x, y)) = mul(x, y * s) if the scale adds no bias, and scale(mulbias(x, y, z)) = mulbias(x, y * s,
+  // scale(z)), so the scale is dropped.
+  void FoldScale(Node* node) {
+    auto* in = Inputs(node)[0];
+    if (!IsInternal(in) || !in->source_node.get()) return;
+    auto* producer = in->source_node.get();
+    auto& op_type  = producer->op()->name;
+    if (op_type != "mul" && op_type != "mulbias") return;
+    auto inputs = Inputs(producer);
+    // the result of mul is output 0, and that of mulbias is output 1
+    if (Outputs(producer)[op_type == "mul" ? 0 : 1] != in) return;
+    for (int i = 1; i < inputs.size(); i++) {
+      if (!IsConst(inputs[i])) return;
+    }
+    float scale = GetAttr<float>(node, "scale", 1.f);
+    float bias  = GetAttr<float>(node, "bias", 0.f);
+    if (!GetAttr<bool>(node, "bias_after_scale", true)) bias *= scale;
+    if (op_type == "mul" && bias != 0.f) return;
+    VLOG(3) << "Fold " << node->id() << " into " << producer->id();
+
+    inputs[1] = AddOp("scale", {inputs[1]}, {{"scale", scale}}, inputs[1]);
+    if (op_type == "mulbias") {
+      inputs[2] = AddOp("scale", {inputs[2]}, {{"scale", scale}, {"bias", bias}}, inputs[2]);
+    }
+    SetInputs(producer, inputs);
+    BypassNode(producer, in, node);
+    num_folded_++;
+  }
+};
+
+}  // namespace
+
+void WeightFoldingPass(Graph* graph) {
+  int num_folded = WeightFolder(graph).Run();
+  if (!num_folded) return;
+  auto& shape_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  auto& dtype_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  absl::flat_hash_map<std::string, std::string> layout_dict;
+  auto* layout_dict_ptr = &layout_dict;
+  if (graph->HasAttr("inferlayout")) {
+    layout_dict_ptr = &graph->GetMutableAttrs<absl::flat_hash_map<std::string, std::string>>("inferlayout");
+  }
+  graph->ClearUnlinkedNodes(&shape_dict, &dtype_dict, layout_dict_ptr);
+  VLOG(3) << "WeightFolding folded " << num_folded << " ops";
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(WeightFolding) {
+  CINN_REGISTER_PASS(WeightFolding)
+      .describe(
+          "This pass folds the inference batchnorm after conv2d into the weights and the bias of the conv2d, and the "
+          "scale after mul or mulbias into their weights. The folded weights are computed from the constants by new "
+          "ops, which ConstPropagate runs once before the others. It should be applied after InferShape and before "
+          "AlterLayout and ConstPropagate.")
+      .set_change_structure(true)
+      .provide_graph_attr("infershape")
+      .provide_graph_attr("inferdtype")
+      .set_body(cinn::hlir::pass::WeightFoldingPass);
+  return true;
+}
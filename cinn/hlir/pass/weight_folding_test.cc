@@ -0,0 +1,175 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "cinn/cinn.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/test_helper.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+namespace cinn {
+namespace frontend {
+
+using hlir::framework::Graph;
+using hlir::framework::Node;
+using hlir::framework::Scope;
+using hlir::pass::CountOps;
+
+Target GetTarget() {
+#ifdef CINN_WITH_CUDA
+  return common::DefaultNVGPUTarget();
+#else
+  return common::DefaultHostTarget();
+#endif
+}
+
+// Compile and run the program with or without WeightFolding, the inputs are filled by the same random values in the
+// order of their names, and the output is returned on X86.
+std::vector<float> RunProgram(const Program& program,
+                              const std::vector<std::string>& input_names,
+                              const std::string& output_name,
+                              bool folding,
+                              std::shared_ptr<Graph>* graph_ptr = nullptr) {
+  Target target = GetTarget();
+  auto graph    = std::make_shared<Graph>(program, target);
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  if (folding) hlir::framework::ApplyPass(graph.get(), "WeightFolding");
+  hlir::framework::ApplyPass(graph.get(), "ConstPropagate");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  if (graph_ptr) *graph_ptr = graph;
+  auto scope = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+
+  std::vector<float> res;
+#ifndef CINN_WITH_CUDA
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(0.1f, 1.f);
+  for (auto& name : input_names) {
+    auto tensor = scope->GetTensor(name);
+    auto* data  = tensor->mutable_data<float>(target);
+    for (int i = 0; i < tensor->shape().numel(); i++) data[i] = dist(rng);
+  }
+  runtime_program->PrePack();
+  runtime_program->Execute();
+  auto out  = scope->GetTensor(output_name);
+  auto* data = out->data<float>();
+  res.assign(data, data + out->shape().numel());
+#endif
+  return res;
+}
+
+void CheckResults(const std::vector<float>& res, const std::vector<float>& expected) {
+  ASSERT_EQ(res.size(), expected.size());
+  for (int i = 0; i < res.size(); i++) {
+    ASSERT_NEAR(res[i], expected[i], 1e-3 * std::max(1.f, std::abs(expected[i]))) << "at " << i;
+  }
+}
+
+// conv2d + elementwise_add + batchnorm becomes conv2d with the folded weight + elementwise_add with the folded bias
+TEST(WeightFolding, conv_bias_bn) {
+  Placeholder A(Float(32), {1, 16, 8, 8}, "A");
+  Placeholder W(Float(32), {32, 16, 3, 3}, "W", true);
+  Placeholder Bias(Float(32), {32}, "Bias", true);
+  Placeholder Scale(Float(32), {32}, "Scale", true);
+  Placeholder Shift(Float(32), {32}, "Shift", true);
+  Placeholder Mean(Float(32), {32}, "Mean", true);
+  Placeholder Var(Float(32), {32}, "Var", true);
+
+  Program program;
+  absl::flat_hash_map<std::string, Program::attr_t> attrs;
+  attrs["stride"]   = std::vector<int>({1, 1});
+  attrs["dilation"] = std::vector<int>({1, 1});
+  attrs["padding"]  = std::vector<int>({1, 1});
+  auto c            = program.conv2d(A, W, attrs);
+  auto d            = program.elementwise_add(c, Bias, 1);
+  auto e            = program.batchnorm(d, Scale, Shift, Mean, Var, {{"epsilon", 0.001f}});
+  program.SetInputs({A, W, Bias, Scale, Shift, Mean, Var});
+  program.Validate();
+
+  std::vector<std::string> input_names = {"A", "Bias", "Mean", "Scale", "Shift", "Var", "W"};
+  std::shared_ptr<Graph> graph;
+  auto expected = RunProgram(program, input_names, e->id, false);
+  auto res      = RunProgram(program, input_names, e->id, true, &graph);
+  ASSERT_EQ(CountOps(*graph, "batchnorm"), 0);
+  ASSERT_EQ(CountOps(*graph, "conv2d"), 1);
+  ASSERT_EQ(CountOps(*graph, "elementwise_add"), 1);
+  for (auto* node : graph->nodes()) {
+    auto* op_node = node->safe_as<Node>();
+    if (!op_node || op_node->op()->name == "conv2d" || op_node->op()->name == "elementwise_add") continue;
+    // the ops computing the folded weight and bias run once
+    ASSERT_TRUE(absl::get<bool>(op_node->attrs.attr_store.at("pre_run"))) << op_node->id();
+  }
+  CheckResults(res, expected);
+}
+
+// scale without bias after mul is folded into the weight of mul, while the one with bias is kept
+TEST(WeightFolding, mul_scale) {
+  Placeholder A(Float(32), {16, 32}, "A");
+  Placeholder B(Float(32), {24, 32}, "B", true);
+
+  Program program;
+  auto c = program.mul(A, B, 1, 1);
+  auto d = program.scale(c, {{"scale", 2.f}});
+  auto e = program.scale(d, {{"scale", 0.5f}, {"bias", 1.f}});
+  program.SetInputs({A, B});
+  program.Validate();
+
+  std::shared_ptr<Graph> graph;
+  auto expected = RunProgram(program, {"A", "B"}, e->id, false);
+  auto res      = RunProgram(program, {"A", "B"}, e->id, true, &graph);
+  // the scale left and the one scaling the weight
+  ASSERT_EQ(CountOps(*graph, "scale"), 2);
+  CheckResults(res, expected);
+}
+
+// scale after mulbias is folded into both the weight and the bias
+TEST(WeightFolding, mulbias_scale) {
+  Placeholder A(Float(32), {16, 32}, "A");
+  Placeholder B(Float(32), {24, 32}, "B", true);
+  Placeholder C(Float(32), {16, 24}, "C", true);
+
+  Program program;
+  auto d = program.mulbias(A, B, C, 1, 1);
+  auto e = program.scale(d, {{"scale", 2.f}, {"bias", 1.f}, {"bias_after_scale", false}});
+  auto f = program.relu(e);
+  program.SetInputs({A, B, C});
+  program.Validate();
+
+  std::shared_ptr<Graph> graph;
+  auto expected = RunProgram(program, {"A", "B", "C"}, f->id, false);
+  auto res      = RunProgram(program, {"A", "B", "C"}, f->id, true, &graph);
+  int num_scales = 0;
+  for (auto* node : graph->nodes()) {
+    auto* op_node = node->safe_as<Node>();
+    if (!op_node || op_node->op()->name != "scale") continue;
+    num_scales++;
+    ASSERT_TRUE(absl::get<bool>(op_node->attrs.attr_store.at("pre_run"))) << op_node->id();
+  }
+  ASSERT_EQ(num_scales, 2);
+  CheckResults(res, expected);
+}
+
+}  // namespace frontend
+}  // namespace cinn
@@ -0,0 +1,242 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+DEFINE_int32(cinn_weight_only_quantization_bits,
+             8,
+             "The bits of the weights quantized by the WeightOnlyQuantization pass, 8 or 4.");
+
+namespace cinn {
+namespace hlir {
+namespace pass {
+
+using common::GraphNode;
+using common::Type;
+using framework::Graph;
+using framework::Node;
+using framework::NodeData;
+using framework::Operator;
+using framework::shape_t;
+
+namespace {
+
+// The muls and the 2-D matmuls of the const float32 weights are rewritten to weight_only_mul, which reads the int8 or
+// int4 weights quantized per output channel by quantize_per_channel, and keeps the activations and the accumulation
+// in float16 or float32. The quantizations read the const weights, so they run once in the prepack stage by
+// ConstPropagate, and the float32 weights are not needed after PrePack.
+class WeightOnlyRewriter {
+ public:
+  WeightOnlyRewriter(Graph* graph, int bits)
+      : graph_(graph),
+        bits_(bits),
+        shape_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape")),
+        type_dict_(graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype")) {}
+
+  int Run() {
+    auto store_nodes = std::get<0>(graph_->topological_order());
+    for (auto* graph_node : store_nodes) {
+      auto* node = graph_node->safe_as<Node>();
+      if (!node || (node->op()->name != "mul" && node->op()->name != "matmul")) continue;
+      auto* weight = GetWeight(node);
+      if (weight) Rewrite(node, weight);
+    }
+    // the casts of the weights to float16 inserted by AutoMixedPrecision are not read any more
+    for (auto* cast : weight_casts_) {
+      auto* out = Outputs(cast)[0];
+      if (out->outlinks().empty() && !IsGraphOutput(out)) Unlink(cast);
+    }
+    return num_rewritten_;
+  }
+
+ private:
+  Graph* graph_;
+  int bits_;
+  absl::flat_hash_map<std::string, shape_t>& shape_dict_;
+  absl::flat_hash_map<std::string, Type>& type_dict_;
+  // The quantized weight and the scales of each weight and whether it is transposed, shared by all the readers.
+  absl::flat_hash_map<std::string, std::pair<NodeData*, NodeData*>> quantized_vars_;
+  std::vector<Node*> weight_casts_;
+  int num_rewritten_{0};
+
+  static std::vector<NodeData*> Inputs(Node* node) {
+    std::vector<NodeData*> inputs;
+    for (auto& link : node->inlinks_in_order(true)) inputs.push_back(link->source()->safe_as<NodeData>());
+    return inputs;
+  }
+
+  static std::vector<NodeData*> Outputs(Node* node) {
+    std::vector<NodeData*> outputs;
+    for (auto& link : node->outlinks_in_order(true)) outputs.push_back(link->sink()->safe_as<NodeData>());
+    return outputs;
+  }
+
+  bool IsGraphOutput(NodeData* var) const {
+    return std::find(graph_->outputs.begin(), graph_->outputs.end(), var) != graph_->outputs.end();
+  }
+
+  static void Unlink(GraphNode* node) {
+    std::vector<GraphNode*> sources, sinks;
+    for (auto& link : node->inlinks()) sources.push_back(link->source());
+    for (auto& link : node->outlinks()) sinks.push_back(link->sink());
+    for (auto* source : sources) source->UnLinkTo(node);
+    for (auto* sink : sinks) node->UnLinkTo(sink);
+  }
+
+  static bool GetBoolAttr(Node* node, const std::string& name) {
+    auto& attrs = node->attrs.attr_store;
+    return attrs.count(name) && absl::get<bool>(attrs.at(name));
+  }
+
+  // The weights of the matmuls are [K, N] unless trans_b, and quantized by the channels of their second dim.
+  static bool IsTransposedWeight(Node* node) { return node->op()->name == "matmul" && !GetBoolAttr(node, "trans_b"); }
+
+  // The const float32 weight of the node, either its input or the input of the cast to float16 it reads, nullptr if
+  // the node can't read the quantized one.
+  NodeData* GetWeight(Node* node) {
+    auto inputs = Inputs(node);
+    if (inputs.size() != 2U) return nullptr;
+    auto& x_type = type_dict_.at(inputs[0]->id());
+    if (!x_type.is_float(16) && !x_type.is_float(32)) return nullptr;
+    // weight_only_mul only writes the output, the temporary outputs of mul and matmul should not be read
+    auto outputs = Outputs(node);
+    for (int i = 1; i < outputs.size(); i++) {
+      if (!outputs[i]->outlinks().empty() || IsGraphOutput(outputs[i])) return nullptr;
+    }
+    auto& attrs = node->attrs.attr_store;
+    if (node->op()->name == "mul") {
+      if (attrs.count("y_num_col_dims") && absl::get<int>(attrs.at("y_num_col_dims")) != 1) return nullptr;
+    } else {
+      if (shape_dict_.at(inputs[0]->id()).size() != 2U || GetBoolAttr(node, "trans_a")) return nullptr;
+      if (attrs.count("alpha") && absl::get<float>(attrs.at("alpha")) != 1.f) return nullptr;
+    }
+
+    auto* weight = inputs[1];
+    auto* source = weight->source_node.get();
+    if (!weight->is_const() && source && source->op() && source->op()->name == "cast") {
+      auto cast_inputs = Inputs(source);
+      if (cast_inputs.size() != 1U) return nullptr;
+      weight = cast_inputs[0];
+    }
+    if (!weight->is_const() || type_dict_.at(weight->id()) != Float(32)) return nullptr;
+    auto& shape = shape_dict_.at(weight->id());
+    if (shape.size() != 2U) return nullptr;
+    int K = IsTransposedWeight(node) ? shape[0] : shape[1];
+    if (bits_ == 4 && K % 2) return nullptr;
+    if (weight != inputs[1]) weight_casts_.push_back(source);
+    return weight;
+  }
+
+  NodeData* NewVar(const std::shared_ptr<Node>& source, int index, const std::string& id, const Type& type) {
+    auto* var = new NodeData(source, index, 0, id);
+    graph_->RegisterNode(var->id(), var);
+    type_dict_[var->id()] = type;
+    return var;
+  }
+
+  std::pair<NodeData*, NodeData*> GetQuantizedWeight(NodeData* weight, bool trans) {
+    auto key = weight->id() + (trans ? "_trans" : "");
+    auto it  = quantized_vars_.find(key);
+    if (it != quantized_vars_.end()) return it->second;
+    std::shared_ptr<Node> quantize(new Node(
+        Operator::Get("quantize_per_channel"), "quantize_per_channel", common::UniqName("quantize_" + weight->id())));
+    quantize->attrs.attr_store["bits"]  = bits_;
+    quantize->attrs.attr_store["trans"] = trans;
+    graph_->RegisterNode(quantize->id(), quantize.get());
+    auto& shape = shape_dict_.at(weight->id());
+    int N       = trans ? shape[1] : shape[0];
+    int K       = trans ? shape[0] : shape[1];
+    auto* q     = NewVar(quantize, 0, common::UniqName(weight->id() + "_int" + std::to_string(bits_)), Int(8));
+    auto* scale = NewVar(quantize, 1, common::UniqName(weight->id() + "_scales"), Float(32));
+    shape_dict_[q->id()]     = {N, bits_ == 4 ? K / 2 : K};
+    shape_dict_[scale->id()] = {N};
+    weight->LinkTo(quantize.get());
+    quantize->LinkTo(q);
+    quantize->LinkTo(scale);
+    quantized_vars_[key] = {q, scale};
+    return {q, scale};
+  }
+
+  void Rewrite(Node* node, NodeData* weight) {
+    VLOG(3) << "Quantize the weight " << weight->id() << " of " << node->id() << " to " << bits_ << " bits";
+    auto quantized = GetQuantizedWeight(weight, IsTransposedWeight(node));
+    auto inputs    = Inputs(node);
+    for (auto* input : inputs) input->UnLinkTo(node);
+    inputs[0]->LinkTo(node);
+    quantized.first->LinkTo(node);
+    quantized.second->LinkTo(node);
+    node->inlinks_in_order(true);
+
+    auto& attr_store = node->attrs.attr_store;
+    absl::flat_hash_map<std::string, framework::AttrType> attrs;
+    if (attr_store.count("x_num_col_dims")) attrs["x_num_col_dims"] = attr_store.at("x_num_col_dims");
+    attrs["bits"]         = bits_;
+    attr_store            = std::move(attrs);
+    node->attrs.op        = Operator::Get("weight_only_mul");
+    node->attrs.node_name = "weight_only_mul";
+
+    auto outputs = Outputs(node);
+    for (int i = 1; i < outputs.size(); i++) node->UnLinkTo(outputs[i]);
+    node->outlinks_in_order(true);
+    num_rewritten_++;
+  }
+};
+
+}  // namespace
+
+void WeightOnlyQuantizationPass(Graph* graph) {
+  int bits = FLAGS_cinn_weight_only_quantization_bits;
+  CHECK(bits == 8 || bits == 4) << "The weights can only be quantized to 8 or 4 bits, but got " << bits;
+  int num_rewritten = WeightOnlyRewriter(graph, bits).Run();
+  if (!num_rewritten) return;
+  auto& shape_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, shape_t>>("infershape");
+  auto& dtype_dict = graph->GetMutableAttrs<absl::flat_hash_map<std::string, Type>>("inferdtype");
+  absl::flat_hash_map<std::string, std::string> layout_dict;
+  auto* layout_dict_ptr = &layout_dict;
+  if (graph->HasAttr("inferlayout")) {
+    layout_dict_ptr = &graph->GetMutableAttrs<absl::flat_hash_map<std::string, std::string>>("inferlayout");
+  }
+  graph->ClearUnlinkedNodes(&shape_dict, &dtype_dict, layout_dict_ptr);
+  VLOG(3) << "WeightOnlyQuantization rewrites " << num_rewritten << " ops with " << bits << "-bit weights";
+}
+
+}  // namespace pass
+}  // namespace hlir
+}  // namespace cinn
+
+CINN_REGISTER_HELPER(WeightOnlyQuantization) {
+  CINN_REGISTER_PASS(WeightOnlyQuantization)
+      .describe(
+          "This pass rewrites the muls and the 2-D matmuls of the const float32 weights to weight_only_mul, which "
+          "reads the weights quantized per output channel to the bits of FLAGS_cinn_weight_only_quantization_bits by "
+          "quantize_per_channel, and dequantizes them as they are read. The activations and the accumulation keep "
+          "their float16 or float32 type. It should be applied after InferShape and AutoMixedPrecision, whose casts "
+          "of the weights are replaced by the quantizations, and before ConstPropagate, so that the quantizations run "
+          "once in the prepack stage.")
+      .set_change_structure(true)
+      .provide_graph_attr("infershape")
+      .provide_graph_attr("inferdtype")
+      .set_body(cinn::hlir::pass::WeightOnlyQuantizationPass);
+  return true;
+}
@@ -0,0 +1,122 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "cinn/cinn.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/test_helper.h"
+#include "cinn/hlir/pass/use_pass.h"
+
+DECLARE_int32(cinn_weight_only_quantization_bits);
+
+namespace cinn {
+namespace frontend {
+
+using hlir::framework::Graph;
+using hlir::framework::Node;
+using hlir::framework::Scope;
+using hlir::pass::CountOps;
+using hlir::pass::Fill;
+using hlir::pass::RandomData;
+
+namespace {
+
+// Run the mul, or the matmul of the [K, N] weight, with the weight quantized to the bits, and compare with float32.
+void TestWeightOnly(bool matmul, int bits, float tolerance) {
+  // restore the flag even if an assertion fails
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  FLAGS_cinn_weight_only_quantization_bits = bits;
+  const int M = 4, N = 24, K = 64;
+  Placeholder A(Float(32), {M, K}, "A");
+  Placeholder B(Float(32), matmul ? std::vector<int>{K, N} : std::vector<int>{N, K}, "B", true);
+
+  Program program;
+  auto c = matmul ? program.matmul(A, B) : program.mul(A, B, 1, 1);
+  auto d = program.relu(c);
+  program.SetInputs({A, B});
+  program.Validate();
+
+  Target target = common::DefaultHostTarget();
+  auto graph    = std::make_shared<Graph>(program, target);
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "WeightOnlyQuantization");
+  ASSERT_EQ(CountOps(*graph, matmul ? "matmul" : "mul"), 0);
+  ASSERT_EQ(CountOps(*graph, "weight_only_mul"), 1);
+  ASSERT_EQ(CountOps(*graph, "quantize_per_channel"), 1);
+  hlir::framework::ApplyPass(graph.get(), "ConstPropagate");
+  hlir::framework::ApplyPass(graph.get(), "OpFusion");
+
+  auto scope = BuildScope(target, graph);
+  hlir::framework::GraphCompiler gc(target, scope, graph);
+  auto runtime_program = gc.Build();
+  auto input           = RandomData(M * K, 1);
+  auto weight          = RandomData(N * K, 0);
+  Fill(scope.get(), "A", input, target);
+  Fill(scope.get(), "B", weight, target);
+  // the weight is quantized once, and the float32 one is dropped
+  auto dropped = runtime_program->PrePack();
+  ASSERT_NE(std::find(dropped.begin(), dropped.end(), "B"), dropped.end());
+  runtime_program->Execute();
+
+  auto out   = scope->GetTensor(d->id);
+  auto* data = out->data<float>();
+  ASSERT_EQ(out->shape().numel(), M * N);
+  for (int m = 0; m < M; m++) {
+    for (int n = 0; n < N; n++) {
+      float expected = 0.f;
+      for (int k = 0; k < K; k++) expected += input[m * K + k] * weight[matmul ? k * N + n : n * K + k];
+      expected = std::max(expected, 0.f);
+      ASSERT_NEAR(data[m * N + n], expected, tolerance) << "at " << m << ", " << n;
+    }
+  }
+}
+
+}  // namespace
+
+TEST(WeightOnlyQuantization, mul_int8) { TestWeightOnly(false, 8, 0.05f); }
+
+// each int4 value is off by at most 1/14 of the max of its channel
+TEST(WeightOnlyQuantization, mul_int4) { TestWeightOnly(false, 4, 0.6f); }
+
+TEST(WeightOnlyQuantization, matmul_int4) { TestWeightOnly(true, 4, 0.6f); }
+
+// mul of two activations is kept in float32
+TEST(WeightOnlyQuantization, skip) {
+  Placeholder A(Float(32), {4, 8}, "A");
+  Placeholder B(Float(32), {6, 8}, "B");
+
+  Program program;
+  program.mul(A, B, 1, 1);
+  program.SetInputs({A, B});
+  program.Validate();
+
+  auto graph = std::make_shared<Graph>(program, common::DefaultHostTarget());
+  hlir::framework::ApplyPass(graph.get(), "InferShape");
+  hlir::framework::ApplyPass(graph.get(), "WeightOnlyQuantization");
+  ASSERT_EQ(CountOps(*graph, "mul"), 1);
+  ASSERT_EQ(CountOps(*graph, "quantize_per_channel"), 0);
+}
+
+}  // namespace frontend
+}  // namespace cinn
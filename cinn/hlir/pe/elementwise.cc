@@ -102,6 +102,21 @@ HLIR_IMP_UNARY_PE(Sign);
 HLIR_IMP_UNARY_PE(Abs);
 HLIR_IMP_UNARY_PE(Rsqrt);
 
+ir::Tensor Cast(const Tensor& A, const Type& dtype, const std::string& output_name) {
+  return Compute(
+      A->shape, [=](const std::vector<Expr>& indice) { return ir::Cast::Make(dtype, A(indice)); }, output_name);
+}
+
+ir::Tensor Quantize(const Tensor& A, float scale, const std::string& output_name) {
+  return Compute(
+      A->shape,
+      [=](const std::vector<Expr>& indice) {
+        auto value = lang::Round(A(indice) * Expr(1.f / scale));
+        return ir::Cast::Make(Int(8), ir::Max::Make(ir::Min::Make(value, Expr(127.f)), Expr(-127.f)));
+      },
+      output_name);
+}
+
 }  // namespace pe
 }  // namespace hlir
 }  // namespace cinn
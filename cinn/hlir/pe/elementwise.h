@@ -69,13 +69,34 @@ HLIR_DCL_UNARY_PE(Sigmoid);
 HLIR_DCL_UNARY_PE(Sign);
 HLIR_DCL_UNARY_PE(Abs);
 HLIR_DCL_UNARY_PE(Rsqrt);
-HLIR_DCL_UNARY_PE(Cast);
 HLIR_DCL_UNARY_PE(Clip);
 HLIR_DCL_UNARY_PE(Reinterpret);
 HLIR_DCL_UNARY_PE(ElementwiseSum);
 HLIR_DCL_UNARY_PE(Full);
 HLIR_DCL_UNARY_PE(FullLike);
 
+/**
+ * @brief Cast the elements of A to another type, e.g. between float32 and float16.
+ *
+ * @param A The input Tensor
+ * @param dtype The type of the output elements
+ * @param output_name The name of the output Tensor
+ *
+ * @return The result Tensor.
+ */
+ir::Tensor Cast(const ir::Tensor& A, const Type& dtype, const std::string& output_name = "T_Cast_out");
+
+/**
+ * @brief Quantize A to int8 by round(A / scale) clamped to [-127, 127].
+ *
+ * @param A The input Tensor in float32
+ * @param scale The quantization scale, i.e. the range of A divided by 127
+ * @param output_name The name of the output Tensor
+ *
+ * @return The result Tensor.
+ */
+ir::Tensor Quantize(const ir::Tensor& A, float scale, const std::string& output_name = "T_Quantize_out");
+
 }  // namespace pe
 }  // namespace hlir
 }  // namespace cinn
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
 #include "cinn/hlir/pe/schedule.h"
@@ -51,6 +52,69 @@ TEST(load_x86_params, load_x86_params) {
   ASSERT_EQ(unroll_kw, 1);
 }
 
+TEST(load_x86_params, nearest_x86_params) {
+  auto target = common::DefaultHostTarget();
+  // no conv of the shape is tuned, the params of the nearest shape 1 64 56 56 are adjusted to the new extents
+  std::string key =
+      GenerateX86ConvKey(std::vector<int>({1, 64, 58, 58}), {64, 64, 3, 3}, {1, 1}, {1, 1}, std::vector<int>({1, 1}));
+  ASSERT_EQ(GetX86ConvParams().count(key), 0);
+  absl::flat_hash_map<std::string, std::vector<int>> param;
+  ASSERT_TRUE(GetNearestX86ConvParams(key, &param));
+  ASSERT_EQ(param["ic_bn"], std::vector<int>({1, 64}));
+  ASSERT_EQ(param["oc_bn"], std::vector<int>({2, 32}));
+  ASSERT_EQ(param["ow_bn"], std::vector<int>({29, 2}));
+  ASSERT_EQ(param["unroll_kw"], std::vector<int>({1}));
+
+  absl::flat_hash_map<std::string, int> conv2d_factors;
+  GetConv2dFactors(&conv2d_factors, 64, 64, 64, -1, 58, Float(32), target, key);
+  ASSERT_EQ(conv2d_factors["ic_bn"], 64);
+  ASSERT_EQ(conv2d_factors["oc_bn"], 32);
+  ASSERT_EQ(conv2d_factors["ow_bn"], 2);
+
+  // no tuned conv has the same kernel, strides, paddings and dilations
+  key = GenerateX86ConvKey(std::vector<int>({1, 64, 56, 56}), {64, 64, 5, 5}, {3, 3}, {2, 2}, std::vector<int>({1, 1}));
+  ASSERT_FALSE(GetNearestX86ConvParams(key, &param));
+}
+
+TEST(load_x86_params, tuning_log_path) {
+  ASSERT_EQ(GetTuningLogPath("tuning.log"), "tuning.log");
+  auto path = GetTuningLogPath("tuning_{device}.log");
+  ASSERT_EQ(path.find("{device}"), std::string::npos);
+  ASSERT_EQ(path.substr(0, 7), "tuning_");
+  ASSERT_EQ(path.substr(path.size() - 4), ".log");
+}
+
+TEST(load_x86_params, avx2_params) {
+  CreateX86AVX2SerialData();
+  absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, std::vector<int>>> params;
+  LoadSerialData(&params, "default_avx2_serial.log");
+  std::string key =
+      GenerateX86ConvKey(std::vector<int>({1, 64, 56, 56}), {64, 64, 3, 3}, {1, 1}, {1, 1}, std::vector<int>({1, 1}));
+  ASSERT_EQ(params.count(key), 1);
+  // the accumulators of each microkernel fit the 16 vector registers of AVX2 with the weights
+  for (auto &item : params) {
+    int oc_bn = item.second.at("oc_bn").back();
+    int ow_bn = item.second.at("ow_bn").back();
+    ASSERT_LE(oc_bn, 16) << item.first;
+    ASSERT_LE(oc_bn / 8 * ow_bn, 12) << item.first;
+  }
+
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  auto target                 = common::DefaultHostTarget();
+  FLAGS_cinn_x86_blocking_isa = "avx2";
+  ASSERT_FALSE(UseX86AVX512Blocking(target));
+  ASSERT_EQ(GetX86BlockingLanes(Float(32), target), 8);
+  absl::flat_hash_map<std::string, int> conv2d_factors;
+  GetConv2d1x1Factors(&conv2d_factors, 64, 64, 56, 56, Float(32), target);
+  ASSERT_EQ(conv2d_factors["oc_bn"], 8);
+  ASSERT_LE(conv2d_factors["oh_bn"] * conv2d_factors["ow_bn"], 12);
+  auto blocking = GetX86GemmBlocking(64, 64, 64, Float(32), target);
+  ASSERT_LE(blocking.nr / 8 * blocking.mr, 12);
+
+  FLAGS_cinn_x86_blocking_isa = "avx512";
+  ASSERT_EQ(GetX86BlockingLanes(Float(32), target), 16);
+}
+
 TEST(load_cuda_params, load_cuda_params) {
   auto &res = ScheduleParam::get_cuda_instance().GetParam();
   if (res.empty()) {
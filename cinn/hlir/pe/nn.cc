@@ -16,6 +16,8 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <numeric>
 #include <string>
@@ -26,11 +28,26 @@
 #include "cinn/common/ir_util.h"
 #include "cinn/hlir/pe/broadcast.h"
 #include "cinn/hlir/pe/elementwise.h"
+#include "cinn/hlir/pe/reduction.h"
 #include "cinn/hlir/pe/schedule.h"
+#include "cinn/hlir/pe/transform.h"
 #include "cinn/ir/ir_operators.h"
 #include "cinn/lang/builtin.h"
 #include "cinn/lang/compute.h"
 #include "cinn/optim/ir_copy.h"
+#ifdef CINN_WITH_MKLDNN
+#include "cinn/runtime/cpu/mkldnn_math.h"
+#endif
+
+DEFINE_bool(cinn_use_winograd_conv2d,
+            true,
+            "Whether to compute the 3x3 conv2d of stride 1 by Winograd when the shapes fit, see GetConv2dWinogradTile.");
+DEFINE_bool(cinn_use_im2col_conv2d,
+            true,
+            "Whether to compute the X86 conv2d by the GEMM over its im2col when the shapes fit, see UseConv2dIm2col.");
+DEFINE_bool(cinn_use_implicit_gemm_conv2d,
+            true,
+            "Whether to compute the NVGPU conv2d by the implicit GEMM when the shapes fit, see UseConv2dImplicitGemm.");
 
 namespace cinn {
 namespace hlir {
@@ -326,6 +343,58 @@ std::vector<ir::Tensor> Conv2d_NCHW_MKLDNN(const ir::Tensor &input,
   out->WithBuffer(input->type());
   return {out, call};
 }
+
+std::vector<ir::Tensor> Conv2d_NCHW_MKLDNN_PostOps(const ir::Tensor &input,
+                                                   const ir::Tensor &weights,
+                                                   const ir::Tensor &bias,
+                                                   const ir::Tensor &residual,
+                                                   bool relu,
+                                                   int pad_h,
+                                                   int pad_w,
+                                                   int stride_h,
+                                                   int stride_w,
+                                                   int dilation_h,
+                                                   int dilation_w,
+                                                   const std::string &output_name) {
+  CHECK_EQ(input->shape.size(), 4U) << "Input's dimension of Conv2d_NCHW op is not 4! Please check.";
+  CHECK_EQ(weights->shape.size(), 4U) << "Weight's dimension of Conv2d_NCHW op is not 4! Please check.";
+  int group = input->shape[1].as_int32() / weights->shape[1].as_int32();
+  CHECK_EQ(input->shape[1].as_int32(), weights->shape[1].as_int32() * group)
+      << "input channel should be divisible by filter channel";
+  int post_ops = (bias.defined() ? kMkldnnPostOpBias : 0) | (residual.defined() ? kMkldnnPostOpSum : 0) |
+                 (relu ? kMkldnnPostOpRelu : 0);
+  // the buffers of the post-ops not applied are not read, the input is passed instead
+  auto call = Compute(
+      {Expr(1)},
+      [=]() -> Expr {
+        return lang::CallExtern("cinn_cpu_mkldnn_conv2d_nchw_post_ops_fp32",
+                                {
+                                    Expr(input->shape[0]),                 // batch_size
+                                    Expr(input->shape[1]),                 // c_in
+                                    Expr(input->shape[2]),                 // input_h
+                                    Expr(input->shape[3]),                 // input_w
+                                    Expr(weights->shape[0]),               // c_out
+                                    Expr(group),                           // group
+                                    Expr(weights->shape[2]),               // filter_h
+                                    Expr(weights->shape[3]),               // filter_w
+                                    Expr(pad_h),                           // pad_h
+                                    Expr(pad_w),                           // pad_w
+                                    Expr(stride_h),                        // stride_h
+                                    Expr(stride_w),                        // stride_w
+                                    Expr(dilation_h),                      // dilation_h
+                                    Expr(dilation_w),                      // dilation_w
+                                    Expr(post_ops),                        // post_ops
+                                    input,                                 // input
+                                    weights,                               // weights
+                                    bias.defined() ? bias : input,         // bias
+                                    residual.defined() ? residual : input  // residual
+                                });
+      },
+      UniqName("conv2d_nchw_mkldnn_out"));
+  auto out = call->TupleGet(0);
+  out->WithBuffer(input->type());
+  return {out, call};
+}
 #endif
 
 std::vector<ir::Tensor> Conv2d_NHWC(const ir::Tensor &input,
@@ -393,6 +462,335 @@ std::vector<ir::Tensor> Conv2d_NHWC(const ir::Tensor &input,
   return {res, input_pad, weights_dilation};
 }
 
+namespace {
+//! The transform matrices of the Winograd conv2d F(m x m, 3 x 3).
+struct WinogradMatrices {
+  std::vector<std::vector<float>> A_T;
+  std::vector<std::vector<float>> B_T;
+  std::vector<std::vector<float>> G;
+};
+
+const WinogradMatrices &GetWinogradMatrices(int tile_size) {
+  static const WinogradMatrices f2x2 = {{{1, 1, 1, 0}, {0, 1, -1, -1}},
+                                        {{1, 0, -1, 0}, {0, 1, 1, 0}, {0, -1, 1, 0}, {0, 1, 0, -1}},
+                                        {{1, 0, 0}, {0.5, 0.5, 0.5}, {0.5, -0.5, 0.5}, {0, 0, 1}}};
+  static const WinogradMatrices f4x4 = {
+      {{1, 1, 1, 1, 1, 0}, {0, 1, -1, 2, -2, 0}, {0, 1, 1, 4, 4, 0}, {0, 1, -1, 8, -8, 1}},
+      {{4, 0, -5, 0, 1, 0},
+       {0, -4, -4, 1, 1, 0},
+       {0, 4, -4, -1, 1, 0},
+       {0, -2, -1, 2, 1, 0},
+       {0, 2, -1, -2, 1, 0},
+       {0, 4, 0, -5, 0, 1}},
+      {{1.f / 4, 0, 0},
+       {-1.f / 6, -1.f / 6, -1.f / 6},
+       {-1.f / 6, 1.f / 6, -1.f / 6},
+       {1.f / 24, 1.f / 12, 1.f / 6},
+       {1.f / 24, -1.f / 12, 1.f / 6},
+       {0, 0, 1}}};
+  CHECK(tile_size == 2 || tile_size == 4) << "Winograd only supports F(2x2, 3x3) and F(4x4, 3x3), but get tile size "
+                                          << tile_size;
+  return tile_size == 2 ? f2x2 : f4x4;
+}
+
+// sum_k mat[row][k] * elem(k) of the row selected by the expression, the zero coefficients are skipped
+Expr WinogradDot(const std::vector<std::vector<float>> &mat, Expr row, const std::function<Expr(int)> &elem) {
+  Expr res;
+  for (int r = mat.size() - 1; r >= 0; r--) {
+    Expr sum;
+    for (int k = 0; k < mat[r].size(); k++) {
+      float coef = mat[r][k];
+      if (coef == 0.f) continue;
+      Expr term = coef == 1.f || (coef == -1.f && sum.defined()) ? elem(k) : Expr(coef) * elem(k);
+      if (!sum.defined()) {
+        sum = term;
+      } else {
+        sum = coef == -1.f ? sum - term : sum + term;
+      }
+    }
+    if (!sum.defined()) sum = Expr(0.f);
+    res = res.defined() ? Select::Make(ir::EQ::Make(row, Expr(r)), sum, res) : sum;
+  }
+  return res;
+}
+}  // namespace
+
+int GetConv2dWinogradTile(const std::vector<int> &input_shape,
+                          const std::vector<int> &weight_shape,
+                          const std::vector<int> &padding,
+                          const std::vector<int> &stride,
+                          const std::vector<int> &dilation,
+                          int groups) {
+  if (!FLAGS_cinn_use_winograd_conv2d) return 0;
+  if (input_shape.size() != 4 || weight_shape.size() != 4 || padding.size() != 2 || groups != 1) return 0;
+  if (weight_shape[1] != input_shape[1] || weight_shape[2] != 3 || weight_shape[3] != 3) return 0;
+  for (int i = 0; i < 2; i++) {
+    if (stride[i] != 1 || dilation[i] != 1) return 0;
+  }
+  // the transforms of the tiles are not amortized by the matmuls over the few channels
+  if (input_shape[1] < 16 || weight_shape[0] < 16) return 0;
+  int out_h = input_shape[2] + 2 * padding[0] - 2;
+  int out_w = input_shape[3] + 2 * padding[1] - 2;
+  if (out_h < 4 || out_w < 4) return 0;
+  return out_h >= 8 && out_w >= 8 ? 4 : 2;
+}
+
+ir::Tensor Conv2d_Winograd_WeightTransform(const ir::Tensor &weight, int tile_size, const std::string &output_name) {
+  CHECK_EQ(weight->shape.size(), 4U) << "Weight's dimension of Winograd conv2d is not 4! Please check.";
+  CHECK(MathEqual(weight->shape[2], Expr(3)) && MathEqual(weight->shape[3], Expr(3)))
+      << "Winograd conv2d only supports the 3x3 filters";
+  auto &G   = GetWinogradMatrices(tile_size).G;
+  int alpha = tile_size + 2;
+  return Compute(
+      {Expr(alpha * alpha), weight->shape[0], weight->shape[1]},
+      [=, &G](Expr xy, Expr k, Expr c) {
+        return WinogradDot(G, xy / alpha, [&](int r) {
+          return WinogradDot(G, xy % alpha, [&](int s) { return weight(k, c, Expr(r), Expr(s)); });
+        });
+      },
+      output_name);
+}
+
+std::vector<ir::Tensor> Conv2d_Winograd_NCHW(const ir::Tensor &input,
+                                             const ir::Tensor &weight_transformed,
+                                             int pad_h,
+                                             int pad_w,
+                                             int tile_size,
+                                             const std::string &output_name) {
+  CHECK_EQ(input->shape.size(), 4U) << "Input's dimension of Winograd conv2d is not 4! Please check.";
+  CHECK_EQ(weight_transformed->shape.size(), 3U) << "The transformed weight of Winograd conv2d should be 3-D";
+  for (auto &dim : input->shape) {
+    CHECK(dim.is_constant()) << "Winograd conv2d only supports the constant shapes";
+  }
+  auto &matrices = GetWinogradMatrices(tile_size);
+  int m          = tile_size;
+  int alpha      = m + 2;
+  int out_h      = input->shape[2].as_int32() + 2 * pad_h - 2;
+  int out_w      = input->shape[3].as_int32() + 2 * pad_w - 2;
+  int tiles_h    = (out_h + m - 1) / m;
+  int tiles_w    = (out_w + m - 1) / m;
+  int num_tiles  = input->shape[0].as_int32() * tiles_h * tiles_w;
+  CHECK(MathEqual(weight_transformed->shape[0], Expr(alpha * alpha)))
+      << "The weight of Winograd conv2d is not transformed to the tile size " << m;
+
+  // the padded input covers all the tiles, some of which may exceed the output
+  auto input_pad = Compute(
+      {input->shape[0], input->shape[1], Expr(tiles_h * m + 2), Expr(tiles_w * m + 2)},
+      [=](Expr nn, Expr cc, Expr yy, Expr xx) {
+        auto cond =
+            lang::logic_and({yy >= pad_h, yy < input->shape[2] + pad_h, xx >= pad_w, xx < input->shape[3] + pad_w});
+        return ir::Select::Make(cond, input(nn, cc, yy - pad_h, xx - pad_w), ir::Zero(input->type()));
+      },
+      UniqName("input_pad"));
+
+  auto &B_T           = matrices.B_T;
+  auto data_transform = Compute(
+      {Expr(alpha * alpha), input->shape[1], Expr(num_tiles)},
+      [=, &B_T](Expr xy, Expr c, Expr p) {
+        Expr nn = p / (tiles_h * tiles_w);
+        Expr yy = p / tiles_w % tiles_h * m;
+        Expr xx = p % tiles_w * m;
+        return WinogradDot(B_T, xy / alpha, [&](int r) {
+          return WinogradDot(B_T, xy % alpha, [&](int s) { return input_pad(nn, c, yy + r, xx + s); });
+        });
+      },
+      UniqName("winograd_data_transform"));
+
+  Var rc(input->shape[1], UniqName("rc"));
+  auto batched_matmul = Compute(
+      {Expr(alpha * alpha), weight_transformed->shape[1], Expr(num_tiles)},
+      [=](Expr xy, Expr k, Expr p) {
+        return lang::ReduceSum(weight_transformed(xy, k, rc) * data_transform(xy, rc, p), {rc});
+      },
+      UniqName("winograd_batched_matmul"));
+
+  auto &A_T = matrices.A_T;
+  auto res  = Compute(
+      {input->shape[0], weight_transformed->shape[1], Expr(out_h), Expr(out_w)},
+      [=, &A_T](Expr nn, Expr k, Expr yy, Expr xx) {
+        Expr p = (nn * tiles_h + yy / m) * tiles_w + xx / m;
+        return WinogradDot(A_T, yy % m, [&](int i) {
+          return WinogradDot(A_T, xx % m, [&](int j) { return batched_matmul(Expr(i * alpha + j), k, p); });
+        });
+      },
+      output_name);
+  return {res, batched_matmul, data_transform, input_pad};
+}
+
+bool UseConv2dIm2col(const std::vector<int> &input_shape,
+                     const std::vector<int> &weight_shape,
+                     const std::vector<int> &padding,
+                     const std::vector<int> &stride,
+                     const std::vector<int> &dilation,
+                     int groups) {
+  if (!FLAGS_cinn_use_im2col_conv2d) return false;
+  if (input_shape.size() != 4 || weight_shape.size() != 4 || groups != 1 || weight_shape[1] != input_shape[1]) {
+    return false;
+  }
+  if (padding.size() != 2 || stride.size() != 2 || dilation.size() != 2) return false;
+  int out_h = (input_shape[2] - ((weight_shape[2] - 1) * dilation[0] + 1) + 2 * padding[0]) / stride[0] + 1;
+  int out_w = (input_shape[3] - ((weight_shape[3] - 1) * dilation[1] + 1) + 2 * padding[1]) / stride[1] + 1;
+  // the GEMM of C_out x (H_out * W_out) x (C_in * filter_h * filter_w) reuses the blocks of both operands in the caches,
+  // while the NCHWc loops over the small images reuse little
+  if (input_shape[1] < 128 || weight_shape[0] < 128 || out_h * out_w > 256) return false;
+  std::string key = GenerateX86ConvKey(input_shape, weight_shape, stride, padding, dilation);
+  return !GetX86ConvParams().count(key);
+}
+
+std::vector<ir::Tensor> Conv2d_Im2col_NCHW(const ir::Tensor &input,
+                                           const ir::Tensor &weights,
+                                           int pad_h,
+                                           int pad_w,
+                                           int stride_h,
+                                           int stride_w,
+                                           int dilation_h,
+                                           int dilation_w,
+                                           const std::string &output_name,
+                                           const common::Target &target) {
+  CHECK_EQ(input->shape.size(), 4U) << "Input's dimension of Conv2d_Im2col_NCHW op is not 4! Please check.";
+  CHECK_EQ(weights->shape.size(), 4U) << "Weight's dimension of Conv2d_Im2col_NCHW op is not 4! Please check.";
+  for (auto &dim : input->shape) {
+    CHECK(dim.is_constant()) << "Conv2d_Im2col_NCHW only supports the constant shapes";
+  }
+  for (auto &dim : weights->shape) {
+    CHECK(dim.is_constant()) << "Conv2d_Im2col_NCHW only supports the constant shapes";
+  }
+  int batch    = input->shape[0].as_int32();
+  int in_c     = input->shape[1].as_int32();
+  int in_h     = input->shape[2].as_int32();
+  int in_w     = input->shape[3].as_int32();
+  int out_c    = weights->shape[0].as_int32();
+  int kernel_h = weights->shape[2].as_int32();
+  int kernel_w = weights->shape[3].as_int32();
+  CHECK_EQ(weights->shape[1].as_int32(), in_c) << "Conv2d_Im2col_NCHW does not support the group convolution";
+  int out_h = (in_h - ((kernel_h - 1) * dilation_h + 1) + 2 * pad_h) / stride_h + 1;
+  int out_w = (in_w - ((kernel_w - 1) * dilation_w + 1) + 2 * pad_w) / stride_w + 1;
+  int rows  = in_c * kernel_h * kernel_w;
+
+  ir::Tensor input_pad = Compute(
+      {Expr(batch), Expr(in_c), Expr(in_h + 2 * pad_h), Expr(in_w + 2 * pad_w)},
+      [=](Expr nn, Expr cc, Expr yy, Expr xx) {
+        if (pad_h == 0 && pad_w == 0) return input(nn, cc, yy, xx);
+        auto cond = lang::logic_and({yy >= pad_h, yy < in_h + pad_h, xx >= pad_w, xx < in_w + pad_w});
+        return ir::Select::Make(cond, input(nn, cc, yy - pad_h, xx - pad_w), ir::Zero(input->type()));
+      },
+      UniqName("input_pad"));
+  // the row r of the im2col is (c, ry, rx) and the column p is (yy, xx) of the output
+  ir::Tensor im2col = Compute(
+      {Expr(batch), Expr(rows), Expr(out_h * out_w)},
+      [=](Expr nn, Expr r, Expr p) {
+        Expr cc = r / (kernel_h * kernel_w);
+        Expr ry = r / kernel_w % kernel_h;
+        Expr rx = r % kernel_w;
+        Expr yy = p / out_w * stride_h + ry * dilation_h;
+        Expr xx = p % out_w * stride_w + rx * dilation_w;
+        return input_pad(nn, cc, yy, xx);
+      },
+      UniqName("im2col"));
+  ir::Tensor weights_3d = Compute(
+      {Expr(1), Expr(out_c), Expr(rows)},
+      [=](Expr nn, Expr ff, Expr r) {
+        return weights(ff, r / (kernel_h * kernel_w), r / kernel_w % kernel_h, r % kernel_w);
+      },
+      UniqName("weights_3d"));
+
+  auto gemm = MatmulPacked(weights_3d, im2col, false, false, 1, UniqName("conv2d_gemm"), target);
+  CHECK_EQ(gemm.size(), 3U);
+  // the packed im2col is recomputed for each input, so it is a temporary tensor as the packed weights
+  gemm[1]->WithBuffer("global", "_" + gemm[1]->name + "_temp_buffer");
+  auto res = Compute(
+      {Expr(batch), Expr(out_c), Expr(out_h), Expr(out_w)},
+      [=](Expr nn, Expr ff, Expr yy, Expr xx) { return gemm[0](nn, ff, yy * out_w + xx); },
+      output_name);
+  return {res, gemm[0], gemm[1], gemm[2], im2col, input_pad, weights_3d};
+}
+
+bool UseConv2dImplicitGemm(const std::vector<int> &input_shape,
+                           const std::vector<int> &weight_shape,
+                           const std::vector<int> &padding,
+                           const std::vector<int> &stride,
+                           const std::vector<int> &dilation,
+                           int groups) {
+  if (!FLAGS_cinn_use_implicit_gemm_conv2d) return false;
+  if (input_shape.size() != 4 || weight_shape.size() != 4 || groups != 1 || weight_shape[1] != input_shape[1]) {
+    return false;
+  }
+  if (padding.size() != 2 || stride.size() != 2 || dilation.size() != 2) return false;
+  for (auto &shape : {input_shape, weight_shape}) {
+    if (std::any_of(shape.begin(), shape.end(), [](int dim) { return dim <= 0; })) return false;
+  }
+  // the tiles of the GEMM take up to 64 rows of the output channels and 8 of the reduced elements per step, the
+  // smaller convs leave most of the threads of a block idle
+  int rows = weight_shape[1] * weight_shape[2] * weight_shape[3];
+  return weight_shape[0] >= 32 && rows >= 32;
+}
+
+std::vector<ir::Tensor> Conv2d_ImplicitGemm_NCHW(const ir::Tensor &input,
+                                                 const ir::Tensor &weights,
+                                                 int pad_h,
+                                                 int pad_w,
+                                                 int stride_h,
+                                                 int stride_w,
+                                                 int dilation_h,
+                                                 int dilation_w,
+                                                 const std::string &output_name) {
+  CHECK_EQ(input->shape.size(), 4U) << "Input's dimension of Conv2d_ImplicitGemm_NCHW op is not 4! Please check.";
+  CHECK_EQ(weights->shape.size(), 4U) << "Weight's dimension of Conv2d_ImplicitGemm_NCHW op is not 4! Please check.";
+  for (auto &dim : input->shape) {
+    CHECK(dim.is_constant()) << "Conv2d_ImplicitGemm_NCHW only supports the constant shapes";
+  }
+  for (auto &dim : weights->shape) {
+    CHECK(dim.is_constant()) << "Conv2d_ImplicitGemm_NCHW only supports the constant shapes";
+  }
+  int batch    = input->shape[0].as_int32();
+  int in_c     = input->shape[1].as_int32();
+  int in_h     = input->shape[2].as_int32();
+  int in_w     = input->shape[3].as_int32();
+  int out_c    = weights->shape[0].as_int32();
+  int kernel_h = weights->shape[2].as_int32();
+  int kernel_w = weights->shape[3].as_int32();
+  CHECK_EQ(weights->shape[1].as_int32(), in_c) << "Conv2d_ImplicitGemm_NCHW does not support the group convolution";
+  int out_h = (in_h - ((kernel_h - 1) * dilation_h + 1) + 2 * pad_h) / stride_h + 1;
+  int out_w = (in_w - ((kernel_w - 1) * dilation_w + 1) + 2 * pad_w) / stride_w + 1;
+  int rows  = in_c * kernel_h * kernel_w;
+
+  ir::Tensor input_pad = Compute(
+      {Expr(batch), Expr(in_c), Expr(in_h + 2 * pad_h), Expr(in_w + 2 * pad_w)},
+      [=](Expr nn, Expr cc, Expr yy, Expr xx) {
+        if (pad_h == 0 && pad_w == 0) return input(nn, cc, yy, xx);
+        auto cond = lang::logic_and({yy >= pad_h, yy < in_h + pad_h, xx >= pad_w, xx < in_w + pad_w});
+        return ir::Select::Make(cond, input(nn, cc, yy - pad_h, xx - pad_w), ir::Zero(input->type()));
+      },
+      UniqName("input_pad"));
+  // the row r of the im2col is (c, ry, rx) and the column p is (yy, xx) of the output
+  ir::Tensor im2col = Compute(
+      {Expr(batch), Expr(rows), Expr(out_h * out_w)},
+      [=](Expr nn, Expr r, Expr p) {
+        Expr cc = r / (kernel_h * kernel_w);
+        Expr ry = r / kernel_w % kernel_h;
+        Expr rx = r % kernel_w;
+        Expr yy = p / out_w * stride_h + ry * dilation_h;
+        Expr xx = p % out_w * stride_w + rx * dilation_w;
+        return input_pad(nn, cc, yy, xx);
+      },
+      UniqName("im2col"));
+  ir::Tensor weights_2d = Compute(
+      {Expr(out_c), Expr(rows)},
+      [=](Expr ff, Expr r) { return weights(ff, r / (kernel_h * kernel_w), r / kernel_w % kernel_h, r % kernel_w); },
+      UniqName("weights_2d"));
+
+  Var rk(Expr(rows), UniqName("rk"));
+  ir::Tensor gemm = Compute(
+      {Expr(batch), Expr(out_c), Expr(out_h * out_w)},
+      [=](Expr nn, Expr ff, Expr p) { return lang::ReduceSum(weights_2d(ff, rk) * im2col(nn, rk, p), {rk}); },
+      UniqName("conv2d_implicit_gemm"));
+  auto res = Compute(
+      {Expr(batch), Expr(out_c), Expr(out_h), Expr(out_w)},
+      [=](Expr nn, Expr ff, Expr yy, Expr xx) { return gemm(nn, ff, yy * out_w + xx); },
+      output_name);
+  return {res, gemm, im2col, input_pad, weights_2d};
+}
+
 std::vector<Tensor> Depthwise_Conv2d_NCHW(const Tensor &input,
                                           const Tensor &weight,
                                           int pad_h,
@@ -466,6 +864,66 @@ std::vector<Tensor> Depthwise_Conv2d_NHWC(const Tensor &input,
   return {res, input_pad};
 }
 
+std::vector<Tensor> Depthwise_Conv2d_NCHWc_Row(const Tensor &input,
+                                               const Tensor &weight,
+                                               int pad_h,
+                                               int pad_w,
+                                               int stride_h,
+                                               int stride_w,
+                                               int dilation_h,
+                                               int dilation_w,
+                                               int c_bn,
+                                               const std::string &output_name) {
+  CHECK_EQ(input->shape.size(), 4U) << "Input's dimension of Depthwise_Conv2d_NCHWc_Row is not 4! Please check.";
+  CHECK_EQ(weight->shape.size(), 4U) << "Weight's dimension of Depthwise_Conv2d_NCHWc_Row is not 4! Please check.";
+  for (auto &dim : input->shape) {
+    CHECK(dim.is_constant()) << "Depthwise_Conv2d_NCHWc_Row only supports the constant shapes";
+  }
+  int batch    = input->shape[0].as_int32();
+  int channel  = input->shape[1].as_int32();
+  int in_h     = input->shape[2].as_int32();
+  int in_w     = input->shape[3].as_int32();
+  int kernel_h = weight->shape[2].as_int32();
+  int kernel_w = weight->shape[3].as_int32();
+  CHECK_EQ(weight->shape[0].as_int32(), channel) << "The weight of Depthwise_Conv2d_NCHWc_Row should have C channels";
+  CHECK_EQ(weight->shape[1].as_int32(), 1) << "Depthwise_Conv2d_NCHWc_Row does not support the channel multiplier";
+  CHECK_EQ(channel % c_bn, 0) << "The channels " << channel << " are not divisible by the block " << c_bn;
+  int c_chunk = channel / c_bn;
+  int out_h   = (in_h - ((kernel_h - 1) * dilation_h + 1) + 2 * pad_h) / stride_h + 1;
+  int out_w   = (in_w - ((kernel_w - 1) * dilation_w + 1) + 2 * pad_w) / stride_w + 1;
+
+  auto input_pad = Compute(
+      {Expr(batch), Expr(c_chunk), Expr(in_h + 2 * pad_h), Expr(in_w + 2 * pad_w), Expr(c_bn)},
+      [=](Expr nn, Expr cc, Expr yy, Expr xx, Expr cb) {
+        Expr value = input(nn, cc * c_bn + cb, yy - pad_h, xx - pad_w);
+        if (pad_h == 0 && pad_w == 0) return value;
+        auto cond = lang::logic_and({yy >= pad_h, yy < in_h + pad_h, xx >= pad_w, xx < in_w + pad_w});
+        return ir::Select::Make(cond, value, ir::Zero(input->type()));
+      },
+      UniqName("input_pad_nchwc"));
+  auto weight_packed = Compute(
+      {Expr(c_chunk), Expr(kernel_h), Expr(kernel_w), Expr(c_bn)},
+      [=](Expr cc, Expr ry, Expr rx, Expr cb) { return weight(cc * c_bn + cb, Expr(0), ry, rx); },
+      UniqName("weights_packed"));
+
+  Var ry(kernel_h, UniqName("ry"));
+  Var rx(kernel_w, UniqName("rx"));
+  auto packed_out = Compute(
+      {Expr(batch), Expr(c_chunk), Expr(out_h), Expr(out_w), Expr(c_bn)},
+      [=](Expr nn, Expr cc, Expr yy, Expr xx, Expr cb) {
+        return lang::ReduceSum(
+            input_pad(nn, cc, yy * stride_h + ry * dilation_h, xx * stride_w + rx * dilation_w, cb) *
+                weight_packed(cc, ry, rx, cb),
+            {ry, rx});
+      },
+      UniqName("packed_out"));
+  auto res = Compute(
+      {Expr(batch), Expr(channel), Expr(out_h), Expr(out_w)},
+      [=](Expr nn, Expr ff, Expr yy, Expr xx) { return packed_out(nn, ff / c_bn, yy, xx, ff % c_bn); },
+      output_name);
+  return {res, packed_out, weight_packed, input_pad};
+}
+
 /**
  * Can be used as a normalizer function for convolution or fully_connected operations.
  * Specified for NCHW layout.
@@ -497,6 +955,27 @@ ir::Tensor BatchNorm_NCHW(const ir::Tensor &input,
   return res;
 }
 
+ir::Tensor BatchNorm_NHWC(const ir::Tensor &input,
+                          const ir::Tensor &scale,
+                          const ir::Tensor &bias,
+                          const ir::Tensor &mean,
+                          const ir::Tensor &variance,
+                          float epsilon,
+                          const std::string &output_name) {
+  CHECK_EQ(input->shape.size(), 4U) << "Input's dimension of BatchNorm op is not 4! Please check.";
+  CHECK_EQ(scale->shape.size(), 1U) << "Scale's dimension of BatchNorm op is not 1! Please check.";
+  CHECK_EQ(bias->shape.size(), 1U) << "Bias's dimension of BatchNorm op is not 1! Please check.";
+  CHECK_EQ(mean->shape.size(), 1U) << "Mean's dimension of BatchNorm op is not 1! Please check.";
+  CHECK_EQ(variance->shape.size(), 1U) << "Variance's dimension of BatchNorm op is not 1! Please check.";
+  auto res = Compute(
+      input->shape,
+      [=](Expr n, Expr h, Expr w, Expr c) {
+        return (input(n, h, w, c) - mean(c)) * scale(c) / lang::Sqrt(variance(c) + Expr(epsilon)) + bias(c);
+      },
+      UniqName(output_name));
+  return res;
+}
+
 ir::Tensor BatchNorm_NCHWc(const ir::Tensor &input,
                            const ir::Tensor &scale,
                            const ir::Tensor &bias,
@@ -521,6 +1000,97 @@ ir::Tensor BatchNorm_NCHWc(const ir::Tensor &input,
   return res;
 }
 
+namespace {
+//! The threads of the block reducing the statistics of a channel by cinn_cuda_batch_norm_stats_fp32 on NVGPU.
+constexpr int kCudaBatchNormThreads = 512;
+}  // namespace
+
+std::vector<ir::Tensor> BatchNormTrain(const ir::Tensor &input,
+                                       const ir::Tensor &scale,
+                                       const ir::Tensor &bias,
+                                       const ir::Tensor &moving_mean,
+                                       const ir::Tensor &moving_variance,
+                                       float epsilon,
+                                       float momentum,
+                                       const std::string &data_layout,
+                                       bool fuse_relu,
+                                       const common::Target &target,
+                                       const std::string &output_name) {
+  CHECK(input->type().is_float(32)) << "batch_norm_train only supports float32 now";
+  CHECK_EQ(input->shape.size(), 4U) << "Input's dimension of BatchNorm op is not 4! Please check.";
+  int channel_axis = 0;
+  if (data_layout == "NCHW") {
+    channel_axis = 1;
+  } else if (data_layout == "NHWC") {
+    channel_axis = 3;
+  } else {
+    LOG(FATAL) << data_layout << " setting is not support!";
+  }
+  // the input is viewed as [outer, channels, inner]
+  Expr outer(1), inner(1);
+  for (int i = 0; i < 4; i++) {
+    if (i < channel_axis) outer = outer * input->shape[i];
+    if (i > channel_axis) inner = inner * input->shape[i];
+  }
+  outer         = common::AutoSimplify(outer);
+  inner         = common::AutoSimplify(inner);
+  Expr channels = input->shape[channel_axis];
+
+  ir::Tensor call;
+  if (target.arch == common::Target::Arch::NVGPU) {
+    // every thread of the block of a channel calls the reduction, which is cooperative
+    call = Compute(
+        {channels, Expr(kCudaBatchNormThreads)},
+        [=](Expr channel, Expr thread) -> Expr {
+          return lang::CallExtern("cinn_cuda_batch_norm_stats_fp32",
+                                  {
+                                      channel,   // channel
+                                      outer,     // outer
+                                      channels,  // channels
+                                      inner,     // inner
+                                      input,     // x
+                                  });
+        },
+        UniqName(output_name + "_stats_call"));
+  } else {
+    call = Compute(
+        {Expr(1)},
+        [=]() -> Expr {
+          return lang::CallExtern("cinn_cpu_batch_norm_stats_fp32",
+                                  {
+                                      outer,     // outer
+                                      channels,  // channels
+                                      inner,     // inner
+                                      input,     // x
+                                  });
+        },
+        UniqName(output_name + "_stats_call"));
+  }
+  auto saved_mean = call->TupleGet(0);
+  saved_mean->WithBuffer(input->type());
+  auto saved_variance = call->TupleGet(1);
+  saved_variance->WithBuffer(input->type());
+
+  auto out = Compute(
+      input->shape,
+      [=](const std::vector<Expr> &indice) {
+        Expr c          = indice[channel_axis];
+        Expr normalized = (input(indice) - saved_mean(c)) * lang::Rsqrt(saved_variance(c) + Expr(epsilon));
+        Expr res        = normalized * scale(c) + bias(c);
+        return fuse_relu ? lang::Relu<float>(res) : res;
+      },
+      output_name);
+  auto new_moving_mean = Compute(
+      {channels},
+      [=](Expr c) { return moving_mean(c) * Expr(momentum) + saved_mean(c) * Expr(1.f - momentum); },
+      UniqName(output_name + "_moving_mean"));
+  auto new_moving_variance = Compute(
+      {channels},
+      [=](Expr c) { return moving_variance(c) * Expr(momentum) + saved_variance(c) * Expr(1.f - momentum); },
+      UniqName(output_name + "_moving_variance"));
+  return {out, saved_mean, saved_variance, new_moving_mean, new_moving_variance, call};
+}
+
 /**
  * This operator implements the softmax layer.
  * @param A The input tensor.
@@ -528,35 +1098,37 @@ ir::Tensor BatchNorm_NCHWc(const ir::Tensor &input,
  * @param output_name The name of output tensor.
  * @return The calculated output tensor.
  */
-std::vector<ir::Tensor> Softmax(const ir::Tensor &A, int axis, const std::string &output_name) {
-  if (axis == -1) {
-    axis = A->shape.size() - 1;
-  }
-  Var reduce_axis(A->shape[axis], UniqName("reduce_axis"));
+namespace {
+//! The sum of \p E along \p axis, the elements are exp(A) or E itself when \p A is undefined.
+ir::Tensor SoftmaxSum(const ir::Tensor &A, const ir::Tensor &E, int axis) {
+  Var reduce_axis(E->shape[axis], UniqName("reduce_axis"));
   std::vector<Expr> new_shapes;
-  for (size_t i = 0; i < A->shape.size(); i++) {
+  for (size_t i = 0; i < E->shape.size(); i++) {
     if (static_cast<int>(i) != axis) {
-      new_shapes.push_back(A->shape[i]);
+      new_shapes.push_back(E->shape[i]);
     }
   }
-  auto temp = Compute(
+  return Compute(
       new_shapes,
       [=](const std::vector<Expr> &indice) {
         std::vector<Expr> new_indice;
         int count = 0;
-        for (size_t i = 0; i < A->shape.size(); i++) {
+        for (size_t i = 0; i < E->shape.size(); i++) {
           if (static_cast<int>(i) != axis) {
             new_indice.push_back(indice[count++]);
           } else {
             new_indice.push_back(reduce_axis);
           }
         }
-        return lang::ReduceSum(lang::Exp(A(new_indice)), {reduce_axis});
+        return lang::ReduceSum(A.defined() ? lang::Exp(A(new_indice)) : E(new_indice), {reduce_axis});
       },
       UniqName("softmax_temp_out"));
+}
 
-  ir::Tensor out = Compute(
-      A->shape,
+//! Divide the elements of \p E, which are exp(A) or E itself when \p A is undefined, by their sum \p temp.
+ir::Tensor SoftmaxDivide(const ir::Tensor &A, const ir::Tensor &E, const ir::Tensor &temp, int axis) {
+  return Compute(
+      E->shape,
       [=](const std::vector<Expr> &indice) {
         std::vector<Expr> new_indice;
         for (size_t i = 0; i < indice.size(); i++) {
@@ -564,12 +1136,70 @@ std::vector<ir::Tensor> Softmax(const ir::Tensor &A, int axis, const std::string
             new_indice.push_back(indice[i]);
           }
         }
-        return lang::Exp(A(indice)) / temp(new_indice);
+        return (A.defined() ? lang::Exp(A(indice)) : E(indice)) / temp(new_indice);
       },
       UniqName("softmax_out"));
+}
+
+//! The log of the sum of exp(A) along \p axis, reduced in a single pass by the online normalizer.
+ir::Tensor SoftmaxLogSumExp(const ir::Tensor &A, int axis) {
+  Var reduce_axis(A->shape[axis], UniqName("reduce_axis"));
+  std::vector<Expr> new_shapes;
+  for (size_t i = 0; i < A->shape.size(); i++) {
+    if (static_cast<int>(i) != axis) {
+      new_shapes.push_back(A->shape[i]);
+    }
+  }
+  return Compute(
+      new_shapes,
+      [=](const std::vector<Expr> &indice) {
+        std::vector<Expr> new_indice(indice);
+        new_indice.insert(new_indice.begin() + axis, reduce_axis);
+        return lang::ReduceLogSumExp(A(new_indice), {reduce_axis});
+      },
+      UniqName("softmax_logsumexp"));
+}
+
+//! exp(A - lse) for the softmax, or A - lse for the log_softmax, where \p lse is the reduction along \p axis.
+ir::Tensor SoftmaxNormalize(
+    const ir::Tensor &A, const ir::Tensor &lse, int axis, bool log, const std::string &output_name) {
+  return Compute(
+      A->shape,
+      [=](const std::vector<Expr> &indice) {
+        std::vector<Expr> new_indice(indice);
+        new_indice.erase(new_indice.begin() + axis);
+        Expr shifted = A(indice) - lse(new_indice);
+        return log ? shifted : lang::Exp(shifted);
+      },
+      output_name);
+}
+}  // namespace
+
+std::vector<ir::Tensor> Softmax(const ir::Tensor &A, int axis, const std::string &output_name) {
+  if (axis == -1) {
+    axis = A->shape.size() - 1;
+  }
+  auto temp      = SoftmaxSum(A, A, axis);
+  ir::Tensor out = SoftmaxDivide(A, A, temp, axis);
   return {out, temp};
 }
 
+std::vector<ir::Tensor> SoftmaxOnline(const ir::Tensor &A, int axis, const std::string &output_name) {
+  if (axis == -1) {
+    axis = A->shape.size() - 1;
+  }
+  auto lse = SoftmaxLogSumExp(A, axis);
+  return {SoftmaxNormalize(A, lse, axis, false, output_name), lse};
+}
+
+std::vector<ir::Tensor> LogSoftmax(const ir::Tensor &A, int axis, const std::string &output_name) {
+  if (axis == -1) {
+    axis = A->shape.size() - 1;
+  }
+  auto lse = SoftmaxLogSumExp(A, axis);
+  return {SoftmaxNormalize(A, lse, axis, true, output_name), lse};
+}
+
 #ifdef CINN_WITH_MKLDNN
 std::vector<ir::Tensor> SoftmaxMKLDNN(const ir::Tensor &A, int axis, const std::string &output_name) {
   CHECK_LE(A->shape.size(), 4U) << "Input's dimension of mkldnn softmax op is less than 4! Please check.";
@@ -601,6 +1231,221 @@ std::vector<ir::Tensor> SoftmaxMKLDNN(const ir::Tensor &A, int axis, const std::
 }
 #endif
 
+namespace {
+
+// The indices of \p B broadcast to the \p indice of a tensor of no lower rank, aligned to the trailing axes, where the
+// axes of extent 1 are broadcast.
+std::vector<Expr> BroadcastIndice(const ir::Tensor &B, const std::vector<Expr> &indice) {
+  CHECK_LE(B->shape.size(), indice.size()) << "The tensor " << B->name << " is of higher rank than its broadcast";
+  std::vector<Expr> res;
+  int offset = indice.size() - B->shape.size();
+  for (int i = 0; i < B->shape.size(); i++) {
+    bool broadcast = B->shape[i].is_constant() && B->shape[i].as_int32() == 1;
+    res.push_back(broadcast ? Expr(0) : indice[offset + i]);
+  }
+  return res;
+}
+
+Expr GeluOf(Expr x, bool approximate) {
+  auto type = x.type();
+  if (approximate) {
+    // 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+    Expr inner = make_const(type, 0.7978845608f) * (x + make_const(type, 0.044715f) * x * x * x);
+    return make_const(type, 0.5f) * x * (make_const(type, 1.f) + lang::Tanh(inner));
+  }
+  // 0.5 * x * (1 + erf(x / sqrt(2)))
+  return make_const(type, 0.5f) * x * (make_const(type, 1.f) + lang::Erf(x * make_const(type, 0.7071067812f)));
+}
+
+}  // namespace
+
+std::vector<ir::Tensor> LayerNorm(const ir::Tensor &A,
+                                  const ir::Tensor &scale,
+                                  const ir::Tensor &bias,
+                                  float epsilon,
+                                  int begin_norm_axis,
+                                  const common::Target &target,
+                                  const std::string &output_name) {
+  int rank = A->shape.size();
+  if (begin_norm_axis < 0) begin_norm_axis += rank;
+  CHECK(begin_norm_axis > 0 && begin_norm_axis < rank) << "The begin_norm_axis of layer_norm is out of range";
+  std::vector<Expr> outer_shape(A->shape.begin(), A->shape.begin() + begin_norm_axis);
+  Expr count(1);
+  for (int i = begin_norm_axis; i < rank; i++) count = count * A->shape[i];
+  Expr inv_count = make_const(A->type(), 1.f) / ir::Cast::Make(A->type(), common::AutoSimplify(count));
+
+  // The reduce axes over the normalized axes, each reduction has its own.
+  auto reduce_axes = [=]() {
+    std::vector<Var> axes;
+    for (int i = begin_norm_axis; i < rank; i++) axes.emplace_back(A->shape[i], UniqName("reduce_axis"));
+    return axes;
+  };
+  auto full_indice = [=](const std::vector<Expr> &outer, const std::vector<Var> &axes) {
+    std::vector<Expr> indice(outer);
+    indice.insert(indice.end(), axes.begin(), axes.end());
+    return indice;
+  };
+
+  ir::Tensor mean, variance;
+  std::vector<ir::Tensor> moments;
+  if (target.arch == common::Target::Arch::NVGPU) {
+    // The sum and the sum of the squares are reduced from the same single pass over the row, each by a block over the
+    // flattened normalized axes, then the variance is E(x^2) - E(x)^2.
+    auto row_indice = [=](const std::vector<Expr> &outer, const Var &k) {
+      std::vector<Expr> indice(rank);
+      std::copy(outer.begin(), outer.end(), indice.begin());
+      Expr rest = k;
+      for (int i = rank - 1; i >= begin_norm_axis; i--) {
+        indice[i] = i == begin_norm_axis ? rest : rest % A->shape[i];
+        rest      = rest / A->shape[i];
+      }
+      return indice;
+    };
+    Expr numel = common::AutoSimplify(count);
+    Var k_sum(numel, UniqName("reduce_axis"));
+    auto sum = Compute(
+        outer_shape,
+        [=](const std::vector<Expr> &indice) { return lang::ReduceSum(A(row_indice(indice, k_sum)), {k_sum}); },
+        UniqName("layer_norm_sum"));
+    Var k_sq(numel, UniqName("reduce_axis"));
+    auto sum_sq = Compute(
+        outer_shape,
+        [=](const std::vector<Expr> &indice) {
+          auto row = row_indice(indice, k_sq);
+          return lang::ReduceSum(A(row) * A(row), {k_sq});
+        },
+        UniqName("layer_norm_sum_sq"));
+    mean = Compute(
+        outer_shape,
+        [=](const std::vector<Expr> &indice) { return sum(indice) * inv_count; },
+        UniqName("layer_norm_mean"));
+    variance = Compute(
+        outer_shape,
+        [=](const std::vector<Expr> &indice) {
+          Expr second_moment = sum_sq(indice) * inv_count;
+          return ir::Max::Make(second_moment - mean(indice) * mean(indice), make_const(A->type(), 0.f));
+        },
+        UniqName("layer_norm_variance"));
+    moments = {sum, sum_sq};
+  } else {
+    auto mean_axes = reduce_axes();
+    mean           = Compute(
+        outer_shape,
+        [=](const std::vector<Expr> &indice) {
+          return lang::ReduceSum(A(full_indice(indice, mean_axes)) * inv_count, {mean_axes.begin(), mean_axes.end()});
+        },
+        UniqName("layer_norm_mean"));
+    auto var_axes = reduce_axes();
+    variance      = Compute(
+        outer_shape,
+        [=](const std::vector<Expr> &indice) {
+          Expr diff = A(full_indice(indice, var_axes)) - mean(indice);
+          return lang::ReduceSum(diff * diff * inv_count, {var_axes.begin(), var_axes.end()});
+        },
+        UniqName("layer_norm_variance"));
+  }
+
+  auto out = Compute(
+      A->shape,
+      [=](const std::vector<Expr> &indice) {
+        std::vector<Expr> outer(indice.begin(), indice.begin() + begin_norm_axis);
+        std::vector<Expr> inner(indice.begin() + begin_norm_axis, indice.end());
+        // the scale and the bias of Paddle are flattened over the normalized axes
+        auto param_indice = [&](const ir::Tensor &param) -> std::vector<Expr> {
+          if (param->shape.size() == inner.size()) return inner;
+          CHECK_EQ(param->shape.size(), 1UL) << "The scale and bias of layer_norm should be flattened or normalized";
+          Expr flat(0);
+          for (int i = begin_norm_axis; i < rank; i++) flat = flat * A->shape[i] + indice[i];
+          return {flat};
+        };
+        Expr normalized = (A(indice) - mean(outer)) * lang::Rsqrt(variance(outer) + make_const(A->type(), epsilon));
+        return normalized * scale(param_indice(scale)) + bias(param_indice(bias));
+      },
+      output_name);
+  std::vector<ir::Tensor> res{out, mean, variance};
+  res.insert(res.end(), moments.begin(), moments.end());
+  return res;
+}
+
+ir::Tensor Gelu(const ir::Tensor &A, bool approximate, const std::string &output_name) {
+  return Compute(
+      A->shape, [=](const std::vector<Expr> &indice) { return GeluOf(A(indice), approximate); }, output_name);
+}
+
+ir::Tensor BiasGelu(const ir::Tensor &A, const ir::Tensor &bias, bool approximate, const std::string &output_name) {
+  return Compute(
+      A->shape,
+      [=](const std::vector<Expr> &indice) {
+        return GeluOf(A(indice) + bias(BroadcastIndice(bias, indice)), approximate);
+      },
+      output_name);
+}
+
+std::vector<ir::Tensor> SoftmaxMask(const ir::Tensor &A,
+                                    const ir::Tensor &mask,
+                                    float scale,
+                                    const common::Target &target,
+                                    const std::string &output_name) {
+  auto masked = Compute(
+      A->shape,
+      [=](const std::vector<Expr> &indice) {
+        return A(indice) * make_const(A->type(), scale) + mask(BroadcastIndice(mask, indice));
+      },
+      UniqName("softmax_mask_in"));
+  int axis = A->shape.size() - 1;
+  auto res = target.arch == common::Target::Arch::NVGPU ? SoftmaxOnline(masked, axis, output_name)
+                                                         : Softmax(masked, axis, output_name);
+  res.insert(res.begin() + 2, masked);
+  return res;
+}
+
+std::vector<ir::Tensor> MultiHeadAttention(const ir::Tensor &Q,
+                                           const ir::Tensor &K,
+                                           const ir::Tensor &V,
+                                           const ir::Tensor &mask,
+                                           int num_heads,
+                                           float scale,
+                                           const std::string &output_name) {
+  CHECK_EQ(Q->shape.size(), 3UL) << "The query of the attention should be in [batch, seq, hidden]";
+  CHECK(Q->shape[2].is_constant()) << "The hidden size of the attention should be constant";
+  int hidden = Q->shape[2].as_int32();
+  CHECK_EQ(hidden % num_heads, 0) << "The hidden size " << hidden << " is not divisible by " << num_heads << " heads";
+  int head_dim = hidden / num_heads;
+  if (scale == 0.f) scale = 1.f / std::sqrt(static_cast<float>(head_dim));
+  Expr batch = Q->shape[0], seq_q = Q->shape[1], seq_k = K->shape[1];
+  auto type  = Q->type();
+
+  Var d(Expr(head_dim), UniqName("reduce_axis"));
+  auto scores = Compute(
+      {batch, Expr(num_heads), seq_q, seq_k},
+      [=](Expr b, Expr h, Expr i, Expr j) {
+        Expr n = h * head_dim + d;
+        return lang::ReduceSum(Q(b, i, n) * K(b, j, n), {d});
+      },
+      UniqName("attention_scores"));
+  auto exp = Compute(
+      scores->shape,
+      [=](const std::vector<Expr> &indice) {
+        Expr x = scores(indice) * make_const(type, scale);
+        if (mask.defined()) x = x + mask(BroadcastIndice(mask, indice));
+        return lang::Exp(x);
+      },
+      UniqName("attention_exp"));
+  Var j(seq_k, UniqName("reduce_axis"));
+  auto sum = Compute(
+      {batch, Expr(num_heads), seq_q},
+      [=](Expr b, Expr h, Expr i) { return lang::ReduceSum(exp(b, h, i, j), {j}); },
+      UniqName("attention_sum"));
+  Var k(seq_k, UniqName("reduce_axis"));
+  auto context = Compute(
+      Q->shape,
+      [=](Expr b, Expr i, Expr n) { return lang::ReduceSum(exp(b, n / head_dim, i, k) * V(b, k, n), {k}); },
+      UniqName("attention_context"));
+  auto out = Compute(
+      Q->shape, [=](Expr b, Expr i, Expr n) { return context(b, i, n) / sum(b, n / head_dim, i); }, output_name);
+  return {out, context, sum, exp, scores};
+}
+
 ir::Tensor Slice(const ir::Tensor &A,
                  const std::vector<int> &starts,
                  const std::vector<int> &axes,
@@ -973,6 +1818,166 @@ std::vector<Tensor> Pool2d(const Tensor &tensor,
                   UniqName(output_name));
 }
 
+namespace {
+// The height and width axes of a tensor of \p data_format.
+std::pair<int, int> GetPool2dAxes(const std::string &data_format) {
+  if (data_format == "NCHW" || data_format == "AnyLayout") return {2, 3};
+  if (data_format == "NHWC") return {1, 2};
+  LOG(FATAL) << "Unsupported data format: " << data_format << std::endl;
+  return {-1, -1};
+}
+}  // namespace
+
+bool IsSeparablePool2d(const std::vector<int> &kernel_size, const std::vector<int> &stride_size) {
+  return kernel_size.size() == 2U && stride_size.size() == 2U && stride_size[0] == 1 && stride_size[1] == 1 &&
+         kernel_size[0] > 1 && kernel_size[1] > 1 && kernel_size[0] * kernel_size[1] >= 16;
+}
+
+std::vector<Tensor> SeparablePool2d(const Tensor &tensor,
+                                    const std::vector<int> &kernel_size,
+                                    const std::vector<int> &stride_size,
+                                    const std::vector<int> &padding_size,
+                                    const std::string &pool_type,
+                                    bool ceil_mode,
+                                    bool exclusive,
+                                    const std::string &data_format,
+                                    const std::string &output_name) {
+  CHECK(pool_type == "max" || pool_type == "avg") << "Unrecognized pool_type: " << pool_type;
+  CHECK_EQ(kernel_size.size(), 2U) << "Pooling kernel_size must have 2 elements\n";
+  CHECK_EQ(stride_size.size(), 2U) << "Pooling stride_size must have 2 elements\n";
+  CHECK_EQ(padding_size.size(), 4U) << "Pooling padding_size must have 4 elements\n";
+  auto axes             = GetPool2dAxes(data_format);
+  std::vector<int> axis = {axes.first, axes.second};
+  int x_size            = tensor->shape.size();
+
+  std::vector<Expr> kernel(2), stride(2), pad_head(2);
+  std::vector<Expr> pad_before(x_size, Expr(0));
+  std::vector<Expr> pad_after(x_size, Expr(0));
+  std::vector<Expr> out_shape = tensor->shape;
+  bool do_pad                 = ceil_mode && stride_size[0] > 1;
+  for (int i = 0; i < 2; i++) {
+    int ii        = axis[i];
+    kernel[i]     = Expr(kernel_size[i]);
+    stride[i]     = Expr(stride_size[i]);
+    pad_head[i]   = Expr(padding_size[i]);
+    Expr pad_tail = Expr(padding_size[i + 2]);
+    do_pad        = do_pad || padding_size[i] || padding_size[i + 2];
+    if (ceil_mode) pad_tail = common::AutoSimplify(pad_tail + stride[i] - 1);
+    pad_before[ii] = pad_head[i];
+    pad_after[ii]  = pad_tail;
+    out_shape[ii]  = common::AutoSimplify((tensor->shape[ii] - kernel[i] + pad_head[i] + pad_tail) / stride[i] + 1);
+  }
+
+  bool is_max    = pool_type == "max";
+  Expr min_value = lang::min_value(tensor->type());
+  Tensor temp    = tensor;
+  if (do_pad) {
+    temp = Pad(tensor, pad_before, pad_after, is_max ? min_value : Expr(0), UniqName("pad_temp"));
+  }
+  // the windows of the width first, keeping the padded height
+  std::vector<Expr> rows_shape = temp->shape;
+  rows_shape[axis[1]]          = out_shape[axis[1]];
+  Var kernel_w(kernel[1], UniqName("kernel_idx"));
+  auto rows = Compute(
+      rows_shape,
+      [=](const std::vector<Expr> &output) {
+        std::vector<Expr> indices(output.begin(), output.end());
+        indices[axis[1]] = output[axis[1]] * stride[1] + kernel_w;
+        return is_max ? lang::ReduceMax(temp(indices), {kernel_w}, min_value)
+                      : lang::ReduceSum(temp(indices), {kernel_w});
+      },
+      UniqName(output_name + "_rows"));
+
+  Var kernel_h(kernel[0], UniqName("kernel_idx"));
+  auto res = Compute(
+      out_shape,
+      [=](const std::vector<Expr> &output) {
+        std::vector<Expr> indices(output.begin(), output.end());
+        indices[axis[0]] = output[axis[0]] * stride[0] + kernel_h;
+        if (is_max) return lang::ReduceMax(rows(indices), {kernel_h}, min_value);
+        auto divide_factor = kernel[0] * kernel[1];
+        if (exclusive) {
+          // the elements of the window within the input, which is the product of the ones of the height and width
+          divide_factor = make_const(Int(32), 1);
+          for (int i = 0; i < 2; i++) {
+            int ii        = axis[i];
+            Expr start    = common::AutoSimplify(output[ii] * stride[i] - pad_head[i]);
+            Expr end      = Min::Make(start + kernel[i], tensor->shape[ii]);
+            start         = Max::Make(start, make_const(Int(32), 0));
+            divide_factor = divide_factor * (end - start);
+          }
+          divide_factor = Max::Make(divide_factor, make_const(Int(32), 1));
+        }
+        return lang::ReduceSum(ir::Div::Make(rows(indices), cast(divide_factor, Float(32))), {kernel_h});
+      },
+      UniqName(output_name));
+  if (do_pad) {
+    return {res, rows, temp};
+  } else {
+    return {res, rows};
+  }
+}
+
+std::vector<Tensor> GlobalPool2d(const Tensor &tensor,
+                                 const std::string &pool_type,
+                                 const std::string &data_format,
+                                 int num_parts,
+                                 bool interleave_parts,
+                                 const std::string &output_name) {
+  CHECK(pool_type == "max" || pool_type == "avg") << "Unrecognized pool_type: " << pool_type;
+  auto axes       = GetPool2dAxes(data_format);
+  int height_axis = axes.first;
+  int width_axis  = axes.second;
+  CHECK(tensor->shape[height_axis].is_constant() && tensor->shape[width_axis].is_constant())
+      << "The global pooling needs the height and width of constant extents";
+  int height = tensor->shape[height_axis].as_int32();
+  int width  = tensor->shape[width_axis].as_int32();
+  bool is_max             = pool_type == "max";
+  std::string reduce_name = is_max ? output_name : output_name + "_sum";
+
+  std::vector<Tensor> partials;
+  Tensor reduced;
+  if (num_parts > 1) {
+    CHECK_EQ(width_axis, static_cast<int>(tensor->shape.size()) - 1)
+        << "The global pooling is reduced in parts only if the height and width are the trailing axes";
+    ReduceFunc reduce_func = is_max ? ReduceFunc(ReduceMax) : ReduceFunc(ReduceSum);
+    auto outs = TwoStageReduce(tensor, {height_axis, width_axis}, reduce_func, num_parts, true, reduce_name,
+                               interleave_parts);
+    reduced   = outs[0];
+    partials  = {outs[1], outs[2]};
+  } else {
+    std::vector<Expr> out_shape = tensor->shape;
+    out_shape[height_axis]      = Expr(1);
+    out_shape[width_axis]       = Expr(1);
+    Var kernel_idx(Expr(height * width), UniqName("kernel_idx"));
+    Expr min_value = lang::min_value(tensor->type());
+    reduced        = Compute(
+        out_shape,
+        [=](const std::vector<Expr> &output) {
+          std::vector<Expr> indices(output.begin(), output.end());
+          indices[height_axis] = Expr(kernel_idx) / width;
+          indices[width_axis]  = Expr(kernel_idx) % width;
+          return is_max ? lang::ReduceMax(tensor(indices), {kernel_idx}, min_value)
+                        : lang::ReduceSum(tensor(indices), {kernel_idx});
+        },
+        reduce_name);
+  }
+
+  std::vector<Tensor> res;
+  if (!is_max) {
+    // the elements are summed before divided, so that the reduction loads them only
+    res.push_back(Compute(
+        reduced->shape,
+        [=](const std::vector<Expr> &output) {
+          return ir::Div::Make(reduced(output), cast(Expr(height * width), reduced->type()));
+        },
+        output_name));
+  }
+  res.push_back(reduced);
+  res.insert(res.end(), partials.begin(), partials.end());
+  return res;
+}
+
 std::vector<Tensor> Pool3d(const Tensor &tensor,
                            const std::vector<int> &kernel_size,
                            const std::vector<int> &stride_size,
@@ -1026,6 +2031,28 @@ Tensor DropoutInfer(const ir::Tensor &tensor,
   }
 }
 
+Tensor Dropout(const ir::Tensor &tensor,
+               const ir::Tensor &seed_offset,
+               float dropout_prob,
+               const std::string &dropout_implementation,
+               const std::string &output_name) {
+  CHECK_EQ(seed_offset->type(), Int(32)) << "The seed_offset of dropout should be int32";
+  CHECK(dropout_prob >= 0.f && dropout_prob < 1.f) << "The dropout_prob should be in [0, 1)";
+  CHECK(dropout_implementation == "downgrade_in_infer" || dropout_implementation == "upscale_in_train")
+      << "dropout_implementation attr must be 'downgrade_in_infer' or 'upscale_in_train'\n";
+  float scale = dropout_implementation == "upscale_in_train" ? 1.f / (1.f - dropout_prob) : 1.f;
+  return Compute(
+      tensor->shape,
+      [=](const std::vector<Expr> &indice) {
+        Expr index = indice.front();
+        for (int i = 1; i < indice.size(); i++) index = index * tensor->shape[i] + indice[i];
+        auto uniform = lang::PhiloxUniform(seed_offset(Expr(0)), seed_offset(Expr(1)), index);
+        auto scaled  = tensor(indice) * make_const(tensor->type(), scale);
+        return ir::Select::Make(uniform >= Expr(dropout_prob), scaled, make_const(tensor->type(), 0));
+      },
+      output_name);
+}
+
 ir::Tensor Select(const ir::Tensor &condition,
                   const ir::Tensor &true_value,
                   const ir::Tensor &false_value,
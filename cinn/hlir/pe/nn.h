@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <gflags/gflags.h>
+
 #include <string>
 #include <vector>
 
@@ -22,6 +24,10 @@
 #include "cinn/lang/compute.h"
 #include "cinn/poly/stage.h"
 
+DECLARE_bool(cinn_use_winograd_conv2d);
+DECLARE_bool(cinn_use_im2col_conv2d);
+DECLARE_bool(cinn_use_implicit_gemm_conv2d);
+
 namespace cinn {
 namespace hlir {
 namespace pe {
@@ -164,6 +170,23 @@ std::vector<ir::Tensor> Conv2d_NCHW_MKLDNN(const ir::Tensor &input,
                                            int dilation_h,
                                            int dilation_w,
                                            const std::string &output_name = UniqName("T_Conv2d_NCHW_out"));
+
+/**
+ * The oneDNN convolution with the post-ops fused, the \p bias {C_out} and the \p residual of the output shape are
+ * added when they are defined, and \p relu is applied last.
+ */
+std::vector<ir::Tensor> Conv2d_NCHW_MKLDNN_PostOps(const ir::Tensor &input,
+                                                   const ir::Tensor &weights,
+                                                   const ir::Tensor &bias,
+                                                   const ir::Tensor &residual,
+                                                   bool relu,
+                                                   int pad_h,
+                                                   int pad_w,
+                                                   int stride_h,
+                                                   int stride_w,
+                                                   int dilation_h,
+                                                   int dilation_w,
+                                                   const std::string &output_name = UniqName("T_Conv2d_NCHW_out"));
 #endif
 
 /**
@@ -192,6 +215,144 @@ std::vector<ir::Tensor> Conv2d_NHWC(const ir::Tensor &input,
                                     int dilation_w,
                                     const std::string &output_name = UniqName("T_Conv2d_NHWC_out"));
 
+/**
+ * @brief The output tile size m of the Winograd conv2d F(m x m, 3 x 3) chosen by the shapes.
+ *
+ * Winograd computes the NCHW 3x3 conv2d of stride 1, dilation 1 and groups 1, with enough channels to amortize the
+ * transforms. The large outputs take F(4x4, 3x3) and the small ones F(2x2, 3x3).
+ *
+ * @return 2 or 4, or 0 when the conv2d does not fit Winograd
+ */
+int GetConv2dWinogradTile(const std::vector<int> &input_shape,
+                          const std::vector<int> &weight_shape,
+                          const std::vector<int> &padding,
+                          const std::vector<int> &stride,
+                          const std::vector<int> &dilation,
+                          int groups);
+
+/**
+ * @brief Transform the weights of the Winograd conv2d F(m x m, 3 x 3), U = G g G^T for each 3x3 filter g.
+ *
+ * @param weight The 4-D weight tensor {C_out, C_in, 3, 3}
+ * @param tile_size The output tile size m
+ * @param output_name The name of the output tensor
+ *
+ * @return the 3-D transformed weight tensor {alpha * alpha, C_out, C_in}, alpha = m + 2
+ */
+ir::Tensor Conv2d_Winograd_WeightTransform(const ir::Tensor &weight,
+                                           int tile_size,
+                                           const std::string &output_name = UniqName("T_Conv2d_winograd_weight"));
+
+/**
+ * @brief Perform the Winograd conv2d F(m x m, 3 x 3) with an NCHW-layout.
+ *
+ * The input is split into the alpha x alpha tiles overlapped by 2, each tile d is transformed to V = B^T d B. For each
+ * of the alpha * alpha positions, the matmul M = U V of the transformed weights and tiles reduces the input channels,
+ * and the m x m output tile is transformed back by Y = A^T M A.
+ *
+ * @param input The 4-D input tensor {N, C_in, H, W}
+ * @param weight_transformed The weight tensor transformed by Conv2d_Winograd_WeightTransform
+ * @param pad_h padding applied to the height of the image
+ * @param pad_w padding applied to the width of the image
+ * @param tile_size The output tile size m
+ * @param output_name The name of the output tensor
+ *
+ * @return {output, M, V, input_pad}, M is {alpha * alpha, C_out, P} and V is {alpha * alpha, C_in, P} for the P tiles
+ */
+std::vector<ir::Tensor> Conv2d_Winograd_NCHW(const ir::Tensor &input,
+                                             const ir::Tensor &weight_transformed,
+                                             int pad_h,
+                                             int pad_w,
+                                             int tile_size,
+                                             const std::string &output_name = UniqName("T_Conv2d_winograd_out"));
+
+/**
+ * @brief Whether the X86 conv2d is computed by the GEMM over its im2col instead of the direct NCHWc convolution.
+ *
+ * The rule takes the convs of many channels and small images, whose NCHWc loops reuse little of the caches, unless their
+ * schedule params are tuned or in the static table of GetX86ConvParams.
+ */
+bool UseConv2dIm2col(const std::vector<int> &input_shape,
+                     const std::vector<int> &weight_shape,
+                     const std::vector<int> &padding,
+                     const std::vector<int> &stride,
+                     const std::vector<int> &dilation,
+                     int groups);
+
+/**
+ * @brief Perform a 2-D convolution with an NCHW-layout by the packed GEMM of MatmulPacked.
+ *
+ * The im2col of the input is [N, C_in * filter_h * filter_w, H_out * W_out], which is read by the packing of the GEMM
+ * directly, so it is never materialized. The GEMM output [N, C_out, H_out * W_out] is reshaped to the output.
+ *
+ * @param input The 4-D input tensor {N, C_in, H, W}
+ * @param weights The 4-D weight tensor {C_out, C_in, filter_h, filter_w}
+ * @param pad_h padding applied to the height of the image
+ * @param pad_w padding applied to the width of the image
+ * @param stride_h striding applied to the height of the image
+ * @param stride_w striding applied to the width of the image
+ * @param dilation_h dilation applied to the height of the image
+ * @param dilation_w dilation applied to the width of the image
+ * @param output_name The name of the output tensor
+ * @param target The X86 target
+ *
+ * @return {output, gemm, packed im2col, packed weights, im2col, input_pad, weights reshaped to 3-D}
+ */
+std::vector<ir::Tensor> Conv2d_Im2col_NCHW(const ir::Tensor &input,
+                                           const ir::Tensor &weights,
+                                           int pad_h,
+                                           int pad_w,
+                                           int stride_h,
+                                           int stride_w,
+                                           int dilation_h,
+                                           int dilation_w,
+                                           const std::string &output_name = UniqName("T_Conv2d_im2col_out"),
+                                           const common::Target &target   = common::DefaultHostTarget());
+
+/**
+ * @brief Whether the NVGPU conv2d is computed by the implicit GEMM of Conv2d_ImplicitGemm_NCHW instead of the direct
+ * convolution of CudaScheduleConv.
+ *
+ * The rule takes the convs whose GEMM of C_out x (H_out * W_out) x (C_in * filter_h * filter_w) fills the tiles of
+ * CudaScheduleMatmul, i.e. those of enough output channels and reduced elements.
+ */
+bool UseConv2dImplicitGemm(const std::vector<int> &input_shape,
+                           const std::vector<int> &weight_shape,
+                           const std::vector<int> &padding,
+                           const std::vector<int> &stride,
+                           const std::vector<int> &dilation,
+                           int groups);
+
+/**
+ * @brief Perform a 2-D convolution with an NCHW-layout by the implicit GEMM on NVGPU.
+ *
+ * The GEMM [N, C_out, H_out * W_out] reduces the weights [C_out, C_in * filter_h * filter_w] times the im2col of the
+ * input [N, C_in * filter_h * filter_w, H_out * W_out]. Both operands are computed inline, so the im2col is never
+ * materialized and its tiles are gathered from the input straight into the shared memory by CudaScheduleMatmul. The
+ * GEMM output is reshaped to the output by another kernel.
+ *
+ * @param input The 4-D input tensor {N, C_in, H, W}
+ * @param weights The 4-D weight tensor {C_out, C_in, filter_h, filter_w}
+ * @param pad_h padding applied to the height of the image
+ * @param pad_w padding applied to the width of the image
+ * @param stride_h striding applied to the height of the image
+ * @param stride_w striding applied to the width of the image
+ * @param dilation_h dilation applied to the height of the image
+ * @param dilation_w dilation applied to the width of the image
+ * @param output_name The name of the output tensor
+ *
+ * @return {output, gemm, im2col, input_pad, weights reshaped to 2-D}
+ */
+std::vector<ir::Tensor> Conv2d_ImplicitGemm_NCHW(const ir::Tensor &input,
+                                                 const ir::Tensor &weights,
+                                                 int pad_h,
+                                                 int pad_w,
+                                                 int stride_h,
+                                                 int stride_w,
+                                                 int dilation_h,
+                                                 int dilation_w,
+                                                 const std::string &output_name = UniqName("T_Conv2d_igemm_out"));
+
 /**
  * @brief Perform a 2-D depthwise convolution with an NCHW-layout
  *
@@ -236,6 +397,37 @@ std::vector<ir::Tensor> Depthwise_Conv2d_NHWC(const ir::Tensor &input,
                                               int stride_w,
                                               const std::string output_name = UniqName("T_depthwise_conv2d_nhwc"));
 
+/**
+ * @brief Perform a 2-D depthwise convolution with an NCHW-layout by the row kernels over the NCHWc blocks of channels.
+ *
+ * The padded input is packed to NCHWc and the weights to [C / c_bn, filter_h, filter_w, c_bn], so that the c_bn
+ * channels of each pixel are a vector, and each row of pixels accumulates its vectors in the registers.
+ *
+ * @param input The 4-D input tensor {N, C, H, W}
+ * @param weight The 4-D weight tensor {C, 1, filter_h, filter_w}
+ * @param pad_h padding applied to the height of the image
+ * @param pad_w padding applied to the width of the image
+ * @param stride_h striding applied to the height of the image
+ * @param stride_w striding applied to the width of the image
+ * @param dilation_h dilation applied to the height of the image
+ * @param dilation_w dilation applied to the width of the image
+ * @param c_bn The block of channels, which divides C
+ * @param output_name The name of the output tensor
+ *
+ * @return {output, packed output, packed weights, packed input_pad}
+ */
+std::vector<ir::Tensor> Depthwise_Conv2d_NCHWc_Row(
+    const ir::Tensor &input,
+    const ir::Tensor &weight,
+    int pad_h,
+    int pad_w,
+    int stride_h,
+    int stride_w,
+    int dilation_h,
+    int dilation_w,
+    int c_bn,
+    const std::string &output_name = UniqName("T_depthwise_conv2d_nchwc_row_out"));
+
 ir::Tensor BatchNorm_NCHW(const ir::Tensor &input,
                           const ir::Tensor &scale,
                           const ir::Tensor &bias,
@@ -244,6 +436,14 @@ ir::Tensor BatchNorm_NCHW(const ir::Tensor &input,
                           float epsilon,
                           const std::string &output_name = UniqName("T_BatchNorm_NCHW_out"));
 
+ir::Tensor BatchNorm_NHWC(const ir::Tensor &input,
+                          const ir::Tensor &scale,
+                          const ir::Tensor &bias,
+                          const ir::Tensor &mean,
+                          const ir::Tensor &variance,
+                          float epsilon,
+                          const std::string &output_name = UniqName("T_BatchNorm_NHWC_out"));
+
 ir::Tensor BatchNorm_NCHWc(const ir::Tensor &input,
                            const ir::Tensor &scale,
                            const ir::Tensor &bias,
@@ -252,6 +452,25 @@ ir::Tensor BatchNorm_NCHWc(const ir::Tensor &input,
                            float epsilon,
                            const std::string &output_name = UniqName("T_BatchNorm_NCHWc_out"));
 
+/**
+ * The batch norm in the training of the 4-D \p input in the \p data_layout of NCHW or NHWC. The mean and the biased
+ * variance of the channels are reduced from a single pass over the input, by cinn_cuda_batch_norm_stats_fp32 with a
+ * block a channel on NVGPU, or by cinn_cpu_batch_norm_stats_fp32 on the host, then the normalize, the scale, the shift
+ * and the relu if \p fuse_relu are computed from a second pass. Return {out, saved_mean, saved_variance,
+ * new_moving_mean, new_moving_variance} followed by the call of the statistics.
+ */
+std::vector<ir::Tensor> BatchNormTrain(const ir::Tensor &input,
+                                       const ir::Tensor &scale,
+                                       const ir::Tensor &bias,
+                                       const ir::Tensor &moving_mean,
+                                       const ir::Tensor &moving_variance,
+                                       float epsilon,
+                                       float momentum,
+                                       const std::string &data_layout,
+                                       bool fuse_relu,
+                                       const common::Target &target,
+                                       const std::string &output_name = UniqName("T_BatchNormTrain_out"));
+
 /**
  * @brief Perform padding operation.
  * @param tensor The input tensor.
@@ -291,12 +510,71 @@ std::vector<ir::Tensor> Softmax(const ir::Tensor &A,
                                 int axis                       = -1,
                                 const std::string &output_name = UniqName("T_softmax_out"));
 
+/**
+ * Softmax by the online normalizer, the row is read once to reduce lse = log(sum(exp(A))) with the running maximum,
+ * which is reduced by a block on NVGPU, and once more to output exp(A - lse). Return {out, lse}.
+ */
+std::vector<ir::Tensor> SoftmaxOnline(const ir::Tensor &A,
+                                      int axis                       = -1,
+                                      const std::string &output_name = UniqName("T_softmax_out"));
+
+//! The log of the softmax, A - lse with lse reduced like SoftmaxOnline. Return {out, lse}.
+std::vector<ir::Tensor> LogSoftmax(const ir::Tensor &A,
+                                   int axis                       = -1,
+                                   const std::string &output_name = UniqName("T_log_softmax_out"));
+
 #ifdef CINN_WITH_MKLDNN
 std::vector<ir::Tensor> SoftmaxMKLDNN(const ir::Tensor &A,
                                       int axis                       = -1,
                                       const std::string &output_name = UniqName("T_softmax_out"));
 #endif
 
+/**
+ * Normalize \p A over the axes from \p begin_norm_axis by their mean and variance, then scale and shift it by \p scale
+ * and \p bias, which are given either flattened or in the normalized shape. Return {out, mean, variance}, where the
+ * mean and the variance are in the shape of the leading axes. On NVGPU, both moments are reduced from a single pass
+ * over the row, which are returned after the variance as {sum, sum of the squares}.
+ */
+std::vector<ir::Tensor> LayerNorm(const ir::Tensor &A,
+                                  const ir::Tensor &scale,
+                                  const ir::Tensor &bias,
+                                  float epsilon,
+                                  int begin_norm_axis,
+                                  const common::Target &target,
+                                  const std::string &output_name = UniqName("T_layer_norm_out"));
+
+//! The GELU activation by the erf, or by its tanh approximation if \p approximate.
+ir::Tensor Gelu(const ir::Tensor &A, bool approximate, const std::string &output_name = UniqName("T_gelu_out"));
+
+//! The GELU activation of \p A plus \p bias, which is broadcast to the trailing axes of \p A.
+ir::Tensor BiasGelu(const ir::Tensor &A,
+                    const ir::Tensor &bias,
+                    bool approximate,
+                    const std::string &output_name = UniqName("T_bias_gelu_out"));
+
+/**
+ * The softmax over the last axis of \p A * \p scale + \p mask, where the mask is broadcast to the trailing axes of
+ * \p A. Return {out, sum, masked}, where the sum is the lse of SoftmaxOnline on NVGPU.
+ */
+std::vector<ir::Tensor> SoftmaxMask(const ir::Tensor &A,
+                                    const ir::Tensor &mask,
+                                    float scale,
+                                    const common::Target &target,
+                                    const std::string &output_name = UniqName("T_softmax_mask_out"));
+
+/**
+ * The scaled dot-product attention of \p num_heads heads, where \p Q in [batch, seq_q, num_heads * head_dim] and \p K,
+ * \p V in [batch, seq_k, num_heads * head_dim]. The optional \p mask is added to the scores in [batch, num_heads,
+ * seq_q, seq_k], to whose trailing axes it is broadcast. Return {out, context, sum, exp, scores}.
+ */
+std::vector<ir::Tensor> MultiHeadAttention(const ir::Tensor &Q,
+                                           const ir::Tensor &K,
+                                           const ir::Tensor &V,
+                                           const ir::Tensor &mask,
+                                           int num_heads,
+                                           float scale,
+                                           const std::string &output_name = UniqName("T_attention_out"));
+
 ir::Tensor Slice(const ir::Tensor &A,
                  const std::vector<int> &starts,
                  const std::vector<int> &axes,
@@ -356,6 +634,53 @@ std::vector<ir::Tensor> Pool2d(const ir::Tensor &tensor,
                                bool adaptive                  = false,
                                const std::string &output_name = UniqName("T_Pool2d_out"));
 
+/**
+ * @brief Whether the pooling of \p kernel_size and \p stride_size on the height and width runs faster separably by
+ *        SeparablePool2d, which is the case of stride 1 and the windows of 16 elements or more, where the reads saved
+ *        pay off the intermediate tensor.
+ */
+bool IsSeparablePool2d(const std::vector<int> &kernel_size, const std::vector<int> &stride_size);
+
+/**
+ * @brief Perform pooling on the height and width dimension of the tensor separably. The windows of the width are
+ *        pooled into an intermediate tensor first, whose windows of the height are pooled into the output, so that
+ *        each output reads kernel_h + kernel_w elements instead of kernel_h * kernel_w of the overlapping windows. The
+ *        arguments are the same as Pool2d, and the divisor of the exclusive avg pooling is separable as well.
+ *
+ * @return The pooling tensor, the intermediate tensor of the pooled width, and the padding tensor if padded.
+ */
+std::vector<ir::Tensor> SeparablePool2d(const ir::Tensor &tensor,
+                                        const std::vector<int> &kernel_size,
+                                        const std::vector<int> &stride_size,
+                                        const std::vector<int> &padding_size,
+                                        const std::string &pool_type   = "max",
+                                        bool ceil_mode                 = false,
+                                        bool exclusive                 = true,
+                                        const std::string &data_format = "NCHW",
+                                        const std::string &output_name = UniqName("T_Pool2d_out"));
+
+/**
+ * @brief Perform the global pooling on the height and width dimension of the tensor as a reduction. The height and
+ *        width are reduced as one flattened axis, so that the pooling is scheduled in the same way as the reduce ops,
+ *        e.g. by a block for each output on NVGPU.
+ * @param tensor The input tensor with shape of {N, C, H, W} or {N, H, W, C}
+ * @param pool_type The type of pooling operator, "max" or "avg".
+ * @param data_format The input data format, NCHW or NHWC.
+ * @param num_parts The number of parts the reduced elements are split into by TwoStageReduce, which only applies to
+ *        NCHW, where the height and width are the trailing axes.
+ * @param interleave_parts See TwoStageReduce.
+ * @param output_name the name of the output tensor after pooling.
+ *
+ * @return The pooling tensor of height and width 1, the sum it divides for avg, and if num_parts > 1 the partial tensor
+ *         and the reshaped input of TwoStageReduce, which is to compute inline.
+ */
+std::vector<ir::Tensor> GlobalPool2d(const ir::Tensor &tensor,
+                                     const std::string &pool_type   = "max",
+                                     const std::string &data_format = "NCHW",
+                                     int num_parts                  = 1,
+                                     bool interleave_parts          = false,
+                                     const std::string &output_name = UniqName("T_GlobalPool2d_out"));
+
 /**
  * @brief Perform pooling on the depth, height and width dimension of the tensor.
  *        Depth, height and width axis is determined by the data_format string in which 'D' means depth, 'H' means
@@ -397,6 +722,26 @@ ir::Tensor DropoutInfer(const ir::Tensor &tensor,
                         const std::string &dropout_implementation = "downgrade_in_infer",
                         const std::string &output_name            = UniqName("T_Dropout_infer_out"));
 
+/**
+ * @brief Perform dropout in the training with the mask generated in the kernel by lang::PhiloxUniform, so the mask is
+ * neither stored nor read. The element of the flat index i is kept if philox_uniform(seed, offset, i) >= dropout_prob,
+ * and the backward regenerates the same mask by calling it on the output grad with the same (seed, offset).
+ * @param tensor The input tensor, or the grad of the output in the backward.
+ * @param seed_offset The int32 tensor of [2], the seed and the offset of the counter of the RNG.
+ * @param dropout_prob float. Probability of setting units to zero.
+ * @param dropout_implementation ['downgrade_in_infer'(default)|'upscale_in_train']
+ * 1. downgrade_in_infer(default), keep the kept units the same
+ *      out = input * mask
+ * 2. upscale_in_train, upscale the kept units
+ *      out = input * mask / (1.0 - dropout_prob)
+ * @param output_name the name of the output tensor.
+ */
+ir::Tensor Dropout(const ir::Tensor &tensor,
+                   const ir::Tensor &seed_offset,
+                   float dropout_prob,
+                   const std::string &dropout_implementation = "downgrade_in_infer",
+                   const std::string &output_name            = UniqName("T_Dropout_out"));
+
 /**
  * @brief Perform Select for meta op 'Select'.
  * @param condition : the condition tensor for select value.
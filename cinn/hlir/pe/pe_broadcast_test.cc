@@ -19,6 +19,7 @@
 #include "cinn/common/target.h"
 #include "cinn/common/test_helper.h"
 #include "cinn/hlir/pe/broadcast.h"
+#include "cinn/hlir/pe/schedule.h"
 #include "cinn/runtime/cpu/host_intrinsics.h"
 
 namespace cinn {
@@ -193,6 +194,46 @@ void TestBroadcastPE2(
 TEST_BROADCAST_PE_FP32(Add, return a + b;)
 TEST_BROADCAST_PE_FP32(Multiply, return a * b;)
 
+TEST(broadcast_pe, contiguous_inner_axes) {
+  Expr N(2), C(8), H(7), W(7);
+  Placeholder<float> A("A", {N, C, H, W});
+  Placeholder<float> B("B", {C});
+  Placeholder<float> D("D", {N, C, H, W});
+  // the bias is invariant in H and W, which are collapsed, but not in C
+  auto E = Add(A.tensor(), B.tensor(), "E", Expr(1));
+  ASSERT_EQ(GetContiguousInnerAxes(E.self()), 2);
+  ASSERT_EQ(GetContiguousInnerAxes(Add(A.tensor(), D.tensor(), "F", Expr()).self()), 4);
+  // the computed operands are checked in their bodies
+  auto G = Multiply(E, D.tensor(), "G", Expr());
+  ASSERT_EQ(GetContiguousInnerAxes(G.self()), 2);
+
+  Target target = common::DefaultHostTarget();
+  auto stages   = CreateStages({E});
+  ScheduleInjectiveCPU(stages[E], {2, 8, 7, 7}, target);
+  // the fused N and C are parallel, and the collapsed H and W are split by the vectors
+  ASSERT_EQ(stages[E]->n_out_dims(), 3);
+  Module::Builder builder("module0", target);
+  auto func = Lower("fn", stages, {A, B, E});
+  builder.AddFunction(func);
+  LOG(INFO) << "func:\n" << func;
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn = reinterpret_cast<void (*)(void *, int32_t)>(jit->Lookup("fn"));
+  ASSERT_TRUE(fn);
+
+  auto *A_buf = common::BufferBuilder(Float(32), {2, 8, 7, 7}).set_random().Build();
+  auto *B_buf = common::BufferBuilder(Float(32), {8}).set_random().Build();
+  auto *E_buf = common::BufferBuilder(Float(32), {2, 8, 7, 7}).set_zero().Build();
+  cinn_pod_value_t args[] = {cinn_pod_value_t(A_buf), cinn_pod_value_t(B_buf), cinn_pod_value_t(E_buf)};
+  fn(args, 3);
+  auto *ad = reinterpret_cast<float *>(A_buf->memory);
+  auto *bd = reinterpret_cast<float *>(B_buf->memory);
+  auto *ed = reinterpret_cast<float *>(E_buf->memory);
+  for (int i = 0; i < 2 * 8 * 49; i++) {
+    ASSERT_NEAR(ed[i], ad[i] + bd[i / 49 % 8], 1e-5) << "at " << i;
+  }
+}
+
 }  // namespace pe
 }  // namespace hlir
 }  // namespace cinn
@@ -0,0 +1,238 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "cinn/backends/llvm/execution_engine.h"
+#include "cinn/cinn.h"
+#include "cinn/common/target.h"
+#include "cinn/common/test_helper.h"
+#include "cinn/hlir/pe/nn.h"
+#include "cinn/hlir/pe/schedule.h"
+#include "cinn/runtime/cpu/host_intrinsics.h"
+
+namespace cinn {
+namespace hlir {
+namespace pe {
+
+// check the output of the NCHW conv2d against the direct convolution
+void CheckConv2d(cinn_buffer_t *A_buf,
+                 cinn_buffer_t *B_buf,
+                 cinn_buffer_t *C_buf,
+                 const std::vector<int> &input_shape,
+                 const std::vector<int> &weight_shape,
+                 int pad,
+                 int stride) {
+  int n = input_shape[0], c = input_shape[1], h = input_shape[2], w = input_shape[3];
+  int k = weight_shape[0], kh = weight_shape[2], kw = weight_shape[3];
+  int out_h = (h + 2 * pad - kh) / stride + 1;
+  int out_w = (w + 2 * pad - kw) / stride + 1;
+  auto *ad  = reinterpret_cast<float *>(A_buf->memory);
+  auto *bd  = reinterpret_cast<float *>(B_buf->memory);
+  auto *cd  = reinterpret_cast<float *>(C_buf->memory);
+  for (int b = 0; b < n; b++) {
+    for (int o = 0; o < k; o++) {
+      for (int y = 0; y < out_h; y++) {
+        for (int x = 0; x < out_w; x++) {
+          float tmp = 0;
+          for (int i = 0; i < c; i++) {
+            for (int r = 0; r < kh; r++) {
+              for (int s = 0; s < kw; s++) {
+                int iy = y * stride + r - pad;
+                int ix = x * stride + s - pad;
+                if (iy < 0 || iy >= h || ix < 0 || ix >= w) continue;
+                tmp += ad[((b * c + i) * h + iy) * w + ix] * bd[((o * c + i) * kh + r) * kw + s];
+              }
+            }
+          }
+          ASSERT_NEAR(cd[((b * k + o) * out_h + y) * out_w + x], tmp, 1e-3)
+              << "at (" << b << ", " << o << ", " << y << ", " << x << ")";
+        }
+      }
+    }
+  }
+}
+
+void TestConv2dWinograd(int n, int c, int h, int w, int k, int pad, int tile_size) {
+  Placeholder<float> A("A", {Expr(n), Expr(c), Expr(h), Expr(w)});
+  Placeholder<float> B("B", {Expr(k), Expr(c), Expr(3), Expr(3)});
+
+  Target target = common::DefaultHostTarget();
+  auto U        = Conv2d_Winograd_WeightTransform(B.tensor(), tile_size, "U");
+  auto out      = Conv2d_Winograd_NCHW(A.tensor(), U, pad, pad, tile_size, "C");
+  ASSERT_EQ(out.size(), 4UL);
+
+  auto stages = CreateStages({A, B, U});
+  for (auto &t : out) stages->InsertLazily(t);
+  stages[U]->Fuse(0, 1);
+  stages[U]->Parallel(0);
+  Conv2d_Winograd_Schedule_CPU(stages, out[0], out[1], out[2], out[3], target);
+
+  Module::Builder builder("module0", target);
+  // the transformed weights and tiles and the batched matmul are temporary buffers of the function
+  auto func = Lower("fn", stages, {A, B, out[0]});
+  builder.AddFunction(func);
+  VLOG(3) << "func:\n" << func;
+
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn = jit->Lookup("fn");
+  CHECK(fn);
+  auto fn_ = reinterpret_cast<void (*)(void *, int32_t)>(fn);
+
+  int out_h            = h + 2 * pad - 2;
+  int out_w            = w + 2 * pad - 2;
+  cinn_buffer_t *A_buf = common::BufferBuilder(Float(32), {n, c, h, w}).set_random().Build();
+  cinn_buffer_t *B_buf = common::BufferBuilder(Float(32), {k, c, 3, 3}).set_random().Build();
+  cinn_buffer_t *C_buf = common::BufferBuilder(Float(32), {n, k, out_h, out_w}).set_zero().Build();
+  cinn_pod_value_t a_arg(A_buf), b_arg(B_buf), c_arg(C_buf);
+  std::vector<cinn_pod_value_t> args = {a_arg, b_arg, c_arg};
+  fn_(reinterpret_cast<void **>(args.data()), args.size());
+
+  CheckConv2d(A_buf, B_buf, C_buf, {n, c, h, w}, {k, c, 3, 3}, pad, 1);
+}
+
+void TestConv2dIm2col(int n, int c, int h, int w, int k, int kernel, int pad, int stride) {
+  Placeholder<float> A("A", {Expr(n), Expr(c), Expr(h), Expr(w)});
+  Placeholder<float> B("B", {Expr(k), Expr(c), Expr(kernel), Expr(kernel)});
+
+  Target target = common::DefaultHostTarget();
+  auto out      = Conv2d_Im2col_NCHW(A.tensor(), B.tensor(), pad, pad, stride, stride, 1, 1, "C", target);
+  ASSERT_EQ(out.size(), 7UL);
+
+  auto stages = CreateStages({A, B});
+  for (auto &t : out) stages->InsertLazily(t);
+  Conv2d_Im2col_Schedule_CPU(stages, out[0], out[1], out[2], out[3], out[4], out[5], out[6], target);
+
+  Module::Builder builder("module0", target);
+  // the packed im2col and weights and the GEMM are temporary buffers of the function
+  auto func = Lower("fn", stages, {A, B, out[0]});
+  builder.AddFunction(func);
+  VLOG(3) << "func:\n" << func;
+
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn = jit->Lookup("fn");
+  CHECK(fn);
+  auto fn_ = reinterpret_cast<void (*)(void *, int32_t)>(fn);
+
+  int out_h            = (h + 2 * pad - kernel) / stride + 1;
+  int out_w            = (w + 2 * pad - kernel) / stride + 1;
+  cinn_buffer_t *A_buf = common::BufferBuilder(Float(32), {n, c, h, w}).set_random().Build();
+  cinn_buffer_t *B_buf = common::BufferBuilder(Float(32), {k, c, kernel, kernel}).set_random().Build();
+  cinn_buffer_t *C_buf = common::BufferBuilder(Float(32), {n, k, out_h, out_w}).set_zero().Build();
+  cinn_pod_value_t a_arg(A_buf), b_arg(B_buf), c_arg(C_buf);
+  std::vector<cinn_pod_value_t> args = {a_arg, b_arg, c_arg};
+  fn_(reinterpret_cast<void **>(args.data()), args.size());
+  CheckConv2d(A_buf, B_buf, C_buf, {n, c, h, w}, {k, c, kernel, kernel}, pad, stride);
+}
+
+void TestDepthwiseConv2dRow(int n, int c, int h, int w, int kernel, int pad, int stride) {
+  Placeholder<float> A("A", {Expr(n), Expr(c), Expr(h), Expr(w)});
+  Placeholder<float> B("B", {Expr(c), Expr(1), Expr(kernel), Expr(kernel)});
+
+  Target target = common::DefaultHostTarget();
+  int c_bn      = GetBasicFactor(Float(32), target);
+  auto out      = Depthwise_Conv2d_NCHWc_Row(A.tensor(), B.tensor(), pad, pad, stride, stride, 1, 1, c_bn, "C");
+  ASSERT_EQ(out.size(), 4UL);
+
+  auto stages = CreateStages({A, B});
+  for (auto &t : out) stages->InsertLazily(t);
+  Depthwise_Conv2d_NCHWc_Row_Schedule_CPU(stages, out[0], out[1], out[2], out[3], target);
+
+  Module::Builder builder("module0", target);
+  auto func = Lower("fn", stages, {A, B, out[0]});
+  builder.AddFunction(func);
+  VLOG(3) << "func:\n" << func;
+
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn = jit->Lookup("fn");
+  CHECK(fn);
+  auto fn_ = reinterpret_cast<void (*)(void *, int32_t)>(fn);
+
+  int out_h            = (h + 2 * pad - kernel) / stride + 1;
+  int out_w            = (w + 2 * pad - kernel) / stride + 1;
+  cinn_buffer_t *A_buf = common::BufferBuilder(Float(32), {n, c, h, w}).set_random().Build();
+  cinn_buffer_t *B_buf = common::BufferBuilder(Float(32), {c, 1, kernel, kernel}).set_random().Build();
+  cinn_buffer_t *C_buf = common::BufferBuilder(Float(32), {n, c, out_h, out_w}).set_zero().Build();
+  cinn_pod_value_t a_arg(A_buf), b_arg(B_buf), c_arg(C_buf);
+  std::vector<cinn_pod_value_t> args = {a_arg, b_arg, c_arg};
+  fn_(reinterpret_cast<void **>(args.data()), args.size());
+
+  auto *ad = reinterpret_cast<float *>(A_buf->memory);
+  auto *bd = reinterpret_cast<float *>(B_buf->memory);
+  auto *cd = reinterpret_cast<float *>(C_buf->memory);
+  for (int b = 0; b < n; b++) {
+    for (int i = 0; i < c; i++) {
+      for (int y = 0; y < out_h; y++) {
+        for (int x = 0; x < out_w; x++) {
+          float tmp = 0;
+          for (int r = 0; r < kernel; r++) {
+            for (int s = 0; s < kernel; s++) {
+              int iy = y * stride + r - pad;
+              int ix = x * stride + s - pad;
+              if (iy < 0 || iy >= h || ix < 0 || ix >= w) continue;
+              tmp += ad[((b * c + i) * h + iy) * w + ix] * bd[(i * kernel + r) * kernel + s];
+            }
+          }
+          ASSERT_NEAR(cd[((b * c + i) * out_h + y) * out_w + x], tmp, 1e-3)
+              << "at (" << b << ", " << i << ", " << y << ", " << x << ")";
+        }
+      }
+    }
+  }
+}
+
+TEST(Conv2dPE, PE_Conv2d_Winograd_F2x2) { TestConv2dWinograd(1, 16, 9, 9, 32, 1, 2); }
+
+TEST(Conv2dPE, PE_Conv2d_Winograd_F4x4) { TestConv2dWinograd(2, 16, 14, 14, 16, 1, 4); }
+
+TEST(Conv2dPE, PE_Conv2d_Winograd_Tile) {
+  // 3x3 stride 1 convs with enough channels are computed by Winograd, the large outputs by F(4x4, 3x3)
+  EXPECT_EQ(GetConv2dWinogradTile({1, 64, 56, 56}, {64, 64, 3, 3}, {1, 1}, {1, 1}, {1, 1}, 1), 4);
+  EXPECT_EQ(GetConv2dWinogradTile({1, 256, 7, 7}, {256, 256, 3, 3}, {1, 1}, {1, 1}, {1, 1}, 1), 2);
+  EXPECT_EQ(GetConv2dWinogradTile({1, 64, 56, 56}, {64, 64, 3, 3}, {1, 1}, {2, 2}, {1, 1}, 1), 0);
+  EXPECT_EQ(GetConv2dWinogradTile({1, 64, 56, 56}, {64, 64, 1, 1}, {0, 0}, {1, 1}, {1, 1}, 1), 0);
+  EXPECT_EQ(GetConv2dWinogradTile({1, 3, 224, 224}, {64, 3, 3, 3}, {1, 1}, {1, 1}, {1, 1}, 1), 0);
+}
+
+TEST(Conv2dPE, PE_Conv2d_Im2col_1x1) { TestConv2dIm2col(1, 64, 7, 7, 48, 1, 0, 1); }
+
+TEST(Conv2dPE, PE_Conv2d_Im2col_3x3_Stride2) { TestConv2dIm2col(2, 16, 9, 9, 32, 3, 1, 2); }
+
+TEST(Conv2dPE, PE_Conv2d_Im2col_Rule) {
+  // the convs of many channels and small images are computed by the GEMM
+  EXPECT_TRUE(UseConv2dIm2col({1, 256, 14, 14}, {512, 256, 1, 1}, {0, 0}, {1, 1}, {1, 1}, 1));
+  EXPECT_TRUE(UseConv2dIm2col({1, 256, 14, 14}, {256, 256, 3, 3}, {1, 1}, {2, 2}, {1, 1}, 1));
+  EXPECT_FALSE(UseConv2dIm2col({1, 64, 56, 56}, {64, 64, 1, 1}, {0, 0}, {1, 1}, {1, 1}, 1));
+  EXPECT_FALSE(UseConv2dIm2col({1, 256, 14, 14}, {256, 128, 3, 3}, {1, 1}, {1, 1}, {1, 1}, 2));
+}
+
+TEST(Conv2dPE, PE_Conv2d_ImplicitGemm_Rule) {
+  // the NVGPU convs of enough output channels and reduced elements fill the tiles of the GEMM
+  EXPECT_TRUE(UseConv2dImplicitGemm({1, 64, 56, 56}, {64, 64, 1, 1}, {0, 0}, {1, 1}, {1, 1}, 1));
+  EXPECT_TRUE(UseConv2dImplicitGemm({8, 32, 28, 28}, {128, 32, 3, 3}, {1, 1}, {2, 2}, {1, 1}, 1));
+  EXPECT_FALSE(UseConv2dImplicitGemm({1, 3, 224, 224}, {16, 3, 3, 3}, {1, 1}, {1, 1}, {1, 1}, 1));
+  EXPECT_FALSE(UseConv2dImplicitGemm({1, 16, 56, 56}, {64, 16, 1, 1}, {0, 0}, {1, 1}, {1, 1}, 1));
+  EXPECT_FALSE(UseConv2dImplicitGemm({1, 256, 14, 14}, {256, 128, 3, 3}, {1, 1}, {1, 1}, {1, 1}, 2));
+}
+
+TEST(DepthwiseConv2dPE, PE_Depthwise_Conv2d_Row_3x3) { TestDepthwiseConv2dRow(1, 32, 14, 14, 3, 1, 1); }
+
+TEST(DepthwiseConv2dPE, PE_Depthwise_Conv2d_Row_Stride2) { TestDepthwiseConv2dRow(2, 32, 13, 13, 3, 1, 2); }
+
+}  // namespace pe
+}  // namespace hlir
+}  // namespace cinn
@@ -0,0 +1,151 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "cinn/backends/llvm/execution_engine.h"
+#include "cinn/cinn.h"
+#include "cinn/common/test_helper.h"
+#include "cinn/hlir/pe/reduction.h"
+#include "cinn/hlir/pe/schedule.h"
+
+namespace cinn {
+namespace hlir {
+namespace pe {
+
+void TestTwoStageReduce(const std::vector<int>& shape,
+                        const std::vector<int>& axes,
+                        int num_parts,
+                        bool keep_dims,
+                        bool interleave_parts = false,
+                        bool split_outer      = false) {
+  std::vector<Expr> shape_expr(shape.begin(), shape.end());
+  Placeholder<float> A("A", shape_expr);
+  std::vector<ir::Tensor> outs;
+  if (split_outer) {
+    outs = TwoStageReduceOuter(A.tensor(), axes, ReduceSum, num_parts, keep_dims, "two_stage_out");
+  } else {
+    outs = TwoStageReduce(A.tensor(), axes, ReduceSum, num_parts, keep_dims, "two_stage_out", interleave_parts);
+  }
+  auto expected = ReduceSum(A.tensor(), axes, keep_dims, Expr(), "one_stage_out");
+  ASSERT_EQ(outs.size(), 3U);
+  ASSERT_EQ(outs[0]->shape.size(), expected->shape.size());
+  int part_axis = split_outer ? *std::min_element(axes.begin(), axes.end()) : outs[1]->shape.size() - 1;
+  ASSERT_EQ(outs[1]->shape[part_axis].as_int32(), num_parts);
+
+  auto stages = CreateStages({A, outs[0], outs[1], expected});
+  stages->InsertLazily(outs[2]);
+  stages[outs[2]]->ComputeInline();
+  // the interleaved parts are the lanes of the vector accumulators on X86
+  if (interleave_parts) ScheduleReduceCPU(stages[outs[1]], common::DefaultHostTarget());
+  auto func = Lower("fn", stages, {A, outs[0], outs[1], expected});
+  LOG(INFO) << "func:\n" << func;
+
+  Module::Builder builder("module0", common::DefaultHostTarget());
+  builder.AddFunction(func);
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn = reinterpret_cast<void (*)(void*, int32_t)>(jit->Lookup("fn"));
+  CHECK(fn);
+
+  int out_numel = 1, partial_numel = 1;
+  for (auto& dim : expected->shape) out_numel *= dim.as_int32();
+  for (auto& dim : outs[1]->shape) partial_numel *= dim.as_int32();
+  auto* A_buf       = common::BufferBuilder(Float(32), shape).set_random().Build();
+  auto* out_buf     = common::BufferBuilder(Float(32), {out_numel}).set_zero().Build();
+  auto* partial_buf = common::BufferBuilder(Float(32), {partial_numel}).set_zero().Build();
+  auto* expect_buf  = common::BufferBuilder(Float(32), {out_numel}).set_zero().Build();
+  cinn_pod_value_t args[] = {
+      cinn_pod_value_t(A_buf), cinn_pod_value_t(out_buf), cinn_pod_value_t(partial_buf), cinn_pod_value_t(expect_buf)};
+  fn(args, 4);
+
+  auto* out_data    = reinterpret_cast<float*>(out_buf->memory);
+  auto* expect_data = reinterpret_cast<float*>(expect_buf->memory);
+  for (int i = 0; i < out_numel; i++) {
+    ASSERT_NEAR(out_data[i], expect_data[i], 1e-4 * std::max(1.f, std::abs(expect_data[i]))) << "at " << i;
+  }
+}
+
+TEST(TwoStageReduce, reduce_last_axis) { TestTwoStageReduce({4, 256}, {1}, 8, false); }
+
+TEST(TwoStageReduce, reduce_trailing_axes) { TestTwoStageReduce({2, 4, 16, 8}, {2, 3}, 16, true); }
+
+TEST(TwoStageReduce, reduce_all) { TestTwoStageReduce({32, 64}, {}, 4, false); }
+
+TEST(TwoStageReduce, reduce_interleaved_parts) { TestTwoStageReduce({4, 16, 64}, {1, 2}, 32, false, true); }
+
+// the column sums are split along the rows
+TEST(TwoStageReduceOuter, reduce_first_axis) { TestTwoStageReduce({256, 6}, {0}, 16, false, false, true); }
+
+TEST(TwoStageReduceOuter, reduce_inner_axes) { TestTwoStageReduce({3, 64, 5, 4}, {1, 3}, 8, true, false, true); }
+
+// the outer axis is reduced along the vectors of the innermost axis kept
+TEST(ScheduleReduceCPU, reduce_outer_axis) {
+  Placeholder<float> A("A", {Expr(64), Expr(100)});
+  auto out      = ReduceSum(A.tensor(), {0}, true, Expr(), "vectorized_out");
+  auto expected = ReduceSum(A.tensor(), {0}, true, Expr(), "serial_out");
+  auto stages   = CreateStages({A, out, expected});
+  ScheduleReduceCPU(stages[out], common::DefaultHostTarget());
+  auto func = Lower("fn", stages, {A, out, expected});
+  LOG(INFO) << "func:\n" << func;
+
+  Module::Builder builder("module0", common::DefaultHostTarget());
+  builder.AddFunction(func);
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn = reinterpret_cast<void (*)(void*, int32_t)>(jit->Lookup("fn"));
+  CHECK(fn);
+
+  auto* A_buf      = common::BufferBuilder(Float(32), {64, 100}).set_random().Build();
+  auto* out_buf    = common::BufferBuilder(Float(32), {100}).set_zero().Build();
+  auto* expect_buf = common::BufferBuilder(Float(32), {100}).set_zero().Build();
+  cinn_pod_value_t args[] = {cinn_pod_value_t(A_buf), cinn_pod_value_t(out_buf), cinn_pod_value_t(expect_buf)};
+  fn(args, 3);
+
+  auto* out_data    = reinterpret_cast<float*>(out_buf->memory);
+  auto* expect_data = reinterpret_cast<float*>(expect_buf->memory);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_NEAR(out_data[i], expect_data[i], 1e-4 * std::max(1.f, std::abs(expect_data[i]))) << "at " << i;
+  }
+}
+
+TEST(GetCpuReduceParts, GetCpuReduceParts) {
+  auto target = common::DefaultHostTarget();
+  // the reductions too short, or not divisible into the vectors, stay serial
+  ASSERT_EQ(GetCpuReduceParts(49, Float(32), target), 1);
+  ASSERT_EQ(GetCpuReduceParts(8, Float(32), target), 1);
+  int num_parts = GetCpuReduceParts(1 << 12, Float(32), target);
+  ASSERT_GT(num_parts, 1);
+  ASSERT_EQ((1 << 12) % num_parts, 0);
+}
+
+TEST(GetCudaReduceParts, GetCudaReduceParts) {
+  auto target = common::DefaultNVGPUTarget();
+  // the outputs occupy the device, or the reductions are short
+  ASSERT_EQ(GetCudaReduceParts(1 << 20, 1024, target), 1);
+  ASSERT_EQ(GetCudaReduceParts(16, 64, target), 1);
+  ASSERT_EQ(GetCudaReduceParts(4, 1000, target), 1);
+  // the few long reductions are split, each part reduces at least 1024 elements
+  int num_parts = GetCudaReduceParts(4, 1 << 16, target);
+  ASSERT_GT(num_parts, 1);
+  ASSERT_EQ((1 << 16) % num_parts, 0);
+  ASSERT_GE((1 << 16) / num_parts, 1024);
+}
+
+}  // namespace pe
+}  // namespace hlir
+}  // namespace cinn
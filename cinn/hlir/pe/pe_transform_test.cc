@@ -18,6 +18,7 @@
 #include "cinn/cinn.h"
 #include "cinn/common/target.h"
 #include "cinn/common/test_helper.h"
+#include "cinn/hlir/pe/schedule.h"
 #include "cinn/hlir/pe/transform.h"
 #include "cinn/runtime/cpu/host_intrinsics.h"
 
@@ -92,6 +93,153 @@ TEST(MatmulPE, PE_Matmul_Test0) {
   }
 }
 
+void TestMatmulPacked(int m, int n, int k, bool trans_b) {
+  Placeholder<float> A("A", {Expr(m), Expr(k)});
+  Placeholder<float> B("B", trans_b ? std::vector<Expr>{Expr(n), Expr(k)} : std::vector<Expr>{Expr(k), Expr(n)});
+
+  Target target = common::DefaultHostTarget();
+  auto C        = hlir::pe::MatmulPacked(A.tensor(), B.tensor(), false, trans_b, 1, "C", target);
+  ASSERT_EQ(C.size(), 3UL);
+
+  auto stages = CreateStages({A, B});
+  for (auto &t : C) stages->InsertLazily(t);
+  hlir::pe::MatmulScheduleCPU(stages, C[0], C[1], C[2], target);
+
+  Module::Builder builder("module0", target);
+  // the packed A is a temporary buffer of the function
+  auto func = Lower("fn", stages, {A, B, C[0], C[1]});
+  builder.AddFunction(func);
+  VLOG(3) << "func:\n" << func;
+
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn = jit->Lookup("fn");
+  CHECK(fn);
+  auto fn_ = reinterpret_cast<void (*)(void *, int32_t)>(fn);
+
+  std::vector<int> packed_shape;
+  for (auto &dim : C[1]->shape) packed_shape.push_back(dim.as_int32());
+  cinn_buffer_t *A_buf      = common::BufferBuilder(Float(32), {m, k}).set_random().Build();
+  cinn_buffer_t *B_buf      = common::BufferBuilder(Float(32), {k, n}).set_random().Build();
+  cinn_buffer_t *C_buf      = common::BufferBuilder(Float(32), {m, n}).set_zero().Build();
+  cinn_buffer_t *packed_buf = common::BufferBuilder(Float(32), packed_shape).set_zero().Build();
+  cinn_pod_value_t a_arg(A_buf), b_arg(B_buf), c_arg(C_buf), packed_arg(packed_buf);
+  std::vector<cinn_pod_value_t> args = {a_arg, b_arg, c_arg, packed_arg};
+  fn_(reinterpret_cast<void **>(args.data()), args.size());
+
+  auto *ad = reinterpret_cast<float *>(A_buf->memory);
+  auto *bd = reinterpret_cast<float *>(B_buf->memory);
+  auto *cd = reinterpret_cast<float *>(C_buf->memory);
+  for (int i = 0; i < m; i++) {
+    for (int j = 0; j < n; j++) {
+      float tmp = 0;
+      for (int x = 0; x < k; x++) {
+        tmp += ad[i * k + x] * (trans_b ? bd[j * k + x] : bd[x * n + j]);
+      }
+      ASSERT_NEAR(cd[i * n + j], tmp, 1e-4) << "at (" << i << ", " << j << ")";
+    }
+  }
+}
+
+TEST(MatmulPE, PE_MatmulPacked_Test0) {
+  TestMatmulPacked(64, 64, 128, false);
+  // extents without a good blocking factor
+  TestMatmulPacked(37, 20, 33, false);
+  // the layout of the mul op
+  TestMatmulPacked(30, 48, 70, true);
+}
+
+void TestMatmulSmall(int batch, int m, int n, int k, bool trans_b) {
+  Placeholder<float> A("A", {Expr(batch), Expr(m), Expr(k)});
+  Placeholder<float> B("B",
+                       trans_b ? std::vector<Expr>{Expr(batch), Expr(n), Expr(k)}
+                               : std::vector<Expr>{Expr(batch), Expr(k), Expr(n)});
+  ASSERT_TRUE(UseSmallMatmul(m, n, k));
+
+  Target target = common::DefaultHostTarget();
+  auto C        = hlir::pe::MatmulSmall(A.tensor(), B.tensor(), false, trans_b, 2.f, "C");
+  ASSERT_EQ(C.size(), 1UL);
+  // the reduction is unrolled
+  ASSERT_FALSE(C[0]->is_reduce_tensor());
+
+  auto stages = CreateStages({A, B, C[0]});
+  hlir::pe::ScheduleSmallMatmulCPU(stages[C[0]], {batch, m, n}, target);
+  Module::Builder builder("module0", target);
+  auto func = Lower("fn", stages, {A, B, C[0]});
+  builder.AddFunction(func);
+  VLOG(3) << "func:\n" << func;
+
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn = jit->Lookup("fn");
+  CHECK(fn);
+  auto fn_ = reinterpret_cast<void (*)(void *, int32_t)>(fn);
+
+  cinn_buffer_t *A_buf = common::BufferBuilder(Float(32), {batch, m, k}).set_random().Build();
+  cinn_buffer_t *B_buf = common::BufferBuilder(Float(32), {batch, k, n}).set_random().Build();
+  cinn_buffer_t *C_buf = common::BufferBuilder(Float(32), {batch, m, n}).set_zero().Build();
+  cinn_pod_value_t a_arg(A_buf), b_arg(B_buf), c_arg(C_buf);
+  std::vector<cinn_pod_value_t> args = {a_arg, b_arg, c_arg};
+  fn_(reinterpret_cast<void **>(args.data()), args.size());
+
+  auto *ad = reinterpret_cast<float *>(A_buf->memory);
+  auto *bd = reinterpret_cast<float *>(B_buf->memory);
+  auto *cd = reinterpret_cast<float *>(C_buf->memory);
+  for (int b = 0; b < batch; b++) {
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < n; j++) {
+        float tmp = 0;
+        for (int x = 0; x < k; x++) {
+          tmp += ad[(b * m + i) * k + x] * (trans_b ? bd[(b * n + j) * k + x] : bd[(b * k + x) * n + j]);
+        }
+        ASSERT_NEAR(cd[(b * m + i) * n + j], 2.f * tmp, 1e-4) << "at (" << b << ", " << i << ", " << j << ")";
+      }
+    }
+  }
+}
+
+TEST(MatmulPE, PE_MatmulSmall_Test0) {
+  // the batches of the tiny matrices split among the parallel tasks
+  TestMatmulSmall(100, 3, 3, 3, false);
+  TestMatmulSmall(37, 4, 4, 4, true);
+  // only the columns unrolled
+  TestMatmulSmall(5, 16, 16, 16, false);
+  ASSERT_FALSE(UseSmallMatmul(16, 16, 17));
+  // the layout of the mul op, [M, K] * [N, K]
+  ASSERT_TRUE(UseSmallMul({2, 4, 3}, {5, 12}, 1, 1));
+  ASSERT_FALSE(UseSmallMul({2, 4, 8}, {5, 32}, 1, 1));
+}
+
+// NCHW -> NHWC merges HW, and moves the innermost axis of the input
+TEST(TransposePE, NormalizeTranspose) {
+  std::vector<int> shape;
+  std::vector<int> axis;
+  ASSERT_TRUE(NormalizeTranspose({8, 64, 7, 7}, {0, 2, 3, 1}, &shape, &axis));
+  ASSERT_EQ(shape, std::vector<int>({8, 64, 49}));
+  ASSERT_EQ(axis, std::vector<int>({0, 2, 1}));
+  // the axes of extent 1 are dropped, and the innermost stays
+  ASSERT_FALSE(NormalizeTranspose({1, 16, 32}, {1, 0, 2}, &shape, &axis));
+  ASSERT_EQ(shape, std::vector<int>({512}));
+  ASSERT_EQ(axis, std::vector<int>({0}));
+}
+
+// NCHW -> NCHW16c is the transpose of [N, C/16, 16, H, W] by {0, 1, 3, 4, 2}
+TEST(TransposePE, GetLayoutTransformAxis) {
+  std::vector<int> shape;
+  std::vector<int> axis;
+  ASSERT_TRUE(GetLayoutTransformAxis({2, 64, 7, 7}, "NCHW", "NCHW16c", &shape, &axis));
+  ASSERT_EQ(shape, std::vector<int>({2, 4, 16, 7, 7}));
+  ASSERT_EQ(axis, std::vector<int>({0, 1, 3, 4, 2}));
+  ASSERT_TRUE(GetLayoutTransformAxis({2, 4, 7, 7, 16}, "NCHW16c", "NCHW", &shape, &axis));
+  ASSERT_EQ(shape, std::vector<int>({2, 4, 7, 7, 16}));
+  ASSERT_EQ(axis, std::vector<int>({0, 1, 4, 2, 3}));
+  std::vector<int> norm_shape;
+  std::vector<int> norm_axis;
+  ASSERT_TRUE(NormalizeTranspose(shape, axis, &norm_shape, &norm_axis));
+  ASSERT_EQ(norm_shape, std::vector<int>({8, 49, 16}));
+  ASSERT_EQ(norm_axis, std::vector<int>({0, 2, 1}));
+}
+
 }  // namespace pe
 }  // namespace hlir
 }  // namespace cinn
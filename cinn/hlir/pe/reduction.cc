@@ -18,6 +18,7 @@
 
 #include <algorithm>
 
+#include "cinn/common/cas.h"
 #include "cinn/common/ir_util.h"
 #include "cinn/hlir/pe/broadcast.h"
 #include "cinn/ir/ir_operators.h"
@@ -201,6 +202,203 @@ Tensor ReduceMin(
   return Reduce(A, axes, lang::ReduceMin, keep_dims, Expr(), output_name);
 }
 
+std::vector<Tensor> TwoStageReduce(const Tensor& A,
+                                   const std::vector<int>& axes,
+                                   const ReduceFunc& reduce_func,
+                                   int num_parts,
+                                   bool keep_dims,
+                                   const std::string& output_name,
+                                   bool interleave_parts) {
+  int ndim = A->shape.size();
+  std::vector<int> real_axes;
+  GetRealAxes(ndim, axes, &real_axes);
+  int num_reduced = real_axes.size();
+  int num_kept    = ndim - num_reduced;
+  for (int i = 0; i < num_reduced; i++) {
+    CHECK_EQ(real_axes[i], num_kept + i) << "TwoStageReduce only reduces the trailing axes";
+  }
+  int reduce_numel = 1;
+  for (int i = num_kept; i < ndim; i++) {
+    CHECK(A->shape[i].is_constant()) << "TwoStageReduce only reduces the axes of constant extents";
+    reduce_numel *= A->shape[i].as_int32();
+  }
+  CHECK_GT(num_parts, 0);
+  CHECK_EQ(reduce_numel % num_parts, 0) << "The reduced elements can not be split into " << num_parts << " parts";
+  int part_size = reduce_numel / num_parts;
+
+  // A is viewed as [kept axes..., 1...1, num_parts, part_size], the ones keep the reduced axes before the last one, so
+  // that reducing the partial tensor keeps the dims the same as reducing A. The interleaved parts view it as
+  // [kept axes..., 1...1, part_size, num_parts] instead.
+  std::vector<Expr> reshaped_shape(A->shape.begin(), A->shape.begin() + num_kept);
+  for (int i = 1; i < num_reduced; i++) reshaped_shape.push_back(common::make_one());
+  reshaped_shape.push_back(Expr(interleave_parts ? part_size : num_parts));
+  reshaped_shape.push_back(Expr(interleave_parts ? num_parts : part_size));
+  int inner_size = interleave_parts ? num_parts : part_size;
+  auto reshaped  = Compute(
+      reshaped_shape,
+      [=](const std::vector<Expr>& indices) {
+        std::vector<Expr> a_indices(indices.begin(), indices.begin() + num_kept);
+        Expr offset = indices[indices.size() - 2] * inner_size + indices.back();
+        std::vector<Expr> reduced_indices(num_reduced);
+        for (int i = ndim - 1; i >= num_kept; i--) {
+          int extent                    = A->shape[i].as_int32();
+          reduced_indices[i - num_kept] = i == num_kept ? offset : offset % extent;
+          if (i > num_kept) offset = offset / extent;
+        }
+        a_indices.insert(a_indices.end(), reduced_indices.begin(), reduced_indices.end());
+        return A(a_indices);
+      },
+      UniqName(output_name + "_reshape"));
+
+  int part_axis = reshaped_shape.size() - (interleave_parts ? 2 : 1);
+  auto partial  = reduce_func(reshaped, {part_axis}, false, Expr(), output_name + "_partial");
+  std::vector<int> partial_axes;
+  for (int i = num_kept; i < num_kept + num_reduced; i++) partial_axes.push_back(i);
+  auto out = reduce_func(partial, partial_axes, keep_dims, Expr(), output_name);
+  return {out, partial, reshaped};
+}
+
+std::vector<Tensor> TwoStageReduceOuter(const Tensor& A,
+                                        const std::vector<int>& axes,
+                                        const ReduceFunc& reduce_func,
+                                        int num_parts,
+                                        bool keep_dims,
+                                        const std::string& output_name) {
+  int ndim = A->shape.size();
+  std::vector<int> real_axes;
+  GetRealAxes(ndim, axes, &real_axes);
+  CHECK(!real_axes.empty());
+  int first = real_axes.front();
+  CHECK(A->shape[first].is_constant()) << "TwoStageReduceOuter only splits the axis of constant extent";
+  int extent = A->shape[first].as_int32();
+  CHECK_GT(num_parts, 0);
+  CHECK_EQ(extent % num_parts, 0) << "The reduced axis of " << extent << " can not be split into " << num_parts
+                                  << " parts";
+  int part_size = extent / num_parts;
+
+  // A is viewed as [..., num_parts, part_size, ...] in the place of the first reduced axis
+  std::vector<Expr> reshaped_shape(A->shape.begin(), A->shape.begin() + first);
+  reshaped_shape.push_back(Expr(num_parts));
+  reshaped_shape.push_back(Expr(part_size));
+  reshaped_shape.insert(reshaped_shape.end(), A->shape.begin() + first + 1, A->shape.end());
+  auto reshaped = Compute(
+      reshaped_shape,
+      [=](const std::vector<Expr>& indices) {
+        std::vector<Expr> a_indices(indices.begin(), indices.begin() + first);
+        a_indices.push_back(indices[first] * part_size + indices[first + 1]);
+        a_indices.insert(a_indices.end(), indices.begin() + first + 2, indices.end());
+        return A(a_indices);
+      },
+      UniqName(output_name + "_reshape"));
+
+  // the axes before the first reduced one are all kept, so the parts stay at its place in the partial tensor, and
+  // reducing them out of the dims kept as 1s leaves the dims the same as reducing A
+  std::vector<int> partial_axes;
+  for (int axis : real_axes) partial_axes.push_back(axis + 1);
+  auto partial = reduce_func(reshaped, partial_axes, keep_dims, Expr(), output_name + "_partial");
+  auto out     = reduce_func(partial, {first}, false, Expr(), output_name);
+  return {out, partial, reshaped};
+}
+
+namespace {
+//! The threads of the block selecting a row, and the largest k selected, by cinn_cuda_top_k_fp32 on NVGPU.
+constexpr int kCudaTopKThreads = 256;
+constexpr int kCudaTopKMaxK    = 1024;
+}  // namespace
+
+/**
+ * @brief The indices of the first of the elements reduced to the \p value of \p A along \p axis, in int32.
+ */
+Tensor ArgReduce(const Tensor& A, const Tensor& value, int axis, bool keep_dims, const std::string& output_name) {
+  std::vector<Expr> output_shape;
+  GetOutputShape({axis}, &output_shape, A, keep_dims);
+  Expr extent = A->shape[axis];
+  return Compute(
+      output_shape,
+      [=](const std::vector<Expr>& indices) {
+        Var k(extent, UniqName("kk"));
+        std::vector<Expr> eval_indice;
+        int indice_cnt = 0;
+        for (int i = 0; i < A->shape.size(); ++i) {
+          if (i == axis) {
+            eval_indice.push_back(k);
+            indice_cnt += keep_dims;
+            continue;
+          }
+          eval_indice.push_back(indices[indice_cnt++]);
+        }
+        // the value is reduced in the same order, so the element equals it exactly
+        Expr hit = ir::EQ::Make(A(eval_indice), value(indices));
+        return lang::ReduceMin(ir::Select::Make(hit, Expr(k), extent), {k}, extent);
+      },
+      output_name);
+}
+
+std::vector<Tensor> Argmax(const Tensor& A, int axis, bool keep_dims, const std::string& output_name) {
+  int ndim = A->shape.size();
+  if (axis < 0) axis += ndim;
+  CHECK(axis >= 0 && axis < ndim) << "The axis of argmax should be in [-ndim, ndim)";
+  auto value = ReduceMax(A, {axis}, keep_dims, Expr(), output_name + "_value");
+  return {ArgReduce(A, value, axis, keep_dims, output_name), value};
+}
+
+std::vector<Tensor> Argmin(const Tensor& A, int axis, bool keep_dims, const std::string& output_name) {
+  int ndim = A->shape.size();
+  if (axis < 0) axis += ndim;
+  CHECK(axis >= 0 && axis < ndim) << "The axis of argmin should be in [-ndim, ndim)";
+  auto value = ReduceMin(A, {axis}, keep_dims, Expr(), output_name + "_value");
+  return {ArgReduce(A, value, axis, keep_dims, output_name), value};
+}
+
+std::vector<Tensor> TopK(
+    const Tensor& A, int k, bool largest, const common::Target& target, const std::string& output_name) {
+  CHECK(A->type().is_float(32)) << "top_k only supports float32 now";
+  CHECK(!A->shape.empty() && A->shape.back().is_constant()) << "The last axis of top_k should be constant";
+  int cols = A->shape.back().as_int32();
+  CHECK(k > 0 && k <= cols) << "The k of top_k should be in [1, " << cols << "]";
+  Expr rows(1);
+  for (int i = 0; i + 1 < A->shape.size(); i++) rows = rows * A->shape[i];
+  rows = common::AutoSimplify(rows);
+
+  Tensor call;
+  if (target.arch == common::Target::Arch::NVGPU) {
+    CHECK_LE(k, kCudaTopKMaxK) << "The k of top_k is at most " << kCudaTopKMaxK << " on NVGPU";
+    // every thread of the block of a row calls the selection, which is cooperative
+    call = Compute(
+        {rows, Expr(kCudaTopKThreads)},
+        [=](Expr row, Expr thread) -> Expr {
+          return lang::CallExtern("cinn_cuda_top_k_fp32",
+                                  {
+                                      row,                              // row
+                                      Expr(cols),                       // cols
+                                      Expr(k),                          // k
+                                      Expr(static_cast<int>(largest)),  // largest
+                                      A,                                // x
+                                  });
+        },
+        UniqName(output_name + "_call"));
+  } else {
+    call = Compute(
+        {Expr(1)},
+        [=]() -> Expr {
+          return lang::CallExtern("cinn_cpu_top_k_fp32",
+                                  {
+                                      rows,                             // rows
+                                      Expr(cols),                       // cols
+                                      Expr(k),                          // k
+                                      Expr(static_cast<int>(largest)),  // largest
+                                      A,                                // x
+                                  });
+        },
+        UniqName(output_name + "_call"));
+  }
+  auto values = call->TupleGet(0);
+  values->WithBuffer(A->type());
+  auto indices = call->TupleGet(1);
+  indices->WithBuffer(Int(32));
+  return {values, indices, call};
+}
+
 }  // namespace pe
 }  // namespace hlir
 }  // namespace cinn
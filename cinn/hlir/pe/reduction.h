@@ -13,9 +13,11 @@
 // limitations under the License.
 
 #pragma once
+#include <functional>
 #include <string>
 #include <vector>
 
+#include "cinn/common/target.h"
 #include "cinn/ir/ir.h"
 
 namespace cinn {
@@ -99,6 +101,97 @@ ir::Tensor ReduceMin(const ir::Tensor& A,
                      Expr initial                   = Expr(),
                      const std::string& output_name = "T_Reduce_Min_out");
 
+using ReduceFunc =
+    std::function<ir::Tensor(const ir::Tensor&, const std::vector<int>&, bool, Expr, const std::string&)>;
+
+/**
+ * @brief reduce the trailing axes in two stages, the reduced elements are split into parts reduced independently into a
+ * partial tensor first, which is then reduced into the output. It exposes more parallelism when the output is small
+ * and the reduced extent is large.
+ *
+ * @param A The input Tensor
+ * @param axis The trailing axes to reduce, whose product of extents is divisible by num_parts.
+ * @param reduce_func The reduction, e.g. ReduceSum.
+ * @param num_parts The number of parts the reduced elements are split into.
+ * @param keep_dims If it is set true, the axes which are reduced are left in the result as dimensions with size one.
+ * @param output_name The name of the output Tensor
+ * @param interleave_parts If it is set true, the i-th part reduces every num_parts-th element from the i-th instead of
+ * the i-th chunk of them, so that the parts are the lanes of the vector accumulators reading the elements contiguously.
+ *
+ * @return The output Tensor, the partial Tensor of one more trailing axis of num_parts, and the input reshaped for the
+ * partial reduction, which is to compute inline.
+ */
+std::vector<ir::Tensor> TwoStageReduce(const ir::Tensor& A,
+                                       const std::vector<int>& axis,
+                                       const ReduceFunc& reduce_func,
+                                       int num_parts,
+                                       bool keep_dims,
+                                       const std::string& output_name,
+                                       bool interleave_parts = false);
+
+/**
+ * @brief reduce the axes in two stages by splitting the first reduced axis, which needs not be the trailing ones, into
+ * parts reduced independently into a partial tensor first, which is then reduced along the parts into the output. It
+ * exposes more parallelism when the output is small and the outer reduced extent is large, e.g. the column sums.
+ *
+ * @param A The input Tensor
+ * @param axis The axes to reduce, the extent of the first of which is constant and divisible by num_parts.
+ * @param reduce_func The reduction, e.g. ReduceSum.
+ * @param num_parts The number of parts the first reduced axis is split into.
+ * @param keep_dims If it is set true, the axes which are reduced are left in the result as dimensions with size one.
+ * @param output_name The name of the output Tensor
+ *
+ * @return The output Tensor, the partial Tensor with the axis of num_parts in the place of the first reduced axis, and
+ * the input reshaped for the partial reduction, which is to compute inline.
+ */
+std::vector<ir::Tensor> TwoStageReduceOuter(const ir::Tensor& A,
+                                            const std::vector<int>& axis,
+                                            const ReduceFunc& reduce_func,
+                                            int num_parts,
+                                            bool keep_dims,
+                                            const std::string& output_name);
+
+/**
+ * @brief find the indices of the maximum of array elements over a given axis, the first one of the ties
+ *
+ * @param A The input Tensor
+ * @param axis The axis to find the maximum over. If axis is negative it counts from the last to the first axis.
+ * @param keep_dims If it is set true, the axis which is reduced is left in the result as a dimension with size one.
+ * @param output_name The name of the output Tensor
+ *
+ * @return The int32 indices, and the maximum which it reduces in the same way as ReduceMax.
+ */
+std::vector<ir::Tensor> Argmax(const ir::Tensor& A,
+                               int axis,
+                               bool keep_dims                 = false,
+                               const std::string& output_name = "T_Argmax_out");
+
+/**
+ * @brief find the indices of the minimum of array elements over a given axis, the first one of the ties
+ *
+ * @return The int32 indices, and the minimum which it reduces in the same way as ReduceMin.
+ */
+std::vector<ir::Tensor> Argmin(const ir::Tensor& A,
+                               int axis,
+                               bool keep_dims                 = false,
+                               const std::string& output_name = "T_Argmin_out");
+
+/**
+ * @brief find the k largest, or smallest, elements of the last axis of a float32 tensor, in the descending, or
+ * ascending, order along with their int32 indices.
+ *
+ * On X86 the rows are selected by the heaps of k elements, or by the partial sort when k is not far less than the row,
+ * in parallel. On NVGPU a block selects a row by the radix select of the k-th element, and sorts the selected by the
+ * bitonic sort, of a warp if k is no more than 32. k is at most 1024 on NVGPU.
+ *
+ * @return The values, the indices and the extern call computing both, whose stage is scheduled on NVGPU.
+ */
+std::vector<ir::Tensor> TopK(const ir::Tensor& A,
+                             int k,
+                             bool largest,
+                             const common::Target& target,
+                             const std::string& output_name = "T_TopK_out");
+
 }  // namespace pe
 }  // namespace hlir
 }  // namespace cinn
@@ -16,18 +16,55 @@
 
 #include <absl/container/flat_hash_map.h>
 #include <isl/cpp.h>
+#include <unistd.h>
 
 #include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <numeric>
+#include <set>
+#include <sstream>
+#include <string>
 #include <utility>
 
 #include "cinn/common/cas.h"
+#include "cinn/ir/collect_ir_nodes.h"
+#include "cinn/ir/ir_mutator.h"
+#include "cinn/optim/ir_copy.h"
 #include "cinn/optim/ir_simplify.h"
 #include "cinn/poly/isl_utils.h"
 
+#ifdef CINN_WITH_CUDA
+#include "cinn/backends/cuda_util.h"
+#endif
+
+DEFINE_string(cinn_tuning_log,
+              "",
+              "The file of the conv params tuned by the AutoTuner, which override the static ones when the X86 convs "
+              "are scheduled. The {device} in it is replaced by the CPU model name, so that the machines with the "
+              "same CPU model share the tuned params.");
+DEFINE_bool(cinn_cuda_vectorize_injective,
+            true,
+            "Whether to access the contiguous elements of the injective ops on NVGPU by the float4 or half2 vectors.");
+DEFINE_string(cinn_cuda_tuning_log,
+              "",
+              "The file of the launch params of the CUDA injective kernels tuned by the AutoTuner, which override the "
+              "heuristic ones. The {device} in it is replaced by the GPU name and its compute capability, so that each "
+              "GPU generation keeps its own tuned params.");
+DEFINE_string(cinn_x86_blocking_isa,
+              "",
+              "The ISA the X86 convs and GEMMs are blocked for, \"avx512\" or \"avx2\", empty for the one the host CPU "
+              "supports.");
+DEFINE_bool(cinn_cuda_auto_cache,
+            true,
+            "Whether the reductions on NVGPU reduced by one thread for each output are accumulated in the registers, "
+            "and the inputs read by all the threads of a block are staged in the shared memory.");
+
 namespace cinn {
 namespace hlir {
 namespace pe {
@@ -67,11 +104,24 @@ int SplitEven(int origin) {
 }
 
 int GetBasicFactor(const Type &type, const common::Target &target) {
-  int target_native_vector_bits = target.get_target_bits() * 8;
+  int target_native_vector_bits = target.get_vector_bits();
   int type_bits                 = type.bits();
   return target_native_vector_bits / type_bits;
 }
 
+bool UseX86AVX512Blocking(const common::Target &target) {
+  if (target.arch != common::Target::Arch::X86) return false;
+  if (FLAGS_cinn_x86_blocking_isa == "avx512") return true;
+  if (FLAGS_cinn_x86_blocking_isa == "avx2") return false;
+  CHECK(FLAGS_cinn_x86_blocking_isa.empty()) << "Unknown X86 blocking ISA " << FLAGS_cinn_x86_blocking_isa;
+  return target.supports(common::Target::X86Feature::AVX512);
+}
+
+int GetX86BlockingLanes(const Type &type, const common::Target &target) {
+  if (target.arch != common::Target::Arch::X86) return GetBasicFactor(type, target);
+  return (UseX86AVX512Blocking(target) ? 512 : 256) / type.bits();
+}
+
 int GetBetterSplitFactor(int shape, int split_factor) {
   int better_factor = split_factor;
   while (better_factor > shape) {
@@ -92,11 +142,86 @@ int GetVectorizeFactor(int shape, int split_factor) {
   return better_factor;
 }
 
+namespace {
+bool IsVarNamed(const Expr &expr, const std::string &name) { return expr.as_var() && expr.as_var()->name == name; }
+
+bool AxesContiguousInLoads(const ir::_Tensor_ *tensor, int axis, int depth);
+
+// Erase the adjacent indices x and y of the loads taking them contiguously, where the extent of y is the full dim of
+// the loaded tensor. The computed tensors loaded so are checked in their bodies, which the fused kernels inline.
+struct ContiguousAxesEraser : public ir::IRMutator<> {
+  ContiguousAxesEraser(const std::string &x, const std::string &y, int64_t extent, int depth)
+      : x_(x), y_(y), extent_(extent), depth_(depth) {}
+
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+  bool inlined_contiguous{true};
+
+ private:
+  void Visit(const ir::Load *op, Expr *expr) override {
+    auto *node   = expr->As<ir::Load>();
+    auto *tensor = node->tensor.as_tensor();
+    for (int p = 0; tensor && p + 1 < node->indices.size() && p + 1 < tensor->shape.size(); p++) {
+      auto &dim = tensor->shape[p + 1];
+      if (!IsVarNamed(node->indices[p], x_) || !IsVarNamed(node->indices[p + 1], y_) || !dim.is_constant() ||
+          dim.get_constant() != extent_) {
+        continue;
+      }
+      if (tensor->is_compute_node() && !tensor->is_reduce_tensor() && !AxesContiguousInLoads(tensor, p, depth_ + 1)) {
+        inlined_contiguous = false;
+      }
+      node->indices[p]     = Expr(0);
+      node->indices[p + 1] = Expr(0);
+      break;
+    }
+    ir::IRMutator<>::Visit(op, expr);
+  }
+
+  std::string x_;
+  std::string y_;
+  int64_t extent_;
+  int depth_;
+};
+
+// Whether the axis and the next one of \p tensor are used by its body only as the contiguous indices of the loads.
+bool AxesContiguousInLoads(const ir::_Tensor_ *tensor, int axis, int depth) {
+  constexpr int kMaxInlinedDepth = 8;
+  auto &axes                     = tensor->axis();
+  if (depth > kMaxInlinedDepth || axis + 1 >= axes.size() || axis + 1 >= tensor->shape.size() ||
+      !tensor->shape[axis + 1].is_constant()) {
+    return false;
+  }
+  const std::string &x = axes[axis]->name;
+  const std::string &y = axes[axis + 1]->name;
+  Expr body            = optim::IRCopy(tensor->body());
+  ContiguousAxesEraser eraser(x, y, tensor->shape[axis + 1].get_constant(), depth);
+  eraser(&body);
+  return eraser.inlined_contiguous &&
+         ir::CollectIRNodes(body, [&](const Expr *e) { return IsVarNamed(*e, x) || IsVarNamed(*e, y); }).empty();
+}
+}  // namespace
+
+int GetContiguousInnerAxes(const ir::_Tensor_ *tensor) {
+  if (!tensor->is_compute_node() || tensor->is_reduce_tensor() || tensor->axis().empty()) return 1;
+  int dims = tensor->axis().size();
+  int num  = 1;
+  while (num < dims && AxesContiguousInLoads(tensor, dims - num - 1, 0)) num++;
+  return num;
+}
+
 void ScheduleInjectiveCPU(poly::Stage *stage,
                           const std::vector<int> &output_shape,
                           const common::Target &target,
                           bool vectorizable) {
-  int dims             = stage->n_out_dims();
+  int dims = stage->n_out_dims();
+  // the inner axes contiguous in all the operands are collapsed into a long innermost loop to vectorize
+  int collapsed = vectorizable && dims == stage->tensor()->axis().size() ? GetContiguousInnerAxes(stage->tensor()) : 1;
+  if (collapsed > 1) {
+    std::vector<int> levels(collapsed);
+    std::iota(levels.begin(), levels.end(), dims - collapsed);
+    stage->Fuse(levels);
+    dims = stage->n_out_dims();
+  }
   int factor           = GetBasicFactor(stage->tensor()->type(), target);
   poly::Iterator fused = stage->axis(0);
   if (dims >= 5) {
@@ -110,8 +235,9 @@ void ScheduleInjectiveCPU(poly::Stage *stage,
   if (vectorizable) {
     poly::Iterator lo;
     poly::Iterator li;
+    // the iterations of the last shape not filling the vectors are peeled off into a serial epilogue by VectorizeLoops
     int last_shape   = stage->GetDimRange(dims - 1);
-    factor           = GetVectorizeFactor(last_shape, factor);
+    factor           = last_shape > factor ? factor : GetVectorizeFactor(last_shape, factor);
     std::tie(lo, li) = stage->Split(stage->axis(dims - 1), factor);
     stage->Vectorize(li, factor);
     if (dims == 1) {
@@ -120,6 +246,83 @@ void ScheduleInjectiveCPU(poly::Stage *stage,
   }
 }
 
+void ScheduleGatherCPU(poly::Stage *stage, const std::vector<int> &output_shape, const common::Target &target) {
+  int dims = stage->n_out_dims();
+  if (dims < 2) {
+    ScheduleInjectiveCPU(stage, output_shape, target);
+    return;
+  }
+  for (int i = 1; i < dims - 1; i++) {
+    stage->Fuse(0, 1);
+  }
+  // the parallel tasks gather the rows one after another, so that the rows ahead are prefetched in the serial loop
+  constexpr int kRowsPerTask = 64;
+  int rows = std::accumulate(output_shape.begin(), output_shape.end() - 1, 1, std::multiplies<int>());
+  if (rows > kRowsPerTask) {
+    stage->Split(0, kRowsPerTask);
+    stage->Parallel(0);
+  }
+  int factor = GetBasicFactor(stage->tensor()->type(), target);
+  int row    = output_shape.back();
+  factor     = row > factor ? factor : GetVectorizeFactor(row, factor);
+  auto lo_li = stage->Split(stage->n_out_dims() - 1, factor);
+  stage->Vectorize(std::get<1>(lo_li), factor);
+}
+
+void ScheduleSmallMatmulCPU(poly::Stage *stage, const std::vector<int> &output_shape, const common::Target &target) {
+  int dims = output_shape.size();
+  CHECK(dims == 2 || dims == 3) << "The small matmul should be 2 or 3 dims while current dim is " << dims;
+  // the tasks of one tiny matrix each cost more to spawn than to compute
+  constexpr int kMatricesPerTask = 16;
+  // the outputs of a matrix unrolled entirely, beyond which only the columns are
+  constexpr int kUnrolledOutputs = 64;
+  if (dims == 3 && output_shape[0] > kMatricesPerTask) {
+    stage->Split(0, kMatricesPerTask);
+    stage->Parallel(0);
+  }
+  int levels = stage->n_out_dims();
+  if (output_shape[dims - 2] * output_shape[dims - 1] <= kUnrolledOutputs) stage->Unroll(levels - 2);
+  stage->Unroll(levels - 1);
+}
+
+namespace {
+//! The independent vector accumulators of a reduction on X86, which hide the latency of the vector adds.
+constexpr int kCpuReduceAccumulators = 4;
+}  // namespace
+
+int GetCpuReduceParts(int reduce_numel, const Type &type, const common::Target &target) {
+  int lanes = GetBasicFactor(type, target);
+  for (int accumulators = kCpuReduceAccumulators; accumulators > 1 && lanes > 1; accumulators /= 2) {
+    int num_parts = lanes * accumulators;
+    // each part reduces a few elements at least, or the second stage costs as much as the first
+    if (reduce_numel % num_parts == 0 && reduce_numel >= num_parts * 4) return num_parts;
+  }
+  return 1;
+}
+
+void ScheduleReduceCPU(poly::Stage *stage, const common::Target &target) {
+  auto *tensor    = stage->tensor();
+  int num_reduce  = tensor->reduce_axis.size();
+  int num_spatial = stage->n_out_dims() - num_reduce;
+  CHECK_GT(num_reduce, 0) << "ScheduleReduceCPU only schedules the reductions";
+  // the innermost kept axis, after which the axes of extent 1 kept by keep_dims are moved out with the reduced ones
+  int level = num_spatial - 1;
+  while (level > 0 && stage->GetDimRange(level) == 1) level--;
+  if (level < 0) return;
+  int factor = GetBasicFactor(tensor->type(), target) * kCpuReduceAccumulators;
+  int extent = stage->GetDimRange(level);
+  factor     = extent > factor ? factor : GetVectorizeFactor(extent, factor);
+  if (factor <= 1) return;
+  // the vectors of the innermost kept axis are reduced in the innermost loop, the remainder is peeled off serially
+  auto lo_li = stage->Split(level, factor);
+  std::vector<poly::Iterator> order;
+  for (int i = level + 2; i < stage->n_out_dims(); i++) order.push_back(stage->ith_iterator(i));
+  order.push_back(std::get<1>(lo_li));
+  stage->Reorder(order);
+  stage->Vectorize(stage->n_out_dims() - 1, factor);
+  if (level > 0 && stage->GetDimRange(0) > 1) stage->Parallel(0);
+}
+
 void ScheduleInjectiveCPU1(poly::Stage *stage,
                            const std::vector<int> &output_shape,
                            const common::Target &target,
@@ -130,7 +333,7 @@ void ScheduleInjectiveCPU1(poly::Stage *stage,
     CHECK_EQ(stage->n_out_dims(), output_shape.size())
         << "The origin stage out dims should be same with output_shape sizes";
     poly::Iterator fused          = stage->axis(dims - 1);
-    int target_native_vector_bits = target.get_target_bits() * 8;
+    int target_native_vector_bits = target.get_vector_bits();
     int type_bits                 = stage->tensor()->type().bits();
     int prod_size                 = output_shape.back();
     // fuse conservatively for the complex index from poly and may not benefit a lot compared with llvm optimization,
@@ -176,112 +379,150 @@ int GetArrayPackingFactor(int shape, const Type &type, const common::Target &tar
   return split_factor;
 }
 
+namespace {
+// The size of the data cache of the level, from the host or a common size if it is unknown.
+int GetCacheBytes(int level) {
+  static const std::vector<int> cache_bytes = [] {
+    std::vector<int> bytes = {32 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+    int names[] = {_SC_LEVEL1_DCACHE_SIZE, _SC_LEVEL2_CACHE_SIZE, _SC_LEVEL3_CACHE_SIZE};
+    for (int i = 0; i < 3; i++) {
+      long size = sysconf(names[i]);
+      if (size > 0) bytes[i] = size;
+    }
+#endif
+    return bytes;
+  }();
+  return cache_bytes[level - 1];
+}
+
+// The largest factor no larger than bound, which is a multiple of step and divides extent, extent itself if no such one.
+int GetBlockingFactor(int extent, int bound, int step = 1) {
+  for (int i = std::min(extent, bound) / step * step; i >= step; i -= step) {
+    if (extent % i == 0) return i;
+  }
+  return extent;
+}
+}  // namespace
+
+X86GemmBlocking GetX86GemmBlocking(int M, int N, int K, const Type &type, const common::Target &target) {
+  int lanes = GetX86BlockingLanes(type, target);
+  int bytes = type.bits() / 8;
+  // the microkernel of 2 vectors wide uses 2 * mr accumulators, AVX-512 has 32 vector registers and AVX2 16
+  bool avx512 = UseX86AVX512Blocking(target);
+  X86GemmBlocking blocking;
+  blocking.nr = GetBlockingFactor(N, 2 * lanes);
+  blocking.mr = GetBlockingFactor(M, avx512 ? 14 : 6);
+  blocking.kc = GetBlockingFactor(K, std::max(GetCacheBytes(1) / 2 / ((blocking.mr + blocking.nr) * bytes), 1));
+  // too short a kc leaves the reduction outside the microkernel, e.g. for the prime K
+  if (blocking.kc < std::min(K, 16)) blocking.kc = K;
+  blocking.mc = GetBlockingFactor(M, std::max(GetCacheBytes(2) / 2 / (blocking.kc * bytes), blocking.mr), blocking.mr);
+  blocking.nc = GetBlockingFactor(N, std::max(GetCacheBytes(3) / 2 / (blocking.kc * bytes), blocking.nr), blocking.nr);
+  VLOG(3) << "GEMM blocking of " << M << "x" << N << "x" << K << ": mr " << blocking.mr << ", nr " << blocking.nr
+          << ", mc " << blocking.mc << ", nc " << blocking.nc << ", kc " << blocking.kc;
+  return blocking;
+}
+
+namespace {
+// Tile the loops [batch..., M, N, K] of the GEMM stage by the blocking of GetX86GemmBlocking.
+void BlockGemmLoopsCPU(
+    poly::Stage *stage, int batch_dims, int M, int N, int K, const Type &type, const common::Target &target) {
+  auto blocking = GetX86GemmBlocking(M, N, K, type, target);
+  // split the axis by the factors from the outer to the inner, the levels not split are left undefined, as splitting
+  // by the extent or 1 hits the wrong elimination of isl
+  auto split_axis = [&](poly::Iterator axis, int extent, const std::vector<int> &factors) {
+    std::vector<poly::Iterator> levels(factors.size() + 1);
+    for (int i = 0; i < factors.size(); i++) {
+      if (factors[i] > 1 && factors[i] < extent) {
+        auto outer_inner = stage->Split(axis, factors[i]);
+        levels[i]        = std::get<0>(outer_inner);
+        axis             = std::get<1>(outer_inner);
+        extent           = factors[i];
+      } else if (factors[i] == 1) {
+        levels[i] = axis;
+        axis      = poly::Iterator();
+        break;
+      }
+    }
+    levels.back() = axis;
+    return levels;
+  };
+  auto i_axes = split_axis(stage->axis(batch_dims), M, {blocking.mc, blocking.mr});
+  auto j_axes = split_axis(stage->axis(batch_dims + 1), N, {blocking.nc, blocking.nr});
+  auto k_axes = split_axis(stage->axis(batch_dims + 2), K, {blocking.kc});
+
+  // the loops from the outer to the inner, the mc x kc block of A is reused across the nc blocks, and each microkernel
+  // loops kc on the mr x nr accumulators
+  std::vector<poly::Iterator> order;
+  for (int i = 0; i < batch_dims; i++) order.push_back(stage->axis(i));
+  for (auto *axis : {&i_axes[0], &j_axes[0], &k_axes[0], &i_axes[1], &j_axes[1], &k_axes[1], &i_axes[2], &j_axes[2]}) {
+    if (!axis->id.empty()) order.push_back(*axis);
+  }
+  stage->Reorder(order);
+  // the blocks of C are parallel, but not the reduction
+  if (order.front() != k_axes[0] && order.front() != k_axes[1]) stage->Parallel(order.front());
+  auto &i_register = i_axes[2];
+  auto &j_register = j_axes[2];
+  if (!i_register.id.empty() && blocking.mr > 1 && i_register.id != order.front().id) stage->Unroll(i_register);
+  if (!j_register.id.empty() && blocking.nr >= 4) stage->Vectorize(j_register, blocking.nr);
+}
+}  // namespace
+
 void MatmulScheduleCPU(poly::StageMap stages,
                        const ir::Tensor &output,
                        const ir::Tensor &packedB,
+                       const ir::Tensor &packedA,
                        const common::Target &target) {
   CHECK_EQ(output->type(), packedB->type());
-  int basic_split_factor = GetBasicFactor(packedB->type(), target);
-  // packedB
-  int packedB_dims         = stages[packedB]->axis_names().size();
-  int packed_last_dim      = packedB->shape[packedB_dims - 1].as_int32();
-  int packedB_split_factor = GetBetterSplitFactor(packed_last_dim, basic_split_factor);
-  // tempory solution for indivisible case
-  if (packedB_split_factor >= 8 && packed_last_dim % packedB_split_factor == 0) {
-    stages[packedB]->Vectorize(packedB_dims - 1, packedB_split_factor);
-  }
-  // output
   int output_size = output->shape.size();
-  // M, N
-  int M             = output->shape[output_size - 2].as_int32();
-  int N             = output->shape[output_size - 1].as_int32();
-  int bm            = GetArrayPackingFactor(M, output->type(), target);
-  int bn            = GetArrayPackingFactor(N, output->type(), target);
-  int out_axis_dims = stages[output]->axis_names().size();
-  CHECK_GE(out_axis_dims, 3U) << "output tensor's size should be at least 3";
-  poly::Iterator i_axis = stages[output]->axis(out_axis_dims - 3);
-  poly::Iterator j_axis = stages[output]->axis(out_axis_dims - 2);
-  poly::Iterator i_outer, i_inner, j_outer, j_inner;
-  std::vector<poly::Iterator> i_axes, j_axes, k_axes;
-  std::vector<poly::Iterator> all_axes;
-  std::vector<poly::Iterator> all_axes_outer;
-  std::vector<poly::Iterator> all_axes_inner;
-  bool is_m_splited = false;
-  bool is_n_splited = false;
-  // tempory solution for isl for1 wrong elimination
-  if (bm >= 4 && M != bm) {
-    auto axes = stages[output]->Split(i_axis, bm);
-    all_axes_outer.push_back(std::get<0>(axes));
-    all_axes_inner.push_back(std::get<1>(axes));
-    is_m_splited = true;
-  } else {
-    all_axes_outer.push_back(i_axis);
-  }
-  out_axis_dims = stages[output]->axis_names().size();
-  // temp solution for isl for1 wrong elimination
-  if (bn >= 4 && N != bn) {
-    auto axes = stages[output]->Split(j_axis, bn);
-    all_axes_outer.push_back(std::get<0>(axes));
-    all_axes_inner.push_back(std::get<1>(axes));
-    is_n_splited = true;
-  } else {
-    all_axes_outer.push_back(j_axis);
-  }
-  // K
-  int K              = packedB->shape[packedB->shape.size() - 2].as_int32();
-  int k_split_factor = GetBetterSplitFactor(K, basic_split_factor);
-  out_axis_dims      = stages[output]->axis_names().size();
-  auto k_axis        = stages[output]->axis(out_axis_dims - 1);
-  bool is_k_splited  = false;
-  if (k_split_factor >= 4) {
-    auto axes = stages[output]->Split(k_axis, k_split_factor);
-    k_axes.push_back(std::get<0>(axes));
-    k_axes.push_back(std::get<1>(axes));
-    all_axes_outer.push_back(std::get<0>(axes));
-    all_axes_inner.push_back(std::get<1>(axes));
-    is_k_splited = true;
-  } else {
-    all_axes_outer.push_back(k_axis);
-  }
-  std::vector<poly::Iterator> new_order;
-  out_axis_dims = stages[output]->axis_names().size();
-  if (output_size > 2) {
-    // batch
-    all_axes.push_back(stages[output]->axis(0));
-  }
-  for (int i = 0; i < all_axes_outer.size(); ++i) {
-    all_axes.push_back(all_axes_outer[i]);
-  }
-  for (int i = 0; i < all_axes_inner.size(); ++i) {
-    all_axes.push_back(all_axes_inner[i]);
-  }
-  // int axies
-  CHECK_EQ(all_axes.size(), out_axis_dims);
-  if (is_k_splited) {
-    if (is_m_splited || is_n_splited) {
-      // swap k_inner and j_inner/i_inner
-      std::swap(all_axes[out_axis_dims - 1], all_axes[out_axis_dims - 2]);
-    } else {
-      // swap k_inner and j
-      std::swap(all_axes[out_axis_dims - 1], all_axes[out_axis_dims - 3]);
-    }
-  } else {
-    // swap k and j
-    std::swap(all_axes[out_axis_dims - 1], all_axes[out_axis_dims - 2]);
-  }
-  stages[output]->Reorder(all_axes);
-  // vectorize output's last dimemsion
-  auto out_domain = stages[output]->transformed_domain();
-  auto range      = poly::isl_set_get_axis_range(out_domain.get(), out_axis_dims - 1);
-  auto &min       = std::get<0>(range);
-  auto &max       = std::get<1>(range);
-  CHECK_EQ(min.get_num_si(), 0) << "axis range should begin from zero";
-  int out_last_dim        = max.get_num_si() + 1;
-  int output_split_factor = GetBetterSplitFactor(out_last_dim, basic_split_factor);
-  // tempory solution for indivisible case
-  if (output_split_factor >= 8 && packed_last_dim % output_split_factor == 0) {
-    stages[output]->Vectorize(out_axis_dims - 1, output_split_factor);
-  }
+  int M           = output->shape[output_size - 2].as_int32();
+  int N           = output->shape[output_size - 1].as_int32();
+  int K           = packedB->shape[packedB->shape.size() - 2].as_int32();
+  auto blocking   = GetX86GemmBlocking(M, N, K, output->type(), target);
+
+  // the packings are parallel on the panels, and packedB is vectorized on nr
+  int packedB_dims = stages[packedB]->n_out_dims();
+  if (blocking.nr >= 8) stages[packedB]->Vectorize(packedB_dims - 1, blocking.nr);
+  stages[packedB]->Parallel(0);
+  stages[packedA]->Parallel(0);
+  BlockGemmLoopsCPU(stages[output], output_size - 2, M, N, K, output->type(), target);
+}
+
+void Conv2d_Winograd_Schedule_CPU(poly::StageMap stages,
+                                  const ir::Tensor &output,
+                                  const ir::Tensor &batched_matmul,
+                                  const ir::Tensor &data_transform,
+                                  const ir::Tensor &input_pad,
+                                  const common::Target &target) {
+  stages[input_pad]->ComputeInline();
+  // the transforms are parallel on the tile positions and the channels
+  stages[data_transform]->Fuse(0, 1);
+  stages[data_transform]->Parallel(0);
+  int M = batched_matmul->shape[1].as_int32();
+  int N = batched_matmul->shape[2].as_int32();
+  int K = data_transform->shape[1].as_int32();
+  BlockGemmLoopsCPU(stages[batched_matmul], 1, M, N, K, output->type(), target);
+  stages[output]->Fuse(0, 1);
+  stages[output]->Parallel(0);
+}
+
+void Conv2d_Im2col_Schedule_CPU(poly::StageMap stages,
+                                const ir::Tensor &output,
+                                const ir::Tensor &gemm,
+                                const ir::Tensor &packed_im2col,
+                                const ir::Tensor &packed_weights,
+                                const ir::Tensor &im2col,
+                                const ir::Tensor &input_pad,
+                                const ir::Tensor &weights_3d,
+                                const common::Target &target) {
+  // the packings read the input and the weights by the im2col indices
+  stages[input_pad]->ComputeInline();
+  stages[im2col]->ComputeInline();
+  stages[weights_3d]->ComputeInline();
+  MatmulScheduleCPU(stages, gemm, packed_im2col, packed_weights, target);
+  std::vector<int> output_shape;
+  for (auto &dim : output->shape) output_shape.push_back(dim.as_int32());
+  ScheduleInjectiveCPU(stages[output], output_shape, target);
 }
 
 void MulScheduleCPU(poly::StageMap stages,
@@ -334,11 +575,21 @@ void PoolScheduleCPU(poly::StageMap stages, const ir::Tensor &output, const comm
 }
 
 void PoolScheduleGPU(poly::StageMap stages, ir::Tensor &output, const common::Target &target) {
-  CHECK_GE(stages[output]->axis_names().size(), 4);
-  stages[output]->Fuse({0, 1, 2, 3});
-  stages[output]->Split(0, 1024);
-  stages[output]->Bind(0, "blockIdx.x");
-  stages[output]->Bind(1, "threadIdx.x");
+  auto *stage  = stages[output];
+  int num_axes = output->shape.size();
+  CHECK_GE(num_axes, 4);
+  // all the output axes are fused, including the channel blocks of NCHWc, each thread pools one output
+  for (int i = 1; i < num_axes; i++) stage->Fuse(0, 1);
+  int numel = 1;
+  for (auto &dim : output->shape) numel = dim.is_constant() ? numel * dim.as_int32() : 0;
+  int num_thread = target.max_num_threads();
+  if (numel > 0 && numel <= num_thread) {
+    stage->Bind(0, "threadIdx.x");
+    return;
+  }
+  stage->Split(0, num_thread);
+  stage->Bind(0, "blockIdx.x");
+  stage->Bind(1, "threadIdx.x");
 }
 
 void GetConv2dFactors(absl::flat_hash_map<std::string, int> *factors,
@@ -352,24 +603,28 @@ void GetConv2dFactors(absl::flat_hash_map<std::string, int> *factors,
                       const std::string &key,
                       bool import_params) {
   if (import_params) {
-    auto &params = ScheduleParam::get_x86_instance().GetParam();
-    if (params.empty()) {
-      CreateX86SerialData();
-      LoadSerialData(&params);
-    }
+    auto &params = GetX86ConvParams();
+    absl::flat_hash_map<std::string, std::vector<int>> param;
     if (params.count(key)) {
       VLOG(3) << "find saved param, key is: " << key;
-      CHECK(!params[key]["oc_bn"].empty());
-      CHECK(!params[key]["ic_bn"].empty());
-      CHECK(!params[key]["ow_bn"].empty());
-      (*factors)["oc_bn"] = params[key]["oc_bn"].back();
-      (*factors)["ic_bn"] = params[key]["ic_bn"].back();
-      (*factors)["ow_bn"] = params[key]["ow_bn"].back();
-      if (!params[key]["oh_bn"].empty()) {
-        (*factors)["oh_bn"] = params[key]["oh_bn"].back();
+      param = params.at(key);
+    } else if (GetNearestX86ConvParams(key, &param)) {
+      VLOG(3) << "find saved param of the nearest shape, key is: " << key;
+    } else {
+      VLOG(3) << "Can not find saved param, key is: " << key;
+    }
+    if (!param.empty()) {
+      CHECK(!param["oc_bn"].empty());
+      CHECK(!param["ic_bn"].empty());
+      CHECK(!param["ow_bn"].empty());
+      (*factors)["oc_bn"] = param["oc_bn"].back();
+      (*factors)["ic_bn"] = param["ic_bn"].back();
+      (*factors)["ow_bn"] = param["ow_bn"].back();
+      if (!param["oh_bn"].empty()) {
+        (*factors)["oh_bn"] = param["oh_bn"].back();
       }
-      if (!params[key]["unroll_kw"].empty()) {
-        (*factors)["unroll_kw"] = params[key]["unroll_kw"].back();
+      if (!param["unroll_kw"].empty()) {
+        (*factors)["unroll_kw"] = param["unroll_kw"].back();
       }
       if (ic == fc) {
         (*factors)["fc_bn"] = (*factors)["ic_bn"];
@@ -385,11 +640,9 @@ void GetConv2dFactors(absl::flat_hash_map<std::string, int> *factors,
         (*factors)["fc_bn"] = fc_bn;
       }
       return;
-    } else {
-      VLOG(3) << "Can not find saved param, key is: " << key;
     }
   }
-  int bn_base = GetBasicFactor(type, target);
+  int bn_base = GetX86BlockingLanes(type, target);
   int oc_bn   = 1;
   for (int i = bn_base; i > 1; i--) {
     if (oc < 1) break;
@@ -429,14 +682,17 @@ void GetConv2dFactors(absl::flat_hash_map<std::string, int> *factors,
     }
     (*factors)["ow_bn"] = ow_bn;
   } else {
-    int oh_bn = 1;
-    int begin = std::min(ow, bn_base);
+    // the oh_bn x ow_bn accumulators of the 1x1 microkernel stay in the vector registers with the weights, of the 32
+    // registers of AVX-512 or the 16 of AVX2
+    int max_accumulators = target.arch == common::Target::Arch::X86 && !UseX86AVX512Blocking(target) ? 12 : 16;
+    int oh_bn            = 1;
+    int begin            = std::min(ow, bn_base);
     for (int i = begin; i >= 1; i--) {
       if (ow < 1) break;
       if (ow % i == 0) {
         ow_bn = i;
         for (int j = oh; j >= 1; j--) {
-          if (oh % j == 0 && j * ow_bn <= 16) {
+          if (oh % j == 0 && j * ow_bn <= max_accumulators) {
             oh_bn               = j;
             (*factors)["oh_bn"] = oh_bn;
             (*factors)["ow_bn"] = ow_bn;
@@ -455,7 +711,7 @@ void GetConv2d1x1Factors(absl::flat_hash_map<std::string, int> *factors,
                          int ow,
                          const Type &type,
                          const common::Target &target) {
-  int bn_base = GetBasicFactor(type, target);
+  int bn_base = GetX86BlockingLanes(type, target);
   int oc_bn   = 1;
   for (int i = bn_base; i > 1; i--) {
     if (oc < 1) break;
@@ -474,15 +730,16 @@ void GetConv2d1x1Factors(absl::flat_hash_map<std::string, int> *factors,
   }
   (*factors)["oc_bn"] = oc_bn;
   (*factors)["ic_bn"] = ic_bn;
-  int ow_bn           = 1;
-  int oh_bn           = 1;
-  int begin           = std::min(ow, bn_base);
+  int ow_bn            = 1;
+  int oh_bn            = 1;
+  int begin            = std::min(ow, bn_base);
+  int max_accumulators = target.arch == common::Target::Arch::X86 && !UseX86AVX512Blocking(target) ? 12 : 16;
   for (int i = begin; i >= 1; i--) {
     if (ow < 1) break;
     if (ow % i == 0) {
       ow_bn = i;
       for (int j = oh; j >= 1; j--) {
-        if (oh % j == 0 && j * ow_bn <= 16) {
+        if (oh % j == 0 && j * ow_bn <= max_accumulators) {
           oh_bn               = j;
           (*factors)["oh_bn"] = oh_bn;
           (*factors)["ow_bn"] = ow_bn;
@@ -694,6 +951,194 @@ void CreateX86SerialData(const std::string &file_name) {
   SaveSerialData(model_data, file_name);
 }
 
+void CreateX86AVX2SerialData(const std::string &file_name) {
+  absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, std::vector<int>>> model_data;
+  /** The microkernels keep their accumulators and the weights in the 16 vector registers of 8 floats of AVX2: the
+   * oc_bn of 16 in 2 registers by the ow_bn of 4 pixels, or the oc_bn of 8 by 7 pixels for the narrow outputs, and the
+   * ic_bn of 8 of the inner reduction.
+   */
+  // resnet 1
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 3 224 224 weight 64 3 7 7 stride 2 2 padding 3 3 dilation 1 1",
+                {{"ic_bn", {1, 3}}, {"oc_bn", {4, 16}}, {"ow_bn", {28, 4}}, {"unroll_kw", {0}}});
+  // resnet 3 4 5 6
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 64 56 56 weight 64 64 3 3 stride 1 1 padding 1 1 dilation 1 1",
+                {{"ic_bn", {8, 8}}, {"oc_bn", {4, 16}}, {"ow_bn", {14, 4}}, {"unroll_kw", {1}}});
+  // resnet 8
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 64 56 56 weight 128 64 3 3 stride 2 2 padding 1 1 dilation 1 1",
+                {{"ic_bn", {8, 8}}, {"oc_bn", {8, 16}}, {"ow_bn", {7, 4}}, {"unroll_kw", {1}}});
+  // resnet 9 10 11
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 128 28 28 weight 128 128 3 3 stride 1 1 padding 1 1 dilation 1 1",
+                {{"ic_bn", {16, 8}}, {"oc_bn", {8, 16}}, {"ow_bn", {7, 4}}, {"unroll_kw", {1}}});
+  // resnet 13
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 128 28 28 weight 256 128 3 3 stride 2 2 padding 1 1 dilation 1 1",
+                {{"ic_bn", {16, 8}}, {"oc_bn", {32, 8}}, {"ow_bn", {2, 7}}, {"unroll_kw", {1}}});
+  // resnet 14 15 16
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 256 14 14 weight 256 256 3 3 stride 1 1 padding 1 1 dilation 1 1",
+                {{"ic_bn", {32, 8}}, {"oc_bn", {32, 8}}, {"ow_bn", {2, 7}}, {"unroll_kw", {1}}});
+  // resnet 18
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 256 14 14 weight 512 256 3 3 stride 2 2 padding 1 1 dilation 1 1",
+                {{"ic_bn", {32, 8}}, {"oc_bn", {64, 8}}, {"ow_bn", {1, 7}}, {"unroll_kw", {1}}});
+  // resnet 19 20 21
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 512 7 7 weight 512 512 3 3 stride 1 1 padding 1 1 dilation 1 1",
+                {{"ic_bn", {64, 8}}, {"oc_bn", {64, 8}}, {"ow_bn", {1, 7}}, {"unroll_kw", {1}}});
+  // resnet 7
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 64 56 56 weight 128 64 1 1 stride 2 2 padding 0 0 dilation 1 1",
+                {{"ic_bn", {8, 8}}, {"oc_bn", {8, 16}}, {"ow_bn", {7, 4}}, {"oh_bn", {1}}});
+  // resnet 12
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 128 28 28 weight 256 128 1 1 stride 2 2 padding 0 0 dilation 1 1",
+                {{"ic_bn", {16, 8}}, {"oc_bn", {32, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  // resnet 17
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 256 14 14 weight 512 256 1 1 stride 2 2 padding 0 0 dilation 1 1",
+                {{"ic_bn", {32, 8}}, {"oc_bn", {64, 8}}, {"ow_bn", {1, 7}}, {"oh_bn", {1}}});
+  // resnet50
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 64 56 56 weight 64 64 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {8, 8}}, {"oc_bn", {4, 16}}, {"ow_bn", {14, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 64 56 56 weight 256 64 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {8, 8}}, {"oc_bn", {16, 16}}, {"ow_bn", {14, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 256 56 56 weight 64 256 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {32, 8}}, {"oc_bn", {4, 16}}, {"ow_bn", {14, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 256 56 56 weight 128 256 1 1 stride 2 2 padding 0 0 dilation 1 1",
+                {{"ic_bn", {32, 8}}, {"oc_bn", {8, 16}}, {"ow_bn", {7, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 256 56 56 weight 512 256 1 1 stride 2 2 padding 0 0 dilation 1 1",
+                {{"ic_bn", {32, 8}}, {"oc_bn", {32, 16}}, {"ow_bn", {7, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 128 28 28 weight 512 128 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {16, 8}}, {"oc_bn", {32, 16}}, {"ow_bn", {7, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 512 28 28 weight 128 512 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {64, 8}}, {"oc_bn", {8, 16}}, {"ow_bn", {7, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 512 28 28 weight 256 512 1 1 stride 2 2 padding 0 0 dilation 1 1",
+                {{"ic_bn", {64, 8}}, {"oc_bn", {32, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 512 28 28 weight 1024 512 1 1 stride 2 2 padding 0 0 dilation 1 1",
+                {{"ic_bn", {64, 8}}, {"oc_bn", {128, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 256 14 14 weight 1024 256 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {32, 8}}, {"oc_bn", {128, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 1024 14 14 weight 256 1024 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {128, 8}}, {"oc_bn", {32, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 1024 14 14 weight 512 1024 1 1 stride 2 2 padding 0 0 dilation 1 1",
+                {{"ic_bn", {128, 8}}, {"oc_bn", {64, 8}}, {"ow_bn", {1, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 1024 14 14 weight 2048 1024 1 1 stride 2 2 padding 0 0 dilation 1 1",
+                {{"ic_bn", {128, 8}}, {"oc_bn", {256, 8}}, {"ow_bn", {1, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 512 7 7 weight 2048 512 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {64, 8}}, {"oc_bn", {256, 8}}, {"ow_bn", {1, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 2048 7 7 weight 512 2048 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {256, 8}}, {"oc_bn", {64, 8}}, {"ow_bn", {1, 7}}, {"oh_bn", {1}}});
+  // mobilenet v1
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 3 224 224 weight 32 3 3 3 stride 2 2 padding 1 1 dilation 1 1",
+                {{"ic_bn", {1, 3}}, {"oc_bn", {2, 16}}, {"ow_bn", {28, 4}}, {"unroll_kw", {0}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 32 112 112 weight 64 32 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {4, 8}}, {"oc_bn", {4, 16}}, {"ow_bn", {28, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 64 56 56 weight 128 64 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {8, 8}}, {"oc_bn", {8, 16}}, {"ow_bn", {14, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 128 56 56 weight 128 128 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {16, 8}}, {"oc_bn", {8, 16}}, {"ow_bn", {14, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 128 28 28 weight 256 128 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {16, 8}}, {"oc_bn", {16, 16}}, {"ow_bn", {7, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 256 28 28 weight 256 256 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {32, 8}}, {"oc_bn", {16, 16}}, {"ow_bn", {7, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 256 14 14 weight 512 256 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {32, 8}}, {"oc_bn", {64, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 512 14 14 weight 512 512 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {64, 8}}, {"oc_bn", {64, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 512 7 7 weight 1024 512 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {64, 8}}, {"oc_bn", {128, 8}}, {"ow_bn", {1, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 1024 7 7 weight 1024 1024 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {128, 8}}, {"oc_bn", {128, 8}}, {"ow_bn", {1, 7}}, {"oh_bn", {1}}});
+  // mobilenet v2
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 32 112 112 weight 16 32 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {4, 8}}, {"oc_bn", {1, 16}}, {"ow_bn", {28, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 16 112 112 weight 96 16 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {2, 8}}, {"oc_bn", {6, 16}}, {"ow_bn", {28, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 96 56 56 weight 24 96 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {12, 8}}, {"oc_bn", {3, 8}}, {"ow_bn", {8, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 24 56 56 weight 144 24 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {3, 8}}, {"oc_bn", {9, 16}}, {"ow_bn", {14, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 144 56 56 weight 24 144 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {18, 8}}, {"oc_bn", {3, 8}}, {"ow_bn", {8, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 144 28 28 weight 32 144 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {18, 8}}, {"oc_bn", {2, 16}}, {"ow_bn", {7, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 32 28 28 weight 192 32 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {4, 8}}, {"oc_bn", {12, 16}}, {"ow_bn", {7, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 192 28 28 weight 32 192 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {24, 8}}, {"oc_bn", {2, 16}}, {"ow_bn", {7, 4}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 192 14 14 weight 64 192 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {24, 8}}, {"oc_bn", {8, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 64 14 14 weight 384 64 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {8, 8}}, {"oc_bn", {48, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 384 14 14 weight 64 384 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {48, 8}}, {"oc_bn", {8, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 384 14 14 weight 96 384 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {48, 8}}, {"oc_bn", {12, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 96 14 14 weight 576 96 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {12, 8}}, {"oc_bn", {72, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 576 14 14 weight 96 576 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {72, 8}}, {"oc_bn", {12, 8}}, {"ow_bn", {2, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 576 7 7 weight 160 576 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {72, 8}}, {"oc_bn", {20, 8}}, {"ow_bn", {1, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 160 7 7 weight 960 160 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {20, 8}}, {"oc_bn", {120, 8}}, {"ow_bn", {1, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 960 7 7 weight 160 960 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {120, 8}}, {"oc_bn", {20, 8}}, {"ow_bn", {1, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 960 7 7 weight 320 960 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {120, 8}}, {"oc_bn", {40, 8}}, {"ow_bn", {1, 7}}, {"oh_bn", {1}}});
+  InputX86Param(model_data,
+                "X86ScheduleConv input 1 320 7 7 weight 1280 320 1 1 stride 1 1 padding 0 0 dilation 1 1",
+                {{"ic_bn", {40, 8}}, {"oc_bn", {160, 8}}, {"ow_bn", {1, 7}}, {"oh_bn", {1}}});
+  SaveSerialData(model_data, file_name);
+}
+
 void Conv2d_NCHWc_1X1_Schedule_CPU(poly::StageMap stages,
                                    const ir::Tensor &res,
                                    ir::Tensor &packed_out,
@@ -703,7 +1148,7 @@ void Conv2d_NCHWc_1X1_Schedule_CPU(poly::StageMap stages,
                                    const common::Target &target,
                                    const std::string &key,
                                    bool do_padding) {
-  CHECK(target.arch == Target::Arch::X86) << "Conv2d_NCHWc_1X1_Schedule_CPU schedule only used in x86";
+  CHECK(target.is_cpu()) << "Conv2d_NCHWc_1X1_Schedule_CPU schedule only used on the CPUs";
   CHECK(packed_out.defined());
   CHECK(input_pad.defined());
   auto type = packed_out->type();
@@ -830,7 +1275,7 @@ void Conv2d_NCHWc_1X1_Schedule_CPU_Nofuse(poly::StageMap stages,
                                           const ir::Tensor &weights_dilation,
                                           const ir::Tensor &data,
                                           const common::Target &target) {
-  CHECK(target.arch == Target::Arch::X86) << "Conv2d_NCHWc_1X1_Schedule_CPU_Nofuse schedule only used in x86";
+  CHECK(target.is_cpu()) << "Conv2d_NCHWc_1X1_Schedule_CPU_Nofuse schedule only used on the CPUs";
   CHECK(packed_out.defined());
   CHECK(input_pad.defined());
   auto type = packed_out->type();
@@ -935,7 +1380,7 @@ void Conv2d_NCHWc_Schedule_CPU_Nofuse(poly::StageMap stages,
                                       const ir::Tensor &weights_dilation,
                                       const ir::Tensor &data,
                                       const common::Target &target) {
-  CHECK(target.arch == Target::Arch::X86) << "Conv2d_NCHWc_Schedule_CPU_Nofuse schedule only used in x86";
+  CHECK(target.is_cpu()) << "Conv2d_NCHWc_Schedule_CPU_Nofuse schedule only used on the CPUs";
   CHECK(packed_out.defined());
   CHECK(input_pad.defined());
   auto type = packed_out->type();
@@ -1029,7 +1474,7 @@ void Conv2d_NCHWc_Schedule_CPU(poly::StageMap stages,
                                const common::Target &target,
                                const std::string &key,
                                bool do_padding) {
-  CHECK(target.arch == Target::Arch::X86) << "Conv2d_NCHWc_Schedule_CPU schedule only used in x86";
+  CHECK(target.is_cpu()) << "Conv2d_NCHWc_Schedule_CPU schedule only used on the CPUs";
   CHECK(packed_out.defined());
   CHECK(input_pad.defined());
   auto type = packed_out->type();
@@ -1143,7 +1588,7 @@ void Depthwise_Conv2d_NCHWc_Schedule_CPU_Nofuse(poly::StageMap stages,
                                                 const ir::Tensor &data,
                                                 const common::Target &target,
                                                 bool do_padding) {
-  CHECK(target.arch == Target::Arch::X86) << "Depthwise_Conv2d_NCHWc_Schedule_CPU_Nofuse schedule only used in x86";
+  CHECK(target.is_cpu()) << "Depthwise_Conv2d_NCHWc_Schedule_CPU_Nofuse schedule only used on the CPUs";
   CHECK(packed_out.defined());
   CHECK(input_pad.defined());
   auto type = packed_out->type();
@@ -1227,15 +1672,164 @@ void Depthwise_Conv2d_NCHWc_Schedule_CPU_Nofuse(poly::StageMap stages,
   }
 }
 
+void Depthwise_Conv2d_NCHWc_Row_Schedule_CPU(poly::StageMap stages,
+                                             const ir::Tensor &res,
+                                             ir::Tensor &packed_out,
+                                             const ir::Tensor &weight_packed,
+                                             const ir::Tensor &input_pad,
+                                             const common::Target &target) {
+  CHECK(target.is_cpu()) << "Depthwise_Conv2d_NCHWc_Row_Schedule_CPU schedule only used on the CPUs";
+  CHECK_EQ(packed_out->shape.size(), 5U) << "packed_out's shape size should be 5";
+  auto to_int_shape = [](const ir::Tensor &tensor) {
+    std::vector<int> shape;
+    for (auto &dim : tensor->shape) shape.push_back(dim.as_int32());
+    return shape;
+  };
+  int out_w = packed_out->shape[3].as_int32();
+  int c_bn  = packed_out->shape[4].as_int32();
+  // each pixel of the row keeps a vector accumulator, AVX-512 has 32 vector registers and AVX2 16
+  bool avx512 = UseX86AVX512Blocking(target);
+  int ow_bn   = GetMaxSplitter(out_w, avx512 ? 24 : 12);
+  VLOG(3) << "depthwise row kernel of " << packed_out->name << ": ow_bn " << ow_bn << ", c_bn " << c_bn;
+
+  ScheduleInjectiveCPU(stages[input_pad], to_int_shape(input_pad), target);
+  ScheduleInjectiveCPU(stages[weight_packed], to_int_shape(weight_packed), target);
+
+  // packed_out: [batch, c_outer, oh, ow, c_inner] -> [batch * c_outer * oh, ow_outer, ow_inner, c_inner]
+  auto CC = stages[packed_out]->CacheWrite("global", stages, packed_out);
+  int level = 0;
+  if (ow_bn < out_w) {
+    stages[packed_out]->Split(3, ow_bn);
+    level = 1;
+  }
+  stages[packed_out]->Fuse({0, 1, 2});
+  stages[packed_out]->Parallel(0);
+  stages[packed_out]->Vectorize(stages[packed_out]->n_out_dims() - 1, c_bn);
+
+  // CC: [..., ow_inner, c_inner, kh, kw] -> [..., kh, kw, ow_inner, c_inner]
+  stages[CC]->ComputeAt(stages[packed_out], level);
+  stages[CC]->Reorder({level + 3, level + 4, level + 1, level + 2});
+  stages[CC]->Unroll(level + 3);
+  stages[CC]->Vectorize(level + 4, c_bn);
+  auto CC_init = CC->GetInitTensor(stages, target);
+  stages[CC_init]->Vectorize(stages[CC_init]->n_out_dims() - 1, c_bn);
+
+  ScheduleInjectiveCPU(stages[res], to_int_shape(res), target);
+}
+
 void CudaScheduleMul(poly::StageMap stages,
                      ir::Tensor output,
                      const std::vector<int> &output_shape,
                      const common::Target &target) {
+  if (output->is_reduce_sum() && output->reduce_axis.size() == 1U &&
+      (output->shape.size() == 2U || output->shape.size() == 3U)) {
+    CudaScheduleMatmul(stages, output, target);
+    return;
+  }
   stages[output]->Split(1, 2);
   stages[output]->Bind(0, "blockIdx.x");
   stages[output]->Bind(1, "threadIdx.x");
 }
 
+CudaGemmTiles GetCudaGemmTiles(int M, int N, int K) {
+  CudaGemmTiles tiles;
+  tiles.tm = GetMaxSplitter(M, 4);
+  tiles.tn = GetMaxSplitter(N, 4);
+  tiles.ty = GetMaxSplitter(M / tiles.tm, 16);
+  tiles.tx = GetMaxSplitter(N / tiles.tn, 16);
+  tiles.bk = GetMaxSplitter(K, 8);
+  return tiles;
+}
+
+void CudaScheduleMatmul(poly::StageMap stages, ir::Tensor output, const common::Target &target) {
+  CHECK_EQ(output->reduce_axis.size(), 1U) << "The matmul " << output->name << " should reduce one axis";
+  // the operands are the tensors loaded by the reduce axis in the body of the output
+  auto reduce_var = output->reduce_axis[0]->name;
+  auto by_reduce  = [&](const ir::Load *load) {
+    for (auto &index : load->indices) {
+      bool found = !ir::CollectIRNodes(index, [&](const Expr *x) {
+                      return x->As<ir::_Var_>() && x->As<ir::_Var_>()->name == reduce_var;
+                    }).empty();
+      if (found) return true;
+    }
+    return false;
+  };
+  std::vector<ir::Tensor> operands;
+  ir::CollectIRNodes(output->body(), [&](const Expr *x) {
+    auto *load = x->As<ir::Load>();
+    if (load && load->tensor.as_tensor() && by_reduce(load)) {
+      auto tensor = load->tensor.as_tensor_ref();
+      if (tensor->name != output->name &&
+          std::none_of(operands.begin(), operands.end(), [&](const ir::Tensor &t) { return t->name == tensor->name; })) {
+        operands.push_back(tensor);
+      }
+    }
+    return false;
+  });
+  CHECK_EQ(operands.size(), 2U) << "The matmul " << output->name << " should load two operands";
+
+  int b = output->shape.size() - 2;
+  int M = output->shape[b].as_int32();
+  int N = output->shape[b + 1].as_int32();
+  int K = output->reduce_axis[0]->upper_bound.as_int32();
+  // Each block computes a [ty * tm, tx * tn] tile of the output, for which the [ty * tm, bk] tile of A and the
+  // [bk, tx * tn] tile of B are staged in the shared memory per bk of the reduction, and each thread accumulates its
+  // [tm, tn] tile in the registers.
+  auto tiles = GetCudaGemmTiles(M, N, K);
+  VLOG(3) << "matmul " << output->name << " tiles: tm " << tiles.tm << ", tn " << tiles.tn << ", ty " << tiles.ty
+          << ", tx " << tiles.tx << ", bk " << tiles.bk;
+
+  std::vector<ir::Tensor> readers{output};
+  auto AS = stages[operands[0]]->CacheRead("shared", readers, stages);
+  auto BS = stages[operands[1]]->CacheRead("shared", readers, stages);
+  auto CL = stages[output]->CacheWrite("local", stages, output);
+
+  // [batch, i, j] -> [batch, bi, ty, tm, bj, tx, tn]
+  stages[output]->Split(b + 1, tiles.tn);
+  stages[output]->Split(b + 1, tiles.tx);
+  stages[output]->Split(b, tiles.tm);
+  stages[output]->Split(b, tiles.ty);
+  // -> [batch, bi, bj, ty, tx, tm, tn]
+  stages[output]->Reorder({b, b + 3, b + 1, b + 4, b + 2, b + 5});
+  if (b > 0) stages[output]->Bind(0, "blockIdx.z");
+  stages[output]->Bind(b, "blockIdx.y");
+  stages[output]->Bind(b + 1, "blockIdx.x");
+  stages[output]->Bind(b + 2, "threadIdx.y");
+  stages[output]->Bind(b + 3, "threadIdx.x");
+
+  // [batch, bi, bj, ty, tx, tm, tn, k] -> [batch, bi, bj, ty, tx, ko, ki, tm, tn]
+  stages[CL]->ComputeAt(stages[output], b + 3);
+  stages[CL]->Split(b + 6, tiles.bk);
+  stages[CL]->Reorder({b + 6, b + 7, b + 4, b + 5});
+
+  auto CL_init = CL->GetInitTensor(stages, target);
+  stages[AS]->ComputeAt(stages[CL], b + 4);
+  stages[BS]->ComputeAt(stages[CL], b + 4);
+  stages[AS]->SyncThreads(b + 4, {CL_init}, stages);
+  stages[BS]->CtrlDepend(AS);
+  stages[BS]->SyncThreads(stages);
+  // load the next tiles while computing on the current ones
+  if (K / tiles.bk >= 2) stages[CL]->Pipeline(b + 4, 2);
+
+  // all the threads of the block load the tiles together
+  for (auto &cache : {AS, BS}) {
+    auto *stage = stages[cache];
+    std::vector<int> tile_levels;
+    for (int i = b + 5; i < stage->n_out_dims(); i++) tile_levels.push_back(i);
+    if (tile_levels.size() > 1U) stage->Fuse(tile_levels);
+    int extent = stage->GetDimRange(b + 5);
+    if (extent % (tiles.tx * tiles.ty) == 0) {
+      stage->Split(b + 5, tiles.tx);
+      stage->Split(b + 5, tiles.ty);
+      stage->Bind(b + 6, "threadIdx.y");
+      stage->Bind(b + 7, "threadIdx.x");
+    } else {
+      stage->Split(b + 5, GetMaxSplitter(extent, tiles.tx));
+      stage->Bind(b + 6, "threadIdx.x");
+    }
+  }
+}
+
 inline void InputCudaParam(
     absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, std::vector<int>>> &model_data,
     const std::string &key,
@@ -1362,6 +1956,159 @@ void SaveSerialData(
   output.close();
 }
 
+absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, std::vector<int>>> &GetX86ConvParams() {
+  auto &params = ScheduleParam::get_x86_instance().GetParam();
+  if (params.empty()) {
+    auto &host = common::DefaultHostTarget();
+    if (host.arch != common::Target::Arch::X86 || UseX86AVX512Blocking(host)) {
+      CreateX86SerialData();
+      LoadSerialData(&params);
+    } else {
+      CreateX86AVX2SerialData();
+      LoadSerialData(&params, "default_avx2_serial.log");
+    }
+    auto tuning_log = GetTuningLogPath(FLAGS_cinn_tuning_log);
+    if (!tuning_log.empty() && std::ifstream(tuning_log).good()) {
+      VLOG(3) << "Load the tuned conv params from " << tuning_log;
+      LoadSerialData(&params, tuning_log);
+    }
+  }
+  return params;
+}
+
+namespace {
+// The shape of a conv parsed from its key generated by GenerateX86ConvKey.
+struct X86ConvShape {
+  std::vector<int> input;
+  std::vector<int> weight;
+  std::vector<int> stride;
+  std::vector<int> padding;
+  std::vector<int> dilation;
+
+  int OutputExtent(int axis) const {
+    return (input[axis] + 2 * padding[axis - 2] - dilation[axis - 2] * (weight[axis] - 1) - 1) / stride[axis - 2] + 1;
+  }
+};
+
+bool ParseX86ConvKey(const std::string &key, X86ConvShape *shape) {
+  std::istringstream is(key);
+  std::string word;
+  if (!(is >> word) || word != "X86ScheduleConv") return false;
+  std::vector<int> *values = nullptr;
+  while (is >> word) {
+    if (word == "input") {
+      values = &shape->input;
+    } else if (word == "weight") {
+      values = &shape->weight;
+    } else if (word == "stride") {
+      values = &shape->stride;
+    } else if (word == "padding") {
+      values = &shape->padding;
+    } else if (word == "dilation") {
+      values = &shape->dilation;
+    } else if (values && std::all_of(word.begin(), word.end(), ::isdigit)) {
+      values->push_back(std::stoi(word));
+    } else {
+      return false;
+    }
+  }
+  return shape->input.size() == 4 && shape->weight.size() == 4 && shape->stride.size() == 2 &&
+         shape->padding.size() == 2 && shape->dilation.size() == 2;
+}
+
+// The largest divisor of the extent no larger than the factor, so that the split still covers the extent evenly.
+int AdjustSplitFactor(int extent, int factor) {
+  if (extent < 1) return 1;
+  for (int i = std::min(extent, std::max(factor, 1)); i > 1; i--) {
+    if (extent % i == 0) return i;
+  }
+  return 1;
+}
+}  // namespace
+
+bool GetNearestX86ConvParams(const std::string &key, absl::flat_hash_map<std::string, std::vector<int>> *param) {
+  X86ConvShape shape;
+  if (!ParseX86ConvKey(key, &shape)) return false;
+
+  // only the shapes with the same kernel, strides, paddings and dilations are similar, and the distance is the sum of
+  // the log ratios of the channels and the spatial extents
+  std::string nearest_key;
+  double min_distance = std::numeric_limits<double>::max();
+  for (auto &item : GetX86ConvParams()) {
+    X86ConvShape tuned;
+    if (!ParseX86ConvKey(item.first, &tuned)) continue;
+    if (tuned.weight[2] != shape.weight[2] || tuned.weight[3] != shape.weight[3] || tuned.stride != shape.stride ||
+        tuned.padding != shape.padding || tuned.dilation != shape.dilation) {
+      continue;
+    }
+    double distance = 0.;
+    for (int i = 0; i < 4; i++) {
+      distance += std::abs(std::log2(static_cast<double>(tuned.input[i]) / shape.input[i]));
+    }
+    distance += std::abs(std::log2(static_cast<double>(tuned.weight[0]) / shape.weight[0]));
+    if (distance < min_distance || (distance == min_distance && item.first < nearest_key)) {
+      min_distance = distance;
+      nearest_key  = item.first;
+    }
+  }
+  if (nearest_key.empty()) return false;
+  VLOG(3) << "The nearest shape of " << key << " is " << nearest_key;
+
+  // the split factors are adjusted to divide the new extents
+  auto nearest = GetX86ConvParams().at(nearest_key);
+  absl::flat_hash_map<std::string, int> extents = {{"ic_bn", shape.input[1]},
+                                                   {"oc_bn", shape.weight[0]},
+                                                   {"oh_bn", shape.OutputExtent(2)},
+                                                   {"ow_bn", shape.OutputExtent(3)}};
+  for (auto &extent : extents) {
+    auto factor = nearest.find(extent.first);
+    if (factor == nearest.end() || factor->second.empty()) continue;
+    int inner      = AdjustSplitFactor(extent.second, factor->second.back());
+    factor->second = {extent.second / inner, inner};
+  }
+  *param = std::move(nearest);
+  return true;
+}
+
+namespace {
+constexpr char kDevicePlaceholder[] = "{device}";
+
+std::string ReplaceDevicePlaceholder(const std::string &path, const std::string &device) {
+  auto pos = path.find(kDevicePlaceholder);
+  if (pos == std::string::npos) return path;
+  return path.substr(0, pos) + device + path.substr(pos + std::strlen(kDevicePlaceholder));
+}
+}  // namespace
+
+std::string GetTuningLogPath(const std::string &path) {
+  if (path.find(kDevicePlaceholder) == std::string::npos) return path;
+  // the CPU model name, e.g. "Intel(R) Xeon(R) Gold 6148 CPU @ 2.40GHz", with the characters other than the letters
+  // and the digits replaced by '_'
+  std::string device = "unknown";
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.compare(0, 10, "model name") != 0) continue;
+    auto colon = line.find(':');
+    if (colon == std::string::npos) continue;
+    device = line.substr(colon + 1);
+    device.erase(0, device.find_first_not_of(' '));
+    std::replace_if(
+        device.begin(), device.end(), [](char c) { return !std::isalnum(static_cast<unsigned char>(c)); }, '_');
+    break;
+  }
+  return ReplaceDevicePlaceholder(path, device);
+}
+
+std::string GetCudaTuningLogPath(const std::string &path) {
+  if (path.find(kDevicePlaceholder) == std::string::npos) return path;
+#ifdef CINN_WITH_CUDA
+  return ReplaceDevicePlaceholder(path, backends::GetCudaDeviceName());
+#else
+  return ReplaceDevicePlaceholder(path, "unknown");
+#endif
+}
+
 void CudaScheduleDepthwiseConv(poly::StageMap stages, ir::Tensor &output, const common::Target &target) {
   auto OL = stages[output]->CacheWrite("local", stages, output);
   stages[output]->Bind(0, "blockIdx.x");
@@ -1371,6 +2118,77 @@ void CudaScheduleDepthwiseConv(poly::StageMap stages, ir::Tensor &output, const
   stages[OL]->ComputeAt(stages[output], 3);
 }
 
+void CudaScheduleDepthwiseConv(poly::StageMap stages,
+                               ir::Tensor &input_pad,
+                               ir::Tensor &output,
+                               const common::Target &target) {
+  stages[input_pad]->ComputeInline();
+  int out_h = output->shape[2].as_int32();
+  int out_w = output->shape[3].as_int32();
+  // each thread computes py x px pixels, the block covers the whole width in tx threads and ty * py rows
+  int px = out_w % 2 == 0 && out_w > 2 ? 2 : 1;
+  int tx = out_w / px;
+  if (output->reduce_axis.size() != 2U || tx > 128) {
+    CudaScheduleDepthwiseConv(stages, output, target);
+    return;
+  }
+  int py = GetMaxSplitter(out_h, 4);
+  if (py == out_h) py = 1;
+  int ty = GetMaxSplitter(out_h / py, std::max(256 / tx, 1));
+  VLOG(3) << "depthwise conv " << output->name << " tiles: py " << py << ", px " << px << ", ty " << ty << ", tx " << tx;
+
+  std::vector<ir::Tensor> readers{output};
+  auto PR     = stages[input_pad]->CacheRead("shared", readers, stages);
+  auto OL     = stages[output]->CacheWrite("local", stages, output);
+  auto *stage = stages[output];
+
+  // [n, c, oh, ow] -> [n, c, by, ty, tx, py, px], the levels not split are left undefined
+  poly::Iterator x_outer = stage->axis(3), x_inner;
+  if (px > 1) std::tie(x_outer, x_inner) = stage->Split(3, px);
+  poly::Iterator y_outer = stage->axis(2), y_inner;
+  if (py > 1) std::tie(y_outer, y_inner) = stage->Split(2, py);
+  poly::Iterator block_y, thread_y;
+  if (ty == out_h / py) {
+    thread_y = y_outer;
+  } else if (ty == 1) {
+    block_y = y_outer;
+  } else {
+    std::tie(block_y, thread_y) = stage->Split(y_outer, ty);
+  }
+  std::vector<poly::Iterator> order{stage->axis(0), stage->axis(1)};
+  for (auto *axis : {&block_y, &thread_y, &x_outer, &y_inner, &x_inner}) {
+    if (!axis->id.empty()) order.push_back(*axis);
+  }
+  stage->Reorder(order);
+  stage->Bind(0, "blockIdx.z");
+  stage->Bind(1, "blockIdx.y");
+  int level = 2;
+  if (!block_y.id.empty()) stage->Bind(level++, "blockIdx.x");
+  int block_level = level - 1;
+  if (!thread_y.id.empty()) stage->Bind(level++, "threadIdx.y");
+  stage->Bind(level, "threadIdx.x");
+  stages[OL]->ComputeAt(stages[output], level);
+
+  // all the threads of the block load the input tile together
+  stages[PR]->ComputeAt(stages[OL], block_level);
+  stages[PR]->SyncThreads(stages);
+  auto *cache = stages[PR];
+  std::vector<int> tile_levels;
+  for (int i = block_level + 1; i < cache->n_out_dims(); i++) tile_levels.push_back(i);
+  if (tile_levels.size() > 1U) cache->Fuse(tile_levels);
+  int extent  = cache->GetDimRange(block_level + 1);
+  int threads = thread_y.id.empty() ? 1 : ty;
+  if (threads > 1 && extent % (tx * threads) == 0) {
+    cache->Split(block_level + 1, tx);
+    cache->Split(block_level + 1, threads);
+    cache->Bind(block_level + 2, "threadIdx.y");
+    cache->Bind(block_level + 3, "threadIdx.x");
+  } else {
+    cache->Split(block_level + 1, GetMaxSplitter(extent, tx));
+    cache->Bind(block_level + 2, "threadIdx.x");
+  }
+}
+
 void CudaScheduleConv(poly::StageMap stages,
                       ir::Tensor &input_pad,
                       ir::Tensor &weights,
@@ -1533,38 +2351,390 @@ void CudaScheduleConv2(poly::StageMap stages,
   }
 }
 
+namespace {
+// The rough capacity of the NVGPUs, the threads resident on all the SMs fill the device.
+constexpr int kCudaWarpSize      = 32;
+constexpr int kCudaNumSMs        = 80;
+constexpr int kCudaThreadsPerSM  = 2048;
+constexpr int kCudaDeviceThreads = kCudaNumSMs * kCudaThreadsPerSM;
+
+thread_local std::vector<std::string> *cuda_launch_keys = nullptr;
+}  // namespace
+
+std::string GenerateCudaInjectiveKey(int numel, int lanes) {
+  return "CudaScheduleInjective numel " + std::to_string(numel) + " lanes " + std::to_string(lanes);
+}
+
+bool ParseCudaInjectiveKey(const std::string &key, int *numel, int *lanes) {
+  std::istringstream is(key);
+  std::string name, numel_word, lanes_word;
+  return (is >> name >> numel_word >> *numel >> lanes_word >> *lanes) && name == "CudaScheduleInjective" &&
+         numel_word == "numel" && lanes_word == "lanes";
+}
+
+absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, std::vector<int>>> &GetCudaTunedLaunchParams() {
+  static auto *params = [] {
+    auto *res       = new absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, std::vector<int>>>;
+    auto tuning_log = GetCudaTuningLogPath(FLAGS_cinn_cuda_tuning_log);
+    if (!tuning_log.empty() && std::ifstream(tuning_log).good()) {
+      VLOG(3) << "Load the tuned CUDA launch params from " << tuning_log;
+      LoadSerialData(res, tuning_log);
+    }
+    return res;
+  }();
+  return *params;
+}
+
+absl::flat_hash_map<std::string, std::vector<int>> GetCudaLaunchParams(const std::string &key,
+                                                                       int numel,
+                                                                       const common::Target &target) {
+  auto &tuned = GetCudaTunedLaunchParams();
+  auto it     = tuned.find(key);
+  if (it != tuned.end()) {
+    auto &params = it->second;
+    if (params.count("num_thread") && params.count("num_block") && params.count("unroll") &&
+        params.at("num_thread")[0] <= target.max_num_threads()) {
+      return params;
+    }
+    LOG(WARNING) << "Ignore the invalid tuned CUDA launch params of " << key;
+  }
+  // the threads per block are cut to a smaller multiple of the warp size when the blocks are too few to occupy the SMs
+  int num_thread = target.max_num_threads();
+  while (num_thread > 4 * kCudaWarpSize && numel / num_thread < kCudaNumSMs) num_thread /= 2;
+  return {{"num_thread", {num_thread}}, {"num_block", {4 * kCudaDeviceThreads / num_thread}}, {"unroll", {0}}};
+}
+
+CudaLaunchKeyRecorder::CudaLaunchKeyRecorder() : parent_(cuda_launch_keys) { cuda_launch_keys = &keys_; }
+
+CudaLaunchKeyRecorder::~CudaLaunchKeyRecorder() { cuda_launch_keys = parent_; }
+
+namespace {
+// Bind the fused loop of numel iterations at \p level to the blocks and the threads by the launch params of \p key,
+// see GetCudaLaunchParams. The loop is split further when the grid is smaller than it, so that each thread computes
+// several iterations strided by the whole grid, which keeps the accesses coalesced. Return the number of the threads
+// of each block, or 0 if the loop is bound to the threads of one block only.
+int CudaBindFusedLoop(
+    poly::Stage *stage, int level, int numel, const common::Target &target, const std::string &key = "") {
+  auto params    = GetCudaLaunchParams(key, numel, target);
+  int num_thread = params.at("num_thread")[0];
+  int num_block  = params.at("num_block")[0];
+  if (numel <= num_thread) {
+    stage->Bind(level, "threadIdx.x");
+    return 0;
+  }
+  if (numel > num_thread * num_block) {
+    auto x_outer_inner    = stage->Split(level, num_thread * num_block);
+    auto block_x_thread_x = stage->Split(std::get<1>(x_outer_inner), num_thread);
+    stage->Reorder({std::get<0>(block_x_thread_x), std::get<1>(block_x_thread_x), std::get<0>(x_outer_inner)});
+    if (params.at("unroll")[0]) stage->Unroll(level + 2);
+  } else {
+    stage->Split(level, num_thread);
+  }
+  stage->Bind(level, "blockIdx.x");
+  stage->Bind(level + 1, "threadIdx.x");
+  return num_thread;
+}
+}  // namespace
+
+int GetCudaInjectiveLanes(const ir::_Tensor_ *tensor, const std::vector<int> &output_shape) {
+  if (!FLAGS_cinn_cuda_vectorize_injective || !tensor->is_compute_node() || tensor->is_reduce_tensor() ||
+      output_shape.empty()) {
+    return 1;
+  }
+  int lanes = tensor->type().is_float(32) ? 4 : (tensor->type().is_float(16) ? 2 : 1);
+  if (lanes == 1 || output_shape.back() % lanes != 0) return 1;
+  // the lanes are the innermost axis, which each load should take as its innermost index or not take at all
+  auto &last_axis  = tensor->axis().back();
+  auto unsupported = ir::CollectIRNodes(tensor->body(), [&](const Expr *x) {
+    if (x->As<ir::Call>() || x->As<ir::Select>() || x->As<ir::Cast>()) return true;
+    auto *load = x->As<ir::Load>();
+    if (!load || load->indices.empty()) return false;
+    auto &index = load->indices.back();
+    if (index.as_var() && index.as_var()->name == last_axis->name) return false;
+    return !ir::CollectIRNodes(index, [&](const Expr *y) {
+              return y->as_var() && y->as_var()->name == last_axis->name;
+            }).empty();
+  });
+  return unsupported.empty() ? lanes : 1;
+}
+
 void CudaScheduleInjective(poly::Stage *stage, const std::vector<int> &output_shape, const common::Target &target) {
   CHECK_EQ(stage->n_out_dims(), stage->n_in_dims()) << "The dims of op are not equal";
   int dims = stage->n_out_dims();
   for (int i = 1; i < dims; i++) {
     stage->Fuse(0, 1);
   }
-  int num_thread        = target.max_num_threads();
-  int num_block         = 256;
-  int vector_width      = 1;
-  int prod_size         = std::accumulate(output_shape.begin(), output_shape.end(), 1, std::multiplies<int>());
-  bool need_block_split = prod_size > num_thread * num_block * vector_width ? true : false;
-  if (need_block_split) {
-    auto x_outer_inner = stage->Split(0, num_thread * num_block);
-    auto &X_outer      = std::get<0>(x_outer_inner);
-    auto &X_inner      = std::get<1>(x_outer_inner);
-
-    auto Block_x_Thread_x = stage->Split(X_inner, num_thread);
-    auto &Block_x         = std::get<0>(Block_x_Thread_x);
-    auto &Thread_x        = std::get<1>(Block_x_Thread_x);
-
-    stage->Reorder({Block_x, Thread_x, X_outer});
-    stage->Bind(0, "blockIdx.x");
-    stage->Bind(1, "threadIdx.x");
-  } else {
-    if (prod_size > num_thread) {
-      stage->Split(0, num_thread);
-      stage->Bind(0, "blockIdx.x");
-      stage->Bind(1, "threadIdx.x");
-    } else {
-      stage->Bind(0, "threadIdx.x");
+  int prod_size = std::accumulate(output_shape.begin(), output_shape.end(), 1, std::multiplies<int>());
+  int lanes     = GetCudaInjectiveLanes(stage->tensor(), output_shape);
+  auto key      = GenerateCudaInjectiveKey(prod_size / lanes, lanes);
+  if (cuda_launch_keys) cuda_launch_keys->push_back(key);
+  if (lanes > 1) {
+    // each thread accesses a vector of the contiguous elements
+    stage->Split(0, lanes);
+    CudaBindFusedLoop(stage, 0, prod_size / lanes, target, key);
+    stage->Vectorize(stage->n_out_dims() - 1, lanes);
+    return;
+  }
+  CudaBindFusedLoop(stage, 0, prod_size, target, key);
+}
+
+void CudaScheduleGather(poly::Stage *stage, const std::vector<int> &output_shape, const common::Target &target) {
+  int dims  = stage->n_out_dims();
+  int lanes = GetCudaInjectiveLanes(stage->tensor(), output_shape);
+  int row   = output_shape.empty() ? 0 : output_shape.back();
+  if (dims < 2 || row < kCudaWarpSize * lanes || row / lanes > target.max_num_threads()) {
+    CudaScheduleInjective(stage, output_shape, target);
+    return;
+  }
+  for (int i = 1; i < dims - 1; i++) {
+    stage->Fuse(0, 1);
+  }
+  // a block reads each gathered row by its consecutive threads, which loads the index once and coalesces the row
+  if (lanes > 1) stage->Split(1, lanes);
+  stage->Bind(0, "blockIdx.x");
+  stage->Bind(1, "threadIdx.x");
+  if (lanes > 1) stage->Vectorize(2, lanes);
+}
+
+void CudaScheduleSmallMatmul(poly::Stage *stage, const std::vector<int> &output_shape, const common::Target &target) {
+  int dims = output_shape.size();
+  CHECK(dims == 2 || dims == 3) << "The small matmul should be 2 or 3 dims while current dim is " << dims;
+  for (int i = 1; i < dims - 1; i++) {
+    stage->Fuse(0, 1);
+  }
+  int rows = std::accumulate(output_shape.begin(), output_shape.end() - 1, 1, std::multiplies<int>());
+  CudaBindFusedLoop(stage, 0, rows, target);
+  stage->Unroll(stage->n_out_dims() - 1);
+}
+
+int GetBroadcastInvariantAxes(const ir::_Tensor_ *tensor) {
+  if (!tensor->is_compute_node() || tensor->is_reduce_tensor()) return 0;
+  auto &axis = tensor->axis();
+  int dims   = axis.size();
+  int num    = 0;
+  for (auto &x : ir::CollectIRNodes(tensor->body(), [](const Expr *x) { return x->As<ir::Load>(); })) {
+    auto &indices = x.As<ir::Load>()->indices;
+    std::set<std::string> used;
+    for (auto &index : indices) {
+      for (auto &var : ir::CollectIRNodes(index, [](const Expr *y) { return y->as_var(); })) {
+        used.insert(var.as_var()->name);
+      }
     }
+    int invariant = 0;
+    while (invariant < dims && !used.count(axis[dims - 1 - invariant]->name)) invariant++;
+    // the scalars are loaded once by each thread anyway
+    if (invariant < dims) num = std::max(num, invariant);
   }
+  return num;
+}
+
+void CudaScheduleBroadcast(poly::Stage *stage, const std::vector<int> &output_shape, const common::Target &target) {
+  CHECK_EQ(stage->n_out_dims(), stage->n_in_dims()) << "The dims of op are not equal";
+  int dims        = stage->n_out_dims();
+  int inner_axes  = GetBroadcastInvariantAxes(stage->tensor());
+  int lanes       = GetCudaInjectiveLanes(stage->tensor(), output_shape);
+  int outer_numel = std::accumulate(output_shape.begin(), output_shape.end() - inner_axes, 1, std::multiplies<int>());
+  int inner_numel = std::accumulate(output_shape.end() - inner_axes, output_shape.end(), 1, std::multiplies<int>());
+  // the threads of a block sweep a run of the inner axes, the largest one dividing it evenly
+  int num_thread = std::min(inner_numel / lanes, target.max_num_threads());
+  while (num_thread > kCudaWarpSize && (inner_numel / lanes) % num_thread != 0) num_thread--;
+  if (inner_axes == 0 || inner_axes == dims || outer_numel < kCudaNumSMs || num_thread < kCudaWarpSize ||
+      (inner_numel / lanes) % num_thread != 0) {
+    CudaScheduleInjective(stage, output_shape, target);
+    return;
+  }
+  for (int i = 1; i < dims - inner_axes; i++) {
+    stage->Fuse(0, 1);
+  }
+  for (int i = 1; i < inner_axes; i++) {
+    stage->Fuse(1, 2);
+  }
+  // each block computes the elements sharing the invariant operand elements, which are loaded out of its serial loop
+  if (lanes > 1) stage->Split(1, lanes);
+  int serial = inner_numel / lanes / num_thread;
+  if (serial > 1) stage->Split(1, num_thread);
+  stage->Bind(0, "blockIdx.x");
+  stage->Bind(serial > 1 ? 2 : 1, "threadIdx.x");
+  if (lanes > 1) stage->Vectorize(stage->n_out_dims() - 1, lanes);
+}
+
+void CudaScheduleTiledTranspose(poly::Stage *stage) {
+  int dims = stage->n_out_dims();
+  CHECK_GE(dims, 3) << "The call of the tiled transpose should be over the tiles and the threads";
+  // the batches and the tiles are fused into the blocks
+  std::vector<int> levels;
+  for (int i = 0; i + 1 < dims; i++) levels.push_back(i);
+  stage->Fuse(levels);
+  stage->Bind(0, "blockIdx.x");
+  stage->Bind(1, "threadIdx.x");
+}
+
+int GetCudaReduceParts(int output_numel, int reduce_numel, const common::Target &target) {
+  // a block reduces each output, enough outputs occupy the SMs, and the short reductions are not worth another kernel
+  if (output_numel >= kCudaNumSMs * 2 || reduce_numel < 2048) return 1;
+  int num_parts = 1;
+  while (num_parts * 2 * output_numel <= kCudaNumSMs * 4 && reduce_numel % (num_parts * 2) == 0 &&
+         reduce_numel / (num_parts * 2) >= 1024) {
+    num_parts *= 2;
+  }
+  return num_parts;
+}
+
+namespace {
+// The bytes of an input staged in the shared memory for all the threads of a block, within the 48KB of a block.
+constexpr int kMaxCudaSharedCacheBytes = 16 * 1024;
+
+// The input tensors of the reduction whose loads take none of the output axes, so that all the threads of a block read
+// the same elements, e.g. the vector of a matrix-vector product.
+std::vector<ir::Tensor> GetCudaBlockSharedInputs(const ir::Tensor &output) {
+  std::set<std::string> output_axes;
+  for (auto &axis : output->axis()) output_axes.insert(axis->name);
+  std::vector<ir::Tensor> inputs;
+  std::set<std::string> rejected;
+  ir::CollectIRNodes(output->body(), [&](const Expr *x) {
+    auto *load = x->As<ir::Load>();
+    if (!load || !load->tensor.as_tensor()) return false;
+    auto tensor = load->tensor.as_tensor_ref();
+    if (rejected.count(tensor->name)) return false;
+    bool by_output = false;
+    for (auto &index : load->indices) {
+      by_output |= !ir::CollectIRNodes(index, [&](const Expr *e) {
+                      return e->As<ir::_Var_>() && output_axes.count(e->As<ir::_Var_>()->name);
+                    }).empty();
+    }
+    int64_t bytes = tensor->type().bits() / 8;
+    for (auto &dim : tensor->shape) bytes *= dim.is_constant() ? dim.as_int32() : kMaxCudaSharedCacheBytes;
+    if (by_output || !tensor->is_placeholder_node() || bytes > kMaxCudaSharedCacheBytes) {
+      rejected.insert(tensor->name);
+      inputs.erase(std::remove_if(inputs.begin(),
+                                  inputs.end(),
+                                  [&](const ir::Tensor &t) { return t->name == tensor->name; }),
+                   inputs.end());
+    } else if (std::none_of(
+                   inputs.begin(), inputs.end(), [&](const ir::Tensor &t) { return t->name == tensor->name; })) {
+      inputs.push_back(tensor);
+    }
+    return false;
+  });
+  return inputs;
+}
+
+void CudaScheduleReduceImpl(poly::StageMap stages, ir::Tensor &output, const common::Target &target, bool cache) {
+  // the output axes come before the reduce axes
+  int num_axes = output->shape.size();
+  int numel = 1;
+  for (auto &dim : output->shape) {
+    CHECK(dim.is_constant()) << "The reduction of dynamic shape is not supported on NVGPU";
+    numel *= dim.as_int32();
+  }
+  // the long reduction of the elements loaded from a tensor, or the sum of their squares, is reduced by a block for
+  // each output
+  auto *reduce        = output->body().As<ir::Reduce>();
+  auto is_block_input = [&](const Expr &body) {
+    if (body.As<ir::Load>()) return true;
+    auto *mul = body.As<ir::Mul>();
+    return reduce->reduce_type == ir::Reduce::kSum && mul && mul->a().As<ir::Load>() &&
+           utils::GetStreamCnt(mul->a()) == utils::GetStreamCnt(mul->b());
+  };
+  bool block_reduce = reduce && is_block_input(reduce->body) && output->reduce_axis.size() == 1U &&
+                      output->type().is_float(32) &&
+                      (reduce->reduce_type == ir::Reduce::kSum || reduce->reduce_type == ir::Reduce::kMul ||
+                       reduce->reduce_type == ir::Reduce::kMax || reduce->reduce_type == ir::Reduce::kMin ||
+                       reduce->reduce_type == ir::Reduce::kLogSumExp);
+  if (block_reduce) {
+    auto &axis   = output->reduce_axis.front();
+    block_reduce = axis->lower_bound.is_constant() && axis->upper_bound.is_constant() &&
+                   axis->upper_bound.as_int32() - axis->lower_bound.as_int32() >= 8 * kCudaWarpSize;
+  }
+  auto fuse_output_axes = [&](poly::Stage *stage) {
+    for (int i = 1; i < num_axes; i++) stage->Fuse(0, 1);
+  };
+  if (block_reduce) {
+    auto *stage = stages[output];
+    fuse_output_axes(stage);
+    if (num_axes > 0) stage->Bind(0, "blockIdx.x");
+    stage->BlockReduce(num_axes > 0 ? 1 : 0);
+    return;
+  }
+  cache &= FLAGS_cinn_cuda_auto_cache && num_axes > 0;
+  if (!cache) {
+    auto *stage = stages[output];
+    fuse_output_axes(stage);
+    CudaBindFusedLoop(stage, 0, numel, target);
+    return;
+  }
+
+  // each thread accumulates its outputs in the registers and writes them once, and the inputs all the threads of a
+  // block read are loaded into the shared memory by them together
+  auto shared_inputs = GetCudaBlockSharedInputs(output);
+  std::vector<ir::Tensor> readers{output};
+  std::vector<ir::Tensor> shared_caches;
+  for (auto &input : shared_inputs) shared_caches.push_back(stages[input]->CacheRead("shared", readers, stages));
+  auto OL     = stages[output]->CacheWrite("local", stages, output);
+  auto *stage = stages[output];
+  fuse_output_axes(stage);
+  int num_thread = CudaBindFusedLoop(stage, 0, numel, target);
+  stages[OL]->ComputeAt(stages[output], stage->n_out_dims() - 1);
+  VLOG(3) << "cache " << output->name << " in the registers, " << shared_caches.size() << " inputs in shared memory";
+  for (auto &cache_tensor : shared_caches) {
+    auto *cache_stage = stages[cache_tensor];
+    if (!num_thread) {
+      // without the blocks the inputs are read from the global memory, the threads of one block share the L1 cache
+      cache_stage->ComputeInline();
+      continue;
+    }
+    cache_stage->ComputeAt(stages[OL], 0);
+    cache_stage->SyncThreads(stages);
+    std::vector<int> tile_levels;
+    for (int i = 1; i < cache_stage->n_out_dims(); i++) tile_levels.push_back(i);
+    if (tile_levels.size() > 1U) cache_stage->Fuse(tile_levels);
+    int extent = cache_stage->GetDimRange(1);
+    cache_stage->Split(1, GetMaxSplitter(extent, num_thread));
+    cache_stage->Bind(2, "threadIdx.x");
+  }
+}
+}  // namespace
+
+void CudaScheduleReduce(poly::StageMap stages, const ir::Tensor &output, const common::Target &target) {
+  ir::Tensor tensor = output;
+  CudaScheduleReduceImpl(stages, tensor, target, false);
+}
+
+ir::Tensor CudaScheduleCachedReduce(poly::StageMap stages, const ir::Tensor &output, const common::Target &target) {
+  ir::Tensor tensor = output;
+  CudaScheduleReduceImpl(stages, tensor, target, true);
+  return tensor;
+}
+
+void CudaScheduleConv2dWinograd(poly::StageMap stages,
+                                const ir::Tensor &output,
+                                const ir::Tensor &batched_matmul,
+                                const ir::Tensor &data_transform,
+                                const ir::Tensor &input_pad,
+                                const common::Target &target) {
+  stages[input_pad]->ComputeInline();
+  // the transforms and the batched matmul are the kernels one after another
+  for (auto &tensor : {data_transform, output}) {
+    std::vector<int> shape;
+    for (auto &dim : tensor->shape) shape.push_back(dim.as_int32());
+    CudaScheduleInjective(stages[tensor], shape, target);
+  }
+  CudaScheduleMatmul(stages, batched_matmul, target);
+}
+
+void CudaScheduleConv2dImplicitGemm(poly::StageMap stages,
+                                    const ir::Tensor &output,
+                                    const ir::Tensor &gemm,
+                                    const ir::Tensor &im2col,
+                                    const ir::Tensor &input_pad,
+                                    const ir::Tensor &weights_2d,
+                                    const common::Target &target) {
+  // the tiles of the operands staged in the shared memory are gathered from the input and the weights directly
+  for (auto &tensor : {input_pad, im2col, weights_2d}) stages[tensor]->ComputeInline();
+  CudaScheduleMatmul(stages, gemm, target);
+  std::vector<int> shape;
+  for (auto &dim : output->shape) shape.push_back(dim.as_int32());
+  CudaScheduleInjective(stages[output], shape, target);
 }
 
 void CudaSplitSchedule(poly::Stage *stage, const std::vector<int> &output_shape) {
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <absl/container/flat_hash_map.h>
+#include <gflags/gflags.h>
 
 #include <string>
 #include <vector>
@@ -25,6 +26,12 @@
 #include "cinn/lang/compute.h"
 #include "cinn/poly/stage.h"
 
+DECLARE_string(cinn_tuning_log);
+DECLARE_bool(cinn_cuda_vectorize_injective);
+DECLARE_string(cinn_cuda_tuning_log);
+DECLARE_string(cinn_x86_blocking_isa);
+DECLARE_bool(cinn_cuda_auto_cache);
+
 namespace cinn {
 namespace hlir {
 namespace pe {
@@ -58,23 +65,89 @@ int SplitEven(int origin);
 
 int GetBasicFactor(const Type &type, const common::Target &target);
 
+/**
+ * Whether the X86 convs and GEMMs are blocked for the 32 vector registers of 512 bits of AVX-512, true if the host CPU
+ * supports it, otherwise they are blocked for the 16 registers of 256 bits of AVX2. FLAGS_cinn_x86_blocking_isa
+ * overrides it by "avx512" or "avx2". Always false on the other CPUs.
+ */
+bool UseX86AVX512Blocking(const common::Target &target);
+
+//! The lanes of the vector registers of \p type the convs and GEMMs are blocked by, see UseX86AVX512Blocking.
+int GetX86BlockingLanes(const Type &type, const common::Target &target);
+
 int GetBetterSplitFactor(int shape, int split_factor);
 
 int GetArrayPackingFactor(int shape, const Type &type, const common::Target &target);
 
+/**
+ * The number of the innermost axes of the injective \p tensor contiguous in all the operands, at least 1. Two adjacent
+ * axes are contiguous if each load takes them as its adjacent indices over the full dim or doesn't take them at all,
+ * e.g. the H and W of the bias add with the shapes [N, C, H, W] and [C]. Fusing them keeps the indices linear, so the
+ * fused loop is as good as a long innermost axis.
+ */
+int GetContiguousInnerAxes(const ir::_Tensor_ *tensor);
+
+/**
+ * Schedule the injective \p stage on X86. The inner axes contiguous in all the operands are collapsed into a long
+ * innermost loop first, so that the small spatial shapes, e.g. 7x7, are vectorized and parallelized as well.
+ */
 void ScheduleInjectiveCPU(poly::Stage *stage,
                           const std::vector<int> &output_shape,
                           const common::Target &target,
                           bool vectorizable = true);
+/**
+ * Schedule the rows gathered by the indices, e.g. the embeddings of pe::LookupTable, on X86. The rows of the innermost
+ * axis are copied by the vectors, and the parallel tasks gather the fused leading axes in the serial loops, where
+ * optim::InsertCacheHints prefetches the rows of the indices ahead.
+ */
+void ScheduleGatherCPU(poly::Stage *stage, const std::vector<int> &output_shape, const common::Target &target);
+
+/**
+ * Schedule the output of pe::MatmulSmall on X86: the parallel tasks compute the chunks of the batch, and the columns,
+ * with the rows too if the matrix is small enough, are unrolled so that the products are kept in the registers and
+ * vectorized by LLVM.
+ */
+void ScheduleSmallMatmulCPU(poly::Stage *stage, const std::vector<int> &output_shape, const common::Target &target);
+
+/**
+ * The number of the interleaved parts to split the trailing reduced elements into on X86, see TwoStageReduce, which
+ * are the lanes of up to 4 independent vector accumulators, so that the reduction is not bound by the latency of one
+ * accumulator. 1 means the elements are too few, or not divisible into the vectors, and are reduced serially.
+ */
+int GetCpuReduceParts(int reduce_numel, const Type &type, const common::Target &target);
+
+/**
+ * Schedule the reduction keeping the innermost axis of its input on X86, e.g. the partial reduction of the interleaved
+ * parts, or the reduction of the outer axes. The innermost kept axis is split into the vector accumulators, out of
+ * which the reduced axes are reordered, so that each iteration of them adds a contiguous vector of the input.
+ */
+void ScheduleReduceCPU(poly::Stage *stage, const common::Target &target);
+
 // to deprecate
 void ScheduleInjectiveCPU1(poly::Stage *stage,
                            const std::vector<int> &output_shape,
                            const common::Target &target,
                            bool vectorizable = true);
 
+/**
+ * The blocking of the packed X86 GEMM. The mr x nr microkernel keeps its accumulators in the vector registers, the
+ * kc x nr panel of B and the mr x kc panel of A stay in L1, the mc x kc block of A in L2 and the kc x nc block of B in
+ * L3. Each factor divides its extent, and nr is also the packing factor of B.
+ */
+struct X86GemmBlocking {
+  int mr;
+  int nr;
+  int mc;
+  int nc;
+  int kc;
+};
+X86GemmBlocking GetX86GemmBlocking(int M, int N, int K, const Type &type, const common::Target &target);
+
+//! Schedule the packed GEMM of pe::MatmulPacked, the output loops are tiled by the blocking of GetX86GemmBlocking.
 void MatmulScheduleCPU(poly::StageMap stage,
                        const ir::Tensor &output,
                        const ir::Tensor &packedB,
+                       const ir::Tensor &packedA,
                        const common::Target &target);
 
 void MulScheduleCPU(poly::StageMap stage,
@@ -103,6 +176,31 @@ void GetConv2d1x1Factors(absl::flat_hash_map<std::string, int> *factors,
                          const Type &type,
                          const common::Target &target);
 
+/**
+ * Schedule the Winograd conv2d of pe::Conv2d_Winograd_NCHW, the transforms are parallel and the batched matmul is tiled
+ * by the blocking of GetX86GemmBlocking.
+ */
+void Conv2d_Winograd_Schedule_CPU(poly::StageMap stages,
+                                  const ir::Tensor &output,
+                                  const ir::Tensor &batched_matmul,
+                                  const ir::Tensor &data_transform,
+                                  const ir::Tensor &input_pad,
+                                  const common::Target &target);
+
+/**
+ * Schedule the conv2d of pe::Conv2d_Im2col_NCHW, the im2col is inlined into its packing and the GEMM is scheduled by
+ * MatmulScheduleCPU.
+ */
+void Conv2d_Im2col_Schedule_CPU(poly::StageMap stages,
+                                const ir::Tensor &output,
+                                const ir::Tensor &gemm,
+                                const ir::Tensor &packed_im2col,
+                                const ir::Tensor &packed_weights,
+                                const ir::Tensor &im2col,
+                                const ir::Tensor &input_pad,
+                                const ir::Tensor &weights_3d,
+                                const common::Target &target);
+
 void Conv2d_NCHWc_Schedule_CPU(poly::StageMap stages,
                                const ir::Tensor &res,
                                ir::Tensor &packed_out,
@@ -113,7 +211,15 @@ void Conv2d_NCHWc_Schedule_CPU(poly::StageMap stages,
                                const std::string &key,
                                bool do_padding);
 
+/**
+ * Schedule the pooling on X86, the batch and the channels are fused and parallelized. The global pooling of NHWC and
+ * the partial reductions of the global pooling are scheduled by ScheduleReduceCPU instead.
+ */
 void PoolScheduleCPU(poly::StageMap stages, const ir::Tensor &output, const common::Target &target);
+/**
+ * Schedule the pooling on NVGPU, or the intermediate tensor of the separable pooling, each thread pools one output
+ * of the fused output axes. The global pooling is scheduled by CudaScheduleReduce instead.
+ */
 void PoolScheduleGPU(poly::StageMap stages, ir::Tensor &output, const common::Target &target);
 
 void Conv2d_NCHWc_Schedule_CPU_Nofuse(poly::StageMap stages,
@@ -151,13 +257,57 @@ void Depthwise_Conv2d_NCHWc_Schedule_CPU_Nofuse(poly::StageMap stages,
                                                 const common::Target &target,
                                                 bool do_padding);
 
+/**
+ * Schedule the depthwise conv2d of pe::Depthwise_Conv2d_NCHWc_Row, the blocks of channels are vectorized and each row
+ * kernel unrolls the pixels accumulated in the vector registers.
+ */
+void Depthwise_Conv2d_NCHWc_Row_Schedule_CPU(poly::StageMap stages,
+                                             const ir::Tensor &res,
+                                             ir::Tensor &packed_out,
+                                             const ir::Tensor &weight_packed,
+                                             const ir::Tensor &input_pad,
+                                             const common::Target &target);
+
+/**
+ * Schedule the matmul on NVGPU, the reduction of the matmul is tiled by CudaScheduleMatmul and the other tensors are
+ * simply bound to the blocks and threads.
+ */
 void CudaScheduleMul(poly::StageMap stages,
                      ir::Tensor output,
                      const std::vector<int> &output_shape,
                      const common::Target &target);
 
+//! The tiles of the matmul on NVGPU, each block of tx * ty threads computes a [ty * tm, tx * tn] tile of the output.
+struct CudaGemmTiles {
+  int tm;
+  int tn;
+  int ty;
+  int tx;
+  int bk;
+};
+
+CudaGemmTiles GetCudaGemmTiles(int M, int N, int K);
+
+/**
+ * Schedule the [batch, ]M x N output reducing K on NVGPU. The tiles of both the operands are staged in the shared
+ * memory per bk of the reduction, double buffered by Stage::Pipeline, and each thread accumulates a tm x tn tile in
+ * the registers. The operands are the two tensors loaded by the reduce axis, the others loaded in the body, e.g. the
+ * scales of a dequantized weight, are read from the global memory directly.
+ */
+void CudaScheduleMatmul(poly::StageMap stages, ir::Tensor output, const common::Target &target);
+
 void CudaScheduleDepthwiseConv(poly::StageMap stages, ir::Tensor &output, const common::Target &target);
 
+/**
+ * Schedule the NCHW depthwise conv2d on NVGPU by the tiles of rows. Each block stages the input tile of its rows with
+ * the halo in the shared memory, and each thread accumulates a few rows and columns of pixels in the registers. The
+ * images too wide for a block fall back to CudaScheduleDepthwiseConv.
+ */
+void CudaScheduleDepthwiseConv(poly::StageMap stages,
+                               ir::Tensor &input_pad,
+                               ir::Tensor &output,
+                               const common::Target &target);
+
 void CudaScheduleConv(poly::StageMap stages,
                       ir::Tensor &input_pad,
                       ir::Tensor &weights,
@@ -171,10 +321,84 @@ void CudaScheduleConv2(poly::StageMap stages,
                        const common::Target &target,
                        const std::string &key);
 
+/**
+ * The lanes of the float4 or half2 vectors to access the elements of the injective \p tensor on NVGPU by, which is 1
+ * if FLAGS_cinn_cuda_vectorize_injective is off or the tensor is not the lane-wise arithmetic of the loads contiguous
+ * or invariant in its innermost axis. VectorizeLoops still keeps the loop serial unless the lowered body also is.
+ */
+int GetCudaInjectiveLanes(const ir::_Tensor_ *tensor, const std::vector<int> &output_shape);
+
+//! Bind the fused injective stage to the GPU threads, each thread computes a vector of GetCudaInjectiveLanes elements.
 void CudaScheduleInjective(poly::Stage *stage, const std::vector<int> &output_shape, const common::Target &target);
 
+/**
+ * Schedule the rows gathered by the indices on NVGPU, each block reads a row of the innermost axis by its consecutive
+ * threads. The rows shorter than a warp, or longer than the threads of a block, are scheduled by CudaScheduleInjective.
+ */
+void CudaScheduleGather(poly::Stage *stage, const std::vector<int> &output_shape, const common::Target &target);
+
+//! Schedule the output of pe::MatmulSmall on NVGPU, each thread computes a row of a matrix of the batch, unrolled so
+//! that the row of A read is kept in the registers.
+void CudaScheduleSmallMatmul(poly::Stage *stage, const std::vector<int> &output_shape, const common::Target &target);
+
+//! The number of the innermost axes of the injective \p tensor, which some operand of its body is invariant in.
+int GetBroadcastInvariantAxes(const ir::_Tensor_ *tensor);
+
+/**
+ * Schedule the injective stage reading a broadcast operand on NVGPU, each block sweeps the innermost axes the operand
+ * is invariant in, so that all its threads read the same operand element by the block index, out of their serial
+ * loops. The stages without such axes, or with the sweeps not fitting the blocks, fall back to CudaScheduleInjective.
+ */
+void CudaScheduleBroadcast(poly::Stage *stage, const std::vector<int> &output_shape, const common::Target &target);
+
+//! Bind the call stage of TiledTranspose to the GPU, each block of its threads copies a tile of a batch.
+void CudaScheduleTiledTranspose(poly::Stage *stage);
+
+//! Schedule the Winograd conv2d of pe::Conv2d_Winograd_NCHW on NVGPU, the batched matmul is tiled by CudaScheduleMatmul.
+void CudaScheduleConv2dWinograd(poly::StageMap stages,
+                                const ir::Tensor &output,
+                                const ir::Tensor &batched_matmul,
+                                const ir::Tensor &data_transform,
+                                const ir::Tensor &input_pad,
+                                const common::Target &target);
+
+/**
+ * Schedule the implicit GEMM conv2d of pe::Conv2d_ImplicitGemm_NCHW on NVGPU. The GEMM is tiled by CudaScheduleMatmul
+ * with the padded input, the im2col and the weights computed inline into its shared memory tiles, and the reshape to
+ * the output is another kernel.
+ */
+void CudaScheduleConv2dImplicitGemm(poly::StageMap stages,
+                                    const ir::Tensor &output,
+                                    const ir::Tensor &gemm,
+                                    const ir::Tensor &im2col,
+                                    const ir::Tensor &input_pad,
+                                    const ir::Tensor &weights_2d,
+                                    const common::Target &target);
+
 void CudaSplitSchedule(poly::Stage *stage, const std::vector<int> &output_shape);
 
+/**
+ * The number of parts to split the reduced elements into on NVGPU, see TwoStageReduce. 1 means the elements of each
+ * output are reduced together, which is enough when the outputs occupy the SMs. Otherwise the elements are split into
+ * the parts reduced by the blocks in parallel, each of which reduces at least 1024 elements.
+ */
+int GetCudaReduceParts(int output_numel, int reduce_numel, const common::Target &target);
+
+/**
+ * Bind the output axes of the reduction to the blocks and the threads, each thread reduces the elements of one output.
+ * The long float32 sum, prod, max or min of the elements loaded from a tensor is reduced by a block for each output
+ * instead, see Stage::BlockReduce.
+ */
+void CudaScheduleReduce(poly::StageMap stages, const ir::Tensor &output, const common::Target &target);
+
+/**
+ * CudaScheduleReduce, and if FLAGS_cinn_cuda_auto_cache, the outputs reduced by the threads are accumulated in the
+ * local memory by CacheWrite, and the small inputs every thread of a block reads, whose indices take none of the output
+ * axes, are loaded into the shared memory by CacheRead, the threads of the block loading them together before a sync.
+ * It returns the tensor writing the result back, which the caller should take as the output instead of \p output.
+ */
+ir::Tensor CudaScheduleCachedReduce(poly::StageMap stages, const ir::Tensor &output, const common::Target &target);
+
 void CreateCudaSerialData(const std::string &file_name = "default_serial.log");
 
 std::string GenerateX86ConvKey(const std::vector<Expr> &input_shape,
@@ -190,6 +414,9 @@ std::string GenerateX86ConvKey(const std::vector<int> &input_shape,
                                const std::vector<int> &dilations);
 void CreateX86SerialData(const std::string &file_name = "default_serial.log");
 
+//! Create the static table of the conv params tuned for the AVX2 CPUs, of the common ResNet and MobileNet convs.
+void CreateX86AVX2SerialData(const std::string &file_name = "default_avx2_serial.log");
+
 void LoadSerialData(absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, std::vector<int>>> *params,
                     const std::string &file_name = "default_serial.log");
 
@@ -197,6 +424,63 @@ void SaveSerialData(
     const absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, std::vector<int>>> &model_data,
     const std::string &file_name = "default_serial.log");
 
+/**
+ * Get the params of the X86 convs, keyed by GenerateX86ConvKey. The static table of the ISA of UseX86AVX512Blocking is
+ * loaded at the first call, and the tuned params in FLAGS_cinn_tuning_log, if the file exists, override it.
+ */
+absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, std::vector<int>>> &GetX86ConvParams();
+
+/**
+ * Get the params of the tuned conv nearest to the conv of \p key, with the same kernel size, strides, paddings and
+ * dilations, and adjust the split factors to divide the extents of the conv. Return false if there is no such conv.
+ */
+bool GetNearestX86ConvParams(const std::string &key, absl::flat_hash_map<std::string, std::vector<int>> *param);
+
+//! Replace the "{device}" in \p path by the CPU model name.
+std::string GetTuningLogPath(const std::string &path);
+
+//! Replace the "{device}" in \p path by the name and the compute capability of the current GPU.
+std::string GetCudaTuningLogPath(const std::string &path);
+
+//! The key of the CUDA injective kernel binding the fused loop of \p numel iterations of \p lanes elements each.
+std::string GenerateCudaInjectiveKey(int numel, int lanes);
+
+//! Parse the key generated by GenerateCudaInjectiveKey, return false if \p key is not one.
+bool ParseCudaInjectiveKey(const std::string &key, int *numel, int *lanes);
+
+/**
+ * Get the launch params of the CUDA injective kernels tuned by the AutoTuner, keyed by GenerateCudaInjectiveKey. They
+ * are loaded from FLAGS_cinn_cuda_tuning_log at the first call, if the file exists.
+ */
+absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, std::vector<int>>> &GetCudaTunedLaunchParams();
+
+/**
+ * Get the launch params of the CUDA injective kernel of \p key binding \p numel iterations: the threads per block
+ * "num_thread", the blocks "num_block", and "unroll", whether to unroll the iterations each thread computes when the
+ * grid is smaller than the loop. The tuned params are taken if any, otherwise the heuristic ones filling the device.
+ */
+absl::flat_hash_map<std::string, std::vector<int>> GetCudaLaunchParams(const std::string &key,
+                                                                       int numel,
+                                                                       const common::Target &target);
+
+/**
+ * Record the keys of the CUDA injective kernels scheduled on this thread while it lives, e.g. to find the kernels of
+ * a program to tune by lowering it.
+ */
+class CudaLaunchKeyRecorder {
+ public:
+  CudaLaunchKeyRecorder();
+  ~CudaLaunchKeyRecorder();
+  CudaLaunchKeyRecorder(const CudaLaunchKeyRecorder &) = delete;
+  CudaLaunchKeyRecorder &operator=(const CudaLaunchKeyRecorder &) = delete;
+
+  const std::vector<std::string> &keys() const { return keys_; }
+
+ private:
+  std::vector<std::string> keys_;
+  std::vector<std::string> *parent_;
+};
+
 int GetMaxSplitter(int a, int b);
 }  // namespace pe
 }  // namespace hlir
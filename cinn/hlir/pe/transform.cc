@@ -15,6 +15,8 @@
 #include "cinn/hlir/pe/transform.h"
 
 #include <algorithm>
+#include <functional>
+#include <numeric>
 #include <utility>
 
 #include "cinn/common/cas.h"
@@ -26,6 +28,11 @@
 #include "cinn/lang/builtin.h"
 #include "cinn/lang/compute.h"
 
+DEFINE_int32(cinn_small_matmul_threshold,
+             16,
+             "The largest M, N and K of the matmuls and the muls computed by the unrolled small GEMM, 0 to disable it, "
+             "see UseSmallMatmul.");
+
 namespace cinn {
 namespace hlir {
 namespace pe {
@@ -93,6 +100,72 @@ std::vector<Tensor> Matmul(
   }
 }
 
+std::vector<Tensor> MatmulSmall(
+    const Tensor& A, const Tensor& B, bool trans_a, bool trans_b, float alpha, const std::string& name) {
+  int a_dim = A->shape.size();
+  int b_dim = B->shape.size();
+  CHECK(a_dim == 3U || a_dim == 2U) << "tensor_A's dim should be 2 or 3 while current dim is " << a_dim;
+  CHECK_EQ(a_dim, b_dim) << "tensor_A's dim should be same with tensor_B";
+  Expr x_width  = trans_a ? A->shape[a_dim - 2] : A->shape.back();
+  Expr y_height = trans_b ? B->shape.back() : B->shape[b_dim - 2];
+  Expr M        = trans_a ? A->shape.back() : A->shape[a_dim - 2];
+  Expr N        = trans_b ? B->shape[b_dim - 2] : B->shape.back();
+  CHECK(x_width.is_constant()) << "The small matmul unrolls K, which should be constant";
+  CHECK(is_zero(x_width - y_height)) << "matrix multiplication requires x_width to be same with y_height";
+  int K = x_width.as_int32();
+  std::vector<Expr> output_shape;
+  if (a_dim == 3) {
+    int max_batch = std::max(A->shape[0].as_int32(), B->shape[0].as_int32());
+    output_shape  = {Expr(max_batch), M, N};
+  } else {
+    output_shape = {M, N};
+  }
+  auto res = Compute(
+      output_shape,
+      [=](const std::vector<Expr>& indice) {
+        int out_dim = indice.size();
+        Expr i      = indice[out_dim - 2];
+        Expr j      = indice[out_dim - 1];
+        Expr sum;
+        for (int k = 0; k < K; k++) {
+          std::vector<Expr> A_indice;
+          std::vector<Expr> B_indice;
+          if (out_dim == 3U) {
+            // batch
+            A_indice.push_back(indice[0]);
+            B_indice.push_back(indice[0]);
+          }
+          A_indice.insert(A_indice.end(), {trans_a ? Expr(k) : i, trans_a ? i : Expr(k)});
+          B_indice.insert(B_indice.end(), {trans_b ? j : Expr(k), trans_b ? Expr(k) : j});
+          Expr prod = A(A_indice) * B(B_indice);
+          sum       = k == 0 ? prod : sum + prod;
+        }
+        return alpha != 1 ? sum * make_const(A->type(), alpha) : sum;
+      },
+      name);
+  return {res};
+}
+
+bool UseSmallMatmul(int M, int N, int K) {
+  int threshold = FLAGS_cinn_small_matmul_threshold;
+  return threshold > 0 && M > 0 && N > 0 && K > 0 && M <= threshold && N <= threshold && K <= threshold;
+}
+
+bool UseSmallMul(const std::vector<int>& x_shape,
+                 const std::vector<int>& y_shape,
+                 int x_num_col_dims,
+                 int y_num_col_dims) {
+  if (x_num_col_dims > x_shape.size() || y_num_col_dims > y_shape.size()) return false;
+  auto prod = [](std::vector<int>::const_iterator begin, std::vector<int>::const_iterator end) {
+    return std::accumulate(begin, end, 1, std::multiplies<int>());
+  };
+  // [M, K] * [N, K]
+  int M = prod(x_shape.begin(), x_shape.begin() + x_num_col_dims);
+  int K = prod(x_shape.begin() + x_num_col_dims, x_shape.end());
+  int N = prod(y_shape.begin(), y_shape.begin() + y_num_col_dims);
+  return UseSmallMatmul(M, N, K);
+}
+
 ir::Tensor Reshape(const ir::Tensor& A,
                    const std::vector<int>& new_shape,
                    poly::StageMap stages,
@@ -286,6 +359,82 @@ std::vector<Tensor> MatmulV2(const Tensor& A,
   return {res, packedB};
 }
 
+std::vector<Tensor> MatmulPacked(const Tensor& A,
+                                 const Tensor& B,
+                                 bool trans_a,
+                                 bool trans_b,
+                                 float alpha,
+                                 const std::string& name,
+                                 const common::Target& target) {
+  std::vector<Expr> shape_A = A->shape;
+  std::vector<Expr> shape_B = B->shape;
+  int a_dim                 = shape_A.size();
+  int b_dim                 = shape_B.size();
+  CHECK(a_dim == 3U || a_dim == 2U) << "tensor_A's dim should be 2 or 3 while current dim is " << a_dim;
+  CHECK_EQ(a_dim, b_dim) << "tensor_A's dim should be same with tensor_B";
+
+  Expr x_width  = trans_a ? shape_A[a_dim - 2] : shape_A.back();
+  Expr y_height = trans_b ? shape_B.back() : shape_B[b_dim - 2];
+  Expr M        = trans_a ? shape_A.back() : shape_A[a_dim - 2];
+  Expr N        = trans_b ? shape_B[b_dim - 2] : shape_B.back();
+  CHECK(is_zero(x_width - y_height)) << "matrix multiplication requires x_width to be same with y_height";
+  auto blocking = GetX86GemmBlocking(M.as_int32(), N.as_int32(), x_width.as_int32(), A->type(), target);
+  int mr        = blocking.mr;
+  int nr        = blocking.nr;
+
+  std::vector<Expr> output_shape = {M, N};
+  if (a_dim == 3) {
+    output_shape.insert(output_shape.begin(), Expr(std::max(shape_A[0].as_int32(), shape_B[0].as_int32())));
+  }
+  // pack the panels, [batch, rows / factor, K, factor], whose factor consecutive rows or columns are read together
+  auto Pack = [&](const Tensor& tensor, Expr rows, int factor, bool k_first, const std::string& pack_name) {
+    std::vector<Expr> packed_shape = {Expr(rows.as_int32() / factor), x_width, Expr(factor)};
+    if (a_dim == 3) packed_shape.insert(packed_shape.begin(), tensor->shape[0]);
+    return Compute(
+        packed_shape,
+        [=](const std::vector<Expr>& indice) {
+          int dim = indice.size();
+          std::vector<Expr> tensor_indice;
+          if (dim == 4) tensor_indice.push_back(indice[0]);
+          Expr row = Expr(factor) * indice[dim - 3] + indice.back();
+          if (k_first) {
+            tensor_indice.push_back(indice[dim - 2]);
+            tensor_indice.push_back(row);
+          } else {
+            tensor_indice.push_back(row);
+            tensor_indice.push_back(indice[dim - 2]);
+          }
+          return tensor(tensor_indice);
+        },
+        UniqName(pack_name));
+  };
+  auto packedB = Pack(B, N, nr, !trans_b, "packedB");
+  auto packedA = Pack(A, M, mr, trans_a, "packedA");
+  packedA->WithBuffer("global", "_" + packedA->name + "_temp_buffer");
+
+  Var reduce_k(x_width, UniqName("reduce_k"));
+  auto res = Compute(
+      output_shape,
+      [=](const std::vector<Expr>& indice) {
+        int out_dim = indice.size();
+        std::vector<Expr> indice_a;
+        std::vector<Expr> indice_b;
+        if (out_dim == 3) {
+          indice_a.push_back(shape_A[0].as_int32() == 1 ? Expr(0) : indice[0]);
+          indice_b.push_back(shape_B[0].as_int32() == 1 ? Expr(0) : indice[0]);
+        }
+        Expr i = indice[out_dim - 2];
+        Expr j = indice[out_dim - 1];
+        indice_a.insert(indice_a.end(), {i / Expr(mr), reduce_k, i % Expr(mr)});
+        indice_b.insert(indice_b.end(), {j / Expr(nr), reduce_k, j % Expr(nr)});
+        Expr product = packedA(indice_a) * packedB(indice_b);
+        if (alpha != 1) product = product * make_const(A->type(), alpha);
+        return lang::ReduceSum(product, {reduce_k});
+      },
+      name);
+  return {res, packedB, packedA};
+}
+
 std::vector<Tensor> MatmulMKL(const Tensor& A,
                               const Tensor& B,
                               bool trans_a,
@@ -379,6 +528,103 @@ int GetMulFactor(int shape, const Type& type, const common::Target& target) {
   return split_factor;
 }
 
+std::vector<Tensor> QuantizedMul(const Tensor& A, const Tensor& B, float scale, const std::string& name) {
+  CHECK_EQ(A->shape.size(), 2U) << "tensor_A's shape size should be two while current shape size is "
+                                << A->shape.size();
+  CHECK_EQ(B->shape.size(), 2U) << "tensor_B's shape size should be two while current shape size is "
+                                << B->shape.size();
+  CHECK(A->type().is_int(8) && B->type().is_int(8)) << "The inputs of the quantized mul should be int8";
+  std::vector<Expr> output_shape = {A->shape[0], B->shape[0]};
+  Var reduce_k(A->shape[1], UniqName("reduce_k"));
+  auto acc = Compute(
+      output_shape,
+      [=](const std::vector<Expr>& indice) {
+        return lang::ReduceSum(ir::Cast::Make(Int(32), A({indice[0], reduce_k})) *
+                                   ir::Cast::Make(Int(32), B({indice[1], reduce_k})),
+                               {reduce_k});
+      },
+      UniqName("quantized_mul_acc"));
+  auto out = Compute(
+      output_shape,
+      [=](const std::vector<Expr>& indice) { return ir::Cast::Make(Float(32), acc(indice)) * Expr(scale); },
+      name);
+  return {out, acc};
+}
+
+std::vector<Tensor> QuantizePerChannel(const Tensor& W, int bits, bool trans, const std::string& name) {
+  CHECK_EQ(W->shape.size(), 2U) << "The weight to quantize should be 2-D while current shape size is "
+                                << W->shape.size();
+  CHECK(bits == 8 || bits == 4) << "The weight can only be quantized to 8 or 4 bits, but got " << bits;
+  Expr N      = trans ? W->shape[1] : W->shape[0];
+  Expr K      = trans ? W->shape[0] : W->shape[1];
+  auto weight = [=](Expr n, Expr k) { return trans ? W({k, n}) : W({n, k}); };
+  float qmax  = (1 << (bits - 1)) - 1;
+  Var reduce_k(K, UniqName("reduce_k"));
+  auto scales = Compute(
+      {N},
+      [=](const std::vector<Expr>& indice) {
+        return lang::ReduceMax(lang::Abs(weight(indice[0], reduce_k)) * Expr(1.f / qmax), {reduce_k}, Expr(0.f));
+      },
+      name + "_scales");
+  // the channels of all zeros have the scale 0 and are quantized to 0
+  auto quantize = [=](Expr n, Expr k) {
+    auto value = lang::Round(weight(n, k) / ir::Max::Make(scales({n}), Expr(1e-30f)));
+    return ir::Cast::Make(Int(32), ir::Max::Make(ir::Min::Make(value, Expr(qmax)), Expr(-qmax)));
+  };
+  if (bits == 8) {
+    auto out = Compute(
+        {N, K},
+        [=](const std::vector<Expr>& indice) { return ir::Cast::Make(Int(8), quantize(indice[0], indice[1])); },
+        name);
+    return {out, scales};
+  }
+  CHECK_EQ(K.as_int32() % 2, 0) << "The weight quantized to 4 bits should have an even number of inputs";
+  auto out = Compute(
+      {N, Expr(K.as_int32() / 2)},
+      [=](const std::vector<Expr>& indice) {
+        auto low  = quantize(indice[0], indice[1] * 2) & Expr(15);
+        auto high = quantize(indice[0], indice[1] * 2 + 1) << Expr(4);
+        return ir::Cast::Make(Int(8), low | high);
+      },
+      name);
+  return {out, scales};
+}
+
+Tensor WeightOnlyMul(const Tensor& A, const Tensor& Q, const Tensor& scales, int bits, const std::string& name) {
+  CHECK_EQ(A->shape.size(), 2U) << "tensor_A's shape size should be two while current shape size is "
+                                << A->shape.size();
+  CHECK_EQ(Q->shape.size(), 2U) << "The quantized weight's shape size should be two while current shape size is "
+                                << Q->shape.size();
+  CHECK(Q->type().is_int(8)) << "The quantized weight should be int8";
+  CHECK(bits == 8 || bits == 4) << "The weight can only be quantized to 8 or 4 bits, but got " << bits;
+  Type type = A->type();
+  // the scales are read once per product, the operands in the reduction are staged as the ones of a mul
+  auto dequantize = [=](Expr q, Expr n) { return ir::Cast::Make(type, q) * ir::Cast::Make(type, scales({n})); };
+  if (bits == 8) {
+    Var reduce_k(A->shape[1], UniqName("reduce_k"));
+    return Compute(
+        {A->shape[0], Q->shape[0]},
+        [=](const std::vector<Expr>& indice) {
+          return lang::ReduceSum(A({indice[0], reduce_k}) * dequantize(Q({indice[1], reduce_k}), indice[1]),
+                                 {reduce_k});
+        },
+        name);
+  }
+  // each packed int8 holds the values of k = 2 * kp and 2 * kp + 1, which are sign extended from the 4 bits
+  Var reduce_kp(Q->shape[1], UniqName("reduce_kp"));
+  return Compute(
+      {A->shape[0], Q->shape[0]},
+      [=](const std::vector<Expr>& indice) {
+        auto packed = ir::Cast::Make(Int(32), Q({indice[1], reduce_kp}));
+        auto low    = (packed << Expr(28)) >> Expr(28);
+        auto high   = packed >> Expr(4);
+        return lang::ReduceSum(A({indice[0], reduce_kp * 2}) * dequantize(low, indice[1]) +
+                                   A({indice[0], reduce_kp * 2 + 1}) * dequantize(high, indice[1]),
+                               {reduce_kp});
+      },
+      name);
+}
+
 std::vector<Tensor> MulBase(const Tensor& A, const Tensor& B, const std::string& name, const common::Target& target) {
   std::vector<Expr> output_shape;
   CHECK_EQ(A->shape.size(), 2U) << "tensor_A's shape size should be two while current shape size is "
@@ -389,7 +635,7 @@ std::vector<Tensor> MulBase(const Tensor& A, const Tensor& B, const std::string&
   output_shape.push_back(A->shape[0]);
   output_shape.push_back(B->shape[0]);
 
-  if (target.arch == Target::Arch::X86) {
+  if (target.is_cpu()) {
     int reduce_dim   = A->shape[1].as_int32();
     int split_factor = GetMulFactor(reduce_dim, A->type(), target);
     Var reduce_k_first(common::make_const(A->shape[1]->type(), reduce_dim / split_factor), UniqName("reduce_k_first"));
@@ -706,6 +952,259 @@ ir::Tensor Transpose(const ir::Tensor& input, const std::vector<int>& axis, cons
       output_name);
 }
 
+bool NormalizeTranspose(const std::vector<int>& shape,
+                        const std::vector<int>& axis,
+                        std::vector<int>* norm_shape,
+                        std::vector<int>* norm_axis) {
+  CHECK_EQ(shape.size(), axis.size()) << "input shape size and axis size is not equal!";
+  // the input axes of extent > 1, renumbered in order
+  std::vector<int> index(shape.size(), -1);
+  std::vector<int> kept_shape;
+  for (int i = 0; i < shape.size(); i++) {
+    if (shape[i] == 1) continue;
+    index[i] = kept_shape.size();
+    kept_shape.push_back(shape[i]);
+  }
+  // the runs of the consecutive input axes in the output order
+  std::vector<std::vector<int>> runs;
+  for (int i : axis) {
+    if (index[i] < 0) continue;
+    if (!runs.empty() && runs.back().back() + 1 == index[i]) {
+      runs.back().push_back(index[i]);
+    } else {
+      runs.push_back({index[i]});
+    }
+  }
+  std::vector<int> order(runs.size());
+  for (int i = 0; i < order.size(); i++) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](int a, int b) { return runs[a].front() < runs[b].front(); });
+  norm_shape->clear();
+  norm_axis->assign(runs.size(), 0);
+  for (int i = 0; i < order.size(); i++) {
+    int extent = 1;
+    for (int j : runs[order[i]]) extent *= kept_shape[j];
+    norm_shape->push_back(extent);
+    (*norm_axis)[order[i]] = i;
+  }
+  return !norm_axis->empty() && norm_axis->back() != norm_axis->size() - 1;
+}
+
+bool GetLayoutTransformAxis(const std::vector<int>& input_shape,
+                            const std::string& src_layout,
+                            const std::string& dst_layout,
+                            std::vector<int>* shape,
+                            std::vector<int>* axis) {
+  ir::Layout old_layout(src_layout);
+  ir::Layout new_layout(dst_layout);
+  int src_dim = old_layout.ndims();
+  int dst_dim = new_layout.ndims();
+  CHECK_EQ(input_shape.size(), src_dim);
+  absl::flat_hash_map<int, std::vector<int>> split_index_map;
+  shape->clear();
+  axis->clear();
+  if (src_dim < dst_dim) {
+    // the output axes read the chunks and the blocks of the input axes split
+    GetLayoutTransformInfo(old_layout, new_layout, &split_index_map);
+    axis->resize(dst_dim);
+    for (int i = 0; i < src_dim; i++) {
+      CHECK(split_index_map.count(i));
+      auto& split_infos = split_index_map.at(i);
+      if (split_infos.size() == 3) {
+        int factor = split_infos[2];
+        CHECK_EQ(input_shape[i] % factor, 0) << "The axis of layout_transform should be divisible by " << factor;
+        (*axis)[split_infos[0]] = shape->size();
+        shape->push_back(input_shape[i] / factor);
+        (*axis)[split_infos[1]] = shape->size();
+        shape->push_back(factor);
+      } else {
+        (*axis)[split_infos[0]] = shape->size();
+        shape->push_back(input_shape[i]);
+      }
+    }
+    return true;
+  } else if (src_dim > dst_dim) {
+    // the output axes merge the chunks and the blocks of the input in order
+    GetLayoutTransformInfo(new_layout, old_layout, &split_index_map);
+    *shape = input_shape;
+    for (int i = 0; i < dst_dim; i++) {
+      CHECK(split_index_map.count(i));
+      auto& split_infos = split_index_map.at(i);
+      axis->push_back(split_infos[0]);
+      if (split_infos.size() == 3) axis->push_back(split_infos[1]);
+    }
+    return true;
+  }
+  return false;
+}
+
+namespace {
+//! The tiles of cinn_cuda_transpose_tiled_fp32, each staged by the threads of a block in the shared memory.
+constexpr int kCudaTransposeTile    = 32;
+constexpr int kCudaTransposeThreads = 256;
+}  // namespace
+
+std::vector<ir::Tensor> TiledTranspose(const ir::Tensor& input,
+                                       const std::vector<int>& shape,
+                                       const std::vector<int>& axis,
+                                       const std::string& output_name) {
+  CHECK(input->type().is_float(32)) << "The tiled transpose only supports float32 now";
+  int ndim = shape.size();
+  CHECK_EQ(axis.size(), ndim) << "input shape size and axis size is not equal!";
+  // the output axis of the input innermost, which is tiled with the output innermost
+  int col_axis = std::find(axis.begin(), axis.end(), ndim - 1) - axis.begin();
+  CHECK_LT(col_axis, ndim - 1) << "The tiled transpose should move the innermost axis";
+  int row_axis = axis.back();
+  std::vector<int> in_strides(ndim, 1);
+  std::vector<int> out_strides(ndim, 1);
+  for (int i = ndim - 2; i >= 0; i--) {
+    in_strides[i]  = in_strides[i + 1] * shape[i + 1];
+    out_strides[i] = out_strides[i + 1] * shape[axis[i + 1]];
+  }
+  int rows = shape[row_axis];
+  int cols = shape[ndim - 1];
+  // the other output axes batched over the blocks, then the tiles and the threads of a block
+  std::vector<int> batch_axes;
+  std::vector<Expr> domain;
+  for (int i = 0; i + 1 < ndim; i++) {
+    if (i == col_axis) continue;
+    batch_axes.push_back(i);
+    domain.push_back(Expr(shape[axis[i]]));
+  }
+  domain.push_back(Expr((rows + kCudaTransposeTile - 1) / kCudaTransposeTile));
+  domain.push_back(Expr((cols + kCudaTransposeTile - 1) / kCudaTransposeTile));
+  domain.push_back(Expr(kCudaTransposeThreads));
+
+  auto call = Compute(
+      domain,
+      [=](const std::vector<Expr>& indice) -> Expr {
+        int num_batch = batch_axes.size();
+        Expr x_offset(0);
+        Expr out_offset(0);
+        for (int i = 0; i < num_batch; i++) {
+          x_offset   = x_offset + indice[i] * in_strides[axis[batch_axes[i]]];
+          out_offset = out_offset + indice[i] * out_strides[batch_axes[i]];
+        }
+        // every thread of the block of a tile calls the copy, which is cooperative
+        return lang::CallExtern("cinn_cuda_transpose_tiled_fp32",
+                                {
+                                    indice[num_batch],                 // tile_row
+                                    indice[num_batch + 1],             // tile_col
+                                    Expr(rows),                        // rows
+                                    Expr(cols),                        // cols
+                                    common::AutoSimplify(x_offset),    // x_offset
+                                    Expr(in_strides[row_axis]),        // x_stride
+                                    common::AutoSimplify(out_offset),  // out_offset
+                                    Expr(out_strides[col_axis]),       // out_stride
+                                    input,                             // x
+                                });
+      },
+      UniqName(output_name + "_call"));
+  auto out = call->TupleGet(0);
+  out->WithBuffer(input->type());
+  return {out, call};
+}
+
+namespace {
+//! The element of the integer \p index tensor as an int32 index.
+Expr IndexAt(const ir::Tensor& index, const std::vector<Expr>& indice) {
+  Expr value = index(indice);
+  return value.type() == Int(32) ? value : ir::Cast::Make(Int(32), value);
+}
+}  // namespace
+
+ir::Tensor Gather(const ir::Tensor& input, const ir::Tensor& index, int axis, const std::string& output_name) {
+  int rank = input->shape.size();
+  if (axis < 0) axis += rank;
+  CHECK(axis >= 0 && axis < rank) << "The axis of gather should be in [-rank, rank)";
+  CHECK(index->type().is_int()) << "The index of gather should be integers";
+  int index_rank = index->shape.size();
+  std::vector<Expr> shape(input->shape.begin(), input->shape.begin() + axis);
+  shape.insert(shape.end(), index->shape.begin(), index->shape.end());
+  shape.insert(shape.end(), input->shape.begin() + axis + 1, input->shape.end());
+  return lang::Compute(
+      shape,
+      [=](const std::vector<Expr>& indice) {
+        std::vector<Expr> index_indice(indice.begin() + axis, indice.begin() + axis + index_rank);
+        std::vector<Expr> input_indice(indice.begin(), indice.begin() + axis);
+        input_indice.push_back(IndexAt(index, index_indice));
+        input_indice.insert(input_indice.end(), indice.begin() + axis + index_rank, indice.end());
+        return input(input_indice);
+      },
+      output_name);
+}
+
+ir::Tensor GatherNd(const ir::Tensor& input, const ir::Tensor& index, const std::string& output_name) {
+  CHECK(index->type().is_int()) << "The index of gather_nd should be integers";
+  CHECK(!index->shape.empty() && index->shape.back().is_constant()) << "The last axis of the index should be constant";
+  int depth = index->shape.back().as_int32();
+  CHECK_LE(depth, input->shape.size()) << "The index of gather_nd is deeper than the input";
+  int batch_rank = index->shape.size() - 1;
+  std::vector<Expr> shape(index->shape.begin(), index->shape.end() - 1);
+  shape.insert(shape.end(), input->shape.begin() + depth, input->shape.end());
+  return lang::Compute(
+      shape,
+      [=](const std::vector<Expr>& indice) {
+        std::vector<Expr> index_indice(indice.begin(), indice.begin() + batch_rank);
+        index_indice.push_back(Expr(0));
+        std::vector<Expr> input_indice;
+        for (int i = 0; i < depth; i++) {
+          index_indice.back() = Expr(i);
+          input_indice.push_back(IndexAt(index, index_indice));
+        }
+        input_indice.insert(input_indice.end(), indice.begin() + batch_rank, indice.end());
+        return input(input_indice);
+      },
+      output_name);
+}
+
+std::vector<ir::Tensor> ScatterAdd(const ir::Tensor& input,
+                                   const ir::Tensor& index,
+                                   const ir::Tensor& updates,
+                                   int axis,
+                                   const std::string& output_name) {
+  int rank = input->shape.size();
+  if (axis < 0) axis += rank;
+  CHECK(axis >= 0 && axis < rank) << "The axis of scatter_add should be in [-rank, rank)";
+  CHECK_EQ(index->shape.size(), 1U) << "The index of scatter_add should be 1-D";
+  CHECK(index->type().is_int()) << "The index of scatter_add should be integers";
+  CHECK_EQ(updates->shape.size(), input->shape.size()) << "The updates of scatter_add should be as ranked as the input";
+  Var k(index->shape[0], UniqName("reduce_axis"));
+  auto updated = lang::Compute(
+      input->shape,
+      [=](const std::vector<Expr>& indice) {
+        std::vector<Expr> updates_indice(indice);
+        updates_indice[axis] = k;
+        Expr hit             = ir::EQ::Make(IndexAt(index, {k}), indice[axis]);
+        return lang::ReduceSum(ir::Select::Make(hit, updates(updates_indice), common::make_const(updates->type(), 0)),
+                               {k});
+      },
+      UniqName("scatter_add_updates"));
+  auto out = lang::Compute(
+      input->shape, [=](const std::vector<Expr>& indice) { return input(indice) + updated(indice); }, output_name);
+  return {out, updated};
+}
+
+ir::Tensor LookupTable(const ir::Tensor& table,
+                       const ir::Tensor& ids,
+                       int64_t padding_idx,
+                       const std::string& output_name) {
+  CHECK_EQ(table->shape.size(), 2U) << "The table of lookup_table should be in [vocab, dim]";
+  CHECK(ids->type().is_int()) << "The ids of lookup_table should be integers";
+  std::vector<Expr> shape(ids->shape);
+  shape.push_back(table->shape[1]);
+  return lang::Compute(
+      shape,
+      [=](const std::vector<Expr>& indice) {
+        std::vector<Expr> ids_indice(indice.begin(), indice.end() - 1);
+        Expr id  = IndexAt(ids, ids_indice);
+        Expr row = table(id, indice.back());
+        if (padding_idx == -1) return row;
+        Expr padding = ir::EQ::Make(id, Expr(static_cast<int32_t>(padding_idx)));
+        return ir::Select::Make(padding, common::make_const(table->type(), 0), row);
+      },
+      output_name);
+}
+
 }  // namespace pe
 }  // namespace hlir
 }  // namespace cinn
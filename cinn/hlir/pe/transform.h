@@ -14,6 +14,7 @@
 
 #pragma once
 #include <absl/container/flat_hash_map.h>
+#include <gflags/gflags.h>
 
 #include <string>
 #include <vector>
@@ -22,6 +23,8 @@
 #include "cinn/ir/layout.h"
 #include "cinn/poly/stage.h"
 
+DECLARE_int32(cinn_small_matmul_threshold);
+
 namespace cinn {
 namespace hlir {
 namespace pe {
@@ -73,6 +76,29 @@ std::vector<ir::Tensor> MatmulV2(const ir::Tensor& A,
                                  const std::string& name      = UniqName("T_Transform_MatmulV2_out"),
                                  const common::Target& target = common::DefaultHostTarget());
 
+/**
+ * @brief the packed GEMM on X86, scheduled by MatmulScheduleCPU.
+ *
+ * @param A The first input tensor, [batch, M, K] or [M, K]
+ * @param B The second input tensor, [batch, K, N] or [K, N]
+ * @param trans_a whether A is transposed, default: false
+ * @param trans_b whether B is transposed, default: false
+ * @param alpha  The scale of output, default: 1.0.
+ * @param name The name of the operation
+ * @param target
+ *
+ * @return the output, B packed into the panels of [batch, N / nr, K, nr] and A packed into the panels of
+ * [batch, M / mr, K, mr], where mr and nr are the microkernel sizes of GetX86GemmBlocking. The packed A is a temporary
+ * tensor of the computation.
+ */
+std::vector<ir::Tensor> MatmulPacked(const ir::Tensor& A,
+                                     const ir::Tensor& B,
+                                     bool trans_a                 = false,
+                                     bool trans_b                 = false,
+                                     float alpha                  = 1,
+                                     const std::string& name      = UniqName("T_Transform_MatmulPacked_out"),
+                                     const common::Target& target = common::DefaultHostTarget());
+
 std::vector<ir::Tensor> MatmulMKL(const ir::Tensor& A,
                                   const ir::Tensor& B,
                                   bool trans_a                 = false,
@@ -81,6 +107,39 @@ std::vector<ir::Tensor> MatmulMKL(const ir::Tensor& A,
                                   const std::string& name      = UniqName("T_Transform_MatmulMKL_out"),
                                   const common::Target& target = common::DefaultHostTarget());
 
+/**
+ * @brief The GEMM of the tiny matrices, e.g. the batches of 3x3 or 4x4 ones, whose reduction over K is unrolled into
+ * the sum of the products, so that the loops left are all spatial and scheduled by ScheduleSmallMatmulCPU or
+ * CudaScheduleSmallMatmul, which unroll the matrix dimensions into the registers and spread the batch across the
+ * threads. K should be constant.
+ *
+ * @param A The first input tensor, [batch, M, K] or [M, K]
+ * @param B The second input tensor, [batch, K, N] or [K, N]
+ * @param trans_a whether A is transposed, default: false
+ * @param trans_b whether B is transposed, default: false
+ * @param alpha  The scale of output, default: 1.0.
+ * @param name The name of the operation
+ *
+ * @return the output tensor
+ */
+std::vector<ir::Tensor> MatmulSmall(const ir::Tensor& A,
+                                    const ir::Tensor& B,
+                                    bool trans_a            = false,
+                                    bool trans_b            = false,
+                                    float alpha             = 1,
+                                    const std::string& name = UniqName("T_Transform_MatmulSmall_out"));
+
+//! Whether the GEMM of [M, K] * [K, N] is computed by MatmulSmall instead of the library calls and the generic
+//! schedules, whose overhead of each matrix is far above its compute, i.e. M, N and K are all within
+//! FLAGS_cinn_small_matmul_threshold.
+bool UseSmallMatmul(int M, int N, int K);
+
+//! Whether the mul of \p x_shape and \p y_shape with the num_col_dims is computed by MatmulSmall, see UseSmallMatmul.
+bool UseSmallMul(const std::vector<int>& x_shape,
+                 const std::vector<int>& y_shape,
+                 int x_num_col_dims = 1,
+                 int y_num_col_dims = 1);
+
 int GetMulFactor(int shape, const Type& type, const common::Target& target);
 
 /**
@@ -111,6 +170,56 @@ std::vector<ir::Tensor> MulMKL(const ir::Tensor& A,
                                const std::string& name      = UniqName("T_Transform_MulMKL_out"),
                                const common::Target& target = common::DefaultHostTarget());
 
+/**
+ * @brief The int8 mul [M, K] * [N, K] accumulated in int32, whose result is dequantized to float32.
+ *
+ * @param A The first input tensor in int8, [M, K]
+ * @param B The second input tensor in int8, [N, K]
+ * @param scale The product of the quantization scales of A and B
+ * @param name The name of the operation
+ *
+ * @return the float32 output tensor and the int32 accumulation tensor
+ */
+std::vector<ir::Tensor> QuantizedMul(const ir::Tensor& A,
+                                     const ir::Tensor& B,
+                                     float scale,
+                                     const std::string& name = UniqName("T_Transform_QuantizedMul_out"));
+
+/**
+ * @brief Quantize the float32 weight to the symmetric int8 or int4 values by the scale of each output channel, the max
+ * absolute value of the channel divided by 127 or 7.
+ *
+ * @param W The weight in float32, [N, K], or [K, N] if trans
+ * @param bits The bits of the quantized values, 8 or 4
+ * @param trans Whether the channels are the second dim of W
+ * @param name The name of the operation
+ *
+ * @return the int8 weight [N, K], or [N, K / 2] of 4 bits with two values packed in each int8 and the even k in the low
+ * 4 bits, and the float32 scales [N]
+ */
+std::vector<ir::Tensor> QuantizePerChannel(const ir::Tensor& W,
+                                           int bits,
+                                           bool trans,
+                                           const std::string& name = UniqName("T_Transform_QuantizePerChannel_out"));
+
+/**
+ * @brief The mul [M, K] * [N, K] of the weight quantized by QuantizePerChannel, which is dequantized to the type of A
+ * in the registers as it is read, and accumulated in the type of A.
+ *
+ * @param A The first input tensor in float16 or float32, [M, K]
+ * @param Q The quantized weight in int8, [N, K], or [N, K / 2] of 4 bits
+ * @param scales The scales of the channels of the weight in float32, [N]
+ * @param bits The bits of the quantized values, 8 or 4
+ * @param name The name of the operation
+ *
+ * @return the output tensor in the type of A, [M, N]
+ */
+ir::Tensor WeightOnlyMul(const ir::Tensor& A,
+                         const ir::Tensor& Q,
+                         const ir::Tensor& scales,
+                         int bits,
+                         const std::string& name = UniqName("T_Transform_WeightOnlyMul_out"));
+
 std::vector<ir::Tensor> MulBias(const ir::Tensor& A,
                                 const ir::Tensor& B,
                                 const ir::Tensor& C,
@@ -149,6 +258,80 @@ ir::Tensor Transpose(const ir::Tensor& input,
                      const std::vector<int>& axis,
                      const std::string& output_name = UniqName("T_Transpose_out"));
 
+/**
+ * @brief Normalize the transpose of the \p shape by \p axis, with the axes of extent 1 dropped and the input axes
+ * staying adjacent and in order in the output merged into one.
+ * @return Whether the normalized transpose moves the innermost axis, so that it is run by TiledTranspose on NVGPU.
+ */
+bool NormalizeTranspose(const std::vector<int>& shape,
+                        const std::vector<int>& axis,
+                        std::vector<int>* norm_shape,
+                        std::vector<int>* norm_axis);
+
+/**
+ * @brief The transpose by \p axis of the \p input viewed in \p shape, which the layout transform of \p src_layout
+ * into \p dst_layout is, with the axes split by a factor viewed as the chunks and the blocks.
+ * @return Whether the layouts are of different ranks, the others are not transformed.
+ */
+bool GetLayoutTransformAxis(const std::vector<int>& input_shape,
+                            const std::string& src_layout,
+                            const std::string& dst_layout,
+                            std::vector<int>* shape,
+                            std::vector<int>* axis);
+
+/**
+ * @brief The transpose of the float32 \p input viewed in the normalized \p shape by \p axis on NVGPU, moving the
+ * innermost axis. Each block of cinn_cuda_transpose_tiled_fp32 stages a 32x32 tile of the input innermost axis and the
+ * output innermost one in the shared memory, padded against the bank conflicts, so that both its reads and its writes
+ * are coalesced, while the other axes are batched over the blocks.
+ * @return The output written flat in the memory of the transposed shape, and the call.
+ */
+std::vector<ir::Tensor> TiledTranspose(const ir::Tensor& input,
+                                       const std::vector<int>& shape,
+                                       const std::vector<int>& axis,
+                                       const std::string& output_name = UniqName("T_Transpose_out"));
+
+/**
+ * @brief Gather the slices of \p input along \p axis by \p index, the output is in the shape of
+ * input.shape[:axis] + index.shape + input.shape[axis + 1:].
+ * @param input The input tensor
+ * @param index The integer indices into the axis
+ * @param axis The axis to gather
+ * @param output_name the name of the output tensor
+ */
+ir::Tensor Gather(const ir::Tensor& input,
+                  const ir::Tensor& index,
+                  int axis,
+                  const std::string& output_name = UniqName("T_Gather_out"));
+
+/**
+ * @brief Gather the slices of \p input by the last axis of \p index, which indexes the first index.shape[-1] axes of
+ * the input, the output is in the shape of index.shape[:-1] + input.shape[index.shape[-1]:].
+ */
+ir::Tensor GatherNd(const ir::Tensor& input,
+                    const ir::Tensor& index,
+                    const std::string& output_name = UniqName("T_GatherNd_out"));
+
+/**
+ * @brief Add the slices of \p updates along \p axis to the slices of \p input indexed by the 1-D \p index, where the
+ * duplicated indices accumulate. Each output element reduces the updates of its index, so no atomics are needed.
+ * @return The output, and the reduced updates of each output element
+ */
+std::vector<ir::Tensor> ScatterAdd(const ir::Tensor& input,
+                                   const ir::Tensor& index,
+                                   const ir::Tensor& updates,
+                                   int axis,
+                                   const std::string& output_name = UniqName("T_ScatterAdd_out"));
+
+/**
+ * @brief Look up the rows of the embedding \p table in [vocab, dim] by \p ids, the output is in the shape of
+ * ids.shape + [dim], and the rows of \p padding_idx are zeros if it is not -1.
+ */
+ir::Tensor LookupTable(const ir::Tensor& table,
+                       const ir::Tensor& ids,
+                       int64_t padding_idx,
+                       const std::string& output_name = UniqName("T_LookupTable_out"));
+
 }  // namespace pe
 }  // namespace hlir
 }  // namespace cinn
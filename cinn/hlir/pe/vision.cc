@@ -14,8 +14,159 @@
 
 #include "cinn/hlir/pe/vision.h"
 
+#include "cinn/ir/ir_operators.h"
+#include "cinn/lang/compute.h"
+
 namespace cinn {
 namespace hlir {
-namespace pe {}  // namespace pe
+namespace pe {
+
+using cinn::lang::Compute;
+using ir::Tensor;
+
+namespace {
+struct ImageAxes {
+  int c;
+  int h;
+  int w;
+};
+
+ImageAxes GetImageAxes(const Tensor& input, const std::string& layout) {
+  CHECK_EQ(input->shape.size(), 4U) << "The images of " << input->name << " should be 4-D";
+  for (auto& dim : input->shape) {
+    CHECK(dim.is_constant()) << "The image ops only support the constant shapes";
+  }
+  if (layout == "NCHW") return {1, 2, 3};
+  CHECK_EQ(layout, "NHWC") << "The images should be in NCHW or NHWC";
+  return {3, 1, 2};
+}
+
+Expr ToFloat(const Expr& value) { return value.type() == Float(32) ? value : ir::Cast::Make(Float(32), value); }
+
+//! The constant of channel \p c out of \p values, a single value is of all the channels.
+Expr ChannelConstant(const std::vector<float>& values, const Expr& c) {
+  Expr res(values.back());
+  for (int i = static_cast<int>(values.size()) - 2; i >= 0; i--) {
+    res = ir::Select::Make(ir::EQ::Make(c, Expr(i)), Expr(values[i]), res);
+  }
+  return res;
+}
+}  // namespace
+
+Tensor Resize(const Tensor& input,
+              int out_h,
+              int out_w,
+              const std::string& method,
+              const std::string& layout,
+              const std::string& output_name) {
+  auto axes = GetImageAxes(input, layout);
+  CHECK(out_h > 0 && out_w > 0) << "The output size of resize should be positive";
+  int in_h                = input->shape[axes.h].as_int32();
+  int in_w                = input->shape[axes.w].as_int32();
+  std::vector<Expr> shape = input->shape;
+  shape[axes.h]           = Expr(out_h);
+  shape[axes.w]           = Expr(out_w);
+  if (method == "nearest") {
+    return Compute(
+        shape,
+        [=](const std::vector<Expr>& indice) {
+          std::vector<Expr> src = indice;
+          src[axes.h]           = ir::Min::Make(indice[axes.h] * in_h / out_h, Expr(in_h - 1));
+          src[axes.w]           = ir::Min::Make(indice[axes.w] * in_w / out_w, Expr(in_w - 1));
+          return input(src);
+        },
+        output_name);
+  }
+  CHECK_EQ(method, "bilinear") << "The resize method should be bilinear or nearest";
+  float scale_h = static_cast<float>(in_h) / out_h;
+  float scale_w = static_cast<float>(in_w) / out_w;
+  return Compute(
+      shape,
+      [=](const std::vector<Expr>& indice) {
+        // the source pixel and its top left neighbor, clamped to the border
+        auto source = [](const Expr& index, float scale, int extent, Expr* low, Expr* high) {
+          Expr pos = ir::Max::Make((ToFloat(index) + Expr(0.5f)) * Expr(scale) - Expr(0.5f), Expr(0.f));
+          *low     = ir::Min::Make(ir::Cast::Make(Int(32), pos), Expr(extent - 1));
+          *high    = ir::Min::Make(*low + 1, Expr(extent - 1));
+          return pos - ToFloat(*low);
+        };
+        Expr y0, y1, x0, x1;
+        Expr ly = source(indice[axes.h], scale_h, in_h, &y0, &y1);
+        Expr lx = source(indice[axes.w], scale_w, in_w, &x0, &x1);
+        auto at = [&](const Expr& y, const Expr& x) {
+          std::vector<Expr> src = indice;
+          src[axes.h]           = y;
+          src[axes.w]           = x;
+          return ToFloat(input(src));
+        };
+        Expr top    = at(y0, x0) + (at(y0, x1) - at(y0, x0)) * lx;
+        Expr bottom = at(y1, x0) + (at(y1, x1) - at(y1, x0)) * lx;
+        return top + (bottom - top) * ly;
+      },
+      output_name);
+}
+
+Tensor Crop(const Tensor& input,
+            int offset_h,
+            int offset_w,
+            int crop_h,
+            int crop_w,
+            const std::string& layout,
+            const std::string& output_name) {
+  auto axes = GetImageAxes(input, layout);
+  CHECK(offset_h >= 0 && offset_w >= 0 && crop_h > 0 && crop_w > 0) << "Bad crop window";
+  CHECK_LE(offset_h + crop_h, input->shape[axes.h].as_int32()) << "The crop window exceeds the height of the images";
+  CHECK_LE(offset_w + crop_w, input->shape[axes.w].as_int32()) << "The crop window exceeds the width of the images";
+  std::vector<Expr> shape = input->shape;
+  shape[axes.h]           = Expr(crop_h);
+  shape[axes.w]           = Expr(crop_w);
+  return Compute(
+      shape,
+      [=](const std::vector<Expr>& indice) {
+        std::vector<Expr> src = indice;
+        src[axes.h]           = indice[axes.h] + offset_h;
+        src[axes.w]           = indice[axes.w] + offset_w;
+        return input(src);
+      },
+      output_name);
+}
+
+Tensor Normalize(const Tensor& input,
+                 const std::vector<float>& mean,
+                 const std::vector<float>& stddev,
+                 const std::string& layout,
+                 const std::string& output_name) {
+  auto axes    = GetImageAxes(input, layout);
+  int channels = input->shape[axes.c].as_int32();
+  CHECK(mean.size() == 1U || mean.size() == channels) << "The mean should be of each channel or a single one";
+  CHECK(stddev.size() == 1U || stddev.size() == channels) << "The stddev should be of each channel or a single one";
+  std::vector<float> inv_std;
+  for (float value : stddev) {
+    CHECK_NE(value, 0.f) << "The stddev of normalize should not be zero";
+    inv_std.push_back(1.f / value);
+  }
+  return Compute(
+      input->shape,
+      [=](const std::vector<Expr>& indice) {
+        Expr c = indice[axes.c];
+        return (ToFloat(input(indice)) - ChannelConstant(mean, c)) * ChannelConstant(inv_std, c);
+      },
+      output_name);
+}
+
+Tensor ImageToTensor(const Tensor& input, float scale, bool reverse_channels, const std::string& output_name) {
+  GetImageAxes(input, "NHWC");
+  int channels = input->shape[3].as_int32();
+  return Compute(
+      {input->shape[0], input->shape[3], input->shape[1], input->shape[2]},
+      [=](Expr n, Expr c, Expr h, Expr w) {
+        Expr src_c = reverse_channels ? Expr(channels - 1) - c : c;
+        Expr value = ToFloat(input(n, h, w, src_c));
+        return scale == 1.f ? value : value * Expr(scale);
+      },
+      output_name);
+}
+
+}  // namespace pe
 }  // namespace hlir
 }  // namespace cinn
@@ -14,8 +14,78 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
+#include "cinn/ir/ir.h"
+#include "cinn/ir/tensor.h"
+
 namespace cinn {
 namespace hlir {
-namespace pe {}  // namespace pe
+namespace pe {
+
+/**
+ * The image preprocessing PEs, which run in the compiled program on the uploaded frames instead of in OpenCV on the
+ * host. They are all injective, so a chain of them like ImageToTensor, Resize, Crop and Normalize is one kernel
+ * writing the input of the first conv.
+ */
+
+/**
+ * @brief Resize the images to \p out_h x \p out_w.
+ *
+ * The bilinear resize samples the half pixel centers like OpenCV's INTER_LINEAR, i.e. the pixel y of the output is
+ * at (y + 0.5) * in_h / out_h - 0.5 of the input, and returns float32. The nearest resize takes the pixel
+ * floor(y * in_h / out_h) like INTER_NEAREST and keeps the type of the input.
+ *
+ * @param input The 4-D images in \p layout
+ * @param method "bilinear" or "nearest"
+ * @param layout "NCHW" or "NHWC"
+ */
+ir::Tensor Resize(const ir::Tensor& input,
+                  int out_h,
+                  int out_w,
+                  const std::string& method      = "bilinear",
+                  const std::string& layout      = "NCHW",
+                  const std::string& output_name = UniqName("T_Resize_out"));
+
+/**
+ * @brief Crop the window of \p crop_h x \p crop_w from the pixel (\p offset_h, \p offset_w) of the images.
+ *
+ * @param input The 4-D images in \p layout, "NCHW" or "NHWC"
+ */
+ir::Tensor Crop(const ir::Tensor& input,
+                int offset_h,
+                int offset_w,
+                int crop_h,
+                int crop_w,
+                const std::string& layout      = "NCHW",
+                const std::string& output_name = UniqName("T_Crop_out"));
+
+/**
+ * @brief Normalize the channels of the images in float32 by (x - mean[c]) / stddev[c].
+ *
+ * @param input The 4-D images in \p layout, "NCHW" or "NHWC"
+ * @param mean The mean of each channel, or a single one of all
+ * @param stddev The standard deviation of each channel, or a single one of all
+ */
+ir::Tensor Normalize(const ir::Tensor& input,
+                     const std::vector<float>& mean,
+                     const std::vector<float>& stddev,
+                     const std::string& layout      = "NCHW",
+                     const std::string& output_name = UniqName("T_Normalize_out"));
+
+/**
+ * @brief Convert the NHWC images, e.g. the uint8 decoded frames, to the NCHW float32 tensor scaled by \p scale.
+ *
+ * @param input The 4-D images {N, H, W, C}
+ * @param scale The scale of the pixels, e.g. 1 / 255 to map the uint8 pixels to [0, 1]
+ * @param reverse_channels Whether to reverse the order of the channels, e.g. from BGR to RGB
+ */
+ir::Tensor ImageToTensor(const ir::Tensor& input,
+                         float scale                    = 1.f,
+                         bool reverse_channels          = false,
+                         const std::string& output_name = UniqName("T_ImageToTensor_out"));
+
+}  // namespace pe
 }  // namespace hlir
 }  // namespace cinn
@@ -21,6 +21,12 @@
 #include "cinn/runtime/intrinsic.h"
 #include "cinn/utils/string.h"
 
+DEFINE_int32(cinn_assume_buffer_alignment,
+             0,
+             "The alignment in bytes the X86 code assumes of the data of the argument buffers, so that the vector "
+             "accesses are aligned without peeling the loops. All the buffers of the framework are aligned to 64, "
+             "while the memory bound from outside should be aligned as well. 0 to assume nothing.");
+
 namespace cinn {
 namespace ir {
 
@@ -65,6 +71,11 @@ Buffer _Buffer_::Make(Var data,
   return Buffer(node);
 }
 
+int _Buffer_::KnownAlignment() const {
+  if (data_alignment > 0) return data_alignment;
+  return target.is_cpu() ? FLAGS_cinn_assume_buffer_alignment : 0;
+}
+
 Buffer _Buffer_::Make(const std::string &name, const std::vector<Expr> &shape) {
   auto *node  = common::make_shared<_Buffer_>();
   node->name  = name;
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <gflags/gflags.h>
+
 #include <memory>
 #include <set>
 #include <string>
@@ -22,6 +24,8 @@
 #include "cinn/common/common.h"
 #include "cinn/ir/ir.h"
 
+DECLARE_int32(cinn_assume_buffer_alignment);
+
 namespace cinn {
 namespace ir {
 
@@ -121,6 +125,13 @@ class _Buffer_ : public ExprNode<_Buffer_> {
   bool is_on_gpu() const { return memory_type == MemoryType::GPULocal || memory_type == MemoryType::GPUShared; }
   bool is_on_host() const { return !is_on_gpu(); }
 
+  /**
+   * The alignment in bytes the code generated can assume of the data pointer, data_alignment if the buffer is
+   * allocated by the code, or FLAGS_cinn_assume_buffer_alignment for the buffers of the arguments on CPU, 0 if not
+   * known.
+   */
+  int KnownAlignment() const;
+
   void BindTo(const Tensor& tensor);
   void BindTo(const _Tensor_* tensor);
   void Unbind(const _Tensor_* tensor);
@@ -124,4 +124,22 @@ Expr intrinsics::BuiltinIntrin::Make(
   return Expr(n);
 }
 
+Expr intrinsics::DotProduct4::Make(Expr acc, llvm::ArrayRef<Expr> a, llvm::ArrayRef<Expr> b) {
+  auto* n = new DotProduct4;
+  CHECK_EQ(a.size(), kLanes);
+  CHECK_EQ(b.size(), kLanes);
+  CHECK_EQ(acc.type(), Int(32)) << "The dot product should accumulate to an int32, but get " << acc.type();
+  n->AddInputType(Int(32));
+  for (int i = 0; i < 2 * kLanes; i++) n->AddInputType(Int(8));
+  n->acc = acc;
+  n->a.assign(a.begin(), a.end());
+  n->b.assign(b.begin(), b.end());
+  llvm::SmallVector<Expr, 9> inputs({acc});
+  inputs.append(a.begin(), a.end());
+  inputs.append(b.begin(), b.end());
+  n->Verify(inputs);
+  n->set_type(n->GetOutputType(0));
+  return Expr(n);
+}
+
 }  // namespace cinn::ir
@@ -37,7 +37,8 @@ namespace cinn::ir {
   macro__(BufferCreate)                                  \
   macro__(GetAddr)                                       \
   macro__(ArgsConstruct)                                 \
-  macro__(BuiltinIntrin)
+  macro__(BuiltinIntrin)                                 \
+  macro__(DotProduct4)
 // clang-format on
 
 enum class IntrinsicKind {
@@ -195,6 +196,25 @@ struct BuiltinIntrin : public IntrinsicOp {
   int64_t arg_nums;
 };
 
+/**
+ * The 4-way dot product of the int8 elements accumulated to an int32, acc + a[0] * b[0] + ... + a[3] * b[3], which is
+ * a single instruction of the VNNI of X86 and the DP4A of CUDA.
+ */
+struct DotProduct4 : public IntrinsicOp {
+  // signature: (int32, int8 x 4, int8 x 4) -> int32
+  DotProduct4() : IntrinsicOp(IntrinsicKind::kDotProduct4, {}, {Int(32)}) {}
+
+  static constexpr int kLanes = 4;
+
+  static Expr Make(Expr acc, llvm::ArrayRef<Expr> a, llvm::ArrayRef<Expr> b);
+
+  static bool classof(const IntrinsicOp* s) { return s->getKind() == IntrinsicKind::kDotProduct4; }
+
+  Expr acc;
+  llvm::SmallVector<Expr, 4> a;
+  llvm::SmallVector<Expr, 4> b;
+};
+
 }  // namespace intrinsics
 
 }  // namespace cinn::ir
@@ -228,6 +228,7 @@ Expr _Var_::Copy() const {
   n->is_reduce_axis = is_reduce_axis;
   n->lower_bound    = lower_bound;
   n->upper_bound    = upper_bound;
+  n->divisor        = divisor;
   n->set_type(type());
   return Expr(n);
 }
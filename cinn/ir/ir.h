@@ -375,6 +375,10 @@ struct _Var_ : public ExprNode<_Var_> {
   // ! Extra tag of this variable/axis.
   std::string tag;
 
+  //! The symbolic dim is known to be a multiple of it, which the polyhedral domains are constrained by, so the
+  //! schedules specialize on it, e.g. a split by a factor dividing it has no tail.
+  int divisor{1};
+
   _Var_() = default;
   _Var_(const std::string& name, Type type) : ExprNode<_Var_>(type), name(name) {}
 
@@ -424,6 +428,8 @@ struct Reduce : public ExprNode<Reduce> {
     kDiv,
     kMax,
     kMin,
+    //! log(sum(exp(x))), accumulated in a single pass without overflowing the exponents.
+    kLogSumExp,
   };
 
   //! The initial value.
@@ -597,14 +603,18 @@ struct IfThenElse : public ExprNode<IfThenElse> {
 };
 
 enum class ForType : int {
-  Serial     = 0,       //! Serial execution.
-  Parallel   = 1,       //! Parallel execution.
-  Vectorized = 1 << 1,  //! Vector SIMD loop annotation.
-  Unrolled   = 1 << 2,  //! Unroll annotation.
-  GPUThread  = 1 << 3,  //! GPU Thread.
-  GPUBlock   = 1 << 4,  //! GPU Block.
-  GPULane    = 1 << 5,  //! GPU Lane.
-  Default    = 1 << 6,
+  Serial      = 0,        //! Serial execution.
+  Parallel    = 1,        //! Parallel execution.
+  Vectorized  = 1 << 1,   //! Vector SIMD loop annotation.
+  Unrolled    = 1 << 2,   //! Unroll annotation.
+  GPUThread   = 1 << 3,   //! GPU Thread.
+  GPUBlock    = 1 << 4,   //! GPU Block.
+  GPULane     = 1 << 5,   //! GPU Lane.
+  Default     = 1 << 6,
+  TensorCore  = 1 << 7,   //! The 16x16x16 MMA tile of the tensor cores.
+  BlockReduce = 1 << 8,   //! The reduction by all the threads of a GPU block.
+  Pipelined   = 1 << 9,   //! The software pipeline over the multi-buffered shared memory tiles.
+  DotProduct  = 1 << 10,  //! The 4-way int8 dot product of the VNNI or DP4A.
 };
 
 struct VectorizeInfo {
@@ -657,11 +667,43 @@ struct ForBase {
     else
       unset_for_type_flag(ForType::Parallel);
   }
+  void set_tensor_core(bool x = true) {
+    if (x)
+      set_for_type_flag(ForType::TensorCore);
+    else
+      unset_for_type_flag(ForType::TensorCore);
+  }
+  void set_block_reduce(bool x = true) {
+    if (x)
+      set_for_type_flag(ForType::BlockReduce);
+    else
+      unset_for_type_flag(ForType::BlockReduce);
+  }
+  void set_dot_product(bool x = true) {
+    if (x)
+      set_for_type_flag(ForType::DotProduct);
+    else
+      unset_for_type_flag(ForType::DotProduct);
+  }
 
   inline bool is_serial() const { return for_type_ == ForType::Serial; }
   inline bool is_unrolled() const { return tell_for_type_flag(ForType::Unrolled); }
   inline bool is_vectorized() const { return tell_for_type_flag(ForType::Vectorized); }
   inline bool is_parallel() const { return tell_for_type_flag(ForType::Parallel); }
+  inline bool is_tensor_core() const { return tell_for_type_flag(ForType::TensorCore); }
+  inline bool is_block_reduce() const { return tell_for_type_flag(ForType::BlockReduce); }
+  inline bool is_pipelined() const { return tell_for_type_flag(ForType::Pipelined); }
+  inline bool is_dot_product() const { return tell_for_type_flag(ForType::DotProduct); }
+
+  //! Pipeline the loop over \p x buffers of the shared memory tiles, the loop is not pipelined if x < 2.
+  void set_pipeline_stages(int x) {
+    if (x > 1)
+      set_for_type_flag(ForType::Pipelined);
+    else
+      unset_for_type_flag(ForType::Pipelined);
+    pipeline_stages_ = x > 1 ? x : 0;
+  }
+  inline int pipeline_stages() const { return pipeline_stages_; }
 
  private:
   inline void set_for_type_flag(ForType type) { *reinterpret_cast<int*>(&for_type_) |= static_cast<int>(type); }
@@ -670,6 +712,7 @@ struct ForBase {
 
   ForType for_type_{ForType::Serial};
   VectorizeInfo vectorize_info_;
+  int pipeline_stages_{0};
 };
 
 /// LLVM loop unroll metadata infomation
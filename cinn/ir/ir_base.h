@@ -29,6 +29,7 @@
 namespace cinn {
 
 namespace ir {
+using common::BFloat16;
 using common::Float;
 using common::Int;
 using common::Type;
@@ -131,7 +132,7 @@ struct Expr;
 /**
  * The base of all the nodes in the IR.
  */
-class IrNode : public common::Object {
+class IrNode : public common::Object, public common::ArenaAllocatable {
  public:
   //! The operands of this operator.
   std::vector<Expr> operands;
@@ -254,7 +255,7 @@ struct FloatImm : public ExprNode<FloatImm> {
   FloatImm(Type t, float v) : ExprNode<FloatImm>(t), value(v) { Verify(); }
 
   void Verify() const override {
-    CHECK(type().is_float());
+    CHECK(type().is_floating_point());
     CHECK(type().is_scalar());
   }
 
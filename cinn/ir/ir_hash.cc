@@ -0,0 +1,344 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/ir/ir_hash.h"
+
+#include <functional>
+#include <string>
+
+#include "cinn/ir/ir_printer.h"
+#include "cinn/ir/tensor.h"
+#include "cinn/utils/string.h"
+
+namespace cinn {
+namespace ir {
+
+namespace {
+
+inline size_t HashCombine(size_t seed, size_t value) { return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2)); }
+
+inline size_t HashType(const Type& type) {
+  size_t hash = HashCombine(static_cast<size_t>(type.type()), type.bits());
+  return HashCombine(hash, type.lanes());
+}
+
+//! Whether the node is compared by its operands, the arithmetic nodes.
+bool IsOperandsNode(IrNodeTy type) {
+  switch (type) {
+#define __(op__) case IrNodeTy::op__:
+    NODETY_OP_FOR_EACH(__)
+#undef __
+    case IrNodeTy::Cast:
+    case IrNodeTy::FracOp:
+    case IrNodeTy::Power:
+    case IrNodeTy::Sum:
+    case IrNodeTy::Product:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool StructuralEqual(const std::vector<Expr>& a, const std::vector<Expr>& b, bool compare_types) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (!StructuralEqual(a[i], b[i], compare_types)) return false;
+  }
+  return true;
+}
+
+//! Make an arithmetic node the same as \p expr with the new operands.
+Expr Rebuild(const Expr& expr, const std::vector<Expr>& operands) {
+  switch (expr->node_type()) {
+#define __(op__)       \
+  case IrNodeTy::op__: \
+    return op__::Make(operands[0], operands[1]);
+    NODETY_BINARY_OP_FOR_EACH(__)
+#undef __
+#define __(op__)       \
+  case IrNodeTy::op__: \
+    return op__::Make(operands[0]);
+    NODETY_UNARY_OP_FOR_EACH(__)
+#undef __
+    case IrNodeTy::Cast:
+      return Cast::Make(expr.type(), operands[0]);
+    default:
+      LOG(FATAL) << "Not supported to rebuild the node " << expr->node_type();
+  }
+  return Expr();
+}
+
+}  // namespace
+
+bool StructuralEqual(const Expr& a, const Expr& b, bool compare_types) {
+  if (a.get() == b.get()) return true;
+  if (!a.defined() || !b.defined()) return false;
+  if (a->node_type() != b->node_type()) return false;
+  if (compare_types && a.type() != b.type()) return false;
+
+  auto type = a->node_type();
+  auto eq   = [&](const auto& x, const auto& y) { return StructuralEqual(x, y, compare_types); };
+  if (IsOperandsNode(type)) {
+    if (type == IrNodeTy::Cast && a.type() != b.type()) return false;
+    return eq(a->operands, b->operands);
+  }
+
+  switch (type) {
+    case IrNodeTy::IntImm:
+      return a.As<IntImm>()->value == b.As<IntImm>()->value;
+    case IrNodeTy::UIntImm:
+      return a.As<UIntImm>()->value == b.As<UIntImm>()->value;
+    case IrNodeTy::FloatImm:
+      return a.As<FloatImm>()->value == b.As<FloatImm>()->value;
+    case IrNodeTy::StringImm:
+      return a.As<StringImm>()->value == b.As<StringImm>()->value;
+    case IrNodeTy::_Var_:
+      return a.As<_Var_>()->name == b.As<_Var_>()->name;
+    case IrNodeTy::_Tensor_:
+      return a.As<_Tensor_>()->name == b.As<_Tensor_>()->name;
+    case IrNodeTy::_Buffer_:
+      return a.As<_Buffer_>()->name == b.As<_Buffer_>()->name;
+    case IrNodeTy::Select: {
+      auto* x = a.As<Select>();
+      auto* y = b.As<Select>();
+      return eq(x->condition, y->condition) && eq(x->true_value, y->true_value) && eq(x->false_value, y->false_value);
+    }
+    case IrNodeTy::Load: {
+      auto* x = a.As<Load>();
+      auto* y = b.As<Load>();
+      return eq(x->tensor, y->tensor) && eq(x->indices, y->indices);
+    }
+    case IrNodeTy::Store: {
+      auto* x = a.As<Store>();
+      auto* y = b.As<Store>();
+      return eq(x->tensor, y->tensor) && eq(x->value, y->value) && eq(x->indices, y->indices);
+    }
+    case IrNodeTy::Call: {
+      auto* x = a.As<Call>();
+      auto* y = b.As<Call>();
+      return x->name == y->name && x->call_type == y->call_type && eq(x->read_args, y->read_args) &&
+             eq(x->write_args, y->write_args);
+    }
+    case IrNodeTy::Ramp: {
+      auto* x = a.As<Ramp>();
+      auto* y = b.As<Ramp>();
+      return x->lanes == y->lanes && eq(x->base, y->base) && eq(x->stride, y->stride);
+    }
+    case IrNodeTy::Broadcast: {
+      auto* x = a.As<Broadcast>();
+      auto* y = b.As<Broadcast>();
+      return x->lanes == y->lanes && eq(x->value, y->value);
+    }
+    case IrNodeTy::Let: {
+      auto* x = a.As<Let>();
+      auto* y = b.As<Let>();
+      return eq(x->symbol, y->symbol) && eq(x->body, y->body);
+    }
+    case IrNodeTy::IfThenElse: {
+      auto* x = a.As<IfThenElse>();
+      auto* y = b.As<IfThenElse>();
+      return eq(x->condition, y->condition) && eq(x->true_case, y->true_case) && eq(x->false_case, y->false_case);
+    }
+    case IrNodeTy::Block:
+      return eq(a.As<Block>()->stmts, b.As<Block>()->stmts);
+    case IrNodeTy::For: {
+      auto* x = a.As<For>();
+      auto* y = b.As<For>();
+      return x->for_type() == y->for_type() && eq(x->loop_var, y->loop_var) &&
+             eq(x->min, y->min) && eq(x->extent, y->extent) && eq(x->body, y->body);
+    }
+    default:
+      return utils::GetStreamCnt(a) == utils::GetStreamCnt(b);
+  }
+}
+
+size_t StructuralHasher::operator()(const Expr& expr) {
+  if (!expr.defined()) return 0;
+  auto it = memo_.find(expr.get());
+  if (it != memo_.end()) return it->second.second;
+
+  auto type   = expr->node_type();
+  size_t hash = static_cast<size_t>(type);
+  if (compare_types_) hash = HashCombine(hash, HashType(expr.type()));
+  if (IsOperandsNode(type)) {
+    if (type == IrNodeTy::Cast && !compare_types_) hash = HashCombine(hash, HashType(expr.type()));
+    hash = HashCombine(hash, Hash(expr->operands));
+  } else {
+    switch (type) {
+      case IrNodeTy::IntImm:
+        hash = HashCombine(hash, std::hash<int64_t>()(expr.As<IntImm>()->value));
+        break;
+      case IrNodeTy::UIntImm:
+        hash = HashCombine(hash, std::hash<int64_t>()(expr.As<UIntImm>()->value));
+        break;
+      case IrNodeTy::FloatImm:
+        hash = HashCombine(hash, std::hash<double>()(expr.As<FloatImm>()->value));
+        break;
+      case IrNodeTy::StringImm:
+        hash = HashCombine(hash, std::hash<std::string>()(expr.As<StringImm>()->value));
+        break;
+      case IrNodeTy::_Var_:
+        hash = HashCombine(hash, std::hash<std::string>()(expr.As<_Var_>()->name));
+        break;
+      case IrNodeTy::_Tensor_:
+        hash = HashCombine(hash, std::hash<std::string>()(expr.As<_Tensor_>()->name));
+        break;
+      case IrNodeTy::_Buffer_:
+        hash = HashCombine(hash, std::hash<std::string>()(expr.As<_Buffer_>()->name));
+        break;
+      case IrNodeTy::Select: {
+        auto* node = expr.As<Select>();
+        hash       = HashCombine(hash, Hash({node->condition, node->true_value, node->false_value}));
+      } break;
+      case IrNodeTy::Load: {
+        auto* node = expr.As<Load>();
+        hash       = HashCombine(HashCombine(hash, (*this)(node->tensor)), Hash(node->indices));
+      } break;
+      case IrNodeTy::Store: {
+        auto* node = expr.As<Store>();
+        hash       = HashCombine(HashCombine(hash, Hash({node->tensor, node->value})), Hash(node->indices));
+      } break;
+      case IrNodeTy::Call: {
+        auto* node = expr.As<Call>();
+        hash       = HashCombine(hash, std::hash<std::string>()(node->name));
+        hash       = HashCombine(HashCombine(hash, Hash(node->read_args)), Hash(node->write_args));
+      } break;
+      case IrNodeTy::Ramp: {
+        auto* node = expr.As<Ramp>();
+        hash       = HashCombine(HashCombine(hash, node->lanes), Hash({node->base, node->stride}));
+      } break;
+      case IrNodeTy::Broadcast: {
+        auto* node = expr.As<Broadcast>();
+        hash       = HashCombine(HashCombine(hash, node->lanes), (*this)(node->value));
+      } break;
+      case IrNodeTy::Let: {
+        auto* node = expr.As<Let>();
+        hash       = HashCombine(hash, Hash({node->symbol, node->body}));
+      } break;
+      case IrNodeTy::IfThenElse: {
+        auto* node = expr.As<IfThenElse>();
+        hash       = HashCombine(hash, Hash({node->condition, node->true_case, node->false_case}));
+      } break;
+      case IrNodeTy::Block:
+        hash = HashCombine(hash, Hash(expr.As<Block>()->stmts));
+        break;
+      case IrNodeTy::For: {
+        auto* node = expr.As<For>();
+        hash       = HashCombine(hash, static_cast<size_t>(node->for_type()));
+        hash       = HashCombine(hash, Hash({node->loop_var, node->min, node->extent, node->body}));
+      } break;
+      default:
+        hash = HashCombine(hash, std::hash<std::string>()(utils::GetStreamCnt(expr)));
+    }
+  }
+
+  memo_.emplace(expr.get(), std::make_pair(expr, hash));
+  return hash;
+}
+
+size_t StructuralHasher::Hash(const std::vector<Expr>& exprs) {
+  size_t hash = exprs.size();
+  for (auto& expr : exprs) hash = HashCombine(hash, (*this)(expr));
+  return hash;
+}
+
+size_t StructuralHash(const Expr& expr, bool compare_types) { return StructuralHasher(compare_types)(expr); }
+
+Expr HashConsTable::operator()(const Expr& expr) {
+  if (!expr.defined() || hashes_.count(expr.get()) || !Consable(expr)) return expr;
+
+  Expr node = expr;
+  if (!expr->operands.empty()) {
+    std::vector<Expr> operands;
+    bool changed = false;
+    for (auto& operand : expr->operands) {
+      operands.push_back((*this)(operand));
+      changed |= operands.back().get() != operand.get();
+      // the nodes with the children out of the table are not interned
+      if (!hashes_.count(operands.back().get())) return expr;
+    }
+    if (changed) node = Rebuild(expr, operands);
+  }
+
+  size_t hash  = ShallowHash(node);
+  auto& bucket = buckets_[hash];
+  for (auto& candidate : bucket) {
+    if (ShallowEqual(candidate, node)) return candidate;
+  }
+  bucket.push_back(node);
+  hashes_[node.get()] = hash;
+  return node;
+}
+
+bool HashConsTable::Consable(const Expr& expr) const {
+  switch (expr->node_type()) {
+    case IrNodeTy::IntImm:
+    case IrNodeTy::UIntImm:
+    case IrNodeTy::FloatImm:
+    case IrNodeTy::StringImm:
+#define __(op__) case IrNodeTy::op__:
+      NODETY_OP_FOR_EACH(__)
+#undef __
+    case IrNodeTy::Cast:
+      return true;
+    case IrNodeTy::_Var_:
+      return !expr.As<_Var_>()->is_reduce_axis;
+    default:
+      return false;
+  }
+}
+
+size_t HashConsTable::ShallowHash(const Expr& expr) const {
+  size_t hash = HashCombine(static_cast<size_t>(expr->node_type()), HashType(expr.type()));
+  switch (expr->node_type()) {
+    case IrNodeTy::IntImm:
+      return HashCombine(hash, std::hash<int64_t>()(expr.As<IntImm>()->value));
+    case IrNodeTy::UIntImm:
+      return HashCombine(hash, std::hash<int64_t>()(expr.As<UIntImm>()->value));
+    case IrNodeTy::FloatImm:
+      return HashCombine(hash, std::hash<double>()(expr.As<FloatImm>()->value));
+    case IrNodeTy::StringImm:
+      return HashCombine(hash, std::hash<std::string>()(expr.As<StringImm>()->value));
+    case IrNodeTy::_Var_:
+      return HashCombine(hash, std::hash<std::string>()(expr.As<_Var_>()->name));
+    default:
+      for (auto& operand : expr->operands) hash = HashCombine(hash, hashes_.at(operand.get()));
+      return hash;
+  }
+}
+
+bool HashConsTable::ShallowEqual(const Expr& a, const Expr& b) const {
+  if (a->node_type() != b->node_type() || a.type() != b.type()) return false;
+  switch (a->node_type()) {
+    case IrNodeTy::IntImm:
+      return a.As<IntImm>()->value == b.As<IntImm>()->value;
+    case IrNodeTy::UIntImm:
+      return a.As<UIntImm>()->value == b.As<UIntImm>()->value;
+    case IrNodeTy::FloatImm:
+      return a.As<FloatImm>()->value == b.As<FloatImm>()->value;
+    case IrNodeTy::StringImm:
+      return a.As<StringImm>()->value == b.As<StringImm>()->value;
+    case IrNodeTy::_Var_:
+      return a.As<_Var_>()->name == b.As<_Var_>()->name && a.As<_Var_>()->tag == b.As<_Var_>()->tag;
+    default:
+      if (a->operands.size() != b->operands.size()) return false;
+      for (size_t i = 0; i < a->operands.size(); i++) {
+        if (a->operands[i].get() != b->operands[i].get()) return false;
+      }
+      return true;
+  }
+}
+
+}  // namespace ir
+}  // namespace cinn
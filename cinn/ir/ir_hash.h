@@ -0,0 +1,93 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * This file implements the structural hash and equality of the IR, and the hash-consing of the expressions.
+ */
+#pragma once
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cinn/ir/ir.h"
+
+namespace cinn {
+namespace ir {
+
+/**
+ * Whether two expressions are structurally equal.
+ * The vars, tensors and buffers are compared by their names, and the immediates by their values, the same as comparing
+ * their printed codes, while the nodes without structural comparison yet fall back to their printed codes. The types of
+ * all the nodes are compared too if \p compare_types is set.
+ */
+bool StructuralEqual(const Expr& a, const Expr& b, bool compare_types = false);
+
+/**
+ * Structural hash of the expressions, consistent with StructuralEqual. It memoizes the hashes of the visited nodes,
+ * so keep a hasher while hashing the overlapping expressions repeatedly, and do not mutate the IR hashed during its
+ * lifetime.
+ */
+class StructuralHasher {
+ public:
+  explicit StructuralHasher(bool compare_types = false) : compare_types_(compare_types) {}
+
+  size_t operator()(const Expr& expr);
+
+ private:
+  size_t Hash(const std::vector<Expr>& exprs);
+
+  //! The memoized nodes are held to keep their addresses unique.
+  std::unordered_map<const IrNode*, std::pair<Expr, size_t>> memo_;
+  bool compare_types_{};
+};
+
+//! Hash an expression once.
+size_t StructuralHash(const Expr& expr, bool compare_types = false);
+
+//! The functors to use the expressions as the keys of the unordered containers by their structures.
+// @{
+struct ExprStructuralHash {
+  size_t operator()(const Expr& expr) const { return StructuralHash(expr); }
+};
+struct ExprStructuralEqual {
+  bool operator()(const Expr& a, const Expr& b) const { return StructuralEqual(a, b); }
+};
+// @}
+
+/**
+ * A hash-consing table, which shares the structurally identical immediates, vars and arithmetic nodes bottom up.
+ * The types are compared too. The other nodes are kept as they are, and their children are not interned.
+ *
+ * With the children interned, the nodes are hashed and compared shallowly, by their children's addresses. The nodes
+ * returned are shared by the table, and should be copied by IRCopy or IRCopyOnWrite before the mutations in place.
+ */
+class HashConsTable {
+ public:
+  //! Get the interned expression of \p expr.
+  Expr operator()(const Expr& expr);
+
+  //! The number of the interned nodes.
+  size_t size() const { return hashes_.size(); }
+
+ private:
+  bool Consable(const Expr& expr) const;
+  size_t ShallowHash(const Expr& expr) const;
+  bool ShallowEqual(const Expr& a, const Expr& b) const;
+
+  std::unordered_map<size_t, std::vector<Expr>> buckets_;
+  std::unordered_map<const IrNode*, size_t> hashes_;
+};
+
+}  // namespace ir
+}  // namespace cinn
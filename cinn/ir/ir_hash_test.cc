@@ -0,0 +1,67 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/ir/ir_hash.h"
+
+#include <gtest/gtest.h>
+
+#include <unordered_set>
+
+#include "cinn/ir/ir_operators.h"
+
+namespace cinn {
+namespace ir {
+
+TEST(StructuralHash, basic) {
+  Var i("i");
+  Var j("j");
+  Expr a = i * 16 + j % 4;
+  Expr b = Var("i") * 16 + Var("j") % 4;
+  Expr c = i * 16 + j % 8;
+
+  EXPECT_TRUE(StructuralEqual(a, b));
+  EXPECT_FALSE(StructuralEqual(a, c));
+  EXPECT_FALSE(StructuralEqual(a, Expr()));
+  EXPECT_EQ(StructuralHash(a), StructuralHash(b));
+  EXPECT_NE(StructuralHash(a), StructuralHash(c));
+  EXPECT_TRUE(StructuralEqual(Cast::Make(Float(32), i), Cast::Make(Float(32), Var("i"))));
+  EXPECT_FALSE(StructuralEqual(Cast::Make(Float(32), i), Cast::Make(Int(64), i)));
+
+  std::unordered_set<Expr, ExprStructuralHash, ExprStructuralEqual> exprs({a, b, c});
+  EXPECT_EQ(exprs.size(), 2UL);
+
+  StructuralHasher hasher;
+  EXPECT_EQ(hasher(a), hasher(b));
+  EXPECT_EQ(hasher(a), StructuralHash(a));
+}
+
+TEST(HashConsTable, basic) {
+  HashConsTable table;
+  Expr a = table(Var("i") * 16 + Var("j"));
+  Expr b = table(Var("i") * 16 + Var("j"));
+  EXPECT_EQ(a.get(), b.get());
+  // i, 16, j, i * 16 and i * 16 + j
+  EXPECT_EQ(table.size(), 5UL);
+
+  // the types of the immediates are distinguished
+  Expr c = table(Expr(1));
+  Expr d = table(Expr(static_cast<int64_t>(1)));
+  EXPECT_NE(c.get(), d.get());
+
+  Expr e = table(Var("i") * 16 + Var("k"));
+  EXPECT_EQ(e.As<Add>()->a().get(), a.As<Add>()->a().get());
+}
+
+}  // namespace ir
+}  // namespace cinn
@@ -286,6 +286,12 @@ void IRMutator<T>::Visit(const IntrinsicOp *expr, T op) {
         Visit(&expr, &expr);
       }
     } break;
+    case ir::IntrinsicKind::kDotProduct4: {
+      auto *n = llvm::dyn_cast<intrinsics::DotProduct4>(node);
+      Visit(&n->acc, &n->acc);
+      for (auto &expr : n->a) Visit(&expr, &expr);
+      for (auto &expr : n->b) Visit(&expr, &expr);
+    } break;
   }
 }
 
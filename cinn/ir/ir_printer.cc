@@ -312,6 +312,9 @@ void IrPrinter::Visit(const Reduce *f) {
     case Reduce::ReduceType::kMin:
       os() << "Min";
       break;
+    case Reduce::ReduceType::kLogSumExp:
+      os() << "LogSumExp";
+      break;
   }
   os() << ", ";
   Print(f->body);
@@ -447,6 +450,16 @@ void IrPrinter::Visit(const intrinsics::BuiltinIntrin *x) {
   os_ << ")";
 }
 
+void IrPrinter::Visit(const intrinsics::DotProduct4 *x) {
+  os() << "dot_product4(";
+  Print(x->acc);
+  os() << ", [";
+  Print(std::vector<Expr>(x->a.begin(), x->a.end()));
+  os() << "], [";
+  Print(std::vector<Expr>(x->b.begin(), x->b.end()));
+  os() << "])";
+}
+
 std::ostream &operator<<(std::ostream &os, Expr a) {
   std::stringstream ss;
   IrPrinter printer(ss);
@@ -16,6 +16,7 @@
 
 #include <unordered_set>
 
+#include "cinn/ir/ir_hash.h"
 #include "cinn/ir/ir_printer.h"
 #include "cinn/ir/tensor.h"
 #include "cinn/utils/string.h"
@@ -23,11 +24,7 @@
 namespace cinn {
 namespace ir {
 
-bool operator==(Expr a, Expr b) {
-  if (a.get() == b.get()) return true;
-  // TODO(Superjomn) implement with a more accurate one
-  return utils::GetStreamCnt(a) == utils::GetStreamCnt(b);
-}
+bool operator==(Expr a, Expr b) { return StructuralEqual(a, b); }
 
 bool operator!=(Expr a, Expr b) { return !(a == b); }
 
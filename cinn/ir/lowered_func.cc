@@ -183,6 +183,11 @@ void _LoweredFunc_::PrepareBufferCastExprs() {
   }
 }
 
+void _LoweredFunc_::UpdateBufferCastExprs() {
+  buffer_data_cast_exprs.clear();
+  PrepareBufferCastExprs();
+}
+
 std::vector<Expr> _LoweredFunc_::CudaAliasVarExprs() const {
   std::unordered_set<std::string> args_buffer;
   for (auto arg : args) {
@@ -313,6 +318,27 @@ std::vector<Tensor> _LoweredFunc_::CollectAllTensorReference() const {
   return tensors;
 }
 
+std::vector<DimArgSource> _LoweredFunc_::GetDimArgSources() const {
+  std::vector<DimArgSource> res;
+  for (auto& arg : args) {
+    if (!arg.is_var()) continue;
+    DimArgSource source;
+    for (int i = 0; i < args.size() && source.arg < 0; i++) {
+      if (!args[i].is_buffer()) continue;
+      auto& shape = args[i].buffer_arg()->shape;
+      for (int j = 0; j < shape.size(); j++) {
+        if (shape[j].as_var() && shape[j].as_var()->name == arg.name()) {
+          source.arg = i;
+          source.dim = j;
+          break;
+        }
+      }
+    }
+    res.push_back(source);
+  }
+  return res;
+}
+
 ir::Buffer Argument::buffer_arg() const {
   CHECK(is_buffer());
   return buffer_arg_;
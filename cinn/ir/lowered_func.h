@@ -114,6 +114,12 @@ struct CudaAxisInfo {
 
 std::ostream& operator<<(std::ostream& os, const CudaAxisInfo& x);
 
+//! A scalar argument which is the dim \p dim of the buffer argument at \p arg, e.g. a symbolic batch size.
+struct DimArgSource {
+  int arg{-1};
+  int dim{-1};
+};
+
 /**
  * Definition of a lowered function. Note that, it should be functional.
  *
@@ -163,6 +169,13 @@ struct _LoweredFunc_ : ExprNode<_LoweredFunc_> {
 
   bool is_gpu_host() const { return cuda_axis_info.valid(); }
 
+  /**
+   * Find the buffer argument and the dim each scalar argument is a symbolic dim of, so the runtime fills the scalars
+   * from the shapes of the buffers passed in, and one function runs on the different shapes. A scalar not found in the
+   * shapes is left as the default DimArgSource.
+   */
+  std::vector<DimArgSource> GetDimArgSources() const;
+
   void Verify() const override {}
 
   std::vector<Expr*> expr_fields() override;
@@ -176,6 +189,8 @@ struct _LoweredFunc_ : ExprNode<_LoweredFunc_> {
   std::vector<Expr> PrepareDeallocTempBufferExprs() const;
   std::vector<Expr> CudaPrepareAllocTempBufferExprs() const;
   std::vector<Expr> CudaAliasVarExprs() const;
+  //! Rebuild `buffer_data_cast_exprs` from the tensors the body references, after the passes replacing them.
+  void UpdateBufferCastExprs();
 
  private:
   void CheckValid() const;
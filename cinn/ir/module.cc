@@ -17,6 +17,7 @@
 #include <memory>
 
 #include "cinn/optim/optimize.h"
+#include "cinn/runtime/cinn_runtime.h"
 
 namespace cinn {
 namespace ir {
@@ -29,8 +30,8 @@ void Module::Builder::AddBuffer(ir::Buffer buffer) {
         return x.as_buffer()->name == buffer->name;
       }) == std::end(module_->buffers)) {
     module_->buffers.push_back(buffer);
-    if (module_->target.arch == Target::Arch::X86) {
-      module_->buffers.back().as_buffer()->data_alignment = 32;
+    if (module_->target.is_cpu()) {
+      module_->buffers.back().as_buffer()->data_alignment = CINN_BUFFER_ALIGNMENT;
     }
   }
 }
@@ -28,6 +28,7 @@
 #include "cinn/ir/ir_visitor.h"
 #include "cinn/ir/operation.h"
 #include "cinn/lang/compute.h"
+#include "cinn/optim/ir_copy.h"
 #include "cinn/poly/isl_utils.h"
 #include "cinn/poly/stage.h"
 
@@ -339,6 +340,16 @@ Expr _Tensor_::tensor_store_expanded_body() {
       case ir::Reduce::kMin:
         final_body = Min::Make(Tensor(this)(g_axis), final_body);
         break;
+      case ir::Reduce::kLogSumExp: {
+        // log(exp(a) + exp(b)) = max(a, b) + log(1 + exp(min(a, b) - max(a, b))), whose exponent never overflows
+        // the subexpressions are copied since the mutators rewrite the nodes in place
+        auto elem  = [&] { return optim::IRCopy(final_body); };
+        Expr upper = Max::Make(Tensor(this)(g_axis), elem());
+        Expr lower = Min::Make(Tensor(this)(g_axis), elem());
+        Expr diff  = lower - Max::Make(Tensor(this)(g_axis), elem());
+        final_body = upper + lang::Log(common::make_const(type(), 1.f) + lang::Exp(diff));
+        break;
+      }
       default:
         CINN_NOT_IMPLEMENTED
     }
@@ -153,12 +153,12 @@ void fn(void* _args, int32_t num_args)
 {
   const cinn_buffer_t* _A = cinn_pod_value_to_buffer_p(&(((cinn_pod_value_t*)(_args))[0]));
   cinn_buffer_t* _tensor = cinn_pod_value_to_buffer_p(&(((cinn_pod_value_t*)(_args))[1]));
-  cinn_buffer_t* _A_copied_reshape = cinn_buffer_t::new_((cinn_device_kind_t)(0)/*target*/, cinn_float32_t(), { 10, 10, 100 }, 32/*align*/);
+  cinn_buffer_t* _A_copied_reshape = cinn_buffer_t::new_((cinn_device_kind_t)(0)/*target*/, cinn_float32_t(), { 10, 10, 100 }, 64/*align*/);
   cinn_buffer_malloc((void*)(0), _tensor);
   cinn_buffer_malloc((void*)(0), _A_copied_reshape);
   const float* A = ((const float*)(_A->memory));
-  float* A_copied = ((float*)(_A_copied_reshape->memory));
-  const float* A_copied_reshape = ((const float*)(_A_copied_reshape->memory));
+  float* A_copied = ((float*)(__builtin_assume_aligned(_A_copied_reshape->memory, 64)));
+  const float* A_copied_reshape = ((const float*)(__builtin_assume_aligned(_A_copied_reshape->memory, 64)));
   float* tensor = ((float*)(_tensor->memory));
   for (int32_t i = 0; i < 100; i += 1) {
     for (int32_t j = 0; j < 100; j += 1) {
@@ -55,7 +55,7 @@ Expr logic_or(const std::vector<Expr>& conds) {
   }
 
 EXTERN_CALL_IMP(Exp, exp);
-EXTERN_CALL_IMP_NO_VEC(Erf, erf);
+EXTERN_CALL_IMP(Erf, erf);
 EXTERN_CALL_IMP(Sqrt, sqrt);
 EXTERN_CALL_IMP(Log, log);
 EXTERN_CALL_IMP(Log2, log2);
@@ -77,6 +77,18 @@ EXTERN_CALL_IMP_NO_VEC(Asinh, asinh);
 EXTERN_CALL_IMP_NO_VEC(Atan, atan);
 EXTERN_CALL_IMP_NO_VEC(Atanh, atanh);
 
+Expr PhiloxUniform(Expr seed, Expr offset, Expr index) {
+  for (auto& e : {seed, offset, index}) CHECK_EQ(e.type(), Int(32)) << "The arguments of philox_uniform are int32";
+  return ir::Call::Make(Float(32),
+                        "philox_uniform",
+                        {seed, offset, index},
+                        {},
+                        ir::CallType::Extern,
+                        ir::FunctionRef(),
+                        0,
+                        {{"vectorizable", false}});
+}
+
 Expr min_value(const Type& type) {
   CHECK_EQ(type.lanes(), 1);
 #define FOR_CASE(type__)                                \
@@ -154,7 +166,7 @@ Expr IsNan(Expr e) {
 
 Expr Infinity(const Type& type) {
   CHECK_EQ(type.lanes(), 1U);
-  if (type.is_float()) {
+  if (type.is_floating_point()) {
     if (type.bits() == 64) {
       return make_const(type, std::numeric_limits<double>::infinity());
     } else if (type.bits() == 32 || type.bits() == 16) {
@@ -133,6 +133,20 @@ inline Expr ReduceMin(Expr e, const std::vector<Var>& reduce_axis, Expr initial
   }
   return ir::Reduce::Make(ir::Reduce::kMin, initial, e, reduce_axis);
 }
+//! The log of the sum of the exponents, the normalizer of the softmax reduced in a single pass.
+inline Expr ReduceLogSumExp(Expr e, const std::vector<Var>& reduce_axis, Expr initial = Expr()) {
+  if (!initial.defined()) {
+    initial = min_value(e.type());
+  }
+  return ir::Reduce::Make(ir::Reduce::kLogSumExp, initial, e, reduce_axis);
+}
+
+/**
+ * The uniform float in [0, 1) of the element \p index by the counter-based Philox4x32-10 RNG, keyed by the int32
+ * \p seed with the counter {index, offset, 0, 0}. It is stateless, so the same (seed, offset, index) regenerates the
+ * same number in any kernel, e.g. the dropout mask in the backward.
+ */
+Expr PhiloxUniform(Expr seed, Expr offset, Expr index);
 
 Expr IsNan(Expr e);
 
@@ -14,24 +14,85 @@
 
 #include "cinn/lang/lower.h"
 
+#include <gflags/gflags.h>
+
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <mutex>  // NOLINT
 #include <set>
+#include <sstream>
 #include <stack>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 
+#include "cinn/common/precision.h"
 #include "cinn/ir/buffer.h"
 #include "cinn/ir/ir_printer.h"
 #include "cinn/lang/lower_impl.h"
 #include "cinn/optim/optimize.h"
 
+DEFINE_bool(cinn_lower_cache,
+            false,
+            "Whether to reuse the functions lowered before in the process from the same compute definitions, "
+            "schedules, arguments and target, e.g. when a script or a notebook cell defining the kernels runs again.");
+
 namespace cinn {
 namespace lang {
 
 using ir::Tensor;
 using poly::Stage;
 
+namespace {
+// The functions lowered by Lower and LowerVec, keyed by LowerCacheKey.
+struct LowerCache {
+  std::mutex mutex;
+  std::unordered_map<std::string, std::vector<ir::LoweredFunc>> funcs;
+
+  static LowerCache& Global() {
+    static auto* cache = new LowerCache;
+    return *cache;
+  }
+};
+
+// The key of the functions lowered from the inputs, the fingerprints of the stages in the order of their ids, the
+// arguments, the target, the precision mode and the flags set, e.g. the unroll budgets of the optimizations.
+std::string LowerCacheKey(const std::string& name,
+                          StageMap stages,
+                          const std::vector<Tensor>& tensor_args,
+                          const std::vector<Var>& scalar_args,
+                          const std::vector<Tensor>& temp_tensors,
+                          const Target& target) {
+  std::stringstream ss;
+  ss << "name " << name << "\ntarget " << target << "\nprecision " << common::CurrentPrecisionMode() << "\nargs";
+  for (auto& tensor : tensor_args) ss << " " << tensor->name;
+  ss << "\nscalars";
+  for (auto& var : scalar_args) ss << " " << var->name << ":" << var->type();
+  ss << "\ntemps";
+  for (auto& tensor : temp_tensors) ss << " " << tensor->name;
+  ss << "\n";
+  std::map<std::string, std::string> fingerprints;
+  for (auto& item : stages) fingerprints[item.first] = item.second->Fingerprint();
+  for (auto& item : fingerprints) ss << item.second;
+  std::vector<google::CommandLineFlagInfo> flags;
+  google::GetAllFlags(&flags);
+  for (auto& flag : flags) {
+    if (!flag.is_default) ss << "flag " << flag.name << "=" << flag.current_value << "\n";
+  }
+  return ss.str();
+}
+
+// Add the functions got from the cache to \p b as lowering them does.
+void AddCachedFuncs(const std::vector<ir::LoweredFunc>& funcs, Module::Builder* b) {
+  if (!b) return;
+  for (auto& func : funcs) {
+    for (auto& temp_buffer : func->temp_bufs) b->AddBuffer(temp_buffer);
+    b->AddFunction(func);
+  }
+}
+}  // namespace
+
 //! Collect the temporary tensors from a computational graph.
 std::vector<ir::Buffer> GetTempBuffers(const std::vector<Tensor>& tensor_args,
                                        const poly::StageMap& stage_map,
@@ -87,6 +148,26 @@ void InitReduceTensor(StageMap stages, const Tensor& tensor, const Target& targe
   }
 }
 
+//! The scalar arguments with the symbolic dims of \p tensor_args not in them appended, in the order they appear.
+std::vector<Var> AppendDimArgs(const std::vector<Tensor>& tensor_args, const std::vector<Var>& scalar_args) {
+  std::vector<Var> res = scalar_args;
+  std::unordered_set<std::string> names;
+  for (auto& var : scalar_args) names.insert(var->name);
+  for (auto& tensor : tensor_args) {
+    for (auto& dim : tensor->shape) {
+      if (dim.is_constant()) continue;
+      auto vars = ir::CollectIRNodes(dim, [](const Expr* x) { return x->as_var(); });
+      std::vector<Var> dim_vars;
+      for (auto& var : vars) dim_vars.emplace_back(const_cast<ir::_Var_*>(var.as_var()));
+      std::sort(dim_vars.begin(), dim_vars.end(), [](const Var& a, const Var& b) { return a->name < b->name; });
+      for (auto& var : dim_vars) {
+        if (names.insert(var->name).second) res.push_back(var);
+      }
+    }
+  }
+  return res;
+}
+
 ir::LoweredFunc Lower(const std::string& name,
                       StageMap stages,
                       const std::vector<Tensor>& tensor_args,
@@ -94,6 +175,19 @@ ir::LoweredFunc Lower(const std::string& name,
                       const std::vector<Tensor>& temp_tensors,
                       Module::Builder* b,
                       const Target& target) {
+  std::string cache_key;
+  if (FLAGS_cinn_lower_cache) {
+    cache_key   = "Lower\n" + LowerCacheKey(name, stages, tensor_args, scalar_args, temp_tensors, target);
+    auto& cache = LowerCache::Global();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto it = cache.funcs.find(cache_key);
+    if (it != cache.funcs.end()) {
+      VLOG(3) << "Reuse the function " << name << " lowered before";
+      AddCachedFuncs({it->second[0]}, b);
+      return it->second[0];
+    }
+  }
+
   // Init the reduce tensors first before any process.
   for (auto& t : tensor_args) InitReduceTensor(stages, t, target);
   for (auto& t : temp_tensors) InitReduceTensor(stages, t, target);
@@ -102,8 +196,12 @@ ir::LoweredFunc Lower(const std::string& name,
   auto ctrl_deps = CollectTempTensorsFromCtrlDepends(stages, tensor_args);
   ctrl_deps.insert(temp_tensors.begin(), temp_tensors.end());
 
-  auto lower_impl_instance = detail::LowerImpl(
-      name, stages, tensor_args, scalar_args, std::vector<Tensor>(ctrl_deps.begin(), ctrl_deps.end()), target);
+  auto lower_impl_instance = detail::LowerImpl(name,
+                                               stages,
+                                               tensor_args,
+                                               AppendDimArgs(tensor_args, scalar_args),
+                                               std::vector<Tensor>(ctrl_deps.begin(), ctrl_deps.end()),
+                                               target);
 
   auto result = lower_impl_instance();
   std::vector<ir::LoweredFunc> return_value;
@@ -139,6 +237,11 @@ ir::LoweredFunc Lower(const std::string& name,
 
     return_value.push_back(res);
   }
+  if (!cache_key.empty()) {
+    auto& cache = LowerCache::Global();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.funcs[cache_key] = {return_value[0]};
+  }
   return return_value[0];
 }
 
@@ -149,6 +252,19 @@ std::vector<ir::LoweredFunc> LowerVec(const std::string& name,
                                       const std::vector<Tensor>& temp_tensors,
                                       Module::Builder* b,
                                       const Target& target) {
+  std::string cache_key;
+  if (FLAGS_cinn_lower_cache) {
+    cache_key   = "LowerVec\n" + LowerCacheKey(name, stages, tensor_args, scalar_args, temp_tensors, target);
+    auto& cache = LowerCache::Global();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto it = cache.funcs.find(cache_key);
+    if (it != cache.funcs.end()) {
+      VLOG(3) << "Reuse the functions " << name << " lowered before";
+      AddCachedFuncs(it->second, b);
+      return it->second;
+    }
+  }
+
   // Init the reduce tensors first before any process.
   for (auto& t : tensor_args) InitReduceTensor(stages, t, target);
   for (auto& t : temp_tensors) InitReduceTensor(stages, t, target);
@@ -157,8 +273,12 @@ std::vector<ir::LoweredFunc> LowerVec(const std::string& name,
   auto ctrl_deps = CollectTempTensorsFromCtrlDepends(stages, tensor_args);
   ctrl_deps.insert(temp_tensors.begin(), temp_tensors.end());
 
-  auto lower_impl_instance = detail::LowerImpl(
-      name, stages, tensor_args, scalar_args, std::vector<Tensor>(ctrl_deps.begin(), ctrl_deps.end()), target);
+  auto lower_impl_instance = detail::LowerImpl(name,
+                                               stages,
+                                               tensor_args,
+                                               AppendDimArgs(tensor_args, scalar_args),
+                                               std::vector<Tensor>(ctrl_deps.begin(), ctrl_deps.end()),
+                                               target);
   // return vectorof ir::LoweredFunc.
   auto result = lower_impl_instance();
   std::vector<ir::LoweredFunc> return_value;
@@ -194,6 +314,11 @@ std::vector<ir::LoweredFunc> LowerVec(const std::string& name,
 
     return_value.push_back(res);
   }
+  if (!cache_key.empty()) {
+    auto& cache = LowerCache::Global();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.funcs[cache_key] = return_value;
+  }
   return return_value;
 }
 
@@ -17,6 +17,8 @@
  */
 
 #pragma once
+#include <gflags/gflags.h>
+
 #include <string>
 #include <vector>
 
@@ -26,6 +28,8 @@
 #include "cinn/lang/packed_func.h"
 #include "cinn/poly/schedule.h"
 
+DECLARE_bool(cinn_lower_cache);
+
 namespace cinn {
 namespace lang {
 using ir::Tensor;
@@ -39,7 +43,11 @@ using poly::StageMap;
  * @param temp_tensors The temporary tensors(buffers) used in the body.
  * @param b The module this function belongs to.
  * @return A LoweredFunc, whose name is \p name, the argument list is the concatenation of \p tensor_args and \p
- * scalar_args.
+ * scalar_args. The symbolic dims of the shapes of \p tensor_args not in \p scalar_args are appended to the scalars, so
+ * the function takes them at runtime, see ir::_LoweredFunc_::GetDimArgSources.
+ *
+ * If FLAGS_cinn_lower_cache is set, the function lowered before from the same stages (see poly::Stage::Fingerprint),
+ * arguments, target and flags is reused, and added to \p b again.
  */
 ir::LoweredFunc Lower(const std::string &name,
                       StageMap stages,
@@ -58,7 +66,7 @@ ir::LoweredFunc Lower(const std::string &name,
  * @param temp_tensors The temporary tensors(buffers) used in the body.
  * @param b The module this function belongs to.
  * @return A vector of LoweredFuncs, whose name is \p name, name + "_1", name + "_2"... The argument list is deduced
- * from the expression of each func.
+ * from the expression of each func. They are reused as Lower does if FLAGS_cinn_lower_cache is set.
  */
 std::vector<ir::LoweredFunc> LowerVec(const std::string &name,
                                       StageMap stages,
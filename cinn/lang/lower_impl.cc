@@ -15,15 +15,19 @@
 #include "cinn/lang/lower_impl.h"
 
 #include <algorithm>
+#include <memory>
 #include <queue>
 #include <string>
 #include <unordered_set>
 
+#include "cinn/common/arena.h"
+#include "cinn/common/cas.h"
 #include "cinn/common/context.h"
 #include "cinn/common/ir_util.h"
 #include "cinn/ir/ir_printer.h"
 #include "cinn/ir/tensor.h"
 #include "cinn/poly/stage.h"
+#include "cinn/utils/compile_tracer.h"
 
 namespace cinn {
 namespace lang {
@@ -86,9 +90,7 @@ Expr LowerGroup(const poly::ScheduleGroup& group,
   // get isl generated expression
   isl::set context(Context::isl_ctx(), "{:}");
   poly::AstGen gen(context, stages, group);
-  isl::ast_node ast = gen.Build();
-  ir::Expr e;
-  poly::IslAstNodeToCinnExpr(ast, &e);
+  ir::Expr e = gen.BuildExpr();
   // now we get a workable expression, but the statement are something like `B(((16 * po0) + po1), po2)`, we need to
   // transform this to some realworld statement in CINN.
 
@@ -156,6 +158,54 @@ Expr LowerGroup(const poly::ScheduleGroup& group,
     mutator(&e);
   }
 
+  // mark tensor core.
+  {
+    std::map<std::string, int> tensor_cores;
+    for (auto& node : group.nodes) {
+      if (node->stage->tensor_core_level() >= 0) {
+        tensor_cores[node->stage->id()] = node->stage->tensor_core_level();
+      }
+    }
+    MarkTensorCoreMutator mutator(tensor_cores);
+    mutator(&e);
+  }
+
+  // mark block reduce.
+  {
+    std::map<std::string, int> block_reduces;
+    for (auto& node : group.nodes) {
+      if (node->stage->block_reduce_level() >= 0) {
+        block_reduces[node->stage->id()] = node->stage->block_reduce_level();
+      }
+    }
+    MarkBlockReduceMutator mutator(block_reduces);
+    mutator(&e);
+  }
+
+  // mark pipeline.
+  {
+    std::map<std::string, std::pair<int, int>> pipelines;
+    for (auto& node : group.nodes) {
+      if (node->stage->pipeline_level() >= 0) {
+        pipelines[node->stage->id()] = {node->stage->pipeline_level(), node->stage->pipeline_stages()};
+      }
+    }
+    MarkPipelineMutator mutator(pipelines);
+    mutator(&e);
+  }
+
+  // mark dot product.
+  {
+    std::map<std::string, int> dot_products;
+    for (auto& node : group.nodes) {
+      if (node->stage->dot_product_level() >= 0) {
+        dot_products[node->stage->id()] = node->stage->dot_product_level();
+      }
+    }
+    MarkDotProductMutator mutator(dot_products);
+    mutator(&e);
+  }
+
   // mark gpu threads
 #ifdef CINN_WITH_CUDA
   {
@@ -581,6 +631,9 @@ absl::flat_hash_map<std::string, Tensor> LowerImpl::GenAllTensorMap() {
 }
 
 std::vector<ir::LoweredFunc> LowerImpl::operator()() {
+  std::unique_ptr<common::ArenaScope> arena_scope;
+  if (FLAGS_cinn_use_ir_arena) arena_scope.reset(new common::ArenaScope);
+
   std::vector<poly::Stage*> stages;
   std::map<std::string, ir::Tensor> all_tensor_map;
   for (auto& t : CollectAllTensors()) {
@@ -588,10 +641,18 @@ std::vector<ir::LoweredFunc> LowerImpl::operator()() {
     if (!stages_[t]->inlined()) stages.push_back(stages_[t]);
   }
 
-  auto deps     = CollectExtraDependencies();
-  auto schedule = poly::CreateSchedule(
-      stages, poly::ScheduleKind::Poly, std::vector<std::pair<std::string, std::string>>(deps.begin(), deps.end()));
-  auto func_body = GenerateFunctionBody(schedule.get());
+  auto deps = CollectExtraDependencies();
+  std::unique_ptr<poly::Schedule> schedule;
+  {
+    utils::CompileStageTimer timer("PolyScheduler");
+    schedule = poly::CreateSchedule(
+        stages, poly::ScheduleKind::Poly, std::vector<std::pair<std::string, std::string>>(deps.begin(), deps.end()));
+  }
+  std::vector<ir::Expr> func_body;
+  {
+    utils::CompileStageTimer timer("AstGen");
+    func_body = GenerateFunctionBody(schedule.get());
+  }
 
   std::vector<ir::LoweredFunc> result;
   int num_func = 0;
@@ -680,7 +741,12 @@ std::vector<ir::LoweredFunc> LowerImpl::operator()() {
     // some necessary modification.
     optim::ComputeInlineExpand(&func->body, stages_, &all_tensor_map);
 
-    auto res = optim::Optimize(func, target_, FLAGS_cinn_runtime_display_debug_info);
+    // drop the local references to the function, so that Optimize only copies the nodes shared with the tensors.
+    Expr func_expr = func;
+    func           = ir::LoweredFunc();
+    func_iterator  = Expr();
+    store_exprs.clear();
+    auto res = optim::Optimize(std::move(func_expr), target_, FLAGS_cinn_runtime_display_debug_info);
 
     if (cuda_axis_info_.size() > num_func && cuda_axis_info_[num_func].valid()) {
       auto* res_func           = res.as_lowered_func();
@@ -689,6 +755,7 @@ std::vector<ir::LoweredFunc> LowerImpl::operator()() {
     result.push_back(ir::LoweredFunc(res.get()));
     num_func++;
   }
+  VLOG(3) << "After lowering " << fn_name_ << ", " << common::CasStats::Global().Summary();
   return result;
 }
 
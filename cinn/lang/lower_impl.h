@@ -297,6 +297,134 @@ struct MarkParallelMutator : public ir::IRMutator<Expr*> {
   std::vector<ir::PolyFor*> stack;
 };
 
+/**
+ * Mark the outermost PolyFor of the tile as TensorCore if is called TensorCore in Stage.
+ */
+struct MarkTensorCoreMutator : public ir::IRMutator<Expr*> {
+  std::map<std::string, int /*level*/> tensor_cores;
+
+  explicit MarkTensorCoreMutator(const std::map<std::string, int>& tensor_cores) : tensor_cores(tensor_cores) {}
+
+  void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+  void Visit(const ir::PolyFor* op, Expr* expr) override {
+    auto* node = expr->As<ir::PolyFor>();
+    stack.push_back(node);
+    ir::IRMutator<>::Visit(op, expr);
+    stack.pop_back();
+  }
+
+  // each statement in ISL is bound to a Store node.
+  void Visit(const ir::Store* op, Expr* expr) override {
+    auto* tensor_n = op->tensor.As<ir::_Tensor_>();
+    CHECK(tensor_n);
+    auto it = tensor_cores.find(tensor_n->name);
+    if (it != tensor_cores.end()) {
+      VLOG(1) << "Mark " << it->second << " TensorCore";
+      CHECK_LT(it->second, stack.size());
+      stack[it->second]->set_tensor_core();
+    }
+  }
+
+  std::vector<ir::PolyFor*> stack;
+};
+
+/**
+ * Mark the PolyFor as BlockReduce if is called BlockReduce in Stage.
+ */
+struct MarkBlockReduceMutator : public ir::IRMutator<Expr*> {
+  std::map<std::string, int /*level*/> block_reduces;
+
+  explicit MarkBlockReduceMutator(const std::map<std::string, int>& block_reduces) : block_reduces(block_reduces) {}
+
+  void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+  void Visit(const ir::PolyFor* op, Expr* expr) override {
+    auto* node = expr->As<ir::PolyFor>();
+    stack.push_back(node);
+    ir::IRMutator<>::Visit(op, expr);
+    stack.pop_back();
+  }
+
+  // each statement in ISL is bound to a Store node.
+  void Visit(const ir::Store* op, Expr* expr) override {
+    auto* tensor_n = op->tensor.As<ir::_Tensor_>();
+    CHECK(tensor_n);
+    auto it = block_reduces.find(tensor_n->name);
+    if (it != block_reduces.end()) {
+      VLOG(1) << "Mark " << it->second << " BlockReduce";
+      CHECK_LT(it->second, stack.size());
+      stack[it->second]->set_block_reduce();
+    }
+  }
+
+  std::vector<ir::PolyFor*> stack;
+};
+
+/**
+ * Mark the PolyFor as Pipelined with the number of stages if is called Pipeline in Stage.
+ */
+struct MarkPipelineMutator : public ir::IRMutator<Expr*> {
+  std::map<std::string, std::pair<int /*level*/, int /*stages*/>> pipelines;
+
+  explicit MarkPipelineMutator(const std::map<std::string, std::pair<int, int>>& pipelines) : pipelines(pipelines) {}
+
+  void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+  void Visit(const ir::PolyFor* op, Expr* expr) override {
+    auto* node = expr->As<ir::PolyFor>();
+    stack.push_back(node);
+    ir::IRMutator<>::Visit(op, expr);
+    stack.pop_back();
+  }
+
+  // each statement in ISL is bound to a Store node.
+  void Visit(const ir::Store* op, Expr* expr) override {
+    auto* tensor_n = op->tensor.As<ir::_Tensor_>();
+    CHECK(tensor_n);
+    auto it = pipelines.find(tensor_n->name);
+    if (it != pipelines.end()) {
+      VLOG(1) << "Mark " << it->second.first << " Pipelined of " << it->second.second << " stages";
+      CHECK_LT(it->second.first, stack.size());
+      stack[it->second.first]->set_pipeline_stages(it->second.second);
+    }
+  }
+
+  std::vector<ir::PolyFor*> stack;
+};
+
+/**
+ * Mark the PolyFor as DotProduct if is called DotProduct4 in Stage.
+ */
+struct MarkDotProductMutator : public ir::IRMutator<Expr*> {
+  std::map<std::string, int /*level*/> dot_products;
+
+  explicit MarkDotProductMutator(const std::map<std::string, int>& dot_products) : dot_products(dot_products) {}
+
+  void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+  void Visit(const ir::PolyFor* op, Expr* expr) override {
+    auto* node = expr->As<ir::PolyFor>();
+    stack.push_back(node);
+    ir::IRMutator<>::Visit(op, expr);
+    stack.pop_back();
+  }
+
+  // each statement in ISL is bound to a Store node.
+  void Visit(const ir::Store* op, Expr* expr) override {
+    auto* tensor_n = op->tensor.As<ir::_Tensor_>();
+    CHECK(tensor_n);
+    auto it = dot_products.find(tensor_n->name);
+    if (it != dot_products.end()) {
+      VLOG(1) << "Mark " << it->second << " DotProduct";
+      CHECK_LT(it->second, stack.size());
+      stack[it->second]->set_dot_product();
+    }
+  }
+
+  std::vector<ir::PolyFor*> stack;
+};
+
 }  // namespace detail
 }  // namespace lang
 }  // namespace cinn
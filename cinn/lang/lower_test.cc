@@ -14,6 +14,7 @@
 
 #include "cinn/lang/lower.h"
 
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
 #include <set>
@@ -97,6 +98,30 @@ TEST(lower, dynamic_shape) {
   std::cout << "func:\n" << Expr(lower_funcs->self()) << std::endl;
 }
 
+TEST(lower, dynamic_shape_divisor) {
+  auto lower_split = [](int divisor) {
+    Var M("M");
+    M->divisor = divisor;
+    Placeholder<float> A("A", {Expr(M)});
+    auto B = Compute(
+        {Expr(M)}, [=](Var i) -> Expr { return A(i) + 1.f; }, "B");
+    auto stages = CreateStages({B});
+    stages[B]->Split(0, 8);
+    auto fn = Lower("fn", stages, {A, B});
+    // M is appended to the arguments as it is a dim of A and B
+    CHECK(fn->args[0].is_var());
+    return utils::GetStreamCnt(fn->body);
+  };
+
+  auto general = lower_split(1);
+  auto divided = lower_split(16);
+  LOG(INFO) << "general:\n" << general << "\ndivided:\n" << divided;
+  // the loop is split without the tail when M is known to be a multiple of the factor
+  ASSERT_NE(general, divided);
+  ASSERT_EQ(divided.find("min"), std::string::npos);
+  ASSERT_EQ(divided.find("if ("), std::string::npos);
+}
+
 TEST(lower, lowered_call) {
   Var B("B");  // B is like shape here.
   Expr N(15);
@@ -151,5 +176,32 @@ TEST(lower, temp_buffer_collects) {
   }
 }
 
+TEST(lower, cache) {
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  FLAGS_cinn_lower_cache = true;
+  // Define the same computation again, as a script rerunning does.
+  auto define = [](bool split) {
+    Placeholder<float> A("A", {Expr(32), Expr(16)});
+    auto B = Compute(
+        {Expr(32), Expr(16)}, [=](Var i, Var j) -> Expr { return A(i, j) * 2.f; }, "B");
+    auto stages = CreateStages({B});
+    if (split) stages[B]->Split(1, 4);
+    ir::Module::Builder b("module", common::DefaultHostTarget());
+    auto fn = Lower("cache_fn", stages, {A, B}, {}, {}, &b);
+    EXPECT_EQ(b.Build().functions().size(), 1UL);
+    return fn;
+  };
+
+  auto fn = define(false);
+  ASSERT_EQ(define(false).get(), fn.get());
+  // Another schedule lowers again.
+  auto split_fn = define(true);
+  ASSERT_NE(split_fn.get(), fn.get());
+  ASSERT_EQ(define(true).get(), split_fn.get());
+
+  FLAGS_cinn_lower_cache = false;
+  ASSERT_NE(define(false).get(), fn.get());
+}
+
 }  // namespace lang
 }  // namespace cinn
@@ -26,6 +26,13 @@ ir::Tensor CreatePlaceHolder(const std::vector<Expr> &shape, Type type, const st
     return Placeholder<double>(name, shape);
   } else if (type == Int(32)) {
     return Placeholder<int32_t>(name, shape);
+  } else if (type == Float(16)) {
+    // no C++ type for float16 to instantiate Placeholder<T>, build the same tensor by the type directly.
+    auto op = ir::PlaceholderOp::Make(name, shape, type);
+    ir::Tensor tensor(name, type, shape, shape, op, {});
+    Buffer buffer(tensor->type());
+    tensor->Bind(buffer);
+    return tensor;
   }
   CINN_NOT_IMPLEMENTED
 }
@@ -14,90 +14,129 @@
 
 #include "cinn/optim/eliminate_broadcast_in_forloop.h"
 
-#include <tuple>
+#include <set>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "cinn/common/ir_util.h"
+#include "cinn/ir/collect_ir_nodes.h"
+#include "cinn/ir/ir_hash.h"
 #include "cinn/ir/ir_mutator.h"
 #include "cinn/ir/ir_printer.h"
-#include "cinn/ir/ir_visitor.h"
-#include "cinn/optim/ir_replace.h"
 
 namespace cinn {
 namespace optim {
 
 namespace detail {
 
-struct EliminateBroadcastInForloop : public ir::IRMutator<Expr*> {
-  void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
-
-  void Visit(const ir::Store* op, Expr* expr) {
-    // TODO(Superjom) Support single one level of forloop.
-    if (forloop_stack.size() < 2) return;
-
-    auto* node = expr->As<ir::Store>();
-
-    auto broadcasts = ir::CollectIRNodes(node->value, [&](const Expr* expr) { return expr->As<ir::Broadcast>(); });
-    std::vector<Expr> let_exprs;
-
-    Var tmp;
-    Expr let_expr;
+//! Replace the invariant broadcasts of the body of a loop with the temporary variables.
+struct HoistBroadcastMutator : public ir::IRMutator<Expr*> {
+  HoistBroadcastMutator(const std::set<std::string>& variant_vars, const std::set<std::string>& written)
+      : variant_vars_(variant_vars), written_(written) {}
 
-    Var cur_level_loop_var = forloop_stack.back()->As<ir::For>() ? forloop_stack.back()->As<ir::For>()->loop_var
-                                                                 : forloop_stack.back()->As<ir::PolyFor>()->iterator;
-    for (Expr broadcast : broadcasts) {
-      if (ContainsLoopVar(broadcast, cur_level_loop_var)) continue;
-      VLOG(4) << "eliminating " << broadcast;
-      std::tie(let_expr, tmp) = CreateTmpLet(broadcast);
-      let_exprs.push_back(let_expr);
+  void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
 
-      optim::IrReplace(expr, broadcast, tmp);
+  //! The Let nodes defining the temporary variables, in the order of their first uses.
+  std::vector<Expr> lets;
+
+ private:
+  void Visit(const ir::Broadcast* op, Expr* expr) override {
+    // the splats of the constants are folded by the codegen
+    if (conditional_depth_ > 0 || op->value.is_constant() || !IsInvariant(op->value)) return;
+    auto it = hoisted_.find(*expr);
+    if (it == hoisted_.end()) {
+      Var tmp(Context::Global().NewName("tmp"), expr->type());
+      lets.push_back(ir::Let::Make(tmp, *expr));
+      it = hoisted_.emplace(*expr, tmp).first;
     }
+    *expr = Expr(it->second);
+  }
 
-    // insert the let expressions to the outer forloop.
-
-    Expr* outer_forloop = forloop_stack[forloop_stack.size() - 2];
-
-    auto& outer_forloop_body =
-        outer_forloop->As<ir::For>() ? outer_forloop->As<ir::For>()->body : outer_forloop->As<ir::PolyFor>()->body;
+  void Visit(const ir::Select* op, Expr* expr) override {
+    auto* node = expr->As<ir::Select>();
+    ir::IRMutator<>::Visit(&node->condition, &node->condition);
+    conditional_depth_++;
+    ir::IRMutator<>::Visit(&node->true_value, &node->true_value);
+    ir::IRMutator<>::Visit(&node->false_value, &node->false_value);
+    conditional_depth_--;
+  }
 
-    auto* outer_forloop_body_block = outer_forloop_body.As<ir::Block>();
-    if (outer_forloop_body_block) {
-      outer_forloop_body_block->stmts.insert(
-          std::begin(outer_forloop_body_block->stmts), let_exprs.begin(), let_exprs.end());
+  void Visit(const ir::IfThenElse* op, Expr* expr) override {
+    auto* node = expr->As<ir::IfThenElse>();
+    ir::IRMutator<>::Visit(&node->condition, &node->condition);
+    conditional_depth_++;
+    ir::IRMutator<>::Visit(&node->true_case, &node->true_case);
+    if (node->false_case.defined()) ir::IRMutator<>::Visit(&node->false_case, &node->false_case);
+    conditional_depth_--;
+  }
 
-    } else {
-      let_exprs.push_back(outer_forloop_body);
-      outer_forloop_body = ir::Block::Make(let_exprs);
-    }
+  void Visit(const ir::Let* op, Expr* expr) override {
+    auto* node = expr->As<ir::Let>();
+    if (node->body.defined()) ir::IRMutator<>::Visit(&node->body, &node->body);
   }
 
-  bool ContainsLoopVar(Expr expr, Var loop_var) {
-    return !ir::CollectIRNodes(expr, [&](const Expr* e) -> bool {
-              return e->As<ir::_Var_>() && e->As<ir::_Var_>()->name == loop_var->name;
-            }).empty();
+  bool IsInvariant(const Expr& value) const {
+    if (value.type().lanes() != 1) return false;
+    auto variants = ir::CollectIRNodes(value, [&](const Expr* x) {
+      if (auto* var = x->As<ir::_Var_>()) return variant_vars_.count(var->name) > 0;
+      if (auto* load = x->As<ir::Load>()) {
+        return !load->is_addr_tensor() || written_.count(common::BufferName(load->tensor));
+      }
+      return x->As<ir::Call>() || x->As<ir::IntrinsicOp>() || x->As<ir::Let>() || x->As<ir::Reduce>();
+    });
+    return variants.empty();
   }
 
-  std::tuple<Expr, Var> CreateTmpLet(Expr body) {
-    Var tmp(Context::Global().NewName("tmp"), body.type());
+  const std::set<std::string>& variant_vars_;
+  const std::set<std::string>& written_;
+  std::unordered_map<Expr, Var, ir::ExprStructuralHash, ir::ExprStructuralEqual> hoisted_;
+  int conditional_depth_{0};
+};
 
-    Expr let_expr = ir::Let::Make(tmp, body);
+struct EliminateBroadcastInForloop : public ir::IRMutator<Expr*> {
+  void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
 
-    return std::make_tuple(let_expr, tmp);
-  }
+ private:
+  void Visit(const ir::For* op, Expr* expr) override {
+    auto* node = expr->As<ir::For>();
+    ir::IRMutator<>::Visit(&node->body, &node->body);
 
-  void Visit(const ir::For* op, Expr* expr) {
-    forloop_stack.push_back(expr);
-    ir::IRMutator<>::Visit(op, expr);
-    forloop_stack.pop_back();
-  }
+    if (node->is_parallel() || node->is_vectorized()) return;
+    // the loads of the hoisted broadcasts are evaluated even if the loop has no iteration
+    if (!node->min.is_constant() || !node->extent.is_constant() || node->extent.as_int64() <= node->min.as_int64()) {
+      return;
+    }
 
-  void Visit(const ir::PolyFor* op, Expr* expr) {
-    forloop_stack.push_back(expr);
-    ir::IRMutator<>::Visit(op, expr);
-    forloop_stack.pop_back();
+    std::set<std::string> variant_vars({node->loop_var->name});
+    for (auto& x : ir::CollectIRNodes(node->body, [](const Expr* x) { return x->As<ir::For>() || x->As<ir::Let>(); })) {
+      auto* var = x.As<ir::For>() ? x.As<ir::For>()->loop_var.get() : x.As<ir::Let>()->symbol.As<ir::_Var_>();
+      if (var) variant_vars.insert(var->name);
+    }
+    std::set<std::string> written;
+    for (auto& store : ir::CollectIRNodes(node->body, [](const Expr* x) { return x->As<ir::Store>(); })) {
+      written.insert(common::BufferName(store.As<ir::Store>()->tensor));
+    }
+    // the calls may write any buffer they take the address of
+    auto writing_calls = ir::CollectIRNodes(node->body, [](const Expr* x) {
+      auto* call = x->As<ir::Call>();
+      if (!call) return false;
+      if (!call->write_args.empty()) return true;
+      for (auto& arg : call->read_args) {
+        if (arg.as_tensor() || arg.as_buffer() || arg.type().is_cpp_handle()) return true;
+      }
+      return false;
+    });
+    if (!writing_calls.empty()) return;
+
+    HoistBroadcastMutator hoist(variant_vars, written);
+    hoist(&node->body);
+    if (hoist.lets.empty()) return;
+    VLOG(3) << "hoist " << hoist.lets.size() << " invariant broadcasts out of the loop of " << node->loop_var;
+    auto stmts = hoist.lets;
+    stmts.push_back(*expr);
+    *expr = ir::Block::Make(stmts);
   }
-
-  std::vector<Expr*> forloop_stack;
 };
 
 }  // namespace detail
@@ -18,6 +18,24 @@
 namespace cinn {
 namespace optim {
 
+/**
+ * Hoist the vector splats of the loop-invariant scalars out of the serial loops, e.g. the broadcast operand of the
+ * vectorized elementwise_add with the axis
+ *
+ * float licm_0 = B[c]
+ * for (j, 0, 64)
+ *   C[ramp(c * 256 + j * 4, 1, 4)] = A[ramp(c * 256 + j * 4, 1, 4)] + Broadcast(licm_0, 4)
+ *
+ * to
+ *
+ * float licm_0 = B[c]
+ * auto tmp_0 = Broadcast(licm_0, 4)
+ * for (j, 0, 64)
+ *   C[ramp(c * 256 + j * 4, 1, 4)] = A[ramp(c * 256 + j * 4, 1, 4)] + tmp_0
+ *
+ * A Broadcast is hoisted only if its value uses neither the variables of the loop nor the buffers written in it, and it
+ * is evaluated in every iteration. It runs after LoopInvariantCodeMotion, which has hoisted the scalar loads it splats.
+ */
 void EliminateBroadcastInForloop(Expr* expr);
 
 }  // namespace optim
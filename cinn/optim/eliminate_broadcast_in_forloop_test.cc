@@ -0,0 +1,71 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/eliminate_broadcast_in_forloop.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "cinn/backends/llvm/execution_engine.h"
+#include "cinn/cinn.h"
+#include "cinn/common/test_helper.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/utils/string.h"
+
+namespace cinn::optim {
+
+// the broadcast operand of the vectorized add is splatted once a row
+TEST(EliminateBroadcastInForloop, hoist_broadcast_operand) {
+  const int M = 32, N = 128;
+  Placeholder<float> A("A", {Expr(M), Expr(N)});
+  Placeholder<float> B("B", {Expr(M)});
+  auto C = Compute(
+      {Expr(M), Expr(N)}, [&](Var i, Var j) { return A(i, j) + B(i); }, "C");
+  auto stages = CreateStages({C});
+  stages[C]->Vectorize(1, 16);
+
+  Module::Builder builder("module0", common::DefaultHostTarget());
+  auto func = Lower("fn", stages, {A, B, C}, {}, {}, &builder, common::DefaultHostTarget());
+  LOG(INFO) << func;
+  auto code = utils::GetStreamCnt(func);
+  auto pos  = code.find("Broadcast(");
+  ASSERT_NE(pos, std::string::npos);
+  EXPECT_EQ(pos, code.rfind("Broadcast("));
+  EXPECT_LT(pos, code.rfind("for ("));
+
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn = jit->Lookup("fn");
+  CHECK(fn);
+  auto fn_ = reinterpret_cast<void (*)(void *, int32_t)>(fn);
+
+  cinn_buffer_t *A_buf = common::BufferBuilder(Float(32), {M, N}).set_random().Build();
+  cinn_buffer_t *B_buf = common::BufferBuilder(Float(32), {M}).set_random().Build();
+  cinn_buffer_t *C_buf = common::BufferBuilder(Float(32), {M, N}).set_zero().Build();
+  cinn_pod_value_t a_arg(A_buf), b_arg(B_buf), c_arg(C_buf);
+  std::vector<cinn_pod_value_t> args = {a_arg, b_arg, c_arg};
+  fn_(reinterpret_cast<void **>(args.data()), args.size());
+
+  auto *ad = reinterpret_cast<float *>(A_buf->memory);
+  auto *bd = reinterpret_cast<float *>(B_buf->memory);
+  auto *cd = reinterpret_cast<float *>(C_buf->memory);
+  for (int i = 0; i < M; i++) {
+    for (int j = 0; j < N; j++) {
+      ASSERT_FLOAT_EQ(cd[i * N + j], ad[i * N + j] + bd[i]);
+    }
+  }
+}
+
+}  // namespace cinn::optim
@@ -17,6 +17,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include "cinn/ir/ir_hash.h"
 #include "cinn/ir/ir_mutator.h"
 #include "cinn/ir/ir_printer.h"
 #include "cinn/utils/string.h"
@@ -40,8 +41,8 @@ struct FoldCINNCallArgumentsMutator : public ir::IRMutator<> {
         auto* call = it->As<ir::Store>()->value.As<ir::Call>();
         if (call && call->is_cinn_call()) {
           // remove the duplicate calls.
-          std::string key = utils::GetStreamCnt(Expr(call));
-          if (visited_call_.count(utils::GetStreamCnt(Expr(call)))) {
+          Expr key(call);
+          if (visited_call_.count(key)) {
             it = node->stmts.erase(it);
             continue;
           }
@@ -103,7 +104,7 @@ struct FoldCINNCallArgumentsMutator : public ir::IRMutator<> {
 
  private:
   // To avoid the same call triggered duplicately.
-  std::unordered_set<std::string> visited_call_;
+  std::unordered_set<Expr, ir::ExprStructuralHash, ir::ExprStructuralEqual> visited_call_;
 };
 
 }  // namespace
@@ -0,0 +1,134 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/if_conversion.h"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "cinn/ir/collect_ir_nodes.h"
+#include "cinn/ir/ir_hash.h"
+#include "cinn/ir/ir_mutator.h"
+
+namespace cinn {
+namespace optim {
+
+namespace {
+
+//! The stores of a case converted at most, beyond which the selects cost more than the branch.
+constexpr int kMaxConvertedStores = 4;
+
+// Whether \p expr can be evaluated whatever the condition, i.e. it calls nothing but the extern math functions.
+bool IsSpeculatable(const Expr &expr) {
+  auto calls = ir::CollectIRNodes(expr, [](const Expr *x) {
+    auto *call = x->As<ir::Call>();
+    return call && !(call->is_extern_call() && !call->type().is_void());
+  });
+  return calls.empty();
+}
+
+// Collect the stores of \p expr into \p stores, false if it is anything else.
+bool CollectStores(const Expr &expr, std::vector<const ir::Store *> *stores) {
+  if (auto *block = expr.As<ir::Block>()) {
+    for (auto &stmt : block->stmts) {
+      if (!CollectStores(stmt, stores)) return false;
+    }
+    return true;
+  }
+  auto *store = expr.As<ir::Store>();
+  if (!store || !store->tensor.as_tensor()) return false;
+  stores->push_back(store);
+  return true;
+}
+
+bool IsSameElement(const ir::Store *a, const ir::Store *b) {
+  return a->tensor.as_tensor()->name == b->tensor.as_tensor()->name && a->indices.size() == b->indices.size() &&
+         ir::StructuralEqual(a->index(), b->index());
+}
+
+struct IfConversionMutator : public ir::IRMutator<Expr *> {
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+  using ir::IRMutator<>::Visit;
+
+  void Visit(const ir::IfThenElse *op, Expr *expr) override {
+    ir::IRMutator<>::Visit(op, expr);
+    auto *node = expr->As<ir::IfThenElse>();
+    if (!node->false_case.defined() || node->condition.type().is_vector() || !IsSpeculatable(node->condition)) return;
+    std::vector<const ir::Store *> true_stores, false_stores;
+    if (!CollectStores(node->true_case, &true_stores) || !CollectStores(node->false_case, &false_stores)) return;
+    if (true_stores.empty() || true_stores.size() != false_stores.size() || true_stores.size() > kMaxConvertedStores) {
+      return;
+    }
+    for (int i = 0; i < true_stores.size(); i++) {
+      if (!IsSameElement(true_stores[i], false_stores[i]) || !IsSpeculatable(true_stores[i]->value) ||
+          !IsSpeculatable(false_stores[i]->value)) {
+        return;
+      }
+    }
+    // the condition is evaluated again by each select, after the stores before it
+    if (true_stores.size() > 1) {
+      auto loads = ir::CollectIRNodes(node->condition, [&](const Expr *x) {
+        auto *load = x->As<ir::Load>();
+        return load && load->tensor.as_tensor() &&
+               std::any_of(true_stores.begin(), true_stores.end(), [&](const ir::Store *store) {
+                 return store->tensor.as_tensor()->name == load->tensor.as_tensor()->name;
+               });
+      });
+      if (!loads.empty()) return;
+    }
+    std::vector<Expr> stmts;
+    for (int i = 0; i < true_stores.size(); i++) {
+      auto *store = true_stores[i];
+      Expr value  = ir::Select::Make(node->condition, store->value, false_stores[i]->value);
+      Visit(&value, &value);
+      stmts.push_back(ir::Store::Make(store->tensor, value, store->indices));
+    }
+    *expr = stmts.size() == 1 ? stmts.front() : ir::Block::Make(stmts);
+  }
+
+  void Visit(const ir::Select *op, Expr *expr) override {
+    ir::IRMutator<>::Visit(op, expr);
+    auto *node = expr->As<ir::Select>();
+    if (node->true_value.type() != node->false_value.type()) return;
+    Expr a, b;
+    bool less = false;
+    if (auto *lt = node->condition.As<ir::LT>()) {
+      std::tie(a, b, less) = std::make_tuple(lt->a(), lt->b(), true);
+    } else if (auto *le = node->condition.As<ir::LE>()) {
+      std::tie(a, b, less) = std::make_tuple(le->a(), le->b(), true);
+    } else if (auto *gt = node->condition.As<ir::GT>()) {
+      std::tie(a, b, less) = std::make_tuple(gt->a(), gt->b(), false);
+    } else if (auto *ge = node->condition.As<ir::GE>()) {
+      std::tie(a, b, less) = std::make_tuple(ge->a(), ge->b(), false);
+    } else {
+      return;
+    }
+    if (a.type() != node->true_value.type()) return;
+    // select(a < b, a, b) is min(a, b), and select(a < b, b, a) is max(a, b)
+    if (ir::StructuralEqual(a, node->true_value) && ir::StructuralEqual(b, node->false_value)) {
+      *expr = less ? ir::Min::Make(a, b) : ir::Max::Make(a, b);
+    } else if (ir::StructuralEqual(b, node->true_value) && ir::StructuralEqual(a, node->false_value)) {
+      *expr = less ? ir::Max::Make(a, b) : ir::Min::Make(a, b);
+    }
+  }
+};
+
+}  // namespace
+
+void IfConversion(Expr *expr) { IfConversionMutator()(expr); }
+
+}  // namespace optim
+}  // namespace cinn
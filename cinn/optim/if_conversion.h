@@ -0,0 +1,44 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "cinn/ir/ir.h"
+
+namespace cinn {
+namespace optim {
+
+/**
+ * Lower the side-effect-free conditionals to the branch-free selects, which VectorizeLoops widens to the vector blends
+ * on X86 and which are the predicated selects on NVGPU instead of the divergent branches, e.g.
+ *
+ * if (x[i] > 0) {
+ *   B[i] = x[i]
+ * } else {
+ *   B[i] = x[i] * 0.1
+ * }
+ *
+ * to
+ *
+ * B[i] = select((x[i] > 0), x[i], (x[i] * 0.1))
+ *
+ * 1. An if-then-else is converted if both its cases are at most a few stores, which write the same elements in the same
+ * order, and the values stored call nothing but the extern math functions. The loads of the case not taken are
+ * speculated, as those of the selects of pe::Pad.
+ * 2. select(a < b, a, b) is lowered to min(a, b) and select(a > b, a, b) to max(a, b), also with <=, >= and the values
+ * swapped.
+ */
+void IfConversion(Expr* expr);
+
+}  // namespace optim
+}  // namespace cinn
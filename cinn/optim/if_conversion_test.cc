@@ -0,0 +1,80 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/if_conversion.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "cinn/cinn.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/utils/string.h"
+
+namespace cinn::optim {
+
+TEST(IfConversion, convert_stores) {
+  Placeholder<float> X("X", {Expr(64)});
+  Placeholder<float> B("B", {Expr(64)});
+  Placeholder<float> C("C", {Expr(64)});
+  Var i(64, "i");
+  Expr x = X(i);
+  Expr e = ir::IfThenElse::Make(
+      x > Expr(0.f),
+      ir::Block::Make({ir::Store::Make(B, x, {i}), ir::Store::Make(C, Expr(1.f), {i})}),
+      ir::Block::Make({ir::Store::Make(B, x * Expr(0.1f), {i}), ir::Store::Make(C, Expr(0.f), {i})}));
+  IfConversion(&e);
+  LOG(INFO) << e;
+  auto code = utils::GetStreamCnt(e);
+  EXPECT_EQ(code.find("if"), std::string::npos);
+  EXPECT_NE(code.find("B[i] = select"), std::string::npos);
+  EXPECT_NE(code.find("C[i] = select"), std::string::npos);
+}
+
+TEST(IfConversion, keep_branches) {
+  Placeholder<float> X("X", {Expr(64)});
+  Placeholder<float> B("B", {Expr(64)});
+  Var i(64, "i");
+  Expr x = X(i);
+  // no else case
+  Expr no_else = ir::IfThenElse::Make(x > Expr(0.f), ir::Store::Make(B, x, {i}));
+  // the cases write the different elements
+  Expr different = ir::IfThenElse::Make(x > Expr(0.f), ir::Store::Make(B, x, {i}), ir::Store::Make(B, x, {i + 1}));
+  // the condition reads B written by the first store
+  Expr b            = B(i);
+  Expr reads_stored = ir::IfThenElse::Make(
+      b > Expr(0.f),
+      ir::Block::Make({ir::Store::Make(B, x, {i}), ir::Store::Make(X, x, {i})}),
+      ir::Block::Make({ir::Store::Make(B, -x, {i}), ir::Store::Make(X, -x, {i})}));
+  for (auto *e : {&no_else, &different, &reads_stored}) {
+    IfConversion(e);
+    EXPECT_NE(utils::GetStreamCnt(*e).find("if"), std::string::npos) << *e;
+  }
+}
+
+TEST(IfConversion, min_max) {
+  Var a("a", Float(32));
+  Var b("b", Float(32));
+  Expr lt     = ir::Select::Make(ir::LT::Make(a, b), a, b);
+  Expr ge     = ir::Select::Make(ir::GE::Make(a, b), a, b);
+  Expr ge_rev = ir::Select::Make(ir::GE::Make(a, b), b, a);
+  Expr other  = ir::Select::Make(ir::LT::Make(a, b), a, Expr(0.f));
+  for (auto *e : {&lt, &ge, &ge_rev, &other}) IfConversion(e);
+  EXPECT_TRUE(lt.As<ir::Min>());
+  EXPECT_TRUE(ge.As<ir::Max>());
+  EXPECT_TRUE(ge_rev.As<ir::Min>());
+  EXPECT_TRUE(other.As<ir::Select>());
+}
+
+}  // namespace cinn::optim
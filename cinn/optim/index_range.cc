@@ -0,0 +1,87 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/index_range.h"
+
+#include <algorithm>
+
+namespace cinn {
+namespace optim {
+
+bool GetPositiveConstant(const Expr& expr, int64_t* value) {
+  auto* imm = expr.As<ir::IntImm>();
+  if (!imm || imm->value <= 0) return false;
+  *value = imm->value;
+  return true;
+}
+
+bool GetIndexRange(const Expr& expr, const std::map<std::string, IndexRange>& ranges, IndexRange* range) {
+  if (auto* imm = expr.As<ir::IntImm>()) {
+    *range = IndexRange{imm->value, imm->value};
+    return true;
+  }
+  if (auto* var = expr.As<ir::_Var_>()) {
+    auto it = ranges.find(var->name);
+    if (it == ranges.end()) return false;
+    *range = it->second;
+    return true;
+  }
+  IndexRange a, b;
+  auto get_operands = [&](const Expr& x, const Expr& y) {
+    return GetIndexRange(x, ranges, &a) && GetIndexRange(y, ranges, &b);
+  };
+  if (auto* add = expr.As<ir::Add>()) {
+    if (!get_operands(add->a(), add->b())) return false;
+    *range = IndexRange{a.min + b.min, a.max + b.max};
+  } else if (auto* sub = expr.As<ir::Sub>()) {
+    if (!get_operands(sub->a(), sub->b())) return false;
+    *range = IndexRange{a.min - b.max, a.max - b.min};
+  } else if (auto* mul = expr.As<ir::Mul>()) {
+    if (!get_operands(mul->a(), mul->b())) return false;
+    int64_t corners[] = {a.min * b.min, a.min * b.max, a.max * b.min, a.max * b.max};
+    *range            = IndexRange{*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4)};
+  } else if (auto* div = expr.As<ir::Div>()) {
+    int64_t c;
+    if (!GetPositiveConstant(div->b(), &c) || !GetIndexRange(div->a(), ranges, &a)) return false;
+    // the truncated division by a positive constant is monotonic
+    *range = IndexRange{a.min / c, a.max / c};
+  } else if (auto* mod = expr.As<ir::Mod>()) {
+    int64_t c;
+    if (!GetPositiveConstant(mod->b(), &c) || !GetIndexRange(mod->a(), ranges, &a)) return false;
+    if (a.min >= 0 && a.max < c) {
+      *range = a;
+    } else {
+      *range = IndexRange{a.min >= 0 ? 0 : 1 - c, a.max >= 0 ? c - 1 : 0};
+    }
+  } else if (auto* min = expr.As<ir::Min>()) {
+    if (!get_operands(min->a(), min->b())) return false;
+    *range = IndexRange{std::min(a.min, b.min), std::min(a.max, b.max)};
+  } else if (auto* max = expr.As<ir::Max>()) {
+    if (!get_operands(max->a(), max->b())) return false;
+    *range = IndexRange{std::max(a.min, b.min), std::max(a.max, b.max)};
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool ProveLess(const Expr& a, const Expr& b, const std::map<std::string, IndexRange>& ranges, bool or_equal) {
+  if (!a.type().is_int() || a.type().lanes() != 1 || a.type() != b.type()) return false;
+  IndexRange range;
+  if (!GetIndexRange(ir::Sub::Make(b, a), ranges, &range)) return false;
+  return or_equal ? range.min >= 0 : range.min > 0;
+}
+
+}  // namespace optim
+}  // namespace cinn
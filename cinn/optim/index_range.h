@@ -0,0 +1,45 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "cinn/ir/ir.h"
+
+namespace cinn {
+namespace optim {
+
+//! The closed range [min, max] of the values of an integer expression.
+struct IndexRange {
+  int64_t min;
+  int64_t max;
+};
+
+//! Get the \p value of \p expr if it is a positive integer constant, return false otherwise.
+bool GetPositiveConstant(const Expr& expr, int64_t* value);
+
+/**
+ * Get the range of an integer expression by the \p ranges of its variables, return false if it is unknown. The
+ * expression may contain the constants, the variables, +, -, *, min, max, and the divisions and the modulos by the
+ * positive constants.
+ */
+bool GetIndexRange(const Expr& expr, const std::map<std::string, IndexRange>& ranges, IndexRange* range);
+
+//! Whether \p a <= \p b, or \p a < \p b if not \p or_equal, is proved for all the values in the \p ranges.
+bool ProveLess(const Expr& a, const Expr& b, const std::map<std::string, IndexRange>& ranges, bool or_equal);
+
+}  // namespace optim
+}  // namespace cinn
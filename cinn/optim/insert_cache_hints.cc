@@ -0,0 +1,310 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/insert_cache_hints.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cinn/common/ir_util.h"
+#include "cinn/ir/collect_ir_nodes.h"
+#include "cinn/ir/ir_hash.h"
+#include "cinn/ir/ir_mutator.h"
+#include "cinn/ir/ir_operators.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/optim/ir_copy.h"
+#include "cinn/optim/ir_replace.h"
+#include "cinn/optim/ir_simplify.h"
+#include "cinn/utils/string.h"
+
+DEFINE_int32(cinn_x86_prefetch_distance,
+             8,
+             "The iterations ahead to prefetch the strided reads of the inner loops on X86, 0 to disable the prefetch");
+DEFINE_int64(cinn_x86_l2_bytes,
+             1LL << 20,
+             "The bytes of the L2 cache of the X86 hosts, only the reads of the tensors larger than it are prefetched");
+DEFINE_int64(cinn_x86_llc_bytes,
+             32LL << 20,
+             "The bytes of the last level cache of the X86 hosts, the write-only outputs larger than it are stored by "
+             "the non-temporal stores, 0 to disable them");
+
+namespace cinn {
+namespace optim {
+
+namespace {
+
+constexpr int kCacheLineBytes       = 64;
+constexpr int kMaxPrefetchesPerLoop = 4;
+
+//! Get the bytes of a buffer, return 0 if its shape is not constant.
+int64_t GetBytes(const std::vector<Expr> &shape, const Type &type) {
+  int64_t bytes = type.bits() / 8;
+  for (auto &dim : shape) {
+    if (!dim.is_constant()) return 0;
+    bytes *= dim.as_int64();
+  }
+  return bytes;
+}
+
+//! Replace \p loop_var in \p index with \p loop_var + \p offset.
+Expr ShiftIndex(const Expr &index, const Var &loop_var, int offset) {
+  auto copied = IRCopy(index);
+  IrReplace(&copied, Expr(loop_var), Expr(loop_var) + offset);
+  Simplify(&copied);
+  return copied;
+}
+
+//! Get the stride of \p index between the consecutive iterations of \p loop_var, return false if it is not a constant.
+bool GetStride(const Expr &index, const Var &loop_var, int64_t *stride) {
+  Expr diff = ShiftIndex(index, loop_var, 1) - index;
+  Simplify(&diff);
+  if (!diff.is_constant()) return false;
+  *stride = static_cast<int64_t>(diff.get_constant());
+  return true;
+}
+
+//! Whether \p expr uses any of \p vars.
+bool UsesVars(const Expr &expr, const std::set<std::string> &vars) {
+  return !ir::CollectIRNodes(expr, [&](const Expr *x) {
+            return x->As<ir::_Var_>() && vars.count(x->As<ir::_Var_>()->name);
+          }).empty();
+}
+
+struct PrefetchMutator : public ir::IRMutator<Expr *> {
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::For *op, Expr *expr) override {
+    auto *node = expr->As<ir::For>();
+    ir::IRMutator<>::Visit(&node->body, &node->body);
+
+    int distance = FLAGS_cinn_x86_prefetch_distance;
+    if (distance <= 0 || node->is_parallel() || node->is_vectorized() || node->is_unrolled()) return;
+    if (!node->extent.is_constant() || node->extent.as_int32() <= distance) return;
+
+    std::set<std::string> written;
+    for (auto &store : ir::CollectIRNodes(node->body, [](const Expr *x) { return x->As<ir::Store>(); })) {
+      if (store.As<ir::Store>()->is_addr_tensor()) written.insert(common::BufferName(store.As<ir::Store>()->tensor));
+    }
+    auto inner_loops = ir::CollectIRNodes(node->body, [](const Expr *x) { return x->As<ir::For>(); });
+    std::vector<Expr> stmts;
+    PrefetchGatheredRows(node, inner_loops, written, distance, &stmts);
+    if (inner_loops.empty()) PrefetchStridedReads(node, written, distance, &stmts);
+    if (stmts.empty()) return;
+    stmts.push_back(node->body);
+    node->body = ir::Block::Make(stmts);
+  }
+
+  //! Whether the reads of \p load miss the caches, the accumulators are kept in the caches by the stores, and the small
+  //! tensors by the earlier reads.
+  static bool IsLargeInput(const ir::Load *load, const std::set<std::string> &written) {
+    if (written.count(common::BufferName(load->tensor))) return false;
+    auto *tensor = load->tensor.as_tensor();
+    auto &shape  = tensor->buffer.defined() ? tensor->buffer->shape : tensor->shape;
+    return GetBytes(shape, tensor->type()) > FLAGS_cinn_x86_l2_bytes;
+  }
+
+  //! Read \p ahead, and keep it in all the levels of the caches.
+  static Expr Prefetch(const Expr &ahead) {
+    return ir::intrinsics::BuiltinIntrin::Make(
+        kPrefetchIntrin, {ir::intrinsics::GetAddr::Make(ahead), Expr(0), Expr(3)}, -1, 3, Void());
+  }
+
+  void PrefetchStridedReads(const ir::For *node,
+                            const std::set<std::string> &written,
+                            int distance,
+                            std::vector<Expr> *stmts) {
+    auto loads = ir::CollectIRNodes(node->body, [](const Expr *x) {
+      return x->As<ir::Load>() && x->As<ir::Load>()->is_addr_tensor() && x->type().lanes() == 1;
+    });
+
+    std::unordered_set<Expr, ir::ExprStructuralHash, ir::ExprStructuralEqual> prefetched;
+    for (auto &load_expr : loads) {
+      auto *load = load_expr.As<ir::Load>();
+      if (!IsLargeInput(load, written)) continue;
+      // the hardware prefetcher follows the reads of the consecutive cache lines
+      int64_t stride;
+      if (!GetStride(load->index(), node->loop_var, &stride)) continue;
+      if (std::abs(stride) * load->type().bits() / 8 < kCacheLineBytes) continue;
+
+      std::vector<Expr> indices;
+      for (auto &index : load->indices) indices.push_back(ShiftIndex(index, node->loop_var, distance));
+      Expr ahead = ir::Load::Make(load->tensor, indices);
+      if (prefetched.count(ahead) || prefetched.size() >= kMaxPrefetchesPerLoop) continue;
+      prefetched.insert(ahead);
+      VLOG(3) << "prefetch " << ahead << " in the loop of " << node->loop_var;
+      stmts->push_back(Prefetch(ahead));
+    }
+  }
+
+  /**
+   * Prefetch the rows gathered by the indices read in the loop, e.g. the embeddings of the ids, which are neither
+   * strided nor followed by the hardware prefetcher. The index of the row \p distance iterations ahead is read at the
+   * last iteration at most, and the first cache lines of the row are prefetched.
+   */
+  void PrefetchGatheredRows(const ir::For *node,
+                            const std::set<Expr> &inner_loops,
+                            const std::set<std::string> &written,
+                            int distance,
+                            std::vector<Expr> *stmts) {
+    std::set<std::string> inner_vars;
+    // the elements of the row read by the inner loops, 0 if it is not a constant
+    int64_t row_size = 1;
+    for (auto &loop : inner_loops) {
+      auto *inner = loop.As<ir::For>();
+      inner_vars.insert(inner->loop_var->name);
+      row_size = inner->extent.is_constant() ? row_size * inner->extent.as_int64() : 0;
+    }
+    std::set<std::string> loop_var{node->loop_var->name};
+    // the ids of the rows are read by the loop, and the same in its inner loops
+    auto is_gathered = [&](const Expr &index) {
+      return !ir::CollectIRNodes(index, [&](const Expr *x) {
+                auto *ids = x->As<ir::Load>();
+                if (!ids) return false;
+                bool by_loop = false, by_inner = false;
+                for (auto &idx : ids->indices) {
+                  by_loop |= UsesVars(idx, loop_var);
+                  by_inner |= UsesVars(idx, inner_vars);
+                }
+                return by_loop && !by_inner;
+              }).empty();
+    };
+    auto loads = ir::CollectIRNodes(node->body, [&](const Expr *x) {
+      auto *load = x->As<ir::Load>();
+      if (!load || !load->is_addr_tensor() || load->indices.empty()) return false;
+      return std::any_of(load->indices.begin(), load->indices.end(), is_gathered);
+    });
+
+    Expr last = node->min + node->extent - 1;
+    Expr next = ir::Min::Make(Expr(node->loop_var) + distance, last);
+    int prefetches = 0;
+    std::unordered_set<Expr, ir::ExprStructuralHash, ir::ExprStructuralEqual> prefetched;
+    for (auto &load_expr : loads) {
+      auto *load = load_expr.As<ir::Load>();
+      if (!IsLargeInput(load, written)) continue;
+      std::vector<Expr> indices;
+      for (auto &index : load->indices) {
+        auto *ramp = index.As<ir::Ramp>();
+        Expr ahead = IRCopy(ramp ? ramp->base : index);
+        IrReplace(&ahead, Expr(node->loop_var), next);
+        for (auto &loop : inner_loops) {
+          IrReplace(&ahead, Expr(loop.As<ir::For>()->loop_var), loop.As<ir::For>()->min);
+        }
+        Simplify(&ahead);
+        indices.push_back(ahead);
+      }
+      if (prefetched.count(ir::Load::Make(load->tensor, indices))) continue;
+      prefetched.insert(ir::Load::Make(load->tensor, indices));
+
+      int elems_per_line = std::max(kCacheLineBytes * 8 / load->type().ElementOf().bits(), 1);
+      int64_t row_bytes  = row_size * load->type().lanes() * load->type().ElementOf().bits() / 8;
+      if (row_size == 0) row_bytes = kMaxPrefetchesPerLoop * kCacheLineBytes;
+      Expr offset = indices.back();
+      for (int64_t line = 0; line * kCacheLineBytes < row_bytes && prefetches < kMaxPrefetchesPerLoop; ++line) {
+        indices.back() = line == 0 ? offset : offset + static_cast<int>(line * elems_per_line);
+        Expr ahead     = ir::Load::Make(load->tensor, indices);
+        VLOG(3) << "prefetch the gathered row " << ahead << " in the loop of " << node->loop_var;
+        stmts->push_back(Prefetch(ahead));
+        prefetches++;
+      }
+    }
+  }
+};
+
+struct NontemporalStoreMutator : public ir::IRMutator<Expr *> {
+  explicit NontemporalStoreMutator(const std::set<std::string> &buffers) : buffers_(buffers) {}
+
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::For *op, Expr *expr) override {
+    auto *node = expr->As<ir::For>();
+    loop_depth_++;
+    ir::IRMutator<>::Visit(&node->body, &node->body);
+    loop_depth_--;
+    if (!HasNontemporalStore(node->body)) return;
+    // the non-temporal stores are weakly ordered, so they are fenced in the task of a parallel loop before it ends
+    if (node->is_parallel()) {
+      node->body = ir::Block::Make({node->body, StoreFence()});
+    } else if (loop_depth_ == 0) {
+      *expr = ir::Block::Make({*expr, StoreFence()});
+    }
+  }
+
+  void Visit(const ir::Store *op, Expr *expr) override {
+    ir::IRMutator<>::Visit(op, expr);
+    if (loop_depth_ == 0 || !op->is_addr_tensor() || !buffers_.count(common::BufferName(op->tensor))) return;
+    // only the scalar and the dense vector stores are addressed by their first element
+    Expr index = op->index();
+    if (op->type().lanes() > 1) {
+      auto *ramp = index.As<ir::Ramp>();
+      if (!ramp || !ramp->stride.is_constant() || ramp->stride.get_constant() != 1) return;
+    }
+    *expr = ir::intrinsics::BuiltinIntrin::Make(kNontemporalStoreIntrin, {*expr}, -1, 1, Void());
+  }
+
+  static Expr StoreFence() { return ir::intrinsics::BuiltinIntrin::Make(kStoreFenceIntrin, {}, -1, 0, Void()); }
+
+  static bool HasNontemporalStore(const Expr &expr) {
+    return !ir::CollectIRNodes(expr, [](const Expr *x) {
+              auto *intrin = x->As<ir::IntrinsicOp>();
+              if (!intrin) return false;
+              auto *builtin = llvm::dyn_cast<ir::intrinsics::BuiltinIntrin>(intrin);
+              return builtin && builtin->name == kNontemporalStoreIntrin;
+            }).empty();
+  }
+
+  const std::set<std::string> &buffers_;
+  int loop_depth_{0};
+};
+
+//! Collect the buffers of the outputs of \p func larger than the last level cache and never read in it.
+std::set<std::string> CollectStreamingOutputs(const ir::_LoweredFunc_ *func) {
+  std::set<std::string> res;
+  if (FLAGS_cinn_x86_llc_bytes <= 0) return res;
+  std::set<std::string> read;
+  for (auto &load : ir::CollectIRNodes(func->body, [](const Expr *x) { return x->As<ir::Load>(); })) {
+    if (load.As<ir::Load>()->is_addr_tensor()) read.insert(common::BufferName(load.As<ir::Load>()->tensor));
+  }
+  for (auto &arg : func->args) {
+    if (!arg.is_output() || !arg.is_buffer()) continue;
+    auto buffer   = arg.buffer_arg();
+    int64_t bytes = GetBytes(buffer->shape, buffer->dtype);
+    if (bytes > FLAGS_cinn_x86_llc_bytes && !read.count(buffer->name)) {
+      VLOG(3) << "store " << buffer->name << " of " << bytes << " bytes by the non-temporal stores";
+      res.insert(buffer->name);
+    }
+  }
+  return res;
+}
+
+}  // namespace
+
+void InsertCacheHints(Expr *expr, Target target) {
+  if (target.arch != Target::Arch::X86) return;
+  PrefetchMutator()(expr);
+  if (auto *func = expr->as_lowered_func()) {
+    auto buffers = CollectStreamingOutputs(func);
+    if (buffers.empty()) return;
+    NontemporalStoreMutator mutator(buffers);
+    mutator(&func->body);
+  }
+}
+
+}  // namespace optim
+}  // namespace cinn
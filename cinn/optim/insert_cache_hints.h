@@ -0,0 +1,70 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <gflags/gflags.h>
+
+#include "cinn/common/target.h"
+#include "cinn/ir/ir.h"
+
+DECLARE_int32(cinn_x86_prefetch_distance);
+DECLARE_int64(cinn_x86_l2_bytes);
+DECLARE_int64(cinn_x86_llc_bytes);
+
+namespace cinn {
+namespace optim {
+
+//! The names of the cache hint intrinsics, printed as they are in C.
+static const char* kPrefetchIntrin         = "__builtin_prefetch";
+static const char* kNontemporalStoreIntrin = "nontemporal_store";
+static const char* kStoreFenceIntrin       = "_mm_sfence";
+
+/**
+ * Insert the cache hints of the X86 CPU into the loops of a function.
+ *
+ * 1. The strided reads of the innermost serial loops, whose iterations read different cache lines of the tensors larger
+ * than FLAGS_cinn_x86_l2_bytes, are prefetched FLAGS_cinn_x86_prefetch_distance iterations ahead, e.g.
+ *
+ * for (j, 0, 1024)
+ *   B[i * 1024 + j] = A[j * 1024 + i]
+ *
+ * to
+ *
+ * for (j, 0, 1024)
+ *   __builtin_prefetch(&(A[(j + 8) * 1024 + i]), 0, 3)
+ *   B[i * 1024 + j] = A[j * 1024 + i]
+ *
+ * 2. The rows gathered by the indices read in the serial loops, e.g. the embeddings of pe::LookupTable, are prefetched
+ * from the index FLAGS_cinn_x86_prefetch_distance iterations ahead, e.g.
+ *
+ * for (i, 0, 1024)
+ *   for (j, 0, 16)
+ *     B[i, j * 8 : j * 8 + 8] = A[ids[i], j * 8 : j * 8 + 8]
+ *
+ * to
+ *
+ * for (i, 0, 1024)
+ *   __builtin_prefetch(&(A[ids[min(i + 8, 1023)], 0]), 0, 3)
+ *   ...
+ *   __builtin_prefetch(&(A[ids[min(i + 8, 1023)], 48]), 0, 3)
+ *   for (j, 0, 16)
+ *     B[i, j * 8 : j * 8 + 8] = A[ids[i], j * 8 : j * 8 + 8]
+ *
+ * 3. The write-only outputs larger than FLAGS_cinn_x86_llc_bytes are stored by the non-temporal stores, which bypass
+ * the caches, and a store fence follows the loops writing them.
+ */
+void InsertCacheHints(Expr* expr, Target target);
+
+}  // namespace optim
+}  // namespace cinn
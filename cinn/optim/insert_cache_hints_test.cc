@@ -0,0 +1,80 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/insert_cache_hints.h"
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "cinn/backends/llvm/execution_engine.h"
+#include "cinn/cinn.h"
+#include "cinn/common/test_helper.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/utils/string.h"
+
+namespace cinn::optim {
+
+// B = transpose(A), whose inner loop reads A by the stride of a row
+ir::LoweredFunc LowerTranspose(int m, int n, Module::Builder *builder = nullptr) {
+  Placeholder<float> A("A", {Expr(m), Expr(n)});
+  auto B = Compute(
+      {Expr(n), Expr(m)}, [&](Var i, Var j) { return A(j, i); }, "B");
+  auto stages = CreateStages({B});
+  return Lower("fn", stages, {A, B}, {}, {}, builder, common::DefaultHostTarget());
+}
+
+TEST(InsertCacheHints, prefetch_strided_reads) {
+  auto func = LowerTranspose(1024, 512);
+  LOG(INFO) << func;
+  auto code = utils::GetStreamCnt(func);
+  EXPECT_NE(code.find(kPrefetchIntrin), std::string::npos);
+  // the output is much smaller than the last level cache
+  EXPECT_EQ(code.find(kNontemporalStoreIntrin), std::string::npos);
+}
+
+TEST(InsertCacheHints, nontemporal_stores) {
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  FLAGS_cinn_x86_llc_bytes = 1 << 20;
+
+  Module::Builder builder("module0", common::DefaultHostTarget());
+  auto func = LowerTranspose(1024, 512, &builder);
+  LOG(INFO) << func;
+  auto code = utils::GetStreamCnt(func);
+  EXPECT_NE(code.find(kNontemporalStoreIntrin), std::string::npos);
+  EXPECT_NE(code.find(kStoreFenceIntrin), std::string::npos);
+
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn = jit->Lookup("fn");
+  CHECK(fn);
+  auto fn_ = reinterpret_cast<void (*)(void *, int32_t)>(fn);
+
+  cinn_buffer_t *A_buf = common::BufferBuilder(Float(32), {1024, 512}).set_random().Build();
+  cinn_buffer_t *B_buf = common::BufferBuilder(Float(32), {512, 1024}).set_zero().Build();
+  cinn_pod_value_t a_arg(A_buf), b_arg(B_buf);
+  std::vector<cinn_pod_value_t> args = {a_arg, b_arg};
+  fn_(reinterpret_cast<void **>(args.data()), args.size());
+
+  auto *ad = reinterpret_cast<float *>(A_buf->memory);
+  auto *bd = reinterpret_cast<float *>(B_buf->memory);
+  for (int i = 0; i < 512; i++) {
+    for (int j = 0; j < 1024; j++) {
+      ASSERT_EQ(bd[i * 1024 + j], ad[j * 512 + i]);
+    }
+  }
+}
+
+}  // namespace cinn::optim
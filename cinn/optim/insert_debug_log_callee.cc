@@ -127,6 +127,8 @@ struct StoreDebugInfoBuilder : public ir::IRVisitor {
 };
 
 struct InsertDebugLogCalleeMutator : public ir::IRMutator<> {
+  explicit InsertDebugLogCalleeMutator(const DebugLogSampling &sampling) : sampling_(sampling) {}
+
   void operator()(Expr *e) { ir::IRMutator<>::Visit(e, e); }
 
   void Visit(const ir::_LoweredFunc_ *op, Expr *expr) {
@@ -161,6 +163,15 @@ struct InsertDebugLogCalleeMutator : public ir::IRMutator<> {
     auto *node = expr->As<ir::Block>();
     std::vector<Expr> new_stmts;
     for (auto &e : op->stmts) {
+      if (sampling_.enabled()) {
+        ir::IRMutator<>::Visit(&e, &Reference(&e));
+        new_stmts.push_back(e);
+        if (!IsDebugInfoNode(e) && e.As<ir::Store>()) {
+          auto sampled = SampledStoreDebugStatement(e);
+          if (sampled.defined()) new_stmts.push_back(sampled);
+        }
+        continue;
+      }
       if (!IsDebugInfoNode(e)) {
         std::string msg;
         if (!e.As<ir::Store>()) {
@@ -257,6 +268,22 @@ struct InsertDebugLogCalleeMutator : public ir::IRMutator<> {
     return std::make_tuple(format_ss.str(), val_reprs);
   }
 
+  // Print the store \p e only at the offsets the sampling selects, the vectorized stores are skipped.
+  Expr SampledStoreDebugStatement(const Expr &e) {
+    auto offset = e.As<ir::Store>()->index();
+    if (offset.type().lanes() > 1) return Expr();
+    Expr cond;
+    if (sampling_.first_n > 0) cond = ir::LT::Make(offset, Expr(sampling_.first_n));
+    if (sampling_.every_k > 1) {
+      Expr sampled = ir::EQ::Make(ir::Mod::Make(offset, Expr(sampling_.every_k)), Expr(0));
+      cond         = cond.defined() ? ir::Or::Make(cond, sampled) : sampled;
+    }
+    auto _msg_args_ = StoreDebugInfo(e);
+    auto &msg       = std::get<0>(_msg_args_);
+    auto &args      = std::get<1>(_msg_args_);
+    return ir::IfThenElse::Make(cond, ir::Block::Make({CreateDebugStatement(msg, std::move(args))}));
+  }
+
   inline bool IsDebugInfoNode(const Expr &e) {
     return e.As<ir::Call>() && e.As<ir::Call>()->name == runtime::intrinsic::debug_log_repr;
   }
@@ -266,11 +293,17 @@ struct InsertDebugLogCalleeMutator : public ir::IRMutator<> {
     return ir::Call::Make(
         Void(), runtime::intrinsic::debug_log_repr, args, {}, ir::CallType ::Intrinsic, ir::FunctionRef(), 0);
   }
+
+ private:
+  DebugLogSampling sampling_;
 };
 
 }  // namespace
 
-void InsertDebugLogCallee(Expr *e) { InsertDebugLogCalleeMutator()(e); }
+void InsertDebugLogCallee(Expr *e, const DebugLogSampling &sampling) {
+  InsertDebugLogCalleeMutator mutator(sampling);
+  mutator(e);
+}
 
 }  // namespace optim
 }  // namespace cinn
@@ -21,7 +21,20 @@
 namespace cinn {
 namespace optim {
 
-void InsertDebugLogCallee(Expr* e);
+/**
+ * Which stores the debug log prints, all of them by default. With either field set, only the elements at the offsets
+ * below \p first_n or the multiples of \p every_k of each stored tensor are printed, and the statements other than the
+ * stores are not, so that the kernels run at a fraction of the full logging overhead.
+ */
+struct DebugLogSampling {
+  int first_n{0};
+  int every_k{1};
+
+  bool enabled() const { return first_n > 0 || every_k > 1; }
+};
+
+//! Insert the calls printing the statements and the stored values at runtime into the function \p e.
+void InsertDebugLogCallee(Expr* e, const DebugLogSampling& sampling = DebugLogSampling());
 
 }  // namespace optim
 }  // namespace cinn
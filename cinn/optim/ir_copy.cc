@@ -83,6 +83,7 @@ struct IRCopyVisitor : public ir::IRVisitorBase<Expr> {
 
     n->name           = op->name;
     n->is_reduce_axis = op->is_reduce_axis;
+    n->divisor        = op->divisor;
     n->set_type(op->type());
 
     if (n->is_reduce_axis) {
@@ -190,7 +191,9 @@ struct IRCopyVisitor : public ir::IRVisitorBase<Expr> {
     auto min    = Visit(&op->min);
     auto body   = Visit(&op->body);
 
-    return ir::For::Make(op->loop_var, min, extent, op->for_type(), op->device_api, body, op->vectorize_info());
+    auto expr = ir::For::Make(op->loop_var, min, extent, op->for_type(), op->device_api, body, op->vectorize_info());
+    expr.As<ir::For>()->set_pipeline_stages(op->pipeline_stages());
+    return expr;
   }
 
   Expr Visit(const ir::PolyFor* op) override {
@@ -200,6 +203,7 @@ struct IRCopyVisitor : public ir::IRVisitorBase<Expr> {
     auto body      = Visit(&op->body);
     auto expr =
         PolyFor::Make(op->iterator, init, condition, inc, op->for_type(), op->device_api, body, op->vectorize_info());
+    expr.As<ir::PolyFor>()->set_pipeline_stages(op->pipeline_stages());
     return expr;
   }
 
@@ -407,6 +411,55 @@ Expr IRCopyVisitor::Visit(const ir::intrinsics::ArgsConstruct* op) {
 Expr IRCopyVisitor::Visit(const ir::intrinsics::BuiltinIntrin* op) {
   return intrinsics::BuiltinIntrin::Make(op->name, op->args, op->id, op->arg_nums, op->type());
 }
+Expr IRCopyVisitor::Visit(const ir::intrinsics::DotProduct4* op) {
+  llvm::SmallVector<Expr, 4> a, b;
+  for (auto& x : op->a) a.push_back(Visit(&x));
+  for (auto& x : op->b) b.push_back(Visit(&x));
+  return intrinsics::DotProduct4::Make(Visit(&op->acc), a, b);
+}
+
+/**
+ * Walk down the nodes exclusively owned by the root, and replace the first shared node on each path with its deep copy.
+ * The tensors, buffers and intrinsics are always copied by the IRCopyVisitor to unify the copied tensors and buffers.
+ */
+struct IRCopyOnWriteMutator : public ir::IRMutator<Expr*> {
+  void operator()(Expr* expr) { IRMutator::Visit(expr, expr); }
+
+ private:
+#define __(op__)                                    \
+  void Visit(const op__* expr, Expr* op) override { \
+    if (MustCopy(op)) {                             \
+      *op = copier.Visit(op);                       \
+      return;                                       \
+    }                                               \
+    VisitChildren(expr, op);                        \
+  }
+  NODETY_FORALL(__)
+#undef __
+
+  bool MustCopy(const Expr* op) {
+    return common::ref_count(op->ptr()).val() > 1 || op->As<_Tensor_>() || op->As<_Buffer_>() || op->As<Alloc>() ||
+           op->As<IntrinsicOp>();
+  }
+
+  template <typename T>
+  void VisitChildren(const T* expr, Expr* op) {
+    IRMutator::Visit(expr, op);
+  }
+
+  void VisitChildren(const _LoweredFunc_* expr, Expr* op) {
+    IRMutator::Visit(expr, op);
+    auto* node = op->As<_LoweredFunc_>();
+    for (auto* field : {&node->alloc_output_buffer_exprs,
+                        &node->dealloc_output_buffer_exprs,
+                        &node->buffer_data_cast_exprs,
+                        &node->argument_prepare_exprs}) {
+      for (auto& e : *field) IRMutator::Visit(&e, &e);
+    }
+  }
+
+  IRCopyVisitor copier;
+};
 
 Expr IRCopy(Expr x) {
   IRCopyVisitor visitor;
@@ -414,6 +467,11 @@ Expr IRCopy(Expr x) {
   return copied;
 }
 
+Expr IRCopyOnWrite(Expr x) {
+  IRCopyOnWriteMutator()(&x);
+  return x;
+}
+
 std::vector<Expr> IRCopy(const std::vector<Expr>& x) {
   std::vector<Expr> res;
   for (auto& i : x) {
@@ -25,5 +25,12 @@ Expr IRCopy(Expr x);
 
 std::vector<Expr> IRCopy(const std::vector<Expr>& x);
 
+/**
+ * Copy an expression on write, only the nodes shared with the other owners are deep copied, and the nodes exclusively
+ * owned by \p x are reused, so that the later IRMutators can mutate the result in place without affecting the others.
+ * It is as cheap as no copy when the caller passes in the only reference of a freshly built expression by std::move.
+ */
+Expr IRCopyOnWrite(Expr x);
+
 }  // namespace optim
 }  // namespace cinn
@@ -16,7 +16,9 @@
 
 #include <gtest/gtest.h>
 
+#include "cinn/ir/ir_operators.h"
 #include "cinn/ir/ir_printer.h"
+#include "cinn/utils/string.h"
 
 namespace cinn {
 namespace optim {
@@ -27,5 +29,23 @@ TEST(IrCopy, basic) {
   LOG(INFO) << "aa " << aa;
 }
 
+TEST(IrCopy, copy_on_write) {
+  Var i("i");
+  Expr shared = i + 1;
+  Expr a      = ir::Mul::Make(shared, Expr(2));
+
+  // the root exclusively owned is reused, and the shared child is copied.
+  auto* root  = a.ptr();
+  auto copied = IRCopyOnWrite(std::move(a));
+  EXPECT_EQ(copied.ptr(), root);
+  EXPECT_NE(copied.As<ir::Mul>()->a().ptr(), shared.ptr());
+  EXPECT_EQ(utils::GetStreamCnt(copied.As<ir::Mul>()->a()), utils::GetStreamCnt(shared));
+
+  // all the nodes are copied when the root is still held by the caller.
+  auto copied1 = IRCopyOnWrite(copied);
+  EXPECT_NE(copied1.ptr(), copied.ptr());
+  EXPECT_EQ(utils::GetStreamCnt(copied1), utils::GetStreamCnt(copied));
+}
+
 }  // namespace optim
 }  // namespace cinn
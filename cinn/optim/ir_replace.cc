@@ -16,6 +16,7 @@
 
 #include <set>
 
+#include "cinn/ir/ir_hash.h"
 #include "cinn/ir/ir_mutator.h"
 #include "cinn/ir/ir_printer.h"
 #include "cinn/optim/ir_copy.h"
@@ -23,32 +24,30 @@
 
 namespace cinn {
 namespace optim {
-using utils::GetStreamCnt;
 
 namespace {
 
 struct IrReplaceMutator : ir::IRMutator<Expr*> {
   std::set<ir::IrNodeTy> valid_nodetys{{ir::IrNodeTy::Broadcast, ir::IrNodeTy::_Var_}};
 
-  IrReplaceMutator(ir::Expr from, Expr to) : from_(from), to_(to), from_repr_(GetStreamCnt(from)) {
+  IrReplaceMutator(ir::Expr from, Expr to) : from_(from), to_(to) {
     CHECK(valid_nodetys.count(from->node_type())) << "Not valid node type got " << from->node_type();
   }
   void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
 
  private:
   void Visit(const ir::_Var_* op, Expr* expr) override {
-    if (op->node_type() == from_->node_type() && from_repr_ == GetStreamCnt(*expr)) {
+    if (op->node_type() == from_->node_type() && ir::StructuralEqual(from_, *expr)) {
       *expr = optim::IRCopy(to_);
     }
   }
 
   void Visit(const ir::Broadcast* op, Expr* expr) override {
-    if (op->node_type() == from_->node_type() && from_repr_ == GetStreamCnt(*expr)) {
+    if (op->node_type() == from_->node_type() && ir::StructuralEqual(from_, *expr)) {
       *expr = optim::IRCopy(to_);
     }
   }
 
-  std::string from_repr_;
   ir::Expr from_;
   Expr to_;
 };
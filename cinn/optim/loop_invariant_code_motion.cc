@@ -0,0 +1,179 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/loop_invariant_code_motion.h"
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cinn/common/ir_util.h"
+#include "cinn/ir/collect_ir_nodes.h"
+#include "cinn/ir/ir_hash.h"
+#include "cinn/ir/ir_mutator.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/utils/string.h"
+
+namespace cinn {
+namespace optim {
+
+namespace {
+
+bool IsGlobalLoad(const Expr &expr) {
+  auto *load = expr.As<ir::Load>();
+  if (!load || !load->is_addr_tensor()) return false;
+  auto *tensor = load->tensor.as_tensor();
+  return tensor->buffer.defined() && tensor->buffer->memory_type == ir::MemoryType::Heap;
+}
+
+//! Replace the invariant expressions of the body of a loop with the temporary variables.
+struct HoistMutator : public ir::IRMutator<Expr *> {
+  HoistMutator(const std::set<std::string> &variant_vars, const std::set<std::string> &written)
+      : variant_vars_(variant_vars), written_(written) {}
+
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+  //! The Let nodes defining the temporary variables, in the order of their first uses.
+  std::vector<Expr> lets;
+
+ private:
+#define __(op__)                                         \
+  void Visit(const ir::op__ *op, Expr *expr) override { \
+    if (!Hoist(expr)) ir::IRMutator<>::Visit(op, expr); \
+  }
+  NODETY_OP_FOR_EACH(__)
+  __(Cast)
+  __(Load)
+#undef __
+
+  void Visit(const ir::Select *op, Expr *expr) override {
+    if (Hoist(expr)) return;
+    auto *node = expr->As<ir::Select>();
+    ir::IRMutator<>::Visit(&node->condition, &node->condition);
+    conditional_depth_++;
+    ir::IRMutator<>::Visit(&node->true_value, &node->true_value);
+    ir::IRMutator<>::Visit(&node->false_value, &node->false_value);
+    conditional_depth_--;
+  }
+
+  void Visit(const ir::IfThenElse *op, Expr *expr) override {
+    auto *node = expr->As<ir::IfThenElse>();
+    ir::IRMutator<>::Visit(&node->condition, &node->condition);
+    conditional_depth_++;
+    ir::IRMutator<>::Visit(&node->true_case, &node->true_case);
+    if (node->false_case.defined()) ir::IRMutator<>::Visit(&node->false_case, &node->false_case);
+    conditional_depth_--;
+  }
+
+  void Visit(const ir::Let *op, Expr *expr) override {
+    auto *node = expr->As<ir::Let>();
+    if (node->body.defined()) ir::IRMutator<>::Visit(&node->body, &node->body);
+  }
+
+  // the intrinsics take the addresses of the buffers
+  void Visit(const ir::IntrinsicOp *op, Expr *expr) override {}
+
+  bool IsInvariant(const Expr &expr) const {
+    if (!expr.type().valid() || expr.type().is_void() || expr.type().is_cpp_handle() || expr.type().lanes() != 1) {
+      return false;
+    }
+    bool reads_global = false;
+    auto variants     = ir::CollectIRNodes(expr, [&](const Expr *x) {
+      if (auto *var = x->As<ir::_Var_>()) return variant_vars_.count(var->name) > 0;
+      if (auto *load = x->As<ir::Load>()) {
+        if (!load->is_addr_tensor() || load->type().lanes() != 1) return true;
+        if (written_.count(common::BufferName(load->tensor))) return true;
+        reads_global |= IsGlobalLoad(*x);
+        return false;
+      }
+      return x->As<ir::Call>() || x->As<ir::IntrinsicOp>() || x->As<ir::Ramp>() || x->As<ir::Broadcast>() ||
+             x->As<ir::Let>() || x->As<ir::Reduce>();
+    });
+    return variants.empty() && reads_global;
+  }
+
+  bool Hoist(Expr *expr) {
+    if (conditional_depth_ > 0 || !IsInvariant(*expr)) return false;
+    auto it = hoisted_.find(*expr);
+    if (it == hoisted_.end()) {
+      Var tmp(Context::Global().NewName("licm"), expr->type());
+      lets.push_back(ir::Let::Make(tmp, *expr));
+      it = hoisted_.emplace(*expr, tmp).first;
+    }
+    *expr = Expr(it->second);
+    return true;
+  }
+
+  const std::set<std::string> &variant_vars_;
+  const std::set<std::string> &written_;
+  std::unordered_map<Expr, Var, ir::ExprStructuralHash, ir::ExprStructuralEqual> hoisted_;
+  int conditional_depth_{0};
+};
+
+struct LoopInvariantCodeMotionMutator : public ir::IRMutator<Expr *> {
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::For *op, Expr *expr) override {
+    auto *node = expr->As<ir::For>();
+    ir::IRMutator<>::Visit(&node->body, &node->body);
+
+    if (node->is_parallel() || node->is_vectorized()) return;
+    // the hoisted expressions are evaluated even if the loop has no iteration
+    if (!node->min.is_constant() || !node->extent.is_constant() || node->extent.as_int64() <= node->min.as_int64()) {
+      return;
+    }
+    if (!ir::CollectIRNodes(node->body, [](const Expr *x) { return x->As<ir::For>() || x->As<ir::PolyFor>(); })
+             .empty()) {
+      return;
+    }
+
+    std::set<std::string> variant_vars({node->loop_var->name});
+    for (auto &let : ir::CollectIRNodes(node->body, [](const Expr *x) { return x->As<ir::Let>(); })) {
+      auto *var = let.As<ir::Let>()->symbol.As<ir::_Var_>();
+      if (var) variant_vars.insert(var->name);
+    }
+    std::set<std::string> written;
+    for (auto &store : ir::CollectIRNodes(node->body, [](const Expr *x) { return x->As<ir::Store>(); })) {
+      written.insert(common::BufferName(store.As<ir::Store>()->tensor));
+    }
+    // the calls may write any buffer they take the address of
+    auto writing_calls = ir::CollectIRNodes(node->body, [](const Expr *x) {
+      auto *call = x->As<ir::Call>();
+      if (!call) return false;
+      if (!call->write_args.empty()) return true;
+      for (auto &arg : call->read_args) {
+        if (arg.as_tensor() || arg.as_buffer() || arg.type().is_cpp_handle()) return true;
+      }
+      return false;
+    });
+    if (!writing_calls.empty()) return;
+
+    HoistMutator hoist(variant_vars, written);
+    hoist(&node->body);
+    if (hoist.lets.empty()) return;
+    VLOG(3) << "hoist " << hoist.lets.size() << " invariant expressions out of the loop of " << node->loop_var;
+    auto stmts = hoist.lets;
+    stmts.push_back(*expr);
+    *expr = ir::Block::Make(stmts);
+  }
+};
+
+}  // namespace
+
+void LoopInvariantCodeMotion(Expr *expr) { LoopInvariantCodeMotionMutator()(expr); }
+
+}  // namespace optim
+}  // namespace cinn
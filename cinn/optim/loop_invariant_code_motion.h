@@ -0,0 +1,41 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "cinn/ir/ir.h"
+
+namespace cinn {
+namespace optim {
+
+/**
+ * Hoist the loop-invariant expressions reading the global buffers out of the innermost serial loops, e.g.
+ *
+ * for (j, 0, 1024)
+ *   C[i * 1024 + j] = A[i * 1024 + j] * (S[i] + 1)
+ *
+ * to
+ *
+ * float licm_0 = S[i] + 1
+ * for (j, 0, 1024)
+ *   C[i * 1024 + j] = A[i * 1024 + j] * licm_0
+ *
+ * The expressions are hoisted by the Let nodes, which both the C and the LLVM codegen emit as the scalar locals. The
+ * compilers keep the invariant arithmetics out of the loops themselves, but not the reads of the buffers, which may be
+ * aliased by the stores of the loops. An expression is hoisted only if all the buffers it reads are not written in the
+ * loop, and it is evaluated in every iteration, that is, not in the branches of the IfThenElse or the Select.
+ */
+void LoopInvariantCodeMotion(Expr* expr);
+
+}  // namespace optim
+}  // namespace cinn
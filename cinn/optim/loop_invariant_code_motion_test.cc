@@ -0,0 +1,83 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/loop_invariant_code_motion.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "cinn/backends/llvm/execution_engine.h"
+#include "cinn/cinn.h"
+#include "cinn/common/test_helper.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/utils/string.h"
+
+namespace cinn::optim {
+
+TEST(LoopInvariantCodeMotion, hoist_global_loads) {
+  const int M = 64, N = 128;
+  Placeholder<float> A("A", {Expr(M), Expr(N)});
+  Placeholder<float> S("S", {Expr(M)});
+  auto C = Compute(
+      {Expr(M), Expr(N)}, [&](Var i, Var j) { return A(i, j) * (S(i) + 1.f); }, "C");
+  auto stages = CreateStages({C});
+
+  Module::Builder builder("module0", common::DefaultHostTarget());
+  auto func = Lower("fn", stages, {A, S, C}, {}, {}, &builder, common::DefaultHostTarget());
+  LOG(INFO) << func;
+  auto code = utils::GetStreamCnt(func);
+  // S[i] + 1 is computed once a row
+  EXPECT_NE(code.find("licm"), std::string::npos);
+  EXPECT_EQ(code.find("S[i] + 1"), code.rfind("S[i] + 1"));
+
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder.Build());
+  auto fn = jit->Lookup("fn");
+  CHECK(fn);
+  auto fn_ = reinterpret_cast<void (*)(void *, int32_t)>(fn);
+
+  cinn_buffer_t *A_buf = common::BufferBuilder(Float(32), {M, N}).set_random().Build();
+  cinn_buffer_t *S_buf = common::BufferBuilder(Float(32), {M}).set_random().Build();
+  cinn_buffer_t *C_buf = common::BufferBuilder(Float(32), {M, N}).set_zero().Build();
+  cinn_pod_value_t a_arg(A_buf), s_arg(S_buf), c_arg(C_buf);
+  std::vector<cinn_pod_value_t> args = {a_arg, s_arg, c_arg};
+  fn_(reinterpret_cast<void **>(args.data()), args.size());
+
+  auto *ad = reinterpret_cast<float *>(A_buf->memory);
+  auto *sd = reinterpret_cast<float *>(S_buf->memory);
+  auto *cd = reinterpret_cast<float *>(C_buf->memory);
+  for (int i = 0; i < M; i++) {
+    for (int j = 0; j < N; j++) {
+      ASSERT_FLOAT_EQ(cd[i * N + j], ad[i * N + j] * (sd[i] + 1.f));
+    }
+  }
+}
+
+// the loads of the accumulator C are not hoisted out of the reduction loop writing it
+TEST(LoopInvariantCodeMotion, keep_written_loads) {
+  Expr M(32), N(32), K(16);
+  Placeholder<float> A("A", {M, K});
+  Placeholder<float> B("B", {K, N});
+  Var k(K.as_int32(), "k0");
+  auto C = Compute(
+      {M, N}, [&](Var i, Var j) { return ReduceSum(A(i, k) * B(k, j), {k}); }, "C");
+  auto stages = CreateStages({C});
+
+  auto func = Lower("fn", stages, {A, B, C}, {}, {}, nullptr, common::DefaultHostTarget());
+  LOG(INFO) << func;
+  EXPECT_EQ(utils::GetStreamCnt(func).find("licm"), std::string::npos);
+}
+
+}  // namespace cinn::optim
@@ -14,27 +14,185 @@
 
 #include "cinn/optim/lower_intrin.h"
 
+#include <limits>
 #include <string>
+#include <vector>
 
 #include "cinn/backends/llvm/llvm_intrin_rule.h"
 #include "cinn/cinn.h"
+#include "cinn/common/ir_util.h"
+#include "cinn/common/precision.h"
 #include "cinn/ir/intrinsic_ops.h"
 #include "cinn/ir/ir_mutator.h"
 #include "cinn/ir/registry.h"
+#include "cinn/lang/builtin.h"
+
+DEFINE_int32(cinn_cpu_vector_math_max_ulp,
+             8,
+             "The max ULP error allowed for the polynomials computing the exp, log and tanh of the float32 vectors on "
+             "CPU, a larger one selects the lower degree exp, 0 to call the scalar libm functions instead");
 
 namespace cinn {
 namespace optim {
 
+namespace {
+
+// The max errors of the polynomials over all the float32 inputs, the results flush to zero when they are subnormal.
+constexpr int kExpUlp     = 1;
+constexpr int kFastExpUlp = 700;
+constexpr int kLogUlp     = 1;
+constexpr int kTanhUlp    = 5;
+
+Expr Const(const Expr &x, double value) { return common::make_const(x->type(), value); }
+
+Expr IntConst(const Expr &x, int64_t value) { return common::make_const(Int(32, x->type().lanes()), value); }
+
+Expr Reinterpret(const Expr &x, Type type) {
+  return ir::intrinsics::BuiltinIntrin::Make(kReinterpretIntrin, {x}, -1, 1, type);
+}
+
+//! The ordered comparisons are false for NaN, and the isnan call is not vectorizable.
+Expr IsNan(const Expr &x) { return !ir::EQ::Make(x, x); }
+
+Expr BitwiseOp(const std::string &name, const Expr &a, const Expr &b) {
+  return ir::Call::Make(a->type(), name, {a, b}, {}, ir::CallType::Intrinsic);
+}
+
+//! The polynomial coeffs[0] * x^(n-1) + ... + coeffs[n-1] by Horner's scheme, each step of which is lowered to a fma.
+Expr Polynomial(const Expr &x, const std::vector<double> &coeffs) {
+  Expr p = Const(x, coeffs[0]);
+  for (size_t i = 1; i < coeffs.size(); i++) {
+    p = p * x + Const(x, coeffs[i]);
+  }
+  return p;
+}
+
+//! exp(x) = 2^n * exp(r) of n = round(x / ln2), where ln2 is split into two parts, so that r = x - n * ln2 is exact.
+Expr VectorExp(const Expr &x, bool fast) {
+  const double max_x = 88.3762626647949;
+  const double min_x = -87.3365447504019;
+
+  Expr xc = ir::Min::Make(ir::Max::Make(x, Const(x, min_x)), Const(x, max_x));
+  Expr n  = lang::Floor(xc * Const(x, 1.44269504088896341) + Const(x, 0.5));
+  Expr r  = n * Const(x, -0.693359375) + xc;
+  r       = n * Const(x, 2.12194440e-4) + r;
+
+  // the Taylor series of the fast one, otherwise the minimax one of Cephes
+  Expr p = fast ? Polynomial(r, {1. / 24, 1. / 6, 0.5})
+                : Polynomial(r, {1.9875691500e-4, 1.3981999507e-3, 8.3334519073e-3, 4.1665795894e-2, 1.6666665459e-1,
+                                 5.0000001201e-1});
+  p      = p * (r * r) + r + Const(x, 1);
+
+  Expr exponent = ir::Cast::Make(Int(32, x->type().lanes()), n) + IntConst(x, 127);
+  Expr y        = p * Reinterpret(BitwiseOp("left_shift", exponent, IntConst(x, 23)), x->type());
+  y             = ir::Select::Make(x < Const(x, min_x), Const(x, 0), y);
+  y             = ir::Select::Make(x > Const(x, max_x), Const(x, std::numeric_limits<double>::infinity()), y);
+  return ir::Select::Make(IsNan(x), x, y);
+}
+
+//! log(x) = e * ln2 + log(m) of x = m * 2^e and sqrt(0.5) <= m < sqrt(2), the subnormals are scaled by 2^23 first.
+Expr VectorLog(const Expr &x) {
+  Type int_type = Int(32, x->type().lanes());
+
+  Expr subnormal = x < Const(x, std::numeric_limits<float>::min());
+  Expr xs        = ir::Select::Make(subnormal, x * Const(x, 8388608.0), x);
+  Expr bits      = Reinterpret(xs, int_type);
+  Expr exponent  = BitwiseOp("right_shift", bits, IntConst(x, 23)) - IntConst(x, 126);
+  Expr e         = ir::Cast::Make(x->type(), exponent) + ir::Select::Make(subnormal, Const(x, -23), Const(x, 0));
+  // the mantissa in [0.5, 1), the exponent bits of which are replaced by those of 0.5
+  Expr mantissa = BitwiseOp("bitwise_and", bits, IntConst(x, ~0x7f800000));
+  Expr m        = Reinterpret(BitwiseOp("bitwise_or", mantissa, IntConst(x, 0x3f000000)), x->type());
+
+  Expr lt = m < Const(x, 0.707106781186547524);
+  e       = ir::Select::Make(lt, e - Const(x, 1), e);
+  Expr t  = ir::Select::Make(lt, m + m - Const(x, 1), m - Const(x, 1));
+  Expr z  = t * t;
+
+  Expr p = Polynomial(t,
+                      {7.0376836292e-2,
+                       -1.1514610310e-1,
+                       1.1676998740e-1,
+                       -1.2420140846e-1,
+                       1.4249322787e-1,
+                       -1.6668057665e-1,
+                       2.0000714765e-1,
+                       -2.4999993993e-1,
+                       3.3333331174e-1});
+  Expr y = t * z * p;
+  y      = e * Const(x, -2.12194440e-4) + y;
+  y      = z * Const(x, -0.5) + y;
+  y      = e * Const(x, 0.693359375) + (t + y);
+
+  y = ir::Select::Make(ir::EQ::Make(x, Const(x, std::numeric_limits<double>::infinity())), x, y);
+  y = ir::Select::Make(ir::EQ::Make(x, Const(x, 0)), Const(x, -std::numeric_limits<double>::infinity()), y);
+  return ir::Select::Make(x < Const(x, 0) || IsNan(x), Const(x, std::numeric_limits<double>::quiet_NaN()), y);
+}
+
+//! The rational approximation of Eigen, tanh(x) rounds to +-1 out of [-7.9, 7.9] and to x in (-0.0004, 0.0004).
+Expr VectorTanh(const Expr &x) {
+  const double max_x = 7.90531110763549805;
+
+  Expr xc = ir::Min::Make(ir::Max::Make(x, Const(x, -max_x)), Const(x, max_x));
+  Expr x2 = xc * xc;
+  Expr p  = Polynomial(x2,
+                      {-2.76076847742355e-16,
+                       2.00018790482477e-13,
+                       -8.60467152213735e-11,
+                       5.12229709037114e-08,
+                       1.48572235717979e-05,
+                       6.37261928875436e-04,
+                       4.89352455891786e-03});
+  Expr q  = Polynomial(x2, {1.19825839466702e-06, 1.18534705686654e-04, 2.26843463243900e-03, 4.89352518554385e-03});
+  return ir::Select::Make(lang::Abs(x) < Const(x, 0.0004), x, xc * p / q);
+}
+
+//! The rational approximation of Eigen, erf(x) rounds to +-1 out of [-4, 4], it errs within 6 ULP for the normals.
+Expr VectorErf(const Expr &x) {
+  Expr xc = ir::Min::Make(ir::Max::Make(x, Const(x, -4)), Const(x, 4));
+  Expr x2 = xc * xc;
+  Expr p  = Polynomial(x2,
+                      {-2.72614225801306e-10,
+                       2.77068142495902e-08,
+                       -2.10102402082508e-06,
+                       -5.69250639462346e-05,
+                       -7.34990630326855e-04,
+                       -2.95459980854025e-03,
+                       -1.60960333262415e-02});
+  Expr q  = Polynomial(x2,
+                      {-1.45660718464996e-05,
+                       -2.13374055278905e-04,
+                       -1.68282697438203e-03,
+                       -7.37332916720468e-03,
+                       -1.42647390514189e-02});
+  return xc * p / q;
+}
+
+//! The polynomial of a float32 vector math call, or undefined to lower it as a scalar one, e.g. in the strict mode.
+Expr LowerVectorMath(const ir::Call *op, common::PrecisionMode mode) {
+  if (!op->type().is_float(32) || !op->type().is_vector() || op->read_args.size() != 1U) return Expr();
+  const Expr &x = op->read_args[0];
+  int max_ulp   = FLAGS_cinn_cpu_vector_math_max_ulp;
+  if (op->name == "erf") return VectorErf(x);
+  if (max_ulp <= 0 || mode == common::PrecisionMode::kStrict) return Expr();
+  if (op->name == "exp" && max_ulp >= kExpUlp) return VectorExp(x, max_ulp >= kFastExpUlp);
+  if (op->name == "log" && max_ulp >= kLogUlp) return VectorLog(x);
+  if (op->name == "tanh" && max_ulp >= kTanhUlp) return VectorTanh(x);
+  return Expr();
+}
+
+}  // namespace
+
 void LowerIntrin(Expr *e, Target target) {
-  if (target.arch == Target::Arch::X86) {
+  if (target.is_cpu()) {
     codegen::RegisterCpuIntrinRule();
   } else {
     return;
   }
   struct Mutator : ir::IRMutator<Expr *> {
     Target target;
+    common::PrecisionMode mode;
 
-    explicit Mutator(Target target) : target(target) {}
+    Mutator(Target target, common::PrecisionMode mode) : target(target), mode(mode) {}
 
     void operator()(Expr *e) { ir::IRMutator<>::Visit(e, e); }
 
@@ -42,7 +200,8 @@ void LowerIntrin(Expr *e, Target target) {
       auto *node = expr->As<ir::Add>();
       CHECK(node);
       Expr ret;
-      if (node->type().is_float()) {
+      // the strict mode rounds the product before the sum as IEEE does
+      if (node->type().is_float() && mode != common::PrecisionMode::kStrict) {
         if (const ir::Mul *mul = node->b().As<ir::Mul>()) {
           ret = ir::Call::Make(node->type(), "fma", {mul->a(), mul->b(), node->a()}, {}, ir::CallType::Intrinsic);
         } else if (const ir::Mul *mul = node->a().As<ir::Mul>()) {
@@ -66,6 +225,12 @@ void LowerIntrin(Expr *e, Target target) {
 
     void LowerCpuintrinsicOp(ir::Call *op, Expr *expr) {
       auto *node = expr->As<ir::Call>();
+      Expr vector_math = LowerVectorMath(node, mode);
+      if (vector_math.defined()) {
+        ir::IRMutator<>::Visit(&vector_math, &vector_math);
+        *expr = vector_math;
+        return;
+      }
       if (kIntrinsicCalls.count(node->name)) {
         CHECK(!node->name.empty());
         auto *func_ptr = ir::Registry::Get("lower_cpu_intrinsic_" + node->name);
@@ -87,7 +252,7 @@ void LowerIntrin(Expr *e, Target target) {
     }
   };
 
-  Mutator m(target);
+  Mutator m(target, common::CurrentPrecisionMode());
   m(e);
 }
 
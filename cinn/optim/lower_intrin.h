@@ -14,14 +14,21 @@
 
 #pragma once
 
+#include <gflags/gflags.h>
+
 #include <set>
 #include <string>
 
 #include "cinn/ir/ir.h"
 
+DECLARE_int32(cinn_cpu_vector_math_max_ulp);
+
 namespace cinn {
 namespace optim {
 
+//! The intrinsic reinterpreting the bits of its argument as another type of the same size, printed as it is in C.
+static const char* kReinterpretIntrin = "cinn_reinterpret";
+
 static const std::set<std::string> kIntrinsicCalls{
     {"exp",         "exp2",       "sqrt",        "log",         "log2",        "log10", "floor",
      "ceil",        "round",      "trunc",       "cos",         "cosh",        "tan",   "tanh",
@@ -33,6 +40,11 @@ static const std::set<std::string> kIntrinsicCalls{
  *
  * This will rename the external call with the function in different backends.
  *
+ * The exp, log, tanh and erf of the float32 vectors are expanded to polynomials instead, as LLVM scalarizes them to the
+ * libm calls. Each polynomial is used only when its max error is within FLAGS_cinn_cpu_vector_math_max_ulp, except the
+ * erf, which has no vector libm function. The multiply-adds are contracted to fma and the polynomials are used unless
+ * the current precision mode, see common::PrecisionScope, is strict.
+ *
  * Notes: only support cpu currently.
  */
 void LowerIntrin(Expr *e, Target target);
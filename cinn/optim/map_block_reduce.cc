@@ -0,0 +1,146 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/map_block_reduce.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cinn/ir/ir_mutator.h"
+#include "cinn/ir/ir_operators.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/optim/ir_copy.h"
+#include "cinn/optim/ir_replace.h"
+#include "cinn/utils/string.h"
+#include "cinn/optim/ir_simplify.h"
+
+namespace cinn {
+namespace optim {
+
+namespace {
+
+struct BlockReduceMutator : public ir::IRMutator<Expr *> {
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::For *op, Expr *expr) override {
+    if (op->is_block_reduce()) {
+      Map(op, expr);
+    } else {
+      auto *node = expr->As<ir::For>();
+      ir::IRMutator<>::Visit(&node->body, &node->body);
+    }
+  }
+
+  //! The value of \p index at the iteration \p k of \p loop.
+  Expr IndexAt(Expr index, const ir::For *loop, int k) {
+    auto copied = IRCopy(index);
+    IrReplace(&copied, Expr(loop->loop_var), Expr(k));
+    Simplify(&copied);
+    return copied;
+  }
+
+  //! Split \p value into the reduced tensor \p out and the element, return the name of the reduction.
+  std::string MatchReduce(const Expr &value, const std::string &out, Expr *elem) {
+    auto is_out = [&](const Expr &x) { return x.As<ir::Load>() && x.As<ir::Load>()->tensor.as_tensor()->name == out; };
+    // max(out, x) + log(1 + exp(min(out, x) - max(out, x))) expanded from the ReduceLogSumExp
+    if (auto *add = value.As<ir::Add>()) {
+      for (auto &pair : {std::make_pair(add->a(), add->b()), std::make_pair(add->b(), add->a())}) {
+        auto *max  = pair.first.As<ir::Max>();
+        auto *call = pair.second.As<ir::Call>();
+        if (!max || !call || call->name != "log") continue;
+        if (is_out(max->a()) || is_out(max->b())) {
+          *elem = is_out(max->a()) ? max->b() : max->a();
+          return "logsumexp";
+        }
+      }
+    }
+
+    std::string name;
+    Expr a, b;
+    if (auto *add = value.As<ir::Add>()) {
+      name = "sum", a = add->a(), b = add->b();
+    } else if (auto *mul = value.As<ir::Mul>()) {
+      name = "prod", a = mul->a(), b = mul->b();
+    } else if (auto *max = value.As<ir::Max>()) {
+      name = "max", a = max->a(), b = max->b();
+    } else if (auto *min = value.As<ir::Min>()) {
+      name = "min", a = min->a(), b = min->b();
+    } else {
+      LOG(FATAL) << "The block reduction of " << out << " should be a sum, prod, max or min, but get " << value;
+    }
+    if (!is_out(a)) std::swap(a, b);
+    CHECK(is_out(a)) << "The block reduction should accumulate " << out << ", but get " << value;
+    *elem = b;
+    return name;
+  }
+
+  void Map(const ir::For *op, Expr *expr) {
+    CHECK(op->min.is_constant() && op->min.as_int32() == 0 && op->extent.is_constant())
+        << "The block reduction should be a loop of constant extent from 0";
+    int extent = op->extent.as_int32();
+
+    Expr stmt = op->body;
+    while (stmt.As<ir::Block>()) {
+      CHECK_EQ(stmt.As<ir::Block>()->stmts.size(), 1U) << "The block reduction should only store the output:\n" << stmt;
+      stmt = stmt.As<ir::Block>()->stmts.front();
+    }
+    auto *store = stmt.As<ir::Store>();
+    CHECK(store) << "The block reduction should only store the output:\n" << stmt;
+    auto out_name = store->tensor.as_tensor()->name;
+
+    Expr elem;
+    auto reduce = MatchReduce(store->value, out_name, &elem);
+    // the sum of the squares of the elements, e.g. the second moment of the layer_norm
+    auto *square = elem.As<ir::Mul>();
+    if (reduce == "sum" && square && utils::GetStreamCnt(square->a()) == utils::GetStreamCnt(square->b())) {
+      reduce = "sum_sq";
+      elem   = square->a();
+    }
+    auto *load = elem.As<ir::Load>();
+    CHECK(load) << "The elements of the block reduction should be loaded from a tensor, but get " << elem;
+    CHECK(load->type().is_float(32) && store->tensor.as_tensor()->type().is_float(32))
+        << "Only the float32 reduction is reduced by a block";
+
+    // the element index should be affine in the reduce loop, or each thread reduces all the elements itself
+    auto index  = load->index();
+    auto offset = IndexAt(index, op, 0);
+    Expr stride = IndexAt(index, op, 1) - offset;
+    Expr last   = IndexAt(index, op, extent - 1) - offset;
+    Simplify(&stride);
+    Simplify(&last);
+    if (!stride.is_constant() || !last.is_constant() || last.as_int32() != stride.as_int32() * (extent - 1)) {
+      VLOG(3) << "The index " << index << " of the block reduction of " << out_name << " is not affine, skip it";
+      expr->As<ir::For>()->set_block_reduce(false);
+      return;
+    }
+
+    auto init = ir::Load::Make(store->tensor, store->indices);
+    auto call = ir::Call::Make(Float(32),
+                               "cinn_block_reduce_" + reduce + "_fp32",
+                               {init, load->tensor, offset, Expr(extent), stride},
+                               {},
+                               ir::CallType::Extern);
+    VLOG(3) << "Map the block reduction of " << out_name << " to " << call;
+    *expr = ir::Store::Make(store->tensor, call, store->indices);
+  }
+};
+
+}  // namespace
+
+void MapBlockReduce(Expr *expr) { BlockReduceMutator()(expr); }
+
+}  // namespace optim
+}  // namespace cinn
@@ -0,0 +1,38 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "cinn/ir/ir.h"
+
+namespace cinn {
+namespace optim {
+
+/**
+ * Replace the reduce loops marked by Stage::BlockReduce with the block reduction intrinsics of CUDA, which are called
+ * by all the threads of the block, e.g.
+ *
+ * for (k, 0, 4096)
+ *   B[i] = (B[i] + A[i * 4096 + k])
+ *
+ * to
+ *
+ * B[i] = cinn_block_reduce_sum_fp32(B[i], A, i * 4096, 4096, 1)
+ *
+ * The sums of the squares are reduced by cinn_block_reduce_sum_sq_fp32, and the ReduceLogSumExp is reduced by
+ * cinn_block_reduce_logsumexp_fp32 in a single pass of the online normalizer.
+ */
+void MapBlockReduce(Expr* expr);
+
+}  // namespace optim
+}  // namespace cinn
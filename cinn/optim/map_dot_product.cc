@@ -0,0 +1,97 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/map_dot_product.h"
+
+#include <vector>
+
+#include "cinn/common/ir_util.h"
+#include "cinn/ir/intrinsic_ops.h"
+#include "cinn/ir/ir_mutator.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/optim/ir_copy.h"
+#include "cinn/optim/ir_replace.h"
+#include "cinn/optim/ir_simplify.h"
+
+namespace cinn {
+namespace optim {
+
+namespace {
+
+using ir::intrinsics::DotProduct4;
+
+//! Get the int8 operand widened to int32 by \p x.
+Expr GetOperand(const Expr &x) {
+  auto *cast = x.As<ir::Cast>();
+  CHECK(cast && cast->v().type().is_int(8)) << "The operands of the dot product should be int8, but get " << x;
+  return cast->v();
+}
+
+struct DotProductMutator : public ir::IRMutator<Expr *> {
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::For *op, Expr *expr) override {
+    if (op->is_dot_product()) {
+      Map(op, expr);
+    } else {
+      auto *node = expr->As<ir::For>();
+      ir::IRMutator<>::Visit(&node->body, &node->body);
+    }
+  }
+
+  //! The value of \p x at the iteration \p k of \p loop.
+  Expr ValueAt(Expr x, const ir::For *loop, int k) {
+    auto copied = IRCopy(x);
+    IrReplace(&copied, Expr(loop->loop_var), Expr(k));
+    Simplify(&copied);
+    return copied;
+  }
+
+  void Map(const ir::For *op, Expr *expr) {
+    CHECK(op->min.is_constant() && op->min.as_int32() == 0 && op->extent.is_constant() &&
+          op->extent.as_int32() == DotProduct4::kLanes)
+        << "The dot product loop should be 4:\n"
+        << Expr(const_cast<ir::For *>(op));
+    auto *store = common::GetOnlyStmt(op->body).As<ir::Store>();
+    CHECK(store) << "The dot product loop should store C:\n" << op->body;
+    auto *add = store->value.As<ir::Add>();
+    CHECK(add) << "The dot product loop should accumulate C, but get " << store->value;
+    // C = C + A * B, the product may be the either side
+    bool mul_on_b = add->b().As<ir::Mul>();
+    auto *mul     = mul_on_b ? add->b().As<ir::Mul>() : add->a().As<ir::Mul>();
+    CHECK(mul) << "The dot product loop should accumulate C, but get " << store->value;
+    Expr acc   = mul_on_b ? add->a() : add->b();
+    auto *load = acc.As<ir::Load>();
+    CHECK(load && load->tensor.as_tensor()->name == store->tensor.as_tensor()->name)
+        << "The dot product loop should accumulate C, but get " << store->value;
+
+    Expr lhs = GetOperand(mul->a());
+    Expr rhs = GetOperand(mul->b());
+    std::vector<Expr> a, b;
+    for (int k = 0; k < DotProduct4::kLanes; k++) {
+      a.push_back(ValueAt(lhs, op, k));
+      b.push_back(ValueAt(rhs, op, k));
+    }
+    VLOG(3) << "Map the dot product loop of " << store->tensor.as_tensor()->name;
+    *expr = ir::Store::Make(store->tensor, DotProduct4::Make(acc, a, b), store->indices);
+  }
+};
+
+}  // namespace
+
+void MapDotProducts(Expr *expr) { DotProductMutator()(expr); }
+
+}  // namespace optim
+}  // namespace cinn
@@ -0,0 +1,36 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "cinn/ir/ir.h"
+
+namespace cinn {
+namespace optim {
+
+/**
+ * Replace the reduce loops of 4 iterations marked by Stage::DotProduct4 with the 4-way int8 dot product intrinsic,
+ * e.g.
+ *
+ * for (k_inner, 0, 4)
+ *   C[i, j] = (C[i, j] + (int32(A[i, ((4 * k_outer) + k_inner)]) * int32(B[((4 * k_outer) + k_inner), j])))
+ *
+ * to
+ *
+ * C[i, j] = dot_product4(C[i, j], [A[i, (4 * k_outer)], ..., A[i, ((4 * k_outer) + 3)]],
+ *                                 [B[(4 * k_outer), j], ..., B[((4 * k_outer) + 3), j]])
+ */
+void MapDotProducts(Expr* expr);
+
+}  // namespace optim
+}  // namespace cinn
@@ -41,6 +41,12 @@ void MapExternCall(Expr *e, Target target) {
     }
 
     void DealWithCpuintrinsics(ir::Call *node, Expr *expr) {
+      // the erf of the float32 vectors is lowered to a polynomial by LowerIntrin
+      if (node->name == "erf" && node->type().is_vector()) return;
+      if (node->name == "philox_uniform") {
+        *expr = lang::CallExtern("cinn_host_philox_uniform", node->read_args);
+        return;
+      }
       if (kExternFp32CallsCPU.count(node->name)) {
         CHECK_GE(node->read_args.size(), 1UL);
         CHECK_EQ(node->read_args.front().type(), Float(32));
@@ -50,6 +56,10 @@ void MapExternCall(Expr *e, Target target) {
     }
 
     void DealWithNvGpuintrinsics(ir::Call *node, Expr *expr) {
+      if (node->name == "philox_uniform") {
+        *expr = lang::CallExtern("cinn_nvgpu_philox_uniform", node->read_args);
+        return;
+      }
       if (kExternFp32CallsGPU.count(node->name)) {
         CHECK_GE(node->read_args.size(), 1UL);
         CHECK_EQ(node->read_args.front().type(), Float(32));
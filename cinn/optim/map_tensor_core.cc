@@ -0,0 +1,176 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/map_tensor_core.h"
+
+#include <string>
+#include <vector>
+
+#include "cinn/common/ir_util.h"
+#include "cinn/ir/ir_mutator.h"
+#include "cinn/ir/ir_operators.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/optim/ir_copy.h"
+#include "cinn/optim/ir_replace.h"
+#include "cinn/optim/ir_simplify.h"
+
+namespace cinn {
+namespace optim {
+
+namespace {
+
+constexpr int kTensorCoreTile = 16;
+
+const ir::Load *GetOperand(Expr x) {
+  while (x.As<ir::Cast>()) x = x.As<ir::Cast>()->v();
+  auto *load = x.As<ir::Load>();
+  CHECK(load) << "The operands of the tensor core tile should be loaded, but get " << x;
+  return load;
+}
+
+struct TensorCoreMutator : public ir::IRMutator<Expr *> {
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::For *op, Expr *expr) override {
+    if (op->is_tensor_core()) {
+      Map(op, expr);
+    } else {
+      auto *node = expr->As<ir::For>();
+      ir::IRMutator<>::Visit(&node->body, &node->body);
+    }
+  }
+
+  const ir::For *GetTileLoop(Expr stmt) {
+    auto *loop = common::GetOnlyStmt(stmt).As<ir::For>();
+    CHECK(loop) << "The tensor core tile should be three loops:\n" << stmt;
+    CHECK(loop->min.is_constant() && loop->min.as_int32() == 0 && loop->extent.is_constant() &&
+          loop->extent.as_int32() == kTensorCoreTile)
+        << "The loops of the tensor core tile should be 16:\n"
+        << stmt;
+    return loop;
+  }
+
+  //! The value of \p index when the iterators of the tile are \p values.
+  Expr IndexAt(Expr index, const std::vector<int> &values) {
+    auto copied = IRCopy(index);
+    for (int i = 0; i < iters_.size(); i++) {
+      IrReplace(&copied, iters_[i], Expr(values[i]));
+    }
+    Simplify(&copied);
+    return copied;
+  }
+
+  //! The strides of \p index along the iterators i, j and k of the tile.
+  std::vector<int> GetStrides(Expr index, const Expr &offset) {
+    std::vector<int> strides;
+    for (int i = 0; i < iters_.size(); i++) {
+      std::vector<int> values(iters_.size(), 0);
+      values[i]   = 1;
+      Expr stride = IndexAt(index, values) - offset;
+      Simplify(&stride);
+      CHECK(stride.is_constant()) << "The index " << index << " of the tensor core tile should be affine";
+      strides.push_back(stride.as_int32());
+    }
+    Expr last = IndexAt(index, {1, 1, 1}) - offset;
+    Simplify(&last);
+    CHECK(last.is_constant() && last.as_int32() == strides[0] + strides[1] + strides[2])
+        << "The index " << index << " of the tensor core tile should be affine";
+    return strides;
+  }
+
+  //! Get the leading dimension of the 2D operand of the \p row and \p col iterators, and whether it is row major.
+  int GetLeadingDim(const std::vector<int> &strides, int row, int col, bool *row_major) {
+    for (int i = 0; i < strides.size(); i++) {
+      if (i != row && i != col) {
+        CHECK_EQ(strides[i], 0) << "The operand of the tensor core tile should be 2D";
+      }
+    }
+    if (strides[col] == 1) {
+      *row_major = true;
+      return strides[row];
+    }
+    CHECK_EQ(strides[row], 1) << "The operand of the tensor core tile should be either row major or column major";
+    *row_major = false;
+    return strides[col];
+  }
+
+  void Map(const ir::For *op, Expr *expr) {
+    auto *i_loop = op;
+    auto *j_loop = GetTileLoop(i_loop->body);
+    auto *k_loop = GetTileLoop(j_loop->body);
+    iters_       = {Expr(i_loop->loop_var), Expr(j_loop->loop_var), Expr(k_loop->loop_var)};
+    CHECK_EQ(i_loop->extent.as_int32(), kTensorCoreTile);
+
+    auto *store = common::GetOnlyStmt(k_loop->body).As<ir::Store>();
+    CHECK(store) << "The tensor core tile should store C:\n" << k_loop->body;
+    auto *add = store->value.As<ir::Add>();
+    CHECK(add) << "The tensor core tile should accumulate C, but get " << store->value;
+    // C = C + A * B, the product may be the either side
+    auto *mul = add->b().As<ir::Mul>() ? add->b().As<ir::Mul>() : add->a().As<ir::Mul>();
+    CHECK(mul) << "The tensor core tile should accumulate C, but get " << store->value;
+    auto *lhs = GetOperand(mul->a());
+    auto *rhs = GetOperand(mul->b());
+
+    auto c_index   = store->index();
+    auto lhs_index = lhs->index();
+    auto rhs_index = rhs->index();
+    auto c_offset  = IndexAt(c_index, {0, 0, 0});
+    auto a_offset  = IndexAt(lhs_index, {0, 0, 0});
+    auto b_offset  = IndexAt(rhs_index, {0, 0, 0});
+    auto c_strides = GetStrides(c_index, c_offset);
+    auto a_strides = GetStrides(lhs_index, a_offset);
+    auto b_strides = GetStrides(rhs_index, b_offset);
+    // A is indexed by i and k
+    if (a_strides[1] != 0) {
+      std::swap(lhs, rhs);
+      std::swap(a_offset, b_offset);
+      std::swap(a_strides, b_strides);
+    }
+    CHECK(lhs->type().is_float(16) && rhs->type().is_float(16))
+        << "The operands of the tensor core tile should be float16";
+    CHECK(store->tensor.as_tensor()->type().is_float(32)) << "The tensor core tile should accumulate float32";
+
+    bool a_row_major, b_row_major, c_row_major;
+    int lda = GetLeadingDim(a_strides, 0, 2, &a_row_major);
+    int ldb = GetLeadingDim(b_strides, 2, 1, &b_row_major);
+    int ldc = GetLeadingDim(c_strides, 0, 1, &c_row_major);
+
+    std::string name = std::string("cinn_nvgpu_wmma_m16n16k16_fp16_") + (a_row_major ? "row" : "col") + "_" +
+                       (b_row_major ? "row" : "col");
+    VLOG(3) << "Map the tensor core tile of " << store->tensor.as_tensor()->name << " to " << name;
+    *expr = ir::Call::Make(Void(),
+                           name,
+                           {lhs->tensor,
+                            a_offset,
+                            Expr(lda),
+                            rhs->tensor,
+                            b_offset,
+                            Expr(ldb),
+                            c_offset,
+                            Expr(ldc),
+                            Expr(static_cast<int>(!c_row_major))},
+                           {store->tensor},
+                           ir::CallType::Extern);
+  }
+
+  std::vector<Expr> iters_;
+};
+
+}  // namespace
+
+void MapTensorCoreTiles(Expr *expr) { TensorCoreMutator()(expr); }
+
+}  // namespace optim
+}  // namespace cinn
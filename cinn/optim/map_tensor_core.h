@@ -0,0 +1,37 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "cinn/ir/ir.h"
+
+namespace cinn {
+namespace optim {
+
+/**
+ * Replace the 16x16x16 tiles marked by Stage::TensorCore with the tensor core MMA intrinsics of CUDA. The offsets and
+ * the leading dimensions of the operands are derived from the indices of the tile, e.g.
+ *
+ * for (i, 0, 16)
+ *   for (j, 0, 16)
+ *     for (k, 0, 16)
+ *       C[i * 64 + j] = C[i * 64 + j] + float(A[i * 64 + k]) * float(B[k * 64 + j])
+ *
+ * to
+ *
+ * cinn_nvgpu_wmma_m16n16k16_fp16_row_row(A, 0, 64, B, 0, 64, 0, 64, 0, C)
+ */
+void MapTensorCoreTiles(Expr* expr);
+
+}  // namespace optim
+}  // namespace cinn
@@ -14,6 +14,7 @@
 
 #include "cinn/optim/optimize.h"
 
+#include "cinn/common/context.h"
 #include "cinn/ir/ir_printer.h"
 #include "cinn/optim/call_arg_list_to_pod_value.h"
 #include "cinn/optim/cast_bool_to_int8.h"
@@ -21,13 +22,23 @@
 #include "cinn/optim/eliminate_broadcast_in_forloop.h"
 #include "cinn/optim/extern_call_process.h"
 #include "cinn/optim/fold_cinn_call_arguments.h"
+#include "cinn/optim/if_conversion.h"
 #include "cinn/optim/if_simplify.h"
+#include "cinn/optim/insert_cache_hints.h"
 #include "cinn/optim/insert_debug_log_callee.h"
 #include "cinn/optim/ir_copy.h"
 #include "cinn/optim/ir_simplify.h"
 #include "cinn/optim/lower_function_call_bind_vars.h"
+#include "cinn/optim/loop_invariant_code_motion.h"
 #include "cinn/optim/lower_intrin.h"
+#include "cinn/optim/map_block_reduce.h"
+#include "cinn/optim/map_dot_product.h"
 #include "cinn/optim/map_extern_call.h"
+#include "cinn/optim/map_tensor_core.h"
+#include "cinn/optim/partition_loops.h"
+#include "cinn/optim/pipeline_loops.h"
+#include "cinn/optim/promote_temp_buffers.h"
+#include "cinn/optim/reduce_div_mod.h"
 #include "cinn/optim/remove_nested_block.h"
 #include "cinn/optim/replace_const_param_to_integer.h"
 #include "cinn/optim/transform_computeat_forloop.h"
@@ -35,24 +46,33 @@
 #include "cinn/optim/transform_polyfor_to_for.h"
 #include "cinn/optim/unroll_loops.h"
 #include "cinn/optim/vectorize_loops.h"
+#include "cinn/utils/compile_tracer.h"
 
 namespace cinn {
 namespace optim {
 
 Expr Optimize(Expr e, Target target, bool runtime_debug_info) {
   CHECK(e.defined());
-  auto copied = IRCopy(e);
+  utils::CompileStageTimer timer("Optimize");
+  auto copied = IRCopyOnWrite(std::move(e));
 
   FoldCINNCallArguments(&copied);
   TransformPolyForToFor(&copied);
   ReplaceConstParamToInteger(&copied);
   CastSimplify(&copied);
   Simplify(&copied);
-  UnrollLoop(&copied);
-  VectorizeLoops(&copied, Target());
+  MapTensorCoreTiles(&copied);
+  MapDotProducts(&copied);
+  MapBlockReduce(&copied);
+  ReduceDivMod(&copied);
+  PartitionLoops(&copied);
+  IfConversion(&copied);
+  UnrollLoop(&copied, target);
+  VectorizeLoops(&copied, target);
 #ifdef CINN_WITH_CUDA
   RemoveGpuForloopsAxis(&copied);
   CudaSyncThreadsDropIfThenElse(&copied);
+  PipelineLoops(&copied);
 #endif
 
   RemoveNestedBlock(&copied);
@@ -63,16 +83,24 @@ Expr Optimize(Expr e, Target target, bool runtime_debug_info) {
   CastSimplify(&copied);
   Simplify(&copied);
   IfSimplify(&copied);
+  LoopInvariantCodeMotion(&copied);
+  EliminateBroadcastInForloop(&copied);
+  if (target.arch == Target::Arch::X86) PromoteTempBuffers(&copied);
+  InsertCacheHints(&copied, target);
 
   if (runtime_debug_info) {
     LOG(WARNING) << "Turn on runtime debug information output";
-    InsertDebugLogCallee(&copied);
+    DebugLogSampling sampling;
+    sampling.first_n = FLAGS_cinn_runtime_debug_info_first_n;
+    sampling.every_k = FLAGS_cinn_runtime_debug_info_every_k;
+    InsertDebugLogCallee(&copied, sampling);
   }
   return copied;
 }
 
 ir::Module Optimize(const ir::Module& module, const Target& target) {
-  auto copied = IRCopy(Expr(module));
+  utils::CompileStageTimer timer("OptimizeModule");
+  auto copied = IRCopyOnWrite(Expr(module));
 
   LowerFunctionCallBindVars(&copied);
   CallArgListToPodValue(&copied);
@@ -0,0 +1,198 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/partition_loops.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "cinn/common/ir_util.h"
+#include "cinn/ir/ir_mutator.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/optim/index_range.h"
+#include "cinn/optim/ir_copy.h"
+
+namespace cinn {
+namespace optim {
+
+namespace {
+
+using RangeMap = std::map<std::string, IndexRange>;
+
+//! Set the range of a loop iterator in the scope, which shadows the outer one of the same name.
+class LoopRangeScope {
+ public:
+  //! The range is unknown if \p range is nullptr.
+  LoopRangeScope(const std::string &name, const IndexRange *range, RangeMap *ranges) : name_(name), ranges_(ranges) {
+    auto it   = ranges_->find(name_);
+    shadowed_ = it != ranges_->end();
+    if (shadowed_) old_ = it->second;
+    ranges_->erase(name_);
+    if (range) (*ranges_)[name_] = *range;
+  }
+
+  ~LoopRangeScope() {
+    ranges_->erase(name_);
+    if (shadowed_) (*ranges_)[name_] = old_;
+  }
+
+ private:
+  std::string name_;
+  RangeMap *ranges_;
+  bool shadowed_;
+  IndexRange old_{0, 0};
+};
+
+//! The range of the iterator of \p op, return false if it is unknown.
+bool GetLoopRange(const ir::For *op, const RangeMap &ranges, IndexRange *range) {
+  IndexRange min, extent;
+  if (!GetIndexRange(op->min, ranges, &min) || !GetIndexRange(op->extent, ranges, &extent)) return false;
+  if (extent.max <= min.min) return false;
+  *range = IndexRange{min.min, extent.max - 1};
+  return true;
+}
+
+bool Prove(const Expr &cond, const RangeMap &ranges) {
+  if (auto *op = cond.As<ir::And>()) return Prove(op->a(), ranges) && Prove(op->b(), ranges);
+  if (auto *op = cond.As<ir::Or>()) return Prove(op->a(), ranges) || Prove(op->b(), ranges);
+  if (auto *op = cond.As<ir::LT>()) return ProveLess(op->a(), op->b(), ranges, false);
+  if (auto *op = cond.As<ir::LE>()) return ProveLess(op->a(), op->b(), ranges, true);
+  if (auto *op = cond.As<ir::GT>()) return ProveLess(op->b(), op->a(), ranges, false);
+  if (auto *op = cond.As<ir::GE>()) return ProveLess(op->b(), op->a(), ranges, true);
+  return false;
+}
+
+//! Remove the guards proved by the ranges, and count them.
+struct GuardEliminator : public ir::IRMutator<Expr *> {
+  explicit GuardEliminator(const RangeMap &ranges) : ranges_(ranges) {}
+
+  int operator()(Expr *expr) {
+    ir::IRMutator<>::Visit(expr, expr);
+    return num_eliminated_;
+  }
+
+ private:
+  void Visit(const ir::For *op, Expr *expr) override {
+    auto *node = expr->As<ir::For>();
+    ir::IRMutator<>::Visit(&node->min, &node->min);
+    ir::IRMutator<>::Visit(&node->extent, &node->extent);
+    if (auto *min = node->extent.As<ir::Min>()) {
+      if (ProveLess(min->a(), min->b(), ranges_, true)) {
+        node->extent = min->a();
+        num_eliminated_++;
+      } else if (ProveLess(min->b(), min->a(), ranges_, true)) {
+        node->extent = min->b();
+        num_eliminated_++;
+      }
+    }
+    IndexRange range;
+    bool known = GetLoopRange(node, ranges_, &range);
+    LoopRangeScope scope(node->loop_var->name, known ? &range : nullptr, &ranges_);
+    ir::IRMutator<>::Visit(&node->body, &node->body);
+  }
+
+  void Visit(const ir::IfThenElse *op, Expr *expr) override {
+    ir::IRMutator<>::Visit(op, expr);
+    auto *node = expr->As<ir::IfThenElse>();
+    if (Prove(node->condition, ranges_)) {
+      *expr = node->true_case;
+      num_eliminated_++;
+    }
+  }
+
+  void Visit(const ir::Select *op, Expr *expr) override {
+    ir::IRMutator<>::Visit(op, expr);
+    auto *node = expr->As<ir::Select>();
+    if (Prove(node->condition, ranges_)) {
+      *expr = node->true_value;
+      num_eliminated_++;
+    }
+  }
+
+  RangeMap ranges_;
+  int num_eliminated_{0};
+};
+
+struct LoopPartitioner : public ir::IRMutator<Expr *> {
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::For *op, Expr *expr) override {
+    // the parallel, unrolled and vectorized loops, and the thread loops are kept
+    bool partitionable = op->for_type() == ir::ForType::Serial || op->for_type() == ir::ForType::GPUBlock;
+    auto *min          = op->min.As<ir::IntImm>();
+    auto *extent       = op->extent.As<ir::IntImm>();
+    if (partitionable && min && extent && extent->value > min->value && Partition(min->value, extent->value, expr)) {
+      return;
+    }
+    auto *node = expr->As<ir::For>();
+    IndexRange range;
+    bool known = GetLoopRange(node, ranges_, &range);
+    LoopRangeScope scope(node->loop_var->name, known ? &range : nullptr, &ranges_);
+    ir::IRMutator<>::Visit(&node->body, &node->body);
+  }
+
+  //! Partition the loop of the iterations [begin, end), return false if no guard is eliminated in the first one.
+  bool Partition(int64_t begin, int64_t end, Expr *expr) {
+    int count = CountEliminated(*expr, begin, begin + 1);
+    if (count == 0) return false;
+    // fewer guards are proved in more iterations, find the largest main loop proving as many as the first iteration
+    int64_t lo = begin + 1, hi = end;
+    while (lo < hi) {
+      int64_t mid = lo + (hi - lo + 1) / 2;
+      if (CountEliminated(*expr, begin, mid) == count) {
+        lo = mid;
+      } else {
+        hi = mid - 1;
+      }
+    }
+    VLOG(3) << "partition the loop " << expr->As<ir::For>()->loop_var->name << " of [" << begin << ", " << end
+            << ") at " << lo << ", eliminating " << count << " guards";
+    std::vector<Expr> loops({MakeLoop(*expr, begin, lo)});
+    if (lo < end) loops.push_back(MakeLoop(*expr, lo, end));
+    *expr = loops.size() == 1 ? loops.front() : ir::Block::Make(loops);
+    return true;
+  }
+
+  int CountEliminated(const Expr &loop, int64_t begin, int64_t end) {
+    Expr body = IRCopy(loop.As<ir::For>()->body);
+    return EliminateGuards(loop.As<ir::For>()->loop_var->name, begin, end, &body);
+  }
+
+  int EliminateGuards(const std::string &name, int64_t begin, int64_t end, Expr *body) {
+    IndexRange range{begin, end - 1};
+    LoopRangeScope scope(name, &range, &ranges_);
+    return GuardEliminator(ranges_)(body);
+  }
+
+  //! The copy of \p loop of the iterations [begin, end), without the guards proved in them.
+  Expr MakeLoop(const Expr &loop, int64_t begin, int64_t end) {
+    Expr res     = IRCopy(loop);
+    auto *node   = res.As<ir::For>();
+    node->min    = common::make_const(node->min.type(), begin);
+    node->extent = common::make_const(node->extent.type(), end);
+    EliminateGuards(node->loop_var->name, begin, end, &node->body);
+    return res;
+  }
+
+  RangeMap ranges_;
+};
+
+}  // namespace
+
+void PartitionLoops(Expr *expr) { LoopPartitioner()(expr); }
+
+}  // namespace optim
+}  // namespace cinn
@@ -0,0 +1,48 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "cinn/ir/ir.h"
+
+namespace cinn {
+namespace optim {
+
+/**
+ * Partition the serial loops and the GPU block loops of the constant bounds, whose body is guarded by the
+ * non-divisible splits, into a main loop without the guards and a remainder, e.g.
+ *
+ * for (i, 0, 4)
+ *   for (j, 0, min(32, 100 - i * 32))
+ *     if ((i * 32 + j) < 100)
+ *       B[i * 32 + j] = A[i * 32 + j]
+ *
+ * to
+ *
+ * for (i, 0, 3)
+ *   for (j, 0, 32)
+ *     B[i * 32 + j] = A[i * 32 + j]
+ * for (i, 3, 4)
+ *   for (j, 0, (100 - i * 32))
+ *     B[i * 32 + j] = A[i * 32 + j]
+ *
+ * The guards are the conditions of the IfThenElse and the Select, and the min of the loop extents, which are proved by
+ * the ranges of the loop iterators. The main loop is the largest prefix of the iterations in which all the guards
+ * proved in the first iteration are proved too, and the remainder drops the guards proved in its own iterations, here
+ * the min of the extent and then the condition. On GPU, the partitioned block loops become a uniform branch by the
+ * block index, so that the threads of the most blocks run without the guards.
+ */
+void PartitionLoops(Expr* expr);
+
+}  // namespace optim
+}  // namespace cinn
@@ -0,0 +1,84 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/partition_loops.h"
+
+#include <gtest/gtest.h>
+
+#include "cinn/common/ir_util.h"
+#include "cinn/ir/ir_operators.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/utils/string.h"
+
+namespace cinn::optim {
+
+// for (i, 0, 4)
+//   for (j, 0, min(32, 100 - i * 32))
+//     if ((i * 32 + j) < 100) v = i * 32 + j
+Expr MakeGuardedLoops(ir::ForType outer_type, Var i, Var j, Expr n) {
+  Expr x     = Expr(i) * 32 + j;
+  Expr body  = ir::IfThenElse::Make(x < n, ir::Let::Make(Var("v"), x));
+  Expr inner = ir::For::Make(j,
+                             common::make_const(0),
+                             ir::Min::Make(common::make_const(32), n - Expr(i) * 32),
+                             ir::ForType::Serial,
+                             ir::DeviceAPI::UNK,
+                             body);
+  return ir::For::Make(i, common::make_const(0), common::make_const(4), outer_type, ir::DeviceAPI::UNK, inner);
+}
+
+TEST(PartitionLoops, non_divisible_split) {
+  for (auto outer_type : {ir::ForType::Serial, ir::ForType::GPUBlock}) {
+    Var i("i"), j("j");
+    Expr e = MakeGuardedLoops(outer_type, i, j, Expr(100));
+
+    PartitionLoops(&e);
+    LOG(INFO) << "\n" << e;
+
+    auto *block = e.As<ir::Block>();
+    ASSERT_TRUE(block);
+    ASSERT_EQ(block->stmts.size(), 2UL);
+    // the main loop of the first 3 iterations is not guarded
+    auto *main = block->stmts[0].As<ir::For>();
+    ASSERT_TRUE(main);
+    EXPECT_EQ(main->for_type(), outer_type);
+    EXPECT_EQ(utils::GetStreamCnt(main->min), "0");
+    EXPECT_EQ(utils::GetStreamCnt(main->extent), "3");
+    auto *main_inner = main->body.As<ir::For>();
+    ASSERT_TRUE(main_inner);
+    EXPECT_EQ(utils::GetStreamCnt(main_inner->extent), "32");
+    EXPECT_TRUE(main_inner->body.As<ir::Let>());
+    // the exact extent of the remainder proves the guard too
+    auto *remainder = block->stmts[1].As<ir::For>();
+    ASSERT_TRUE(remainder);
+    EXPECT_EQ(utils::GetStreamCnt(remainder->min), "3");
+    EXPECT_EQ(utils::GetStreamCnt(remainder->extent), "4");
+    auto *remainder_inner = remainder->body.As<ir::For>();
+    ASSERT_TRUE(remainder_inner);
+    EXPECT_EQ(utils::GetStreamCnt(remainder_inner->extent), utils::GetStreamCnt(Expr(100) - Expr(i) * 32));
+    EXPECT_TRUE(remainder_inner->body.As<ir::Let>());
+  }
+}
+
+TEST(PartitionLoops, unknown_bound) {
+  Var i("i"), j("j"), n("n");
+  Expr e        = MakeGuardedLoops(ir::ForType::Serial, i, j, Expr(n));
+  auto expected = utils::GetStreamCnt(e);
+
+  PartitionLoops(&e);
+  // the guards by n can not be proved
+  EXPECT_EQ(utils::GetStreamCnt(e), expected);
+}
+
+}  // namespace cinn::optim
@@ -0,0 +1,312 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/pipeline_loops.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "cinn/ir/collect_ir_nodes.h"
+#include "cinn/ir/intrinsic_ops.h"
+#include "cinn/ir/ir_mutator.h"
+#include "cinn/ir/ir_operators.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/optim/ir_copy.h"
+#include "cinn/optim/ir_replace.h"
+#include "cinn/optim/ir_simplify.h"
+#include "cinn/runtime/intrinsic.h"
+
+namespace cinn {
+namespace optim {
+
+namespace {
+
+static const char* kAsyncCopyFp32 = "cinn_nvgpu_cp_async_fp32";
+static const char* kAsyncCommit   = "cinn_nvgpu_cp_async_commit";
+static const char* kAsyncWait     = "cinn_nvgpu_cp_async_wait";
+
+bool IsSyncThreads(const Expr& stmt) {
+  auto* call = stmt.As<ir::Call>();
+  return call && call->name == runtime::intrinsic::cuda_sync_threads;
+}
+
+bool HasSyncThreads(const Expr& stmt) {
+  return !ir::CollectIRNodes(stmt, [](const Expr* x) { return IsSyncThreads(*x); }).empty();
+}
+
+bool IsShared(const ir::Tensor& tensor) {
+  return tensor->buffer.defined() && tensor->buffer->memory_type == ir::MemoryType::GPUShared;
+}
+
+Expr SyncThreads() { return runtime::IntrinsicCall(Void(), runtime::intrinsic::cuda_sync_threads, {}); }
+
+Expr CallAsync(const std::string& name, const std::vector<Expr>& args) {
+  return ir::Call::Make(Void(), name, args, {}, ir::CallType::Extern);
+}
+
+void FlattenBlock(const Expr& stmt, std::vector<Expr>* stmts) {
+  if (auto* block = stmt.As<ir::Block>()) {
+    for (auto& x : block->stmts) FlattenBlock(x, stmts);
+  } else {
+    stmts->push_back(stmt);
+  }
+}
+
+//! Whether \p store copies a float32 element from the global memory to a shared tile, which could be a cp.async.
+bool IsAsyncCopy(const ir::Store* store) {
+  auto* load = store->value.As<ir::Load>();
+  if (!load || !load->tensor.as_tensor() || store->value.type() != Float(32)) return false;
+  auto src = load->tensor.as_tensor_ref();
+  return IsShared(store->tensor.as_tensor_ref()) && src->buffer.defined() &&
+         src->buffer->memory_type == ir::MemoryType::Heap;
+}
+
+//! Move the accesses of the tiles to the buffer \p stage, e.g. AS[i, j] to AS[i + stage * 16, j] of the [16, 4] AS.
+struct StageOffsetMutator : public ir::IRMutator<Expr*> {
+  StageOffsetMutator(const std::map<std::string, Expr>& extents, Expr stage) : extents(extents), stage(stage) {}
+
+  void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::Load* op, Expr* expr) override {
+    auto* node = expr->As<ir::Load>();
+    for (auto& index : node->indices) ir::IRMutator<>::Visit(&index, &index);
+    Offset(node->tensor, &node->indices);
+  }
+
+  void Visit(const ir::Store* op, Expr* expr) override {
+    auto* node = expr->As<ir::Store>();
+    ir::IRMutator<>::Visit(&node->value, &node->value);
+    for (auto& index : node->indices) ir::IRMutator<>::Visit(&index, &index);
+    Offset(node->tensor, &node->indices);
+  }
+
+  void Offset(const Expr& tensor, std::vector<Expr>* indices) {
+    auto it = extents.find(tensor.as_tensor()->name);
+    if (it == extents.end()) return;
+    CHECK(!indices->empty());
+    indices->front() = indices->front() + stage * it->second;
+  }
+
+  const std::map<std::string, Expr>& extents;
+  Expr stage;
+};
+
+//! Issue the copies of the float32 elements from the global memory to the shared tiles by cp.async.
+struct AsyncCopyMutator : public ir::IRMutator<Expr*> {
+  void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::Store* op, Expr* expr) override {
+    if (!IsAsyncCopy(op)) {
+      ir::IRMutator<>::Visit(op, expr);
+      return;
+    }
+    auto dst = ir::intrinsics::GetAddr::Make(ir::Load::Make(op->tensor, op->indices));
+    auto src = ir::intrinsics::GetAddr::Make(op->value);
+    *expr    = CallAsync(kAsyncCopyFp32, {dst, src});
+  }
+};
+
+struct PipelineMutator : public ir::IRMutator<Expr*> {
+  void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+  //! The number of the buffers of each pipelined tile.
+  std::map<std::string, int> buffer_stages;
+
+ private:
+  void Visit(const ir::For* op, Expr* expr) override {
+    if (op->is_pipelined()) {
+      Pipeline(op, expr);
+    } else {
+      auto* node = expr->As<ir::For>();
+      ir::IRMutator<>::Visit(&node->body, &node->body);
+    }
+  }
+
+  void Skip(const ir::For* op, Expr* expr, const std::string& reason) {
+    VLOG(3) << "Skip pipelining the loop " << op->loop_var->name << ", " << reason;
+    expr->As<ir::For>()->set_pipeline_stages(0);
+  }
+
+  void Pipeline(const ir::For* op, Expr* expr) {
+    int num_stages = std::max(2, op->pipeline_stages());
+    if (!op->min.is_constant() || op->min.as_int32() != 0 || !op->extent.is_constant()) {
+      Skip(op, expr, "the loop is not of constant extent from 0");
+      return;
+    }
+    int extent = op->extent.as_int32();
+    if (extent < num_stages) {
+      Skip(op, expr, "the loop is shorter than the pipeline");
+      return;
+    }
+
+    // the body should be [__syncthreads] loads __syncthreads computes [__syncthreads]
+    std::vector<Expr> stmts;
+    FlattenBlock(op->body, &stmts);
+    std::vector<Expr> loads, computes;
+    std::map<std::string, ir::Tensor> tiles;
+    size_t i          = 0;
+    bool leading_sync = false;
+    for (; i < stmts.size() && IsSyncThreads(stmts[i]); i++) leading_sync = true;
+    for (; i < stmts.size() && !IsSyncThreads(stmts[i]); i++) {
+      auto stores = ir::CollectIRNodes(stmts[i], [](const Expr* x) { return x->As<ir::Store>(); });
+      if (stores.empty() || std::any_of(stores.begin(), stores.end(), [](const Expr& x) {
+            return !IsShared(x.As<ir::Store>()->tensor.as_tensor_ref());
+          })) {
+        break;
+      }
+      for (auto& store : stores) {
+        auto tensor         = store.As<ir::Store>()->tensor.as_tensor_ref();
+        tiles[tensor->name] = tensor;
+      }
+      loads.push_back(stmts[i]);
+    }
+    if (loads.empty() || i == stmts.size() || !IsSyncThreads(stmts[i])) {
+      Skip(op, expr, "the body does not load the shared tiles and then sync the threads");
+      return;
+    }
+    while (i < stmts.size() && IsSyncThreads(stmts[i])) i++;
+    for (; i < stmts.size() && !IsSyncThreads(stmts[i]); i++) computes.push_back(stmts[i]);
+    while (i < stmts.size() && IsSyncThreads(stmts[i])) i++;
+    if (computes.empty() || i != stmts.size()) {
+      Skip(op, expr, "the body does not compute on the shared tiles after loading them");
+      return;
+    }
+    for (auto& stmt : computes) {
+      auto tile_stores = ir::CollectIRNodes(stmt, [&](const Expr* x) {
+        return x->As<ir::Store>() && tiles.count(x->As<ir::Store>()->tensor.as_tensor()->name);
+      });
+      if (!tile_stores.empty() || HasSyncThreads(stmt)) {
+        Skip(op, expr, "the computes write the shared tiles or sync the threads");
+        return;
+      }
+    }
+
+    // each tile should take its whole buffer, which grows by the stages
+    std::map<std::string, Expr> extents;
+    for (auto& item : tiles) {
+      auto& tensor = item.second;
+      Expr tensor_size(1), buffer_size(1);
+      for (auto& dim : tensor->shape) tensor_size = tensor_size * dim;
+      for (auto& dim : tensor->buffer->shape) buffer_size = buffer_size * dim;
+      Simplify(&tensor_size);
+      Simplify(&buffer_size);
+      if (tensor->shape.empty() || !tensor_size.is_constant() || !buffer_size.is_constant() ||
+          tensor_size.as_int32() != buffer_size.as_int32()) {
+        Skip(op, expr, "the shared tile " + tensor->name + " does not take its whole buffer");
+        return;
+      }
+      extents[item.first] = tensor->shape.front();
+    }
+
+    bool async = false;
+    for (auto& stmt : loads) {
+      async = async || !ir::CollectIRNodes(stmt, [](const Expr* x) {
+                           return x->As<ir::Store>() && IsAsyncCopy(x->As<ir::Store>());
+                         }).empty();
+    }
+    VLOG(3) << "Pipeline the loop " << op->loop_var->name << " over " << num_stages << " stages of "
+            << tiles.size() << " shared tiles" << (async ? " by cp.async" : "");
+
+    Var ko = op->loop_var;
+    // the statements at the iteration, which access the tiles in the buffer stage
+    auto at = [&](const std::vector<Expr>& src, Expr iteration, Expr stage, bool copy_async) {
+      std::vector<Expr> res;
+      for (auto& stmt : src) {
+        auto copied = IRCopy(stmt);
+        IrReplace(&copied, Expr(ko), iteration);
+        StageOffsetMutator(extents, stage)(&copied);
+        if (copy_async) AsyncCopyMutator()(&copied);
+        res.push_back(copied);
+      }
+      return res;
+    };
+    auto append = [](std::vector<Expr>* dst, const std::vector<Expr>& src) {
+      dst->insert(dst->end(), src.begin(), src.end());
+    };
+    auto wait = [&](std::vector<Expr>* dst, int pending) {
+      if (async) dst->push_back(CallAsync(kAsyncWait, {Expr(pending)}));
+      dst->push_back(SyncThreads());
+    };
+    auto commit = [&](std::vector<Expr>* dst) {
+      if (async) dst->push_back(CallAsync(kAsyncCommit, {}));
+    };
+
+    std::vector<Expr> pipeline;
+    // prologue, the readers of the tiles before the loop should finish before the tiles are overwritten
+    if (leading_sync) pipeline.push_back(SyncThreads());
+    for (int k = 0; k < num_stages - 1; k++) {
+      append(&pipeline, at(loads, Expr(k), Expr(k), async));
+      commit(&pipeline);
+    }
+
+    // steady state, the tiles of ko are waited and the buffer of ko - 1 is free to load ko + stages - 1
+    std::vector<Expr> body;
+    wait(&body, num_stages - 2);
+    Expr next = Expr(ko) + Expr(num_stages - 1);
+    append(&body, at(loads, next, ir::Mod::Make(next, Expr(num_stages)), async));
+    commit(&body);
+    append(&body, at(computes, Expr(ko), ir::Mod::Make(Expr(ko), Expr(num_stages)), false));
+    auto steady = ir::For::Make(ko,
+                                Expr(0),
+                                Expr(extent - (num_stages - 1)),
+                                op->for_type(),
+                                op->device_api,
+                                ir::Block::Make(body),
+                                op->vectorize_info());
+    steady.As<ir::For>()->set_pipeline_stages(0);
+    pipeline.push_back(steady);
+
+    // epilogue, the tiles of the last stages - 1 iterations are loaded
+    for (int e = 0; e < num_stages - 1; e++) {
+      int k = extent - (num_stages - 1) + e;
+      wait(&pipeline, num_stages - 2 - e);
+      append(&pipeline, at(computes, Expr(k), Expr(k % num_stages), false));
+    }
+
+    for (auto& item : tiles) {
+      auto& stages = buffer_stages[item.second->buffer->name];
+      stages       = std::max(stages, num_stages);
+    }
+    *expr = ir::Block::Make(pipeline);
+  }
+};
+
+}  // namespace
+
+void PipelineLoops(Expr* expr) {
+  PipelineMutator mutator;
+  mutator(expr);
+  if (mutator.buffer_stages.empty()) return;
+
+  // the tiles are declared by the temporary buffers of the function
+  auto* func = expr->As<ir::_LoweredFunc_>();
+  CHECK(func) << "The pipelined loops should be in a function to grow the buffers of the shared tiles";
+  for (auto& buffer : func->temp_bufs) {
+    auto it = mutator.buffer_stages.find(buffer->name);
+    if (it == mutator.buffer_stages.end()) continue;
+    auto grown = IRCopy(Expr(buffer)).as_buffer_ref();
+    CHECK(!grown->shape.empty());
+    grown->shape.front() = grown->shape.front() * Expr(it->second);
+    Simplify(&grown->shape.front());
+    VLOG(3) << "Grow the shared buffer " << grown->name << " by " << it->second << " stages";
+    buffer = grown;
+  }
+}
+
+}  // namespace optim
+}  // namespace cinn
@@ -0,0 +1,48 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "cinn/ir/ir.h"
+
+namespace cinn {
+namespace optim {
+
+/**
+ * Pipeline the loops marked by Stage::Pipeline over the multiple buffers of the shared memory tiles loaded in their
+ * bodies. The tiles of the next stages - 1 iterations are loaded while the tiles of the current one are computed, so a
+ * single __syncthreads is needed per iteration, e.g. the 2 stages
+ *
+ * for (ko, 0, 8)
+ *   __syncthreads()
+ *   AS[i, j] = A[i, ko * 4 + j]
+ *   __syncthreads()
+ *   C[i] = (C[i] + AS[i, 0])
+ *
+ * to
+ *
+ * AS[i, j] = A[i, j]
+ * for (ko, 0, 7)
+ *   __syncthreads()
+ *   AS[i + ((ko + 1) % 2) * 16, j] = A[i, (ko + 1) * 4 + j]
+ *   C[i] = (C[i] + AS[i + (ko % 2) * 16, 0])
+ * __syncthreads()
+ * C[i] = (C[i] + AS[i + 16, 0])
+ *
+ * where the buffer of the [16, 4] AS grows to [32, 4]. The float32 elements copied from the global to the shared
+ * memory are copied by cp.async in the groups committed per iteration, which are waited before the __syncthreads.
+ */
+void PipelineLoops(Expr* expr);
+
+}  // namespace optim
+}  // namespace cinn
@@ -0,0 +1,480 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/promote_temp_buffers.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cinn/ir/ir_hash.h"
+#include "cinn/ir/ir_mutator.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/ir/lowered_func.h"
+#include "cinn/optim/ir_copy.h"
+
+namespace cinn {
+namespace optim {
+
+namespace {
+
+//! A load or a store of a temporary, with the loops enclosing it from the outermost.
+struct TempAccess {
+  bool is_store{false};
+  std::vector<Expr> indices;
+  std::vector<const ir::For *> loops;
+};
+
+//! The accesses of a temporary buffer, and the first and the last statements of the function body accessing it.
+struct TempUsage {
+  ir::Tensor tensor;
+  std::set<std::string> tensor_names;
+  std::vector<TempAccess> accesses;
+  bool escaped{false};
+  int first_stmt{-1};
+  int last_stmt{-1};
+
+  //! Whether the buffer holds a single tensor only loaded and stored.
+  bool promotable() const { return !escaped && tensor_names.size() == 1U && !accesses.empty(); }
+};
+
+//! Collect the loads and the stores of the temporary buffers, each once per occurrence.
+struct TempAccessCollector : public ir::IRVisitor {
+  //! The usages by the names of the temporary buffers.
+  std::map<std::string, TempUsage> usages;
+
+  explicit TempAccessCollector(const std::vector<ir::Buffer> &buffers) {
+    for (auto &buffer : buffers) usages[buffer->name];
+  }
+
+  void Collect(const Expr &body) {
+    auto *block = body.As<ir::Block>();
+    if (!block) return Visit(&body);
+    for (stmt_ = 0; stmt_ < block->stmts.size(); stmt_++) Visit(&block->stmts[stmt_]);
+  }
+
+  void Visit(const Expr *x) override {
+    switch (x->node_type()) {
+      case ir::IrNodeTy::For:
+        loops_.push_back(x->As<ir::For>());
+        ir::IRVisitor::Visit(x);
+        loops_.pop_back();
+        return;
+      case ir::IrNodeTy::Load: {
+        auto *load = x->As<ir::Load>();
+        Record(load->tensor, false, load->indices);
+        for (auto &index : load->indices) Visit(&index);
+        return;
+      }
+      case ir::IrNodeTy::Store: {
+        auto *store = x->As<ir::Store>();
+        Record(store->tensor, true, store->indices);
+        Visit(&store->value);
+        for (auto &index : store->indices) Visit(&index);
+        return;
+      }
+      // referred by anything else, e.g. the arguments of the calls
+      case ir::IrNodeTy::_Tensor_: {
+        auto *tensor = x->As<ir::_Tensor_>();
+        if (tensor->buffer.defined()) Escape(tensor->buffer->name);
+        return;
+      }
+      case ir::IrNodeTy::_Buffer_:
+        Escape(x->As<ir::_Buffer_>()->name);
+        return;
+      case ir::IrNodeTy::IntrinsicOp:
+        // the fields of the intrinsics are opaque, and may be the addresses of any buffer
+        for (auto &item : usages) item.second.escaped = true;
+        return;
+      default:
+        ir::IRVisitor::Visit(x);
+    }
+  }
+
+#define __m(t__)                          \
+  void Visit(const ir::t__ *x) override { \
+    for (auto *n : x->expr_fields()) {    \
+      if (n->defined()) Visit(n);         \
+    }                                     \
+  }
+  NODETY_FORALL(__m)
+#undef __m
+
+ private:
+  void Record(const Expr &tensor, bool is_store, const std::vector<Expr> &indices) {
+    auto *t = tensor.as_tensor();
+    if (!t || !t->buffer.defined()) return;
+    auto it = usages.find(t->buffer->name);
+    if (it == usages.end()) return;
+    auto &usage  = it->second;
+    usage.tensor = tensor.as_tensor_ref();
+    usage.tensor_names.insert(t->name);
+    usage.accesses.push_back({is_store, indices, loops_});
+    if (usage.first_stmt < 0) usage.first_stmt = stmt_;
+    usage.last_stmt = stmt_;
+  }
+
+  void Escape(const std::string &buffer) {
+    auto it = usages.find(buffer);
+    if (it != usages.end()) it->second.escaped = true;
+  }
+
+  std::vector<const ir::For *> loops_;
+  int stmt_{0};
+};
+
+//! Count the loads of a tensor, and tell if any of them is in a loop redefining the vars of their indices.
+struct LoadCounter : public ir::IRVisitor {
+  LoadCounter(const std::string &tensor, const std::set<std::string> &index_vars)
+      : tensor_(tensor), index_vars_(index_vars) {}
+
+  int num_loads{0};
+  bool shadowed{false};
+
+  void Visit(const Expr *x) override {
+    std::string loop_var;
+    if (auto *loop = x->As<ir::For>()) loop_var = loop->loop_var->name;
+    if (auto *loop = x->As<ir::PolyFor>()) loop_var = loop->iterator->name;
+    bool redefines = index_vars_.count(loop_var) > 0;
+    if (auto *load = x->As<ir::Load>()) {
+      if (load->tensor.as_tensor() && load->tensor.as_tensor()->name == tensor_) {
+        num_loads++;
+        shadowed |= redefining_loops_ > 0;
+      }
+    }
+    redefining_loops_ += redefines;
+    ir::IRVisitor::Visit(x);
+    redefining_loops_ -= redefines;
+  }
+
+#define __m(t__)                          \
+  void Visit(const ir::t__ *x) override { \
+    for (auto *n : x->expr_fields()) {    \
+      if (n->defined()) Visit(n);         \
+    }                                     \
+  }
+  NODETY_FORALL(__m)
+#undef __m
+
+ private:
+  const std::string &tensor_;
+  const std::set<std::string> &index_vars_;
+  int redefining_loops_{0};
+};
+
+struct LoadReplacer : public ir::IRMutator<Expr *> {
+  LoadReplacer(const std::string &tensor, const Expr &value) : tensor_(tensor), value_(value) {}
+
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::Load *op, Expr *expr) override {
+    auto *tensor = op->tensor.as_tensor();
+    if (tensor && tensor->name == tensor_) {
+      *expr = value_;
+      return;
+    }
+    ir::IRMutator<>::Visit(op, expr);
+  }
+
+  const std::string &tensor_;
+  const Expr &value_;
+};
+
+//! A temporary stored once and loaded at the same indices.
+struct ScalarCandidate {
+  int num_loads{0};
+  std::set<std::string> index_vars;
+};
+
+//! Replace the store of each candidate by a Let node, if the statements after it in its block have all the loads.
+struct ScalarizeMutator : public ir::IRMutator<Expr *> {
+  explicit ScalarizeMutator(const std::map<std::string, ScalarCandidate> &candidates) : candidates_(candidates) {}
+
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+  //! The names of the tensors kept in the registers.
+  std::set<std::string> scalarized;
+
+ private:
+  void Visit(const ir::Block *op, Expr *expr) override {
+    auto *node = expr->As<ir::Block>();
+    for (int i = 0; i < node->stmts.size(); i++) {
+      Scalarize(&node->stmts, i);
+      ir::IRMutator<>::Visit(&node->stmts[i], &node->stmts[i]);
+    }
+  }
+
+  void Scalarize(std::vector<Expr> *stmts, int i) {
+    auto *store = (*stmts)[i].As<ir::Store>();
+    if (!store || !store->tensor.as_tensor()) return;
+    std::string name = store->tensor.as_tensor()->name;
+    auto it          = candidates_.find(name);
+    if (it == candidates_.end()) return;
+    int num_loads = 0;
+    for (int j = i + 1; j < stmts->size(); j++) {
+      LoadCounter counter(name, it->second.index_vars);
+      counter.Visit(&(*stmts)[j]);
+      if (counter.shadowed) return;
+      num_loads += counter.num_loads;
+    }
+    if (num_loads != it->second.num_loads) return;
+
+    Expr value = store->value;
+    Expr reg   = Var(name + "_reg", value.type());
+    for (int j = i + 1; j < stmts->size(); j++) LoadReplacer(name, reg)(&(*stmts)[j]);
+    (*stmts)[i] = ir::Let::Make(reg, value);
+    VLOG(3) << "Keep the temporary " << name << " in a register";
+    scalarized.insert(name);
+    candidates_.erase(it);
+  }
+
+  std::map<std::string, ScalarCandidate> candidates_;
+};
+
+//! Replace the tensors of the loads and the stores of the temporaries, without the indices of their dropped dims.
+struct TempTensorReplacer : public ir::IRMutator<Expr *> {
+  struct Replacement {
+    ir::Tensor tensor;
+    std::vector<bool> dropped;
+  };
+  std::map<std::string, Replacement> replacements;
+
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::Load *op, Expr *expr) override {
+    ir::IRMutator<>::Visit(op, expr);
+    auto *node = expr->As<ir::Load>();
+    Replace(&node->tensor, &node->indices);
+  }
+
+  void Visit(const ir::Store *op, Expr *expr) override {
+    ir::IRMutator<>::Visit(op, expr);
+    auto *node = expr->As<ir::Store>();
+    Replace(&node->tensor, &node->indices);
+  }
+
+  void Replace(Expr *tensor, std::vector<Expr> *indices) {
+    auto *t = tensor->as_tensor();
+    if (!t || !replacements.count(t->name)) return;
+    auto &replacement = replacements.at(t->name);
+    CHECK_EQ(indices->size(), replacement.dropped.size());
+    std::vector<Expr> kept;
+    for (int i = 0; i < indices->size(); i++) {
+      if (!replacement.dropped[i]) kept.push_back((*indices)[i]);
+    }
+    if (kept.empty()) kept.push_back(Expr(0));
+    *tensor  = Expr(replacement.tensor);
+    *indices = kept;
+  }
+};
+
+bool HasConstantShape(const ir::Tensor &tensor) {
+  return std::all_of(tensor->shape.begin(), tensor->shape.end(), [](const Expr &dim) { return dim.is_constant(); });
+}
+
+int64_t GetNumel(const std::vector<Expr> &shape) {
+  int64_t numel = 1;
+  for (auto &dim : shape) numel *= dim.as_int64();
+  return numel;
+}
+
+std::map<std::string, ScalarCandidate> GetScalarCandidates(const std::map<std::string, TempUsage> &usages) {
+  std::map<std::string, ScalarCandidate> candidates;
+  for (auto &item : usages) {
+    auto &usage = item.second;
+    if (!usage.promotable()) continue;
+    int num_stores = std::count_if(
+        usage.accesses.begin(), usage.accesses.end(), [](const TempAccess &access) { return access.is_store; });
+    auto &store = *std::find_if(
+        usage.accesses.begin(), usage.accesses.end(), [](const TempAccess &access) { return access.is_store; });
+    if (num_stores != 1 || usage.accesses.size() < 2U) continue;
+    bool same_indices = std::all_of(usage.accesses.begin(), usage.accesses.end(), [&](const TempAccess &access) {
+      if (access.indices.size() != store.indices.size()) return false;
+      for (int i = 0; i < access.indices.size(); i++) {
+        if (access.indices[i].type().is_vector() || !ir::ExprStructuralEqual()(access.indices[i], store.indices[i])) {
+          return false;
+        }
+      }
+      return true;
+    });
+    if (!same_indices) continue;
+    auto &candidate     = candidates[usage.tensor->name];
+    candidate.num_loads = usage.accesses.size() - 1;
+    for (auto &index : store.indices) {
+      for (auto &var : ir::CollectIRNodes(index, [](const Expr *x) { return x->As<ir::_Var_>(); })) {
+        candidate.index_vars.insert(var.As<ir::_Var_>()->name);
+      }
+    }
+  }
+  return candidates;
+}
+
+//! The dims of a temporary indexed by the same serial loop enclosing all its accesses, or by the same constant.
+std::vector<bool> GetDroppedDims(const TempUsage &usage) {
+  auto common = usage.accesses.front().loops;
+  for (auto &access : usage.accesses) {
+    int depth = 0;
+    while (depth < common.size() && depth < access.loops.size() && common[depth] == access.loops[depth]) depth++;
+    common.resize(depth);
+  }
+  std::set<std::string> serial_vars;
+  for (auto *loop : common) {
+    if (!loop->is_parallel()) serial_vars.insert(loop->loop_var->name);
+  }
+
+  int rank = usage.tensor->shape.size();
+  std::vector<bool> dropped(rank, false);
+  for (auto &access : usage.accesses) {
+    if (access.indices.size() != rank) return dropped;
+  }
+  for (int i = 0; i < rank; i++) {
+    auto &index = usage.accesses.front().indices[i];
+    bool same   = std::all_of(usage.accesses.begin(), usage.accesses.end(), [&](const TempAccess &access) {
+      return ir::ExprStructuralEqual()(access.indices[i], index);
+    });
+    dropped[i]  = same && (index.is_constant() || (index.as_var() && serial_vars.count(index.as_var()->name)));
+  }
+  return dropped;
+}
+
+}  // namespace
+
+void PromoteTempBuffers(Expr *expr) {
+  auto *func = expr->As<ir::_LoweredFunc_>();
+  if (!func) return;
+  std::vector<ir::Buffer> temp_bufs;
+  for (auto &buffer : func->temp_bufs) {
+    if (buffer->memory_type == ir::MemoryType::Heap) temp_bufs.push_back(buffer);
+  }
+  if (temp_bufs.empty()) return;
+
+  // 1. the temporaries stored once are kept in the registers
+  std::set<std::string> scalarized;
+  {
+    TempAccessCollector collector(temp_bufs);
+    collector.Collect(func->body);
+    auto candidates = GetScalarCandidates(collector.usages);
+    if (!candidates.empty()) {
+      ScalarizeMutator mutator(candidates);
+      mutator(&func->body);
+      for (auto &item : collector.usages) {
+        if (item.second.promotable() && mutator.scalarized.count(item.second.tensor->name)) {
+          scalarized.insert(item.first);
+        }
+      }
+    }
+  }
+
+  TempAccessCollector collector(temp_bufs);
+  collector.Collect(func->body);
+  struct Temp {
+    std::string buffer;
+    TempUsage *usage;
+    std::vector<bool> dropped;
+    std::vector<Expr> shape;
+  };
+  std::vector<Temp> temps;
+  for (auto &item : collector.usages) {
+    auto &usage = item.second;
+    if (!usage.promotable() || !HasConstantShape(usage.tensor)) continue;
+    Temp temp{item.first, &usage, GetDroppedDims(usage), {}};
+    for (int i = 0; i < temp.dropped.size(); i++) {
+      if (!temp.dropped[i]) temp.shape.push_back(usage.tensor->shape[i]);
+    }
+    if (temp.shape.empty()) temp.shape.push_back(Expr(1));
+    temps.push_back(temp);
+  }
+
+  // 2. the dims of each iteration are dropped, and the temporaries accessed by the disjoint statements share the
+  // buffers, each of which is reused by the earliest temporary of the same type after it is dead, the smallest one
+  // large enough if any
+  std::sort(temps.begin(), temps.end(), [](const Temp &a, const Temp &b) {
+    return a.usage->first_stmt < b.usage->first_stmt;
+  });
+  struct SharedBuffer {
+    const Temp *host;
+    int64_t numel;
+    int last_stmt;
+    int num_temps;
+  };
+  std::vector<SharedBuffer> shared;
+  std::map<std::string, int> shared_of;
+  bool reuse = func->body.As<ir::Block>() != nullptr;
+  for (auto &temp : temps) {
+    int64_t numel = GetNumel(temp.shape);
+    int best      = -1;
+    for (int i = 0; reuse && i < shared.size(); i++) {
+      auto &buffer = shared[i];
+      if (buffer.last_stmt >= temp.usage->first_stmt) continue;
+      if (buffer.host->usage->tensor->type() != temp.usage->tensor->type()) continue;
+      if (best < 0) {
+        best = i;
+        continue;
+      }
+      int64_t best_numel = shared[best].numel;
+      bool fits = buffer.numel >= numel, best_fits = best_numel >= numel;
+      if ((fits && (!best_fits || buffer.numel < best_numel)) || (!fits && !best_fits && buffer.numel > best_numel)) {
+        best = i;
+      }
+    }
+    if (best < 0) {
+      best = shared.size();
+      shared.push_back({&temp, numel, temp.usage->last_stmt, 0});
+    }
+    auto &buffer     = shared[best];
+    buffer.numel     = std::max(buffer.numel, numel);
+    buffer.last_stmt = temp.usage->last_stmt;
+    buffer.num_temps++;
+    shared_of[temp.buffer] = best;
+  }
+
+  TempTensorReplacer replacer;
+  std::map<std::string, ir::Buffer> new_buffers;
+  for (auto &temp : temps) {
+    auto &buffer  = shared[shared_of.at(temp.buffer)];
+    bool contract = std::find(temp.dropped.begin(), temp.dropped.end(), true) != temp.dropped.end();
+    if (!contract && buffer.num_temps == 1) continue;
+    auto &host = buffer.host->usage->tensor;
+    if (!new_buffers.count(buffer.host->buffer)) {
+      auto new_buffer   = IRCopy(Expr(host->buffer)).as_buffer_ref();
+      new_buffer->shape = buffer.num_temps == 1 ? temp.shape : std::vector<Expr>({Expr(buffer.numel)});
+      new_buffers[buffer.host->buffer] = new_buffer;
+    }
+    auto tensor    = IRCopy(Expr(temp.usage->tensor)).as_tensor_ref();
+    tensor->name   = host->name;
+    tensor->shape  = temp.shape;
+    tensor->buffer = new_buffers.at(buffer.host->buffer);
+    replacer.replacements[temp.usage->tensor->name] = {tensor, temp.dropped};
+    VLOG(3) << "Store the temporary " << temp.usage->tensor->name << " of " << GetNumel(temp.shape)
+            << " elements in the buffer " << tensor->buffer->name;
+  }
+  if (scalarized.empty() && replacer.replacements.empty()) return;
+  replacer(&func->body);
+
+  std::vector<ir::Buffer> new_temp_bufs;
+  for (auto &buffer : func->temp_bufs) {
+    if (scalarized.count(buffer->name)) continue;
+    if (shared_of.count(buffer->name) && shared[shared_of.at(buffer->name)].host->buffer != buffer->name) continue;
+    new_temp_bufs.push_back(new_buffers.count(buffer->name) ? new_buffers.at(buffer->name) : buffer);
+  }
+  func->temp_bufs = new_temp_bufs;
+  func->UpdateBufferCastExprs();
+}
+
+}  // namespace optim
+}  // namespace cinn
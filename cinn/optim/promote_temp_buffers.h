@@ -0,0 +1,51 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "cinn/ir/ir.h"
+
+namespace cinn {
+namespace optim {
+
+/**
+ * Shrink the temporary heap buffers of a function on the host, each of which holds a tensor computed and consumed in
+ * the function only.
+ *
+ * 1. A temporary stored once by a statement of a block and only loaded at the same indices by the statements after it
+ *    is kept in a register by a Let node, and its buffer is dropped, e.g.
+ *
+ * for (j, 0, 64)
+ *   T[i, j] = A[i, j] * 2
+ *   C[i, j] = T[i, j] + T[i, j] * T[i, j]
+ *
+ * to
+ *
+ * for (j, 0, 64)
+ *   float T_reg = A[i, j] * 2
+ *   C[i, j] = T_reg + T_reg * T_reg
+ *
+ * 2. A dim indexed by the same serial loop enclosing all the accesses of a temporary, or by the same constant, is
+ *    dropped, since each iteration of the loop reads back only what it writes, e.g. the T[i, j] of a reduction
+ *    accumulated across the loop of k and accessed only in the loop of i keeps the elements of one row T[j].
+ *
+ * 3. The temporaries of the same element type whose accesses are in the disjoint statements of the function body share
+ *    a buffer large enough for either, so that the later ones reuse the memory hot in the cache.
+ *
+ * The temporaries referred by anything else than the loads and the stores, e.g. the calls taking their addresses, are
+ * kept as they are.
+ */
+void PromoteTempBuffers(Expr* expr);
+
+}  // namespace optim
+}  // namespace cinn
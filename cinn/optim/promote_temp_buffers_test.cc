@@ -0,0 +1,95 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/promote_temp_buffers.h"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "cinn/backends/llvm/execution_engine.h"
+#include "cinn/cinn.h"
+#include "cinn/common/test_helper.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/utils/string.h"
+
+namespace cinn::optim {
+
+namespace {
+void RunAndCheck(Module::Builder* builder, int numel, std::function<float(float)> expected) {
+  auto jit = backends::ExecutionEngine::Create({});
+  jit->Link(builder->Build());
+  auto fn = jit->Lookup("fn");
+  CHECK(fn);
+  auto fn_ = reinterpret_cast<void (*)(void*, int32_t)>(fn);
+
+  cinn_buffer_t* A_buf = common::BufferBuilder(Float(32), {numel}).set_random().Build();
+  cinn_buffer_t* C_buf = common::BufferBuilder(Float(32), {numel}).set_zero().Build();
+  cinn_pod_value_t a_arg(A_buf), c_arg(C_buf);
+  std::vector<cinn_pod_value_t> args = {a_arg, c_arg};
+  fn_(reinterpret_cast<void**>(args.data()), args.size());
+
+  auto* ad = reinterpret_cast<float*>(A_buf->memory);
+  auto* cd = reinterpret_cast<float*>(C_buf->memory);
+  for (int i = 0; i < numel; i++) {
+    ASSERT_NEAR(cd[i], expected(ad[i]), 1e-5);
+  }
+}
+}  // namespace
+
+TEST(PromoteTempBuffers, scalarize) {
+  const int M = 32, N = 64;
+  Placeholder<float> A("A", {Expr(M), Expr(N)});
+  auto B = Compute(
+      {Expr(M), Expr(N)}, [&](Var i, Var j) { return A(i, j) * 2.f; }, "B");
+  auto C = Compute(
+      {Expr(M), Expr(N)}, [&](Var i, Var j) { return B(i, j) + B(i, j) * B(i, j); }, "C");
+  auto stages = CreateStages({C});
+  stages[B]->ComputeAt(stages[C], 1);
+
+  Module::Builder builder("module0", common::DefaultHostTarget());
+  auto func = Lower("fn", stages, {A, C}, {}, {}, &builder, common::DefaultHostTarget());
+  LOG(INFO) << func;
+  // B is computed and consumed in one iteration, so it is in a register and its buffer is dropped
+  EXPECT_NE(utils::GetStreamCnt(func).find("B_reg"), std::string::npos);
+  EXPECT_TRUE(func->temp_bufs.empty());
+
+  RunAndCheck(&builder, M * N, [](float a) { return a * 2.f + a * a * 4.f; });
+}
+
+TEST(PromoteTempBuffers, reuse_dead_buffers) {
+  const int M = 32, N = 64;
+  Placeholder<float> A("A", {Expr(M), Expr(N)});
+  auto B = Compute(
+      {Expr(M), Expr(N)}, [&](Var i, Var j) { return A(i, j) * 2.f; }, "B");
+  auto C = Compute(
+      {Expr(M), Expr(N)}, [&](Var i, Var j) { return B(i, j) + 1.f; }, "C");
+  auto D = Compute(
+      {Expr(M), Expr(N)}, [&](Var i, Var j) { return C(i, j) * 3.f; }, "D");
+  auto E = Compute(
+      {Expr(M), Expr(N)}, [&](Var i, Var j) { return D(i, j) - 1.f; }, "E");
+  auto stages = CreateStages({E});
+
+  Module::Builder builder("module0", common::DefaultHostTarget());
+  auto func = Lower("fn", stages, {A, E}, {}, {}, &builder, common::DefaultHostTarget());
+  LOG(INFO) << func;
+  // B is dead when D is computed, which reuses its buffer
+  EXPECT_LT(func->temp_bufs.size(), 3UL);
+
+  RunAndCheck(&builder, M * N, [](float a) { return (a * 2.f + 1.f) * 3.f - 1.f; });
+}
+
+}  // namespace cinn::optim
@@ -0,0 +1,173 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/reduce_div_mod.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "cinn/common/ir_util.h"
+#include "cinn/ir/ir_mutator.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/optim/index_range.h"
+
+namespace cinn {
+namespace optim {
+
+namespace {
+
+//! A term coef * expr of a sum, the expr of the constant term is undefined.
+struct Term {
+  int64_t coef;
+  Expr expr;
+};
+
+void CollectTerms(const Expr &expr, int64_t sign, std::vector<Term> *terms) {
+  if (auto *add = expr.As<ir::Add>()) {
+    CollectTerms(add->a(), sign, terms);
+    CollectTerms(add->b(), sign, terms);
+  } else if (auto *sub = expr.As<ir::Sub>()) {
+    CollectTerms(sub->a(), sign, terms);
+    CollectTerms(sub->b(), -sign, terms);
+  } else if (auto *imm = expr.As<ir::IntImm>()) {
+    terms->push_back({sign * imm->value, Expr()});
+  } else if (expr.As<ir::Mul>() && expr.As<ir::Mul>()->b().As<ir::IntImm>()) {
+    terms->push_back({sign * expr.As<ir::Mul>()->b().As<ir::IntImm>()->value, expr.As<ir::Mul>()->a()});
+  } else if (expr.As<ir::Mul>() && expr.As<ir::Mul>()->a().As<ir::IntImm>()) {
+    terms->push_back({sign * expr.As<ir::Mul>()->a().As<ir::IntImm>()->value, expr.As<ir::Mul>()->b()});
+  } else {
+    terms->push_back({sign, expr});
+  }
+}
+
+Expr MakeSum(const std::vector<Term> &terms, const Type &type) {
+  Expr sum;
+  int64_t constant = 0;
+  for (auto &term : terms) {
+    if (!term.expr.defined()) {
+      constant += term.coef;
+      continue;
+    }
+    if (term.coef == 0) continue;
+    Expr x = term.coef == 1 ? term.expr : ir::Mul::Make(term.expr, common::make_const(type, term.coef));
+    sum    = sum.defined() ? ir::Add::Make(sum, x) : x;
+  }
+  if (!sum.defined()) return common::make_const(type, constant);
+  if (constant != 0) sum = ir::Add::Make(sum, common::make_const(type, constant));
+  return sum;
+}
+
+struct ReduceDivModMutator : public ir::IRMutator<Expr *> {
+  void operator()(Expr *expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::For *op, Expr *expr) override {
+    auto *node = expr->As<ir::For>();
+    ir::IRMutator<>::Visit(&node->min, &node->min);
+    ir::IRMutator<>::Visit(&node->extent, &node->extent);
+
+    std::string name = node->loop_var->name;
+    auto it          = ranges_.find(name);
+    bool shadowed    = it != ranges_.end();
+    IndexRange old   = shadowed ? it->second : IndexRange{0, 0};
+    ranges_.erase(name);
+    IndexRange min, extent;
+    if (GetRange(node->min, &min) && GetRange(node->extent, &extent) && extent.max > min.min) {
+      ranges_[name] = IndexRange{min.min, extent.max - 1};
+    }
+    ir::IRMutator<>::Visit(&node->body, &node->body);
+    ranges_.erase(name);
+    if (shadowed) ranges_[name] = old;
+  }
+
+  void Visit(const ir::Div *op, Expr *expr) override {
+    ir::IRMutator<>::Visit(op, expr);
+    while (expr->As<ir::Div>() && ReduceDiv(expr)) {
+    }
+  }
+
+  void Visit(const ir::Mod *op, Expr *expr) override {
+    ir::IRMutator<>::Visit(op, expr);
+    while (expr->As<ir::Mod>() && ReduceMod(expr)) {
+    }
+  }
+
+  bool GetRange(const Expr &expr, IndexRange *range) const { return GetIndexRange(expr, ranges_, range); }
+
+  //! Split x / c or x % c by the terms of x, the terms except for the multiples of c must fall into a multiple of c.
+  bool SplitTerms(const Expr &x, int64_t c, std::vector<Term> *quotient, std::vector<Term> *rest, int64_t *k) const {
+    IndexRange range;
+    // the truncated division is the floor division only if x is not negative
+    if (!GetRange(x, &range) || range.min < 0) return false;
+    std::vector<Term> terms;
+    CollectTerms(x, 1, &terms);
+    for (auto &term : terms) (term.coef % c == 0 ? quotient : rest)->push_back(term);
+    IndexRange rest_range;
+    if (!GetRange(MakeSum(*rest, x.type()), &rest_range) || rest_range.min < 0) return false;
+    if (rest_range.min / c != rest_range.max / c) return false;
+    *k = rest_range.min / c;
+    return true;
+  }
+
+  bool ReduceDiv(Expr *expr) const {
+    auto *node = expr->As<ir::Div>();
+    Type type  = node->type();
+    int64_t c;
+    if (!type.is_int() || type.lanes() != 1 || !GetPositiveConstant(node->b(), &c)) return false;
+
+    int64_t a;
+    if (node->a().As<ir::Div>() && GetPositiveConstant(node->a().As<ir::Div>()->b(), &a)) {
+      *expr = ir::Div::Make(node->a().As<ir::Div>()->a(), common::make_const(type, a * c));
+      return true;
+    }
+    std::vector<Term> quotient, rest;
+    int64_t k;
+    if (!SplitTerms(node->a(), c, &quotient, &rest, &k)) return false;
+    for (auto &term : quotient) term.coef /= c;
+    quotient.push_back({k, Expr()});
+    VLOG(4) << "reduce " << *expr << " to " << MakeSum(quotient, type);
+    *expr = MakeSum(quotient, type);
+    return true;
+  }
+
+  bool ReduceMod(Expr *expr) const {
+    auto *node = expr->As<ir::Mod>();
+    Type type  = node->type();
+    int64_t c;
+    if (!type.is_int() || type.lanes() != 1 || !GetPositiveConstant(node->b(), &c)) return false;
+
+    int64_t a;
+    if (node->a().As<ir::Mod>() && GetPositiveConstant(node->a().As<ir::Mod>()->b(), &a) && a % c == 0) {
+      *expr = ir::Mod::Make(node->a().As<ir::Mod>()->a(), node->b());
+      return true;
+    }
+    std::vector<Term> quotient, rest;
+    int64_t k;
+    if (!SplitTerms(node->a(), c, &quotient, &rest, &k)) return false;
+    rest.push_back({-k * c, Expr()});
+    VLOG(4) << "reduce " << *expr << " to " << MakeSum(rest, type);
+    *expr = MakeSum(rest, type);
+    return true;
+  }
+
+  std::map<std::string, IndexRange> ranges_;
+};
+
+}  // namespace
+
+void ReduceDivMod(Expr *expr) { ReduceDivModMutator()(expr); }
+
+}  // namespace optim
+}  // namespace cinn
@@ -0,0 +1,42 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "cinn/ir/ir.h"
+
+namespace cinn {
+namespace optim {
+
+/**
+ * Reduce the integer divisions and modulos by the positive constants, which the reshapes and the transposes of the
+ * fused kernels leave in the indices, by the ranges of the loop iterators, e.g.
+ *
+ * for (i, 0, 8)
+ *   for (j, 0, 32)
+ *     B[(i * 32 + j) / 32, (i * 32 + j) % 32] = A[(i * 32 + j) / 32 / 4]
+ *
+ * to
+ *
+ * for (i, 0, 8)
+ *   for (j, 0, 32)
+ *     B[i, j] = A[i / 4]
+ *
+ * 1. x / c and x % c are split by the terms of x, the terms whose coefficients are multiples of c are divided, and the
+ * others must fall into a single multiple of c, if x is not negative.
+ * 2. x / a / c is merged to x / (a * c), and x % a % c to x % c if a is a multiple of c.
+ */
+void ReduceDivMod(Expr* expr);
+
+}  // namespace optim
+}  // namespace cinn
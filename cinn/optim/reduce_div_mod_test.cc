@@ -0,0 +1,68 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/reduce_div_mod.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "cinn/common/ir_util.h"
+#include "cinn/ir/ir_operators.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/utils/string.h"
+
+namespace cinn::optim {
+
+Expr MakeSerialFor(Var loop_var, int extent, Expr body) {
+  return ir::For::Make(loop_var,
+                       common::make_const(0),
+                       common::make_const(extent),
+                       ir::ForType::Serial,
+                       ir::DeviceAPI::UNK,
+                       body);
+}
+
+TEST(ReduceDivMod, reshape_indices) {
+  Var i("i"), j("j"), n("n");
+  Expr x = Expr(i) * 32 + j;
+  std::vector<Expr> bodies({x / 32,
+                            x % 32,
+                            x / 32 / 4,
+                            x % 64 % 32,
+                            (x + 7) / 64,
+                            // n is not bounded
+                            (Expr(n) * 32 + j) / 32});
+  std::vector<Expr> stmts;
+  for (size_t k = 0; k < bodies.size(); k++) {
+    stmts.push_back(ir::Let::Make(Var("v" + std::to_string(k)), bodies[k]));
+  }
+  Expr e = MakeSerialFor(i, 8, MakeSerialFor(j, 32, ir::Block::Make(stmts)));
+
+  ReduceDivMod(&e);
+  LOG(INFO) << "\n" << e;
+
+  auto &reduced = e.As<ir::For>()->body.As<ir::For>()->body.As<ir::Block>()->stmts;
+  auto get_body = [&](int k) { return utils::GetStreamCnt(reduced[k].As<ir::Let>()->body); };
+  EXPECT_EQ(get_body(0), "i");
+  EXPECT_EQ(get_body(1), "j");
+  EXPECT_EQ(get_body(2), "(i / 4)");
+  EXPECT_EQ(get_body(3), "j");
+  // (i * 32 + j + 7) / 64 can not be split, as i * 32 is not a multiple of 64
+  EXPECT_EQ(get_body(4), utils::GetStreamCnt((x + 7) / 64));
+  EXPECT_EQ(get_body(5), utils::GetStreamCnt((Expr(n) * 32 + j) / 32));
+}
+
+}  // namespace cinn::optim
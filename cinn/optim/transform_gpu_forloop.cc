@@ -269,8 +269,18 @@ void TransformGpuForloops(const forloop_infos_t &forloop_infos,
 ir::CudaAxisInfo GatherAxisInfoFromStages(const std::vector<poly::Stage *> &stage_group) {
   std::map<std::pair<ir::ForType, uint8_t>, int> gpu_axis_range;
   ir::CudaAxisInfo info;
+  bool use_tensor_core      = false;
+  int block_reduce_threads = 0;
   for (auto *stage : stage_group) {
     if (stage->IfCudaBind()) info.set_valid(true);
+    if (stage->tensor_core_level() >= 0) {
+      info.set_valid(true);
+      use_tensor_core = true;
+    }
+    if (stage->block_reduce_level() >= 0) {
+      info.set_valid(true);
+      block_reduce_threads = std::max(block_reduce_threads, stage->block_reduce_threads());
+    }
     for (auto &item : stage->forloop_infos()) {
       if (item.first < 0) continue;
       int level = poly::isl_get_original_axes_from_optimized_level(stage->transformed_domain().get(), item.first);
@@ -295,6 +305,20 @@ ir::CudaAxisInfo GatherAxisInfoFromStages(const std::vector<poly::Stage *> &stag
         CINN_NOT_IMPLEMENTED
     }
   }
+  if (use_tensor_core) {
+    // the threads of a warp compute the tensor core tiles together
+    CHECK(!gpu_axis_range.count(std::make_pair(ir::ForType::GPUThread, static_cast<uint8_t>(0))))
+        << "threadIdx.x should not be bound in the kernel using the tensor cores";
+    info.set_block_dim(0, 32);
+  }
+  if (block_reduce_threads > 0) {
+    // the block reductions shuffle in the warps along threadIdx.x
+    CHECK(!gpu_axis_range.count(std::make_pair(ir::ForType::GPUThread, static_cast<uint8_t>(1))) &&
+          !gpu_axis_range.count(std::make_pair(ir::ForType::GPUThread, static_cast<uint8_t>(2))))
+        << "threadIdx.y and threadIdx.z should not be bound in the kernel of the block reductions";
+    int threads = std::max(block_reduce_threads, info.block_dim(0));
+    info.set_block_dim(0, (threads + 31) / 32 * 32);
+  }
 
   return info;
 }
@@ -107,6 +107,7 @@ struct PolyForWithSimpleConditionToForMutator : public ir::IRMutator<Expr*> {
 
     Expr new_for =
         ir::For::Make(op->iterator, op->init, rhs, op->for_type(), op->device_api, op->body, op->vectorize_info());
+    new_for.As<ir::For>()->set_pipeline_stages(op->pipeline_stages());
     *expr = new_for;
 
     Visit(&new_for.As<ir::For>()->body);
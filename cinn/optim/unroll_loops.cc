@@ -14,58 +14,160 @@
 
 #include "cinn/optim/unroll_loops.h"
 
+#include <algorithm>
 #include <vector>
 
+#include "cinn/common/ir_util.h"
 #include "cinn/ir/ir_mutator.h"
 #include "cinn/ir/ir_operators.h"
 #include "cinn/ir/ir_printer.h"
 #include "cinn/optim/ir_copy.h"
 #include "cinn/optim/ir_replace.h"
 
+DEFINE_int32(cinn_unroll_max_instrs,
+             0,
+             "The most instructions the copies of an unrolled loop body take, 0 for the default of the target: 512 on "
+             "NVGPU and 1024 on the CPUs, a part of their instruction caches.");
+DEFINE_int32(cinn_unroll_max_registers,
+             0,
+             "The most 32-bit registers the values loaded by the copies of an unrolled loop body take on NVGPU, 0 for "
+             "the default of 64, which keeps the occupancy of the kernels.");
+
 namespace cinn {
 namespace optim {
 
 namespace {
 
+//! Count the nodes of the body, without the bodies of the tensors it loads, each node once per occurrence.
+struct UnrollCostCounter : public ir::IRVisitor {
+  UnrollCost cost;
+
+  void Visit(const Expr* x) override {
+    switch (x->node_type()) {
+      case ir::IrNodeTy::IntImm:
+      case ir::IrNodeTy::UIntImm:
+      case ir::IrNodeTy::FloatImm:
+      case ir::IrNodeTy::StringImm:
+      case ir::IrNodeTy::_Var_:
+      case ir::IrNodeTy::_Buffer_:
+      case ir::IrNodeTy::_Tensor_:
+        return;
+      case ir::IrNodeTy::Block:
+        break;
+      case ir::IrNodeTy::Load: {
+        cost.instrs++;
+        auto type = x->type();
+        cost.registers += std::max(1, type.lanes() * ((type.bits() + 31) / 32));
+        break;
+      }
+      case ir::IrNodeTy::For:
+      case ir::IrNodeTy::PolyFor:
+        // the increment, the comparison and the branch of each iteration
+        cost.instrs += 3;
+        break;
+      default:
+        cost.instrs++;
+    }
+    ir::IRVisitor::Visit(x);
+  }
+
+#define __m(t__)                          \
+  void Visit(const ir::t__* x) override { \
+    for (auto* n : x->expr_fields()) {    \
+      if (n->defined()) Visit(n);         \
+    }                                     \
+  }
+  NODETY_FORALL(__m)
+#undef __m
+};
+
+}  // namespace
+
+UnrollCost EstimateUnrollCost(const Expr& body) {
+  UnrollCostCounter counter;
+  counter.Visit(&body);
+  return counter.cost;
+}
+
+int GetUnrollFactor(int extent, const UnrollCost& cost, const Target& target) {
+  bool is_gpu     = target.arch == Target::Arch::NVGPU;
+  int max_instrs  = FLAGS_cinn_unroll_max_instrs > 0 ? FLAGS_cinn_unroll_max_instrs : (is_gpu ? 512 : 1024);
+  int max_factor  = max_instrs / std::max(cost.instrs, 1);
+  int max_regs    = FLAGS_cinn_unroll_max_registers > 0 ? FLAGS_cinn_unroll_max_registers : 64;
+  // the out-of-order CPUs reuse the registers of the values dead already, so only the instructions count
+  if (is_gpu) max_factor = std::min(max_factor, max_regs / std::max(cost.registers, 1));
+  if (max_factor >= extent) return extent;
+  // a divisor of the extent close to the most copies leaves no remainder
+  for (int factor = max_factor; factor > 1 && factor * 2 >= max_factor; factor--) {
+    if (extent % factor == 0) return factor;
+  }
+  // or the copies of the remainder count too
+  for (int factor = max_factor; factor > 1; factor--) {
+    if (factor + extent % factor <= max_factor) return factor;
+  }
+  return 1;
+}
+
+namespace {
+
 struct UnrollMutator : public ir::IRMutator<Expr*> {
+  explicit UnrollMutator(const Target& target) : target_(target) {}
+
   void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
 
  private:
   void Visit(const ir::For* op, Expr* expr) override {
-    if (is_unrollable(op)) {
-      Unroll(op, expr);
-      IRMutator<>::Visit(expr, expr);
+    auto* node = expr->As<ir::For>();
+    // the inner loops first, so that the cost of the body counts them unrolled
+    ir::IRMutator<>::Visit(&node->body, &node->body);
+    if (!op->is_unrolled() || !op->extent.is_constant()) return;
+
+    int extent = op->extent.as_int32();
+    auto cost  = EstimateUnrollCost(op->body);
+    int factor = GetUnrollFactor(extent, cost, target_);
+    VLOG(4) << "Unroll the loop " << op->loop_var->name << " of extent " << extent << " by " << factor << " for "
+            << cost.instrs << " instructions and " << cost.registers << " registers of each iteration";
+    if (factor >= extent) {
+      std::vector<Expr> body;
+      for (int i = 0; i < extent; i++) body.push_back(Copy(op, op->min + i));
+      *expr = ir::Block::Make(body);
+    } else if (factor > 1) {
+      Unroll(op, factor, expr);
     } else {
-      auto* node = expr->As<ir::For>();
-      ir::IRMutator<>::Visit(&node->body, &node->body);
+      node->set_unrolled(false);
     }
   }
 
-  bool is_unrollable(const ir::For* op) const {
-    return op->is_unrolled() && op->extent.is_constant() && op->extent.as_int32() < 50;
+  //! The copy of the loop body at the iteration \p index.
+  Expr Copy(const ir::For* op, Expr index) {
+    Expr copied = optim::IRCopy(op->body);
+    optim::IrReplace(&copied, op->loop_var, index);
+    return copied;
   }
 
-  //! Unroll a forloop.
-  void Unroll(const ir::For* op, Expr* expr) {
-    std::vector<Expr> body;
-
-    auto* min    = op->min.As<ir::IntImm>();
-    auto* extent = op->extent.As<ir::IntImm>();
-    if (!(min && extent)) return;
-
-    for (int i = min->value; i < extent->value; i++) {
-      Expr start = op->min + i;
-      body.push_back(optim::IRCopy(op->body));
-      optim::IrReplace(&body.back(), op->loop_var, start);
-    }
-
-    *expr = ir::Block::Make(body);
+  //! Unroll a loop partially by \p factor, the remainder iterations follow the loop.
+  void Unroll(const ir::For* op, int factor, Expr* expr) {
+    int extent = op->extent.as_int32();
+    Var outer(op->loop_var->name + "_outer", op->loop_var->type());
+    std::vector<Expr> copies;
+    for (int i = 0; i < factor; i++) copies.push_back(Copy(op, op->min + Expr(outer) * factor + i));
+    Expr loop = ir::For::Make(outer,
+                              common::make_const(0),
+                              common::make_const(extent / factor),
+                              ir::ForType::Serial,
+                              op->device_api,
+                              ir::Block::Make(copies));
+    std::vector<Expr> stmts{loop};
+    for (int i = extent / factor * factor; i < extent; i++) stmts.push_back(Copy(op, op->min + i));
+    *expr = stmts.size() == 1U ? loop : ir::Block::Make(stmts);
   }
+
+  const Target& target_;
 };
 
 }  // namespace
 
-void UnrollLoop(Expr* expr) { UnrollMutator()(expr); }
+void UnrollLoop(Expr* expr, const Target& target) { UnrollMutator{target}(expr); }
 
 }  // namespace optim
 }  // namespace cinn
@@ -13,12 +13,53 @@
 // limitations under the License.
 
 #pragma once
+#include <gflags/gflags.h>
+
+#include "cinn/common/target.h"
 #include "cinn/ir/ir.h"
 
+DECLARE_int32(cinn_unroll_max_instrs);
+DECLARE_int32(cinn_unroll_max_registers);
+
 namespace cinn {
 namespace optim {
 
-void UnrollLoop(Expr* expr);
+//! The cost of an iteration of a loop body estimated from its IR.
+struct UnrollCost {
+  //! The instructions, the arithmetic, the loads, the stores, the calls and the overhead of the inner loops.
+  int instrs{0};
+  //! The 32-bit registers of the values loaded, which the unrolled copies keep live at once on NVGPU.
+  int registers{0};
+};
+
+UnrollCost EstimateUnrollCost(const Expr& body);
+
+/**
+ * The number of copies of the loop body that a loop of \p extent marked unrolled is unrolled by within the budgets of
+ * \p target: the copies take at most FLAGS_cinn_unroll_max_instrs instructions of the instruction cache, and on NVGPU
+ * at most FLAGS_cinn_unroll_max_registers registers of the register file. \p extent means the loop is unrolled fully,
+ * and 1 means it is kept.
+ */
+int GetUnrollFactor(int extent, const UnrollCost& cost, const Target& target);
+
+/**
+ * Unroll the constant-extent loops marked unrolled, the inner ones first, so that the cost of an outer loop covers the
+ * inner loops unrolled in it. A loop too large to unroll fully within the budgets is unrolled partially by a factor,
+ * and the remainder iterations follow it unrolled, e.g. by 4 of
+ *
+ * for (i, 0, 10)
+ *   A[i] = B[i]
+ *
+ * to
+ *
+ * for (i_outer, 0, 2)
+ *   A[i_outer * 4] = B[i_outer * 4]
+ *   ...
+ *   A[i_outer * 4 + 3] = B[i_outer * 4 + 3]
+ * A[8] = B[8]
+ * A[9] = B[9]
+ */
+void UnrollLoop(Expr* expr, const Target& target = common::DefaultHostTarget());
 
 }  // namespace optim
 }  // namespace cinn
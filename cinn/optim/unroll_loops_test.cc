@@ -0,0 +1,97 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/optim/unroll_loops.h"
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include "cinn/common/ir_util.h"
+#include "cinn/ir/ir_operators.h"
+#include "cinn/ir/ir_printer.h"
+#include "cinn/lang/placeholder.h"
+#include "cinn/optim/ir_simplify.h"
+#include "cinn/utils/string.h"
+
+namespace cinn::optim {
+
+// for (i, 0, extent)
+//   B[i] = A[i] + A[i + 1]
+Expr MakeUnrolledLoop(Var i, int extent) {
+  lang::Placeholder<float> A("A", {Expr(extent + 1)});
+  lang::Placeholder<float> B("B", {Expr(extent)});
+  Expr body = ir::Store::Make(B.tensor(), A(Expr(i)) + A(Expr(i) + 1), {Expr(i)});
+  Expr loop = ir::For::Make(
+      i, common::make_const(0), common::make_const(extent), ir::ForType::Serial, ir::DeviceAPI::UNK, body);
+  loop.As<ir::For>()->set_unrolled();
+  return loop;
+}
+
+TEST(UnrollLoop, unroll_factor) {
+  UnrollCost cost;
+  cost.instrs    = 8;
+  cost.registers = 2;
+  // 1024 instructions on the CPUs
+  EXPECT_EQ(GetUnrollFactor(100, cost, common::DefaultHostTarget()), 100);
+  EXPECT_EQ(GetUnrollFactor(256, cost, common::DefaultHostTarget()), 128);
+  // a divisor without the remainder, or the remainder within the budget
+  EXPECT_EQ(GetUnrollFactor(300, cost, common::DefaultHostTarget()), 100);
+  EXPECT_EQ(GetUnrollFactor(131, cost, common::DefaultHostTarget()), 65);
+  // 64 registers on NVGPU
+  EXPECT_EQ(GetUnrollFactor(32, cost, common::DefaultNVGPUTarget()), 32);
+  EXPECT_EQ(GetUnrollFactor(64, cost, common::DefaultNVGPUTarget()), 32);
+  // too large to unroll
+  cost.instrs = 2000;
+  EXPECT_EQ(GetUnrollFactor(4, cost, common::DefaultHostTarget()), 1);
+}
+
+TEST(UnrollLoop, full) {
+  Var i("i");
+  Expr e = MakeUnrolledLoop(i, 4);
+  UnrollLoop(&e);
+  Simplify(&e);
+  LOG(INFO) << "\n" << e;
+  auto* block = e.As<ir::Block>();
+  ASSERT_TRUE(block);
+  ASSERT_EQ(block->stmts.size(), 4UL);
+  EXPECT_EQ(utils::GetStreamCnt(block->stmts[3]), "B[3] = (A[3] + A[4])");
+}
+
+TEST(UnrollLoop, partial) {
+  GFLAGS_NAMESPACE::FlagSaver flag_saver;
+  FLAGS_cinn_unroll_max_instrs = 40;
+  Var i("i");
+  Expr e = MakeUnrolledLoop(i, 11);
+  auto cost = EstimateUnrollCost(e.As<ir::For>()->body);
+  // the store, the add, the loads and the index of the second load
+  EXPECT_EQ(cost.instrs, 5);
+  EXPECT_EQ(cost.registers, 2);
+  UnrollLoop(&e);
+  Simplify(&e);
+  LOG(INFO) << "\n" << e;
+
+  // 8 copies at most, the 5 copies of the loop and the remainder: 11 = 2 * 5 + 1
+  auto* block = e.As<ir::Block>();
+  ASSERT_TRUE(block);
+  ASSERT_EQ(block->stmts.size(), 2UL);
+  auto* loop = block->stmts[0].As<ir::For>();
+  ASSERT_TRUE(loop);
+  EXPECT_FALSE(loop->is_unrolled());
+  EXPECT_EQ(utils::GetStreamCnt(loop->extent), "2");
+  ASSERT_TRUE(loop->body.As<ir::Block>());
+  EXPECT_EQ(loop->body.As<ir::Block>()->stmts.size(), 5UL);
+  EXPECT_EQ(utils::GetStreamCnt(block->stmts[1]), "B[10] = (A[10] + A[11])");
+}
+
+}  // namespace cinn::optim
@@ -17,6 +17,7 @@
 #include <absl/container/flat_hash_map.h>
 
 #include <algorithm>
+#include <functional>
 #include <map>
 #include <string>
 #include <vector>
@@ -341,6 +342,64 @@ class Vectorizer : public IRMutator<Expr *> {
   }
 };
 
+//! Whether the \p index of the loop over \p var accesses the lanes contiguously, or the same element if \p invariant.
+bool IsContiguousIndex(const Expr &index, const Var &var, int lanes, bool invariant) {
+  auto at = [&](int k) {
+    auto copied = IRCopy(index);
+    IrReplace(&copied, Expr(var), Expr(k));
+    Simplify(&copied);
+    return copied;
+  };
+  Expr first = at(0);
+  std::vector<Expr> offsets;
+  for (int k = 1; k < lanes; k++) {
+    Expr offset = at(k) - first;
+    Simplify(&offset);
+    if (!offset.is_constant()) return false;
+    offsets.push_back(offset);
+  }
+  auto is_stride = [&](int stride) {
+    for (int k = 1; k < lanes; k++) {
+      if (offsets[k - 1].as_int32() != k * stride) return false;
+    }
+    return true;
+  };
+  return is_stride(1) || (invariant && is_stride(0));
+}
+
+/**
+ * Whether the body of the loop over \p var could be vectorized to the float2, float4 or half2 loads and stores of
+ * CUDA, the body should store the lane-wise arithmetic of the contiguous or invariant loads to the contiguous elements.
+ */
+bool IsCudaVectorizable(const Expr &body, const Var &var, int lanes) {
+  Expr stmt = body;
+  while (stmt.As<Block>() && stmt.As<Block>()->stmts.size() == 1U) stmt = stmt.As<Block>()->stmts.front();
+  auto *store = stmt.As<Store>();
+  if (!store || !store->tensor.as_tensor()) return false;
+  Type type = store->tensor.as_tensor()->type();
+  if (!(type.is_float(32) && (lanes == 2 || lanes == 4)) && !(type.is_float(16) && lanes == 2)) return false;
+  if (!IsContiguousIndex(store->index(), var, lanes, false)) return false;
+
+  std::function<bool(const Expr &)> is_lane_wise = [&](const Expr &e) -> bool {
+    if (auto *load = e.As<Load>()) {
+      return load->tensor.as_tensor() && load->tensor.as_tensor()->type() == type &&
+             IsContiguousIndex(load->index(), var, lanes, true);
+    }
+    if (e.type() != type) return false;
+    if (e.As<FloatImm>()) return true;
+    if (auto *x = e.As<_Var_>()) return x->name != var->name;
+    if (auto *add = e.As<Add>()) return is_lane_wise(add->a()) && is_lane_wise(add->b());
+    if (auto *sub = e.As<Sub>()) return is_lane_wise(sub->a()) && is_lane_wise(sub->b());
+    if (auto *mul = e.As<Mul>()) return is_lane_wise(mul->a()) && is_lane_wise(mul->b());
+    if (auto *div = e.As<Div>()) return is_lane_wise(div->a()) && is_lane_wise(div->b());
+    // the max and min of half2 need sm_80
+    if (auto *max = e.As<Max>()) return type.is_float(32) && is_lane_wise(max->a()) && is_lane_wise(max->b());
+    if (auto *min = e.As<Min>()) return type.is_float(32) && is_lane_wise(min->a()) && is_lane_wise(min->b());
+    return false;
+  };
+  return is_lane_wise(store->value);
+}
+
 struct VectorizeLoops_ : public IRMutator<Expr *> {
   const Target &target;
   absl::flat_hash_map<std::string, common::CasInterval> var_intervals;
@@ -404,6 +463,12 @@ struct VectorizeLoops_ : public IRMutator<Expr *> {
       var_intervals.emplace(loopvar_name, common::CasInterval{Expr(0), forloop->extent - 1});
     }
     // the extent the forloops marked as Vectorized should be int constant
+    // CUDA only has the vector loads, stores and arithmetic of float2, float4 and half2
+    if (forloop->is_vectorized() && target.arch == Target::Arch::NVGPU &&
+        !IsCudaVectorizable(forloop->body, forloop->loop_var, forloop->vectorize_info().factor)) {
+      VLOG(3) << "The loop " << forloop->loop_var->name << " could not be vectorized on NVGPU, keep it serial";
+      node->reset_vectorize_info();
+    }
     if (forloop->is_vectorized()) {
       Context::info_rgt().Get<int>("vectorized_forloop_count")++;
 
@@ -418,8 +483,15 @@ struct VectorizeLoops_ : public IRMutator<Expr *> {
 
       vectorizable_ = true;
       IRMutator<>::Visit(&node->body, &node->body);
+      if (vectorizable_ && PeelTail(node, expr)) {
+        // the vectorized part is counted again when it is visited
+        Context::info_rgt().Get<int>("vectorized_forloop_count")--;
+        var_intervals.erase(loopvar_name);
+        IRMutator::Visit(expr, expr);
+        return;
+      }
       if (extent_min || extent_max || !vectorizable_) {
-        // not vectorize if has tail blocks, for llvm to optimize
+        // not vectorize the other tail blocks, for llvm to optimize
         node->reset_vectorize_info();
         var_intervals.erase(forloop->loop_var->name);
         return;
@@ -469,6 +541,53 @@ struct VectorizeLoops_ : public IRMutator<Expr *> {
     var_intervals.erase(loopvar_name);
   }
 
+  /**
+   * Peel the iterations not filling the vectors off the vectorized loop \p forloop, into a serial epilogue loop.
+   * 1. If the extent E is a constant not divisible by the factor F, the loop is split to a vectorized loop over
+   * [0, E / F * F) and a serial one over [E / F * F, E).
+   * 2. If the extent is min(F, R), the tail block of a split, the loop is replaced with
+   * if (R >= F) { the vectorized loop over [0, F) } else { a serial loop over [0, R) }.
+   * @return Whether the loop is peeled, the peeled \p expr is not vectorized yet.
+   */
+  bool PeelTail(For *forloop, Expr *expr) {
+    int factor = forloop->vectorize_info().factor;
+    if (!is_zero(forloop->min)) return false;
+
+    Var tail_var(common::UniqName(forloop->loop_var->name + "_tail"));
+    auto make_tail = [&](Expr min, Expr extent) {
+      Expr body = IRCopy(forloop->body);
+      optim::IrReplace(&body, forloop->loop_var, Expr(tail_var));
+      return For::Make(tail_var, min, extent, ForType::Serial, DeviceAPI::UNK, body);
+    };
+
+    if (auto *extent_int = forloop->extent.As<IntImm>()) {
+      int extent = extent_int->value;
+      if (extent <= factor || extent % factor == 0) return false;
+      int main_extent = extent / factor * factor;
+      VLOG(2) << "Peel the tail [" << main_extent << ", " << extent << ") off the loop " << forloop->loop_var;
+      Expr tail       = make_tail(make_const(main_extent), forloop->extent);
+      forloop->extent = make_const(forloop->extent->type(), main_extent);
+      *expr           = Block::Make({*expr, tail});
+      return true;
+    }
+
+    auto *extent_min = forloop->extent.As<Min>();
+    if (!extent_min) return false;
+    Expr rest;
+    if (extent_min->a().As<IntImm>() && extent_min->a().as_int32() == factor) {
+      rest = extent_min->b();
+    } else if (extent_min->b().As<IntImm>() && extent_min->b().as_int32() == factor) {
+      rest = extent_min->a();
+    } else {
+      return false;
+    }
+    VLOG(2) << "Peel the tail block of " << rest << " iterations off the loop " << forloop->loop_var;
+    Expr tail       = make_tail(make_const(0), rest);
+    forloop->extent = make_const(rest->type(), factor);
+    *expr           = IfThenElse::Make(GE::Make(rest, make_const(rest->type(), factor)), *expr, tail);
+    return true;
+  }
+
   //! unroll the forloop if its' extent is min type by solving the condition extent
   //! @return The new forloop.
   bool UnrollCmpFor(For *outer_for, For *inner_for, Expr *expr) {
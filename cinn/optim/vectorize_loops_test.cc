@@ -232,5 +232,30 @@ TEST(Vectorize, single_for) {
   LOG(INFO) << "Forloop\n" << forloop;
 }
 
+TEST(Vectorize, peel_tail) {
+  Context::info_rgt().Clear();
+
+  Placeholder<float> A("A", std::vector<int>{{255}});
+  Placeholder<float> B("B", std::vector<int>{{255}});
+
+  Tensor C = Compute(
+      {Expr(255)}, [&](Var i) { return A(i) + B(i); }, "C");
+  auto stages = CreateStages({C});
+  // 255 is not divisible by 16, the last 15 iterations are left to a serial loop
+  stages[C]->Vectorize(0, 16);
+
+  auto func = Lower("fn", stages, {A, B, C});
+  optim::TransformPolyForToFor(&func->body);
+  optim::VectorizeLoops(&func->body, common::DefaultHostTarget());
+  optim::Simplify(&func->body);
+  LOG(INFO) << func->body;
+
+  auto code = GetStreamCnt(func->body);
+  EXPECT_NE(code.find("Ramp("), std::string::npos);
+  EXPECT_NE(code.find("_tail"), std::string::npos);
+  EXPECT_NE(code.find(", 240, 255)"), std::string::npos);
+  EXPECT_EQ(Context::info_rgt().Get<int>("vectorized_forloop_count"), 1);
+}
+
 }  // namespace optim
 }  // namespace cinn
@@ -16,24 +16,88 @@
 
 #include <llvm/Support/FormatVariadic.h>
 
+#include <memory>
+#include <sstream>
+#include <unordered_map>
 #include <utility>
 
 #include "cinn/common/common.h"
 #include "cinn/ir/ir.h"
+#include "cinn/ir/ir_mutator.h"
+#include "cinn/optim/ir_copy.h"
+
+DEFINE_bool(cinn_cache_ast_gen,
+            true,
+            "Whether to reuse the ISL AST and the Expr generated for the same canonical domains and schedules of the "
+            "stages, instead of generating them for each instance of the same op.");
 
 namespace cinn {
 namespace poly {
 
+namespace {
+
+//! The AST generated for a key, in which the statements are named by the canonical names.
+struct CachedAst {
+  isl_ctx* ctx{};
+  isl::ast_node ast;
+  //! canonical tuple name -> { axis -> isl_ast }
+  std::map<std::string, std::map<std::string, isl::ast_expr>> transformed_indice_map;
+  //! The Expr transformed from the AST, created by the first BuildExpr.
+  ir::Expr expr;
+};
+
+//! The cache of this thread, the isl objects in it belong to the isl ctx of the thread.
+std::unordered_map<std::string, std::shared_ptr<CachedAst>>& AstCache() {
+  thread_local std::unordered_map<std::string, std::shared_ptr<CachedAst>> cache;
+  return cache;
+}
+
+thread_local int num_ast_cache_hits = 0;
+
+//! Rename the tuples of the stages in \p map by \p names.
+isl::map RenameTuples(isl::map map, const std::map<std::string, std::string>& names) {
+  for (auto type : {isl_dim_in, isl_dim_out}) {
+    if (isl_map_has_tuple_name(map.get(), type) != isl_bool_true) continue;
+    auto it = names.find(isl_map_get_tuple_name(map.get(), type));
+    if (it != names.end()) map = isl::manage(isl_map_set_tuple_name(map.release(), type, it->second.c_str()));
+  }
+  return map;
+}
+
+//! Rename the ISL Call nodes by \p names.
+struct IslCallRenamer : public ir::IRMutator<> {
+  explicit IslCallRenamer(const std::map<std::string, std::string>& names) : names(names) {}
+
+  void operator()(Expr* expr) { ir::IRMutator<>::Visit(expr, expr); }
+
+ private:
+  void Visit(const ir::Call* op, Expr* expr) override {
+    auto* node = expr->As<ir::Call>();
+    if (node->is_isl_call()) {
+      auto it = names.find(node->name);
+      if (it != names.end()) node->name = it->second;
+    }
+    ir::IRMutator<>::Visit(op, expr);
+  }
+
+  const std::map<std::string, std::string>& names;
+};
+
+}  // namespace
+
 struct AstGen::Impl {
   Impl(const isl::set& context, const poly::ScheduleGroup& schedule_group)
       : context_(context), schedule_group_(schedule_group) {}
   //! Set the ISL ast_gen configs.
   void InitIslAstConfig();
 
-  //! Return a domain composed of all the elements.
+  //! Name the stages by their order.
+  void InitCanonicalNames();
+
+  //! Return a domain composed of all the elements, with the tuples renamed to the canonical names.
   isl::union_set domain();
 
-  //! Return a map composed of all the transforms.
+  //! Return a map composed of all the transforms, with the tuples renamed to the canonical names.
   isl::union_map transform();
 
   isl::ctx ctx() const;
@@ -57,14 +121,30 @@ struct AstGen::Impl {
   //! tuple name -> { axis -> isl_ast }
   std::map<std::string, std::map<std::string, isl::ast_expr>> transformed_indice_map_;
   isl::union_map build_options_;
+  //! stage id -> canonical name, and the reverse.
+  std::map<std::string, std::string> canonical_names_;
+  std::map<std::string, std::string> stage_ids_;
+  //! The AST of the last build.
+  std::shared_ptr<CachedAst> cached_;
 
   friend class AstGen;
 };
 
+void AstGen::Impl::InitCanonicalNames() {
+  canonical_names_.clear();
+  stage_ids_.clear();
+  for (int i = 0; i < stages_.size(); i++) {
+    std::string name                   = "_s" + std::to_string(i);
+    canonical_names_[stages_[i]->id()] = name;
+    stage_ids_[name]                   = stages_[i]->id();
+  }
+}
+
 isl::union_set AstGen::Impl::domain() {
   CHECK(!stages_.empty());
-  auto sets =
-      utils::Map<std::vector<Shared<Stage>>, isl::set>(stages_, [](const Shared<Stage>& e) { return e->domain(); });
+  auto sets = utils::Map<std::vector<Shared<Stage>>, isl::set>(stages_, [this](const Shared<Stage>& e) {
+    return isl::manage(isl_set_set_tuple_name(e->domain().copy(), canonical_names_.at(e->id()).c_str()));
+  });
   return isl_sets_to_union_set(sets);
 }
 
@@ -133,26 +213,63 @@ isl::union_set TransIdentityExtentToContextId(isl::union_set set) {
 }
 
 isl::ast_node AstGen::Build() {
+  impl_->InitCanonicalNames();
   // Collect schedule from scheduler.
   auto schedule_map = CollectScheduleMapFromGroup(impl_->schedule_group_);
   std::vector<isl::map> maps;
   for (auto& stage : impl_->stages_) {
     auto it = schedule_map.find(stage->id());
     CHECK(it != std::end(schedule_map)) << "stage " << stage->id() << " not found in the map";
-    maps.push_back(it->second);
+    maps.push_back(RenameTuples(it->second, impl_->canonical_names_));
   }
   auto schedule = isl_maps_to_union_map(maps);
 
+  // Set iterators names for readable code.
+  auto iterator_names =
+      impl_->iterator_names_.empty() ? impl_->schedule_group_.dimension_names : impl_->iterator_names_;
+  iterator_names = SchedulerBase::WrapIteratorNames(iterator_names);
+
+  isl::union_map transformed_schedule = impl_->transform().apply_range(schedule);
+  VLOG(4) << "transformed_schedule: " << transformed_schedule;
+  auto schedule_domain = transformed_schedule.intersect_domain(impl_->domain());
+  VLOG(4) << "domain: " << impl_->domain();
+  VLOG(4) << "transform schedule " << impl_->stages()[0]->transform();
+  VLOG(4) << "schedule: " << schedule;
+  VLOG(4) << "schedule_domain: " << schedule_domain;
+
+  // The key of the AST is all the inputs of the AST build.
+  std::stringstream key;
+  key << impl_->context_ << ";" << schedule_domain << ";" << utils::Join(iterator_names, ",");
+  if (!impl_->build_options_.is_null()) key << ";" << impl_->build_options_;
+
+  // The statements renamed back to the stage ids.
+  auto set_transformed_indice_map = [this] {
+    impl_->transformed_indice_map_.clear();
+    for (auto& item : impl_->cached_->transformed_indice_map) {
+      impl_->transformed_indice_map_[impl_->stage_ids_.at(item.first)] = item.second;
+    }
+  };
+
+  auto& cache = AstCache();
+  if (FLAGS_cinn_cache_ast_gen) {
+    auto it = cache.find(key.str());
+    if (it != cache.end() && it->second->ctx == ctx().get()) {
+      VLOG(3) << "Reuse the cached AST for the group of the stage " << impl_->stages_.front()->id();
+      num_ast_cache_hits++;
+      impl_->cached_ = it->second;
+      set_transformed_indice_map();
+      return impl_->cached_->ast;
+    }
+  }
+  impl_->cached_      = std::make_shared<CachedAst>();
+  impl_->cached_->ctx = ctx().get();
+
   // Build it.
   auto ast_build = isl::ast_build::from_context(impl_->context_);
 
   if (!impl_->build_options_.is_null())
     ast_build = isl::manage(isl_ast_build_set_options(ast_build.release(), impl_->build_options_.release()));
 
-  // Set iterators names for readable code.
-  auto iterator_names =
-      impl_->iterator_names_.empty() ? impl_->schedule_group_.dimension_names : impl_->iterator_names_;
-  iterator_names   = SchedulerBase::WrapIteratorNames(iterator_names);
   isl::id_list ids = isl::manage(isl_id_list_alloc(ctx().get(), iterator_names.size()));
   for (int i = 0; i < iterator_names.size(); i++) {
     ids = isl::manage(isl_id_list_add(ids.release(), isl_id_alloc(ctx().get(), iterator_names[i].c_str(), nullptr)));
@@ -161,33 +278,41 @@ isl::ast_node AstGen::Build() {
 
   // collect iterator map
   auto get_domain_by_name = [this](const std::string& name) -> isl::set {
-    auto ele_it = std::find_if(
-        impl_->stages_.begin(), impl_->stages_.end(), [&name](const Shared<Stage>& ele) { return ele->id() == name; });
+    auto ele_it = std::find_if(impl_->stages_.begin(), impl_->stages_.end(), [&](const Shared<Stage>& ele) {
+      return ele->id() == impl_->stage_ids_.at(name);
+    });
     CHECK(ele_it != std::end(impl_->stages_));
-    return (*ele_it)->domain();
+    return isl::manage(isl_set_set_tuple_name((*ele_it)->domain().copy(), name.c_str()));
   };
 
   auto collect = [&](isl::ast_node node, isl::ast_build build) -> isl::ast_node {
     auto tuple_name = detail::GetTupleName(node.get());
     auto indice_map = impl_->ExtractIslTransformedIndiceMap(get_domain_by_name(tuple_name), build.get());
-    impl_->transformed_indice_map_[tuple_name] = indice_map;
+    impl_->cached_->transformed_indice_map[tuple_name] = indice_map;
     return node;
   };
 
   ast_build = ast_build.set_at_each_domain(collect);
 
-  isl::union_map transformed_schedule = impl_->transform().apply_range(schedule);
-  VLOG(4) << "transformed_schedule: " << transformed_schedule;
-  auto schedule_domain = transformed_schedule.intersect_domain(impl_->domain());
-  VLOG(4) << "domain: " << impl_->domain();
-  VLOG(4) << "transform schedule " << impl_->stages()[0]->transform();
-  VLOG(4) << "schedule: " << schedule;
-  VLOG(4) << "schedule_domain: " << schedule_domain;
   auto ast = ast_build.node_from_schedule_map(schedule_domain);
   VLOG(2) << "AST:\n" << isl_ast_node_to_C_str(ast.get());
+  impl_->cached_->ast = ast;
+  set_transformed_indice_map();
+  if (FLAGS_cinn_cache_ast_gen) cache[key.str()] = impl_->cached_;
   return ast;
 }
 
+ir::Expr AstGen::BuildExpr() {
+  Build();
+  auto& cached = impl_->cached_;
+  if (!cached->expr.defined()) IslAstNodeToCinnExpr(cached->ast, &cached->expr);
+  // The cached Expr is shared by the later builds.
+  ir::Expr expr = FLAGS_cinn_cache_ast_gen ? optim::IRCopy(cached->expr) : cached->expr;
+  IslCallRenamer renamer(impl_->stage_ids_);
+  renamer(&expr);
+  return expr;
+}
+
 AstGen& AstGen::SetIteratorNames(const std::vector<std::string>& names) {
   impl_->iterator_names_ = names;
   return *this;
@@ -262,7 +387,7 @@ isl::ast_expr CreateIslAstIndexExpression(isl_ast_build* build, const isl::map&
 isl::union_map AstGen::Impl::transform() {
   std::vector<isl::map> transforms;
   for (auto& stage : stages()) {
-    transforms.push_back(stage->transform());
+    transforms.push_back(RenameTuples(stage->transform(), canonical_names_));
   }
   return isl_maps_to_union_map(transforms);
 }
@@ -522,6 +647,7 @@ AstGen::AstGen(const isl::set& context, const std::vector<Stage*>& stages, const
 }
 void AstGen::SetBuildOptions(const isl::union_map& options) { impl_->build_options_ = options; }
 bool AstGen::ContainsStatement(const std::string& name) const { return impl_->transformed_indice_map_.count(name); }
+int AstGen::num_cache_hits() { return num_ast_cache_hits; }
 
 AstGen::~AstGen() {}
 
@@ -17,6 +17,7 @@
  * schedule.
  */
 #pragma once
+#include <gflags/gflags.h>
 #include <isl/cpp.h>
 
 #include <map>
@@ -30,6 +31,8 @@
 #include "cinn/poly/stage.h"
 #include "cinn/utils/functional.h"
 
+DECLARE_bool(cinn_cache_ast_gen);
+
 namespace cinn {
 namespace poly {
 
@@ -37,6 +40,11 @@ static const char* kIslParamConstPrefix = "_const_";
 
 /**
  * Generate IR from polyhedral schedule.
+ *
+ * The AST is generated from the domains and the schedules of the stages with the tuples renamed to the canonical names
+ * `_s0`, `_s1`, ... by the order of the stages, so the same op lowered for another instance yields the same key. The
+ * AST, the transformed indices and the Expr of a key are cached on the thread, which owns the isl ctx, and reused by
+ * the later builds, so the AST generation runs once for each unique op instead of each instance.
  */
 class AstGen {
  public:
@@ -52,8 +60,12 @@ class AstGen {
 
   isl::ctx ctx() const;
 
+  //! Build the AST, in which the statements are named by the canonical names of their stages.
   isl::ast_node Build();
 
+  //! Build the AST and transform it to Expr, in which the ISL Call nodes are named by the stage ids.
+  ir::Expr BuildExpr();
+
   //! Get the map from original CINN iterators to the transformed actual ISL ast nodes.
   const std::map<std::string, isl::ast_expr>& axis2ast(const std::string& tuple_name) const;
 
@@ -63,6 +75,9 @@ class AstGen {
 
   void SetBuildOptions(const isl::union_map& options);
 
+  //! The number of the builds on this thread that reused a cached AST.
+  static int num_cache_hits();
+
  private:
   class Impl;
   std::unique_ptr<Impl> impl_;
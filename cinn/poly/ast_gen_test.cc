@@ -16,8 +16,10 @@
 
 #include <gtest/gtest.h>
 
+#include "cinn/cinn.h"
 #include "cinn/ir/ir.h"
 #include "cinn/ir/ir_printer.h"
+#include "cinn/utils/string.h"
 
 namespace cinn {
 namespace poly {
@@ -40,5 +42,27 @@ TEST(TransIdentityExtentToContextId, basic1) {
   LOG(INFO) << new_set;
 }
 
+TEST(AstGen, cache) {
+  auto lower = [](const std::string& name) {
+    Expr M(100), N(200);
+    Placeholder<float> A(name + "_A", {M, N});
+    auto B = Compute(
+        {M, N}, [&](Expr i, Expr j) { return A(i, j) + 1.f; }, name + "_B");
+    auto stages = CreateStages({B});
+    stages[B]->Split(1, 8);
+    return Lower(name, stages, {A, B});
+  };
+
+  auto fn0  = lower("fn0");
+  int hits  = AstGen::num_cache_hits();
+  auto fn1  = lower("fn1");
+  auto code = utils::GetStreamCnt(fn1);
+  LOG(INFO) << "fn1:\n" << code;
+  // the second op reuses the AST of the first, and differs from it only by the names
+  ASSERT_EQ(AstGen::num_cache_hits(), hits + 1);
+  utils::Replace(&code, "fn1", "fn0");
+  ASSERT_EQ(code, utils::GetStreamCnt(fn0));
+}
+
 }  // namespace poly
 }  // namespace cinn
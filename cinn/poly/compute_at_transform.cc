@@ -240,5 +240,23 @@ std::vector<int> ComputeAtTransform::GetAccessesPrecedingIndicesMinAssumingParam
   return res;
 }
 
+int GetDeepestComputeAtLevel(isl::set cdomain, isl::map access, isl::map ctransform, int max_level) {
+  // the producer's elements read in each iteration of the consumer's transformed loops
+  isl::map ctransform1 = isl::manage(isl_map_intersect_domain(ctransform.release(), cdomain.release()));
+  isl::map reads       = isl::manage(isl_map_apply_range(isl_map_reverse(ctransform1.release()), access.release()));
+  int num_dims         = isl_map_dim(reads.get(), isl_dim_in);
+  for (int level = std::min(max_level, num_dims - 1); level >= 0; level--) {
+    isl::map tile_reads =
+        isl::manage(isl_map_project_out(reads.copy(), isl_dim_in, level + 1, num_dims - level - 1));
+    // each element of the producer is read by one iteration of the preceding level+1 axes at most
+    isl::map readers = isl::manage(isl_map_reverse(tile_reads.release()));
+    if (isl_map_is_single_valued(readers.get()) == isl_bool_true) {
+      VLOG(3) << "the deepest compute_at level is " << level << ", the tiles read are " << readers;
+      return level;
+    }
+  }
+  return -1;
+}
+
 }  // namespace poly
 }  // namespace cinn
@@ -112,5 +112,18 @@ class ComputeAtTransform {
   int level_;
 };
 
+/**
+ * Get the deepest level of the consumer's loops to compute the producer at, which keeps the producer's buffer the
+ * smallest. A level is legal only if each iteration of the consumer's preceding level+1 axes reads its own elements of
+ * the producer, so that none of the producer's elements is computed twice.
+ *
+ * @param cdomain The domain of the consumer.
+ * @param access The access relation from the consumer to the producer.
+ * @param ctransform The transform of the consumer.
+ * @param max_level The deepest level to try.
+ * @return the level, or -1 if none of the levels is legal.
+ */
+int GetDeepestComputeAtLevel(isl::set cdomain, isl::map access, isl::map ctransform, int max_level);
+
 }  // namespace poly
 }  // namespace cinn
@@ -49,5 +49,22 @@ TEST(ComputeAtTransform2, basic) {
   }
 }
 
+TEST(ComputeAtTransform2, GetDeepestComputeAtLevel) {
+  isl::ctx ctx(isl_ctx_alloc());
+  isl::set cdomain(ctx, "{ c[i,j]: 0<=i<10 and 0<=j<20 }");
+  isl::map ctransform(ctx, "{ c[i,j]->c[t0,t1,t2]: t0=i and t1=j/4 and t2=j%4 }");
+
+  // the elementwise reading is computed at the innermost loop
+  isl::map access0(ctx, "{ c[i,j]->p[i,j] }");
+  EXPECT_EQ(GetDeepestComputeAtLevel(cdomain, access0, ctransform, 2), 2);
+  EXPECT_EQ(GetDeepestComputeAtLevel(cdomain, access0, ctransform, 1), 1);
+  // the row read by all the j iterations is computed outside them
+  isl::map access1(ctx, "{ c[i,j]->p[i] }");
+  EXPECT_EQ(GetDeepestComputeAtLevel(cdomain, access1, ctransform, 2), 0);
+  // the column read by all the i iterations can not be computed at any level
+  isl::map access2(ctx, "{ c[i,j]->p[j] }");
+  EXPECT_EQ(GetDeepestComputeAtLevel(cdomain, access2, ctransform, 2), -1);
+}
+
 }  // namespace poly
 }  // namespace cinn
@@ -34,6 +34,9 @@ std::string Domain::__str__() const {
   std::vector<std::string> range_fields;
   std::transform(
       dims.begin(), dims.end(), std::back_inserter(range_fields), [](const Dim& x) { return x.range_repr(); });
+  for (auto& item : param_divisors) {
+    range_fields.push_back(utils::StringFormat("%s mod %d = 0", item.first.c_str(), item.second));
+  }
   std::string range_repr = utils::Join(range_fields, " and ");
 
   std::vector<std::string> dim_fields;
@@ -60,7 +63,11 @@ void Domain::ExtractParams() {
   auto collect_param_fn = [&](Expr& e) {
     if (!e.is_constant()) {
       auto vars = ir::CollectIRNodes(e, [](const Expr* e) { return e->is_var(); });
-      for (auto& var : vars) var_names.insert(var.As<ir::_Var_>()->name);
+      for (auto& var : vars) {
+        auto* node = var.As<ir::_Var_>();
+        var_names.insert(node->name);
+        if (node->divisor > 1) param_divisors[node->name] = node->divisor;
+      }
     }
   };
 
@@ -16,6 +16,7 @@
 
 #include <isl/cpp.h>
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -31,6 +32,8 @@ struct Domain {
   std::vector<Dim> dims;
   //! The parameters.
   std::vector<Dim> params;
+  //! The divisors greater than 1 the parameters are known to be multiples of, see ir::_Var_::divisor.
+  std::map<std::string, int> param_divisors;
 
   //! The ISL context.
   isl::ctx ctx;
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <set>
+#include <sstream>
 #include <unordered_set>
 #include <utility>
 
@@ -658,6 +659,25 @@ void Stage::ComputeAt(Stage *other, int level) {
   }
 }
 
+int Stage::GetDeepestComputeAtLevel(Stage *other) {
+  CHECK(tensor_);
+  CHECK(other->tensor_);
+  if (!compute_ats_.empty() || !parallel_info_.empty() || !unroll_info_.empty() || vectorize_info_.valid() ||
+      other->tensor_->is_reduce_tensor()) {
+    return -1;
+  }
+  auto indices = optim::CollectTensorIndex(&(other->expr_), this->tensor()->name);
+  RemoveDuplicate(indices);
+  if (indices.size() != 1U) return -1;
+
+  int max_level = other->n_out_dims() - 1;
+  if (other->vectorize_info().valid()) max_level = std::min(max_level, other->vectorize_info().level - 1);
+  if (max_level < 0) return -1;
+  isl::map access = isl::manage(GatherAccesses(other, this->tensor()->name));
+  if (access.is_null()) return -1;
+  return poly::GetDeepestComputeAtLevel(other->domain(), access, other->transform(), max_level);
+}
+
 void Stage::ComputeAt2(Stage *other, int level) {
   // TODO(Superjomn) Check there are data dependency between `self` and `other`, or the `ComputeAt` is meaningless.
   this->ChangeDomain(other, level);
@@ -927,6 +947,85 @@ void Stage::Unroll(int level) {
   unroll_info_.insert(level - removed_axes_counts);
 }
 
+void Stage::TensorCore(int level) {
+  CHECK_GE(level, 0);
+  CHECK_LT(level + 2, n_out_dims()) << "The tensor core tile of " << id() << " needs three loops from level " << level;
+  CHECK(tensor()->is_reduce_sum()) << "Only the reduce sum " << id() << " can be mapped onto the tensor cores";
+  for (int i = level; i < level + 3; i++) {
+    AssertAxisIsNotLocked(i);
+    CHECK(!isl_is_removed_axis(transformed_domain().get(), i)) << "The tensor core tile of " << id() << " has a for-1";
+    CHECK_EQ(GetDimRange(i), 16) << "The loop " << ith_dim_name(i) << " of the tensor core tile should be 16";
+  }
+  int removed_axes_counts = isl_get_precending_removed_axes_counts(transformed_domain().get(), level);
+  tensor_core_level_      = level - removed_axes_counts;
+}
+
+void Stage::TensorCore(const Iterator &level) {
+  auto dim_names = axis_names();
+  auto it        = std::find(dim_names.begin(), dim_names.end(), level.id);
+  int l          = std::distance(dim_names.begin(), it);
+  TensorCore(l);
+}
+
+void Stage::BlockReduce(int level) {
+  CHECK_GE(level, 0);
+  CHECK_EQ(level + 1, n_out_dims()) << "The block reduction of " << id() << " should be the innermost loop";
+  CHECK_EQ(tensor()->reduce_axis.size(), 1U) << "The block reduction of " << id() << " should reduce one axis";
+  CHECK(tensor()->type().is_float(32)) << "Only the float32 reduction " << id() << " is reduced by a block";
+  AssertAxisIsNotLocked(level);
+  CHECK(!isl_is_removed_axis(transformed_domain().get(), level)) << "The block reduction of " << id() << " is a for-1";
+  // a thread for each element up to 512 threads, of whole warps
+  int extent              = GetDimRange(level);
+  block_reduce_threads_   = std::min(512, (extent + 31) / 32 * 32);
+  int removed_axes_counts = isl_get_precending_removed_axes_counts(transformed_domain().get(), level);
+  block_reduce_level_     = level - removed_axes_counts;
+}
+
+void Stage::BlockReduce(const Iterator &level) {
+  auto dim_names = axis_names();
+  auto it        = std::find(dim_names.begin(), dim_names.end(), level.id);
+  int l          = std::distance(dim_names.begin(), it);
+  BlockReduce(l);
+}
+
+void Stage::Pipeline(int level, int num_stages) {
+  CHECK_GE(level, 0);
+  CHECK_LT(level, n_out_dims());
+  CHECK_GE(num_stages, 2) << "The pipeline of " << id() << " should have at least 2 stages";
+  CHECK_LE(num_stages, 4) << "The pipeline of " << id() << " should have at most 4 stages";
+  // the loop is usually locked by the tiles computed at it, which is fine as the pipeline does not change the loop
+  CHECK(!isl_is_removed_axis(transformed_domain().get(), level)) << "The pipelined loop of " << id() << " is a for-1";
+  int removed_axes_counts = isl_get_precending_removed_axes_counts(transformed_domain().get(), level);
+  pipeline_level_         = level - removed_axes_counts;
+  pipeline_stages_        = num_stages;
+}
+
+void Stage::Pipeline(const Iterator &level, int num_stages) {
+  auto dim_names = axis_names();
+  auto it        = std::find(dim_names.begin(), dim_names.end(), level.id);
+  int l          = std::distance(dim_names.begin(), it);
+  Pipeline(l, num_stages);
+}
+
+void Stage::DotProduct4(int level) {
+  CHECK_GE(level, 0);
+  CHECK_EQ(level + 1, n_out_dims()) << "The dot product of " << id() << " should be the innermost loop";
+  CHECK(tensor()->is_reduce_sum()) << "Only the reduce sum " << id() << " can be tensorized onto the dot product";
+  CHECK(tensor()->type().is_int(32)) << "The dot product " << id() << " should accumulate to an int32";
+  AssertAxisIsNotLocked(level);
+  CHECK(!isl_is_removed_axis(transformed_domain().get(), level)) << "The dot product of " << id() << " is a for-1";
+  CHECK_EQ(GetDimRange(level), 4) << "The loop " << ith_dim_name(level) << " of the dot product should be 4";
+  int removed_axes_counts = isl_get_precending_removed_axes_counts(transformed_domain().get(), level);
+  dot_product_level_      = level - removed_axes_counts;
+}
+
+void Stage::DotProduct4(const Iterator &level) {
+  auto dim_names = axis_names();
+  auto it        = std::find(dim_names.begin(), dim_names.end(), level.id);
+  int l          = std::distance(dim_names.begin(), it);
+  DotProduct4(l);
+}
+
 std::string Stage::ith_dim_name(int level) {
   auto dims = isl_get_dim_names(transformed_domain());
   CHECK_LT(level, dims.size());
@@ -941,6 +1040,48 @@ isl::set Stage::transformed_domain() const {
   return domain_.apply(transform_);
 }
 
+namespace {
+// Join the fields of a container printed by operator<<.
+template <typename Container>
+std::string JoinFields(const Container &fields) {
+  std::stringstream ss;
+  for (auto &field : fields) ss << field << ",";
+  return ss.str();
+}
+}  // namespace
+
+std::string Stage::Fingerprint() const {
+  std::stringstream ss;
+  ss << "id " << id() << "\ndomain " << domain_ << "\ntransform " << transform_ << "\n";
+  if (expr_.defined()) ss << "expr " << expr_ << "\n";
+  if (tensor_) {
+    ss << "tensor " << tensor_->name << " " << tensor_->type() << " shape " << JoinFields(tensor_->shape);
+    if (tensor_->buffer.defined()) {
+      ss << " buffer " << tensor_->buffer->name << " " << static_cast<int>(tensor_->buffer->memory_type);
+    }
+    ss << "\n";
+  }
+  for (auto &item : compute_ats_) ss << "compute_at " << item.first << " " << item.second.level << "\n";
+  for (auto &info : meta.compute_at_infos) {
+    ss << "compute_at_info " << info.consumer_tensor_name << " " << info.producer_tensor_name << " "
+       << JoinFields(info.adjusted_producer_shape) << " " << JoinFields(info.preceding_offset_for_producer_load) << " "
+       << info.level << "\n";
+  }
+  ss << "inline " << meta.compute_inline << " share_buffer " << JoinFields(meta.tensors_to_share_buffer_with) << "\n";
+  ss << "vectorize " << vectorize_info_.level << " " << vectorize_info_.factor << " unroll " << JoinFields(unroll_info_)
+     << " parallel " << JoinFields(parallel_info_) << "\n";
+  ss << "tensor_core " << tensor_core_level_ << " block_reduce " << block_reduce_level_ << " " << block_reduce_threads_
+     << " pipeline " << pipeline_level_ << " " << pipeline_stages_ << " dot_product " << dot_product_level_ << "\n";
+  for (auto &item : forloop_infos_) {
+    ss << "forloop " << item.first << " " << static_cast<int>(item.second.for_type) << " "
+       << static_cast<int>(item.second.device) << " " << static_cast<int>(item.second.offset) << "\n";
+  }
+  ss << "scope " << static_cast<int>(scope_) << " ctrl_depends";
+  for (auto &tensor : ctrl_depends_) ss << " " << tensor->name;
+  ss << " locked " << JoinFields(locked_axis_) << " cuda_bind " << cuda_bind_info_ << "\n";
+  return ss.str();
+}
+
 std::vector<std::pair<std::string, std::string>> ExtractExtraDepLinksFromStages(const std::vector<Stage *> &stages) {
   std::vector<std::pair<std::string, std::string>> extra_links;
   for (auto &stage : stages) {
@@ -216,6 +216,39 @@ class Stage : public Object {
   void Unroll(const std::string& level);
   void Unroll(const Iterator& level);
 
+  /**
+   * Map the 16x16x16 tile of the loops \p level, \p level + 1 and \p level + 2 onto the tensor cores. The tile should
+   * be the innermost i, j and k loops of a matmul-like reduction C[i, j] += A[i, k] * B[k, j] of float16 operands and a
+   * float32 C. The MMA is computed by a whole warp, so threadIdx.x should not be bound in this stage.
+   */
+  void TensorCore(int level);
+  void TensorCore(const Iterator& level);
+
+  /**
+   * Reduce the loop \p level by all the threads of a GPU block together, each thread reduces a strided part of the
+   * elements and the parts are combined by the warp shuffles and the shared memory. The loop should be the only reduce
+   * axis of a float32 reduction of the elements loaded from a tensor, and threadIdx is not bound in this stage.
+   */
+  void BlockReduce(int level);
+  void BlockReduce(const Iterator& level);
+
+  /**
+   * Pipeline the loop \p level over \p num_stages buffers of the shared memory tiles loaded in its body, the tiles of
+   * the next num_stages - 1 iterations are loaded while the tiles of the current one are computed. The body should load
+   * the shared tiles, sync the threads and then compute on the tiles, as the CacheRead("shared") tensors computed at
+   * the loop with SyncThreads do. On the GPUs since Ampere the float32 tiles are copied by cp.async.
+   */
+  void Pipeline(int level, int num_stages = 2);
+  void Pipeline(const Iterator& level, int num_stages = 2);
+
+  /**
+   * Tensorize the loop \p level of 4 iterations onto the 4-way int8 dot product, the VNNI on X86 and the DP4A on CUDA.
+   * The loop should be the innermost one, a reduce axis of an int32 reduce sum C += int32(A) * int32(B) of int8 A and
+   * B, e.g. the inner loop of `Split(k, 4)` of a matmul or a conv.
+   */
+  void DotProduct4(int level);
+  void DotProduct4(const Iterator& level);
+
   void Bind(int level, const std::string& axis);
 
   enum ComputeAtKind {
@@ -271,6 +304,18 @@ class Stage : public Object {
    */
   void ComputeAt(Stage* other, int level);
 
+  /**
+   * \brief Get the deepest level of \p other's forloops to compute this stage at by `ComputeAt`, which keeps only the
+   * smallest tile of this stage in its buffer.
+   *
+   * Only a stage not scheduled yet and read directly by \p other with one access pattern can be computed at \p other,
+   * and \p other's vectorized loops can not contain it.
+   *
+   * @param other the consumer stage.
+   * @return the level, or -1 if there is no legal level.
+   */
+  int GetDeepestComputeAtLevel(Stage* other);
+
   void ShowISL() const;
 
   void AddForLoopInTransform(std::vector<std::vector<Expr>>& indices);
@@ -356,6 +401,12 @@ class Stage : public Object {
   inline const ir::VectorizeInfo& vectorize_info() const { return vectorize_info_; }
   inline const std::set<int>& unroll_info() const { return unroll_info_; }
   inline const std::set<int>& parallel_info() const { return parallel_info_; }
+  inline int tensor_core_level() const { return tensor_core_level_; }
+  inline int block_reduce_level() const { return block_reduce_level_; }
+  inline int block_reduce_threads() const { return block_reduce_threads_; }
+  inline int pipeline_level() const { return pipeline_level_; }
+  inline int pipeline_stages() const { return pipeline_stages_; }
+  inline int dot_product_level() const { return dot_product_level_; }
   inline std::map<std::string, ComputeAtRelation>& GetComputeAts() { return compute_ats_; }
   inline void SetComputeAts(const std::map<std::string, ComputeAtRelation>& compute_ats) { compute_ats_ = compute_ats; }
 
@@ -367,6 +418,13 @@ class Stage : public Object {
 
   const std::map<int /*level*/, StageForloopInfo>& forloop_infos() const { return forloop_infos_; }
 
+  /**
+   * A string of everything the lowering reads from the stage and its tensor: the domain, the transform, the expression,
+   * the loop annotations and the relations to the other stages. The stages of the same fingerprints lower to the same
+   * code, keep it in sync with the members.
+   */
+  std::string Fingerprint() const;
+
   bool has_expression() const;
 
   Stage() = default;
@@ -427,6 +485,18 @@ class Stage : public Object {
   std::set<int> unroll_info_;
   //! The for-loop levels to parallel.
   std::set<int> parallel_info_;
+  //! The outermost for-loop level of the tile mapped onto the tensor cores, -1 if none.
+  int tensor_core_level_{-1};
+  //! The for-loop level reduced by the threads of a GPU block, -1 if none.
+  int block_reduce_level_{-1};
+  //! The number of the threads reducing the for-loop of block_reduce_level_.
+  int block_reduce_threads_{0};
+  //! The for-loop level pipelined over the buffers of the shared memory tiles, -1 if none.
+  int pipeline_level_{-1};
+  //! The number of the buffers of each tile pipelined by pipeline_level_.
+  int pipeline_stages_{0};
+  //! The for-loop level tensorized onto the 4-way int8 dot product, -1 if none.
+  int dot_product_level_{-1};
   //! Record some forloop levels' information.
   std::map<int /*level*/, StageForloopInfo> forloop_infos_;
   //! A weak reference to the tensor.
@@ -43,6 +43,7 @@ void BindExecutionEngine(py::module *m) {
   auto lookup = [](ExecutionEngine &self, absl::string_view name) {
     auto *function_ptr    = reinterpret_cast<void (*)(void **, int32_t)>(self.Lookup(name));
     auto function_wrapper = [function_ptr](std::vector<cinn_pod_value_t> &args) {
+      py::gil_scoped_release release;
       function_ptr(reinterpret_cast<void **>(args.data()), args.size());
     };
     return std::function<void(std::vector<cinn_pod_value_t> &)>(function_wrapper);
@@ -52,12 +53,13 @@ void BindExecutionEngine(py::module *m) {
   engine.def_static("create", &ExecutionEngine::Create, py::arg("options") = ExecutionOptions())
       .def(py::init(&ExecutionEngine::Create), py::arg("options") = ExecutionOptions())
       .def("lookup", lookup)
-      .def("link", &ExecutionEngine::Link);
+      .def("link", &ExecutionEngine::Link, py::call_guard<py::gil_scoped_release>());
 
   {
     auto lookup = [](Compiler &self, absl::string_view name) {
       auto *function_ptr    = reinterpret_cast<void (*)(void **, int32_t)>(self.Lookup(name));
       auto function_wrapper = [function_ptr](std::vector<cinn_pod_value_t> &args) {
+        py::gil_scoped_release release;
         function_ptr(reinterpret_cast<void **>(args.data()), args.size());
       };
       return std::function<void(std::vector<cinn_pod_value_t> &)>(function_wrapper);
@@ -66,7 +68,7 @@ void BindExecutionEngine(py::module *m) {
     py::class_<Compiler> compiler(*m, "Compiler");
     compiler
         .def_static("create", &Compiler::Create)  //
-        .def("build", &Compiler::BuildDefault)    //
+        .def("build", &Compiler::BuildDefault, py::call_guard<py::gil_scoped_release>())
         .def("lookup", lookup);
   }
 }
@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <gflags/gflags.h>
+
 #include "cinn/common/ir_util.h"
 #include "cinn/common/object.h"
 #include "cinn/common/shared.h"
@@ -86,6 +88,24 @@ void BindTarget(py::module *m) {
 
   m->def("is_compiled_with_cuda", IsCompiledWithCUDA);
   m->def("is_compiled_with_cudnn", IsCompiledWithCUDNN);
+
+  // Set the flags of CINN, e.g. the caches of the lowered functions and the compiled code, from the scripts.
+  m->def(
+      "set_flag",
+      [](const std::string &name, const std::string &value) {
+        auto result = google::SetCommandLineOption(name.c_str(), value.c_str());
+        CHECK(!result.empty()) << "Failed to set the flag " << name << " to " << value;
+      },
+      py::arg("name"),
+      py::arg("value"));
+  m->def(
+      "get_flag",
+      [](const std::string &name) {
+        std::string value;
+        CHECK(google::GetCommandLineOption(name.c_str(), &value)) << "Unknown flag " << name;
+        return value;
+      },
+      py::arg("name"));
 }
 
 void BindType(py::module *m) {
@@ -126,6 +146,7 @@ void BindType(py::module *m) {
       .value("int", Type::type_t::Int)
       .value("uInt", Type::type_t::UInt)
       .value("float", Type::type_t::Float)
+      .value("bfloat", Type::type_t::BFloat)
       .value("string", Type::type_t::String)
       .value("void", Type::type_t::Void)
       .value("customized", Type::type_t::Customized)
@@ -142,6 +163,7 @@ void BindType(py::module *m) {
       .def("Int", &common::Int, py::arg("bits"), py::arg("lanes") = 1)
       .def("UInt", &common::UInt, py::arg("bits"), py::arg("lanes") = 1)
       .def("Float", &common::Float, py::arg("bits"), py::arg("lanes") = 1)
+      .def("BFloat16", &common::BFloat16, py::arg("lanes") = 1)
       .def("Bool", &common::Bool, py::arg("lanes") = 1)
       .def("String", &common::String);
 
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <dlpack/dlpack.h>
 #include <pybind11/functional.h>
 #include <pybind11/numpy.h>
 #include <pybind11/operators.h>
@@ -25,11 +26,141 @@
 #include "cinn/hlir/framework/scope.h"
 #include "cinn/hlir/op/use_ops.h"
 #include "cinn/pybind/bind.h"
+#include "cinn/utils/compile_tracer.h"
 
 namespace cinn::pybind {
 
 namespace py = pybind11;
 using namespace cinn::hlir::framework;  // NOLINT
+
+namespace {
+constexpr const char *kDLTensorCapsule     = "dltensor";
+constexpr const char *kUsedDLTensorCapsule = "used_dltensor";
+
+DLDataType ToDLDataType(const Type &type) {
+  if (type.is_float(16)) return DLDataType{kDLFloat, 16, 1};
+  if (type.is_int(8)) return DLDataType{kDLInt, 8, 1};
+  if (type.is_int(32)) return DLDataType{kDLInt, 32, 1};
+  // the other tensors are all allocated as float32, see _Tensor_::mutable_data
+  return DLDataType{kDLFloat, 32, 1};
+}
+
+Type FromDLDataType(const DLDataType &dtype) {
+  CHECK_EQ(dtype.lanes, 1) << "The vectorized DLPack types are not supported";
+  if (dtype.code == kDLFloat && dtype.bits == 32) return Float(32);
+  if (dtype.code == kDLFloat && dtype.bits == 16) return Float(16);
+  if (dtype.code == kDLInt && dtype.bits == 32) return Int(32);
+  if (dtype.code == kDLInt && dtype.bits == 8) return Int(8);
+  LOG(FATAL) << "Not supported DLPack type, code: " << static_cast<int>(dtype.code)
+             << ", bits: " << static_cast<int>(dtype.bits);
+  return Type();
+}
+
+DLDeviceType ToDLDeviceType(const Target &target) {
+  return target.arch == Target::Arch::NVGPU ? kDLCUDA : kDLCPU;
+}
+
+//! What a DLPack capsule exported from a tensor holds, the tensor is kept alive until the consumer releases it.
+struct DLPackExport {
+  Tensor tensor;
+  std::vector<int64_t> shape;
+  DLManagedTensor managed;
+};
+
+py::capsule ToDLPack(Tensor tensor) {
+  CHECK(tensor->buffer()->memory) << "The tensor to export is not allocated";
+  auto *ctx   = new DLPackExport;
+  ctx->tensor = tensor;
+  ctx->shape.assign(tensor->shape().data().begin(), tensor->shape().data().end());
+
+  auto &dl_tensor          = ctx->managed.dl_tensor;
+  dl_tensor.data           = tensor->buffer()->memory;
+  dl_tensor.device         = DLDevice{ToDLDeviceType(tensor->target()), 0};
+  dl_tensor.ndim           = ctx->shape.size();
+  dl_tensor.dtype          = ToDLDataType(tensor->type());
+  dl_tensor.shape          = ctx->shape.data();
+  dl_tensor.strides        = nullptr;
+  dl_tensor.byte_offset    = 0;
+  ctx->managed.manager_ctx = ctx;
+  ctx->managed.deleter     = [](DLManagedTensor *self) { delete static_cast<DLPackExport *>(self->manager_ctx); };
+
+  return py::capsule(&ctx->managed, kDLTensorCapsule, [](PyObject *capsule) {
+    // the capsule is renamed once consumed, and then the consumer calls the deleter
+    if (!PyCapsule_IsValid(capsule, kDLTensorCapsule)) return;
+    auto *managed = static_cast<DLManagedTensor *>(PyCapsule_GetPointer(capsule, kDLTensorCapsule));
+    managed->deleter(managed);
+  });
+}
+
+/**
+ * Consume the DLPack capsule of \p obj, or \p obj itself if it is a capsule, and let \p tensor refer to its memory
+ * without copies. The producer is released once the tensor refers to other memory.
+ */
+void ShareDLPack(Tensor tensor, py::object obj, bool check_shape) {
+  py::object capsule = py::hasattr(obj, "__dlpack__") ? obj.attr("__dlpack__")() : obj;
+  CHECK(PyCapsule_IsValid(capsule.ptr(), kDLTensorCapsule)) << "Expect an unconsumed DLPack capsule";
+  auto *managed = static_cast<DLManagedTensor *>(PyCapsule_GetPointer(capsule.ptr(), kDLTensorCapsule));
+  PyCapsule_SetName(capsule.ptr(), kUsedDLTensorCapsule);
+  std::shared_ptr<void> owner(managed, [](DLManagedTensor *self) {
+    if (!self->deleter) return;
+    py::gil_scoped_acquire gil;
+    self->deleter(self);
+  });
+
+  const auto &dl_tensor = managed->dl_tensor;
+  std::vector<int> shape(dl_tensor.shape, dl_tensor.shape + dl_tensor.ndim);
+  if (dl_tensor.strides) {
+    int64_t stride = 1;
+    for (int i = dl_tensor.ndim - 1; i >= 0; i--) {
+      CHECK(shape[i] == 1 || dl_tensor.strides[i] == stride) << "Only the compact DLPack tensors can be shared";
+      stride *= shape[i];
+    }
+  }
+
+  Target target;
+  switch (dl_tensor.device.device_type) {
+    case kDLCPU:
+    case kDLCUDAHost:
+      target = common::DefaultHostTarget();
+      break;
+    case kDLCUDA:
+#ifdef CINN_WITH_CUDA
+      target = common::DefaultNVGPUTarget();
+#else
+      LOG(FATAL) << "To use CUDA backends, you need to set WITH_CUDA ON!";
+#endif
+      break;
+    default:
+      LOG(FATAL) << "Not supported DLPack device type: " << dl_tensor.device.device_type;
+  }
+
+  Type type = FromDLDataType(dl_tensor.dtype);
+  if (check_shape) {
+    CHECK_EQ(Shape(shape).numel(), tensor->shape().numel()) << "The DLPack tensor has different elements";
+    auto expected = ToDLDataType(tensor->type());
+    CHECK(expected.code == dl_tensor.dtype.code && expected.bits == dl_tensor.dtype.bits)
+        << "The DLPack tensor has a different type";
+  } else {
+    tensor->Resize(Shape(shape));
+  }
+  auto *memory = static_cast<uint8_t *>(dl_tensor.data) + dl_tensor.byte_offset;
+  if (type.is_float(32)) {
+    tensor->share_external_data<float>(memory, target, std::move(owner));
+  } else if (type.is_int(32)) {
+    tensor->share_external_data<int32_t>(memory, target, std::move(owner));
+  } else {
+    tensor->set_type(type);
+    tensor->share_external_data(memory, target, std::move(owner));
+  }
+}
+
+Tensor FromDLPack(py::object obj) {
+  Tensor tensor;
+  ShareDLPack(tensor, obj, false);
+  return tensor;
+}
+}  // namespace
+
 void BindFramework(pybind11::module *m) {
   py::class_<Operator>(*m, "Operator")
       .def("get_op_attrs", [](const std::string &key) { return Operator::GetAttrs<StrategyFunction>(key); })
@@ -100,7 +231,7 @@ void BindFramework(pybind11::module *m) {
              py::array::ShapeContainer shape(t->shape().data().begin(), t->shape().data().end());
              py::array array(std::move(dt), std::move(shape));
              auto *mutable_data = array.mutable_data();
-             if (target.arch == Target::Arch::X86) {
+             if (target.is_cpu()) {
                std::memcpy(mutable_data, t->data<float>(), t->shape().numel() * sizeof(float));
              } else if (target.arch == Target::Arch::NVGPU) {
 #ifdef CINN_WITH_CUDA
@@ -116,11 +247,44 @@ void BindFramework(pybind11::module *m) {
              }
              return array;
            })
-      .def("var_names", &Scope::var_names);
+      .def("var_names", &Scope::var_names)
+      .def("tensor_memory_sizes", &Scope::TensorMemorySizes)
+      .def("memory_bytes", &Scope::MemoryBytes);
 
   py::class_<common::Shared<hlir::framework::_Tensor_>>(*m, "SharedTensor");
-  py::class_<Tensor, common::Shared<hlir::framework::_Tensor_>>(*m, "Tensor")
+  py::class_<Tensor, common::Shared<hlir::framework::_Tensor_>>(*m, "Tensor", py::buffer_protocol())
       .def(py::init<>())
+      .def_buffer([](hlir::framework::Tensor &self) {
+        CHECK(self->target().arch != Target::Arch::NVGPU) << "Only the host tensors can be viewed as buffers";
+        CHECK(self->buffer()->memory) << "The tensor to view is not allocated";
+        auto type       = self->type();
+        size_t bytes    = self->element_bytes();
+        std::string fmt = py::format_descriptor<float>::format();
+        if (type.is_float(16)) {
+          fmt = "e";
+        } else if (type.is_int(8)) {
+          fmt = py::format_descriptor<int8_t>::format();
+        } else if (type.is_int(32)) {
+          fmt = py::format_descriptor<int32_t>::format();
+        }
+        std::vector<py::ssize_t> shape(self->shape().data().begin(), self->shape().data().end());
+        std::vector<py::ssize_t> strides(shape.size(), bytes);
+        for (int i = static_cast<int>(shape.size()) - 2; i >= 0; i--) strides[i] = strides[i + 1] * shape[i + 1];
+        return py::buffer_info(self->buffer()->memory, bytes, fmt, shape.size(), shape, strides);
+      })
+      .def(
+          "__dlpack__",
+          [](hlir::framework::Tensor &self, py::object stream) { return ToDLPack(self); },
+          py::arg("stream") = py::none())
+      .def("__dlpack_device__",
+           [](hlir::framework::Tensor &self) {
+             return std::make_tuple(static_cast<int>(ToDLDeviceType(self->target())), 0);
+           })
+      .def_static("from_dlpack", &FromDLPack, "Refer to the memory of a DLPack tensor without copies.")
+      .def("share_dlpack",
+           [](hlir::framework::Tensor &self, py::object obj) { ShareDLPack(self, obj, true); },
+           "Let the tensor, e.g. a feed or fetch variable of a scope, refer to the memory of a DLPack tensor with the "
+           "same elements without copies. The tensor should not share the buffer with other variables.")
       .def("shape", [](hlir::framework::Tensor &self) { return self->shape().data(); })
       .def("set_type", [](hlir::framework::Tensor &self, Type type) { self->set_type(type); })
       .def("numpy",
@@ -131,7 +295,7 @@ void BindFramework(pybind11::module *m) {
              py::array::ShapeContainer shape(self->shape().data().begin(), self->shape().data().end());
              py::array array(std::move(dt), std::move(shape));
              void *array_data = array.mutable_data();
-             if (target.arch == Target::Arch::X86) {
+             if (target.is_cpu()) {
                std::memcpy(array_data, self->data<float>(), self->shape().numel() * sizeof(float));
              } else if (target.arch == Target::Arch::NVGPU) {
 #ifdef CINN_WITH_CUDA
@@ -154,7 +318,7 @@ void BindFramework(pybind11::module *m) {
         CHECK_EQ(std::accumulate(shape.begin(), shape.end(), 1, [](int32_t a, int32_t b) { return a * b; }),
                  self->shape().numel());
         auto *data = self->mutable_data<float>(target);
-        if (target.arch == Target::Arch::X86) {
+        if (target.is_cpu()) {
           for (int i = 0; i < self->shape().numel(); i++) {
             data[i] = reinterpret_cast<const float *>(array.data())[i];
           }
@@ -171,5 +335,29 @@ void BindFramework(pybind11::module *m) {
           CINN_NOT_IMPLEMENTED
         }
       });
+
+  m->def("from_dlpack", &FromDLPack, "Refer to the memory of a DLPack tensor without copies.");
+
+  auto stats_to_dict = [](const std::map<std::string, utils::CompileTracer::Stat> &stats) {
+    py::dict res;
+    for (auto &item : stats) {
+      py::dict stat;
+      stat["count"]    = item.second.count;
+      stat["total_ms"] = item.second.total_ms;
+      stat["max_ms"]   = item.second.max_ms;
+      res[py::str(item.first)] = stat;
+    }
+    return res;
+  };
+  py::class_<utils::CompileTracer, std::unique_ptr<utils::CompileTracer, py::nodelete>>(*m, "CompileTracer")
+      .def_static("global", &utils::CompileTracer::Global, py::return_value_policy::reference)
+      .def_property("enabled", &utils::CompileTracer::enabled, &utils::CompileTracer::set_enabled)
+      .def("clear", &utils::CompileTracer::Clear)
+      .def("report", &utils::CompileTracer::Report, py::arg("top_k") = 10)
+      .def("stage_stats", [=](utils::CompileTracer &self) { return stats_to_dict(self.stage_stats()); })
+      .def("group_stats", [=](utils::CompileTracer &self) { return stats_to_dict(self.group_stats()); })
+      .def("group_stage_stats", [=](utils::CompileTracer &self, const std::string &group) {
+        return stats_to_dict(self.group_stage_stats(group));
+      });
 }
 }  // namespace cinn::pybind
@@ -17,6 +17,10 @@
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 
+#include <chrono>
+#include <future>
+#include <map>
+
 #include "cinn/common/common.h"
 #include "cinn/frontend/cinn_builder.h"
 #include "cinn/frontend/decomposer/use_decomposer.h"
@@ -41,6 +45,36 @@ using frontend::Placeholder;
 namespace py = pybind11;
 using namespace cinn::frontend;  // NOLINT
 
+// A pending run of an Interpreter, it holds the arrays until the run completes.
+struct AsyncRun {
+  std::shared_future<void> future;
+  std::vector<py::object> arrays;
+
+  ~AsyncRun() {
+    // the run still writes the arrays if it is dropped before completion
+    py::gil_scoped_release release;
+    if (future.valid()) future.wait();
+  }
+};
+
+// Collect the host buffers of the inputs and outputs to run an Interpreter on, the arrays should be C-contiguous.
+static void CollectRunBuffers(const std::vector<py::array> &inputs,
+                              const std::map<std::string, py::array> &outputs,
+                              std::vector<const void *> *input_data,
+                              std::vector<hlir::framework::shape_t> *input_shapes,
+                              std::map<std::string, void *> *output_data) {
+  for (auto &input : inputs) {
+    CHECK(input.flags() & py::array::c_style) << "The inputs should be C-contiguous";
+    input_data->push_back(input.data());
+    input_shapes->emplace_back(input.shape(), input.shape() + input.ndim());
+  }
+  for (auto &output : outputs) {
+    auto array = output.second;
+    CHECK(array.flags() & py::array::c_style) << "The output [" << output.first << "] should be C-contiguous";
+    (*output_data)[output.first] = array.mutable_data();
+  }
+}
+
 // this function is a helper function, not threadsafe,
 // used in this file only for py function register
 static const char *SnakeName(const char *name) {
@@ -136,7 +170,11 @@ void BindFrontend(pybind11::module *m) {
              hlir::framework::ApplyPass(g.get(), "OpFusion");
              std::shared_ptr<hlir::framework::Scope> scope = hlir::framework::BuildScope(target, g);
              hlir::framework::GraphCompiler gc(target, scope, g);
-             auto program = gc.Build();
+             std::unique_ptr<hlir::framework::Program> program;
+             {
+               py::gil_scoped_release release;
+               program = gc.Build();
+             }
              for (size_t i = 0; i < tensor_inputs.size(); i++) {
                auto in_tensor = scope->GetTensor(tensor_inputs[i]->id);
                auto *data     = in_tensor->mutable_data<float>(target);
@@ -152,7 +190,7 @@ void BindFrontend(pybind11::module *m) {
 #else
                  LOG(FATAL) <<"To use CUDA backends, you need to set WITH_CUDA ON!";
 #endif
-               } else if (target.arch == Target::Arch::X86) {
+               } else if (target.is_cpu()) {
                  for (size_t j = 0; j < in_tensor->shape().numel(); j++) {
                    data[j] = reinterpret_cast<const float *>(input_data[i].data())[j];  // All random data
                  }
@@ -160,7 +198,10 @@ void BindFrontend(pybind11::module *m) {
                  CINN_NOT_IMPLEMENTED
                }
              }
-             program->Execute();
+             {
+               py::gil_scoped_release release;
+               program->Execute();
+             }
 
              std::vector<hlir::framework::Tensor> outputs;
              for (size_t i = 0; i < tensor_outputs.size(); i++) {
@@ -169,7 +210,9 @@ void BindFrontend(pybind11::module *m) {
 
              return outputs;
            })
-      .def("apply_pass", &ProgramPass::Apply)
+      .def("apply_pass",
+           static_cast<void (*)(Program *, const common::Target &, const std::vector<std::string> &)>(
+               &ProgramPass::Apply))
 
       /**
        * @brief Test the performance of a single-op program
@@ -201,7 +244,11 @@ void BindFrontend(pybind11::module *m) {
              hlir::framework::ApplyPass(g.get(), "InferShape");
              std::shared_ptr<hlir::framework::Scope> scope = hlir::framework::BuildScope(target, g);
              hlir::framework::GraphCompiler gc(target, scope, g);
-             auto program = gc.Build();
+             std::unique_ptr<hlir::framework::Program> program;
+             {
+               py::gil_scoped_release release;
+               program = gc.Build();
+             }
              for (size_t i = 0; i < tensor_inputs.size(); i++) {
                auto in_tensor = scope->GetTensor(tensor_inputs[i]->id);
                auto *data     = in_tensor->mutable_data<float>(target);
@@ -217,7 +264,7 @@ void BindFrontend(pybind11::module *m) {
 #else
                  LOG(FATAL) <<"To use CUDA backends, you need to set WITH_CUDA ON!";
 #endif
-               } else if (target.arch == Target::Arch::X86) {
+               } else if (target.is_cpu()) {
                  for (size_t j = 0; j < in_tensor->shape().numel(); j++) {
                    data[j] = reinterpret_cast<const float *>(input_data[i].data())[j];  // All random data
                  }
@@ -226,7 +273,10 @@ void BindFrontend(pybind11::module *m) {
                }
              }
              LOG(INFO) << info;
-             program->ExecuteTest(repeat_);
+             {
+               py::gil_scoped_release release;
+               program->ExecuteTest(repeat_);
+             }
              auto out = scope->GetTensor(tensor_out->id);
              return out;
            })
@@ -243,7 +293,11 @@ void BindFrontend(pybind11::module *m) {
              hlir::framework::ApplyPass(g.get(), "InferShape");
              std::shared_ptr<hlir::framework::Scope> scope = hlir::framework::BuildScope(target, g);
              hlir::framework::GraphCompiler gc(target, scope, g);
-             auto program = gc.Build(code);
+             std::unique_ptr<hlir::framework::Program> program;
+             {
+               py::gil_scoped_release release;
+               program = gc.Build(code);
+             }
              for (size_t i = 0; i < tensor_inputs.size(); i++) {
                auto in_tensor = scope->GetTensor(tensor_inputs[i]->id);
                auto *data     = in_tensor->mutable_data<float>(target);
@@ -259,7 +313,7 @@ void BindFrontend(pybind11::module *m) {
 #else
                  LOG(FATAL) <<"To use CUDA backends, you need to set WITH_CUDA ON!";
 #endif
-               } else if (target.arch == Target::Arch::X86) {
+               } else if (target.is_cpu()) {
                  for (size_t j = 0; j < in_tensor->shape().numel(); j++) {
                    data[j] = reinterpret_cast<const float *>(input_data[i].data())[j];  // All random data
                  }
@@ -268,7 +322,10 @@ void BindFrontend(pybind11::module *m) {
                }
              }
              LOG(INFO) << info;
-             program->ExecuteTest(repeat_);
+             {
+               py::gil_scoped_release release;
+               program->ExecuteTest(repeat_);
+             }
              auto out = scope->GetTensor(tensor_out->id);
              return out;
            })
@@ -289,11 +346,63 @@ void BindFrontend(pybind11::module *m) {
       .def(py::init<const std::vector<std::string> &, const std::vector<hlir::framework::shape_t> &>(),
            py::arg("input_names"),
            py::arg("input_shapes"))  //
-      .def("load_paddle_model", &frontend::Interpreter::LoadPaddleModel)
-      .def("run", &frontend::Interpreter::Run)
+      .def("load_paddle_model",
+           &frontend::Interpreter::LoadPaddleModel,
+           py::arg("model_dir"),
+           py::arg("target"),
+           py::arg("params_combined") = false,
+           py::call_guard<py::gil_scoped_release>())
+      .def("run", static_cast<void (frontend::Interpreter::*)()>(&frontend::Interpreter::Run),
+           py::call_guard<py::gil_scoped_release>())
+      .def(
+          "run",
+          [](frontend::Interpreter &self,
+             const std::vector<py::array> &inputs,
+             const std::map<std::string, py::array> &outputs) {
+            std::vector<const void *> input_data;
+            std::vector<hlir::framework::shape_t> input_shapes;
+            std::map<std::string, void *> output_data;
+            CollectRunBuffers(inputs, outputs, &input_data, &input_shapes, &output_data);
+            py::gil_scoped_release release;
+            self.Run(input_data, input_shapes, output_data);
+          },
+          py::arg("inputs"),
+          py::arg("outputs"),
+          "Run on the numpy arrays of the inputs in the order of the input names, and write the outputs to the arrays "
+          "by their names. It can be called by several Python threads concurrently.")
+      .def(
+          "run_async",
+          [](frontend::Interpreter &self,
+             const std::vector<py::array> &inputs,
+             const std::map<std::string, py::array> &outputs) {
+            std::vector<const void *> input_data;
+            std::vector<hlir::framework::shape_t> input_shapes;
+            std::map<std::string, void *> output_data;
+            CollectRunBuffers(inputs, outputs, &input_data, &input_shapes, &output_data);
+            auto run = std::make_unique<AsyncRun>();
+            for (auto &input : inputs) run->arrays.push_back(input);
+            for (auto &output : outputs) run->arrays.push_back(output.second);
+            {
+              py::gil_scoped_release release;
+              run->future = self.RunAsync(std::move(input_data), std::move(input_shapes), std::move(output_data));
+            }
+            return run;
+          },
+          py::arg("inputs"),
+          py::arg("outputs"),
+          "Like run, but return an AsyncRun at once, the outputs are ready after its wait().")
+      .def("set_num_async_threads", &frontend::Interpreter::SetNumAsyncThreads)
       .def("get_tensor", &frontend::Interpreter::GetTensor)
+      .def("set_input_shapes", &frontend::Interpreter::SetInputShapes, py::call_guard<py::gil_scoped_release>())
+      .def("num_compiled_programs", &frontend::Interpreter::num_compiled_programs)
       .def("scope", &frontend::Interpreter::scope);
 
+  py::class_<AsyncRun>(*m, "AsyncRun")
+      .def("wait", [](AsyncRun &self) { self.future.get(); }, py::call_guard<py::gil_scoped_release>())
+      .def("done", [](AsyncRun &self) {
+        return self.future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+      });
+
   py::class_<BaseBuilder>(*m, "BaseBuilder")
       .def(py::init<const std::string &>(), py::arg("name") = "")
       .def("create_input",
@@ -255,7 +255,8 @@ void BindIrIr(py::module *m) {
       .value("kMul", ir::Reduce::ReduceType::kMul)
       .value("kDiv", ir::Reduce::ReduceType::kDiv)
       .value("kMax", ir::Reduce::ReduceType::kMax)
-      .value("kMin", ir::Reduce::ReduceType::kMin);
+      .value("kMin", ir::Reduce::ReduceType::kMin)
+      .value("kLogSumExp", ir::Reduce::ReduceType::kLogSumExp);
 
   reduce.def_readwrite("init", &ir::Reduce::init)
       .def_readwrite("body", &ir::Reduce::body)
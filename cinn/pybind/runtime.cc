@@ -128,6 +128,7 @@ void BindCinnRuntime(py::module *m) {
       .value("cinn_type_uint", cinn_type_uint)
       .value("cinn_type_float", cinn_type_float)
       .value("cinn_type_handle", cinn_type_handle)
+      .value("cinn_type_bfloat", cinn_type_bfloat)
       .export_values();
 
   py::class_<cinn_type_t> cinn_type(*m, "cinn_type_t");
@@ -147,6 +148,8 @@ void BindCinnRuntime(py::module *m) {
       .def("cinn_int64_t", &cinn_int64_t)
       .def("cinn_uint32_t", &cinn_uint32_t)
       .def("cinn_uint64_t", &cinn_uint64_t)
+      .def("cinn_float16_t", &cinn_float16_t)
+      .def("cinn_bfloat16_t", &cinn_bfloat16_t)
       .def("cinn_float32_t", &cinn_float32_t)
       .def("cinn_float64_t", &cinn_float64_t);
 
@@ -0,0 +1,272 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/runtime/block_sparse_matmul.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "cinn/runtime/cpu/thread_backend.h"
+
+#ifdef CINN_WITH_CUDA
+#include <cuda_runtime.h>
+
+#include "cinn/backends/cuda_util.h"
+#include "cinn/runtime/cuda/cuda_module.h"
+#endif
+
+namespace cinn {
+namespace runtime {
+
+BsrMatrix MakeBsrMatrix(const float* weight, int64_t N, int64_t K, int block_n, int block_k) {
+  CHECK(block_n > 0 && block_k > 0) << "The blocks should not be empty, but got " << block_n << " x " << block_k;
+  BsrMatrix res;
+  res.block_rows = (N + block_n - 1) / block_n;
+  res.block_cols = (K + block_k - 1) / block_k;
+  res.block_n    = block_n;
+  res.block_k    = block_k;
+  res.row_ptr.reserve(res.block_rows + 1);
+  res.row_ptr.push_back(0);
+  std::vector<float> block(block_k * block_n);
+  for (int64_t r = 0; r < res.block_rows; r++) {
+    int64_t n_end = std::min<int64_t>(N, (r + 1) * block_n);
+    for (int64_t c = 0; c < res.block_cols; c++) {
+      int64_t k_end = std::min<int64_t>(K, (c + 1) * block_k);
+      bool nonzero  = false;
+      std::fill(block.begin(), block.end(), 0.f);
+      for (int64_t n = r * block_n; n < n_end; n++) {
+        for (int64_t k = c * block_k; k < k_end; k++) {
+          float v = weight[n * K + k];
+          nonzero |= v != 0.f;
+          block[(k - c * block_k) * block_n + n - r * block_n] = v;
+        }
+      }
+      if (!nonzero) continue;
+      res.col_idx.push_back(c);
+      res.values.insert(res.values.end(), block.begin(), block.end());
+    }
+    res.row_ptr.push_back(res.col_idx.size());
+  }
+  return res;
+}
+
+namespace {
+
+struct HostTask {
+  const BlockSparseMatmulAttrs* attrs;
+  const BsrMatrix* matrix;
+  const float* x;
+  float* out;
+};
+
+// The outputs of a block row for all the rows of X. The lanes of the outputs are innermost, so that the loops over
+// them are vectorized when the width of the block is known at compile time.
+template <int kBlockN>
+void MultiplyBlockRow(const HostTask& task, int64_t r, int block_n) {
+  auto& attrs   = *task.attrs;
+  auto& matrix  = *task.matrix;
+  int block_k   = matrix.block_k;
+  int64_t n0    = r * block_n;
+  int64_t lanes = std::min<int64_t>(block_n, attrs.N - n0);
+  std::vector<float> acc(block_n);
+  for (int64_t m = 0; m < attrs.M; m++) {
+    const float* x = task.x + m * attrs.K;
+    std::fill(acc.begin(), acc.end(), 0.f);
+    for (int32_t b = matrix.row_ptr[r]; b < matrix.row_ptr[r + 1]; b++) {
+      int64_t k0          = static_cast<int64_t>(matrix.col_idx[b]) * block_k;
+      int64_t k_end       = std::min<int64_t>(attrs.K - k0, block_k);
+      const float* values = matrix.values.data() + static_cast<int64_t>(b) * block_k * block_n;
+      for (int64_t kk = 0; kk < k_end; kk++) {
+        float xv            = x[k0 + kk];
+        const float* column = values + kk * block_n;
+        if (kBlockN) {
+          for (int j = 0; j < kBlockN; j++) acc[j] += xv * column[j];
+        } else {
+          for (int j = 0; j < block_n; j++) acc[j] += xv * column[j];
+        }
+      }
+    }
+    std::copy(acc.begin(), acc.begin() + lanes, task.out + m * attrs.N + n0);
+  }
+}
+
+int MultiplyBlockRowOnHost(int task_id, int num_task, void* datas) {
+  auto& task  = *static_cast<HostTask*>(datas);
+  int block_n = task.matrix->block_n;
+  switch (block_n) {
+    case 16:
+      MultiplyBlockRow<16>(task, task_id, block_n);
+      break;
+    case 8:
+      MultiplyBlockRow<8>(task, task_id, block_n);
+      break;
+    default:
+      MultiplyBlockRow<0>(task, task_id, block_n);
+  }
+  return 0;
+}
+
+#ifdef CINN_WITH_CUDA
+// The same product as MultiplyBlockRow, each CUDA block computes a block row of blockDim.y rows of X, with a thread per
+// output of the block row.
+const char* kBlockSparseKernelSource = R"ROC(
+extern "C" {
+
+__global__ void cinn_block_sparse_matmul(const float* x, const int* row_ptr, const int* col_idx, const float* values,
+                                         float* out, long long M, long long N, long long K, int block_k) {
+  int block_n = blockDim.x;
+  long long n = static_cast<long long>(blockIdx.x) * block_n + threadIdx.x;
+  long long m = static_cast<long long>(blockIdx.y) * blockDim.y + threadIdx.y;
+  if (m >= M) return;
+  const float* row = x + m * K;
+  float acc        = 0.f;
+  for (int b = row_ptr[blockIdx.x]; b < row_ptr[blockIdx.x + 1]; b++) {
+    long long k0        = static_cast<long long>(col_idx[b]) * block_k;
+    int k_end           = K - k0 < block_k ? K - k0 : block_k;
+    const float* column = values + static_cast<long long>(b) * block_k * block_n + threadIdx.x;
+    for (int kk = 0; kk < k_end; kk++) acc += row[k0 + kk] * column[kk * block_n];
+  }
+  if (n < N) out[m * N + n] = acc;
+}
+
+}
+)ROC";
+
+// The module of the kernel.
+cuda::CUDAModule* KernelModule() {
+  static cuda::LazyCUDAModule module(kBlockSparseKernelSource);
+  return module.get();
+}
+
+constexpr int kThreadsPerBlock = 256;
+#endif
+
+}  // namespace
+
+BlockSparseMatmul::BlockSparseMatmul(const BlockSparseMatmulAttrs& attrs, const common::Target& target)
+    : attrs_(attrs), target_(target) {
+  CHECK(attrs_.M > 0 && attrs_.N > 0 && attrs_.K > 0)
+      << "The block-sparse matmul got an empty shape " << attrs_.M << " x " << attrs_.K << " x " << attrs_.N;
+  CHECK(attrs_.block_n > 0 && attrs_.block_k > 0) << "The blocks of the block-sparse matmul should not be empty";
+  CHECK(target_.is_cpu() || target_.arch == common::Target::Arch::NVGPU)
+      << "The block-sparse matmul runs on CPU or NVGPU only";
+#ifdef CINN_WITH_CUDA
+  if (target_.arch == common::Target::Arch::NVGPU) {
+    CHECK_LE(attrs_.block_n, kThreadsPerBlock) << "The blocks on NVGPU are at most " << kThreadsPerBlock << " wide";
+  }
+#endif
+}
+
+bool BlockSparseMatmul::Prepare(const std::vector<cinn_pod_value_t>& args) {
+  CHECK_GE(args.size(), 3UL) << "The block-sparse matmul should take X, W and the output";
+  cinn_buffer_t* weight_buffer = args[1];
+  CHECK(weight_buffer && weight_buffer->memory) << "The weight of the block-sparse matmul is not allocated";
+  const void* weight = weight_buffer->memory;
+  if (weight == packed_weight_) return sparse_;
+
+  std::vector<float> host_weight;
+  const float* data = static_cast<const float*>(weight);
+  if (target_.arch == common::Target::Arch::NVGPU) {
+#ifdef CINN_WITH_CUDA
+    host_weight.resize(attrs_.N * attrs_.K);
+    CUDA_CALL(cudaMemcpy(host_weight.data(), weight, host_weight.size() * sizeof(float), cudaMemcpyDeviceToHost));
+    data = host_weight.data();
+#else
+    LOG(FATAL) << "The block-sparse matmul on NVGPU needs CINN built with CUDA";
+#endif
+  }
+  matrix_        = MakeBsrMatrix(data, attrs_.N, attrs_.K, attrs_.block_n, attrs_.block_k);
+  packed_weight_ = weight;
+  sparse_        = matrix_.density() <= attrs_.density_threshold;
+  VLOG(3) << "The weight of the block-sparse matmul has " << matrix_.num_blocks() << " nonzero blocks of "
+          << attrs_.block_n << " x " << attrs_.block_k << ", density " << matrix_.density() << ", and runs "
+          << (sparse_ ? "sparse" : "dense");
+  if (sparse_ && target_.arch == common::Target::Arch::NVGPU) Upload();
+  return sparse_;
+}
+
+void BlockSparseMatmul::Run(const std::vector<cinn_pod_value_t>& args, void* stream) {
+  CHECK(Prepare(args)) << "The weight of the block-sparse matmul is too dense to run sparse";
+  cinn_buffer_t* x_buffer   = args[0];
+  cinn_buffer_t* out_buffer = args[2];
+  CHECK(x_buffer && x_buffer->memory) << "The X of the block-sparse matmul is not allocated";
+  CHECK(out_buffer && out_buffer->memory) << "The output of the block-sparse matmul is not allocated";
+  auto* x   = reinterpret_cast<const float*>(x_buffer->memory);
+  auto* out = reinterpret_cast<float*>(out_buffer->memory);
+  if (target_.arch == common::Target::Arch::NVGPU) {
+    RunOnDevice(x, out, stream);
+  } else {
+    RunOnHost(x, out);
+  }
+}
+
+void BlockSparseMatmul::RunOnHost(const float* x, float* out) {
+  HostTask task{&attrs_, &matrix_, x, out};
+  cinn_backend_parallel_launch(MultiplyBlockRowOnHost, &task, matrix_.block_rows);
+}
+
+void BlockSparseMatmul::Upload() {
+#ifdef CINN_WITH_CUDA
+  if (device_matrix_) cudaFree(device_matrix_);
+  CUDA_CALL(cudaGetDevice(&device_id_));
+  size_t ptr_bytes = matrix_.row_ptr.size() * sizeof(int32_t);
+  size_t idx_bytes = matrix_.col_idx.size() * sizeof(int32_t);
+  // the values follow the indices at a 16-byte aligned offset
+  size_t values_offset = (ptr_bytes + idx_bytes + 15) / 16 * 16;
+  size_t values_bytes  = matrix_.values.size() * sizeof(float);
+  CUDA_CALL(cudaMalloc(&device_matrix_, values_offset + values_bytes));
+  auto* base = static_cast<char*>(device_matrix_);
+  CUDA_CALL(cudaMemcpy(base, matrix_.row_ptr.data(), ptr_bytes, cudaMemcpyHostToDevice));
+  if (idx_bytes) CUDA_CALL(cudaMemcpy(base + ptr_bytes, matrix_.col_idx.data(), idx_bytes, cudaMemcpyHostToDevice));
+  if (values_bytes) {
+    CUDA_CALL(cudaMemcpy(base + values_offset, matrix_.values.data(), values_bytes, cudaMemcpyHostToDevice));
+  }
+#endif
+}
+
+void BlockSparseMatmul::RunOnDevice(const float* x, float* out, void* stream) {
+#ifdef CINN_WITH_CUDA
+  int device_id = 0;
+  CUDA_CALL(cudaGetDevice(&device_id));
+  CHECK_EQ(device_id, device_id_) << "The block-sparse matmul runs on the device its weight is uploaded to";
+  auto* base         = static_cast<char*>(device_matrix_);
+  size_t ptr_bytes   = matrix_.row_ptr.size() * sizeof(int32_t);
+  size_t idx_bytes   = matrix_.col_idx.size() * sizeof(int32_t);
+  void* row_ptr      = base;
+  void* col_idx      = base + ptr_bytes;
+  void* values       = base + (ptr_bytes + idx_bytes + 15) / 16 * 16;
+  long long M        = attrs_.M;
+  long long N        = attrs_.N;
+  long long K        = attrs_.K;
+  int block_k        = matrix_.block_k;
+  void* args[]       = {&x, &row_ptr, &col_idx, &values, &out, &M, &N, &K, &block_k};
+  int rows_per_block = std::max(1, kThreadsPerBlock / matrix_.block_n);
+  dim3 grid(matrix_.block_rows, (M + rows_per_block - 1) / rows_per_block);
+  dim3 block(matrix_.block_n, rows_per_block);
+  KernelModule()->LaunchKernel(
+      device_id, "cinn_block_sparse_matmul", grid, block, args, 0, static_cast<cudaStream_t>(stream));
+#else
+  LOG(FATAL) << "The block-sparse matmul on NVGPU needs CINN built with CUDA";
+#endif
+}
+
+BlockSparseMatmul::~BlockSparseMatmul() {
+#ifdef CINN_WITH_CUDA
+  if (device_matrix_) cudaFree(device_matrix_);
+#endif
+}
+
+}  // namespace runtime
+}  // namespace cinn
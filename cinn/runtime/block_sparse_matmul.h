@@ -0,0 +1,115 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "cinn/common/macros.h"
+#include "cinn/common/target.h"
+#include "cinn/runtime/cinn_runtime.h"
+
+namespace cinn {
+namespace runtime {
+
+/**
+ * The mul X[M, K] * W[N, K] of a pruned weight. The blocks of the weight are block_n consecutive outputs by block_k
+ * inputs, 1 x 1 for CSR, and the weight runs sparse if the fraction of its nonzero blocks is at most the
+ * density_threshold.
+ */
+struct BlockSparseMatmulAttrs {
+  int64_t M{0};
+  int64_t N{0};
+  int64_t K{0};
+  int block_n{16};
+  int block_k{1};
+  float density_threshold{0.3f};
+};
+
+/**
+ * The weight in the block compressed sparse row(BSR) layout, the block rows are the groups of block_n outputs. The
+ * nonzero blocks of block row r are [row_ptr[r], row_ptr[r + 1]) ordered by their block cols, each stored as
+ * [block_k][block_n] with the outputs contiguous. The blocks crossing the bounds of the weight are padded with zeros.
+ */
+struct BsrMatrix {
+  int64_t block_rows{0};
+  int64_t block_cols{0};
+  int block_n{1};
+  int block_k{1};
+  std::vector<int32_t> row_ptr;
+  std::vector<int32_t> col_idx;
+  std::vector<float> values;
+
+  int64_t num_blocks() const { return col_idx.size(); }
+  //! The fraction of the nonzero blocks.
+  float density() const {
+    return block_rows * block_cols ? static_cast<float>(num_blocks()) / (block_rows * block_cols) : 0.f;
+  }
+};
+
+//! Pack the dense \p weight [N, K] in the row major into the BSR layout, dropping the blocks of all zeros.
+BsrMatrix MakeBsrMatrix(const float* weight, int64_t N, int64_t K, int block_n, int block_k);
+
+/**
+ * The runtime kernel of the op block_sparse_mul, which runs in place of its lowered dense functions when the weight is
+ * sparse enough. The weight is packed into the BSR layout on the first run, and again only when its buffer changes,
+ * so it should be const, e.g. a parameter of a pruned model. On CPU, the block rows run in parallel, and each block
+ * gathers the block_k inputs it multiplies from X. On NVGPU, each CUDA block computes a block row of some rows of X.
+ *
+ * The arguments are X, W and the output [M, N], the other outputs of the lowered functions are not written.
+ */
+class BlockSparseMatmul {
+ public:
+  BlockSparseMatmul(const BlockSparseMatmulAttrs& attrs, const common::Target& target);
+
+  const BlockSparseMatmulAttrs& attrs() const { return attrs_; }
+
+  /**
+   * Pack the weight of \p args if it is not packed yet, and tell whether it is sparse enough to run by this kernel.
+   * Otherwise the dense functions run instead.
+   */
+  bool Prepare(const std::vector<cinn_pod_value_t>& args);
+
+  //! The packed weight, empty before Prepare.
+  const BsrMatrix& matrix() const { return matrix_; }
+
+  //! Run on \p stream on NVGPU, nullptr for the default stream. Prepare should tell it is sparse.
+  void Run(const std::vector<cinn_pod_value_t>& args, void* stream = nullptr);
+
+  ~BlockSparseMatmul();
+
+ private:
+  void RunOnHost(const float* x, float* out);
+
+  void RunOnDevice(const float* x, float* out, void* stream);
+
+  void Upload();
+
+  BlockSparseMatmulAttrs attrs_;
+  common::Target target_;
+  BsrMatrix matrix_;
+  // The weight last packed, which is packed again if it changes.
+  const void* packed_weight_{nullptr};
+  bool sparse_{false};
+
+  // The row_ptr, col_idx and values of the matrix on the device.
+  void* device_matrix_{nullptr};
+  int device_id_{-1};
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(BlockSparseMatmul);
+};
+
+}  // namespace runtime
+}  // namespace cinn
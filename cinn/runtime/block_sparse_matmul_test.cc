@@ -0,0 +1,118 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/runtime/block_sparse_matmul.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace cinn {
+namespace runtime {
+
+namespace {
+std::vector<cinn_pod_value_t> MakeArgs(cinn_buffer_t* buffers, int num) {
+  std::vector<cinn_pod_value_t> res;
+  for (int i = 0; i < num; i++) res.emplace_back(&buffers[i]);
+  return res;
+}
+
+// A [N, K] weight with the blocks of block_n x block_k kept by the probability of density.
+std::vector<float> PrunedWeight(int N, int K, int block_n, int block_k, float density, int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  std::vector<float> weight(N * K);
+  for (auto& v : weight) v = dist(rng);
+  for (int r = 0; r < N; r += block_n) {
+    for (int c = 0; c < K; c += block_k) {
+      if ((dist(rng) + 1.f) / 2.f < density) continue;
+      for (int n = r; n < std::min(N, r + block_n); n++) {
+        for (int k = c; k < std::min(K, c + block_k); k++) weight[n * K + k] = 0.f;
+      }
+    }
+  }
+  return weight;
+}
+
+void TestBlockSparse(int M, int N, int K, int block_n, int block_k) {
+  auto weight = PrunedWeight(N, K, block_n, block_k, 0.2f, 0);
+  std::vector<float> x(M * K), out(M * N, -1.f);
+  for (int i = 0; i < x.size(); i++) x[i] = (i % 7) * 0.25f - 0.5f;
+
+  BlockSparseMatmulAttrs attrs;
+  attrs.M       = M;
+  attrs.N       = N;
+  attrs.K       = K;
+  attrs.block_n = block_n;
+  attrs.block_k = block_k;
+  BlockSparseMatmul matmul(attrs, common::DefaultHostTarget());
+  cinn_buffer_t buffers[3];
+  buffers[0].memory = reinterpret_cast<uint8_t*>(x.data());
+  buffers[1].memory = reinterpret_cast<uint8_t*>(weight.data());
+  buffers[2].memory = reinterpret_cast<uint8_t*>(out.data());
+  auto args = MakeArgs(buffers, 3);
+  ASSERT_TRUE(matmul.Prepare(args));
+  ASSERT_LE(matmul.matrix().density(), 0.3f);
+  matmul.Run(args);
+
+  for (int m = 0; m < M; m++) {
+    for (int n = 0; n < N; n++) {
+      float expected = 0.f;
+      for (int k = 0; k < K; k++) expected += x[m * K + k] * weight[n * K + k];
+      ASSERT_NEAR(out[m * N + n], expected, 1e-4) << "at " << m << ", " << n;
+    }
+  }
+}
+}  // namespace
+
+TEST(BlockSparseMatmul, bsr) {
+  // the last block row and the last block col are partial
+  std::vector<float> weight{1, 0, 0, 2, 0,  //
+                            0, 0, 0, 3, 0,  //
+                            0, 0, 0, 0, 4};
+  auto matrix = MakeBsrMatrix(weight.data(), 3, 5, 2, 2);
+  ASSERT_EQ(matrix.block_rows, 2);
+  ASSERT_EQ(matrix.block_cols, 3);
+  ASSERT_EQ(matrix.row_ptr, (std::vector<int32_t>{0, 2, 3}));
+  ASSERT_EQ(matrix.col_idx, (std::vector<int32_t>{0, 1, 2}));
+  // each block is [block_k][block_n]
+  ASSERT_EQ(matrix.values, (std::vector<float>{1, 0, 0, 0, 0, 0, 2, 3, 4, 0, 0, 0}));
+  ASSERT_FLOAT_EQ(matrix.density(), 0.5f);
+}
+
+TEST(BlockSparseMatmul, block_16x1) { TestBlockSparse(5, 40, 33, 16, 1); }
+
+TEST(BlockSparseMatmul, block_4x4) { TestBlockSparse(3, 18, 21, 4, 4); }
+
+TEST(BlockSparseMatmul, csr) { TestBlockSparse(4, 9, 13, 1, 1); }
+
+TEST(BlockSparseMatmul, dense) {
+  std::vector<float> weight(16 * 8, 1.f), x(8, 1.f), out(16);
+  BlockSparseMatmulAttrs attrs;
+  attrs.M = 1;
+  attrs.N = 16;
+  attrs.K = 8;
+  BlockSparseMatmul matmul(attrs, common::DefaultHostTarget());
+  cinn_buffer_t buffers[3];
+  buffers[0].memory = reinterpret_cast<uint8_t*>(x.data());
+  buffers[1].memory = reinterpret_cast<uint8_t*>(weight.data());
+  buffers[2].memory = reinterpret_cast<uint8_t*>(out.data());
+  // a dense weight runs by the dense functions
+  ASSERT_FALSE(matmul.Prepare(MakeArgs(buffers, 3)));
+  ASSERT_FLOAT_EQ(matmul.matrix().density(), 1.f);
+}
+
+}  // namespace runtime
+}  // namespace cinn
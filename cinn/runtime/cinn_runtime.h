@@ -44,13 +44,17 @@ typedef enum cinn_type_code_t {
   cinn_type_int    = 0,   //! signed int
   cinn_type_uint   = 1,   //! unsigned int
   cinn_type_float  = 2,   //! floating point
-  cinn_type_handle = 3    //! void*
+  cinn_type_handle = 3,   //! void*
+  cinn_type_bfloat = 4    //! bfloat16, the upper 16 bits of a float32
 } cinn_type_code_t;
 
 #ifndef CINN_ATTRIBUTE_ALIGN
 #define CINN_ATTRIBUTE_ALIGN(n) __attribute__((aligned(n)))
 #endif
 
+//! The alignment in bytes of the data of the host buffers, a cache line and an AVX-512 vector.
+#define CINN_BUFFER_ALIGNMENT 64
+
 /**
  * A tuntime tag for type in CINN system.
  */
@@ -91,6 +95,8 @@ extern cinn_type_t cinn_int32_t(int num_asterisks = 0);
 extern cinn_type_t cinn_int64_t(int num_asterisks = 0);
 extern cinn_type_t cinn_uint32_t(int num_asterisks = 0);
 extern cinn_type_t cinn_uint64_t(int num_asterisks = 0);
+extern cinn_type_t cinn_float16_t(int num_asterisks = 0);
+extern cinn_type_t cinn_bfloat16_t(int num_asterisks = 0);
 extern cinn_type_t cinn_float32_t(int num_asterisks = 0);
 extern cinn_type_t cinn_float64_t(int num_asterisks = 0);
 // @}
@@ -109,8 +115,9 @@ typedef enum cinn_device_kind_t {
 
 //! Help to tell where the buffer locates.
 typedef enum cinn_buffer_kind_t {
-  cinn_buffer_on_host   = 0,      //! buffer on host
-  cinn_buffer_on_device = 1 << 1  // ! buffer on device e.g. GPU.
+  cinn_buffer_on_host        = 0,       //! buffer on host
+  cinn_buffer_on_device      = 1 << 1,  // ! buffer on device e.g. GPU.
+  cinn_buffer_on_pinned_host = 1 << 2   //! buffer on page-locked host memory, which can be copied asynchronously.
 } cinn_buffer_kind_t;
 
 struct cinn_buffer_t;
@@ -161,7 +168,7 @@ extern void* cinn_buffer_get_data_handle(struct cinn_buffer_t* buf);
 extern void* cinn_buffer_get_data_const_handle(const struct cinn_buffer_t* buf);
 
 //! Create a new default cinn_buffer.
-extern cinn_buffer_t* cinn_buffer_new_default(int target, uint64_t memory_size, int align = 32);
+extern cinn_buffer_t* cinn_buffer_new_default(int target, uint64_t memory_size, int align = CINN_BUFFER_ALIGNMENT);
 
 //! The raw representation of a buffer,used in the generated code/lib.
 #define CINN_BUFFER_MAX_DIMS 8
@@ -234,6 +241,8 @@ typedef struct cinn_buffer_t {
   CINN_ALWAYS_INLINE bool on_device() const { return get_flag(cinn_buffer_on_device); }
   CINN_ALWAYS_INLINE void set_on_host(bool x = true) { set_flag(cinn_buffer_on_host, x); }
   CINN_ALWAYS_INLINE void set_on_device(bool x = true) { set_flag(cinn_buffer_on_device, x); }
+  CINN_ALWAYS_INLINE bool on_pinned_host() const { return get_flag(cinn_buffer_on_pinned_host); }
+  CINN_ALWAYS_INLINE void set_on_pinned_host(bool x = true) { set_flag(cinn_buffer_on_pinned_host, x); }
 
   CINN_ALWAYS_INLINE int device_sync(void* ctx = NULL) {
     if (device_interface && device_interface->sync) {
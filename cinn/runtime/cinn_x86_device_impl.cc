@@ -35,7 +35,9 @@ int cinn_x86_malloc(void* context, cinn_buffer_t* buf) {
     if (buf->align == 0) {
       buf->memory = (unsigned char*)malloc(memory_size);
     } else {
-      buf->memory = (unsigned char*)aligned_alloc(buf->align, memory_size);
+      // the size of aligned_alloc is a multiple of the alignment
+      uint64_t aligned_size = (memory_size + buf->align - 1) / buf->align * buf->align;
+      buf->memory           = (unsigned char*)aligned_alloc(buf->align, aligned_size);
     }
     buf->memory_size = memory_size;
     CINN_LOG("buf.memory size is %ld\n", buf->memory_size);
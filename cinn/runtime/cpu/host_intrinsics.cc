@@ -17,8 +17,18 @@
 #include <glog/logging.h>
 #include <math.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
 #include "cinn/backends/extern_func_jit_register.h"
 #include "cinn/backends/function_prototype.h"
+#include "cinn/backends/llvm/runtime_symbol_registry.h"
+#include "cinn/common/target.h"
+#include "cinn/runtime/cpu/thread_backend.h"
+#include "cinn/runtime/intrinsic.h"
 
 #ifdef CINN_WITH_MKL_CBLAS
 #include "cinn/runtime/cpu/mkl_math.h"
@@ -35,6 +45,205 @@ void __cinn_host_tanh_v(const cinn_buffer_t* x, cinn_buffer_t* out) {
     out_data[i] = tanhf(x_data[i]);
   }
 }
+
+int cinn_x86_host_supports(int features) { return (cinn::common::GetHostX86Features() & features) == features; }
+
+float cinn_host_half_to_float(uint16_t x) {
+  uint32_t sign     = static_cast<uint32_t>(x & 0x8000) << 16;
+  uint32_t exponent = (x >> 10) & 0x1f;
+  uint32_t mantissa = x & 0x3ff;
+  float res;
+  if (exponent == 0) {
+    // zero or subnormal, the value of which is mantissa * 2^-24
+    res = std::ldexp(static_cast<float>(mantissa), -24);
+    return sign ? -res : res;
+  }
+  // the infinities and NaNs keep their mantissa, the others rebias the exponent from 15 to 127
+  uint32_t bits = sign | (exponent == 0x1f ? 0x7f800000 : (exponent + 112) << 23) | (mantissa << 13);
+  std::memcpy(&res, &bits, sizeof(res));
+  return res;
+}
+
+uint16_t cinn_host_float_to_half(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  uint16_t sign = (bits >> 16) & 0x8000;
+  uint32_t abs  = bits & 0x7fffffff;
+  if (abs > 0x7f800000) return sign | 0x7e00;  // NaN
+  // 65520, halfway between the largest half 65504 and 65536, and the larger ones round to the infinity
+  if (abs >= 0x477ff000) return sign | 0x7c00;
+  if (abs < 0x38800000) {
+    // below the smallest normal half 2^-14, the subnormal half is x * 2^24 rounded, which is exact in float
+    float value;
+    std::memcpy(&value, &abs, sizeof(value));
+    return sign | static_cast<uint16_t>(std::nearbyint(value * 16777216.f));
+  }
+  // rebias the exponent from 127 to 15 and round the 13 dropped bits to the nearest even, carrying to the exponent
+  return sign | static_cast<uint16_t>((abs - 0x38000000 + 0xfff + ((abs >> 13) & 1)) >> 13);
+}
+
+uint16_t cinn_host_double_to_half(double x) { return cinn_host_float_to_half(static_cast<float>(x)); }
+
+float cinn_host_philox_uniform(int seed, int offset, int index) {
+  uint32_t c0 = index, c1 = offset, c2 = 0, c3 = 0;
+  uint32_t k0 = seed, k1 = 0;
+  for (int round = 0; round < 10; round++) {
+    uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+    uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+    uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+    uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+    c1          = static_cast<uint32_t>(p1);
+    c3          = static_cast<uint32_t>(p0);
+    c0          = n0;
+    c2          = n2;
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+  // the 24 high bits, which a float represents exactly
+  return static_cast<float>(c0 >> 8) * (1.f / 16777216.f);
+}
+}
+
+namespace {
+
+struct TopKArgs {
+  int rows;
+  int cols;
+  int k;
+  bool largest;
+  const float* x;
+  float* values;
+  int* indices;
+};
+
+template <bool largest>
+void TopKRow(const float* row, int cols, int k, int* order) {
+  // the ties are ordered by their indices
+  auto before = [row](int a, int b) {
+    return largest ? row[a] > row[b] || (row[a] == row[b] && a < b) : row[a] < row[b] || (row[a] == row[b] && a < b);
+  };
+  if (k * 8 > cols) {
+    std::vector<int> all(cols);
+    std::iota(all.begin(), all.end(), 0);
+    std::partial_sort(all.begin(), all.begin() + k, all.end(), before);
+    std::copy(all.begin(), all.begin() + k, order);
+    return;
+  }
+  // the front of the heap is the last of the k selected, which most elements of a long row are not before
+  std::iota(order, order + k, 0);
+  std::make_heap(order, order + k, before);
+  for (int j = k; j < cols; j++) {
+    if (!before(j, order[0])) continue;
+    std::pop_heap(order, order + k, before);
+    order[k - 1] = j;
+    std::push_heap(order, order + k, before);
+  }
+  std::sort_heap(order, order + k, before);
+}
+
+int TopKTask(int task_id, int num_task, void* datas) {
+  auto* args = static_cast<TopKArgs*>(datas);
+  int begin  = static_cast<int64_t>(args->rows) * task_id / num_task;
+  int end    = static_cast<int64_t>(args->rows) * (task_id + 1) / num_task;
+  for (int i = begin; i < end; i++) {
+    const float* row = args->x + static_cast<int64_t>(i) * args->cols;
+    int* order       = args->indices + static_cast<int64_t>(i) * args->k;
+    if (args->largest) {
+      TopKRow<true>(row, args->cols, args->k, order);
+    } else {
+      TopKRow<false>(row, args->cols, args->k, order);
+    }
+    float* values = args->values + static_cast<int64_t>(i) * args->k;
+    for (int j = 0; j < args->k; j++) values[j] = row[order[j]];
+  }
+  return 0;
+}
+
+struct BatchNormStatsArgs {
+  int outer;
+  int channels;
+  int inner;
+  const float* x;
+  // the sums of the shifted elements and of their squares of each task
+  std::vector<double> sums;
+  std::vector<double> square_sums;
+};
+
+int BatchNormStatsTask(int task_id, int num_task, void* datas) {
+  auto* args   = static_cast<BatchNormStatsArgs*>(datas);
+  int begin    = static_cast<int64_t>(args->outer) * task_id / num_task;
+  int end      = static_cast<int64_t>(args->outer) * (task_id + 1) / num_task;
+  double* sums = args->sums.data() + static_cast<int64_t>(task_id) * args->channels;
+  double* sqs  = args->square_sums.data() + static_cast<int64_t>(task_id) * args->channels;
+  for (int o = begin; o < end; o++) {
+    for (int c = 0; c < args->channels; c++) {
+      const float* in = args->x + (static_cast<int64_t>(o) * args->channels + c) * args->inner;
+      float shift     = args->x[static_cast<int64_t>(c) * args->inner];
+      double sum = 0, sq = 0;
+      for (int i = 0; i < args->inner; i++) {
+        double value = in[i] - shift;
+        sum += value;
+        sq += value * value;
+      }
+      sums[c] += sum;
+      sqs[c] += sq;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+extern "C" {
+
+void cinn_cpu_top_k_fp32(
+    int rows, int cols, int k, int largest, const cinn_buffer_t* x, cinn_buffer_t* values, cinn_buffer_t* indices) {
+  CINN_CHECK(k > 0 && k <= cols);
+  TopKArgs args{rows,
+                cols,
+                k,
+                largest != 0,
+                reinterpret_cast<const float*>(x->memory),
+                reinterpret_cast<float*>(values->memory),
+                reinterpret_cast<int*>(indices->memory)};
+  // the short rows are selected on the calling thread
+  int num_task = std::min(rows, std::max(static_cast<int>(static_cast<int64_t>(rows) * cols / 4096), 1));
+  num_task     = std::min(num_task, max_concurrency());
+  if (num_task <= 1) {
+    TopKTask(0, 1, &args);
+  } else {
+    cinn_backend_parallel_launch(TopKTask, &args, num_task);
+  }
+}
+
+void cinn_cpu_batch_norm_stats_fp32(
+    int outer, int channels, int inner, const cinn_buffer_t* x, cinn_buffer_t* mean, cinn_buffer_t* variance) {
+  CINN_CHECK(outer > 0 && channels > 0 && inner > 0);
+  int64_t numel = static_cast<int64_t>(outer) * channels * inner;
+  int num_task  = std::min<int64_t>(outer, std::max<int64_t>(numel / 16384, 1));
+  num_task      = std::min(num_task, max_concurrency());
+  BatchNormStatsArgs args{outer, channels, inner, reinterpret_cast<const float*>(x->memory)};
+  args.sums.assign(static_cast<int64_t>(num_task) * channels, 0);
+  args.square_sums.assign(static_cast<int64_t>(num_task) * channels, 0);
+  if (num_task <= 1) {
+    BatchNormStatsTask(0, 1, &args);
+  } else {
+    cinn_backend_parallel_launch(BatchNormStatsTask, &args, num_task);
+  }
+  auto* mean_data     = reinterpret_cast<float*>(mean->memory);
+  auto* variance_data = reinterpret_cast<float*>(variance->memory);
+  double count        = static_cast<double>(outer) * inner;
+  for (int c = 0; c < channels; c++) {
+    double sum = 0, sq = 0;
+    for (int t = 0; t < num_task; t++) {
+      sum += args.sums[static_cast<int64_t>(t) * channels + c];
+      sq += args.square_sums[static_cast<int64_t>(t) * channels + c];
+    }
+    double shifted_mean = sum / count;
+    mean_data[c]        = args.x[static_cast<int64_t>(c) * inner] + shifted_mean;
+    variance_data[c]    = std::max(sq / count - shifted_mean * shifted_mean, 0.);
+  }
+}
 }
 
 CINN_REGISTER_HELPER(host_intrinsics) {
@@ -54,5 +263,62 @@ CINN_REGISTER_HELPER(host_intrinsics) {
   REGISTER_EXTERN_FUNC_1_IN_1_OUT_FP32(atanf);
   REGISTER_EXTERN_FUNC_1_IN_1_OUT_FP32(atanhf);
 
+  REGISTER_EXTERN_FUNC_HELPER(cinn_host_philox_uniform, host_target)
+      .SetRetType<float>()
+      .AddInputType<int>()  // seed
+      .AddInputType<int>()  // offset
+      .AddInputType<int>()  // index
+      .End();
+
+  cinn::backends::RuntimeSymbolRegistry::Global().RegisterFn(cinn::runtime::intrinsic::x86_host_supports,
+                                                             reinterpret_cast<void*>(&cinn_x86_host_supports));
+  // the float16 is converted by F16C if the host supports it, or else by these calls
+  cinn::backends::RuntimeSymbolRegistry::Global().RegisterFn(cinn::runtime::intrinsic::half_to_float,
+                                                             reinterpret_cast<void*>(&cinn_host_half_to_float));
+  cinn::backends::RuntimeSymbolRegistry::Global().RegisterFn(cinn::runtime::intrinsic::float_to_half,
+                                                             reinterpret_cast<void*>(&cinn_host_float_to_half));
+  cinn::backends::RuntimeSymbolRegistry::Global().RegisterFn(cinn::runtime::intrinsic::double_to_half,
+                                                             reinterpret_cast<void*>(&cinn_host_double_to_half));
+
+  // the values and the indices of top_k are in the shape of x except the last axis of k
+  FunctionProto::shape_inference_t inference_shape_top_k = [](const std::vector<cinn::ir::Expr>& args, int offset) {
+    CHECK_EQ(args.size(), 5UL) << "Wrong number of arguments passed in";
+    auto* x = args[4].as_tensor();
+    CHECK(x);
+    auto shape   = x->shape;
+    shape.back() = args[2];
+    return shape;
+  };
+
+  REGISTER_EXTERN_FUNC_HELPER(cinn_cpu_top_k_fp32, host_target)
+      .SetRetType<void>()
+      .AddInputType<int>()              // rows
+      .AddInputType<int>()              // cols
+      .AddInputType<int>()              // k
+      .AddInputType<int>()              // largest
+      .AddInputType<cinn_buffer_t*>()   // x
+      .AddOutputType<cinn_buffer_t*>()  // values
+      .AddOutputType<cinn_buffer_t*>()  // indices
+      .SetShapeInference(inference_shape_top_k)
+      .End();
+
+  // the mean and the variance of the batch norm are of the channels
+  FunctionProto::shape_inference_t inference_shape_batch_norm_stats = [](const std::vector<cinn::ir::Expr>& args,
+                                                                         int offset) {
+    CHECK_EQ(args.size(), 4UL) << "Wrong number of arguments passed in";
+    return std::vector<cinn::ir::Expr>{args[1]};
+  };
+
+  REGISTER_EXTERN_FUNC_HELPER(cinn_cpu_batch_norm_stats_fp32, host_target)
+      .SetRetType<void>()
+      .AddInputType<int>()              // outer
+      .AddInputType<int>()              // channels
+      .AddInputType<int>()              // inner
+      .AddInputType<cinn_buffer_t*>()   // x
+      .AddOutputType<cinn_buffer_t*>()  // mean
+      .AddOutputType<cinn_buffer_t*>()  // variance
+      .SetShapeInference(inference_shape_batch_norm_stats)
+      .End();
+
   return true;
 }
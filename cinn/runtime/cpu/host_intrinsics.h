@@ -24,4 +24,36 @@ extern "C" {
 //@{
 void __cinn_host_tanh_v(const cinn_buffer_t* x, cinn_buffer_t* out);
 //@}
+
+//! Whether the host CPU supports all the \p features, a mask of the common::Target::X86Feature.
+int cinn_x86_host_supports(int features);
+
+//! The conversions between float32 and the bits of float16, rounding to the nearest even.
+//@{
+float cinn_host_half_to_float(uint16_t x);
+uint16_t cinn_host_float_to_half(float x);
+uint16_t cinn_host_double_to_half(double x);
+//@}
+
+/**
+ * The uniform float in [0, 1) of the element \p index by Philox4x32-10, keyed by \p seed with the counter
+ * {index, offset, 0, 0}, the same numbers as cinn_nvgpu_philox_uniform on NVGPU.
+ */
+float cinn_host_philox_uniform(int seed, int offset, int index);
+
+/**
+ * Select the k largest, or smallest if \p largest is 0, elements of each row of \p x in [rows, cols], and write them
+ * in the descending, or ascending, order into \p values in [rows, k] along with their int32 \p indices. The rows run
+ * in parallel, each selected by a heap of k elements, or by the partial sort if k is not far less than the row.
+ */
+void cinn_cpu_top_k_fp32(
+    int rows, int cols, int k, int largest, const cinn_buffer_t* x, cinn_buffer_t* values, cinn_buffer_t* indices);
+
+/**
+ * The mean and the biased variance of each channel of \p x in [outer, channels, inner], for the batch norm in the
+ * training, reduced in a single pass. The tasks split the outer axis and accumulate the moments of the elements shifted
+ * by the first of their channel in double, which are merged after.
+ */
+void cinn_cpu_batch_norm_stats_fp32(
+    int outer, int channels, int inner, const cinn_buffer_t* x, cinn_buffer_t* mean, cinn_buffer_t* variance);
 }
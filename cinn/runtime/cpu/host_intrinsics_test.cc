@@ -65,6 +65,78 @@ TEST(tanh, basic) {
   }
 }
 
+TEST(half, conversion) {
+  for (uint32_t bits = 0; bits < 65536; bits++) {
+    uint16_t x = bits;
+    float f    = cinn_host_half_to_float(x);
+    if (std::isnan(f)) {
+      ASSERT_EQ(x & 0x7c00, 0x7c00);
+      continue;
+    }
+    ASSERT_EQ(cinn_host_float_to_half(f), x) << "the half " << x << " doesn't round trip";
+  }
+  ASSERT_EQ(cinn_host_half_to_float(0x3c00), 1.f);
+  ASSERT_EQ(cinn_host_half_to_float(0xc000), -2.f);
+  ASSERT_EQ(cinn_host_half_to_float(0x0001), std::ldexp(1.f, -24));
+  // to the nearest even
+  ASSERT_EQ(cinn_host_float_to_half(1.f + std::ldexp(1.f, -11)), 0x3c00);
+  ASSERT_EQ(cinn_host_float_to_half(1.f + 3 * std::ldexp(1.f, -11)), 0x3c02);
+  ASSERT_EQ(cinn_host_float_to_half(65504.f), 0x7bff);
+  ASSERT_EQ(cinn_host_float_to_half(65520.f), 0x7c00);
+  ASSERT_EQ(cinn_host_float_to_half(std::ldexp(1.f, -26)), 0x0000);
+  ASSERT_TRUE(std::isnan(cinn_host_half_to_float(cinn_host_float_to_half(NAN))));
+}
+
+TEST(philox, uniform) {
+  // the first word of the known answer of Philox4x32-10 with the zero key and counter
+  ASSERT_EQ(cinn_host_philox_uniform(0, 0, 0), (0x6627e8d5u >> 8) * std::ldexp(1.f, -24));
+  double sum = 0;
+  for (int i = 0; i < 10000; i++) {
+    float u = cinn_host_philox_uniform(2021, 7, i);
+    ASSERT_TRUE(u >= 0.f && u < 1.f);
+    ASSERT_EQ(u, cinn_host_philox_uniform(2021, 7, i));
+    sum += u;
+  }
+  ASSERT_NEAR(sum / 10000, 0.5, 0.01);
+  ASSERT_NE(cinn_host_philox_uniform(2021, 7, 0), cinn_host_philox_uniform(2021, 8, 0));
+}
+
+// the float16 and bfloat16 are lowered by LLVM, the bfloat16 computes in float32
+TEST(half, jit_cast) {
+  Expr M(16);
+  Placeholder<float> x("x", {M});
+  for (auto& type : {Float(16), BFloat16()}) {
+    auto y = Compute(
+        {M},
+        [&](Expr i) {
+          auto half = ir::Cast::Make(type, x(i));
+          return ir::Cast::Make(Float(32), half * half);
+        },
+        "y");
+    auto stages = CreateStages({y});
+    auto jit    = backends::SimpleJIT::Create();
+    ir::Module::Builder builder("module_" + utils::GetStreamCnt(type), common::DefaultHostTarget());
+    builder.AddFunction(Lower("fn", stages, {x, y}));
+    jit->Link(builder.Build());
+    auto fnp = reinterpret_cast<lower_func_ptr_t>(jit->Lookup("fn"));
+    ASSERT_TRUE(fnp);
+
+    auto* x_buf   = common::BufferBuilder(Float(32), {16}).set_random().Build();
+    auto* out_buf = common::BufferBuilder(Float(32), {16}).set_zero().Build();
+    auto args     = common::ArgsBuilder().Add(x_buf).Add(out_buf).Build();
+    fnp(args.data(), args.size());
+
+    auto* x_data   = reinterpret_cast<float*>(x_buf->memory);
+    auto* out_data = reinterpret_cast<float*>(out_buf->memory);
+    // 11 and 8 significant bits
+    float tolerance = type.is_float(16) ? 2e-3 : 2e-2;
+    for (int i = 0; i < 16; i++) {
+      float expected = x_data[i] * x_data[i];
+      ASSERT_NEAR(out_data[i], expected, tolerance * std::abs(expected) + 1e-6) << type;
+    }
+  }
+}
+
 }  // namespace cpu
 }  // namespace runtime
 }  // namespace cinn
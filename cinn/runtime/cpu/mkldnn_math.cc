@@ -14,6 +14,13 @@
 
 #include "cinn/runtime/cpu/mkldnn_math.h"
 
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "cinn/backends/extern_func_jit_register.h"
@@ -24,61 +31,127 @@ using mkldnn::memory;
 using tag = memory::format_tag;
 using dt  = memory::data_type;
 
-void cinn_cpu_mkldnn_softmax_fp32(
-    int batch, int channel, int h, int w, int axis, cinn_buffer_t* inputs, cinn_buffer_t* out) {
-  auto engine = mkldnn::engine(mkldnn::engine::kind::cpu, 0);
-  mkldnn::stream engine_stream(engine);
-
-  memory::dims src_dims = {batch, channel};
-  if (h != 1) src_dims.push_back(h);
-  if (w != 1) src_dims.push_back(w);
-  int size        = src_dims.size();
-  auto format_tag = tag::nc;
-  switch (size) {
-    case 2:
-      format_tag = tag::ab;
-      break;
-    case 3:
-      format_tag = tag::abc;
-      break;
-    case 4:
-      format_tag = tag::abcd;
-      break;
-    default:
-      LOG(FATAL) << "wrong dim: " << size;
-      break;
-  }
+namespace {
 
-  auto src_md       = memory::desc(src_dims, dt::f32, format_tag);
-  auto src_mem      = memory(src_md, engine, reinterpret_cast<float*>(inputs->memory));
-  auto dst_mem      = memory(src_md, engine, reinterpret_cast<float*>(out->memory));
-  auto softmax_d    = mkldnn::softmax_forward::desc(mkldnn::prop_kind::forward_inference, src_md, axis);
-  auto softmax_pd   = mkldnn::softmax_forward::primitive_desc(softmax_d, engine);
-  auto softmax_prim = mkldnn::softmax_forward(softmax_pd);
+mkldnn::engine& CpuEngine() {
+  static mkldnn::engine engine(mkldnn::engine::kind::cpu, 0);
+  return engine;
+}
 
-  softmax_prim.execute(engine_stream, {{DNNL_ARG_SRC, src_mem}, {DNNL_ARG_DST, dst_mem}});
-  engine_stream.wait();
+//! The streams are not thread safe, each thread executes the primitives on its own one.
+mkldnn::stream& CpuStream() {
+  thread_local mkldnn::stream stream(CpuEngine());
+  return stream;
 }
 
-void cinn_cpu_mkldnn_conv2d_nchw_fp32(int batch_size,
-                                      int c_in,
-                                      int input_h,
-                                      int input_w,
-                                      int c_out,
-                                      int group,
-                                      int filter_h,
-                                      int filter_w,
-                                      int pad_h,
-                                      int pad_w,
-                                      int stride_h,
-                                      int stride_w,
-                                      int dilation_h,
-                                      int dilation_w,
-                                      cinn_buffer_t* inputs,
-                                      cinn_buffer_t* weights,
-                                      cinn_buffer_t* out) {
-  auto cpu_engine = mkldnn::engine(mkldnn::engine::kind::cpu, 0);
-  mkldnn::stream cpu_stream(cpu_engine);
+std::string MakeKey(const std::string& name, const std::vector<int>& attrs) {
+  std::string key = name;
+  for (int attr : attrs) {
+    key += "," + std::to_string(attr);
+  }
+  return key;
+}
+
+struct SoftmaxPrimitive {
+  memory::desc md;
+  mkldnn::softmax_forward prim;
+};
+
+struct ConvPrimitive {
+  memory::desc user_src_md;
+  memory::desc user_weights_md;
+  mkldnn::convolution_forward::primitive_desc pd;
+  mkldnn::convolution_forward prim;
+  //! Set when oneDNN picks a blocked source format, the NCHW input is reordered to it on each call.
+  std::unique_ptr<mkldnn::reorder> src_reorder;
+};
+
+/**
+ * The primitives created for each shape and attributes, and the weights reordered to the formats picked by oneDNN.
+ * Creating a primitive JITs its kernel, which may cost more than executing a small convolution, and the primitives
+ * are safe to be executed by several threads, so they are created once and shared by all the calls.
+ */
+class PrimitiveCache {
+ public:
+  static PrimitiveCache& Global() {
+    static PrimitiveCache cache;
+    return cache;
+  }
+
+  template <typename CreateFn>
+  std::shared_ptr<SoftmaxPrimitive> GetSoftmax(const std::string& key, CreateFn&& create) {
+    return Get(&softmaxes_, key, create);
+  }
+
+  template <typename CreateFn>
+  std::shared_ptr<ConvPrimitive> GetConv(const std::string& key, CreateFn&& create) {
+    return Get(&convs_, key, create);
+  }
+
+  /**
+   * The weights in the format of \p conv, reordered from \p weights at the first call and reused afterwards, as the
+   * weights of an inference program are constant. Set CINN_MKLDNN_CACHE_WEIGHTS=0 to reorder them on each call.
+   */
+  memory GetWeights(const std::string& key, const ConvPrimitive& conv, float* weights) {
+    memory user_weights(conv.user_weights_md, CpuEngine(), weights);
+    if (conv.pd.weights_desc() == conv.user_weights_md) return user_weights;
+
+    std::string weights_key = key + "@" + std::to_string(reinterpret_cast<uintptr_t>(weights));
+    if (cache_weights_) {
+      std::lock_guard<std::mutex> lock(mu_);
+      auto it = weights_.find(weights_key);
+      if (it != weights_.end()) return it->second;
+    }
+    memory reordered(conv.pd.weights_desc(), CpuEngine());
+    mkldnn::reorder(user_weights, reordered).execute(CpuStream(), user_weights, reordered);
+    CpuStream().wait();
+    if (cache_weights_) {
+      std::lock_guard<std::mutex> lock(mu_);
+      weights_.emplace(weights_key, reordered);
+    }
+    return reordered;
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mu_);
+    softmaxes_.clear();
+    convs_.clear();
+    weights_.clear();
+  }
+
+ private:
+  PrimitiveCache() {
+    const char* val = getenv("CINN_MKLDNN_CACHE_WEIGHTS");
+    cache_weights_  = val == nullptr || atoi(val) != 0;
+  }
+
+  template <typename T, typename CreateFn>
+  std::shared_ptr<T> Get(std::unordered_map<std::string, std::shared_ptr<T>>* cache,
+                         const std::string& key,
+                         CreateFn&& create) {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      auto it = cache->find(key);
+      if (it != cache->end()) return it->second;
+    }
+    // create outside the lock, a primitive created twice by racing threads is harmless
+    std::shared_ptr<T> value = create();
+    std::lock_guard<std::mutex> lock(mu_);
+    return cache->emplace(key, std::move(value)).first->second;
+  }
+
+  std::mutex mu_;
+  bool cache_weights_{true};
+  std::unordered_map<std::string, std::shared_ptr<SoftmaxPrimitive>> softmaxes_;
+  std::unordered_map<std::string, std::shared_ptr<ConvPrimitive>> convs_;
+  std::unordered_map<std::string, memory> weights_;
+};
+
+std::shared_ptr<ConvPrimitive> CreateConv(const std::vector<int>& shape_attrs, int post_ops) {
+  int batch_size = shape_attrs[0], c_in = shape_attrs[1], input_h = shape_attrs[2], input_w = shape_attrs[3];
+  int c_out = shape_attrs[4], group = shape_attrs[5], filter_h = shape_attrs[6], filter_w = shape_attrs[7];
+  int pad_h = shape_attrs[8], pad_w = shape_attrs[9], stride_h = shape_attrs[10], stride_w = shape_attrs[11];
+  int dilation_h = shape_attrs[12], dilation_w = shape_attrs[13];
 
   memory::dims conv_src_tz     = {batch_size, c_in, input_h, input_w};
   memory::dims conv_weights_tz = {c_out, c_in, filter_h, filter_w};
@@ -92,57 +165,222 @@ void cinn_cpu_mkldnn_conv2d_nchw_fp32(int batch_size,
   memory::dims conv_paddings  = {pad_h, pad_w};
   memory::dims conv_dilations = {dilation_h - 1, dilation_w - 1};
 
-  auto conv_user_src_memory =
-      memory({{conv_src_tz}, dt::f32, tag::nchw}, cpu_engine, reinterpret_cast<float*>(inputs->memory));
-  auto conv_user_weights_memory = memory({{conv_weights_tz}, dt::f32, group > 1 ? tag::goihw : tag::oihw},
-                                         cpu_engine,
-                                         reinterpret_cast<float*>(weights->memory));
-  auto conv_user_dst_memory =
-      memory({{conv_dst_tz}, dt::f32, tag::nchw}, cpu_engine, reinterpret_cast<float*>(out->memory));
-
+  // let oneDNN pick the blocked formats of the source and the weights, the destination stays NCHW, so that it can
+  // be accumulated to by the sum post-op and read by the following kernels.
   auto conv_src_md     = memory::desc({conv_src_tz}, dt::f32, tag::any);
   auto conv_weights_md = memory::desc({conv_weights_tz}, dt::f32, tag::any);
+  auto conv_bias_md    = memory::desc({c_out}, dt::f32, tag::x);
   auto conv_dst_md     = memory::desc({conv_dst_tz}, dt::f32, tag::nchw);
 
-  auto conv_desc = mkldnn::convolution_forward::desc(mkldnn::prop_kind::forward_inference,
-                                                     mkldnn::algorithm::convolution_direct,
-                                                     conv_src_md,
-                                                     conv_weights_md,
-                                                     conv_dst_md,
-                                                     conv_strides,
-                                                     conv_dilations,
-                                                     conv_paddings,
-                                                     conv_paddings);
-
-  auto conv_prim_desc = mkldnn::convolution_forward::primitive_desc(conv_desc, cpu_engine);
-
-  auto conv_src_memory     = conv_user_src_memory;
-  auto conv_weights_memory = conv_user_weights_memory;
-  auto conv_dst_memory     = conv_user_dst_memory;
-  if (conv_prim_desc.dst_desc() != conv_user_dst_memory.get_desc()) {
-    conv_dst_memory = memory(conv_prim_desc.dst_desc(), cpu_engine);
+  auto conv_desc =
+      (post_ops & kMkldnnPostOpBias)
+          ? mkldnn::convolution_forward::desc(mkldnn::prop_kind::forward_inference,
+                                              algorithm::convolution_direct,
+                                              conv_src_md,
+                                              conv_weights_md,
+                                              conv_bias_md,
+                                              conv_dst_md,
+                                              conv_strides,
+                                              conv_dilations,
+                                              conv_paddings,
+                                              conv_paddings)
+          : mkldnn::convolution_forward::desc(mkldnn::prop_kind::forward_inference,
+                                              algorithm::convolution_direct,
+                                              conv_src_md,
+                                              conv_weights_md,
+                                              conv_dst_md,
+                                              conv_strides,
+                                              conv_dilations,
+                                              conv_paddings,
+                                              conv_paddings);
+
+  mkldnn::post_ops ops;
+  if (post_ops & kMkldnnPostOpSum) ops.append_sum(1.f);
+  if (post_ops & kMkldnnPostOpRelu) ops.append_eltwise(1.f, algorithm::eltwise_relu, 0.f, 0.f);
+  mkldnn::primitive_attr conv_attr;
+  conv_attr.set_post_ops(ops);
+
+  auto conv_prim_desc = mkldnn::convolution_forward::primitive_desc(conv_desc, conv_attr, CpuEngine());
+
+  auto user_src_md     = memory::desc({conv_src_tz}, dt::f32, tag::nchw);
+  auto user_weights_md = memory::desc({conv_weights_tz}, dt::f32, group > 1 ? tag::goihw : tag::oihw);
+  std::unique_ptr<mkldnn::reorder> src_reorder;
+  if (conv_prim_desc.src_desc() != user_src_md) {
+    src_reorder.reset(new mkldnn::reorder(
+        mkldnn::reorder::primitive_desc(CpuEngine(), user_src_md, CpuEngine(), conv_prim_desc.src_desc())));
+  }
+  return std::shared_ptr<ConvPrimitive>(new ConvPrimitive{user_src_md,
+                                                          user_weights_md,
+                                                          conv_prim_desc,
+                                                          mkldnn::convolution_forward(conv_prim_desc),
+                                                          std::move(src_reorder)});
+}
+
+void Conv2dNCHW(const std::vector<int>& shape_attrs,
+                int post_ops,
+                cinn_buffer_t* inputs,
+                cinn_buffer_t* weights,
+                cinn_buffer_t* bias,
+                cinn_buffer_t* residual,
+                cinn_buffer_t* out) {
+  CHECK_EQ(shape_attrs.size(), 14UL);
+  CHECK_EQ(post_ops & ~(kMkldnnPostOpBias | kMkldnnPostOpSum | kMkldnnPostOpRelu), 0) << "wrong post-ops " << post_ops;
+  std::string key = MakeKey("conv2d_nchw", shape_attrs) + "," + std::to_string(post_ops);
+
+  auto conv = PrimitiveCache::Global().GetConv(key, [&] { return CreateConv(shape_attrs, post_ops); });
+
+  auto& cpu_stream         = CpuStream();
+  auto conv_src_memory     = memory(conv->user_src_md, CpuEngine(), reinterpret_cast<float*>(inputs->memory));
+  auto conv_weights_memory = PrimitiveCache::Global().GetWeights(key, *conv, reinterpret_cast<float*>(weights->memory));
+  auto conv_dst_memory     = memory(conv->pd.dst_desc(), CpuEngine(), reinterpret_cast<float*>(out->memory));
+  if (conv->src_reorder) {
+    auto user_src_memory = conv_src_memory;
+    conv_src_memory      = memory(conv->pd.src_desc(), CpuEngine());
+    conv->src_reorder->execute(cpu_stream, user_src_memory, conv_src_memory);
   }
-  auto conv = mkldnn::convolution_forward(conv_prim_desc);
-  conv.execute(cpu_stream,
-               {{MKLDNN_ARG_SRC, conv_src_memory},
-                {MKLDNN_ARG_WEIGHTS, conv_weights_memory},
-                {MKLDNN_ARG_DST, conv_dst_memory}});
-  if (conv_prim_desc.dst_desc() != conv_user_dst_memory.get_desc()) {
-    mkldnn::reorder(conv_dst_memory, conv_user_dst_memory).execute(cpu_stream, conv_dst_memory, conv_user_dst_memory);
-  } else {
-    conv_user_dst_memory = conv_dst_memory;
+  if ((post_ops & kMkldnnPostOpSum) && residual->memory != out->memory) {
+    memcpy(out->memory, residual->memory, conv->pd.dst_desc().get_size());
   }
 
+  std::unordered_map<int, memory> args = {{MKLDNN_ARG_SRC, conv_src_memory},
+                                          {MKLDNN_ARG_WEIGHTS, conv_weights_memory},
+                                          {MKLDNN_ARG_DST, conv_dst_memory}};
+  if (post_ops & kMkldnnPostOpBias) {
+    args.emplace(MKLDNN_ARG_BIAS, memory(conv->pd.bias_desc(), CpuEngine(), reinterpret_cast<float*>(bias->memory)));
+  }
+  conv->prim.execute(cpu_stream, args);
   cpu_stream.wait();
 }
 
+}  // namespace
+
+void cinn_cpu_mkldnn_softmax_fp32(
+    int batch, int channel, int h, int w, int axis, cinn_buffer_t* inputs, cinn_buffer_t* out) {
+  auto softmax = PrimitiveCache::Global().GetSoftmax(MakeKey("softmax", {batch, channel, h, w, axis}), [&] {
+    memory::dims src_dims = {batch, channel};
+    if (h != 1) src_dims.push_back(h);
+    if (w != 1) src_dims.push_back(w);
+    int size        = src_dims.size();
+    auto format_tag = tag::nc;
+    switch (size) {
+      case 2:
+        format_tag = tag::ab;
+        break;
+      case 3:
+        format_tag = tag::abc;
+        break;
+      case 4:
+        format_tag = tag::abcd;
+        break;
+      default:
+        LOG(FATAL) << "wrong dim: " << size;
+        break;
+    }
+
+    auto src_md     = memory::desc(src_dims, dt::f32, format_tag);
+    auto softmax_d  = mkldnn::softmax_forward::desc(mkldnn::prop_kind::forward_inference, src_md, axis);
+    auto softmax_pd = mkldnn::softmax_forward::primitive_desc(softmax_d, CpuEngine());
+    return std::shared_ptr<SoftmaxPrimitive>(new SoftmaxPrimitive{src_md, mkldnn::softmax_forward(softmax_pd)});
+  });
+
+  auto& engine_stream = CpuStream();
+  auto src_mem        = memory(softmax->md, CpuEngine(), reinterpret_cast<float*>(inputs->memory));
+  auto dst_mem        = memory(softmax->md, CpuEngine(), reinterpret_cast<float*>(out->memory));
+  softmax->prim.execute(engine_stream, {{DNNL_ARG_SRC, src_mem}, {DNNL_ARG_DST, dst_mem}});
+  engine_stream.wait();
+}
+
+void cinn_cpu_mkldnn_conv2d_nchw_fp32(int batch_size,
+                                      int c_in,
+                                      int input_h,
+                                      int input_w,
+                                      int c_out,
+                                      int group,
+                                      int filter_h,
+                                      int filter_w,
+                                      int pad_h,
+                                      int pad_w,
+                                      int stride_h,
+                                      int stride_w,
+                                      int dilation_h,
+                                      int dilation_w,
+                                      cinn_buffer_t* inputs,
+                                      cinn_buffer_t* weights,
+                                      cinn_buffer_t* out) {
+  Conv2dNCHW({batch_size,
+              c_in,
+              input_h,
+              input_w,
+              c_out,
+              group,
+              filter_h,
+              filter_w,
+              pad_h,
+              pad_w,
+              stride_h,
+              stride_w,
+              dilation_h,
+              dilation_w},
+             0,
+             inputs,
+             weights,
+             nullptr,
+             nullptr,
+             out);
+}
+
+void cinn_cpu_mkldnn_conv2d_nchw_post_ops_fp32(int batch_size,
+                                               int c_in,
+                                               int input_h,
+                                               int input_w,
+                                               int c_out,
+                                               int group,
+                                               int filter_h,
+                                               int filter_w,
+                                               int pad_h,
+                                               int pad_w,
+                                               int stride_h,
+                                               int stride_w,
+                                               int dilation_h,
+                                               int dilation_w,
+                                               int post_ops,
+                                               cinn_buffer_t* inputs,
+                                               cinn_buffer_t* weights,
+                                               cinn_buffer_t* bias,
+                                               cinn_buffer_t* residual,
+                                               cinn_buffer_t* out) {
+  Conv2dNCHW({batch_size,
+              c_in,
+              input_h,
+              input_w,
+              c_out,
+              group,
+              filter_h,
+              filter_w,
+              pad_h,
+              pad_w,
+              stride_h,
+              stride_w,
+              dilation_h,
+              dilation_w},
+             post_ops,
+             inputs,
+             weights,
+             bias,
+             residual,
+             out);
+}
+
+void cinn_cpu_mkldnn_clear_cache() { PrimitiveCache::Global().Clear(); }
+
 CINN_REGISTER_HELPER(cinn_cpu_mkldnn) {
   using namespace cinn;  // NOLINT
   using backends::FunctionProto;
   auto host_target = common::DefaultHostTarget();
 
   FunctionProto::shape_inference_t inference_shape_conv2d_nchw = [](const std::vector<Expr>& args, int offset) {
-    CHECK_EQ(args.size(), 16UL) << "Wrong number of arguments passed in";
+    // the post-ops version takes the post-ops and the bias and residual buffers besides
+    CHECK(args.size() == 16UL || args.size() == 19UL) << "Wrong number of arguments passed in";
     auto N         = common::AutoSimplify(args[0]);
     int input_h    = common::AutoSimplify(args[2]).as_int32();
     int input_w    = common::AutoSimplify(args[3]).as_int32();
@@ -188,6 +426,31 @@ CINN_REGISTER_HELPER(cinn_cpu_mkldnn) {
       .SetShapeInference(inference_shape_conv2d_nchw)
       .End();
 
+  REGISTER_EXTERN_FUNC_HELPER(cinn_cpu_mkldnn_conv2d_nchw_post_ops_fp32, host_target)
+      .SetRetType<void>()
+      .AddInputType<int>()              // batch_size
+      .AddInputType<int>()              // c_in
+      .AddInputType<int>()              // input_h
+      .AddInputType<int>()              // input_w
+      .AddInputType<int>()              // c_out
+      .AddInputType<int>()              // group
+      .AddInputType<int>()              // filter_h
+      .AddInputType<int>()              // filter_w
+      .AddInputType<int>()              // pad_h
+      .AddInputType<int>()              // pad_w
+      .AddInputType<int>()              // stride_h
+      .AddInputType<int>()              // stride_w
+      .AddInputType<int>()              // dilation_h
+      .AddInputType<int>()              // dilation_w
+      .AddInputType<int>()              // post_ops
+      .AddInputType<cinn_buffer_t*>()   // inputs
+      .AddInputType<cinn_buffer_t*>()   // weights
+      .AddInputType<cinn_buffer_t*>()   // bias
+      .AddInputType<cinn_buffer_t*>()   // residual
+      .AddOutputType<cinn_buffer_t*>()  // out
+      .SetShapeInference(inference_shape_conv2d_nchw)
+      .End();
+
   REGISTER_EXTERN_FUNC_HELPER(cinn_cpu_mkldnn_softmax_fp32, host_target)
       .SetRetType<void>()
       .AddInputType<int>()              // batch_size
@@ -19,6 +19,13 @@
 #include "mkldnn.hpp"
 #endif
 
+//! The post-ops fused into cinn_cpu_mkldnn_conv2d_nchw_post_ops_fp32, applied in the order of bias, sum and relu.
+enum MkldnnPostOps {
+  kMkldnnPostOpBias = 1,
+  kMkldnnPostOpSum  = 2,
+  kMkldnnPostOpRelu = 4,
+};
+
 // define some C APIs
 extern "C" {
 void cinn_cpu_mkldnn_softmax_fp32(
@@ -42,4 +49,37 @@ void cinn_cpu_mkldnn_conv2d_nchw_fp32(int batch_size,
                                       cinn_buffer_t* weights,
                                       cinn_buffer_t* out);
 
+/**
+ * The convolution \p out = relu(conv(\p inputs, \p weights) + \p bias + \p residual), where the bias, the residual
+ * and the relu are each applied only when their bit is set in \p post_ops, the buffers not used may be any buffer.
+ * The residual is accumulated in place when it is \p out itself.
+ */
+void cinn_cpu_mkldnn_conv2d_nchw_post_ops_fp32(int batch_size,
+                                               int c_in,
+                                               int input_h,
+                                               int input_w,
+                                               int c_out,
+                                               int group,
+                                               int filter_h,
+                                               int filter_w,
+                                               int pad_h,
+                                               int pad_w,
+                                               int stride_h,
+                                               int stride_w,
+                                               int dilation_h,
+                                               int dilation_w,
+                                               int post_ops,
+                                               cinn_buffer_t* inputs,
+                                               cinn_buffer_t* weights,
+                                               cinn_buffer_t* bias,
+                                               cinn_buffer_t* residual,
+                                               cinn_buffer_t* out);
+
+/**
+ * Drop the cached primitives and the reordered weights. The primitives are created once for each shape and attributes,
+ * and the weights are reordered once for each weights buffer, so this should be called once the weights buffers are
+ * freed or updated.
+ */
+void cinn_cpu_mkldnn_clear_cache();
+
 }  // extern "C"
@@ -14,6 +14,8 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 #include "cinn/backends/compiler.h"
 #include "cinn/backends/extern_func_jit_register.h"
 #include "cinn/backends/llvm/execution_engine.h"
@@ -23,6 +25,7 @@
 #include "cinn/common/target.h"
 #include "cinn/common/test_helper.h"
 #include "cinn/runtime/cpu/host_intrinsics.h"
+#include "cinn/runtime/cpu/mkldnn_math.h"
 #include "cinn/runtime/cpu/use_extern_funcs.h"
 
 namespace cinn {
@@ -118,6 +121,59 @@ TEST(cinn_cpu_mkldnn_conv2d_nchw_fp32, test) {
   cinn_buffer_free(nullptr, C_buf);
 }
 
+TEST(cinn_cpu_mkldnn_conv2d_nchw_post_ops_fp32, test) {
+  int n(2), c_in(16), i_h(14), i_w(14), c_out(32), k_h(3), k_w(3);
+  int o_h = i_h, o_w = i_w;
+
+  auto *input    = CreateBuffer({n, c_in, i_h, i_w});
+  auto *weights  = CreateBuffer({c_out, c_in, k_h, k_w});
+  auto *bias     = CreateBuffer({c_out});
+  auto *residual = CreateBuffer({n, c_out, o_h, o_w});
+  auto *expect   = CreateBuffer({n, c_out, o_h, o_w}, false);
+  auto *out      = CreateBuffer({n, c_out, o_h, o_w}, false);
+
+  cinn_cpu_mkldnn_conv2d_nchw_fp32(n, c_in, i_h, i_w, c_out, 1, k_h, k_w, 1, 1, 1, 1, 1, 1, input, weights, expect);
+  auto *expect_data         = reinterpret_cast<float *>(expect->memory);
+  const auto *bias_data     = reinterpret_cast<float *>(bias->memory);
+  const auto *residual_data = reinterpret_cast<float *>(residual->memory);
+  for (int i = 0; i < n * c_out * o_h * o_w; i++) {
+    expect_data[i] = std::max(expect_data[i] + bias_data[i / (o_h * o_w) % c_out] + residual_data[i], 0.f);
+  }
+
+  // the second call runs the cached primitive on the weights reordered by the first one
+  for (int repeat = 0; repeat < 2; repeat++) {
+    cinn_cpu_mkldnn_conv2d_nchw_post_ops_fp32(n,
+                                              c_in,
+                                              i_h,
+                                              i_w,
+                                              c_out,
+                                              1,
+                                              k_h,
+                                              k_w,
+                                              1,
+                                              1,
+                                              1,
+                                              1,
+                                              1,
+                                              1,
+                                              kMkldnnPostOpBias | kMkldnnPostOpSum | kMkldnnPostOpRelu,
+                                              input,
+                                              weights,
+                                              bias,
+                                              residual,
+                                              out);
+    const auto *out_data = reinterpret_cast<float *>(out->memory);
+    for (int i = 0; i < n * c_out * o_h * o_w; i++) {
+      ASSERT_NEAR(out_data[i], expect_data[i], 1e-3) << "at " << i;
+    }
+  }
+  cinn_cpu_mkldnn_clear_cache();
+
+  for (auto *buffer : {input, weights, bias, residual, expect, out}) {
+    cinn_buffer_free(nullptr, buffer);
+  }
+}
+
 }  // namespace cpu
 }  // namespace runtime
 }  // namespace cinn
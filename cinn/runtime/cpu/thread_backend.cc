@@ -14,43 +14,465 @@
 
 #include "cinn/runtime/cpu/thread_backend.h"
 
+#include <glog/logging.h>
+
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
 #include <vector>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include "cinn/backends/extern_func_jit_register.h"
 #include "cinn/backends/llvm/runtime_symbol_registry.h"
 #include "cinn/common/cas.h"
 #include "cinn/runtime/intrinsic.h"
 
-int max_concurrency() {
-  int max_concurrency = 1;
-  const char* val     = getenv("CINN_NUM_THREADS");
-  if (val == nullptr) {
-    val = getenv("OMP_NUM_THREADS");
-  }
-  if (val != nullptr) {
-    max_concurrency = atoi(val);
-  } else {
-    max_concurrency = std::thread::hardware_concurrency();
+struct cinn_thread_budget_t {
+  int max_threads{0};
+  int priority{0};
+  // The threads running the jobs of the budget, the launching threads and the workers joining them.
+  std::atomic<int> busy_threads{0};
+  std::atomic<int64_t> num_launches{0};
+  std::atomic<int64_t> num_tasks{0};
+};
+
+namespace {
+std::atomic<int> g_max_concurrency{0};
+
+// The cap of the number of threads of the jobs launched by the thread, 0 if not set.
+thread_local int t_max_concurrency = 0;
+// The budget of the jobs launched by the thread, null if not set.
+thread_local cinn_thread_budget_t* t_budget = nullptr;
+// The priority of the jobs launched by the thread besides the one of its budget.
+thread_local int t_launch_priority = 0;
+
+// The number of threads by the environment variables or the hardware, it is read once.
+int DefaultConcurrency() {
+  static const int default_concurrency = [] {
+    int num_threads = 1;
+    const char* val = getenv("CINN_NUM_THREADS");
+    if (val == nullptr) {
+      val = getenv("OMP_NUM_THREADS");
+    }
+    if (val != nullptr) {
+      num_threads = atoi(val);
+    } else {
+      num_threads = std::thread::hardware_concurrency();
+#if defined(_M_X64) || defined(__x86_64__)
+      num_threads /= 2;  // ignore hyper-threading
+#endif
+    }
+    return std::max(num_threads, 1);
+  }();
+  return default_concurrency;
+}
+
+inline void CpuRelax() {
 #if defined(_M_X64) || defined(__x86_64__)
-    max_concurrency /= 2;  // ignore hyper-threading
+  __builtin_ia32_pause();
+#else
+  std::this_thread::yield();
+#endif
+}
+
+// Parse the CPU list like "0-3,8,10-11" of sysfs.
+std::vector<int> ParseCpuList(const std::string& list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty()) continue;
+    auto dash = range.find('-');
+    int first = std::atoi(range.substr(0, dash).c_str());
+    int last  = dash == std::string::npos ? first : std::atoi(range.substr(dash + 1).c_str());
+    for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+/**
+ * The physical cores of each NUMA node, each core is represented by its first hyper-thread, and only the CPUs the
+ * process is allowed to run on are kept. It is empty if the topology is unknown, e.g. not on Linux.
+ */
+struct CpuTopology {
+  std::vector<std::vector<int>> node_cores;
+  std::vector<int> allowed_cpus;
+
+  static const CpuTopology& Global() {
+    static const CpuTopology topology;
+    return topology;
+  }
+
+ private:
+  CpuTopology() {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &allowed)) allowed_cpus.push_back(cpu);
+    }
+    for (int node = 0; node < kMaxNumaNodes; node++) {
+      std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+      if (!cpulist) continue;
+      std::string list;
+      std::getline(cpulist, list);
+      std::vector<int> cores;
+      for (int cpu : ParseCpuList(list)) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        std::ifstream siblings("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+        std::string sibling_list;
+        // Only one hyper-thread of each core runs the workers.
+        if (siblings && std::getline(siblings, sibling_list) && ParseCpuList(sibling_list).front() != cpu) continue;
+        cores.push_back(cpu);
+      }
+      node_cores.resize(node + 1);
+      node_cores[node] = std::move(cores);
+    }
+#endif
+  }
+
+  static constexpr int kMaxNumaNodes = 64;
+};
+
+// Pin \p thread to \p cpus, it does nothing and returns false if the affinity is not supported.
+bool PinThread(std::thread::native_handle_type thread, const std::vector<int>& cpus) {
+#ifdef __linux__
+  if (cpus.empty()) return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+std::thread::native_handle_type CurrentThread() {
+#ifdef __linux__
+  return pthread_self();
+#else
+  return std::thread::native_handle_type();
 #endif
+}
+
+// The physical cores of the NUMA nodes listed like "0,1", false if any node is unknown.
+bool GetNumaCores(const std::string& numa_nodes, std::vector<int>* cores) {
+  auto& topology = CpuTopology::Global();
+  for (int node : ParseCpuList(numa_nodes)) {
+    if (node < 0 || node >= cinn_num_numa_nodes() || topology.node_cores[node].empty()) return false;
+    cores->insert(cores->end(), topology.node_cores[node].begin(), topology.node_cores[node].end());
+  }
+  return true;
+}
+
+// A launch of a parallel lambda, whose tasks are claimed one by one by the launching thread and the workers joining it.
+struct ParallelJob {
+  FCINNParallelLambda flambda;
+  void* datas;
+  int num_task;
+  // The max number of the workers joining the launching thread.
+  int max_helpers;
+  cinn_thread_budget_t* budget{nullptr};
+  int priority{0};
+  std::atomic<int> next_task{0};
+  std::atomic<int> num_finished{0};
+  std::atomic<int> num_helpers{0};
+
+  void RunTasks() {
+    for (int task = next_task++; task < num_task; task = next_task++) {
+      (*flambda)(task, num_task, datas);
+      num_finished.fetch_add(1, std::memory_order_release);
+    }
+  }
+};
+
+/**
+ * The persistent workers running the parallel lambdas. The threads launching concurrently, e.g. the instructions run
+ * by ParallelExecutor, share the workers, so the number of the busy threads stays around the number of the cores
+ * however many instructions run at once. The idle workers spin for a while before parking, as the kernels are
+ * usually launched back to back.
+ */
+class ParallelLaunchPool {
+ public:
+  /**
+   * The pool of the threads not bound to a NUMA node, its workers are pinned to the cores of the nodes set by the
+   * environment variable CINN_NUMA_NODES or cinn_set_numa_nodes, or not pinned by default.
+   */
+  static ParallelLaunchPool& Global() {
+    // The workers are never joined, so that the kernels may still be launched when the process exits.
+    static auto* pool = [] {
+      std::vector<int> cores;
+      const char* numa_nodes = getenv("CINN_NUMA_NODES");
+      if (numa_nodes && !GetNumaCores(numa_nodes, &cores)) {
+        LOG(WARNING) << "Ignore the unknown NUMA nodes " << numa_nodes << " in CINN_NUMA_NODES";
+        cores.clear();
+      }
+      return new ParallelLaunchPool(cores);
+    }();
+    return *pool;
+  }
+
+  //! The pool of the threads bound to \p numa_node, its workers are pinned to the cores of the node.
+  static ParallelLaunchPool& OfNumaNode(int numa_node) {
+    static std::mutex mu;
+    static auto* pools = new std::map<int, ParallelLaunchPool*>;
+    std::lock_guard<std::mutex> lock(mu);
+    auto& pool = (*pools)[numa_node];
+    if (!pool) pool = new ParallelLaunchPool(CpuTopology::Global().node_cores.at(numa_node));
+    return *pool;
+  }
+
+  //! The number of the threads a job runs on by default, that is the cores of the pool if it is pinned.
+  int concurrency() const {
+    int num_cores = num_cores_.load(std::memory_order_relaxed);
+    return num_cores > 0 ? num_cores : DefaultConcurrency();
+  }
+
+  //! Pin the workers to \p cores, one core each, or unpin them if it is empty.
+  void SetCores(const std::vector<int>& cores) {
+    std::lock_guard<std::mutex> lock(mu_);
+    cores_     = cores;
+    num_cores_ = cores.size();
+    for (int i = 0; i < workers_.size(); i++) PinWorker(i);
+  }
+
+  void Launch(FCINNParallelLambda flambda,
+              void* datas,
+              int num_task,
+              int num_workers,
+              cinn_thread_budget_t* budget,
+              int priority) {
+    ParallelJob job;
+    job.flambda     = flambda;
+    job.datas       = datas;
+    job.num_task    = num_task;
+    job.max_helpers = std::min(num_workers, num_task) - 1;
+    job.budget      = in_worker_ ? nullptr : budget;
+    job.priority    = priority + (job.budget ? job.budget->priority : 0);
+    if (job.budget) {
+      job.budget->num_launches.fetch_add(1, std::memory_order_relaxed);
+      job.budget->num_tasks.fetch_add(num_task, std::memory_order_relaxed);
+      job.budget->busy_threads.fetch_add(1, std::memory_order_relaxed);
+    }
+    // The lambdas launched by the tasks run on the calling worker.
+    if (job.max_helpers <= 0 || in_worker_) {
+      job.RunTasks();
+      if (job.budget) job.budget->busy_threads.fetch_sub(1, std::memory_order_relaxed);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      while (static_cast<int>(workers_.size()) < job.max_helpers) AddWorker();
+      jobs_.push_back(&job);
+      num_jobs_++;
+    }
+    for (int i = 0; i < job.max_helpers; i++) cond_.notify_one();
+    job.RunTasks();
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      jobs_.erase(std::find(jobs_.begin(), jobs_.end(), &job));
+      num_jobs_--;
+    }
+    // Wait for the tasks still running on the workers, no more workers join the job after it is removed.
+    for (int i = 0; job.num_finished.load(std::memory_order_acquire) < num_task ||
+                    job.num_helpers.load(std::memory_order_acquire) > 0;
+         i++) {
+      if (i < kSpinCount) {
+        CpuRelax();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    if (job.budget) job.budget->busy_threads.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+ private:
+  explicit ParallelLaunchPool(const std::vector<int>& cores) : cores_(cores), num_cores_(cores.size()) {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (int i = 0; i < concurrency() - 1; i++) AddWorker();
   }
-  return std::max(max_concurrency, 1);
+
+  // Should be called under mu_.
+  void AddWorker() {
+    workers_.emplace_back([this] { WorkerLoop(); });
+    PinWorker(workers_.size() - 1);
+  }
+
+  // The first core is left to the launching thread. Should be called under mu_.
+  void PinWorker(int i) {
+    if (cores_.empty()) {
+      PinThread(workers_[i].native_handle(), CpuTopology::Global().allowed_cpus);
+    } else {
+      PinThread(workers_[i].native_handle(), {cores_[(i + 1) % cores_.size()]});
+    }
+  }
+
+  // Find a job with the tasks unclaimed and room for one more worker within its budget, of the highest priority and
+  // then the fewest workers, should be called under mu_.
+  ParallelJob* FindJob() {
+    ParallelJob* found = nullptr;
+    for (auto* job : jobs_) {
+      if (job->next_task.load(std::memory_order_relaxed) >= job->num_task || job->num_helpers >= job->max_helpers) {
+        continue;
+      }
+      auto* budget = job->budget;
+      if (budget && budget->max_threads > 0 &&
+          budget->busy_threads.load(std::memory_order_relaxed) >= budget->max_threads) {
+        continue;
+      }
+      if (!found || job->priority > found->priority ||
+          (job->priority == found->priority && job->num_helpers < found->num_helpers)) {
+        found = job;
+      }
+    }
+    return found;
+  }
+
+  void WorkerLoop() {
+    in_worker_ = true;
+    while (true) {
+      for (int i = 0; i < kSpinCount && num_jobs_.load(std::memory_order_relaxed) == 0; i++) CpuRelax();
+      ParallelJob* job = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(mu_);
+        cond_.wait(lock, [&] { return (job = FindJob()) != nullptr; });
+        job->num_helpers++;
+        if (job->budget) job->budget->busy_threads.fetch_add(1, std::memory_order_relaxed);
+      }
+      job->RunTasks();
+      if (job->budget) job->budget->busy_threads.fetch_sub(1, std::memory_order_relaxed);
+      // The job may be gone right after it.
+      job->num_helpers.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  static constexpr int kSpinCount = 1 << 14;
+  static thread_local bool in_worker_;
+
+  std::vector<int> cores_;
+  std::atomic<int> num_cores_{0};
+  std::vector<std::thread> workers_;
+  std::vector<ParallelJob*> jobs_;
+  std::atomic<int> num_jobs_{0};
+  std::mutex mu_;
+  std::condition_variable cond_;
+};
+
+thread_local bool ParallelLaunchPool::in_worker_ = false;
+
+// The pool of the NUMA node the thread is bound to, null if not bound.
+thread_local ParallelLaunchPool* t_numa_pool = nullptr;
+
+ParallelLaunchPool& CurrentPool() { return t_numa_pool ? *t_numa_pool : ParallelLaunchPool::Global(); }
+
+int TouchPages(int task_id, int num_task, void* datas) {
+  constexpr size_t kPageSize = 4096;
+  auto* range                = static_cast<std::pair<char*, size_t>*>(datas);
+  size_t num_pages           = (range->second + kPageSize - 1) / kPageSize;
+  size_t step                = (num_pages + num_task - 1) / num_task;
+  for (size_t page = task_id * step; page < std::min((task_id + 1) * step, num_pages); page++) {
+    range->first[page * kPageSize] = 0;
+  }
+  return 0;
+}
+
+// A lambda launched with all the threads is split to more tasks than the threads, so that the threads finishing early
+// take over the rest, e.g. when some cores are busy with the other instructions.
+constexpr int kTasksPerThread = 4;
+}  // namespace
+
+void cinn_set_max_concurrency(int num_threads) { g_max_concurrency = std::max(num_threads, 0); }
+
+void cinn_set_thread_max_concurrency(int num_threads) { t_max_concurrency = std::max(num_threads, 0); }
+
+int max_concurrency() {
+  int num_threads = g_max_concurrency.load(std::memory_order_relaxed);
+  if (num_threads <= 0) num_threads = CurrentPool().concurrency();
+  if (t_max_concurrency > 0) num_threads = std::min(num_threads, t_max_concurrency);
+  if (t_budget && t_budget->max_threads > 0) num_threads = std::min(num_threads, t_budget->max_threads);
+  return num_threads;
+}
+
+cinn_thread_budget_t* cinn_thread_budget_create(int max_threads, int priority) {
+  auto* budget        = new cinn_thread_budget_t;
+  budget->max_threads = std::max(max_threads, 0);
+  budget->priority    = priority;
+  return budget;
+}
+
+void cinn_thread_budget_destroy(cinn_thread_budget_t* budget) { delete budget; }
+
+int cinn_set_thread_launch_priority(int priority) {
+  int prev          = t_launch_priority;
+  t_launch_priority = priority;
+  return prev;
+}
+
+cinn_thread_budget_t* cinn_set_thread_budget(cinn_thread_budget_t* budget) {
+  auto* prev = t_budget;
+  t_budget   = budget;
+  return prev;
+}
+
+int cinn_thread_budget_busy_threads(const cinn_thread_budget_t* budget) {
+  return budget->busy_threads.load(std::memory_order_relaxed);
+}
+
+int64_t cinn_thread_budget_num_launches(const cinn_thread_budget_t* budget) {
+  return budget->num_launches.load(std::memory_order_relaxed);
+}
+
+int64_t cinn_thread_budget_num_tasks(const cinn_thread_budget_t* budget) {
+  return budget->num_tasks.load(std::memory_order_relaxed);
+}
+
+int cinn_num_numa_nodes() { return CpuTopology::Global().node_cores.size(); }
+
+int cinn_set_numa_nodes(const char* numa_nodes) {
+  std::vector<int> cores;
+  if (!GetNumaCores(numa_nodes ? numa_nodes : "", &cores)) return -1;
+  ParallelLaunchPool::Global().SetCores(cores);
+  return 0;
+}
+
+int cinn_bind_thread_to_numa_node(int numa_node) {
+  auto& topology = CpuTopology::Global();
+  if (numa_node < 0) {
+    t_numa_pool = nullptr;
+    PinThread(CurrentThread(), topology.allowed_cpus);
+    return 0;
+  }
+  if (numa_node >= cinn_num_numa_nodes() || topology.node_cores[numa_node].empty()) return -1;
+  if (!PinThread(CurrentThread(), topology.node_cores[numa_node])) return -1;
+  t_numa_pool = &ParallelLaunchPool::OfNumaNode(numa_node);
+  return 0;
 }
 
 int cinn_backend_parallel_launch(FCINNParallelLambda flambda, void* datas, int num_task) {
   int num_workers = max_concurrency();
-  if (num_task == 0) num_task = num_workers;
-  omp_set_num_threads(num_task);
-#pragma omp parallel num_threads(num_task)
-  {
-    int thread_num = omp_get_thread_num();
-    (*flambda)(thread_num, num_task, datas);
-  }
+  if (num_task == 0) num_task = num_workers > 1 ? num_workers * kTasksPerThread : 1;
+  CurrentPool().Launch(flambda, datas, num_task, num_workers, t_budget, t_launch_priority);
   return 0;
 }
 
+void cinn_backend_first_touch(void* data, size_t nbytes) {
+  std::pair<char*, size_t> range(static_cast<char*>(data), nbytes);
+  cinn_backend_parallel_launch(&TouchPages, &range, 0);
+}
+
 CINN_REGISTER_HELPER(cinn_backend_parallel) {
   using namespace cinn;  // NOLINT
   using backends::FunctionProto;
@@ -21,8 +21,81 @@
 
 extern "C" {
 
+//! The number of threads a parallel job runs on, set by cinn_set_max_concurrency or the environment variables, and
+//! capped by cinn_set_thread_max_concurrency and the budget of the calling thread.
 int max_concurrency();
 
+/**
+ * @brief Set the number of threads a parallel job runs on, e.g. to split the cores between the instructions running
+ *        concurrently. If 0, it is decided by the environment variables CINN_NUM_THREADS or OMP_NUM_THREADS.
+ */
+void cinn_set_max_concurrency(int num_threads);
+
+/**
+ * @brief Cap the number of threads the parallel jobs launched by the calling thread run on, e.g. for the workers of
+ *        an inter-op executor, without changing the others. 0 clears the cap.
+ */
+void cinn_set_thread_max_concurrency(int num_threads);
+
+/**
+ * @brief A thread budget shared by the threads running the kernels of a tenant, e.g. the programs of a model among the
+ *        many served by one process. The parallel jobs of the threads with the budget run on at most its max_threads
+ *        threads at once, the launching threads included, and the idle workers of the shared pool serve the jobs of
+ *        the higher priorities first, and the jobs with the fewest workers among those of the same priority.
+ */
+typedef struct cinn_thread_budget_t cinn_thread_budget_t;
+
+//! @brief Create a budget of \p max_threads threads(0 for no limit) with \p priority.
+cinn_thread_budget_t* cinn_thread_budget_create(int max_threads, int priority);
+
+//! @brief Destroy the budget, no thread should be running the jobs with it.
+void cinn_thread_budget_destroy(cinn_thread_budget_t* budget);
+
+/**
+ * @brief Let the parallel jobs launched by the calling thread run within \p budget, null to clear it.
+ * @return The budget of the calling thread before.
+ */
+cinn_thread_budget_t* cinn_set_thread_budget(cinn_thread_budget_t* budget);
+
+/**
+ * @brief Set the priority of the parallel jobs launched by the calling thread, which is added to the priority of its
+ *        budget, e.g. for the latency-critical runs of a program among the bulk ones.
+ * @return The priority of the calling thread before.
+ */
+int cinn_set_thread_launch_priority(int priority);
+
+//! @brief The usage of a budget: the threads running its jobs now, and the jobs and the tasks run by it so far.
+int cinn_thread_budget_busy_threads(const cinn_thread_budget_t* budget);
+int64_t cinn_thread_budget_num_launches(const cinn_thread_budget_t* budget);
+int64_t cinn_thread_budget_num_tasks(const cinn_thread_budget_t* budget);
+
+/**
+ * @brief The number of the NUMA nodes, 0 if the topology is unknown, e.g. not on Linux.
+ */
+int cinn_num_numa_nodes();
+
+/**
+ * @brief Pin the workers of the parallel jobs to the physical cores of the NUMA nodes \p numa_nodes, e.g. "0" or "0-1",
+ *        one core each, and let the jobs run on as many threads as the cores by default. An empty list unpins them.
+ *        It can also be set by the environment variable CINN_NUMA_NODES. It works for the threads not bound by
+ *        cinn_bind_thread_to_numa_node.
+ * @return 0 on success, -1 if any node is unknown.
+ */
+int cinn_set_numa_nodes(const char* numa_nodes);
+
+/**
+ * @brief Bind the calling thread to the physical cores of \p numa_node, and let its parallel jobs run on the workers
+ *        pinned to the cores of the node, e.g. to run one program replica on each socket. -1 unbinds it.
+ * @return 0 on success, -1 if the node is unknown or the affinity is not supported.
+ */
+int cinn_bind_thread_to_numa_node(int numa_node);
+
+/**
+ * @brief Touch the pages of the newly allocated \p data first by the threads running the parallel jobs of the calling
+ *        thread, so that the pages are placed on their NUMA nodes by the first-touch policy of the OS.
+ */
+void cinn_backend_first_touch(void* data, size_t nbytes);
+
 /**
  * @brief The callback function to execute a parallel lambda
  * @param task_id the task id of the function.
@@ -35,10 +108,14 @@ typedef int (*FCINNParallelLambda)(int task_id, int num_task, void* datas);
 /**
  * @brief Backend function for running parallel jobs.
  *
+ * The tasks run on the calling thread and a persistent pool of workers shared by all the calling threads, each task
+ * is claimed by the first thread free, so the threads finishing early take over the rest. At most max_concurrency()
+ * threads run the tasks of one launch.
+ *
  * @param flambda The parallel function to be launched.
  * @param datas The closure datas.
  * @param num_task The Number of tasks to launch. If 0, it means to launch
- *           with all available threads.
+ *           with all available threads, by several tasks each.
  *
  * @return 0 when no error is thrown, -1 when failure happens
  */
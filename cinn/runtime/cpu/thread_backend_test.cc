@@ -0,0 +1,182 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/runtime/cpu/thread_backend.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace cinn {
+namespace runtime {
+namespace cpu {
+
+namespace {
+struct Counters {
+  std::vector<std::atomic<int>> runs;
+  std::atomic<int> num_task{0};
+
+  explicit Counters(int n) : runs(n) {}
+};
+
+int CountTask(int task_id, int num_task, void* datas) {
+  auto* counters = static_cast<Counters*>(datas);
+  if (task_id < counters->runs.size()) counters->runs[task_id]++;
+  counters->num_task = num_task;
+  return 0;
+}
+
+// The tasks running at once, and the most of them.
+struct InFlight {
+  std::atomic<int> running{0};
+  std::atomic<int> max_running{0};
+};
+
+int SleepTask(int task_id, int num_task, void* datas) {
+  auto* in_flight = static_cast<InFlight*>(datas);
+  int running     = ++in_flight->running;
+  int max         = in_flight->max_running;
+  while (running > max && !in_flight->max_running.compare_exchange_weak(max, running)) {
+  }
+  std::this_thread::sleep_for(std::chrono::microseconds(200));
+  in_flight->running--;
+  return 0;
+}
+}  // namespace
+
+TEST(ParallelLaunch, each_task_once) {
+  cinn_set_max_concurrency(4);
+  for (int num_task : {1, 3, 37}) {
+    Counters counters(num_task);
+    ASSERT_EQ(cinn_backend_parallel_launch(&CountTask, &counters, num_task), 0);
+    ASSERT_EQ(counters.num_task, num_task);
+    for (auto& runs : counters.runs) ASSERT_EQ(runs, 1);
+  }
+  // all the threads are launched by several tasks each
+  Counters counters(64);
+  cinn_backend_parallel_launch(&CountTask, &counters, 0);
+  ASSERT_EQ(counters.num_task % max_concurrency(), 0);
+  for (int i = 0; i < counters.num_task; i++) ASSERT_EQ(counters.runs[i], 1);
+  cinn_set_max_concurrency(0);
+}
+
+TEST(ParallelLaunch, concurrent_launches) {
+  cinn_set_max_concurrency(4);
+  // the launching threads share the workers
+  std::vector<std::thread> threads;
+  std::atomic<int> num_failed{0};
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&] {
+      for (int repeat = 0; repeat < 100; repeat++) {
+        Counters counters(16);
+        cinn_backend_parallel_launch(&CountTask, &counters, 16);
+        for (auto& runs : counters.runs) num_failed += runs != 1;
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  ASSERT_EQ(num_failed, 0);
+  cinn_set_max_concurrency(0);
+}
+
+TEST(ParallelLaunch, thread_budget) {
+  cinn_set_max_concurrency(8);
+  auto* budget = cinn_thread_budget_create(2, 1);
+  ASSERT_EQ(cinn_set_thread_budget(budget), nullptr);
+  ASSERT_LE(max_concurrency(), 2);
+  ASSERT_EQ(cinn_set_thread_budget(nullptr), budget);
+  cinn_set_thread_max_concurrency(3);
+  ASSERT_EQ(max_concurrency(), 3);
+  std::thread([] { ASSERT_EQ(max_concurrency(), 8); }).join();
+  cinn_set_thread_max_concurrency(0);
+  ASSERT_EQ(max_concurrency(), 8);
+
+  // the launches of the threads sharing the budget run on at most 2 threads at once
+  InFlight in_flight;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&] {
+      cinn_set_thread_budget(budget);
+      for (int repeat = 0; repeat < 10; repeat++) cinn_backend_parallel_launch(&SleepTask, &in_flight, 16);
+      cinn_set_thread_budget(nullptr);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  // each launching thread runs its own tasks, and the workers join them within the budget
+  ASSERT_LE(in_flight.max_running, 4);
+  ASSERT_EQ(cinn_thread_budget_busy_threads(budget), 0);
+  ASSERT_EQ(cinn_thread_budget_num_launches(budget), 40);
+  ASSERT_EQ(cinn_thread_budget_num_tasks(budget), 40 * 16);
+  cinn_thread_budget_destroy(budget);
+
+  // a thread alone with the budget gets one worker
+  budget = cinn_thread_budget_create(2, 0);
+  cinn_set_thread_budget(budget);
+  InFlight alone;
+  cinn_backend_parallel_launch(&SleepTask, &alone, 64);
+  ASSERT_LE(alone.max_running, 2);
+  cinn_set_thread_budget(nullptr);
+  cinn_thread_budget_destroy(budget);
+  cinn_set_max_concurrency(0);
+}
+
+TEST(ParallelLaunch, launch_priority) {
+  cinn_set_max_concurrency(4);
+  ASSERT_EQ(cinn_set_thread_launch_priority(2), 0);
+  ASSERT_EQ(cinn_set_thread_launch_priority(0), 2);
+
+  // the bulk launches and the latency-critical ones share the workers, the idle ones serving the latter first
+  std::vector<std::thread> threads;
+  std::atomic<int> num_failed{0};
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      cinn_set_thread_launch_priority(t % 2 ? 10 : -1);
+      for (int repeat = 0; repeat < 50; repeat++) {
+        Counters counters(16);
+        cinn_backend_parallel_launch(&CountTask, &counters, 16);
+        for (auto& runs : counters.runs) num_failed += runs != 1;
+      }
+      cinn_set_thread_launch_priority(0);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  ASSERT_EQ(num_failed, 0);
+  cinn_set_max_concurrency(0);
+}
+
+TEST(ParallelLaunch, numa_binding) {
+  ASSERT_EQ(cinn_bind_thread_to_numa_node(cinn_num_numa_nodes()), -1);
+  ASSERT_EQ(cinn_set_numa_nodes("1024"), -1);
+  if (cinn_num_numa_nodes() == 0) return;
+  // the jobs of the bound thread run on the workers of the node
+  ASSERT_EQ(cinn_bind_thread_to_numa_node(0), 0);
+  Counters counters(64);
+  cinn_backend_parallel_launch(&CountTask, &counters, 0);
+  for (int i = 0; i < counters.num_task; i++) ASSERT_EQ(counters.runs[i], 1);
+
+  void* data = malloc(4 << 20);
+  cinn_backend_first_touch(data, 4 << 20);
+  free(data);
+  ASSERT_EQ(cinn_bind_thread_to_numa_node(-1), 0);
+  ASSERT_EQ(cinn_set_numa_nodes("0"), 0);
+  ASSERT_EQ(cinn_set_numa_nodes(""), 0);
+}
+
+}  // namespace cpu
+}  // namespace runtime
+}  // namespace cinn
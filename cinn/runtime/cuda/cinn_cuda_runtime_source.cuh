@@ -2,6 +2,21 @@
  * \file This file contains all the intrinsics available to be used in CUDA code generated by CodeGen.
  */
 
+#include <cuda_fp16.h>
+#if __CUDACC_VER_MAJOR__ >= 11
+#include <cuda_bf16.h>
+#endif
+extern "C++" {
+#include <mma.h>
+}
+
+// The float16 tensors are generated as half.
+typedef half float16;
+#if __CUDACC_VER_MAJOR__ >= 11
+// The bfloat16 tensors are generated as nv_bfloat16, the arithmetic on them requires sm_80 and above.
+typedef nv_bfloat16 bfloat16;
+#endif
+
 #define FN(x) cinn_nvgpu_ ## x ## _fp32
 // NOTE Due to function override, we don't need to use type (such as '_fp32') as the suffix of function's name.
 __device__ inline float FN(sin)(float x) { return sin(x); }
@@ -34,3 +49,506 @@ __device__ inline bool FN(isnan)(float x) { return isnan(x); }
 __device__ inline float FN(max)(float a, float b) { return max(a, b); }
 __device__ inline float FN(min)(float a, float b) { return min(a, b); }
 #undef FN
+
+// The uniform float in [0, 1) of the element index by Philox4x32-10, keyed by seed with the counter
+// {index, offset, 0, 0}. It is stateless, so the mask of the dropout is regenerated in its backward by the same
+// arguments, and it is the same as cinn_host_philox_uniform on the host.
+__device__ inline float cinn_nvgpu_philox_uniform(int seed, int offset, int index) {
+  unsigned int c0 = index, c1 = offset, c2 = 0, c3 = 0;
+  unsigned int k0 = seed, k1 = 0;
+#pragma unroll
+  for (int round = 0; round < 10; round++) {
+    unsigned int hi0 = __umulhi(0xD2511F53u, c0), lo0 = 0xD2511F53u * c0;
+    unsigned int hi1 = __umulhi(0xCD9E8D57u, c2), lo1 = 0xCD9E8D57u * c2;
+    c0               = hi1 ^ c1 ^ k0;
+    c1               = lo1;
+    c2               = hi0 ^ c3 ^ k1;
+    c3               = lo0;
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+  return (c0 >> 8) * (1.f / 16777216.f);
+}
+
+// The tensor core MMA of the 16x16x16 tile C += A * B, the float16 A and B are row or column major as the suffix tells,
+// and the float32 C is column major if c_col_major. All the threads of a warp should call it with the same tiles
+// together. The GPUs without tensor cores compute the tile with the threads of the warp instead.
+#define CINN_WMMA_M16N16K16(a_layout, b_layout)                                                                     \
+  __device__ inline void cinn_nvgpu_wmma_m16n16k16_fp16_##a_layout##_##b_layout(const float16* a,                   \
+                                                                               int a_offset,                       \
+                                                                               int lda,                            \
+                                                                               const float16* b,                   \
+                                                                               int b_offset,                       \
+                                                                               int ldb,                            \
+                                                                               int c_offset,                       \
+                                                                               int ldc,                            \
+                                                                               int c_col_major,                    \
+                                                                               float* c) {                         \
+    __syncwarp();                                                                                                   \
+    CINN_WMMA_TILE(a_layout, b_layout)                                                                              \
+    __syncwarp();                                                                                                   \
+  }
+
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 700
+#define CINN_WMMA_TILE(a_layout, b_layout)                                                                          \
+  nvcuda::wmma::fragment<nvcuda::wmma::matrix_a, 16, 16, 16, half, nvcuda::wmma::a_layout##_major> a_frag;          \
+  nvcuda::wmma::fragment<nvcuda::wmma::matrix_b, 16, 16, 16, half, nvcuda::wmma::b_layout##_major> b_frag;          \
+  nvcuda::wmma::fragment<nvcuda::wmma::accumulator, 16, 16, 16, float> c_frag;                                      \
+  nvcuda::wmma::layout_t c_layout = c_col_major ? nvcuda::wmma::mem_col_major : nvcuda::wmma::mem_row_major;        \
+  nvcuda::wmma::load_matrix_sync(a_frag, a + a_offset, lda);                                                        \
+  nvcuda::wmma::load_matrix_sync(b_frag, b + b_offset, ldb);                                                        \
+  nvcuda::wmma::load_matrix_sync(c_frag, c + c_offset, ldc, c_layout);                                              \
+  nvcuda::wmma::mma_sync(c_frag, a_frag, b_frag, c_frag);                                                           \
+  nvcuda::wmma::store_matrix_sync(c + c_offset, c_frag, ldc, c_layout);
+#else
+#define CINN_WMMA_TILE(a_layout, b_layout)                                                                          \
+  const bool a_row_major = (#a_layout)[0] == 'r';                                                                   \
+  const bool b_row_major = (#b_layout)[0] == 'r';                                                                   \
+  for (int e = threadIdx.x % 32; e < 256; e += 32) {                                                                \
+    int i   = e / 16;                                                                                               \
+    int j   = e % 16;                                                                                               \
+    int idx = c_offset + (c_col_major ? j * ldc + i : i * ldc + j);                                                 \
+    float acc = c[idx];                                                                                             \
+    for (int k = 0; k < 16; k++) {                                                                                  \
+      acc += __half2float(a[a_offset + (a_row_major ? i * lda + k : k * lda + i)]) *                                \
+             __half2float(b[b_offset + (b_row_major ? k * ldb + j : j * ldb + k)]);                                 \
+    }                                                                                                               \
+    c[idx] = acc;                                                                                                   \
+  }
+#endif
+
+CINN_WMMA_M16N16K16(row, row)
+CINN_WMMA_M16N16K16(row, col)
+CINN_WMMA_M16N16K16(col, row)
+CINN_WMMA_M16N16K16(col, col)
+#undef CINN_WMMA_TILE
+#undef CINN_WMMA_M16N16K16
+
+// The warp and block reductions of float32, cinn_block_reduce_<op>_fp32 reduces the elements
+// x[offset + k * stride] (0 <= k < extent), or their squares for sum_sq, by all the threads of the one dimensional
+// block, whose size should be a multiple of 32, and returns op(init, result) to every thread.
+#define CINN_REDUCE_SUM(a, b) ((a) + (b))
+#define CINN_REDUCE_PROD(a, b) ((a) * (b))
+#define CINN_REDUCE_MAX(a, b) max((a), (b))
+#define CINN_REDUCE_MIN(a, b) min((a), (b))
+#define CINN_REDUCE_ELEM(x) (x)
+#define CINN_REDUCE_SQUARE(x) ((x) * (x))
+
+#define CINN_BLOCK_REDUCE(name, op, identity, elem)                                                                 \
+  __device__ inline float cinn_warp_reduce_##name##_fp32(float value) {                                             \
+    for (int delta = 16; delta > 0; delta >>= 1) {                                                                  \
+      value = op(value, __shfl_down_sync(0xffffffff, value, delta));                                                \
+    }                                                                                                               \
+    return value;                                                                                                   \
+  }                                                                                                                 \
+  __device__ inline float cinn_block_reduce_##name##_fp32(                                                          \
+      float init, const float* x, int offset, int extent, int stride) {                                             \
+    __shared__ float warp_results[32];                                                                              \
+    /* the shared results may be still read by the last reduction */                                                \
+    __syncthreads();                                                                                                \
+    float value = identity;                                                                                         \
+    for (int k = threadIdx.x; k < extent; k += blockDim.x) {                                                        \
+      value = op(value, elem(x[offset + k * stride]));                                                              \
+    }                                                                                                               \
+    value     = cinn_warp_reduce_##name##_fp32(value);                                                              \
+    int lane  = threadIdx.x % 32;                                                                                   \
+    int warp  = threadIdx.x / 32;                                                                                   \
+    if (lane == 0) warp_results[warp] = value;                                                                      \
+    __syncthreads();                                                                                                \
+    if (warp == 0) {                                                                                                \
+      value = lane < blockDim.x / 32 ? warp_results[lane] : identity;                                               \
+      value = cinn_warp_reduce_##name##_fp32(value);                                                                \
+      if (lane == 0) warp_results[0] = value;                                                                       \
+    }                                                                                                               \
+    __syncthreads();                                                                                                \
+    return op(init, warp_results[0]);                                                                               \
+  }
+
+CINN_BLOCK_REDUCE(sum, CINN_REDUCE_SUM, 0.f, CINN_REDUCE_ELEM)
+CINN_BLOCK_REDUCE(prod, CINN_REDUCE_PROD, 1.f, CINN_REDUCE_ELEM)
+CINN_BLOCK_REDUCE(max, CINN_REDUCE_MAX, __int_as_float(0xff800000), CINN_REDUCE_ELEM)
+CINN_BLOCK_REDUCE(min, CINN_REDUCE_MIN, __int_as_float(0x7f800000), CINN_REDUCE_ELEM)
+CINN_BLOCK_REDUCE(sum_sq, CINN_REDUCE_SUM, 0.f, CINN_REDUCE_SQUARE)
+#undef CINN_BLOCK_REDUCE
+#undef CINN_REDUCE_SUM
+#undef CINN_REDUCE_PROD
+#undef CINN_REDUCE_MAX
+#undef CINN_REDUCE_MIN
+#undef CINN_REDUCE_ELEM
+#undef CINN_REDUCE_SQUARE
+
+// The online normalizer of the softmax, each thread keeps the running maximum of its elements and the sum of their
+// exponents scaled by it, so log(sum(exp(x))) is reduced in a single pass without overflowing the exponents.
+__device__ inline void cinn_online_softmax_merge_fp32(float* max_value, float* sum, float other_max, float other_sum) {
+  float new_max = max(*max_value, other_max);
+  // nothing is merged while both are empty
+  if (new_max == __int_as_float(0xff800000)) return;
+  *sum       = *sum * __expf(*max_value - new_max) + other_sum * __expf(other_max - new_max);
+  *max_value = new_max;
+}
+
+__device__ inline void cinn_warp_reduce_logsumexp_fp32(float* max_value, float* sum) {
+  for (int delta = 16; delta > 0; delta >>= 1) {
+    float other_max = __shfl_down_sync(0xffffffff, *max_value, delta);
+    float other_sum = __shfl_down_sync(0xffffffff, *sum, delta);
+    cinn_online_softmax_merge_fp32(max_value, sum, other_max, other_sum);
+  }
+}
+
+__device__ inline float cinn_block_reduce_logsumexp_fp32(
+    float init, const float* x, int offset, int extent, int stride) {
+  __shared__ float warp_max[32];
+  __shared__ float warp_sum[32];
+  // the shared results may be still read by the last reduction
+  __syncthreads();
+  float max_value = __int_as_float(0xff800000);
+  float sum       = 0.f;
+  for (int k = threadIdx.x; k < extent; k += blockDim.x) {
+    float value = x[offset + k * stride];
+    if (value > max_value) {
+      sum       = sum * __expf(max_value - value) + 1.f;
+      max_value = value;
+    } else if (max_value != __int_as_float(0xff800000)) {
+      sum += __expf(value - max_value);
+    }
+  }
+  cinn_warp_reduce_logsumexp_fp32(&max_value, &sum);
+  int lane = threadIdx.x % 32;
+  int warp = threadIdx.x / 32;
+  if (lane == 0) {
+    warp_max[warp] = max_value;
+    warp_sum[warp] = sum;
+  }
+  __syncthreads();
+  if (warp == 0) {
+    max_value = lane < blockDim.x / 32 ? warp_max[lane] : __int_as_float(0xff800000);
+    sum       = lane < blockDim.x / 32 ? warp_sum[lane] : 0.f;
+    cinn_warp_reduce_logsumexp_fp32(&max_value, &sum);
+    if (lane == 0) {
+      warp_max[0] = max_value;
+      warp_sum[0] = sum;
+    }
+  }
+  __syncthreads();
+  float result = warp_max[0] + logf(warp_sum[0]);
+  float upper  = max(init, result);
+  return upper + logf(1.f + __expf(min(init, result) - upper));
+}
+
+// The statistics of the batch norm in the training, cinn_cuda_batch_norm_stats_fp32 reduces the mean and the biased
+// variance of the channel of x in [outer, channels, inner] by all the threads of the block in a single pass. Each
+// thread keeps the count, the mean and the sum of the squared differences M2 of its elements by Welford, which are
+// merged across the threads by the parallel variance of Chan et al.
+__device__ inline void cinn_batch_norm_stats_merge_fp32(
+    float* count, float* mean, float* m2, float other_count, float other_mean, float other_m2) {
+  float total = *count + other_count;
+  if (total == 0.f) return;
+  float delta = other_mean - *mean;
+  float ratio = other_count / total;
+  *mean += delta * ratio;
+  *m2 += other_m2 + delta * delta * *count * ratio;
+  *count = total;
+}
+
+__device__ inline void cinn_warp_reduce_batch_norm_stats_fp32(float* count, float* mean, float* m2) {
+  for (int delta = 16; delta > 0; delta >>= 1) {
+    float other_count = __shfl_down_sync(0xffffffff, *count, delta);
+    float other_mean  = __shfl_down_sync(0xffffffff, *mean, delta);
+    float other_m2    = __shfl_down_sync(0xffffffff, *m2, delta);
+    cinn_batch_norm_stats_merge_fp32(count, mean, m2, other_count, other_mean, other_m2);
+  }
+}
+
+__device__ inline void cinn_cuda_batch_norm_stats_fp32(
+    int channel, int outer, int channels, int inner, const float* x, float* mean, float* variance) {
+  __shared__ float warp_count[32];
+  __shared__ float warp_mean[32];
+  __shared__ float warp_m2[32];
+  float count = 0.f, running_mean = 0.f, m2 = 0.f;
+  for (int k = threadIdx.x; k < outer * inner; k += blockDim.x) {
+    int o       = k / inner;
+    float value = x[(o * channels + channel) * inner + k - o * inner];
+    count += 1.f;
+    float delta = value - running_mean;
+    running_mean += delta / count;
+    m2 += delta * (value - running_mean);
+  }
+  cinn_warp_reduce_batch_norm_stats_fp32(&count, &running_mean, &m2);
+  int lane = threadIdx.x % 32;
+  int warp = threadIdx.x / 32;
+  if (lane == 0) {
+    warp_count[warp] = count;
+    warp_mean[warp]  = running_mean;
+    warp_m2[warp]    = m2;
+  }
+  __syncthreads();
+  if (warp == 0) {
+    count        = lane < blockDim.x / 32 ? warp_count[lane] : 0.f;
+    running_mean = lane < blockDim.x / 32 ? warp_mean[lane] : 0.f;
+    m2           = lane < blockDim.x / 32 ? warp_m2[lane] : 0.f;
+    cinn_warp_reduce_batch_norm_stats_fp32(&count, &running_mean, &m2);
+    if (lane == 0) {
+      mean[channel]     = running_mean;
+      variance[channel] = m2 / count;
+    }
+  }
+}
+
+// The top-k of float32, cinn_cuda_top_k_fp32 selects the k largest, or smallest if largest is 0, elements of the row
+// of x in [rows, cols] by all the threads of the block, and writes them in the descending, or ascending, order into
+// values in [rows, k] along with their indices. The k-th key is found by the radix select of 8 bits a pass, and the
+// selected are sorted by the bitonic sort, of a warp if k <= 32. The elements ordered the same by their keys are
+// ordered by their indices, while the ones tied with the k-th key are selected in no particular order.
+#define CINN_TOP_K_MAX_K 1024
+
+// the unsigned keys ordered as the floats, and reversed for the smallest
+__device__ inline unsigned int cinn_top_k_key_fp32(float x, int largest) {
+  unsigned int bits = __float_as_uint(x);
+  unsigned int key  = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+  return largest ? key : ~key;
+}
+
+__device__ inline bool cinn_top_k_before(unsigned int key_a, int index_a, unsigned int key_b, int index_b) {
+  return key_a > key_b || (key_a == key_b && index_a < index_b);
+}
+
+__device__ inline void cinn_cuda_top_k_fp32(
+    int row, int cols, int k, int largest, const float* x, float* values, int* indices) {
+  __shared__ unsigned int histogram[256];
+  __shared__ unsigned int selected_keys[CINN_TOP_K_MAX_K];
+  __shared__ int selected_indices[CINN_TOP_K_MAX_K];
+  __shared__ unsigned int prefix;
+  __shared__ int remaining;
+  __shared__ int num_greater;
+  __shared__ int num_equal;
+  const float* in = x + row * cols;
+  int tid         = threadIdx.x;
+  // the shared selection may be still read by the last one
+  __syncthreads();
+  if (tid == 0) {
+    prefix    = 0;
+    remaining = k;
+  }
+  // the digits of the k-th key from the highest, which the keys of the same higher digits are counted by
+  unsigned int mask = 0;
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    for (int i = tid; i < 256; i += blockDim.x) histogram[i] = 0;
+    __syncthreads();
+    unsigned int digits = prefix;
+    for (int j = tid; j < cols; j += blockDim.x) {
+      unsigned int key = cinn_top_k_key_fp32(in[j], largest);
+      if ((key & mask) == digits) atomicAdd(&histogram[(key >> shift) & 255], 1u);
+    }
+    __syncthreads();
+    if (tid == 0) {
+      int rest = remaining;
+      int d    = 255;
+      for (; d > 0 && histogram[d] < rest; --d) rest -= histogram[d];
+      prefix    = digits | (static_cast<unsigned int>(d) << shift);
+      remaining = rest;
+      if (shift == 0) {
+        num_greater = 0;
+        num_equal   = 0;
+      }
+    }
+    mask |= 255u << shift;
+    __syncthreads();
+  }
+
+  unsigned int kth_key = prefix;
+  int num_ties         = remaining;
+  for (int j = tid; j < cols; j += blockDim.x) {
+    unsigned int key = cinn_top_k_key_fp32(in[j], largest);
+    if (key > kth_key) {
+      int pos               = atomicAdd(&num_greater, 1);
+      selected_keys[pos]    = key;
+      selected_indices[pos] = j;
+    } else if (key == kth_key) {
+      int pos = atomicAdd(&num_equal, 1);
+      if (pos < num_ties) {
+        selected_keys[k - num_ties + pos]    = key;
+        selected_indices[k - num_ties + pos] = j;
+      }
+    }
+  }
+  __syncthreads();
+
+  int n = 1;
+  while (n < k) n <<= 1;
+  if (n <= 32) {
+    if (tid < 32) {
+      unsigned int key = tid < k ? selected_keys[tid] : 0u;
+      int index        = tid < k ? selected_indices[tid] : 0x7fffffff;
+      for (int size = 2; size <= 32; size <<= 1) {
+        for (int stride = size >> 1; stride > 0; stride >>= 1) {
+          unsigned int other_key = __shfl_xor_sync(0xffffffff, key, stride);
+          int other_index        = __shfl_xor_sync(0xffffffff, index, stride);
+          // the lower of a pair keeps the one before in the descending halves, and the one after in the others
+          bool lower        = (tid & stride) == 0;
+          bool descending   = (tid & size) == 0;
+          bool other_before = cinn_top_k_before(other_key, other_index, key, index);
+          if (lower == descending ? other_before : !other_before) {
+            key   = other_key;
+            index = other_index;
+          }
+        }
+      }
+      if (tid < k) {
+        values[row * k + tid]  = in[index];
+        indices[row * k + tid] = index;
+      }
+    }
+    return;
+  }
+
+  for (int i = k + tid; i < n; i += blockDim.x) {
+    selected_keys[i]    = 0u;
+    selected_indices[i] = 0x7fffffff;
+  }
+  __syncthreads();
+  for (int size = 2; size <= n; size <<= 1) {
+    for (int stride = size >> 1; stride > 0; stride >>= 1) {
+      for (int i = tid; i < n; i += blockDim.x) {
+        int j = i ^ stride;
+        if (j <= i) continue;
+        bool descending = (i & size) == 0;
+        bool j_before =
+            cinn_top_k_before(selected_keys[j], selected_indices[j], selected_keys[i], selected_indices[i]);
+        if (descending == j_before) {
+          unsigned int key    = selected_keys[i];
+          int index           = selected_indices[i];
+          selected_keys[i]    = selected_keys[j];
+          selected_indices[i] = selected_indices[j];
+          selected_keys[j]    = key;
+          selected_indices[j] = index;
+        }
+      }
+      __syncthreads();
+    }
+  }
+  for (int i = tid; i < k; i += blockDim.x) {
+    values[row * k + i]  = in[selected_indices[i]];
+    indices[row * k + i] = selected_indices[i];
+  }
+}
+
+// The tiled transpose of float32, cinn_cuda_transpose_tiled_fp32 copies the tile of the input of [rows, cols] at
+// x_offset with the rows x_stride apart, into the output of [cols, rows] at out_offset with the rows out_stride apart,
+// by all the threads of the block, which each copy a column of the tile every warps rows. The tile is staged in the
+// shared memory padded by a column, so that both the reads of its rows and of its columns are free of bank conflicts,
+// and both the global reads and writes are coalesced.
+#define CINN_TRANSPOSE_TILE 32
+
+__device__ inline void cinn_cuda_transpose_tiled_fp32(int tile_row,
+                                                      int tile_col,
+                                                      int rows,
+                                                      int cols,
+                                                      int x_offset,
+                                                      int x_stride,
+                                                      int out_offset,
+                                                      int out_stride,
+                                                      const float* x,
+                                                      float* out) {
+  __shared__ float tile[CINN_TRANSPOSE_TILE][CINN_TRANSPOSE_TILE + 1];
+  int lane     = threadIdx.x % CINN_TRANSPOSE_TILE;
+  int warp     = threadIdx.x / CINN_TRANSPOSE_TILE;
+  int warps    = blockDim.x / CINN_TRANSPOSE_TILE;
+  int row_base = tile_row * CINN_TRANSPOSE_TILE;
+  int col_base = tile_col * CINN_TRANSPOSE_TILE;
+  if (col_base + lane < cols) {
+    for (int i = warp; i < CINN_TRANSPOSE_TILE && row_base + i < rows; i += warps) {
+      tile[i][lane] = x[x_offset + (row_base + i) * x_stride + col_base + lane];
+    }
+  }
+  __syncthreads();
+  if (row_base + lane < rows) {
+    for (int i = warp; i < CINN_TRANSPOSE_TILE && col_base + i < cols; i += warps) {
+      out[out_offset + (col_base + i) * out_stride + row_base + lane] = tile[lane][i];
+    }
+  }
+}
+
+// The asynchronous copy of a float32 element from the global to the shared memory, cinn_nvgpu_cp_async_commit closes
+// the group of the copies issued since the last group and cinn_nvgpu_cp_async_wait waits until at most pending groups
+// are in flight, the threads should still sync to see the copies of each other. The GPUs before Ampere copy
+// synchronously, and the commit and wait do nothing.
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 800
+__device__ inline void cinn_nvgpu_cp_async_fp32(float* dst, const float* src) {
+  unsigned int addr = static_cast<unsigned int>(__cvta_generic_to_shared(dst));
+  asm volatile("cp.async.ca.shared.global [%0], [%1], 4;\n" ::"r"(addr), "l"(src));
+}
+
+__device__ inline void cinn_nvgpu_cp_async_commit() { asm volatile("cp.async.commit_group;\n" ::); }
+
+__device__ inline void cinn_nvgpu_cp_async_wait(int pending) {
+  switch (pending) {
+    case 0:
+      asm volatile("cp.async.wait_group 0;\n" ::);
+      break;
+    case 1:
+      asm volatile("cp.async.wait_group 1;\n" ::);
+      break;
+    case 2:
+      asm volatile("cp.async.wait_group 2;\n" ::);
+      break;
+    default:
+      asm volatile("cp.async.wait_all;\n" ::);
+  }
+}
+#else
+__device__ inline void cinn_nvgpu_cp_async_fp32(float* dst, const float* src) { *dst = *src; }
+
+__device__ inline void cinn_nvgpu_cp_async_commit() {}
+
+__device__ inline void cinn_nvgpu_cp_async_wait(int pending) {}
+#endif
+
+// The lane-wise arithmetic of the float2 and float4 vectorized by VectorizeLoops, and the loads and stores of the
+// vectors not aligned to their size, which access the elements one by one. half2 has its arithmetic in cuda_fp16.h.
+#define CINN_VECTOR_ADD(a, b) ((a) + (b))
+#define CINN_VECTOR_SUB(a, b) ((a) - (b))
+#define CINN_VECTOR_MUL(a, b) ((a) * (b))
+#define CINN_VECTOR_DIV(a, b) ((a) / (b))
+
+#define CINN_FLOAT_VECTOR_OP(fn, op)                                                                                \
+  __device__ inline float2 fn(float2 a, float2 b) { return make_float2(op(a.x, b.x), op(a.y, b.y)); }               \
+  __device__ inline float4 fn(float4 a, float4 b) {                                                                 \
+    return make_float4(op(a.x, b.x), op(a.y, b.y), op(a.z, b.z), op(a.w, b.w));                                     \
+  }
+
+CINN_FLOAT_VECTOR_OP(operator+, CINN_VECTOR_ADD)
+CINN_FLOAT_VECTOR_OP(operator-, CINN_VECTOR_SUB)
+CINN_FLOAT_VECTOR_OP(operator*, CINN_VECTOR_MUL)
+CINN_FLOAT_VECTOR_OP(operator/, CINN_VECTOR_DIV)
+CINN_FLOAT_VECTOR_OP(cinn_nvgpu_max_fp32, max)
+CINN_FLOAT_VECTOR_OP(cinn_nvgpu_min_fp32, min)
+#undef CINN_FLOAT_VECTOR_OP
+#undef CINN_VECTOR_ADD
+#undef CINN_VECTOR_SUB
+#undef CINN_VECTOR_MUL
+#undef CINN_VECTOR_DIV
+
+__device__ inline float2 cinn_nvgpu_loadu_float2(const float* p) { return make_float2(p[0], p[1]); }
+__device__ inline float4 cinn_nvgpu_loadu_float4(const float* p) { return make_float4(p[0], p[1], p[2], p[3]); }
+__device__ inline half2 cinn_nvgpu_loadu_half2(const float16* p) { return __halves2half2(p[0], p[1]); }
+
+// Pack 4 int8 into an int32 with the first one in the lowest byte, the operand of the DP4A.
+__device__ inline int cinn_nvgpu_pack_char4(signed char a0, signed char a1, signed char a2, signed char a3) {
+  return (static_cast<unsigned char>(a0)) | (static_cast<unsigned char>(a1) << 8) |
+         (static_cast<unsigned char>(a2) << 16) | (static_cast<unsigned char>(a3) << 24);
+}
+
+__device__ inline void cinn_nvgpu_storeu(float* p, float2 v) {
+  p[0] = v.x;
+  p[1] = v.y;
+}
+__device__ inline void cinn_nvgpu_storeu(float* p, float4 v) {
+  p[0] = v.x;
+  p[1] = v.y;
+  p[2] = v.z;
+  p[3] = v.w;
+}
+__device__ inline void cinn_nvgpu_storeu(float16* p, half2 v) {
+  p[0] = __low2half(v);
+  p[1] = __high2half(v);
+}
@@ -16,6 +16,7 @@
 #include "cinn/backends/extern_func_jit_register.h"
 #include "cinn/backends/function_prototype.h"
 #include "cinn/common/cas.h"
+#include "cinn/ir/tensor.h"
 #include "cinn/runtime/cuda/cuda_util.h"
 
 CINN_REGISTER_HELPER(cuda_intrinsics) {
@@ -51,6 +52,83 @@ CINN_REGISTER_HELPER(cuda_intrinsics) {
   REGISTER_EXTERN_FUNC_1_IN_1_OUT_FLOAT(isfinite);
   REGISTER_EXTERN_FUNC_1_IN_1_OUT_FLOAT(isinf);
 
+  REGISTER_FACKED_EXTERN_FUNC_HELPER(cinn_nvgpu_philox_uniform, target)
+      .SetRetType<float>()
+      .AddInputType<int>()  // seed
+      .AddInputType<int>()  // offset
+      .AddInputType<int>()  // index
+      .End();
+
+  // the values and the indices of top_k are in the shape of x except the last axis of k
+  FunctionProto::shape_inference_t inference_shape_top_k = [](const std::vector<cinn::ir::Expr> &args, int offset) {
+    CHECK_EQ(args.size(), 5UL) << "Wrong number of arguments passed in";
+    auto *x = args[4].as_tensor();
+    CHECK(x);
+    auto shape   = x->shape;
+    shape.back() = args[2];
+    return shape;
+  };
+
+  REGISTER_FACKED_EXTERN_FUNC_HELPER(cinn_cuda_top_k_fp32, target)
+      .SetRetType<void>()
+      .AddInputType<int>()               // row
+      .AddInputType<int>()               // cols
+      .AddInputType<int>()               // k
+      .AddInputType<int>()               // largest
+      .AddInputType<cinn_buffer_t *>()   // x
+      .AddOutputType<cinn_buffer_t *>()  // values
+      .AddOutputType<cinn_buffer_t *>()  // indices
+      .SetShapeInference(inference_shape_top_k)
+      .End();
+
+  // the mean and the variance of the batch norm are of the channels
+  FunctionProto::shape_inference_t inference_shape_batch_norm_stats = [](const std::vector<cinn::ir::Expr> &args,
+                                                                         int offset) {
+    CHECK_EQ(args.size(), 5UL) << "Wrong number of arguments passed in";
+    return std::vector<cinn::ir::Expr>{args[2]};
+  };
+
+  REGISTER_FACKED_EXTERN_FUNC_HELPER(cinn_cuda_batch_norm_stats_fp32, target)
+      .SetRetType<void>()
+      .AddInputType<int>()               // channel
+      .AddInputType<int>()               // outer
+      .AddInputType<int>()               // channels
+      .AddInputType<int>()               // inner
+      .AddInputType<cinn_buffer_t *>()   // x
+      .AddOutputType<cinn_buffer_t *>()  // mean
+      .AddOutputType<cinn_buffer_t *>()  // variance
+      .SetShapeInference(inference_shape_batch_norm_stats)
+      .End();
+
+  // the output of the tiled transpose is written flat, in the memory of the transposed shape of x
+  FunctionProto::shape_inference_t inference_shape_transpose = [](const std::vector<cinn::ir::Expr> &args,
+                                                                  int offset) {
+    CHECK_EQ(args.size(), 9UL) << "Wrong number of arguments passed in";
+    auto *x = args[8].as_tensor();
+    CHECK(x);
+    int numel = 1;
+    for (auto &dim : x->shape) {
+      CHECK(dim.is_constant()) << "The shape of the tiled transpose should be constant";
+      numel *= dim.as_int32();
+    }
+    return std::vector<cinn::ir::Expr>{cinn::ir::Expr(numel)};
+  };
+
+  REGISTER_FACKED_EXTERN_FUNC_HELPER(cinn_cuda_transpose_tiled_fp32, target)
+      .SetRetType<void>()
+      .AddInputType<int>()               // tile_row
+      .AddInputType<int>()               // tile_col
+      .AddInputType<int>()               // rows
+      .AddInputType<int>()               // cols
+      .AddInputType<int>()               // x_offset
+      .AddInputType<int>()               // x_stride
+      .AddInputType<int>()               // out_offset
+      .AddInputType<int>()               // out_stride
+      .AddInputType<cinn_buffer_t *>()   // x
+      .AddOutputType<cinn_buffer_t *>()  // out
+      .SetShapeInference(inference_shape_transpose)
+      .End();
+
   return true;
 }
 
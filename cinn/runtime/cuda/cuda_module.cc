@@ -14,20 +14,41 @@
 
 #include "cinn/runtime/cuda/cuda_module.h"
 
+#include <absl/container/flat_hash_map.h>
 #include <cuda.h>
 #include <cuda_runtime.h>
 #include <glog/logging.h>
 
+#include <atomic>
 #include <mutex>  // NOLINT
 #include <string>
+#include <utility>
 
 #include "cinn/backends/cuda_util.h"
+#include "cinn/backends/nvrtc_util.h"
 #include "cinn/runtime/cuda/cuda_util.h"
 
 namespace cinn {
 namespace runtime {
 namespace cuda {
 
+namespace {
+
+// The module and the name of each function got by CUDAModule::GetFunction, to find the same kernel on other devices.
+struct FunctionRegistry {
+  std::mutex mutex;
+  absl::flat_hash_map<CUfunction, std::pair<CUDAModule*, std::string>> functions;
+  // Increased when a module is destroyed, to invalidate the functions cached by the threads.
+  std::atomic<uint64_t> generation{0};
+
+  static FunctionRegistry& Global() {
+    static FunctionRegistry registry;
+    return registry;
+  }
+};
+
+}  // namespace
+
 CUDAModule::CUDAModule(const std::string& data, Kind kind) : data_(data), kind_(kind) {
   CHECK(!data.empty());
 
@@ -43,6 +64,11 @@ CUDAModule::CUDAModule(const std::string& data, Kind kind) : data_(data), kind_(
   cuDevicePrimaryCtxRetain(&context_, device_);
 }
 
+CUDAModule::Kind CUDAModule::KindOf(const std::string& data) {
+  bool is_elf = data.size() >= 4 && data[0] == '\x7f' && data.compare(1, 3, "ELF") == 0;
+  return is_elf ? Kind::CUBIN : Kind::PTX;
+}
+
 void CUDAModule::LaunchKernel(int device_id,
                               const std::string& func_name,
                               dim3 gridDim,
@@ -65,39 +91,105 @@ void CUDAModule::LaunchKernel(int device_id,
                                   nullptr));
 }
 
-CUfunction CUDAModule::GetFunction(int device_id, const std::string& func_name) {
+CUmodule CUDAModule::ModuleOnDevice(int device_id) {
+  CHECK_GE(device_id, 0);
+  CHECK_LT(device_id, kCUDAMaxCards);
+  std::lock_guard<std::mutex> lock(mutex_);
   if (!module_per_card_[device_id]) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    // The module is loaded in the current context, which may belong to another device.
+    CUdevice device;
+    CUcontext context;
+    CUDA_DRIVER_CALL(cuDeviceGet(&device, device_id));
+    CUDA_DRIVER_CALL(cuDevicePrimaryCtxRetain(&context, device));
+    CUDA_DRIVER_CALL(cuCtxPushCurrent(context));
     CUDA_DRIVER_CALL(cuModuleLoadData(&module_per_card_[device_id], data_.c_str()));
+    CUDA_DRIVER_CALL(cuCtxPopCurrent(&context));
+    context_per_card_[device_id] = context;
   }
+  return module_per_card_[device_id];
+}
 
+CUfunction CUDAModule::GetFunction(int device_id, const std::string& func_name) {
   CUfunction func;
-  CUDA_DRIVER_CALL(cuModuleGetFunction(&func, module_per_card_[device_id], func_name.c_str()));
+  CUDA_DRIVER_CALL(cuModuleGetFunction(&func, ModuleOnDevice(device_id), func_name.c_str()));
+  auto& registry = FunctionRegistry::Global();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.functions[func] = std::make_pair(this, func_name);
   return func;
 }
 
-CUdeviceptr CUDAModule::GetGlobal(int device_id, const std::string& name, size_t nbytes) {
-  if (!module_per_card_[device_id]) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    CUDA_DRIVER_CALL(cuModuleLoadData(&module_per_card_[device_id], data_.c_str()));
+CUfunction CUDAModule::FunctionOnDevice(CUfunction function, int device_id) {
+  auto& registry = FunctionRegistry::Global();
+  // It is called on each kernel launch of the replicas, so the functions found are cached by the thread.
+  thread_local absl::flat_hash_map<std::pair<CUfunction, int>, CUfunction> t_functions;
+  thread_local uint64_t t_generation = 0;
+  uint64_t generation                = registry.generation.load(std::memory_order_acquire);
+  if (t_generation != generation) {
+    t_functions.clear();
+    t_generation = generation;
   }
+  auto key = std::make_pair(function, device_id);
+  auto it  = t_functions.find(key);
+  if (it != t_functions.end()) return it->second;
+
+  CUDAModule* module = nullptr;
+  std::string name;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto found = registry.functions.find(function);
+    CHECK(found != registry.functions.end()) << "The function is not got from a CUDAModule";
+    module = found->second.first;
+    name   = found->second.second;
+  }
+  auto result = module->GetFunction(device_id, name);
+  t_functions.emplace(key, result);
+  return result;
+}
 
+CUdeviceptr CUDAModule::GetGlobal(int device_id, const std::string& name, size_t nbytes) {
   CUdeviceptr global;
   size_t _nbytes;
-  CUDA_DRIVER_CALL(cuModuleGetGlobal(&global, &_nbytes, module_per_card_[device_id], name.c_str()));
+  CUDA_DRIVER_CALL(cuModuleGetGlobal(&global, &_nbytes, ModuleOnDevice(device_id), name.c_str()));
   return global;
 }
 
 CUDAModule::~CUDAModule() {
+  {
+    auto& registry = FunctionRegistry::Global();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto it = registry.functions.begin(); it != registry.functions.end();) {
+      if (it->second.first == this) {
+        registry.functions.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    registry.generation.fetch_add(1, std::memory_order_release);
+  }
   for (int i = 0; i < module_per_card_.size(); i++) {
     auto* module = module_per_card_[i];
     if (module) {
-      CUDA_CALL(cudaSetDevice(i));
+      CUcontext context = context_per_card_[i];
+      CUDA_DRIVER_CALL(cuCtxPushCurrent(context));
       CUDA_DRIVER_CALL(cuModuleUnload(module));
+      CUDA_DRIVER_CALL(cuCtxPopCurrent(&context));
+      CUdevice device;
+      CUDA_DRIVER_CALL(cuDeviceGet(&device, i));
+      CUDA_DRIVER_CALL(cuDevicePrimaryCtxRelease(device));
     }
   }
 }
 
+CUDAModule* LazyCUDAModule::get() {
+  std::call_once(once_, [this] {
+    backends::NVRTC_Compiler compiler;
+    auto code = compiler(source_, true);
+    CHECK(!code.empty()) << "Failed to compile the CUDA source:\n" << source_;
+    module_.reset(new CUDAModule(code, CUDAModule::KindOf(code)));
+  });
+  return module_.get();
+}
+
 }  // namespace cuda
 }  // namespace runtime
 }  // namespace cinn
@@ -18,6 +18,7 @@
 #include <cuda.h>
 #include <cuda_runtime.h>
 
+#include <memory>
 #include <mutex>  // NOLINT
 #include <string>
 #include <vector>
@@ -35,12 +36,17 @@ namespace cuda {
  */
 class CUDAModule {
  public:
+  //! The driver tells the kind from the data itself, so a CUBIN loads as well when it is passed as PTX.
   enum class Kind {
-    PTX = 0,
+    PTX   = 0,
+    CUBIN = 1,
   };
 
   CUDAModule(const std::string& data, Kind kind);
 
+  //! The kind of the PTX or CUBIN \p data, the CUBIN is an ELF file.
+  static Kind KindOf(const std::string& data);
+
   void LaunchKernel(int device_id,
                     const std::string& func_name,
                     dim3 gridDim,
@@ -49,21 +55,32 @@ class CUDAModule {
                     size_t share_memory_size = 0,
                     CUstream stream          = nullptr);
 
-  //! Get a function.
+  //! Get a function, the module is loaded on \p device_id on the first use.
   CUfunction GetFunction(int device_id, const std::string& func_name);
 
+  /**
+   * Get the same kernel as \p function on \p device_id, where \p function is got by GetFunction of any module on any
+   * device, e.g. the kernel a compiled host function launches on device 0. It is thread-safe.
+   */
+  static CUfunction FunctionOnDevice(CUfunction function, int device_id);
+
   //! Get a global variable.
   CUdeviceptr GetGlobal(int device_id, const std::string& name, size_t nbytes);
 
   ~CUDAModule();
 
  private:
+  //! Get the module loaded on \p device_id, it is loaded in the primary context of the device on the first use.
+  CUmodule ModuleOnDevice(int device_id);
+
   //! The input data.
   std::string data_;
   //! Kind of the input.
   Kind kind_;
   //! To make parallel, we prepare one module for each card.
   std::vector<CUmodule> module_per_card_{kCUDAMaxCards, nullptr};
+  //! The primary contexts the modules are loaded in.
+  std::vector<CUcontext> context_per_card_{kCUDAMaxCards, nullptr};
   std::string cuda_source_;
   std::mutex mutex_;
 
@@ -72,6 +89,24 @@ class CUDAModule {
   int num_devices_{0};
 };
 
+/**
+ * The module of the CUDA source of the runtime kernels, compiled by NVRTC once on the first use and loaded on each
+ * device. It is usually a function-local static, as the kernels of a runtime op are only compiled when they are run.
+ */
+class LazyCUDAModule {
+ public:
+  //! \p source should outlive the module, e.g. a string literal.
+  explicit LazyCUDAModule(const char* source) : source_(source) {}
+
+  //! Get the module, it is compiled on the first call. It is thread-safe.
+  CUDAModule* get();
+
+ private:
+  const char* source_;
+  std::unique_ptr<CUDAModule> module_;
+  std::once_flag once_;
+};
+
 }  // namespace cuda
 }  // namespace runtime
 }  // namespace cinn
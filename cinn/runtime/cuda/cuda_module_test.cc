@@ -47,6 +47,70 @@ void saxpy(float a, float *x, float *y, float *out, size_t n)
   ASSERT_TRUE(func);
 }
 
+TEST(KernelLaunch, many_args) {
+  // a kernel summing 24 inputs, more arguments than the launches used to take
+  constexpr int kNumInputs = 24;
+  constexpr int kNumel     = 1000;
+  std::string params, sum;
+  for (int i = 0; i < kNumInputs; i++) {
+    params += "const float* x" + std::to_string(i) + ", ";
+    sum += (i ? " + x" : "x") + std::to_string(i) + "[tid]";
+  }
+  std::string source_code = "extern \"C\" __global__ void sum(" + params +
+                            "float* out, int n) {\n"
+                            "  int tid = blockIdx.x * blockDim.x + threadIdx.x;\n"
+                            "  if (tid < n) out[tid] = " +
+                            sum + ";\n}\n";
+  backends::NVRTC_Compiler compiler;
+  auto ptx = compiler(source_code);
+  ASSERT_FALSE(ptx.empty());
+  CUDAModule module(ptx, CUDAModule::Kind::PTX);
+
+  std::vector<cinn_buffer_t> buffers(kNumInputs + 1);
+  std::vector<float> host(kNumel);
+  for (int i = 0; i <= kNumInputs; i++) {
+    void* data = nullptr;
+    CUDA_CALL(cudaMalloc(&data, kNumel * sizeof(float)));
+    for (int j = 0; j < kNumel; j++) host[j] = i + j * 0.5f;
+    CUDA_CALL(cudaMemcpy(data, host.data(), kNumel * sizeof(float), cudaMemcpyHostToDevice));
+    buffers[i].memory = static_cast<uint8_t*>(data);
+  }
+  std::vector<cinn_pod_value_t> args;
+  for (auto& buffer : buffers) args.emplace_back(&buffer);
+  args.emplace_back(static_cast<int32_t>(kNumel));
+
+  KernelLaunch launch;
+  launch.function   = module.GetFunction(0, "sum");
+  launch.grid_dims  = {(kNumel + 255) / 256, 1, 1};
+  launch.block_dims = {256, 1, 1};
+  launch.BindArgs(args.data(), args.size());
+  ASSERT_EQ(launch.params.size(), kNumInputs + 2);
+  // the sum of the inputs from the first one
+  auto check = [&](int first) {
+    CUDA_CALL(cudaMemcpy(host.data(), buffers.back().memory, kNumel * sizeof(float), cudaMemcpyDeviceToHost));
+    for (int j = 0; j < kNumel; j++) {
+      float expected = 0.f;
+      for (int i = first; i < kNumInputs; i++) expected += i + j * 0.5f;
+      ASSERT_FLOAT_EQ(host[j], expected) << "at " << j;
+    }
+  };
+  launch.Launch(nullptr);
+  check(0);
+
+  // the parameters point at the memory fields of the buffers, so the launch takes the memory set after the binding
+  std::swap(buffers[0].memory, buffers[kNumInputs].memory);
+  CUDA_CALL(cudaMemset(buffers[0].memory, 0, kNumel * sizeof(float)));
+  launch.Launch(nullptr);
+  check(1);
+
+  // the host functions launch through cinn_call_cuda_kernel without the limit as well
+  CUDA_CALL(cudaMemset(buffers.back().memory, 0, kNumel * sizeof(float)));
+  cinn_call_cuda_kernel(
+      launch.function, args.data(), args.size(), launch.grid_dims[0], 1, 1, launch.block_dims[0], 1, 1, nullptr);
+  check(1);
+  for (auto& buffer : buffers) CUDA_CALL(cudaFree(buffer.memory));
+}
+
 }  // namespace cuda
 }  // namespace runtime
 }  // namespace cinn
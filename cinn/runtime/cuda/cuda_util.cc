@@ -14,14 +14,20 @@
 
 #include "cinn/runtime/cuda/cuda_util.h"
 
+#include <cuda_fp16.h>
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "cinn/backends/cuda_util.h"
 #include "cinn/backends/extern_func_jit_register.h"
 #include "cinn/common/target.h"
+#include "cinn/runtime/cuda/cuda_module.h"
 #include "cinn/utils/timer.h"
 
 namespace cinn {
@@ -32,55 +38,195 @@ SerialData::SerialData() {}
 
 SerialData::~SerialData() {}
 
-CudnnHandle::CudnnHandle() {
-  CUDNN_CALL(cudnnCreate(&cudnn));
-  size_      = 0;
-  work_space = nullptr;
+std::vector<std::string> SerialData::Context() {
+  int device = 0;
+  CUDA_CALL(cudaGetDevice(&device));
+  CHECK_LT(device, kCUDAMaxCards);
+  std::lock_guard<std::mutex> lock(mu_);
+  auto &context = contexts_[device];
+  if (context.empty()) {
+    cudaDeviceProp prop;
+    CUDA_CALL(cudaGetDeviceProperties(&prop, device));
+    context = {prop.name, std::to_string(prop.major) + "." + std::to_string(prop.minor), std::to_string(CUDNN_VERSION)};
+  }
+  return context;
+}
+
+bool SerialData::FindAlgo(const std::string &key, int *algo) { return algos_.Find(key, Context(), algo); }
+
+void SerialData::StoreAlgo(const std::string &key, int algo) { algos_.Store(key, Context(), algo); }
+
+namespace {
+struct WorkSpaceAllocator {
+  std::mutex mu;
+  LibraryHandles::malloc_t malloc;
+  LibraryHandles::free_t free;
+
+  static WorkSpaceAllocator &Global() {
+    static auto *x = new WorkSpaceAllocator;
+    return *x;
+  }
+};
+}  // namespace
+
+std::atomic<size_t> LibraryHandles::total_workspace_size_{0};
+std::atomic<uint64_t> LibraryHandles::workspace_generation_{0};
+
+namespace {
+struct HandlesPool {
+  std::mutex mu;
+  std::map<std::pair<int, cudaStream_t>, std::unique_ptr<LibraryHandles>> handles;
+};
+
+// The handles live till the process exits, as the streams may be reused by the later programs.
+HandlesPool &GlobalHandlesPool() {
+  static auto *pool = new HandlesPool;
+  return *pool;
+}
+}  // namespace
+
+LibraryHandles &LibraryHandles::Get(cudaStream_t stream) {
+  auto &pool = GlobalHandlesPool();
+  int device = 0;
+  CUDA_CALL(cudaGetDevice(&device));
+  std::lock_guard<std::mutex> lock(pool.mu);
+  auto &handles = pool.handles[{device, stream}];
+  if (!handles) handles.reset(new LibraryHandles(device, stream));
+  return *handles;
 }
 
-CudnnHandle::~CudnnHandle() {
-  CUDNN_CALL(cudnnDestroy(cudnn));
-  if (size_ > 0) {
-    CUDA_CALL(cudaFree(work_space));
+void LibraryHandles::ReleaseWorkSpaces() {
+  auto &pool = GlobalHandlesPool();
+  std::lock_guard<std::mutex> lock(pool.mu);
+  bool released = false;
+  for (auto &item : pool.handles) {
+    auto &handles = *item.second;
+    std::lock_guard<std::mutex> handles_lock(handles.mu_);
+    if (!handles.workspace_) continue;
+    // the frees are ordered after the calls queued on the stream, as in GetWorkSpace
+    handles.workspace_free_(handles.workspace_);
+    total_workspace_size_ -= handles.workspace_size_;
+    handles.workspace_      = nullptr;
+    handles.workspace_size_ = 0;
+    released                = true;
   }
+  if (released) workspace_generation_++;
 }
 
-CublasHandle::CublasHandle() { cublasCreate(&cublas); }
+void LibraryHandles::SetWorkSpaceAllocator(malloc_t malloc, free_t free) {
+  auto &allocator = WorkSpaceAllocator::Global();
+  std::lock_guard<std::mutex> lock(allocator.mu);
+  allocator.malloc = std::move(malloc);
+  allocator.free   = std::move(free);
+}
 
-CublasHandle::~CublasHandle() { cublasDestroy(cublas); }
+LibraryHandles::LibraryHandles(int device, cudaStream_t stream) : device_(device), stream_(stream) {
+  CUDNN_CALL(cudnnCreate(&cudnn_));
+  CUDNN_CALL(cudnnSetStream(cudnn_, stream));
+  CHECK_EQ(cublasCreate(&cublas_), CUBLAS_STATUS_SUCCESS);
+  CHECK_EQ(cublasSetStream(cublas_, stream), CUBLAS_STATUS_SUCCESS);
+  CHECK_EQ(cublasLtCreate(&cublas_lt_), CUBLAS_STATUS_SUCCESS);
+}
 
-float *CudnnHandle::GetWorkSpace(size_t size) {
-  if (size_ >= size) {
-    return work_space;
-  } else {
-    if (size_ > 0) {
-      CUDA_CALL(cudaFree(work_space));
+LibraryHandles::~LibraryHandles() {
+  if (workspace_) workspace_free_(workspace_);
+  cublasLtDestroy(cublas_lt_);
+  cublasDestroy(cublas_);
+  cudnnDestroy(cudnn_);
+}
+
+void *LibraryHandles::GetWorkSpace(size_t size) {
+  if (size <= workspace_size_) return workspace_;
+  // The calls on the stream using the old workspace are ordered before the later ones, so it can be freed to the
+  // allocator of the stream right away.
+  if (workspace_) workspace_free_(workspace_);
+  total_workspace_size_ -= workspace_size_;
+  {
+    auto &allocator = WorkSpaceAllocator::Global();
+    std::lock_guard<std::mutex> lock(allocator.mu);
+    if (allocator.malloc) {
+      workspace_      = allocator.malloc(size, stream_);
+      workspace_free_ = allocator.free;
+    } else {
+      CUDA_CALL(cudaMalloc(&workspace_, size));
+      workspace_free_ = [](void *data) { CUDA_CALL(cudaFree(data)); };
     }
-    CUDA_CALL(cudaMalloc(&work_space, size));
-    size_ = size;
-    return work_space;
   }
+  workspace_size_ = size;
+  total_workspace_size_ += size;
+  return workspace_;
+}
+
+namespace {
+// The extern functions run their library calls on the default stream.
+void RunOnDefaultStream(CudaLibraryCall &&call, const std::vector<cinn_pod_value_t> &args) {
+  auto &handles = LibraryHandles::Get(nullptr);
+  std::lock_guard<std::mutex> lock(handles.mutex());
+  call.Run(args, &handles);
 }
+}  // namespace
 
 void cinn_gpu_cublas_mul(const std::vector<int> &attrs,
                          cinn_buffer_t *input1,
                          cinn_buffer_t *input2,
                          cinn_buffer_t *output) {
-  cublasHandle_t &cublas = CublasHandle::get_instance().GetCublasHandle();
-  float *x_data          = reinterpret_cast<float *>(input1->memory);
-  float *y_data          = reinterpret_cast<float *>(input2->memory);
-  float *out_data        = reinterpret_cast<float *>(output->memory);
-  int M                  = 1;
-  CHECK_GE(attrs.size(), 6);
-  for (int i = 0; i < attrs[attrs.size() - 2]; i++) {
-    M *= attrs[i];
-  }
-  int N       = attrs[attrs.size() - 3];
-  int K       = attrs[attrs.size() - 4];
-  float alpha = 1.f;
-  float beta  = 0.f;
-  // M,N * N,K
-  cublasSgemm(cublas, CUBLAS_OP_N, CUBLAS_OP_N, K, M, N, &alpha, y_data, K, x_data, N, &beta, out_data, K);
+  RunOnDefaultStream(CublasMul(attrs), {cinn_pod_value_t(input1), cinn_pod_value_t(input2), cinn_pod_value_t(output)});
+}
+
+void cinn_buffer_malloc_pinned(cinn_buffer_t *buf) {
+  CHECK(buf);
+  if (buf->memory_size == 0) buf->memory_size = buf->num_elements() * buf->type.bytes();
+  void *data;
+  CUDA_CALL(cudaHostAlloc(&data, buf->memory_size, cudaHostAllocDefault));
+  buf->memory = reinterpret_cast<uint8_t *>(data);
+  buf->set_on_pinned_host(true);
+}
+
+void cinn_buffer_free_pinned(cinn_buffer_t *buf) {
+  CHECK(buf);
+  CHECK(buf->on_pinned_host()) << "The buffer is not allocated by cinn_buffer_malloc_pinned";
+  CUDA_CALL(cudaFreeHost(buf->memory));
+  buf->memory = nullptr;
+  buf->set_on_pinned_host(false);
+}
+
+namespace {
+
+cudaEvent_t CopyBufferAsync(const cinn_buffer_t *src, cinn_buffer_t *dst, cudaMemcpyKind kind, cudaStream_t stream) {
+  CHECK(src && dst);
+  CHECK_LE(src->memory_size, dst->memory_size) << "The destination buffer is smaller than the source one";
+  CUDA_CALL(cudaMemcpyAsync(dst->memory, src->memory, src->memory_size, kind, stream));
+  cudaEvent_t event;
+  CUDA_CALL(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  CUDA_CALL(cudaEventRecord(event, stream));
+  return event;
+}
+
+}  // namespace
+
+cudaEvent_t cinn_buffer_copy_to_device_async(const cinn_buffer_t *src, cinn_buffer_t *dst, cudaStream_t stream) {
+  return CopyBufferAsync(src, dst, cudaMemcpyHostToDevice, stream);
+}
+
+cudaEvent_t cinn_buffer_copy_to_host_async(const cinn_buffer_t *src, cinn_buffer_t *dst, cudaStream_t stream) {
+  return CopyBufferAsync(src, dst, cudaMemcpyDeviceToHost, stream);
+}
+
+namespace {
+thread_local int t_launch_device   = -1;
+thread_local void *t_launch_stream = nullptr;
+}  // namespace
+
+void SetThreadLaunchDevice(int device) { t_launch_device = device; }
+
+int GetThreadLaunchDevice() { return t_launch_device; }
+
+void SetThreadLaunchStream(void *stream) { t_launch_stream = stream; }
+
+void SetCurrentDevice(int device) {
+  CUDA_CALL(cudaSetDevice(device));
+  SetThreadLaunchDevice(device);
+  SetThreadLaunchStream(nullptr);
 }
 
 void cinn_call_cuda_kernel(void *kernel_fn,
@@ -93,29 +239,45 @@ void cinn_call_cuda_kernel(void *kernel_fn,
                            int block_y,
                            int block_z,
                            void *stream) {
-  // prepare void**
   VLOG(3) << "In cinn_call_cuda_kernel,\ngrid xyz is : " << grid_x << ", " << grid_y << ", " << grid_z;
   VLOG(3) << "block xyz is : " << block_x << ", " << block_y << ", " << block_z;
   VLOG(3) << "num_args is : " << num_args;
-  void *arr[20];
-  CHECK_LT(num_args, 20);
+  // the parameters are reused by the calls on the thread to save their allocations
+  thread_local KernelLaunch launch;
+  launch.function   = static_cast<CUfunction>(kernel_fn);
+  launch.grid_dims  = {grid_x, grid_y, grid_z};
+  launch.block_dims = {block_x, block_y, block_z};
+  launch.BindArgs(args, num_args);
+  launch.Launch(stream);
+}
+
+void KernelLaunch::BindArgs(cinn_pod_value_t *args, int num_args) {
+  params.resize(num_args);
   for (int i = 0; i < num_args; i++) {
     if (args[i].type_code() == ::cinn_type_code<cinn_buffer_t *>()) {
-      arr[i] = &((cinn_buffer_t *)(args[i]))->memory;  // NOLINT
+      params[i] = &((cinn_buffer_t *)(args[i]))->memory;  // NOLINT
     } else {
-      arr[i] = args[i].data_addr();
+      params[i] = args[i].data_addr();
     }
   }
-  CUDA_DRIVER_CALL(cuLaunchKernel(static_cast<CUfunction>(kernel_fn),
-                                  grid_x,
-                                  grid_y,
-                                  grid_z,
-                                  block_x,
-                                  block_y,
-                                  block_z,
+}
+
+void KernelLaunch::Launch(void *stream) const {
+  auto kernel = function;
+  if (t_launch_device >= 0) {
+    kernel = CUDAModule::FunctionOnDevice(kernel, t_launch_device);
+    stream = t_launch_stream;
+  }
+  CUDA_DRIVER_CALL(cuLaunchKernel(kernel,
+                                  grid_dims[0],
+                                  grid_dims[1],
+                                  grid_dims[2],
+                                  block_dims[0],
+                                  block_dims[1],
+                                  block_dims[2],
                                   0,  // share memory
                                   static_cast<CUstream>(stream),
-                                  reinterpret_cast<void **>(arr),
+                                  const_cast<void **>(params.data()),
                                   nullptr))
 }
 
@@ -129,10 +291,9 @@ void cinn_call_cuda_kernel(void *kernel_fn,
     LOG(FATAL) << #key_name << " is not exist in attr_map!"; \
   }
 
-void cinn_gpu_cudnn_conv2d(const absl::flat_hash_map<std::string, int> &attr,
-                           cinn_buffer_t *x,
-                           cinn_buffer_t *w,
-                           cinn_buffer_t *y) {
+namespace {
+
+Conv2dAttrs Conv2dAttrsFromMap(const absl::flat_hash_map<std::string, int> &attr) {
   GetAttrValue(attr, input_n, -1);
   GetAttrValue(attr, input_c, -1);
   GetAttrValue(attr, input_h, -1);
@@ -152,240 +313,347 @@ void cinn_gpu_cudnn_conv2d(const absl::flat_hash_map<std::string, int> &attr,
   GetAttrValue(attr, output_c, -1);
   GetAttrValue(attr, output_h, -1);
   GetAttrValue(attr, output_w, -1);
+  return Conv2dAttrs{input_n,
+                     input_c,
+                     input_h,
+                     input_w,
+                     weights_n,
+                     weights_c,
+                     weights_h,
+                     weights_w,
+                     pad_h,
+                     pad_w,
+                     stride_h,
+                     stride_w,
+                     dilation_h,
+                     dilation_w,
+                     groups,
+                     output_n,
+                     output_c,
+                     output_h,
+                     output_w};
+}
 
-  cudnnHandle_t &handle = CudnnHandle::get_instance().GetCudnnHandle();
-  float *_x             = reinterpret_cast<float *>(x->memory);
-  float *_w             = reinterpret_cast<float *>(w->memory);
-  float *_y             = reinterpret_cast<float *>(y->memory);
-
-  cudnnTensorDescriptor_t x_desc;
-  CUDNN_CALL(cudnnCreateTensorDescriptor(&x_desc));
-  CUDNN_CALL(
-      cudnnSetTensor4dDescriptor(x_desc, CUDNN_TENSOR_NCHW, CUDNN_DATA_FLOAT, input_n, input_c, input_h, input_w));
-
-  cudnnFilterDescriptor_t w_desc;
-  CUDNN_CALL(cudnnCreateFilterDescriptor(&w_desc));
-  CUDNN_CALL(cudnnSetFilter4dDescriptor(
-      w_desc, CUDNN_DATA_FLOAT, CUDNN_TENSOR_NCHW, weights_n, weights_c, weights_h, weights_w));
-
-  cudnnConvolutionDescriptor_t conv_desc;
-  CUDNN_CALL(cudnnCreateConvolutionDescriptor(&conv_desc));
-  CUDNN_CALL(cudnnSetConvolution2dDescriptor(
-      conv_desc, pad_h, pad_w, stride_h, stride_w, dilation_h, dilation_w, CUDNN_CROSS_CORRELATION, CUDNN_DATA_FLOAT));
-  CUDNN_CALL(cudnnSetConvolutionGroupCount(conv_desc, groups));
-
-  cudnnTensorDescriptor_t y_desc;
-  CUDNN_CALL(cudnnCreateTensorDescriptor(&y_desc));
-  CUDNN_CALL(
-      cudnnSetTensor4dDescriptor(y_desc, CUDNN_TENSOR_NCHW, CUDNN_DATA_FLOAT, output_n, output_c, output_h, output_w));
-
-  absl::flat_hash_map<std::string, int> &algo_map = SerialData::get_instance().GetMap();
-  std::string hash_str = "conv2d forward," + std::to_string(input_n) + "," + std::to_string(input_c) + "," +
-                         std::to_string(input_h) + "," + std::to_string(input_w) + "," + std::to_string(weights_n) +
-                         "," + std::to_string(weights_c) + "," + std::to_string(weights_h) + "," +
-                         std::to_string(weights_w) + "," + std::to_string(output_n) + "," + std::to_string(output_c) +
-                         "," + std::to_string(output_h) + "," + std::to_string(output_w);
-
-  cudnnConvolutionFwdAlgo_t algo;
-  if (algo_map.count(hash_str) != 0) {
-    algo = cudnnConvolutionFwdAlgo_t(algo_map[hash_str]);
-  } else {
-    cudnnConvolutionFwdAlgoPerf_t algo_perf;
-    int count = 0;
-    CUDNN_CALL(cudnnFindConvolutionForwardAlgorithm(handle, x_desc, w_desc, conv_desc, y_desc, 1, &count, &algo_perf));
-    algo_map[hash_str] = static_cast<int>(algo_perf.algo);
-    algo               = algo_perf.algo;
-  }
-  size_t ws_size = 0;
-  CUDNN_CALL(cudnnGetConvolutionForwardWorkspaceSize(handle, x_desc, w_desc, conv_desc, y_desc, algo, &ws_size));
-
-  float *ws_data = CudnnHandle::get_instance().GetWorkSpace(ws_size);
-
-  float alpha[] = {1.f}, beta[] = {0.f};
-
-  CUDNN_CALL(cudnnConvolutionForward(
-      handle, alpha, x_desc, _x, w_desc, _w, conv_desc, algo, ws_data, ws_size, beta, y_desc, _y));
+}  // namespace
 
-  CUDNN_CALL(cudnnDestroyTensorDescriptor(x_desc));
-  CUDNN_CALL(cudnnDestroyFilterDescriptor(w_desc));
-  CUDNN_CALL(cudnnDestroyConvolutionDescriptor(conv_desc));
-  CUDNN_CALL(cudnnDestroyTensorDescriptor(y_desc));
+void cinn_gpu_cudnn_conv2d(const absl::flat_hash_map<std::string, int> &attr,
+                           cinn_buffer_t *x,
+                           cinn_buffer_t *w,
+                           cinn_buffer_t *y) {
+  RunOnDefaultStream(CudnnConv2d(Conv2dAttrsFromMap(attr), Conv2dKind::kForward),
+                     {cinn_pod_value_t(x), cinn_pod_value_t(w), cinn_pod_value_t(y)});
 }
 
 void cinn_gpu_cudnn_conv2d_backward_data(const absl::flat_hash_map<std::string, int> &attr,
                                          cinn_buffer_t *w,
                                          cinn_buffer_t *dy,
                                          cinn_buffer_t *dx) {
-  GetAttrValue(attr, input_n, -1);
-  GetAttrValue(attr, input_c, -1);
-  GetAttrValue(attr, input_h, -1);
-  GetAttrValue(attr, input_w, -1);
-  GetAttrValue(attr, weights_n, -1);
-  GetAttrValue(attr, weights_c, -1);
-  GetAttrValue(attr, weights_h, -1);
-  GetAttrValue(attr, weights_w, -1);
-  GetAttrValue(attr, pad_h, 0);
-  GetAttrValue(attr, pad_w, 0);
-  GetAttrValue(attr, stride_h, 1);
-  GetAttrValue(attr, stride_w, 1);
-  GetAttrValue(attr, dilation_h, 1);
-  GetAttrValue(attr, dilation_w, 1);
-  GetAttrValue(attr, groups, 1);
-  GetAttrValue(attr, output_n, -1);
-  GetAttrValue(attr, output_c, -1);
-  GetAttrValue(attr, output_h, -1);
-  GetAttrValue(attr, output_w, -1);
-
-  cudnnHandle_t &handle = CudnnHandle::get_instance().GetCudnnHandle();
-  float *_w             = reinterpret_cast<float *>(w->memory);
-  float *_dy            = reinterpret_cast<float *>(dy->memory);
-  float *_dx            = reinterpret_cast<float *>(dx->memory);
-
-  cudnnTensorDescriptor_t x_desc;
-  CUDNN_CALL(cudnnCreateTensorDescriptor(&x_desc));
-  CUDNN_CALL(
-      cudnnSetTensor4dDescriptor(x_desc, CUDNN_TENSOR_NCHW, CUDNN_DATA_FLOAT, input_n, input_c, input_h, input_w));
-
-  cudnnFilterDescriptor_t w_desc;
-  CUDNN_CALL(cudnnCreateFilterDescriptor(&w_desc));
-  CUDNN_CALL(cudnnSetFilter4dDescriptor(
-      w_desc, CUDNN_DATA_FLOAT, CUDNN_TENSOR_NCHW, weights_n, weights_c, weights_h, weights_w));
-
-  cudnnConvolutionDescriptor_t conv_desc;
-  CUDNN_CALL(cudnnCreateConvolutionDescriptor(&conv_desc));
-  CUDNN_CALL(cudnnSetConvolution2dDescriptor(
-      conv_desc, pad_h, pad_w, stride_h, stride_w, dilation_h, dilation_w, CUDNN_CROSS_CORRELATION, CUDNN_DATA_FLOAT));
-  CUDNN_CALL(cudnnSetConvolutionGroupCount(conv_desc, groups));
-
-  cudnnTensorDescriptor_t y_desc;
-  CUDNN_CALL(cudnnCreateTensorDescriptor(&y_desc));
-  CUDNN_CALL(
-      cudnnSetTensor4dDescriptor(y_desc, CUDNN_TENSOR_NCHW, CUDNN_DATA_FLOAT, output_n, output_c, output_h, output_w));
-
-  absl::flat_hash_map<std::string, int> &algo_map = SerialData::get_instance().GetMap();
-  std::string hash_str = "conv2d backward data," + std::to_string(input_n) + "," + std::to_string(input_c) + "," +
-                         std::to_string(input_h) + "," + std::to_string(input_w) + "," + std::to_string(weights_n) +
-                         "," + std::to_string(weights_c) + "," + std::to_string(weights_h) + "," +
-                         std::to_string(weights_w) + "," + std::to_string(output_n) + "," + std::to_string(output_c) +
-                         "," + std::to_string(output_h) + "," + std::to_string(output_w);
-
-  cudnnConvolutionBwdDataAlgo_t algo = CUDNN_CONVOLUTION_BWD_DATA_ALGO_0;
-  if (algo_map.count(hash_str) != 0) {
-    algo = cudnnConvolutionBwdDataAlgo_t(algo_map[hash_str]);
-  } else {
-    int count = 0;
-    cudnnConvolutionBwdDataAlgoPerf_t algo_perf;
-    CUDNN_CALL(
-        cudnnFindConvolutionBackwardDataAlgorithm(handle, w_desc, y_desc, conv_desc, x_desc, 1, &count, &algo_perf));
-    algo_map[hash_str] = static_cast<int>(algo_perf.algo);
-    algo               = algo_perf.algo;
-  }
-
-  size_t ws_size = 0;
-  CUDNN_CALL(cudnnGetConvolutionBackwardDataWorkspaceSize(handle, w_desc, y_desc, conv_desc, x_desc, algo, &ws_size));
-
-  float *ws_data = CudnnHandle::get_instance().GetWorkSpace(ws_size);
-
-  float alpha[] = {1.0f}, beta[] = {0.0f};
-  CUDNN_CALL(cudnnConvolutionBackwardData(
-      handle, alpha, w_desc, _w, y_desc, _dy, conv_desc, algo, ws_data, ws_size, beta, x_desc, _dx));
-
-  CUDNN_CALL(cudnnDestroyTensorDescriptor(x_desc));
-  CUDNN_CALL(cudnnDestroyFilterDescriptor(w_desc));
-  CUDNN_CALL(cudnnDestroyConvolutionDescriptor(conv_desc));
-  CUDNN_CALL(cudnnDestroyTensorDescriptor(y_desc));
+  RunOnDefaultStream(CudnnConv2d(Conv2dAttrsFromMap(attr), Conv2dKind::kBackwardData),
+                     {cinn_pod_value_t(w), cinn_pod_value_t(dy), cinn_pod_value_t(dx)});
 }
 
 void cinn_gpu_cudnn_conv2d_backward_filter(const absl::flat_hash_map<std::string, int> &attr,
                                            cinn_buffer_t *x,
                                            cinn_buffer_t *dy,
                                            cinn_buffer_t *dw) {
-  GetAttrValue(attr, input_n, -1);
-  GetAttrValue(attr, input_c, -1);
-  GetAttrValue(attr, input_h, -1);
-  GetAttrValue(attr, input_w, -1);
-  GetAttrValue(attr, weights_n, -1);
-  GetAttrValue(attr, weights_c, -1);
-  GetAttrValue(attr, weights_h, -1);
-  GetAttrValue(attr, weights_w, -1);
-  GetAttrValue(attr, pad_h, 0);
-  GetAttrValue(attr, pad_w, 0);
-  GetAttrValue(attr, stride_h, 1);
-  GetAttrValue(attr, stride_w, 1);
-  GetAttrValue(attr, dilation_h, 1);
-  GetAttrValue(attr, dilation_w, 1);
-  GetAttrValue(attr, groups, 1);
-  GetAttrValue(attr, output_n, -1);
-  GetAttrValue(attr, output_c, -1);
-  GetAttrValue(attr, output_h, -1);
-  GetAttrValue(attr, output_w, -1);
+  RunOnDefaultStream(CudnnConv2d(Conv2dAttrsFromMap(attr), Conv2dKind::kBackwardFilter),
+                     {cinn_pod_value_t(x), cinn_pod_value_t(dy), cinn_pod_value_t(dw)});
+}
 
-  cudnnHandle_t &handle = CudnnHandle::get_instance().GetCudnnHandle();
+void cinn_gpu_cudnn_pool2d(const std::vector<int> &attrs,
+                           const std::vector<std::string> &str_attrs,
+                           cinn_buffer_t *input,
+                           cinn_buffer_t *output) {
+  RunOnDefaultStream(CudnnPool2d(attrs, str_attrs), {cinn_pod_value_t(input), cinn_pod_value_t(output)});
+}
 
-  float *_x  = reinterpret_cast<float *>(x->memory);
-  float *_dy = reinterpret_cast<float *>(dy->memory);
-  float *_dw = reinterpret_cast<float *>(dw->memory);
+void cinn_gpu_cudnn_softmax(const std::vector<int> &attrs, cinn_buffer_t *input, cinn_buffer_t *output) {
+  RunOnDefaultStream(CudnnSoftmax(attrs), {cinn_pod_value_t(input), cinn_pod_value_t(output)});
+}
 
-  cudnnTensorDescriptor_t x_desc;
-  CUDNN_CALL(cudnnCreateTensorDescriptor(&x_desc));
-  CUDNN_CALL(
-      cudnnSetTensor4dDescriptor(x_desc, CUDNN_TENSOR_NCHW, CUDNN_DATA_FLOAT, input_n, input_c, input_h, input_w));
+namespace {
+
+struct EpilogueOps {
+  bool bias{false};
+  bool residual{false};
+  bool relu{false};
+};
+
+EpilogueOps ParseEpilogue(const std::vector<std::string> &epilogue) {
+  EpilogueOps ops;
+  for (auto &op : epilogue) {
+    if (op == "bias") {
+      ops.bias = true;
+    } else if (op == "residual") {
+      ops.residual = true;
+    } else if (op == "relu") {
+      ops.relu = true;
+    } else {
+      LOG(FATAL) << "Unsupported epilogue op " << op;
+    }
+  }
+  CHECK(ops.bias) << "The epilogue of a library call starts with the bias add";
+  return ops;
+}
 
-  cudnnFilterDescriptor_t w_desc;
-  CUDNN_CALL(cudnnCreateFilterDescriptor(&w_desc));
-  CUDNN_CALL(cudnnSetFilter4dDescriptor(
-      w_desc, CUDNN_DATA_FLOAT, CUDNN_TENSOR_NCHW, weights_n, weights_c, weights_h, weights_w));
+// The fastest of the \p count algorithms found by cudnnFind*Algorithm, which is deterministic if \p deterministic.
+template <typename PerfT>
+int ChooseConvAlgo(const PerfT *perfs, int count, bool deterministic) {
+  for (int i = 0; i < count; i++) {
+    if (perfs[i].status != CUDNN_STATUS_SUCCESS) continue;
+    if (deterministic && perfs[i].determinism != CUDNN_DETERMINISTIC) continue;
+    return static_cast<int>(perfs[i].algo);
+  }
+  CHECK_GT(count, 0) << "No conv2d algorithm is found";
+  LOG(WARNING) << "No deterministic conv2d algorithm is found, use the fastest one";
+  return static_cast<int>(perfs[0].algo);
+}
 
-  cudnnConvolutionDescriptor_t conv_desc;
-  CUDNN_CALL(cudnnCreateConvolutionDescriptor(&conv_desc));
-  CUDNN_CALL(cudnnSetConvolution2dDescriptor(
-      conv_desc, pad_h, pad_w, stride_h, stride_w, dilation_h, dilation_w, CUDNN_CROSS_CORRELATION, CUDNN_DATA_FLOAT));
-  CUDNN_CALL(cudnnSetConvolutionGroupCount(conv_desc, groups));
+// Set the math mode of the cuBLAS \p handle for a call in \p mode, the handles are shared by the calls of different
+// modes.
+void SetCublasMathMode(cublasHandle_t handle, common::PrecisionMode mode) {
+  cublasMath_t math = CUBLAS_DEFAULT_MATH;
+  if (mode == common::PrecisionMode::kReduced) math = CUBLAS_TF32_TENSOR_OP_MATH;
+  if (mode == common::PrecisionMode::kStrict) math = CUBLAS_PEDANTIC_MATH;
+  CHECK_EQ(cublasSetMathMode(handle, math), CUBLAS_STATUS_SUCCESS);
+}
 
-  cudnnTensorDescriptor_t y_desc;
-  CUDNN_CALL(cudnnCreateTensorDescriptor(&y_desc));
-  CUDNN_CALL(
-      cudnnSetTensor4dDescriptor(y_desc, CUDNN_TENSOR_NCHW, CUDNN_DATA_FLOAT, output_n, output_c, output_h, output_w));
-
-  absl::flat_hash_map<std::string, int> &algo_map = SerialData::get_instance().GetMap();
-  std::string hash_str = "conv2d backward filter," + std::to_string(input_n) + "," + std::to_string(input_c) + "," +
-                         std::to_string(input_h) + "," + std::to_string(input_w) + "," + std::to_string(weights_n) +
-                         "," + std::to_string(weights_c) + "," + std::to_string(weights_h) + "," +
-                         std::to_string(weights_w) + "," + std::to_string(output_n) + "," + std::to_string(output_c) +
-                         "," + std::to_string(output_h) + "," + std::to_string(output_w);
-
-  cudnnConvolutionBwdFilterAlgo_t algo = CUDNN_CONVOLUTION_BWD_FILTER_ALGO_0;
-  if (algo_map.count(hash_str) != 0) {
-    algo = cudnnConvolutionBwdFilterAlgo_t(algo_map[hash_str]);
+// The compute type of the half gemms in \p mode, which accumulate in half in the reduced mode.
+cublasComputeType_t HalfComputeType(common::PrecisionMode mode) {
+  if (mode == common::PrecisionMode::kReduced) return CUBLAS_COMPUTE_16F;
+  if (mode == common::PrecisionMode::kStrict) return CUBLAS_COMPUTE_32F_PEDANTIC;
+  return CUBLAS_COMPUTE_32F;
+}
+
+}  // namespace
+
+CudnnConv2d::CudnnConv2d(const Conv2dAttrs &attrs, Conv2dKind kind, const std::vector<std::string> &epilogue)
+    : kind_(kind) {
+  // The algorithms are searched with the handle of the default stream.
+  auto &handles = LibraryHandles::Get(nullptr);
+  std::lock_guard<std::mutex> lock(handles.mutex());
+  cudnnHandle_t handle       = handles.cudnn();
+  cudnnTensorFormat_t format = attrs.nhwc ? CUDNN_TENSOR_NHWC : CUDNN_TENSOR_NCHW;
+  // The half convolutions still accumulate in float.
+  cudnnDataType_t data_type = attrs.fp16 ? CUDNN_DATA_HALF : CUDNN_DATA_FLOAT;
+
+  CUDNN_CALL(cudnnCreateTensorDescriptor(&x_desc_));
+  CUDNN_CALL(cudnnSetTensor4dDescriptor(
+      x_desc_, format, data_type, attrs.input_n, attrs.input_c, attrs.input_h, attrs.input_w));
+
+  CUDNN_CALL(cudnnCreateFilterDescriptor(&w_desc_));
+  CUDNN_CALL(cudnnSetFilter4dDescriptor(w_desc_,
+                                        data_type,
+                                        format,
+                                        attrs.weights_n,
+                                        attrs.weights_c,
+                                        attrs.weights_h,
+                                        attrs.weights_w));
+
+  CUDNN_CALL(cudnnCreateConvolutionDescriptor(&conv_desc_));
+  CUDNN_CALL(cudnnSetConvolution2dDescriptor(conv_desc_,
+                                             attrs.pad_h,
+                                             attrs.pad_w,
+                                             attrs.stride_h,
+                                             attrs.stride_w,
+                                             attrs.dilation_h,
+                                             attrs.dilation_w,
+                                             CUDNN_CROSS_CORRELATION,
+                                             CUDNN_DATA_FLOAT));
+  CUDNN_CALL(cudnnSetConvolutionGroupCount(conv_desc_, attrs.groups));
+  if (attrs.fp16) {
+    CUDNN_CALL(cudnnSetConvolutionMathType(conv_desc_, CUDNN_TENSOR_OP_MATH));
   } else {
-    int count = 0;
-    cudnnConvolutionBwdFilterAlgoPerf_t algo_perf;
-    CUDNN_CALL(
-        cudnnFindConvolutionBackwardFilterAlgorithm(handle, x_desc, y_desc, conv_desc, w_desc, 1, &count, &algo_perf));
-    algo_map[hash_str] = static_cast<int>(algo_perf.algo);
-    algo               = algo_perf.algo;
+#if CUDNN_VERSION >= 8000
+    // the default math allows TF32 on the devices supporting it
+    CUDNN_CALL(cudnnSetConvolutionMathType(
+        conv_desc_, attrs.precision == common::PrecisionMode::kReduced ? CUDNN_DEFAULT_MATH : CUDNN_FMA_MATH));
+#endif
   }
+  bool deterministic = attrs.precision == common::PrecisionMode::kStrict;
 
-  size_t ws_size = 0;
-  CUDNN_CALL(cudnnGetConvolutionBackwardFilterWorkspaceSize(handle, x_desc, y_desc, conv_desc, w_desc, algo, &ws_size));
+  CUDNN_CALL(cudnnCreateTensorDescriptor(&y_desc_));
+  CUDNN_CALL(cudnnSetTensor4dDescriptor(
+      y_desc_, format, data_type, attrs.output_n, attrs.output_c, attrs.output_h, attrs.output_w));
+
+  static const char *kind_names[] = {"conv2d forward", "conv2d backward data", "conv2d backward filter"};
+  std::string hash_str = std::string(kind_names[static_cast<int>(kind)]) + (attrs.nhwc ? " nhwc" : "") +
+                         (attrs.fp16 ? " fp16" : "") + " " + common::PrecisionModeName(attrs.precision);
+  for (int v : {attrs.input_n,
+                attrs.input_c,
+                attrs.input_h,
+                attrs.input_w,
+                attrs.weights_n,
+                attrs.weights_c,
+                attrs.weights_h,
+                attrs.weights_w,
+                attrs.output_n,
+                attrs.output_c,
+                attrs.output_h,
+                attrs.output_w,
+                attrs.pad_h,
+                attrs.pad_w,
+                attrs.stride_h,
+                attrs.stride_w,
+                attrs.dilation_h,
+                attrs.dilation_w,
+                attrs.groups}) {
+    hash_str += "," + std::to_string(v);
+  }
 
-  float *ws_data = ws_data = CudnnHandle::get_instance().GetWorkSpace(ws_size);
+  bool found = SerialData::get_instance().FindAlgo(hash_str, &algo_);
+  int count  = 0;
+  switch (kind_) {
+    case Conv2dKind::kForward: {
+      if (!found) {
+        cudnnConvolutionFwdAlgoPerf_t perfs[CUDNN_CONVOLUTION_FWD_ALGO_COUNT];
+        CUDNN_CALL(cudnnFindConvolutionForwardAlgorithm(
+            handle, x_desc_, w_desc_, conv_desc_, y_desc_, CUDNN_CONVOLUTION_FWD_ALGO_COUNT, &count, perfs));
+        algo_ = ChooseConvAlgo(perfs, count, deterministic);
+      }
+      CUDNN_CALL(cudnnGetConvolutionForwardWorkspaceSize(
+          handle, x_desc_, w_desc_, conv_desc_, y_desc_, cudnnConvolutionFwdAlgo_t(algo_), &ws_size_));
+      break;
+    }
+    case Conv2dKind::kBackwardData: {
+      if (!found) {
+        cudnnConvolutionBwdDataAlgoPerf_t perfs[CUDNN_CONVOLUTION_BWD_DATA_ALGO_COUNT];
+        CUDNN_CALL(cudnnFindConvolutionBackwardDataAlgorithm(
+            handle, w_desc_, y_desc_, conv_desc_, x_desc_, CUDNN_CONVOLUTION_BWD_DATA_ALGO_COUNT, &count, perfs));
+        algo_ = ChooseConvAlgo(perfs, count, deterministic);
+      }
+      CUDNN_CALL(cudnnGetConvolutionBackwardDataWorkspaceSize(
+          handle, w_desc_, y_desc_, conv_desc_, x_desc_, cudnnConvolutionBwdDataAlgo_t(algo_), &ws_size_));
+      break;
+    }
+    case Conv2dKind::kBackwardFilter: {
+      if (!found) {
+        cudnnConvolutionBwdFilterAlgoPerf_t perfs[CUDNN_CONVOLUTION_BWD_FILTER_ALGO_COUNT];
+        CUDNN_CALL(cudnnFindConvolutionBackwardFilterAlgorithm(
+            handle, x_desc_, y_desc_, conv_desc_, w_desc_, CUDNN_CONVOLUTION_BWD_FILTER_ALGO_COUNT, &count, perfs));
+        algo_ = ChooseConvAlgo(perfs, count, deterministic);
+      }
+      CUDNN_CALL(cudnnGetConvolutionBackwardFilterWorkspaceSize(
+          handle, x_desc_, y_desc_, conv_desc_, w_desc_, cudnnConvolutionBwdFilterAlgo_t(algo_), &ws_size_));
+      break;
+    }
+  }
+  if (!found) SerialData::get_instance().StoreAlgo(hash_str, algo_);
+
+  if (epilogue.empty()) return;
+  CHECK(kind_ == Conv2dKind::kForward) << "Only the forward conv2d has an epilogue";
+  auto ops       = ParseEpilogue(epilogue);
+  with_residual_ = ops.residual;
+  CUDNN_CALL(cudnnCreateTensorDescriptor(&bias_desc_));
+  CUDNN_CALL(cudnnSetTensor4dDescriptor(bias_desc_, format, data_type, 1, attrs.output_c, 1, 1));
+  CUDNN_CALL(cudnnCreateActivationDescriptor(&act_desc_));
+  CUDNN_CALL(cudnnSetActivationDescriptor(
+      act_desc_, ops.relu ? CUDNN_ACTIVATION_RELU : CUDNN_ACTIVATION_IDENTITY, CUDNN_NOT_PROPAGATE_NAN, 0.));
+  if (!ops.relu) {
+    // cudnnConvolutionBiasActivationForward only supports the identity activation with this algorithm.
+    algo_ = static_cast<int>(CUDNN_CONVOLUTION_FWD_ALGO_IMPLICIT_PRECOMP_GEMM);
+    CUDNN_CALL(cudnnGetConvolutionForwardWorkspaceSize(
+        handle, x_desc_, w_desc_, conv_desc_, y_desc_, cudnnConvolutionFwdAlgo_t(algo_), &ws_size_));
+  }
+}
+
+CudnnConv2d::~CudnnConv2d() {
+  CUDNN_CALL(cudnnDestroyTensorDescriptor(x_desc_));
+  CUDNN_CALL(cudnnDestroyFilterDescriptor(w_desc_));
+  CUDNN_CALL(cudnnDestroyConvolutionDescriptor(conv_desc_));
+  CUDNN_CALL(cudnnDestroyTensorDescriptor(y_desc_));
+  if (bias_desc_) CUDNN_CALL(cudnnDestroyTensorDescriptor(bias_desc_));
+  if (act_desc_) CUDNN_CALL(cudnnDestroyActivationDescriptor(act_desc_));
+}
 
-  float alpha[] = {1.0}, beta[] = {0.0};
-  CUDNN_CALL(cudnnConvolutionBackwardFilter(
-      handle, alpha, x_desc, _x, y_desc, _dy, conv_desc, algo, ws_data, ws_size, beta, w_desc, _dw));
+void CudnnConv2d::Run(const std::vector<cinn_pod_value_t> &args, LibraryHandles *handles) {
+  CHECK_GE(args.size(), 3);
+  cudnnHandle_t handle = handles->cudnn();
+  float *a             = reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[0])->memory);
+  float *b             = reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[1])->memory);
+  float *c             = reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[2])->memory);
+  void *ws_data        = handles->GetWorkSpace(ws_size_);
 
-  CUDNN_CALL(cudnnDestroyTensorDescriptor(x_desc));
-  CUDNN_CALL(cudnnDestroyFilterDescriptor(w_desc));
-  CUDNN_CALL(cudnnDestroyConvolutionDescriptor(conv_desc));
-  CUDNN_CALL(cudnnDestroyTensorDescriptor(y_desc));
+  float alpha[] = {1.f}, beta[] = {0.f};
+  switch (kind_) {
+    case Conv2dKind::kForward:
+      if (bias_desc_) {
+        // x, w, bias, [residual], y. Without the residual, y is passed as z and scaled by a zero alpha2.
+        CHECK_GE(args.size(), with_residual_ ? 5 : 4);
+        float *y       = reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[with_residual_ ? 4 : 3])->memory);
+        float *z       = with_residual_ ? reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[3])->memory) : y;
+        float alpha2[] = {with_residual_ ? 1.f : 0.f};
+        CUDNN_CALL(cudnnConvolutionBiasActivationForward(handle,
+                                                         alpha,
+                                                         x_desc_,
+                                                         a,
+                                                         w_desc_,
+                                                         b,
+                                                         conv_desc_,
+                                                         cudnnConvolutionFwdAlgo_t(algo_),
+                                                         ws_data,
+                                                         ws_size_,
+                                                         alpha2,
+                                                         y_desc_,
+                                                         z,
+                                                         bias_desc_,
+                                                         c,
+                                                         act_desc_,
+                                                         y_desc_,
+                                                         y));
+        break;
+      }
+      // x, w, y
+      CUDNN_CALL(cudnnConvolutionForward(handle,
+                                         alpha,
+                                         x_desc_,
+                                         a,
+                                         w_desc_,
+                                         b,
+                                         conv_desc_,
+                                         cudnnConvolutionFwdAlgo_t(algo_),
+                                         ws_data,
+                                         ws_size_,
+                                         beta,
+                                         y_desc_,
+                                         c));
+      break;
+    case Conv2dKind::kBackwardData:
+      // w, dy, dx
+      CUDNN_CALL(cudnnConvolutionBackwardData(handle,
+                                              alpha,
+                                              w_desc_,
+                                              a,
+                                              y_desc_,
+                                              b,
+                                              conv_desc_,
+                                              cudnnConvolutionBwdDataAlgo_t(algo_),
+                                              ws_data,
+                                              ws_size_,
+                                              beta,
+                                              x_desc_,
+                                              c));
+      break;
+    case Conv2dKind::kBackwardFilter:
+      // x, dy, dw
+      CUDNN_CALL(cudnnConvolutionBackwardFilter(handle,
+                                                alpha,
+                                                x_desc_,
+                                                a,
+                                                y_desc_,
+                                                b,
+                                                conv_desc_,
+                                                cudnnConvolutionBwdFilterAlgo_t(algo_),
+                                                ws_data,
+                                                ws_size_,
+                                                beta,
+                                                w_desc_,
+                                                c));
+      break;
+  }
 }
 
-void cinn_gpu_cudnn_pool2d(const std::vector<int> &attrs,
-                           const std::vector<std::string> &str_attrs,
-                           cinn_buffer_t *input,
-                           cinn_buffer_t *output) {
-  cudnnHandle_t &cudnn = CudnnHandle::get_instance().GetCudnnHandle();
+CudnnPool2d::CudnnPool2d(const std::vector<int> &attrs, const std::vector<std::string> &str_attrs) {
   CHECK_EQ(attrs.size(), 17);
   // Here the input paddings are pad_top, pad_bottom, pad_left, pad_right.
   // Since pad_top==pad_bottom and pad_left==pad_rifht, we only take pad_top and pad_left.
@@ -405,8 +673,8 @@ void cinn_gpu_cudnn_pool2d(const std::vector<int> &attrs,
   int output_w          = attrs[15];
   int adaptive          = attrs[16];
   std::string pool_type = str_attrs[0];
-  cudnnPoolingDescriptor_t pooling_desc;
-  CUDNN_CALL(cudnnCreatePoolingDescriptor(&pooling_desc));
+  auto format           = str_attrs.size() > 1 && str_attrs[1] == "NHWC" ? CUDNN_TENSOR_NHWC : CUDNN_TENSOR_NCHW;
+  CUDNN_CALL(cudnnCreatePoolingDescriptor(&pooling_desc_));
   cudnnPoolingMode_t pool_mode;
   if (pool_type == "max") {
     pool_mode = CUDNN_POOLING_MAX;
@@ -423,36 +691,34 @@ void cinn_gpu_cudnn_pool2d(const std::vector<int> &attrs,
   }
 
   CUDNN_CALL(cudnnSetPooling2dDescriptor(
-      pooling_desc, pool_mode, CUDNN_NOT_PROPAGATE_NAN, kernel_h, kernel_w, pad_h, pad_w, stride_h, stride_w));
-
-  cudnnTensorDescriptor_t in_desc;
-
-  CUDNN_CALL(cudnnCreateTensorDescriptor(&in_desc));
+      pooling_desc_, pool_mode, CUDNN_NOT_PROPAGATE_NAN, kernel_h, kernel_w, pad_h, pad_w, stride_h, stride_w));
 
+  CUDNN_CALL(cudnnCreateTensorDescriptor(&in_desc_));
   CUDNN_CALL(
-      cudnnSetTensor4dDescriptor(in_desc, CUDNN_TENSOR_NCHW, CUDNN_DATA_FLOAT, input_n, input_c, input_h, input_w));
+      cudnnSetTensor4dDescriptor(in_desc_, format, CUDNN_DATA_FLOAT, input_n, input_c, input_h, input_w));
 
-  cudnnTensorDescriptor_t out_desc;
-
-  CUDNN_CALL(cudnnCreateTensorDescriptor(&out_desc));
-
-  CUDNN_CALL(cudnnSetTensor4dDescriptor(
-      out_desc, CUDNN_TENSOR_NCHW, CUDNN_DATA_FLOAT, output_n, output_c, output_h, output_w));
-
-  float alpha = 1.0f;
-  float beta  = 0.0f;
-
-  float *in_data  = reinterpret_cast<float *>(input->memory);
-  float *out_data = reinterpret_cast<float *>(output->memory);
+  CUDNN_CALL(cudnnCreateTensorDescriptor(&out_desc_));
+  CUDNN_CALL(
+      cudnnSetTensor4dDescriptor(out_desc_, format, CUDNN_DATA_FLOAT, output_n, output_c, output_h, output_w));
+}
 
-  CUDNN_CALL(cudnnPoolingForward(cudnn, pooling_desc, &alpha, in_desc, in_data, &beta, out_desc, out_data));
+CudnnPool2d::~CudnnPool2d() {
+  cudnnDestroyTensorDescriptor(in_desc_);
+  cudnnDestroyTensorDescriptor(out_desc_);
+  cudnnDestroyPoolingDescriptor(pooling_desc_);
+}
 
-  cudnnDestroyTensorDescriptor(in_desc);
-  cudnnDestroyTensorDescriptor(out_desc);
-  cudnnDestroyPoolingDescriptor(pooling_desc);
+void CudnnPool2d::Run(const std::vector<cinn_pod_value_t> &args, LibraryHandles *handles) {
+  CHECK_GE(args.size(), 2);
+  cudnnHandle_t cudnn  = handles->cudnn();
+  float *in_data       = reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[0])->memory);
+  float *out_data      = reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[1])->memory);
+  float alpha          = 1.0f;
+  float beta           = 0.0f;
+  CUDNN_CALL(cudnnPoolingForward(cudnn, pooling_desc_, &alpha, in_desc_, in_data, &beta, out_desc_, out_data));
 }
 
-void cinn_gpu_cudnn_softmax(const std::vector<int> &attrs, cinn_buffer_t *input, cinn_buffer_t *output) {
+CudnnSoftmax::CudnnSoftmax(const std::vector<int> &attrs) {
   std::vector<int> shape;
   int rank = attrs.size() - 1;
   for (int i = 0; i < rank; i++) {
@@ -468,30 +734,233 @@ void cinn_gpu_cudnn_softmax(const std::vector<int> &attrs, cinn_buffer_t *input,
     else if (i > axis)
       inner_num *= shape[i];
   }
-  rank = shape.size();
-
-  cudnnHandle_t &cudnn = CudnnHandle::get_instance().GetCudnnHandle();
-  float *in_data       = reinterpret_cast<float *>(input->memory);
-  float *out_data      = reinterpret_cast<float *>(output->memory);
 
-  cudnnTensorDescriptor_t in_desc;
-  CUDNN_CALL(cudnnCreateTensorDescriptor(&in_desc));
+  CUDNN_CALL(cudnnCreateTensorDescriptor(&in_desc_));
   CUDNN_CALL(
-      cudnnSetTensor4dDescriptor(in_desc, CUDNN_TENSOR_NCHW, CUDNN_DATA_FLOAT, outer_num, shape[axis], inner_num, 1));
+      cudnnSetTensor4dDescriptor(in_desc_, CUDNN_TENSOR_NCHW, CUDNN_DATA_FLOAT, outer_num, shape[axis], inner_num, 1));
 
-  cudnnTensorDescriptor_t out_desc;
-  CUDNN_CALL(cudnnCreateTensorDescriptor(&out_desc));
+  CUDNN_CALL(cudnnCreateTensorDescriptor(&out_desc_));
   CUDNN_CALL(
-      cudnnSetTensor4dDescriptor(out_desc, CUDNN_TENSOR_NCHW, CUDNN_DATA_FLOAT, outer_num, shape[axis], inner_num, 1));
+      cudnnSetTensor4dDescriptor(out_desc_, CUDNN_TENSOR_NCHW, CUDNN_DATA_FLOAT, outer_num, shape[axis], inner_num, 1));
+}
 
-  float alpha = 1.f;
-  float beta  = 0.f;
+CudnnSoftmax::~CudnnSoftmax() {
+  cudnnDestroyTensorDescriptor(in_desc_);
+  cudnnDestroyTensorDescriptor(out_desc_);
+}
+
+void CudnnSoftmax::Run(const std::vector<cinn_pod_value_t> &args, LibraryHandles *handles) {
+  CHECK_GE(args.size(), 2);
+  cudnnHandle_t cudnn  = handles->cudnn();
+  float *in_data       = reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[0])->memory);
+  float *out_data      = reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[1])->memory);
+  float alpha          = 1.f;
+  float beta           = 0.f;
+  CUDNN_CALL(cudnnSoftmaxForward(cudnn,
+                                 CUDNN_SOFTMAX_ACCURATE,
+                                 CUDNN_SOFTMAX_MODE_CHANNEL,
+                                 &alpha,
+                                 in_desc_,
+                                 in_data,
+                                 &beta,
+                                 out_desc_,
+                                 out_data));
+}
 
-  CUDNN_CALL(cudnnSoftmaxForward(
-      cudnn, CUDNN_SOFTMAX_ACCURATE, CUDNN_SOFTMAX_MODE_CHANNEL, &alpha, in_desc, in_data, &beta, out_desc, out_data));
+CublasMul::CublasMul(const std::vector<int> &attrs, bool fp16, common::PrecisionMode mode) : fp16_(fp16), mode_(mode) {
+  CHECK_GE(attrs.size(), 6);
+  for (int i = 0; i < attrs[attrs.size() - 2]; i++) {
+    M_ *= attrs[i];
+  }
+  N_ = attrs[attrs.size() - 3];
+  K_ = attrs[attrs.size() - 4];
+}
 
-  cudnnDestroyTensorDescriptor(in_desc);
-  cudnnDestroyTensorDescriptor(out_desc);
+void CublasMul::Run(const std::vector<cinn_pod_value_t> &args, LibraryHandles *handles) {
+  CHECK_GE(args.size(), 3);
+  cublasHandle_t cublas  = handles->cublas();
+  float *x_data          = reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[0])->memory);
+  float *y_data          = reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[1])->memory);
+  float *out_data        = reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[2])->memory);
+  float alpha            = 1.f;
+  float beta             = 0.f;
+  SetCublasMathMode(cublas, mode_);
+  // M,N * N,K
+  if (fp16_) {
+    // in half with the float accumulation, or the half one whose scalars are half too
+    cublasComputeType_t compute = HalfComputeType(mode_);
+    __half half_alpha           = __float2half(alpha), half_beta = __float2half(beta);
+    bool half_scalars           = compute == CUBLAS_COMPUTE_16F;
+    CHECK_EQ(cublasGemmEx(cublas,
+                          CUBLAS_OP_N,
+                          CUBLAS_OP_N,
+                          K_,
+                          M_,
+                          N_,
+                          half_scalars ? static_cast<void *>(&half_alpha) : &alpha,
+                          y_data,
+                          CUDA_R_16F,
+                          K_,
+                          x_data,
+                          CUDA_R_16F,
+                          N_,
+                          half_scalars ? static_cast<void *>(&half_beta) : &beta,
+                          out_data,
+                          CUDA_R_16F,
+                          K_,
+                          compute,
+                          CUBLAS_GEMM_DEFAULT_TENSOR_OP),
+             CUBLAS_STATUS_SUCCESS);
+    return;
+  }
+  cublasSgemm(cublas, CUBLAS_OP_N, CUBLAS_OP_N, K_, M_, N_, &alpha, y_data, K_, x_data, N_, &beta, out_data, K_);
+}
+
+CublasLtMul::CublasLtMul(const std::vector<int> &attrs,
+                         const std::vector<std::string> &epilogue,
+                         bool fp16,
+                         common::PrecisionMode mode)
+    : CublasMul(attrs, fp16, mode) {
+  auto ops                    = ParseEpilogue(epilogue);
+  with_residual_              = ops.residual;
+  cublasComputeType_t compute = CUBLAS_COMPUTE_32F;
+  if (mode_ == common::PrecisionMode::kStrict) compute = CUBLAS_COMPUTE_32F_PEDANTIC;
+  if (mode_ == common::PrecisionMode::kReduced && !fp16_) compute = CUBLAS_COMPUTE_32F_FAST_TF32;
+  CHECK_EQ(cublasLtMatmulDescCreate(&matmul_desc_, compute, CUDA_R_32F), CUBLAS_STATUS_SUCCESS);
+  cublasLtEpilogue_t lt_epilogue = ops.relu ? CUBLASLT_EPILOGUE_RELU_BIAS : CUBLASLT_EPILOGUE_BIAS;
+  CHECK_EQ(cublasLtMatmulDescSetAttribute(
+               matmul_desc_, CUBLASLT_MATMUL_DESC_EPILOGUE, &lt_epilogue, sizeof(lt_epilogue)),
+           CUBLAS_STATUS_SUCCESS);
+  // The row-major out[M, K] = x[M, N] * y[N, K] is computed as the column-major out[K, M] = y[K, N] * x[N, M], whose
+  // bias is added along the rows, i.e. the last axis of the row-major output.
+  // The bias is of the output type, the half matrices are multiplied with the float accumulation as well.
+  cudaDataType_t data_type = fp16_ ? CUDA_R_16F : CUDA_R_32F;
+  CHECK_EQ(cublasLtMatrixLayoutCreate(&y_desc_, data_type, K_, N_, K_), CUBLAS_STATUS_SUCCESS);
+  CHECK_EQ(cublasLtMatrixLayoutCreate(&x_desc_, data_type, N_, M_, N_), CUBLAS_STATUS_SUCCESS);
+  CHECK_EQ(cublasLtMatrixLayoutCreate(&out_desc_, data_type, K_, M_, K_), CUBLAS_STATUS_SUCCESS);
+}
+
+CublasLtMul::~CublasLtMul() {
+  cublasLtMatrixLayoutDestroy(out_desc_);
+  cublasLtMatrixLayoutDestroy(x_desc_);
+  cublasLtMatrixLayoutDestroy(y_desc_);
+  cublasLtMatmulDescDestroy(matmul_desc_);
+}
+
+void CublasLtMul::Run(const std::vector<cinn_pod_value_t> &args, LibraryHandles *handles) {
+  CHECK_GE(args.size(), with_residual_ ? 5 : 4);
+  auto get_data   = [&](int i) { return reinterpret_cast<float *>(static_cast<cinn_buffer_t *>(args[i])->memory); };
+  float *x_data   = get_data(0);
+  float *y_data   = get_data(1);
+  float *bias     = get_data(2);
+  float *out_data = get_data(with_residual_ ? 4 : 3);
+  // C is the residual, or the output scaled by a zero beta.
+  float *c_data = with_residual_ ? get_data(3) : out_data;
+  float alpha   = 1.f;
+  float beta    = with_residual_ ? 1.f : 0.f;
+  CHECK_EQ(cublasLtMatmulDescSetAttribute(matmul_desc_, CUBLASLT_MATMUL_DESC_BIAS_POINTER, &bias, sizeof(bias)),
+           CUBLAS_STATUS_SUCCESS);
+  void *workspace = handles->GetWorkSpace(kWorkSpaceSize);
+  // cublasLt takes the stream per call.
+  CHECK_EQ(cublasLtMatmul(handles->cublas_lt(),
+                          matmul_desc_,
+                          &alpha,
+                          y_data,
+                          y_desc_,
+                          x_data,
+                          x_desc_,
+                          &beta,
+                          c_data,
+                          out_desc_,
+                          out_data,
+                          out_desc_,
+                          nullptr,
+                          workspace,
+                          kWorkSpaceSize,
+                          handles->stream()),
+           CUBLAS_STATUS_SUCCESS);
+}
+
+CublasMatmul::CublasMatmul(const std::vector<int> &attrs, float alpha, bool fp16, common::PrecisionMode mode)
+    : alpha_(alpha), fp16_(fp16), mode_(mode) {
+  CHECK_EQ(attrs.size(), 7UL);
+  batch_a_ = attrs[0];
+  batch_b_ = attrs[1];
+  M_       = attrs[2];
+  N_       = attrs[3];
+  K_       = attrs[4];
+  trans_a_ = attrs[5];
+  trans_b_ = attrs[6];
+  CHECK(batch_a_ == batch_b_ || batch_a_ == 1 || batch_b_ == 1)
+      << "The batches " << batch_a_ << " and " << batch_b_ << " of matmul can not be broadcast";
+}
+
+void CublasMatmul::Run(const std::vector<cinn_pod_value_t> &args, LibraryHandles *handles) {
+  CHECK_GE(args.size(), 3);
+  void *x_data = static_cast<cinn_buffer_t *>(args[0])->memory;
+  void *y_data = static_cast<cinn_buffer_t *>(args[1])->memory;
+  void *out    = static_cast<cinn_buffer_t *>(args[2])->memory;
+  float beta   = 0.f;
+  // The row-major out[M, N] = op(x) * op(y) is computed as the column-major out[N, M] = op(y)^T * op(x)^T, where the
+  // row-major matrices are read as their column-major transposes.
+  cublasOperation_t op_x = trans_a_ ? CUBLAS_OP_T : CUBLAS_OP_N;
+  cublasOperation_t op_y = trans_b_ ? CUBLAS_OP_T : CUBLAS_OP_N;
+  int ld_x               = trans_a_ ? M_ : K_;
+  int ld_y               = trans_b_ ? K_ : N_;
+  long long stride_x     = batch_a_ == 1 ? 0 : static_cast<long long>(M_) * K_;  // NOLINT
+  long long stride_y     = batch_b_ == 1 ? 0 : static_cast<long long>(K_) * N_;  // NOLINT
+  long long stride_out   = static_cast<long long>(M_) * N_;                      // NOLINT
+  int batch              = std::max(batch_a_, batch_b_);
+  SetCublasMathMode(handles->cublas(), mode_);
+  if (fp16_) {
+    cublasComputeType_t compute = HalfComputeType(mode_);
+    __half half_alpha           = __float2half(alpha_), half_beta = __float2half(beta);
+    bool half_scalars           = compute == CUBLAS_COMPUTE_16F;
+    CHECK_EQ(cublasGemmStridedBatchedEx(handles->cublas(),
+                                        op_y,
+                                        op_x,
+                                        N_,
+                                        M_,
+                                        K_,
+                                        half_scalars ? static_cast<void *>(&half_alpha) : &alpha_,
+                                        y_data,
+                                        CUDA_R_16F,
+                                        ld_y,
+                                        stride_y,
+                                        x_data,
+                                        CUDA_R_16F,
+                                        ld_x,
+                                        stride_x,
+                                        half_scalars ? static_cast<void *>(&half_beta) : &beta,
+                                        out,
+                                        CUDA_R_16F,
+                                        N_,
+                                        stride_out,
+                                        batch,
+                                        compute,
+                                        CUBLAS_GEMM_DEFAULT_TENSOR_OP),
+             CUBLAS_STATUS_SUCCESS);
+    return;
+  }
+  CHECK_EQ(cublasSgemmStridedBatched(handles->cublas(),
+                                     op_y,
+                                     op_x,
+                                     N_,
+                                     M_,
+                                     K_,
+                                     &alpha_,
+                                     static_cast<float *>(y_data),
+                                     ld_y,
+                                     stride_y,
+                                     static_cast<float *>(x_data),
+                                     ld_x,
+                                     stride_x,
+                                     &beta,
+                                     static_cast<float *>(out),
+                                     N_,
+                                     stride_out,
+                                     batch),
+           CUBLAS_STATUS_SUCCESS);
 }
 
 }  // namespace cuda
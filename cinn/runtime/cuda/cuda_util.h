@@ -15,12 +15,21 @@
 #pragma once
 
 #include <absl/container/flat_hash_map.h>
+#include <cublasLt.h>
 #include <cublas_v2.h>
+#include <cuda.h>
+#include <cuda_runtime.h>
 #include <cudnn.h>
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>  // NOLINT
 #include <string>
 #include <vector>
 
+#include "cinn/backends/algo_cache.h"
+#include "cinn/common/precision.h"
 #include "cinn/runtime/cinn_runtime.h"
 
 namespace cinn {
@@ -28,22 +37,6 @@ namespace runtime {
 namespace cuda {
 
 const int kCUDAMaxCards{10};
-class CublasHandle {
- public:
-  ~CublasHandle();
-  CublasHandle(const CublasHandle&) = delete;
-  CublasHandle& operator=(const CublasHandle&) = delete;
-  static CublasHandle& get_instance() {
-    static CublasHandle instance;
-    return instance;
-  }
-  cublasHandle_t& GetCublasHandle() { return cublas; }
-
- private:
-  CublasHandle();
-  cublasHandle_t cublas;
-};
-
 class SerialData {
  public:
   ~SerialData();
@@ -53,30 +46,111 @@ class SerialData {
     static SerialData instance;
     return instance;
   }
-  absl::flat_hash_map<std::string, int>& GetMap() { return get_algo; }
+
+  /**
+   * Get the algorithm chosen for the convolution \p key on the current device to \p algo, return false if none. The
+   * choices are also persisted in the compilation cache(FLAGS_cinn_compilation_cache_dir) by backends::AlgoCache if
+   * it is enabled, so that the processes sharing it skip the search. It is thread-safe.
+   */
+  bool FindAlgo(const std::string& key, int* algo);
+  void StoreAlgo(const std::string& key, int algo);
 
  private:
   SerialData();
-  absl::flat_hash_map<std::string, int> get_algo;
+  // The device and the cuDNN version the algorithms of the current device are chosen for.
+  std::vector<std::string> Context();
+
+  backends::AlgoCache algos_;
+  std::array<std::vector<std::string>, kCUDAMaxCards> contexts_;
+  std::mutex mu_;
 };
 
-class CudnnHandle {
+/**
+ * The cuDNN and cuBLAS handles bound to a stream of a device, with the workspace the library calls on the stream
+ * share. Each stream has its own handles, so the library calls on different streams run concurrently, and the calls
+ * on one stream are ordered by it, so they can share the workspace.
+ */
+class LibraryHandles {
  public:
-  ~CudnnHandle();
-  CudnnHandle(const CudnnHandle&) = delete;
-  CudnnHandle& operator=(const CudnnHandle&) = delete;
-  static CudnnHandle& get_instance() {
-    static CudnnHandle instance;
-    return instance;
-  }
-  cudnnHandle_t& GetCudnnHandle() { return cudnn; }
-  float* GetWorkSpace(size_t size);
+  //! Allocate \p nbytes of device memory used on \p stream.
+  using malloc_t = std::function<void*(size_t nbytes, cudaStream_t stream)>;
+  using free_t   = std::function<void(void*)>;
+
+  /**
+   * Get the handles of the current device bound to \p stream, they are created on the first use. It is thread-safe,
+   * while the handles should be used under mutex() if the stream is shared by several threads.
+   */
+  static LibraryHandles& Get(cudaStream_t stream);
+
+  /**
+   * Let the workspaces allocated later be allocated by \p malloc and freed by \p free, e.g. by the caching
+   * allocator, instead of cudaMalloc and cudaFree.
+   */
+  static void SetWorkSpaceAllocator(malloc_t malloc, free_t free);
+
+  //! The number of bytes of the workspaces of all the streams.
+  static size_t TotalWorkSpaceSize() { return total_workspace_size_; }
+
+  /**
+   * Free the workspaces of all the streams, e.g. while the programs are idle, the later library calls allocate them
+   * again. It waits for the library calls running under mutex().
+   */
+  static void ReleaseWorkSpaces();
+
+  //! The number of ReleaseWorkSpaces freeing any workspace, the CUDA graphs captured before a change refer to the
+  //! workspaces freed, and should be captured again.
+  static uint64_t WorkSpaceGeneration() { return workspace_generation_; }
+
+  ~LibraryHandles();
+  LibraryHandles(const LibraryHandles&) = delete;
+  LibraryHandles& operator=(const LibraryHandles&) = delete;
+
+  cudnnHandle_t cudnn() const { return cudnn_; }
+  cublasHandle_t cublas() const { return cublas_; }
+  cublasLtHandle_t cublas_lt() const { return cublas_lt_; }
+  cudaStream_t stream() const { return stream_; }
+  std::mutex& mutex() { return mu_; }
+
+  //! Get the workspace of at least \p size bytes, it only grows, so reserving the maximum size ahead avoids the
+  //! reallocation in running.
+  void* GetWorkSpace(size_t size);
+  size_t workspace_size() const { return workspace_size_; }
 
  private:
-  CudnnHandle();
-  cudnnHandle_t cudnn;
-  float* work_space;
-  size_t size_;
+  LibraryHandles(int device, cudaStream_t stream);
+
+  int device_;
+  cudaStream_t stream_;
+  cudnnHandle_t cudnn_;
+  cublasHandle_t cublas_;
+  cublasLtHandle_t cublas_lt_;
+  void* workspace_{};
+  size_t workspace_size_{};
+  // The workspace is freed by the allocator it is allocated by.
+  free_t workspace_free_;
+  std::mutex mu_;
+
+  static std::atomic<size_t> total_workspace_size_;
+  static std::atomic<uint64_t> workspace_generation_;
+};
+
+/**
+ * A launch of a CUDA kernel resolved once, instead of by the type codes of the arguments in each call like
+ * cinn_call_cuda_kernel. Each parameter points at a stable slot of its argument, the memory field of a buffer or the
+ * value of a scalar, so a launch passes their current values without any dispatch, and the kernel may take any number
+ * of arguments.
+ */
+struct KernelLaunch {
+  CUfunction function{};
+  std::array<int, 3> grid_dims{1, 1, 1};
+  std::array<int, 3> block_dims{1, 1, 1};
+  std::vector<void*> params;
+
+  //! Point the parameters at the slots of \p args, which should stay in place as long as the launch runs with them.
+  void BindArgs(cinn_pod_value_t* args, int num_args);
+
+  //! Launch the kernel on \p stream, or on the launch device and stream of the calling thread if set.
+  void Launch(void* stream) const;
 };
 
 /**
@@ -96,6 +170,38 @@ void cinn_call_cuda_kernel(void* kernel_fn,
                            int block_z,
                            void* stream);
 
+/**
+ * Let the kernels launched by cinn_call_cuda_kernel on the calling thread run on \p device instead of the device they
+ * are loaded on(device 0), so that the replicas of a program on several devices share its compiled host functions.
+ * While it is set, the kernels are launched on the stream set by SetThreadLaunchStream instead of the one the host
+ * functions pass, since the latter is held globally. \p device is -1 to reset.
+ */
+void SetThreadLaunchDevice(int device);
+//! The device set by SetThreadLaunchDevice on the calling thread, -1 if not set.
+int GetThreadLaunchDevice();
+//! Set the stream the kernels launched on the calling thread run on, it only takes effect with a launch device.
+void SetThreadLaunchStream(void* stream);
+//! Let the calling thread allocate the memory and launch the kernels on \p device, on its default stream.
+void SetCurrentDevice(int device);
+
+/**
+ * Allocate page-locked host memory of \p buf->memory_size bytes(or the size of its elements if not set) and mark the
+ * buffer on_pinned_host, so that it can be copied to or from the device asynchronously.
+ */
+void cinn_buffer_malloc_pinned(cinn_buffer_t* buf);
+
+//! Free the page-locked host memory allocated by cinn_buffer_malloc_pinned.
+void cinn_buffer_free_pinned(cinn_buffer_t* buf);
+
+/**
+ * The asynchronous variants of cinn_buffer_copy_to_device and cinn_buffer_copy_to_host, which copy the memory of
+ * \p src to \p dst on \p stream and return an event recorded after the copy. The copy only overlaps with the work on
+ * the other streams when the host buffer is pinned, and the host buffer should not be touched until the event
+ * completes. The caller owns the event and should destroy it by cudaEventDestroy.
+ */
+cudaEvent_t cinn_buffer_copy_to_device_async(const cinn_buffer_t* src, cinn_buffer_t* dst, cudaStream_t stream);
+cudaEvent_t cinn_buffer_copy_to_host_async(const cinn_buffer_t* src, cinn_buffer_t* dst, cudaStream_t stream);
+
 void cinn_gpu_cudnn_conv2d(const absl::flat_hash_map<std::string, int>& attr,
                            cinn_buffer_t* x,
                            cinn_buffer_t* w,
@@ -122,6 +228,182 @@ void cinn_gpu_cublas_mul(const std::vector<int>& attrs,
                          cinn_buffer_t* input1,
                          cinn_buffer_t* input2,
                          cinn_buffer_t* output);
+
+/**
+ * The attributes of a 2-D convolution, the input, weights and output are all in NCHW layout.
+ */
+struct Conv2dAttrs {
+  int input_n{}, input_c{}, input_h{}, input_w{};
+  int weights_n{}, weights_c{}, weights_h{}, weights_w{};
+  int pad_h{0}, pad_w{0};
+  int stride_h{1}, stride_w{1};
+  int dilation_h{1}, dilation_w{1};
+  int groups{1};
+  int output_n{}, output_c{}, output_h{}, output_w{};
+  // The tensors are NHWC and the filter is OHWI, the sizes above are still in the NCHW order.
+  bool nhwc{false};
+  // The tensors are all half.
+  bool fp16{false};
+  // The float convs use TF32 in the reduced mode, and only the deterministic algorithms are chosen in the strict one.
+  common::PrecisionMode precision{common::PrecisionMode::kFast};
+};
+
+enum class Conv2dKind { kForward, kBackwardData, kBackwardFilter };
+
+/**
+ * A call to cuDNN or cuBLAS, whose descriptors and configurations are built once from the op attributes and reused
+ * in each run, to keep the attribute parsing and descriptor creation off the execution path.
+ */
+class CudaLibraryCall {
+ public:
+  virtual ~CudaLibraryCall() = default;
+
+  //! Run with the arguments of an instruction, the inputs are followed by the outputs, by the \p handles.
+  virtual void Run(const std::vector<cinn_pod_value_t>& args, LibraryHandles* handles) = 0;
+
+  //! The number of bytes of the workspace it needs.
+  virtual size_t workspace_size() const { return 0; }
+};
+
+class CudnnConv2d : public CudaLibraryCall {
+ public:
+  /**
+   * @param epilogue The ops the forward convolution applies to its result in order, "bias" first and then "residual"
+   * or "relu", which run by cudnnConvolutionBiasActivationForward.
+   */
+  CudnnConv2d(const Conv2dAttrs& attrs, Conv2dKind kind, const std::vector<std::string>& epilogue = {});
+  ~CudnnConv2d();
+
+  //! The arguments are (x, w, y) for forward, (w, dy, dx) for backward data and (x, dy, dw) for backward filter.
+  //! With an epilogue the forward ones are (x, w, bias, y), or (x, w, bias, residual, y) with the residual add.
+  void Run(const std::vector<cinn_pod_value_t>& args, LibraryHandles* handles) override;
+
+  size_t workspace_size() const override { return ws_size_; }
+
+ private:
+  Conv2dKind kind_;
+  cudnnTensorDescriptor_t x_desc_;
+  cudnnFilterDescriptor_t w_desc_;
+  cudnnConvolutionDescriptor_t conv_desc_;
+  cudnnTensorDescriptor_t y_desc_;
+  // Only created with an epilogue.
+  cudnnTensorDescriptor_t bias_desc_{nullptr};
+  cudnnActivationDescriptor_t act_desc_{nullptr};
+  bool with_residual_{false};
+  // The algorithm of the kind, cast to the corresponding cudnnConvolution*Algo_t.
+  int algo_{};
+  size_t ws_size_{};
+};
+
+class CudnnPool2d : public CudaLibraryCall {
+ public:
+  //! The str_attrs are the pool type, optionally followed by the data format "NCHW" or "NHWC".
+  CudnnPool2d(const std::vector<int>& attrs, const std::vector<std::string>& str_attrs);
+  ~CudnnPool2d();
+
+  //! The arguments are (input, output).
+  void Run(const std::vector<cinn_pod_value_t>& args, LibraryHandles* handles) override;
+
+ private:
+  cudnnPoolingDescriptor_t pooling_desc_;
+  cudnnTensorDescriptor_t in_desc_;
+  cudnnTensorDescriptor_t out_desc_;
+};
+
+class CudnnSoftmax : public CudaLibraryCall {
+ public:
+  explicit CudnnSoftmax(const std::vector<int>& attrs);
+  ~CudnnSoftmax();
+
+  //! The arguments are (input, output).
+  void Run(const std::vector<cinn_pod_value_t>& args, LibraryHandles* handles) override;
+
+ private:
+  cudnnTensorDescriptor_t in_desc_;
+  cudnnTensorDescriptor_t out_desc_;
+};
+
+/**
+ * The cuBLAS calls follow the precision mode of the program: the float ones use TF32 and the half ones accumulate in
+ * half in the reduced mode, and the strict mode uses the pedantic math, i.e. no reduced precision anywhere.
+ */
+class CublasMul : public CudaLibraryCall {
+ public:
+  //! @param fp16 Whether the matrices are all half.
+  explicit CublasMul(const std::vector<int>& attrs,
+                     bool fp16                  = false,
+                     common::PrecisionMode mode = common::PrecisionMode::kFast);
+
+  //! The arguments are (x, y, out).
+  void Run(const std::vector<cinn_pod_value_t>& args, LibraryHandles* handles) override;
+
+ protected:
+  int M_{1};
+  int N_{};
+  int K_{};
+  bool fp16_{false};
+  common::PrecisionMode mode_{common::PrecisionMode::kFast};
+};
+
+/**
+ * A mul whose bias add, residual add and relu run as the epilogue of cublasLtMatmul. The bias is added along the
+ * last axis of the 2-D output.
+ */
+class CublasLtMul : public CublasMul {
+ public:
+  //! @param epilogue The ops applied to the product in order, "bias" first and then "residual" or "relu".
+  //! The half ones still accumulate in float in the reduced mode, as the bias is added in the scale type.
+  CublasLtMul(const std::vector<int>& attrs,
+              const std::vector<std::string>& epilogue,
+              bool fp16                  = false,
+              common::PrecisionMode mode = common::PrecisionMode::kFast);
+  ~CublasLtMul();
+
+  //! The arguments are (x, y, bias, out), or (x, y, bias, residual, out) with the residual add.
+  void Run(const std::vector<cinn_pod_value_t>& args, LibraryHandles* handles) override;
+
+  //! The workspace lets cublasLt choose the algorithms split along the reduction.
+  size_t workspace_size() const override { return kWorkSpaceSize; }
+  static constexpr size_t kWorkSpaceSize = 4 << 20;
+
+ private:
+  bool with_residual_{false};
+  cublasLtMatmulDesc_t matmul_desc_;
+  cublasLtMatrixLayout_t x_desc_;
+  cublasLtMatrixLayout_t y_desc_;
+  cublasLtMatrixLayout_t out_desc_;
+};
+
+/**
+ * A (batched) matmul of the row-major x[batch, M, K] and y[batch, K, N], or their transposes, by one strided batched
+ * gemm. The x or y with batch 1 is broadcast to the batch of the other one by the zero stride.
+ */
+class CublasMatmul : public CudaLibraryCall {
+ public:
+  //! @param attrs The batches of x and y, followed by M, N, K, trans_a and trans_b.
+  //! @param fp16 Whether the matrices are all half, which run on the tensor cores with the float accumulation, or the
+  //! half one in the reduced mode.
+  CublasMatmul(const std::vector<int>& attrs,
+               float alpha,
+               bool fp16                  = false,
+               common::PrecisionMode mode = common::PrecisionMode::kFast);
+
+  //! The arguments are (x, y, out).
+  void Run(const std::vector<cinn_pod_value_t>& args, LibraryHandles* handles) override;
+
+ private:
+  int batch_a_{1};
+  int batch_b_{1};
+  int M_{};
+  int N_{};
+  int K_{};
+  bool trans_a_{false};
+  bool trans_b_{false};
+  float alpha_{1.f};
+  bool fp16_{false};
+  common::PrecisionMode mode_{common::PrecisionMode::kFast};
+};
+
 }  // namespace cuda
 }  // namespace runtime
 }  // namespace cinn
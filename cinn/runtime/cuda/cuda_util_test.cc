@@ -0,0 +1,61 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/runtime/cuda/cuda_util.h"
+
+#include <gtest/gtest.h>
+
+namespace cinn {
+namespace runtime {
+namespace cuda {
+
+TEST(LibraryHandles, per_stream) {
+  // The streams are kept alive, a stream created later at the same address would find the handles bound to them.
+  cudaStream_t stream0, stream1;
+  CUDA_CALL(cudaStreamCreate(&stream0));
+  CUDA_CALL(cudaStreamCreate(&stream1));
+
+  auto& handles0 = LibraryHandles::Get(stream0);
+  auto& handles1 = LibraryHandles::Get(stream1);
+  EXPECT_NE(&handles0, &handles1);
+  EXPECT_NE(handles0.cudnn(), handles1.cudnn());
+  EXPECT_NE(handles0.cublas(), handles1.cublas());
+  EXPECT_NE(handles0.cublas_lt(), handles1.cublas_lt());
+  // The same stream gets the same handles.
+  EXPECT_EQ(&LibraryHandles::Get(stream0), &handles0);
+  EXPECT_EQ(&LibraryHandles::Get(stream1), &handles1);
+
+  // The handles run the library calls on their streams.
+  for (auto* handles : {&handles0, &handles1}) {
+    EXPECT_EQ(handles->stream(), handles == &handles0 ? stream0 : stream1);
+    cudaStream_t cudnn_stream, cublas_stream;
+    CUDNN_CALL(cudnnGetStream(handles->cudnn(), &cudnn_stream));
+    ASSERT_EQ(cublasGetStream(handles->cublas(), &cublas_stream), CUBLAS_STATUS_SUCCESS);
+    EXPECT_EQ(cudnn_stream, handles->stream());
+    EXPECT_EQ(cublas_stream, handles->stream());
+  }
+
+  // Each stream has its own workspace, which only grows.
+  void* workspace0 = handles0.GetWorkSpace(1 << 10);
+  void* workspace1 = handles1.GetWorkSpace(1 << 10);
+  ASSERT_NE(workspace0, nullptr);
+  ASSERT_NE(workspace1, nullptr);
+  EXPECT_NE(workspace0, workspace1);
+  EXPECT_EQ(handles0.GetWorkSpace(1 << 9), workspace0);
+  EXPECT_GE(handles0.workspace_size(), 1UL << 10);
+}
+
+}  // namespace cuda
+}  // namespace runtime
+}  // namespace cinn
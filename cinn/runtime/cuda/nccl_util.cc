@@ -0,0 +1,166 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/runtime/cuda/nccl_util.h"
+
+#ifdef CINN_WITH_NCCL
+#include <glog/logging.h>
+
+#include "cinn/backends/cuda_util.h"
+#include "cinn/common/type.h"
+
+namespace cinn {
+namespace runtime {
+namespace cuda {
+
+namespace {
+
+int CurrentDevice() {
+  int device = 0;
+  CUDA_CALL(cudaGetDevice(&device));
+  return device;
+}
+
+ncclRedOp_t GetReduceOp(const std::string& type) {
+  if (type == "sum") return ncclSum;
+  if (type == "max") return ncclMax;
+  if (type == "min") return ncclMin;
+  if (type == "prod") return ncclProd;
+  LOG(FATAL) << "Unsupported reduce_type " << type;
+  return ncclSum;
+}
+
+ncclDataType_t GetDataType(const std::string& type) {
+  if (type == "float16") return ncclFloat16;
+  if (type == "float32") return ncclFloat32;
+  if (type == "float64") return ncclFloat64;
+  if (type == "int8") return ncclInt8;
+  if (type == "int32") return ncclInt32;
+  if (type == "int64") return ncclInt64;
+  LOG(FATAL) << "NCCL doesn't support the data type " << type;
+  return ncclFloat32;
+}
+
+}  // namespace
+
+NcclComms& NcclComms::Global() {
+  static NcclComms comms;
+  return comms;
+}
+
+NcclComms::~NcclComms() {
+  for (auto& item : comms_) {
+    if (item.second.owned) ncclCommDestroy(item.second.comm);
+  }
+}
+
+void NcclComms::Set(int ring_id, Comm comm) {
+  std::lock_guard<std::mutex> lock(mu_);
+  auto key = std::make_pair(ring_id, CurrentDevice());
+  auto it  = comms_.find(key);
+  if (it != comms_.end() && it->second.owned) NCCL_CALL(ncclCommDestroy(it->second.comm));
+  comms_[key] = comm;
+}
+
+void NcclComms::Init(int ring_id, int nranks, int rank, const ncclUniqueId& id) {
+  Comm comm;
+  NCCL_CALL(ncclCommInitRank(&comm.comm, nranks, id, rank));
+  comm.owned = true;
+  Global().Set(ring_id, comm);
+  VLOG(3) << "Create the NCCL communicator of ring " << ring_id << " as rank " << rank << " of " << nranks;
+}
+
+void NcclComms::Register(int ring_id, ncclComm_t comm) {
+  CHECK(comm);
+  Global().Set(ring_id, Comm{comm, false});
+}
+
+ncclComm_t NcclComms::Get(int ring_id) {
+  auto& comms = Global();
+  std::lock_guard<std::mutex> lock(comms.mu_);
+  auto it = comms.comms_.find(std::make_pair(ring_id, CurrentDevice()));
+  CHECK(it != comms.comms_.end()) << "No NCCL communicator of ring " << ring_id
+                                  << " on the current device, it should be created by NcclComms::Init or Register";
+  return it->second.comm;
+}
+
+NcclCollective::NcclCollective(CollectiveKind kind,
+                               const std::vector<int>& attrs,
+                               const std::vector<std::string>& str_attrs)
+    : kind_(kind) {
+  CHECK_GT(attrs.size(), 2UL);
+  CHECK_EQ(str_attrs.size(), 2UL);
+  ring_id_ = attrs[0];
+  nranks_  = attrs[1];
+  numels_.assign(attrs.begin() + 2, attrs.end());
+  CHECK(kind_ == CollectiveKind::kAllReduce || numels_.size() == 1) << "Only the allreduces can be bucketed";
+  reduce_op_     = GetReduceOp(str_attrs[0]);
+  dtype_         = GetDataType(str_attrs[1]);
+  element_bytes_ = common::Str2Type(str_attrs[1]).bits() / 8;
+}
+
+size_t NcclCollective::workspace_size() const {
+  if (numels_.size() == 1) return 0;
+  size_t numel = 0;
+  for (auto n : numels_) numel += n;
+  return numel * element_bytes_;
+}
+
+void NcclCollective::Launch(const void* input, void* output, size_t count, ncclComm_t comm, cudaStream_t stream) const {
+  switch (kind_) {
+    case CollectiveKind::kAllReduce:
+      NCCL_CALL(ncclAllReduce(input, output, count, dtype_, reduce_op_, comm, stream));
+      break;
+    case CollectiveKind::kAllGather:
+      NCCL_CALL(ncclAllGather(input, output, count, dtype_, comm, stream));
+      break;
+    case CollectiveKind::kReduceScatter:
+      // the count is that of the output of each rank
+      NCCL_CALL(ncclReduceScatter(input, output, count / nranks_, dtype_, reduce_op_, comm, stream));
+      break;
+  }
+}
+
+void NcclCollective::Run(const std::vector<cinn_pod_value_t>& args, LibraryHandles* handles) {
+  int n = numels_.size();
+  CHECK_EQ(args.size(), 2 * n) << "Each input of the collective should have an output";
+  auto data   = [&](int i) { return static_cast<cinn_buffer_t*>(args[i])->memory; };
+  auto comm   = NcclComms::Get(ring_id_);
+  auto stream = handles->stream();
+  if (n == 1) {
+    Launch(data(0), data(1), numels_[0], comm, stream);
+    return;
+  }
+  // The bucket is reduced in place in the workspace, which is ordered with the other library calls by the stream.
+  auto* packed  = static_cast<uint8_t*>(handles->GetWorkSpace(workspace_size()));
+  size_t offset = 0;
+  for (int i = 0; i < n; i++) {
+    size_t bytes = numels_[i] * element_bytes_;
+    CUDA_CALL(cudaMemcpyAsync(packed + offset, data(i), bytes, cudaMemcpyDeviceToDevice, stream));
+    offset += bytes;
+  }
+  Launch(packed, packed, offset / element_bytes_, comm, stream);
+  offset = 0;
+  for (int i = 0; i < n; i++) {
+    size_t bytes = numels_[i] * element_bytes_;
+    CUDA_CALL(cudaMemcpyAsync(data(n + i), packed + offset, bytes, cudaMemcpyDeviceToDevice, stream));
+    offset += bytes;
+  }
+}
+
+}  // namespace cuda
+}  // namespace runtime
+}  // namespace cinn
+
+#endif  // CINN_WITH_NCCL
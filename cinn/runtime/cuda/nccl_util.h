@@ -0,0 +1,108 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#ifdef CINN_WITH_NCCL
+
+#include <nccl.h>
+
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cinn/runtime/cuda/cuda_util.h"
+
+#define NCCL_CALL(func)                                                                        \
+  {                                                                                            \
+    ncclResult_t e = (func);                                                                   \
+    CHECK(e == ncclSuccess) << "NCCL: " #func " failed with error: " << ncclGetErrorString(e); \
+  }
+
+namespace cinn {
+namespace runtime {
+namespace cuda {
+
+/**
+ * The NCCL communicators the collective ops run on, each is looked up by the ring id of the op and the current device.
+ * They are either created by Init, or created outside and registered by Register, e.g. by the framework running the
+ * training whose gradients are reduced. It is thread-safe.
+ */
+class NcclComms {
+ public:
+  /**
+   * Create the communicator of ring \p ring_id on the current device as rank \p rank of \p nranks, all the ranks
+   * should call it with the same \p id, which is got by ncclGetUniqueId on one of them. It is destroyed at exit.
+   */
+  static void Init(int ring_id, int nranks, int rank, const ncclUniqueId& id);
+
+  //! Run the collectives of ring \p ring_id on the current device by \p comm, which is owned by the caller.
+  static void Register(int ring_id, ncclComm_t comm);
+
+  //! Get the communicator of ring \p ring_id on the current device.
+  static ncclComm_t Get(int ring_id);
+
+ private:
+  struct Comm {
+    ncclComm_t comm{};
+    bool owned{false};
+  };
+
+  static NcclComms& Global();
+  ~NcclComms();
+  void Set(int ring_id, Comm comm);
+
+  // The communicators by the ring ids and the devices.
+  std::map<std::pair<int, int>, Comm> comms_;
+  std::mutex mu_;
+};
+
+enum class CollectiveKind { kAllReduce, kAllGather, kReduceScatter };
+
+/**
+ * A collective run by NCCL on the stream of the \p handles. The allreduce of a bucket of tensors, e.g. the small
+ * gradients packed by the pass AllReduceFusion, packs them into the workspace and reduces them by one call.
+ */
+class NcclCollective : public CudaLibraryCall {
+ public:
+  /**
+   * @param attrs The ring id and the number of ranks, followed by the number of elements of each input.
+   * @param str_attrs The reduction, "sum", "max", "min" or "prod", followed by the data type, e.g. "float32".
+   */
+  NcclCollective(CollectiveKind kind, const std::vector<int>& attrs, const std::vector<std::string>& str_attrs);
+
+  //! The arguments are the inputs followed by the outputs, one for each input.
+  void Run(const std::vector<cinn_pod_value_t>& args, LibraryHandles* handles) override;
+
+  size_t workspace_size() const override;
+
+ private:
+  // Run the collective of \p count elements of the input on \p comm.
+  void Launch(const void* input, void* output, size_t count, ncclComm_t comm, cudaStream_t stream) const;
+
+  CollectiveKind kind_;
+  int ring_id_;
+  int nranks_;
+  std::vector<size_t> numels_;
+  ncclRedOp_t reduce_op_;
+  ncclDataType_t dtype_;
+  size_t element_bytes_;
+};
+
+}  // namespace cuda
+}  // namespace runtime
+}  // namespace cinn
+
+#endif  // CINN_WITH_NCCL
@@ -84,6 +84,16 @@ static const char* cuda_sync_threads = "__syncthreads";
 
 static const char* parallel_launch = "cinn_backend_parallel_launch";
 
+//! Name of the function checking the X86 features of the host, called by the stubs of the multi-versioned functions.
+static const char* x86_host_supports = "cinn_x86_host_supports";
+
+//! Names of the functions LLVM calls to convert float16 on the X86 CPUs without F16C.
+//@{
+static const char* half_to_float  = "__gnu_h2f_ieee";
+static const char* float_to_half  = "__gnu_f2h_ieee";
+static const char* double_to_half = "__truncdfhf2";
+//@}
+
 }  // namespace intrinsic
 
 /**
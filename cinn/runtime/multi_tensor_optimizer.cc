@@ -0,0 +1,392 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/runtime/multi_tensor_optimizer.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "cinn/runtime/cpu/host_intrinsics.h"
+#include "cinn/runtime/cpu/thread_backend.h"
+
+#ifdef CINN_WITH_CUDA
+#include <cuda_runtime.h>
+
+#include "cinn/backends/cuda_util.h"
+#include "cinn/runtime/cuda/cuda_module.h"
+#endif
+
+namespace cinn {
+namespace runtime {
+
+OptimizerKind OptimizerKindOf(const std::string& op_name) {
+  if (op_name == "multi_tensor_sgd") return OptimizerKind::kSgd;
+  if (op_name == "multi_tensor_momentum") return OptimizerKind::kMomentum;
+  CHECK_EQ(op_name, "multi_tensor_adam") << "Unknown multi-tensor optimizer " << op_name;
+  return OptimizerKind::kAdam;
+}
+
+int NumOptimizerStates(OptimizerKind kind) {
+  switch (kind) {
+    case OptimizerKind::kSgd:
+      return 0;
+    case OptimizerKind::kMomentum:
+      return 1;
+    default:
+      return 2;
+  }
+}
+
+std::vector<TensorChunk> MakeTensorChunks(const std::vector<int64_t>& numels, int64_t chunk_size) {
+  CHECK_GT(chunk_size, 0);
+  std::vector<TensorChunk> chunks;
+  for (int64_t t = 0; t < numels.size(); t++) {
+    for (int64_t begin = 0; begin < numels[t]; begin += chunk_size) {
+      chunks.push_back({t, begin, std::min(begin + chunk_size, numels[t])});
+    }
+  }
+  return chunks;
+}
+
+namespace {
+
+// The lists of the arguments, each of n tensors, and the powers of the betas of adam after the input lists.
+struct ArgLayout {
+  int n;
+  int num_states;
+  bool multi_precision;
+  bool adam;
+
+  int num_input_lists() const { return 2 + num_states + multi_precision; }
+  int num_output_lists() const { return 1 + num_states + multi_precision; }
+  int num_inputs() const { return n * num_input_lists() + 2 * adam; }
+  int num_outputs() const { return n * num_output_lists() + 2 * adam; }
+  // The index of the first output argument.
+  int output_base() const { return num_inputs(); }
+};
+
+ArgLayout LayoutOf(const MultiTensorOptimizerAttrs& attrs) {
+  return ArgLayout{static_cast<int>(attrs.numels.size()),
+                   NumOptimizerStates(attrs.kind),
+                   attrs.multi_precision,
+                   attrs.kind == OptimizerKind::kAdam};
+}
+
+// The hyperparameters of a step, in the same layout as the struct of the kernel source.
+struct StepConfig {
+  int kind;
+  int use_nesterov;
+  float learning_rate;
+  float momentum;
+  float beta1;
+  float beta2;
+  float epsilon;
+  float weight_decay;
+};
+
+StepConfig MakeStepConfig(const MultiTensorOptimizerAttrs& attrs) {
+  return StepConfig{static_cast<int>(attrs.kind),
+                    attrs.use_nesterov,
+                    attrs.learning_rate,
+                    attrs.momentum,
+                    attrs.beta1,
+                    attrs.beta2,
+                    attrs.epsilon,
+                    attrs.weight_decay};
+}
+
+// Update a float32 parameter p by its gradient g and the states s0, s1 in place, return the new value. The lr and the
+// eps of adam are corrected by the powers of the betas.
+inline float UpdateElement(const StepConfig& cfg, float lr, float eps, float p, float g, float* s0, float* s1) {
+  g += cfg.weight_decay * p;
+  switch (static_cast<OptimizerKind>(cfg.kind)) {
+    case OptimizerKind::kSgd:
+      return p - lr * g;
+    case OptimizerKind::kMomentum: {
+      float v = cfg.momentum * *s0 + g;
+      *s0     = v;
+      return cfg.use_nesterov ? p - lr * (g + cfg.momentum * v) : p - lr * v;
+    }
+    default: {
+      float m = cfg.beta1 * *s0 + (1.f - cfg.beta1) * g;
+      float v = cfg.beta2 * *s1 + (1.f - cfg.beta2) * g * g;
+      *s0     = m;
+      *s1     = v;
+      return p - lr * m / (std::sqrt(v) + eps);
+    }
+  }
+}
+
+struct HostTask {
+  const StepConfig* cfg;
+  const ArgLayout* layout;
+  const std::vector<TensorChunk>* chunks;
+  const std::vector<void*>* data;
+  float lr;
+  float eps;
+};
+
+int UpdateChunkOnHost(int task_id, int num_task, void* datas) {
+  auto& task   = *static_cast<HostTask*>(datas);
+  auto& layout = *task.layout;
+  auto& chunk  = (*task.chunks)[task_id];
+  auto& data   = *task.data;
+  int n        = layout.n;
+  int t        = chunk.tensor;
+  int out      = layout.output_base();
+  bool mp      = layout.multi_precision;
+  auto arg     = [&](int list) { return data[list * n + t]; };
+  auto out_arg = [&](int list) { return data[out + list * n + t]; };
+  // the input lists are params, grads, states and masters, and the output lists skip the grads
+  auto* in_s0      = layout.num_states > 0 ? static_cast<const float*>(arg(2)) : nullptr;
+  auto* in_s1      = layout.num_states > 1 ? static_cast<const float*>(arg(3)) : nullptr;
+  auto* out_s0     = layout.num_states > 0 ? static_cast<float*>(out_arg(1)) : nullptr;
+  auto* out_s1     = layout.num_states > 1 ? static_cast<float*>(out_arg(2)) : nullptr;
+  int master_list  = 2 + layout.num_states;
+  auto* in_master  = mp ? static_cast<const float*>(arg(master_list)) : nullptr;
+  auto* out_master = mp ? static_cast<float*>(out_arg(master_list - 1)) : nullptr;
+  for (int64_t i = chunk.begin; i < chunk.end; i++) {
+    float s0 = in_s0 ? in_s0[i] : 0.f;
+    float s1 = in_s1 ? in_s1[i] : 0.f;
+    float p, g;
+    if (mp) {
+      p = in_master[i];
+      g = cinn_host_half_to_float(static_cast<const uint16_t*>(arg(1))[i]);
+    } else {
+      p = static_cast<const float*>(arg(0))[i];
+      g = static_cast<const float*>(arg(1))[i];
+    }
+    p = UpdateElement(*task.cfg, task.lr, task.eps, p, g, &s0, &s1);
+    if (out_s0) out_s0[i] = s0;
+    if (out_s1) out_s1[i] = s1;
+    if (mp) {
+      out_master[i]                         = p;
+      static_cast<uint16_t*>(out_arg(0))[i] = cinn_host_float_to_half(p);
+    } else {
+      static_cast<float*>(out_arg(0))[i] = p;
+    }
+  }
+  return 0;
+}
+
+#ifdef CINN_WITH_CUDA
+// The same update as UpdateElement by a block per chunk, the chunks and the data of the arguments are in a table.
+const char* kMultiTensorKernelSource = R"ROC(
+#include <cuda_fp16.h>
+
+struct TensorChunk {
+  long long tensor;
+  long long begin;
+  long long end;
+};
+
+struct StepConfig {
+  int kind;
+  int use_nesterov;
+  float learning_rate;
+  float momentum;
+  float beta1;
+  float beta2;
+  float epsilon;
+  float weight_decay;
+};
+
+__device__ __forceinline__ float ToFloat(float x) { return x; }
+__device__ __forceinline__ float ToFloat(__half x) { return __half2float(x); }
+__device__ __forceinline__ void Store(float* p, float x) { *p = x; }
+__device__ __forceinline__ void Store(__half* p, float x) { *p = __float2half(x); }
+
+template <typename T>
+__device__ void UpdateChunk(StepConfig cfg, void* const* data, const TensorChunk* chunks, int n, int num_states,
+                            int multi_precision, int output_base) {
+  TensorChunk chunk = chunks[blockIdx.x];
+  int t             = chunk.tensor;
+  float lr          = cfg.learning_rate;
+  float eps         = cfg.epsilon;
+  if (cfg.kind == 2) {
+    int pows        = n * (2 + num_states + multi_precision);
+    float beta1_pow = *static_cast<const float*>(data[pows]);
+    float beta2_pow = *static_cast<const float*>(data[pows + 1]);
+    lr              = lr * sqrtf(1.f - beta2_pow) / (1.f - beta1_pow);
+    eps             = eps * sqrtf(1.f - beta2_pow);
+  }
+  const T* param         = static_cast<const T*>(data[t]);
+  const T* grad          = static_cast<const T*>(data[n + t]);
+  const float* in_s0     = num_states > 0 ? static_cast<const float*>(data[2 * n + t]) : nullptr;
+  const float* in_s1     = num_states > 1 ? static_cast<const float*>(data[3 * n + t]) : nullptr;
+  const float* in_master = multi_precision ? static_cast<const float*>(data[(2 + num_states) * n + t]) : nullptr;
+  T* out_param           = static_cast<T*>(data[output_base + t]);
+  float* out_s0          = num_states > 0 ? static_cast<float*>(data[output_base + n + t]) : nullptr;
+  float* out_s1          = num_states > 1 ? static_cast<float*>(data[output_base + 2 * n + t]) : nullptr;
+  float* out_master = multi_precision ? static_cast<float*>(data[output_base + (1 + num_states) * n + t]) : nullptr;
+  for (long long i = chunk.begin + threadIdx.x; i < chunk.end; i += blockDim.x) {
+    float p = in_master ? in_master[i] : ToFloat(param[i]);
+    float g = ToFloat(grad[i]) + cfg.weight_decay * p;
+    if (cfg.kind == 0) {
+      p -= lr * g;
+    } else if (cfg.kind == 1) {
+      float v   = cfg.momentum * in_s0[i] + g;
+      out_s0[i] = v;
+      p -= cfg.use_nesterov ? lr * (g + cfg.momentum * v) : lr * v;
+    } else {
+      float m   = cfg.beta1 * in_s0[i] + (1.f - cfg.beta1) * g;
+      float v   = cfg.beta2 * in_s1[i] + (1.f - cfg.beta2) * g * g;
+      out_s0[i] = m;
+      out_s1[i] = v;
+      p -= lr * m / (sqrtf(v) + eps);
+    }
+    if (out_master) out_master[i] = p;
+    Store(out_param + i, p);
+  }
+}
+
+extern "C" {
+
+__global__ void cinn_multi_tensor_update_float(StepConfig cfg, void* const* data, const TensorChunk* chunks, int n,
+                                               int num_states, int multi_precision, int output_base) {
+  UpdateChunk<float>(cfg, data, chunks, n, num_states, multi_precision, output_base);
+}
+
+__global__ void cinn_multi_tensor_update_half(StepConfig cfg, void* const* data, const TensorChunk* chunks, int n,
+                                              int num_states, int multi_precision, int output_base) {
+  UpdateChunk<__half>(cfg, data, chunks, n, num_states, multi_precision, output_base);
+}
+
+// The powers of the betas are advanced after the update, for they may be updated in place.
+__global__ void cinn_multi_tensor_beta_pows(StepConfig cfg, void* const* data, int in_pows, int out_pows) {
+  float beta1_pow                          = *static_cast<const float*>(data[in_pows]);
+  float beta2_pow                          = *static_cast<const float*>(data[in_pows + 1]);
+  *static_cast<float*>(data[out_pows])     = beta1_pow * cfg.beta1;
+  *static_cast<float*>(data[out_pows + 1]) = beta2_pow * cfg.beta2;
+}
+
+}
+)ROC";
+
+// The module of the kernels.
+cuda::CUDAModule* KernelModule() {
+  static cuda::LazyCUDAModule module(kMultiTensorKernelSource);
+  return module.get();
+}
+
+constexpr int kThreadsPerBlock = 512;
+#endif
+
+}  // namespace
+
+MultiTensorOptimizer::MultiTensorOptimizer(const MultiTensorOptimizerAttrs& attrs, const common::Target& target)
+    : attrs_(attrs), target_(target), chunks_(MakeTensorChunks(attrs.numels, kChunkSize)) {
+  CHECK(!attrs_.numels.empty()) << "The multi-tensor optimizer should update at least 1 tensor";
+  CHECK(target_.is_cpu() || target_.arch == common::Target::Arch::NVGPU)
+      << "The multi-tensor optimizer runs on CPU or NVGPU only";
+}
+
+int MultiTensorOptimizer::num_inputs() const { return LayoutOf(attrs_).num_inputs(); }
+
+int MultiTensorOptimizer::num_outputs() const { return LayoutOf(attrs_).num_outputs(); }
+
+void MultiTensorOptimizer::Run(const std::vector<cinn_pod_value_t>& args, void* stream) {
+  CHECK_EQ(args.size(), num_inputs() + num_outputs()) << "The multi-tensor optimizer got wrong number of arguments";
+  std::vector<void*> data(args.size());
+  for (int i = 0; i < args.size(); i++) {
+    cinn_buffer_t* buffer = args[i];
+    CHECK(buffer && buffer->memory) << "The argument " << i << " of the multi-tensor optimizer is not allocated";
+    data[i] = buffer->memory;
+  }
+  if (chunks_.empty()) return;
+  if (target_.arch == common::Target::Arch::NVGPU) {
+    RunOnDevice(data, stream);
+  } else {
+    RunOnHost(data);
+  }
+}
+
+void MultiTensorOptimizer::RunOnHost(const std::vector<void*>& data) {
+  auto layout = LayoutOf(attrs_);
+  auto cfg    = MakeStepConfig(attrs_);
+  float lr    = attrs_.learning_rate;
+  float eps   = attrs_.epsilon;
+  float beta1_pow{0.f}, beta2_pow{0.f};
+  if (layout.adam) {
+    int pows  = layout.num_inputs() - 2;
+    beta1_pow = *static_cast<const float*>(data[pows]);
+    beta2_pow = *static_cast<const float*>(data[pows + 1]);
+    lr        = lr * std::sqrt(1.f - beta2_pow) / (1.f - beta1_pow);
+    eps       = eps * std::sqrt(1.f - beta2_pow);
+  }
+  HostTask task{&cfg, &layout, &chunks_, &data, lr, eps};
+  cinn_backend_parallel_launch(UpdateChunkOnHost, &task, chunks_.size());
+  if (layout.adam) {
+    int pows                             = layout.output_base() + layout.num_outputs() - 2;
+    *static_cast<float*>(data[pows])     = beta1_pow * attrs_.beta1;
+    *static_cast<float*>(data[pows + 1]) = beta2_pow * attrs_.beta2;
+  }
+}
+
+void MultiTensorOptimizer::RunOnDevice(const std::vector<void*>& data, void* stream) {
+#ifdef CINN_WITH_CUDA
+  int device_id = 0;
+  CUDA_CALL(cudaGetDevice(&device_id));
+  auto cu_stream    = static_cast<cudaStream_t>(stream);
+  size_t data_bytes = data.size() * sizeof(void*);
+  if (!device_table_) {
+    device_id_ = device_id;
+    CUDA_CALL(cudaMalloc(&device_table_, data_bytes + chunks_.size() * sizeof(TensorChunk)));
+    CUDA_CALL(cudaMemcpyAsync(static_cast<char*>(device_table_) + data_bytes,
+                              chunks_.data(),
+                              chunks_.size() * sizeof(TensorChunk),
+                              cudaMemcpyHostToDevice,
+                              cu_stream));
+  }
+  CHECK_EQ(device_id, device_id_) << "The multi-tensor optimizer runs on the device it first ran on";
+  if (uploaded_data_ != data) {
+    // the pageable source is copied out before cudaMemcpyAsync returns, so it is fine to change it after
+    uploaded_data_ = data;
+    CUDA_CALL(cudaMemcpyAsync(device_table_, uploaded_data_.data(), data_bytes, cudaMemcpyHostToDevice, cu_stream));
+  }
+
+  auto layout     = LayoutOf(attrs_);
+  auto cfg        = MakeStepConfig(attrs_);
+  void* table     = device_table_;
+  void* chunks    = static_cast<char*>(device_table_) + data_bytes;
+  int n           = layout.n;
+  int num_states  = layout.num_states;
+  int mp          = layout.multi_precision;
+  int output_base = layout.output_base();
+  void* args[]    = {&cfg, &table, &chunks, &n, &num_states, &mp, &output_base};
+  auto* kernel    = mp ? "cinn_multi_tensor_update_half" : "cinn_multi_tensor_update_float";
+  auto* module    = KernelModule();
+  // a block per chunk in a single launch
+  module->LaunchKernel(device_id, kernel, dim3(chunks_.size()), dim3(kThreadsPerBlock), args, 0, cu_stream);
+  if (layout.adam) {
+    int in_pows      = layout.num_inputs() - 2;
+    int out_pows     = output_base + layout.num_outputs() - 2;
+    void* pow_args[] = {&cfg, &table, &in_pows, &out_pows};
+    module->LaunchKernel(device_id, "cinn_multi_tensor_beta_pows", dim3(1), dim3(1), pow_args, 0, cu_stream);
+  }
+#else
+  LOG(FATAL) << "The multi-tensor optimizer on NVGPU needs CINN built with CUDA";
+#endif
+}
+
+MultiTensorOptimizer::~MultiTensorOptimizer() {
+#ifdef CINN_WITH_CUDA
+  if (device_table_) cudaFree(device_table_);
+#endif
+}
+
+}  // namespace runtime
+}  // namespace cinn
@@ -0,0 +1,116 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cinn/common/macros.h"
+#include "cinn/common/target.h"
+#include "cinn/runtime/cinn_runtime.h"
+
+namespace cinn {
+namespace runtime {
+
+enum class OptimizerKind {
+  kSgd      = 0,
+  kMomentum = 1,
+  kAdam     = 2,
+};
+
+//! The kind of the op multi_tensor_sgd, multi_tensor_momentum or multi_tensor_adam.
+OptimizerKind OptimizerKindOf(const std::string& op_name);
+
+//! The number of the state lists of \p kind, the velocities of momentum, the moment1 and the moment2 of adam.
+int NumOptimizerStates(OptimizerKind kind);
+
+/**
+ * The hyperparameters of a multi-tensor optimizer update and the number of elements of each parameter. The gradients
+ * are added by weight_decay * param first. Adam takes the powers of beta1 and beta2 of the current step as the
+ * tensors of a single element, which are updated for the next step.
+ */
+struct MultiTensorOptimizerAttrs {
+  OptimizerKind kind{OptimizerKind::kSgd};
+  float learning_rate{1e-3f};
+  float momentum{0.9f};
+  bool use_nesterov{false};
+  float beta1{0.9f};
+  float beta2{0.999f};
+  float epsilon{1e-8f};
+  float weight_decay{0.f};
+  //! Whether the parameters and the gradients are float16, updated by the float32 master weights.
+  bool multi_precision{false};
+  std::vector<int64_t> numels;
+};
+
+//! The elements [begin, end) of a tensor, processed by a task on CPU or a block on NVGPU.
+struct TensorChunk {
+  int64_t tensor;
+  int64_t begin;
+  int64_t end;
+};
+
+//! Split the tensors of \p numels into the chunks of at most \p chunk_size elements, in order.
+std::vector<TensorChunk> MakeTensorChunks(const std::vector<int64_t>& numels, int64_t chunk_size);
+
+/**
+ * The runtime kernel of the ops multi_tensor_sgd, multi_tensor_momentum and multi_tensor_adam, which updates all the
+ * n parameters by the chunk list of their elements in a single parallel loop on CPU, or a single launch on NVGPU,
+ * instead of a kernel per parameter and state.
+ *
+ * The arguments are the inputs followed by the outputs of the op. The inputs are the lists of n params, n grads, the
+ * n tensors of each state, the n master weights if multi_precision, and the beta1_pow and beta2_pow of adam. The
+ * outputs are in the same order without the grads. An output may share the buffer of its input to update in place.
+ */
+class MultiTensorOptimizer {
+ public:
+  MultiTensorOptimizer(const MultiTensorOptimizerAttrs& attrs, const common::Target& target);
+
+  const MultiTensorOptimizerAttrs& attrs() const { return attrs_; }
+
+  int num_tensors() const { return attrs_.numels.size(); }
+  int num_chunks() const { return chunks_.size(); }
+  //! The number of the inputs and the outputs.
+  int num_inputs() const;
+  int num_outputs() const;
+
+  //! Update on \p stream on NVGPU, nullptr for the default stream.
+  void Run(const std::vector<cinn_pod_value_t>& args, void* stream = nullptr);
+
+  ~MultiTensorOptimizer();
+
+  //! The elements of a chunk.
+  static constexpr int64_t kChunkSize = 65536;
+
+ private:
+  void RunOnHost(const std::vector<void*>& data);
+
+  void RunOnDevice(const std::vector<void*>& data, void* stream);
+
+  MultiTensorOptimizerAttrs attrs_;
+  common::Target target_;
+  std::vector<TensorChunk> chunks_;
+
+  // The device table of the data of the arguments followed by the chunks, the data is uploaded again if it changes.
+  std::vector<void*> uploaded_data_;
+  void* device_table_{nullptr};
+  int device_id_{-1};
+
+  CINN_DISALLOW_COPY_AND_ASSIGN(MultiTensorOptimizer);
+};
+
+}  // namespace runtime
+}  // namespace cinn
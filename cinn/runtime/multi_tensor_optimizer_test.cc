@@ -0,0 +1,166 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/runtime/multi_tensor_optimizer.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "cinn/runtime/cpu/host_intrinsics.h"
+
+namespace cinn {
+namespace runtime {
+
+namespace {
+// The host buffers of the arguments, which own the data.
+struct Args {
+  std::vector<std::vector<float>> data;
+  std::vector<std::vector<uint16_t>> half_data;
+  std::vector<cinn_buffer_t> buffers;
+
+  std::vector<float>* Add(int64_t numel, float value) {
+    data.emplace_back(numel, value);
+    return &data.back();
+  }
+
+  std::vector<uint16_t>* AddHalf(int64_t numel, float value) {
+    half_data.emplace_back(numel, cinn_host_float_to_half(value));
+    return &half_data.back();
+  }
+
+  // The arguments in the order of the data added
+  std::vector<cinn_pod_value_t> Build(const std::vector<void*>& order) {
+    buffers.resize(order.size());
+    std::vector<cinn_pod_value_t> res;
+    for (int i = 0; i < order.size(); i++) {
+      buffers[i].memory = static_cast<uint8_t*>(order[i]);
+      res.emplace_back(&buffers[i]);
+    }
+    return res;
+  }
+};
+}  // namespace
+
+TEST(MultiTensorOptimizer, chunks) {
+  auto chunks = MakeTensorChunks({5, 0, 12}, 4);
+  ASSERT_EQ(chunks.size(), 5UL);
+  ASSERT_EQ(chunks[0].tensor, 0);
+  ASSERT_EQ(chunks[1].end, 5);
+  ASSERT_EQ(chunks[2].tensor, 2);
+  ASSERT_EQ(chunks[4].begin, 8);
+  ASSERT_EQ(chunks[4].end, 12);
+}
+
+TEST(MultiTensorOptimizer, momentum) {
+  // the second param spans several chunks
+  std::vector<int64_t> numels{7, 2 * MultiTensorOptimizer::kChunkSize + 3};
+  MultiTensorOptimizerAttrs attrs;
+  attrs.kind          = OptimizerKind::kMomentum;
+  attrs.learning_rate = 0.1f;
+  attrs.momentum      = 0.5f;
+  attrs.use_nesterov  = true;
+  attrs.numels        = numels;
+  MultiTensorOptimizer optimizer(attrs, common::DefaultHostTarget());
+  ASSERT_EQ(optimizer.num_chunks(), 4);
+  ASSERT_EQ(optimizer.num_inputs(), 6);
+  ASSERT_EQ(optimizer.num_outputs(), 4);
+
+  Args args;
+  args.data.reserve(8);
+  std::vector<void*> params, grads, velocities;
+  for (int t = 0; t < 2; t++) {
+    params.push_back(args.Add(numels[t], 1.f)->data());
+    grads.push_back(args.Add(numels[t], t + 1.f)->data());
+    velocities.push_back(args.Add(numels[t], 2.f)->data());
+  }
+  std::vector<void*> order = params;
+  order.insert(order.end(), grads.begin(), grads.end());
+  order.insert(order.end(), velocities.begin(), velocities.end());
+  // update in place
+  order.insert(order.end(), params.begin(), params.end());
+  order.insert(order.end(), velocities.begin(), velocities.end());
+  optimizer.Run(args.Build(order));
+
+  for (int t = 0; t < 2; t++) {
+    float g = t + 1.f;
+    float v = 0.5f * 2.f + g;
+    float p = 1.f - 0.1f * (g + 0.5f * v);
+    auto* param    = static_cast<float*>(params[t]);
+    auto* velocity = static_cast<float*>(velocities[t]);
+    for (int64_t i = 0; i < numels[t]; i++) {
+      ASSERT_FLOAT_EQ(param[i], p);
+      ASSERT_FLOAT_EQ(velocity[i], v);
+    }
+  }
+}
+
+TEST(MultiTensorOptimizer, adam_multi_precision) {
+  std::vector<int64_t> numels{16, 3};
+  MultiTensorOptimizerAttrs attrs;
+  attrs.kind            = OptimizerKind::kAdam;
+  attrs.learning_rate   = 0.01f;
+  attrs.weight_decay    = 0.1f;
+  attrs.multi_precision = true;
+  attrs.numels          = numels;
+  MultiTensorOptimizer optimizer(attrs, common::DefaultHostTarget());
+  ASSERT_EQ(optimizer.num_inputs(), 12);
+  ASSERT_EQ(optimizer.num_outputs(), 10);
+
+  Args args;
+  args.data.reserve(16);
+  args.half_data.reserve(8);
+  std::vector<void*> inputs(10), outputs(8);
+  for (int t = 0; t < 2; t++) {
+    inputs[t]      = args.AddHalf(numels[t], 0.f)->data();
+    inputs[2 + t]  = args.AddHalf(numels[t], 0.5f)->data();
+    inputs[4 + t]  = args.Add(numels[t], 0.1f)->data();
+    inputs[6 + t]  = args.Add(numels[t], 0.2f)->data();
+    inputs[8 + t]  = args.Add(numels[t], 2.f)->data();
+    outputs[t]     = args.AddHalf(numels[t], 0.f)->data();
+    outputs[2 + t] = args.Add(numels[t], 0.f)->data();
+    outputs[4 + t] = args.Add(numels[t], 0.f)->data();
+    outputs[6 + t] = args.Add(numels[t], 0.f)->data();
+  }
+  float beta1_pow = 0.9f, beta2_pow = 0.999f, pows_out[2];
+  inputs.push_back(&beta1_pow);
+  inputs.push_back(&beta2_pow);
+  outputs.push_back(&pows_out[0]);
+  outputs.push_back(&pows_out[1]);
+  std::vector<void*> order = inputs;
+  order.insert(order.end(), outputs.begin(), outputs.end());
+  optimizer.Run(args.Build(order));
+
+  // the master weights are updated, and the params are cast from them
+  float g  = 0.5f + 0.1f * 2.f;
+  float m  = 0.9f * 0.1f + 0.1f * g;
+  float v  = 0.999f * 0.2f + 0.001f * g * g;
+  float lr = 0.01f * std::sqrt(1.f - beta2_pow) / (1.f - beta1_pow);
+  float p  = 2.f - lr * m / (std::sqrt(v) + 1e-8f * std::sqrt(1.f - beta2_pow));
+  for (int t = 0; t < 2; t++) {
+    for (int64_t i = 0; i < numels[t]; i++) {
+      ASSERT_FLOAT_EQ(static_cast<float*>(outputs[6 + t])[i], p);
+      ASSERT_FLOAT_EQ(static_cast<float*>(outputs[2 + t])[i], m);
+      ASSERT_FLOAT_EQ(static_cast<float*>(outputs[4 + t])[i], v);
+      ASSERT_NEAR(cinn_host_half_to_float(static_cast<uint16_t*>(outputs[t])[i]), p, 1e-3);
+    }
+  }
+  ASSERT_FLOAT_EQ(pows_out[0], 0.9f * 0.9f);
+  ASSERT_FLOAT_EQ(pows_out[1], 0.999f * 0.999f);
+}
+
+}  // namespace runtime
+}  // namespace cinn
@@ -16,12 +16,14 @@
 #include <omp.h>
 
 #include <algorithm>
+#include <cstring>
 #include <map>
 #include <memory>
+#include <string>
 #include <thread>
 #include <vector>
 
-#include "cinn_runtime.h"
+#include "tiny_runtime.h"
 
 extern "C" {
 int max_num_workers = std::thread::hardware_concurrency();
@@ -35,28 +37,26 @@ struct param_context_t {
   std::vector<std::string> instructions;
   std::vector<int> inst_argc;
   std::vector<cinn_pod_value_t *> inst_argv;
+  // The functions of the instructions, bound by bind_program_function or looked up on the first run.
+  std::vector<lower_func_ptr_t> inst_funcs;
 };
+}
 
-void *load_program(const char *paramfile) {
-  FILE *f = fopen(paramfile, "r");
-  fseek(f, 0, SEEK_END);
-  int fsize = ftell(f);
-  rewind(f);
-  if (fsize < 32) {
-    fclose(f);
-    return nullptr;
-  }
+namespace {
+// The alignment of the persistent buffers in the loaded program, the widest vector the kernels access.
+constexpr int kProgramAlignment = 64;
 
-  std::unique_ptr<param_context_t> ctx(new param_context_t{});
-  int alignment = std::max(alignof(cinn_pod_value_t), alignof(cinn_buffer_t));
-  ctx->buf.resize(fsize + alignment);
+// Allocate the aligned buffer of \p ctx for the program of \p size bytes.
+uint8_t *alloc_program_buffer(param_context_t *ctx, int size) {
+  ctx->buf.resize(size + kProgramAlignment);
   uint8_t *buf = ctx->buf.data();
-  if ((uintptr_t)buf % alignment) {
-    buf = buf + alignment - ((uintptr_t)buf % alignment);
+  if ((uintptr_t)buf % kProgramAlignment) {
+    buf = buf + kProgramAlignment - ((uintptr_t)buf % kProgramAlignment);
   }
-  fread(buf, 1, fsize, f);
-  fclose(f);
+  return buf;
+}
 
+void *parse_program(std::unique_ptr<param_context_t> ctx, uint8_t *buf, int fsize) {
   if (std::string(buf, buf + 4) != "CINN") {
     // TODO LOG fatal
     return nullptr;
@@ -115,8 +115,51 @@ void *load_program(const char *paramfile) {
     }
     ctx->inst_argv.push_back(argv);
   }
+  ctx->inst_funcs.resize(ctx->instructions.size(), nullptr);
   return ctx.release();
 }
+}  // namespace
+
+extern "C" {
+void *load_program(const char *paramfile) {
+  FILE *f = fopen(paramfile, "r");
+  if (!f) return nullptr;
+  fseek(f, 0, SEEK_END);
+  int fsize = ftell(f);
+  rewind(f);
+  if (fsize < 32) {
+    fclose(f);
+    return nullptr;
+  }
+
+  std::unique_ptr<param_context_t> ctx(new param_context_t{});
+  uint8_t *buf = alloc_program_buffer(ctx.get(), fsize);
+  fread(buf, 1, fsize, f);
+  fclose(f);
+  return parse_program(std::move(ctx), buf, fsize);
+}
+
+void *load_program_from_memory(const void *data, int64_t size) {
+  if (size < 32) return nullptr;
+  std::unique_ptr<param_context_t> ctx(new param_context_t{});
+  uint8_t *buf = alloc_program_buffer(ctx.get(), size);
+  memcpy(buf, data, size);
+  return parse_program(std::move(ctx), buf, size);
+}
+
+int bind_program_function(void *ctx, const char *name, lower_func_ptr_t fn) {
+  param_context_t *pc = (param_context_t *)ctx;
+  int bound           = 0;
+  for (int i = 0; i < pc->instructions.size(); i++) {
+    if (pc->instructions[i] == name) {
+      pc->inst_funcs[i] = fn;
+      bound++;
+    }
+  }
+  return bound;
+}
+
+void free_program(void *ctx) { delete (param_context_t *)ctx; }
 
 int set_maxconcurrency(int c) {
   int old_c       = max_num_workers;
@@ -124,14 +167,15 @@ int set_maxconcurrency(int c) {
   return old_c;
 }
 
-typedef void (*func_t)(cinn_pod_value_t *, int);
 void run_program(void *ctx) {
   param_context_t *pc = (param_context_t *)ctx;
   for (int i = 0; i < pc->instructions.size(); i++) {
-    const char *sym = pc->instructions[i].c_str();
-    void *p         = dlsym(RTLD_DEFAULT, sym);
-    func_t f        = (func_t)p;
-    f(pc->inst_argv[i], pc->inst_argc[i]);
+    if (!pc->inst_funcs[i]) {
+      // the functions not bound are looked up once, which requires them to be exported dynamically
+      const char *sym   = pc->instructions[i].c_str();
+      pc->inst_funcs[i] = (lower_func_ptr_t)dlsym(RTLD_DEFAULT, sym);
+    }
+    pc->inst_funcs[i](pc->inst_argv[i], pc->inst_argc[i]);
   }
 }
 
@@ -143,6 +187,11 @@ cinn_pod_value_t *get_pod_value(void *ctx, const char *tname) {
   return nullptr;
 }
 
+cinn_buffer_t *get_buffer(void *ctx, const char *tname) {
+  cinn_pod_value_t *value = get_pod_value(ctx, tname);
+  return value ? (cinn_buffer_t *)(*value) : nullptr;
+}
+
 typedef int (*FCINNParallelLambda)(int task_id, int num_task, void *datas);
 int cinn_backend_parallel_launch(FCINNParallelLambda flambda, void *datas, int num_task) {
   int num_workers = max_num_workers;
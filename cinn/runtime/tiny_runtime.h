@@ -0,0 +1,56 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+/**
+ * \file This file contains the minimal runtime to run a program exported by Program::Export without CINN and LLVM,
+ * e.g. the ahead-of-time compiled models exported by Program::ExportLibrary. It links the object files of the lowered
+ * functions, and the buffers and the arguments of the instructions are loaded from the program file.
+ */
+
+#include "cinn_runtime.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Load the program file \p paramfile, return NULL if it is invalid.
+void* load_program(const char* paramfile);
+
+//! Load the program from the \p size bytes of \p data, e.g. the ones embedded in a library, which are copied.
+void* load_program_from_memory(const void* data, int64_t size);
+
+/**
+ * Let the instructions calling the function \p name call \p fn, so that no symbol is looked up by dlsym, which
+ * requires the functions exported dynamically. Return the number of the instructions bound.
+ */
+int bind_program_function(void* ctx, const char* name, lower_func_ptr_t fn);
+
+//! Run the instructions of the program in order.
+void run_program(void* ctx);
+
+//! The argument of the variable \p tname, or NULL if it is not in the program.
+cinn_pod_value_t* get_pod_value(void* ctx, const char* tname);
+
+//! The buffer of the variable \p tname, or NULL if it is not in the program.
+cinn_buffer_t* get_buffer(void* ctx, const char* tname);
+
+void free_program(void* ctx);
+
+//! Set the number of the threads the parallel loops run on, return the old one.
+int set_maxconcurrency(int c);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
@@ -0,0 +1,159 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/utils/compile_tracer.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+DEFINE_bool(cinn_trace_compile, false, "Whether to trace the time spent in the stages of the compilation");
+
+namespace cinn {
+namespace utils {
+
+namespace {
+
+std::string& CurrentGroup() {
+  static thread_local std::string group;
+  return group;
+}
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//! The \p top_k slowest items by the total time.
+std::vector<std::pair<std::string, CompileTracer::Stat>> Slowest(const std::map<std::string, CompileTracer::Stat>& stats,
+                                                                 int top_k) {
+  std::vector<std::pair<std::string, CompileTracer::Stat>> items(stats.begin(), stats.end());
+  std::stable_sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+    return a.second.total_ms > b.second.total_ms;
+  });
+  if (top_k >= 0 && items.size() > top_k) items.resize(top_k);
+  return items;
+}
+
+void PrintStats(std::ostream& os, const std::vector<std::pair<std::string, CompileTracer::Stat>>& items) {
+  for (auto& item : items) {
+    os << "  " << std::left << std::setw(40) << item.first << std::right << std::setw(8) << item.second.count
+       << std::setw(14) << std::fixed << std::setprecision(3) << item.second.total_ms << std::setw(14)
+       << item.second.max_ms << "\n";
+  }
+}
+
+}  // namespace
+
+void CompileTracer::Stat::Add(double ms) {
+  count++;
+  total_ms += ms;
+  max_ms = std::max(max_ms, ms);
+}
+
+CompileTracer& CompileTracer::Global() {
+  static CompileTracer tracer;
+  return tracer;
+}
+
+void CompileTracer::Record(const std::string& stage, const std::string& group, double ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stages_[stage].Add(ms);
+  if (!group.empty()) group_stages_[group][stage].Add(ms);
+}
+
+void CompileTracer::RecordGroup(const std::string& group, double ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  groups_[group].Add(ms);
+}
+
+std::map<std::string, CompileTracer::Stat> CompileTracer::stage_stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stages_;
+}
+
+std::map<std::string, CompileTracer::Stat> CompileTracer::group_stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return groups_;
+}
+
+std::map<std::string, CompileTracer::Stat> CompileTracer::group_stage_stats(const std::string& group) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = group_stages_.find(group);
+  return it == group_stages_.end() ? std::map<std::string, Stat>() : it->second;
+}
+
+void CompileTracer::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stages_.clear();
+  groups_.clear();
+  group_stages_.clear();
+}
+
+std::string CompileTracer::Report(int top_k) const {
+  std::map<std::string, Stat> passes;
+  for (auto& item : stage_stats()) {
+    if (item.first.rfind("pass:", 0) == 0) passes.emplace(item.first.substr(5), item.second);
+  }
+
+  std::stringstream ss;
+  auto header = [&](const std::string& title) {
+    ss << title << "\n  " << std::left << std::setw(40) << "name" << std::right << std::setw(8) << "count"
+       << std::setw(14) << "total(ms)" << std::setw(14) << "max(ms)"
+       << "\n";
+  };
+  header("Compile time of the stages:");
+  PrintStats(ss, Slowest(stage_stats(), -1));
+  header("The slowest passes:");
+  PrintStats(ss, Slowest(passes, top_k));
+  header("The slowest groups:");
+  auto groups = Slowest(group_stats(), top_k);
+  PrintStats(ss, groups);
+  for (auto& group : groups) {
+    auto stages = Slowest(group_stage_stats(group.first), 3);
+    if (stages.empty()) continue;
+    ss << "  " << group.first << " spends the most in:";
+    for (auto& stage : stages) ss << " " << stage.first << "(" << stage.second.total_ms << "ms)";
+    ss << "\n";
+  }
+  return ss.str();
+}
+
+CompileGroupScope::CompileGroupScope(const std::string& group)
+    : nvtx_(group), prev_(CurrentGroup()), enabled_(CompileTracer::Global().enabled()) {
+  CurrentGroup() = group;
+  if (enabled_) start_ = std::chrono::steady_clock::now();
+}
+
+CompileGroupScope::~CompileGroupScope() {
+  if (enabled_) CompileTracer::Global().RecordGroup(CurrentGroup(), MillisecondsSince(start_));
+  CurrentGroup() = prev_;
+}
+
+const std::string& CompileGroupScope::Current() { return CurrentGroup(); }
+
+CompileStageTimer::CompileStageTimer(const std::string& stage)
+    : nvtx_(stage), enabled_(CompileTracer::Global().enabled()) {
+  if (!enabled_) return;
+  stage_ = stage;
+  start_ = std::chrono::steady_clock::now();
+}
+
+CompileStageTimer::~CompileStageTimer() {
+  if (enabled_) CompileTracer::Global().Record(stage_, CurrentGroup(), MillisecondsSince(start_));
+}
+
+}  // namespace utils
+}  // namespace cinn
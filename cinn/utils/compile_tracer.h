@@ -0,0 +1,112 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <gflags/gflags.h>
+
+#include <chrono>  //NOLINT
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "cinn/utils/nvtx.h"
+
+DECLARE_bool(cinn_trace_compile);
+
+namespace cinn {
+namespace utils {
+
+/**
+ * CompileTracer aggregates the time spent in the stages of the compilation, such as the passes, the lowering, the
+ * optimization and the code generation of the backends, per stage and per fused group. The stages are timed by the
+ * CompileStageTimers in their scopes, and attributed to the group of the CompileGroupScope active on the thread.
+ * It is enabled by --cinn_trace_compile or set_enabled.
+ */
+class CompileTracer {
+ public:
+  struct Stat {
+    int64_t count{};
+    double total_ms{};
+    double max_ms{};
+
+    void Add(double ms);
+  };
+
+  static CompileTracer& Global();
+
+  bool enabled() const { return enabled_ || FLAGS_cinn_trace_compile; }
+  void set_enabled(bool enabled) { enabled_ = enabled; }
+
+  //! Record a stage taking \p ms milliseconds in \p group, an empty group for the work out of the groups.
+  void Record(const std::string& stage, const std::string& group, double ms);
+  //! Record the whole time of a group.
+  void RecordGroup(const std::string& group, double ms);
+
+  //! The statistics of each stage, the passes are named after "pass:".
+  std::map<std::string, Stat> stage_stats() const;
+  //! The statistics of the whole time of each group.
+  std::map<std::string, Stat> group_stats() const;
+  //! The statistics of the stages in a group.
+  std::map<std::string, Stat> group_stage_stats(const std::string& group) const;
+
+  void Clear();
+
+  //! Print the stages, and the \p top_k slowest passes and groups.
+  std::string Report(int top_k = 10) const;
+
+ private:
+  bool enabled_{false};
+  std::map<std::string, Stat> stages_;
+  std::map<std::string, Stat> groups_;
+  std::map<std::string, std::map<std::string, Stat>> group_stages_;
+  mutable std::mutex mutex_;
+};
+
+/**
+ * The fused group the stages in the scope are attributed to, on this thread. The scope is also an NVTX range with
+ * --cinn_nvtx, as are the stages in it.
+ */
+class CompileGroupScope {
+ public:
+  explicit CompileGroupScope(const std::string& group);
+  ~CompileGroupScope();
+
+  //! The group of the active scope on this thread, empty if none.
+  static const std::string& Current();
+
+ private:
+  NvtxRange nvtx_;
+  std::string prev_;
+  bool enabled_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Time the stage in the scope, nothing is recorded if the CompileTracer is not enabled.
+ */
+class CompileStageTimer {
+ public:
+  explicit CompileStageTimer(const std::string& stage);
+  ~CompileStageTimer();
+
+ private:
+  NvtxRange nvtx_;
+  std::string stage_;
+  bool enabled_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace utils
+}  // namespace cinn
@@ -0,0 +1,65 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/utils/compile_tracer.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace cinn {
+namespace utils {
+
+TEST(CompileTracer, basic) {
+  auto& tracer = CompileTracer::Global();
+  tracer.Clear();
+  tracer.set_enabled(false);
+  { CompileStageTimer timer("Optimize"); }
+  ASSERT_TRUE(tracer.stage_stats().empty());
+
+  tracer.set_enabled(true);
+  {
+    CompileGroupScope group("fn_conv2d_relu");
+    EXPECT_EQ(CompileGroupScope::Current(), "fn_conv2d_relu");
+    {
+      CompileStageTimer timer("AstGen");
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    for (int i = 0; i < 2; i++) {
+      CompileStageTimer timer("Optimize");
+    }
+  }
+  EXPECT_EQ(CompileGroupScope::Current(), "");
+  { CompileStageTimer timer("pass:OpFusion"); }
+
+  auto stages = tracer.stage_stats();
+  ASSERT_EQ(stages.size(), 3UL);
+  EXPECT_EQ(stages["Optimize"].count, 2);
+  EXPECT_GE(stages["AstGen"].total_ms, 2.);
+  EXPECT_EQ(tracer.group_stats().count("fn_conv2d_relu"), 1UL);
+  EXPECT_GE(tracer.group_stats()["fn_conv2d_relu"].total_ms, stages["AstGen"].total_ms);
+  EXPECT_EQ(tracer.group_stage_stats("fn_conv2d_relu").size(), 2UL);
+
+  auto report = tracer.Report();
+  LOG(INFO) << "\n" << report;
+  EXPECT_NE(report.find("OpFusion"), std::string::npos);
+  EXPECT_NE(report.find("fn_conv2d_relu spends the most in: AstGen"), std::string::npos);
+
+  tracer.set_enabled(false);
+  tracer.Clear();
+}
+
+}  // namespace utils
+}  // namespace cinn
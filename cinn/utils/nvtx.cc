@@ -0,0 +1,52 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/utils/nvtx.h"
+
+#ifdef CINN_WITH_CUDA
+// the header-only NVTX v3 shipped with the CUDA toolkit, no library to link
+#include <nvtx3/nvToolsExt.h>
+#endif
+
+DEFINE_bool(cinn_nvtx,
+            false,
+            "Whether to annotate the instructions and the compile stages with NVTX ranges for Nsight Systems.");
+
+namespace cinn {
+namespace utils {
+
+bool NvtxRange::enabled() {
+#ifdef CINN_WITH_CUDA
+  return FLAGS_cinn_nvtx;
+#else
+  return false;
+#endif
+}
+
+NvtxRange::NvtxRange(const std::string& name) {
+#ifdef CINN_WITH_CUDA
+  if (!FLAGS_cinn_nvtx) return;
+  nvtxRangePushA(name.c_str());
+  pushed_ = true;
+#endif
+}
+
+NvtxRange::~NvtxRange() {
+#ifdef CINN_WITH_CUDA
+  if (pushed_) nvtxRangePop();
+#endif
+}
+
+}  // namespace utils
+}  // namespace cinn
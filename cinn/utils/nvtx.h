@@ -0,0 +1,46 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <gflags/gflags.h>
+
+#include <string>
+
+DECLARE_bool(cinn_nvtx);
+
+namespace cinn {
+namespace utils {
+
+/**
+ * Push an NVTX range named \p name in the scope on this thread, which Nsight Systems shows on the timeline above the
+ * kernels launched in it. It does nothing unless CINN is built with CUDA and --cinn_nvtx is set.
+ */
+class NvtxRange {
+ public:
+  explicit NvtxRange(const std::string& name);
+  ~NvtxRange();
+
+  NvtxRange(const NvtxRange&) = delete;
+  NvtxRange& operator=(const NvtxRange&) = delete;
+
+  //! Whether the ranges are pushed, the callers can skip building the names if not.
+  static bool enabled();
+
+ private:
+  bool pushed_{false};
+};
+
+}  // namespace utils
+}  // namespace cinn
@@ -0,0 +1,38 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cinn/utils/thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+namespace cinn {
+namespace utils {
+
+TEST(ThreadPool, basic) {
+  std::atomic<int> sum{0};
+  {
+    ThreadPool pool(4);
+    ASSERT_EQ(pool.num_threads(), 4);
+    for (int i = 1; i <= 100; i++) {
+      pool.Schedule([&sum, i] { sum += i; });
+    }
+    // the scheduled tasks are finished before the pool is destroyed.
+  }
+  ASSERT_EQ(sum.load(), 5050);
+}
+
+}  // namespace utils
+}  // namespace cinn
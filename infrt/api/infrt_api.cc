@@ -19,6 +19,7 @@
 #include "infrt/host_context/value.h"
 #include "infrt/kernel/basic_kernels.h"
 #include "infrt/kernel/control_flow_kernels.h"
+#include "infrt/kernel/pd_fused_kernels.h"
 #include "infrt/kernel/tensor_kernels.h"
 #include "infrt/kernel/tensor_shape_kernels.h"
 #include "infrt/kernel/test_kernels.h"
@@ -59,6 +60,9 @@ struct MlirToRuntimeTranslator::Impl {
   // Map from an operation to its results.
   absl::flat_hash_map<const mlir::Operation*, std::vector<ValueRef>> op_results;
   llvm::DenseMap<mlir::Value, ValueRef> value_map;
+
+  // The Values of the attributes, the attributes are uniqued by MLIR so the ops with an equal attribute share a Value.
+  llvm::DenseMap<mlir::Attribute, ValueRef> attribute_values;
 };
 
 /**
@@ -177,6 +181,7 @@ int CinnRtPredictor::Init(const CinnRtConfig& config) {
   kernel::RegisterTensorShapeKernels(registry);
   kernel::RegisterTensorKernels(registry);
   kernel::RegisterControlFlowKernels(registry);
+  kernel::RegisterPdFusedKernels(registry);
 
   impl_->module_ref = std::move(module_ref);
 
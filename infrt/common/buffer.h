@@ -201,6 +201,9 @@ extern struct cinn_device_interface_t* cinn_x86_device_interface();
 struct Buffer final {
   Buffer() = default;
   explicit Buffer(const infrt::common::Target& target) { SetTarget(target); }
+  Buffer(const Buffer&) = delete;
+  Buffer& operator=(const Buffer&) = delete;
+  ~Buffer() { Free(); }
 
   //! Resize the memory hold by this buffer *exactlly* to \p size.
   void Resize(uint32_t size);
@@ -227,6 +230,8 @@ struct Buffer final {
   void Free() {
     if (!data_.memory) return;
     memory_mng_cache_->free(data_.memory);
+    data_.memory = nullptr;
+    size_        = 0;
   }
 
  private:
@@ -1,19 +1,102 @@
 #include "infrt/common/memory.h"
 
+#include <mutex>
+#include <vector>
+
 namespace infrt {
 
 using infrt::common::Target;
 
 namespace {
 
+/**
+ * The host memory manager, which keeps the freed blocks in the free lists of their size classes, the powers of 2, to
+ * serve the later allocations. The tensors of a function are mostly of the same few sizes in each execution, so the
+ * intermediate tensors of an execution are mostly allocated from the blocks freed before.
+ */
 class X86MemoryMng : public MemoryInterface {
  public:
-  void* malloc(size_t nbytes) override { return ::malloc(nbytes); }
+  void* malloc(size_t nbytes) override {
+    size_t size = SizeClass(nbytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.num_mallocs++;
+    stats_.malloc_bytes += nbytes;
+    auto& blocks = free_blocks_[size];
+    if (!blocks.empty()) {
+      void* data = blocks.back();
+      blocks.pop_back();
+      cached_bytes_ -= size;
+      return data;
+    }
+    void* data = ::aligned_alloc(kAlignment, size);
+    if (data) block_sizes_[data] = size;
+    stats_.num_system_allocs++;
+    stats_.system_alloc_bytes += size;
+    return data;
+  }
+
   void free(void* data) override {
     if (!data) return;
-    ::free(data);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = block_sizes_.find(data);
+    // not from the pool, e.g. by aligned_alloc
+    if (it == block_sizes_.end()) {
+      ::free(data);
+      return;
+    }
+    if (cached_bytes_ + it->second > kMaxCachedBytes) {
+      block_sizes_.erase(it);
+      ::free(data);
+      return;
+    }
+    free_blocks_[it->second].push_back(data);
+    cached_bytes_ += it->second;
+  }
+
+  void* aligned_alloc(size_t alignment, size_t nbytes) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.num_mallocs++;
+    stats_.malloc_bytes += nbytes;
+    stats_.num_system_allocs++;
+    stats_.system_alloc_bytes += nbytes;
+    return ::aligned_alloc(alignment, nbytes);
+  }
+
+  MemoryStats stats() const override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
   }
-  void* aligned_alloc(size_t alignment, size_t nbytes) override { return ::aligned_alloc(alignment, nbytes); }
+
+  void ReleaseCache() override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& item : free_blocks_) {
+      for (void* data : item.second) {
+        block_sizes_.erase(data);
+        ::free(data);
+      }
+      item.second.clear();
+    }
+    cached_bytes_ = 0;
+  }
+
+  ~X86MemoryMng() { ReleaseCache(); }
+
+ private:
+  static constexpr size_t kAlignment = 64;
+  //! The freed blocks beyond it are returned to the system.
+  static constexpr size_t kMaxCachedBytes = 1UL << 30;
+
+  static size_t SizeClass(size_t nbytes) {
+    size_t size = kAlignment;
+    while (size < nbytes) size <<= 1;
+    return size;
+  }
+
+  mutable std::mutex mutex_;
+  absl::flat_hash_map<size_t, std::vector<void*>> free_blocks_;
+  absl::flat_hash_map<void*, size_t> block_sizes_;
+  size_t cached_bytes_{};
+  MemoryStats stats_;
 };
 
 }  // namespace
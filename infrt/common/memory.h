@@ -3,6 +3,7 @@
 #include <absl/container/flat_hash_map.h>
 #include <glog/logging.h>
 
+#include <cstdint>
 #include <memory>
 
 #include "infrt/common/macros.h"
@@ -10,11 +11,24 @@
 
 namespace infrt {
 
+//! The counters of the allocations by a MemoryInterface since it is created.
+struct MemoryStats {
+  //! The allocations and their bytes requested.
+  uint64_t num_mallocs{};
+  uint64_t malloc_bytes{};
+  //! The allocations not served by the cache, which go to the system.
+  uint64_t num_system_allocs{};
+  uint64_t system_alloc_bytes{};
+};
+
 class MemoryInterface {
  public:
   virtual void* malloc(size_t nbytes) = 0;
   virtual void free(void* data)       = 0;
   virtual void* aligned_alloc(size_t alignment, size_t nbytes) { return nullptr; }
+  //! Return the memory cached for the later allocations to the system.
+  virtual void ReleaseCache() {}
+  virtual MemoryStats stats() const { return {}; }
   virtual ~MemoryInterface() {}
 };
 
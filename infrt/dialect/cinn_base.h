@@ -8,6 +8,8 @@
 #include <mlir/IR/TypeUtilities.h>
 #include <mlir/IR/Types.h>
 
+#include <cmath>
+
 #include "infrt/dialect/cinn_base.hpp.inc"
 
 namespace infrt::dialect {
@@ -48,4 +50,29 @@ static mlir::ValueRange concatTwoValueRange(mlir::ValueRange operand_0, mlir::Va
   return operands;
 }
 
+//! Whether \p attr is the float elements of the same value close to \p value.
+static bool isSplatFloatNear(mlir::Attribute attr, double value) {
+  auto elements = attr.dyn_cast<mlir::DenseFPElementsAttr>();
+  if (!elements || !elements.isSplat()) return false;
+  llvm::APFloat splat = elements.getSplatValue<llvm::APFloat>();
+  bool loses_info;
+  splat.convert(llvm::APFloat::IEEEdouble(), llvm::APFloat::rmNearestTiesToEven, &loses_info);
+  return std::abs(splat.convertToDouble() - value) < 1e-5;
+}
+
+//! The value of the splat float elements \p attr as a F32Attr.
+static mlir::FloatAttr getSplatF32Attr(mlir::OpBuilder &b, mlir::Attribute attr) {
+  llvm::APFloat splat = attr.cast<mlir::DenseFPElementsAttr>().getSplatValue<llvm::APFloat>();
+  bool loses_info;
+  splat.convert(llvm::APFloat::IEEEsingle(), llvm::APFloat::rmNearestTiesToEven, &loses_info);
+  return b.getF32FloatAttr(splat.convertToFloat());
+}
+
+//! Whether the dimensions \p attr of a reduction is the last one only.
+static bool isLastAxis(mlir::ArrayAttr attr) {
+  if (attr.size() != 1) return false;
+  auto axis = attr[0].dyn_cast<mlir::IntegerAttr>();
+  return axis && axis.getInt() == -1;
+}
+
 }  // namespace mlir
@@ -0,0 +1,104 @@
+#include "infrt/dialect/dt_buffer_planning.h"
+
+#include <llvm/ADT/DenseMap.h>
+#include <mlir/IR/Builders.h>
+#include <mlir/IR/Function.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "infrt/dialect/dense_tensor.h"
+
+namespace infrt::dt {
+namespace {
+
+constexpr char kUninitPrefix[]  = "dt.create_uninit_tensor.";
+constexpr char kPlannedPrefix[] = "dt.create_planned_tensor.";
+
+//! Whether \p user only accesses the tensor while running, so the buffer is free after it.
+bool IsTransientUser(mlir::Operation* user) {
+  // the copy shares the buffer, its users are not tracked
+  if (llvm::isa<ShallowCopyTensorOp>(user)) return false;
+  if (user->getDialect() && user->getDialect()->getNamespace() == "dt") return true;
+  // cinn.fusion reads its operands and writes new results
+  return user->getName().getStringRef() == "cinn.fusion";
+}
+
+struct BufferPlanningPass : public mlir::PassWrapper<BufferPlanningPass, mlir::FunctionPass> {
+  void runOnFunction() override {
+    for (auto& block : getFunction().getBody()) PlanBlock(&block);
+  }
+
+  void PlanBlock(mlir::Block* block);
+};
+
+void BufferPlanningPass::PlanBlock(mlir::Block* block) {
+  llvm::DenseMap<mlir::Operation*, int> op_ids;
+  int num_ops = 0;
+  for (auto& op : *block) op_ids[&op] = num_ops++;
+
+  //! A planned buffer, free for the tensors created after the last use of the tensor on it.
+  struct Slot {
+    std::string planned_op;
+    mlir::Attribute shape;
+    mlir::Value tensor;
+    int last_use;
+  };
+  std::vector<Slot> slots;
+
+  for (auto it = block->begin(); it != block->end();) {
+    mlir::Operation* op = &*it++;
+    auto name           = op->getName().getStringRef();
+    if (!name.startswith(kUninitPrefix)) continue;
+
+    auto result    = op->getResult(0);
+    int id         = op_ids[op];
+    int last_use   = id;
+    bool plannable = true;
+    for (auto& use : result.getUses()) {
+      auto* user = use.getOwner();
+      if (user->getBlock() != block || !IsTransientUser(user)) {
+        plannable = false;
+        break;
+      }
+      last_use = std::max(last_use, op_ids[user]);
+    }
+    if (!plannable) continue;
+
+    std::string planned_op = kPlannedPrefix + name.drop_front(sizeof(kUninitPrefix) - 1).str();
+    auto shape             = op->getAttr("shape");
+    auto slot              = std::find_if(slots.begin(), slots.end(), [&](const Slot& slot) {
+      return slot.planned_op == planned_op && slot.shape == shape && slot.tensor.getType() == result.getType() &&
+             slot.last_use < id;
+    });
+
+    mlir::OpBuilder builder(op);
+    mlir::Value tensor;
+    if (slot != slots.end()) {
+      tensor         = builder.create<ReuseTensorOp>(op->getLoc(), result.getType(), slot->tensor);
+      slot->tensor   = tensor;
+      slot->last_use = last_use;
+    } else {
+      mlir::OperationState state(op->getLoc(), planned_op);
+      state.addAttributes(op->getAttrs());
+      state.addTypes(result.getType());
+      tensor = builder.createOperation(state)->getResult(0);
+      slots.push_back({planned_op, shape, tensor, last_use});
+    }
+    op_ids[tensor.getDefiningOp()] = id;
+    result.replaceAllUsesWith(tensor);
+    op->erase();
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<mlir::Pass> CreateBufferPlanningPass() { return std::make_unique<BufferPlanningPass>(); }
+
+void RegisterBufferPlanningPass() {
+  mlir::PassRegistration<BufferPlanningPass>("dt-plan-buffers",
+                                             "Preallocate and reuse the buffers of the uninitialized tensors");
+}
+
+}  // namespace infrt::dt
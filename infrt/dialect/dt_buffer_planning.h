@@ -0,0 +1,20 @@
+#pragma once
+
+#include <mlir/Pass/Pass.h>
+
+#include <memory>
+
+namespace infrt::dt {
+
+/**
+ * Create the pass planning the buffers of the uninitialized tensors of the functions. The tensors of the static shapes
+ * that are only used by the dt ops and cinn.fusion in the same block, never returned nor aliased, are preallocated in
+ * the first execution by dt.create_planned_tensor, and a tensor created after the last use of a planned one of the
+ * same shape takes over its buffer by dt.reuse_tensor. So the steady executions allocate none of them.
+ */
+std::unique_ptr<mlir::Pass> CreateBufferPlanningPass();
+
+//! Register the pass as `dt-plan-buffers` to the pass drivers.
+void RegisterBufferPlanningPass();
+
+}  // namespace infrt::dt
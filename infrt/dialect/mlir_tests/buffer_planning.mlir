@@ -0,0 +1,26 @@
+// CHECK-LABEL: @plan_buffers
+func @plan_buffers() -> !cinn.tensor<X86, NCHW, F32> {
+  // CHECK: %[[A:.*]] = dt.create_planned_tensor.f32
+  %a = dt.create_uninit_tensor.f32 [2:i64, 3:i64] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%a : !cinn.tensor<X86, NCHW, F32>) {value=1.0:f32}
+  dt.print_tensor (%a : !cinn.tensor<X86, NCHW, F32>)
+
+  // created after the last use of %a, it takes over the buffer of %a
+  // CHECK: %[[B:.*]] = dt.reuse_tensor %[[A]]
+  %b = dt.create_uninit_tensor.f32 [2:i64, 3:i64] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%b : !cinn.tensor<X86, NCHW, F32>) {value=2.0:f32}
+
+  // live together with %b
+  // CHECK: %[[C:.*]] = dt.create_planned_tensor.f32
+  %c = dt.create_uninit_tensor.f32 [2:i64, 3:i64] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%c : !cinn.tensor<X86, NCHW, F32>) {value=3.0:f32}
+  dt.print_tensor (%b : !cinn.tensor<X86, NCHW, F32>)
+  dt.print_tensor (%c : !cinn.tensor<X86, NCHW, F32>)
+
+  // returned to the caller, so it is created in each execution
+  // CHECK: %[[D:.*]] = dt.create_uninit_tensor.f32
+  %d = dt.create_uninit_tensor.f32 [2:i64, 3:i64] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%d : !cinn.tensor<X86, NCHW, F32>) {value=4.0:f32}
+  // CHECK: cinn.return %[[D]]
+  cinn.return %d : !cinn.tensor<X86, NCHW, F32>
+}
@@ -0,0 +1,62 @@
+// CHECK-LABEL: @fuse_fc_relu
+func @fuse_fc_relu() -> tensor<?xf32> {
+  %a = "pd.Feed"() : () -> tensor<?xf32>
+  %b = "pd.Feed"() : () -> tensor<?xf32>
+  %bias = "pd.Feed"() : () -> tensor<?xf32>
+
+  // CHECK: "pd.RepeatedFCRelu"
+  %c = "pd.Matmul"(%a, %b) {transpose_x=false, transpose_y=false} : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  %d = "pd.ElementwiseAdd"(%bias, %c) {axis=1:i32} : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  %e = "pd.Relu"(%d) {} : (tensor<?xf32>) -> tensor<?xf32>
+  cinn.return %e : tensor<?xf32>
+}
+
+// CHECK-LABEL: @fuse_conv_relu
+func @fuse_conv_relu() -> tensor<?x64x254x254xf32> {
+  %a = "pd.Feed"() : () -> tensor<?x3x256x256xf32>
+  %filter = "pd.Feed"() : () -> tensor<64x3x3x3xf32>
+  %bias = "pd.Feed"() : () -> tensor<64xf32>
+
+  // CHECK: "pd.FusedConv2dRelu"
+  %c = "pd.conv2d"(%a, %filter, %bias) {} : (tensor<?x3x256x256xf32>, tensor<64x3x3x3xf32>, tensor<64xf32>) -> tensor<?x64x254x254xf32>
+  %d = "pd.Relu"(%c) {} : (tensor<?x64x254x254xf32>) -> tensor<?x64x254x254xf32>
+  cinn.return %d : tensor<?x64x254x254xf32>
+}
+
+// CHECK-LABEL: @fuse_layer_norm
+func @fuse_layer_norm() -> tensor<8x768xf32> {
+  %x = "pd.Feed"() : () -> tensor<8x768xf32>
+  %scale = "pd.Feed"() : () -> tensor<768xf32>
+  %bias = "pd.Feed"() : () -> tensor<768xf32>
+  %eps = "pd.Constant"() {value = dense<1.000000e-05> : tensor<1xf32>} : () -> tensor<1xf32>
+
+  // CHECK: "pd.layer_norm"
+  // CHECK-NOT: "pd.reduce_mean"
+  %mean = "pd.reduce_mean"(%x) {dim = [-1], keep_dim = true} : (tensor<8x768xf32>) -> tensor<8x1xf32>
+  %z = "pd.ElementwiseSub"(%x, %mean) {axis = -1 : i32} : (tensor<8x768xf32>, tensor<8x1xf32>) -> tensor<8x768xf32>
+  %z2 = "pd.ElementwiseMul"(%z, %z) {axis = -1 : i32} : (tensor<8x768xf32>, tensor<8x768xf32>) -> tensor<8x768xf32>
+  %var = "pd.reduce_mean"(%z2) {dim = [-1], keep_dim = true} : (tensor<8x768xf32>) -> tensor<8x1xf32>
+  %var_eps = "pd.ElementwiseAdd"(%var, %eps) {axis = -1 : i32} : (tensor<8x1xf32>, tensor<1xf32>) -> tensor<8x1xf32>
+  %std = "pd.sqrt"(%var_eps) : (tensor<8x1xf32>) -> tensor<8x1xf32>
+  %norm = "pd.ElementwiseDiv"(%z, %std) {axis = -1 : i32} : (tensor<8x768xf32>, tensor<8x1xf32>) -> tensor<8x768xf32>
+  %scaled = "pd.ElementwiseMul"(%norm, %scale) {axis = -1 : i32} : (tensor<8x768xf32>, tensor<768xf32>) -> tensor<8x768xf32>
+  %out = "pd.ElementwiseAdd"(%scaled, %bias) {axis = -1 : i32} : (tensor<8x768xf32>, tensor<768xf32>) -> tensor<8x768xf32>
+  cinn.return %out : tensor<8x768xf32>
+}
+
+// CHECK-LABEL: @fuse_gelu
+func @fuse_gelu() -> tensor<8x768xf32> {
+  %x = "pd.Feed"() : () -> tensor<8x768xf32>
+  %half = "pd.Constant"() {value = dense<5.000000e-01> : tensor<1xf32>} : () -> tensor<1xf32>
+  %one = "pd.Constant"() {value = dense<1.000000e+00> : tensor<1xf32>} : () -> tensor<1xf32>
+  %inv_sqrt2 = "pd.Constant"() {value = dense<0.707106769> : tensor<1xf32>} : () -> tensor<1xf32>
+
+  // CHECK: "pd.gelu"
+  // CHECK-NOT: "pd.erf"
+  %a = "pd.ElementwiseMul"(%x, %half) {axis = -1 : i32} : (tensor<8x768xf32>, tensor<1xf32>) -> tensor<8x768xf32>
+  %b = "pd.ElementwiseMul"(%x, %inv_sqrt2) {axis = -1 : i32} : (tensor<8x768xf32>, tensor<1xf32>) -> tensor<8x768xf32>
+  %c = "pd.erf"(%b) : (tensor<8x768xf32>) -> tensor<8x768xf32>
+  %d = "pd.ElementwiseAdd"(%c, %one) {axis = -1 : i32} : (tensor<8x768xf32>, tensor<1xf32>) -> tensor<8x768xf32>
+  %out = "pd.ElementwiseMul"(%a, %d) {axis = -1 : i32} : (tensor<8x768xf32>, tensor<8x768xf32>) -> tensor<8x768xf32>
+  cinn.return %out : tensor<8x768xf32>
+}
@@ -0,0 +1,64 @@
+// CHECK-LABEL: @fc
+func @fc(%x : tensor<2x3xf32>, %w : tensor<3x2xf32>, %b : tensor<2xf32>) -> tensor<2x2xf32> {
+  %y = "pd.FC"(%x, %w, %b) {in_num_col_dims = 1 : i32} : (tensor<2x3xf32>, tensor<3x2xf32>, tensor<2xf32>) -> tensor<2x2xf32>
+  cinn.return %y : tensor<2x2xf32>
+}
+
+// CHECK-LABEL: @conv2d_relu
+func @conv2d_relu(%x : tensor<1x1x3x3xf32>, %filter : tensor<1x1x2x2xf32>, %b : tensor<1xf32>) -> tensor<1x1x2x2xf32> {
+  %y = "pd.FusedConv2dRelu"(%x, %filter, %b) : (tensor<1x1x3x3xf32>, tensor<1x1x2x2xf32>, tensor<1xf32>) -> tensor<1x1x2x2xf32>
+  cinn.return %y : tensor<1x1x2x2xf32>
+}
+
+// CHECK-LABEL: @layer_norm
+func @layer_norm(%x : tensor<2x3xf32>, %scale : tensor<3xf32>, %b : tensor<3xf32>) -> tensor<2x3xf32> {
+  %y = "pd.layer_norm"(%x, %scale, %b) {epsilon = 1.0e-05 : f32, begin_norm_axis = -1 : i32} : (tensor<2x3xf32>, tensor<3xf32>, tensor<3xf32>) -> tensor<2x3xf32>
+  cinn.return %y : tensor<2x3xf32>
+}
+
+// CHECK-LABEL: @gelu
+func @gelu(%x : tensor<2x3xf32>) -> tensor<2x3xf32> {
+  %y = "pd.gelu"(%x) : (tensor<2x3xf32>) -> tensor<2x3xf32>
+  cinn.return %y : tensor<2x3xf32>
+}
+
+// CHECK-LABEL: @main
+func @main() {
+  %x = dt.create_uninit_tensor.f32 [2:i64, 3:i64] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%x : !cinn.tensor<X86, NCHW, F32>) {value=1.0:f32}
+  %w = dt.create_uninit_tensor.f32 [3:i64, 2:i64] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%w : !cinn.tensor<X86, NCHW, F32>) {value=2.0:f32}
+  %b = dt.create_uninit_tensor.f32 [2:i64] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%b : !cinn.tensor<X86, NCHW, F32>) {value=1.0:f32}
+
+  // CHECK: tensor: shape=shape[2,2], values=[7, 7, 7, 7]
+  %fc = cinn.call @fc(%x, %w, %b) : (!cinn.tensor<X86, NCHW, F32>, !cinn.tensor<X86, NCHW, F32>, !cinn.tensor<X86, NCHW, F32>) -> (!cinn.tensor<X86, NCHW, F32>)
+  dt.print_tensor (%fc : !cinn.tensor<X86, NCHW, F32>)
+
+  %image = dt.create_uninit_tensor.f32 [1:i64, 1:i64, 3:i64, 3:i64] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%image : !cinn.tensor<X86, NCHW, F32>) {value=1.0:f32}
+  %filter = dt.create_uninit_tensor.f32 [1:i64, 1:i64, 2:i64, 2:i64] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%filter : !cinn.tensor<X86, NCHW, F32>) {value=1.0:f32}
+  %conv_b = dt.create_uninit_tensor.f32 [1:i64] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%conv_b : !cinn.tensor<X86, NCHW, F32>) {value=-2.0:f32}
+
+  // CHECK: tensor: shape=shape[1,1,2,2], values=[2, 2, 2, 2]
+  %conv = cinn.call @conv2d_relu(%image, %filter, %conv_b) : (!cinn.tensor<X86, NCHW, F32>, !cinn.tensor<X86, NCHW, F32>, !cinn.tensor<X86, NCHW, F32>) -> (!cinn.tensor<X86, NCHW, F32>)
+  dt.print_tensor (%conv : !cinn.tensor<X86, NCHW, F32>)
+
+  %scale = dt.create_uninit_tensor.f32 [3:i64] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%scale : !cinn.tensor<X86, NCHW, F32>) {value=2.0:f32}
+  %shift = dt.create_uninit_tensor.f32 [3:i64] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%shift : !cinn.tensor<X86, NCHW, F32>) {value=0.5:f32}
+
+  // the rows are constant, so they are normalized to zero and shifted
+  // CHECK: tensor: shape=shape[2,3], values=[0.5, 0.5, 0.5, 0.5, 0.5, 0.5]
+  %norm = cinn.call @layer_norm(%x, %scale, %shift) : (!cinn.tensor<X86, NCHW, F32>, !cinn.tensor<X86, NCHW, F32>, !cinn.tensor<X86, NCHW, F32>) -> (!cinn.tensor<X86, NCHW, F32>)
+  dt.print_tensor (%norm : !cinn.tensor<X86, NCHW, F32>)
+
+  // CHECK: tensor: shape=shape[2,3], values=[0.841345, 0.841345, 0.841345, 0.841345, 0.841345, 0.841345]
+  %gelu = cinn.call @gelu(%x) : (!cinn.tensor<X86, NCHW, F32>) -> (!cinn.tensor<X86, NCHW, F32>)
+  dt.print_tensor (%gelu : !cinn.tensor<X86, NCHW, F32>)
+
+  cinn.return
+}
@@ -0,0 +1,14 @@
+// CHECK-LABEL: @infer_shapes
+func @infer_shapes() -> tensor<?x?xf32> {
+  %a = "pd.Feed"() : () -> tensor<2x3xf32>
+  %b = "pd.Feed"() : () -> tensor<3x4xf32>
+  %bias = "pd.Feed"() : () -> tensor<4xf32>
+
+  // CHECK: "pd.Matmul"{{.*}} -> tensor<2x4xf32>
+  %c = "pd.Matmul"(%a, %b) {transpose_x=false, transpose_y=false} : (tensor<2x3xf32>, tensor<3x4xf32>) -> tensor<?x?xf32>
+  // CHECK: "pd.ElementwiseAdd"{{.*}} -> tensor<2x4xf32>
+  %d = "pd.ElementwiseAdd"(%c, %bias) {axis=1:i32} : (tensor<?x?xf32>, tensor<4xf32>) -> tensor<?x?xf32>
+  // CHECK: "pd.Relu"{{.*}} -> tensor<2x4xf32>
+  %e = "pd.Relu"(%d) : (tensor<?x?xf32>) -> tensor<?x?xf32>
+  cinn.return %e : tensor<?x?xf32>
+}
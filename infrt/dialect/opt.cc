@@ -15,8 +15,11 @@
 #include <iostream>
 
 #include "infrt/common/global.h"
+#include "infrt/dialect/dt_buffer_planning.h"
 #include "infrt/dialect/init_cinn_dialects.h"
 #include "infrt/dialect/mlir_loader.h"
+#include "infrt/dialect/pd_fusion.h"
+#include "infrt/dialect/pd_shape_inference.h"
 
 int main(int argc, char **argv) {
   mlir::MLIRContext *context = infrt::Global::getMLIRContext();
@@ -25,6 +28,9 @@ int main(int argc, char **argv) {
   infrt::RegisterCinnDialects(registry);
 
   mlir::registerCanonicalizerPass();
+  infrt::RegisterPdShapeInferencePass();
+  infrt::RegisterPdFusionPass();
+  infrt::dt::RegisterBufferPlanningPass();
 
   return mlir::failed(mlir::MlirOptMain(argc, argv, "CINN mlir pass driver", registry));
 }
@@ -0,0 +1,28 @@
+#include "infrt/dialect/pd_fusion.h"
+
+#include <mlir/IR/Function.h>
+#include <mlir/IR/PatternMatch.h>
+#include <mlir/Transforms/GreedyPatternRewriteDriver.h>
+
+#include "infrt/dialect/pd_ops.h"
+
+namespace infrt {
+namespace {
+
+struct PdFusionPass : public mlir::PassWrapper<PdFusionPass, mlir::FunctionPass> {
+  void runOnFunction() override {
+    mlir::OwningRewritePatternList patterns;
+    mlir::pd::PopulateFusionPatterns(&getContext(), &patterns);
+    if (mlir::failed(mlir::applyPatternsAndFoldGreedily(getFunction(), patterns))) signalPassFailure();
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<mlir::Pass> CreatePdFusionPass() { return std::make_unique<PdFusionPass>(); }
+
+void RegisterPdFusionPass() {
+  mlir::PassRegistration<PdFusionPass>("pd-fuse-ops", "Fuse the common subgraphs of the pd ops into the fused ops");
+}
+
+}  // namespace infrt
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <mlir/Pass/Pass.h>
+
+#include <memory>
+
+namespace infrt {
+
+/**
+ * Create the pass fusing the common subgraphs of the pd ops into the fused ops with the infrt kernels, which are
+ * Matmul + ElementwiseAdd (+ Relu) into FC (RepeatedFCRelu), conv2d (+ batch_norm) + Relu into FusedConv2dRelu, and
+ * the decompositions of layer_norm and gelu. The canonicalization only applies the first ones.
+ */
+std::unique_ptr<mlir::Pass> CreatePdFusionPass();
+
+//! Register the pass as `pd-fuse-ops` to the pass drivers.
+void RegisterPdFusionPass();
+
+}  // namespace infrt
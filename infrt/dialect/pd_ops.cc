@@ -32,6 +32,10 @@ mlir::Operation *PaddleDialect::materializeConstant(mlir::OpBuilder &builder,
 
 #include "infrt/dialect/rewrite.hpp.inc"
 
+void PopulateFusionPatterns(MLIRContext *context, OwningRewritePatternList *patterns) {
+  populateWithGenerated(context, patterns);
+}
+
 void ConstantOp::build(OpBuilder &builder, OperationState &state, Attribute value) {
   if (auto elem_attr = value.dyn_cast<ElementsAttr>()) {
     return ConstantOp::build(builder, state, elem_attr);
@@ -8,6 +8,7 @@
 #include "mlir/IR/Matchers.h"
 #include "mlir/IR/Module.h"
 #include "mlir/IR/OpImplementation.h"
+#include "mlir/IR/PatternMatch.h"
 #include "mlir/IR/StandardTypes.h"
 #include "mlir/IR/TypeUtilities.h"
 #include "mlir/Interfaces/CallInterfaces.h"
@@ -32,5 +33,8 @@ class PaddleDialect : public Dialect {
   void printType(Type type, DialectAsmPrinter& printer) const override { Dialect::printType(type, printer); }
 };
 
+//! Populate all the patterns of rewrite.td, which fuse the common subgraphs of the pd ops into the fused ones.
+void PopulateFusionPatterns(MLIRContext* context, OwningRewritePatternList* patterns);
+
 }  // namespace pd
 }  // namespace mlir
@@ -0,0 +1,99 @@
+#include "infrt/dialect/pd_shape_inference.h"
+
+#include <mlir/IR/Function.h>
+#include <mlir/IR/StandardTypes.h>
+#include <mlir/IR/TypeUtilities.h>
+
+#include "infrt/dialect/pd_ops.h"
+
+namespace infrt {
+namespace {
+
+using shape_t = llvm::SmallVector<int64_t, 4>;
+
+//! The shape of \p value if it is a ranked tensor of the static shape.
+llvm::Optional<shape_t> GetStaticShape(mlir::Value value) {
+  auto type = value.getType().dyn_cast<mlir::RankedTensorType>();
+  if (!type || !type.hasStaticShape()) return llvm::None;
+  return shape_t(type.getShape().begin(), type.getShape().end());
+}
+
+llvm::Optional<shape_t> InferMatmul(const shape_t& x, const shape_t& y, bool transpose_x, bool transpose_y) {
+  if (x.size() < 2 || y.size() < 2) return llvm::None;
+  int64_t m   = transpose_x ? x[x.size() - 1] : x[x.size() - 2];
+  int64_t k_x = transpose_x ? x[x.size() - 2] : x[x.size() - 1];
+  int64_t k_y = transpose_y ? y[y.size() - 1] : y[y.size() - 2];
+  int64_t n   = transpose_y ? y[y.size() - 2] : y[y.size() - 1];
+  if (k_x != k_y) return llvm::None;
+  // the batch dimensions are of the operand of the higher rank
+  const shape_t& batch = x.size() >= y.size() ? x : y;
+  shape_t res(batch.begin(), batch.end() - 2);
+  res.push_back(m);
+  res.push_back(n);
+  return res;
+}
+
+//! Infer the static shape of the single result of \p op, None if the op is not supported or not static.
+llvm::Optional<shape_t> InferShape(mlir::Operation* op) {
+  if (op->getNumResults() != 1 || op->getNumOperands() == 0) return llvm::None;
+  for (auto operand : op->getOperands()) {
+    if (!GetStaticShape(operand)) return llvm::None;
+  }
+
+  if (op->hasTrait<mlir::OpTrait::SameOperandsAndResultType>()) return GetStaticShape(op->getOperand(0));
+  if (auto matmul = llvm::dyn_cast<mlir::pd::MatmulOp>(op)) {
+    return InferMatmul(*GetStaticShape(matmul.x()),
+                       *GetStaticShape(matmul.y()),
+                       matmul.transpose_x(),
+                       matmul.transpose_y());
+  }
+  // the elementwise ops and mul, the refined types should agree with their own inference to pass the verifier
+  if (auto infer = llvm::dyn_cast<mlir::InferTypeOpInterface>(op)) {
+    llvm::SmallVector<mlir::Type, 1> types;
+    if (mlir::failed(infer.inferReturnTypes(op->getContext(),
+                                            op->getLoc(),
+                                            op->getOperands(),
+                                            op->getAttrDictionary(),
+                                            op->getRegions(),
+                                            types)) ||
+        types.size() != 1) {
+      return llvm::None;
+    }
+    auto type = types[0].dyn_cast<mlir::RankedTensorType>();
+    if (!type || !type.hasStaticShape()) return llvm::None;
+    return shape_t(type.getShape().begin(), type.getShape().end());
+  }
+  return llvm::None;
+}
+
+struct PdShapeInferencePass : public mlir::PassWrapper<PdShapeInferencePass, mlir::FunctionPass> {
+  void runOnFunction() override {
+    // the ops are visited in order, including the ones in the regions of cinn.fusion, so the shapes flow forward
+    getFunction().walk([&](mlir::Operation* op) {
+      if (op->getDialect() == nullptr || op->getDialect()->getNamespace() != "pd") return;
+      auto shape = InferShape(op);
+      if (!shape) return;
+      auto result = op->getResult(0);
+      auto type   = result.getType().dyn_cast<mlir::TensorType>();
+      if (!type) return;
+      if (type.hasStaticShape()) {
+        if (type.getShape() != llvm::ArrayRef<int64_t>(*shape)) {
+          op->emitError("the static shape of the result conflicts with the one inferred from the operands");
+          signalPassFailure();
+        }
+        return;
+      }
+      result.setType(mlir::RankedTensorType::get(*shape, type.getElementType()));
+    });
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<mlir::Pass> CreatePdShapeInferencePass() { return std::make_unique<PdShapeInferencePass>(); }
+
+void RegisterPdShapeInferencePass() {
+  mlir::PassRegistration<PdShapeInferencePass>("pd-infer-shapes", "Propagate the static shapes through the pd ops");
+}
+
+}  // namespace infrt
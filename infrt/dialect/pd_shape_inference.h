@@ -0,0 +1,20 @@
+#pragma once
+
+#include <mlir/Pass/Pass.h>
+
+#include <memory>
+
+namespace infrt {
+
+/**
+ * Create the pass propagating the static shapes through the pd ops. The results of the activation ops, the ops
+ * inferring their types and Matmul are refined to the static ranked tensors when the shapes of their operands are
+ * static, so the later passes and the CINN compilation see the shapes without running the program. The ops of other
+ * kinds or with the dynamic operands are left as they are.
+ */
+std::unique_ptr<mlir::Pass> CreatePdShapeInferencePass();
+
+//! Register the pass as `pd-infer-shapes` to the pass drivers.
+void RegisterPdShapeInferencePass();
+
+}  // namespace infrt
@@ -0,0 +1,21 @@
+// CHECK-LABEL: @fusion
+func @fusion() {
+  %a = dt.create_uninit_tensor.f32 [2, 3] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%a : !cinn.tensor<X86, NCHW, F32>) {value=1.0:f32}
+  %b = dt.create_uninit_tensor.f32 [2, 3] -> !cinn.tensor<X86, NCHW, F32>
+  dt.fill_tensor_with_constant.f32 (%b : !cinn.tensor<X86, NCHW, F32>) {value=-3.0:f32}
+
+  // relu(a - b) * a, fused into one kernel
+  %c = "cinn.fusion"(%a, %b) ({
+  ^bb0(%x : tensor<2x3xf32>, %y : tensor<2x3xf32>):
+    %z = "pd.ElementwiseSub"(%x, %y) {axis = -1 : i32} : (tensor<2x3xf32>, tensor<2x3xf32>) -> tensor<2x3xf32>
+    %r = "pd.Relu"(%z) : (tensor<2x3xf32>) -> tensor<2x3xf32>
+    %m = "pd.ElementwiseMul"(%r, %x) {axis = -1 : i32} : (tensor<2x3xf32>, tensor<2x3xf32>) -> tensor<2x3xf32>
+    cinn.return %m : tensor<2x3xf32>
+  }) : (!cinn.tensor<X86, NCHW, F32>, !cinn.tensor<X86, NCHW, F32>) -> !cinn.tensor<X86, NCHW, F32>
+
+  // CHECK: tensor: shape=shape[2,3], values=[4, 4, 4, 4, 4, 4]
+  dt.print_tensor (%c : !cinn.tensor<X86, NCHW, F32>)
+
+  cinn.return
+}
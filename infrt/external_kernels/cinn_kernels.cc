@@ -0,0 +1,233 @@
+#include <absl/container/flat_hash_map.h>
+#include <glog/logging.h>
+#include <llvm/ADT/DenseMap.h>
+#include <mlir/IR/Attributes.h>
+#include <mlir/IR/Function.h>
+#include <mlir/IR/Operation.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cinn/common/target.h"
+#include "cinn/frontend/syntax.h"
+#include "cinn/hlir/framework/graph.h"
+#include "cinn/hlir/framework/graph_compiler.h"
+#include "cinn/hlir/framework/pass.h"
+#include "cinn/hlir/op/use_ops.h"
+#include "cinn/hlir/pass/use_pass.h"
+#include "infrt/host_context/kernel_registry.h"
+#include "infrt/host_context/kernel_utils.h"
+#include "infrt/host_context/mlir_function_executable.h"
+#include "infrt/tensor/dense_host_tensor.h"
+
+namespace infrt::kernel {
+
+using host_context::MlirFunctionExecutable;
+using host_context::Value;
+using tensor::DenseHostTensor;
+
+namespace {
+
+std::vector<int> GetShape(const DenseHostTensor& tensor) {
+  std::vector<int> shape;
+  for (int i = 0; i < tensor.shape().GetRank(); i++) shape.push_back(tensor.shape().GetDim(i));
+  return shape;
+}
+
+/**
+ * A region of pd ops compiled by CINN for the shapes of its inputs. The compiled program reads and writes the buffers
+ * of the DenseHostTensors directly, they are bound to it once and only their memory is updated in each run.
+ */
+class CinnCompiledRegion {
+ public:
+  CinnCompiledRegion(mlir::Region* region, llvm::ArrayRef<Value*> inputs);
+
+  //! Whether the region is compiled for the shapes of \p inputs.
+  bool Match(llvm::ArrayRef<Value*> inputs) const;
+
+  void Run(llvm::ArrayRef<Value*> inputs, llvm::MutableArrayRef<Value*> outputs);
+
+ private:
+  //! Translate the pd ops of the region to a CINN program.
+  cinn::frontend::Program Translate(mlir::Region* region, llvm::ArrayRef<Value*> inputs);
+
+  std::vector<std::vector<int>> input_shapes_;
+  std::vector<std::string> input_names_;
+  std::vector<std::string> output_names_;
+  std::vector<std::vector<int>> output_shapes_;
+
+  std::shared_ptr<cinn::hlir::framework::Scope> scope_;
+  std::unique_ptr<cinn::hlir::framework::GraphCompiler> graph_compiler_;
+  std::unique_ptr<cinn::hlir::framework::Program> runtime_program_;
+  // bound to the runtime program, so they are never reallocated
+  std::vector<cinn_buffer_t> input_buffers_;
+  std::vector<cinn_buffer_t> output_buffers_;
+};
+
+CinnCompiledRegion::CinnCompiledRegion(mlir::Region* region, llvm::ArrayRef<Value*> inputs) {
+  auto program = Translate(region, inputs);
+  auto target  = cinn::common::DefaultHostTarget();
+
+  std::unordered_set<std::string> fetch_ids(output_names_.begin(), output_names_.end());
+  auto graph = std::make_shared<cinn::hlir::framework::Graph>(program, fetch_ids, target);
+  cinn::hlir::framework::ApplyPass(graph.get(), "InferShape");
+  cinn::hlir::framework::ApplyPass(graph.get(), "OpFusion");
+  scope_ = cinn::hlir::framework::BuildScope(target, graph);
+  graph_compiler_.reset(new cinn::hlir::framework::GraphCompiler(target, scope_, graph));
+  runtime_program_ = graph_compiler_->Build();
+
+  auto make_buffer = [](const std::vector<int>& shape) {
+    cinn_buffer_t buffer;
+    buffer.device = cinn_x86_device;
+    buffer.type   = cinn_float32_t();
+    buffer.resize(shape.data(), shape.size());
+    buffer.memory_size = buffer.num_elements() * sizeof(float);
+    return buffer;
+  };
+  for (auto& shape : input_shapes_) input_buffers_.push_back(make_buffer(shape));
+  for (auto& name : output_names_) {
+    output_shapes_.push_back(scope_->GetTensor(name)->shape().data());
+    output_buffers_.push_back(make_buffer(output_shapes_.back()));
+  }
+  for (int i = 0; i < input_names_.size(); i++) runtime_program_->BindInput(input_names_[i], &input_buffers_[i]);
+  for (int i = 0; i < output_names_.size(); i++) runtime_program_->BindOutput(output_names_[i], &output_buffers_[i]);
+}
+
+cinn::frontend::Program CinnCompiledRegion::Translate(mlir::Region* region, llvm::ArrayRef<Value*> inputs) {
+  using cinn::frontend::Variable;
+  CHECK_EQ(region->getBlocks().size(), 1UL) << "region with more than one block is not supported yet";
+  auto& block = region->front();
+  CHECK_EQ(block.getNumArguments(), inputs.size());
+
+  cinn::frontend::Program program;
+  llvm::DenseMap<mlir::Value, Variable> vars;
+  std::vector<Variable> input_vars;
+  for (int i = 0; i < inputs.size(); i++) {
+    auto& tensor = inputs[i]->get<DenseHostTensor>();
+    CHECK(tensor.metadata().dtype == GetDType<float>()) << "cinn.fusion only supports the float32 tensors";
+    input_shapes_.push_back(GetShape(tensor));
+    cinn::frontend::Placeholder placeholder(cinn::common::Float(32), input_shapes_.back());
+    input_names_.emplace_back(placeholder.id());
+    input_vars.push_back(placeholder);
+    vars[block.getArgument(i)] = input_vars.back();
+  }
+  program.SetInputs(input_vars);
+
+  auto get_var = [&](mlir::Value value) {
+    auto it = vars.find(value);
+    CHECK(it != vars.end()) << "the operand is not defined in the region";
+    return it->second;
+  };
+  auto get_int = [](mlir::Operation& op, const char* name, int default_value) {
+    auto attr = op.getAttrOfType<mlir::IntegerAttr>(name);
+    return attr ? static_cast<int>(attr.getInt()) : default_value;
+  };
+  auto get_bool = [](mlir::Operation& op, const char* name) {
+    auto attr = op.getAttrOfType<mlir::BoolAttr>(name);
+    return attr && attr.getValue();
+  };
+
+  for (auto& op : block) {
+    auto name = op.getName().getStringRef();
+    if (name == "cinn.return") {
+      for (auto operand : op.getOperands()) {
+        auto var = get_var(operand);
+        CHECK(std::find(input_names_.begin(), input_names_.end(), var->id) == input_names_.end())
+            << "returning an argument of cinn.fusion directly is not supported";
+        output_names_.push_back(var->id);
+      }
+      break;
+    }
+
+    Variable out;
+    if (name == "pd.ElementwiseAdd") {
+      out = program.elementwise_add(get_var(op.getOperand(0)), get_var(op.getOperand(1)), get_int(op, "axis", -1));
+    } else if (name == "pd.ElementwiseSub") {
+      out = program.elementwise_sub(get_var(op.getOperand(0)), get_var(op.getOperand(1)), get_int(op, "axis", -1));
+    } else if (name == "pd.ElementwiseMul") {
+      out = program.elementwise_mul(get_var(op.getOperand(0)), get_var(op.getOperand(1)), get_int(op, "axis", -1));
+    } else if (name == "pd.ElementwiseDiv") {
+      out = program.elementwise_div(get_var(op.getOperand(0)), get_var(op.getOperand(1)), get_int(op, "axis", -1));
+    } else if (name == "pd.Relu") {
+      out = program.relu(get_var(op.getOperand(0)));
+    } else if (name == "pd.Relu6") {
+      out = program.relu6(get_var(op.getOperand(0)));
+    } else if (name == "pd.sqrt") {
+      out = program.sqrt(get_var(op.getOperand(0)));
+    } else if (name == "pd.Abs") {
+      out = program.abs(get_var(op.getOperand(0)));
+    } else if (name == "pd.mul") {
+      out = program.mul(get_var(op.getOperand(0)), get_var(op.getOperand(1)));
+    } else if (name == "pd.Matmul") {
+      auto alpha = op.getAttrOfType<mlir::FloatAttr>("alpha");
+      out        = program.matmul(get_var(op.getOperand(0)),
+                           get_var(op.getOperand(1)),
+                           get_bool(op, "transpose_x"),
+                           get_bool(op, "transpose_y"),
+                           alpha ? alpha.getValueAsDouble() : 1.f);
+    } else {
+      LOG(FATAL) << "The op " << name.str() << " is not supported by cinn.fusion yet";
+    }
+    CHECK_EQ(op.getNumResults(), 1U);
+    vars[op.getResult(0)] = out;
+  }
+  CHECK(!output_names_.empty()) << "the region of cinn.fusion should return its results by cinn.return";
+  return program;
+}
+
+bool CinnCompiledRegion::Match(llvm::ArrayRef<Value*> inputs) const {
+  for (int i = 0; i < inputs.size(); i++) {
+    if (GetShape(inputs[i]->get<DenseHostTensor>()) != input_shapes_[i]) return false;
+  }
+  return true;
+}
+
+void CinnCompiledRegion::Run(llvm::ArrayRef<Value*> inputs, llvm::MutableArrayRef<Value*> outputs) {
+  CHECK_EQ(outputs.size(), output_buffers_.size());
+  for (int i = 0; i < inputs.size(); i++) {
+    input_buffers_[i].memory = static_cast<uint8_t*>(inputs[i]->get<DenseHostTensor>().raw_data());
+  }
+  for (int i = 0; i < outputs.size(); i++) {
+    std::vector<int64_t> shape(output_shapes_[i].begin(), output_shapes_[i].end());
+    DenseHostTensor tensor(tensor::TensorShape(shape), GetDType<float>());
+    output_buffers_[i].memory = static_cast<uint8_t*>(tensor.raw_data());
+    outputs[i]->set(std::move(tensor));
+  }
+  runtime_program_->Execute();
+}
+
+}  // namespace
+
+/**
+ * Run the region of a cinn.fusion op by CINN. The region is compiled in the first run, and compiled again if the
+ * shapes of the arguments change.
+ */
+static void CinnFusion(host_context::RemainingArguments args,
+                       host_context::RemainingResults results,
+                       host_context::Attribute<MlirFunctionExecutable*> fn) {
+  static std::mutex mutex;
+  static absl::flat_hash_map<const MlirFunctionExecutable*, std::unique_ptr<CinnCompiledRegion>> compiled_regions;
+
+  CinnCompiledRegion* compiled{};
+  {
+    // the ops may run concurrently, each of them has its own executable
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& item = compiled_regions[fn.get()];
+    if (!item || !item->Match(args.values())) {
+      VLOG(3) << "compiling the region of cinn.fusion by CINN";
+      item.reset(new CinnCompiledRegion(fn.get()->region(), args.values()));
+    }
+    compiled = item.get();
+  }
+  compiled->Run(args.values(), results.values());
+}
+
+}  // namespace infrt::kernel
+
+void RegisterKernels(infrt::host_context::KernelRegistry *registry) {
+  registry->AddKernel("cinn.fusion", CINN_KERNEL(infrt::kernel::CinnFusion));
+}
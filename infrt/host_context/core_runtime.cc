@@ -1,10 +1,19 @@
 #include "infrt/host_context/core_runtime.h"
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "infrt/host_context/host_context.h"
+#include "infrt/host_context/kernel_frame.h"
 #include "infrt/host_context/kernel_registry.h"
 #include "infrt/host_context/op_executable.h"
 #include "infrt/host_context/symbol_table.h"
@@ -12,30 +21,205 @@
 namespace infrt::host_context {
 
 struct CoreRuntime::Impl {
+  //! The states of the async execution, reused across the executions so that none of them allocates.
+  struct AsyncExecution {
+    HostContext* host_context{};
+    std::unique_ptr<std::atomic<int>[]> num_pending;
+    size_t num_pending_size{};
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t num_done{};
+  };
+
   KernelRegistry* kernel_registry{};
   SymbolTable symbol_table;
   std::vector<OpExecutableBuilder> op_executables;
 
   mutable std::vector<ValueRef> results;
+
+  //! The ops depending on each op and the number of ops each op depends on, for the first num_tracked_ops ops.
+  std::vector<std::vector<int>> successors;
+  std::vector<int> num_predecessors;
+  size_t num_tracked_ops{};
+  AsyncExecution async_execution;
+  KernelStats* kernel_stats{};
+
+  //! The tensors to release after each op, for the first num_release_tracked_ops ops.
+  bool release_intermediates{};
+  absl::flat_hash_set<const Value*> kept_values;
+  std::vector<llvm::SmallVector<Value*, 2>> releases;
+  size_t num_release_tracked_ops{};
+
+  void TrackDependencies();
+  void TrackReleases();
+  void RunOp(int op_id);
+  void RunAsync(int op_id);
+  // The work captures nothing but the op, so it fits in the inline storage of std::function.
+  void EnqueueAsync(int op_id) {
+    async_execution.host_context->EnqueueWork([this, op_id] { RunAsync(op_id); });
+  }
 };
 
+void KernelStats::Add(absl::string_view name, int64_t ns) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& entry = entries_[name];
+  entry.count++;
+  entry.total_ns += ns;
+}
+
+std::vector<std::pair<std::string, KernelStats::Entry>> KernelStats::entries() const {
+  std::vector<std::pair<std::string, Entry>> res;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    res.assign(entries_.begin(), entries_.end());
+  }
+  std::sort(res.begin(), res.end(), [](auto& a, auto& b) { return a.second.total_ns > b.second.total_ns; });
+  return res;
+}
+
+void KernelStats::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+}
+
+void CoreRuntime::Impl::RunOp(int op_id) {
+  auto& op = op_executables[op_id];
+  VLOG(3) << "running op " << op_id << " " << op.name();
+  if (!kernel_stats) {
+    op.Execute();
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  op.Execute();
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  kernel_stats->Add(op.name(), ns);
+}
+
+void CoreRuntime::Impl::TrackDependencies() {
+  if (num_tracked_ops == op_executables.size()) return;
+  successors.assign(op_executables.size(), {});
+  num_predecessors.assign(op_executables.size(), 0);
+  absl::flat_hash_map<const Value*, int> last_writer;
+  absl::flat_hash_map<const Value*, std::vector<int>> readers;
+  int last_without_results = -1;
+  for (int i = 0; i < op_executables.size(); i++) {
+    std::vector<int> deps;
+    auto& frame = op_executables[i].frame();
+    auto read   = [&](const Value* value) {
+      auto it = last_writer.find(value);
+      if (it != last_writer.end()) deps.push_back(it->second);
+      readers[value].push_back(i);
+    };
+    auto write = [&](const Value* value) {
+      auto it = last_writer.find(value);
+      if (it != last_writer.end()) deps.push_back(it->second);
+      auto& value_readers = readers[value];
+      deps.insert(deps.end(), value_readers.begin(), value_readers.end());
+      value_readers.clear();
+      last_writer[value] = i;
+    };
+    bool has_results      = frame.GetNumResults() > 0;
+    bool writes_arguments = !has_results || op_executables[i].writes_arguments();
+    for (auto* value : frame.GetArguments()) {
+      if (writes_arguments) {
+        write(value);
+      } else {
+        read(value);
+      }
+    }
+    if (has_results) {
+      for (auto* value : frame.GetResults()) write(value);
+    } else {
+      if (last_without_results >= 0) deps.push_back(last_without_results);
+      last_without_results = i;
+    }
+    std::sort(deps.begin(), deps.end());
+    deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+    for (int dep : deps) {
+      if (dep == i) continue;
+      successors[dep].push_back(i);
+      num_predecessors[i]++;
+    }
+  }
+  num_tracked_ops = op_executables.size();
+}
+
+void CoreRuntime::Impl::TrackReleases() {
+  if (num_release_tracked_ops == op_executables.size()) return;
+  absl::flat_hash_map<Value*, int> last_use;
+  for (int i = 0; i < op_executables.size(); i++) {
+    auto& frame = op_executables[i].frame();
+    for (auto* value : frame.GetArguments()) {
+      auto it = last_use.find(value);
+      if (it != last_use.end()) it->second = i;
+    }
+    if (op_executables[i].run_once() || frame.GetNumResults() == 0) continue;
+    for (auto* value : frame.GetResults()) {
+      if (!kept_values.count(value)) last_use[value] = i;
+    }
+  }
+  releases.assign(op_executables.size(), {});
+  for (auto& item : last_use) releases[item.second].push_back(item.first);
+  num_release_tracked_ops = op_executables.size();
+}
+
+void CoreRuntime::Impl::RunAsync(int op_id) {
+  RunOp(op_id);
+  for (int next : successors[op_id]) {
+    if (async_execution.num_pending[next].fetch_sub(1) == 1) EnqueueAsync(next);
+  }
+  // nothing is touched after the lock is released, the caller may start the next execution by then
+  std::lock_guard<std::mutex> lock(async_execution.mutex);
+  if (++async_execution.num_done == op_executables.size()) async_execution.cv.notify_all();
+}
+
 SymbolTable* CoreRuntime::symbol_table() { return &impl_->symbol_table; }
 
 CoreRuntime::CoreRuntime(CoreRuntime::Impl* impl) : impl_(impl) { CHECK(impl); }
 
 void CoreRuntime::Execute() {
   // std::cout << "CoreRuntime::Execute" << std::endl;
-  int op_offset = 0;
-  for (auto& op : impl_->op_executables) {
-    VLOG(3) << "running op " << op_offset++ << " " << op.name();
-    op.Execute();
+  if (impl_->release_intermediates) impl_->TrackReleases();
+  for (int op_offset = 0; op_offset < impl_->op_executables.size(); op_offset++) {
+    impl_->RunOp(op_offset);
+    if (impl_->release_intermediates) {
+      // drop the references to the buffers, they go back to the memory pool if not shared by others
+      for (auto* value : impl_->releases[op_offset]) {
+        if (value->is_type<tensor::DenseHostTensor>()) value->set(tensor::DenseHostTensor());
+      }
+    }
+  }
+}
+
+void CoreRuntime::Execute(HostContext* host_context) {
+  CHECK(host_context);
+  if (impl_->op_executables.empty()) return;
+  impl_->TrackDependencies();
+  size_t num_ops  = impl_->op_executables.size();
+  auto& execution = impl_->async_execution;
+  if (execution.num_pending_size != num_ops) {
+    execution.num_pending.reset(new std::atomic<int>[num_ops]);
+    execution.num_pending_size = num_ops;
   }
+  for (int i = 0; i < num_ops; i++) execution.num_pending[i] = impl_->num_predecessors[i];
+  execution.host_context = host_context;
+  {
+    std::lock_guard<std::mutex> lock(execution.mutex);
+    execution.num_done = 0;
+  }
+  for (int i = 0; i < num_ops; i++) {
+    if (impl_->num_predecessors[i] == 0) impl_->EnqueueAsync(i);
+  }
+  std::unique_lock<std::mutex> lock(execution.mutex);
+  execution.cv.wait(lock, [&] { return execution.num_done == num_ops; });
 }
 
 KernelRegistry* CoreRuntime::kernel_registry() const { return impl_->kernel_registry; }
 
 size_t CoreRuntime::num_ops() const { return impl_->op_executables.size(); }
 
+void CoreRuntime::SetKernelStats(KernelStats* stats) { impl_->kernel_stats = stats; }
+
 CoreRuntimeBuilder::CoreRuntimeBuilder(KernelRegistry* kernel_registry) : CoreRuntime(new Impl) {
   impl_->kernel_registry = kernel_registry ? kernel_registry : GetCpuKernelRegistry();
 }
@@ -52,6 +236,31 @@ void CoreRuntimeBuilder::FeedInArgs(llvm::ArrayRef<std::pair<std::string, ValueR
   }
 }
 
+void CoreRuntimeBuilder::ReleaseIntermediateTensors(llvm::ArrayRef<Value*> outputs) {
+  impl_->release_intermediates = true;
+  impl_->kept_values.insert(outputs.begin(), outputs.end());
+  impl_->num_release_tracked_ops = 0;
+}
+
+void CoreRuntimeBuilder::RebindArguments(llvm::ArrayRef<Value*> from, llvm::ArrayRef<Value*> to) {
+  CHECK_EQ(from.size(), to.size());
+  absl::flat_hash_map<Value*, Value*> bindings;
+  for (int i = 0; i < from.size(); i++) {
+    if (from[i] != to[i]) bindings[from[i]] = to[i];
+  }
+  if (bindings.empty()) return;
+  for (auto& op : impl_->op_executables) {
+    auto& frame = op.frame();
+    for (auto*& value : frame.GetMutableValues(0, frame.GetNumArgs())) {
+      auto it = bindings.find(value);
+      if (it != bindings.end()) value = it->second;
+    }
+  }
+  // the tracked dependencies and releases are of the Values bound before
+  impl_->num_tracked_ops         = 0;
+  impl_->num_release_tracked_ops = 0;
+}
+
 void CoreRuntimeBuilder::SetKernelRegistry(KernelRegistry* x) {
   CHECK(x);
   impl_->kernel_registry = x;
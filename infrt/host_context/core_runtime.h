@@ -2,19 +2,49 @@
 #include <llvm/ADT/ArrayRef.h>
 #include <llvm/ADT/SmallVector.h>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/string_view.h>
+
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "infrt/host_context/value.h"
 
 namespace infrt::host_context {
 
+class HostContext;
 class KernelRegistry;
 class OpExecutable;
 class OpExecutableBuilder;
 class SymbolTable;
 
+/**
+ * The time spent in the kernels by the name of their ops, recorded by the runtimes it is set to. The ops calling a
+ * function, e.g. cinn.call, include the time of the function.
+ */
+class KernelStats {
+ public:
+  struct Entry {
+    int64_t count{};
+    int64_t total_ns{};
+  };
+
+  void Add(absl::string_view name, int64_t ns);
+
+  //! The entries in the descending order of the total time.
+  std::vector<std::pair<std::string, Entry>> entries() const;
+
+  void Clear();
+
+ private:
+  mutable std::mutex mutex_;
+  absl::flat_hash_map<std::string, Entry> entries_;
+};
+
 /**
  * CoreRuntime encapsulate the execution for a sequence of ops.
  * Each function call will bind to a CoreRuntime instance, push the argument Values in to the argument-list, and get the
@@ -25,9 +55,24 @@ class CoreRuntime : public std::enable_shared_from_this<CoreRuntime> {
   //! Execute a program.
   void Execute();
 
+  /**
+   * Execute a program on the worker threads of \p host_context, each op is enqueued once the ops it depends on are
+   * done, so that the independent ops run concurrently. It returns after all the ops are done.
+   *
+   * The dependencies are tracked by the Values of the ops. An op depends on the last op writing any of its arguments
+   * or results, and on the ops reading its results since that write. An op without results is taken to write its
+   * arguments in place, e.g. filling a tensor, and the ops without results keep their order, e.g. the prints.
+   *
+   * The states of the execution are kept in the runtime and reused, so a runtime should not be executed concurrently.
+   */
+  void Execute(HostContext* host_context);
+
   //! Return the number of ops.
   size_t num_ops() const;
 
+  //! Record the time of each op to \p stats in the following executions, null to stop.
+  void SetKernelStats(KernelStats* stats);
+
   //! Get the results of the execution.
   llvm::SmallVector<ValueRef, 4>  //
   GetResults(llvm::ArrayRef<absl::string_view> arg_names);
@@ -64,6 +109,16 @@ class CoreRuntimeBuilder : public CoreRuntime {
   llvm::ArrayRef<absl::string_view> attr_names() const;
 
   OpExecutableBuilder* NewOpExecutable(absl::string_view op_name);
+
+  /**
+   * Release the tensors produced by the ops once their last readers are done in each in-order execution, so that their
+   * buffers are reused by the later ops and executions. The \p outputs and the results of the ops run once are kept.
+   * It takes the ops appended so far and the later ones.
+   */
+  void ReleaseIntermediateTensors(llvm::ArrayRef<Value*> outputs);
+
+  //! Replace each of the \p from Values by the one of \p to in the arguments of the ops, e.g. to run with other inputs.
+  void RebindArguments(llvm::ArrayRef<Value*> from, llvm::ArrayRef<Value*> to);
 };
 
 }  // namespace infrt::host_context
@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 
+#include "infrt/host_context/host_context.h"
+
 #include "infrt/host_context/kernel_registry.h"
 #include "infrt/host_context/kernel_utils.h"
 #include "infrt/host_context/op_executable.h"
@@ -76,5 +78,98 @@ TEST(CoreRuntime, function) {
   ASSERT_EQ(res[0].get<int>(), 3);
 }
 
+int mul(int a, int b) { return a * b; }
+
+TEST(CoreRuntime, async) {
+  KernelRegistry registry;
+  registry.AddKernel("cinn.test.addi32", CINN_KERNEL(add));
+  registry.AddKernel("cinn.test.subi32", CINN_KERNEL(sub));
+  registry.AddKernel("cinn.test.muli32", CINN_KERNEL(mul));
+
+  CoreRuntimeBuilder builder(&registry);
+  auto* table = builder.symbol_table();
+  table->Register("a", 5);
+  table->Register("b", 2);
+
+  // c = a + b and d = a - b are independent, e = c * d depends on both
+  auto* op0 = builder.NewOpExecutable("cinn.test.addi32");
+  op0->AppendArgument("a");
+  op0->AppendArgument("b");
+  op0->SetResults({"c"});
+
+  auto* op1 = builder.NewOpExecutable("cinn.test.subi32");
+  op1->AppendArgument("a");
+  op1->AppendArgument("b");
+  op1->SetResults({"d"});
+
+  auto* op2 = builder.NewOpExecutable("cinn.test.muli32");
+  op2->AppendArgument("c");
+  op2->AppendArgument("d");
+  op2->SetResults({"e"});
+
+  // a = e - b overwrites an argument of the ops above
+  auto* op3 = builder.NewOpExecutable("cinn.test.subi32");
+  op3->AppendArgument("e");
+  op3->AppendArgument("b");
+  op3->SetResults({"a"});
+
+  HostContext host_context(4);
+  builder.Execute(&host_context);
+  ASSERT_EQ(table->GetValue("e")->get<int>(), 21);
+  ASSERT_EQ(table->GetValue("a")->get<int>(), 19);
+
+  // run again from the updated a
+  builder.Execute(&host_context);
+  ASSERT_EQ(table->GetValue("e")->get<int>(), 357);
+  ASSERT_EQ(table->GetValue("a")->get<int>(), 355);
+}
+
+const void* last_tensor_data{};
+
+tensor::DenseHostTensor ones(int n) {
+  int64_t dims[] = {n};
+  tensor::DenseHostTensor tensor(tensor::TensorShape(dims), GetDType<float>());
+  auto* data = reinterpret_cast<float*>(tensor.raw_data());
+  for (int i = 0; i < n; i++) data[i] = 1.f;
+  return tensor;
+}
+
+float sum(const tensor::DenseHostTensor& tensor) {
+  last_tensor_data = tensor.raw_data();
+  auto* data       = reinterpret_cast<const float*>(tensor.raw_data());
+  float res        = 0.f;
+  for (int i = 0; i < tensor.shape().GetNumElements(); i++) res += data[i];
+  return res;
+}
+
+TEST(CoreRuntime, release_intermediate_tensors) {
+  KernelRegistry registry;
+  registry.AddKernel("cinn.test.ones", CINN_KERNEL(ones));
+  registry.AddKernel("cinn.test.sum", CINN_KERNEL(sum));
+
+  CoreRuntimeBuilder builder(&registry);
+  auto* table = builder.symbol_table();
+  table->Register("n", 1000);
+
+  // t = ones(n), s = sum(t)
+  auto* op0 = builder.NewOpExecutable("cinn.test.ones");
+  op0->AppendArgument("n");
+  op0->SetResults({"t"});
+  auto* op1 = builder.NewOpExecutable("cinn.test.sum");
+  op1->AppendArgument("t");
+  op1->SetResults({"s"});
+
+  builder.ReleaseIntermediateTensors({table->GetValue("s")});
+  builder.Execute();
+  ASSERT_EQ(table->GetValue("s")->get<float>(), 1000.f);
+  ASSERT_FALSE(table->GetValue("t")->get<tensor::DenseHostTensor>().buffer());
+  const void* first_data = last_tensor_data;
+
+  // the buffer of t released in the first execution is reused
+  builder.Execute();
+  ASSERT_EQ(table->GetValue("s")->get<float>(), 1000.f);
+  ASSERT_EQ(last_tensor_data, first_data);
+}
+
 }  // namespace host_context
 }  // namespace infrt
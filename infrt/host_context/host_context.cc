@@ -0,0 +1,48 @@
+#include "infrt/host_context/host_context.h"
+
+#include <glog/logging.h>
+
+#include <utility>
+
+namespace infrt::host_context {
+
+HostContext::HostContext(int num_threads) {
+  CHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; i++) {
+    workers_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+HostContext::~HostContext() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& worker : workers_) worker.join();
+}
+
+void HostContext::EnqueueWork(std::function<void()> work) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    works_.push_back(std::move(work));
+  }
+  cv_.notify_one();
+}
+
+void HostContext::WorkerLoop() {
+  while (true) {
+    std::function<void()> work;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stop_ || !works_.empty(); });
+      // the works left are drained before stopping
+      if (works_.empty()) return;
+      work = std::move(works_.front());
+      works_.pop_front();
+    }
+    work();
+  }
+}
+
+}  // namespace infrt::host_context
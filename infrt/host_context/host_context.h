@@ -0,0 +1,35 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace infrt::host_context {
+
+/**
+ * HostContext holds the work queue and the worker threads the ops run on in the async execution of CoreRuntime.
+ * The works are run in the order they are enqueued, each on any one of the workers.
+ */
+class HostContext {
+ public:
+  explicit HostContext(int num_threads);
+  ~HostContext();
+
+  //! Enqueue the \p work to run on a worker thread.
+  void EnqueueWork(std::function<void()> work);
+
+  int num_threads() const { return workers_.size(); }
+
+ private:
+  void WorkerLoop();
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> works_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_{false};
+};
+
+}  // namespace infrt::host_context
@@ -41,25 +41,19 @@ class RemainingArguments {
 };
 
 /**
- * RemainingResults collects all remaining results in a MutableArrayRef.
+ * RemainingResults collects all remaining results in a MutableArrayRef. It refers to the result Values of the frame
+ * directly, so that no ValueRefs are built and counted for each invocation.
  */
 class RemainingResults {
  public:
-  RemainingResults(llvm::MutableArrayRef<ValueRef> remaining_results) : remaining_results_(remaining_results) {}
-  llvm::MutableArrayRef<ValueRef> values() { return remaining_results_; }
+  explicit RemainingResults(llvm::MutableArrayRef<Value*> remaining_results) : remaining_results_(remaining_results) {}
+  llvm::MutableArrayRef<Value*> values() { return remaining_results_; }
   size_t size() const { return remaining_results_.size(); }
 
-  template <typename T>
-  const ValueRef& AllocateAt(int index) {
-    // eagerly create a ValueRef
-    if (remaining_results_[index].get()) return remaining_results_[index];
-    remaining_results_[index] = ValueRef(new Value);
-    return remaining_results_[index];
-  }
-  ValueRef& operator[](size_t i) const { return remaining_results_[i]; }
+  Value* operator[](size_t i) const { return remaining_results_[i]; }
 
  private:
-  llvm::MutableArrayRef<ValueRef> remaining_results_;
+  llvm::MutableArrayRef<Value*> remaining_results_;
 };
 
 template <typename T>
@@ -242,12 +236,7 @@ struct KernelImpl<Return (*)(Args...), impl_fn> {
     static void Invoke(KernelFrame* frame, const PreviousArgs&... pargs) {
       static_assert(out_idx != -1, "Do not use more than one RemainingResults");
       static_assert(const_idx == 0, "Arguments and results should appear before attributes");
-      llvm::MutableArrayRef<Value*> returned_results = frame->GetResults().drop_front(out_idx);
-
-      llvm::SmallVector<ValueRef, 4> result_values;
-      for (int i = 0; i < returned_results.size(); i++) result_values.emplace_back(returned_results[i]);
-
-      RemainingResults remaining_results(result_values);
+      RemainingResults remaining_results(frame->GetResults().drop_front(out_idx));
       KernelCallHelper<Tail...>::template Invoke<in_idx, -1, const_idx>(frame, pargs..., remaining_results);
     }
   };
@@ -0,0 +1,212 @@
+// cinn-bench, benchmark the functions without arguments of a MLIR program. Each function is run repeatedly after the
+// warmup by each executor, the sequential one and the async ones on the worker threads, and the latency percentiles,
+// the time of each kernel and the tensor allocations per run are reported.
+//
+//   cinn-bench -i program.mlir --function=main --warmup=10 --repeat=100 --num_threads=0,4
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/DynamicLibrary.h>
+#include <llvm/Support/raw_ostream.h>
+#include <mlir/Pass/PassManager.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "infrt/common/global.h"
+#include "infrt/common/memory.h"
+#include "infrt/dialect/dt_buffer_planning.h"
+#include "infrt/dialect/mlir_loader.h"
+#include "infrt/dialect/pd_shape_inference.h"
+#include "infrt/host_context/core_runtime.h"
+#include "infrt/host_context/host_context.h"
+#include "infrt/host_context/kernel_registry.h"
+#include "infrt/host_context/mlir_function_executable.h"
+#include "infrt/host_context/mlir_program_executor.h"
+#include "infrt/kernel/basic_kernels.h"
+#include "infrt/kernel/control_flow_kernels.h"
+#include "infrt/kernel/pd_fused_kernels.h"
+#include "infrt/kernel/tensor_kernels.h"
+#include "infrt/kernel/tensor_shape_kernels.h"
+#include "infrt/kernel/test_kernels.h"
+
+static llvm::cl::list<std::string> cl_shared_libs(  // NOLINT
+    "shared_libs",
+    llvm::cl::desc("Specify shared library with kernels."),
+    llvm::cl::ZeroOrMore,
+    llvm::cl::MiscFlags::CommaSeparated);
+
+namespace {
+
+using infrt::host_context::KernelStats;
+using infrt::host_context::MlirFunctionExecutable;
+using infrt::host_context::Value;
+using infrt::host_context::ValueRef;
+
+//! The allocations of the host tensors so far.
+infrt::MemoryStats GetHostMemoryStats() {
+  infrt::MemoryStats res;
+  for (auto arch : {infrt::common::Target::Arch::Unk, infrt::common::Target::Arch::X86}) {
+    auto stats = infrt::MemoryManager::Global().RetrieveSafely(arch)->stats();
+    res.num_mallocs += stats.num_mallocs;
+    res.malloc_bytes += stats.malloc_bytes;
+    res.num_system_allocs += stats.num_system_allocs;
+    res.system_alloc_bytes += stats.system_alloc_bytes;
+  }
+  return res;
+}
+
+void Benchmark(const std::string& name,
+               MlirFunctionExecutable* func,
+               int num_threads,
+               int warmup,
+               int repeat,
+               bool per_kernel) {
+  std::unique_ptr<infrt::host_context::HostContext> host_context;
+  if (num_threads > 0) host_context.reset(new infrt::host_context::HostContext(num_threads));
+  func->SetHostContext(host_context.get());
+
+  std::vector<ValueRef> results;
+  for (int i = 0; i < func->num_results(); i++) results.emplace_back(new Value);
+  auto run = [&] { func->Execute({}, llvm::MutableArrayRef<ValueRef>(results.data(), results.size())); };
+
+  for (int i = 0; i < warmup; i++) run();
+
+  KernelStats kernel_stats;
+  if (per_kernel) func->SetKernelStats(&kernel_stats);
+  auto memory_before = GetHostMemoryStats();
+  std::vector<int64_t> latencies;
+  for (int i = 0; i < repeat; i++) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    latencies.push_back(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+  }
+  auto memory_after = GetHostMemoryStats();
+  func->SetKernelStats(nullptr);
+  func->SetHostContext(nullptr);
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) { return latencies[std::min<size_t>(latencies.size() * p, latencies.size() - 1)]; };
+  int64_t total_ns = 0;
+  for (auto ns : latencies) total_ns += ns;
+
+  // BENCH: prefix is added to make grepping the results easier, like the BM: of cinn.benchmark.
+  std::string prefix;
+  llvm::raw_string_ostream(prefix) << "BENCH:" << name << ':'
+                                   << (num_threads > 0 ? "async" + std::to_string(num_threads) : "seq") << ':';
+  auto& os = llvm::outs();
+  os << prefix << "Count: " << latencies.size() << '\n';
+  os << prefix << "Time Mean(ns): " << total_ns / static_cast<int64_t>(latencies.size()) << '\n';
+  os << prefix << "Time Min(ns): " << latencies.front() << '\n';
+  os << prefix << "Time 50%(ns): " << percentile(0.5) << '\n';
+  os << prefix << "Time 95%(ns): " << percentile(0.95) << '\n';
+  os << prefix << "Time 99%(ns): " << percentile(0.99) << '\n';
+  os << prefix << "Time Max(ns): " << latencies.back() << '\n';
+  os << prefix << "Mallocs per run: " << (memory_after.num_mallocs - memory_before.num_mallocs) / repeat << '\n';
+  os << prefix << "Malloc bytes per run: " << (memory_after.malloc_bytes - memory_before.malloc_bytes) / repeat
+     << '\n';
+  os << prefix << "System allocs per run: "
+     << (memory_after.num_system_allocs - memory_before.num_system_allocs) / repeat << '\n';
+  os << prefix << "System alloc bytes per run: "
+     << (memory_after.system_alloc_bytes - memory_before.system_alloc_bytes) / repeat << '\n';
+  // the kernels of the async executor overlap, so their total time may exceed the latency
+  for (auto& item : kernel_stats.entries()) {
+    os << prefix << "Kernel " << item.first << ": count " << item.second.count / repeat << ", total(ns) "
+       << item.second.total_ns / repeat << ", percent " << item.second.total_ns * 100.0 / total_ns << '\n';
+  }
+  os.flush();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  using namespace llvm;   // NOLINT
+  using namespace infrt;  // NOLINT
+  cl::opt<std::string> input_file("i", cl::desc("Specify input filename"), cl::value_desc("input file name"));
+  cl::list<std::string> functions("function",
+                                  cl::desc("The functions to benchmark, all the ones without arguments if not set"),
+                                  cl::ZeroOrMore,
+                                  cl::MiscFlags::CommaSeparated);
+  cl::opt<int> warmup("warmup", cl::desc("The runs before the measured ones"), cl::init(10));
+  cl::opt<int> repeat("repeat", cl::desc("The measured runs"), cl::init(100));
+  cl::list<int> num_threads("num_threads",
+                            cl::desc("The executors to compare, 0 runs the ops in order and N runs the independent "
+                                     "ops concurrently on N threads"),
+                            cl::ZeroOrMore,
+                            cl::MiscFlags::CommaSeparated);
+  cl::opt<bool> per_kernel("per_kernel", cl::desc("Report the time of each kernel"), cl::init(true));
+  cl::opt<bool> plan_buffers("plan_buffers",
+                             cl::desc("Infer the static shapes and plan the buffers of the tensors before executing"),
+                             cl::init(false));
+  cl::ParseCommandLineOptions(argc, argv);
+  if (repeat <= 0) {
+    llvm::errs() << "--repeat should be positive\n";
+    return 1;
+  }
+
+  mlir::MLIRContext* context = infrt::Global::getMLIRContext();
+  auto module                = dialect::LoadMlirFile(input_file.c_str(), context);
+  if (plan_buffers) {
+    mlir::PassManager pm(context);
+    auto& func_pm = pm.nest<mlir::FuncOp>();
+    func_pm.addPass(CreatePdShapeInferencePass());
+    func_pm.addPass(dt::CreateBufferPlanningPass());
+    if (mlir::failed(pm.run(*module))) {
+      llvm::errs() << "Failed to plan the buffers of " << input_file << "\n";
+      return 1;
+    }
+  }
+
+  host_context::KernelRegistry registry;
+
+  kernel::RegisterBasicKernels(&registry);
+  kernel::RegisterTestKernels(&registry);
+  kernel::RegisterTensorShapeKernels(&registry);
+  kernel::RegisterTensorKernels(&registry);
+  kernel::RegisterControlFlowKernels(&registry);
+  kernel::RegisterPdFusedKernels(&registry);
+
+  // load extra shared library
+  for (const auto& lib_path : cl_shared_libs) {
+    std::string err;
+    llvm::sys::DynamicLibrary dynLib = llvm::sys::DynamicLibrary::getPermanentLibrary(lib_path.c_str(), &err);
+    if (!dynLib.isValid()) {
+      llvm::errs() << "Load shared library failed. Error: " << err << "\n";
+      return 1;
+    }
+    if (auto reg_sym = dynLib.SearchForAddressOfSymbol("RegisterKernels")) {
+      auto reg_func = reinterpret_cast<void (*)(host_context::KernelRegistry*)>(reg_sym);
+      reg_func(&registry);
+    } else {
+      llvm::outs() << "Symbol \"RegisterKernels\" not found in \"" << lib_path << "\". Skip.\n";
+    }
+  }
+
+  host_context::MlirProgramExecutor executor(module.get(), &registry);
+  executor.BuildFunctions();
+
+  std::vector<std::string> names(functions.begin(), functions.end());
+  if (names.empty()) {
+    for (auto func_op : module->getOps<mlir::FuncOp>()) {
+      if (func_op.getNumArguments() == 0) names.push_back(func_op.getName().str());
+    }
+  }
+  std::vector<int> executors(num_threads.begin(), num_threads.end());
+  if (executors.empty()) executors.push_back(0);
+
+  for (auto& name : names) {
+    auto* func = executor.LookupFunc(name);
+    if (!func) {
+      llvm::errs() << "No function " << name << " found\n";
+      return 1;
+    }
+    if (func->num_arguments() > 0) {
+      llvm::errs() << "The function " << name << " takes arguments, skipped\n";
+      continue;
+    }
+    for (int threads : executors) Benchmark(name, func, threads, warmup, repeat, per_kernel);
+  }
+  return 0;
+}
@@ -1,15 +1,21 @@
 #include <llvm/Support/CommandLine.h>
+#include <mlir/Pass/PassManager.h>
 
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include "infrt/common/global.h"
+#include "infrt/dialect/dt_buffer_planning.h"
 #include "infrt/dialect/mlir_loader.h"
+#include "infrt/dialect/pd_shape_inference.h"
 #include "infrt/host_context/core_runtime.h"
+#include "infrt/host_context/host_context.h"
 #include "infrt/host_context/kernel_registry.h"
 #include "infrt/host_context/mlir_to_runtime_translate.h"
 #include "infrt/kernel/basic_kernels.h"
 #include "infrt/kernel/control_flow_kernels.h"
+#include "infrt/kernel/pd_fused_kernels.h"
 #include "infrt/kernel/tensor_kernels.h"
 #include "infrt/kernel/tensor_shape_kernels.h"
 #include "infrt/kernel/test_kernels.h"
@@ -25,10 +31,26 @@ int main(int argc, char** argv) {
   using namespace llvm;   // NOLINT
   using namespace infrt;  // NOLINT
   cl::opt<std::string> input_file("i", cl::desc("Specify input filename"), cl::value_desc("input file name"));
+  cl::opt<int> num_threads("num_threads",
+                           cl::desc("Execute the independent ops concurrently on this many threads, 0 to run in order"),
+                           cl::init(0));
+  cl::opt<bool> plan_buffers("plan_buffers",
+                             cl::desc("Infer the static shapes and plan the buffers of the tensors before executing"),
+                             cl::init(false));
   cl::ParseCommandLineOptions(argc, argv);
 
   mlir::MLIRContext* context = infrt::Global::getMLIRContext();
   auto module                = dialect::LoadMlirFile(input_file.c_str(), context);
+  if (plan_buffers) {
+    mlir::PassManager pm(context);
+    auto& func_pm = pm.nest<mlir::FuncOp>();
+    func_pm.addPass(CreatePdShapeInferencePass());
+    func_pm.addPass(dt::CreateBufferPlanningPass());
+    if (mlir::failed(pm.run(*module))) {
+      llvm::errs() << "Failed to plan the buffers of " << input_file << "\n";
+      return 1;
+    }
+  }
 
   host_context::KernelRegistry registry;
 
@@ -37,6 +59,7 @@ int main(int argc, char** argv) {
   kernel::RegisterTensorShapeKernels(&registry);
   kernel::RegisterTensorKernels(&registry);
   kernel::RegisterControlFlowKernels(&registry);
+  kernel::RegisterPdFusedKernels(&registry);
 
   // load extra shared library
   for (const auto& lib_path : cl_shared_libs) {
@@ -54,7 +77,9 @@ int main(int argc, char** argv) {
     }
   }
 
-  host_context::TestMlir(module.get(), &registry);
+  std::unique_ptr<host_context::HostContext> host_ctx;
+  if (num_threads > 0) host_ctx.reset(new host_context::HostContext(num_threads));
+  host_context::TestMlir(module.get(), &registry, host_ctx.get());
 
   std::cout << std::endl;
   return 0;
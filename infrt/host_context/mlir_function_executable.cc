@@ -2,6 +2,7 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <string>
 
 #include "infrt/host_context/core_runtime.h"
@@ -38,19 +39,20 @@ MlirFunctionExecutable::MlirFunctionExecutable(mlir::Region* region,
       function_table_(function_table) {}
 
 void MlirFunctionExecutable::BuildExecutables(llvm::ArrayRef<Value*> arguments,
-                                              llvm::MutableArrayRef<ValueRef> results,
+                                              llvm::ArrayRef<Value*> results,
                                               bool is_region) {
   CHECK_EQ(arguments.size(), num_arguments());
   // We use the function call's arguments as op_executable's operands to avoid copy.
   for (int i = 0; i < num_arguments(); i++) {
     AddValue(region_->getArgument(i), arguments[i]);
   }
+  bound_arguments_.assign(arguments.begin(), arguments.end());
 
   // build the program
   auto& blocks = region_->getBlocks();
   CHECK_EQ(blocks.size(), 1UL) << "function with more than one block is not supported yet";
 
-  llvm::SmallVector<Value*, 3> runtime_results;
+  auto& runtime_results = runtime_results_;
   for (auto& op : blocks.front()) {
     if (EmitConstantOp(&op)) continue;
     if (EmitBuildShapeOp(&op)) continue;
@@ -72,38 +74,58 @@ void MlirFunctionExecutable::BuildExecutables(llvm::ArrayRef<Value*> arguments,
   }
 
   // after the block is built, we can get the result values of the whole function call in the runtime_results.
+  // the other tensors are intermediates of the call, their buffers are recycled once they are consumed.
+  core_runtime_builder_.ReleaseIntermediateTensors(runtime_results);
+  CHECK_EQ(is_region ? 0UL : results.size(), runtime_results.size());
+  built_ = true;
+}
 
-  mlir::SmallVector<Value*, 3> results_copied;
-  if (!is_region) {
-    for (ValueRef& x : results) {
-      results_copied.push_back(x.get());
-    }
+void MlirFunctionExecutable::RebindArguments(llvm::ArrayRef<Value*> arguments) {
+  if (std::equal(arguments.begin(), arguments.end(), bound_arguments_.begin())) return;
+  VLOG(3) << "rebind the arguments of function " << name();
+  core_runtime_builder_.RebindArguments(bound_arguments_, arguments);
+  // an argument returned directly
+  for (auto*& value : runtime_results_) {
+    auto it = std::find(bound_arguments_.begin(), bound_arguments_.end(), value);
+    if (it != bound_arguments_.end()) value = arguments[it - bound_arguments_.begin()];
   }
-
-  // set a lambda function to help copy the results from the runtime results in the local function to outer program.
-  CHECK_EQ(results_copied.size(), runtime_results.size());
-  this->copy_res_fn_ = [results_copied, runtime_results] {
-    VLOG(4) << "copy results to result";
-    for (int i = 0; i < results_copied.size(); i++) {
-      VLOG(4) << ".. copy " << runtime_results[i] << " to " << results_copied[i];
-      CopyTo(*runtime_results[i], results_copied[i]);
-    }
-  };
+  bound_arguments_.assign(arguments.begin(), arguments.end());
 }
 
 void MlirFunctionExecutable::Execute(llvm::ArrayRef<Value*> arguments,
                                      llvm::MutableArrayRef<ValueRef> results,
                                      bool is_region) const {
+  llvm::SmallVector<Value*, 4> result_values;
+  for (ValueRef& x : results) result_values.push_back(x.get());
+  Execute(arguments, llvm::ArrayRef<Value*>(result_values), is_region);
+}
+
+void MlirFunctionExecutable::Execute(llvm::ArrayRef<Value*> arguments,
+                                     llvm::ArrayRef<Value*> results,
+                                     bool is_region) const {
   CHECK_EQ(arguments.size(), num_arguments());
   CHECK_EQ(results.size(), num_results());
 
-  if (core_runtime_builder_.num_ops() == 0) {
-    const_cast<MlirFunctionExecutable*>(this)->BuildExecutables(arguments, results, is_region);
+  auto* self = const_cast<MlirFunctionExecutable*>(this);
+  if (!built_) {
+    self->BuildExecutables(arguments, results, is_region);
+  } else {
+    self->RebindArguments(arguments);
   }
 
-  const_cast<CoreRuntimeBuilder*>(&core_runtime_builder_)->Execute();
+  if (host_context_) {
+    self->core_runtime_builder_.Execute(host_context_);
+  } else {
+    self->core_runtime_builder_.Execute();
+  }
 
-  copy_res_fn_();
+  // copy the results from the runtime results in the local function to outer program.
+  if (is_region) return;
+  VLOG(4) << "copy results to result";
+  for (int i = 0; i < runtime_results_.size(); i++) {
+    VLOG(4) << ".. copy " << runtime_results_[i] << " to " << results[i];
+    CopyTo(*runtime_results_[i], results[i]);
+  }
 }
 
 }  // namespace host_context
@@ -33,22 +33,43 @@ class MlirFunctionExecutable : public Function, public MlirToRuntimeTranslator {
 
   /**
    * Execute the function with the given arguments and results.
-   * NOTE the \param arguments and \param results should not be altered.
+   * The function is translated in the first call and bound to its arguments, a later call with other argument Values
+   * only rebinds the executables to them.
    */
   void Execute(llvm::ArrayRef<Value*> arguments, llvm::MutableArrayRef<ValueRef> results, bool is_region = false) const;
 
+  //! Execute with the result Values directly, e.g. those of the KernelFrame of a `cinn.call`, without any allocation.
+  void Execute(llvm::ArrayRef<Value*> arguments, llvm::ArrayRef<Value*> results, bool is_region = false) const;
+
+  //! Execute the ops on the worker threads of \p host_context in the following calls, in order if null.
+  void SetHostContext(HostContext* host_context) { host_context_ = host_context; }
+
+  //! Record the time of the ops of the function to \p stats, null to stop.
+  void SetKernelStats(KernelStats* stats) { core_runtime_builder_.SetKernelStats(stats); }
+
+  //! The region of the function, e.g. for the kernels compiling it instead of executing it.
+  mlir::Region* region() const { return region_; }
+
  private:
   /**
    * Build the runtime executables once the function call arguments and results are passed in.
    * This will trigger in the first execution.
    */
-  void BuildExecutables(llvm::ArrayRef<Value*> arguments, llvm::MutableArrayRef<ValueRef> results, bool is_region);
+  void BuildExecutables(llvm::ArrayRef<Value*> arguments, llvm::ArrayRef<Value*> results, bool is_region);
+
+  //! Bind the executables built to the \p arguments of a later call if they are other Values than the bound ones.
+  void RebindArguments(llvm::ArrayRef<Value*> arguments);
 
  private:
   mlir::Region* region_{};
   CoreRuntimeBuilder core_runtime_builder_;
   MlirToRuntimeTranslator::function_defs_t& function_table_;
-  std::function<void()> copy_res_fn_;
+  bool built_{};
+  HostContext* host_context_{};
+  //! The arguments the executables are bound to.
+  llvm::SmallVector<Value*, 4> bound_arguments_;
+  //! The Values in the function returned, they are copied to the results of each call.
+  llvm::SmallVector<Value*, 3> runtime_results_;
 };
 
 }  // namespace host_context
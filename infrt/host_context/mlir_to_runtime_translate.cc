@@ -54,6 +54,9 @@ struct MlirToRuntimeTranslator::Impl {
   // Map from an operation to its results.
   absl::flat_hash_map<const mlir::Operation*, std::vector<ValueRef>> op_results;
   llvm::DenseMap<mlir::Value, ValueRef> value_map;
+
+  // The Values of the attributes, the attributes are uniqued by MLIR so the ops with an equal attribute share a Value.
+  llvm::DenseMap<mlir::Attribute, ValueRef> attribute_values;
 };
 
 bool MlirToRuntimeTranslator::EmitConstantOp(mlir::Operation* op) {
@@ -241,30 +244,7 @@ bool MlirToRuntimeTranslator::EmitGeneralOp(mlir::Operation* op) {
   auto attrs = op->getAttrs();
 
   for (int i = 0; i < attrs.size(); i++) {
-    auto& attr = attrs[i];
-    if (auto v = EmitAttribute<int32_t>(&attr.second)) {
-      impl_->cur_op->AppendAttribute(new Value(*v));
-    } else if (auto v = EmitAttribute<int64_t>(&attr.second)) {
-      impl_->cur_op->AppendAttribute(new Value(*v));
-    } else if (auto v = EmitAttribute<float>(&attr.second)) {
-      impl_->cur_op->AppendAttribute(new Value(*v));
-    } else if (auto v = EmitAttribute<double>(&attr.second)) {
-      impl_->cur_op->AppendAttribute(new Value(*v));
-    } else if (auto v = EmitAttribute<std::string>(&attr.second)) {
-      impl_->cur_op->AppendAttribute(new Value(std::move(*v)));
-    } else if (auto v = EmitAttribute<std::vector<int16_t>>(&attr.second)) {
-      impl_->cur_op->AppendAttribute(new Value(std::move(*v)));
-    } else if (auto v = EmitAttribute<std::vector<int32_t>>(&attr.second)) {
-      impl_->cur_op->AppendAttribute(new Value(std::move(*v)));
-    } else if (auto v = EmitAttribute<std::vector<int64_t>>(&attr.second)) {
-      impl_->cur_op->AppendAttribute(new Value(std::move(*v)));
-    } else if (auto v = EmitAttribute<std::vector<float>>(&attr.second)) {
-      impl_->cur_op->AppendAttribute(new Value(std::move(*v)));
-    } else if (auto v = EmitAttribute<std::vector<double>>(&attr.second)) {
-      impl_->cur_op->AppendAttribute(new Value(std::move(*v)));
-    } else {
-      LOG(FATAL) << "Not supported attribute type";
-    }
+    impl_->cur_op->AppendAttribute(GetAttributeValue(attrs[i].second));
   }
 
   // process regions, we treat regions as attribute.
@@ -313,6 +293,38 @@ bool MlirToRuntimeTranslator::EmitFunctions() {
 
 void MlirToRuntimeTranslator::EmitFunction(mlir::FuncOp op) { impl_->func_defs[op.getName().str()] = op; }
 
+Value* MlirToRuntimeTranslator::GetAttributeValue(mlir::Attribute attr) {
+  auto it = impl_->attribute_values.find(attr);
+  if (it != impl_->attribute_values.end()) return it->second.get();
+
+  Value* value{};
+  if (auto v = EmitAttribute<int32_t>(&attr)) {
+    value = new Value(*v);
+  } else if (auto v = EmitAttribute<int64_t>(&attr)) {
+    value = new Value(*v);
+  } else if (auto v = EmitAttribute<float>(&attr)) {
+    value = new Value(*v);
+  } else if (auto v = EmitAttribute<double>(&attr)) {
+    value = new Value(*v);
+  } else if (auto v = EmitAttribute<std::string>(&attr)) {
+    value = new Value(std::move(*v));
+  } else if (auto v = EmitAttribute<std::vector<int16_t>>(&attr)) {
+    value = new Value(std::move(*v));
+  } else if (auto v = EmitAttribute<std::vector<int32_t>>(&attr)) {
+    value = new Value(std::move(*v));
+  } else if (auto v = EmitAttribute<std::vector<int64_t>>(&attr)) {
+    value = new Value(std::move(*v));
+  } else if (auto v = EmitAttribute<std::vector<float>>(&attr)) {
+    value = new Value(std::move(*v));
+  } else if (auto v = EmitAttribute<std::vector<double>>(&attr)) {
+    value = new Value(std::move(*v));
+  } else {
+    LOG(FATAL) << "Not supported attribute type";
+  }
+  impl_->attribute_values.try_emplace(attr, ValueRef(value));
+  return value;
+}
+
 Value* MlirToRuntimeTranslator::GetOpResult(mlir::Operation* op) {
   auto it = impl_->op_results.find(op);
   return it == impl_->op_results.end() ? nullptr : it->second.front().get();
@@ -422,8 +434,11 @@ class MlirProgramTestExecutor : public MlirToRuntimeTranslator {
  public:
   CoreRuntimeBuilder core_runtime;
 
-  MlirProgramTestExecutor(mlir::ModuleOp module, KernelRegistry* registry)
-      : core_runtime(registry), MlirToRuntimeTranslator(module, &core_runtime), registry(registry) {
+  MlirProgramTestExecutor(mlir::ModuleOp module, KernelRegistry* registry, HostContext* host_context = nullptr)
+      : core_runtime(registry),
+        MlirToRuntimeTranslator(module, &core_runtime),
+        registry(registry),
+        host_context(host_context) {
     CHECK(registry);
   }
 
@@ -468,7 +483,11 @@ class MlirProgramTestExecutor : public MlirToRuntimeTranslator {
         LOG(FATAL) << "Not supported op: " << DumpToString(op);
       }
 
-      runtime.Execute();
+      if (host_context) {
+        runtime.Execute(host_context);
+      } else {
+        runtime.Execute();
+      }
 
     } else {
       VLOG(2) << "get an callable function: " << func.getName().str();
@@ -477,10 +496,11 @@ class MlirProgramTestExecutor : public MlirToRuntimeTranslator {
 
  private:
   KernelRegistry* registry{};
+  HostContext* host_context{};
 };
 
-void TestMlir(mlir::ModuleOp module, KernelRegistry* registry) {
-  MlirProgramTestExecutor execute(module, registry);
+void TestMlir(mlir::ModuleOp module, KernelRegistry* registry, HostContext* host_context) {
+  MlirProgramTestExecutor execute(module, registry, host_context);
   execute.Run();
 }
 
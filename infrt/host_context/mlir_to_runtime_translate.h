@@ -18,6 +18,7 @@ class Value;
 namespace infrt::host_context {
 
 class CoreRuntimeBuilder;
+class HostContext;
 class Value;
 class ValueRef;
 class KernelRegistry;
@@ -58,6 +59,9 @@ class MlirToRuntimeTranslator {
   template <typename T>
   absl::optional<T> EmitAttribute(const mlir::Attribute* attr);
 
+  //! Get the Value of an attribute, it is emitted once and shared by all the ops of the translator with the attribute.
+  Value* GetAttributeValue(mlir::Attribute attr);
+
   Value* GetOpResult(mlir::Operation* op);
 
   Value* GetValue(mlir::Value value);
@@ -83,7 +87,8 @@ void MlirToRuntimeTranslate(mlir::ModuleOp module, CoreRuntimeBuilder* runtime);
  * This is mainly used by testcase.
  * @param module a MLIR module.
  * @param registry the kernel registry containing all the valid kernels.
+ * @param host_context the work queue to execute the functions asynchronously on, they are executed in order if null.
  */
-void TestMlir(mlir::ModuleOp module, KernelRegistry* registry);
+void TestMlir(mlir::ModuleOp module, KernelRegistry* registry, HostContext* host_context = nullptr);
 
 }  // namespace infrt::host_context
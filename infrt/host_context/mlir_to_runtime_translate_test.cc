@@ -136,4 +136,45 @@ cinn.return %a0, %b0: !cinn.tensor<X86, NCHW, F32>, !cinn.tensor<X86, NCHW, F32>
   }
 }
 
+TEST(TestMlir, rebind_function_arguments) {
+  mlir::MLIRContext* context = infrt::Global::getMLIRContext();
+
+  auto source = R"ROC(
+func @add(%a: f32, %b: f32) -> f32 {
+  %c = "cinn.add.f32"(%a, %b) : (f32, f32) -> f32
+  cinn.return %c : f32
+}
+)ROC";
+
+  auto module = dialect::LoadMlirSource(context, source);
+  module->verify();
+
+  KernelRegistry registry;
+  kernel::RegisterFloatBasicKernels(&registry);
+  kernel::RegisterIntBasicKernels(&registry);
+
+  MlirProgramExecutor executor(*module, &registry);
+  executor.BuildFunctions();
+  auto* func = executor.LookupFunc("add");
+  ASSERT_TRUE(func);
+
+  std::vector<ValueRef> outputs({ValueRef(new Value(0.f))});
+  auto results = llvm::MutableArrayRef<ValueRef>(outputs.data(), outputs.size());
+
+  // the function is translated in the first call
+  std::vector<ValueRef> inputs0({ValueRef(new Value(1.f)), ValueRef(new Value(2.f))});
+  std::vector<Value*> args0({inputs0[0].get(), inputs0[1].get()});
+  func->Execute(llvm::ArrayRef<Value*>(args0.data(), args0.size()), results);
+  ASSERT_EQ(outputs[0].get<float>(), 3.f);
+
+  // and only rebound to the arguments of the later calls
+  std::vector<ValueRef> inputs1({ValueRef(new Value(3.f)), ValueRef(new Value(4.f))});
+  std::vector<Value*> args1({inputs1[0].get(), inputs1[1].get()});
+  func->Execute(llvm::ArrayRef<Value*>(args1.data(), args1.size()), results);
+  ASSERT_EQ(outputs[0].get<float>(), 7.f);
+
+  func->Execute(llvm::ArrayRef<Value*>(args0.data(), args0.size()), results);
+  ASSERT_EQ(outputs[0].get<float>(), 3.f);
+}
+
 }  // namespace infrt::host_context
@@ -1,5 +1,7 @@
 #include "infrt/host_context/op_executable.h"
 
+#include <absl/strings/match.h>
+
 #include <string>
 
 #include "infrt/host_context/kernel_frame.h"
@@ -31,6 +33,8 @@ struct OpExecutable::Impl {
 
   //! Tell whether this Op should be executed only once.
   bool run_once{};
+  //! Tell whether this Op writes its arguments though it has results.
+  bool writes_arguments{};
   //! Tell whether this op has been executed.
   bool has_executed{};
 };
@@ -49,9 +53,13 @@ OpExecutableBuilder::OpExecutableBuilder(absl::string_view op_name,
   // TODO(Superjomn) support other device other than CPU.
   CHECK(impl_->kernel_impl) << "No CPU kernel called " << op_name;
 
-  if (op_name == "dt.get_param") {
+  if (op_name == "dt.get_param" || absl::StartsWith(op_name, "dt.create_planned_tensor.")) {
     impl_->run_once = true;
   }
+  // the input buffer is taken over by the result, so the earlier users of the input should finish first
+  if (op_name == "dt.reuse_tensor") {
+    impl_->writes_arguments = true;
+  }
 }
 
 void OpExecutableBuilder::AppendArgument(absl::string_view name) {
@@ -99,6 +107,10 @@ MlirFunctionExecutable* OpExecutableBuilder::CreateFunctionExecutable(mlir::Regi
   return impl_->mlir_function_executable.get();
 }
 
+bool OpExecutable::run_once() const { return impl_->run_once; }
+
+bool OpExecutable::writes_arguments() const { return impl_->writes_arguments; }
+
 void OpExecutable::Execute() {
 #ifndef NDEBUG
   VLOG(3) << "execute " << name() << " --- frame args: " << impl_->frame.GetNumArgs() << " results "
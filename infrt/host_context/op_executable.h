@@ -36,6 +36,12 @@ class OpExecutable {
 
   absl::string_view name() const;
 
+  //! Whether the op is executed only in the first execution, its results are kept for the later ones.
+  bool run_once() const;
+
+  //! Whether the op writes its arguments though it has results, the ops without results are assumed to write them.
+  bool writes_arguments() const;
+
   ~OpExecutable();
 
  protected:
@@ -73,6 +73,11 @@ class Value : public infrt::common::Object {
     return data.get<T>();
   }
 
+  template <typename T>
+  bool is_type() const {
+    return data.template is<T>();
+  }
+
   template <typename T>
   void set(T&& v) {
     data = std::move(v);
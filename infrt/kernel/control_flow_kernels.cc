@@ -15,8 +15,8 @@ static void CINNCall(host_context::RemainingArguments args,
   CHECK_EQ(fn.get()->num_arguments(), args.size());
   CHECK_EQ(fn.get()->num_results(), results.size());
 
-  for (auto& v : results.values()) {
-    CHECK(v.get());
+  for (auto* v : results.values()) {
+    CHECK(v);
   }
   fn.get()->Execute(args.values(), results.values());
 }
@@ -0,0 +1,202 @@
+#include "infrt/kernel/pd_fused_kernels.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "infrt/host_context/kernel_registry.h"
+#include "infrt/host_context/kernel_utils.h"
+#include "infrt/tensor/dense_host_tensor.h"
+
+namespace infrt::kernel {
+using namespace host_context;  // NOLINT
+using namespace tensor;        // NOLINT
+
+namespace {
+
+std::vector<int64_t> GetDims(const DenseHostTensor& tensor) {
+  std::vector<int64_t> dims;
+  for (int i = 0; i < tensor.shape().GetRank(); i++) dims.push_back(tensor.shape().GetDim(i));
+  return dims;
+}
+
+int64_t Product(const std::vector<int64_t>& dims, int begin, int end) {
+  int64_t res = 1;
+  for (int i = begin; i < end; i++) res *= dims[i];
+  return res;
+}
+
+const float* GetData(const DenseHostTensor& tensor) {
+  CHECK(tensor.metadata().dtype == GetDType<float>()) << "the fused pd kernels only support the float32 tensors";
+  return static_cast<const float*>(tensor.raw_data());
+}
+
+DenseHostTensor CreateTensor(const std::vector<int64_t>& dims) {
+  return DenseHostTensor(TensorShape(llvm::ArrayRef<int64_t>(dims.data(), dims.size())), GetDType<float>());
+}
+
+/**
+ * out[m, n] = x[m, k] * w[k, n] + bias[n], with the relu optionally. The loops are in the order of m, k and n, so the
+ * innermost one runs over the contiguous rows of w and out, which the compiler vectorizes.
+ */
+void Gemm(const float* x, const float* w, const float* bias, float* out, int64_t m, int64_t k, int64_t n, bool relu) {
+  for (int64_t i = 0; i < m; i++) {
+    float* out_row = out + i * n;
+    std::copy(bias, bias + n, out_row);
+    for (int64_t p = 0; p < k; p++) {
+      float a            = x[i * k + p];
+      const float* w_row = w + p * n;
+      for (int64_t j = 0; j < n; j++) out_row[j] += a * w_row[j];
+    }
+    if (relu) {
+      for (int64_t j = 0; j < n; j++) out_row[j] = std::max(out_row[j], 0.f);
+    }
+  }
+}
+
+//! The FC of x flattened to [x0 * ... * x(num_col_dims - 1), ...], the result keeps the leading dimensions of x.
+DenseHostTensor FullyConnected(
+    const DenseHostTensor& x, const DenseHostTensor& w, const DenseHostTensor& bias, int num_col_dims, bool relu) {
+  auto x_dims = GetDims(x);
+  auto w_dims = GetDims(w);
+  CHECK_EQ(w_dims.size(), 2UL) << "the weight of FC should be 2-D";
+  CHECK(num_col_dims > 0 && num_col_dims <= x_dims.size());
+  int64_t m = Product(x_dims, 0, num_col_dims);
+  int64_t k = Product(x_dims, num_col_dims, x_dims.size());
+  int64_t n = w_dims[1];
+  CHECK_EQ(k, w_dims[0]) << "the shapes of the input and the weight of FC mismatch";
+  CHECK_EQ(bias.shape().GetNumElements(), n) << "the bias of FC should be of the output width";
+
+  std::vector<int64_t> out_dims(x_dims.begin(), x_dims.begin() + num_col_dims);
+  out_dims.push_back(n);
+  auto out = CreateTensor(out_dims);
+  Gemm(GetData(x), GetData(w), GetData(bias), static_cast<float*>(out.raw_data()), m, k, n, relu);
+  return out;
+}
+
+/// ===== Kernel begin ====
+
+DenseHostTensor FC(const DenseHostTensor& x,
+                   const DenseHostTensor& w,
+                   const DenseHostTensor& bias,
+                   Attribute<int32_t> in_num_col_dims) {
+  return FullyConnected(x, w, bias, in_num_col_dims.get(), false);
+}
+
+//! The arguments are the input, the weights and the biases, each layer is an FC with relu fed by the last one.
+void RepeatedFCRelu(RemainingArguments args, RemainingResults results) {
+  CHECK_EQ(args.size() % 2, 1UL) << "RepeatedFCRelu takes an input and the same number of weights and biases";
+  CHECK_EQ(results.size(), 1UL);
+  int num_layers = args.size() / 2;
+  DenseHostTensor out;
+  for (int i = 0; i < num_layers; i++) {
+    const auto& x = i == 0 ? args[0]->get<DenseHostTensor>() : out;
+    out           = FullyConnected(
+        x, args[1 + i]->get<DenseHostTensor>(), args[1 + num_layers + i]->get<DenseHostTensor>(), 1, true);
+  }
+  results[0]->set(std::move(out));
+}
+
+//! The conv2d of NCHW with the filter of OIHW, the stride 1 and no padding, followed by relu.
+DenseHostTensor FusedConv2dRelu(const DenseHostTensor& input,
+                                const DenseHostTensor& filter,
+                                const DenseHostTensor& bias) {
+  auto in_dims     = GetDims(input);
+  auto filter_dims = GetDims(filter);
+  CHECK_EQ(in_dims.size(), 4UL) << "the input of conv2d should be NCHW";
+  CHECK_EQ(filter_dims.size(), 4UL) << "the filter of conv2d should be OIHW";
+  int64_t batch = in_dims[0], channels = in_dims[1], in_h = in_dims[2], in_w = in_dims[3];
+  int64_t out_c = filter_dims[0], k_h = filter_dims[2], k_w = filter_dims[3];
+  CHECK_EQ(filter_dims[1], channels) << "the channels of the input and the filter of conv2d mismatch";
+  CHECK_EQ(bias.shape().GetNumElements(), out_c) << "the bias of conv2d should be of the output channels";
+  int64_t out_h = in_h - k_h + 1, out_w = in_w - k_w + 1;
+  CHECK(out_h > 0 && out_w > 0) << "the filter of conv2d is larger than the input";
+
+  auto out         = CreateTensor({batch, out_c, out_h, out_w});
+  const float* in  = GetData(input);
+  const float* w   = GetData(filter);
+  const float* b   = GetData(bias);
+  float* out_data  = static_cast<float*>(out.raw_data());
+  int64_t in_area  = in_h * in_w;
+  int64_t out_area = out_h * out_w;
+  for (int64_t n = 0; n < batch; n++) {
+    for (int64_t o = 0; o < out_c; o++) {
+      float* out_plane = out_data + (n * out_c + o) * out_area;
+      std::fill(out_plane, out_plane + out_area, b[o]);
+      for (int64_t c = 0; c < channels; c++) {
+        const float* in_plane = in + (n * channels + c) * in_area;
+        const float* w_plane  = w + (o * channels + c) * k_h * k_w;
+        for (int64_t kh = 0; kh < k_h; kh++) {
+          for (int64_t kw = 0; kw < k_w; kw++) {
+            float weight = w_plane[kh * k_w + kw];
+            // the rows of the output and the shifted input are contiguous, so the innermost loop is vectorized
+            for (int64_t oh = 0; oh < out_h; oh++) {
+              const float* in_row = in_plane + (oh + kh) * in_w + kw;
+              float* out_row      = out_plane + oh * out_w;
+              for (int64_t ow = 0; ow < out_w; ow++) out_row[ow] += weight * in_row[ow];
+            }
+          }
+        }
+      }
+      for (int64_t i = 0; i < out_area; i++) out_plane[i] = std::max(out_plane[i], 0.f);
+    }
+  }
+  return out;
+}
+
+//! The attributes are in the order of their names, begin_norm_axis then epsilon.
+DenseHostTensor LayerNorm(const DenseHostTensor& x,
+                          const DenseHostTensor& scale,
+                          const DenseHostTensor& bias,
+                          Attribute<int32_t> begin_norm_axis,
+                          Attribute<float> epsilon) {
+  auto dims = GetDims(x);
+  int axis  = begin_norm_axis.get() < 0 ? begin_norm_axis.get() + dims.size() : begin_norm_axis.get();
+  CHECK(axis >= 0 && axis < dims.size()) << "invalid begin_norm_axis " << begin_norm_axis.get() << " of layer_norm";
+  int64_t rows = Product(dims, 0, axis);
+  int64_t cols = Product(dims, axis, dims.size());
+  CHECK_EQ(scale.shape().GetNumElements(), cols) << "the scale of layer_norm should be of the normalized size";
+  CHECK_EQ(bias.shape().GetNumElements(), cols) << "the bias of layer_norm should be of the normalized size";
+
+  auto out       = CreateTensor(dims);
+  const float* s = GetData(scale);
+  const float* b = GetData(bias);
+  for (int64_t i = 0; i < rows; i++) {
+    const float* in_row = GetData(x) + i * cols;
+    float* out_row      = static_cast<float*>(out.raw_data()) + i * cols;
+    float mean          = 0;
+    for (int64_t j = 0; j < cols; j++) mean += in_row[j];
+    mean /= cols;
+    float var = 0;
+    for (int64_t j = 0; j < cols; j++) var += (in_row[j] - mean) * (in_row[j] - mean);
+    float inv_std = 1.f / std::sqrt(var / cols + epsilon.get());
+    for (int64_t j = 0; j < cols; j++) out_row[j] = (in_row[j] - mean) * inv_std * s[j] + b[j];
+  }
+  return out;
+}
+
+DenseHostTensor Gelu(const DenseHostTensor& x) {
+  auto out         = CreateTensor(GetDims(x));
+  const float* in  = GetData(x);
+  float* out_data  = static_cast<float*>(out.raw_data());
+  int64_t num      = x.shape().GetNumElements();
+  const float kInv = 0.70710678f;
+  for (int64_t i = 0; i < num; i++) out_data[i] = 0.5f * in[i] * (1.f + std::erf(in[i] * kInv));
+  return out;
+}
+
+/// ===== Kernel end ====
+
+}  // namespace
+
+void RegisterPdFusedKernels(host_context::KernelRegistry* registry) {
+  registry->AddKernel("pd.FC", CINN_KERNEL(FC));
+  registry->AddKernel("pd.RepeatedFCRelu", CINN_KERNEL(RepeatedFCRelu));
+  registry->AddKernel("pd.FusedConv2dRelu", CINN_KERNEL(FusedConv2dRelu));
+  registry->AddKernel("pd.layer_norm", CINN_KERNEL(LayerNorm));
+  registry->AddKernel("pd.gelu", CINN_KERNEL(Gelu));
+}
+
+}  // namespace infrt::kernel
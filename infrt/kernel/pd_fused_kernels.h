@@ -0,0 +1,15 @@
+#pragma once
+
+namespace infrt::host_context {
+struct KernelRegistry;
+}  // namespace infrt::host_context
+
+namespace infrt::kernel {
+
+/**
+ * Register the kernels of the fused pd ops created by the pd-fuse-ops pass, FC, RepeatedFCRelu, FusedConv2dRelu,
+ * layer_norm and gelu, on the float DenseHostTensors.
+ */
+void RegisterPdFusedKernels(host_context::KernelRegistry* registry);
+
+}  // namespace infrt::kernel
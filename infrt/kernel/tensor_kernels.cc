@@ -46,12 +46,16 @@ DenseHostTensor ShallowCopyTensor(DenseHostTensor v) { return v; }
 void RegisterTensorKernels(host_context::KernelRegistry *registry) {
   registry->AddKernel("dt.create_uninit_tensor.f32", CINN_KERNEL(CreateUninitTensor<float>));
   registry->AddKernelAttrNameList("dt.create_uninit_tensor.f32", {"shape"});
+  // created once by the run_once executables, the kernel is the same
+  registry->AddKernel("dt.create_planned_tensor.f32", CINN_KERNEL(CreateUninitTensor<float>));
+  registry->AddKernelAttrNameList("dt.create_planned_tensor.f32", {"shape"});
   registry->AddKernel("dt.print_tensor", CINN_KERNEL(PrintTensor));
   registry->AddKernel("dt.fill_tensor_with_constant.f32", CINN_KERNEL(FillTensorWithConstant<float>));
   registry->AddKernel("dt.fill_tensor_with_constant.f64", CINN_KERNEL(FillTensorWithConstant<double>));
   registry->AddKernel("dt.load_params", CINN_KERNEL(LoadParams));
   registry->AddKernel("dt.get_param", CINN_KERNEL(GetParam));
   registry->AddKernel("dt.shallow_copy_tensor", CINN_KERNEL(ShallowCopyTensor));
+  registry->AddKernel("dt.reuse_tensor", CINN_KERNEL(ShallowCopyTensor));
 }
 
 }  // namespace infrt::kernel
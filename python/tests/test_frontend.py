@@ -188,6 +188,28 @@ class TestLoadPaddleModel_MultiFC(unittest.TestCase):
 
         self.assertTrue(np.allclose(out.numpy(self.target), target, atol=1e-4))
 
+    def test_run_async(self):
+        np.random.seed(0)
+        self.x_shape = [8, 64]
+        x_data = np.random.random(self.x_shape).astype("float32")
+
+        self.executor = Interpreter(["A"], [self.x_shape])
+        self.executor.load_paddle_model(self.model_dir, self.target, False)
+        out_name = "save_infer_model/scale_0.tmp_0"
+        out_shape = self.executor.get_tensor(out_name).shape()
+        expected = np.zeros(out_shape, "float32")
+        self.executor.run([x_data], {out_name: expected})
+
+        outs = [np.zeros(out_shape, "float32") for _ in range(4)]
+        runs = [
+            self.executor.run_async([x_data], {out_name: out})
+            for out in outs
+        ]
+        for run, out in zip(runs, outs):
+            run.wait()
+            self.assertTrue(run.done())
+            self.assertTrue(np.array_equal(out, expected))
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -13,6 +13,7 @@
 # limitations under the License.
 
 from cinn.framework import *
+from cinn.common import *
 import unittest
 import numpy as np
 
@@ -29,6 +30,34 @@ class TensorTest(unittest.TestCase):
 
         self.assertTrue(np.allclose(tensor.numpy(), data))
 
+    def test_buffer_view(self):
+        target = DefaultHostTarget()
+        tensor = Tensor()
+        data = np.random.random([4, 3]).astype("float32")
+        tensor.from_numpy(data, target)
+
+        view = np.asarray(tensor)
+        self.assertEqual(view.shape, (4, 3))
+        self.assertTrue(np.allclose(view, data))
+        view[1, 2] = 7.0
+        self.assertEqual(tensor.numpy(target)[1, 2], 7.0)
+
+    @unittest.skipIf(not hasattr(np, "from_dlpack"), "numpy has no DLPack")
+    def test_dlpack(self):
+        data = np.random.random([2, 8]).astype("float32")
+        tensor = from_dlpack(data)
+        self.assertEqual(tensor.shape(), [2, 8])
+        data[0, 3] = 5.0
+        self.assertEqual(np.asarray(tensor)[0, 3], 5.0)
+
+        out = np.from_dlpack(tensor)
+        self.assertTrue(np.allclose(out, data))
+
+        fed = Tensor()
+        fed.from_numpy(np.zeros([16], "float32"), DefaultHostTarget())
+        fed.share_dlpack(data)
+        self.assertTrue(np.allclose(np.asarray(fed), data.reshape([16])))
+
 
 if __name__ == "__main__":
     unittest.main()
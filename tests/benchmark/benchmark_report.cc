@@ -0,0 +1,171 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/benchmark/benchmark_report.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "cinn/utils/string.h"
+
+DEFINE_string(benchmark_json, "", "The file to write the benchmark results in JSON, skipped if empty.");
+DEFINE_string(benchmark_csv, "", "The file to write the benchmark results in CSV, which can be a later baseline.");
+DEFINE_string(benchmark_baseline, "", "The CSV results to compare with, the regressions fail the run.");
+DEFINE_double(benchmark_regression_threshold, 0.1, "The ratio of the p50 latency over the baseline to fail.");
+
+namespace cinn {
+namespace tests {
+namespace {
+
+std::string ShapesToString(const std::vector<std::vector<int>>& shapes) {
+  std::vector<std::string> strs;
+  for (auto& shape : shapes) {
+    std::vector<std::string> dims;
+    for (int dim : shape) dims.push_back(std::to_string(dim));
+    strs.push_back(utils::Join(dims, "x"));
+  }
+  return utils::Join(strs, ";");
+}
+
+std::vector<std::vector<int>> ShapesFromString(const std::string& str) {
+  std::vector<std::vector<int>> shapes;
+  for (auto& shape_str : utils::Split(str, ";")) {
+    std::vector<int> shape;
+    for (auto& dim : utils::Split(shape_str, "x")) shape.push_back(std::stoi(dim));
+    shapes.push_back(shape);
+  }
+  return shapes;
+}
+
+// Write the results and compare with the baseline after all the tests.
+class BenchmarkEnvironment : public ::testing::Environment {
+ public:
+  void TearDown() override {
+    for (auto& regression : BenchmarkReport::Global().Finish()) ADD_FAILURE() << "Benchmark regression: " << regression;
+  }
+};
+
+::testing::Environment* const benchmark_env = ::testing::AddGlobalTestEnvironment(new BenchmarkEnvironment);
+
+}  // namespace
+
+double Percentile(std::vector<double> samples, double p) {
+  CHECK(!samples.empty());
+  std::sort(samples.begin(), samples.end());
+  int rank = std::ceil(p * samples.size());
+  return samples[std::min<int>(std::max(rank, 1), samples.size()) - 1];
+}
+
+BenchmarkReport& BenchmarkReport::Global() {
+  static BenchmarkReport report;
+  return report;
+}
+
+void BenchmarkReport::Add(const BenchmarkResult& result) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  LOG(INFO) << "Benchmark " << result.name << ": p50 " << result.p50_ms << " ms, p99 " << result.p99_ms << " ms, "
+            << result.gbps() << " GB/s, " << result.gflops() << " GFLOP/s";
+  results_.push_back(result);
+}
+
+void BenchmarkReport::WriteJson(const std::string& path) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ofstream os(path);
+  CHECK(os.is_open()) << "Cannot open file: " << path;
+  os << "[\n";
+  for (int i = 0; i < results_.size(); i++) {
+    auto& r = results_[i];
+    os << "  {\"name\": \"" << r.name << "\", \"op\": \"" << r.op_name << "\", \"input_shapes\": [";
+    for (int j = 0; j < r.input_shapes.size(); j++) {
+      os << (j ? ", [" : "[") << utils::Join(r.input_shapes[j], ", ") << "]";
+    }
+    os << "], \"repeat\": " << r.repeat << ", \"mean_ms\": " << r.mean_ms << ", \"p50_ms\": " << r.p50_ms
+       << ", \"p99_ms\": " << r.p99_ms << ", \"gbps\": " << r.gbps() << ", \"gflops\": " << r.gflops() << "}"
+       << (i + 1 < results_.size() ? ",\n" : "\n");
+  }
+  os << "]\n";
+}
+
+void BenchmarkReport::WriteCsv(const std::string& path) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ofstream os(path);
+  CHECK(os.is_open()) << "Cannot open file: " << path;
+  os << "name,op,input_shapes,repeat,mean_ms,p50_ms,p99_ms,bytes,flops,gbps,gflops\n";
+  for (auto& r : results_) {
+    os << r.name << "," << r.op_name << "," << ShapesToString(r.input_shapes) << "," << r.repeat << "," << r.mean_ms
+       << "," << r.p50_ms << "," << r.p99_ms << "," << r.bytes << "," << r.flops << "," << r.gbps() << ","
+       << r.gflops() << "\n";
+  }
+}
+
+std::map<std::string, BenchmarkResult> BenchmarkReport::LoadCsv(const std::string& path) {
+  std::ifstream is(path);
+  CHECK(is.is_open()) << "Cannot open file: " << path;
+  std::map<std::string, BenchmarkResult> results;
+  std::string line;
+  // skip the header
+  std::getline(is, line);
+  while (std::getline(is, line)) {
+    if (line.empty()) continue;
+    auto fields = utils::Split(line, ",");
+    CHECK_GE(fields.size(), 9UL) << "Invalid benchmark result: " << line;
+    BenchmarkResult r;
+    r.name         = fields[0];
+    r.op_name      = fields[1];
+    r.input_shapes = ShapesFromString(fields[2]);
+    r.repeat       = std::stoi(fields[3]);
+    r.mean_ms      = std::stod(fields[4]);
+    r.p50_ms       = std::stod(fields[5]);
+    r.p99_ms       = std::stod(fields[6]);
+    r.bytes        = std::stod(fields[7]);
+    r.flops        = std::stod(fields[8]);
+    results[r.name] = r;
+  }
+  return results;
+}
+
+std::vector<std::string> BenchmarkReport::Compare(const std::map<std::string, BenchmarkResult>& baseline,
+                                                  double threshold) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::string> regressions;
+  for (auto& r : results_) {
+    auto it = baseline.find(r.name);
+    if (it == baseline.end()) {
+      LOG(INFO) << "Benchmark " << r.name << " is not in the baseline";
+      continue;
+    }
+    double ratio = it->second.p50_ms > 0 ? r.p50_ms / it->second.p50_ms : 1;
+    if (ratio > 1 + threshold) {
+      std::stringstream ss;
+      ss << r.name << " p50 " << r.p50_ms << " ms vs baseline " << it->second.p50_ms << " ms (" << ratio << "x)";
+      regressions.push_back(ss.str());
+    }
+  }
+  return regressions;
+}
+
+std::vector<std::string> BenchmarkReport::Finish() const {
+  if (!FLAGS_benchmark_json.empty()) WriteJson(FLAGS_benchmark_json);
+  if (!FLAGS_benchmark_csv.empty()) WriteCsv(FLAGS_benchmark_csv);
+  if (FLAGS_benchmark_baseline.empty()) return {};
+  return Compare(LoadCsv(FLAGS_benchmark_baseline), FLAGS_benchmark_regression_threshold);
+}
+
+}  // namespace tests
+}  // namespace cinn
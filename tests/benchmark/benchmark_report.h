@@ -0,0 +1,85 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <gflags/gflags.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+DECLARE_string(benchmark_json);
+DECLARE_string(benchmark_csv);
+DECLARE_string(benchmark_baseline);
+DECLARE_double(benchmark_regression_threshold);
+
+namespace cinn {
+namespace tests {
+
+//! The measurement of a kernel benchmarked by OpBenchmarkTester.
+struct BenchmarkResult {
+  std::string name;
+  std::string op_name;
+  std::vector<std::vector<int>> input_shapes;
+  int repeat{};
+  double mean_ms{};
+  double p50_ms{};
+  double p99_ms{};
+  //! Bytes of all the inputs and outputs, each is assumed to be accessed once a run.
+  double bytes{};
+  double flops{};
+
+  double gbps() const { return p50_ms > 0 ? bytes / (p50_ms * 1e6) : 0; }
+  double gflops() const { return p50_ms > 0 ? flops / (p50_ms * 1e6) : 0; }
+};
+
+//! Get the p-th(0 ~ 1) percentile of \p samples by the nearest rank.
+double Percentile(std::vector<double> samples, double p);
+
+/**
+ * The results of all the benchmarks in a test binary. They are written to the files of --benchmark_json and
+ * --benchmark_csv after all the tests, and compared with the csv file of --benchmark_baseline if given, a benchmark
+ * whose p50 latency exceeds the baseline by --benchmark_regression_threshold fails the run.
+ */
+class BenchmarkReport {
+ public:
+  static BenchmarkReport& Global();
+
+  void Add(const BenchmarkResult& result);
+
+  const std::vector<BenchmarkResult>& results() const { return results_; }
+
+  void WriteJson(const std::string& path) const;
+  void WriteCsv(const std::string& path) const;
+
+  //! Load the results written by WriteCsv, by their names.
+  static std::map<std::string, BenchmarkResult> LoadCsv(const std::string& path);
+
+  //! Describe the results slower than their \p baseline by more than \p threshold of the p50 latency.
+  std::vector<std::string> Compare(const std::map<std::string, BenchmarkResult>& baseline, double threshold) const;
+
+  //! Write the files and compare with the baseline as the flags tell, return the regressions found.
+  std::vector<std::string> Finish() const;
+
+ private:
+  BenchmarkReport() = default;
+
+  std::vector<BenchmarkResult> results_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace tests
+}  // namespace cinn
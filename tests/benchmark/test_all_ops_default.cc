@@ -35,7 +35,7 @@ using cinn::hlir::framework::AttrType;
     hlir::framework::NodeAttr attrs;                                                                \
     OpBenchmarkTester tester(op_name, input_shapes);                                                \
     auto input_tensors = tester.CreateInputTensors<float>();                                        \
-    tester.TestOp(common::UniqName(#op_name__), input_tensors, attrs, input_types_, output_types_); \
+    tester.TestOp(#op_name__ "/" #shape_name__, input_tensors, attrs, input_types_, output_types_); \
   }
 
 #define TEST_DEFAULT1(op_name__, shape_name__, input_types_, output_types_, attr_store__)           \
@@ -47,7 +47,7 @@ using cinn::hlir::framework::AttrType;
     attrs.attr_store   = attr_store__;                                                              \
     auto input_tensors = tester.CreateInputTensors<float>();                                        \
     std::vector<Type> input_types{Float(32), Float(32)};                                            \
-    tester.TestOp(common::UniqName(#op_name__), input_tensors, attrs, input_types_, output_types_); \
+    tester.TestOp(#op_name__ "/" #shape_name__, input_tensors, attrs, input_types_, output_types_); \
   }
 
 #define TEST_DEFAULT_INT(op_name__, shape_name__, input_types_, output_types_)                      \
@@ -57,7 +57,7 @@ using cinn::hlir::framework::AttrType;
     hlir::framework::NodeAttr attrs;                                                                \
     OpBenchmarkTester tester(op_name, input_shapes);                                                \
     auto input_tensors = tester.CreateInputTensors<int>();                                          \
-    tester.TestOp(common::UniqName(#op_name__), input_tensors, attrs, input_types_, output_types_); \
+    tester.TestOp(#op_name__ "/" #shape_name__, input_tensors, attrs, input_types_, output_types_); \
   }
 
 std::vector<Type> type  = {Float(32)};
@@ -34,6 +34,11 @@ class MatmulTester : public OpBenchmarkTester {
 
   std::vector<ir::Tensor> CreateSpecificStrategy(const std::vector<ir::Tensor> &inputs,
                                                  poly::StageMap *stages) override;
+
+  //! 2 * M * N * K for the inputs of [M, K] and [K, N].
+  double EstimateFlops() const override {
+    return 2. * input_shapes()[0][0] * input_shapes()[0][1] * input_shapes()[1][1];
+  }
 };
 
 class MatmulTileTester : public MatmulTester {
@@ -0,0 +1,118 @@
+// Copyright (c) 2021 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cinn/cinn.h"
+#include "cinn/hlir/framework/node.h"
+#include "cinn/hlir/framework/op.h"
+#include "cinn/runtime/cpu/use_extern_funcs.h"
+#include "cinn/utils/string.h"
+#include "tests/benchmark/benchmark_report.h"
+#include "tests/benchmark/test_utils.h"
+
+DEFINE_string(benchmark_corpus, "", "The file of the op shapes to benchmark, see shape_corpus.txt.");
+
+namespace cinn {
+namespace tests {
+
+using cinn::hlir::framework::AttrType;
+
+namespace {
+
+struct CorpusEntry {
+  std::string name;
+  std::string op_name;
+  std::vector<std::vector<int>> input_shapes;
+  int num_outputs{1};
+  hlir::framework::NodeAttr attrs;
+};
+
+AttrType ParseAttr(const std::string& value) {
+  if (value == "true" || value == "false") return value == "true";
+  if (value.find_first_not_of("0123456789-.,") != std::string::npos) return value;
+  if (value.find(',') != std::string::npos) {
+    std::vector<int> values;
+    for (auto& item : utils::Split(value, ",")) {
+      if (!item.empty()) values.push_back(std::stoi(item));
+    }
+    return values;
+  }
+  if (value.find('.') != std::string::npos) return std::stof(value);
+  return std::stoi(value);
+}
+
+std::vector<CorpusEntry> LoadCorpus(const std::string& path) {
+  std::ifstream is(path);
+  CHECK(is.is_open()) << "Cannot open file: " << path;
+  std::vector<CorpusEntry> entries;
+  std::string line;
+  while (std::getline(is, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::stringstream ss(line);
+    CorpusEntry entry;
+    std::string shapes;
+    ss >> entry.name >> entry.op_name >> shapes;
+    CHECK(!shapes.empty()) << "Invalid corpus entry: " << line;
+    for (auto& shape_str : utils::Split(shapes, ";")) {
+      std::vector<int> shape;
+      for (auto& dim : utils::Split(shape_str, "x")) shape.push_back(std::stoi(dim));
+      entry.input_shapes.push_back(shape);
+    }
+    std::string attr;
+    while (ss >> attr) {
+      auto pos = attr.find('=');
+      CHECK_NE(pos, std::string::npos) << "Invalid attribute " << attr << " in: " << line;
+      auto key = attr.substr(0, pos);
+      if (key == "outputs") {
+        entry.num_outputs = std::stoi(attr.substr(pos + 1));
+      } else {
+        entry.attrs.attr_store[key] = ParseAttr(attr.substr(pos + 1));
+      }
+    }
+    entries.push_back(entry);
+  }
+  return entries;
+}
+
+}  // namespace
+
+TEST(op_corpus, models) {
+  if (FLAGS_benchmark_corpus.empty()) {
+    LOG(INFO) << "No --benchmark_corpus given, skipped";
+    return;
+  }
+  for (auto& entry : LoadCorpus(FLAGS_benchmark_corpus)) {
+    OpBenchmarkTester tester(entry.op_name, entry.input_shapes);
+    auto input_tensors = tester.CreateInputTensors<float>();
+    std::vector<Type> input_types(entry.input_shapes.size(), Float(32));
+    std::vector<Type> out_types(entry.num_outputs, Float(32));
+    tester.TestOp(entry.name, input_tensors, entry.attrs, input_types, out_types);
+  }
+
+  std::set<std::string> covered;
+  for (auto& result : BenchmarkReport::Global().results()) covered.insert(result.op_name);
+  for (auto& op_name : hlir::framework::OpRegistry::Global()->ListAllNames()) {
+    if (!covered.count(op_name)) LOG(INFO) << "The op " << op_name << " is not in the corpus";
+  }
+}
+
+}  // namespace tests
+}  // namespace cinn
@@ -14,12 +14,15 @@
 
 #include "tests/benchmark/test_utils.h"
 
+#include <numeric>
+
 #include "cinn/backends/llvm/codegen_x86.h"
 #include "cinn/common/cas.h"
 #include "cinn/common/test_helper.h"
 #include "cinn/hlir/framework/op.h"
 #include "cinn/hlir/framework/op_strategy.h"
 #include "cinn/utils/timer.h"
+#include "tests/benchmark/benchmark_report.h"
 
 namespace cinn {
 namespace tests {
@@ -49,12 +52,37 @@ void OpBenchmarkTester::TestOp(const std::string& test_name,
   test_func_ptr(reinterpret_cast<void**>(all_args_.data()), all_args_.size());
   double test_op_time = timer.Stop();
   LOG(INFO) << "kernel warmup run time: " << test_op_time << " ms";
-  timer.Start();
+  std::vector<double> samples;
   for (int i = 0; i < repeat_; i++) {
+    timer.Start();
     test_func_ptr(reinterpret_cast<void**>(all_args_.data()), all_args_.size());
+    samples.push_back(timer.Stop());
   }
-  test_op_time = timer.Stop() / repeat_;
+  test_op_time = std::accumulate(samples.begin(), samples.end(), 0.) / repeat_;
   LOG(INFO) << "repeat times: " << repeat_ << ", kernel run time: " << test_op_time << " ms";
+
+  BenchmarkResult result;
+  result.name         = test_name;
+  result.op_name      = op_name_;
+  result.input_shapes = input_shapes_;
+  result.repeat       = repeat_;
+  result.mean_ms      = test_op_time;
+  result.p50_ms       = Percentile(samples, 0.5);
+  result.p99_ms       = Percentile(samples, 0.99);
+  for (auto& arg : all_args_) {
+    cinn_buffer_t* buffer = arg;
+    result.bytes += buffer->num_elements() * buffer->type.bytes();
+  }
+  result.flops = EstimateFlops();
+  BenchmarkReport::Global().Add(result);
+}
+
+double OpBenchmarkTester::EstimateFlops() const {
+  double flops = 0;
+  for (auto& shape : output_shapes_) {
+    flops += std::accumulate(shape.begin(), shape.end(), 1., std::multiplies<double>());
+  }
+  return flops;
 }
 
 Module OpBenchmarkTester::CreateCinnModule(const std::vector<Tensor>& input_tensors,
@@ -58,8 +58,12 @@ class OpBenchmarkTester {
 
   virtual std::unique_ptr<backends::ExecutionEngine> CreateExecutionEngine(const cinn::ir::Module &module);
 
+  //! The floating point operations of a run, one per output element by default.
+  virtual double EstimateFlops() const;
+
   std::vector<cinn_pod_value_t> &GetAllArgs() { return all_args_; }
   int GetOutDims() { return out_dims_; }
+  const std::vector<std::vector<int>> &input_shapes() const { return input_shapes_; }
 
   template <typename T = float>
   std::vector<ir::Tensor> CreateInputTensors() {
@@ -0,0 +1,290 @@
+# Copyright (c) 2021 CINN Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""
+Benchmark a Paddle inference model end to end on CINN, Paddle Inference and TVM.
+
+For each backend, target, batch size and number of threads, it measures the compile time, the first-run latency, the
+steady-state latency(p50/p99) and throughput, and the peak host memory. The threads are concurrent serving workers,
+each runs its own copy of the model on the same inputs. The peak memory is of the whole process, so run the backends
+in separate processes to compare their memory.
+
+Example:
+    python model_benchmark.py --model_dir ResNet50 --params_combined \\
+        --input_name inputs --input_shape 3,224,224 \\
+        --output_name save_infer_model/scale_0.tmp_1 \\
+        --batch_sizes 1,8,32 --threads 1,4 --targets x86,nvgpu \\
+        --backends cinn,paddle,tvm --csv resnet50.csv
+"""
+
+import argparse
+import csv
+import json
+import resource
+import threading
+import time
+
+import numpy as np
+
+
+def percentile(samples, p):
+    samples = sorted(samples)
+    rank = max(1, int(np.ceil(p * len(samples))))
+    return samples[min(rank, len(samples)) - 1]
+
+
+def peak_host_memory_mb():
+    # ru_maxrss is in kilobytes on Linux
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024.0
+
+
+def measure(runners, x_data, warmup, repeat):
+    """
+    Run each runner, one per worker thread, `repeat` times after the warmup and collect the latencies in ms.
+    Return the first-run latency, all the steady-state latencies and the elapsed seconds of the steady runs.
+    """
+    start = time.perf_counter()
+    runners[0](x_data)
+    first_ms = (time.perf_counter() - start) * 1000
+    for runner in runners:
+        for _ in range(warmup):
+            runner(x_data)
+
+    latencies = []
+    lock = threading.Lock()
+
+    def worker(runner):
+        local = []
+        for _ in range(repeat):
+            begin = time.perf_counter()
+            runner(x_data)
+            local.append((time.perf_counter() - begin) * 1000)
+        with lock:
+            latencies.extend(local)
+
+    threads = [
+        threading.Thread(target=worker, args=(runner, )) for runner in runners
+    ]
+    start = time.perf_counter()
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    return first_ms, latencies, time.perf_counter() - start
+
+
+class CinnBackend:
+    name = "cinn"
+
+    def __init__(self, args, target):
+        from cinn.common import DefaultHostTarget, DefaultNVGPUTarget
+        self.args = args
+        self.target = DefaultNVGPUTarget(
+        ) if target == "nvgpu" else DefaultHostTarget()
+
+    def compile(self, x_shape):
+        from cinn.frontend import Interpreter
+        self.executor = Interpreter([self.args.input_name], [x_shape])
+        self.executor.load_paddle_model(self.args.model_dir, self.target,
+                                        self.args.params_combined)
+        self.out_shape = self.executor.get_tensor(
+            self.args.output_name).shape()
+
+    def runners(self, num_threads):
+        # the interpreter runs the concurrent calls on its own clones of the program
+        def make_runner():
+            out = np.zeros(self.out_shape, dtype="float32")
+
+            def run(x_data):
+                self.executor.run([x_data], {self.args.output_name: out})
+
+            return run
+
+        return [make_runner() for _ in range(num_threads)]
+
+
+class PaddleBackend:
+    name = "paddle"
+
+    def __init__(self, args, target):
+        self.args = args
+        self.target = target
+
+    def compile(self, x_shape):
+        from paddle.inference import Config, create_predictor
+        if self.args.params_combined:
+            config = Config(self.args.model_dir + "/__model__",
+                            self.args.model_dir + "/params")
+        else:
+            config = Config(self.args.model_dir)
+        if self.target == "nvgpu":
+            config.enable_use_gpu(1000, 0)
+        else:
+            config.disable_gpu()
+            config.enable_mkldnn()
+        config.switch_ir_optim(True)
+        config.enable_memory_optim()
+        self.predictor = create_predictor(config)
+        self.x_shape = x_shape
+
+    def runners(self, num_threads):
+        predictors = [self.predictor] + [
+            self.predictor.clone() for _ in range(num_threads - 1)
+        ]
+
+        def make_runner(predictor):
+            input_tensor = predictor.get_input_handle(self.args.input_name)
+            output_tensor = predictor.get_output_handle(
+                predictor.get_output_names()[0])
+
+            def run(x_data):
+                input_tensor.reshape(list(x_data.shape))
+                input_tensor.copy_from_cpu(x_data)
+                predictor.run()
+                output_tensor.copy_to_cpu()
+
+            return run
+
+        return [make_runner(predictor) for predictor in predictors]
+
+
+class TvmBackend:
+    name = "tvm"
+
+    def __init__(self, args, target):
+        self.args = args
+        self.target = target
+
+    def compile(self, x_shape):
+        import paddle
+        import tvm
+        from tvm import relay
+        from tvm.contrib import graph_executor
+        paddle.enable_static()
+        exe = paddle.static.Executor(paddle.CPUPlace())
+        if self.args.params_combined:
+            program, _, _ = paddle.static.load_inference_model(
+                self.args.model_dir,
+                exe,
+                model_filename="__model__",
+                params_filename="params")
+        else:
+            program, _, _ = paddle.static.load_inference_model(
+                self.args.model_dir, exe)
+        mod, params = relay.frontend.from_paddle(
+            program, shape_dict={self.args.input_name: x_shape})
+        tvm_target = "cuda" if self.target == "nvgpu" else "llvm -mcpu=core-avx2"
+        with tvm.transform.PassContext(opt_level=3):
+            self.lib = relay.build(mod, target=tvm_target, params=params)
+        self.device = tvm.cuda(0) if self.target == "nvgpu" else tvm.cpu(0)
+        self.graph_executor = graph_executor
+
+    def runners(self, num_threads):
+        def make_runner():
+            module = self.graph_executor.GraphModule(
+                self.lib["default"](self.device))
+
+            def run(x_data):
+                module.set_input(self.args.input_name, x_data)
+                module.run()
+                module.get_output(0).numpy()
+
+            return run
+
+        return [make_runner() for _ in range(num_threads)]
+
+
+BACKENDS = {
+    "cinn": CinnBackend,
+    "paddle": PaddleBackend,
+    "tvm": TvmBackend,
+}
+
+
+def parse_ints(value):
+    return [int(v) for v in value.split(",") if v]
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("--model_dir", type=str, required=True)
+    parser.add_argument(
+        "--params_combined",
+        action="store_true",
+        help="whether the parameters are in a single file named params")
+    parser.add_argument("--input_name", type=str, required=True)
+    parser.add_argument(
+        "--input_shape",
+        type=parse_ints,
+        required=True,
+        help="the input shape without the batch dimension, e.g. 3,224,224")
+    parser.add_argument("--output_name", type=str, required=True)
+    parser.add_argument("--batch_sizes", type=parse_ints, default=[1])
+    parser.add_argument("--threads", type=parse_ints, default=[1])
+    parser.add_argument("--targets", type=str, default="x86")
+    parser.add_argument("--backends", type=str, default="cinn")
+    parser.add_argument("--warmup", type=int, default=10)
+    parser.add_argument("--repeat", type=int, default=100)
+    parser.add_argument("--json", type=str, default="")
+    parser.add_argument("--csv", type=str, default="")
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+    results = []
+    for backend_name in args.backends.split(","):
+        for target in args.targets.split(","):
+            for batch_size in args.batch_sizes:
+                x_shape = [batch_size] + args.input_shape
+                x_data = np.random.random(x_shape).astype("float32")
+                backend = BACKENDS[backend_name](args, target)
+                try:
+                    start = time.perf_counter()
+                    backend.compile(x_shape)
+                    compile_s = time.perf_counter() - start
+                except ImportError as e:
+                    print("Skip {}: {}".format(backend_name, e))
+                    break
+                for num_threads in args.threads:
+                    first_ms, latencies, elapsed = measure(
+                        backend.runners(num_threads), x_data, args.warmup,
+                        args.repeat)
+                    result = {
+                        "backend": backend_name,
+                        "target": target,
+                        "batch_size": batch_size,
+                        "threads": num_threads,
+                        "compile_s": compile_s,
+                        "first_run_ms": first_ms,
+                        "p50_ms": percentile(latencies, 0.5),
+                        "p99_ms": percentile(latencies, 0.99),
+                        "throughput": len(latencies) * batch_size / elapsed,
+                        "peak_host_mb": peak_host_memory_mb(),
+                    }
+                    print(json.dumps(result))
+                    results.append(result)
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent=2)
+    if args.csv and results:
+        with open(args.csv, "w", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=list(results[0].keys()))
+            writer.writeheader()
+            writer.writerows(results)
+
+
+if __name__ == "__main__":
+    main()
@@ -43,6 +43,13 @@ C = cinn.compute([
 
 stages = cinn.create_stages([C])
 
+##################################################################
+# Rerunning the script or the notebook cell defining the same computation
+# can reuse the functions lowered and the code compiled before in the
+# process, skipping the lowering and the LLVM compiler.
+cinn.set_flag("cinn_lower_cache", "true")
+cinn.set_flag("cinn_compilation_cache_memory_mb", "256")
+
 target = cinn.Target()
 builder = cinn.Module.Builder("matmul", target)
 